@@ -10,6 +10,7 @@ LOCAL_SRC_FILES := \
     AIMessage.cpp \
     AIState.cpp \
     AIStateMachine.cpp \
+    Allocator.cpp \
     Animation.cpp \
     AnimationClip.cpp \
     AnimationController.cpp \
@@ -19,6 +20,7 @@ LOCAL_SRC_FILES := \
     AudioController.cpp \
     AudioListener.cpp \
     AudioSource.cpp \
+    Benchmark.cpp \
     BoundingBox.cpp \
     BoundingSphere.cpp \
     Bundle.cpp \
@@ -27,38 +29,61 @@ LOCAL_SRC_FILES := \
     CheckBox.cpp \
     Container.cpp \
     Control.cpp \
+    CrowdRenderer.cpp \
     Curve.cpp \
+    DebugMarkers.cpp \
     DebugNew.cpp \
+    DebugRenderer.cpp \
     DepthStencilTarget.cpp \
+    DynamicResolution.cpp \
     Effect.cpp \
+    EffectPermutations.cpp \
     FileSystem.cpp \
     FlowLayout.cpp \
     Font.cpp \
     Form.cpp \
     FrameBuffer.cpp \
+    FrameGraph.cpp \
+    FramePacer.cpp \
     Frustum.cpp \
     Game.cpp \
     Gamepad.cpp \
+    GpuUploadQueue.cpp \
     HeightField.cpp \
     Image.cpp \
 	ImageControl.cpp \
+    InputQueue.cpp \
+    InputRecorder.cpp \
+    InstanceBuffer.cpp \
+    JobScheduler.cpp \
     Joint.cpp \
     Joystick.cpp \
     Label.cpp \
     Layout.cpp \
     Light.cpp \
+    LightClusters.cpp \
+    LightProbes.cpp \
+    ListContainer.cpp \
+    LoadProfiler.cpp \
     Logger.cpp \
     Material.cpp \
     MaterialParameter.cpp \
     MathUtil.cpp \
+    MatrixPaletteTexture.cpp \
     Matrix.cpp \
     Mesh.cpp \
     MeshBatch.cpp \
     MeshPart.cpp \
     MeshSkin.cpp \
     Model.cpp \
+    NavigationMesh.cpp \
     Node.cpp \
+    NodePool.cpp \
+    OcclusionBuffer.cpp \
+    OcclusionCuller.cpp \
+    Octree.cpp \
     ParticleEmitter.cpp \
+    ParticleManager.cpp \
     Pass.cpp \
     PhysicsCharacter.cpp \
     PhysicsCollisionObject.cpp \
@@ -74,39 +99,68 @@ LOCAL_SRC_FILES := \
     PhysicsSpringConstraint.cpp \
     PhysicsVehicle.cpp \
     PhysicsVehicleWheel.cpp \
+    Picker.cpp \
     Plane.cpp \
     Platform.cpp \
     PlatformAndroid.cpp \
+    PostProcessor.cpp \
+    Prefab.cpp \
+    Profiler.cpp \
+    ProgramCache.cpp \
     Properties.cpp \
     Quaternion.cpp \
     RadioButton.cpp \
     Ray.cpp \
+    ReadbackQueue.cpp \
     Rectangle.cpp \
     Ref.cpp \
+    RenderCommandList.cpp \
+    RenderQueue.cpp \
     RenderState.cpp \
+    RenderStats.cpp \
     RenderTarget.cpp \
+    RenderTargetPool.cpp \
+    RenderThread.cpp \
+    ResourceCache.cpp \
     Scene.cpp \
     SceneLoader.cpp \
+    SceneSnapshot.cpp \
     ScreenDisplayer.cpp \
     ScriptController.cpp \
     ScriptTarget.cpp \
+    ShadowMaps.cpp \
     Slider.cpp \
     SpriteBatch.cpp \
+    StartupTrace.cpp \
+    StateCache.cpp \
+    StaticBatcher.cpp \
+    StreamBuffer.cpp \
+    StringTable.cpp \
     Technique.cpp \
     Terrain.cpp \
+    TerrainDetail.cpp \
+    TerrainPager.cpp \
     TerrainPatch.cpp \
     TextBox.cpp \
     Texture.cpp \
+    TextureStreamer.cpp \
     Theme.cpp \
     ThemeStyle.cpp \
+    Thread.cpp \
+    TimerWheel.cpp \
     Transform.cpp \
+    TweenManager.cpp \
+    UniformBuffer.cpp \
     Vector2.cpp \
     Vector3.cpp \
     Vector4.cpp \
+    VertexAnimation.cpp \
     VertexAttributeBinding.cpp \
     VertexFormat.cpp \
     VerticalLayout.cpp \
     lua/lua_AbsoluteLayout.cpp \
+    lua/lua_Allocator.cpp \
+    lua/lua_AllocatorCategory.cpp \
     lua/lua_AIAgent.cpp \
     lua/lua_AIAgentListener.cpp \
     lua/lua_AIController.cpp \
@@ -240,9 +294,11 @@ LOCAL_SRC_FILES := \
     lua/lua_RenderStateCullFaceSide.cpp \
     lua/lua_RenderStateDepthFunction.cpp \
     lua/lua_RenderStateStateBlock.cpp \
+    lua/lua_RenderStats.cpp \
     lua/lua_RenderTarget.cpp \
     lua/lua_Scene.cpp \
     lua/lua_SceneDebugFlags.cpp \
+    lua/lua_SceneVisitFilter.cpp \
     lua/lua_ScreenDisplayer.cpp \
     lua/lua_ScriptController.cpp \
     lua/lua_ScriptTarget.cpp \
@@ -1,8 +1,12 @@
 // Attributes
 attribute vec4 a_position;									// Vertex Position							(x, y, z, w)
 #if defined(TEXTURE_LIGHTMAP)
+#if defined(TEXCOORD1)
+attribute vec2 a_texCoord1;                                 // Second tex coord, holding the lightmap layout
+#else
 attribute vec2 a_texCoord;                                  // Texture Coordinate (for lightmapping)
 #endif
+#endif
 #if defined(SKINNING)
 attribute vec4 a_blendWeights;								// Vertex blend weight, up to 4				(0, 1, 2, 3) 
 attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette	(0, 1, 2, 3)
@@ -10,12 +14,30 @@ attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette
 #if defined(VERTEX_COLOR)
 attribute vec3 a_color;										// Vertex Color								(r, g, b)
 #endif
+#if defined(INSTANCED) && !defined(INSTANCING_UNIFORM)
+attribute mat4 a_instanceMatrix;							// Instance world matrix
+#endif
 
 // Uniforms
+#if defined(INSTANCED)
+uniform mat4 u_viewProjectionMatrix;						// Matrix to transform a world position to clip space
+#if defined(INSTANCING_UNIFORM)
+uniform mat4 u_instanceMatrix;								// Instance world matrix (when hardware instancing is unavailable)
+#define a_instanceMatrix u_instanceMatrix
+#endif
+#else
 uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space.
+#endif
 #if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices as an array of floats
 #endif
+#endif
 
 // Varyings
 #if defined(TEXTURE_LIGHTMAP)
@@ -39,11 +61,19 @@ void main()
     vec4 position = getPosition();
     
     // Transform position to clip space.a
+    #if defined(INSTANCED)
+    gl_Position = u_viewProjectionMatrix * (a_instanceMatrix * position);
+    #else
     gl_Position = u_worldViewProjectionMatrix *  position;
+    #endif
     
     // Pass lightmap tex coord to fragment shader
     #if defined(TEXTURE_LIGHTMAP)
-    v_texCoord0 = a_texCoord0;
+    #if defined(TEXCOORD1)
+    v_texCoord = a_texCoord1;
+    #else
+    v_texCoord = a_texCoord;
+    #endif
     #endif
 
      // Pass on vertex color to fragment shader
@@ -16,9 +16,19 @@ varying vec3 v_color;										// Output Vertex Color
 uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space.
 uniform mat4 u_inverseTransposeWorldViewMatrix;				// Matrix to transform a normal to view space
 uniform mat4 u_worldViewMatrix;								// Matrix to tranform a position to view space.
+#if defined(SHADOWS)
+uniform mat4 u_worldMatrix;									// Matrix to transform a position to world space.
+#endif
 #if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
 #endif
+#endif
 #if defined(SPECULAR)
 uniform vec3 u_cameraPosition;                 				// Position of the camera in view space.
 #endif
@@ -36,9 +46,15 @@ varying vec3 v_normalVector;								// Normal vector in view space.
 #if defined(SPECULAR)
 varying vec3 v_cameraDirection;								// Direction the camera is looking at in tangent space.
 #endif
+#if defined(SHADOWS)
+varying vec4 v_shadowPosition;								// World position and view depth for shadow lookups.
+#endif
 
 // Lighting
-#if defined(POINT_LIGHT)
+#if defined(CLUSTERED_LIGHTING) || defined(FORWARD_LIGHTING)
+varying vec3 v_positionViewSpace;							// Position in view space.
+#include "lighting-clustered.vert"
+#elif defined(POINT_LIGHT)
 varying vec3 v_vertexToPointLightDirection;					// Direction of point light w.r.t current vertex in tangent space.
 varying float v_pointLightAttenuation;						// Attenuation of point light.
 #include "lighting-point.vert"
@@ -74,6 +90,11 @@ void main()
 
     // Apply light.
     applyLight(position);
+
+    // Pass the position to the shadow lookups.
+    #if defined(SHADOWS)
+    v_shadowPosition = vec4((u_worldMatrix * position).xyz, -(u_worldViewMatrix * position).z);
+    #endif
     
     // Pass the vertex color to fragment shader
     #if defined(VERTEX_COLOR)
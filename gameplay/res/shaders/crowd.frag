@@ -0,0 +1,36 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+// Uniforms
+uniform sampler2D u_diffuseTexture;     	// Diffuse texture
+uniform vec3 u_ambientColor;				// Ambient color
+uniform vec3 u_lightColor;					// Color of the directional light
+uniform vec3 u_lightDirection;				// Direction of the directional light, in world space
+#if defined(MODULATE_COLOR)
+uniform vec4 u_modulateColor;               // Modulation color
+#endif
+
+// Varyings
+varying vec2 v_texCoord0;                	// Texture coordinate(u, v)
+varying vec3 v_normalVector;				// Normal vector in world space
+
+
+void main()
+{
+    vec4 baseColor = texture2D(u_diffuseTexture, v_texCoord0);
+    #if defined(TEXTURE_DISCARD_ALPHA)
+    if (baseColor.a < 0.5)
+        discard;
+    #endif
+
+    // Ambient and diffuse lighting.
+    vec3 normalVector = normalize(v_normalVector);
+    float diffuse = max(dot(normalVector, -normalize(u_lightDirection)), 0.0);
+    gl_FragColor = vec4(baseColor.rgb * (u_ambientColor + u_lightColor * diffuse), baseColor.a);
+
+    // Global color modulation
+    #if defined(MODULATE_COLOR)
+    gl_FragColor *= u_modulateColor;
+    #endif
+}
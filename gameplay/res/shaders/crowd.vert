@@ -0,0 +1,67 @@
+// Attributes
+attribute vec2 a_texCoord0;									// Vertex Texture Coordinate				(u, v)
+attribute float a_texCoord1;								// Index of the vertex in the frames of the animation
+#if defined(INSTANCED) && !defined(INSTANCING_UNIFORM)
+attribute mat4 a_instanceMatrix;							// Instance world matrix
+attribute vec4 a_instanceData;								// Instance clip (first frame, frame count, speed, time offset)
+#endif
+
+// Uniforms
+#if defined(INSTANCED)
+uniform mat4 u_viewProjectionMatrix;						// Matrix to transform a world position to clip space
+#if defined(INSTANCING_UNIFORM)
+uniform mat4 u_instanceMatrix;								// Instance world matrix (when hardware instancing is unavailable)
+uniform vec4 u_instanceData;								// Instance clip (when hardware instancing is unavailable)
+#define a_instanceMatrix u_instanceMatrix
+#define a_instanceData u_instanceData
+#endif
+#else
+uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space
+uniform mat4 u_worldMatrix;									// Matrix to transform a position to world space
+uniform vec4 u_vertexAnimationClip;							// Clip (first frame, frame count, speed, time offset)
+#define a_instanceData u_vertexAnimationClip
+#endif
+uniform sampler2D u_vertexAnimation;						// Positions and normals of every vertex of every frame
+uniform vec2 u_vertexAnimationSize;							// Width and height of the frame texture
+uniform float u_vertexAnimationVertexCount;					// Number of vertices of a frame
+uniform float u_vertexAnimationFrameRate;					// Number of frames per second
+uniform float u_time;										// Time of the crowd, in milliseconds
+
+// Varyings
+varying vec2 v_texCoord0;									// Texture Coordinate
+varying vec3 v_normalVector;								// Normal vector in world space
+
+
+vec4 getTexel(float texel)
+{
+    float row = floor(texel / u_vertexAnimationSize.x);
+    float column = texel - row * u_vertexAnimationSize.x;
+    return texture2DLod(u_vertexAnimation, (vec2(column, row) + 0.5) / u_vertexAnimationSize, 0.0);
+}
+
+void main()
+{
+    // Find the two frames of the clip around the time of the instance.
+    float frameCount = a_instanceData.y;
+    float frame = mod((u_time * a_instanceData.z + a_instanceData.w) * u_vertexAnimationFrameRate * 0.001, frameCount);
+    float frame0 = floor(frame);
+    float frame1 = mod(frame0 + 1.0, frameCount);
+    float blend = frame - frame0;
+
+    // Each vertex of each frame is a position texel followed by a normal texel.
+    float texel0 = ((a_instanceData.x + frame0) * u_vertexAnimationVertexCount + a_texCoord1) * 2.0;
+    float texel1 = ((a_instanceData.x + frame1) * u_vertexAnimationVertexCount + a_texCoord1) * 2.0;
+    vec4 position = vec4(mix(getTexel(texel0).xyz, getTexel(texel1).xyz, blend), 1.0);
+    vec3 normal = mix(getTexel(texel0 + 1.0).xyz, getTexel(texel1 + 1.0).xyz, blend);
+
+    // Transform position to clip space, and the normal to world space.
+    #if defined(INSTANCED)
+    gl_Position = u_viewProjectionMatrix * (a_instanceMatrix * position);
+    v_normalVector = (a_instanceMatrix * vec4(normal, 0.0)).xyz;
+    #else
+    gl_Position = u_worldViewProjectionMatrix * position;
+    v_normalVector = (u_worldMatrix * vec4(normal, 0.0)).xyz;
+    #endif
+
+    v_texCoord0 = a_texCoord0;
+}
@@ -0,0 +1,10 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+
+void main()
+{
+    // Only the depth is written; the color channels are masked off.
+    gl_FragColor = vec4(0.0);
+}
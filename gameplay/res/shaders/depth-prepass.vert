@@ -0,0 +1,35 @@
+// Attributes
+attribute vec4 a_position;									// Vertex position							(x, y, z, w)
+#if defined(SKINNING)
+attribute vec4 a_blendWeights;								// Vertex blend weight, up to 4				(0, 1, 2, 3)
+attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette	(0, 1, 2, 3)
+#endif
+
+// Uniforms
+uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space
+#if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
+#endif
+#endif
+
+// Skinning
+#if defined(SKINNING)
+#include "skinning.vert"
+#else
+#include "skinning-none.vert"
+#endif
+
+
+void main()
+{
+    // The position is computed exactly as the built-in shaders compute it, so that the
+    // depth of the main pass is equal to the depth written here.
+    vec4 position = getPosition();
+    gl_Position = u_worldViewProjectionMatrix * position;
+}
@@ -1,4 +1,7 @@
 #ifdef OPENGL_ES
+#ifdef DISTANCE_FIELD
+#extension GL_OES_standard_derivatives : enable
+#endif
 precision highp float;
 #endif
 
@@ -13,5 +16,17 @@ varying vec4 v_color;
 void main()
 {
     gl_FragColor = v_color;
+#ifdef DISTANCE_FIELD
+    // The texture holds the distance to the glyph outlines, which are at 0.5,
+    // so the edges are smoothed over about a pixel at any size.
+    float distance = texture2D(u_texture, v_texCoord).a;
+#if defined(OPENGL_ES) && !defined(GL_OES_standard_derivatives)
+    float smoothing = 0.0625;
+#else
+    float smoothing = 0.7 * fwidth(distance);
+#endif
+    gl_FragColor.a = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance) * v_color.a;
+#else
     gl_FragColor.a = texture2D(u_texture, v_texCoord).a * v_color.a;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef CLUSTER_MAX_LIGHTS
+#define CLUSTER_MAX_LIGHTS 32                   // Lights listed per cluster, must match gameplay::LightClusters
+#endif
+#ifndef CLUSTER_MAX_DIRECTIONAL_LIGHTS
+#define CLUSTER_MAX_DIRECTIONAL_LIGHTS 4        // Directional lights shaded per pixel
+#endif
+
+// Uniforms
+uniform sampler2D u_clusterLights;              // Light data: position and inverse range, color and inner cone cosine, direction and outer cone cosine
+uniform sampler2D u_clusterCounts;              // Number of lights of each cluster (tile, slice)
+uniform sampler2D u_clusterIndices;             // Light indices of each cluster, four per texel
+uniform vec4 u_clusterScale;                    // Tiles per pixel (x, y), depth slice scale and bias
+uniform vec4 u_clusterSize;                     // Tile count (x, y), slice count and light data width
+uniform float u_clusterDirectionalLightCount;   // Number of directional lights at the start of the light data
+
+vec4 fetchLight(float index, float row)
+{
+    return texture2D(u_clusterLights, vec2((index + 0.5) / u_clusterSize.w, (row + 0.5) / 3.0));
+}
+
+vec3 shadeLight(float index, vec3 normalVector, vec3 cameraDirection)
+{
+    vec4 positionRange = fetchLight(index, 0.0);
+    vec4 colorInner = fetchLight(index, 1.0);
+    vec4 directionOuter = fetchLight(index, 2.0);
+
+    vec3 lightDirection;
+    float attenuation = 1.0;
+    if (positionRange.w == 0.0)
+    {
+        // Directional light
+        lightDirection = -directionOuter.xyz;
+    }
+    else
+    {
+        // Point or spot light; the cone of a point light never attenuates.
+        vec3 vertexToLight = positionRange.xyz - v_positionViewSpace;
+        vec3 scaled = vertexToLight * positionRange.w;
+        lightDirection = normalize(vertexToLight);
+        attenuation = clamp(1.0 - dot(scaled, scaled), 0.0, 1.0);
+        attenuation *= smoothstep(directionOuter.w, colorInner.w, dot(-lightDirection, directionOuter.xyz));
+    }
+
+    // Diffuse
+    float diffuseIntensity = max(0.0, dot(normalVector, lightDirection)) * attenuation;
+    vec3 color = colorInner.rgb * _baseColor.rgb * diffuseIntensity;
+
+    #if defined(SPECULAR)
+
+    // Specular
+    vec3 halfVector = normalize(lightDirection + cameraDirection);
+    float specularIntensity = attenuation * pow(max(0.0, dot(normalVector, halfVector)), u_specularExponent);
+    color += colorInner.rgb * _baseColor.rgb * specularIntensity;
+
+    #endif
+
+    return color;
+}
+
+vec3 getLitPixel()
+{
+    vec3 normalVector = normalize(v_normalVector);
+    #if defined(SPECULAR)
+    vec3 cameraDirection = normalize(v_cameraDirection);
+    #else
+    vec3 cameraDirection = vec3(0.0);
+    #endif
+
+    // Ambient
+    vec3 color = _baseColor.rgb * getAmbientColor(normalVector);
+
+    // Directional lights reach every cluster.
+    for (int i = 0; i < CLUSTER_MAX_DIRECTIONAL_LIGHTS; ++i)
+    {
+        if (float(i) >= u_clusterDirectionalLightCount)
+            break;
+        color += shadeLight(float(i), normalVector, cameraDirection);
+    }
+
+    // Find the cluster of this pixel from its screen tile and view depth.
+    vec2 tile = floor(gl_FragCoord.xy * u_clusterScale.xy);
+    float tileIndex = tile.y * u_clusterSize.x + tile.x;
+    float tileCount = u_clusterSize.x * u_clusterSize.y;
+    float slice = clamp(floor(log(-v_positionViewSpace.z) * u_clusterScale.z + u_clusterScale.w), 0.0, u_clusterSize.z - 1.0);
+    float sliceCoord = (slice + 0.5) / u_clusterSize.z;
+    float lightCount = floor(texture2D(u_clusterCounts, vec2((tileIndex + 0.5) / tileCount, sliceCoord)).a * 255.0 + 0.5);
+
+    // Shade the lights listed for the cluster.
+    const float texelsPerCluster = float(CLUSTER_MAX_LIGHTS / 4);
+    for (int i = 0; i < CLUSTER_MAX_LIGHTS / 4; ++i)
+    {
+        float first = float(i * 4);
+        if (first >= lightCount)
+            break;
+        vec4 indices = floor(texture2D(u_clusterIndices, vec2((tileIndex * texelsPerCluster + float(i) + 0.5) / (tileCount * texelsPerCluster), sliceCoord)) * 255.0 + 0.5);
+        color += shadeLight(indices.x, normalVector, cameraDirection);
+        if (first + 1.0 < lightCount)
+            color += shadeLight(indices.y, normalVector, cameraDirection);
+        if (first + 2.0 < lightCount)
+            color += shadeLight(indices.z, normalVector, cameraDirection);
+        if (first + 3.0 < lightCount)
+            color += shadeLight(indices.w, normalVector, cameraDirection);
+    }
+
+    return color;
+}
@@ -0,0 +1,13 @@
+void applyLight(vec4 position)
+{
+    // World view space position, from which the pixel finds its light cluster, or the
+    // vectors to the lights selected for the node with forward lighting.
+    vec4 positionWorldViewSpace = u_worldViewMatrix * position;
+    v_positionViewSpace = positionWorldViewSpace.xyz;
+
+    #if defined(SPECULAR)
+
+    v_cameraDirection = u_cameraPosition - positionWorldViewSpace.xyz;
+
+    #endif
+}
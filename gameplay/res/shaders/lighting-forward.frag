@@ -0,0 +1,62 @@
+#ifndef FORWARD_LIGHT_COUNT
+#define FORWARD_LIGHT_COUNT 4                   // Lights shaded per node, at most 8 (gameplay::RenderState::NODE_LIGHTS)
+#endif
+
+// Uniforms
+uniform vec4 u_forwardLights[FORWARD_LIGHT_COUNT * 3];  // Per light: position and inverse range, color and inner cone cosine, direction and outer cone cosine
+
+vec3 shadeLight(vec4 positionRange, vec4 colorInner, vec4 directionOuter, vec3 normalVector, vec3 cameraDirection)
+{
+    vec3 lightDirection;
+    float attenuation = 1.0;
+    if (positionRange.w == 0.0)
+    {
+        // Directional light
+        lightDirection = -directionOuter.xyz;
+    }
+    else
+    {
+        // Point or spot light; the cone of a point light never attenuates.
+        vec3 vertexToLight = positionRange.xyz - v_positionViewSpace;
+        vec3 scaled = vertexToLight * positionRange.w;
+        lightDirection = normalize(vertexToLight);
+        attenuation = clamp(1.0 - dot(scaled, scaled), 0.0, 1.0);
+        attenuation *= smoothstep(directionOuter.w, colorInner.w, dot(-lightDirection, directionOuter.xyz));
+    }
+
+    // Diffuse
+    float diffuseIntensity = max(0.0, dot(normalVector, lightDirection)) * attenuation;
+    vec3 color = colorInner.rgb * _baseColor.rgb * diffuseIntensity;
+
+    #if defined(SPECULAR)
+
+    // Specular
+    vec3 halfVector = normalize(lightDirection + cameraDirection);
+    float specularIntensity = attenuation * pow(max(0.0, dot(normalVector, halfVector)), u_specularExponent);
+    color += colorInner.rgb * _baseColor.rgb * specularIntensity;
+
+    #endif
+
+    return color;
+}
+
+vec3 getLitPixel()
+{
+    vec3 normalVector = normalize(v_normalVector);
+    #if defined(SPECULAR)
+    vec3 cameraDirection = normalize(v_cameraDirection);
+    #else
+    vec3 cameraDirection = vec3(0.0);
+    #endif
+
+    // Ambient
+    vec3 color = _baseColor.rgb * getAmbientColor(normalVector);
+
+    // The lights selected for the node; unused ones have a zero color.
+    for (int i = 0; i < FORWARD_LIGHT_COUNT; ++i)
+    {
+        color += shadeLight(u_forwardLights[i * 3], u_forwardLights[i * 3 + 1], u_forwardLights[i * 3 + 2], normalVector, cameraDirection);
+    }
+
+    return color;
+}
@@ -2,6 +2,17 @@ vec4 _baseColor;
 vec3 _ambientColor;
 vec3 _diffuseColor;
 
+#if defined(LIGHT_PROBES)
+// Irradiance from the light probes around the object, for the normal in view space.
+vec3 getAmbientColor(vec3 normalVector)
+{
+    vec4 n = vec4(normalVector, 1.0);
+    return max(vec3(dot(u_lightProbe[0], n), dot(u_lightProbe[1], n), dot(u_lightProbe[2], n)), 0.0);
+}
+#else
+#define getAmbientColor(normalVector) u_ambientColor
+#endif
+
 #if defined(SPECULAR)
 
 vec3 _specularColor;
@@ -9,7 +20,11 @@ vec3 _specularColor;
 vec3 computeLighting(vec3 normalVector, vec3 lightDirection, float attenuation, vec3 cameraDirection)
 {
     // Ambient
-    _ambientColor = _baseColor.rgb * u_ambientColor;
+    _ambientColor = _baseColor.rgb * getAmbientColor(normalVector);
+
+    #if defined(SHADOWS)
+    attenuation *= getShadow();
+    #endif
 
     // Diffuse
     float ddot = dot(normalVector, lightDirection);
@@ -31,7 +46,11 @@ vec3 computeLighting(vec3 normalVector, vec3 lightDirection, float attenuation,
 vec3 computeLighting(vec3 normalVector, vec3 lightDirection, float attenuation)
 {
     // Ambient
-    _ambientColor = _baseColor.rgb * u_ambientColor;
+    _ambientColor = _baseColor.rgb * getAmbientColor(normalVector);
+
+    #if defined(SHADOWS)
+    attenuation *= getShadow();
+    #endif
 
     // Diffuse
 	float ddot = dot(normalVector, lightDirection);
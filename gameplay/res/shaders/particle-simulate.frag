@@ -0,0 +1,9 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+// Transform feedback runs with rasterization disabled, so nothing is ever shaded.
+void main()
+{
+    gl_FragColor = vec4(0.0);
+}
@@ -0,0 +1,50 @@
+// Attributes
+attribute vec4 a_position;          // xyz: position, w: remaining energy (ms)
+attribute vec4 a_velocity;          // xyz: velocity, w: angle
+attribute vec4 a_acceleration;      // xyz: acceleration, w: initial sprite frame
+attribute vec4 a_rotation;          // xyz: rotation axis, w: rotation speed
+attribute vec4 a_size;              // x: start size, y: end size, z: rotation speed per particle, w: start energy (ms)
+
+// Uniforms
+uniform float u_elapsedTime;        // Milliseconds since the last update.
+
+// Varyings
+varying vec4 v_position;
+varying vec4 v_velocity;
+varying vec4 v_acceleration;
+
+
+vec3 rotate(vec3 v, vec3 axis, float angle)
+{
+    float c = cos(angle);
+    float s = sin(angle);
+    return v * c + cross(axis, v) * s + axis * dot(axis, v) * (1.0 - c);
+}
+
+void main()
+{
+    float elapsedSecs = u_elapsedTime * 0.001;
+    vec3 position = a_position.xyz;
+    vec3 velocity = a_velocity.xyz;
+    vec3 acceleration = a_acceleration.xyz;
+    float energy = a_position.w - u_elapsedTime;
+
+    if (energy > 0.0)
+    {
+        if (a_rotation.w != 0.0 && dot(a_rotation.xyz, a_rotation.xyz) > 0.0)
+        {
+            vec3 axis = normalize(a_rotation.xyz);
+            float angle = a_rotation.w * elapsedSecs;
+            velocity = rotate(velocity, axis, angle);
+            acceleration = rotate(acceleration, axis, angle);
+        }
+
+        velocity += acceleration * elapsedSecs;
+        position += velocity * elapsedSecs;
+    }
+
+    v_position = vec4(position, energy);
+    v_velocity = vec4(velocity, a_velocity.w + a_size.z * elapsedSecs);
+    v_acceleration = vec4(acceleration, a_acceleration.w);
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
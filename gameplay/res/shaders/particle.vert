@@ -0,0 +1,63 @@
+#define FRAME_COUNT_MAX 64
+
+// Attributes
+attribute vec2 a_corner;            // Corner of the billboard, from (0, 0) to (1, 1).
+attribute vec4 a_position;          // xyz: position, w: remaining energy (ms)
+attribute vec4 a_velocity;          // w: angle
+attribute vec4 a_acceleration;      // w: initial sprite frame
+attribute vec4 a_colorStart;
+attribute vec4 a_colorEnd;
+attribute vec4 a_size;              // x: start size, y: end size, w: start energy (ms)
+
+// Uniforms
+uniform mat4 u_viewProjectionMatrix;
+uniform vec3 u_cameraRight;
+uniform vec3 u_cameraUp;
+uniform vec4 u_spriteAnimation;     // x: frame count, y: lifetime percent per frame, z: frame duration (ms), w: 0 static, 1 animated, 2 looped
+uniform vec4 u_frameCoords[FRAME_COUNT_MAX];
+
+// Varyings
+varying vec2 v_texCoord;
+varying vec4 v_color;
+
+
+void main()
+{
+    float energy = a_position.w;
+    if (energy <= 0.0)
+    {
+        // Dead particles collapse to a point outside the view volume.
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        v_texCoord = vec2(0.0);
+        v_color = vec4(0.0);
+        return;
+    }
+
+    // Simple linear interpolation of color and size.
+    float percent = 1.0 - energy / a_size.w;
+    float size = mix(a_size.x, a_size.y, percent);
+    v_color = mix(a_colorStart, a_colorEnd, percent);
+
+    // Sprite animation.
+    float frame = a_acceleration.w;
+    if (u_spriteAnimation.w == 1.0)
+    {
+        // The last frame finishes exactly when the particle dies.
+        frame = max(frame, min(floor(percent / u_spriteAnimation.y), u_spriteAnimation.x - 1.0));
+    }
+    else if (u_spriteAnimation.w == 2.0)
+    {
+        frame = mod(frame + floor((a_size.w - energy) / u_spriteAnimation.z), u_spriteAnimation.x);
+    }
+    vec4 coords = u_frameCoords[int(frame)];
+    v_texCoord = mix(coords.xy, coords.zw, a_corner);
+
+    // Camera facing billboard rotated around its center.
+    vec2 offset = (a_corner - 0.5) * size;
+    float c = cos(a_velocity.w);
+    float s = sin(a_velocity.w);
+    offset = vec2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);
+    vec3 position = a_position.xyz + u_cameraRight * offset.x + u_cameraUp * offset.y;
+
+    gl_Position = u_viewProjectionMatrix * vec4(position, 1.0);
+}
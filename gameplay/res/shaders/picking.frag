@@ -0,0 +1,25 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+// Uniforms
+uniform vec4 u_pickColor;					// Index of the node drawn, packed into the color channels
+#if defined(TEXTURE_DISCARD_ALPHA)
+uniform sampler2D u_diffuseTexture;			// Diffuse texture of the material drawn
+#endif
+
+// Varyings
+#if defined(TEXTURE_DISCARD_ALPHA)
+varying vec2 v_texCoord;					// Texture coordinate
+#endif
+
+
+void main()
+{
+    // Fragments are discarded where the material discards them, so the cut out parts of a model are not picked.
+    #if defined(TEXTURE_DISCARD_ALPHA)
+    if (texture2D(u_diffuseTexture, v_texCoord).a < 0.5)
+        discard;
+    #endif
+    gl_FragColor = u_pickColor;
+}
@@ -0,0 +1,58 @@
+// Attributes
+attribute vec4 a_position;									// Vertex position							(x, y, z, w)
+#if defined(SKINNING)
+attribute vec4 a_blendWeights;								// Vertex blend weight, up to 4				(0, 1, 2, 3)
+attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette	(0, 1, 2, 3)
+#endif
+#if defined(TEXTURE_DISCARD_ALPHA)
+attribute vec2 a_texCoord;									// Vertex texture coordinate				(u, v)
+#endif
+
+// Uniforms
+uniform mat4 u_worldMatrix;									// Matrix to transform a position to world space
+uniform mat4 u_pickViewProjectionMatrix;					// Matrix to transform a world position to the clip space of the picked area
+#if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
+#endif
+#endif
+#if defined(TEXTURE_REPEAT)
+uniform vec2 u_textureRepeat;								// Texture repeat for tiling
+#endif
+#if defined(TEXTURE_OFFSET)
+uniform vec2 u_textureOffset;								// Texture offset
+#endif
+
+// Skinning
+#if defined(SKINNING)
+#include "skinning.vert"
+#else
+#include "skinning-none.vert"
+#endif
+
+// Varyings
+#if defined(TEXTURE_DISCARD_ALPHA)
+varying vec2 v_texCoord;									// Texture coordinate
+#endif
+
+
+void main()
+{
+    gl_Position = u_pickViewProjectionMatrix * (u_worldMatrix * getPosition());
+
+    // Texture coordinates are computed as the built-in shaders compute them, for the alpha test.
+    #if defined(TEXTURE_DISCARD_ALPHA)
+    v_texCoord = a_texCoord;
+    #if defined(TEXTURE_REPEAT)
+    v_texCoord *= u_textureRepeat;
+    #endif
+    #if defined(TEXTURE_OFFSET)
+    v_texCoord += u_textureOffset;
+    #endif
+    #endif
+}
@@ -0,0 +1,37 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+// Uniforms
+uniform sampler2D u_texture;
+#if defined(BRIGHT_PASS)
+uniform vec2 u_texelSize;                   // Size of a texel of the full resolution scene
+uniform float u_threshold;                  // Brightness above which colors bloom
+#else
+uniform vec2 u_direction;                   // Size of a texel along the blur direction
+#endif
+
+// Varyings
+varying vec2 v_texCoord;
+
+
+void main()
+{
+#if defined(BRIGHT_PASS)
+    // Four bilinear taps average the 4x4 texels under each texel of the quarter resolution target,
+    // so the bright pass and the downsample are a single pass.
+    vec3 color = texture2D(u_texture, v_texCoord + vec2(-1.0, -1.0) * u_texelSize).rgb;
+    color += texture2D(u_texture, v_texCoord + vec2(1.0, -1.0) * u_texelSize).rgb;
+    color += texture2D(u_texture, v_texCoord + vec2(-1.0, 1.0) * u_texelSize).rgb;
+    color += texture2D(u_texture, v_texCoord + vec2(1.0, 1.0) * u_texelSize).rgb;
+    gl_FragColor = vec4(max(color * 0.25 - vec3(u_threshold), vec3(0.0)), 1.0);
+#else
+    // A 9 tap gaussian in 5 bilinear taps, placed between texels to weigh two of them at once.
+    vec3 color = texture2D(u_texture, v_texCoord).rgb * 0.2270270270;
+    color += texture2D(u_texture, v_texCoord + u_direction * 1.3846153846).rgb * 0.3162162162;
+    color += texture2D(u_texture, v_texCoord - u_direction * 1.3846153846).rgb * 0.3162162162;
+    color += texture2D(u_texture, v_texCoord + u_direction * 3.2307692308).rgb * 0.0702702703;
+    color += texture2D(u_texture, v_texCoord - u_direction * 3.2307692308).rgb * 0.0702702703;
+    gl_FragColor = vec4(color, 1.0);
+#endif
+}
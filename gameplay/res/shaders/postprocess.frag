@@ -0,0 +1,108 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+#ifndef FXAA_SPAN_MAX
+#define FXAA_SPAN_MAX 8.0
+#endif
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+
+// Uniforms
+uniform sampler2D u_texture;                // The scene
+uniform vec2 u_texelSize;                   // Size of a texel of the scene
+#if defined(BLOOM)
+uniform sampler2D u_bloomTexture;           // Blurred bright parts of the scene, at a reduced resolution
+uniform float u_bloomIntensity;             // Scale of the bloom added to the scene
+#endif
+#if defined(TONE_MAPPING)
+uniform float u_exposure;                   // Scale of the scene colors before tone mapping
+#endif
+#if defined(COLOR_GRADING)
+uniform sampler2D u_colorGradingTexture;    // 256x16 lookup table: 16 slices of blue, each 16x16 of red by green
+#endif
+
+// Varyings
+varying vec2 v_texCoord;
+
+
+// Reads the scene with the bloom added and tone mapped, so that FXAA works on final colors.
+vec3 sampleScene(vec2 texCoord)
+{
+    vec3 color = texture2D(u_texture, texCoord).rgb;
+#if defined(BLOOM)
+    color += texture2D(u_bloomTexture, texCoord).rgb * u_bloomIntensity;
+#endif
+#if defined(TONE_MAPPING)
+    // Filmic curve fitted to the ACES reference tone mapping.
+    color *= u_exposure;
+    color = clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+#endif
+    return color;
+}
+
+#if defined(FXAA)
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+vec3 fxaa(vec2 texCoord)
+{
+    vec3 colorNW = sampleScene(texCoord + vec2(-1.0, -1.0) * u_texelSize);
+    vec3 colorNE = sampleScene(texCoord + vec2(1.0, -1.0) * u_texelSize);
+    vec3 colorSW = sampleScene(texCoord + vec2(-1.0, 1.0) * u_texelSize);
+    vec3 colorSE = sampleScene(texCoord + vec2(1.0, 1.0) * u_texelSize);
+    vec3 colorM = sampleScene(texCoord);
+    float lumaNW = luma(colorNW);
+    float lumaNE = luma(colorNE);
+    float lumaSW = luma(colorSW);
+    float lumaSE = luma(colorSE);
+    float lumaM = luma(colorM);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Blur along the edge, which runs across the steepest change of luma.
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float directionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + directionReduce);
+    direction = clamp(direction * scale, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * u_texelSize;
+
+    vec3 colorA = 0.5 * (sampleScene(texCoord + direction * (1.0 / 3.0 - 0.5)) +
+                         sampleScene(texCoord + direction * (2.0 / 3.0 - 0.5)));
+    vec3 colorB = colorA * 0.5 + 0.25 * (sampleScene(texCoord - direction * 0.5) +
+                                         sampleScene(texCoord + direction * 0.5));
+
+    // The wider blur is dropped when it reaches past the edge.
+    float lumaB = luma(colorB);
+    if (lumaB < lumaMin || lumaB > lumaMax)
+        return colorA;
+    return colorB;
+}
+#endif
+
+#if defined(COLOR_GRADING)
+vec3 grade(vec3 color)
+{
+    // Blend the two slices of blue around the color, each sampled bilinearly in red and green.
+    float blue = color.b * 15.0;
+    float slice = floor(blue);
+    vec2 texCoord = vec2((color.r * 15.0 + 0.5) / 256.0, (color.g * 15.0 + 0.5) / 16.0);
+    vec3 color0 = texture2D(u_colorGradingTexture, vec2(texCoord.x + slice / 16.0, texCoord.y)).rgb;
+    vec3 color1 = texture2D(u_colorGradingTexture, vec2(texCoord.x + min(slice + 1.0, 15.0) / 16.0, texCoord.y)).rgb;
+    return mix(color0, color1, blue - slice);
+}
+#endif
+
+void main()
+{
+#if defined(FXAA)
+    vec3 color = fxaa(v_texCoord);
+#else
+    vec3 color = sampleScene(v_texCoord);
+#endif
+#if defined(COLOR_GRADING)
+    color = grade(clamp(color, 0.0, 1.0));
+#endif
+    gl_FragColor = vec4(color, 1.0);
+}
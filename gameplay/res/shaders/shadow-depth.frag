@@ -0,0 +1,11 @@
+#ifdef OPENGL_ES
+precision highp float;
+#endif
+
+
+void main()
+{
+    // Pack the depth into all four 8-bit channels, since depth textures are optional on OpenGL ES 2.0.
+    vec4 depth = fract(gl_FragCoord.z * vec4(1.0, 255.0, 65025.0, 16581375.0));
+    gl_FragColor = depth - depth.yzww * vec4(1.0 / 255.0, 1.0 / 255.0, 1.0 / 255.0, 0.0);
+}
@@ -0,0 +1,74 @@
+// Shadow maps drawn by ShadowMaps. The static map holds the cached depth of static casters
+// and the dynamic map the depth of moving casters; a fragment is lit if it is in front of both.
+uniform sampler2D u_shadowStaticMap;			// Packed depth of static casters
+uniform sampler2D u_shadowDynamicMap;			// Packed depth of dynamic casters
+uniform float u_shadowBias;						// Depth bias against shadow acne
+#if defined(POINT_LIGHT)
+#define SHADOW_MATRIX_COUNT 6
+uniform vec3 u_shadowLightPosition;				// World position of the point light
+#elif defined(SPOT_LIGHT)
+#define SHADOW_MATRIX_COUNT 1
+#else
+#ifndef SHADOW_CASCADE_COUNT
+#define SHADOW_CASCADE_COUNT 4
+#endif
+#define SHADOW_MATRIX_COUNT SHADOW_CASCADE_COUNT
+uniform vec4 u_shadowCascadeSplits;				// View depth at the far end of each cascade
+#endif
+uniform mat4 u_shadowMatrices[SHADOW_MATRIX_COUNT];	// World to shadow map texture space, per cascade or cube face
+
+float unpackShadowDepth(vec4 color)
+{
+    return dot(color, vec4(1.0, 1.0 / 255.0, 1.0 / 65025.0, 1.0 / 16581375.0));
+}
+
+float getShadowFromMatrix(mat4 matrix)
+{
+    vec4 position = matrix * vec4(v_shadowPosition.xyz, 1.0);
+    if (position.w <= 0.0)
+        return 1.0;
+    position.xyz /= position.w;
+
+    float depth = min(unpackShadowDepth(texture2D(u_shadowStaticMap, position.xy)), unpackShadowDepth(texture2D(u_shadowDynamicMap, position.xy)));
+    return position.z - u_shadowBias > depth ? 0.0 : 1.0;
+}
+
+float getShadow()
+{
+    #if defined(POINT_LIGHT)
+
+    // Faces are ordered +X, -X, +Y, -Y, +Z, -Z.
+    vec3 lightToPosition = v_shadowPosition.xyz - u_shadowLightPosition;
+    vec3 distance = abs(lightToPosition);
+    int index;
+    if (distance.x >= distance.y && distance.x >= distance.z)
+        index = lightToPosition.x > 0.0 ? 0 : 1;
+    else if (distance.y >= distance.z)
+        index = lightToPosition.y > 0.0 ? 2 : 3;
+    else
+        index = lightToPosition.z > 0.0 ? 4 : 5;
+
+    #elif defined(SPOT_LIGHT)
+
+    int index = 0;
+
+    #else
+
+    // Pick the first cascade that reaches the fragment; beyond the last one there is no shadow.
+    int index = SHADOW_CASCADE_COUNT;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+    {
+        if (index == SHADOW_CASCADE_COUNT && v_shadowPosition.w <= u_shadowCascadeSplits[i])
+            index = i;
+    }
+
+    #endif
+
+    // OpenGL ES 2.0 only indexes uniform arrays in fragment shaders by loop indices.
+    for (int i = 0; i < SHADOW_MATRIX_COUNT; ++i)
+    {
+        if (i == index)
+            return getShadowFromMatrix(u_shadowMatrices[i]);
+    }
+    return 1.0;
+}
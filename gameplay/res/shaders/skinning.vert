@@ -1,3 +1,102 @@
+#if defined(SKINNING_TEXTURE)
+
+vec4 getMatrixPaletteRow(int row)
+{
+    // The palettes fill the texture row after row, SKINNING_TEXTURE_SIZE texels per line.
+    float texel = u_matrixPaletteOffset + float(row);
+    float y = floor((texel + 0.5) / SKINNING_TEXTURE_SIZE);
+    float x = texel - y * SKINNING_TEXTURE_SIZE;
+    return texture2DLod(u_matrixPalette, (vec2(x, y) + 0.5) / SKINNING_TEXTURE_SIZE, 0.0);
+}
+
+#else
+
+vec4 getMatrixPaletteRow(int row)
+{
+    return u_matrixPalette[row];
+}
+
+#endif
+
+#if defined(SKINNING_DUAL_QUATERNION)
+
+vec4 _blendedReal;
+vec4 _blendedDual;
+bool _blended = false;
+
+void blendDualQuaternion(float blendWeight, int row)
+{
+    vec4 real = getMatrixPaletteRow(row);
+
+    // Blend each joint in the hemisphere of the first one, since q and -q are the same rotation.
+    if (dot(real, _blendedReal) < 0.0)
+        blendWeight = -blendWeight;
+    _blendedReal += blendWeight * real;
+    _blendedDual += blendWeight * getMatrixPaletteRow(row + 1);
+}
+
+void blendDualQuaternions()
+{
+    if (_blended)
+        return;
+    _blended = true;
+
+    // Each dual quaternion takes two rows of the palette: the rotation, then the dual part.
+    _blendedReal = a_blendWeights[0] * getMatrixPaletteRow(int(a_blendIndices[0]) * 2);
+    _blendedDual = a_blendWeights[0] * getMatrixPaletteRow(int(a_blendIndices[0]) * 2 + 1);
+    blendDualQuaternion(a_blendWeights[1], int(a_blendIndices[1]) * 2);
+    blendDualQuaternion(a_blendWeights[2], int(a_blendIndices[2]) * 2);
+    blendDualQuaternion(a_blendWeights[3], int(a_blendIndices[3]) * 2);
+
+    float norm = length(_blendedReal);
+    _blendedReal /= norm;
+    _blendedDual /= norm;
+}
+
+vec3 rotateVector(vec3 vector)
+{
+    return vector + 2.0 * cross(_blendedReal.xyz, cross(_blendedReal.xyz, vector) + _blendedReal.w * vector);
+}
+
+vec4 getPosition()
+{
+    blendDualQuaternions();
+
+    // The translation is twice the dual part multiplied by the conjugate of the rotation.
+    vec3 translation = 2.0 * (_blendedReal.w * _blendedDual.xyz - _blendedDual.w * _blendedReal.xyz + cross(_blendedReal.xyz, _blendedDual.xyz));
+    return vec4(rotateVector(a_position.xyz) + translation * a_position.w, a_position.w);
+}
+
+#if defined(LIGHTING)
+
+vec3 getTangentSpaceVector(vec3 vector)
+{
+    blendDualQuaternions();
+    return rotateVector(vector);
+}
+
+vec3 getNormal()
+{
+    return getTangentSpaceVector(a_normal);
+}
+
+#if defined(BUMPED)
+
+vec3 getTangent()
+{
+    return getTangentSpaceVector(a_tangent);
+}
+
+vec3 getBinormal()
+{
+    return getTangentSpaceVector(a_binormal);
+}
+
+#endif
+#endif
+
+#else
+
 vec4 _skinnedPosition;
 #if defined(LIGHTING)
 vec3 _skinnedNormal;
@@ -6,9 +105,9 @@ vec3 _skinnedNormal;
 void skinPosition(float blendWeight, int matrixIndex)
 {
     vec4 tmp;
-    tmp.x = dot(a_position, u_matrixPalette[matrixIndex]);
-    tmp.y = dot(a_position, u_matrixPalette[matrixIndex + 1]);
-    tmp.z = dot(a_position, u_matrixPalette[matrixIndex + 2]);
+    tmp.x = dot(a_position, getMatrixPaletteRow(matrixIndex));
+    tmp.y = dot(a_position, getMatrixPaletteRow(matrixIndex + 1));
+    tmp.z = dot(a_position, getMatrixPaletteRow(matrixIndex + 2));
     tmp.w = a_position.w;
     _skinnedPosition += blendWeight * tmp;
 }
@@ -42,9 +141,9 @@ vec4 getPosition()
 void skinTangentSpaceVector(vec3 vector, float blendWeight, int matrixIndex)
 {
     vec3 tmp;
-    tmp.x = dot(vector, u_matrixPalette[matrixIndex].xyz);
-    tmp.y = dot(vector, u_matrixPalette[matrixIndex + 1].xyz);
-    tmp.z = dot(vector, u_matrixPalette[matrixIndex + 2].xyz);
+    tmp.x = dot(vector, getMatrixPaletteRow(matrixIndex).xyz);
+    tmp.y = dot(vector, getMatrixPaletteRow(matrixIndex + 1).xyz);
+    tmp.z = dot(vector, getMatrixPaletteRow(matrixIndex + 2).xyz);
     _skinnedNormal += blendWeight * tmp;
 }
 
@@ -90,4 +189,6 @@ vec3 getBinormal()
 }
 
 #endif
-#endif
\ No newline at end of file
+#endif
+
+#endif
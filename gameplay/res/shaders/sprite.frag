@@ -1,16 +1,31 @@
+#if defined(TEXTURE_ARRAY)
+#extension GL_EXT_texture_array : enable
+#endif
 #ifdef OPENGL_ES
 precision highp float;
 #endif
 
 // Uniforms
+#if defined(TEXTURE_ARRAY)
+uniform sampler2DArray u_texture;
+#else
 uniform sampler2D u_texture;
+#endif
 
 // Varyings
+#if defined(TEXTURE_ARRAY)
+varying vec3 v_texCoord;
+#else
 varying vec2 v_texCoord;
+#endif
 varying vec4 v_color;
 
 
 void main()
 {
+#if defined(TEXTURE_ARRAY)
+    gl_FragColor = v_color * texture2DArray(u_texture, v_texCoord);
+#else
     gl_FragColor = v_color * texture2D(u_texture, v_texCoord);
+#endif
 }
\ No newline at end of file
@@ -1,13 +1,21 @@
 // Attributes
 attribute vec3 a_position;
+#if defined(TEXTURE_ARRAY)
+attribute vec3 a_texCoord;                      // The third coordinate is the layer of the texture array
+#else
 attribute vec2 a_texCoord;
+#endif
 attribute vec4 a_color;
 
 // Uniforms
 uniform mat4 u_projectionMatrix;
 
 // Varyings
+#if defined(TEXTURE_ARRAY)
+varying vec3 v_texCoord;
+#else
 varying vec2 v_texCoord;
+#endif
 varying vec4 v_color;
 
 
@@ -0,0 +1,39 @@
+// Attributes
+attribute vec4 a_position;									// Vertex Position							(x, y, z, w)
+attribute vec3 a_normal;									// Vertex Normal							(x, y, z)
+attribute vec2 a_texCoord0;									// Vertex Texture Coordinate				(u, v)
+#if !defined(INSTANCING_UNIFORM)
+attribute mat4 a_instanceMatrix;							// Instance world matrix
+attribute vec4 a_instanceData;								// Instance rank, from 0 (drawn farthest) to 1 (drawn nearest)
+#endif
+
+// Uniforms
+uniform mat4 u_viewProjectionMatrix;						// Matrix to transform a world position to clip space
+#if defined(INSTANCING_UNIFORM)
+uniform mat4 u_instanceMatrix;								// Instance world matrix (when hardware instancing is unavailable)
+uniform vec4 u_instanceData;								// Instance rank (when hardware instancing is unavailable)
+#define a_instanceMatrix u_instanceMatrix
+#define a_instanceData u_instanceData
+#endif
+uniform vec3 u_cameraPosition;								// Position of the camera in world space
+uniform vec2 u_fadeDistance;								// Distances at which instances start thinning out and are all gone
+
+// Varyings
+varying vec2 v_texCoord0;									// Texture Coordinate
+varying vec3 v_normalVector;								// Normal vector in world space
+
+
+void main()
+{
+    // Each instance is drawn up to a distance between the fade distances picked by its rank, and
+    // shrinks into the ground over the last quarter of the fade range before it.
+    vec3 origin = a_instanceMatrix[3].xyz;
+    float range = u_fadeDistance.y - u_fadeDistance.x;
+    float cutoff = u_fadeDistance.y - range * a_instanceData.x;
+    float size = clamp((cutoff - distance(origin, u_cameraPosition)) / (range * 0.25 + 0.001), 0.0, 1.0);
+
+    vec4 position = vec4(a_position.xyz * size, 1.0);
+    gl_Position = u_viewProjectionMatrix * (a_instanceMatrix * position);
+    v_normalVector = (a_instanceMatrix * vec4(a_normal, 0.0)).xyz;
+    v_texCoord0 = a_texCoord0;
+}
@@ -1,3 +1,6 @@
+#if defined(TEXTURE_ARRAY)
+#extension GL_EXT_texture_array : enable
+#endif
 #ifdef OPENGL_ES
 precision highp float;
 #endif
@@ -10,7 +13,16 @@ uniform vec3 u_lightDirection;					// Light direction
 uniform float u_row;                            // Patch row
 uniform float u_column;                         // Patch column
 #endif
+#if defined(TEXTURE_ARRAY)
 #if (LAYER_COUNT > 0)
+uniform sampler2DArray u_layerArray;            // Surface layer textures
+uniform vec4 u_layers[LAYER_COUNT];             // Texture repeat (xy) and array layer (z) of each layer
+#endif
+#if (LAYER_COUNT > 1)
+uniform sampler2D u_blendMaps[LAYER_COUNT - 1]; // Blend map of each layer after the first
+uniform vec4 u_blendChannels[LAYER_COUNT - 1];  // Blend map channel mask of each layer after the first
+#endif
+#elif (LAYER_COUNT > 0)
 uniform sampler2D u_samplers[SAMPLER_COUNT];    // Surface layer samplers
 #endif
 #if defined (NORMAL_MAP)
@@ -24,6 +36,7 @@ vec3 v_normalVector;                            // Normal vector variable (from
 varying vec3 v_normalVector;					// Normal vector from vertex shader
 #endif
 varying vec2 v_texCoord0;
+#if !defined(TEXTURE_ARRAY)
 #if (LAYER_COUNT > 0)
 varying vec2 v_texCoordLayer0;
 #endif
@@ -33,12 +46,19 @@ varying vec2 v_texCoordLayer1;
 #if (LAYER_COUNT > 2)
 varying vec2 v_texCoordLayer2;
 #endif
+#endif
 
 // Lighting
 #include "lighting.frag"
 #include "lighting-directional.frag"
 
-#if (LAYER_COUNT > 1)
+#if defined(TEXTURE_ARRAY) && (LAYER_COUNT > 0)
+vec3 sampleLayer(vec4 layer)
+{
+    // The array repeats, so texture coordinates need no wrapping
+    return texture2DArray(u_layerArray, vec3(v_texCoord0 * layer.xy, layer.z)).rgb;
+}
+#elif (LAYER_COUNT > 1)
 void blendLayer(sampler2D textureMap, vec2 texCoord, float alphaBlend)
 {
     // Sample full intensity diffuse color
@@ -50,7 +70,17 @@ void blendLayer(sampler2D textureMap, vec2 texCoord, float alphaBlend)
 
 void main()
 {
-#if (LAYER_COUNT > 0)
+#if defined(TEXTURE_ARRAY) && (LAYER_COUNT > 0)
+    // Sample base layer, then blend the other layers over it
+    _baseColor.rgb = sampleLayer(u_layers[0]);
+    _baseColor.a = 1.0;
+#if (LAYER_COUNT > 1)
+    _baseColor.rgb = mix(_baseColor.rgb, sampleLayer(u_layers[1]), dot(texture2D(u_blendMaps[0], v_texCoord0), u_blendChannels[0]));
+#endif
+#if (LAYER_COUNT > 2)
+    _baseColor.rgb = mix(_baseColor.rgb, sampleLayer(u_layers[2]), dot(texture2D(u_blendMaps[1], v_texCoord0), u_blendChannels[1]));
+#endif
+#elif (LAYER_COUNT > 0)
     // Sample base texture
 	_baseColor.rgb = texture2D(u_samplers[TEXTURE_INDEX_0], mod(v_texCoordLayer0, vec2(1,1))).rgb;
     _baseColor.a = 1.0;
@@ -59,10 +89,10 @@ void main()
     _baseColor = vec4(1,1,1,1);
 #endif
 
-#if (LAYER_COUNT > 1)
+#if !defined(TEXTURE_ARRAY) && (LAYER_COUNT > 1)
     blendLayer(u_samplers[TEXTURE_INDEX_1], v_texCoordLayer1, texture2D(u_samplers[BLEND_INDEX_1], v_texCoord0)[BLEND_CHANNEL_1]);
 #endif
-#if (LAYER_COUNT > 2)
+#if !defined(TEXTURE_ARRAY) && (LAYER_COUNT > 2)
     blendLayer(u_samplers[TEXTURE_INDEX_2], v_texCoordLayer2, texture2D(u_samplers[BLEND_INDEX_2], v_texCoord0)[BLEND_CHANNEL_2]);
 #endif
 
@@ -4,6 +4,9 @@ attribute vec4 a_position;									// Vertex Position							(x, y, z, w)
 attribute vec3 a_normal;									// Vertex Normal							(x, y, z)
 #endif
 attribute vec2 a_texCoord0;
+#if defined(GEOMORPHING)
+attribute vec2 a_texCoord1;                                 // Morph height offset and level            (dh, level)
+#endif
 
 // Uniforms
 uniform mat4 u_worldViewProjectionMatrix;					// World view projection matrix
@@ -11,12 +14,16 @@ uniform mat4 u_worldViewProjectionMatrix;					// World view projection matrix
 uniform mat4 u_normalMatrix;					            // Matrix used for normal vector transformation
 #endif
 uniform vec3 u_lightDirection;								// Direction of light
+#if defined(GEOMORPHING)
+uniform vec2 u_morph;                                       // Drawn level and morph towards the next   (level, factor)
+#endif
 
 // Varyings
 #ifndef NORMAL_MAP
 varying vec3 v_normalVector;								// Normal vector out
 #endif
 varying vec2 v_texCoord0;
+#if !defined(TEXTURE_ARRAY)
 #if LAYER_COUNT > 0
 varying vec2 v_texCoordLayer0;
 #endif
@@ -26,11 +33,19 @@ varying vec2 v_texCoordLayer1;
 #if LAYER_COUNT > 2
 varying vec2 v_texCoordLayer2;
 #endif
+#endif
 
 void main()
 {
+    vec4 position = a_position;
+
+#if defined(GEOMORPHING)
+    // Move the vertices that the next level drops onto its surface.
+    position.y += a_texCoord1.x * u_morph.y * (1.0 - step(0.5, abs(a_texCoord1.y - u_morph.x)));
+#endif
+
     // Transform position to clip space.
-    gl_Position = u_worldViewProjectionMatrix * a_position;
+    gl_Position = u_worldViewProjectionMatrix * position;
 
 #ifndef NORMAL_MAP
     // Pass normal to fragment shader
@@ -40,7 +55,8 @@ void main()
     // Pass base texture coord
     v_texCoord0 = a_texCoord0;
 
-    // Pass repeated texture coordinates for each layer
+    // Pass repeated texture coordinates for each layer (texture arrays repeat them per pixel)
+#if !defined(TEXTURE_ARRAY)
 #if LAYER_COUNT > 0
     v_texCoordLayer0 = a_texCoord0 * TEXTURE_REPEAT_0;
 #endif
@@ -50,4 +66,5 @@ void main()
 #if LAYER_COUNT > 2
     v_texCoordLayer2 = a_texCoord0 * TEXTURE_REPEAT_2;
 #endif
+#endif
 }
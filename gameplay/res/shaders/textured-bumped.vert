@@ -20,8 +20,15 @@ uniform mat4 u_worldViewMatrix;								// Matrix to tranform a position to view
 uniform mat4 u_worldMatrix;								    // Matrix to tranform a position to world space
 #endif
 #if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
 #endif
+#endif
 #if defined(SPECULAR)
 uniform vec3 u_cameraPosition;                 				// Position of the camera in view space
 #endif
@@ -8,12 +8,30 @@ attribute vec2 a_texCoord1;                                 // Second tex coord
 attribute vec4 a_blendWeights;								// Vertex blend weight, up to 4				(0, 1, 2, 3) 
 attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette	(0, 1, 2, 3)
 #endif
+#if defined(INSTANCED) && !defined(INSTANCING_UNIFORM)
+attribute mat4 a_instanceMatrix;							// Instance world matrix
+#endif
 
 // Uniforms
+#if defined(INSTANCED)
+uniform mat4 u_viewProjectionMatrix;						// Matrix to transform a world position to clip space
+#if defined(INSTANCING_UNIFORM)
+uniform mat4 u_instanceMatrix;								// Instance world matrix (when hardware instancing is unavailable)
+#define a_instanceMatrix u_instanceMatrix
+#endif
+#else
 uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space
+#endif
 #if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
 #endif
+#endif
 #if defined(TEXTURE_REPEAT)
 uniform vec2 u_textureRepeat;								// Texture repeat for tiling
 #endif
@@ -41,7 +59,11 @@ void main()
     vec4 position = getPosition();
 
     // Transform position to clip space.
+    #if defined(INSTANCED)
+    gl_Position = u_viewProjectionMatrix * (a_instanceMatrix * position);
+    #else
     gl_Position = u_worldViewProjectionMatrix * position;
+    #endif
 
     // Texture transformation.
     v_texCoord0 = a_texCoord0;
@@ -6,7 +6,11 @@ precision highp float;
 
 // Uniforms
 uniform sampler2D u_diffuseTexture;             // Diffuse map texture
+#if defined(LIGHT_PROBES)
+uniform vec4 u_lightProbe[3];                   // Baked irradiance per color channel, in view space
+#else
 uniform vec3 u_ambientColor;                    // Ambient color
+#endif
 uniform vec3 u_lightColor;                      // Light color
 uniform vec3 u_lightDirection;					// Light direction
 #if defined(SPECULAR)
@@ -22,7 +26,9 @@ uniform float u_modulateAlpha;              	// Modulation alpha
 // Varyings
 varying vec3 v_normalVector;                    // Normal vector in view space
 varying vec2 v_texCoord;                        // Texture coordinate
-#if defined(POINT_LIGHT)
+#if defined(CLUSTERED_LIGHTING) || defined(FORWARD_LIGHTING)
+varying vec3 v_positionViewSpace;               // Position in view space.
+#elif defined(POINT_LIGHT)
 varying vec3 v_vertexToPointLightDirection;		// Light direction w.r.t current vertex in tangent space.
 varying float v_pointLightAttenuation;			// Attenuation of point light.
 #elif defined(SPOT_LIGHT)
@@ -35,10 +41,20 @@ varying vec3 v_lightDirection;					// Direction of light in tangent space.
 #if defined(SPECULAR)
 varying vec3 v_cameraDirection;                 // Camera direction
 #endif
+#if defined(SHADOWS)
+varying vec4 v_shadowPosition;                  // World position and view depth
+#endif
 
 // Lighting 
+#if defined(SHADOWS)
+#include "shadows.frag"
+#endif
 #include "lighting.frag"
-#if defined(POINT_LIGHT)
+#if defined(CLUSTERED_LIGHTING)
+#include "lighting-clustered.frag"
+#elif defined(FORWARD_LIGHTING)
+#include "lighting-forward.frag"
+#elif defined(POINT_LIGHT)
 #include "lighting-point.frag"
 #elif defined(SPOT_LIGHT)
 uniform float u_spotLightInnerAngleCos;			// The bright spot [0.0 - 1.0]
@@ -12,12 +12,22 @@ attribute vec4 a_blendIndices;								// Vertex blend index int u_matrixPalette
 // Uniforms
 uniform mat4 u_worldViewProjectionMatrix;					// Matrix to transform a position to clip space
 uniform mat4 u_inverseTransposeWorldViewMatrix;				// Matrix to transform a normal to view space
-#if defined(SPECULAR) || defined(SPOT_LIGHT) || defined(POINT_LIGHT)
+#if defined(SPECULAR) || defined(SPOT_LIGHT) || defined(POINT_LIGHT) || defined(CLUSTERED_LIGHTING) || defined(FORWARD_LIGHTING) || defined(SHADOWS)
 uniform mat4 u_worldViewMatrix;								// Matrix to tranform a position to view space
 #endif
+#if defined(SHADOWS)
+uniform mat4 u_worldMatrix;									// Matrix to transform a position to world space
+#endif
 #if defined(SKINNING)
+#if defined(SKINNING_TEXTURE)
+uniform sampler2D u_matrixPalette;						// Matrix palettes of the skins drawn in the frame
+uniform float u_matrixPaletteOffset;					// Texel of the first row of this skin's palette
+#elif defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 2];		// Array of dual quaternions
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];		// Array of 4x3 matrices
 #endif
+#endif
 #if defined(SPECULAR)
 uniform vec3 u_cameraPosition;                 				// Position of the camera in view space
 #endif
@@ -43,7 +53,13 @@ varying vec2 v_texCoord;									// Texture coordinate
 #if defined(SPECULAR)
 varying vec3 v_cameraDirection;								// Direction the camera is looking at in tangent space
 #endif
-#if defined(POINT_LIGHT)
+#if defined(SHADOWS)
+varying vec4 v_shadowPosition;								// World position and view depth for shadow lookups
+#endif
+#if defined(CLUSTERED_LIGHTING) || defined(FORWARD_LIGHTING)
+varying vec3 v_positionViewSpace;							// Position in view space
+#include "lighting-clustered.vert"
+#elif defined(POINT_LIGHT)
 varying vec3 v_vertexToPointLightDirection;					// Direction of point light w.r.t current vertex in tangent space
 varying float v_pointLightAttenuation;						// Attenuation of point light
 #include "lighting-point.vert"
@@ -81,6 +97,11 @@ void main()
     // Apply light.
     applyLight(position);
 
+    // Pass the position to the shadow lookups.
+    #if defined(SHADOWS)
+    v_shadowPosition = vec4((u_worldMatrix * position).xyz, -(u_worldViewMatrix * position).z);
+    #endif
+
     // Texture transformation
     v_texCoord = a_texCoord;
     #if defined(TEXTURE_REPEAT)
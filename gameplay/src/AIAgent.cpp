@@ -1,20 +1,24 @@
 #include "Base.h"
 #include "AIAgent.h"
 #include "Node.h"
+#include "Game.h"
 
 namespace gameplay
 {
 
 AIAgent::AIAgent()
-    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _next(NULL)
+    : _stateMachine(NULL), _node(NULL), _enabled(true), _listener(NULL), _next(NULL), _updateInterval(0.0f), _pendingTime(0.0f),
+      _pathState(PATH_NONE), _pathRequest(NULL)
 {
     _stateMachine = new AIStateMachine(this);
 
     addScriptEvent("message", "<AIMessage>");
+    addScriptEvent("pathFinished", "<AIAgent>b");
 }
 
 AIAgent::~AIAgent()
 {
+    clearPath();
     SAFE_DELETE(_stateMachine);
 }
 
@@ -56,11 +60,77 @@ void AIAgent::setListener(Listener* listener)
     _listener = listener;
 }
 
+float AIAgent::getUpdateInterval() const
+{
+    return _updateInterval;
+}
+
+void AIAgent::setUpdateInterval(float interval)
+{
+    _updateInterval = std::max(0.0f, interval);
+}
+
+bool AIAgent::findPath(const Vector3& destination)
+{
+    clearPath();
+    if (_node == NULL)
+        return false;
+
+    _pathRequest = Game::getInstance()->getAIController()->requestPath(this, _node->getTranslationWorld(), destination);
+    if (_pathRequest == NULL)
+        return false;
+    _pathState = PATH_PENDING;
+    return true;
+}
+
+AIAgent::PathState AIAgent::getPathState() const
+{
+    return _pathState;
+}
+
+const std::vector<Vector3>& AIAgent::getPath() const
+{
+    return _path;
+}
+
+void AIAgent::clearPath()
+{
+    // The controller deletes the request once it sees it was dropped.
+    if (_pathRequest)
+    {
+        _pathRequest->agent = NULL;
+        _pathRequest = NULL;
+    }
+    _pathState = PATH_NONE;
+    _path.clear();
+}
+
+void AIAgent::pathFinished(bool found)
+{
+    _pathRequest = NULL;
+    _pathState = found ? PATH_FOUND : PATH_FAILED;
+
+    if (_listener)
+        _listener->pathFinished(this, found);
+    fireScriptEvent<void>("pathFinished", this, found);
+}
+
 void AIAgent::update(float elapsedTime)
 {
     _stateMachine->update(elapsedTime);
 }
 
+bool AIAgent::isThreadSafe() const
+{
+    AIState* state = _stateMachine->getActiveState();
+    return state && state->isThreadSafe();
+}
+
+bool AIAgent::hasMessageListeners() const
+{
+    return _listener != NULL || hasScriptCallbacks("message");
+}
+
 bool AIAgent::processMessage(AIMessage* message)
 {
     // Handle built-in message types.
@@ -5,6 +5,7 @@
 #include "AIStateMachine.h"
 #include "AIMessage.h"
 #include "ScriptTarget.h"
+#include "Vector3.h"
 
 namespace gameplay
 {
@@ -23,6 +24,7 @@ class AIAgent : public Ref, public ScriptTarget
 {
     friend class Node;
     friend class AIController;
+    friend class AIStateMachine;
 
 public:
 
@@ -53,6 +55,28 @@ public:
          * @return true to mark the message as handled, false otherwise.
          */
         virtual bool messageReceived(AIMessage* message) = 0;
+
+        /**
+         * Called when the search of the path requested with AIAgent::findPath finishes.
+         *
+         * @param agent The agent.
+         * @param found true if the path was found, false if the destination cannot be reached.
+         * @script{ignore}
+         */
+        virtual void pathFinished(AIAgent* agent, bool found) { };
+    };
+
+    /**
+     * The states of the path of an agent.
+     *
+     * @script{ignore}
+     */
+    enum PathState
+    {
+        PATH_NONE,
+        PATH_PENDING,
+        PATH_FOUND,
+        PATH_FAILED
     };
 
     /**
@@ -118,8 +142,80 @@ public:
      */
     void setListener(Listener* listener);
 
+    /**
+     * Returns the time between two updates of the AIAgent.
+     *
+     * @return The update interval, in milliseconds.
+     */
+    float getUpdateInterval() const;
+
+    /**
+     * Sets the time between two updates of the AIAgent.
+     *
+     * Agents that do not need to think every frame can be updated less often. The
+     * elapsed time passed to the state update is then the time since the last update
+     * of the agent. Agents can also be updated later than their interval when the
+     * AIController runs out of its per-frame budget.
+     *
+     * @param interval The update interval in milliseconds, or 0 to update the agent every frame.
+     */
+    void setUpdateInterval(float interval);
+
+    /**
+     * Requests a path from the node of the agent to a destination, on the navigation mesh of the AIController.
+     *
+     * The path is searched on worker threads over the next frames (see AIController::setNavigationMesh).
+     * Once the search finishes, the path state becomes PATH_FOUND or PATH_FAILED and the listener is
+     * notified, before the agent is next updated. A new request replaces the pending one. Paths can be
+     * requested from states that are updated in parallel.
+     *
+     * @param destination The destination, in world space.
+     *
+     * @return false if the agent has no node or the controller has no navigation mesh.
+     * @script{ignore}
+     */
+    bool findPath(const Vector3& destination);
+
+    /**
+     * Gets the state of the path requested with findPath.
+     *
+     * @return The path state.
+     * @script{ignore}
+     */
+    PathState getPathState() const;
+
+    /**
+     * Gets the path found for the agent, from the position of its node to the destination,
+     * through the corners of the walkable surface it turns around.
+     *
+     * @return The points of the path, or an empty list if no path was found.
+     * @script{ignore}
+     */
+    const std::vector<Vector3>& getPath() const;
+
+    /**
+     * Clears the path of the agent and drops its pending path request.
+     *
+     * @script{ignore}
+     */
+    void clearPath();
+
 private:
 
+    /**
+     * A path requested by an agent, owned by the AIController until it is delivered.
+     */
+    struct PathRequest
+    {
+        AIAgent* agent;             // NULL once the agent dropped the request.
+        Vector3 start;
+        Vector3 end;
+        int startTriangle;
+        bool done;
+        bool found;
+        std::vector<Vector3> path;
+    };
+
     /**
      * Constructor.
      */
@@ -156,11 +252,31 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Determines whether the active state of the agent can be updated on a worker thread.
+     */
+    bool isThreadSafe() const;
+
+    /**
+     * Determines whether the agent has a listener or a script handler for its messages.
+     */
+    bool hasMessageListeners() const;
+
+    /**
+     * Called by the AIController once the path requested by the agent is searched and stored in it.
+     */
+    void pathFinished(bool found);
+
     AIStateMachine* _stateMachine;
     Node* _node;
     bool _enabled;
     Listener* _listener;
     AIAgent* _next;
+    float _updateInterval;
+    float _pendingTime;         // The time elapsed since the last update of the agent.
+    PathState _pathState;
+    std::vector<Vector3> _path;
+    PathRequest* _pathRequest;
 
 };
 
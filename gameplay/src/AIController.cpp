@@ -2,11 +2,18 @@
 #include "AIController.h"
 #include "Game.h"
 
+// Triangles each path search expands per frame.
+#define AI_DEFAULT_PATH_ITERATIONS 1024
+
+// Searches kept for agents heading to the same destinations.
+#define AI_DEFAULT_PATH_CACHE 16
+
 namespace gameplay
 {
 
 AIController::AIController()
-    : _paused(false), _firstMessage(NULL), _firstAgent(NULL)
+    : _paused(false), _messageSequence(0), _firstAgent(NULL), _budget(0.0f), _deferMessages(false),
+      _navigationMesh(NULL), _pathIterations(AI_DEFAULT_PATH_ITERATIONS), _pathCacheSize(AI_DEFAULT_PATH_CACHE), _pathFrame(0)
 {
 }
 
@@ -14,12 +21,55 @@ AIController::~AIController()
 {
 }
 
-void AIController::initialize()
+void AIController::initialize(Properties* properties)
+{
+    if (properties && properties->exists("budget"))
+    {
+        _budget = std::max(0.0f, properties->getFloat("budget"));
+    }
+    if (properties && properties->exists("pathIterations"))
+    {
+        _pathIterations = (unsigned int)std::max(1, properties->getInt("pathIterations"));
+    }
+    if (properties && properties->exists("pathCache"))
+    {
+        _pathCacheSize = (unsigned int)std::max(1, properties->getInt("pathCache"));
+    }
+}
+
+float AIController::getBudget() const
+{
+    return _budget;
+}
+
+void AIController::setBudget(float budget)
+{
+    _budget = std::max(0.0f, budget);
+}
+
+NavigationMesh* AIController::getNavigationMesh() const
 {
+    return _navigationMesh;
+}
+
+void AIController::setNavigationMesh(NavigationMesh* mesh)
+{
+    if (mesh == _navigationMesh)
+        return;
+
+    clearPaths(true);
+    if (mesh)
+        mesh->addRef();
+    SAFE_RELEASE(_navigationMesh);
+    _navigationMesh = mesh;
 }
 
 void AIController::finalize()
 {
+    // Drop the path searches, leaving the agents without paths.
+    clearPaths(false);
+    SAFE_RELEASE(_navigationMesh);
+
     // Remove all agents
     AIAgent* agent = _firstAgent;
     while (agent)
@@ -31,14 +81,12 @@ void AIController::finalize()
     _firstAgent = NULL;
 
     // Remove all messages
-    AIMessage* message = _firstMessage;
-    while (message)
+    for (size_t i = 0, count = _pendingMessages.size(); i < count; ++i)
     {
-        AIMessage* temp = message;
-        message = message->_next;
-        AIMessage::destroy(temp);
+        AIMessage::destroy(_pendingMessages[i].message);
     }
-    _firstMessage = NULL;
+    _pendingMessages.clear();
+    AIMessage::clearPool();
 }
 
 void AIController::pause()
@@ -53,6 +101,17 @@ void AIController::resume()
 
 void AIController::sendMessage(AIMessage* message, float delay)
 {
+    // Messages sent by agents updated in parallel are delivered on the main thread afterwards.
+    if (_deferMessages)
+    {
+        DeferredMessage deferred;
+        deferred.message = message;
+        deferred.delay = delay;
+        MutexLock lock(_deferredMessagesMutex);
+        _deferredMessages.push_back(deferred);
+        return;
+    }
+
     if (delay <= 0)
     {
         // Send instantly
@@ -87,51 +146,121 @@ void AIController::sendMessage(AIMessage* message, float delay)
     else
     {
         // Queue for later delivery
-        if (_firstMessage)
-            message->_next = _firstMessage;
-        _firstMessage = message;
+        PendingMessage pending;
+        pending.deliveryTime = Game::getInstance()->getGameTime() + delay;
+        pending.sequence = _messageSequence++;
+        pending.message = message;
+        message->_deliveryTime = pending.deliveryTime;
+        _pendingMessages.push_back(pending);
+        std::push_heap(_pendingMessages.begin(), _pendingMessages.end(), comparePendingMessages);
     }
 }
 
+bool AIController::comparePendingMessages(const PendingMessage& a, const PendingMessage& b)
+{
+    // The heap keeps the greatest element first, so later messages compare as smaller.
+    if (a.deliveryTime != b.deliveryTime)
+        return a.deliveryTime > b.deliveryTime;
+    return (int)(a.sequence - b.sequence) > 0;
+}
+
 void AIController::update(float elapsedTime)
 {
+    GP_PROFILE_SCOPE("AIController::update");
+
     if (_paused)
         return;
 
     static Game* game = Game::getInstance();
 
-    // Send all pending messages that have expired
-    AIMessage* prevMsg = NULL;
-    AIMessage* msg = _firstMessage;
-    while (msg)
+    // Hand the paths found since the last frame over to their agents before they update.
+    finishPaths();
+    deliverPaths();
+
+    // Send all pending messages that have expired, soonest first (this also deletes them).
+    // Messages sent while delivering are queued on the heap and delivered in turn once they expire.
+    double gameTime = game->getGameTime();
+    while (!_pendingMessages.empty() && _pendingMessages.front().deliveryTime <= gameTime)
     {
-        // If the message delivery time has expired, send it (this also deletes it)
-        if (msg->getDeliveryTime() >= game->getGameTime())
-        {
-            // Link the message out of our list
-            if (prevMsg)
-                prevMsg->_next = msg->_next;
+        std::pop_heap(_pendingMessages.begin(), _pendingMessages.end(), comparePendingMessages);
+        AIMessage* message = _pendingMessages.back().message;
+        _pendingMessages.pop_back();
+        sendMessage(message);
+    }
 
-            AIMessage* temp = msg;
-            msg = msg->_next;
-            temp->_next = NULL;
-            sendMessage(temp);
-        }
+    // Gather the enabled agents whose update interval has elapsed.
+    _parallelAgents.clear();
+    _serialAgents.clear();
+    for (AIAgent* agent = _firstAgent; agent; agent = agent->_next)
+    {
+        if (!agent->isEnabled())
+            continue;
+
+        agent->_pendingTime += elapsedTime;
+        if (agent->_pendingTime < agent->_updateInterval)
+            continue;
+
+        if (agent->isThreadSafe())
+            _parallelAgents.push_back(agent);
         else
+            _serialAgents.push_back(agent);
+    }
+
+    // Update the agents whose active state is thread safe in parallel.
+    if (!_parallelAgents.empty())
+    {
+        _deferMessages = true;
+        game->getJobScheduler()->parallelFor((unsigned int)_parallelAgents.size(), updateAgents, &_parallelAgents, 16);
+        _deferMessages = false;
+
+        for (size_t i = 0, count = _parallelAgents.size(); i < count; ++i)
         {
-            prevMsg = msg;
-            msg = msg->_next;
+            _parallelAgents[i]->_stateMachine->applyPendingState();
         }
+        for (size_t i = 0; i < _deferredMessages.size(); ++i)
+        {
+            sendMessage(_deferredMessages[i].message, _deferredMessages[i].delay);
+        }
+        _deferredMessages.clear();
     }
 
-    // Update all enabled agents
-    AIAgent* agent = _firstAgent;
-    while (agent)
+    // Update the other agents, those that waited longest first, until the budget is used up.
+    double end = 0;
+    if (_budget > 0.0f)
+    {
+        std::sort(_serialAgents.begin(), _serialAgents.end(), compareAgents);
+        end = Game::getAbsoluteTime() + _budget;
+    }
+    for (size_t i = 0, count = _serialAgents.size(); i < count; ++i)
     {
-        if (agent->isEnabled())
-            agent->update(elapsedTime);
+        if (i > 0 && _budget > 0.0f && Game::getAbsoluteTime() >= end)
+            break;
 
-        agent = agent->_next;
+        AIAgent* agent = _serialAgents[i];
+        float pendingTime = agent->_pendingTime;
+        agent->_pendingTime = 0.0f;
+        agent->update(pendingTime);
+    }
+
+    // Search the paths requested so far on the job scheduler while the rest of the frame runs.
+    startPaths();
+    deliverPaths();
+}
+
+bool AIController::compareAgents(const AIAgent* a, const AIAgent* b)
+{
+    return a->_pendingTime > b->_pendingTime;
+}
+
+void AIController::updateAgents(unsigned int start, unsigned int end, void* cookie)
+{
+    std::vector<AIAgent*>& agents = *static_cast<std::vector<AIAgent*>*>(cookie);
+    for (unsigned int i = start; i < end; ++i)
+    {
+        AIAgent* agent = agents[i];
+        float pendingTime = agent->_pendingTime;
+        agent->_pendingTime = 0.0f;
+        agent->update(pendingTime);
     }
 }
 
@@ -169,6 +298,217 @@ void AIController::removeAgent(AIAgent* agent)
     }
 }
 
+AIAgent::PathRequest* AIController::requestPath(AIAgent* agent, const Vector3& start, const Vector3& end)
+{
+    if (_navigationMesh == NULL)
+        return NULL;
+
+    AIAgent::PathRequest* request = new AIAgent::PathRequest();
+    request->agent = agent;
+    request->start = start;
+    request->end = end;
+    request->startTriangle = -1;
+    request->done = false;
+    request->found = false;
+
+    // Agents updated in parallel request their paths concurrently.
+    MutexLock lock(_newPathsMutex);
+    _newPaths.push_back(request);
+    return request;
+}
+
+void AIController::finishPaths()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, searchCount = _pathSearches.size(); i < searchCount; ++i)
+    {
+        PathSearch* search = _pathSearches[i];
+        if (search->job)
+        {
+            scheduler->wait(search->job);
+            search->job = NULL;
+        }
+
+        // Keep the requests still searched for, in the order they were made.
+        std::vector<AIAgent::PathRequest*>& requests = search->requests;
+        size_t count = 0;
+        for (size_t j = 0, requestCount = requests.size(); j < requestCount; ++j)
+        {
+            AIAgent::PathRequest* request = requests[j];
+            if (request->done || request->agent == NULL)
+                _finishedPaths.push_back(request);
+            else
+                requests[count++] = request;
+        }
+        requests.resize(count);
+    }
+}
+
+void AIController::startPaths()
+{
+    ++_pathFrame;
+
+    std::vector<AIAgent::PathRequest*> requests;
+    {
+        MutexLock lock(_newPathsMutex);
+        requests.swap(_newPaths);
+    }
+
+    for (size_t i = 0, count = requests.size(); i < count; ++i)
+    {
+        AIAgent::PathRequest* request = requests[i];
+        request->done = true;
+        if (request->agent == NULL || _navigationMesh == NULL)
+        {
+            _finishedPaths.push_back(request);
+            continue;
+        }
+
+        // Requests for points off the mesh fail at once.
+        int goal = _navigationMesh->findTriangle(request->end);
+        request->startTriangle = _navigationMesh->findTriangle(request->start);
+        if (goal < 0 || request->startTriangle < 0)
+        {
+            _finishedPaths.push_back(request);
+            continue;
+        }
+
+        // Share the search of the destination triangle, or start one in place of the least recently used idle search.
+        PathSearch* search = NULL;
+        for (size_t j = 0, searchCount = _pathSearches.size(); j < searchCount; ++j)
+        {
+            if (_pathSearches[j]->search.goal == goal)
+            {
+                search = _pathSearches[j];
+                break;
+            }
+        }
+        if (search == NULL)
+        {
+            if (_pathSearches.size() >= _pathCacheSize)
+            {
+                int oldest = -1;
+                for (size_t j = 0, searchCount = _pathSearches.size(); j < searchCount; ++j)
+                {
+                    if (_pathSearches[j]->requests.empty() && (oldest < 0 || _pathSearches[j]->lastUsed < _pathSearches[oldest]->lastUsed))
+                        oldest = (int)j;
+                }
+                if (oldest >= 0)
+                {
+                    SAFE_DELETE(_pathSearches[oldest]);
+                    _pathSearches.erase(_pathSearches.begin() + oldest);
+                }
+            }
+            search = new PathSearch();
+            search->job = NULL;
+            search->mesh = _navigationMesh;
+            search->iterations = 0;
+            _navigationMesh->beginSearch(&search->search, goal);
+            _pathSearches.push_back(search);
+        }
+        search->lastUsed = _pathFrame;
+
+        // A start the search has already reached has its path at once.
+        unsigned int iterations = 0;
+        NavigationMesh::SearchResult result = _navigationMesh->advanceSearch(&search->search, request->startTriangle, &iterations);
+        if (result == NavigationMesh::SEARCH_PENDING)
+        {
+            request->done = false;
+            search->requests.push_back(request);
+            continue;
+        }
+        request->found = result == NavigationMesh::SEARCH_FOUND;
+        if (request->found)
+            _navigationMesh->buildPath(search->search, request->startTriangle, request->start, request->end, &request->path);
+        _finishedPaths.push_back(request);
+    }
+
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = _pathSearches.size(); i < count; ++i)
+    {
+        PathSearch* search = _pathSearches[i];
+        if (!search->requests.empty())
+        {
+            search->iterations = _pathIterations;
+            search->job = scheduler->submit(searchPaths, search);
+        }
+    }
+}
+
+void AIController::searchPaths(void* cookie)
+{
+    // Only the search and the fields of the requests the main thread leaves alone are touched here.
+    PathSearch* search = static_cast<PathSearch*>(cookie);
+    unsigned int iterations = search->iterations;
+    for (size_t i = 0, count = search->requests.size(); i < count; ++i)
+    {
+        AIAgent::PathRequest* request = search->requests[i];
+        if (request->done)
+            continue;
+
+        NavigationMesh::SearchResult result = search->mesh->advanceSearch(&search->search, request->startTriangle, &iterations);
+        if (result == NavigationMesh::SEARCH_PENDING)
+            break;
+
+        request->found = result == NavigationMesh::SEARCH_FOUND;
+        if (request->found)
+            search->mesh->buildPath(search->search, request->startTriangle, request->start, request->end, &request->path);
+        request->done = true;
+    }
+}
+
+void AIController::clearPaths(bool notify)
+{
+    finishPaths();
+    for (size_t i = 0, count = _pathSearches.size(); i < count; ++i)
+    {
+        PathSearch* search = _pathSearches[i];
+        _finishedPaths.insert(_finishedPaths.end(), search->requests.begin(), search->requests.end());
+        SAFE_DELETE(search);
+    }
+    _pathSearches.clear();
+    {
+        MutexLock lock(_newPathsMutex);
+        _finishedPaths.insert(_finishedPaths.end(), _newPaths.begin(), _newPaths.end());
+        _newPaths.clear();
+    }
+
+    // The requests that did not find their path fail.
+    for (size_t i = 0, count = _finishedPaths.size(); i < count; ++i)
+    {
+        AIAgent::PathRequest* request = _finishedPaths[i];
+        if (!request->done)
+        {
+            request->done = true;
+            request->found = false;
+            request->path.clear();
+        }
+        if (!notify && request->agent)
+        {
+            request->agent->clearPath();
+        }
+    }
+    deliverPaths();
+}
+
+void AIController::deliverPaths()
+{
+    // The agents may request new paths when notified; those are queued for the next searches.
+    std::vector<AIAgent::PathRequest*> finished;
+    finished.swap(_finishedPaths);
+    for (size_t i = 0, count = finished.size(); i < count; ++i)
+    {
+        AIAgent::PathRequest* request = finished[i];
+        AIAgent* agent = request->agent;
+        if (agent)
+        {
+            agent->_path.swap(request->path);
+            agent->pathFinished(request->found);
+        }
+        SAFE_DELETE(request);
+    }
+}
+
 AIAgent* AIController::findAgent(const char* id) const
 {
     GP_ASSERT(id);
@@ -3,6 +3,10 @@
 
 #include "AIAgent.h"
 #include "AIMessage.h"
+#include "NavigationMesh.h"
+#include "JobScheduler.h"
+#include "Properties.h"
+#include "Thread.h"
 
 namespace gameplay
 {
@@ -11,11 +15,38 @@ namespace gameplay
  * The AIController facilitates state machine execution and message passing
  * between AI objects in the game. This class is generally not interfaced
  * with directly.
+ *
+ * Every frame, the controller updates the enabled agents whose update interval
+ * has elapsed (see AIAgent::setUpdateInterval). Agents whose active state is
+ * thread safe (see AIState::setThreadSafe) are updated in parallel on the job
+ * scheduler. The other agents are updated on the main thread, those that have
+ * waited longest first, until the per-frame budget is used up; the rest wait for
+ * the next frame.
+ *
+ * Agents find their paths on the navigation mesh of the controller (see setNavigationMesh and
+ * AIAgent::findPath). The paths are searched on the job scheduler while the rest of the frame
+ * runs, and each search expands a limited number of triangles per frame, so long paths take
+ * several frames but never stall a thread. A search starts from the destination and is kept
+ * once its paths are found: the path of an agent heading to the same destination triangle from
+ * a triangle the search has already reached is found at once, and from anywhere else the search
+ * resumes where it stopped. The most recently used searches are kept, up to the path cache size.
+ *
+ * The budgets are configured in the game config:
+ *
+ * @verbatim
+    ai
+    {
+        budget = 2              // Milliseconds of serial agent updates per frame, or 0 for no limit.
+        pathIterations = 1024   // Triangles each path search expands per frame (default 1024).
+        pathCache = 16          // Searches kept for agents heading to the same destinations (default 16).
+    }
+   @endverbatim
  */
 class AIController
 {
     friend class Game;
     friend class Node;
+    friend class AIStateMachine;
 
 public:
 
@@ -43,8 +74,76 @@ public:
      */
     AIAgent* findAgent(const char* id) const;
 
+    /**
+     * Returns the time the controller spends updating agents on the main thread each frame.
+     *
+     * @return The budget in milliseconds, or 0 if there is no limit.
+     * @script{ignore}
+     */
+    float getBudget() const;
+
+    /**
+     * Sets the time the controller spends updating agents on the main thread each frame.
+     *
+     * At least one agent is updated per frame, whatever the budget.
+     *
+     * @param budget The budget in milliseconds, or 0 for no limit.
+     * @script{ignore}
+     */
+    void setBudget(float budget);
+
+    /**
+     * Gets the navigation mesh agents find their paths on.
+     *
+     * @return The navigation mesh, or NULL.
+     * @script{ignore}
+     */
+    NavigationMesh* getNavigationMesh() const;
+
+    /**
+     * Sets the navigation mesh agents find their paths on.
+     *
+     * The pending path requests fail and the kept searches are dropped.
+     *
+     * @param mesh The navigation mesh, or NULL.
+     * @script{ignore}
+     */
+    void setNavigationMesh(NavigationMesh* mesh);
+
 private:
 
+    /**
+     * Defines a message waiting to be delivered.
+     */
+    struct PendingMessage
+    {
+        double deliveryTime;
+        unsigned int sequence;  // Orders messages with the same delivery time by the time they were sent.
+        AIMessage* message;
+    };
+
+    /**
+     * Defines a message sent during the parallel agent updates.
+     */
+    struct DeferredMessage
+    {
+        AIMessage* message;
+        float delay;
+    };
+
+    /**
+     * Defines a path search from a destination triangle, with the requests waiting for it.
+     */
+    struct PathSearch
+    {
+        NavigationMesh::Search search;
+        std::vector<AIAgent::PathRequest*> requests;
+        JobScheduler::Job* job;
+        const NavigationMesh* mesh;
+        unsigned int iterations;
+        unsigned int lastUsed;      // The frame the destination was last requested.
+    };
+
     /**
      * Constructor.
      */
@@ -67,8 +166,10 @@ private:
 
     /**
      * Called during startup to initialize the AIController.
+     *
+     * @param properties The 'ai' namespace of the game config, or NULL.
      */
-    void initialize();
+    void initialize(Properties* properties);
 
     /**
      * Called during shutdown to finalize the AIController.
@@ -96,9 +197,67 @@ private:
 
     void removeAgent(AIAgent* agent);
 
+    static bool comparePendingMessages(const PendingMessage& a, const PendingMessage& b);
+
+    static bool compareAgents(const AIAgent* a, const AIAgent* b);
+
+    /**
+     * Updates a range of the thread safe agents (called from a job).
+     */
+    static void updateAgents(unsigned int start, unsigned int end, void* cookie);
+
+    /**
+     * Queues a path request of an agent (thread safe).
+     *
+     * @return The request, or NULL if there is no navigation mesh.
+     */
+    AIAgent::PathRequest* requestPath(AIAgent* agent, const Vector3& start, const Vector3& end);
+
+    /**
+     * Waits for the path searches of the previous frame and gathers the requests they finished.
+     */
+    void finishPaths();
+
+    /**
+     * Assigns the new path requests to searches and starts the searches of the frame.
+     */
+    void startPaths();
+
+    /**
+     * Fails the pending path requests and drops the searches.
+     *
+     * @param notify true to notify the agents, false to only detach the requests from them.
+     */
+    void clearPaths(bool notify);
+
+    /**
+     * Hands the finished path requests over to their agents and deletes them.
+     */
+    void deliverPaths();
+
+    /**
+     * Advances a path search for its waiting requests (called from a job).
+     */
+    static void searchPaths(void* cookie);
+
     bool _paused;
-    AIMessage* _firstMessage;
+    std::vector<PendingMessage> _pendingMessages;   // A heap of the delayed messages, soonest first.
+    unsigned int _messageSequence;
     AIAgent* _firstAgent;
+    float _budget;
+    std::vector<AIAgent*> _parallelAgents;
+    std::vector<AIAgent*> _serialAgents;
+    bool _deferMessages;                            // Messages are sent from the parallel agent updates.
+    std::vector<DeferredMessage> _deferredMessages;
+    Mutex _deferredMessagesMutex;
+    NavigationMesh* _navigationMesh;
+    unsigned int _pathIterations;
+    unsigned int _pathCacheSize;
+    unsigned int _pathFrame;
+    std::vector<PathSearch*> _pathSearches;
+    std::vector<AIAgent::PathRequest*> _newPaths;       // Requested since the searches were started.
+    Mutex _newPathsMutex;
+    std::vector<AIAgent::PathRequest*> _finishedPaths;
 
 };
 
@@ -1,36 +1,107 @@
 #include "Base.h"
 #include "AIMessage.h"
+#include "Thread.h"
+
+// The maximum number of destroyed messages kept for reuse.
+#define AI_MESSAGE_POOL_SIZE 1024
 
 namespace gameplay
 {
 
+// Messages are also created by agents updated on worker threads.
+static Mutex __poolMutex;
+static AIMessage* __freeMessages = NULL;
+static unsigned int __freeMessageCount = 0;
+
 AIMessage::AIMessage()
-    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
+    : _id(0), _deliveryTime(0), _parameters(_inlineParameters), _parameterCount(0), _parameterCapacity(INLINE_PARAMETER_COUNT),
+      _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
 {
 }
 
 AIMessage::~AIMessage()
 {
-    SAFE_DELETE_ARRAY(_parameters);
+    if (_parameters != _inlineParameters)
+    {
+        SAFE_DELETE_ARRAY(_parameters);
+    }
 }
 
 AIMessage* AIMessage::create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount)
 {
-    AIMessage* message = new AIMessage();
+    AIMessage* message;
+    {
+        MutexLock lock(__poolMutex);
+        message = __freeMessages;
+        if (message)
+        {
+            __freeMessages = message->_next;
+            message->_next = NULL;
+            --__freeMessageCount;
+        }
+    }
+    if (message == NULL)
+    {
+        message = new AIMessage();
+    }
+
     message->_id = id;
-    message->_sender = sender;
-    message->_receiver = receiver;
-    message->_parameterCount = parameterCount;
-    if (parameterCount > 0)
+    message->_sender = sender ? sender : "";
+    message->_receiver = receiver ? receiver : "";
+    message->_deliveryTime = 0;
+    message->_messageType = MESSAGE_TYPE_CUSTOM;
+
+    // Messages with few parameters keep them inline, larger arrays are kept while the message is pooled.
+    if (parameterCount > message->_parameterCapacity)
+    {
+        if (message->_parameters != message->_inlineParameters)
+        {
+            SAFE_DELETE_ARRAY(message->_parameters);
+        }
         message->_parameters = new AIMessage::Parameter[parameterCount];
+        message->_parameterCapacity = parameterCount;
+    }
+    message->_parameterCount = parameterCount;
     return message;
 }
 
 void AIMessage::destroy(AIMessage* message)
 {
+    if (message == NULL)
+        return;
+
+    for (unsigned int i = 0; i < message->_parameterCount; ++i)
+    {
+        message->_parameters[i].clear();
+    }
+    message->_parameterCount = 0;
+    message->_strings.clear();
+
+    {
+        MutexLock lock(__poolMutex);
+        if (__freeMessageCount < AI_MESSAGE_POOL_SIZE)
+        {
+            message->_next = __freeMessages;
+            __freeMessages = message;
+            ++__freeMessageCount;
+            return;
+        }
+    }
     SAFE_DELETE(message);
 }
 
+void AIMessage::clearPool()
+{
+    MutexLock lock(__poolMutex);
+    while (__freeMessages)
+    {
+        AIMessage* message = __freeMessages;
+        __freeMessages = message->_next;
+        SAFE_DELETE(message);
+    }
+    __freeMessageCount = 0;
+}
+
 unsigned int AIMessage::getId() const
 {
     return _id;
@@ -146,7 +217,7 @@ const char* AIMessage::getString(unsigned int index) const
     GP_ASSERT(index < _parameterCount);
     GP_ASSERT(_parameters[index].type == AIMessage::STRING);
 
-    return _parameters[index].stringValue;
+    return &_strings[_parameters[index].stringOffset];
 }
 
 void AIMessage::setString(unsigned int index, const char* value)
@@ -156,12 +227,11 @@ void AIMessage::setString(unsigned int index, const char* value)
 
     clearParameter(index);
 
-    // Copy the string into our parameter
+    // Copy the string into the string storage of the message, which keeps its capacity while the message is pooled.
     size_t len = strlen(value);
-    char* buffer = new char[len + 1];
-    strcpy(buffer, value);
-    _parameters[index].stringValue = buffer;
+    _parameters[index].stringOffset = (unsigned int)_strings.size();
     _parameters[index].type = AIMessage::STRING;
+    _strings.insert(_strings.end(), value, value + len + 1);
 }
 
 unsigned int AIMessage::getParameterCount() const
@@ -188,20 +258,8 @@ AIMessage::Parameter::Parameter()
 {
 }
 
-AIMessage::Parameter::~Parameter()
-{
-    clear();
-}
-
 void AIMessage::Parameter::clear()
 {
-    switch (type)
-    {
-    case AIMessage::STRING:
-        SAFE_DELETE_ARRAY(stringValue);
-        break;
-    }
-
     type = AIMessage::UNDEFINED;
 }
 
@@ -1,6 +1,8 @@
 #ifndef AIMESSAGE_H_
 #define AIMESSAGE_H_
 
+#include "Allocator.h"
+
 namespace gameplay
 {
 
@@ -11,6 +13,10 @@ namespace gameplay
  * Messages can store an arbitrary number of parameters. For the sake of simplicity,
  * each parameter is stored as type double, which is flexible enough to store most
  * data that needs to be passed.
+ *
+ * Messages are recycled: destroyed messages are kept in a pool and handed out again
+ * by create(), together with their parameter and string storage, so sending messages
+ * does not allocate once the pool has warmed up.
  */
 class AIMessage
 {
@@ -18,6 +24,8 @@ class AIMessage
     friend class AIController;
     friend class AIStateMachine;
 
+    GP_POOLED_ALLOCATION(AI)
+
 public:
 
     /**
@@ -221,8 +229,6 @@ private:
     {
         Parameter();
 
-        ~Parameter();
-
         void clear();
 
         union
@@ -232,12 +238,17 @@ private:
             float floatValue;
             double doubleValue;
             bool boolValue;
-            char* stringValue;
+            unsigned int stringOffset;  // Offset of the string in the string storage of the message.
         };
 
         AIMessage::ParameterType type;
     };
 
+    /**
+     * The number of parameters stored in the message itself.
+     */
+    static const unsigned int INLINE_PARAMETER_COUNT = 4;
+
     /**
      * Constructor.
      */
@@ -267,14 +278,22 @@ private:
 
     void clearParameter(unsigned int index);
 
+    /**
+     * Deletes the messages kept for reuse.
+     */
+    static void clearPool();
+
     unsigned int _id;
     std::string _sender;
     std::string _receiver;
     double _deliveryTime;
     Parameter* _parameters;
     unsigned int _parameterCount;
+    unsigned int _parameterCapacity;
+    Parameter _inlineParameters[INLINE_PARAMETER_COUNT];
+    std::vector<char> _strings;
     MessageType _messageType;
-    AIMessage* _next;
+    AIMessage* _next;                   // The next message in the pool.
 
 };
 
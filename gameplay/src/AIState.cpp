@@ -1,6 +1,10 @@
 #include "Base.h"
 #include "AIState.h"
 #include "AIStateMachine.h"
+#include "StringTable.h"
+
+// The registry of interned state IDs. IDs are only added by the AIState constructor, on the main thread.
+static gameplay::StringTable __ids;
 
 namespace gameplay
 {
@@ -8,7 +12,7 @@ namespace gameplay
 AIState* AIState::_empty = NULL;
 
 AIState::AIState(const char* id)
-    : _id(id), _listener(NULL)
+    : _id(id), _idHandle(__ids.intern(id)), _listener(NULL), _threadSafe(false)
 {
     addScriptEvent("enter", "<AIAgent><AIState>");
     addScriptEvent("exit", "<AIAgent><AIState>");
@@ -29,11 +33,33 @@ const char* AIState::getId() const
     return _id.c_str();
 }
 
+unsigned int AIState::getIdHandle() const
+{
+    return _idHandle;
+}
+
+unsigned int AIState::getIdHandle(const char* id)
+{
+    GP_ASSERT(id);
+
+    return __ids.find(id);
+}
+
 void AIState::setListener(Listener* listener)
 {
     _listener = listener;
 }
 
+bool AIState::isThreadSafe() const
+{
+    return _threadSafe && !hasScriptCallbacks("update");
+}
+
+void AIState::setThreadSafe(bool threadSafe)
+{
+    _threadSafe = threadSafe;
+}
+
 void AIState::enter(AIStateMachine* stateMachine)
 {
     if (_listener)
@@ -82,6 +82,29 @@ public:
      */
     const char* getId() const;
 
+    /**
+     * Returns the handle of the ID of this state.
+     *
+     * @return The ID handle (see getIdHandle(const char*)).
+     * @script{ignore}
+     */
+    unsigned int getIdHandle() const;
+
+    /**
+     * Gets the handle of a state ID.
+     *
+     * State IDs are interned in a hashed registry shared by all states when a state
+     * is created, so state machines find their states by comparing handles instead
+     * of strings. Handles start at zero and are never reused. Looking up an ID does
+     * not add it to the registry, so this can be called from the parallel agent updates.
+     *
+     * @param id The state ID.
+     *
+     * @return The handle of the ID, or StringTable::INVALID_HANDLE if no state has this ID.
+     * @script{ignore}
+     */
+    static unsigned int getIdHandle(const char* id);
+
     /**
      * Sets a listener to dispatch state events to.
      * 
@@ -89,6 +112,27 @@ public:
      */
     void setListener(Listener* listener);
 
+    /**
+     * Determines whether the update event of this state can run on a worker thread.
+     *
+     * @return true if the state is marked thread safe and has no script update callbacks.
+     */
+    bool isThreadSafe() const;
+
+    /**
+     * Marks the update event of this state as safe to run on a worker thread.
+     *
+     * The AIController updates the agents whose active state is thread safe in
+     * parallel on the job scheduler. The stateUpdate method of the listener of such
+     * a state must only touch its own agent. The messages it sends, including state
+     * changes, are delivered once all parallel updates have finished. Script update
+     * callbacks always run on the main thread, so a state with such callbacks is
+     * updated serially whether it is marked thread safe or not.
+     *
+     * @param threadSafe true if the update event is thread safe, false otherwise.
+     */
+    void setThreadSafe(bool threadSafe);
+
 private:
 
     /**
@@ -127,7 +171,9 @@ private:
     void update(AIStateMachine* stateMachine, float elapsedTime);
 
     std::string _id;
+    unsigned int _idHandle;
     Listener* _listener;
+    bool _threadSafe;
 
     // The default/empty state.
     static AIState* _empty;
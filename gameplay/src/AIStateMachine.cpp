@@ -8,7 +8,7 @@ namespace gameplay
 {
 
 AIStateMachine::AIStateMachine(AIAgent* agent)
-    : _agent(agent)
+    : _agent(agent), _pendingState(NULL), _states(new StateTable())
 {
     GP_ASSERT(agent);
     if (AIState::_empty)
@@ -21,10 +21,7 @@ AIStateMachine::AIStateMachine(AIAgent* agent)
 AIStateMachine::~AIStateMachine()
 {
     // Release all states
-    for (std::list<AIState*>::iterator itr = _states.begin(); itr != _states.end(); ++itr)
-    {
-        (*itr)->release();
-    }
+    SAFE_RELEASE(_states);
 
     if (AIState::_empty)
     {
@@ -39,6 +36,14 @@ AIStateMachine::~AIStateMachine()
     }
 }
 
+AIStateMachine::StateTable::~StateTable()
+{
+    for (size_t i = 0, count = states.size(); i < count; ++i)
+    {
+        states[i]->release();
+    }
+}
+
 AIAgent* AIStateMachine::getAgent() const
 {
     return _agent;
@@ -47,37 +52,50 @@ AIAgent* AIStateMachine::getAgent() const
 AIState* AIStateMachine::addState(const char* id)
 {
     AIState* state = AIState::create(id);
-    _states.push_back(state);
+    StateTable* table = getOwnStates();
+    table->states.push_back(state);
+    table->idHandles.push_back(state->getIdHandle());
     return state;
 }
 
 void AIStateMachine::addState(AIState* state)
 {
+    GP_ASSERT(state);
+
     state->addRef();
-    _states.push_back(state);
+    StateTable* table = getOwnStates();
+    table->states.push_back(state);
+    table->idHandles.push_back(state->getIdHandle());
 }
 
 void AIStateMachine::removeState(AIState* state)
 {
-    std::list<AIState*>::iterator itr = std::find(_states.begin(), _states.end(), state);
-    if (itr != _states.end())
-    {
-        _states.erase(itr);
-        state->release();
-    }
+    if (!hasState(state))
+        return;
+
+    StateTable* table = getOwnStates();
+    std::vector<AIState*>::iterator itr = std::find(table->states.begin(), table->states.end(), state);
+    table->idHandles.erase(table->idHandles.begin() + (itr - table->states.begin()));
+    table->states.erase(itr);
+    if (_pendingState == state)
+        _pendingState = NULL;
+    state->release();
 }
 
 AIState* AIStateMachine::getState(const char* id) const
 {
     GP_ASSERT(id);
 
-    AIState* state;
-    for (std::list<AIState*>::const_iterator itr = _states.begin(); itr != _states.end(); ++itr)
-    {
-        state = (*itr);
+    return getState(AIState::getIdHandle(id));
+}
 
-        if (strcmp(id, state->getId()) == 0)
-            return state;
+AIState* AIStateMachine::getState(unsigned int idHandle) const
+{
+    const std::vector<unsigned int>& idHandles = _states->idHandles;
+    for (size_t i = 0, count = idHandles.size(); i < count; ++i)
+    {
+        if (idHandles[i] == idHandle)
+            return _states->states[i];
     }
 
     return NULL;
@@ -92,14 +110,14 @@ bool AIStateMachine::hasState(AIState* state) const
 {
     GP_ASSERT(state);
 
-    return (std::find(_states.begin(), _states.end(), state) != _states.end());
+    return (std::find(_states->states.begin(), _states->states.end(), state) != _states->states.end());
 }
 
 AIState* AIStateMachine::setState(const char* id)
 {
     AIState* state = getState(id);
     if (state)
-        sendChangeStateMessage(state);
+        changeState(state);
     return state;
 }
 
@@ -107,19 +125,78 @@ bool AIStateMachine::setState(AIState* state)
 {
     if (hasState(state))
     {
-        sendChangeStateMessage(state);
+        changeState(state);
         return true;
     }
 
     return false;
 }
 
-void AIStateMachine::sendChangeStateMessage(AIState* newState)
+AIState* AIStateMachine::setState(unsigned int idHandle)
+{
+    AIState* state = getState(idHandle);
+    if (state)
+        changeState(state);
+    return state;
+}
+
+void AIStateMachine::shareStates(AIStateMachine* stateMachine)
 {
+    GP_ASSERT(stateMachine);
+
+    if (stateMachine->_states == _states)
+        return;
+
+    stateMachine->_states->addRef();
+    _states->release();
+    _states = stateMachine->_states;
+}
+
+AIStateMachine::StateTable* AIStateMachine::getOwnStates()
+{
+    if (_states->getRefCount() > 1)
+    {
+        StateTable* table = new StateTable();
+        table->states = _states->states;
+        table->idHandles = _states->idHandles;
+        for (size_t i = 0, count = table->states.size(); i < count; ++i)
+        {
+            table->states[i]->addRef();
+        }
+        _states->release();
+        _states = table;
+    }
+    return _states;
+}
+
+void AIStateMachine::changeState(AIState* newState)
+{
+    AIController* controller = Game::getInstance()->getAIController();
+    if (!_agent->hasMessageListeners())
+    {
+        // Nothing sees the state change message, so change the state without one. During the
+        // parallel agent updates the change waits for the updates to finish, like messages do.
+        if (controller->_deferMessages)
+            _pendingState = newState;
+        else
+            setStateInternal(newState);
+        return;
+    }
+
     AIMessage* message = AIMessage::create(0, _agent->getId(), _agent->getId(), 1);
     message->_messageType = AIMessage::MESSAGE_TYPE_STATE_CHANGE;
     message->setString(0, newState->getId());
-    Game::getInstance()->getAIController()->sendMessage(message);
+    controller->sendMessage(message);
+}
+
+void AIStateMachine::applyPendingState()
+{
+    if (_pendingState)
+    {
+        AIState* state = _pendingState;
+        _pendingState = NULL;
+        setStateInternal(state);
+    }
 }
 
 void AIStateMachine::setStateInternal(AIState* state)
@@ -26,10 +26,18 @@ class AIAgent;
  * machines of any other agents in a game and can contain any arbitrary
  * information. This mechanism provides a simple, flexible and easily
  * debuggable method for communicating between AI objects in a game.
+ * State changes are only sent as messages when the agent has a listener or
+ * a script handler for its messages; otherwise the state is changed at once
+ * (or, during the parallel agent updates, once those have finished).
+ *
+ * State IDs are interned (see AIState::getIdHandle), so states are looked up
+ * by comparing integer handles. Agents that run the same logic can share a
+ * single table of states with shareStates() instead of each holding its own.
  */
 class AIStateMachine
 {
     friend class AIAgent;
+    friend class AIController;
 
 public:
 
@@ -76,6 +84,16 @@ public:
      */
     AIState* getState(const char* id) const;
 
+    /**
+     * Returns a state registered with this state machine.
+     *
+     * @param idHandle The handle of the ID of the state (see AIState::getIdHandle).
+     *
+     * @return The state with the given ID, or NULL if no such state exists.
+     * @script{ignore}
+     */
+    AIState* getState(unsigned int idHandle) const;
+
     /**
      * Returns the active state for this state machine.
      *
@@ -107,8 +125,43 @@ public:
      */
     bool setState(AIState* state);
 
+    /**
+     * Changes the state of this state machine to the given state.
+     *
+     * @param idHandle The handle of the ID of the new state (see AIState::getIdHandle).
+     *
+     * @return The new state, or NULL if no matching state could be found.
+     * @script{ignore}
+     */
+    AIState* setState(unsigned int idHandle);
+
+    /**
+     * Makes this state machine use the states of another state machine.
+     *
+     * The state machines then share one table of states, so the states of many
+     * agents running the same logic are defined once. Adding or removing a state
+     * gives a state machine its own copy of the table first. The active state is kept.
+     *
+     * @param stateMachine The state machine whose states to use.
+     * @script{ignore}
+     */
+    void shareStates(AIStateMachine* stateMachine);
+
 private:
 
+    /**
+     * The states of one or more state machines, with the handles of their IDs in a parallel array.
+     */
+    class StateTable : public Ref
+    {
+    public:
+
+        ~StateTable();
+
+        std::vector<AIState*> states;
+        std::vector<unsigned int> idHandles;
+    };
+
     /**
      * Constructor.
      */
@@ -130,9 +183,19 @@ private:
     AIStateMachine& operator=(const AIStateMachine&);
 
     /**
-     * Sends a message to change the state of this state machine.
+     * Changes the state of this state machine, through a message if the agent listens to its messages.
+     */
+    void changeState(AIState* newState);
+
+    /**
+     * Changes to the state set during the parallel agent updates, if any.
+     */
+    void applyPendingState();
+
+    /**
+     * Gets the table of states of this state machine, copying it first if it is shared.
      */
-    void sendChangeStateMessage(AIState* newState);
+    StateTable* getOwnStates();
 
     /**
      * Changes the active state of the state machine.
@@ -151,7 +214,8 @@ private:
 
     AIAgent* _agent;
     AIState* _currentState;
-    std::list<AIState*> _states;
+    AIState* _pendingState;
+    StateTable* _states;
 
 };
 
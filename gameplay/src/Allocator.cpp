@@ -0,0 +1,437 @@
+#include "Base.h"
+#include "Allocator.h"
+#include "Thread.h"
+#include "Profiler.h"
+#include "FileSystem.h"
+#include "Properties.h"
+
+// Pooled blocks are multiples of ALLOCATOR_POOL_GRANULARITY bytes, up to ALLOCATOR_POOL_MAX_SIZE bytes.
+#define ALLOCATOR_POOL_GRANULARITY 16
+#define ALLOCATOR_POOL_MAX_SIZE 4096
+#define ALLOCATOR_POOL_COUNT (ALLOCATOR_POOL_MAX_SIZE / ALLOCATOR_POOL_GRANULARITY)
+
+// The pools take memory from the source in pages of at least ALLOCATOR_POOL_PAGE_SIZE bytes.
+#define ALLOCATOR_POOL_PAGE_SIZE (64 * 1024)
+
+// The smallest chunk of memory of the frame arena.
+#define ALLOCATOR_FRAME_CHUNK_SIZE (256 * 1024)
+
+namespace gameplay
+{
+
+struct FrameChunk
+{
+    unsigned char* memory;
+    size_t size;
+    size_t used;
+};
+
+static Allocator::Source* __source = NULL;
+static Mutex* __mutex = NULL;
+static size_t __sourceBytes = 0;
+static Allocator::Statistics __statistics[Allocator::CATEGORY_COUNT];
+static void* __pools[ALLOCATOR_POOL_COUNT];      // Free list of each pool, linked through the first word of the blocks.
+static std::vector<FrameChunk> __frameChunks;
+static size_t __frameChunk = 0;
+static size_t __budgets[Allocator::CATEGORY_COUNT];
+static bool __overBudget[Allocator::CATEGORY_COUNT];
+
+static const char* __categoryNames[Allocator::CATEGORY_COUNT] =
+{
+    "general",
+    "frame",
+    "scene",
+    "material",
+    "ai",
+    "script",
+    "texture",
+    "buffer",
+    "framebuffer",
+    "animation",
+    "physics",
+    "audio"
+};
+
+static const char* __counterNames[Allocator::CATEGORY_COUNT] =
+{
+    "Allocator::general",
+    "Allocator::frame",
+    "Allocator::scene",
+    "Allocator::material",
+    "Allocator::ai",
+    "Allocator::script",
+    "Allocator::texture",
+    "Allocator::buffer",
+    "Allocator::framebuffer",
+    "Allocator::animation",
+    "Allocator::physics",
+    "Allocator::audio"
+};
+
+static Mutex& getMutex()
+{
+    // Created on first use, since engine objects may be allocated during static initialization.
+    if (__mutex == NULL)
+        __mutex = new Mutex();
+    return *__mutex;
+}
+
+static void* allocateSource(size_t size)
+{
+    void* memory = __source ? __source->allocate(size) : malloc(size);
+    if (memory)
+        __sourceBytes += size;
+    return memory;
+}
+
+static void deallocateSource(void* memory, size_t size)
+{
+    if (memory == NULL)
+        return;
+
+    __sourceBytes -= size;
+    if (__source)
+        __source->deallocate(memory, size);
+    else
+        free(memory);
+}
+
+static void recordAllocation(Allocator::Category category, size_t size)
+{
+    Allocator::Statistics& statistics = __statistics[category];
+    ++statistics.allocationCount;
+    ++statistics.totalAllocationCount;
+    statistics.bytes += size;
+    if (statistics.bytes > statistics.peakBytes)
+        statistics.peakBytes = statistics.bytes;
+}
+
+static void recordDeallocation(Allocator::Category category, size_t size)
+{
+    Allocator::Statistics& statistics = __statistics[category];
+    GP_ASSERT(statistics.allocationCount > 0 && statistics.bytes >= size);
+    --statistics.allocationCount;
+    statistics.bytes -= size;
+}
+
+void Allocator::setSource(Source* source)
+{
+    MutexLock lock(getMutex());
+    if (__sourceBytes > 0)
+    {
+        GP_WARN("The memory source cannot be changed once memory has been allocated from it.");
+        return;
+    }
+    __source = source;
+}
+
+Allocator::Source* Allocator::getSource()
+{
+    return __source;
+}
+
+void* Allocator::allocate(size_t size, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    MutexLock lock(getMutex());
+    void* memory = allocateSource(size);
+    if (memory)
+        recordAllocation(category, size);
+    return memory;
+}
+
+void Allocator::deallocate(void* memory, size_t size, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    if (memory == NULL)
+        return;
+
+    MutexLock lock(getMutex());
+    deallocateSource(memory, size);
+    recordDeallocation(category, size);
+}
+
+void* Allocator::reallocate(void* memory, size_t size, size_t newSize, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    if (memory == NULL)
+        return newSize > 0 ? allocate(newSize, category) : NULL;
+    if (newSize == 0)
+    {
+        deallocate(memory, size, category);
+        return NULL;
+    }
+
+    MutexLock lock(getMutex());
+    void* newMemory = NULL;
+    if (__source == NULL)
+    {
+        newMemory = realloc(memory, newSize);
+        if (newMemory)
+            __sourceBytes = __sourceBytes - size + newSize;
+    }
+    else
+    {
+        newMemory = allocateSource(newSize);
+        if (newMemory)
+        {
+            memcpy(newMemory, memory, std::min(size, newSize));
+            deallocateSource(memory, size);
+        }
+    }
+
+    if (newMemory)
+    {
+        recordDeallocation(category, size);
+        recordAllocation(category, newSize);
+    }
+    return newMemory;
+}
+
+void* Allocator::allocatePooled(size_t size, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    size_t blockSize = (std::max(size, (size_t)1) + ALLOCATOR_POOL_GRANULARITY - 1) & ~(size_t)(ALLOCATOR_POOL_GRANULARITY - 1);
+    if (blockSize > ALLOCATOR_POOL_MAX_SIZE)
+        return allocate(size, category);
+
+    MutexLock lock(getMutex());
+    unsigned int pool = (unsigned int)(blockSize / ALLOCATOR_POOL_GRANULARITY) - 1;
+    if (__pools[pool] == NULL)
+    {
+        // Pages are never returned to the source, the blocks are reused by the next allocations of the same size.
+        size_t blockCount = std::max(ALLOCATOR_POOL_PAGE_SIZE / blockSize, (size_t)8);
+        unsigned char* page = (unsigned char*)allocateSource(blockCount * blockSize);
+        if (page == NULL)
+            return NULL;
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            void* block = page + i * blockSize;
+            *(void**)block = __pools[pool];
+            __pools[pool] = block;
+        }
+    }
+
+    void* block = __pools[pool];
+    __pools[pool] = *(void**)block;
+    recordAllocation(category, blockSize);
+    return block;
+}
+
+void Allocator::deallocatePooled(void* memory, size_t size, Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    if (memory == NULL)
+        return;
+
+    size_t blockSize = (std::max(size, (size_t)1) + ALLOCATOR_POOL_GRANULARITY - 1) & ~(size_t)(ALLOCATOR_POOL_GRANULARITY - 1);
+    if (blockSize > ALLOCATOR_POOL_MAX_SIZE)
+    {
+        deallocate(memory, size, category);
+        return;
+    }
+
+    MutexLock lock(getMutex());
+    unsigned int pool = (unsigned int)(blockSize / ALLOCATOR_POOL_GRANULARITY) - 1;
+    *(void**)memory = __pools[pool];
+    __pools[pool] = memory;
+    recordDeallocation(category, blockSize);
+}
+
+void* Allocator::allocateFrame(size_t size)
+{
+    size = (std::max(size, (size_t)1) + 15) & ~(size_t)15;
+
+    // Move on to the next chunk, or add a new one, when the current chunk is full.
+    while (__frameChunk < __frameChunks.size() && __frameChunks[__frameChunk].used + size > __frameChunks[__frameChunk].size)
+    {
+        ++__frameChunk;
+    }
+    if (__frameChunk == __frameChunks.size())
+    {
+        FrameChunk chunk;
+        chunk.size = std::max(size, (size_t)ALLOCATOR_FRAME_CHUNK_SIZE);
+        {
+            MutexLock lock(getMutex());
+            chunk.memory = (unsigned char*)allocateSource(chunk.size);
+        }
+        if (chunk.memory == NULL)
+        {
+            GP_ERROR("Failed to allocate %u bytes for the frame arena.", (unsigned int)chunk.size);
+            return NULL;
+        }
+        chunk.used = 0;
+        __frameChunks.push_back(chunk);
+    }
+
+    FrameChunk& chunk = __frameChunks[__frameChunk];
+    void* memory = chunk.memory + chunk.used;
+    chunk.used += size;
+    recordAllocation(FRAME, size);
+    return memory;
+}
+
+Allocator::Statistics Allocator::getStatistics(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    MutexLock lock(getMutex());
+    return __statistics[category];
+}
+
+void Allocator::track(Category category, size_t size)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    MutexLock lock(getMutex());
+    recordAllocation(category, size);
+}
+
+void Allocator::untrack(Category category, size_t size)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+
+    MutexLock lock(getMutex());
+    recordDeallocation(category, size);
+}
+
+unsigned int Allocator::getAllocationCount(Category category)
+{
+    return getStatistics(category).allocationCount;
+}
+
+size_t Allocator::getBytes(Category category)
+{
+    return getStatistics(category).bytes;
+}
+
+size_t Allocator::getPeakBytes(Category category)
+{
+    return getStatistics(category).peakBytes;
+}
+
+size_t Allocator::getBudget(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __budgets[category];
+}
+
+void Allocator::setBudget(Category category, size_t budget)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    __budgets[category] = budget;
+}
+
+bool Allocator::isOverBudget(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __budgets[category] > 0 && getBytes(category) > __budgets[category];
+}
+
+bool Allocator::writeReport(const char* path)
+{
+    Stream* stream = NULL;
+    if (path)
+    {
+        stream = FileSystem::open(path, FileSystem::WRITE);
+        if (stream == NULL)
+        {
+            GP_WARN("Failed to open file '%s' for the memory report.", path);
+            return false;
+        }
+    }
+
+    char line[256];
+    sprintf(line, "%-12s %12s %12s %12s %12s\n", "category", "allocations", "bytes", "peak bytes", "budget");
+    if (stream)
+        stream->write(line, 1, strlen(line));
+    else
+        print("[memory] %s", line);
+
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        Statistics statistics = getStatistics((Category)i);
+        sprintf(line, "%-12s %12u %12lu %12lu %12lu%s\n", __categoryNames[i], statistics.allocationCount, (unsigned long)statistics.bytes,
+            (unsigned long)statistics.peakBytes, (unsigned long)__budgets[i], isOverBudget((Category)i) ? " (over budget)" : "");
+        if (stream)
+            stream->write(line, 1, strlen(line));
+        else
+            print("[memory] %s", line);
+    }
+
+    if (stream)
+    {
+        stream->close();
+        SAFE_DELETE(stream);
+    }
+    return true;
+}
+
+const char* Allocator::getCategoryName(Category category)
+{
+    GP_ASSERT(category < CATEGORY_COUNT);
+    return __categoryNames[category];
+}
+
+void Allocator::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+    {
+        if (properties->exists(__categoryNames[i]))
+        {
+            __budgets[i] = (size_t)(std::max(0.0f, properties->getFloat(__categoryNames[i])) * 1024 * 1024);
+        }
+    }
+}
+
+void Allocator::nextFrame()
+{
+    {
+        MutexLock lock(getMutex());
+        for (unsigned int i = 0; i < CATEGORY_COUNT; ++i)
+        {
+            GP_PROFILE_COUNTER(__counterNames[i], (double)__statistics[i].bytes);
+
+            // Warn once each time a category goes over its budget.
+            bool overBudget = __budgets[i] > 0 && __statistics[i].bytes > __budgets[i];
+            if (overBudget && !__overBudget[i])
+            {
+                GP_WARN("Memory category '%s' is over its budget (%lu of %lu bytes).", __categoryNames[i], (unsigned long)__statistics[i].bytes, (unsigned long)__budgets[i]);
+            }
+            __overBudget[i] = overBudget;
+        }
+
+        // A frame that needed more than one chunk gets a single chunk large enough for all of it from now on.
+        if (__frameChunks.size() > 1)
+        {
+            size_t size = 0;
+            for (size_t i = 0, count = __frameChunks.size(); i < count; ++i)
+            {
+                size += __frameChunks[i].size;
+                deallocateSource(__frameChunks[i].memory, __frameChunks[i].size);
+            }
+            __frameChunks.clear();
+
+            FrameChunk chunk;
+            chunk.memory = (unsigned char*)allocateSource(size);
+            chunk.size = size;
+            if (chunk.memory)
+                __frameChunks.push_back(chunk);
+        }
+    }
+
+    for (size_t i = 0, count = __frameChunks.size(); i < count; ++i)
+    {
+        __frameChunks[i].used = 0;
+    }
+    __frameChunk = 0;
+    __statistics[FRAME].allocationCount = 0;
+    __statistics[FRAME].bytes = 0;
+}
+
+}
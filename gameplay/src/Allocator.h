@@ -0,0 +1,418 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+namespace gameplay
+{
+
+class Properties;
+
+/**
+ * Defines the memory layer of the engine.
+ *
+ * Engine objects that are created and destroyed in large numbers (nodes,
+ * transforms, material parameters and AI messages) are allocated from
+ * fixed-size pools instead of the heap, and temporaries that only live for a
+ * frame can be allocated from a linear frame arena that is reset at the start
+ * of every frame. The pools and the arena take their memory in large blocks
+ * from a source, which defaults to malloc and free and can be replaced by the
+ * game to route the engine's memory through its own allocator.
+ *
+ * The number of live allocations and bytes of every category of memory are
+ * tracked and reported to the profiler every frame. Memory that the engine does
+ * not allocate through this class, like the GPU memory of textures and buffers,
+ * is estimated by its owners and reported with track and untrack.
+ *
+ * A budget can be set for every category, either in code or in the 'memory'
+ * namespace of the game config, in megabytes:
+ *
+ * @verbatim
+    memory
+    {
+        texture = 96
+        buffer = 32
+        audio = 24
+        script = 8
+    }
+   @endverbatim
+ *
+ * A warning is logged when a category goes over its budget, and writeReport
+ * writes the counters and budgets of all categories to a file or to the log.
+ */
+class Allocator
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the categories that allocations are reported under.
+     */
+    enum Category
+    {
+        GENERAL,
+        FRAME,
+        SCENE,
+        MATERIAL,
+        AI,
+        SCRIPT,
+        TEXTURE,
+        BUFFER,
+        FRAMEBUFFER,
+        ANIMATION,
+        PHYSICS,
+        AUDIO,
+        CATEGORY_COUNT
+    };
+
+    /**
+     * Defines the counters of a category.
+     *
+     * @script{ignore}
+     */
+    struct Statistics
+    {
+        /**
+         * The number of live allocations, or the number of allocations of the current frame for FRAME.
+         */
+        unsigned int allocationCount;
+
+        /**
+         * The number of allocations since startup.
+         */
+        unsigned int totalAllocationCount;
+
+        /**
+         * The size in bytes of the live allocations, or of the allocations of the current frame for FRAME.
+         */
+        size_t bytes;
+
+        /**
+         * The largest value of bytes since startup.
+         */
+        size_t peakBytes;
+    };
+
+    /**
+     * Defines the interface of the source of the memory of the engine.
+     *
+     * @script{ignore}
+     */
+    class Source
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~Source() { }
+
+        /**
+         * Allocates memory.
+         *
+         * @param size The size in bytes of the memory.
+         *
+         * @return The memory, aligned to at least 16 bytes, or NULL if it could not be allocated.
+         */
+        virtual void* allocate(size_t size) = 0;
+
+        /**
+         * Frees memory returned by allocate.
+         *
+         * @param memory The memory.
+         * @param size The size passed to allocate.
+         */
+        virtual void deallocate(void* memory, size_t size) = 0;
+    };
+
+    /**
+     * Sets the source of the memory of the engine.
+     *
+     * This must be called before the engine allocates memory through this class, typically
+     * before the game is run, and the source must outlive the engine.
+     *
+     * @param source The source, or NULL to use malloc and free.
+     * @script{ignore}
+     */
+    static void setSource(Source* source);
+
+    /**
+     * Gets the source of the memory of the engine.
+     *
+     * @return The source, or NULL if malloc and free are used.
+     * @script{ignore}
+     */
+    static Source* getSource();
+
+    /**
+     * Allocates memory from the source.
+     *
+     * @param size The size in bytes of the memory.
+     * @param category The category to report the allocation under.
+     *
+     * @return The memory, or NULL if it could not be allocated.
+     * @script{ignore}
+     */
+    static void* allocate(size_t size, Category category = GENERAL);
+
+    /**
+     * Frees memory returned by allocate.
+     *
+     * @param memory The memory, or NULL.
+     * @param size The size passed to allocate.
+     * @param category The category passed to allocate.
+     * @script{ignore}
+     */
+    static void deallocate(void* memory, size_t size, Category category = GENERAL);
+
+    /**
+     * Resizes memory returned by allocate, keeping its content.
+     *
+     * @param memory The memory, or NULL to allocate new memory.
+     * @param size The size in bytes of memory, or 0 if memory is NULL.
+     * @param newSize The new size in bytes, or 0 to free the memory.
+     * @param category The category of the allocation.
+     *
+     * @return The resized memory, or NULL if newSize is 0 or the memory could not be resized.
+     * @script{ignore}
+     */
+    static void* reallocate(void* memory, size_t size, size_t newSize, Category category = GENERAL);
+
+    /**
+     * Allocates a block from the pool that holds blocks of the given size.
+     *
+     * Blocks larger than the largest pool are allocated from the source.
+     *
+     * @param size The size in bytes of the block.
+     * @param category The category to report the allocation under.
+     *
+     * @return The block.
+     * @script{ignore}
+     */
+    static void* allocatePooled(size_t size, Category category);
+
+    /**
+     * Returns a block to its pool.
+     *
+     * @param memory The block returned by allocatePooled, or NULL.
+     * @param size The size passed to allocatePooled.
+     * @param category The category passed to allocatePooled.
+     * @script{ignore}
+     */
+    static void deallocatePooled(void* memory, size_t size, Category category);
+
+    /**
+     * Allocates memory from the frame arena.
+     *
+     * The memory is released all at once at the start of the next frame, so it
+     * must not be kept beyond the current frame. The arena must only be used
+     * from the main thread.
+     *
+     * @param size The size in bytes of the memory.
+     *
+     * @return The memory, aligned to 16 bytes.
+     * @script{ignore}
+     */
+    static void* allocateFrame(size_t size);
+
+    /**
+     * Gets the counters of a category.
+     *
+     * @param category The category.
+     *
+     * @return The counters.
+     * @script{ignore}
+     */
+    static Statistics getStatistics(Category category);
+
+    /**
+     * Reports memory that is not allocated through this class, like GPU memory.
+     *
+     * @param category The category to report the memory under.
+     * @param size The size in bytes of the memory, or an estimate of it.
+     * @script{ignore}
+     */
+    static void track(Category category, size_t size);
+
+    /**
+     * Reports that memory passed to track has been freed.
+     *
+     * @param category The category passed to track.
+     * @param size The size passed to track.
+     * @script{ignore}
+     */
+    static void untrack(Category category, size_t size);
+
+    /**
+     * Gets the number of live allocations of a category.
+     *
+     * @param category The category.
+     *
+     * @return The number of live allocations.
+     */
+    static unsigned int getAllocationCount(Category category);
+
+    /**
+     * Gets the size of the live allocations of a category.
+     *
+     * @param category The category.
+     *
+     * @return The size in bytes.
+     */
+    static size_t getBytes(Category category);
+
+    /**
+     * Gets the largest size of the live allocations of a category since startup.
+     *
+     * @param category The category.
+     *
+     * @return The size in bytes.
+     */
+    static size_t getPeakBytes(Category category);
+
+    /**
+     * Gets the budget of a category.
+     *
+     * @param category The category.
+     *
+     * @return The budget in bytes, or 0 if the category has no budget.
+     */
+    static size_t getBudget(Category category);
+
+    /**
+     * Sets the budget of a category.
+     *
+     * Going over the budget does not make allocations fail, a warning is logged
+     * the first frame the category is over its budget.
+     *
+     * @param category The category.
+     * @param budget The budget in bytes, or 0 for no budget.
+     */
+    static void setBudget(Category category, size_t budget);
+
+    /**
+     * Determines if a category is over its budget.
+     *
+     * @param category The category.
+     *
+     * @return true if the category has a budget and its live allocations exceed it.
+     */
+    static bool isOverBudget(Category category);
+
+    /**
+     * Writes the counters and budgets of all categories.
+     *
+     * @param path The path of the file to write the report to, or NULL to print it to the log.
+     *
+     * @return true if the report was written.
+     */
+    static bool writeReport(const char* path = NULL);
+
+    /**
+     * Gets the name of a category.
+     *
+     * @param category The category.
+     *
+     * @return The name of the category.
+     */
+    static const char* getCategoryName(Category category);
+
+private:
+
+    /**
+     * Hidden constructor.
+     */
+    Allocator();
+
+    /**
+     * Called during startup to read the budgets of the game config.
+     *
+     * @param properties The 'memory' namespace of the game config, or NULL.
+     */
+    static void initialize(Properties* properties);
+
+    /**
+     * Called at the start of every frame to reset the frame arena and report the counters to the profiler.
+     */
+    static void nextFrame();
+};
+
+/**
+ * Defines an STL allocator that allocates from the frame arena, for temporary
+ * containers that do not outlive the current frame.
+ *
+ * @script{ignore}
+ */
+template <class T>
+class FrameAllocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef FrameAllocator<U> other;
+    };
+
+    FrameAllocator() { }
+
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>&) { }
+
+    pointer address(reference value) const { return &value; }
+
+    const_pointer address(const_reference value) const { return &value; }
+
+    pointer allocate(size_type count, const void* hint = 0) { return (pointer)Allocator::allocateFrame(count * sizeof(T)); }
+
+    // Frame memory is released all at once by the arena.
+    void deallocate(pointer memory, size_type count) { }
+
+    size_type max_size() const { return ((size_type)-1) / sizeof(T); }
+
+    void construct(pointer memory, const T& value)
+    {
+#ifdef GAMEPLAY_MEM_LEAK_DETECTION
+#undef new
+        new ((void*)memory) T(value);
+#define new DEBUG_NEW
+#else
+        new ((void*)memory) T(value);
+#endif
+    }
+
+    void destroy(pointer memory) { memory->~T(); }
+
+    template <class U>
+    bool operator==(const FrameAllocator<U>&) const { return true; }
+
+    template <class U>
+    bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+}
+
+/**
+ * Allocates the objects of a class, and of the classes derived from it, from the pools
+ * of the given Allocator category. Placed at the start of the class body.
+ *
+ * Memory leak detection tracks every allocation with the global new operator, so pools
+ * are disabled when it is enabled.
+ */
+#ifdef GAMEPLAY_MEM_LEAK_DETECTION
+#define GP_POOLED_ALLOCATION(category)
+#else
+#define GP_POOLED_ALLOCATION(category) \
+public: \
+    static void* operator new(size_t size) { return gameplay::Allocator::allocatePooled(size, gameplay::Allocator::category); } \
+    static void operator delete(void* memory, size_t size) { gameplay::Allocator::deallocatePooled(memory, size, gameplay::Allocator::category); }
+#endif
+
+#endif
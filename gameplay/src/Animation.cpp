@@ -6,6 +6,8 @@
 #include "Game.h"
 #include "Transform.h"
 #include "Properties.h"
+#include "Allocator.h"
+#include "Bundle.h"
 
 #define ANIMATION_INDEFINITE_STR "INDEFINITE"
 #define ANIMATION_DEFAULT_CLIP 0
@@ -16,7 +18,7 @@ namespace gameplay
 {
 
 Animation::Animation(const char* id, AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL), _loaded(true)
 {
     createChannel(target, propertyId, keyCount, keyTimes, keyValues, type);
 
@@ -26,7 +28,7 @@ Animation::Animation(const char* id, AnimationTarget* target, int propertyId, un
 }
 
 Animation::Animation(const char* id, AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, float* keyInValue, float* keyOutValue, unsigned int type)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL), _loaded(true)
 {
     createChannel(target, propertyId, keyCount, keyTimes, keyValues, keyInValue, keyOutValue, type);
     // Release the animation because a newly created animation has a ref count of 1 and the channels hold the ref to animation.
@@ -35,7 +37,7 @@ Animation::Animation(const char* id, AnimationTarget* target, int propertyId, un
 }
 
 Animation::Animation(const char* id)
-    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL)
+    : _controller(Game::getInstance()->getAnimationController()), _id(id), _duration(0L), _defaultClip(NULL), _clips(NULL), _bundle(NULL), _loaded(true)
 {
 }
 
@@ -43,6 +45,15 @@ Animation::~Animation()
 {
     _channels.clear();
 
+    if (_bundle)
+    {
+        // The controller may be gone when animations outlive the game.
+        AnimationController* controller = Game::getInstance()->getAnimationController();
+        if (_loaded && controller)
+            controller->removePagedAnimation(this);
+        SAFE_RELEASE(_bundle);
+    }
+
     if (_defaultClip)
     {
         if (_defaultClip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
@@ -75,12 +86,16 @@ Animation::~Animation()
 }
 
 Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration)
-    : _animation(animation), _target(target), _propertyId(propertyId), _curve(curve), _duration(duration)
+    : _animation(animation), _target(target), _propertyId(propertyId), _curve(curve), _duration(duration), _memorySize(0), _pageOffset(0), _setter(NULL)
 {
     GP_ASSERT(_animation);
     GP_ASSERT(_target);
     GP_ASSERT(_curve);
 
+    // Cloned channels share the curve, so only the channel that created it reports its memory.
+    _memorySize = _curve->getMemorySize();
+    Allocator::track(Allocator::ANIMATION, _memorySize);
+
     // get property component count, and ensure the property exists on the AnimationTarget by getting the property component count.
     GP_ASSERT(_target->getAnimationPropertyComponentCount(propertyId));
     _curve->addRef();
@@ -88,8 +103,20 @@ Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int p
     _animation->addRef();
 }
 
+Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int propertyId, unsigned long duration, unsigned int pageOffset)
+    : _animation(animation), _target(target), _propertyId(propertyId), _curve(NULL), _duration(duration), _memorySize(0), _pageOffset(pageOffset), _setter(NULL)
+{
+    GP_ASSERT(_animation);
+    GP_ASSERT(_target);
+
+    // The curve is set when the animation is loaded.
+    GP_ASSERT(_target->getAnimationPropertyComponentCount(propertyId));
+    _target->addChannel(this);
+    _animation->addRef();
+}
+
 Animation::Channel::Channel(const Channel& copy, Animation* animation, AnimationTarget* target)
-    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve), _duration(copy._duration)
+    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve), _duration(copy._duration), _memorySize(0), _pageOffset(0), _setter(NULL)
 {
     GP_ASSERT(_curve);
     GP_ASSERT(_target);
@@ -102,6 +129,8 @@ Animation::Channel::Channel(const Channel& copy, Animation* animation, Animation
 
 Animation::Channel::~Channel()
 {
+    if (_memorySize)
+        Allocator::untrack(Allocator::ANIMATION, _memorySize);
     SAFE_RELEASE(_curve);
     SAFE_RELEASE(_animation);
 }
@@ -111,6 +140,25 @@ Curve* Animation::Channel::getCurve() const
     return _curve;
 }
 
+void Animation::Channel::setCurve(Curve* curve)
+{
+    GP_ASSERT(curve);
+    GP_ASSERT(_curve == NULL);
+
+    _curve = curve;
+    _curve->addRef();
+    _memorySize = _curve->getMemorySize();
+    Allocator::track(Allocator::ANIMATION, _memorySize);
+}
+
+void Animation::Channel::unload()
+{
+    if (_memorySize)
+        Allocator::untrack(Allocator::ANIMATION, _memorySize);
+    _memorySize = 0;
+    SAFE_RELEASE(_curve);
+}
+
 const char* Animation::getId() const
 {
     return _id.c_str();
@@ -225,6 +273,73 @@ void Animation::pause(const char * clipId)
     }
 }
 
+bool Animation::isLoaded() const
+{
+    return _loaded;
+}
+
+bool Animation::prefetch()
+{
+    if (_bundle == NULL)
+        return true;
+
+    if (!_loaded)
+    {
+        _loaded = _bundle->loadAnimation(this);
+        if (!_loaded)
+        {
+            GP_WARN("Failed to load the key data of animation '%s' from bundle '%s'.", _id.c_str(), _bundle->_path.c_str());
+            unload();
+            return false;
+        }
+    }
+
+    // Loading an animation may unload others that were not played recently.
+    GP_ASSERT(_controller);
+    _controller->usePagedAnimation(this);
+    return true;
+}
+
+void Animation::unload()
+{
+    GP_ASSERT(_bundle);
+
+    for (std::vector<Channel*>::iterator itr = _channels.begin(); itr != _channels.end(); ++itr)
+    {
+        GP_ASSERT(*itr);
+        (*itr)->unload();
+    }
+    _loaded = false;
+}
+
+unsigned int Animation::getMemorySize() const
+{
+    unsigned int size = 0;
+    for (std::vector<Channel*>::const_iterator itr = _channels.begin(); itr != _channels.end(); ++itr)
+    {
+        GP_ASSERT(*itr);
+        size += (*itr)->_memorySize;
+    }
+    return size;
+}
+
+bool Animation::isPlaying() const
+{
+    if (_defaultClip && _defaultClip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
+        return true;
+
+    if (_clips)
+    {
+        for (std::vector<AnimationClip*>::const_iterator itr = _clips->begin(); itr != _clips->end(); ++itr)
+        {
+            GP_ASSERT(*itr);
+            if ((*itr)->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
+                return true;
+        }
+    }
+    return false;
+}
+
 bool Animation::targets(AnimationTarget* target) const
 {
     for (std::vector<Animation::Channel*>::const_iterator itr = _channels.begin(); itr != _channels.end(); ++itr)
@@ -313,7 +428,7 @@ AnimationClip* Animation::findClip(const char* id) const
     return NULL;
 }
 
-Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type)
+Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type, Channel* paged)
 {
     GP_ASSERT(target);
     GP_ASSERT(keyTimes);
@@ -348,9 +463,17 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
         normalizedKeyTimes[i] = 1.0f;
         curve->setPoint(i, normalizedKeyTimes[i], keyValues + pointOffset, (Curve::InterpolationType) type);
     }
+    curve->finalize();
 
     SAFE_DELETE_ARRAY(normalizedKeyTimes);
 
+    if (paged)
+    {
+        paged->setCurve(curve);
+        curve->release();
+        return paged;
+    }
+
     Channel* channel = new Channel(this, target, propertyId, curve, duration);
     curve->release();
     addChannel(channel);
@@ -390,6 +513,7 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     i = keyCount - 1;
     normalizedKeyTimes[i] = 1.0f;
     curve->setPoint(i, normalizedKeyTimes[i], keyValues + pointOffset, (Curve::InterpolationType) type, keyInValue + pointOffset, keyOutValue + pointOffset);
+    curve->finalize();
 
     SAFE_DELETE_ARRAY(normalizedKeyTimes);
 
@@ -399,6 +523,58 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     return channel;
 }
 
+Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, const unsigned short* keyValues, const float* offsets, const float* scales, Channel* paged)
+{
+    GP_ASSERT(target);
+    GP_ASSERT(keyTimes);
+    GP_ASSERT(keyValues && offsets && scales);
+
+    unsigned int propertyComponentCount = target->getAnimationPropertyComponentCount(propertyId);
+    GP_ASSERT(propertyComponentCount > 0);
+
+    Curve* curve = Curve::create(keyCount, propertyComponentCount);
+    GP_ASSERT(curve);
+    if (target->_targetType == AnimationTarget::TRANSFORM)
+        setTransformRotationOffset(curve, propertyId);
+
+    unsigned int lowest = keyTimes[0];
+    unsigned long duration = keyTimes[keyCount-1] - lowest;
+
+    // Only the key times are set on the points; the values are kept quantized by the curve.
+    curve->setPoint(0, 0.0f, NULL, Curve::LINEAR);
+    for (unsigned int i = 1; i < keyCount - 1; i++)
+    {
+        curve->setPoint(i, (float) (keyTimes[i] - lowest) / (float) duration, NULL, Curve::LINEAR);
+    }
+    if (keyCount > 1)
+    {
+        curve->setPoint(keyCount - 1, 1.0f, NULL, Curve::LINEAR);
+    }
+    curve->setQuantizedValues(keyValues, offsets, scales);
+
+    if (paged)
+    {
+        paged->setCurve(curve);
+        curve->release();
+        return paged;
+    }
+
+    Channel* channel = new Channel(this, target, propertyId, curve, duration);
+    curve->release();
+    addChannel(channel);
+    return channel;
+}
+
+Animation::Channel* Animation::createPagedChannel(AnimationTarget* target, int propertyId, unsigned long duration, unsigned int pageOffset)
+{
+    GP_ASSERT(target);
+    GP_ASSERT(_bundle);
+
+    Channel* channel = new Channel(this, target, propertyId, duration, pageOffset);
+    addChannel(channel);
+    return channel;
+}
+
 void Animation::addChannel(Channel* channel)
 {
     GP_ASSERT(channel);
@@ -448,6 +624,10 @@ Animation* Animation::clone(Channel* channel, AnimationTarget* target)
 {
     GP_ASSERT(channel);
 
+    // Clones share the curves of a paged animation, which keep them alive when it is unloaded.
+    if (!prefetch())
+        return NULL;
+
     Animation* animation = new Animation(getId());
 
     Animation::Channel* channelCopy = new Animation::Channel(*channel, animation, target);
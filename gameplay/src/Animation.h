@@ -4,6 +4,7 @@
 #include "Ref.h"
 #include "Properties.h"
 #include "Curve.h"
+#include "Allocator.h"
 
 namespace gameplay
 {
@@ -11,6 +12,7 @@ namespace gameplay
 class AnimationTarget;
 class AnimationController;
 class AnimationClip;
+class Bundle;
 
 /**
  * Defines a generic property animation.
@@ -19,13 +21,22 @@ class AnimationClip;
  * Every Animation has the default clip which will run from begin-end time.
  * You can create additional clips to run only parts of an animation and control
  * various runtime characteristics, such as repeat count, etc.
+ *
+ * The animations of a scene loaded from a bundle can be paged (see AnimationController::setPagingBudget):
+ * only the targets and durations of their channels are read with the scene, and the key data of an
+ * animation is read from the bundle when one of its clips is played or when it is prefetched. Paged
+ * animations that are not playing are unloaded again, least recently played first, when the loaded
+ * ones exceed the paging budget.
  */
 class Animation : public Ref
 {
     friend class AnimationClip;
+    friend class AnimationController;
     friend class AnimationTarget;
     friend class Bundle;
 
+    GP_POOLED_ALLOCATION(ANIMATION)
+
 public:
 
     /**
@@ -110,6 +121,22 @@ public:
      */
     bool targets(AnimationTarget* target) const;
 
+    /**
+     * Returns true if the key data of the animation is loaded.
+     *
+     * This is always the case for animations that are not paged.
+     */
+    bool isLoaded() const;
+
+    /**
+     * Loads the key data of a paged animation ahead of playing it, so that
+     * the first play does not have to wait on the bundle.
+     *
+     * @return true if the key data is loaded.
+     * @script{ignore}
+     */
+    bool prefetch();
+
 private:
 
     /**
@@ -123,21 +150,30 @@ private:
         friend class AnimationClip;
         friend class Animation;
         friend class AnimationTarget;
+        friend class Bundle;
+
+        GP_POOLED_ALLOCATION(ANIMATION)
 
     private:
 
         Channel(Animation* animation, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration);
+        Channel(Animation* animation, AnimationTarget* target, int propertyId, unsigned long duration, unsigned int pageOffset);
         Channel(const Channel& copy, Animation* animation, AnimationTarget* target);
         Channel(const Channel&); // Hidden copy constructor.
         ~Channel();
         Channel& operator=(const Channel&); // Hidden copy assignment operator.
         Curve* getCurve() const;
+        void setCurve(Curve* curve);
+        void unload();
 
         Animation* _animation;                // Reference to the animation this channel belongs to.
         AnimationTarget* _target;             // The target of this channel.
         int _propertyId;                      // The target property this channel targets.
         Curve* _curve;                        // The curve used to represent the animation data.
         unsigned long _duration;              // The length of the animation (in milliseconds).
+        unsigned int _memorySize;             // The size of the curve reported to the allocator, 0 for channels that share the curve of another.
+        unsigned int _pageOffset;             // The offset of the key data in the bundle of a paged animation.
+        void (*_setter)(AnimationTarget* target, const float* value, float blendWeight); // Writes the property directly, resolved once by the target; NULL to go through setAnimationPropertyValue.
     };
 
     /**
@@ -191,15 +227,44 @@ private:
     AnimationClip* findClip(const char* id) const;
 
     /**
-     * Creates a channel within this animation.
+     * Creates a channel within this animation, or loads the curve of the given channel of a paged animation.
      */
-    Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type);
+    Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type, Channel* paged = NULL);
 
     /**
      * Creates a channel within this animation.
      */
     Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, float* keyValues, float* keyInValue, float* keyOutValue, unsigned int type);
 
+    /**
+     * Creates a channel within this animation from 16-bit quantized key values.
+     *
+     * Component i of a key value is decoded as offsets[i] + keyValues[i] * scales[i].
+     * The values stay quantized in the curve of the channel, which is linearly interpolated.
+     * If a channel of a paged animation is given, its curve is loaded instead.
+     */
+    Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount, unsigned int* keyTimes, const unsigned short* keyValues, const float* offsets, const float* scales, Channel* paged = NULL);
+
+    /**
+     * Creates a channel of a paged animation, whose curve is read from the bundle when the animation is loaded.
+     */
+    Channel* createPagedChannel(AnimationTarget* target, int propertyId, unsigned long duration, unsigned int pageOffset);
+
+    /**
+     * Releases the curves of a paged animation, which are read from the bundle again on the next play.
+     */
+    void unload();
+
+    /**
+     * Gets the memory used by the loaded curves of the animation.
+     */
+    unsigned int getMemorySize() const;
+
+    /**
+     * Returns true if any clip of the animation is playing.
+     */
+    bool isPlaying() const;
+
     /**
      * Adds a channel to the animation.
      */
@@ -221,7 +286,7 @@ private:
      * @param channel The channel to clone and add to the animation.
      * @param target The target of the animation.
      *
-     * @return The newly created animation.
+     * @return The newly created animation, or NULL if a paged animation failed to load.
      */
     Animation* clone(Channel* channel, AnimationTarget* target);
 
@@ -231,6 +296,8 @@ private:
     std::vector<Channel*> _channels;        // The channels within this Animation.
     AnimationClip* _defaultClip;            // The Animation's default clip.
     std::vector<AnimationClip*>* _clips;    // All the clips created from this Animation.
+    Bundle* _bundle;                        // The bundle the curves of a paged animation are read from; NULL if not paged.
+    bool _loaded;                           // Whether the curves of the channels are loaded.
 
 };
 
@@ -13,17 +13,34 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
     : _id(id), _animation(animation), _startTime(startTime), _endTime(endTime), _duration(_endTime - _startTime), 
       _stateBits(0x00), _repeatCount(1.0f), _loopBlendTime(0), _activeDuration(_duration * _repeatCount), _speed(1.0f), _timeStarted(0), 
       _elapsedTime(0), _crossFadeToClip(NULL), _crossFadeOutElapsed(0), _crossFadeOutDuration(0), _blendWeight(1.0f), 
-      _beginListeners(NULL), _endListeners(NULL), _listeners(NULL), _listenerItr(NULL), _scriptListeners(NULL)
+      _percentComplete(0.0f), _valueData(NULL), _lodFrame(0), _listenerIndex(0), _scriptListeners(NULL)
 {
     GP_ASSERT(_animation);
     GP_ASSERT(0 <= startTime && startTime <= _animation->_duration && 0 <= endTime && endTime <= _animation->_duration);
 
-    for (size_t i = 0, count = _animation->_channels.size(); i < count; i++)
+    // Store the values of all channels in one block so that evaluating the clip writes to contiguous memory.
+    size_t channelCount = _animation->_channels.size();
+    unsigned int componentCount = 0;
+    for (size_t i = 0; i < channelCount; i++)
     {
-        GP_ASSERT(_animation->_channels[i]);
-        GP_ASSERT(_animation->_channels[i]->getCurve());
-        _values.push_back(new AnimationValue(_animation->_channels[i]->getCurve()->getComponentCount()));
+        Animation::Channel* channel = _animation->_channels[i];
+        GP_ASSERT(channel);
+        componentCount += channel->_target->getAnimationPropertyComponentCount(channel->_propertyId);
     }
+    if (componentCount > 0)
+    {
+        _valueData = new float[componentCount];
+    }
+
+    float* value = _valueData;
+    for (size_t i = 0; i < channelCount; i++)
+    {
+        Animation::Channel* channel = _animation->_channels[i];
+        unsigned int count = channel->_target->getAnimationPropertyComponentCount(channel->_propertyId);
+        _values.push_back(new AnimationValue(count, value));
+        value += count;
+    }
+    _keyframeHints.resize(channelCount, 0);
 }
 
 AnimationClip::~AnimationClip()
@@ -35,10 +52,9 @@ AnimationClip::~AnimationClip()
         valueIter++;
     }
     _values.clear();
+    SAFE_DELETE_ARRAY(_valueData);
 
     SAFE_RELEASE(_crossFadeToClip);
-    SAFE_DELETE(_beginListeners);
-    SAFE_DELETE(_endListeners);
 
     if (_scriptListeners)
     {
@@ -48,19 +64,6 @@ AnimationClip::~AnimationClip()
         }
         SAFE_DELETE(_scriptListeners);
     }
-
-    if (_listeners)
-    {
-        *_listenerItr = _listeners->begin();
-        while (*_listenerItr != _listeners->end())
-        {
-            ListenerEvent* lEvt = **_listenerItr;
-            SAFE_DELETE(lEvt);
-            ++*_listenerItr;
-        }
-        SAFE_DELETE(_listeners);
-    }
-    SAFE_DELETE(_listenerItr);
 }
 
 AnimationClip::ListenerEvent::ListenerEvent(Listener* listener, unsigned long eventTime)
@@ -69,10 +72,6 @@ AnimationClip::ListenerEvent::ListenerEvent(Listener* listener, unsigned long ev
     _eventTime = eventTime;
 }
 
-AnimationClip::ListenerEvent::~ListenerEvent()
-{
-}
-
 const char* AnimationClip::getId() const
 {
     return _id.c_str();
@@ -189,6 +188,11 @@ bool AnimationClip::isPlaying() const
 
 void AnimationClip::play()
 {
+    // The key data of a paged animation is loaded before its clips run.
+    GP_ASSERT(_animation);
+    if (!_animation->prefetch())
+        return;
+
     if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
     {
         // If paused, reset the bit and return.
@@ -283,59 +287,55 @@ void AnimationClip::addListener(AnimationClip::Listener* listener, unsigned long
     GP_ASSERT(listener);
     GP_ASSERT(eventTime < _activeDuration);
 
-    ListenerEvent* listenerEvent = new ListenerEvent(listener, eventTime);
-
-    if (!_listeners)
+    // Binary search for the first event after the new one, so events with the same time
+    // are triggered in the order they were added.
+    size_t index = 0;
+    size_t count = _listeners.size();
+    while (count > 0)
     {
-        _listeners = new std::list<ListenerEvent*>;
-        _listeners->push_front(listenerEvent);
-
-        _listenerItr = new std::list<ListenerEvent*>::iterator;
-        if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-            *_listenerItr = _listeners->begin();
+        size_t half = count / 2;
+        if (_listeners[index + half]._eventTime <= eventTime)
+        {
+            index += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
     }
-    else
+    _listeners.insert(_listeners.begin() + index, ListenerEvent(listener, eventTime));
+
+    // If playing, move the index so the new event is triggered if it is still ahead;
+    // otherwise, it will just be set the next time the clip gets played.
+    if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
     {
-        for (std::list<ListenerEvent*>::iterator itr = _listeners->begin(); itr != _listeners->end(); itr++)
+        float currentTime = fmodf(_elapsedTime, (float)_duration);
+        if (_speed >= 0.0f)
         {
-            GP_ASSERT(*itr);
-            if (eventTime < (*itr)->_eventTime)
-            {
-                itr = _listeners->insert(itr, listenerEvent);
-
-                // If playing, update the iterator if we need to.
-                // otherwise, it will just be set the next time the clip gets played.
-                if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-                {
-                    float currentTime = fmodf(_elapsedTime, (float)_duration);
-                    GP_ASSERT(**_listenerItr || *_listenerItr == _listeners->end());
-                    if ((_speed >= 0.0f && currentTime < eventTime && (*_listenerItr == _listeners->end() || eventTime < (**_listenerItr)->_eventTime)) || 
-                        (_speed <= 0 && currentTime > eventTime && (*_listenerItr == _listeners->begin() || eventTime > (**_listenerItr)->_eventTime)))
-                        *_listenerItr = itr;
-                }
-                return;
-            }
+            if (index < _listenerIndex)
+                _listenerIndex = currentTime < eventTime ? index : _listenerIndex + 1;
+        }
+        else
+        {
+            if (index < _listenerIndex)
+                ++_listenerIndex;
+            else if (currentTime > eventTime)
+                _listenerIndex = index + 1;
         }
-        _listeners->push_back(listenerEvent);
     }
 }
 
 void AnimationClip::addBeginListener(AnimationClip::Listener* listener)
 {
-    if (!_beginListeners)
-        _beginListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _beginListeners->push_back(listener);
+    _beginListeners.push_back(listener);
 }
 
 void AnimationClip::addEndListener(AnimationClip::Listener* listener)
 {
-    if (!_endListeners)
-        _endListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _endListeners->push_back(listener);
+    _endListeners.push_back(listener);
 }
 
 void AnimationClip::addBeginListener(const char* function)
@@ -369,10 +369,21 @@ void AnimationClip::addListener(const char* function, unsigned long eventTime)
 }
 
 bool AnimationClip::update(float elapsedTime)
+{
+    UpdateResult result = advance(elapsedTime);
+    if (result != UPDATE_EVALUATE)
+        return result == UPDATE_REMOVE;
+
+    evaluate();
+    apply();
+    return finishUpdate();
+}
+
+AnimationClip::UpdateResult AnimationClip::advance(float elapsedTime)
 {
     if (isClipStateBitSet(CLIP_IS_PAUSED_BIT))
     {
-        return false;
+        return UPDATE_SKIP;
     }
 
     if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT))
@@ -381,7 +392,7 @@ bool AnimationClip::update(float elapsedTime)
         // after the last update call. Reset the flag, and return true so the AnimationClip is removed from the 
         // running clips on the AnimationController.
         onEnd();
-        return true;
+        return UPDATE_REMOVE;
     }
 
     if (!isClipStateBitSet(CLIP_IS_STARTED_BIT))
@@ -429,34 +440,24 @@ bool AnimationClip::update(float elapsedTime)
         }
     }
 
-    // Notify any listeners of Animation events.
-    if (_listeners)
+    // Notify any listeners of Animation events. The events are indexed again after each
+    // callback, since a listener may add events to the clip.
+    if (_speed >= 0.0f)
     {
-        GP_ASSERT(_listenerItr);
-
-        if (_speed >= 0.0f)
+        while (_listenerIndex < _listeners.size() && _elapsedTime >= (long) _listeners[_listenerIndex]._eventTime)
         {
-            while (*_listenerItr != _listeners->end() && _elapsedTime >= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                ++*_listenerItr;
-            }
+            Listener* listener = _listeners[_listenerIndex++]._listener;
+            GP_ASSERT(listener);
+            listener->animationEvent(this, Listener::TIME);
         }
-        else
+    }
+    else
+    {
+        while (_listenerIndex > 0 && _elapsedTime <= (long) _listeners[_listenerIndex - 1]._eventTime)
         {
-            while (*_listenerItr != _listeners->begin() && _elapsedTime <= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                --*_listenerItr;
-            }
+            Listener* listener = _listeners[--_listenerIndex]._listener;
+            GP_ASSERT(listener);
+            listener->animationEvent(this, Listener::TIME);
         }
     }
 
@@ -466,10 +467,10 @@ bool AnimationClip::update(float elapsedTime)
     // Compute percentage complete for the current loop (prevent a divide by zero if _duration==0).
     // Note that we don't use (currentTime/(_duration+_loopBlendTime)). That's because we want a
     // % value that is outside the 0-1 range for loop smoothing/blending purposes.
-    float percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
+    _percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
 
     if (_loopBlendTime == 0.0f)
-        percentComplete = MATH_CLAMP(percentComplete, 0.0f, 1.0f);
+        _percentComplete = MATH_CLAMP(_percentComplete, 0.0f, 1.0f);
 
     // If we're cross fading, compute blend weights
     if (isClipStateBitSet(CLIP_IS_FADING_OUT_BIT))
@@ -518,11 +519,44 @@ bool AnimationClip::update(float elapsedTime)
             SAFE_RELEASE(_crossFadeToClip);
         }
     }
-    
-    // Evaluate this clip.
+
+    // Distant models are animated at a reduced rate. Cross fades and the last frame of the clip are always evaluated.
+    unsigned int lodInterval = getLodInterval();
+    if (lodInterval > 1 && isClipStateBitSet(CLIP_IS_STARTED_BIT) && !isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) &&
+        !isClipStateBitSet(CLIP_IS_FADING_OUT_BIT) && !isClipStateBitSet(CLIP_IS_FADING_IN_BIT))
+    {
+        if (_lodFrame > 0 && _lodFrame < lodInterval)
+        {
+            --_lodFrame;
+            return UPDATE_SKIP;
+        }
+        _lodFrame = lodInterval - 1;
+    }
+    else
+    {
+        _lodFrame = 0;
+    }
+
+    return UPDATE_EVALUATE;
+}
+
+unsigned int AnimationClip::getLodInterval() const
+{
+    // The channels of a clip normally animate a single character, so its first target decides.
+    GP_ASSERT(_animation);
+    if (_animation->_channels.empty())
+        return 1;
+
+    AnimationTarget* target = _animation->_channels[0]->_target;
+    return target ? target->getAnimationLodInterval() : 1;
+}
+
+void AnimationClip::evaluate()
+{
+    GP_ASSERT(_animation);
+
     Animation::Channel* channel = NULL;
     AnimationValue* value = NULL;
-    AnimationTarget* target = NULL;
     size_t channelCount = _animation->_channels.size();
     float percentageStart = (float)_startTime / (float)_animation->_duration;
     float percentageEnd = (float)_endTime / (float)_animation->_duration;
@@ -531,19 +565,40 @@ bool AnimationClip::update(float elapsedTime)
     {
         channel = _animation->_channels[i];
         GP_ASSERT(channel);
-        target = channel->_target;
-        GP_ASSERT(target);
         value = _values[i];
         GP_ASSERT(value);
 
         // Evaluate the point on Curve
         GP_ASSERT(channel->getCurve());
-        channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value);
+        channel->getCurve()->evaluate(_percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value, &_keyframeHints[i]);
+    }
+}
 
-        // Set the animation value on the target property.
-        target->setAnimationPropertyValue(channel->_propertyId, value, _blendWeight);
+void AnimationClip::apply()
+{
+    GP_ASSERT(_animation);
+
+    Animation::Channel* channel = NULL;
+    AnimationTarget* target = NULL;
+    size_t channelCount = _animation->_channels.size();
+    for (size_t i = 0; i < channelCount; i++)
+    {
+        channel = _animation->_channels[i];
+        GP_ASSERT(channel);
+        target = channel->_target;
+        GP_ASSERT(target);
+        GP_ASSERT(_values[i]);
+
+        // Set the animation value on the target property, directly when the target bound a setter to the channel.
+        if (channel->_setter)
+            channel->_setter(target, _values[i]->_value, _blendWeight);
+        else
+            target->setAnimationPropertyValue(channel->_propertyId, _values[i], _blendWeight);
     }
+}
 
+bool AnimationClip::finishUpdate()
+{
     // When ended. Probably should move to it's own method so we can call it when the clip is ended early.
     if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT))
     {
@@ -563,28 +618,19 @@ void AnimationClip::onBegin()
     if (_speed >= 0)
     {
         _elapsedTime = (Game::getGameTime() - _timeStarted) * _speed;
-
-        if (_listeners)
-            *_listenerItr = _listeners->begin();
+        _listenerIndex = 0;
     }
     else
     {
         _elapsedTime = _activeDuration + (Game::getGameTime() - _timeStarted) * _speed;
-
-        if (_listeners)
-            *_listenerItr = _listeners->end();
+        _listenerIndex = _listeners.size();
     }
     
     // Notify begin listeners if any.
-    if (_beginListeners)
+    for (size_t i = 0; i < _beginListeners.size(); ++i)
     {
-        std::vector<Listener*>::iterator listener = _beginListeners->begin();
-        while (listener != _beginListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::BEGIN);
-            listener++;
-        }
+        GP_ASSERT(_beginListeners[i]);
+        _beginListeners[i]->animationEvent(this, Listener::BEGIN);
     }
 
     release();
@@ -598,15 +644,10 @@ void AnimationClip::onEnd()
     resetClipStateBit(CLIP_ALL_BITS);
 
     // Notify end listeners if any.
-    if (_endListeners)
+    for (size_t i = 0; i < _endListeners.size(); ++i)
     {
-        std::vector<Listener*>::iterator listener = _endListeners->begin();
-        while (listener != _endListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::END);
-            listener++;
-        }
+        GP_ASSERT(_endListeners[i]);
+        _endListeners[i]->animationEvent(this, Listener::END);
     }
 
     release();
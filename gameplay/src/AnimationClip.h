@@ -20,6 +20,9 @@ class AnimationClip : public Ref
 {
     friend class AnimationController;
     friend class Animation;
+    friend class SceneSnapshot;
+
+    GP_POOLED_ALLOCATION(ANIMATION)
 
 public:
 
@@ -292,10 +295,21 @@ private:
     static const unsigned char CLIP_IS_PAUSED_BIT = 0x80;              // Bit representing if the clip is currently paused.
     static const unsigned char CLIP_ALL_BITS = 0xFF;                   // Bit mask for all the state bits.
 
+    /**
+     * The results of advancing the clip's time.
+     */
+    enum UpdateResult
+    {
+        UPDATE_SKIP,        // The clip is paused or reduced by an animation LOD, and nothing needs to be evaluated.
+        UPDATE_EVALUATE,    // The clip's channels need to be evaluated and applied.
+        UPDATE_REMOVE       // The clip has ended and must be removed from the AnimationController.
+    };
+
     /**
      * ListenerEvent.
      *
      * Internal structure used for storing the event time at which an AnimationClip::Listener should be called back.
+     * Events are stored by value, sorted by time.
      */
     struct ListenerEvent
     {
@@ -304,16 +318,6 @@ private:
          */
         ListenerEvent(Listener* listener, unsigned long eventTime);
 
-        /**
-         * Destructor.
-         */
-        ~ListenerEvent();
-
-        /**
-         * Hidden copy assignment operator.
-         */
-        ListenerEvent& operator=(const ListenerEvent&);
-
         Listener* _listener;        // This listener to call back when this event is triggered.
         unsigned long _eventTime;   // The time at which the listener will be called back at during the playback of the AnimationClip.
     };
@@ -367,6 +371,35 @@ private:
      */
     bool update(float elapsedTime);
 
+    /**
+     * Advances the clip's time, fires time events and updates cross fade blend weights.
+     *
+     * @param elapsedTime The elapsed time since the last update.
+     *
+     * @return Whether the clip needs to be evaluated or removed.
+     */
+    UpdateResult advance(float elapsedTime);
+
+    /**
+     * Evaluates the curve of every channel at the time computed by advance().
+     *
+     * Only the clip's own values are written, so different clips can be
+     * evaluated concurrently.
+     */
+    void evaluate();
+
+    /**
+     * Sets the values computed by evaluate() on the animation targets.
+     */
+    void apply();
+
+    /**
+     * Ends the clip if it has completed.
+     *
+     * @return true if the clip ended and must be removed from the AnimationController.
+     */
+    bool finishUpdate();
+
     /**
      * Handles when the AnimationClip begins.
      */
@@ -401,6 +434,11 @@ private:
      */
     AnimationClip* clone(Animation* animation) const;
 
+    /**
+     * Gets the number of frames between two evaluations of the clip, from the animation LOD of its first target.
+     */
+    unsigned int getLodInterval() const;
+
     std::string _id;                                    // AnimationClip ID.
     Animation* _animation;                              // The Animation this clip is created from.
     unsigned long _startTime;                           // Start time of the clip.
@@ -417,11 +455,15 @@ private:
     float _crossFadeOutElapsed;                         // The amount of time that has elapsed for the crossfade.
     unsigned long _crossFadeOutDuration;                // The duration of the cross fade.
     float _blendWeight;                                 // The clip's blendweight.
+    float _percentComplete;                             // The position within the animation computed by the last advance().
     std::vector<AnimationValue*> _values;               // AnimationValue holder.
-    std::vector<Listener*>* _beginListeners;            // Collection of begin listeners on the clip.
-    std::vector<Listener*>* _endListeners;              // Collection of end listeners on the clip.
-    std::list<ListenerEvent*>* _listeners;              // Ordered collection of listeners on the clip.
-    std::list<ListenerEvent*>::iterator* _listenerItr;  // Iterator that points to the next listener event to be triggered.
+    float* _valueData;                                  // Contiguous storage for the values of all channels.
+    std::vector<unsigned int> _keyframeHints;           // The keyframe each channel's curve was last evaluated from.
+    unsigned int _lodFrame;                             // The number of frames to skip before the clip is evaluated again.
+    std::vector<Listener*> _beginListeners;             // Collection of begin listeners on the clip.
+    std::vector<Listener*> _endListeners;               // Collection of end listeners on the clip.
+    std::vector<ListenerEvent> _listeners;              // Listener events on the clip, sorted by event time.
+    size_t _listenerIndex;                              // Index of the next listener event to trigger, or one past it when playing in reverse.
     std::vector<ScriptListener*>* _scriptListeners;     // Collection of listeners that are bound to Lua script functions.
 };
 
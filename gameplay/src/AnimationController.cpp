@@ -2,12 +2,13 @@
 #include "AnimationController.h"
 #include "Game.h"
 #include "Curve.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
 
 AnimationController::AnimationController()
-    : _state(STOPPED)
+    : _state(STOPPED), _batched(false), _parallel(false), _pagingBudget(0), _pagedMemorySize(0)
 {
 }
 
@@ -27,13 +28,49 @@ void AnimationController::stopAllAnimations()
     }
 }
 
+void AnimationController::setBatchedUpdate(bool batched, bool parallel)
+{
+    _batched = batched;
+    _parallel = batched && parallel;
+}
+
+bool AnimationController::isBatchedUpdate() const
+{
+    return _batched;
+}
+
+bool AnimationController::isParallelUpdate() const
+{
+    return _parallel;
+}
+
+void AnimationController::setPagingBudget(unsigned int bytes)
+{
+    _pagingBudget = bytes;
+}
+
+unsigned int AnimationController::getPagingBudget() const
+{
+    return _pagingBudget;
+}
+
+unsigned int AnimationController::getPagedMemorySize() const
+{
+    return _pagedMemorySize;
+}
+
 AnimationController::State AnimationController::getState() const
 {
     return _state;
 }
 
-void AnimationController::initialize()
+void AnimationController::initialize(Properties* properties)
 {
+    if (properties)
+    {
+        setBatchedUpdate(properties->getBool("batched"), properties->getBool("parallel"));
+        setPagingBudget((unsigned int)std::max(0, properties->getInt("pagingBudget")) * 1024);
+    }
     _state = IDLE;
 }
 
@@ -46,6 +83,8 @@ void AnimationController::finalize()
         SAFE_RELEASE(clip);
     }
     _runningClips.clear();
+    _pagedAnimations.clear();
+    _pagedMemorySize = 0;
     _state = STOPPED;
 }
 
@@ -95,11 +134,24 @@ void AnimationController::unschedule(AnimationClip* clip)
 
 void AnimationController::update(float elapsedTime)
 {
+    GP_PROFILE_SCOPE("AnimationController::update");
+
     if (_state != RUNNING)
         return;
     
     Transform::suspendTransformChanged();
 
+    if (_batched)
+    {
+        updateBatched(elapsedTime);
+
+        Transform::resumeTransformChanged();
+
+        if (_runningClips.empty())
+            _state = IDLE;
+        return;
+    }
+
     // Loop through running clips and call update() on them.
     std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
     while (clipIter != _runningClips.end())
@@ -133,4 +185,133 @@ void AnimationController::update(float elapsedTime)
         _state = IDLE;
 }
 
+void AnimationController::updateBatched(float elapsedTime)
+{
+    // Advance every clip first. This fires the time events and updates the cross fade
+    // weights, which may affect other clips, before any clip is sampled.
+    std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
+    while (clipIter != _runningClips.end())
+    {
+        AnimationClip* clip = (*clipIter);
+        GP_ASSERT(clip);
+        if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_RESTARTED_BIT))
+        {   // If the CLIP_IS_RESTARTED_BIT is set, we should end the clip and 
+            // move it from where it is in the running clips list to the back.
+            clip->addRef();
+            clip->onEnd();
+            clip->setClipStateBit(AnimationClip::CLIP_IS_PLAYING_BIT);
+            _runningClips.push_back(clip);
+            clipIter = _runningClips.erase(clipIter);
+            clip->release();
+            continue;
+        }
+
+        AnimationClip::UpdateResult result = clip->advance(elapsedTime);
+        if (result == AnimationClip::UPDATE_REMOVE)
+        {
+            clipIter = _runningClips.erase(clipIter);
+            SAFE_RELEASE(clip);
+            continue;
+        }
+        if (result == AnimationClip::UPDATE_EVALUATE)
+        {
+            _applyClips.push_back(clipIter);
+            _evaluateClips.push_back(clip);
+        }
+        clipIter++;
+    }
+
+    // Sample the clips grouped by animation so that clips sharing an animation
+    // read the same curves one after the other.
+    if (!_evaluateClips.empty())
+    {
+        std::stable_sort(_evaluateClips.begin(), _evaluateClips.end(), compareClipAnimations);
+        unsigned int clipCount = (unsigned int)_evaluateClips.size();
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (_parallel && clipCount > 1 && scheduler && scheduler->getWorkerCount() > 0)
+            scheduler->parallelFor(clipCount, evaluateClips, &_evaluateClips[0]);
+        else
+            evaluateClips(0, clipCount, &_evaluateClips[0]);
+    }
+
+    // Apply the sampled values in the order the clips are running, since blending depends on it.
+    for (size_t i = 0, count = _applyClips.size(); i < count; ++i)
+    {
+        clipIter = _applyClips[i];
+        AnimationClip* clip = (*clipIter);
+        clip->addRef();
+        clip->apply();
+        if (clip->finishUpdate())
+        {
+            _runningClips.erase(clipIter);
+            clip->release();
+        }
+        clip->release();
+    }
+
+    _applyClips.clear();
+    _evaluateClips.clear();
+}
+
+void AnimationController::evaluateClips(unsigned int start, unsigned int end, void* cookie)
+{
+    AnimationClip** clips = (AnimationClip**)cookie;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        clips[i]->evaluate();
+    }
+}
+
+bool AnimationController::compareClipAnimations(const AnimationClip* a, const AnimationClip* b)
+{
+    return a->_animation < b->_animation;
+}
+
+void AnimationController::usePagedAnimation(Animation* animation)
+{
+    GP_ASSERT(animation);
+    GP_ASSERT(animation->isLoaded());
+
+    // The size is kept with the entry, since the channels of an animation are gone by the time it is destroyed.
+    std::list<std::pair<Animation*, unsigned int> >::iterator itr = _pagedAnimations.begin();
+    while (itr != _pagedAnimations.end() && itr->first != animation)
+        ++itr;
+    if (itr == _pagedAnimations.end())
+    {
+        _pagedAnimations.push_front(std::make_pair(animation, animation->getMemorySize()));
+        _pagedMemorySize += _pagedAnimations.front().second;
+    }
+    else
+    {
+        _pagedAnimations.splice(_pagedAnimations.begin(), _pagedAnimations, itr);
+    }
+
+    // Unload from the least recently used end, skipping the animations that are playing.
+    itr = _pagedAnimations.end();
+    while (_pagedMemorySize > _pagingBudget && itr != _pagedAnimations.begin())
+    {
+        --itr;
+        Animation* candidate = itr->first;
+        if (candidate == animation || candidate->isPlaying())
+            continue;
+
+        _pagedMemorySize -= itr->second;
+        candidate->unload();
+        itr = _pagedAnimations.erase(itr);
+    }
+}
+
+void AnimationController::removePagedAnimation(Animation* animation)
+{
+    for (std::list<std::pair<Animation*, unsigned int> >::iterator itr = _pagedAnimations.begin(); itr != _pagedAnimations.end(); ++itr)
+    {
+        if (itr->first == animation)
+        {
+            _pagedMemorySize -= itr->second;
+            _pagedAnimations.erase(itr);
+            return;
+        }
+    }
+}
+
 }
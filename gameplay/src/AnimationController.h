@@ -11,6 +11,40 @@ namespace gameplay
 
 /**
  * Defines a class for controlling game animation.
+ *
+ * By default each running clip is evaluated and applied to its targets in
+ * turn. Scenes with many animated characters can enable a batched update in
+ * the game config:
+ *
+ * @verbatim
+    animations
+    {
+        batched = true
+        parallel = true
+    }
+   @endverbatim
+ *
+ * When batched, the controller first advances every running clip, then
+ * samples the channels of all clips into their value buffers, grouped by
+ * animation so that clips sharing an animation reuse the same keyframe data,
+ * and finally sets the values on the targets in one pass in the order the
+ * clips are running. With parallel set, the sampling is split across the
+ * worker threads of the JobScheduler.
+ *
+ * Games with many clips per character can page the animations of the scenes
+ * they load from bundles by giving them a memory budget, in kilobytes:
+ *
+ * @verbatim
+    animations
+    {
+        pagingBudget = 4096
+    }
+   @endverbatim
+ *
+ * The key data of a paged animation is read when one of its clips is played
+ * or the animation is prefetched (see Animation::prefetch). When the loaded
+ * paged animations exceed the budget, the ones played least recently are
+ * unloaded, except those with clips still playing.
  */
 class AnimationController
 {
@@ -25,6 +59,58 @@ public:
      * Stops all AnimationClips currently playing on the AnimationController.
      */
     void stopAllAnimations();
+
+    /**
+     * Enables or disables the batched update of the running clips.
+     *
+     * @param batched true to advance, sample and apply all clips in separate passes.
+     * @param parallel true to sample the clips on the worker threads; ignored unless batched.
+     * @script{ignore}
+     */
+    void setBatchedUpdate(bool batched, bool parallel = false);
+
+    /**
+     * Determines whether the running clips are updated in batches.
+     *
+     * @return true if the batched update is enabled.
+     * @script{ignore}
+     */
+    bool isBatchedUpdate() const;
+
+    /**
+     * Determines whether batched clips are sampled on the worker threads.
+     *
+     * @return true if the clips are sampled in parallel.
+     * @script{ignore}
+     */
+    bool isParallelUpdate() const;
+
+    /**
+     * Sets the memory budget of the key data of paged animations.
+     *
+     * Animations are only paged in scenes loaded while the budget is not 0, which is the default.
+     * Scenes loaded asynchronously are read from memory and never paged.
+     *
+     * @param bytes The budget, in bytes, or 0 to load all animations with their scenes.
+     * @script{ignore}
+     */
+    void setPagingBudget(unsigned int bytes);
+
+    /**
+     * Gets the memory budget of the key data of paged animations.
+     *
+     * @return The budget, in bytes.
+     * @script{ignore}
+     */
+    unsigned int getPagingBudget() const;
+
+    /**
+     * Gets the memory used by the key data of the loaded paged animations.
+     *
+     * @return The memory size, in bytes.
+     * @script{ignore}
+     */
+    unsigned int getPagedMemorySize() const;
        
 private:
 
@@ -63,8 +149,10 @@ private:
 
     /**
      * Callback for when the controller is initialized.
+     *
+     * @param properties The 'animations' namespace of the game config, or NULL.
      */
-    void initialize();
+    void initialize(Properties* properties);
 
     /*
      * Callback for when the controller is finalized.
@@ -95,9 +183,36 @@ private:
      * Callback for when the controller receives a frame update event.
      */
     void update(float elapsedTime);
+
+    /**
+     * Updates the running clips in separate advance, sample and apply passes.
+     */
+    void updateBatched(float elapsedTime);
+
+    static void evaluateClips(unsigned int start, unsigned int end, void* cookie);
+
+    static bool compareClipAnimations(const AnimationClip* a, const AnimationClip* b);
+
+    /**
+     * Marks a loaded paged animation as the most recently used and unloads the least
+     * recently used animations that are not playing while the budget is exceeded.
+     */
+    void usePagedAnimation(Animation* animation);
+
+    /**
+     * Forgets a loaded paged animation that is destroyed.
+     */
+    void removePagedAnimation(Animation* animation);
     
     State _state;                                 // The current state of the AnimationController.
     std::list<AnimationClip*> _runningClips;      // A list of running AnimationClips.
+    bool _batched;                                // Whether running clips are updated in batches.
+    bool _parallel;                               // Whether batched clips are sampled on the worker threads.
+    std::vector<std::list<AnimationClip*>::iterator> _applyClips;  // The clips to apply in the current batched update.
+    std::vector<AnimationClip*> _evaluateClips;   // The clips to sample in the current batched update, grouped by animation.
+    unsigned int _pagingBudget;                   // The memory budget of paged animations, in bytes; 0 when not paging.
+    unsigned int _pagedMemorySize;                // The memory used by the loaded paged animations.
+    std::list<std::pair<Animation*, unsigned int> > _pagedAnimations;  // The loaded paged animations and their memory sizes, most recently used first.
 };
 
 }
@@ -10,12 +10,19 @@ namespace gameplay
 {
 
 AnimationTarget::AnimationTarget()
-    : _targetType(SCALAR), _animationChannels(NULL)
+    : _targetType(SCALAR), _animationChannels(NULL), _tweenCount(0)
 {
 }
 
 AnimationTarget::~AnimationTarget()
 {
+    if (_tweenCount > 0)
+    {
+        TweenManager* tweens = Game::getInstance()->getTweenManager();
+        if (tweens)
+            tweens->stop(this);
+    }
+
     if (_animationChannels)
     {
         std::vector<Animation::Channel*>::iterator itr = _animationChannels->begin();
@@ -339,6 +346,22 @@ Animation* AnimationTarget::getAnimation(const char* id) const
     return NULL;
 }
 
+unsigned int AnimationTarget::getAnimations(std::vector<Animation*>& animations) const
+{
+    if (_animationChannels == NULL)
+        return 0;
+
+    size_t start = animations.size();
+    for (std::vector<Animation::Channel*>::const_iterator itr = _animationChannels->begin(); itr != _animationChannels->end(); ++itr)
+    {
+        GP_ASSERT(*itr);
+        Animation* animation = (*itr)->_animation;
+        if (std::find(animations.begin() + start, animations.end(), animation) == animations.end())
+            animations.push_back(animation);
+    }
+    return (unsigned int)(animations.size() - start);
+}
+
 int AnimationTarget::getPropertyId(TargetType type, const char* propertyIdStr)
 {
     GP_ASSERT(propertyIdStr);
@@ -408,6 +431,9 @@ void AnimationTarget::addChannel(Animation::Channel* channel)
 
     GP_ASSERT(channel);
     _animationChannels->push_back(channel);
+
+    // Bind the channel to its property once, so clips do not dispatch on the property ID for every value.
+    channel->_setter = getAnimationPropertySetter(channel->_propertyId);
 }
 
 void AnimationTarget::removeChannel(Animation::Channel* channel)
@@ -455,6 +481,16 @@ Animation::Channel* AnimationTarget::getChannel(const char* id) const
     return NULL;
 }
 
+unsigned int AnimationTarget::getAnimationLodInterval() const
+{
+    return 1;
+}
+
+AnimationTarget::AnimationPropertySetter AnimationTarget::getAnimationPropertySetter(int propertyId) const
+{
+    return NULL;
+}
+
 void AnimationTarget::cloneInto(AnimationTarget* target, NodeCloneContext &context) const
 {
     if (_animationChannels)
@@ -475,7 +511,8 @@ void AnimationTarget::cloneInto(AnimationTarget* target, NodeCloneContext &conte
             {
                 // Clone the animation and register it with the context so that it only gets cloned once.
                 animation = channel->_animation->clone(channel, target);
-                context.registerClonedAnimation(channel->_animation, animation);
+                if (animation)
+                    context.registerClonedAnimation(channel->_animation, animation);
             }
         }
     }
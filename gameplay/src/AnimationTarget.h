@@ -19,6 +19,7 @@ class AnimationTarget
 {
     friend class Animation;
     friend class AnimationClip;
+    friend class TweenManager;
 
 public:
 
@@ -145,6 +146,16 @@ public:
      */
     Animation* getAnimation(const char* id = NULL) const;
 
+    /**
+     * Gets the animations that have channels targeting this object.
+     *
+     * @param animations The vector to add the animations to, each once.
+     *
+     * @return The number of animations added.
+     * @script{ignore}
+     */
+    unsigned int getAnimations(std::vector<Animation*>& animations) const;
+
 protected:
 
     /**
@@ -195,6 +206,38 @@ protected:
      */
     void cloneInto(AnimationTarget* target, NodeCloneContext &context) const;
 
+    /**
+     * Gets the number of frames between two evaluations of the clips animating this target.
+     *
+     * @return The frame interval. The default implementation returns one.
+     *
+     * @see Model::addAnimationLod
+     */
+    virtual unsigned int getAnimationLodInterval() const;
+
+    /**
+     * Defines a function that writes an animation value straight to a property of a target.
+     *
+     * @param target The target, which the function casts to its own type.
+     * @param value The components of the animation value.
+     * @param blendWeight The blend weight.
+     */
+    typedef void (*AnimationPropertySetter)(AnimationTarget* target, const float* value, float blendWeight);
+
+    /**
+     * Gets a function that sets the animation value of a property, bypassing setAnimationPropertyValue.
+     *
+     * The function is resolved once for each channel when the channel is bound to this target,
+     * and called by the clips of the channel for every value they apply. Targets can only
+     * return a function for properties whose layout does not change while they are animated.
+     *
+     * @param propertyId The ID of the property.
+     *
+     * @return The function, or NULL to set the property through setAnimationPropertyValue.
+     *      The default implementation returns NULL.
+     */
+    virtual AnimationPropertySetter getAnimationPropertySetter(int propertyId) const;
+
     /**
      * The target's type.
      *
@@ -241,6 +284,7 @@ private:
     void convertByValues(float* from, float* by, unsigned int componentCount);
 
     std::vector<Animation::Channel*>* _animationChannels;   // Collection of all animation channels that target the AnimationTarget
+    unsigned int _tweenCount;                               // The number of tweens of the TweenManager running on the AnimationTarget
 
 };
 }
@@ -12,6 +12,9 @@ namespace gameplay
 class AnimationValue
 {
     friend class AnimationClip;
+    friend class TweenManager;
+
+    GP_POOLED_ALLOCATION(ANIMATION)
 
 public:
 
@@ -62,6 +65,11 @@ private:
      */
     AnimationValue(unsigned int componentCount);
 
+    /**
+     * Constructor. The value is stored in the specified memory, which is not owned by the AnimationValue.
+     */
+    AnimationValue(unsigned int componentCount, float* value);
+
     /**
      * Constructor.
      */
@@ -80,6 +88,7 @@ private:
     unsigned int _componentCount;   // The number of float values for the property.
     unsigned int _componentSize;    // The number of bytes of memory the property is.
     float* _value;                  // The current value of the property.
+    bool _ownsValue;                // Whether _value was allocated by this AnimationValue.
 
 };
 
@@ -1,12 +1,262 @@
 #include "Base.h"
 #include "AudioBuffer.h"
 #include "FileSystem.h"
+#include "Game.h"
+#include "LoadProfiler.h"
+#include "ResourceCache.h"
+#include "Allocator.h"
+
+// The number of OpenAL buffers, and decoded chunks, in the ring of a streamed buffer.
+#define AUDIO_STREAM_BUFFER_COUNT 4
+
+// The size in bytes of every chunk decoded for a streamed buffer.
+#define AUDIO_STREAM_CHUNK_SIZE (64 * 1024)
+
+// The size in bytes of every chunk decoded for a compressed buffer.
+#define AUDIO_CLIP_CHUNK_SIZE (16 * 1024)
+
+// The size in bytes per channel of the IMA ADPCM blocks that PCM clips are encoded to.
+#define AUDIO_ADPCM_BLOCK_ALIGN 512
+
+// The largest IMA ADPCM block of a clip, whose samples fit in a chunk.
+#define AUDIO_ADPCM_MAX_BLOCK_ALIGN 4096
+
+// The format tag of IMA ADPCM wave files.
+#define WAVE_FORMAT_IMA_ADPCM 0x11
 
 namespace gameplay
 {
 
-// Audio buffer cache
-static std::vector<AudioBuffer*> __buffers;
+// Cache of loaded buffers, keyed by their normalized path.
+static ResourceCache __bufferCache("audioBuffers");
+
+// Buffers of the preload manifests, kept loaded once uploaded.
+static std::vector<AudioBuffer*> __preloadedBuffers;
+
+std::vector<AudioBuffer::Preload*> AudioBuffer::_preloads;
+std::vector<AudioBuffer::Ring*> AudioBuffer::_rings;
+
+/**
+ * Normalizes a path, so that every way of referring to a file gives the same path.
+ */
+static std::string normalizePath(const char* path)
+{
+    std::string resolvedPath(FileSystem::resolvePath(path));
+    std::replace(resolvedPath.begin(), resolvedPath.end(), '\\', '/');
+    const bool absolute = !resolvedPath.empty() && resolvedPath[0] == '/';
+
+    // Drop the empty and '.' segments and fold the '..' segments into their parent.
+    std::vector<std::string> segments;
+    size_t start = 0;
+    while (start <= resolvedPath.size())
+    {
+        size_t end = resolvedPath.find('/', start);
+        if (end == std::string::npos)
+            end = resolvedPath.size();
+        std::string segment = resolvedPath.substr(start, end - start);
+        if (segment == "..")
+        {
+            if (!segments.empty() && segments.back() != "..")
+                segments.pop_back();
+            else if (!absolute)
+                segments.push_back(segment);
+        }
+        else if (!segment.empty() && segment != ".")
+        {
+            segments.push_back(segment);
+        }
+        start = end + 1;
+    }
+
+    std::string normalizedPath(absolute ? "/" : "");
+    for (size_t i = 0, count = segments.size(); i < count; ++i)
+    {
+        if (i > 0)
+            normalizedPath += '/';
+        normalizedPath += segments[i];
+    }
+    return normalizedPath;
+}
+
+// Steps and step index changes of IMA ADPCM.
+static const int __imaSteps[89] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060,
+    1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+static const int __imaIndices[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static unsigned int readUnsignedShort(const unsigned char* bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static unsigned int readUnsignedInt(const unsigned char* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+static short decodeImaNibble(unsigned int nibble, int& predictor, int& index)
+{
+    const int step = __imaSteps[index];
+    int difference = step >> 3;
+    if (nibble & 4)
+        difference += step;
+    if (nibble & 2)
+        difference += step >> 1;
+    if (nibble & 1)
+        difference += step >> 2;
+    predictor += (nibble & 8) ? -difference : difference;
+    predictor = std::max(-32768, std::min(32767, predictor));
+    index = std::max(0, std::min(88, index + __imaIndices[nibble]));
+    return (short)predictor;
+}
+
+static unsigned int encodeImaSample(int sample, int& predictor, int& index)
+{
+    const int step = __imaSteps[index];
+    int difference = sample - predictor;
+    unsigned int nibble = 0;
+    if (difference < 0)
+    {
+        nibble = 8;
+        difference = -difference;
+    }
+    if (difference >= step)
+    {
+        nibble |= 4;
+        difference -= step;
+    }
+    if (difference >= step >> 1)
+    {
+        nibble |= 2;
+        difference -= step >> 1;
+    }
+    if (difference >= step >> 2)
+        nibble |= 1;
+
+    // Follow the decoder, so that the rounding errors do not add up.
+    decodeImaNibble(nibble, predictor, index);
+    return nibble;
+}
+
+/**
+ * Decodes the frames [first, last) of an IMA ADPCM block into interleaved 16-bit samples.
+ */
+static void decodeImaBlock(const unsigned char* block, unsigned int channels, unsigned int first, unsigned int last, short* samples)
+{
+    for (unsigned int c = 0; c < channels; ++c)
+    {
+        const unsigned char* header = block + c * 4;
+        int predictor = (short)readUnsignedShort(header);
+        int index = std::min((int)header[2], 88);
+        if (first == 0 && last > 0)
+            samples[c] = (short)predictor;
+
+        // The other samples of every channel follow in groups of eight, four bytes per channel.
+        const unsigned char* data = block + (channels + c) * 4;
+        for (unsigned int frame = 1; frame < last; data += channels * 4)
+        {
+            for (unsigned int i = 0; i < 8 && frame < last; ++i, ++frame)
+            {
+                unsigned int nibble = (i & 1) ? data[i >> 1] >> 4 : data[i >> 1] & 0x0f;
+                short sample = decodeImaNibble(nibble, predictor, index);
+                if (frame >= first)
+                    samples[(frame - first) * channels + c] = sample;
+            }
+        }
+    }
+}
+
+/**
+ * Encodes a block of interleaved 16-bit samples to IMA ADPCM, repeating the last frame past the end of the samples.
+ */
+static void encodeImaBlock(const short* samples, unsigned int channels, unsigned int frameCount, unsigned int samplesPerBlock, int* indices, unsigned char* block)
+{
+    for (unsigned int c = 0; c < channels; ++c)
+    {
+        int predictor = samples[c];
+        int& index = indices[c];
+        unsigned char* header = block + c * 4;
+        header[0] = (unsigned char)(predictor & 0xff);
+        header[1] = (unsigned char)((predictor >> 8) & 0xff);
+        header[2] = (unsigned char)index;
+        header[3] = 0;
+
+        unsigned char* data = block + (channels + c) * 4;
+        for (unsigned int frame = 1; frame < samplesPerBlock; data += channels * 4)
+        {
+            memset(data, 0, 4);
+            for (unsigned int i = 0; i < 8; ++i, ++frame)
+            {
+                int sample = samples[std::min(frame, frameCount - 1) * channels + c];
+                unsigned int nibble = encodeImaSample(sample, predictor, index);
+                data[i >> 1] |= (unsigned char)((i & 1) ? nibble << 4 : nibble);
+            }
+        }
+    }
+}
+
+/**
+ * A read-only stream over the data of a compressed clip, which it does not own.
+ */
+class ClipStream : public Stream
+{
+public:
+
+    ClipStream(const unsigned char* data, size_t length)
+        : _data(data), _length(length), _position(0)
+    {
+    }
+
+    virtual bool canRead() { return true; }
+    virtual bool canWrite() { return false; }
+    virtual bool canSeek() { return true; }
+
+    // The decoder closes its stream when it is cleared, but the clip outlives it.
+    virtual void close() { }
+
+    virtual size_t read(void* ptr, size_t size, size_t count)
+    {
+        if (size == 0)
+            return 0;
+        size_t available = (_length - _position) / size;
+        if (count > available)
+            count = available;
+        memcpy(ptr, _data + _position, size * count);
+        _position += size * count;
+        return count;
+    }
+
+    virtual char* readLine(char* str, int num) { return NULL; }
+    virtual size_t write(const void* ptr, size_t size, size_t count) { return 0; }
+    virtual bool eof() { return _position >= _length; }
+    virtual size_t length() { return _length; }
+    virtual long int position() { return (long int)_position; }
+
+    virtual bool seek(long int offset, int origin)
+    {
+        long int base = origin == SEEK_CUR ? (long int)_position : (origin == SEEK_END ? (long int)_length : 0);
+        if (base + offset < 0 || (size_t)(base + offset) > _length)
+            return false;
+        _position = (size_t)(base + offset);
+        return true;
+    }
+
+    virtual bool rewind()
+    {
+        _position = 0;
+        return true;
+    }
+
+private:
+
+    const unsigned char* _data;
+    size_t _length;
+    size_t _position;
+};
 
 // Callbacks for loading an ogg file using Stream
 static size_t readStream(void *ptr, size_t size, size_t nmemb, void *datasource)
@@ -39,65 +289,163 @@ static long tellStream(void *datasource)
 }
 
 AudioBuffer::AudioBuffer(const char* path, ALuint buffer)
-    : _filePath(path), _alBuffer(buffer)
+    : _filePath(path), _alBuffer(buffer), _duration(-1.0f), _streamed(false), _memorySize(0), _clip(NULL), _clipBuffer(NULL), _clipFrame(0),
+      _decoderOpen(false), _ring(NULL), _chunkSize(AUDIO_STREAM_CHUNK_SIZE), _stream(NULL), _streamFormat(0), _streamFrequency(0),
+      _queueIndex(0), _decodedCount(0), _streamEnded(false), _streamLooped(false), _streamJob(NULL)
 {
+    memset(&_oggFile, 0, sizeof(_oggFile));
 }
 
 AudioBuffer::~AudioBuffer()
 {
-    // Remove the buffer from the cache.
-    unsigned int bufferCount = (unsigned int)__buffers.size();
-    for (unsigned int i = 0; i < bufferCount; i++)
-    {
-        if (this == __buffers[i])
-        {
-            __buffers.erase(__buffers.begin() + i);
-            break;
-        }
-    }
-
     if (_alBuffer)
     {
+        // Remove the buffer from the cache.
+        __bufferCache.remove(ResourceCache::Key(_filePath.c_str()), this);
+
         AL_CHECK( alDeleteBuffers(1, &_alBuffer) );
         _alBuffer = 0;
     }
+    if (_clip)
+    {
+        // Remove the clip from the cache.
+        __bufferCache.remove(ResourceCache::Key(_filePath.c_str(), "compressed"), this);
+
+        SAFE_DELETE_ARRAY(_clip->data);
+        SAFE_DELETE(_clip);
+    }
+    setMemorySize(0);
+
+    if (_streamed)
+    {
+        // The decoding job still uses the ogg file.
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (_streamJob && scheduler)
+        {
+            scheduler->wait(_streamJob);
+        }
+        _streamJob = NULL;
+
+        if (_clipBuffer)
+        {
+            // The ring of a compressed buffer goes back to the pool.
+            closeDecoder();
+            SAFE_DELETE(_stream);
+            SAFE_RELEASE(_clipBuffer);
+        }
+        else
+        {
+            ov_clear(&_oggFile);
+            SAFE_DELETE(_stream);
+            if (!_streamBuffers.empty())
+            {
+                AL_CHECK( alDeleteBuffers((ALsizei)_streamBuffers.size(), &_streamBuffers[0]) );
+            }
+            for (size_t i = 0, count = _chunks.size(); i < count; ++i)
+            {
+                SAFE_DELETE_ARRAY(_chunks[i].data);
+            }
+        }
+    }
 }
 
-AudioBuffer* AudioBuffer::create(const char* path)
+AudioBuffer* AudioBuffer::create(const char* path, bool streamed, bool compressed)
 {
     GP_ASSERT(path);
 
-    // Search the cache for a stream from this file.
-    unsigned int bufferCount = (unsigned int)__buffers.size();
-    AudioBuffer* buffer = NULL;
-    for (unsigned int i = 0; i < bufferCount; i++)
+    // Compressed buffers decode a clip that is shared by every source playing the file.
+    std::string normalizedPath = normalizePath(path);
+    if (compressed)
     {
-        buffer = __buffers[i];
-        GP_ASSERT(buffer);
-        if (buffer->_filePath.compare(path) == 0)
+        ResourceCache::Key key(normalizedPath.c_str(), "compressed");
+        AudioBuffer* clipBuffer = static_cast<AudioBuffer*>(__bufferCache.find(key));
+        if (clipBuffer)
         {
-            buffer->addRef();
-            return buffer;
+            clipBuffer->addRef();
+        }
+        else
+        {
+            LoadProfiler::Scope profile("audio", normalizedPath.c_str());
+            Clip clip;
+            if (!AudioBuffer::loadClip(normalizedPath.c_str(), &clip))
+                return NULL;
+            clipBuffer = new AudioBuffer(normalizedPath.c_str(), 0);
+            clipBuffer->_clip = new Clip(clip);
+            clipBuffer->setMemorySize(clip.size);
+            __bufferCache.add(key, clipBuffer);
         }
+        AudioBuffer* buffer = AudioBuffer::createClipStream(clipBuffer);
+        SAFE_RELEASE(clipBuffer);
+        return buffer;
     }
 
-    ALuint alBuffer;
+    // Streamed files are decoded while they play, into buffers of their own.
+    // Streamed buffers belong to a single source and are never shared.
+    if (streamed)
+    {
+        std::auto_ptr<Stream> stream(FileSystem::open(path));
+        if (stream.get() == NULL || !stream->canRead())
+        {
+            GP_ERROR("Failed to load audio file %s.", path);
+            return NULL;
+        }
+        char header[4];
+        if (stream->read(header, 1, 4) == 4 && memcmp(header, "OggS", 4) == 0)
+        {
+            return AudioBuffer::createStream(path, stream.release());
+        }
+        GP_WARN("Only ogg files can be streamed; loading audio file %s instead.", path);
+    }
 
-    // Load audio data into a buffer.
-    AL_CHECK( alGenBuffers(1, &alBuffer) );
-    if (AL_LAST_ERROR())
+    // Search the cache for a buffer loaded from this file.
+    AudioBuffer* buffer = static_cast<AudioBuffer*>(__bufferCache.find(ResourceCache::Key(normalizedPath.c_str())));
+    if (buffer)
     {
-        GP_ERROR("Failed to create OpenAL buffer; alGenBuffers error: %d", AL_LAST_ERROR());
-        AL_CHECK( alDeleteBuffers(1, &alBuffer) );
-        return NULL;
+        buffer->addRef();
+        return buffer;
     }
-    
+
+    // A file that is being preloaded is finished rather than decoded again.
+    for (size_t i = 0, count = _preloads.size(); i < count; ++i)
+    {
+        Preload* preload = _preloads[i];
+        if (preload->path == normalizedPath)
+        {
+            _preloads.erase(_preloads.begin() + i);
+            buffer = finishPreload(preload);
+            if (buffer)
+                buffer->addRef();
+            return buffer;
+        }
+    }
+
+    LoadProfiler::Scope profile("audio", normalizedPath.c_str());
+    Samples samples;
+    {
+        LoadProfiler::Phase decode(LoadProfiler::DECODE);
+        if (!AudioBuffer::load(normalizedPath.c_str(), &samples))
+            return NULL;
+    }
+    LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
+    return AudioBuffer::upload(normalizedPath.c_str(), &samples);
+}
+
+bool AudioBuffer::load(const char* path, Samples* samples)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(samples);
+
+    samples->format = 0;
+    samples->frequency = 0;
+    samples->data = NULL;
+    samples->size = 0;
+
     // Load sound file.
     std::auto_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
     {
         GP_ERROR("Failed to load audio file %s.", path);
-        goto cleanup;
+        return false;
     }
     
     // Read the file header
@@ -105,48 +453,249 @@ AudioBuffer* AudioBuffer::create(const char* path)
     if (stream->read(header, 1, 12) != 12)
     {
         GP_ERROR("Invalid header for audio file %s.", path);
-        goto cleanup;
+        return false;
     }
-    
+
     // Check the file format
     if (memcmp(header, "RIFF", 4) == 0)
     {
-        if (!AudioBuffer::loadWav(stream.get(), alBuffer))
+        if (!AudioBuffer::loadWav(stream.get(), samples))
         {
             GP_ERROR("Invalid wave file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else if (memcmp(header, "OggS", 4) == 0)
     {
-        if (!AudioBuffer::loadOgg(stream.get(), alBuffer))
+        if (!AudioBuffer::loadOgg(stream.get(), samples))
         {
             GP_ERROR("Invalid ogg file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else
     {
         GP_ERROR("Unsupported audio file: %s", path);
-        goto cleanup;
+        return false;
+    }
+    return true;
+}
+
+AudioBuffer* AudioBuffer::upload(const char* path, Samples* samples)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(samples && samples->data);
+
+    ALuint alBuffer;
+
+    // Load audio data into a buffer.
+    AL_CHECK( alGenBuffers(1, &alBuffer) );
+    if (AL_LAST_ERROR())
+    {
+        GP_ERROR("Failed to create OpenAL buffer; alGenBuffers error: %d", AL_LAST_ERROR());
+        AL_CHECK( alDeleteBuffers(1, &alBuffer) );
+        SAFE_DELETE_ARRAY(samples->data);
+        return NULL;
     }
+    AL_CHECK( alBufferData(alBuffer, samples->format, samples->data, (ALsizei)samples->size, samples->frequency) );
+    SAFE_DELETE_ARRAY(samples->data);
 
-    buffer = new AudioBuffer(path, alBuffer);
+    AudioBuffer* buffer = new AudioBuffer(path, alBuffer);
+    buffer->setMemorySize(samples->size);
 
     // Add the buffer to the cache.
-    __buffers.push_back(buffer);
+    __bufferCache.add(ResourceCache::Key(path), buffer);
 
     return buffer;
-    
-cleanup:
-    if (alBuffer)
-        AL_CHECK( alDeleteBuffers(1, &alBuffer) );
-    return NULL;
 }
 
-bool AudioBuffer::loadWav(Stream* stream, ALuint buffer)
+bool AudioBuffer::loadClip(const char* path, Clip* clip)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(clip);
+
+    memset(clip, 0, sizeof(Clip));
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to load audio file %s.", path);
+        return false;
+    }
+
+    char header[12];
+    if (stream->read(header, 1, 12) != 12)
+    {
+        GP_ERROR("Invalid header for audio file %s.", path);
+        return false;
+    }
+
+    if (memcmp(header, "RIFF", 4) == 0)
+    {
+        if (!AudioBuffer::loadWavClip(stream.get(), clip))
+        {
+            GP_ERROR("Invalid wave file: %s", path);
+            return false;
+        }
+        return true;
+    }
+    if (memcmp(header, "OggS", 4) == 0)
+    {
+        // Ogg Vorbis files are kept as they are.
+        size_t length = stream->length();
+        clip->data = new unsigned char[length];
+        if (!stream->rewind() || stream->read(clip->data, 1, length) != length)
+        {
+            GP_ERROR("Failed to read ogg file: %s", path);
+            SAFE_DELETE_ARRAY(clip->data);
+            return false;
+        }
+        clip->size = (unsigned int)length;
+        return true;
+    }
+
+    GP_ERROR("Unsupported audio file: %s", path);
+    return false;
+}
+
+bool AudioBuffer::loadWavClip(Stream* stream, Clip* clip)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(clip);
+
+    unsigned int formatTag = 0;
+    unsigned int bits = 0;
+    unsigned int factFrameCount = 0;
+    while (true)
+    {
+        unsigned char header[8];
+        if (stream->read(header, 1, 8) != 8)
+        {
+            GP_ERROR("Failed to load wave file; file appears to have no data.");
+            return false;
+        }
+        const unsigned int size = readUnsignedInt(header + 4);
+
+        if (memcmp(header, "fmt ", 4) == 0)
+        {
+            unsigned char format[20];
+            const unsigned int length = std::min(size, (unsigned int)sizeof(format));
+            if (size < 16 || stream->read(format, 1, length) != length || !stream->seek(size - length + (size & 1), SEEK_CUR))
+            {
+                GP_ERROR("Failed to read the format of the wave file.");
+                return false;
+            }
+            formatTag = readUnsignedShort(format);
+            clip->channels = readUnsignedShort(format + 2);
+            clip->frequency = readUnsignedInt(format + 4);
+            clip->blockAlign = readUnsignedShort(format + 12);
+            bits = readUnsignedShort(format + 14);
+            clip->samplesPerBlock = length >= 20 ? readUnsignedShort(format + 18) : 0;
+        }
+        else if (memcmp(header, "fact", 4) == 0)
+        {
+            unsigned char fact[4];
+            if (size < 4 || stream->read(fact, 1, 4) != 4 || !stream->seek(size - 4 + (size & 1), SEEK_CUR))
+            {
+                GP_ERROR("Failed to read the 'fact' chunk of the wave file.");
+                return false;
+            }
+            factFrameCount = readUnsignedInt(fact);
+        }
+        else if (memcmp(header, "data", 4) == 0)
+        {
+            if (clip->channels < 1 || clip->channels > 2)
+            {
+                GP_ERROR("Unsupported wave file channel count (%u) or missing format.", clip->channels);
+                return false;
+            }
+            const unsigned int channels = clip->channels;
+
+            unsigned char* data = new unsigned char[size];
+            if (stream->read(data, 1, size) != size)
+            {
+                GP_ERROR("Failed to load wave file; file is missing data.");
+                SAFE_DELETE_ARRAY(data);
+                return false;
+            }
+
+            if (formatTag == WAVE_FORMAT_IMA_ADPCM)
+            {
+                // IMA ADPCM blocks are kept as they are.
+                const unsigned int headerSize = channels * 4;
+                if (bits != 4 || clip->blockAlign <= headerSize || clip->blockAlign > AUDIO_ADPCM_MAX_BLOCK_ALIGN || clip->blockAlign % headerSize != 0)
+                {
+                    GP_ERROR("Unsupported IMA ADPCM wave file (%u bits, blocks of %u bytes).", bits, clip->blockAlign);
+                    SAFE_DELETE_ARRAY(data);
+                    return false;
+                }
+                const unsigned int samplesPerBlock = (clip->blockAlign - headerSize) * 2 / channels + 1;
+                if (clip->samplesPerBlock == 0 || clip->samplesPerBlock > samplesPerBlock)
+                    clip->samplesPerBlock = samplesPerBlock;
+
+                // The last block may be partial.
+                const unsigned int rest = size % clip->blockAlign;
+                clip->frameCount = (size / clip->blockAlign) * clip->samplesPerBlock;
+                if (rest >= headerSize)
+                    clip->frameCount += std::min(clip->samplesPerBlock, 1 + (rest - headerSize) / headerSize * 8);
+                if (factFrameCount > 0)
+                    clip->frameCount = std::min(clip->frameCount, factFrameCount);
+                clip->data = data;
+                clip->size = size;
+                clip->adpcm = true;
+                return true;
+            }
+
+            if (formatTag != 1 || (bits != 8 && bits != 16))
+            {
+                GP_ERROR("Unsupported wave file format %u with %u bits (must be PCM or IMA ADPCM).", formatTag, bits);
+                SAFE_DELETE_ARRAY(data);
+                return false;
+            }
+
+            // Encode the PCM samples to IMA ADPCM, a quarter of the size of 16-bit samples.
+            const unsigned int frameCount = size / (channels * bits / 8);
+            if (frameCount == 0)
+            {
+                GP_ERROR("Failed to load wave file; file has no samples.");
+                SAFE_DELETE_ARRAY(data);
+                return false;
+            }
+            std::vector<short> samples(frameCount * channels);
+            for (size_t i = 0, count = samples.size(); i < count; ++i)
+            {
+                samples[i] = bits == 8 ? (short)((data[i] - 128) << 8) : (short)readUnsignedShort(data + i * 2);
+            }
+            SAFE_DELETE_ARRAY(data);
+
+            clip->blockAlign = AUDIO_ADPCM_BLOCK_ALIGN * channels;
+            clip->samplesPerBlock = (AUDIO_ADPCM_BLOCK_ALIGN - 4) * 2 + 1;
+            const unsigned int blockCount = (frameCount + clip->samplesPerBlock - 1) / clip->samplesPerBlock;
+            clip->size = blockCount * clip->blockAlign;
+            clip->data = new unsigned char[clip->size];
+            int indices[2] = { 0, 0 };
+            for (unsigned int i = 0; i < blockCount; ++i)
+            {
+                const unsigned int first = i * clip->samplesPerBlock;
+                encodeImaBlock(&samples[first * channels], channels, std::min(clip->samplesPerBlock, frameCount - first),
+                    clip->samplesPerBlock, indices, clip->data + i * clip->blockAlign);
+            }
+            clip->frameCount = frameCount;
+            clip->adpcm = true;
+            return true;
+        }
+        else if (!stream->seek(size + (size & 1), SEEK_CUR))
+        {
+            GP_ERROR("Failed to seek past a chunk of the wave file.");
+            return false;
+        }
+    }
+}
+
+bool AudioBuffer::loadWav(Stream* stream, Samples* samples)
 {
     GP_ASSERT(stream);
+    GP_ASSERT(samples);
 
     unsigned char data[12];
     
@@ -283,8 +832,10 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer)
                 return false;
             }
 
-            AL_CHECK( alBufferData(buffer, format, data, dataSize, frequency) );
-            SAFE_DELETE_ARRAY(data);
+            samples->format = format;
+            samples->frequency = frequency;
+            samples->data = data;
+            samples->size = dataSize;
 
             // We've read the data, so return now.
             return true;
@@ -330,9 +881,10 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer)
     return false;
 }
 
-bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer)
+bool AudioBuffer::loadOgg(Stream* stream, Samples* samples)
 {
     GP_ASSERT(stream);
+    GP_ASSERT(samples);
 
     OggVorbis_File ogg_file;
     vorbis_info* info;
@@ -392,12 +944,615 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer)
         return false;
     }
 
-    AL_CHECK( alBufferData(buffer, format, data, data_size, info->rate) );
+    samples->format = format;
+    samples->frequency = (ALsizei)info->rate;
+    samples->data = data;
+    samples->size = (unsigned int)data_size;
 
-    SAFE_DELETE_ARRAY(data);
     ov_clear(&ogg_file);
 
     return true;
 }
 
+float AudioBuffer::getDuration()
+{
+    GP_ASSERT(!_streamed);
+
+    // The data of a loaded buffer never changes, so the duration is only queried once.
+    if (_duration < 0.0f)
+    {
+        ALint size = 0;
+        ALint frequency = 0;
+        ALint channels = 0;
+        ALint bits = 0;
+        AL_CHECK( alGetBufferi(_alBuffer, AL_SIZE, &size) );
+        AL_CHECK( alGetBufferi(_alBuffer, AL_FREQUENCY, &frequency) );
+        AL_CHECK( alGetBufferi(_alBuffer, AL_CHANNELS, &channels) );
+        AL_CHECK( alGetBufferi(_alBuffer, AL_BITS, &bits) );
+        _duration = (frequency > 0 && channels > 0 && bits >= 8) ? (float)size / (frequency * channels * (bits / 8)) : 0.0f;
+    }
+    return _duration;
+}
+
+AudioBuffer* AudioBuffer::createStream(const char* path, Stream* stream)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(stream);
+
+    stream->rewind();
+
+    ov_callbacks callbacks;
+    callbacks.read_func = readStream;
+    callbacks.seek_func = seekStream;
+    callbacks.close_func = closeStream;
+    callbacks.tell_func = tellStream;
+
+    // The ogg file keeps pointers into itself, so it is opened in place.
+    AudioBuffer* buffer = new AudioBuffer(path, 0);
+    if (ov_open_callbacks(stream, &buffer->_oggFile, NULL, 0, callbacks) < 0)
+    {
+        GP_ERROR("Failed to open ogg file %s.", path);
+        SAFE_DELETE(stream);
+        SAFE_RELEASE(buffer);
+        return NULL;
+    }
+    buffer->_streamed = true;
+    buffer->_stream = stream;
+
+    vorbis_info* info = ov_info(&buffer->_oggFile, -1);
+    GP_ASSERT(info);
+    buffer->_streamFormat = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    buffer->_streamFrequency = (ALsizei)info->rate;
+
+    ALuint alBuffers[AUDIO_STREAM_BUFFER_COUNT];
+    AL_CHECK( alGenBuffers(AUDIO_STREAM_BUFFER_COUNT, alBuffers) );
+    if (AL_LAST_ERROR())
+    {
+        GP_ERROR("Failed to create OpenAL buffers for streamed audio file %s; alGenBuffers error: %d", path, AL_LAST_ERROR());
+        SAFE_RELEASE(buffer);
+        return NULL;
+    }
+    buffer->_streamBuffers.assign(alBuffers, alBuffers + AUDIO_STREAM_BUFFER_COUNT);
+    buffer->_freeBuffers = buffer->_streamBuffers;
+
+    buffer->_chunks.resize(AUDIO_STREAM_BUFFER_COUNT);
+    for (unsigned int i = 0; i < AUDIO_STREAM_BUFFER_COUNT; ++i)
+    {
+        buffer->_chunks[i].data = new char[AUDIO_STREAM_CHUNK_SIZE];
+        buffer->_chunks[i].size = 0;
+    }
+
+    // The decoded chunks, and the OpenAL buffers they are uploaded to.
+    buffer->setMemorySize(AUDIO_STREAM_BUFFER_COUNT * AUDIO_STREAM_CHUNK_SIZE * 2);
+
+    return buffer;
+}
+
+AudioBuffer* AudioBuffer::createClipStream(AudioBuffer* clipBuffer)
+{
+    GP_ASSERT(clipBuffer && clipBuffer->_clip);
+
+    const Clip* clip = clipBuffer->_clip;
+    AudioBuffer* buffer = new AudioBuffer(clipBuffer->_filePath.c_str(), 0);
+    buffer->_streamed = true;
+    buffer->_clipBuffer = clipBuffer;
+    clipBuffer->addRef();
+    buffer->_chunkSize = AUDIO_CLIP_CHUNK_SIZE;
+    if (clip->adpcm)
+    {
+        buffer->_streamFormat = clip->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+        buffer->_streamFrequency = (ALsizei)clip->frequency;
+    }
+    else
+    {
+        // The format of a Vorbis clip is known once its decoder is opened.
+        buffer->_stream = new ClipStream(clip->data, clip->size);
+    }
+    return buffer;
+}
+
+bool AudioBuffer::isStreamed() const
+{
+    return _streamed;
+}
+
+void AudioBuffer::resetStream(ALuint source)
+{
+    GP_ASSERT(_streamed);
+
+    // A compressed buffer takes its decoder when it starts playing.
+    if (_clipBuffer && !openDecoder())
+        return;
+
+    if (_streamJob)
+    {
+        Game::getInstance()->getJobScheduler()->wait(_streamJob);
+        _streamJob = NULL;
+    }
+
+    // Rewinding puts the source in its initial state, in which its buffers can be detached.
+    AL_CHECK( alSourceRewind(source) );
+    AL_CHECK( alSourcei(source, AL_BUFFER, 0) );
+    _freeBuffers = _streamBuffers;
+
+    if (!rewindSamples())
+    {
+        GP_WARN("Failed to seek to the start of streamed audio file %s.", _filePath.c_str());
+    }
+    _queueIndex = 0;
+    _decodedCount = 0;
+    _streamEnded = false;
+
+    // Decode the first chunk right away so the source can start playing, the job decodes the rest.
+    decodeChunks(1);
+    queueChunks(source);
+}
+
+bool AudioBuffer::isStreamIdle() const
+{
+    return _clipBuffer && !_decoderOpen;
+}
+
+void AudioBuffer::stopStream(ALuint source)
+{
+    GP_ASSERT(_streamed);
+
+    if (!_clipBuffer || !_decoderOpen)
+        return;
+
+    if (_streamJob)
+    {
+        Game::getInstance()->getJobScheduler()->wait(_streamJob);
+        _streamJob = NULL;
+    }
+
+    // The buffers of the ring are detached from the stopped source before the ring goes back to the pool.
+    AL_CHECK( alSourceStop(source) );
+    AL_CHECK( alSourcei(source, AL_BUFFER, 0) );
+    closeDecoder();
+}
+
+bool AudioBuffer::openDecoder()
+{
+    GP_ASSERT(_clipBuffer);
+
+    if (_decoderOpen)
+        return true;
+
+    const Clip* clip = _clipBuffer->_clip;
+    if (!clip->adpcm)
+    {
+        ov_callbacks callbacks;
+        callbacks.read_func = readStream;
+        callbacks.seek_func = seekStream;
+        callbacks.close_func = closeStream;
+        callbacks.tell_func = tellStream;
+
+        _stream->rewind();
+        if (ov_open_callbacks(_stream, &_oggFile, NULL, 0, callbacks) < 0)
+        {
+            GP_WARN("Failed to open compressed audio file %s.", _filePath.c_str());
+            memset(&_oggFile, 0, sizeof(_oggFile));
+            return false;
+        }
+        vorbis_info* info = ov_info(&_oggFile, -1);
+        GP_ASSERT(info);
+        _streamFormat = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+        _streamFrequency = (ALsizei)info->rate;
+    }
+    _clipFrame = 0;
+
+    // Take a ring from the pool, or create one when every ring is playing.
+    if (_rings.empty())
+    {
+        ALuint alBuffers[AUDIO_STREAM_BUFFER_COUNT];
+        AL_CHECK( alGenBuffers(AUDIO_STREAM_BUFFER_COUNT, alBuffers) );
+        if (AL_LAST_ERROR())
+        {
+            GP_WARN("Failed to create OpenAL buffers for compressed audio file %s; alGenBuffers error: %d", _filePath.c_str(), AL_LAST_ERROR());
+            if (!clip->adpcm)
+                ov_clear(&_oggFile);
+            return false;
+        }
+        Ring* ring = new Ring();
+        ring->buffers.assign(alBuffers, alBuffers + AUDIO_STREAM_BUFFER_COUNT);
+        ring->chunks.resize(AUDIO_STREAM_BUFFER_COUNT);
+        for (unsigned int i = 0; i < AUDIO_STREAM_BUFFER_COUNT; ++i)
+        {
+            ring->chunks[i].data = new char[AUDIO_CLIP_CHUNK_SIZE];
+            ring->chunks[i].size = 0;
+        }
+        Allocator::track(Allocator::AUDIO, AUDIO_STREAM_BUFFER_COUNT * AUDIO_CLIP_CHUNK_SIZE * 2);
+        _rings.push_back(ring);
+    }
+    _ring = _rings.back();
+    _rings.pop_back();
+    _streamBuffers.swap(_ring->buffers);
+    _chunks.swap(_ring->chunks);
+    _freeBuffers = _streamBuffers;
+    _decoderOpen = true;
+    return true;
+}
+
+void AudioBuffer::closeDecoder()
+{
+    if (!_decoderOpen)
+        return;
+
+    if (_streamJob)
+    {
+        Game::getInstance()->getJobScheduler()->wait(_streamJob);
+        _streamJob = NULL;
+    }
+
+    if (!_clipBuffer->_clip->adpcm)
+        ov_clear(&_oggFile);
+
+    _streamBuffers.swap(_ring->buffers);
+    _chunks.swap(_ring->chunks);
+    _rings.push_back(_ring);
+    _ring = NULL;
+    _freeBuffers.clear();
+    _queueIndex = 0;
+    _decodedCount = 0;
+    _decoderOpen = false;
+}
+
+long AudioBuffer::readSamples(char* data, unsigned int size)
+{
+    if (_clipBuffer && _clipBuffer->_clip->adpcm)
+        return readAdpcm(data, size);
+
+    int section;
+    return ov_read(&_oggFile, data, (int)size, 0, 2, 1, &section);
+}
+
+long AudioBuffer::readAdpcm(char* data, unsigned int size)
+{
+    const Clip* clip = _clipBuffer->_clip;
+    const unsigned int frameSize = clip->channels * 2;
+    unsigned int count = 0;
+    while (size - count >= frameSize && _clipFrame < clip->frameCount)
+    {
+        // Decode the frames of the current block that fit, from the start of the block.
+        const unsigned int block = _clipFrame / clip->samplesPerBlock;
+        const unsigned int first = _clipFrame % clip->samplesPerBlock;
+        unsigned int last = std::min(clip->samplesPerBlock, clip->frameCount - block * clip->samplesPerBlock);
+        last = std::min(last, first + (size - count) / frameSize);
+        decodeImaBlock(clip->data + block * clip->blockAlign, clip->channels, first, last, reinterpret_cast<short*>(data + count));
+        count += (last - first) * frameSize;
+        _clipFrame += last - first;
+    }
+    return (long)count;
+}
+
+bool AudioBuffer::rewindSamples()
+{
+    if (_clipBuffer && _clipBuffer->_clip->adpcm)
+    {
+        _clipFrame = 0;
+        return true;
+    }
+    return ov_pcm_seek(&_oggFile, 0) == 0;
+}
+
+void AudioBuffer::updateStream(ALuint source)
+{
+    GP_ASSERT(_streamed);
+
+    // Recycle the buffers the source has finished playing.
+    ALint processed = 0;
+    AL_CHECK( alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed) );
+    for (ALint i = 0; i < processed; ++i)
+    {
+        ALuint alBuffer = 0;
+        AL_CHECK( alSourceUnqueueBuffers(source, 1, &alBuffer) );
+        _freeBuffers.push_back(alBuffer);
+    }
+    queueChunks(source);
+
+    // A source that ran out of queued data before the next chunk was decoded stops, so restart it.
+    ALint state = AL_INITIAL;
+    ALint queued = 0;
+    AL_CHECK( alGetSourcei(source, AL_SOURCE_STATE, &state) );
+    AL_CHECK( alGetSourcei(source, AL_BUFFERS_QUEUED, &queued) );
+    if (state == AL_STOPPED && queued > 0)
+    {
+        AL_CHECK( alSourcePlay(source) );
+    }
+
+    // Decode the chunks that have been queued.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    GP_ASSERT(scheduler);
+    if (_streamJob && scheduler->isFinished(_streamJob))
+    {
+        scheduler->release(_streamJob);
+        _streamJob = NULL;
+    }
+    if (_streamJob == NULL)
+    {
+        bool decode;
+        {
+            MutexLock lock(_streamMutex);
+            decode = !_streamEnded && _decodedCount < _chunks.size();
+        }
+        if (decode)
+        {
+            _streamJob = scheduler->submit(decodeStream, this);
+        }
+    }
+}
+
+void AudioBuffer::setStreamLooped(bool looped)
+{
+    MutexLock lock(_streamMutex);
+    _streamLooped = looped;
+
+    // A stream that already reached its end starts over.
+    if (looped)
+        _streamEnded = false;
+}
+
+void AudioBuffer::queueChunks(ALuint source)
+{
+    unsigned int count;
+    {
+        MutexLock lock(_streamMutex);
+        count = _decodedCount;
+    }
+
+    while (count > 0 && !_freeBuffers.empty())
+    {
+        const Chunk& chunk = _chunks[_queueIndex];
+        ALuint alBuffer = _freeBuffers.back();
+        _freeBuffers.pop_back();
+        AL_CHECK( alBufferData(alBuffer, _streamFormat, chunk.data, chunk.size, _streamFrequency) );
+        AL_CHECK( alSourceQueueBuffers(source, 1, &alBuffer) );
+        --count;
+
+        MutexLock lock(_streamMutex);
+        _queueIndex = (_queueIndex + 1) % _chunks.size();
+        --_decodedCount;
+    }
+}
+
+void AudioBuffer::decodeChunks(unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // Only the slots after the decoded chunks are free, the others wait to be queued.
+        unsigned int index;
+        bool looped;
+        {
+            MutexLock lock(_streamMutex);
+            if (_streamEnded || _decodedCount == _chunks.size())
+                return;
+            index = (_queueIndex + _decodedCount) % _chunks.size();
+            looped = _streamLooped;
+        }
+
+        Chunk& chunk = _chunks[index];
+        chunk.size = 0;
+        bool ended = false;
+        bool rewound = false;
+        while (chunk.size < _chunkSize)
+        {
+            long result = readSamples(chunk.data + chunk.size, _chunkSize - chunk.size);
+            if (result > 0)
+            {
+                chunk.size += (unsigned int)result;
+                rewound = false;
+            }
+            else if (result == OV_HOLE)
+            {
+                continue;
+            }
+            else if (result == 0 && looped && !rewound)
+            {
+                // Start over at the end of a looped stream, once in a row in case the file holds no samples.
+                rewound = true;
+                if (!rewindSamples())
+                {
+                    ended = true;
+                    break;
+                }
+            }
+            else
+            {
+                if (result < 0)
+                {
+                    GP_WARN("Failed to decode streamed audio file %s; ov_read error: %ld", _filePath.c_str(), result);
+                }
+                ended = true;
+                break;
+            }
+        }
+
+        MutexLock lock(_streamMutex);
+        if (chunk.size > 0)
+            ++_decodedCount;
+        if (ended)
+            _streamEnded = true;
+    }
+}
+
+void AudioBuffer::decodeStream(void* cookie)
+{
+    AudioBuffer* buffer = static_cast<AudioBuffer*>(cookie);
+    GP_ASSERT(buffer);
+    buffer->decodeChunks(AUDIO_STREAM_BUFFER_COUNT);
+}
+
+unsigned int AudioBuffer::preload(const char* manifestPath)
+{
+    GP_ASSERT(manifestPath);
+
+    Properties* manifest = Properties::create(manifestPath);
+    if (manifest == NULL)
+    {
+        GP_ERROR("Failed to load audio manifest '%s'.", manifestPath);
+        return 0;
+    }
+
+    // Every property of the manifest, in any of its namespaces, is the path of a file to load.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    unsigned int count = 0;
+    std::vector<Properties*> namespaces(1, manifest);
+    while (!namespaces.empty())
+    {
+        Properties* properties = namespaces.back();
+        namespaces.pop_back();
+        Properties* ns;
+        while ((ns = properties->getNextNamespace()) != NULL)
+        {
+            namespaces.push_back(ns);
+        }
+
+        const char* name;
+        while ((name = properties->getNextProperty()) != NULL)
+        {
+            std::string path;
+            if (!properties->getPath(name, &path))
+            {
+                GP_WARN("Audio file '%s' listed in manifest '%s' does not exist.", properties->getString(name), manifestPath);
+                continue;
+            }
+
+            // Files that are already loaded are kept loaded like the preloaded ones.
+            std::string normalizedPath = normalizePath(path.c_str());
+            AudioBuffer* buffer = static_cast<AudioBuffer*>(__bufferCache.find(ResourceCache::Key(normalizedPath.c_str())));
+            if (buffer)
+            {
+                if (std::find(__preloadedBuffers.begin(), __preloadedBuffers.end(), buffer) == __preloadedBuffers.end())
+                {
+                    buffer->addRef();
+                    __preloadedBuffers.push_back(buffer);
+                }
+                ++count;
+                continue;
+            }
+            bool pending = false;
+            for (size_t i = 0, preloadCount = _preloads.size(); i < preloadCount && !pending; ++i)
+            {
+                pending = _preloads[i]->path == normalizedPath;
+            }
+            if (pending)
+                continue;
+
+            Preload* preload = new Preload();
+            preload->path = normalizedPath;
+            preload->loaded = false;
+            preload->job = NULL;
+
+            // Without worker threads the files are decoded right away.
+            if (scheduler && scheduler->getWorkerCount() > 0)
+                preload->job = scheduler->submit(decodePreload, preload);
+            else
+                decodePreload(preload);
+            _preloads.push_back(preload);
+            ++count;
+        }
+    }
+    SAFE_DELETE(manifest);
+
+    return count;
+}
+
+void AudioBuffer::updatePreloads()
+{
+    if (_preloads.empty())
+        return;
+
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0; i < _preloads.size(); )
+    {
+        Preload* preload = _preloads[i];
+        if (preload->job && !scheduler->isFinished(preload->job))
+        {
+            ++i;
+            continue;
+        }
+        _preloads.erase(_preloads.begin() + i);
+        finishPreload(preload);
+    }
+}
+
+AudioBuffer* AudioBuffer::finishPreload(Preload* preload)
+{
+    GP_ASSERT(preload);
+
+    if (preload->job)
+    {
+        Game::getInstance()->getJobScheduler()->wait(preload->job);
+        preload->job = NULL;
+    }
+
+    // The preloaded buffers stay loaded until the audio controller is finalized.
+    AudioBuffer* buffer = NULL;
+    if (preload->loaded)
+    {
+        buffer = AudioBuffer::upload(preload->path.c_str(), &preload->samples);
+        if (buffer)
+            __preloadedBuffers.push_back(buffer);
+    }
+    SAFE_DELETE(preload);
+    return buffer;
+}
+
+void AudioBuffer::decodePreload(void* cookie)
+{
+    Preload* preload = static_cast<Preload*>(cookie);
+    GP_ASSERT(preload);
+    preload->loaded = AudioBuffer::load(preload->path.c_str(), &preload->samples);
+}
+
+void AudioBuffer::finalize()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = _preloads.size(); i < count; ++i)
+    {
+        Preload* preload = _preloads[i];
+        if (preload->job && scheduler)
+            scheduler->wait(preload->job);
+        SAFE_DELETE_ARRAY(preload->samples.data);
+        SAFE_DELETE(preload);
+    }
+    _preloads.clear();
+
+    for (size_t i = 0, count = __preloadedBuffers.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(__preloadedBuffers[i]);
+    }
+    __preloadedBuffers.clear();
+
+    // The OpenAL buffers must be deleted before the device is closed.
+    __bufferCache.setRetainedCapacity(0);
+    for (size_t i = 0, count = _rings.size(); i < count; ++i)
+    {
+        Ring* ring = _rings[i];
+        AL_CHECK( alDeleteBuffers((ALsizei)ring->buffers.size(), &ring->buffers[0]) );
+        for (size_t j = 0, chunkCount = ring->chunks.size(); j < chunkCount; ++j)
+        {
+            SAFE_DELETE_ARRAY(ring->chunks[j].data);
+        }
+        Allocator::untrack(Allocator::AUDIO, AUDIO_STREAM_BUFFER_COUNT * AUDIO_CLIP_CHUNK_SIZE * 2);
+        SAFE_DELETE(ring);
+    }
+    _rings.clear();
+}
+
+unsigned int AudioBuffer::getLoadedBufferCount()
+{
+    return __bufferCache.getResourceCount();
+}
+
+void AudioBuffer::setMemorySize(unsigned int size)
+{
+    if (_memorySize)
+        Allocator::untrack(Allocator::AUDIO, _memorySize);
+    _memorySize = size;
+    if (_memorySize)
+        Allocator::track(Allocator::AUDIO, _memorySize);
+}
+
 }
@@ -3,6 +3,8 @@
 
 #include "Ref.h"
 #include "Stream.h"
+#include "Thread.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
@@ -13,12 +15,86 @@ class AudioSource;
  * The actual audio buffer data.
  *
  * Currently only supports supported formats: .wav, .au and .raw files.
+ *
+ * A buffer is either loaded, in which case the whole file is decoded into a
+ * single OpenAL buffer that is shared by all sources playing the file, or
+ * streamed. A streamed buffer belongs to a single source and decodes an Ogg
+ * Vorbis file a chunk at a time on the job scheduler into a small ring of
+ * OpenAL buffers that are queued on the source as it plays.
+ *
+ * A compressed buffer is a streamed buffer that decodes a clip kept compressed
+ * in memory and shared by every source playing the file: Ogg Vorbis files are
+ * kept as they are, IMA ADPCM wave files are kept as ADPCM blocks and PCM wave
+ * files are encoded to IMA ADPCM when they are loaded, a quarter of their size.
+ * The decoder of a compressed buffer and its ring of OpenAL buffers are only
+ * held while its source plays, and the rings are pooled across all sources.
+ *
+ * Loaded buffers are cached by their normalized path, so every way of referring
+ * to a file shares the same buffer. Buffers listed in a preload manifest are
+ * decoded on the job scheduler and uploaded to OpenAL by the audio controller.
+ * The memory of every buffer is reported to the allocator under Allocator::AUDIO.
  */
 class AudioBuffer : public Ref
 {
     friend class AudioSource;
+    friend class AudioController;
 
 private:
+
+    /**
+     * Defines the PCM samples decoded from a file.
+     */
+    struct Samples
+    {
+        ALenum format;
+        ALsizei frequency;
+        char* data;
+        unsigned int size;
+    };
+
+    /**
+     * Defines the data of a clip kept compressed in memory.
+     */
+    struct Clip
+    {
+        unsigned char* data;
+        unsigned int size;
+        bool adpcm;                 // IMA ADPCM blocks, otherwise an Ogg Vorbis file.
+        unsigned int channels;
+        unsigned int frequency;
+        unsigned int blockAlign;
+        unsigned int samplesPerBlock;
+        unsigned int frameCount;
+    };
+
+    /**
+     * Defines a chunk of decoded PCM data waiting to be queued.
+     */
+    struct Chunk
+    {
+        char* data;
+        unsigned int size;
+    };
+
+    /**
+     * Defines the OpenAL buffers and decoded chunks of a pooled stream ring.
+     */
+    struct Ring
+    {
+        std::vector<ALuint> buffers;
+        std::vector<Chunk> chunks;
+    };
+
+    /**
+     * Defines a buffer of a preload manifest being decoded.
+     */
+    struct Preload
+    {
+        std::string path;
+        Samples samples;
+        bool loaded;
+        JobScheduler::Job* job;
+    };
     
     /**
      * Constructor.
@@ -39,17 +115,210 @@ private:
      * Creates an audio buffer from a file.
      * 
      * @param path The path to the audio buffer on the filesystem.
+     * @param streamed true to stream the file while it plays instead of loading it up front.
+     *      Only Ogg Vorbis files can be streamed, other files are always loaded.
+     * @param compressed true to keep the file compressed in memory and decode it while it plays.
+     *      This takes precedence over streamed.
      * 
      * @return The buffer from a file.
      */
-    static AudioBuffer* create(const char* path);
+    static AudioBuffer* create(const char* path, bool streamed = false, bool compressed = false);
+
+    /**
+     * Loads a clip kept compressed in memory.
+     *
+     * @param path The normalized path of the file.
+     * @param clip The clip to fill. Its data must be freed by the caller.
+     *
+     * @return true if the clip was loaded.
+     */
+    static bool loadClip(const char* path, Clip* clip);
+
+    /**
+     * Reads the format and data chunks of a wave file into a clip, encoding PCM data to IMA ADPCM.
+     */
+    static bool loadWavClip(Stream* stream, Clip* clip);
+
+    /**
+     * Creates a compressed buffer decoding the specified clip buffer.
+     */
+    static AudioBuffer* createClipStream(AudioBuffer* clipBuffer);
+
+    /**
+     * Decodes an audio file into PCM samples.
+     *
+     * @param path The normalized path of the file.
+     * @param samples The samples to fill. Their data must be freed by the caller.
+     *
+     * @return true if the file was decoded.
+     */
+    static bool load(const char* path, Samples* samples);
+
+    /**
+     * Uploads decoded samples to a new OpenAL buffer and adds the buffer to the cache.
+     *
+     * The data of the samples is freed.
+     */
+    static AudioBuffer* upload(const char* path, Samples* samples);
     
-    static bool loadWav(Stream* stream, ALuint buffer);
+    static bool loadWav(Stream* stream, Samples* samples);
     
-    static bool loadOgg(Stream* stream, ALuint buffer);
+    static bool loadOgg(Stream* stream, Samples* samples);
+
+    /**
+     * Starts decoding the files listed in a manifest on the job scheduler.
+     *
+     * @see AudioController::preload
+     */
+    static unsigned int preload(const char* manifestPath);
+
+    /**
+     * Uploads the preloaded buffers whose files have been decoded (called once per frame).
+     */
+    static void updatePreloads();
+
+    /**
+     * Waits for a preload and uploads its buffer.
+     */
+    static AudioBuffer* finishPreload(Preload* preload);
+
+    /**
+     * Decodes the file of a preload (called from a job).
+     */
+    static void decodePreload(void* cookie);
+
+    /**
+     * Releases the preloaded and retained buffers before the audio device is closed.
+     */
+    static void finalize();
+
+    /**
+     * Gets the number of loaded buffers in the cache.
+     */
+    static unsigned int getLoadedBufferCount();
+
+    /**
+     * Sets the size in bytes of the buffer and reports it to the allocator.
+     */
+    void setMemorySize(unsigned int size);
+
+    /**
+     * Gets the duration in seconds of a loaded buffer.
+     */
+    float getDuration();
+
+    /**
+     * Creates a streamed buffer for an opened Ogg Vorbis file.
+     */
+    static AudioBuffer* createStream(const char* path, Stream* stream);
+
+    /**
+     * Determines whether the buffer is streamed.
+     */
+    bool isStreamed() const;
+
+    /**
+     * Determines whether the buffer is a compressed buffer that does not hold a decoder,
+     * because its source is not playing.
+     */
+    bool isStreamIdle() const;
+
+    /**
+     * Called when the source stops, so that a compressed buffer returns its decoder and ring.
+     *
+     * @param source The source the stream is queued on.
+     */
+    void stopStream(ALuint source);
+
+    /**
+     * Opens the decoder of a compressed buffer and takes a ring from the pool.
+     */
+    bool openDecoder();
+
+    /**
+     * Closes the decoder of a compressed buffer and returns its ring to the pool.
+     */
+    void closeDecoder();
+
+    /**
+     * Decodes up to the specified number of bytes of samples.
+     *
+     * @return The number of bytes decoded, 0 at the end of the stream, or a negative Vorbis error.
+     */
+    long readSamples(char* data, unsigned int size);
+
+    /**
+     * Decodes IMA ADPCM samples of a compressed buffer.
+     */
+    long readAdpcm(char* data, unsigned int size);
+
+    /**
+     * Moves the decoder back to the first sample.
+     */
+    bool rewindSamples();
+
+    /**
+     * Stops the source, drops its queued buffers and restarts the stream from the beginning.
+     *
+     * @param source The source the stream is queued on.
+     */
+    void resetStream(ALuint source);
+
+    /**
+     * Called once per frame while the source plays to recycle the buffers it has
+     * played, queue newly decoded chunks and schedule decoding of the next ones.
+     *
+     * @param source The source the stream is queued on.
+     */
+    void updateStream(ALuint source);
+
+    /**
+     * Sets whether the stream restarts from the beginning once it reaches its end.
+     */
+    void setStreamLooped(bool looped);
+
+    /**
+     * Uploads the decoded chunks to the free OpenAL buffers and queues them on the source.
+     */
+    void queueChunks(ALuint source);
+
+    /**
+     * Decodes up to the specified number of chunks into the free slots of the ring.
+     */
+    void decodeChunks(unsigned int count);
+
+    /**
+     * Decodes the free chunks of the ring (called from a job).
+     */
+    static void decodeStream(void* cookie);
 
     std::string _filePath;
     ALuint _alBuffer;
+    float _duration;
+    bool _streamed;
+    unsigned int _memorySize;
+    Clip* _clip;                                // The data of a clip buffer.
+    AudioBuffer* _clipBuffer;                   // The clip a compressed buffer decodes.
+    unsigned int _clipFrame;                    // The next frame of an ADPCM clip to decode.
+    bool _decoderOpen;
+    Ring* _ring;                                // The pooled ring of a playing compressed buffer.
+    unsigned int _chunkSize;
+    Stream* _stream;
+    OggVorbis_File _oggFile;
+    ALenum _streamFormat;
+    ALsizei _streamFrequency;
+    std::vector<ALuint> _streamBuffers;
+    std::vector<ALuint> _freeBuffers;
+    std::vector<Chunk> _chunks;
+    unsigned int _queueIndex;                   // The next chunk to queue.
+    unsigned int _decodedCount;                 // The number of decoded chunks not yet queued.
+    bool _streamEnded;
+    bool _streamLooped;
+    Mutex _streamMutex;                         // Guards the chunk counters shared with the decoding job.
+    JobScheduler::Job* _streamJob;
+
+    static std::vector<Preload*> _preloads;     // Preloads whose buffers are not uploaded yet.
+    static std::vector<Ring*> _rings;           // Rings of compressed buffers that are not playing.
 };
 
 }
@@ -3,21 +3,36 @@
 #include "AudioListener.h"
 #include "AudioBuffer.h"
 #include "AudioSource.h"
+#include "Profiler.h"
+#include "Allocator.h"
 
 namespace gameplay
 {
 
 AudioController::AudioController() 
-    : _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL)
+    : _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _voiceLimit(32), _minGain(0.0f)
 {
+    memset(&_statistics, 0, sizeof(_statistics));
 }
 
 AudioController::~AudioController()
 {
 }
 
-void AudioController::initialize()
+void AudioController::initialize(Properties* properties)
 {
+    if (properties)
+    {
+        if (properties->exists("voices"))
+        {
+            _voiceLimit = (unsigned int)std::max(0, properties->getInt("voices"));
+        }
+        if (properties->exists("minGain"))
+        {
+            _minGain = std::max(0.0f, properties->getFloat("minGain"));
+        }
+    }
+
     _alcDevice = alcOpenDevice(NULL);
     if (!_alcDevice)
     {
@@ -40,10 +55,17 @@ void AudioController::initialize()
     {
         GP_ERROR("Unable to make OpenAL context current. Error: %d\n", alcErr);
     }
+
+    if (properties && properties->exists("preload"))
+    {
+        preload(properties->getString("preload"));
+    }
 }
 
 void AudioController::finalize()
 {
+    AudioBuffer::finalize();
+
     alcMakeContextCurrent(NULL);
     if (_alcContext)
     {
@@ -57,6 +79,37 @@ void AudioController::finalize()
     }
 }
 
+unsigned int AudioController::getVoiceLimit() const
+{
+    return _voiceLimit;
+}
+
+void AudioController::setVoiceLimit(unsigned int limit)
+{
+    _voiceLimit = limit;
+}
+
+float AudioController::getMinimumGain() const
+{
+    return _minGain;
+}
+
+void AudioController::setMinimumGain(float gain)
+{
+    _minGain = std::max(0.0f, gain);
+}
+
+const AudioController::Statistics& AudioController::getStatistics() const
+{
+    return _statistics;
+}
+
+unsigned int AudioController::preload(const char* manifestPath)
+{
+    GP_ASSERT(manifestPath);
+    return AudioBuffer::preload(manifestPath);
+}
+
 void AudioController::pause()
 {
     std::set<AudioSource*>::iterator itr = _playingSources.begin();
@@ -93,14 +146,125 @@ void AudioController::resume()
 
 void AudioController::update(float elapsedTime)
 {
+    GP_PROFILE_SCOPE("AudioController::update");
+
+    // Apply the changes of the whole frame at once.
+    if (_alcContext)
+        alcSuspendContext(_alcContext);
+
     AudioListener* listener = AudioListener::getInstance();
     if (listener)
     {
-        AL_CHECK( alListenerf(AL_GAIN, listener->getGain()) );
-        AL_CHECK( alListenerfv(AL_ORIENTATION, (ALfloat*)listener->getOrientation()) );
-        AL_CHECK( alListenerfv(AL_VELOCITY, (ALfloat*)&listener->getVelocity()) );
-        AL_CHECK( alListenerfv(AL_POSITION, (ALfloat*)&listener->getPosition()) );
+        listener->update(elapsedTime);
+    }
+
+    AudioBuffer::updatePreloads();
+    updateTransforms(elapsedTime);
+    updateVoices(elapsedTime);
+
+    _statistics.bufferCount = AudioBuffer::getLoadedBufferCount();
+    _statistics.bufferMemorySize = Allocator::getBytes(Allocator::AUDIO);
+
+    if (_alcContext)
+        alcProcessContext(_alcContext);
+}
+
+void AudioController::updateTransforms(float elapsedTime)
+{
+    // The sources that moved in the last update but not since then have stopped.
+    _movedSources.swap(_movingSources);
+    for (size_t i = 0, count = _movedSources.size(); i < count; ++i)
+    {
+        AudioSource* source = _movedSources[i];
+        if (!source->_transformDirty && source->updateTransform(elapsedTime))
+            _movingSources.push_back(source);
     }
+    _movedSources.clear();
+
+    for (size_t i = 0, count = _dirtySources.size(); i < count; ++i)
+    {
+        AudioSource* source = _dirtySources[i];
+        if (source->updateTransform(elapsedTime))
+            _movingSources.push_back(source);
+    }
+    _dirtySources.clear();
+}
+
+bool AudioController::compareVoices(const Voice& a, const Voice& b)
+{
+    return a.score > b.score;
+}
+
+void AudioController::updateVoices(float elapsedTime)
+{
+    AudioListener* listener = AudioListener::getInstance();
+    Vector3 listenerPosition = listener ? listener->getPosition() : Vector3::zero();
+
+    _voices.clear();
+    std::set<AudioSource*>::iterator itr = _playingSources.begin();
+    while (itr != _playingSources.end())
+    {
+        AudioSource* source = *itr;
+        GP_ASSERT(source);
+
+        if (source->_virtual)
+        {
+            // Forget virtual sources that would have finished playing by now.
+            if (!source->updateVirtual(elapsedTime))
+            {
+                _playingSources.erase(itr++);
+                continue;
+            }
+        }
+        else
+        {
+            // Keep streamed sources fed and forget the sources that finished playing.
+            source->updateStream();
+            AudioSource::State state = source->getState();
+            if (state == AudioSource::STOPPED || state == AudioSource::INITIAL)
+            {
+                _playingSources.erase(itr++);
+                continue;
+            }
+        }
+
+        Voice voice;
+        voice.source = source;
+        voice.audibility = source->getAudibility(listenerPosition);
+        voice.score = voice.audibility * source->_priority;
+        _voices.push_back(voice);
+        ++itr;
+    }
+
+    // Mix the highest ranked sources that are loud enough, up to the voice limit.
+    std::sort(_voices.begin(), _voices.end(), compareVoices);
+    _statistics.voiceCount = 0;
+    _statistics.realVoiceCount = 0;
+    _statistics.virtualVoiceCount = 0;
+    for (size_t i = 0, count = _voices.size(); i < count; ++i)
+    {
+        const Voice& voice = _voices[i];
+        AudioSource* source = voice.source;
+        if ((_voiceLimit == 0 || _statistics.realVoiceCount < _voiceLimit) && voice.audibility >= _minGain)
+        {
+            if (source->_virtual && !source->promote())
+            {
+                _playingSources.erase(source);
+                continue;
+            }
+            ++_statistics.realVoiceCount;
+        }
+        else
+        {
+            if (!source->_virtual)
+                source->demote();
+            ++_statistics.virtualVoiceCount;
+        }
+        ++_statistics.voiceCount;
+    }
+
+    GP_PROFILE_COUNTER("Audio voices", _statistics.realVoiceCount);
+    GP_PROFILE_COUNTER("Virtual audio voices", _statistics.virtualVoiceCount);
 }
 
 }
@@ -1,6 +1,8 @@
 #ifndef AUDIOCONTROLLER_H_
 #define AUDIOCONTROLLER_H_
 
+#include "Properties.h"
+
 namespace gameplay
 {
 
@@ -9,6 +11,25 @@ class AudioSource;
 
 /**
  * Defines a class for controlling game audio.
+ *
+ * The controller limits the number of sources that are mixed at once. Once per
+ * frame, the playing sources are ranked by their priority times their estimated
+ * audibility, which is their gain attenuated by their distance to the listener.
+ * Only the highest ranked sources, up to the voice limit and as long as they are
+ * loud enough, play as real voices. The others become virtual voices: they are
+ * paused while their place in the sound keeps advancing, and play again from
+ * there once they rank high enough. Streamed sources resume where they were
+ * paused. The limits, and a manifest of files to preload at startup (see
+ * preload), are configured in the game config:
+ *
+ * @verbatim
+    audio
+    {
+        voices = 32             // Sources mixed at once, or 0 for no limit.
+        minGain = 0.01          // Sources estimated quieter than this become virtual.
+        preload = res/audio.manifest
+    }
+   @endverbatim
  */
 class AudioController
 {
@@ -16,13 +37,122 @@ class AudioController
     friend class AudioSource;
 
 public:
-    
+
+    /**
+     * Defines the counters gathered by the controller.
+     *
+     * @script{ignore}
+     */
+    struct Statistics
+    {
+        /**
+         * The number of playing sources.
+         */
+        unsigned int voiceCount;
+
+        /**
+         * The number of playing sources that are mixed.
+         */
+        unsigned int realVoiceCount;
+
+        /**
+         * The number of playing sources that were skipped because they ranked too low.
+         */
+        unsigned int virtualVoiceCount;
+
+        /**
+         * The number of loaded (not streamed) audio buffers.
+         */
+        unsigned int bufferCount;
+
+        /**
+         * The size in bytes of the loaded and streamed audio buffers.
+         */
+        size_t bufferMemorySize;
+    };
+
     /**
      * Destructor.
      */
     virtual ~AudioController();
 
+    /**
+     * Gets the maximum number of sources that are mixed at once.
+     *
+     * @return The voice limit, or 0 if there is no limit.
+     * @script{ignore}
+     */
+    unsigned int getVoiceLimit() const;
+
+    /**
+     * Sets the maximum number of sources that are mixed at once.
+     *
+     * @param limit The voice limit, or 0 for no limit.
+     * @script{ignore}
+     */
+    void setVoiceLimit(unsigned int limit);
+
+    /**
+     * Gets the estimated gain below which playing sources become virtual.
+     *
+     * @return The minimum gain.
+     * @script{ignore}
+     */
+    float getMinimumGain() const;
+
+    /**
+     * Sets the estimated gain below which playing sources become virtual.
+     *
+     * @param gain The minimum gain, or 0 to keep quiet sources mixed.
+     * @script{ignore}
+     */
+    void setMinimumGain(float gain);
+
+    /**
+     * Gets the statistics of the controller.
+     *
+     * @return The statistics of the last update.
+     * @script{ignore}
+     */
+    const Statistics& getStatistics() const;
+
+    /**
+     * Starts loading the audio files listed in a manifest, so that sources created
+     * from them later do not decode them.
+     *
+     * Every property of the manifest, in any namespace, is the path of a file:
+     *
+     * @verbatim
+        sounds
+        {
+            footstep = res/audio/footstep.wav
+            explosion = res/audio/explosion.ogg
+        }
+       @endverbatim
+     *
+     * The files are decoded on the job scheduler and their buffers are uploaded
+     * by the following updates of the controller. A source created from a file that
+     * is still being decoded waits for it. The preloaded buffers stay loaded until
+     * the game shuts down.
+     *
+     * @param manifestPath The path of the manifest.
+     *
+     * @return The number of files of the manifest that are loaded or being loaded.
+     * @script{ignore}
+     */
+    unsigned int preload(const char* manifestPath);
+
 private:
+
+    /**
+     * Defines a playing source ranked for a voice.
+     */
+    struct Voice
+    {
+        AudioSource* source;
+        float audibility;
+        float score;
+    };
     
     /**
      * Constructor.
@@ -31,8 +161,10 @@ private:
 
     /**
      * Controller initialize.
+     *
+     * @param properties The 'audio' namespace of the game config, or NULL.
      */
-    void initialize();
+    void initialize(Properties* properties);
 
     /**
      * Controller finalize.
@@ -54,11 +186,29 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Passes the transforms of the sources that moved since the last frame to OpenAL.
+     */
+    void updateTransforms(float elapsedTime);
+
+    /**
+     * Makes the highest ranked playing sources real voices and the others virtual.
+     */
+    void updateVoices(float elapsedTime);
+
+    static bool compareVoices(const Voice& a, const Voice& b);
 
     ALCdevice* _alcDevice;
     ALCcontext* _alcContext;
     std::set<AudioSource*> _playingSources;
     AudioSource* _pausingSource;
+    std::vector<AudioSource*> _dirtySources;   // Sources whose node moved since the last update.
+    std::vector<AudioSource*> _movingSources;  // Sources whose node moved in the last update.
+    std::vector<AudioSource*> _movedSources;
+    std::vector<Voice> _voices;
+    unsigned int _voiceLimit;
+    float _minGain;
+    Statistics _statistics;
 };
 
 }
@@ -7,7 +7,7 @@ namespace gameplay
 {
 
 AudioListener::AudioListener()
-    : _gain(1.0f), _camera(NULL)
+    : _gain(1.0f), _camera(NULL), _dirty(true), _transformDirty(false), _transformReset(false)
 {
 }
 
@@ -31,6 +31,7 @@ float AudioListener::getGain() const
 void AudioListener::setGain(float gain)
 {
     _gain = gain;
+    _dirty = true;
 }
 
 const Vector3& AudioListener::getPosition() const 
@@ -41,11 +42,13 @@ const Vector3& AudioListener::getPosition() const
 void AudioListener::setPosition(const Vector3& position)
 {
     _position = position;
+    _dirty = true;
 }
 
 void AudioListener::setPosition(float x, float y, float z)
 {
     _position.set(x, y, z);
+    _dirty = true;
 }
 
 const Vector3& AudioListener::getVelocity() const 
@@ -56,11 +59,13 @@ const Vector3& AudioListener::getVelocity() const
 void AudioListener::setVelocity(const Vector3& velocity)
 {
     _velocity = velocity;
+    _dirty = true;
 }
 
 void AudioListener::setVelocity(float x, float y, float z)
 {
     _velocity.set(x, y, z);
+    _dirty = true;
 }
 
 const float* AudioListener::getOrientation() const
@@ -87,12 +92,14 @@ void AudioListener::setOrientation(const Vector3& forward, const Vector3& up)
     _orientation[1].x = up.x;
     _orientation[1].y = up.y;
     _orientation[1].z = up.z;
+    _dirty = true;
 }
 
 void AudioListener::setOrientation(float forwardX, float forwardY, float forwardZ, float upX, float upY, float upZ)
 {
     _orientation[0].set(forwardX, forwardY, forwardZ);
     _orientation[1].set(upX, upY, upZ);
+    _dirty = true;
 }
 
 Camera* AudioListener::getCamera() const
@@ -119,22 +126,54 @@ void AudioListener::setCamera(Camera* c)
         {
             GP_ASSERT(_camera->getNode());
             _camera->addRef();
-            _camera->getNode()->addListener(this);
+            _camera->getNode()->addListener(this, 0, false);
+            _transformDirty = true;
+            _transformReset = true;
         }
     }
 }
 
 void AudioListener::transformChanged(Transform* transform, long cookie)
 {
-    if (transform)
+    // The camera can move several times in a frame, it is only read once in update().
+    _transformDirty = true;
+}
+
+void AudioListener::update(float elapsedTime)
+{
+    Vector3 cameraVelocity;
+    Node* node = _camera ? _camera->getNode() : NULL;
+    if (_transformDirty && node)
     {
-        Node* node = static_cast<Node*>(transform);
-        setPosition(node->getTranslationWorld());
-        
+        Vector3 position = node->getTranslationWorld();
+        if (!_transformReset && elapsedTime > 0.0f)
+        {
+            cameraVelocity = (position - _position) * (1000.0f / elapsedTime);
+        }
+        setPosition(position);
+
         Vector3 up;
         node->getWorldMatrix().getUpVector(&up);
         setOrientation(node->getForwardVectorWorld(), up);
     }
+    _transformDirty = false;
+    _transformReset = false;
+
+    // A camera that moved in the last frame but not in this one has stopped.
+    if (cameraVelocity != _cameraVelocity)
+    {
+        _cameraVelocity = cameraVelocity;
+        _dirty = true;
+    }
+    if (!_dirty)
+        return;
+
+    Vector3 velocity = _velocity + _cameraVelocity;
+    AL_CHECK( alListenerf(AL_GAIN, _gain) );
+    AL_CHECK( alListenerfv(AL_ORIENTATION, (const ALfloat*)&_orientation[0]) );
+    AL_CHECK( alListenerfv(AL_VELOCITY, (const ALfloat*)&velocity) );
+    AL_CHECK( alListenerfv(AL_POSITION, (const ALfloat*)&_position) );
+    _dirty = false;
 }
 
 }
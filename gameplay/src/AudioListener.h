@@ -73,6 +73,9 @@ public:
     /**
      * Sets the velocity of the audio source
      *
+     * While the listener is bound to a camera, the velocity the camera moves with,
+     * measured once per frame, is added to this velocity.
+     *
      * @param velocity A vector representing the velocity.
      */
     void setVelocity(const Vector3& velocity);
@@ -160,11 +163,20 @@ private:
     */
     void transformChanged(Transform* transform, long cookie);
 
+    /**
+    * Takes the transform of the camera and passes the changed listener state to OpenAL (called once per frame).
+    */
+    void update(float elapsedTime);
+
     float _gain;
     Vector3 _position;
     Vector3 _velocity;
     Vector3 _orientation[2];
     Camera* _camera;
+    Vector3 _cameraVelocity;    // The velocity of the camera over the last frame.
+    bool _dirty;                // The listener state has changed since it was last passed to OpenAL.
+    bool _transformDirty;       // The camera has moved since the last frame.
+    bool _transformReset;       // The camera has just been bound, so it has no velocity yet.
 };
 
 }
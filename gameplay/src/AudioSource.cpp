@@ -9,11 +9,22 @@
 namespace gameplay
 {
 
+static void eraseSource(std::vector<AudioSource*>& sources, AudioSource* source)
+{
+    std::vector<AudioSource*>::iterator itr = std::find(sources.begin(), sources.end(), source);
+    if (itr != sources.end())
+        sources.erase(itr);
+}
+
 AudioSource::AudioSource(AudioBuffer* buffer, ALuint source) 
-    : _alSource(source), _buffer(buffer), _looped(false), _gain(1.0f), _pitch(1.0f), _node(NULL)
+    : _alSource(source), _buffer(buffer), _looped(false), _gain(1.0f), _pitch(1.0f), _node(NULL),
+      _priority(1.0f), _transformDirty(false), _transformReset(false), _virtual(false), _virtualOffset(0.0f)
 {
     GP_ASSERT(buffer);
-    AL_CHECK( alSourcei(_alSource, AL_BUFFER, buffer->_alBuffer) );
+    if (!buffer->isStreamed())
+        AL_CHECK( alSourcei(_alSource, AL_BUFFER, buffer->_alBuffer) );
+    else if (!buffer->isStreamIdle())
+        buffer->resetStream(_alSource);
     AL_CHECK( alSourcei(_alSource, AL_LOOPING, _looped) );
     AL_CHECK( alSourcef(_alSource, AL_PITCH, _pitch) );
     AL_CHECK( alSourcef(_alSource, AL_GAIN, _gain) );
@@ -22,6 +33,16 @@ AudioSource::AudioSource(AudioBuffer* buffer, ALuint source)
 
 AudioSource::~AudioSource()
 {
+    // Remove the source from the controller's set of currently playing sources.
+    Game* game = Game::getInstance();
+    AudioController* audioController = game ? game->getAudioController() : NULL;
+    if (audioController)
+    {
+        audioController->_playingSources.erase(this);
+        eraseSource(audioController->_dirtySources, this);
+        eraseSource(audioController->_movingSources, this);
+    }
+
     if (_alSource)
     {
         AL_CHECK( alDeleteSources(1, &_alSource) );
@@ -30,7 +51,7 @@ AudioSource::~AudioSource()
     SAFE_RELEASE(_buffer);
 }
 
-AudioSource* AudioSource::create(const char* url)
+AudioSource* AudioSource::create(const char* url, bool streamed, bool compressed)
 {
     // Load from a .audio file.
     std::string pathStr = url;
@@ -49,7 +70,7 @@ AudioSource* AudioSource::create(const char* url)
     }
 
     // Create an audio buffer from this URL.
-    AudioBuffer* buffer = AudioBuffer::create(url);
+    AudioBuffer* buffer = AudioBuffer::create(url, streamed, compressed);
     if (buffer == NULL)
         return NULL;
 
@@ -85,7 +106,7 @@ AudioSource* AudioSource::create(Properties* properties)
     }
 
     // Create the audio source.
-    AudioSource* audio = AudioSource::create(path.c_str());
+    AudioSource* audio = AudioSource::create(path.c_str(), properties->getBool("streamed"), properties->getBool("compressed"));
     if (audio == NULL)
     {
         GP_ERROR("Audio file '%s' failed to load properly.", path.c_str());
@@ -105,6 +126,10 @@ AudioSource* AudioSource::create(Properties* properties)
     {
         audio->setPitch(properties->getFloat("pitch"));
     }
+    if (properties->exists("priority"))
+    {
+        audio->setPriority(properties->getFloat("priority"));
+    }
     Vector3 v;
     if (properties->getVector3("velocity", &v))
     {
@@ -116,6 +141,10 @@ AudioSource* AudioSource::create(Properties* properties)
 
 AudioSource::State AudioSource::getState() const
 {
+    // Virtual sources are paused but still playing as far as the game is concerned.
+    if (_virtual)
+        return PLAYING;
+
     ALint state;
     AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
 
@@ -135,6 +164,28 @@ AudioSource::State AudioSource::getState() const
 
 void AudioSource::play()
 {
+    // Playing a playing source starts it over; a virtual source does so where it cannot be heard.
+    if (_virtual)
+    {
+        _virtualOffset = 0.0f;
+        if (_buffer->isStreamed())
+            _buffer->resetStream(_alSource);
+        return;
+    }
+
+    // A stopped stream has played its queued buffers, so it starts over from the beginning.
+    // An idle compressed stream takes a decoder and starts from the beginning too.
+    GP_ASSERT(_buffer);
+    if (_buffer->isStreamed() && (getState() == STOPPED || _buffer->isStreamIdle()))
+        _buffer->resetStream(_alSource);
+
+    // A source whose node has moved since the last update is placed before it is heard.
+    if (_transformDirty && _node)
+    {
+        Vector3 position = _node->getTranslationWorld();
+        AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&position) );
+    }
+
     AL_CHECK( alSourcePlay(_alSource) );
 
     // Add the source to the controller's list of currently playing sources.
@@ -146,6 +197,14 @@ void AudioSource::play()
 
 void AudioSource::pause()
 {
+    // A virtual source is paused where it would be by now.
+    if (_virtual)
+    {
+        _virtual = false;
+        if (!seekVirtualOffset())
+            AL_CHECK( alSourceStop(_alSource) );
+    }
+
     AL_CHECK( alSourcePause(_alSource) );
 
     // Remove the source from the controller's set of currently playing sources
@@ -170,7 +229,11 @@ void AudioSource::resume()
 
 void AudioSource::stop()
 {
+    _virtual = false;
     AL_CHECK( alSourceStop(_alSource) );
+    GP_ASSERT(_buffer);
+    if (_buffer->isStreamed())
+        _buffer->stopStream(_alSource);
 
     // Remove the source from the controller's set of currently playing sources.
     AudioController* audioController = Game::getInstance()->getAudioController();
@@ -182,7 +245,12 @@ void AudioSource::stop()
 
 void AudioSource::rewind()
 {
-    AL_CHECK( alSourceRewind(_alSource) );
+    _virtual = false;
+    GP_ASSERT(_buffer);
+    if (!_buffer->isStreamed())
+        AL_CHECK( alSourceRewind(_alSource) );
+    else if (!_buffer->isStreamIdle())
+        _buffer->resetStream(_alSource);
 }
 
 bool AudioSource::isLooped() const
@@ -192,6 +260,15 @@ bool AudioSource::isLooped() const
 
 void AudioSource::setLooped(bool looped)
 {
+    // Looping a streamed source would repeat its queued buffers, so the stream loops itself instead.
+    GP_ASSERT(_buffer);
+    if (_buffer->isStreamed())
+    {
+        _buffer->setStreamLooped(looped);
+        _looped = looped;
+        return;
+    }
+
     AL_CHECK( alSourcei(_alSource, AL_LOOPING, (looped) ? AL_TRUE : AL_FALSE) );
     if (AL_LAST_ERROR())
     {
@@ -229,7 +306,8 @@ const Vector3& AudioSource::getVelocity() const
 
 void AudioSource::setVelocity(const Vector3& velocity)
 {
-    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&velocity) );
+    Vector3 sourceVelocity = velocity + _nodeVelocity;
+    AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (ALfloat*)&sourceVelocity) );
     _velocity = velocity;
 }
 
@@ -238,6 +316,16 @@ void AudioSource::setVelocity(float x, float y, float z)
     setVelocity(Vector3(x, y, z));
 }
 
+float AudioSource::getPriority() const
+{
+    return _priority;
+}
+
+void AudioSource::setPriority(float priority)
+{
+    _priority = priority;
+}
+
 Node* AudioSource::getNode() const
 {
     return _node;
@@ -258,40 +346,161 @@ void AudioSource::setNode(Node* node)
 
         if (_node)
         {
-            _node->addListener(this);
-            // Update the audio source position.
-            transformChanged(_node, 0);
+            _node->addListener(this, 0, false);
         }
+
+        // Update the audio source position.
+        _transformReset = true;
+        transformChanged(_node, 0);
     }
 }
 
 void AudioSource::transformChanged(Transform* transform, long cookie)
 {
+    // The node can move several times in a frame, the audio controller only reads it once per frame.
+    if (!_transformDirty)
+    {
+        Game* game = Game::getInstance();
+        AudioController* audioController = game ? game->getAudioController() : NULL;
+        if (audioController)
+        {
+            _transformDirty = true;
+            audioController->_dirtySources.push_back(this);
+        }
+    }
+}
+
+bool AudioSource::updateTransform(float elapsedTime)
+{
+    Vector3 nodeVelocity;
     if (_node)
     {
-        Vector3 translation = _node->getTranslationWorld();
-        AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&translation.x) );
+        Vector3 position = _node->getTranslationWorld();
+        if (!_transformReset && elapsedTime > 0.0f)
+        {
+            nodeVelocity = (position - _position) * (1000.0f / elapsedTime);
+        }
+        if (_transformReset || position != _position)
+        {
+            _position = position;
+            AL_CHECK( alSourcefv(_alSource, AL_POSITION, (const ALfloat*)&_position) );
+        }
+    }
+    _transformDirty = false;
+    _transformReset = false;
+
+    if (nodeVelocity != _nodeVelocity)
+    {
+        _nodeVelocity = nodeVelocity;
+        Vector3 velocity = _velocity + _nodeVelocity;
+        AL_CHECK( alSourcefv(_alSource, AL_VELOCITY, (const ALfloat*)&velocity) );
+    }
+    return !_nodeVelocity.isZero();
+}
+
+void AudioSource::updateStream()
+{
+    GP_ASSERT(_buffer);
+    if (_buffer->isStreamed())
+    {
+        _buffer->updateStream(_alSource);
+
+        // A compressed stream that finished playing returns its decoder.
+        if (getState() == STOPPED)
+            _buffer->stopStream(_alSource);
     }
 }
 
+float AudioSource::getAudibility(const Vector3& listenerPosition) const
+{
+    // Sources are attenuated by the inverse of their distance beyond a reference distance of 1.
+    return _gain / std::max(1.0f, _position.distance(listenerPosition));
+}
+
+void AudioSource::demote()
+{
+    GP_ASSERT(!_virtual);
+    AL_CHECK( alGetSourcef(_alSource, AL_SEC_OFFSET, &_virtualOffset) );
+    AL_CHECK( alSourcePause(_alSource) );
+    _virtual = true;
+}
+
+bool AudioSource::promote()
+{
+    GP_ASSERT(_virtual);
+    _virtual = false;
+    if (!seekVirtualOffset())
+    {
+        AL_CHECK( alSourceStop(_alSource) );
+        return false;
+    }
+    AL_CHECK( alSourcePlay(_alSource) );
+    return true;
+}
+
+bool AudioSource::updateVirtual(float elapsedTime)
+{
+    GP_ASSERT(_virtual);
+    _virtualOffset += elapsedTime * 0.001f * _pitch;
+    if (!_looped && !_buffer->isStreamed() && _virtualOffset >= _buffer->getDuration())
+    {
+        _virtual = false;
+        AL_CHECK( alSourceStop(_alSource) );
+        return false;
+    }
+    return true;
+}
+
+bool AudioSource::seekVirtualOffset()
+{
+    // Streams are not seekable by time and resume where they were paused.
+    GP_ASSERT(_buffer);
+    if (_buffer->isStreamed())
+        return true;
+
+    float duration = _buffer->getDuration();
+    if (_virtualOffset >= duration)
+    {
+        if (!_looped || duration <= 0.0f)
+            return false;
+        _virtualOffset = fmod(_virtualOffset, duration);
+    }
+    AL_CHECK( alSourcef(_alSource, AL_SEC_OFFSET, _virtualOffset) );
+    return true;
+}
+
 AudioSource* AudioSource::clone(NodeCloneContext &context) const
 {
     GP_ASSERT(_buffer);
 
+    // Every streamed source decodes the file on its own.
+    AudioBuffer* buffer = _buffer;
+    if (_buffer->isStreamed())
+    {
+        buffer = AudioBuffer::create(_buffer->_filePath.c_str(), true, _buffer->_clipBuffer != NULL);
+        if (buffer == NULL)
+            return NULL;
+    }
+    else
+    {
+        _buffer->addRef();
+    }
+
     ALuint alSource = 0;
     AL_CHECK( alGenSources(1, &alSource) );
     if (AL_LAST_ERROR())
     {
+        SAFE_RELEASE(buffer);
         GP_ERROR("Error generating audio source.");
         return NULL;
     }
-    AudioSource* audioClone = new AudioSource(_buffer, alSource);
+    AudioSource* audioClone = new AudioSource(buffer, alSource);
 
-    _buffer->addRef();
     audioClone->setLooped(isLooped());
     audioClone->setGain(getGain());
     audioClone->setPitch(getPitch());
     audioClone->setVelocity(getVelocity());
+    audioClone->setPriority(getPriority());
     if (Node* node = getNode())
     {
         Node* clonedNode = context.findClonedNode(node);
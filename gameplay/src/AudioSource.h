@@ -39,10 +39,17 @@ public:
      * "<file-path>.<extension>#<namespace-id>/<namespace-id>/.../<namespace-id>" and "#<namespace-id>/<namespace-id>/.../<namespace-id>" is optional).
      * 
      * @param url The relative location on disk of the sound file or a URL specifying a Properties object defining an audio source.
+     * @param streamed true to decode the sound file while it plays instead of loading it up front, which suits music
+     *      and other long clips. Only Ogg Vorbis files can be streamed. This is ignored when a Properties object is
+     *      specified, which sets it with its 'streamed' property instead.
+     * @param compressed true to keep the sound file compressed in memory, shared by every source playing it, and
+     *      decode it while it plays, which suits large libraries of sound effects. Ogg Vorbis and IMA ADPCM files
+     *      are kept as they are, PCM wave files are encoded to IMA ADPCM. This takes precedence over streamed, and
+     *      is ignored when a Properties object is specified, which sets it with its 'compressed' property instead.
      * @return The newly created audio source, or NULL if an audio source cannot be created.
      * @script{create}
      */
-    static AudioSource* create(const char* url);
+    static AudioSource* create(const char* url, bool streamed = false, bool compressed = false);
 
     /**
      * Create an audio source from the given properties object.
@@ -137,6 +144,9 @@ public:
     /**
      * Sets the velocity of the audio source.
      *
+     * While the source is attached to a node, the velocity the node moves with,
+     * measured once per frame, is added to this velocity.
+     *
      * @param velocity A vector representing the velocity.
      */
     void setVelocity(const Vector3& velocity);
@@ -150,6 +160,24 @@ public:
      */
     void setVelocity(float x, float y, float z);
 
+    /**
+     * Gets the priority of the audio source.
+     *
+     * @return The priority.
+     */
+    float getPriority() const;
+
+    /**
+     * Sets the priority of the audio source.
+     *
+     * When more sources play than the audio controller mixes at once, the sources with
+     * the highest priority times estimated audibility are mixed and the others are
+     * skipped until they rank high enough again. The default priority is 1.
+     *
+     * @param priority The priority of the source.
+     */
+    void setPriority(float priority);
+
     /**
      * Gets the node that this source is attached to.
      * 
@@ -184,6 +212,49 @@ private:
      */
     void transformChanged(Transform* transform, long cookie);
 
+    /**
+     * Passes the position of the node, and the velocity it moved with since the last frame, to OpenAL.
+     *
+     * @return true if the node moved since the last frame.
+     */
+    bool updateTransform(float elapsedTime);
+
+    /**
+     * Keeps the queue of a streamed source filled while it plays.
+     */
+    void updateStream();
+
+    /**
+     * Estimates the gain the source is heard with, using the default OpenAL distance model.
+     */
+    float getAudibility(const Vector3& listenerPosition) const;
+
+    /**
+     * Pauses the source while it keeps playing virtually.
+     */
+    void demote();
+
+    /**
+     * Plays a virtual source again from where it would be by now.
+     *
+     * @return false if the source finished playing while it was virtual.
+     */
+    bool promote();
+
+    /**
+     * Advances a virtual source.
+     *
+     * @return false if the source finished playing while it was virtual.
+     */
+    bool updateVirtual(float elapsedTime);
+
+    /**
+     * Moves a virtual source to where it would be by now, without playing it.
+     *
+     * @return false if the source finished playing while it was virtual.
+     */
+    bool seekVirtualOffset();
+
     /**
      * Clones the audio source and returns a new audio source.
      * 
@@ -200,6 +271,13 @@ private:
     float _pitch;
     Vector3 _velocity;
     Node* _node;
+    float _priority;
+    Vector3 _position;          // The position of the node as of the last update.
+    Vector3 _nodeVelocity;      // The velocity of the node over the last frame.
+    bool _transformDirty;       // The node has moved since the last update.
+    bool _transformReset;       // The node has just been set, so it has no velocity yet.
+    bool _virtual;
+    float _virtualOffset;       // The position in seconds that a virtual source would be playing.
 };
 
 }
@@ -74,6 +74,11 @@ extern void print(const char* format, ...);
 #define GP_ASSERT(expression)
 #endif
 
+// Lowest log level kept by the log macros (see Logger::Level).
+#ifndef GP_LOG_LEVEL
+#define GP_LOG_LEVEL 0
+#endif
+
 // Error macro.
 #ifdef GP_ERRORS_AS_WARNINGS
 #define GP_ERROR GP_WARN
@@ -89,12 +94,16 @@ extern void print(const char* format, ...);
 #endif
 
 // Warning macro.
+#if GP_LOG_LEVEL > 1
+#define GP_WARN(...) do { } while (0)
+#else
 #define GP_WARN(...) do \
     { \
         gameplay::Logger::log(gameplay::Logger::LEVEL_WARN, "%s -- ", __current__func__); \
         gameplay::Logger::log(gameplay::Logger::LEVEL_WARN, __VA_ARGS__); \
         gameplay::Logger::log(gameplay::Logger::LEVEL_WARN, "\n"); \
     } while (0)
+#endif
 
 // Bullet Physics
 #include <btBulletDynamicsCommon.h>
@@ -184,11 +193,47 @@ extern void print(const char* format, ...);
 // Scripting
 using std::va_list;
 #include <lua.hpp>
+#ifdef GP_LUAJIT
+    // The type of FFI cdata values, which the public LuaJIT headers do not declare.
+    #define LUA_TCDATA 10
+    // LuaJIT implements the Lua 5.1 API and part of 5.2; these cover the rest of what the engine and bindings use.
+    #include <luajit.h>
+    #ifndef LUA_OK
+    #define LUA_OK 0
+    #endif
+    #define luaL_checkunsigned(L, n) ((unsigned int)luaL_checknumber((L), (n)))
+    #define lua_pushunsigned(L, n) lua_pushnumber((L), (lua_Number)(n))
+    #define lua_len(L, index) lua_pushinteger((L), (lua_Integer)lua_objlen((L), (index)))
+    #define lua_resume(L, from, n) lua_resume((L), (n))
+    inline void lua_rawgetp(lua_State* L, int index, const void* p)
+    {
+        if (index < 0 && index > LUA_REGISTRYINDEX)
+            index += lua_gettop(L) + 1;
+        lua_pushlightuserdata(L, (void*)p);
+        lua_rawget(L, index);
+    }
+    inline void lua_rawsetp(lua_State* L, int index, const void* p)
+    {
+        if (index < 0 && index > LUA_REGISTRYINDEX)
+            index += lua_gettop(L) + 1;
+        lua_pushlightuserdata(L, (void*)p);
+        lua_insert(L, -2);
+        lua_rawset(L, index);
+    }
+#else
+    // Stock Lua has no cdata; the bindings' cdata checks test for a type no argument can have.
+    #define LUA_TCDATA LUA_TNONE
+#endif
 
 #define WINDOW_VSYNC        1
 
 // Graphics (OpenGL)
-#ifdef __QNX__
+#if defined(GP_HEADLESS)
+    // No window or GL context: the GL functions are the no-op backend of NullGraphics.cpp.
+    #include <GL/gl.h>
+    #include <GL/glext.h>
+    #include "NullGraphics.h"
+#elif __QNX__
     #include <EGL/egl.h>
     #include <GLES2/gl2.h>
     #include <GLES2/gl2ext.h>
@@ -197,10 +242,17 @@ using std::va_list;
     extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArrays;
     extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArrays;
     extern PFNGLISVERTEXARRAYOESPROC glIsVertexArray;
+    extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary;
+    extern PFNGLPROGRAMBINARYOESPROC glProgramBinary;
+    extern PFNGLDISCARDFRAMEBUFFEREXTPROC glInvalidateFramebuffer;
+    #define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+    #define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
     #define GL_DEPTH24_STENCIL8 GL_DEPTH24_STENCIL8_OES
     #define glClearDepth glClearDepthf
     #define OPENGL_ES
     #define USE_PVRTC
+    #define USE_PROGRAM_BINARY
+    #define USE_INVALIDATE_FRAMEBUFFER
     #ifdef __arm__
         #define USE_NEON
     #endif
@@ -212,18 +264,72 @@ using std::va_list;
     extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArrays;
     extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArrays;
     extern PFNGLISVERTEXARRAYOESPROC glIsVertexArray;
+    extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary;
+    extern PFNGLPROGRAMBINARYOESPROC glProgramBinary;
+    #define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+    #define GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+    extern PFNGLGENQUERIESEXTPROC glGenQueries;
+    extern PFNGLDELETEQUERIESEXTPROC glDeleteQueries;
+    extern PFNGLQUERYCOUNTEREXTPROC glQueryCounter;
+    extern PFNGLGETQUERYOBJECTIVEXTPROC glGetQueryObjectiv;
+    extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v;
+    extern PFNGLBEGINQUERYEXTPROC glBeginQuery;
+    extern PFNGLENDQUERYEXTPROC glEndQuery;
+    extern PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuiv;
+    extern PFNGLDISCARDFRAMEBUFFEREXTPROC glInvalidateFramebuffer;
+    extern PFNGLPUSHDEBUGGROUPKHRPROC glPushDebugGroup;
+    extern PFNGLPOPDEBUGGROUPKHRPROC glPopDebugGroup;
+    extern PFNGLOBJECTLABELKHRPROC glObjectLabel;
+    #define GLuint64 GLuint64EXT
+    #define GL_TIMESTAMP GL_TIMESTAMP_EXT
+    #define GL_QUERY_RESULT GL_QUERY_RESULT_EXT
+    #define GL_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE_EXT
+    #define GL_GPU_DISJOINT GL_GPU_DISJOINT_EXT
+    #define GL_ANY_SAMPLES_PASSED GL_ANY_SAMPLES_PASSED_EXT
+    #define GL_DEBUG_SOURCE_APPLICATION GL_DEBUG_SOURCE_APPLICATION_KHR
+    #define GL_BUFFER GL_BUFFER_KHR
+    #define GL_PROGRAM GL_PROGRAM_KHR
     #define GL_DEPTH24_STENCIL8 GL_DEPTH24_STENCIL8_OES
     #define glClearDepth glClearDepthf
     #define OPENGL_ES
+    #define USE_PROGRAM_BINARY
+    #define USE_TIMER_QUERIES
+    #define USE_OCCLUSION_QUERIES
+    #define USE_INVALIDATE_FRAMEBUFFER
+    #define USE_DEBUG_MARKERS
 #elif WIN32
     #define WIN32_LEAN_AND_MEAN
     #define GLEW_STATIC
     #include <GL/glew.h>
     #define USE_VAO
+    #define USE_INSTANCED_ARRAYS
+    #define USE_UNIFORM_BUFFERS
+    #define USE_PROGRAM_BINARY
+    #define USE_TIMER_QUERIES
+    #define USE_OCCLUSION_QUERIES
+    #define USE_TRANSFORM_FEEDBACK
+    #define USE_TEXTURE_ARRAYS
+    #define USE_MAPPED_BUFFERS
+    #define USE_FENCE_SYNC
+    #define USE_SAMPLER_OBJECTS
+    #define USE_INVALIDATE_FRAMEBUFFER
+    #define USE_DEBUG_MARKERS
 #elif __linux__
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define USE_VAO
+        #define USE_INSTANCED_ARRAYS
+        #define USE_UNIFORM_BUFFERS
+        #define USE_PROGRAM_BINARY
+        #define USE_TIMER_QUERIES
+        #define USE_OCCLUSION_QUERIES
+        #define USE_TRANSFORM_FEEDBACK
+        #define USE_TEXTURE_ARRAYS
+        #define USE_MAPPED_BUFFERS
+        #define USE_FENCE_SYNC
+        #define USE_SAMPLER_OBJECTS
+        #define USE_INVALIDATE_FRAMEBUFFER
+        #define USE_DEBUG_MARKERS
 #elif __APPLE__
     #include "TargetConditionals.h"
     #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
@@ -233,10 +339,12 @@ using std::va_list;
         #define glDeleteVertexArrays glDeleteVertexArraysOES
         #define glGenVertexArrays glGenVertexArraysOES
         #define glIsVertexArray glIsVertexArrayOES
+        #define glInvalidateFramebuffer glDiscardFramebufferEXT
         #define GL_DEPTH24_STENCIL8 GL_DEPTH24_STENCIL8_OES
         #define glClearDepth glClearDepthf
         #define OPENGL_ES
         #define USE_VAO
+        #define USE_INVALIDATE_FRAMEBUFFER
         #ifdef __arm__
             #define USE_NEON
         #endif
@@ -247,12 +355,24 @@ using std::va_list;
         #define glDeleteVertexArrays glDeleteVertexArraysAPPLE
         #define glGenVertexArrays glGenVertexArraysAPPLE
         #define glIsVertexArray glIsVertexArrayAPPLE
+        #define glDrawArraysInstanced glDrawArraysInstancedARB
+        #define glDrawElementsInstanced glDrawElementsInstancedARB
+        #define glVertexAttribDivisor glVertexAttribDivisorARB
         #define USE_VAO
+        #define USE_INSTANCED_ARRAYS
     #else
         #error "Unsupported Apple Device"
     #endif
 #endif
 
+// Math (SIMD)
+// Define GP_NO_SIMD to use the portable math code on x86 targets.
+#if !defined(USE_NEON) && !defined(GP_NO_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define USE_SSE
+    #endif
+#endif
+
 // Graphics (GLSL)
 #define VERTEX_ATTRIBUTE_POSITION_NAME              "a_position"
 #define VERTEX_ATTRIBUTE_NORMAL_NAME                "a_normal"
@@ -262,6 +382,10 @@ using std::va_list;
 #define VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME          "a_blendWeights"
 #define VERTEX_ATTRIBUTE_BLENDINDICES_NAME          "a_blendIndices"
 #define VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME       "a_texCoord"
+#define VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME       "a_instanceMatrix"
+#define VERTEX_ATTRIBUTE_INSTANCE_DATA_NAME         "a_instanceData"
+#define INSTANCE_UNIFORM_MATRIX_NAME                "u_instanceMatrix"
+#define INSTANCE_UNIFORM_DATA_NAME                  "u_instanceData"
 
 // Hardware buffer
 namespace gameplay
@@ -0,0 +1,357 @@
+#include "Base.h"
+#include "Benchmark.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "LoadProfiler.h"
+#include "RenderStats.h"
+#include "Scene.h"
+
+namespace gameplay
+{
+
+Benchmark::Benchmark()
+    : _running(false), _frames(1200), _warmup(60), _timestep(1000.0f / 60.0f), _output("benchmark.json"),
+      _orbit(false), _orbitPeriod(20000.0f), _orbitElevation(30.0f), _orbitDistance(2.0f), _loadRuns(1), _loadOutput("loads.json"),
+      _frameIndex(0), _lastFrameTime(0.0), _startTime(0.0), _radius(0.0f),
+      _drawCalls(0.0), _triangles(0.0), _effectBinds(0.0), _textureBinds(0.0), _redundantStateChanges(0.0), _uploadSize(0.0), _peakTextureMemory(0)
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::initialize(Properties* properties)
+{
+    if (properties)
+    {
+        readSettings(properties);
+        _running = properties->getBool("enabled");
+    }
+
+    // "--benchmark [path]" enables the benchmark; the settings in the file override the config.
+    int argc = 0;
+    char** argv = NULL;
+    Game::getInstance()->getArguments(&argc, &argv);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--benchmark") != 0)
+            continue;
+
+        _running = true;
+        if (i + 1 < argc && argv[i + 1][0] != '-')
+        {
+            Properties* settings = Properties::create(argv[i + 1]);
+            if (settings)
+            {
+                Properties* benchmark = strcmp(settings->getNamespace(), "benchmark") == 0 ? settings : settings->getNamespace("benchmark", true);
+                if (benchmark)
+                {
+                    readSettings(benchmark);
+                }
+                SAFE_DELETE(settings);
+            }
+            else
+            {
+                GP_WARN("Failed to load benchmark settings '%s'.", argv[i + 1]);
+            }
+        }
+        break;
+    }
+
+    if (_running)
+    {
+        _frameTimes.reserve(_frames);
+        GP_WARN("Running benchmark: %u frames after %u warm-up frames, %.3f ms timestep.", _frames, _warmup, _timestep);
+    }
+}
+
+void Benchmark::readSettings(Properties* properties)
+{
+    GP_ASSERT(properties);
+
+    if (properties->exists("frames"))
+        _frames = (unsigned int)std::max(1, properties->getInt("frames"));
+    if (properties->exists("warmup"))
+        _warmup = (unsigned int)std::max(0, properties->getInt("warmup"));
+    if (properties->exists("timestep"))
+        _timestep = properties->getFloat("timestep");
+    if (properties->exists("output"))
+        _output = properties->getString("output");
+    if (properties->exists("orbit"))
+        _orbit = properties->getBool("orbit");
+    if (properties->exists("orbitPeriod"))
+        _orbitPeriod = properties->getFloat("orbitPeriod");
+    if (properties->exists("orbitElevation"))
+        _orbitElevation = properties->getFloat("orbitElevation");
+    if (properties->exists("orbitDistance"))
+        _orbitDistance = properties->getFloat("orbitDistance");
+    if (properties->exists("loadScene"))
+        _loadScene = properties->getString("loadScene");
+    if (properties->exists("loadRuns"))
+        _loadRuns = (unsigned int)std::max(0, properties->getInt("loadRuns"));
+    if (properties->exists("loadOutput"))
+        _loadOutput = properties->getString("loadOutput");
+}
+
+bool Benchmark::isRunning() const
+{
+    return _running;
+}
+
+float Benchmark::getTimestep() const
+{
+    return _timestep;
+}
+
+unsigned int Benchmark::getRecordedFrameCount() const
+{
+    return (unsigned int)_frameTimes.size();
+}
+
+void Benchmark::runLoads()
+{
+    if (!_running || _loadScene.empty())
+        return;
+
+    FILE* file = FileSystem::openFile(_loadOutput.c_str(), "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create load benchmark file '%s'.", _loadOutput.c_str());
+        return;
+    }
+
+    bool enabled = LoadProfiler::isEnabled();
+    LoadProfiler::setEnabled(true);
+
+    // The first run is cold, the others reload the scene once it is released.
+    fputs("{\n\"scene\":", file);
+    fprintf(file, "\"%s\",\n\"runs\":[", _loadScene.c_str());
+    for (unsigned int run = 0; run <= _loadRuns; ++run)
+    {
+        LoadProfiler::clear();
+        double start = Game::getAbsoluteTime();
+        Scene* scene = Scene::load(_loadScene.c_str());
+        double time = Game::getAbsoluteTime() - start;
+        if (scene == NULL)
+        {
+            GP_WARN("Failed to load benchmark scene '%s'.", _loadScene.c_str());
+            break;
+        }
+        SAFE_RELEASE(scene);
+
+        print("[load] %s load of '%s': %.2f ms\n", run == 0 ? "Cold" : "Warm", _loadScene.c_str(), time);
+        if (run == 0)
+            LoadProfiler::print();
+        fprintf(file, "%s\n{\"cold\":%s,\"wallTime\":%.3f,\"report\":", run == 0 ? "" : ",", run == 0 ? "true" : "false", time);
+        LoadProfiler::writeReport(file);
+        fputc('}', file);
+    }
+    fputs("\n]}\n", file);
+
+    LoadProfiler::clear();
+    LoadProfiler::setEnabled(enabled);
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write load benchmark file '%s'.", _loadOutput.c_str());
+    }
+}
+
+void Benchmark::beginFrame()
+{
+    if (!_running)
+        return;
+
+    // The time of a frame runs from the start of one Game::frame to the next, so it includes the buffer swap.
+    double now = Game::getAbsoluteTime();
+    if (_frameIndex > _warmup)
+    {
+        recordFrame(now - _lastFrameTime);
+    }
+    else if (_frameIndex == _warmup)
+    {
+        _startTime = now;
+    }
+    _lastFrameTime = now;
+    ++_frameIndex;
+
+    if (_frameTimes.size() >= _frames)
+    {
+        _running = false;
+        writeResults();
+        Game::getInstance()->exit();
+    }
+}
+
+void Benchmark::recordFrame(double frameTime)
+{
+    _frameTimes.push_back(frameTime);
+
+    // The render statistics were rolled over at the start of this frame and hold the recorded frame.
+    _drawCalls += RenderStats::getDrawCalls();
+    _triangles += RenderStats::getTriangleCount();
+    _effectBinds += RenderStats::getEffectBinds();
+    _textureBinds += RenderStats::getTextureBinds();
+    _redundantStateChanges += RenderStats::getRedundantStateChanges();
+    _uploadSize += RenderStats::getUploadSize();
+
+    TextureStreamer* streamer = Game::getInstance()->getTextureStreamer();
+    if (streamer)
+    {
+        _peakTextureMemory = std::max(_peakTextureMemory, streamer->getMemoryUsage());
+    }
+
+    Profiler* profiler = Game::getInstance()->getProfiler();
+    const Profiler::Frame* frame = profiler ? profiler->getFrame(0) : NULL;
+    if (frame)
+    {
+        for (size_t i = 0, count = frame->cpuSamples.size(); i < count; ++i)
+        {
+            const Profiler::Sample& sample = frame->cpuSamples[i];
+            std::map<std::string, Scope>::iterator itr = _scopes.find(sample.name);
+            if (itr == _scopes.end())
+            {
+                Scope scope = { 0.0, 0.0 };
+                itr = _scopes.insert(std::make_pair(std::string(sample.name), scope)).first;
+            }
+            itr->second.total += sample.duration;
+            itr->second.max = std::max(itr->second.max, sample.duration);
+        }
+    }
+}
+
+void Benchmark::computeSceneBounds(Scene* scene)
+{
+    BoundingSphere bounds;
+    for (Node* node = scene->getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        if (node->getCamera() == NULL)
+        {
+            const BoundingSphere& sphere = node->getBoundingSphere();
+            if (sphere.radius > 0.0f)
+            {
+                if (bounds.radius > 0.0f)
+                    bounds.merge(sphere);
+                else
+                    bounds.set(sphere.center, sphere.radius);
+            }
+        }
+    }
+    _center = bounds.center;
+    _radius = bounds.radius > 0.0f ? bounds.radius : 10.0f;
+}
+
+void Benchmark::updateCamera()
+{
+    if (!_running || !_orbit)
+        return;
+
+    Scene* scene = Scene::getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    Node* node = camera ? camera->getNode() : NULL;
+    if (node == NULL)
+        return;
+
+    // The bounds are taken once the game had the warm-up frames to build its scene.
+    if (_radius == 0.0f || _frameIndex <= _warmup)
+    {
+        computeSceneBounds(scene);
+    }
+
+    float time = (float)_frameIndex * _timestep;
+    float angle = MATH_PIX2 * fmodf(time, _orbitPeriod) / _orbitPeriod;
+    float elevation = MATH_DEG_TO_RAD(_orbitElevation);
+    float distance = _radius * _orbitDistance;
+    Vector3 eye(_center.x + cos(angle) * cos(elevation) * distance,
+                _center.y + sin(elevation) * distance,
+                _center.z + sin(angle) * cos(elevation) * distance);
+
+    // Place the camera node so that its world transform is the inverse of the look-at view.
+    Matrix world;
+    Matrix::createLookAt(eye, _center, Vector3::unitY(), &world);
+    world.invert();
+    Node* parent = node->getParent();
+    if (parent)
+    {
+        Matrix parentInverse;
+        parent->getWorldMatrix().invert(&parentInverse);
+        Matrix::multiply(parentInverse, world, &world);
+    }
+
+    Vector3 scale;
+    Quaternion rotation;
+    Vector3 translation;
+    world.decompose(&scale, &rotation, &translation);
+    node->setRotation(rotation);
+    node->setTranslation(translation);
+}
+
+bool Benchmark::writeResults() const
+{
+    FILE* file = FileSystem::openFile(_output.c_str(), "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create benchmark results file '%s'.", _output.c_str());
+        return false;
+    }
+
+    std::vector<double> sorted(_frameTimes);
+    std::sort(sorted.begin(), sorted.end());
+    size_t count = sorted.size();
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += sorted[i];
+    }
+
+    // Nearest-rank percentiles.
+    const double percentiles[] = { 50.0, 90.0, 95.0, 99.0 };
+    double elapsed = Game::getAbsoluteTime() - _startTime;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"frames\": %u,\n", (unsigned int)count);
+    fprintf(file, "  \"timestep\": %.4f,\n", _timestep);
+    fprintf(file, "  \"elapsed\": %.3f,\n", elapsed);
+    fprintf(file, "  \"frameTime\": {\n");
+    fprintf(file, "    \"avg\": %.4f,\n", total / count);
+    fprintf(file, "    \"min\": %.4f,\n", sorted[0]);
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i)
+    {
+        size_t rank = (size_t)ceil(percentiles[i] / 100.0 * count);
+        fprintf(file, "    \"p%d\": %.4f,\n", (int)percentiles[i], sorted[std::max(rank, (size_t)1) - 1]);
+    }
+    fprintf(file, "    \"max\": %.4f\n", sorted[count - 1]);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"render\": {\n");
+    fprintf(file, "    \"drawCalls\": %.2f,\n", _drawCalls / count);
+    fprintf(file, "    \"triangles\": %.2f,\n", _triangles / count);
+    fprintf(file, "    \"effectBinds\": %.2f,\n", _effectBinds / count);
+    fprintf(file, "    \"textureBinds\": %.2f,\n", _textureBinds / count);
+    fprintf(file, "    \"redundantStateChanges\": %.2f,\n", _redundantStateChanges / count);
+    fprintf(file, "    \"uploadSize\": %.2f\n", _uploadSize / count);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"memory\": {\n");
+    fprintf(file, "    \"peakTextureMemory\": %u\n", _peakTextureMemory);
+    fprintf(file, "  },\n");
+    fprintf(file, "  \"scopes\": {");
+    for (std::map<std::string, Scope>::const_iterator itr = _scopes.begin(); itr != _scopes.end(); ++itr)
+    {
+        fprintf(file, "%s\n    \"%s\": { \"avg\": %.4f, \"max\": %.4f }", itr == _scopes.begin() ? "" : ",",
+            itr->first.c_str(), itr->second.total / count, itr->second.max);
+    }
+    fprintf(file, "\n  }\n");
+    fprintf(file, "}\n");
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write benchmark results file '%s'.", _output.c_str());
+    }
+    return result;
+}
+
+}
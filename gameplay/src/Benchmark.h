@@ -0,0 +1,168 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "Properties.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+class Scene;
+
+/**
+ * Defines a benchmark mode that runs the game for a fixed number of frames and reports timings.
+ *
+ * While the benchmark runs, the game is advanced with a fixed timestep instead of
+ * the real elapsed time, so animations, physics and scripts play out the same way
+ * on every run. The active camera of the first scene can be moved along a fixed
+ * orbit around the scene, overriding any camera control done by the game.
+ *
+ * After the warm-up frames, the benchmark records the time of every frame. It also
+ * records the render statistics, texture memory and (when the profiler is enabled)
+ * the CPU scopes of each frame. When all frames are recorded, it writes the results
+ * as JSON and exits the game.
+ *
+ * When a scene is named with 'loadScene', the benchmark also times its loading during
+ * startup, before the game loads anything itself: once cold, as the first load of the
+ * process, and then warm, after the first scene is released, so that the engine caches
+ * are empty again but the files are in the cache of the operating system. Each load is
+ * recorded with the LoadProfiler, and the report of every run, with the assets sorted by
+ * load time, is written to 'loadOutput'. The records of the load profiler are cleared.
+ *
+ * The benchmark is enabled by the 'benchmark' namespace of the game config, or by
+ * starting the game with the "--benchmark" argument, optionally followed by the
+ * path of a file holding the 'benchmark' namespace:
+ *
+ * @verbatim
+    benchmark
+    {
+        enabled = true
+        frames = 1200           // Number of recorded frames.
+        warmup = 60             // Number of frames run before recording starts.
+        timestep = 16.666667    // Fixed elapsed time of each frame in milliseconds.
+        output = benchmark.json
+        orbit = true            // Move the active camera around the scene.
+        orbitPeriod = 20000     // Time of a full orbit in milliseconds of game time.
+        orbitElevation = 30     // Angle above the horizon in degrees.
+        orbitDistance = 2       // Distance from the scene center in scene radii.
+        loadScene = res/game.scene  // Scene whose loading is timed, if any.
+        loadRuns = 3            // Number of warm loads after the cold one.
+        loadOutput = loads.json
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class Benchmark
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Determines if the benchmark is driving the game.
+     *
+     * @return True while the benchmark runs.
+     */
+    bool isRunning() const;
+
+    /**
+     * Gets the fixed elapsed time applied to each frame while the benchmark runs.
+     *
+     * @return The timestep in milliseconds.
+     */
+    float getTimestep() const;
+
+    /**
+     * Gets the number of frames recorded so far.
+     *
+     * @return The number of recorded frames.
+     */
+    unsigned int getRecordedFrameCount() const;
+
+private:
+
+    struct Scope
+    {
+        double total;
+        double max;
+    };
+
+    /**
+     * Constructor.
+     */
+    Benchmark();
+
+    /**
+     * Destructor.
+     */
+    ~Benchmark();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Benchmark(const Benchmark& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Benchmark& operator=(const Benchmark&);
+
+    /**
+     * Called during startup to read the benchmark settings from the config and the command line.
+     *
+     * @param properties The 'benchmark' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called at the end of the startup to time the loads of the benchmark scene.
+     */
+    void runLoads();
+
+    /**
+     * Called at the start of each frame to record the previous frame.
+     */
+    void beginFrame();
+
+    /**
+     * Called before the game renders to move the camera along the orbit.
+     */
+    void updateCamera();
+
+    void readSettings(Properties* properties);
+    void computeSceneBounds(Scene* scene);
+    void recordFrame(double frameTime);
+    bool writeResults() const;
+
+    bool _running;
+    unsigned int _frames;
+    unsigned int _warmup;
+    float _timestep;
+    std::string _output;
+    bool _orbit;
+    float _orbitPeriod;
+    float _orbitElevation;
+    float _orbitDistance;
+    std::string _loadScene;
+    unsigned int _loadRuns;
+    std::string _loadOutput;
+    unsigned int _frameIndex;
+    double _lastFrameTime;
+    double _startTime;
+    Vector3 _center;
+    float _radius;
+    std::vector<double> _frameTimes;
+    double _drawCalls;
+    double _triangles;
+    double _effectBinds;
+    double _textureBinds;
+    double _redundantStateChanges;
+    double _uploadSize;
+    unsigned int _peakTextureMemory;
+    std::map<std::string, Scope> _scopes;
+};
+
+}
+
+#endif
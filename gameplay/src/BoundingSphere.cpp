@@ -151,6 +151,56 @@ float BoundingSphere::intersects(const Ray& ray) const
     }
 }
 
+unsigned int BoundingSphere::intersects(const BoundingSphere* spheres, unsigned int count, unsigned int* visibility) const
+{
+    GP_ASSERT(count == 0 || (spheres && visibility));
+
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(unsigned int));
+
+    // Compare squared distances to avoid a square root per sphere.
+    unsigned int visibleCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float vx = spheres[i].center.x - center.x;
+        float vy = spheres[i].center.y - center.y;
+        float vz = spheres[i].center.z - center.z;
+        float r = radius + spheres[i].radius;
+        if (r >= 0.0f && vx * vx + vy * vy + vz * vz <= r * r)
+        {
+            visibility[i >> 5] |= 1u << (i & 31);
+            ++visibleCount;
+        }
+    }
+    return visibleCount;
+}
+
+unsigned int BoundingSphere::intersects(const BoundingBox* boxes, unsigned int count, unsigned int* visibility) const
+{
+    GP_ASSERT(count == 0 || (boxes && visibility));
+
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(unsigned int));
+    if (radius < 0.0f)
+        return 0;
+
+    // The distance to the closest point of each box is compared with the radius, squared.
+    unsigned int visibleCount = 0;
+    const float radiusSquared = radius * radius;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const Vector3& boxMin = boxes[i].min;
+        const Vector3& boxMax = boxes[i].max;
+        float dx = center.x < boxMin.x ? boxMin.x - center.x : (center.x > boxMax.x ? boxMax.x - center.x : 0.0f);
+        float dy = center.y < boxMin.y ? boxMin.y - center.y : (center.y > boxMax.y ? boxMax.y - center.y : 0.0f);
+        float dz = center.z < boxMin.z ? boxMin.z - center.z : (center.z > boxMax.z ? boxMax.z - center.z : 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+        {
+            visibility[i >> 5] |= 1u << (i & 31);
+            ++visibleCount;
+        }
+    }
+    return visibleCount;
+}
+
 bool BoundingSphere::isEmpty() const
 {
     return radius == 0.0f;
@@ -101,6 +101,32 @@ public:
      */
     float intersects(const Ray& ray) const;
 
+    /**
+     * Tests which of the specified bounding spheres intersect this bounding sphere.
+     *
+     * @param spheres The bounding spheres to test intersection with.
+     * @param count The number of bounding spheres.
+     * @param visibility An array of (count + 31) / 32 words that receives the result: bit (i % 32)
+     *  of word (i / 32) is set if the i-th bounding sphere intersects this bounding sphere.
+     *
+     * @return The number of bounding spheres that intersect this bounding sphere.
+     * @script{ignore}
+     */
+    unsigned int intersects(const BoundingSphere* spheres, unsigned int count, unsigned int* visibility) const;
+
+    /**
+     * Tests which of the specified bounding boxes intersect this bounding sphere.
+     *
+     * @param boxes The bounding boxes to test intersection with.
+     * @param count The number of bounding boxes.
+     * @param visibility An array of (count + 31) / 32 words that receives the result: bit (i % 32)
+     *  of word (i / 32) is set if the i-th bounding box intersects this bounding sphere.
+     *
+     * @return The number of bounding boxes that intersect this bounding sphere.
+     * @script{ignore}
+     */
+    unsigned int intersects(const BoundingBox* boxes, unsigned int count, unsigned int* visibility) const;
+
     /**
      * Determines if this bounding sphere is empty.
      *
@@ -1,12 +1,21 @@
 #include "Base.h"
 #include "Bundle.h"
 #include "FileSystem.h"
+#include "LoadProfiler.h"
+#include "DebugMarkers.h"
 #include "MeshPart.h"
 #include "Scene.h"
+#include "Profiler.h"
 #include "Joint.h"
+#include "VertexAttributeBinding.h"
+#include "VertexAnimation.h"
+#include "NavigationMesh.h"
+#include "StringTable.h"
+#include <zlib.h>
 
 #define BUNDLE_VERSION_MAJOR            1
-#define BUNDLE_VERSION_MINOR            2
+#define BUNDLE_VERSION_MINOR            8
+#define BUNDLE_VERSION_MINOR_MIN        2
 
 #define BUNDLE_TYPE_SCENE               1
 #define BUNDLE_TYPE_NODE                2
@@ -21,8 +30,16 @@
 #define BUNDLE_TYPE_MESH                34
 #define BUNDLE_TYPE_MESHPART            35
 #define BUNDLE_TYPE_MESHSKIN            36
+#define BUNDLE_TYPE_MESHBVH             37
+#define BUNDLE_TYPE_MESHLOD             38
+#define BUNDLE_TYPE_VERTEXANIMATION     39
+#define BUNDLE_TYPE_NAVIGATIONMESH      40
 #define BUNDLE_TYPE_FONT                128
 
+// Animation channel encodings
+#define BUNDLE_ENCODING_FLOAT           0
+#define BUNDLE_ENCODING_QUANTIZED       1
+
 // For sanity checking string reads
 #define BUNDLE_MAX_STRING_LENGTH        5000
 
@@ -30,10 +47,101 @@ namespace gameplay
 {
 
 static std::vector<Bundle*> __bundleCache;
+static std::vector<Bundle::AsyncLoad*> __asyncLoads;
+static float __asyncLoadTimeBudget = 4.0f;
+
+/**
+ * A read-only stream over a bundle file held in memory by asynchronous loads.
+ */
+class MemoryStream : public Stream
+{
+public:
+
+    MemoryStream(unsigned char* data, size_t length)
+        : _data(data), _length(length), _position(0)
+    {
+    }
+
+    ~MemoryStream()
+    {
+        close();
+    }
+
+    virtual bool canRead() { return _data != NULL; }
+    virtual bool canWrite() { return false; }
+    virtual bool canSeek() { return true; }
+
+    virtual void close()
+    {
+        SAFE_DELETE_ARRAY(_data);
+        _length = _position = 0;
+    }
+
+    virtual size_t read(void* ptr, size_t size, size_t count)
+    {
+        if (size == 0)
+            return 0;
+        size_t available = (_length - _position) / size;
+        if (count > available)
+            count = available;
+        memcpy(ptr, _data + _position, size * count);
+        _position += size * count;
+        return count;
+    }
+
+    virtual char* readLine(char* str, int num)
+    {
+        if (num <= 0 || _position >= _length)
+            return NULL;
+        int i = 0;
+        while (i < num - 1 && _position < _length)
+        {
+            char c = (char)_data[_position++];
+            str[i++] = c;
+            if (c == '\n')
+                break;
+        }
+        str[i] = '\0';
+        return str;
+    }
+
+    virtual size_t write(const void* ptr, size_t size, size_t count) { return 0; }
+    virtual bool eof() { return _position >= _length; }
+    virtual size_t length() { return _length; }
+    virtual long int position() { return (long int)_position; }
+
+    virtual bool seek(long int offset, int origin)
+    {
+        long int base = origin == SEEK_CUR ? (long int)_position : (origin == SEEK_END ? (long int)_length : 0);
+        if (base + offset < 0 || (size_t)(base + offset) > _length)
+            return false;
+        _position = (size_t)(base + offset);
+        return true;
+    }
+
+    virtual bool rewind()
+    {
+        _position = 0;
+        return true;
+    }
+
+    virtual const unsigned char* getData()
+    {
+        return _data;
+    }
+
+private:
+
+    unsigned char* _data;
+    size_t _length;
+    size_t _position;
+};
 
 Bundle::Bundle(const char* path) :
-    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL)
+    _path(path), _referenceCount(0), _references(NULL), _referenceTableOffset(0), _stream(NULL), _inMemory(false), _trackedNodes(NULL)
 {
+    _version[0] = BUNDLE_VERSION_MAJOR;
+    _version[1] = BUNDLE_VERSION_MINOR;
 }
 
 Bundle::~Bundle()
@@ -49,6 +157,11 @@ Bundle::~Bundle()
 
     SAFE_DELETE_ARRAY(_references);
 
+    for (std::map<std::string, Mesh*>::iterator itr = _preparedMeshes.begin(); itr != _preparedMeshes.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+
     if (_stream)
     {
         SAFE_DELETE(_stream);
@@ -127,6 +240,14 @@ bool Bundle::readArray(unsigned int* length, std::vector<T>* values, unsigned in
     return true;
 }
 
+// Multiplicative hash of a reference offset. The index is masked to its low bits, which
+// only depend on the low bits of the offset, so the high bits are folded into them.
+static unsigned int hashReferenceOffset(unsigned int offset)
+{
+    unsigned int hash = offset * 2654435761u;
+    return hash ^ (hash >> 16);
+}
+
 static std::string readString(Stream* stream)
 {
     GP_ASSERT(stream);
@@ -172,6 +293,7 @@ Bundle* Bundle::create(const char* path)
     }
 
     // Open the bundle.
+    LoadProfiler::Scope profile("bundle", path);
     Stream* stream = FileSystem::open(path);
     if (!stream)
     {
@@ -179,38 +301,68 @@ Bundle* Bundle::create(const char* path)
         return NULL;
     }
 
+    unsigned int refCount;
+    unsigned char version[2];
+    if (!readHeader(stream, path, version, &refCount))
+    {
+        SAFE_DELETE(stream);
+        return NULL;
+    }
+
+    // Keep file open for faster reading later. The reference table is read on first use.
+    Bundle* bundle = new Bundle(path);
+    bundle->_version[0] = version[0];
+    bundle->_version[1] = version[1];
+    bundle->_referenceCount = refCount;
+    bundle->_referenceTableOffset = stream->position();
+    bundle->_stream = stream;
+
+    return bundle;
+}
+
+bool Bundle::readHeader(Stream* stream, const char* path, unsigned char* version, unsigned int* referenceCount)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(version);
+    GP_ASSERT(referenceCount);
+
     // Read the GPB header info.
     char sig[9];
     if (stream->read(sig, 1, 9) != 9 || memcmp(sig, "\xABGPB\xBB\r\n\x1A\n", 9) != 0)
     {
-        SAFE_DELETE(stream);
         GP_ERROR("Invalid GPB header for bundle '%s'.", path);
-        return NULL;
+        return false;
     }
 
     // Read version.
     unsigned char ver[2];
     if (stream->read(ver, 1, 2) != 2)
     {
-        SAFE_DELETE(stream);
         GP_ERROR("Failed to read GPB version for bundle '%s'.", path);
-        return NULL;
+        return false;
     }
-    if (ver[0] != BUNDLE_VERSION_MAJOR || ver[1] != BUNDLE_VERSION_MINOR)
+    if (ver[0] != BUNDLE_VERSION_MAJOR || ver[1] < BUNDLE_VERSION_MINOR_MIN || ver[1] > BUNDLE_VERSION_MINOR)
     {
-        SAFE_DELETE(stream);
-        GP_ERROR("Unsupported version (%d.%d) for bundle '%s' (expected %d.%d).", (int)ver[0], (int)ver[1], path, BUNDLE_VERSION_MAJOR, BUNDLE_VERSION_MINOR);
-        return NULL;
+        GP_ERROR("Unsupported version (%d.%d) for bundle '%s' (expected %d.%d to %d.%d).", (int)ver[0], (int)ver[1], path,
+            BUNDLE_VERSION_MAJOR, BUNDLE_VERSION_MINOR_MIN, BUNDLE_VERSION_MAJOR, BUNDLE_VERSION_MINOR);
+        return false;
     }
+    version[0] = ver[0];
+    version[1] = ver[1];
 
-    // Read ref table.
-    unsigned int refCount;
-    if (stream->read(&refCount, 4, 1) != 1)
+    // Read ref table size.
+    if (stream->read(referenceCount, 4, 1) != 1)
     {
-        SAFE_DELETE(stream);
         GP_ERROR("Failed to read ref table for bundle '%s'.", path);
-        return NULL;
+        return false;
     }
+    return true;
+}
+
+bool Bundle::readReferences(Stream* stream, const char* path, unsigned int refCount, Reference** references)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(references);
 
     // Read all refs.
     Reference* refs = new Reference[refCount];
@@ -220,36 +372,84 @@ Bundle* Bundle::create(const char* path)
             stream->read(&refs[i].type, 4, 1) != 1 ||
             stream->read(&refs[i].offset, 4, 1) != 1)
         {
-            SAFE_DELETE(stream);
             GP_ERROR("Failed to read ref number %d for bundle '%s'.", i, path);
             SAFE_DELETE_ARRAY(refs);
-            return NULL;
+            return false;
         }
     }
 
-    // Keep file open for faster reading later.
-    Bundle* bundle = new Bundle(path);
-    bundle->_referenceCount = refCount;
-    bundle->_references = refs;
-    bundle->_stream = stream;
+    *references = refs;
+    return true;
+}
 
-    return bundle;
+bool Bundle::loadReferences() const
+{
+    if (_references)
+        return true;
+
+    // The table may be needed in the middle of reading another object.
+    GP_ASSERT(_stream);
+    long position = _stream->position();
+    if (_stream->seek(_referenceTableOffset, SEEK_SET) == false ||
+        !readReferences(_stream, _path.c_str(), _referenceCount, &_references))
+    {
+        GP_ERROR("Failed to read the reference table of bundle '%s'.", _path.c_str());
+        _stream->seek(position, SEEK_SET);
+        return false;
+    }
+    _stream->seek(position, SEEK_SET);
+
+    buildReferenceIndices();
+    return true;
 }
 
-Bundle::Reference* Bundle::find(const char* id) const
+void Bundle::buildReferenceIndices() const
 {
-    GP_ASSERT(id);
-    GP_ASSERT(_references);
+    GP_ASSERT(_references || _referenceCount == 0);
+
+    // Power of two sizes at most half full, so probe sequences stay short.
+    unsigned int size = 16;
+    while (size < _referenceCount * 2)
+        size <<= 1;
+    _idIndex.assign(size, 0);
+    _offsetIndex.assign(size, 0);
 
-    // Search the ref table for the given id (case-sensitive).
     for (unsigned int i = 0; i < _referenceCount; ++i)
     {
-        if (_references[i].id == id)
+        const Reference& ref = _references[i];
+
+        // Duplicate IDs keep the first reference, which is what a linear search finds.
+        unsigned int slot = StringTable::hash(ref.id.c_str()) & (size - 1);
+        while (_idIndex[slot] != 0 && _references[_idIndex[slot] - 1].id != ref.id)
+            slot = (slot + 1) & (size - 1);
+        if (_idIndex[slot] == 0)
+            _idIndex[slot] = i + 1;
+
+        if (ref.offset > 0 && !ref.id.empty())
         {
-            // Found a match
-            return &_references[i];
+            slot = hashReferenceOffset(ref.offset) & (size - 1);
+            while (_offsetIndex[slot] != 0 && _references[_offsetIndex[slot] - 1].offset != ref.offset)
+                slot = (slot + 1) & (size - 1);
+            if (_offsetIndex[slot] == 0)
+                _offsetIndex[slot] = i + 1;
         }
     }
+}
+
+Bundle::Reference* Bundle::find(const char* id) const
+{
+    GP_ASSERT(id);
+    if (!loadReferences())
+        return NULL;
+
+    // Probe the ID index (case-sensitive).
+    unsigned int mask = (unsigned int)_idIndex.size() - 1;
+    for (unsigned int slot = StringTable::hash(id) & mask; _idIndex[slot] != 0; slot = (slot + 1) & mask)
+    {
+        Reference* ref = &_references[_idIndex[slot] - 1];
+        if (ref->id == id)
+            return ref;
+    }
 
     return NULL;
 }
@@ -271,16 +471,15 @@ const char* Bundle::getIdFromOffset() const
 
 const char* Bundle::getIdFromOffset(unsigned int offset) const
 {
-    // Search the ref table for the given offset.
-    if (offset > 0)
+    // Probe the offset index of the ref table.
+    if (offset > 0 && loadReferences())
     {
-        GP_ASSERT(_references);
-        for (unsigned int i = 0; i < _referenceCount; ++i)
+        unsigned int mask = (unsigned int)_offsetIndex.size() - 1;
+        for (unsigned int slot = hashReferenceOffset(offset) & mask; _offsetIndex[slot] != 0; slot = (slot + 1) & mask)
         {
-            if (_references[i].offset == offset && _references[i].id.length() > 0)
-            {
-                return _references[i].id.c_str();
-            }
+            const Reference& ref = _references[_offsetIndex[slot] - 1];
+            if (ref.offset == offset)
+                return ref.id.c_str();
         }
     }
     return NULL;
@@ -332,8 +531,9 @@ Bundle::Reference* Bundle::seekTo(const char* id, unsigned int type)
 
 Bundle::Reference* Bundle::seekToFirstType(unsigned int type)
 {
-    GP_ASSERT(_references);
     GP_ASSERT(_stream);
+    if (!loadReferences())
+        return NULL;
 
     for (unsigned int i = 0; i < _referenceCount; ++i)
     {
@@ -374,6 +574,7 @@ bool Bundle::readMatrix(float* m)
 
 Scene* Bundle::loadScene(const char* id)
 {
+    LoadProfiler::Scope profile("scene", _path.c_str(), id);
     clearLoadSession();
 
     Reference* ref = NULL;
@@ -452,7 +653,43 @@ Scene* Bundle::loadScene(const char* id)
     }
     scene->setAmbientColor(red, green, blue);
 
-    // Parse animations.
+    // Read the light probes baked for lighting dynamic objects.
+    unsigned int probeCount = 0;
+    if (_version[1] >= 8 && !read(&probeCount))
+    {
+        GP_ERROR("Failed to read the light probe count of the scene in bundle '%s'.", _path.c_str());
+        SAFE_RELEASE(scene);
+        return NULL;
+    }
+    if (probeCount > 0)
+    {
+        LightProbes* probes = LightProbes::create(probeCount);
+        for (unsigned int i = 0; i < probeCount; ++i)
+        {
+            float values[15];
+            if (_stream->read(values, sizeof(float), 15) != 15)
+            {
+                GP_ERROR("Failed to read light probe %u of the scene in bundle '%s'.", i, _path.c_str());
+                SAFE_RELEASE(probes);
+                SAFE_RELEASE(scene);
+                return NULL;
+            }
+            Vector4 irradiance[3] =
+            {
+                Vector4(values + 3),
+                Vector4(values + 7),
+                Vector4(values + 11)
+            };
+            probes->setProbe(i, Vector3(values), irradiance);
+        }
+        scene->setLightProbes(probes);
+        SAFE_RELEASE(probes);
+    }
+
+    // Parse animations. They are paged when the controller has a budget for them,
+    // unless the whole file is held in memory anyway.
+    AnimationController* controller = Game::getInstance()->getAnimationController();
+    bool paged = controller && controller->getPagingBudget() > 0 && !_inMemory;
     GP_ASSERT(_references);
     GP_ASSERT(_stream);
     for (unsigned int i = 0; i < _referenceCount; ++i)
@@ -466,7 +703,7 @@ Scene* Bundle::loadScene(const char* id)
                 GP_ERROR("Failed to seek to object '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
                 return NULL;
             }
-            readAnimations(scene);
+            readAnimations(scene, paged);
         }
     }
 
@@ -483,8 +720,9 @@ Node* Bundle::loadNode(const char* id)
 Node* Bundle::loadNode(const char* id, Scene* sceneContext)
 {
     GP_ASSERT(id);
-    GP_ASSERT(_references);
     GP_ASSERT(_stream);
+    if (!loadReferences())
+        return NULL;
 
     clearLoadSession();
 
@@ -667,6 +905,8 @@ bool Bundle::skipNode()
     Light* light = readLight(); SAFE_RELEASE(light);
     Model* model = readModel(id); SAFE_RELEASE(model);
 
+    readLightmap(NULL);
+
     return true;
 }
 
@@ -807,9 +1047,42 @@ Node* Bundle::readNode(Scene* sceneContext, Node* nodeContext)
         SAFE_RELEASE(model);
     }
 
+    readLightmap(node);
+
     return node;
 }
 
+void Bundle::readLightmap(Node* node)
+{
+    if (_version[1] < 8)
+        return;
+
+    std::string lightmap = readString(_stream);
+    if (lightmap.empty() || node == NULL)
+        return;
+
+    Model* model = node->getModel();
+    if (model == NULL)
+    {
+        GP_WARN("Node '%s' has lightmap '%s' but no model.", node->getId(), lightmap.c_str());
+        return;
+    }
+
+    // The lightmap is written next to the bundle.
+    std::string path = FileSystem::getDirectoryName(_path.c_str());
+    path.append(lightmap);
+    Texture::Sampler* sampler = Texture::Sampler::create(path.c_str(), true);
+    if (sampler == NULL)
+    {
+        GP_ERROR("Failed to load lightmap '%s' for node '%s'.", path.c_str(), node->getId());
+        return;
+    }
+    sampler->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    model->setLightmap(sampler);
+    SAFE_RELEASE(sampler);
+}
+
 Camera* Bundle::readCamera()
 {
     unsigned char cameraType;
@@ -1001,6 +1274,7 @@ Model* Bundle::readModel(const char* nodeId)
                     }
                 }
             }
+            readMeshLods(xref.c_str() + 1, model);
             return model;
         }
     }
@@ -1075,6 +1349,37 @@ MeshSkin* Bundle::readMeshSkin()
         }
     }
 
+    // Read the bounding sphere of the vertices each joint influences, in bundles since version 1.7.
+    unsigned int jointBoundsCount = 0;
+    if (_version[1] >= 7 && !read(&jointBoundsCount))
+    {
+        GP_ERROR("Failed to load number of joint bounds in bundle '%s'.", _path.c_str());
+        SAFE_DELETE(meshSkin);
+        SAFE_DELETE(skinData);
+        return NULL;
+    }
+    if (jointBoundsCount > 0)
+    {
+        std::vector<BoundingSphere> jointBounds(jointBoundsCount);
+        for (unsigned int i = 0; i < jointBoundsCount; ++i)
+        {
+            BoundingSphere& sphere = jointBounds[i];
+            if (!read(&sphere.center.x) || !read(&sphere.center.y) || !read(&sphere.center.z) || !read(&sphere.radius))
+            {
+                GP_ERROR("Failed to load joint bounds (for joint with index %d) in bundle '%s'.", i, _path.c_str());
+                SAFE_DELETE(meshSkin);
+                SAFE_DELETE(skinData);
+                return NULL;
+            }
+        }
+
+        // Skins whose bounds do not match their joints keep the bounds of the mesh.
+        if (jointBoundsCount == jointCount)
+            meshSkin->_jointBounds.swap(jointBounds);
+        else
+            GP_WARN("Ignoring %u joint bounds of a skin with %u joints in bundle '%s'.", jointBoundsCount, jointCount, _path.c_str());
+    }
+
     // Store the MeshSkinData so we can go back and resolve all joint references later.
     _meshSkins.push_back(skinData);
 
@@ -1194,7 +1499,7 @@ void Bundle::resolveJointReferences(Scene* sceneContext, Node* nodeContext)
     _meshSkins.clear();
 }
 
-void Bundle::readAnimation(Scene* scene)
+void Bundle::readAnimation(Scene* scene, bool paged)
 {
     const std::string animationId = readString(_stream);
 
@@ -1209,11 +1514,11 @@ void Bundle::readAnimation(Scene* scene)
     Animation* animation = NULL;
     for (unsigned int i = 0; i < animationChannelCount; i++)
     {
-        animation = readAnimationChannel(scene, animation, animationId.c_str());
+        animation = readAnimationChannel(scene, animation, animationId.c_str(), paged);
     }
 }
 
-void Bundle::readAnimations(Scene* scene)
+void Bundle::readAnimations(Scene* scene, bool paged)
 {
     // Read the number of animations in this object.
     unsigned int animationCount;
@@ -1225,11 +1530,11 @@ void Bundle::readAnimations(Scene* scene)
 
     for (unsigned int i = 0; i < animationCount; i++)
     {
-        readAnimation(scene);
+        readAnimation(scene, paged);
     }
 }
 
-Animation* Bundle::readAnimationChannel(Scene* scene, Animation* animation, const char* animationId)
+Animation* Bundle::readAnimationChannel(Scene* scene, Animation* animation, const char* animationId, bool paged)
 {
     GP_ASSERT(animationId);
 
@@ -1262,10 +1567,53 @@ Animation* Bundle::readAnimationChannel(Scene* scene, Animation* animation, cons
         }
     }
 
+    if (paged)
+        return readPagedAnimationChannel(animation, animationId, target, targetAttribute);
+
     return readAnimationChannelData(animation, animationId, target, targetAttribute);
 }
 
-Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute)
+Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute, Animation::Channel* paged)
+{
+    GP_ASSERT(id);
+
+    // Bundles since version 1.6 may store the keys compressed; they are then read from memory.
+    unsigned int storedSize = 0;
+    if (_version[1] >= 6 && !read(&storedSize))
+    {
+        GP_ERROR("Failed to read key data size for animation '%s'.", id);
+        return NULL;
+    }
+    if (storedSize == 0)
+        return readAnimationChannelKeys(animation, id, target, targetAttribute, paged);
+
+    // Channels that are skipped are not decompressed.
+    if (targetAttribute == 0)
+    {
+        if (!_stream->seek((long)storedSize, SEEK_CUR))
+        {
+            GP_ERROR("Failed to skip key data for animation '%s'.", id);
+            return NULL;
+        }
+        return animation;
+    }
+
+    unsigned int size;
+    unsigned char* data = readCompressedSection(_stream, storedSize, &size);
+    if (data == NULL)
+    {
+        GP_ERROR("Failed to decompress key data for animation '%s'.", id);
+        return NULL;
+    }
+    Stream* stream = _stream;
+    MemoryStream keys(data, size);
+    _stream = &keys;
+    animation = readAnimationChannelKeys(animation, id, target, targetAttribute, paged);
+    _stream = stream;
+    return animation;
+}
+
+Animation* Bundle::readAnimationChannelKeys(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute, Animation::Channel* paged)
 {
     GP_ASSERT(id);
 
@@ -1274,6 +1622,9 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
     std::vector<float> tangentsIn;
     std::vector<float> tangentsOut;
     std::vector<unsigned int> interpolation;
+    std::vector<float> offsets;
+    std::vector<float> scales;
+    std::vector<unsigned short> quantizedValues;
 
     // Length of the arrays.
     unsigned int keyTimesCount;
@@ -1281,32 +1632,69 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
     unsigned int tangentsInCount;
     unsigned int tangentsOutCount;
     unsigned int interpolationCount;
+    unsigned int offsetsCount;
+    unsigned int scalesCount;
 
-    // Read key times.
-    if (!readArray(&keyTimesCount, &keyTimes, sizeof(unsigned int)))
+    // Read the encoding of the key values (bundles before version 1.3 only have float values).
+    unsigned int encoding = BUNDLE_ENCODING_FLOAT;
+    if (_version[1] >= 3 && !read(&encoding))
     {
-        GP_ERROR("Failed to read key times for animation '%s'.", id);
+        GP_ERROR("Failed to read key value encoding for animation '%s'.", id);
         return NULL;
     }
 
-    // Read key values.
-    if (!readArray(&valuesCount, &values))
+    // Read key times.
+    if (!readArray(&keyTimesCount, &keyTimes, sizeof(unsigned int)))
     {
-        GP_ERROR("Failed to read key values for animation '%s'.", id);
+        GP_ERROR("Failed to read key times for animation '%s'.", id);
         return NULL;
     }
 
-    // Read in-tangents.
-    if (!readArray(&tangentsInCount, &tangentsIn))
+    if (encoding == BUNDLE_ENCODING_QUANTIZED)
     {
-        GP_ERROR("Failed to read in tangents for animation '%s'.", id);
-        return NULL;
+        // Read the offset and scale of each component, then the quantized key values.
+        if (!readArray(&offsetsCount, &offsets) || !readArray(&scalesCount, &scales))
+        {
+            GP_ERROR("Failed to read key value ranges for animation '%s'.", id);
+            return NULL;
+        }
+        if (!readArray(&valuesCount, &quantizedValues, sizeof(unsigned short)))
+        {
+            GP_ERROR("Failed to read quantized key values for animation '%s'.", id);
+            return NULL;
+        }
+        if (offsetsCount == 0 || scalesCount != offsetsCount || valuesCount != keyTimesCount * offsetsCount)
+        {
+            GP_ERROR("Invalid quantized key values for animation '%s'.", id);
+            return NULL;
+        }
     }
+    else if (encoding == BUNDLE_ENCODING_FLOAT)
+    {
+        // Read key values.
+        if (!readArray(&valuesCount, &values))
+        {
+            GP_ERROR("Failed to read key values for animation '%s'.", id);
+            return NULL;
+        }
+
+        // Read in-tangents.
+        if (!readArray(&tangentsInCount, &tangentsIn))
+        {
+            GP_ERROR("Failed to read in tangents for animation '%s'.", id);
+            return NULL;
+        }
 
-    // Read out-tangents.
-    if (!readArray(&tangentsOutCount, &tangentsOut))
+        // Read out-tangents.
+        if (!readArray(&tangentsOutCount, &tangentsOut))
+        {
+            GP_ERROR("Failed to read out tangents for animation '%s'.", id);
+            return NULL;
+        }
+    }
+    else
     {
-        GP_ERROR("Failed to read out tangents for animation '%s'.", id);
+        GP_ERROR("Unsupported key value encoding (%d) for animation '%s'.", (int)encoding, id);
         return NULL;
     }
 
@@ -1317,7 +1705,28 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
         return NULL;
     }
 
-    if (targetAttribute > 0)
+    if (targetAttribute > 0 && encoding == BUNDLE_ENCODING_QUANTIZED)
+    {
+        GP_ASSERT(target);
+        GP_ASSERT(keyTimes.size() > 0);
+        if (target->getAnimationPropertyComponentCount(targetAttribute) != offsetsCount)
+        {
+            GP_ERROR("Quantized key values for animation '%s' do not match the component count of the target property.", id);
+            return animation;
+        }
+        if (animation == NULL)
+        {
+            animation = new Animation(id);
+            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &quantizedValues[0], &offsets[0], &scales[0]);
+            // Release the animation because a newly created animation has a ref count of 1 and the channels hold the ref to animation.
+            animation->release();
+        }
+        else
+        {
+            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &quantizedValues[0], &offsets[0], &scales[0], paged);
+        }
+    }
+    else if (targetAttribute > 0)
     {
         GP_ASSERT(target);
         GP_ASSERT(keyTimes.size() > 0 && values.size() > 0);
@@ -1328,64 +1737,289 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
         }
         else
         {
-            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR);
+            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR, paged);
         }
     }
 
     return animation;
 }
 
-Mesh* Bundle::loadMesh(const char* id)
+// Reads the number of key times and the first and last key time of the key data of an animation channel.
+static bool readKeyTimeRange(Stream* stream, unsigned int* count, unsigned int* first, unsigned int* last)
 {
-    return loadMesh(id, NULL);
+    if (stream->read(count, 4, 1) != 1 || *count == 0 || stream->read(first, 4, 1) != 1)
+        return false;
+    *last = *first;
+    if (*count > 1 && (!stream->seek((long)(*count - 2) * 4, SEEK_CUR) || stream->read(last, 4, 1) != 1))
+        return false;
+    return true;
 }
 
-Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
+// Skips the arrays that follow the key times of an animation channel, which are each preceded by their length.
+static bool skipKeyArrays(Stream* stream, unsigned int encoding)
 {
-    GP_ASSERT(_stream);
-    GP_ASSERT(id);
-
-    // Save the file position.
-    long position = _stream->position();
-    if (position == -1L)
+    static const unsigned int floatSizes[] = { 4, 4, 4, 4 };            // Values, in and out tangents, interpolations.
+    static const unsigned int quantizedSizes[] = { 4, 4, 2, 4 };        // Offsets, scales, values, interpolations.
+    const unsigned int* sizes = encoding == BUNDLE_ENCODING_QUANTIZED ? quantizedSizes : floatSizes;
+    for (unsigned int i = 0; i < 4; ++i)
     {
-        GP_ERROR("Failed to save the current file position before loading mesh '%s'.", id);
-        return NULL;
+        unsigned int length;
+        if (stream->read(&length, 4, 1) != 1 || !stream->seek((long)length * sizes[i], SEEK_CUR))
+            return false;
     }
+    return true;
+}
 
-    // Seek to the specified mesh.
-    Reference* ref = seekTo(id, BUNDLE_TYPE_MESH);
-    if (ref == NULL)
-    {
-        GP_ERROR("Failed to locate ref for mesh '%s'.", id);
-        return NULL;
-    }
+Animation* Bundle::readPagedAnimationChannel(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute)
+{
+    GP_ASSERT(id);
 
-    // Read mesh data.
-    MeshData* meshData = readMeshData();
-    if (meshData == NULL)
+    // The channel keeps the offset of its key data, which is read again when the animation is loaded.
+    long offset = _stream->position();
+    unsigned int storedSize = 0;
+    if (_version[1] >= 6 && !read(&storedSize))
     {
-        GP_ERROR("Failed to load mesh data for mesh '%s'.", id);
+        GP_ERROR("Failed to read key data size for animation '%s'.", id);
         return NULL;
     }
 
-    // Create mesh.
-    Mesh* mesh = Mesh::createMesh(meshData->vertexFormat, meshData->vertexCount, false);
-    if (mesh == NULL)
+    unsigned int encoding = BUNDLE_ENCODING_FLOAT;
+    unsigned int keyCount, firstTime, lastTime;
+    bool valid;
+    if (storedSize == 0)
     {
-        GP_ERROR("Failed to create mesh '%s'.", id);
-        SAFE_DELETE_ARRAY(meshData);
-        return NULL;
+        valid = (_version[1] < 3 || read(&encoding)) && readKeyTimeRange(_stream, &keyCount, &firstTime, &lastTime) && skipKeyArrays(_stream, encoding);
     }
-
-    mesh->_url = _path;
+    else
+    {
+        // Only the blocks holding the key times are decompressed.
+        long start = _stream->position();
+        unsigned int size = 0;
+        unsigned char* data = readCompressedSection(_stream, storedSize, &size, 8);
+        if (data && size >= 8)
+        {
+            memcpy(&keyCount, data + 4, 4);
+            unsigned int needed = 8 + keyCount * 4;
+            if (size < needed)
+            {
+                SAFE_DELETE_ARRAY(data);
+                if (_stream->seek(start, SEEK_SET))
+                    data = readCompressedSection(_stream, storedSize, &size, needed);
+            }
+        }
+        valid = data != NULL;
+        if (valid)
+        {
+            MemoryStream keys(data, size);
+            valid = keys.read(&encoding, 4, 1) == 1 && readKeyTimeRange(&keys, &keyCount, &firstTime, &lastTime);
+        }
+        valid = valid && _stream->seek(start + (long)storedSize, SEEK_SET);
+    }
+    if (!valid)
+    {
+        GP_ERROR("Failed to read key times for animation '%s'.", id);
+        return NULL;
+    }
+
+    if (targetAttribute == 0)
+        return animation;
+
+    GP_ASSERT(target);
+    if (animation == NULL)
+    {
+        animation = new Animation(id);
+        animation->_bundle = this;
+        animation->_loaded = false;
+        addRef();
+        animation->createPagedChannel(target, targetAttribute, lastTime - firstTime, (unsigned int)offset);
+        // Release the animation because a newly created animation has a ref count of 1 and the channels hold the ref to animation.
+        animation->release();
+    }
+    else
+    {
+        animation->createPagedChannel(target, targetAttribute, lastTime - firstTime, (unsigned int)offset);
+    }
+    return animation;
+}
+
+bool Bundle::loadAnimation(Animation* animation)
+{
+    GP_ASSERT(animation);
+    GP_ASSERT(_stream);
+
+    // Animations are loaded when they are played, which may be in the middle of another load from the bundle.
+    long position = _stream->position();
+    bool loaded = true;
+    for (size_t i = 0, count = animation->_channels.size(); i < count && loaded; ++i)
+    {
+        Animation::Channel* channel = animation->_channels[i];
+        GP_ASSERT(channel);
+        if (channel->_curve)
+            continue;
+
+        loaded = _stream->seek(channel->_pageOffset, SEEK_SET) &&
+            readAnimationChannelData(animation, animation->getId(), channel->_target, channel->_propertyId, channel) == animation &&
+            channel->_curve != NULL;
+    }
+    _stream->seek(position, SEEK_SET);
+    return loaded;
+}
+
+Mesh* Bundle::loadMesh(const char* id)
+{
+    return loadMesh(id, NULL);
+}
+
+Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
+{
+    GP_ASSERT(_stream);
+    GP_ASSERT(id);
+
+    // Meshes created ahead of time by an asynchronous load are used once.
+    std::map<std::string, Mesh*>::iterator itr = _preparedMeshes.find(id);
+    if (itr != _preparedMeshes.end())
+    {
+        Mesh* mesh = itr->second;
+        _preparedMeshes.erase(itr);
+        return mesh;
+    }
+
+    // Save the file position.
+    long position = _stream->position();
+    if (position == -1L)
+    {
+        GP_ERROR("Failed to save the current file position before loading mesh '%s'.", id);
+        return NULL;
+    }
+
+    // Seek to the specified mesh.
+    Reference* ref = seekTo(id, BUNDLE_TYPE_MESH);
+    if (ref == NULL)
+    {
+        GP_ERROR("Failed to locate ref for mesh '%s'.", id);
+        return NULL;
+    }
+
+    // Read mesh data.
+    LoadProfiler::Scope profile("mesh", _path.c_str(), id);
+    MeshData* meshData;
+    {
+        LoadProfiler::Phase decode(LoadProfiler::DECODE);
+        meshData = readMeshData();
+    }
+    if (meshData == NULL)
+    {
+        GP_ERROR("Failed to load mesh data for mesh '%s'.", id);
+        return NULL;
+    }
+
+    Mesh* mesh;
+    {
+        LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
+        mesh = createMesh(meshData, id);
+    }
+    SAFE_DELETE(meshData);
+    if (mesh == NULL)
+    {
+        return NULL;
+    }
+
+    // Restore file pointer.
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
+        SAFE_RELEASE(mesh);
+        return NULL;
+    }
+
+    return mesh;
+}
+
+// Converts vertex data to an all float vertex format, for devices that cannot read some of its types.
+static float* expandVertexData(const VertexFormat& format, const unsigned char* vertexData, unsigned int vertexCount, std::vector<VertexFormat::Element>* floatElements)
+{
+    unsigned int floatCount = 0;
+    for (unsigned int i = 0, count = format.getElementCount(); i < count; ++i)
+    {
+        VertexFormat::Element e = format.getElement(i);
+        if (e.type == VertexFormat::INT_2_10_10_10_REV || e.type == VertexFormat::UNSIGNED_INT_2_10_10_10_REV)
+            e.size = 4;
+        floatElements->push_back(VertexFormat::Element(e.usage, e.size));
+        floatCount += e.size;
+    }
+
+    float* data = new float[floatCount * vertexCount];
+    float* dst = data;
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        const unsigned char* src = vertexData + v * format.getVertexSize();
+        for (unsigned int i = 0, count = format.getElementCount(); i < count; ++i)
+        {
+            const VertexFormat::Element& e = format.getElement(i);
+            VertexFormat::decode(e, src, dst);
+            src += e.getByteSize();
+            dst += (*floatElements)[i].size;
+        }
+    }
+    return data;
+}
+
+Mesh* Bundle::createMesh(MeshData* meshData, const char* id)
+{
+    GP_ASSERT(meshData);
+
+    bool supported = true;
+    for (unsigned int i = 0, count = meshData->vertexFormat.getElementCount(); i < count; ++i)
+    {
+        if (!VertexAttributeBinding::isTypeSupported(meshData->vertexFormat.getElement(i).type))
+            supported = false;
+    }
+
+    // Create mesh.
+    Mesh* mesh;
+    if (supported)
+    {
+        mesh = Mesh::createMesh(meshData->vertexFormat, meshData->vertexCount, false);
+        if (mesh)
+            mesh->setVertexData((float*)meshData->vertexData, 0, meshData->vertexCount);
+    }
+    else
+    {
+        GP_WARN("Expanding the vertices of mesh '%s' to floats; the device does not support its vertex types.", id);
+        std::vector<VertexFormat::Element> elements;
+        float* vertexData = expandVertexData(meshData->vertexFormat, meshData->vertexData, meshData->vertexCount, &elements);
+        mesh = Mesh::createMesh(VertexFormat(&elements[0], (unsigned int)elements.size()), meshData->vertexCount, false);
+        if (mesh)
+            mesh->setVertexData(vertexData, 0, meshData->vertexCount);
+        SAFE_DELETE_ARRAY(vertexData);
+    }
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to create mesh '%s'.", id);
+        return NULL;
+    }
+
+    mesh->_url = _path;
     mesh->_url += "#";
     mesh->_url += id;
 
-    mesh->setVertexData((float*)meshData->vertexData, 0, meshData->vertexCount);
-
     mesh->_boundingBox.set(meshData->boundingBox);
     mesh->_boundingSphere.set(meshData->boundingSphere);
+    if (meshData->hasPositionDecode)
+        mesh->setPositionDecode(meshData->positionOffset, meshData->positionScale);
+
+    // The parts share one index buffer, so that drawing them one after another binds it once.
+    if (meshData->parts.size() > 1)
+    {
+        unsigned int indexBufferSize = 0;
+        for (unsigned int i = 0; i < meshData->parts.size(); ++i)
+        {
+            const MeshPartData* partData = meshData->parts[i];
+            unsigned int indexSize = partData->indexFormat == Mesh::INDEX32 ? 4 : (partData->indexFormat == Mesh::INDEX16 ? 2 : 1);
+            indexBufferSize = (indexBufferSize + indexSize - 1) / indexSize * indexSize + indexSize * partData->indexCount;
+        }
+        mesh->reserveIndexBuffer(indexBufferSize);
+    }
 
     // Create mesh parts.
     for (unsigned int i = 0; i < meshData->parts.size(); ++i)
@@ -1393,33 +2027,112 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
         MeshPartData* partData = meshData->parts[i];
         GP_ASSERT(partData);
 
+        if (!Mesh::isIndexFormatSupported(partData->indexFormat))
+        {
+            GP_WARN("Mesh '%s' uses 32-bit indices, which this device does not support; re-encode it with the encoder's -i16 option.", id);
+        }
+
         MeshPart* part = mesh->addPart(partData->primitiveType, partData->indexFormat, partData->indexCount, false);
         if (part == NULL)
         {
             GP_ERROR("Failed to create mesh part (with index %d) for mesh '%s'.", i, id);
-            SAFE_DELETE(meshData);
+            SAFE_RELEASE(mesh);
             return NULL;
         }
         part->setIndexData(partData->indexData, 0, partData->indexCount);
+        DebugMarkers::setLabel(GL_BUFFER, part->getIndexBuffer(), mesh->_url.c_str());
     }
+    DebugMarkers::setLabel(GL_BUFFER, mesh->_vertexBuffer, mesh->_url.c_str());
 
-    SAFE_DELETE(meshData);
+    return mesh;
+}
 
-    // Restore file pointer.
-    if (_stream->seek(position, SEEK_SET) == false)
+Bundle::MeshData* Bundle::readMeshData()
+{
+    return readMeshData(_stream, true, _version[1]);
+}
+
+// Points the data at the current position of a memory-backed stream and skips it.
+static unsigned char* readInPlace(Stream* stream, size_t size)
+{
+    const unsigned char* data = stream->getData();
+    long position = stream->position();
+    if (data == NULL || position < 0 || (size_t)position + size > stream->length())
+        return NULL;
+    if (!stream->seek((long)size, SEEK_CUR))
+        return NULL;
+    return const_cast<unsigned char*>(data + position);
+}
+
+unsigned char* Bundle::readCompressedSection(Stream* stream, unsigned int storedSize, unsigned int* size, unsigned int limit)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(size);
+
+    // The decompressed size comes first, then blocks of zlib data that are each preceded by
+    // their decompressed and compressed sizes and decompress on their own.
+    unsigned int dataSize;
+    if (stream->read(&dataSize, 4, 1) != 1 || storedSize < 4)
+        return NULL;
+    storedSize -= 4;
+
+    std::vector<unsigned char> buffer;
+    unsigned char* data = new unsigned char[dataSize];
+    unsigned int offset = 0;
+    unsigned int position = 0;
+    bool valid = true;
+    while (valid && position + 8 <= storedSize && offset < limit)
     {
-        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
+        unsigned int header[2];
+        if (stream->read(header, 4, 2) != 2)
+        {
+            valid = false;
+            break;
+        }
+        unsigned int blockSize = header[0];
+        unsigned int packedSize = header[1];
+        position += 8;
+        if (blockSize > dataSize - offset || packedSize > storedSize - position)
+        {
+            valid = false;
+            break;
+        }
+
+        const unsigned char* packed = readInPlace(stream, packedSize);
+        if (packed == NULL)
+        {
+            buffer.resize(packedSize);
+            if (packedSize == 0 || stream->read(&buffer[0], 1, packedSize) != packedSize)
+            {
+                valid = false;
+                break;
+            }
+            packed = &buffer[0];
+        }
+        uLongf length = blockSize;
+        valid = uncompress(data + offset, &length, packed, packedSize) == Z_OK && length == blockSize;
+        offset += blockSize;
+        position += packedSize;
+    }
+
+    // A limited read may stop at any block, a full one must end with the section.
+    if (!valid || (offset < limit && (position != storedSize || offset != dataSize)))
+    {
+        SAFE_DELETE_ARRAY(data);
         return NULL;
     }
 
-    return mesh;
+    *size = offset;
+    return data;
 }
 
-Bundle::MeshData* Bundle::readMeshData()
+Bundle::MeshData* Bundle::readMeshData(Stream* stream, bool inPlace, unsigned char minorVersion)
 {
+    GP_ASSERT(stream);
+
     // Read vertex format/elements.
     unsigned int vertexElementCount;
-    if (_stream->read(&vertexElementCount, 4, 1) != 1)
+    if (stream->read(&vertexElementCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex element count.");
         return NULL;
@@ -1434,13 +2147,13 @@ Bundle::MeshData* Bundle::readMeshData()
     for (unsigned int i = 0; i < vertexElementCount; ++i)
     {
         unsigned int vUsage, vSize;
-        if (_stream->read(&vUsage, 4, 1) != 1)
+        if (stream->read(&vUsage, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex usage.");
             SAFE_DELETE_ARRAY(vertexElements);
             return NULL;
         }
-        if (_stream->read(&vSize, 4, 1) != 1)
+        if (stream->read(&vSize, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex size.");
             SAFE_DELETE_ARRAY(vertexElements);
@@ -1449,14 +2162,52 @@ Bundle::MeshData* Bundle::readMeshData()
 
         vertexElements[i].usage = (VertexFormat::Usage)vUsage;
         vertexElements[i].size = vSize;
+
+        // Bundles before version 1.5 only have float vertex elements.
+        if (minorVersion >= 5)
+        {
+            unsigned int vType;
+            unsigned char vNormalized;
+            if (stream->read(&vType, 4, 1) != 1 || stream->read(&vNormalized, 1, 1) != 1)
+            {
+                GP_ERROR("Failed to load vertex type.");
+                SAFE_DELETE_ARRAY(vertexElements);
+                return NULL;
+            }
+            if (vType > VertexFormat::UNSIGNED_INT_2_10_10_10_REV)
+            {
+                GP_ERROR("Unsupported vertex type %u.", vType);
+                SAFE_DELETE_ARRAY(vertexElements);
+                return NULL;
+            }
+            vertexElements[i].type = (VertexFormat::Type)vType;
+            vertexElements[i].normalized = vNormalized != 0;
+        }
     }
 
     MeshData* meshData = new MeshData(VertexFormat(vertexElements, vertexElementCount));
     SAFE_DELETE_ARRAY(vertexElements);
 
+    // Quantized positions are followed by the transform that decodes them.
+    for (unsigned int i = 0; i < vertexElementCount; ++i)
+    {
+        const VertexFormat::Element& e = meshData->vertexFormat.getElement(i);
+        if (e.usage == VertexFormat::POSITION && e.type != VertexFormat::FLOAT)
+        {
+            if (stream->read(&meshData->positionOffset.x, 4, 3) != 3 || stream->read(&meshData->positionScale.x, 4, 3) != 3)
+            {
+                GP_ERROR("Failed to load vertex position decode.");
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
+            meshData->hasPositionDecode = true;
+            break;
+        }
+    }
+
     // Read vertex data.
     unsigned int vertexByteCount;
-    if (_stream->read(&vertexByteCount, 4, 1) != 1)
+    if (stream->read(&vertexByteCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex byte count.");
         SAFE_DELETE(meshData);
@@ -1469,10 +2220,34 @@ Bundle::MeshData* Bundle::readMeshData()
         return NULL;
     }
 
+    // Bundles since version 1.6 may store the vertex data compressed.
+    unsigned int vertexStoredSize = 0;
+    if (minorVersion >= 6 && stream->read(&vertexStoredSize, 4, 1) != 1)
+    {
+        GP_ERROR("Failed to load vertex data size.");
+        SAFE_DELETE(meshData);
+        return NULL;
+    }
+
     GP_ASSERT(meshData->vertexFormat.getVertexSize());
     meshData->vertexCount = vertexByteCount / meshData->vertexFormat.getVertexSize();
-    meshData->vertexData = new unsigned char[vertexByteCount];
-    if (_stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+    meshData->vertexData = inPlace && vertexStoredSize == 0 ? readInPlace(stream, vertexByteCount) : NULL;
+    if (vertexStoredSize > 0)
+    {
+        unsigned int size = 0;
+        meshData->vertexData = readCompressedSection(stream, vertexStoredSize, &size);
+        if (meshData->vertexData == NULL || size != vertexByteCount)
+        {
+            GP_ERROR("Failed to decompress vertex data.");
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
+    }
+    else if (meshData->vertexData)
+    {
+        meshData->ownsData = false;
+    }
+    else if (stream->read(meshData->vertexData = new unsigned char[vertexByteCount], 1, vertexByteCount) != vertexByteCount)
     {
         GP_ERROR("Failed to load vertex data.");
         SAFE_DELETE(meshData);
@@ -1480,13 +2255,13 @@ Bundle::MeshData* Bundle::readMeshData()
     }
 
     // Read mesh bounds (bounding box and bounding sphere).
-    if (_stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || _stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
+    if (stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
     {
         GP_ERROR("Failed to load mesh bounding box.");
         SAFE_DELETE(meshData);
         return NULL;
     }
-    if (_stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || _stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
+    if (stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh bounding sphere.");
         SAFE_DELETE(meshData);
@@ -1495,7 +2270,7 @@ Bundle::MeshData* Bundle::readMeshData()
 
     // Read mesh parts.
     unsigned int meshPartCount;
-    if (_stream->read(&meshPartCount, 4, 1) != 1)
+    if (stream->read(&meshPartCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh part count.");
         SAFE_DELETE(meshData);
@@ -1505,19 +2280,19 @@ Bundle::MeshData* Bundle::readMeshData()
     {
         // Read primitive type, index format and index count.
         unsigned int pType, iFormat, iByteCount;
-        if (_stream->read(&pType, 4, 1) != 1)
+        if (stream->read(&pType, 4, 1) != 1)
         {
             GP_ERROR("Failed to load primitive type for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iFormat, 4, 1) != 1)
+        if (stream->read(&iFormat, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index format for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iByteCount, 4, 1) != 1)
+        if (stream->read(&iByteCount, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index byte count for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
@@ -1550,8 +2325,31 @@ Bundle::MeshData* Bundle::readMeshData()
         GP_ASSERT(indexSize);
         partData->indexCount = iByteCount / indexSize;
 
-        partData->indexData = new unsigned char[iByteCount];
-        if (_stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+        unsigned int iStoredSize = 0;
+        if (minorVersion >= 6 && stream->read(&iStoredSize, 4, 1) != 1)
+        {
+            GP_ERROR("Failed to load index data size for mesh part with index %d.", i);
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
+
+        partData->indexData = inPlace && iStoredSize == 0 ? readInPlace(stream, iByteCount) : NULL;
+        if (iStoredSize > 0)
+        {
+            unsigned int size = 0;
+            partData->indexData = readCompressedSection(stream, iStoredSize, &size);
+            if (partData->indexData == NULL || size != iByteCount)
+            {
+                GP_ERROR("Failed to decompress index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
+        }
+        else if (partData->indexData)
+        {
+            partData->ownsData = false;
+        }
+        else if (stream->read(partData->indexData = new unsigned char[iByteCount], 1, iByteCount) != iByteCount)
         {
             GP_ERROR("Failed to read index data for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
@@ -1601,14 +2399,215 @@ Bundle::MeshData* Bundle::readMeshData(const char* url)
         return NULL;
     }
 
-    // Read mesh data from current file position.
-    MeshData* meshData = bundle->readMeshData();
+    // Read mesh data from current file position. The data is copied since the bundle is released below.
+    MeshData* meshData = readMeshData(bundle->_stream, false, bundle->_version[1]);
+    if (meshData)
+        bundle->readMeshBvhData(id.c_str(), meshData);
 
     SAFE_RELEASE(bundle);
 
     return meshData;
 }
 
+void Bundle::readMeshBvhData(const char* id, MeshData* meshData)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(meshData);
+
+    // The hierarchy is optional, so a missing one is not an error.
+    std::string bvhId(id);
+    bvhId.append("_bvh");
+    Reference* ref = find(bvhId.c_str());
+    if (ref == NULL || ref->type != BUNDLE_TYPE_MESHBVH)
+        return;
+
+    GP_ASSERT(_stream);
+    unsigned int size;
+    if (_stream->seek(ref->offset, SEEK_SET) == false ||
+        !read(&meshData->bvhPlatform) || !read(&meshData->bvhVersion) || !read(&size))
+    {
+        GP_WARN("Failed to read collision hierarchy header for mesh '%s' in bundle '%s'.", id, _path.c_str());
+        return;
+    }
+    if (size == 0)
+        return;
+
+    unsigned char* data = new unsigned char[size];
+    if (_stream->read(data, 1, size) != size)
+    {
+        GP_WARN("Failed to read collision hierarchy for mesh '%s' in bundle '%s'.", id, _path.c_str());
+        SAFE_DELETE_ARRAY(data);
+        return;
+    }
+    meshData->bvhSize = size;
+    meshData->bvhData = data;
+}
+
+void Bundle::readMeshLods(const char* id, Model* model)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(model);
+
+    // The levels of detail are optional, so missing ones are not an error.
+    std::string lodId(id);
+    lodId.append("_lod");
+    Reference* ref = find(lodId.c_str());
+    if (ref == NULL || ref->type != BUNDLE_TYPE_MESHLOD)
+        return;
+
+    GP_ASSERT(_stream);
+    long position = _stream->position();
+    unsigned int levelCount;
+    if (position == -1L || _stream->seek(ref->offset, SEEK_SET) == false || !read(&levelCount))
+    {
+        GP_WARN("Failed to read levels of detail for mesh '%s' in bundle '%s'.", id, _path.c_str());
+        if (position != -1L)
+            _stream->seek(position, SEEK_SET);
+        return;
+    }
+
+    for (unsigned int i = 0; i < levelCount; ++i)
+    {
+        std::string xref = readString(_stream);
+        float screenSize;
+        if (xref.length() <= 1 || xref[0] != '#' || !read(&screenSize))
+        {
+            GP_WARN("Failed to read level of detail %u for mesh '%s' in bundle '%s'.", i, id, _path.c_str());
+            break;
+        }
+
+        // loadMesh restores the stream position, so the next level follows.
+        Mesh* mesh = loadMesh(xref.c_str() + 1, NULL);
+        if (mesh)
+        {
+            if (mesh->getVertexFormat() == model->getMesh()->getVertexFormat() &&
+                mesh->getPartCount() == model->getMesh()->getPartCount())
+            {
+                model->addMeshLod(mesh, screenSize);
+            }
+            else
+            {
+                GP_WARN("Level of detail '%s' does not match the vertex format and parts of mesh '%s'.", xref.c_str() + 1, id);
+            }
+            SAFE_RELEASE(mesh);
+        }
+    }
+
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading levels of detail for mesh '%s'.", id);
+    }
+}
+
+VertexAnimation* Bundle::loadVertexAnimation(const char* id)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(_stream);
+
+    std::string vatId(id);
+    vatId.append("_vat");
+    long position = _stream->position();
+    if (position == -1L || seekTo(vatId.c_str(), BUNDLE_TYPE_VERTEXANIMATION) == NULL)
+    {
+        GP_ERROR("Failed to locate the vertex animation of mesh '%s'; the bundle must be encoded with -vat.", id);
+        return NULL;
+    }
+
+    VertexAnimation::Data data;
+    float min[3], max[3];
+    unsigned int count = 0, partCount = 0;
+    bool valid = read(&data.frameRate) && read(&data.frameCount) && read(&data.vertexCount) &&
+        _stream->read(min, sizeof(float), 3) == 3 && _stream->read(max, sizeof(float), 3) == 3 && read(&count);
+    if (valid)
+    {
+        data.texCoords.resize(count);
+        valid = count == 0 || _stream->read(&data.texCoords[0], sizeof(float), count) == count;
+    }
+    valid = valid && read(&partCount);
+    for (unsigned int i = 0; valid && i < partCount; ++i)
+    {
+        unsigned int primitiveType;
+        valid = read(&primitiveType) && read(&count);
+        if (valid)
+        {
+            data.primitiveTypes.push_back(primitiveType);
+            data.indices.push_back(std::vector<unsigned int>(count));
+            valid = count == 0 || _stream->read(&data.indices.back()[0], sizeof(unsigned int), count) == count;
+        }
+    }
+    valid = valid && read(&count);
+    if (valid)
+    {
+        data.positions.resize(count);
+        valid = count == 0 || _stream->read(&data.positions[0], sizeof(float), count) == count;
+    }
+    valid = valid && read(&count);
+    if (valid)
+    {
+        data.normals.resize(count);
+        valid = count == 0 || _stream->read(&data.normals[0], sizeof(float), count) == count;
+    }
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading the vertex animation of mesh '%s'.", id);
+        return NULL;
+    }
+    if (!valid)
+    {
+        GP_ERROR("Failed to read the vertex animation of mesh '%s' in bundle '%s'.", id, _path.c_str());
+        return NULL;
+    }
+    data.boundingBox.set(Vector3(min), Vector3(max));
+
+    return VertexAnimation::create(id, data);
+}
+
+NavigationMesh* Bundle::loadNavigationMesh(const char* id)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(_stream);
+
+    long position = _stream->position();
+    if (position == -1L || seekTo(id, BUNDLE_TYPE_NAVIGATIONMESH) == NULL)
+    {
+        GP_ERROR("Failed to locate navigation mesh '%s'; the bundle must be encoded with -nav.", id);
+        return NULL;
+    }
+
+    NavigationMesh::Data data;
+    unsigned int count = 0;
+    bool valid = read(&count);
+    if (valid)
+    {
+        data.vertices.resize(count);
+        valid = count == 0 || _stream->read(&data.vertices[0], sizeof(float), count) == count;
+    }
+    valid = valid && read(&count);
+    if (valid)
+    {
+        data.triangles.resize(count);
+        valid = count == 0 || _stream->read(&data.triangles[0], sizeof(unsigned int), count) == count;
+    }
+    valid = valid && read(&count);
+    if (valid)
+    {
+        data.links.resize(count);
+        valid = count == 0 || _stream->read(&data.links[0], sizeof(unsigned int), count) == count;
+    }
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading navigation mesh '%s'.", id);
+        return NULL;
+    }
+    if (!valid)
+    {
+        GP_ERROR("Failed to read navigation mesh '%s' in bundle '%s'.", id, _path.c_str());
+        return NULL;
+    }
+
+    return NavigationMesh::create(id, data);
+}
+
 Font* Bundle::loadFont(const char* id)
 {
     GP_ASSERT(id);
@@ -1646,6 +2645,14 @@ Font* Bundle::loadFont(const char* id)
     // Read character set.
     std::string charset = readString(_stream);
 
+    // Read the glyph format (bundles before version 1.4 only have bitmap fonts).
+    unsigned int format = 0;
+    if (_version[1] >= 4 && !read(&format))
+    {
+        GP_ERROR("Failed to read format for font '%s'.", id);
+        return NULL;
+    }
+
     // Read font glyphs.
     unsigned int glyphCount;
     if (_stream->read(&glyphCount, 4, 1) != 1)
@@ -1718,7 +2725,7 @@ Font* Bundle::loadFont(const char* id)
     }
 
     // Create the font.
-    Font* font = Font::create(family.c_str(), Font::PLAIN, size, glyphs, glyphCount, texture);
+    Font* font = Font::create(family.c_str(), Font::PLAIN, size, glyphs, glyphCount, texture, format == 1);
 
     // Free the glyph array.
     SAFE_DELETE_ARRAY(glyphs);
@@ -1761,8 +2768,300 @@ unsigned int Bundle::getObjectCount() const
 
 const char* Bundle::getObjectId(unsigned int index) const
 {
-    GP_ASSERT(_references);
-    return (index >= _referenceCount ? NULL : _references[index].id.c_str());
+    return (index >= _referenceCount || !loadReferences() ? NULL : _references[index].id.c_str());
+}
+
+Bundle::AsyncLoad* Bundle::loadSceneAsync(const char* path, const char* id, AsyncLoadCallback callback, void* cookie)
+{
+    return loadAsync(BUNDLE_TYPE_SCENE, path, id, callback, cookie);
+}
+
+Bundle::AsyncLoad* Bundle::loadNodeAsync(const char* path, const char* id, AsyncLoadCallback callback, void* cookie)
+{
+    GP_ASSERT(id);
+    return loadAsync(BUNDLE_TYPE_NODE, path, id, callback, cookie);
+}
+
+Bundle::AsyncLoad* Bundle::loadMeshAsync(const char* path, const char* id, AsyncLoadCallback callback, void* cookie)
+{
+    GP_ASSERT(id);
+    return loadAsync(BUNDLE_TYPE_MESH, path, id, callback, cookie);
+}
+
+void Bundle::setAsyncLoadTimeBudget(float milliseconds)
+{
+    __asyncLoadTimeBudget = milliseconds;
+}
+
+Bundle::AsyncLoad* Bundle::loadAsync(unsigned int type, const char* path, const char* id, AsyncLoadCallback callback, void* cookie)
+{
+    GP_ASSERT(path);
+
+    AsyncLoad* load = new AsyncLoad();
+    load->_type = type;
+    load->_path = path;
+    load->_id = id ? id : "";
+    load->_callback = callback;
+    load->_cookie = cookie;
+
+    // The pending list holds its own reference until the load finishes.
+    load->addRef();
+    __asyncLoads.push_back(load);
+
+    // Reading the whole file up front means that building the objects on the main thread never waits on file IO.
+    load->_read = FileSystem::readAsync(path);
+
+    return load;
+}
+
+void Bundle::decodeAsyncLoad(void* cookie)
+{
+    AsyncLoad* load = (AsyncLoad*)cookie;
+    GP_ASSERT(load);
+
+    GP_ASSERT(load->_stream);
+    if (!readHeader(load->_stream, load->_path.c_str(), load->_version, &load->_referenceCount) ||
+        !readReferences(load->_stream, load->_path.c_str(), load->_referenceCount, &load->_references))
+    {
+        load->_decodeFailed = true;
+        return;
+    }
+
+    // Decode the vertex and index data of the meshes that may be needed.
+    for (unsigned int i = 0; i < load->_referenceCount; ++i)
+    {
+        Reference* ref = &load->_references[i];
+        if (ref->type != BUNDLE_TYPE_MESH || (load->_type == BUNDLE_TYPE_MESH && ref->id != load->_id))
+            continue;
+
+        if (load->_stream->seek(ref->offset, SEEK_SET) == false)
+        {
+            GP_WARN("Failed to seek to mesh '%s' in bundle '%s'.", ref->id.c_str(), load->_path.c_str());
+            continue;
+        }
+        MeshData* meshData = readMeshData(load->_stream, true, load->_version[1]);
+        if (meshData)
+        {
+            load->_meshData.push_back(std::make_pair(ref->id, meshData));
+        }
+    }
+}
+
+bool Bundle::updateAsyncLoad(AsyncLoad* load, double endTime)
+{
+    GP_ASSERT(load);
+
+    if (load->_read)
+    {
+        if (load->_read->getState() == FileSystem::AsyncRead::LOADING)
+            return false;
+
+        size_t length = load->_read->getSize();
+        unsigned char* data = (unsigned char*)load->_read->detachData();
+        SAFE_RELEASE(load->_read);
+        if (data == NULL)
+        {
+            load->_state = AsyncLoad::FAILED;
+            return true;
+        }
+        load->_stream = new MemoryStream(data, length);
+
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (scheduler)
+        {
+            load->_job = scheduler->submit(decodeAsyncLoad, load);
+            return false;
+        }
+
+        // Without worker threads decode right away.
+        decodeAsyncLoad(load);
+    }
+
+    if (load->_job)
+    {
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        GP_ASSERT(scheduler);
+        if (!scheduler->isFinished(load->_job))
+            return false;
+
+        scheduler->release(load->_job);
+        load->_job = NULL;
+    }
+
+    if (load->_decodeFailed)
+    {
+        load->_state = AsyncLoad::FAILED;
+        return true;
+    }
+
+    if (load->_bundle == NULL)
+    {
+        // The decoded file replaces the file stream of a regular bundle.
+        Bundle* bundle = new Bundle(load->_path.c_str());
+        bundle->_version[0] = load->_version[0];
+        bundle->_version[1] = load->_version[1];
+        bundle->_referenceCount = load->_referenceCount;
+        bundle->_references = load->_references;
+        bundle->_stream = load->_stream;
+        bundle->_inMemory = true;
+        bundle->buildReferenceIndices();
+        load->_references = NULL;
+        load->_referenceCount = 0;
+        load->_stream = NULL;
+        load->_bundle = bundle;
+    }
+    Bundle* bundle = load->_bundle;
+
+    // Create the GL buffers of the decoded meshes, at least one per frame.
+    while (load->_meshIndex < load->_meshData.size())
+    {
+        std::pair<std::string, MeshData*>& entry = load->_meshData[load->_meshIndex++];
+        Mesh* mesh = bundle->createMesh(entry.second, entry.first.c_str());
+        SAFE_DELETE(entry.second);
+        if (mesh)
+        {
+            SAFE_RELEASE(bundle->_preparedMeshes[entry.first]);
+            bundle->_preparedMeshes[entry.first] = mesh;
+        }
+
+        if (load->_meshIndex < load->_meshData.size() && Game::getAbsoluteTime() >= endTime)
+            return false;
+    }
+
+    // Build the requested object, which picks up the prepared meshes.
+    switch (load->_type)
+    {
+    case BUNDLE_TYPE_SCENE:
+        load->_scene = bundle->loadScene(load->_id.empty() ? NULL : load->_id.c_str());
+        break;
+    case BUNDLE_TYPE_NODE:
+        load->_node = bundle->loadNode(load->_id.c_str());
+        break;
+    case BUNDLE_TYPE_MESH:
+        load->_mesh = bundle->loadMesh(load->_id.c_str());
+        break;
+    }
+
+    for (std::map<std::string, Mesh*>::iterator itr = bundle->_preparedMeshes.begin(); itr != bundle->_preparedMeshes.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    bundle->_preparedMeshes.clear();
+
+    load->_state = (load->_scene || load->_node || load->_mesh) ? AsyncLoad::COMPLETE : AsyncLoad::FAILED;
+    return true;
+}
+
+void Bundle::updateAsyncLoads()
+{
+    GP_PROFILE_SCOPE("Bundle::updateAsyncLoads");
+
+    if (__asyncLoads.empty())
+        return;
+
+    // Every load makes progress each frame, even once the budget is used up.
+    double endTime = Game::getAbsoluteTime() + __asyncLoadTimeBudget;
+    for (size_t i = 0; i < __asyncLoads.size();)
+    {
+        AsyncLoad* load = __asyncLoads[i];
+        if (updateAsyncLoad(load, endTime))
+        {
+            // Callbacks may start new loads, so remove this one first.
+            __asyncLoads.erase(__asyncLoads.begin() + i);
+            if (load->_callback)
+            {
+                load->_callback(load, load->_cookie);
+            }
+            SAFE_RELEASE(load);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void Bundle::finalizeAsyncLoads()
+{
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = __asyncLoads.size(); i < count; ++i)
+    {
+        AsyncLoad* load = __asyncLoads[i];
+        SAFE_RELEASE(load->_read);
+        if (load->_job)
+        {
+            GP_ASSERT(scheduler);
+            scheduler->wait(load->_job);
+            scheduler->release(load->_job);
+            load->_job = NULL;
+        }
+        load->_state = AsyncLoad::FAILED;
+        SAFE_RELEASE(load);
+    }
+    __asyncLoads.clear();
+}
+
+Bundle::AsyncLoad::AsyncLoad()
+    : _type(0), _callback(NULL), _cookie(NULL), _state(LOADING), _read(NULL), _job(NULL), _decodeFailed(false), _stream(NULL),
+    _references(NULL), _referenceCount(0), _meshIndex(0), _bundle(NULL), _scene(NULL), _node(NULL), _mesh(NULL)
+{
+    memset(_version, 0, sizeof(_version));
+}
+
+Bundle::AsyncLoad::~AsyncLoad()
+{
+    for (size_t i = 0, count = _meshData.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_meshData[i].second);
+    }
+    SAFE_RELEASE(_read);
+    SAFE_DELETE(_stream);
+    SAFE_DELETE_ARRAY(_references);
+    SAFE_RELEASE(_scene);
+    SAFE_RELEASE(_node);
+    SAFE_RELEASE(_mesh);
+    SAFE_RELEASE(_bundle);
+}
+
+Bundle::AsyncLoad::State Bundle::AsyncLoad::getState() const
+{
+    return _state;
+}
+
+float Bundle::AsyncLoad::getProgress() const
+{
+    if (_state != LOADING)
+        return 1.0f;
+
+    // Decoding counts as the first half, creating the meshes as the second.
+    if (_read || _job || _bundle == NULL)
+        return 0.0f;
+    return _meshData.empty() ? 0.5f : 0.5f + 0.5f * (float)_meshIndex / (float)_meshData.size();
+}
+
+const char* Bundle::AsyncLoad::getPath() const
+{
+    return _path.c_str();
+}
+
+const char* Bundle::AsyncLoad::getId() const
+{
+    return _id.c_str();
+}
+
+Scene* Bundle::AsyncLoad::getScene() const
+{
+    return _scene;
+}
+
+Node* Bundle::AsyncLoad::getNode() const
+{
+    return _node;
+}
+
+Mesh* Bundle::AsyncLoad::getMesh() const
+{
+    return _mesh;
 }
 
 Bundle::Reference::Reference()
@@ -1775,23 +3074,28 @@ Bundle::Reference::~Reference()
 }
 
 Bundle::MeshPartData::MeshPartData() :
-    indexCount(0), indexData(NULL)
+    indexCount(0), indexData(NULL), ownsData(true)
 {
 }
 
 Bundle::MeshPartData::~MeshPartData()
 {
-    SAFE_DELETE_ARRAY(indexData);
+    if (ownsData)
+        SAFE_DELETE_ARRAY(indexData);
 }
 
 Bundle::MeshData::MeshData(const VertexFormat& vertexFormat)
-    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL)
+    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), ownsData(true),
+      hasPositionDecode(false), positionScale(Vector3::one()),
+      bvhPlatform(0), bvhVersion(0), bvhSize(0), bvhData(NULL)
 {
 }
 
 Bundle::MeshData::~MeshData()
 {
-    SAFE_DELETE_ARRAY(vertexData);
+    if (ownsData)
+        SAFE_DELETE_ARRAY(vertexData);
+    SAFE_DELETE_ARRAY(bvhData);
 
     for (unsigned int i = 0; i < parts.size(); ++i)
     {
@@ -5,21 +5,38 @@
 #include "Font.h"
 #include "Node.h"
 #include "Game.h"
+#include "FileSystem.h"
 
 namespace gameplay
 {
 
+class VertexAnimation;
+class NavigationMesh;
+
 /**
  * Represents a gameplay bundle file (.gpb) that contains a
  * collection of binary game assets that can be loaded.
  */
 class Bundle : public Ref
 {
+    friend class Animation;
     friend class PhysicsController;
     friend class SceneLoader;
+    friend class StaticBatcher;
+    friend class Game;
 
 public:
 
+    class AsyncLoad;
+
+    /**
+     * Defines the callback fired on the main thread when an asynchronous load finishes.
+     *
+     * @param load The finished load. Its state is COMPLETE or FAILED.
+     * @param cookie The user data passed when the load was started.
+     */
+    typedef void (*AsyncLoadCallback)(AsyncLoad* load, void* cookie);
+
     /**
      * Returns a Bundle for the given resource path.
      *
@@ -74,6 +91,28 @@ public:
      */
     Font* loadFont(const char* id);
 
+    /**
+     * Loads the vertex animation baked for a skinned mesh of the bundle.
+     *
+     * @param id The ID of the skinned mesh the animation was baked from.
+     *
+     * @return The loaded vertex animation, or NULL if it could not be loaded.
+     * @see VertexAnimation
+     * @script{ignore}
+     */
+    VertexAnimation* loadVertexAnimation(const char* id);
+
+    /**
+     * Loads the navigation mesh of the bundle.
+     *
+     * @param id The ID of the navigation mesh, "navmesh" for the navigation mesh baked by the encoder.
+     *
+     * @return The loaded navigation mesh, or NULL if it could not be loaded.
+     * @see NavigationMesh
+     * @script{ignore}
+     */
+    NavigationMesh* loadNavigationMesh(const char* id);
+
     /**
      * Determines if this bundle contains a top-level object with the given ID.
      *
@@ -97,6 +136,66 @@ public:
      */
     const char* getObjectId(unsigned int index) const;
 
+    /**
+     * Starts loading the scene with the specified ID from a bundle file without blocking.
+     *
+     * The file is read by the I/O threads of FileSystem::readAsync and its mesh data
+     * decoded on a worker thread. The vertex and
+     * index buffers are then created on the main thread during Game::frame, within
+     * the time budget set by setAsyncLoadTimeBudget each frame, after which the scene
+     * is built and the callback is fired.
+     *
+     * The returned load must be released when no longer needed; releasing it before
+     * it finishes does not cancel it.
+     *
+     * @param path The path of the bundle file.
+     * @param id The ID of the scene to load (NULL to load the first scene).
+     * @param callback The function called on the main thread when the load finishes, or NULL.
+     * @param cookie User data passed to the callback.
+     *
+     * @return The asynchronous load.
+     * @script{ignore}
+     */
+    static AsyncLoad* loadSceneAsync(const char* path, const char* id = NULL, AsyncLoadCallback callback = NULL, void* cookie = NULL);
+
+    /**
+     * Starts loading the node with the specified ID from a bundle file without blocking.
+     *
+     * @param path The path of the bundle file.
+     * @param id The ID of the node to load.
+     * @param callback The function called on the main thread when the load finishes, or NULL.
+     * @param cookie User data passed to the callback.
+     *
+     * @return The asynchronous load.
+     * @see loadSceneAsync
+     * @script{ignore}
+     */
+    static AsyncLoad* loadNodeAsync(const char* path, const char* id, AsyncLoadCallback callback = NULL, void* cookie = NULL);
+
+    /**
+     * Starts loading the mesh with the specified ID from a bundle file without blocking.
+     *
+     * @param path The path of the bundle file.
+     * @param id The ID of the mesh to load.
+     * @param callback The function called on the main thread when the load finishes, or NULL.
+     * @param cookie User data passed to the callback.
+     *
+     * @return The asynchronous load.
+     * @see loadSceneAsync
+     * @script{ignore}
+     */
+    static AsyncLoad* loadMeshAsync(const char* path, const char* id, AsyncLoadCallback callback = NULL, void* cookie = NULL);
+
+    /**
+     * Sets the time the main thread may spend per frame on asynchronous loads.
+     *
+     * The budget is shared by all loads in progress. At least one step of each
+     * load is performed per frame, so huge meshes may exceed the budget.
+     *
+     * @param milliseconds The time budget per frame (4 by default).
+     */
+    static void setAsyncLoadTimeBudget(float milliseconds);
+
 private:
 
     class Reference
@@ -133,6 +232,7 @@ private:
         Mesh::IndexFormat indexFormat;
         unsigned int indexCount;
         unsigned char* indexData;
+        bool ownsData;              // false if indexData points into the bundle's stream.
     };
 
     struct MeshData
@@ -147,6 +247,14 @@ private:
         BoundingSphere boundingSphere;
         Mesh::PrimitiveType primitiveType;
         std::vector<MeshPartData*> parts;
+        bool ownsData;              // false if vertexData points into the bundle's stream.
+        bool hasPositionDecode;     // true if positions are quantized; see Mesh::getPositionDecode.
+        Vector3 positionOffset;
+        Vector3 positionScale;
+        unsigned int bvhPlatform;   // Platform the baked collision hierarchy was built for.
+        unsigned int bvhVersion;    // Bullet version the baked collision hierarchy was built with.
+        unsigned int bvhSize;
+        unsigned char* bvhData;     // Baked collision hierarchy, or NULL if the mesh has none.
     };
 
     Bundle(const char* path);
@@ -166,6 +274,20 @@ private:
      */
     Reference* find(const char* id) const;
 
+    /**
+     * Reads the reference table and builds its indices, if they have not been read yet.
+     *
+     * The table is read on first use rather than when the bundle is opened.
+     *
+     * @return True if the reference table is available, false if it could not be read.
+     */
+    bool loadReferences() const;
+
+    /**
+     * Builds the hash indices of the reference table by ID and by offset.
+     */
+    void buildReferenceIndices() const;
+
     /**
      * Resets any load session specific state for the bundle.
      */
@@ -346,6 +468,14 @@ private:
      */
     Model* readModel(const char* nodeId);
 
+    /**
+     * Reads the name of the lightmap baked for a node from the current file position and
+     * sets the lightmap on the node's model.
+     *
+     * @param node The node, or NULL to skip the lightmap.
+     */
+    void readLightmap(Node* node);
+
     /**
      * Reads mesh data from the current file position.
      */
@@ -356,7 +486,8 @@ private:
      *
      * The specified URL should be formatted as 'bundle#id', where
      * 'bundle' is the bundle file containing the mesh and 'id' is the ID
-     * of the mesh to read data for.
+     * of the mesh to read data for. The collision hierarchy baked for
+     * the mesh by the encoder is also read, if the bundle contains one.
      *
      * @param url The URL to read mesh data from.
      *
@@ -375,8 +506,9 @@ private:
      * Reads an animation from the current file position.
      * 
      * @param scene The scene to load the animations into.
+     * @param paged true to only read the targets and durations of the channels.
      */
-    void readAnimation(Scene* scene);
+    void readAnimation(Scene* scene, bool paged);
 
     /**
      * Reads an "animations" object from the current file position and all of the animations contained in it.
@@ -391,10 +523,11 @@ private:
      * @param scene The scene that the animation is in.
      * @param animation The animation to the load channel into.
      * @param animationId The ID of the animation that this channel is loaded into.
+     * @param paged true to only read the target and duration of the channel.
      * 
      * @return The animation that the channel was loaded into.
      */
-    Animation* readAnimationChannel(Scene* scene, Animation* animation, const char* animationId);
+    Animation* readAnimationChannel(Scene* scene, Animation* animation, const char* animationId, bool paged);
 
     /**
      * Reads the animation channel data at the current file position into the given animation
@@ -406,10 +539,34 @@ private:
      * @param id The ID of the animation that this channel is loaded into.
      * @param target The animation target.
      * @param targetAttribute The target attribute being animated.
+     * @param paged The channel of a paged animation to load the curve of, or NULL to create a new channel.
      * 
      * @return The animation that the channel was loaded into.
      */
-    Animation* readAnimationChannelData(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute);
+    Animation* readAnimationChannelData(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute, Animation::Channel* paged = NULL);
+
+    /**
+     * Reads the key times, values and interpolations of an animation channel, which follow
+     * its key data size in the bundle or come from the decompressed key data.
+     */
+    Animation* readAnimationChannelKeys(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute, Animation::Channel* paged);
+
+    /**
+     * Reads the duration of an animation channel at the current file position and skips its key data,
+     * creating a channel of a paged animation that remembers where the key data is.
+     *
+     * @return The animation that the channel was added to.
+     */
+    Animation* readPagedAnimationChannel(Animation* animation, const char* id, AnimationTarget* target, unsigned int targetAttribute);
+
+    /**
+     * Reads the curves of the channels of a paged animation from the bundle.
+     *
+     * @param animation The paged animation.
+     *
+     * @return true if the curves of all channels were read.
+     */
+    bool loadAnimation(Animation* animation);
 
     /**
      * Sets the transformation matrix.
@@ -433,14 +590,245 @@ private:
      */
     bool skipNode();
 
+    /**
+     * Reads and validates the GPB header and the size of the reference table.
+     *
+     * Leaves the stream at the first entry of the reference table.
+     *
+     * @param stream The stream to read from.
+     * @param path The path of the bundle, used in error messages.
+     * @param version Receives the major and minor version of the bundle.
+     * @param referenceCount Receives the number of references.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    static bool readHeader(Stream* stream, const char* path, unsigned char* version, unsigned int* referenceCount);
+
+    /**
+     * Reads the entries of the reference table from the current position of the given stream.
+     *
+     * @param stream The stream to read from.
+     * @param path The path of the bundle, used in error messages.
+     * @param referenceCount The number of references.
+     * @param references Receives the reference table.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    static bool readReferences(Stream* stream, const char* path, unsigned int referenceCount, Reference** references);
+
+    /**
+     * Reads mesh data from the current position of the given stream.
+     *
+     * Does not touch any GL state, so it can be called from a worker thread.
+     *
+     * @param stream The stream to read from.
+     * @param inPlace true to point the vertex and index data into the stream when its
+     *      contents are directly accessible, instead of copying them. The mesh data
+     *      must then not outlive the stream.
+     * @param minorVersion The minor version of the bundle being read.
+     */
+    static MeshData* readMeshData(Stream* stream, bool inPlace, unsigned char minorVersion);
+
+    /**
+     * Reads and decompresses a section of the bundle that the encoder compressed.
+     *
+     * Since version 1.6 the vertex data, index data and animation keys of a bundle are preceded
+     * by the size they are stored with, which is 0 when they are stored as is. Compressed sections
+     * hold their decompressed size followed by zlib blocks that each decompress on their own.
+     * Does not touch any GL state, so it can be called from a worker thread.
+     *
+     * @param stream The stream to read from, positioned after the stored size.
+     * @param storedSize The stored size of the section.
+     * @param size Set to the decompressed size of the section, or of its first blocks when limited.
+     * @param limit Only the blocks holding the first limit bytes are decompressed, in which case the
+     *      stream is left within the section.
+     *
+     * @return The decompressed data, to be deleted with delete[], or NULL if the section is invalid.
+     */
+    static unsigned char* readCompressedSection(Stream* stream, unsigned int storedSize, unsigned int* size, unsigned int limit = 0xFFFFFFFF);
+
+    /**
+     * Reads the baked collision hierarchy of a mesh into its mesh data.
+     *
+     * @param id The ID of the mesh.
+     * @param meshData The mesh data to store the hierarchy in.
+     */
+    void readMeshBvhData(const char* id, MeshData* meshData);
+
+    /**
+     * Loads the levels of detail of a mesh and adds them to a model.
+     *
+     * @param id The ID of the mesh.
+     * @param model The model drawing the mesh.
+     */
+    void readMeshLods(const char* id, Model* model);
+
+    /**
+     * Creates a mesh and its vertex and index buffers from mesh data.
+     */
+    Mesh* createMesh(MeshData* meshData, const char* id);
+
+    /**
+     * Starts an asynchronous load of the object with the given bundle type.
+     */
+    static AsyncLoad* loadAsync(unsigned int type, const char* path, const char* id, AsyncLoadCallback callback, void* cookie);
+
+    /**
+     * Decodes the mesh data of a bundle file that has been read. Runs on a worker thread.
+     */
+    static void decodeAsyncLoad(void* cookie);
+
+    /**
+     * Performs the main thread steps of an asynchronous load until the given time.
+     *
+     * @return True if the load has finished, false otherwise.
+     */
+    static bool updateAsyncLoad(AsyncLoad* load, double endTime);
+
+    /**
+     * Performs the main thread steps of all asynchronous loads. Called by Game once per frame.
+     */
+    static void updateAsyncLoads();
+
+    /**
+     * Waits for the worker steps of all asynchronous loads and discards them. Called by Game on shutdown.
+     */
+    static void finalizeAsyncLoads();
+
     std::string _path;
     std::string _materialPath;
+    unsigned char _version[2];
     unsigned int _referenceCount;
-    Reference* _references;
+    mutable Reference* _references;
+    long _referenceTableOffset;                         // Offset of the reference table, which is read on first use.
+    mutable std::vector<unsigned int> _idIndex;         // Open addressing table of reference index + 1 by ID hash.
+    mutable std::vector<unsigned int> _offsetIndex;     // Open addressing table of reference index + 1 by offset.
     Stream* _stream;
+    bool _inMemory;                                     // Whether the whole file is held in memory, as for asynchronous loads.
 
     std::vector<MeshSkinData*> _meshSkins;
     std::map<std::string, Node*>* _trackedNodes;
+    std::map<std::string, Mesh*> _preparedMeshes;
+};
+
+/**
+ * Defines an asynchronous load started by Bundle::loadSceneAsync,
+ * Bundle::loadNodeAsync or Bundle::loadMeshAsync.
+ *
+ * @script{ignore}
+ */
+class Bundle::AsyncLoad : public Ref
+{
+    friend class Bundle;
+
+public:
+
+    /**
+     * Defines the states of a load.
+     */
+    enum State
+    {
+        LOADING,
+        COMPLETE,
+        FAILED
+    };
+
+    /**
+     * Gets the state of the load.
+     *
+     * @return The state of the load.
+     */
+    State getState() const;
+
+    /**
+     * Gets the fraction of the load that is done.
+     *
+     * @return The progress, between 0 and 1.
+     */
+    float getProgress() const;
+
+    /**
+     * Gets the path of the bundle file being loaded.
+     *
+     * @return The path of the bundle.
+     */
+    const char* getPath() const;
+
+    /**
+     * Gets the ID of the object being loaded.
+     *
+     * @return The ID of the object, or an empty string for the first scene of the bundle.
+     */
+    const char* getId() const;
+
+    /**
+     * Gets the loaded scene.
+     *
+     * The scene is owned by the load; call addRef() on it to keep it after releasing the load.
+     *
+     * @return The loaded scene, or NULL if the load is not a completed scene load.
+     */
+    Scene* getScene() const;
+
+    /**
+     * Gets the loaded node.
+     *
+     * The node is owned by the load; call addRef() on it to keep it after releasing the load.
+     *
+     * @return The loaded node, or NULL if the load is not a completed node load.
+     */
+    Node* getNode() const;
+
+    /**
+     * Gets the loaded mesh.
+     *
+     * The mesh is owned by the load; call addRef() on it to keep it after releasing the load.
+     *
+     * @return The loaded mesh, or NULL if the load is not a completed mesh load.
+     */
+    Mesh* getMesh() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    AsyncLoad();
+
+    /**
+     * Destructor.
+     */
+    ~AsyncLoad();
+
+    /**
+     * Hidden copy constructor.
+     */
+    AsyncLoad(const AsyncLoad& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    AsyncLoad& operator=(const AsyncLoad&);
+
+    unsigned int _type;
+    std::string _path;
+    std::string _id;
+    AsyncLoadCallback _callback;
+    void* _cookie;
+    State _state;
+    FileSystem::AsyncRead* _read;
+    JobScheduler::Job* _job;
+    bool _decodeFailed;
+    Stream* _stream;
+    unsigned char _version[2];
+    Reference* _references;
+    unsigned int _referenceCount;
+    std::vector<std::pair<std::string, MeshData*> > _meshData;
+    unsigned int _meshIndex;
+    Bundle* _bundle;
+    Scene* _scene;
+    Node* _node;
+    Mesh* _mesh;
 };
 
 }
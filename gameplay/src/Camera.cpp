@@ -20,15 +20,18 @@
 namespace gameplay
 {
 
+// The last version given to a camera; versions are unique across all cameras.
+static unsigned int __cameraVersion = 0;
+
 Camera::Camera(float fieldOfView, float aspectRatio, float nearPlane, float farPlane)
     : _type(PERSPECTIVE), _fieldOfView(fieldOfView), _aspectRatio(aspectRatio), _nearPlane(nearPlane), _farPlane(farPlane),
-      _bits(CAMERA_DIRTY_ALL), _node(NULL)
+      _bits(CAMERA_DIRTY_ALL), _version(++__cameraVersion), _node(NULL)
 {
 }
 
 Camera::Camera(float zoomX, float zoomY, float aspectRatio, float nearPlane, float farPlane)
     : _type(ORTHOGRAPHIC), _aspectRatio(aspectRatio), _nearPlane(nearPlane), _farPlane(farPlane),
-      _bits(CAMERA_DIRTY_ALL), _node(NULL)
+      _bits(CAMERA_DIRTY_ALL), _version(++__cameraVersion), _node(NULL)
 {
     // Orthographic camera.
     _zoom[0] = zoomX;
@@ -134,7 +137,7 @@ void Camera::setFieldOfView(float fieldOfView)
     GP_ASSERT(_type == Camera::PERSPECTIVE);
 
     _fieldOfView = fieldOfView;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 float Camera::getZoomX() const
@@ -149,7 +152,7 @@ void Camera::setZoomX(float zoomX)
     GP_ASSERT(_type == Camera::ORTHOGRAPHIC);
 
     _zoom[0] = zoomX;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 float Camera::getZoomY() const
@@ -164,7 +167,7 @@ void Camera::setZoomY(float zoomY)
     GP_ASSERT(_type == Camera::ORTHOGRAPHIC);
 
     _zoom[1] = zoomY;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 float Camera::getAspectRatio() const
@@ -175,7 +178,7 @@ float Camera::getAspectRatio() const
 void Camera::setAspectRatio(float aspectRatio)
 {
     _aspectRatio = aspectRatio;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 float Camera::getNearPlane() const
@@ -186,7 +189,7 @@ float Camera::getNearPlane() const
 void Camera::setNearPlane(float nearPlane)
 {
     _nearPlane = nearPlane;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 float Camera::getFarPlane() const
@@ -197,7 +200,7 @@ float Camera::getFarPlane() const
 void Camera::setFarPlane(float farPlane)
 {
     _farPlane = farPlane;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 Node* Camera::getNode() const
@@ -219,10 +222,10 @@ void Camera::setNode(Node* node)
 
         if (_node)
         {
-            _node->addListener(this);
+            _node->addListener(this, 0, false);
         }
 
-        _bits |= CAMERA_DIRTY_VIEW | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+        setDirty(CAMERA_DIRTY_VIEW | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
     }
 }
 
@@ -281,7 +284,7 @@ void Camera::setProjectionMatrix(const Matrix& matrix)
 {
     _projection = matrix;
     _bits |= CAMERA_CUSTOM_PROJECTION;
-    _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 void Camera::resetProjectionMatrix()
@@ -289,7 +292,7 @@ void Camera::resetProjectionMatrix()
     if (_bits & CAMERA_CUSTOM_PROJECTION)
     {
         _bits &= ~CAMERA_CUSTOM_PROJECTION;
-        _bits |= CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+        setDirty(CAMERA_DIRTY_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
     }
 }
 
@@ -324,12 +327,55 @@ const Frustum& Camera::getFrustum() const
         // Update our bounding frustum from our view projection matrix.
         _bounds.set(getViewProjectionMatrix());
 
+        const Plane* planes[6] = { &_bounds.getNear(), &_bounds.getFar(), &_bounds.getLeft(), &_bounds.getRight(), &_bounds.getBottom(), &_bounds.getTop() };
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            const Vector3& normal = planes[i]->getNormal();
+            _planes.normalX[i] = normal.x;
+            _planes.normalY[i] = normal.y;
+            _planes.normalZ[i] = normal.z;
+            _planes.distance[i] = planes[i]->getDistance();
+        }
+
         _bits &= ~CAMERA_DIRTY_BOUNDS;
     }
 
     return _bounds;
 }
 
+const Camera::FrustumPlanes& Camera::getFrustumPlanes() const
+{
+    getFrustum();
+    return _planes;
+}
+
+unsigned int Camera::getVersion() const
+{
+    return _version;
+}
+
+void Camera::setDirty(int bits)
+{
+    _bits |= bits;
+
+    // Versions skip zero so that zero can stand for no camera.
+    _version = ++__cameraVersion;
+    if (_version == 0)
+        _version = ++__cameraVersion;
+}
+
+bool Camera::FrustumPlanes::intersects(const BoundingSphere& sphere) const
+{
+    // The sphere is outside if its center is further than its radius behind any plane.
+    bool inside = true;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        float d = normalX[i] * sphere.center.x + normalY[i] * sphere.center.y + normalZ[i] * sphere.center.z + distance[i];
+        inside &= d >= -sphere.radius;
+    }
+    return inside;
+}
+
 void Camera::project(const Rectangle& viewport, const Vector3& position, float* x, float* y, float* depth) const
 {
     GP_ASSERT(x);
@@ -439,7 +485,7 @@ Camera* Camera::clone(NodeCloneContext &context) const
 
 void Camera::transformChanged(Transform* transform, long cookie)
 {
-    _bits |= CAMERA_DIRTY_VIEW | CAMERA_DIRTY_INV_VIEW | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_BOUNDS;
+    setDirty(CAMERA_DIRTY_VIEW | CAMERA_DIRTY_INV_VIEW | CAMERA_DIRTY_INV_VIEW_PROJ | CAMERA_DIRTY_VIEW_PROJ | CAMERA_DIRTY_BOUNDS);
 }
 
 }
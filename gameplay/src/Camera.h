@@ -4,6 +4,7 @@
 #include "Ref.h"
 #include "Transform.h"
 #include "Frustum.h"
+#include "BoundingSphere.h"
 #include "Rectangle.h"
 #include "Properties.h"
 
@@ -22,6 +23,49 @@ class Camera : public Ref, public Transform::Listener
 
 public:
 
+    /**
+     * Defines the six planes of the view frustum, with each plane component stored in its own array.
+     *
+     * The planes are in the order near, far, left, right, bottom and top, and their normals
+     * point into the frustum. Keeping the components apart lets culling code test a bounding
+     * volume against all the planes with a few vector operations.
+     *
+     * @script{ignore}
+     */
+    struct FrustumPlanes
+    {
+        /**
+         * The x components of the plane normals.
+         */
+        float normalX[6];
+
+        /**
+         * The y components of the plane normals.
+         */
+        float normalY[6];
+
+        /**
+         * The z components of the plane normals.
+         */
+        float normalZ[6];
+
+        /**
+         * The distances of the planes from the origin along their normals.
+         */
+        float distance[6];
+
+        /**
+         * Tests whether a sphere is at least partly inside the frustum.
+         *
+         * This gives the same result as BoundingSphere::intersects(const Frustum&).
+         *
+         * @param sphere The sphere to test.
+         *
+         * @return True if the sphere intersects the frustum or is inside it.
+         */
+        bool intersects(const BoundingSphere& sphere) const;
+    };
+
     /**
      * The type of camera.
      */
@@ -232,6 +276,29 @@ public:
      */
     const Frustum& getFrustum() const;
 
+    /**
+     * Gets the planes of the view bounding frustum, laid out for fast culling.
+     *
+     * The planes are computed along with the frustum and are cached until the view or
+     * the projection of the camera changes.
+     *
+     * @return The planes of the view frustum.
+     * @script{ignore}
+     */
+    const FrustumPlanes& getFrustumPlanes() const;
+
+    /**
+     * Gets the version of the camera's view and projection.
+     *
+     * The version changes each time the view or the projection of the camera changes,
+     * and no two cameras share a version, so values computed from the matrices of a
+     * camera can be cached under its version. The version is never zero.
+     *
+     * @return The version of the camera.
+     * @script{ignore}
+     */
+    unsigned int getVersion() const;
+
     /**
      * Projects the specified world position into the viewport coordinates.
      *
@@ -327,6 +394,11 @@ private:
      */
     void setNode(Node* node);
 
+    /**
+     * Marks cached matrices dirty and gives the camera a new version.
+     */
+    void setDirty(int bits);
+
     Camera::Type _type;
     float _fieldOfView;
     float _zoom[2];
@@ -339,7 +411,9 @@ private:
     mutable Matrix _inverseView;
     mutable Matrix _inverseViewProjection;
     mutable Frustum _bounds;
+    mutable FrustumPlanes _planes;
     mutable int _bits;
+    unsigned int _version;
     Node* _node;
 };
 
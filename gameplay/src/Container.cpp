@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "Container.h"
+#include "StateCache.h"
 #include "Layout.h"
 #include "AbsoluteLayout.h"
 #include "FlowLayout.h"
@@ -29,6 +30,10 @@ static const float JOYSTICK_THRESHOLD = 0.75f;
 static const float GAMEPAD_SCROLL_SPEED = 500.0f;
 // If the DPad or joystick is held down, this is the initial delay in milliseconds between focus change events.
 static const float FOCUS_CHANGE_REPEAT_DELAY = 300.0f;
+// Containers with fewer controls than this test them all for pointer events instead of indexing their bounds.
+static const unsigned int HIT_INDEX_MIN_CONTROLS = 32;
+// Largest number of columns or rows of the hit-test grid.
+static const unsigned int HIT_INDEX_MAX_CELLS = 256;
 
 /**
  * Sort function for use with _controls.sort(), based on Z-Order.
@@ -54,13 +59,14 @@ Container::Container()
       _scrollingStartTimeX(0), _scrollingStartTimeY(0), _scrollingLastTime(0),
       _scrollingVelocity(Vector2::zero()), _scrollingFriction(1.0f), _scrollWheelSpeed(400.0f),
       _scrollingRight(false), _scrollingDown(false),
-      _scrollingMouseVertically(false), _scrollingMouseHorizontally(false),
+      _scrollingMouseVertically(false), _scrollingMouseHorizontally(false), _totalWidth(0), _totalHeight(0),
       _scrollBarOpacityClip(NULL), _zIndexDefault(0), _focusIndexDefault(0), _focusIndexMax(0),
       _focusPressed(0), _selectButtonDown(false),
       _lastFrameTime(0), _focusChangeRepeat(false),
       _focusChangeStartTime(0), _focusChangeRepeatDelay(FOCUS_CHANGE_REPEAT_DELAY), _focusChangeCount(0),
-      _totalWidth(0), _totalHeight(0),
-      _initializedWithScroll(false), _scrollWheelRequiresFocus(false)
+      _initializedWithScroll(false), _scrollWheelRequiresFocus(false),
+      _hitIndexEnabled(true), _hitIndexDirty(true), _hitIndexed(false), _hitIndexX(0), _hitIndexY(0),
+      _hitIndexWidth(0), _hitIndexHeight(0), _hitIndexColumns(0), _hitIndexRows(0)
 {
 	clearContacts();
 }
@@ -127,6 +133,8 @@ Container* Container::create(Theme::Style* style, Properties* properties, Theme*
         container->_scrollingFriction = properties->getFloat("scrollingFriction");
     if (properties->exists("scrollWheelSpeed"))
         container->_scrollWheelSpeed = properties->getFloat("scrollWheelSpeed");
+    if (properties->exists("hitTestIndex"))
+        container->_hitIndexEnabled = properties->getBool("hitTestIndex");
 
     container->addControls(theme, properties);
     container->_layout->update(container, container->_scrollPosition);
@@ -249,6 +257,7 @@ unsigned int Container::addControl(Control* control)
         _controls.push_back(control);
         control->addRef();
         control->_parent = this;
+        _hitIndexDirty = true;
         sortControls();
         return (unsigned int)(_controls.size() - 1);
     }
@@ -287,6 +296,7 @@ void Container::insertControl(Control* control, unsigned int index)
         _controls.insert(it, control);
         control->addRef();
         control->_parent = this;
+        _hitIndexDirty = true;
     }
 }
 
@@ -299,6 +309,7 @@ void Container::removeControl(unsigned int index)
     Control* control = *it;
     control->_parent = NULL;
     SAFE_RELEASE(control);
+    _hitIndexDirty = true;
 }
 
 void Container::removeControl(const char* id)
@@ -313,6 +324,7 @@ void Container::removeControl(const char* id)
             c->_parent = NULL;
             SAFE_RELEASE(c);
             _controls.erase(it);
+            _hitIndexDirty = true;
             return;
         }
     }
@@ -329,6 +341,7 @@ void Container::removeControl(Control* control)
             control->_parent = NULL;
             SAFE_RELEASE(control);
             _controls.erase(it);
+            _hitIndexDirty = true;
             return;
         }
     }
@@ -445,6 +458,20 @@ void Container::setScrollWheelRequiresFocus(bool required)
     _scrollWheelRequiresFocus = required;
 }
 
+bool Container::isHitTestIndexEnabled() const
+{
+    return _hitIndexEnabled;
+}
+
+void Container::setHitTestIndexEnabled(bool enabled)
+{
+    if (enabled != _hitIndexEnabled)
+    {
+        _hitIndexEnabled = enabled;
+        _hitIndexDirty = true;
+    }
+}
+
 void Container::update(const Control* container, const Vector2& offset)
 {
     // Update this container's viewport.
@@ -488,11 +515,16 @@ void Container::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needs
 {
     if (needsClear)
     {
-        GL_ASSERT( glEnable(GL_SCISSOR_TEST) );
+        // Draw what is collected before clearing under it.
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->flushBatch();
+
+        StateCache::setEnabled(GL_SCISSOR_TEST, true);
         float clearY = targetHeight - _clearBounds.y - _clearBounds.height;
-        GL_ASSERT( glScissor(_clearBounds.x, clearY, _clearBounds.width, _clearBounds.height) );
+        StateCache::setScissor(_clearBounds.x, clearY, _clearBounds.width, _clearBounds.height);
         Game::getInstance()->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0f, 0);
-        GL_ASSERT( glDisable(GL_SCISSOR_TEST) );
+        StateCache::setEnabled(GL_SCISSOR_TEST, false);
         needsClear = false;
         cleared = true;
     }
@@ -504,9 +536,7 @@ void Container::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needs
     if (!_visible)
         return;
 
-    spriteBatch->start();
-    Control::drawBorder(spriteBatch, clip);
-    spriteBatch->finish();
+    drawGeometry(spriteBatch, clip);
 
     std::vector<Control*>::const_iterator it;
     Rectangle boundsUnion = Rectangle::empty();
@@ -526,7 +556,12 @@ void Container::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needs
         // Draw scroll bars.
         Rectangle clipRegion(_viewportClipBounds);
 
-        spriteBatch->start();
+        // The scroll bars are drawn over the children.
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->prepareBatch(Theme::BATCH_SPRITES, _absoluteClipBounds);
+        else
+            spriteBatch->start();
 
         if (_scrollBarBounds.height > 0 && ((_scroll & SCROLL_VERTICAL) == SCROLL_VERTICAL))
         {
@@ -590,7 +625,8 @@ void Container::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needs
             spriteBatch->draw(bounds.x, bounds.y, bounds.width, bounds.height, rightUVs.u1, rightUVs.v1, rightUVs.u2, rightUVs.v2, rightColor, clipRegion);
         }
 
-        spriteBatch->finish();
+        if (!theme)
+            spriteBatch->finish();
 
         if (_scrollingVelocity.isZero())
         {
@@ -1406,6 +1442,7 @@ void Container::sortControls()
     if (_layout->getType() == Layout::LAYOUT_ABSOLUTE)
     {
         std::sort(_controls.begin(), _controls.end(), &sortControlsByZOrder);
+        _hitIndexDirty = true;
     }
 }
 
@@ -1676,10 +1713,38 @@ bool Container::pointerEvent(bool mouse, char evt, int x, int y, int data)
         offset = &_scrollPosition;
     }
 
-    std::vector<Control*>::const_iterator it;
-    for (it = _controls.begin(); it < _controls.end(); it++)
+    const bool positional = (evt == Touch::TOUCH_PRESS ||
+                             evt == Mouse::MOUSE_PRESS_LEFT_BUTTON ||
+                             evt == Mouse::MOUSE_PRESS_MIDDLE_BUTTON ||
+                             evt == Mouse::MOUSE_PRESS_RIGHT_BUTTON ||
+                             evt == Mouse::MOUSE_MOVE ||
+                             evt == Mouse::MOUSE_WHEEL);
+
+    // The hit-test index narrows the controls down to those under the point and those that are
+    // not in the NORMAL state. They are tested below exactly as when every control is tested.
+    if (_hitIndexDirty)
     {
-        Control* control = *it;
+        updateHitIndex();
+    }
+    const bool indexed = _hitIndexed;
+    std::vector<unsigned int> candidates;
+    if (indexed)
+    {
+        float contentX = x - xPos - (offset ? offset->x : 0.0f);
+        float contentY = y - yPos - (offset ? offset->y : 0.0f);
+        getHitCandidates(positional, contentX, contentY, candidates);
+    }
+    size_t engagedCount = _hitIndexEngaged.size();
+
+    size_t count = indexed ? candidates.size() : _controls.size();
+    for (size_t c = 0; c < count; ++c)
+    {
+        size_t i = indexed ? candidates[c] : c;
+        if (i >= _controls.size())
+        {
+            break;
+        }
+        Control* control = _controls[i];
         GP_ASSERT(control);
         if (!control->isEnabled() || !control->isVisible())
         {
@@ -1697,12 +1762,7 @@ bool Container::pointerEvent(bool mouse, char evt, int x, int y, int data)
 
         Control::State currentState = control->getState();
         if ((currentState != Control::NORMAL) ||
-            ((evt == Touch::TOUCH_PRESS ||
-              evt == Mouse::MOUSE_PRESS_LEFT_BUTTON ||
-              evt == Mouse::MOUSE_PRESS_MIDDLE_BUTTON ||
-              evt == Mouse::MOUSE_PRESS_RIGHT_BUTTON ||
-              evt == Mouse::MOUSE_MOVE ||
-              evt == Mouse::MOUSE_WHEEL) &&
+            (positional &&
                 x >= xPos + boundsX &&
                 x <= xPos + boundsX + bounds.width &&
                 y >= yPos + boundsY &&
@@ -1713,6 +1773,30 @@ bool Container::pointerEvent(bool mouse, char evt, int x, int y, int data)
                 eventConsumed |= control->mouseEvent((Mouse::MouseEvent)evt, x - xPos - boundsX, y - yPos - boundsY, data);
             else
                 eventConsumed |= control->touchEvent((Touch::TouchEvent)evt, x - xPos - boundsX, y - yPos - boundsY, (unsigned int)data);
+
+            // Controls may change their own state without going through setState().
+            if (indexed && control->getState() != Control::NORMAL)
+            {
+                engageHitControl((unsigned int)i);
+            }
+        }
+
+        // Controls further in the order that left the NORMAL state while the event
+        // was handled receive it too, as they would without the index.
+        if (indexed && _hitIndexEngaged.size() > engagedCount)
+        {
+            for (size_t e = engagedCount; e < _hitIndexEngaged.size(); ++e)
+            {
+                unsigned int index = _hitIndexEngaged[e];
+                if (index > i)
+                {
+                    std::vector<unsigned int>::iterator it = std::lower_bound(candidates.begin() + c + 1, candidates.end(), index);
+                    if (it == candidates.end() || *it != index)
+                        candidates.insert(it, index);
+                }
+            }
+            engagedCount = _hitIndexEngaged.size();
+            count = candidates.size();
         }
     }
 
@@ -1806,6 +1890,152 @@ bool Container::pointerEvent(bool mouse, char evt, int x, int y, int data)
     return (_consumeInputEvents | eventConsumed);
 }
 
+void Container::updateHitIndex()
+{
+    _hitIndexDirty = false;
+    _hitIndexCells.clear();
+    _hitIndexControls.clear();
+    _hitIndexEngaged.clear();
+
+    const size_t count = _controls.size();
+    _hitIndexed = _hitIndexEnabled && count >= HIT_INDEX_MIN_CONTROLS;
+    if (!_hitIndexed)
+        return;
+
+    // Bounds are grown by a pixel so that rounding never leaves a control out of a cell it touches.
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Control* control = _controls[i];
+        const Rectangle& bounds = control->getBounds();
+        minX = std::min(minX, bounds.x - 1.0f);
+        minY = std::min(minY, bounds.y - 1.0f);
+        maxX = std::max(maxX, bounds.x + bounds.width + 1.0f);
+        maxY = std::max(maxY, bounds.y + bounds.height + 1.0f);
+
+        if (control->getState() != Control::NORMAL)
+            _hitIndexEngaged.push_back((unsigned int)i);
+    }
+    _hitIndexX = minX;
+    _hitIndexY = minY;
+    _hitIndexWidth = maxX - minX;
+    _hitIndexHeight = maxY - minY;
+
+    // Size the cells for about one control each, about as wide as they are high.
+    float columns = sqrt(count * _hitIndexWidth / _hitIndexHeight);
+    _hitIndexColumns = (unsigned int)std::max(1.0f, std::min((float)HIT_INDEX_MAX_CELLS, columns + 0.5f));
+    _hitIndexRows = (unsigned int)std::max((size_t)1, std::min((size_t)HIT_INDEX_MAX_CELLS, (count + _hitIndexColumns - 1) / _hitIndexColumns));
+
+    // Count the controls of each cell, then store them in the order of the controls.
+    _hitIndexCells.assign(_hitIndexColumns * _hitIndexRows + 1, 0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Rectangle& bounds = _controls[i]->getBounds();
+            unsigned int column0, row0, column1, row1;
+            getHitCell(bounds.x - 1.0f, bounds.y - 1.0f, &column0, &row0);
+            getHitCell(bounds.x + bounds.width + 1.0f, bounds.y + bounds.height + 1.0f, &column1, &row1);
+            for (unsigned int row = row0; row <= row1; ++row)
+            {
+                for (unsigned int column = column0; column <= column1; ++column)
+                {
+                    unsigned int cell = row * _hitIndexColumns + column;
+                    if (pass == 0)
+                        ++_hitIndexCells[cell + 1];
+                    else
+                        _hitIndexControls[_hitIndexCells[cell]++] = (unsigned int)i;
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            // Make each count the start of its cell; the second pass advances them to the end of their cell.
+            for (size_t cell = 1; cell < _hitIndexCells.size(); ++cell)
+            {
+                _hitIndexCells[cell] += _hitIndexCells[cell - 1];
+            }
+            _hitIndexControls.resize(_hitIndexCells.back());
+        }
+    }
+
+    // Each cell now starts where the one before it ends.
+    for (size_t cell = _hitIndexCells.size() - 1; cell > 0; --cell)
+    {
+        _hitIndexCells[cell] = _hitIndexCells[cell - 1];
+    }
+    _hitIndexCells[0] = 0;
+}
+
+void Container::getHitCell(float x, float y, unsigned int* column, unsigned int* row) const
+{
+    GP_ASSERT(column && row);
+
+    float cellX = (x - _hitIndexX) * _hitIndexColumns / _hitIndexWidth;
+    float cellY = (y - _hitIndexY) * _hitIndexRows / _hitIndexHeight;
+    *column = cellX > 0.0f ? std::min(_hitIndexColumns - 1, (unsigned int)cellX) : 0;
+    *row = cellY > 0.0f ? std::min(_hitIndexRows - 1, (unsigned int)cellY) : 0;
+}
+
+void Container::getHitCandidates(bool positional, float x, float y, std::vector<unsigned int>& candidates)
+{
+    candidates.clear();
+    if (positional &&
+        x >= _hitIndexX && x <= _hitIndexX + _hitIndexWidth &&
+        y >= _hitIndexY && y <= _hitIndexY + _hitIndexHeight)
+    {
+        unsigned int column, row;
+        getHitCell(x, y, &column, &row);
+        unsigned int cell = row * _hitIndexColumns + column;
+        candidates.assign(_hitIndexControls.begin() + _hitIndexCells[cell], _hitIndexControls.begin() + _hitIndexCells[cell + 1]);
+    }
+
+    // Controls that went back to the NORMAL state only receive the events under them again.
+    size_t engagedCount = 0;
+    for (size_t i = 0; i < _hitIndexEngaged.size(); ++i)
+    {
+        unsigned int index = _hitIndexEngaged[i];
+        if (index < _controls.size() && _controls[index]->getState() != Control::NORMAL)
+        {
+            _hitIndexEngaged[engagedCount++] = index;
+            candidates.push_back(index);
+        }
+    }
+    _hitIndexEngaged.resize(engagedCount);
+
+    if (engagedCount > 0)
+    {
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+}
+
+void Container::engageHitControl(unsigned int index)
+{
+    if (std::find(_hitIndexEngaged.begin(), _hitIndexEngaged.end(), index) == _hitIndexEngaged.end())
+        _hitIndexEngaged.push_back(index);
+}
+
+void Container::engageHitControl(Control* control)
+{
+    // A stale index is rebuilt from the states of the controls.
+    if (!_hitIndexed || _hitIndexDirty)
+        return;
+
+    for (size_t i = 0; i < _controls.size(); ++i)
+    {
+        if (_controls[i] == control)
+        {
+            engageHitControl((unsigned int)i);
+            return;
+        }
+    }
+}
+
 Container::Scroll Container::getScroll(const char* scroll)
 {
     if (!scroll)
@@ -32,6 +32,7 @@ namespace gameplay
          scrollWheelRequiresFocus = <bool>  // Whether focus or hover state handles scroll-wheel events.
          scrollWheelSpeed = <float>         // Speed to scroll at on a scroll-wheel event.
          consumeEvents = <bool>             // Whether the container propagates input events to the Game's input event handler. Default is true.
+         hitTestIndex = <bool>              // Whether the container indexes the bounds of its controls for pointer events. Default is true.
 
          // All the nested controls within this container.
          container 
@@ -45,11 +46,13 @@ namespace gameplay
          checkBox { }
          radioButton { }
          slider { }
+         list { }
     }
  @endverbatim
  */
 class Container : public Control, TimeListener
 {
+    friend class Control;
 
 public:
 
@@ -237,6 +240,26 @@ public:
      */
     void setScrollWheelRequiresFocus(bool required);
 
+    /**
+     * Gets whether this container indexes the bounds of its controls to find the controls under a pointer.
+     *
+     * @return Whether the hit-test index is enabled.
+     */
+    bool isHitTestIndexEnabled() const;
+
+    /**
+     * Sets whether this container indexes the bounds of its controls to find the controls under a pointer.
+     *
+     * When enabled, a container with many controls sorts their bounds into a grid each time
+     * the controls are added, removed or moved, and a pointer event only tests the controls
+     * in the cell under the pointer and the controls that are not in the NORMAL state,
+     * instead of every control. Containers with few controls test them all either way.
+     * The controls receive the events in the same order in both cases. Default is true.
+     *
+     * @param enabled Whether to enable the hit-test index.
+     */
+    void setHitTestIndexEnabled(bool enabled);
+
     /**
      * @see AnimationTarget::getAnimationPropertyComponentCount
      */
@@ -291,6 +314,13 @@ protected:
      */
     static Container* create(Theme::Style* style, Properties* properties, Theme* theme);
 
+    /**
+     * Reads the scrolling properties of a container.
+     *
+     * @param properties The properties of the container.
+     */
+    void initializeScroll(Properties* properties);
+
     /**
      * Updates each control within this container,
      * and positions them according to the container's layout.
@@ -569,6 +599,16 @@ protected:
      */
     bool _scrollingMouseHorizontally;
 
+    /**
+     * The width of the scrollable content.
+     */
+    float _totalWidth;
+
+    /**
+     * The height of the scrollable content.
+     */
+    float _totalHeight;
+
 private:
 
     /**
@@ -601,6 +641,19 @@ private:
     void clearContacts();
     bool inContact();
 
+    // Sorts the bounds of the controls into the grid of the hit-test index.
+    void updateHitIndex();
+
+    // Gets the cell of the hit-test grid that holds a point of the content.
+    void getHitCell(float x, float y, unsigned int* column, unsigned int* row) const;
+
+    // Gets the indices of the controls that may handle a pointer event at a point of the content, in order.
+    void getHitCandidates(bool positional, float x, float y, std::vector<unsigned int>& candidates);
+
+    // Records that a control has left the NORMAL state, so that it receives every pointer event.
+    void engageHitControl(unsigned int index);
+    void engageHitControl(Control* control);
+
     AnimationClip* _scrollBarOpacityClip;
     int _zIndexDefault;
     int _focusIndexDefault;
@@ -616,11 +669,24 @@ private:
     unsigned int _focusChangeCount;
     Direction _direction;
 
-    float _totalWidth;
-    float _totalHeight;
     bool _contactIndices[MAX_CONTACT_INDICES];
     bool _initializedWithScroll;
     bool _scrollWheelRequiresFocus;
+
+    // The hit-test index: a grid over the bounds of the controls, with the controls of each cell
+    // stored one cell after another, and the controls that are not in the NORMAL state.
+    bool _hitIndexEnabled;
+    bool _hitIndexDirty;
+    bool _hitIndexed;
+    float _hitIndexX;
+    float _hitIndexY;
+    float _hitIndexWidth;
+    float _hitIndexHeight;
+    unsigned int _hitIndexColumns;
+    unsigned int _hitIndexRows;
+    std::vector<unsigned int> _hitIndexCells;
+    std::vector<unsigned int> _hitIndexControls;
+    std::vector<unsigned int> _hitIndexEngaged;
 };
 
 }
@@ -1,14 +1,19 @@
 #include "Base.h"
 #include "Game.h"
 #include "Control.h"
+#include "Container.h"
+#include "StateCache.h"
 
 namespace gameplay
 {
 
+unsigned int Control::_arrangeCount = 0;
+
 Control::Control()
     : _id(""), _state(Control::NORMAL), _bounds(Rectangle::empty()), _clipBounds(Rectangle::empty()), _viewportClipBounds(Rectangle::empty()),
     _clearBounds(Rectangle::empty()), _dirty(true), _consumeInputEvents(false), _alignment(ALIGN_TOP_LEFT), _isAlignmentSet(false), _autoWidth(false), _autoHeight(false), _listeners(NULL), _visible(true),
-    _zIndex(-1), _contactIndex(INVALID_CONTACT_INDEX), _focusIndex(-1), _parent(NULL), _styleOverridden(false), _skin(NULL), _previousState(NORMAL)
+    _zIndex(-1), _contactIndex(INVALID_CONTACT_INDEX), _focusIndex(-1), _parent(NULL), _cacheGeometry(true), _styleOverridden(false), _skin(NULL), _previousState(NORMAL),
+    _geometryValid(false), _geometryUnclipped(false), _geometryOpacity(0.0f), _arrangeContainer(NULL), _arrangeOpacity(0.0f)
 {
     addScriptEvent("controlEvent", "<Control>[Control::Listener::EventType]");
 }
@@ -146,6 +151,8 @@ void Control::setPosition(float x, float y)
         _bounds.x = x;
         _bounds.y = y;
         _dirty = true;
+        if (_parent)
+            _parent->_hitIndexDirty = true;
     }
 }
 
@@ -156,6 +163,8 @@ void Control::setSize(float width, float height)
         _bounds.width = width;
         _bounds.height = height;
         _dirty = true;
+        if (_parent)
+            _parent->_hitIndexDirty = true;
     }
 }
 
@@ -165,6 +174,8 @@ void Control::setWidth(float width)
     {
         _bounds.width = width;
         _dirty = true;
+        if (_parent)
+            _parent->_hitIndexDirty = true;
     }
 }
 
@@ -174,6 +185,8 @@ void Control::setHeight(float height)
     {
         _bounds.height = height;
         _dirty = true;
+        if (_parent)
+            _parent->_hitIndexDirty = true;
     }
 }
 
@@ -183,6 +196,8 @@ void Control::setBounds(const Rectangle& bounds)
     {
         _bounds.set(bounds);
         _dirty = true;
+        if (_parent)
+            _parent->_hitIndexDirty = true;
     }
 }
 
@@ -656,6 +671,10 @@ void Control::setState(State state)
         _dirty = true;
 
     _state = state;
+
+    // Controls that are not in the NORMAL state receive every pointer event of their container.
+    if (state != NORMAL && _parent)
+        _parent->engageHitControl(this);
 }
 
 Control::State Control::getState() const
@@ -1052,6 +1071,28 @@ void Control::update(const Control* container, const Vector2& offset)
     _opacity = getOpacity(_state) * container->_opacity;
 }
 
+void Control::arrange(const Control* container, const Vector2& offset)
+{
+    GP_ASSERT(container);
+
+    // Containers are dirty when any of their descendants is, so an unchanged subtree is skipped entirely.
+    if (!isDirty() && container == _arrangeContainer && offset == _arrangeOffset &&
+        container->_viewportBounds == _arrangeViewport && container->_viewportClipBounds == _arrangeClip &&
+        container->_opacity == _arrangeOpacity)
+    {
+        return;
+    }
+
+    update(container, offset);
+    ++_arrangeCount;
+
+    _arrangeContainer = container;
+    _arrangeOffset = offset;
+    _arrangeViewport = container->_viewportBounds;
+    _arrangeClip = container->_viewportClipBounds;
+    _arrangeOpacity = container->_opacity;
+}
+
 void Control::drawBorder(SpriteBatch* spriteBatch, const Rectangle& clip)
 {
     if (!spriteBatch || !_skin || _bounds.width <= 0 || _bounds.height <= 0)
@@ -1125,24 +1166,88 @@ void Control::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needsCl
 {
     if (needsClear)
     {
-        GL_ASSERT( glEnable(GL_SCISSOR_TEST) );
-        GL_ASSERT( glScissor(_clearBounds.x, targetHeight - _clearBounds.y - _clearBounds.height, _clearBounds.width, _clearBounds.height) );
+        // Draw what is collected before clearing under it.
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->flushBatch();
+
+        StateCache::setEnabled(GL_SCISSOR_TEST, true);
+        StateCache::setScissor(_clearBounds.x, targetHeight - _clearBounds.y - _clearBounds.height, _clearBounds.width, _clearBounds.height);
         Game::getInstance()->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0f, 0);
-        GL_ASSERT( glDisable(GL_SCISSOR_TEST) );
+        StateCache::setEnabled(GL_SCISSOR_TEST, false);
     }
 
     if (!_visible)
         return;
 
-    spriteBatch->start();
-    drawBorder(spriteBatch, clip);
-    drawImages(spriteBatch, clip);
-    spriteBatch->finish();
-
+    drawGeometry(spriteBatch, clip);
     drawText(clip);
     _dirty = false;
 }
 
+void Control::drawGeometry(SpriteBatch* spriteBatch, const Rectangle& clip)
+{
+    GP_ASSERT(spriteBatch);
+
+    Theme* theme = getBatchTheme();
+    if (theme)
+        theme->prepareBatch(Theme::BATCH_SPRITES, _absoluteClipBounds);
+    else
+        spriteBatch->start();
+
+    if (!_cacheGeometry)
+    {
+        drawBorder(spriteBatch, clip);
+        drawImages(spriteBatch, clip);
+        _geometryOffset.set(0, 0);
+    }
+    else
+    {
+        if (!isGeometryValid(clip))
+        {
+            _geometry.clear();
+            spriteBatch->setCapture(&_geometry);
+            drawBorder(spriteBatch, clip);
+            drawImages(spriteBatch, clip);
+            spriteBatch->setCapture(NULL);
+
+            _geometryValid = true;
+            _geometryUnclipped = clip.contains(_absoluteBounds);
+            _geometryBounds = _absoluteBounds;
+            _geometryClip = clip;
+            _geometryOpacity = _opacity;
+        }
+        _geometryOffset.set(_absoluteBounds.x - _geometryBounds.x, _absoluteBounds.y - _geometryBounds.y);
+        if (!_geometry.empty())
+            spriteBatch->addSprites(&_geometry[0], (unsigned int)(_geometry.size() / 4), _geometryOffset);
+    }
+
+    if (!theme)
+        spriteBatch->finish();
+}
+
+Theme* Control::getBatchTheme() const
+{
+    Theme* theme = _style ? _style->getTheme() : NULL;
+    return theme && theme->isBatching() ? theme : NULL;
+}
+
+bool Control::isGeometryValid(const Rectangle& clip) const
+{
+    if (!_geometryValid || _dirty || _opacity != _geometryOpacity ||
+        _absoluteBounds.width != _geometryBounds.width || _absoluteBounds.height != _geometryBounds.height)
+    {
+        return false;
+    }
+
+    // Nothing has moved.
+    if (_absoluteBounds.x == _geometryBounds.x && _absoluteBounds.y == _geometryBounds.y && clip == _geometryClip)
+        return true;
+
+    // The control has moved, which does not change its sprites unless they are clipped.
+    return _geometryUnclipped && clip.contains(_absoluteBounds);
+}
+
 bool Control::isDirty()
 {
     return _dirty;
@@ -1294,6 +1399,44 @@ void Control::setAnimationPropertyValue(int propertyId, AnimationValue* value, f
         break;
     }
 }
+
+Control::AnimationPropertySetter Control::getAnimationPropertySetter(int propertyId) const
+{
+    switch (propertyId)
+    {
+    case ANIMATE_POSITION:
+        return setAnimationPosition;
+    case ANIMATE_SIZE:
+        return setAnimationSize;
+    case ANIMATE_OPACITY:
+        return setAnimationOpacity;
+    default:
+        return NULL;
+    }
+}
+
+void Control::setAnimationPosition(AnimationTarget* target, const float* value, float blendWeight)
+{
+    Control* control = static_cast<Control*>(target);
+    control->_bounds.x = Curve::lerp(blendWeight, control->_bounds.x, value[0]);
+    control->_bounds.y = Curve::lerp(blendWeight, control->_bounds.y, value[1]);
+    control->_dirty = true;
+}
+
+void Control::setAnimationSize(AnimationTarget* target, const float* value, float blendWeight)
+{
+    Control* control = static_cast<Control*>(target);
+    control->_bounds.width = Curve::lerp(blendWeight, control->_bounds.width, value[0]);
+    control->_bounds.height = Curve::lerp(blendWeight, control->_bounds.height, value[1]);
+    control->_dirty = true;
+}
+
+void Control::setAnimationOpacity(AnimationTarget* target, const float* value, float blendWeight)
+{
+    Control* control = static_cast<Control*>(target);
+    control->setOpacity(Curve::lerp(blendWeight, control->_opacity, value[0]));
+    control->_dirty = true;
+}
     
 
 Theme::Style::Overlay** Control::getOverlays(unsigned char overlayTypes, Theme::Style::Overlay** overlays)
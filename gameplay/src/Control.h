@@ -816,6 +816,11 @@ protected:
      */
     Control& operator=(const Control&);
 
+    /**
+     * @see AnimationTarget::getAnimationPropertySetter
+     */
+    virtual AnimationPropertySetter getAnimationPropertySetter(int propertyId) const;
+
     /**
      * Get the overlay type corresponding to this control's current state.
      *
@@ -883,6 +888,16 @@ protected:
      */
     virtual void update(const Control* container, const Vector2& offset);
 
+    /**
+     * Called by layouts after positioning a control. Updates the control unless it is not
+     * dirty and its container and offset are the same as on its last update, in which case
+     * nothing the update computes can have changed.
+     *
+     * @param container This control's parent container.
+     * @param offset Positioning offset to add to the control's position.
+     */
+    void arrange(const Control* container, const Vector2& offset);
+
     /**
      * Draws the themed border and background of a control.
      *
@@ -906,6 +921,30 @@ protected:
      */
     virtual void drawText(const Rectangle& clip);
 
+    /**
+     * Draws the border and images of this control with a sprite batch.
+     *
+     * The sprites generated by drawBorder and drawImages are kept and drawn again,
+     * without calling those methods, until the control becomes dirty or its size,
+     * opacity or clipping changes. When the control has only moved, for instance
+     * because its container scrolled, the kept sprites are translated to its new
+     * position, provided it was not clipped then and is not clipped now.
+     *
+     * @param spriteBatch The sprite batch to use.
+     * @param clip The clipping rectangle of this control's parent container.
+     */
+    void drawGeometry(SpriteBatch* spriteBatch, const Rectangle& clip);
+
+    /**
+     * Gets the theme of this control if its form is collecting the sprites and text of all
+     * its controls to draw them together (see Theme::startBatch).
+     *
+     * Controls then add to the batches of the theme without starting or finishing them.
+     *
+     * @return The theme collecting the form, or NULL if controls draw on their own.
+     */
+    Theme* getBatchTheme() const;
+
     /**
      * Draws a sprite batch for the specified clipping rect.
      *
@@ -1090,6 +1129,18 @@ protected:
      */
     Container* _parent;
 
+    /**
+     * Whether the sprites of the border and images can be kept between draws.
+     * This must be false for controls whose drawImages draws with another batch.
+     */
+    bool _cacheGeometry;
+
+    /**
+     * The translation of the kept sprites to the current position of the control,
+     * which is zero on the draw that generated them.
+     */
+    Vector2 _geometryOffset;
+
 private:
 
     /*
@@ -1114,10 +1165,31 @@ private:
     Theme::Skin* getSkin(State state);
 
     void addSpecificListener(Control::Listener* listener, Control::Listener::EventType eventType);
+
+    bool isGeometryValid(const Rectangle& clip) const;
+
+    static void setAnimationPosition(AnimationTarget* target, const float* value, float blendWeight);
+
+    static void setAnimationSize(AnimationTarget* target, const float* value, float blendWeight);
+
+    static void setAnimationOpacity(AnimationTarget* target, const float* value, float blendWeight);
+
+    static unsigned int _arrangeCount;
     
     bool _styleOverridden;
     Theme::Skin* _skin;
     State _previousState;
+    std::vector<SpriteBatch::SpriteVertex> _geometry;
+    bool _geometryValid;
+    bool _geometryUnclipped;
+    Rectangle _geometryBounds;
+    Rectangle _geometryClip;
+    float _geometryOpacity;
+    const Control* _arrangeContainer;
+    Vector2 _arrangeOffset;
+    Rectangle _arrangeViewport;
+    Rectangle _arrangeClip;
+    float _arrangeOpacity;
 };
 
 }
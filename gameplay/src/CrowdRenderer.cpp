@@ -0,0 +1,197 @@
+#include "Base.h"
+#include "CrowdRenderer.h"
+#include "VertexAnimation.h"
+#include "InstanceBuffer.h"
+#include "Model.h"
+#include "Material.h"
+#include "Camera.h"
+
+// Floats of an instance: its world matrix, then its first frame, frame count, speed and time offset.
+#define INSTANCE_FLOATS 20
+
+namespace gameplay
+{
+
+CrowdRenderer::CrowdRenderer()
+    : _animation(NULL), _model(NULL), _instances(NULL), _time(0.0f)
+{
+}
+
+CrowdRenderer::~CrowdRenderer()
+{
+    SAFE_RELEASE(_instances);
+    SAFE_RELEASE(_model);
+    SAFE_RELEASE(_animation);
+}
+
+CrowdRenderer* CrowdRenderer::create(VertexAnimation* animation, unsigned int capacity)
+{
+    GP_ASSERT(animation);
+
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::INSTANCE_MATRIX, 16),
+        VertexFormat::Element(VertexFormat::INSTANCE_DATA, 4)
+    };
+    InstanceBuffer* instances = InstanceBuffer::create(VertexFormat(elements, 2), capacity, true);
+    if (instances == NULL)
+    {
+        GP_ERROR("Failed to create the instance buffer of a crowd renderer.");
+        return NULL;
+    }
+
+    Model* model = Model::create(animation->getMesh());
+    Material* material = model->setMaterial("res/shaders/crowd.vert", "res/shaders/crowd.frag", "INSTANCED");
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create the material of a crowd renderer.");
+        SAFE_RELEASE(model);
+        SAFE_RELEASE(instances);
+        return NULL;
+    }
+    material->getParameter("u_ambientColor")->setValue(Vector3(0.2f, 0.2f, 0.2f));
+    material->getParameter("u_lightColor")->setValue(Vector3::one());
+    material->getParameter("u_lightDirection")->setValue(Vector3(0.0f, -1.0f, 0.0f));
+    animation->bind(material);
+
+    CrowdRenderer* crowd = new CrowdRenderer();
+    crowd->_animation = animation;
+    animation->addRef();
+    crowd->_model = model;
+    crowd->_instances = instances;
+    crowd->_crowd.reserve(capacity);
+    crowd->_visible.resize(capacity * INSTANCE_FLOATS);
+    return crowd;
+}
+
+VertexAnimation* CrowdRenderer::getVertexAnimation() const
+{
+    return _animation;
+}
+
+Material* CrowdRenderer::getMaterial() const
+{
+    return _model->getMaterial();
+}
+
+void CrowdRenderer::setMaterial(Material* material)
+{
+    GP_ASSERT(material);
+
+    _animation->bind(material);
+    _model->setMaterial(material);
+}
+
+unsigned int CrowdRenderer::getCapacity() const
+{
+    return _instances->getCapacity();
+}
+
+unsigned int CrowdRenderer::getInstanceCount() const
+{
+    return (unsigned int)_crowd.size();
+}
+
+int CrowdRenderer::addInstance(const Matrix& world, unsigned int firstFrame, unsigned int frameCount, float speed, float timeOffset)
+{
+    if (_crowd.size() >= _instances->getCapacity())
+    {
+        GP_WARN("The crowd renderer is full (%u instances).", _instances->getCapacity());
+        return -1;
+    }
+
+    _crowd.push_back(Instance());
+    unsigned int index = (unsigned int)_crowd.size() - 1;
+    setInstanceTransform(index, world);
+    setInstanceClip(index, firstFrame, frameCount, speed, timeOffset);
+    return (int)index;
+}
+
+void CrowdRenderer::setInstanceTransform(unsigned int index, const Matrix& world)
+{
+    GP_ASSERT(index < _crowd.size());
+
+    Instance& instance = _crowd[index];
+    instance.world = world;
+    instance.bounds.set(_animation->getBoundingBox());
+    instance.bounds.transform(world);
+}
+
+void CrowdRenderer::setInstanceClip(unsigned int index, unsigned int firstFrame, unsigned int frameCount, float speed, float timeOffset)
+{
+    GP_ASSERT(index < _crowd.size());
+
+    // Keep the clip within the baked frames.
+    const unsigned int totalCount = _animation->getFrameCount();
+    firstFrame = std::min(firstFrame, totalCount - 1);
+    if (frameCount == 0 || firstFrame + frameCount > totalCount)
+        frameCount = totalCount - firstFrame;
+
+    Instance& instance = _crowd[index];
+    instance.data[0] = (float)firstFrame;
+    instance.data[1] = (float)frameCount;
+    instance.data[2] = speed;
+    instance.data[3] = timeOffset;
+}
+
+void CrowdRenderer::removeInstance(unsigned int index)
+{
+    GP_ASSERT(index < _crowd.size());
+
+    _crowd[index] = _crowd.back();
+    _crowd.pop_back();
+}
+
+void CrowdRenderer::clearInstances()
+{
+    _crowd.clear();
+}
+
+float CrowdRenderer::getTime() const
+{
+    return _time;
+}
+
+void CrowdRenderer::setTime(float time)
+{
+    _time = time;
+}
+
+void CrowdRenderer::update(float elapsedTime)
+{
+    _time += elapsedTime;
+}
+
+unsigned int CrowdRenderer::draw(Camera* camera)
+{
+    GP_ASSERT(camera);
+
+    // Gather the instances in view; the frames they play are computed by the vertex shader.
+    const Frustum& frustum = camera->getFrustum();
+    unsigned int count = 0;
+    for (size_t i = 0, crowdCount = _crowd.size(); i < crowdCount; ++i)
+    {
+        const Instance& instance = _crowd[i];
+        if (!frustum.intersects(instance.bounds))
+            continue;
+        float* data = &_visible[count * INSTANCE_FLOATS];
+        memcpy(data, instance.world.m, 16 * sizeof(float));
+        memcpy(data + 16, instance.data, 4 * sizeof(float));
+        ++count;
+    }
+    _instances->setInstanceCount(count);
+    if (count == 0)
+        return 0;
+    _instances->setInstanceData(&_visible[0], 0, count);
+
+    static const unsigned int viewProjectionMatrixHandle = RenderState::getParameterHandle("u_viewProjectionMatrix");
+    static const unsigned int timeHandle = RenderState::getParameterHandle("u_time");
+    Material* material = _model->getMaterial();
+    GP_ASSERT(material);
+    material->getParameter(viewProjectionMatrixHandle)->setValue(camera->getViewProjectionMatrix());
+    material->getParameter(timeHandle)->setValue(_time);
+    _model->drawInstanced(_instances);
+    return count;
+}
+
+}
@@ -0,0 +1,199 @@
+#ifndef CROWDRENDERER_H_
+#define CROWDRENDERER_H_
+
+#include "Ref.h"
+#include "Matrix.h"
+#include "BoundingSphere.h"
+
+namespace gameplay
+{
+
+class Camera;
+class InstanceBuffer;
+class Material;
+class Model;
+class VertexAnimation;
+
+/**
+ * Defines a renderer that draws many instances of a vertex animation with one instanced draw call.
+ *
+ * Each instance has its own world matrix and plays its own range of the baked frames, the clip
+ * of the instance, at its own speed and time offset. The frames of every instance are computed
+ * by the vertex shader from the time of the renderer, so animating the crowd costs nothing on
+ * the CPU: update() only advances the time. When the crowd is drawn, the instances outside the
+ * view frustum of the camera are skipped and the others are uploaded to the instance buffer.
+ *
+ * The default material draws the instances with res/shaders/crowd.vert and crowd.frag, lit by
+ * an ambient color and a directional light. It must be given a "u_diffuseTexture" sampler, and
+ * its "u_ambientColor", "u_lightColor" and "u_lightDirection" parameters can be changed or
+ * bound to the SCENE_AMBIENT_COLOR, SCENE_LIGHT_COLOR and SCENE_LIGHT_DIRECTION auto bindings.
+ * A material set with setMaterial must use the crowd shaders or shaders with the same inputs.
+ *
+ * @script{ignore}
+ */
+class CrowdRenderer : public Ref
+{
+public:
+
+    /**
+     * Creates a crowd renderer.
+     *
+     * @param animation The vertex animation the instances play.
+     * @param capacity The maximum number of instances.
+     *
+     * @return The crowd renderer, or NULL if it could not be created.
+     */
+    static CrowdRenderer* create(VertexAnimation* animation, unsigned int capacity);
+
+    /**
+     * Gets the vertex animation the instances play.
+     *
+     * @return The vertex animation.
+     */
+    VertexAnimation* getVertexAnimation() const;
+
+    /**
+     * Gets the material the instances are drawn with.
+     *
+     * @return The material.
+     */
+    Material* getMaterial() const;
+
+    /**
+     * Sets the material the instances are drawn with.
+     *
+     * @param material The material.
+     */
+    void setMaterial(Material* material);
+
+    /**
+     * Gets the maximum number of instances.
+     *
+     * @return The capacity of the renderer.
+     */
+    unsigned int getCapacity() const;
+
+    /**
+     * Gets the number of instances.
+     *
+     * @return The instance count.
+     */
+    unsigned int getInstanceCount() const;
+
+    /**
+     * Adds an instance.
+     *
+     * @param world The world matrix of the instance.
+     * @param firstFrame The first frame of the clip the instance plays.
+     * @param frameCount The number of frames of the clip, or 0 for every frame from the first one.
+     * @param speed The speed the clip plays at.
+     * @param timeOffset The time added to the time of the renderer for the instance, in milliseconds.
+     *
+     * @return The index of the instance, or -1 if the renderer is full.
+     */
+    int addInstance(const Matrix& world, unsigned int firstFrame = 0, unsigned int frameCount = 0, float speed = 1.0f, float timeOffset = 0.0f);
+
+    /**
+     * Sets the world matrix of an instance.
+     *
+     * @param index The index of the instance.
+     * @param world The world matrix.
+     */
+    void setInstanceTransform(unsigned int index, const Matrix& world);
+
+    /**
+     * Sets the clip an instance plays.
+     *
+     * @param index The index of the instance.
+     * @param firstFrame The first frame of the clip.
+     * @param frameCount The number of frames of the clip, or 0 for every frame from the first one.
+     * @param speed The speed the clip plays at.
+     * @param timeOffset The time added to the time of the renderer for the instance, in milliseconds.
+     */
+    void setInstanceClip(unsigned int index, unsigned int firstFrame, unsigned int frameCount, float speed = 1.0f, float timeOffset = 0.0f);
+
+    /**
+     * Removes an instance. The last instance takes its index.
+     *
+     * @param index The index of the instance.
+     */
+    void removeInstance(unsigned int index);
+
+    /**
+     * Removes every instance.
+     */
+    void clearInstances();
+
+    /**
+     * Gets the time the instances are animated at.
+     *
+     * @return The time, in milliseconds.
+     */
+    float getTime() const;
+
+    /**
+     * Sets the time the instances are animated at.
+     *
+     * @param time The time, in milliseconds.
+     */
+    void setTime(float time);
+
+    /**
+     * Advances the time the instances are animated at.
+     *
+     * @param elapsedTime The time elapsed since the last update, in milliseconds.
+     */
+    void update(float elapsedTime);
+
+    /**
+     * Draws the instances in the view frustum of a camera.
+     *
+     * @param camera The camera to draw the instances with.
+     *
+     * @return The number of instances drawn.
+     */
+    unsigned int draw(Camera* camera);
+
+private:
+
+    /**
+     * An instance of the crowd.
+     */
+    struct Instance
+    {
+        Matrix world;
+        float data[4];
+        BoundingSphere bounds;
+    };
+
+    /**
+     * Constructor.
+     */
+    CrowdRenderer();
+
+    /**
+     * Destructor.
+     */
+    ~CrowdRenderer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    CrowdRenderer(const CrowdRenderer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    CrowdRenderer& operator=(const CrowdRenderer&);
+
+    VertexAnimation* _animation;
+    Model* _model;
+    InstanceBuffer* _instances;
+    std::vector<Instance> _crowd;
+    std::vector<float> _visible;
+    float _time;
+};
+
+}
+
+#endif
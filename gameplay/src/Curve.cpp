@@ -1,10 +1,7 @@
-// Purposely not including Base.h here, or any other gameplay dependencies, so it can be reused between gameplay and gameplay-encoder.
+#include "Base.h"
 #include "Curve.h"
 #include "Quaternion.h"
-#include <cassert>
-#include <cstring>
-#include <cmath>
-#include <memory>
+#include "MathUtilSIMD.h"
 
 using std::memcpy;
 using std::fabs;
@@ -14,41 +11,8 @@ using std::sin;
 using std::exp;
 using std::strcmp;
 
-#ifndef NULL
-#define NULL 0
-#endif
-
-#ifndef MATH_PI
-#define MATH_PI 3.14159265358979323846f
-#endif
-
-#ifndef MATH_PIOVER2 
-#define MATH_PIOVER2 1.57079632679489661923f
-#endif
-
-#ifndef MATH_PIX2
-#define MATH_PIX2 6.28318530717958647693f
-#endif
-
-// Object deletion macro
-#ifndef SAFE_DELETE
-#define SAFE_DELETE(x) \
-    if (x) \
-    { \
-        delete x; \
-        x = NULL; \
-    }
-#endif
-
-// Array deletion macro
-#ifndef SAFE_DELETE_ARRAY
-#define SAFE_DELETE_ARRAY(x) \
-    if (x) \
-    { \
-        delete[] x; \
-        x = NULL; \
-    }
-#endif
+// Maximum number of components of a quantized curve, which are decoded on the stack.
+#define CURVE_MAX_QUANTIZED_COMPONENTS 16
 
 static inline float bezier(float eq0, float eq1, float eq2, float eq3, float from, float out, float to, float in)
 {
@@ -80,6 +44,41 @@ static inline float lerpInl(float s, float from, float to)
     return from + (to - from) * s;
 }
 
+// Power basis coefficients of a segment, so that its value is ((a * s + b) * s + c) * s + d.
+static inline void bezierCoefficients(float from, float out, float to, float in, float* a, float* b, float* c, float* d)
+{
+    *a = -from + 3 * out - 3 * in + to;
+    *b = 3 * from - 6 * out + 3 * in;
+    *c = 3 * (out - from);
+    *d = from;
+}
+
+static inline void bsplineCoefficients(float c0, float c1, float c2, float c3, float* a, float* b, float* c, float* d)
+{
+    *a = (-c0 + 3 * c1 - 3 * c2 + c3) / 6.0f;
+    *b = (3 * c0 - 6 * c1 + 3 * c2) / 6.0f;
+    *c = (-3 * c0 + 3 * c2) / 6.0f;
+    *d = (c0 + 4 * c1 + c2) / 6.0f;
+}
+
+static inline void hermiteCoefficients(float from, float out, float to, float in, float* a, float* b, float* c, float* d)
+{
+    *a = 2 * from - 2 * to + out + in;
+    *b = -3 * from + 3 * to - 2 * out - in;
+    *c = out;
+    *d = from;
+}
+
+// Tangents of SMOOTH interpolation, from the values and times of the points around a segment.
+static inline void smoothTangents(bool first, bool last, float prev, float from, float to, float next,
+                                  float prevTime, float fromTime, float toTime, float nextTime, float* out, float* in)
+{
+    *out = first ? to - from : (to - prev) * ((fromTime - prevTime) / (toTime - prevTime));
+    *in = last ? to - from : (next - from) * ((toTime - fromTime) / (nextTime - fromTime));
+}
+
+static bool __nlerp = false;
+
 namespace gameplay
 {
 
@@ -89,7 +88,8 @@ Curve* Curve::create(unsigned int pointCount, unsigned int componentCount)
 }
 
 Curve::Curve(unsigned int pointCount, unsigned int componentCount)
-    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL)
+    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL),
+      _quantizedValues(NULL), _quantizedRanges(NULL), _coefficients(NULL)
 {
     _points = new Point[_pointCount];
     for (unsigned int i = 0; i < _pointCount; i++)
@@ -107,6 +107,9 @@ Curve::~Curve()
 {
     SAFE_DELETE_ARRAY(_points);
     SAFE_DELETE_ARRAY(_quaternionOffset);
+    SAFE_DELETE_ARRAY(_quantizedValues);
+    SAFE_DELETE_ARRAY(_quantizedRanges);
+    SAFE_DELETE_ARRAY(_coefficients);
 }
 
 Curve::Point::Point()
@@ -131,6 +134,23 @@ unsigned int Curve::getComponentCount() const
     return _componentCount;
 }
 
+unsigned int Curve::getMemorySize() const
+{
+    unsigned int size = sizeof(Curve) + sizeof(Point) * _pointCount;
+    for (unsigned int i = 0; i < _pointCount; i++)
+    {
+        if (_points[i].value)
+            size += _componentSize * 3;
+    }
+    if (_quaternionOffset)
+        size += sizeof(unsigned int);
+    if (_quantizedValues)
+        size += sizeof(unsigned short) * _pointCount * _componentCount + _componentSize * 2;
+    if (_coefficients)
+        size += sizeof(float) * (_pointCount - 1) * 4 * (_componentCount + 1);
+    return size;
+}
+
 float Curve::getStartTime() const
 {
     return _points[0].time;
@@ -149,7 +169,9 @@ void Curve::setPoint(unsigned int index, float time, float* value, Interpolation
 void Curve::setPoint(unsigned int index, float time, float* value, InterpolationType type, float* inValue, float* outValue)
 {
     assert(index < _pointCount && time >= 0.0f && time <= 1.0f && !(_pointCount > 1 && index == 0 && time != 0.0f) && !(_pointCount != 1 && index == _pointCount - 1 && time != 1.0f));
+    assert(!_quantizedValues || (!value && !inValue && !outValue));
 
+    SAFE_DELETE_ARRAY(_coefficients);
     _points[index].time = time;
     _points[index].type = type;
 
@@ -166,7 +188,9 @@ void Curve::setPoint(unsigned int index, float time, float* value, Interpolation
 void Curve::setTangent(unsigned int index, InterpolationType type, float* inValue, float* outValue)
 {
     assert(index < _pointCount);
+    assert(!_quantizedValues || (!inValue && !outValue));
 
+    SAFE_DELETE_ARRAY(_coefficients);
     _points[index].type = type;
 
     if (inValue)
@@ -184,13 +208,31 @@ void Curve::evaluate(float time, float* dst) const
 }
 
 void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const
+{
+    evaluate(time, startTime, endTime, loopBlendTime, dst, NULL);
+}
+
+void Curve::evaluate(unsigned int count, const float* times, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* hint) const
+{
+    assert(times && dst);
+
+    unsigned int index = hint ? *hint : 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        evaluate(times[i], startTime, endTime, loopBlendTime, dst + i * _componentCount, &index);
+    }
+    if (hint)
+        *hint = index;
+}
+
+void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* hint) const
 {
     assert(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
 
     // If there's only one point on the curve, return its value.
     if (_pointCount == 1)
     {
-        memcpy(dst, _points[0].value, _componentSize);
+        getPointValue(0, dst);
         return;
     }
 
@@ -219,12 +261,12 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     // If an exact endpoint was specified, skip interpolation and return the value directly
     if (localTime == _points[min].time)
     {
-        memcpy(dst, _points[min].value, _componentSize);
+        getPointValue(min, dst);
         return;
     }
     if (localTime == _points[max].time)
     {
-        memcpy(dst, _points[max].value, _componentSize);
+        getPointValue(max, dst);
         return;
     }
 
@@ -256,14 +298,21 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     }
     else
     {
-        // Locate the points we are interpolating between using a binary search.
-        index = determineIndex(localTime, min, max);
+        // Locate the points we are interpolating between, starting from the hint.
+        index = determineIndex(localTime, min, max, hint);
         from = &_points[index];
         to = &_points[index == max ? index : index+1];
 
         // Calculate the fractional time between the two points.
         scale = (to->time - from->time);
         t = (localTime - from->time) / scale;
+
+        // Finalized curves evaluate the segment as a polynomial in the eased time.
+        if (_coefficients && to == from + 1 && from->type != STEP)
+        {
+            evaluateSegment(index, ease(from->type, t), from, to, dst);
+            return;
+        }
     }
 
     // Calculate the value of the curve discretely if appropriate.
@@ -320,9 +369,34 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
         }
         case STEP:
         {
-            memcpy(dst, from->value, _componentSize);
+            getPointValue((unsigned int)(from - _points), dst);
             return;
         }
+        default:
+        {
+            // Ease the fractional time, then interpolate linearly below.
+            t = ease(from->type, t);
+            break;
+        }
+    }
+
+    if (_quantizedValues)
+    {
+        float fromValue[CURVE_MAX_QUANTIZED_COMPONENTS];
+        float toValue[CURVE_MAX_QUANTIZED_COMPONENTS];
+        getPointValue((unsigned int)(from - _points), fromValue);
+        getPointValue((unsigned int)(to - _points), toValue);
+        interpolateLinear(t, fromValue, toValue, dst);
+        return;
+    }
+
+    interpolateLinear(t, from, to, dst);
+}
+
+float Curve::ease(InterpolationType type, float t)
+{
+    switch (type)
+    {
         case QUADRATIC_IN:
         {
             t *= t;
@@ -796,9 +870,12 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
             }
             break;
         }
+        default:
+        {
+            break;
+        }
     }
-
-    interpolateLinear(t, from, to, dst);
+    return t;
 }
 
 float Curve::lerp(float t, float from, float to)
@@ -806,10 +883,148 @@ float Curve::lerp(float t, float from, float to)
     return lerpInl(t, from, to);
 }
 
+void Curve::finalize()
+{
+    SAFE_DELETE_ARRAY(_coefficients);
+    if (_quantizedValues || _pointCount < 2)
+        return;
+
+    // Each segment has rows of a, b, c and d, with one extra component for the parameter of the rotation.
+    const unsigned int stride = _componentCount + 1;
+    _coefficients = new float[(_pointCount - 1) * 4 * stride];
+    for (unsigned int index = 0; index < _pointCount - 1; index++)
+    {
+        const Point* from = &_points[index];
+        const Point* to = from + 1;
+        const Point* prev = index == 0 ? from : from - 1;
+        const Point* next = index == _pointCount - 2 ? to : to + 1;
+        bool first = (index == 0);
+        bool last = (index == _pointCount - 2);
+        float* a = _coefficients + index * 4 * stride;
+        float* b = a + stride;
+        float* c = b + stride;
+        float* d = c + stride;
+
+        for (unsigned int i = 0; i < _componentCount; i++)
+        {
+            float fromValue = from->value[i];
+            float toValue = to->value[i];
+            if (fromValue == toValue || from->type == STEP)
+            {
+                a[i] = b[i] = c[i] = 0.0f;
+                d[i] = fromValue;
+                continue;
+            }
+
+            switch (from->type)
+            {
+                case BEZIER:
+                    bezierCoefficients(fromValue, from->outValue[i], toValue, to->inValue[i], a + i, b + i, c + i, d + i);
+                    break;
+                case BSPLINE:
+                    bsplineCoefficients(prev->value[i], fromValue, toValue, next->value[i], a + i, b + i, c + i, d + i);
+                    break;
+                case FLAT:
+                    hermiteCoefficients(fromValue, 0.0f, toValue, 0.0f, a + i, b + i, c + i, d + i);
+                    break;
+                case HERMITE:
+                    hermiteCoefficients(fromValue, from->outValue[i], toValue, to->inValue[i], a + i, b + i, c + i, d + i);
+                    break;
+                case SMOOTH:
+                {
+                    float out, in;
+                    smoothTangents(first, last, prev->value[i], fromValue, toValue, next->value[i],
+                                   prev->time, from->time, to->time, next->time, &out, &in);
+                    hermiteCoefficients(fromValue, out, toValue, in, a + i, b + i, c + i, d + i);
+                    break;
+                }
+                default:
+                    // Linear, and the easing types once the time is eased.
+                    a[i] = b[i] = 0.0f;
+                    c[i] = toValue - fromValue;
+                    d[i] = fromValue;
+                    break;
+            }
+        }
+
+        // The rotation is slerped by a parameter that is itself interpolated over the times of the points.
+        unsigned int p = _componentCount;
+        switch (_quaternionOffset ? from->type : LINEAR)
+        {
+            case BEZIER:
+                bezierCoefficients(from->time, from->outValue[*_quaternionOffset], to->time, to->inValue[*_quaternionOffset], a + p, b + p, c + p, d + p);
+                break;
+            case FLAT:
+                hermiteCoefficients(from->time, 0.0f, to->time, 0.0f, a + p, b + p, c + p, d + p);
+                break;
+            case HERMITE:
+                hermiteCoefficients(from->time, from->outValue[*_quaternionOffset], to->time, to->inValue[*_quaternionOffset], a + p, b + p, c + p, d + p);
+                break;
+            case SMOOTH:
+            {
+                float out, in;
+                smoothTangents(first, last, prev->time, from->time, to->time, next->time,
+                               prev->time, from->time, to->time, next->time, &out, &in);
+                hermiteCoefficients(from->time, out, to->time, in, a + p, b + p, c + p, d + p);
+                break;
+            }
+            default:
+                a[p] = b[p] = d[p] = 0.0f;
+                c[p] = 1.0f;
+                break;
+        }
+    }
+}
+
+void Curve::setNlerpEnabled(bool enabled)
+{
+    __nlerp = enabled;
+}
+
+bool Curve::isNlerpEnabled()
+{
+    return __nlerp;
+}
+
+void Curve::evaluateSegment(unsigned int index, float s, const Point* from, const Point* to, float* dst) const
+{
+    const unsigned int stride = _componentCount + 1;
+    const float* a = _coefficients + index * 4 * stride;
+    const float* b = a + stride;
+    const float* c = b + stride;
+    const float* d = c + stride;
+
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 s4 = FLOAT4_SET(s);
+    for (; i + 4 <= _componentCount; i += 4)
+    {
+        float4 v = FLOAT4_MADD(FLOAT4_LOAD(b + i), FLOAT4_LOAD(a + i), s4);
+        v = FLOAT4_MADD(FLOAT4_LOAD(c + i), v, s4);
+        FLOAT4_STORE(dst + i, FLOAT4_MADD(FLOAT4_LOAD(d + i), v, s4));
+    }
+#endif
+    for (; i < _componentCount; i++)
+    {
+        dst[i] = ((a[i] * s + b[i]) * s + c[i]) * s + d[i];
+    }
+
+    if (_quaternionOffset)
+    {
+        // Overwrite the rotation components with the rotation at the interpolated parameter.
+        unsigned int q = *_quaternionOffset;
+        unsigned int p = _componentCount;
+        float interpTime = ((a[p] * s + b[p]) * s + c[p]) * s + d[p];
+        interpolateQuaternion(interpTime, from->value + q, to->value + q, dst + q);
+    }
+}
+
 void Curve::setQuaternionOffset(unsigned int offset)
 {
     assert(offset <= (_componentCount - 4));
 
+    SAFE_DELETE_ARRAY(_coefficients);
+
     if (!_quaternionOffset)
         _quaternionOffset = new unsigned int[1];
     
@@ -1171,9 +1386,11 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
 
 void Curve::interpolateLinear(float s, Point* from, Point* to, float* dst) const
 {
-    float* fromValue = from->value;
-    float* toValue = to->value;
+    interpolateLinear(s, from->value, to->value, dst);
+}
 
+void Curve::interpolateLinear(float s, const float* fromValue, const float* toValue, float* dst) const
+{
     if (!_quaternionOffset)
     {
         for (unsigned int i = 0; i < _componentCount; i++)
@@ -1211,8 +1428,30 @@ void Curve::interpolateLinear(float s, Point* from, Point* to, float* dst) const
     }
 }
 
-void Curve::interpolateQuaternion(float s, float* from, float* to, float* dst) const
+void Curve::interpolateQuaternion(float s, const float* from, const float* to, float* dst) const
 {
+    if (__nlerp && s >= 0.0f && s <= 1.0f)
+    {
+        // Blend along the shorter arc and renormalize.
+        float dot = from[0] * to[0] + from[1] * to[1] + from[2] * to[2] + from[3] * to[3];
+        float t = dot < 0.0f ? -s : s;
+        float r = 1.0f - s;
+        float x = from[0] * r + to[0] * t;
+        float y = from[1] * r + to[1] * t;
+        float z = from[2] * r + to[2] * t;
+        float w = from[3] * r + to[3] * t;
+        float n = sqrt(x * x + y * y + z * z + w * w);
+        if (n > 0.0f)
+        {
+            n = 1.0f / n;
+            dst[0] = x * n;
+            dst[1] = y * n;
+            dst[2] = z * n;
+            dst[3] = w * n;
+            return;
+        }
+    }
+
     // Evaluate.
     if (s >= 0)
         Quaternion::slerp(from[0], from[1], from[2], from[3], to[0], to[1], to[2], to[3], s, dst, dst + 1, dst + 2, dst + 3);
@@ -1220,6 +1459,61 @@ void Curve::interpolateQuaternion(float s, float* from, float* to, float* dst) c
         Quaternion::slerp(to[0], to[1], to[2], to[3], from[0], from[1], from[2], from[3], s, dst, dst + 1, dst + 2, dst + 3);
 }
 
+void Curve::setQuantizedValues(const unsigned short* values, const float* offsets, const float* scales)
+{
+    assert(values && offsets && scales && _componentCount <= CURVE_MAX_QUANTIZED_COMPONENTS);
+
+    if (!_quantizedValues)
+    {
+        _quantizedValues = new unsigned short[_pointCount * _componentCount];
+        _quantizedRanges = new float[_componentCount * 2];
+    }
+    memcpy(_quantizedValues, values, sizeof(unsigned short) * _pointCount * _componentCount);
+    memcpy(_quantizedRanges, offsets, _componentSize);
+    memcpy(_quantizedRanges + _componentCount, scales, _componentSize);
+
+    // The float values are no longer used.
+    for (unsigned int i = 0; i < _pointCount; i++)
+    {
+        assert(_points[i].type != BEZIER && _points[i].type != BSPLINE && _points[i].type != FLAT && _points[i].type != HERMITE && _points[i].type != SMOOTH);
+        SAFE_DELETE_ARRAY(_points[i].value);
+        SAFE_DELETE_ARRAY(_points[i].inValue);
+        SAFE_DELETE_ARRAY(_points[i].outValue);
+    }
+}
+
+void Curve::getPointValue(unsigned int index, float* dst) const
+{
+    if (!_quantizedValues)
+    {
+        memcpy(dst, _points[index].value, _componentSize);
+        return;
+    }
+
+    const unsigned short* values = _quantizedValues + index * _componentCount;
+    const float* offsets = _quantizedRanges;
+    const float* scales = _quantizedRanges + _componentCount;
+    for (unsigned int i = 0; i < _componentCount; i++)
+    {
+        dst[i] = offsets[i] + values[i] * scales[i];
+    }
+
+    // Quantization denormalizes rotations slightly, so renormalize them before they are interpolated.
+    if (_quaternionOffset)
+    {
+        float* q = dst + *_quaternionOffset;
+        float n = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+        if (n > 0.0f)
+        {
+            n = 1.0f / sqrt(n);
+            q[0] *= n;
+            q[1] *= n;
+            q[2] *= n;
+            q[3] *= n;
+        }
+    }
+}
+
 int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
 {
     unsigned int mid;
@@ -1240,6 +1534,34 @@ int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
     return max;
 }
 
+unsigned int Curve::determineIndex(float time, unsigned int min, unsigned int max, unsigned int* hint) const
+{
+    if (hint)
+    {
+        // Playback usually stays within the same keyframe or moves on to a neighbouring one.
+        unsigned int last = *hint;
+        if (last >= min && last < max)
+        {
+            if (time >= _points[last].time)
+            {
+                if (time < _points[last + 1].time)
+                    return last;
+                if (last + 1 < max && time < _points[last + 2].time)
+                    return (*hint = last + 1);
+            }
+            else if (last > min && time >= _points[last - 1].time)
+            {
+                return (*hint = last - 1);
+            }
+        }
+    }
+
+    unsigned int index = (unsigned int)determineIndex(time, min, max);
+    if (hint)
+        *hint = index;
+    return index;
+}
+
 int Curve::getInterpolationType(const char* curveId)
 {
     if (strcmp(curveId, "BEZIER") == 0)
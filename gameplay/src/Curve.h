@@ -298,6 +298,14 @@ public:
      */
     unsigned int getComponentCount() const;
 
+    /**
+     * Gets the size in bytes of the curve and its point data.
+     *
+     * @return The size in bytes.
+     * @script{ignore}
+     */
+    unsigned int getMemorySize() const;
+
     /**
      * Returns the start time for the curve.
      *
@@ -384,11 +392,102 @@ public:
      */
     void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const;
 
+    /**
+     * Evaluates the curve within the specified subregion, starting the keyframe search at a hint.
+     *
+     * The hint holds the index of the keyframe the previous evaluation interpolated from. When
+     * the curve is evaluated at increasing (or decreasing) times, as when a clip plays, the
+     * keyframes are usually found in constant time; otherwise a binary search is used. The hint
+     * is updated with the keyframe found, so each evaluator (such as an animation clip) should
+     * keep its own hint, initialized to zero.
+     *
+     * @param time The position within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curve
+     *      for looping purposes. A value of zero here disables curve looping.
+     * @param dst The evaluated value of the curve at the given time.
+     * @param hint The keyframe index to start searching from, updated with the keyframe found.
+     *      May be NULL.
+     * @script{ignore}
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* hint) const;
+
+    /**
+     * Evaluates the curve within the specified subregion at several positions.
+     *
+     * Sorting the times in increasing order lets each keyframe lookup continue from the previous one.
+     *
+     * @param count The number of positions to evaluate.
+     * @param times The positions within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curve
+     *      for looping purposes. A value of zero here disables curve looping.
+     * @param dst The evaluated values, getComponentCount() floats for each position.
+     * @param hint The keyframe index to start searching from, updated with the last keyframe found.
+     *      May be NULL.
+     * @script{ignore}
+     */
+    void evaluate(unsigned int count, const float* times, float startTime, float endTime, float loopBlendTime, float* dst, unsigned int* hint) const;
+
     /**
      * Linear interpolation function.
      */
     static float lerp(float t, float from, float to);
 
+    /**
+     * Eases a fractional time the way the curve does between two points of an interpolation type.
+     *
+     * The easing types (QUADRATIC_IN through BOUNCE_OUT_IN) reshape the time, which is then
+     * interpolated linearly; any other type returns the time unchanged.
+     *
+     * @param type The interpolation type.
+     * @param t The fractional time between the two points (between 0.0 - 1.0).
+     *
+     * @return The eased time.
+     * @script{ignore}
+     */
+    static float ease(InterpolationType type, float t);
+
+    /**
+     * Precomputes the polynomial coefficients of each segment of the curve.
+     *
+     * Every interpolation type between two points is a polynomial of at most the third degree
+     * in the (eased) fractional time, so a finalized curve evaluates a segment with three
+     * multiply-adds per component instead of recomputing the basis functions, tangents and
+     * control points on each call. The coefficients are stored by segment, and within a segment
+     * as four contiguous rows of components, so the inner loop evaluates four components at a
+     * time where SIMD instructions are available.
+     *
+     * Call this once all the points and tangents are set; changing a point or tangent afterwards
+     * discards the coefficients until the curve is finalized again. Curves with quantized values
+     * are not finalized, as their coefficients would take more memory than the quantization saves.
+     *
+     * @script{ignore}
+     */
+    void finalize();
+
+    /**
+     * Sets whether rotations are interpolated with a normalized linear blend instead of a spherical one.
+     *
+     * The normalized blend follows the same path as slerp at a slightly uneven speed, which is not
+     * noticeable between closely spaced animation keys, and costs no trigonometry. It is disabled
+     * by default and applies to all curves.
+     *
+     * @param enabled true to interpolate rotations with nlerp, false to use slerp.
+     * @script{ignore}
+     */
+    static void setNlerpEnabled(bool enabled);
+
+    /**
+     * Determines whether rotations are interpolated with a normalized linear blend.
+     *
+     * @return true if rotations are interpolated with nlerp, false if they use slerp.
+     * @script{ignore}
+     */
+    static bool isNlerpEnabled();
+
 private:
 
     /**
@@ -483,16 +582,50 @@ private:
      */ 
     void interpolateLinear(float s, Point* from, Point* to, float* dst) const;
 
+    /** 
+     * Linear interpolation function.
+     */ 
+    void interpolateLinear(float s, const float* fromValue, const float* toValue, float* dst) const;
+
     /**
      * Quaternion interpolation function.
      */
-    void interpolateQuaternion(float s, float* from, float* to, float* dst) const;
+    void interpolateQuaternion(float s, const float* from, const float* to, float* dst) const;
+
+    /**
+     * Evaluates a segment from the precomputed coefficients.
+     */
+    void evaluateSegment(unsigned int index, float s, const Point* from, const Point* to, float* dst) const;
+
+    /**
+     * Replaces the values of all points with 16-bit quantized values.
+     *
+     * Component i of a point is decoded as offsets[i] + values[i] * scales[i]. The float
+     * values and tangents of the points are freed, so quantized curves only support the
+     * interpolation types that do not use tangents or neighbouring points (LINEAR, STEP
+     * and the easing types), and their values cannot be set anymore.
+     *
+     * @param values The quantized values of all points (point count * component count values).
+     * @param offsets The offset of each component.
+     * @param scales The scale of each component.
+     */
+    void setQuantizedValues(const unsigned short* values, const float* offsets, const float* scales);
+
+    /**
+     * Copies the value of the point at the specified index, decoding it if the curve is quantized.
+     */
+    void getPointValue(unsigned int index, float* dst) const;
     
     /**
      * Determines the current keyframe to interpolate from based on the specified time.
      */ 
     int determineIndex(float time, unsigned int min, unsigned int max) const;
 
+    /**
+     * Determines the keyframe to interpolate from, checking the hinted keyframe and its neighbours before searching.
+     */
+    unsigned int determineIndex(float time, unsigned int min, unsigned int max, unsigned int* hint) const;
+
     /**
      * Sets the offset for the beginning of a Quaternion piece of data within the curve's value span at the specified
      * index. The next four components of data starting at the given index will be interpolated as a Quaternion.
@@ -516,6 +649,9 @@ private:
     unsigned int _componentSize;        // The component size (in bytes).
     unsigned int* _quaternionOffset;    // Offset for the rotation component.
     Point* _points;                     // The points on the curve.
+    unsigned short* _quantizedValues;   // Quantized values of the points, or NULL if they are stored as floats.
+    float* _quantizedRanges;            // Offset and scale of each quantized component.
+    float* _coefficients;               // Cubic coefficients of each segment, or NULL if the curve is not finalized.
 };
 
 }
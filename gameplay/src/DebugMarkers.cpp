@@ -0,0 +1,84 @@
+#include "Base.h"
+#include "DebugMarkers.h"
+#include "RenderCommandList.h"
+
+namespace gameplay
+{
+
+static bool __enabled = false;
+
+DebugMarkers::Group::Group(const char* name, const char* detail)
+    : _active(__enabled && name)
+{
+    if (!_active)
+        return;
+
+    if (detail && detail[0] != '\0')
+    {
+        std::string text = name;
+        text += " [";
+        text += detail;
+        text += "]";
+        pushGroup(text.c_str());
+    }
+    else
+    {
+        pushGroup(name);
+    }
+}
+
+DebugMarkers::Group::~Group()
+{
+    if (_active)
+        popGroup();
+}
+
+bool DebugMarkers::isEnabled()
+{
+    return __enabled;
+}
+
+void DebugMarkers::pushGroup(const char* name)
+{
+    GP_ASSERT(name);
+
+#ifdef USE_DEBUG_MARKERS
+    if (__enabled)
+        RenderCommandList::pushDebugGroup(name);
+#endif
+}
+
+void DebugMarkers::popGroup()
+{
+#ifdef USE_DEBUG_MARKERS
+    if (__enabled)
+        RenderCommandList::popDebugGroup();
+#endif
+}
+
+void DebugMarkers::setLabel(GLenum type, GLuint object, const char* label)
+{
+#ifdef USE_DEBUG_MARKERS
+    // Objects are shared with the context of the render thread, so they are labelled right away.
+    if (__enabled && object && label && glObjectLabel)
+    {
+        GL_ASSERT( glObjectLabel(type, object, -1, label) );
+    }
+#endif
+}
+
+void DebugMarkers::initialize(Properties* properties)
+{
+    if (properties == NULL || !properties->getBool("markers"))
+        return;
+
+#ifdef USE_DEBUG_MARKERS
+    __enabled = glPushDebugGroup && glPopDebugGroup;
+#endif
+    if (!__enabled)
+    {
+        GP_WARN("Debug markers are not supported (KHR_debug is missing).");
+    }
+}
+
+}
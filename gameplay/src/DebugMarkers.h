@@ -0,0 +1,106 @@
+#ifndef DEBUGMARKERS_H_
+#define DEBUGMARKERS_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Labels the draws and GL objects of the game for frame debuggers such as RenderDoc.
+ *
+ * When enabled, the engine wraps its rendering in KHR_debug groups, which frame debuggers
+ * show as a tree over the GL calls of a frame: scene visits and render queues, each model
+ * part drawn (labelled with the id of its node and its material pass), sprite batches,
+ * forms and terrains. The textures loaded from files, the textures of render targets, the
+ * vertex and index buffers of meshes loaded from bundles and the programs of effects loaded
+ * from files are labelled with the paths, URLs or ids they were created for.
+ *
+ * The markers are enabled in the 'debug' namespace of the game config:
+ *
+ * @verbatim
+    debug
+    {
+        markers = true
+    }
+   @endverbatim
+ *
+ * Objects are labelled when they are created, so the setting only labels the objects created
+ * after the startup. Groups cost a string per draw, so the markers are off by default. They
+ * are only available where the driver exposes KHR_debug.
+ *
+ * @script{ignore}
+ */
+class DebugMarkers
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Opens a debug group until the end of the enclosing block.
+     */
+    class Group
+    {
+    public:
+
+        /**
+         * Opens a group, if the markers are enabled.
+         *
+         * @param name The name of the group.
+         * @param detail Text appended to the name in brackets, or NULL.
+         */
+        explicit Group(const char* name, const char* detail = NULL);
+
+        /**
+         * Closes the group.
+         */
+        ~Group();
+
+    private:
+
+        Group(const Group&);
+        Group& operator=(const Group&);
+
+        bool _active;
+    };
+
+    /**
+     * Determines if the markers are enabled.
+     *
+     * @return true if groups and labels are emitted.
+     */
+    static bool isEnabled();
+
+    /**
+     * Opens a debug group. Every group must be closed with popGroup().
+     *
+     * @param name The name of the group.
+     */
+    static void pushGroup(const char* name);
+
+    /**
+     * Closes the last debug group opened.
+     */
+    static void popGroup();
+
+    /**
+     * Labels a GL object, if the markers are enabled.
+     *
+     * @param type The type of the object: GL_TEXTURE, GL_BUFFER, GL_PROGRAM or GL_FRAMEBUFFER.
+     * @param object The name of the object.
+     * @param label The label.
+     */
+    static void setLabel(GLenum type, GLuint object, const char* label);
+
+private:
+
+    /**
+     * Reads the settings from the 'debug' namespace of the game config.
+     */
+    static void initialize(Properties* properties);
+};
+
+}
+
+#endif
@@ -0,0 +1,479 @@
+#include "Base.h"
+#include "DebugRenderer.h"
+#include "Game.h"
+#include "Font.h"
+#include "Model.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+
+// The number of segments of each circle of a sphere.
+#define DEBUG_SPHERE_SEGMENTS 10
+
+// The number of levels of the overdraw heat map; the last one also holds the pixels shaded more times.
+#define DEBUG_OVERDRAW_LEVELS 16
+
+// The number of frames between two readbacks of the overdraw heat map, which stall the GPU.
+#define DEBUG_OVERDRAW_READBACK_INTERVAL 10
+
+namespace gameplay
+{
+
+// The points of a circle of radius one, repeating the first point at the end.
+static float __circleCos[DEBUG_SPHERE_SEGMENTS + 1];
+static float __circleSin[DEBUG_SPHERE_SEGMENTS + 1];
+static bool __circleInitialized = false;
+
+static Material* createDebugMaterial(Effect* effect, bool depthTest)
+{
+    Material* material = Material::create(effect);
+    GP_ASSERT(material && material->getStateBlock());
+    material->getStateBlock()->setDepthTest(depthTest);
+    material->getStateBlock()->setDepthFunction(RenderState::DEPTH_LEQUAL);
+    material->getStateBlock()->setBlend(true);
+    material->getStateBlock()->setBlendSrc(RenderState::BLEND_SRC_ALPHA);
+    material->getStateBlock()->setBlendDst(RenderState::BLEND_ONE_MINUS_SRC_ALPHA);
+    return material;
+}
+
+DebugRenderer::DebugRenderer()
+    : _categories(CATEGORY_ALL), _font(NULL), _overdraw(false), _overdrawActive(false), _overdrawQuad(NULL),
+      _overdrawMaterial(NULL), _overdrawFrame(0), _averageOverdraw(0.0f)
+{
+    _batches[DEPTH_TESTED] = NULL;
+    _batches[OVERLAY] = NULL;
+}
+
+DebugRenderer::~DebugRenderer()
+{
+    finalize();
+}
+
+void DebugRenderer::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    _overdraw = properties->getBool("overdraw");
+    if (properties->exists("font"))
+    {
+        _font = Font::create(properties->getString("font"));
+        if (_font == NULL)
+            GP_WARN("Failed to load the debug font '%s'.", properties->getString("font"));
+    }
+}
+
+void DebugRenderer::finalize()
+{
+    SAFE_DELETE(_batches[DEPTH_TESTED]);
+    SAFE_DELETE(_batches[OVERLAY]);
+    SAFE_RELEASE(_font);
+    SAFE_RELEASE(_overdrawMaterial);
+    SAFE_RELEASE(_overdrawQuad);
+    _labels.clear();
+}
+
+unsigned int DebugRenderer::getCategories() const
+{
+    return _categories;
+}
+
+void DebugRenderer::setCategories(unsigned int categories)
+{
+    _categories = categories;
+}
+
+void DebugRenderer::setCategoryEnabled(unsigned int categories, bool enabled)
+{
+    if (enabled)
+        _categories |= categories;
+    else
+        _categories &= ~categories;
+}
+
+bool DebugRenderer::isEnabled(unsigned int categories) const
+{
+    return (_categories & categories) != 0;
+}
+
+Font* DebugRenderer::getFont() const
+{
+    return _font;
+}
+
+void DebugRenderer::setFont(Font* font)
+{
+    if (font == _font)
+        return;
+
+    if (font)
+        font->addRef();
+    SAFE_RELEASE(_font);
+    _font = font;
+}
+
+bool DebugRenderer::isOverdrawEnabled() const
+{
+    return _overdraw;
+}
+
+void DebugRenderer::setOverdrawEnabled(bool enabled)
+{
+    _overdraw = enabled;
+}
+
+float DebugRenderer::getAverageOverdraw() const
+{
+    return _averageOverdraw;
+}
+
+DebugRenderer::Vertex* DebugRenderer::addLines(unsigned int count, Mode mode)
+{
+    if (_batches[mode] == NULL)
+    {
+        // Vertex shader for drawing colored lines.
+        const char* vs_str =
+        {
+            "uniform mat4 u_viewProjectionMatrix;\n"
+            "attribute vec4 a_position;\n"
+            "attribute vec4 a_color;\n"
+            "varying vec4 v_color;\n"
+            "void main(void) {\n"
+            "    v_color = a_color;\n"
+            "    gl_Position = u_viewProjectionMatrix * a_position;\n"
+            "}"
+        };
+
+        // Fragment shader for drawing colored lines.
+        const char* fs_str =
+        {
+        #ifdef OPENGL_ES
+            "precision highp float;\n"
+        #endif
+            "varying vec4 v_color;\n"
+            "void main(void) {\n"
+            "   gl_FragColor = v_color;\n"
+            "}"
+        };
+
+        // Both batches are created at once so that they share the effect.
+        Effect* effect = Effect::createFromSource(vs_str, fs_str);
+        if (effect == NULL)
+            return NULL;
+
+        VertexFormat::Element elements[] =
+        {
+            VertexFormat::Element(VertexFormat::POSITION, 3),
+            VertexFormat::Element(VertexFormat::COLOR, 4)
+        };
+        for (unsigned int i = DEPTH_TESTED; i <= OVERLAY; ++i)
+        {
+            Material* material = createDebugMaterial(effect, i == DEPTH_TESTED);
+            _batches[i] = MeshBatch::create(VertexFormat(elements, 2), Mesh::LINES, material, false, 4096, 4096);
+            SAFE_RELEASE(material);
+            _batches[i]->start();
+        }
+        SAFE_RELEASE(effect);
+    }
+
+    void* vertices;
+    unsigned int baseVertex;
+    if (!_batches[mode]->append(count * 2, 0, &vertices, NULL, &baseVertex))
+        return NULL;
+    return (Vertex*)vertices;
+}
+
+static inline void setVertex(void* vertex, float x, float y, float z, const Vector4& color)
+{
+    float* v = (float*)vertex;
+    v[0] = x;
+    v[1] = y;
+    v[2] = z;
+    v[3] = color.x;
+    v[4] = color.y;
+    v[5] = color.z;
+    v[6] = color.w;
+}
+
+void DebugRenderer::drawLine(const Vector3& from, const Vector3& to, const Vector4& color, unsigned int category, Mode mode)
+{
+    drawLine(from, to, color, color, category, mode);
+}
+
+void DebugRenderer::drawLine(const Vector3& from, const Vector3& to, const Vector4& fromColor, const Vector4& toColor,
+                             unsigned int category, Mode mode)
+{
+    if (!isEnabled(category))
+        return;
+
+    Vertex* vertices = addLines(1, mode);
+    if (vertices == NULL)
+        return;
+    setVertex(&vertices[0], from.x, from.y, from.z, fromColor);
+    setVertex(&vertices[1], to.x, to.y, to.z, toColor);
+}
+
+void DebugRenderer::drawBox(const BoundingBox& box, const Matrix& matrix, const Vector4& color, unsigned int category, Mode mode)
+{
+    if (!isEnabled(category) || box.isEmpty())
+        return;
+
+    // Transform box into world space (since we only store local boxes on mesh)
+    BoundingBox worldSpaceBox(box);
+    worldSpaceBox.transform(matrix);
+
+    Vector3 corners[8];
+    worldSpaceBox.getCorners(corners);
+
+    // The twelve edges of the box, as pairs of corners.
+    static const unsigned char edges[24] =
+    {
+        0, 1, 1, 2, 2, 3, 3, 0,
+        4, 5, 5, 6, 6, 7, 7, 4,
+        0, 7, 1, 6, 2, 5, 3, 4
+    };
+
+    Vertex* vertices = addLines(12, mode);
+    if (vertices == NULL)
+        return;
+    for (unsigned int i = 0; i < 24; ++i)
+    {
+        const Vector3& corner = corners[edges[i]];
+        setVertex(&vertices[i], corner.x, corner.y, corner.z, color);
+    }
+}
+
+void DebugRenderer::drawSphere(const BoundingSphere& sphere, const Vector4& color, unsigned int category, Mode mode)
+{
+    if (!isEnabled(category) || sphere.isEmpty())
+        return;
+
+    if (!__circleInitialized)
+    {
+        for (unsigned int i = 0; i <= DEBUG_SPHERE_SEGMENTS; ++i)
+        {
+            float angle = MATH_PIX2 * (float)(i % DEBUG_SPHERE_SEGMENTS) / (float)DEBUG_SPHERE_SEGMENTS;
+            __circleCos[i] = std::cos(angle);
+            __circleSin[i] = std::sin(angle);
+        }
+        __circleInitialized = true;
+    }
+
+    // Draw three rings for the sphere (one for the x, y and z axes)
+    Vertex* vertices = addLines(DEBUG_SPHERE_SEGMENTS * 3, mode);
+    if (vertices == NULL)
+        return;
+
+    const Vector3& c = sphere.center;
+    const float r = sphere.radius;
+    for (unsigned int i = 0; i < DEBUG_SPHERE_SEGMENTS; ++i)
+    {
+        float cos1 = __circleCos[i] * r, sin1 = __circleSin[i] * r;
+        float cos2 = __circleCos[i + 1] * r, sin2 = __circleSin[i + 1] * r;
+
+        setVertex(vertices++, c.x, c.y + cos1, c.z + sin1, color);
+        setVertex(vertices++, c.x, c.y + cos2, c.z + sin2, color);
+        setVertex(vertices++, c.x + cos1, c.y, c.z + sin1, color);
+        setVertex(vertices++, c.x + cos2, c.y, c.z + sin2, color);
+        setVertex(vertices++, c.x + cos1, c.y + sin1, c.z, color);
+        setVertex(vertices++, c.x + cos2, c.y + sin2, c.z, color);
+    }
+}
+
+void DebugRenderer::drawText(const Vector3& position, const char* text, const Vector4& color, unsigned int category)
+{
+    if (!isEnabled(category) || _font == NULL || text == NULL || *text == '\0')
+        return;
+
+    _labels.push_back(Label());
+    Label& label = _labels.back();
+    label.position = position;
+    label.color = color;
+    label.text = text;
+}
+
+void DebugRenderer::flush(const Matrix& viewProjection)
+{
+    for (unsigned int mode = DEPTH_TESTED; mode <= OVERLAY; ++mode)
+    {
+        MeshBatch* batch = _batches[mode];
+        if (batch == NULL)
+            continue;
+
+        static const unsigned int viewProjectionMatrixHandle = RenderState::getParameterHandle("u_viewProjectionMatrix");
+        batch->finish();
+        GP_ASSERT(batch->getMaterial());
+        batch->getMaterial()->getParameter(viewProjectionMatrixHandle)->setValue(viewProjection);
+        batch->draw();
+        batch->start();
+    }
+
+    if (_labels.empty())
+        return;
+
+    // Project the labels the way Camera::project does, dropping those behind the viewer.
+    const Rectangle& viewport = Game::getInstance()->getViewport();
+    _font->start();
+    for (size_t i = 0, count = _labels.size(); i < count; ++i)
+    {
+        const Label& label = _labels[i];
+        Vector4 clip;
+        viewProjection.transformVector(Vector4(label.position.x, label.position.y, label.position.z, 1.0f), &clip);
+        if (clip.w <= 0.0f)
+            continue;
+
+        float ndcX = clip.x / clip.w;
+        float ndcY = clip.y / clip.w;
+        int x = (int)(viewport.x + (ndcX + 1.0f) * 0.5f * viewport.width);
+        int y = (int)(viewport.y + (1.0f - (ndcY + 1.0f) * 0.5f) * viewport.height);
+        _font->drawText(label.text.c_str(), x, y, label.color);
+    }
+    _font->finish();
+    _labels.clear();
+}
+
+void DebugRenderer::discard()
+{
+    for (unsigned int mode = DEPTH_TESTED; mode <= OVERLAY; ++mode)
+    {
+        if (_batches[mode])
+            _batches[mode]->start();
+    }
+    _labels.clear();
+}
+
+void DebugRenderer::beginOverdraw()
+{
+    _overdrawActive = false;
+    if (!_overdraw)
+        return;
+
+    // The view reads back the frame it draws, which a render thread has not replayed yet.
+    if (RenderCommandList::isRecording())
+    {
+        GP_WARN("The overdraw view is not available while frames render on the render thread; it is disabled.");
+        _overdraw = false;
+        return;
+    }
+
+    GLint stencilBits = 0;
+    glGetIntegerv(GL_STENCIL_BITS, &stencilBits);
+    if (stencilBits == 0)
+    {
+        GP_WARN("The overdraw view needs a stencil buffer; it is disabled.");
+        _overdraw = false;
+        return;
+    }
+    _overdrawActive = true;
+
+    // Every fragment that passes the depth test, or is drawn without one, increments the stencil of its pixel.
+    StateCache::setEnabled(GL_SCISSOR_TEST, false);
+    RenderCommandList::stencilMask(0xFF);
+    Game::getInstance()->clear(Game::CLEAR_STENCIL, Vector4::zero(), 1.0f, 0);
+    StateCache::setEnabled(GL_STENCIL_TEST, true);
+    RenderCommandList::stencilFunc(GL_ALWAYS, 0, 0xFF);
+    RenderCommandList::stencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+}
+
+void DebugRenderer::endOverdraw()
+{
+    if (!_overdrawActive)
+        return;
+    _overdrawActive = false;
+
+    if (_overdrawMaterial == NULL)
+    {
+        // Vertex shader for drawing a full screen quad.
+        const char* vs_str =
+        {
+            "attribute vec2 a_position;\n"
+            "void main(void) {\n"
+            "    gl_Position = vec4(a_position, 0.0, 1.0);\n"
+            "}"
+        };
+
+        // Fragment shader for filling the quad with a color.
+        const char* fs_str =
+        {
+        #ifdef OPENGL_ES
+            "precision highp float;\n"
+        #endif
+            "uniform vec4 u_color;\n"
+            "void main(void) {\n"
+            "   gl_FragColor = u_color;\n"
+            "}"
+        };
+
+        Effect* effect = Effect::createFromSource(vs_str, fs_str);
+        Mesh* mesh = Mesh::createQuadFullscreen();
+        if (effect && mesh)
+        {
+            _overdrawMaterial = Material::create(effect);
+            _overdrawMaterial->getStateBlock()->setDepthTest(false);
+            _overdrawMaterial->getStateBlock()->setBlend(false);
+            _overdrawQuad = Model::create(mesh);
+        }
+        SAFE_RELEASE(mesh);
+        SAFE_RELEASE(effect);
+    }
+
+    Game* game = Game::getInstance();
+    Rectangle viewport = game->getViewport();
+    unsigned int width = game->getWidth();
+    unsigned int height = game->getHeight();
+    if (_overdrawMaterial && _overdrawQuad)
+    {
+        game->setViewport(Rectangle((float)width, (float)height));
+        StateCache::setEnabled(GL_SCISSOR_TEST, false);
+        game->clear(Game::CLEAR_COLOR, Vector4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, 0);
+
+        // Each level covers the pixels whose stencil holds its count. Red grows with the count,
+        // and stays exact enough in a 5-bit channel for readOverdraw() to recover the count.
+        RenderCommandList::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        MaterialParameter* color = _overdrawMaterial->getParameter("u_color");
+        for (unsigned int level = 1; level <= DEBUG_OVERDRAW_LEVELS; ++level)
+        {
+            float t = (float)level / (float)DEBUG_OVERDRAW_LEVELS;
+            color->setValue(Vector4(t, 1.0f - fabs(2.0f * t - 1.0f), 1.0f - t, 1.0f));
+            RenderCommandList::stencilFunc(level < DEBUG_OVERDRAW_LEVELS ? GL_EQUAL : GL_LEQUAL, (GLint)level, 0xFF);
+            _overdrawQuad->draw(_overdrawMaterial);
+        }
+
+        if (++_overdrawFrame >= DEBUG_OVERDRAW_READBACK_INTERVAL)
+        {
+            _overdrawFrame = 0;
+            readOverdraw(width, height);
+        }
+    }
+    StateCache::setEnabled(GL_STENCIL_TEST, false);
+    RenderCommandList::stencilFunc(GL_ALWAYS, 0, 0xFF);
+    RenderCommandList::stencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+    GP_PROFILE_COUNTER("Overdraw", _averageOverdraw);
+    if (_font)
+    {
+        char text[64];
+        sprintf(text, "%.2f fragments per pixel", _averageOverdraw);
+        _font->start();
+        _font->drawText(text, 5, 5, Vector4::one());
+        _font->finish();
+    }
+    game->setViewport(viewport);
+}
+
+void DebugRenderer::readOverdraw(unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0)
+        return;
+
+    _overdrawPixels.resize(width * height * 4);
+    GL_ASSERT( glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &_overdrawPixels[0]) );
+
+    unsigned long long total = 0;
+    for (size_t i = 0, count = _overdrawPixels.size(); i < count; i += 4)
+    {
+        total += (_overdrawPixels[i] * DEBUG_OVERDRAW_LEVELS + 127) / 255;
+    }
+    _averageOverdraw = (float)((double)total / ((double)width * height));
+}
+
+}
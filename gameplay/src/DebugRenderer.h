@@ -0,0 +1,319 @@
+#ifndef DEBUGRENDERER_H_
+#define DEBUGRENDERER_H_
+
+#include "MeshBatch.h"
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Vector4.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class Font;
+class Model;
+
+/**
+ * Defines an immediate-mode renderer for debug geometry: lines, boxes, spheres and text.
+ *
+ * Primitives can be drawn from anywhere during the frame and are kept until flush()
+ * draws them all with a view projection matrix. Lines are written straight into one
+ * persistent batch per mode, whose storage is kept from frame to frame, and are streamed
+ * to the GPU through the stream ring buffers, so drawing debug geometry does not
+ * allocate once the batches have grown to the size the game needs.
+ *
+ * Lines are either depth tested against the scene or drawn as an overlay on top of it.
+ * Text is always drawn as an overlay, with the font set on the renderer.
+ *
+ * Each primitive belongs to a category, and the categories can be turned on and off.
+ * Primitives of disabled categories are dropped on entry, and the engine's own debug
+ * drawing (Scene::drawDebug and PhysicsController::drawDebug) returns before visiting
+ * anything when its category is disabled. Primitives that are not flushed by the end
+ * of the frame are discarded.
+ *
+ * The overdraw view replaces the frame with a heat map of how many fragments each pixel
+ * shaded, from blue for one fragment to red for 16 or more. While it is enabled, every
+ * fragment that passes the depth test increments the stencil of its pixel, whatever draws
+ * it: models, terrain, particles, sprite batches and forms alike. At the end of the frame
+ * the stencil counts are drawn as the heat map, and every few frames the heat map is read
+ * back to compute the average number of fragments per pixel, which is drawn with the font
+ * and recorded as the "Overdraw" profiler counter. The view needs a stencil buffer, and
+ * only counts the fragments drawn to the frame buffer the frame ends in, so the post
+ * processor and dynamic resolution draw straight to it while the view is enabled. It
+ * tells whether a depth pre-pass (see RenderQueue::setDepthPrePassEnabled) pays off.
+ *
+ * The renderer is configured in the game config:
+ *
+ * @verbatim
+    debug
+    {
+        font = res/ui/arial.gpb     // Font to draw debug text with (default none; text is ignored).
+        overdraw = false            // Show how many fragments each pixel shades (default false).
+        markers = false             // Group draws and label GL objects for frame debuggers (see DebugMarkers).
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class DebugRenderer
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the categories of debug primitives.
+     */
+    enum Category
+    {
+        CATEGORY_GENERAL = 0x01,
+        CATEGORY_BOUNDS = 0x02,
+        CATEGORY_PHYSICS = 0x04,
+        CATEGORY_AI = 0x08,
+        CATEGORY_USER = 0x100,
+        CATEGORY_ALL = 0xFFFFFFFF
+    };
+
+    /**
+     * Defines how lines are drawn relative to the scene.
+     */
+    enum Mode
+    {
+        DEPTH_TESTED,
+        OVERLAY
+    };
+
+    /**
+     * Gets the enabled categories.
+     *
+     * @return A bitwise combination of Category values.
+     */
+    unsigned int getCategories() const;
+
+    /**
+     * Sets the enabled categories. All categories are enabled by default.
+     *
+     * @param categories A bitwise combination of Category values.
+     */
+    void setCategories(unsigned int categories);
+
+    /**
+     * Enables or disables categories, leaving the other categories unchanged.
+     *
+     * @param categories A bitwise combination of Category values.
+     * @param enabled Whether to enable the categories.
+     */
+    void setCategoryEnabled(unsigned int categories, bool enabled);
+
+    /**
+     * Determines if any of the given categories is enabled.
+     *
+     * @param categories A bitwise combination of Category values.
+     *
+     * @return True if primitives of the categories are drawn.
+     */
+    bool isEnabled(unsigned int categories) const;
+
+    /**
+     * Gets the font used to draw debug text.
+     *
+     * @return The font, or NULL if text is not drawn.
+     */
+    Font* getFont() const;
+
+    /**
+     * Sets the font used to draw debug text.
+     *
+     * @param font The font, or NULL to not draw text.
+     */
+    void setFont(Font* font);
+
+    /**
+     * Determines if render queues draw the overdraw view instead of shading their items.
+     *
+     * @return True if the overdraw view is shown.
+     */
+    bool isOverdrawEnabled() const;
+
+    /**
+     * Sets whether render queues draw the overdraw view instead of shading their items.
+     *
+     * @param enabled True to show the overdraw view.
+     */
+    void setOverdrawEnabled(bool enabled);
+
+    /**
+     * Gets the average number of fragments shaded per pixel, as last read back by the overdraw view.
+     *
+     * Pixels shaded 16 times or more count as 16.
+     *
+     * @return The average number of fragments per pixel, or 0 if the overdraw view has not been read back.
+     */
+    float getAverageOverdraw() const;
+
+    /**
+     * Draws a line.
+     *
+     * @param from The start of the line.
+     * @param to The end of the line.
+     * @param color The color of the line.
+     * @param category The category of the line.
+     * @param mode Whether the line is depth tested or drawn on top of the scene.
+     */
+    void drawLine(const Vector3& from, const Vector3& to, const Vector4& color, unsigned int category = CATEGORY_GENERAL, Mode mode = DEPTH_TESTED);
+
+    /**
+     * Draws a line whose color changes from one end to the other.
+     *
+     * @param from The start of the line.
+     * @param to The end of the line.
+     * @param fromColor The color at the start of the line.
+     * @param toColor The color at the end of the line.
+     * @param category The category of the line.
+     * @param mode Whether the line is depth tested or drawn on top of the scene.
+     */
+    void drawLine(const Vector3& from, const Vector3& to, const Vector4& fromColor, const Vector4& toColor,
+                  unsigned int category = CATEGORY_GENERAL, Mode mode = DEPTH_TESTED);
+
+    /**
+     * Draws the edges of a box.
+     *
+     * The box is transformed by the matrix the same way BoundingBox::transform does,
+     * so the box drawn is aligned with the axes of the world.
+     *
+     * @param box The box.
+     * @param matrix The matrix to transform the box by.
+     * @param color The color of the box.
+     * @param category The category of the box.
+     * @param mode Whether the box is depth tested or drawn on top of the scene.
+     */
+    void drawBox(const BoundingBox& box, const Matrix& matrix, const Vector4& color, unsigned int category = CATEGORY_GENERAL, Mode mode = DEPTH_TESTED);
+
+    /**
+     * Draws a sphere as three circles around its axes.
+     *
+     * @param sphere The sphere.
+     * @param color The color of the sphere.
+     * @param category The category of the sphere.
+     * @param mode Whether the sphere is depth tested or drawn on top of the scene.
+     */
+    void drawSphere(const BoundingSphere& sphere, const Vector4& color, unsigned int category = CATEGORY_GENERAL, Mode mode = DEPTH_TESTED);
+
+    /**
+     * Draws text at a position of the world, on top of the scene.
+     *
+     * @param position The position of the top-left corner of the text.
+     * @param text The text.
+     * @param color The color of the text.
+     * @param category The category of the text.
+     */
+    void drawText(const Vector3& position, const char* text, const Vector4& color, unsigned int category = CATEGORY_GENERAL);
+
+    /**
+     * Draws all the primitives drawn since the last flush.
+     *
+     * Depth tested lines are drawn first, then overlay lines, then text.
+     *
+     * @param viewProjection The view projection matrix to draw the primitives with.
+     */
+    void flush(const Matrix& viewProjection);
+
+private:
+
+    /**
+     * A debug line vertex.
+     */
+    struct Vertex
+    {
+        float x;
+        float y;
+        float z;
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /**
+     * A debug text waiting to be drawn.
+     */
+    struct Label
+    {
+        Vector3 position;
+        Vector4 color;
+        std::string text;
+    };
+
+    /**
+     * Constructor.
+     */
+    DebugRenderer();
+
+    /**
+     * Destructor.
+     */
+    ~DebugRenderer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    DebugRenderer(const DebugRenderer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    DebugRenderer& operator=(const DebugRenderer&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'debug' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    void finalize();
+
+    /**
+     * Adds lines to the batch of a mode and returns their vertices to be filled in by the caller.
+     */
+    Vertex* addLines(unsigned int count, Mode mode);
+
+    /**
+     * Called by the game at the end of each frame to drop the primitives that were not flushed.
+     */
+    void discard();
+
+    /**
+     * Called by the game before rendering a frame to start counting the fragments of each pixel.
+     */
+    void beginOverdraw();
+
+    /**
+     * Called by the game after rendering a frame to draw the overdraw heat map over it.
+     */
+    void endOverdraw();
+
+    /**
+     * Reads back the heat map and computes the average number of fragments per pixel.
+     */
+    void readOverdraw(unsigned int width, unsigned int height);
+
+    unsigned int _categories;
+    MeshBatch* _batches[2];
+    std::vector<Label> _labels;
+    Font* _font;
+    bool _overdraw;
+    bool _overdrawActive;
+    Model* _overdrawQuad;
+    Material* _overdrawMaterial;
+    std::vector<unsigned char> _overdrawPixels;
+    unsigned int _overdrawFrame;
+    float _averageOverdraw;
+};
+
+}
+
+#endif
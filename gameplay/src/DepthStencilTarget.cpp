@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "DepthStencilTarget.h"
+#include "Allocator.h"
 
 #ifndef GL_DEPTH24_STENCIL8_OES
 #define GL_DEPTH24_STENCIL8_OES 0x88F0
@@ -25,6 +26,8 @@ DepthStencilTarget::~DepthStencilTarget()
         GL_ASSERT( glDeleteRenderbuffers(1, &_depthBuffer) );
     if (_stencilBuffer)
         GL_ASSERT( glDeleteRenderbuffers(1, &_stencilBuffer) );
+    if (_depthBuffer)
+        Allocator::untrack(Allocator::FRAMEBUFFER, getMemorySize());
 
     // Remove from vector.
     std::vector<DepthStencilTarget*>::iterator it = std::find(__depthStencilTargets.begin(), __depthStencilTargets.end(), this);
@@ -81,6 +84,8 @@ DepthStencilTarget* DepthStencilTarget::create(const char* id, Format format, un
         depthStencilTarget->_packed = true;
     }
 
+    Allocator::track(Allocator::FRAMEBUFFER, depthStencilTarget->getMemorySize());
+
     // Add it to the cache.
     __depthStencilTargets.push_back(depthStencilTarget);
 
@@ -129,4 +134,10 @@ bool DepthStencilTarget::isPacked() const
 {
     return _packed;
 }
+
+unsigned int DepthStencilTarget::getMemorySize() const
+{
+    // Depth is stored in 24 or 16 bits padded to 32, a separate stencil buffer adds 8 bits per pixel.
+    return _width * _height * (_stencilBuffer ? 5 : 4);
+}
 }
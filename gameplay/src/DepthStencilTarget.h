@@ -106,6 +106,11 @@ private:
      */
     DepthStencilTarget& operator=(const DepthStencilTarget&);
 
+    /**
+     * Gets an estimate of the size in bytes of the render buffers.
+     */
+    unsigned int getMemorySize() const;
+
     std::string _id;
     Format _format;
     RenderBufferHandle _depthBuffer;
@@ -0,0 +1,310 @@
+#include "Base.h"
+#include "DynamicResolution.h"
+#include "Game.h"
+#include "FrameBuffer.h"
+#include "SpriteBatch.h"
+#include "RenderCommandList.h"
+
+// Number of frames a timer query pair may stay in flight before its result is dropped.
+#define DYNAMIC_RESOLUTION_LATENCY 4
+
+// Weight of the newest frame in the smoothed frame time.
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.2f
+
+// Fraction of the target frame time under which the scale is raised.
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85f
+
+// Scale added per raise, and the lowest factor a single drop multiplies the scale by.
+#define DYNAMIC_RESOLUTION_RAISE_STEP 0.02f
+#define DYNAMIC_RESOLUTION_MAX_DROP 0.8f
+
+namespace gameplay
+{
+
+DynamicResolution::DynamicResolution()
+    : _enabled(false), _timerQueries(false), _rendering(false), _scale(1.0f), _minScale(0.5f), _maxScale(1.0f),
+      _targetFrameTime(16.6f), _frameTime(0.0f), _cooldown(0), _lastFrameStart(0.0), _frameBuffer(NULL), _spriteBatch(NULL),
+      _screenWidth(0), _screenHeight(0), _previousFrameBuffer(NULL), _queryIndex(0)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+}
+
+void DynamicResolution::initialize(Properties* properties)
+{
+    if (properties)
+    {
+        _enabled = properties->getBool("enabled");
+        float minScale = properties->exists("minScale") ? properties->getFloat("minScale") : _minScale;
+        float maxScale = properties->exists("maxScale") ? properties->getFloat("maxScale") : _maxScale;
+        setScaleRange(minScale, maxScale);
+        if (properties->exists("targetFrameTime"))
+            setTargetFrameTime(properties->getFloat("targetFrameTime"));
+    }
+    _scale = _maxScale;
+
+#ifdef USE_TIMER_QUERIES
+    // Timer queries belong to the context that issues them, so none are made while a render thread replays the frames.
+    _timerQueries = glGenQueries && glDeleteQueries && glQueryCounter && glGetQueryObjectiv && glGetQueryObjectui64v &&
+        !RenderCommandList::isRecording();
+    if (_timerQueries)
+    {
+        _queries.resize(DYNAMIC_RESOLUTION_LATENCY);
+        for (size_t i = 0; i < _queries.size(); ++i)
+        {
+            GL_ASSERT( glGenQueries(1, &_queries[i].begin) );
+            GL_ASSERT( glGenQueries(1, &_queries[i].end) );
+            _queries[i].pending = false;
+        }
+    }
+#endif
+}
+
+void DynamicResolution::finalize()
+{
+#ifdef USE_TIMER_QUERIES
+    for (size_t i = 0; i < _queries.size(); ++i)
+    {
+        GL_ASSERT( glDeleteQueries(1, &_queries[i].begin) );
+        GL_ASSERT( glDeleteQueries(1, &_queries[i].end) );
+    }
+#endif
+    _queries.clear();
+    SAFE_DELETE(_spriteBatch);
+    SAFE_RELEASE(_frameBuffer);
+}
+
+bool DynamicResolution::isEnabled() const
+{
+    return _enabled;
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+    GP_ASSERT(!_rendering);
+
+    _enabled = enabled;
+    if (!_enabled)
+    {
+        // The frame buffer is only kept while it is in use.
+        SAFE_DELETE(_spriteBatch);
+        SAFE_RELEASE(_frameBuffer);
+    }
+}
+
+float DynamicResolution::getScale() const
+{
+    return _scale;
+}
+
+float DynamicResolution::getMinScale() const
+{
+    return _minScale;
+}
+
+float DynamicResolution::getMaxScale() const
+{
+    return _maxScale;
+}
+
+void DynamicResolution::setScaleRange(float minScale, float maxScale)
+{
+    if (minScale <= 0.0f || maxScale < minScale)
+    {
+        GP_WARN("Invalid dynamic resolution scale range [%f, %f].", minScale, maxScale);
+        return;
+    }
+    _minScale = minScale;
+    _maxScale = maxScale;
+    _scale = MATH_CLAMP(_scale, _minScale, _maxScale);
+}
+
+float DynamicResolution::getTargetFrameTime() const
+{
+    return _targetFrameTime;
+}
+
+void DynamicResolution::setTargetFrameTime(float time)
+{
+    if (time <= 0.0f)
+    {
+        GP_WARN("Invalid dynamic resolution target frame time %f.", time);
+        return;
+    }
+    _targetFrameTime = time;
+}
+
+float DynamicResolution::getFrameTime() const
+{
+    return _frameTime;
+}
+
+void DynamicResolution::update()
+{
+    GP_ASSERT(!_rendering);
+
+    if (!_enabled)
+    {
+        _lastFrameStart = 0.0;
+        return;
+    }
+
+    if (_timerQueries)
+    {
+#ifdef USE_TIMER_QUERIES
+        // Queries complete in order, so older pairs are read first.
+        for (unsigned int i = 1; i <= _queries.size(); ++i)
+        {
+            TimerQuery& query = _queries[(_queryIndex + i) % _queries.size()];
+            if (!query.pending)
+                continue;
+
+            GLint available = 0;
+            GL_ASSERT( glGetQueryObjectiv(query.end, GL_QUERY_RESULT_AVAILABLE, &available) );
+            if (!available)
+                break;
+            query.pending = false;
+
+#ifdef GL_GPU_DISJOINT
+            // A disjoint operation (e.g. a frequency change) invalidates the timestamps.
+            GLint disjoint = 0;
+            glGetIntegerv(GL_GPU_DISJOINT, &disjoint);
+            if (disjoint)
+                continue;
+#endif
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            GL_ASSERT( glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin) );
+            GL_ASSERT( glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end) );
+            adjustScale((float)((double)(end - begin) * 1.0e-6));
+        }
+#endif
+    }
+    else
+    {
+        double now = Game::getAbsoluteTime();
+        if (_lastFrameStart > 0.0)
+            adjustScale((float)(now - _lastFrameStart));
+        _lastFrameStart = now;
+    }
+
+    GP_PROFILE_COUNTER("Resolution scale", _scale);
+}
+
+void DynamicResolution::adjustScale(float frameTime)
+{
+    _frameTime = _frameTime > 0.0f ? _frameTime + (frameTime - _frameTime) * DYNAMIC_RESOLUTION_SMOOTHING : frameTime;
+
+    // Wait for the frames rendered at the last scale before judging it.
+    if (_cooldown > 0)
+    {
+        --_cooldown;
+        return;
+    }
+
+    float scale = _scale;
+    if (_frameTime > _targetFrameTime)
+    {
+        // The pixel count, and with it most of the GPU time, grows with the square of the scale.
+        scale *= std::max(sqrt(_targetFrameTime / _frameTime), DYNAMIC_RESOLUTION_MAX_DROP);
+    }
+    else if (_frameTime < _targetFrameTime * (_timerQueries ? DYNAMIC_RESOLUTION_HEADROOM : 1.0f))
+    {
+        scale += DYNAMIC_RESOLUTION_RAISE_STEP;
+    }
+    scale = MATH_CLAMP(scale, _minScale, _maxScale);
+
+    if (scale != _scale)
+    {
+        _scale = scale;
+        _cooldown = DYNAMIC_RESOLUTION_LATENCY;
+    }
+}
+
+bool DynamicResolution::createFrameBuffer()
+{
+    Game* game = Game::getInstance();
+    if (_frameBuffer && _screenWidth == game->getWidth() && _screenHeight == game->getHeight())
+        return true;
+
+    SAFE_DELETE(_spriteBatch);
+    SAFE_RELEASE(_frameBuffer);
+
+    // The frame buffer fits the highest scale, and lower scales draw into its lower left corner.
+    _screenWidth = game->getWidth();
+    _screenHeight = game->getHeight();
+    unsigned int width = std::max((unsigned int)ceil(_screenWidth * _maxScale), 1u);
+    unsigned int height = std::max((unsigned int)ceil(_screenHeight * _maxScale), 1u);
+    _frameBuffer = game->getRenderTargetPool()->acquire(width, height, Texture::RGBA, true);
+    if (_frameBuffer == NULL)
+    {
+        GP_ERROR("Failed to create the dynamic resolution frame buffer.");
+        return false;
+    }
+
+    _spriteBatch = SpriteBatch::create(_frameBuffer->getRenderTarget()->getTexture());
+    _spriteBatch->getSampler()->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    _spriteBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+
+    // The scene replaces whatever is under it.
+    _spriteBatch->getStateBlock()->setBlend(false);
+    return true;
+}
+
+void DynamicResolution::begin()
+{
+    GP_ASSERT(!_rendering);
+
+    // The overdraw view only counts the fragments drawn to the frame buffer the frame ends in.
+    if (!_enabled || Game::getInstance()->getDebugRenderer()->isOverdrawEnabled() || !createFrameBuffer())
+        return;
+    _rendering = true;
+
+    Game* game = Game::getInstance();
+    _previousViewport = game->getViewport();
+    _previousFrameBuffer = _frameBuffer->bind();
+
+    float width = std::min(floor(_screenWidth * _scale + 0.5f), (float)_frameBuffer->getWidth());
+    float height = std::min(floor(_screenHeight * _scale + 0.5f), (float)_frameBuffer->getHeight());
+    _scaledViewport.set(0.0f, 0.0f, std::max(width, 1.0f), std::max(height, 1.0f));
+    game->setViewport(_scaledViewport);
+
+#ifdef USE_TIMER_QUERIES
+    if (_timerQueries)
+    {
+        // Reuse the oldest pair; if its result is still not available it is dropped.
+        _queryIndex = (_queryIndex + 1) % _queries.size();
+        GL_ASSERT( glQueryCounter(_queries[_queryIndex].begin, GL_TIMESTAMP) );
+    }
+#endif
+}
+
+void DynamicResolution::end()
+{
+    if (!_rendering)
+        return;
+    _rendering = false;
+
+#ifdef USE_TIMER_QUERIES
+    if (_timerQueries)
+    {
+        GL_ASSERT( glQueryCounter(_queries[_queryIndex].end, GL_TIMESTAMP) );
+        _queries[_queryIndex].pending = true;
+    }
+#endif
+
+    _previousFrameBuffer->bind();
+    _previousFrameBuffer = NULL;
+    Game::getInstance()->setViewport(_previousViewport);
+
+    // The render target is stored bottom up, so the scaled rectangle is drawn with flipped texture coordinates.
+    float u = _scaledViewport.width / (float)_frameBuffer->getWidth();
+    float v = _scaledViewport.height / (float)_frameBuffer->getHeight();
+    _spriteBatch->start();
+    _spriteBatch->draw(_previousViewport.x, _previousViewport.y, _previousViewport.width, _previousViewport.height, 0.0f, v, u, 0.0f, Vector4::one());
+    _spriteBatch->finish();
+}
+
+}
@@ -0,0 +1,209 @@
+#ifndef DYNAMICRESOLUTION_H_
+#define DYNAMICRESOLUTION_H_
+
+#include "Properties.h"
+#include "Rectangle.h"
+
+namespace gameplay
+{
+
+class FrameBuffer;
+class SpriteBatch;
+
+/**
+ * Defines a dynamic resolution mode that scales the resolution of the scene to keep
+ * the GPU time of a frame under a target.
+ *
+ * The game renders its scene between begin() and end(). begin() redirects the drawing
+ * to an internal frame buffer and sets a viewport of the current scale of the screen
+ * size; end() upscales the result to the frame buffer and viewport that were bound
+ * before. Everything drawn after end(), such as forms and text, is drawn at the native
+ * resolution. When dynamic resolution is disabled, begin() and end() do nothing.
+ *
+ * The GPU time between begin() and end() is measured with timestamp queries and read
+ * back a few frames later. Once per frame the scale is lowered in proportion to how
+ * far the smoothed GPU time is over the target, and raised in small steps while it
+ * is well under the target. Without timer queries, the time between frames is used
+ * instead; since vsync hides how much time is left, the scale is then raised whenever
+ * frames are on time.
+ *
+ * Dynamic resolution is configured in the game config:
+ *
+ * @verbatim
+    dynamicResolution
+    {
+        enabled = true
+        minScale = 0.5              // Lowest scale of the screen size.
+        maxScale = 1.0              // Highest scale of the screen size.
+        targetFrameTime = 16.6      // GPU time of a frame to stay under, in milliseconds.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class DynamicResolution
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Determines if dynamic resolution is enabled.
+     *
+     * @return True if the scene is rendered at a dynamic resolution.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Enables or disables dynamic resolution.
+     *
+     * @param enabled True to render the scene at a dynamic resolution.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Gets the current scale of the scene resolution.
+     *
+     * @return The scale of the screen size the scene is rendered at.
+     */
+    float getScale() const;
+
+    /**
+     * Gets the lowest scale of the scene resolution.
+     *
+     * @return The lowest scale.
+     */
+    float getMinScale() const;
+
+    /**
+     * Gets the highest scale of the scene resolution.
+     *
+     * @return The highest scale.
+     */
+    float getMaxScale() const;
+
+    /**
+     * Sets the range of the scale of the scene resolution.
+     *
+     * @param minScale The lowest scale, greater than 0.
+     * @param maxScale The highest scale, at least minScale.
+     */
+    void setScaleRange(float minScale, float maxScale);
+
+    /**
+     * Gets the GPU time of a frame that the scale is adjusted to stay under.
+     *
+     * @return The target frame time in milliseconds.
+     */
+    float getTargetFrameTime() const;
+
+    /**
+     * Sets the GPU time of a frame that the scale is adjusted to stay under.
+     *
+     * @param time The target frame time in milliseconds.
+     */
+    void setTargetFrameTime(float time);
+
+    /**
+     * Gets the smoothed time the scale is adjusted from.
+     *
+     * @return The GPU time of the scene, or the time between frames without timer queries, in milliseconds.
+     */
+    float getFrameTime() const;
+
+    /**
+     * Starts rendering the scene at the current scale.
+     *
+     * Binds the internal frame buffer and sets the game viewport to the scaled
+     * screen size. Must be followed by end() in the same frame.
+     */
+    void begin();
+
+    /**
+     * Finishes rendering the scene and upscales it.
+     *
+     * Rebinds the frame buffer and game viewport that were set before begin() and
+     * draws the scene into the viewport.
+     */
+    void end();
+
+private:
+
+    struct TimerQuery
+    {
+        GLuint begin;
+        GLuint end;
+        bool pending;
+    };
+
+    /**
+     * Constructor.
+     */
+    DynamicResolution();
+
+    /**
+     * Destructor.
+     */
+    ~DynamicResolution();
+
+    /**
+     * Hidden copy constructor.
+     */
+    DynamicResolution(const DynamicResolution& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    DynamicResolution& operator=(const DynamicResolution&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'dynamicResolution' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to release the frame buffer and timer queries.
+     */
+    void finalize();
+
+    /**
+     * Called at the start of each frame to read back the measured times and adjust the scale.
+     */
+    void update();
+
+    /**
+     * Adjusts the scale from the time of one frame.
+     */
+    void adjustScale(float frameTime);
+
+    /**
+     * Creates the frame buffer for the current screen size, if it does not have that size already.
+     */
+    bool createFrameBuffer();
+
+    bool _enabled;
+    bool _timerQueries;
+    bool _rendering;
+    float _scale;
+    float _minScale;
+    float _maxScale;
+    float _targetFrameTime;
+    float _frameTime;
+    unsigned int _cooldown;
+    double _lastFrameStart;
+    FrameBuffer* _frameBuffer;
+    SpriteBatch* _spriteBatch;
+    unsigned int _screenWidth;
+    unsigned int _screenHeight;
+    FrameBuffer* _previousFrameBuffer;
+    Rectangle _previousViewport;
+    Rectangle _scaledViewport;
+    std::vector<TimerQuery> _queries;
+    unsigned int _queryIndex;
+};
+
+}
+
+#endif
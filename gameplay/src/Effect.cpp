@@ -1,16 +1,35 @@
 #include "Base.h"
 #include "Effect.h"
 #include "FileSystem.h"
+#include "InstanceBuffer.h"
+#include "ResourceCache.h"
+#include "ProgramCache.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "Game.h"
+#include "LoadProfiler.h"
+#include "DebugMarkers.h"
 
 #define OPENGL_ES_DEFINE  "#define OPENGL_ES\n"
+#define INSTANCING_UNIFORM_DEFINE  "#define INSTANCING_UNIFORM\n"
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 namespace gameplay
 {
 
 // Cache of unique effects.
-static std::map<std::string, Effect*> __effectCache;
+static ResourceCache __effectCache("effects");
 static Effect* __currentEffect = NULL;
 
+// Effects kept loaded by precompile(), and the manifest that new effects are recorded to.
+static std::vector<Effect*> __precompiledEffects;
+static std::string __manifestPath;
+static std::set<std::string> __manifestEntries;
+
 Effect::Effect() : _program(0)
 {
 }
@@ -18,7 +37,7 @@ Effect::Effect() : _program(0)
 Effect::~Effect()
 {
     // Remove this effect from the cache.
-    __effectCache.erase(_id);
+    __effectCache.remove(ResourceCache::Key(_id.c_str()), this);
 
     // Free uniforms.
     for (std::map<std::string, Uniform*>::iterator itr = _uniforms.begin(); itr != _uniforms.end(); ++itr)
@@ -28,41 +47,48 @@ Effect::~Effect()
 
     if (_program)
     {
-        // If our program object is currently bound, unbind it before we're destroyed.
         if (__currentEffect == this)
         {
-            GL_ASSERT( glUseProgram(0) );
             __currentEffect = NULL;
         }
 
-        GL_ASSERT( glDeleteProgram(_program) );
+        // The state cache unbinds the program first if it is current.
+        StateCache::deleteProgram(_program);
         _program = 0;
     }
 }
 
+/**
+ * Replaces the joint count of skinned defines when the game reads the matrix palettes from a texture,
+ * so that skins of every joint count share one effect, and selects dual quaternion palettes when enabled.
+ */
+static const char* replaceSkinningDefines(const char* defines, std::string& out)
+{
+    Game* game = Game::getInstance();
+    MatrixPaletteTexture* palettes = game ? game->getMatrixPaletteTexture() : NULL;
+    return palettes && palettes->replaceDefines(defines, out) ? out.c_str() : defines;
+}
+
 Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const char* defines)
 {
     GP_ASSERT(vshPath);
     GP_ASSERT(fshPath);
 
+    std::string skinningDefines;
+    defines = replaceSkinningDefines(defines, skinningDefines);
+
     // Search the effect cache for an identical effect that is already loaded.
-    std::string uniqueId = vshPath;
-    uniqueId += ';';
-    uniqueId += fshPath;
-    uniqueId += ';';
-    if (defines)
-    {
-        uniqueId += defines;
-    }
-    std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(uniqueId);
-    if (itr != __effectCache.end())
+    ResourceCache::Key key(vshPath, fshPath, defines ? defines : "");
+    Effect* cached = static_cast<Effect*>(__effectCache.find(key));
+    if (cached)
     {
         // Found an exiting effect with this id, so increase its ref count and return it.
-        GP_ASSERT(itr->second);
-        itr->second->addRef();
-        return itr->second;
+        cached->addRef();
+        return cached;
     }
 
+    LoadProfiler::Scope profile("effect", fshPath, defines && defines[0] != '\0' ? defines : NULL);
+
     // Read source from file.
     char* vshSource = FileSystem::readAll(vshPath);
     if (vshSource == NULL)
@@ -78,8 +104,13 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
         return NULL;
     }
 
-    Effect* effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
-    
+    // Compiling and linking the program is timed as its upload.
+    Effect* effect;
+    {
+        LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
+        effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
+    }
+
     SAFE_DELETE_ARRAY(vshSource);
     SAFE_DELETE_ARRAY(fshSource);
 
@@ -90,8 +121,12 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
     else
     {
         // Store this effect in the cache.
-        effect->_id = uniqueId;
-        __effectCache[uniqueId] = effect;
+        effect->_id = key.toString();
+        __effectCache.add(key, effect);
+        DebugMarkers::setLabel(GL_PROGRAM, effect->_program, effect->_id.c_str());
+
+        if (!__manifestPath.empty())
+            recordEffect(key, vshPath, fshPath, defines);
     }
 
     return effect;
@@ -115,6 +150,10 @@ static void replaceDefines(const char* defines, std::string& out)
         }
         out += "\n";
     }
+    if (!InstanceBuffer::isHardwareInstancingSupported())
+    {
+        out.insert(0, INSTANCING_UNIFORM_DEFINE);
+    }
 #ifdef OPENGL_ES
     out.insert(0, OPENGL_ES_DEFINE);
 #endif
@@ -206,44 +245,135 @@ static void writeShaderToErrorFile(const char* filePath, const char* source)
     }
 }
 
-Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
+struct ProgramBuild
 {
-    GP_ASSERT(vshSource);
-    GP_ASSERT(fshSource);
-
-    const unsigned int SHADER_SOURCE_LENGTH = 3;
-    const GLchar* shaderSource[SHADER_SOURCE_LENGTH];
-    char* infoLog = NULL;
     GLuint vertexShader;
     GLuint fragmentShader;
     GLuint program;
-    GLint length;
-    GLint success;
+};
 
-    // Replace all comma separated definitions with #define prefix and \n suffix
-    std::string definesStr = "";
-    replaceDefines(defines, definesStr);
-    
-    shaderSource[0] = definesStr.c_str();
-    shaderSource[1] = "\n";
-    std::string vshSourceStr = "";
-    if (vshPath)
+static void expandSource(const char* path, const char* source, std::string& out)
+{
+    if (path)
     {
         // Replace the #include "xxxxx.xxx" with the sources that come from file paths
-        replaceIncludes(vshPath, vshSource, vshSourceStr);
-        if (vshSource && strlen(vshSource) != 0)
-            vshSourceStr += "\n";
-            
-        //writeShaderToErrorFile(vshPath, vshSourceStr.c_str());   // Debugging
+        replaceIncludes(path, source, out);
+        if (source && strlen(source) != 0)
+            out += "\n";
+
+        //writeShaderToErrorFile(path, out.c_str());   // Debugging
+    }
+    else
+    {
+        out = source;
+    }
+}
+
+/**
+ * The fixed locations of the standard vertex attributes.
+ *
+ * Binding every effect's attributes to the same locations lets the effects drawing a mesh
+ * share one vertex attribute binding, and one VAO, instead of each effect needing its own.
+ * Position stays at location 0, which some drivers require to be enabled for drawing.
+ * Attributes whose locations would exceed the limit of the device are left to the linker.
+ */
+struct AttributeLocation
+{
+    const char* name;
+    GLuint location;
+    GLuint count;       // Number of locations the attribute occupies.
+};
+
+static const AttributeLocation __attributeLocations[] =
+{
+    { VERTEX_ATTRIBUTE_POSITION_NAME, 0, 1 },
+    { VERTEX_ATTRIBUTE_NORMAL_NAME, 1, 1 },
+    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, 2, 1 },
+    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME "0", 2, 1 },
+    { VERTEX_ATTRIBUTE_TANGENT_NAME, 3, 1 },
+    { VERTEX_ATTRIBUTE_BINORMAL_NAME, 4, 1 },
+    { VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME, 5, 1 },
+    { VERTEX_ATTRIBUTE_BLENDINDICES_NAME, 6, 1 },
+    { VERTEX_ATTRIBUTE_COLOR_NAME, 7, 1 },
+    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME "1", 8, 1 },
+    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME "2", 9, 1 },
+    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME "3", 10, 1 },
+    { VERTEX_ATTRIBUTE_INSTANCE_DATA_NAME, 11, 1 },
+    { VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME, 12, 4 }
+};
+
+static GLint __maxVertexAttribs = 0;
+
+static void bindAttributeLocations(GLuint program)
+{
+    if (__maxVertexAttribs == 0)
+    {
+        GL_ASSERT( glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &__maxVertexAttribs) );
     }
-    shaderSource[2] = vshPath ? vshSourceStr.c_str() :  vshSource;
-    GL_ASSERT( vertexShader = glCreateShader(GL_VERTEX_SHADER) );
-    GL_ASSERT( glShaderSource(vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
-    GL_ASSERT( glCompileShader(vertexShader) );
-    GL_ASSERT( glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success) );
+
+    // Names the shaders do not declare are ignored by the linker.
+    for (size_t i = 0, count = sizeof(__attributeLocations) / sizeof(__attributeLocations[0]); i < count; ++i)
+    {
+        const AttributeLocation& attribute = __attributeLocations[i];
+        if (attribute.location + attribute.count <= (GLuint)__maxVertexAttribs)
+        {
+            GL_ASSERT( glBindAttribLocation(program, attribute.location, attribute.name) );
+        }
+    }
+}
+
+static void beginProgram(const char* definesStr, const char* vertexSource, const char* fragmentSource, ProgramBuild* build,
+                         const char** feedbackVaryings = NULL, unsigned int feedbackVaryingCount = 0)
+{
+    // Compile and link without querying any status, so that drivers that compile
+    // in parallel can work on several programs at once.
+    const unsigned int SHADER_SOURCE_LENGTH = 3;
+    const GLchar* shaderSource[SHADER_SOURCE_LENGTH];
+    shaderSource[0] = definesStr;
+    shaderSource[1] = "\n";
+
+    shaderSource[2] = vertexSource;
+    GL_ASSERT( build->vertexShader = glCreateShader(GL_VERTEX_SHADER) );
+    GL_ASSERT( glShaderSource(build->vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
+    GL_ASSERT( glCompileShader(build->vertexShader) );
+
+    shaderSource[2] = fragmentSource;
+    GL_ASSERT( build->fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
+    GL_ASSERT( glShaderSource(build->fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
+    GL_ASSERT( glCompileShader(build->fragmentShader) );
+
+    GL_ASSERT( build->program = glCreateProgram() );
+    GL_ASSERT( glAttachShader(build->program, build->vertexShader) );
+    GL_ASSERT( glAttachShader(build->program, build->fragmentShader) );
+#ifdef USE_TRANSFORM_FEEDBACK
+    if (feedbackVaryingCount > 0)
+    {
+        GL_ASSERT( glTransformFeedbackVaryings(build->program, feedbackVaryingCount, feedbackVaryings, GL_INTERLEAVED_ATTRIBS) );
+    }
+#endif
+    bindAttributeLocations(build->program);
+    ProgramCache::prepareProgram(build->program);
+    GL_ASSERT( glLinkProgram(build->program) );
+}
+
+static bool isProgramComplete(const ProgramBuild& build)
+{
+    GLint complete = GL_TRUE;
+    GL_ASSERT( glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete) );
+    return complete == GL_TRUE;
+}
+
+static GLuint finishProgram(ProgramBuild* build, const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource,
+                            const char* vertexSource, const char* fragmentSource)
+{
+    char* infoLog = NULL;
+    GLint length;
+    GLint success;
+
+    GL_ASSERT( glGetShaderiv(build->vertexShader, GL_COMPILE_STATUS, &success) );
     if (success != GL_TRUE)
     {
-        GL_ASSERT( glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &length) );
+        GL_ASSERT( glGetShaderiv(build->vertexShader, GL_INFO_LOG_LENGTH, &length) );
         if (length == 0)
         {
             length = 4096;
@@ -251,42 +381,29 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
         if (length > 0)
         {
             infoLog = new char[length];
-            GL_ASSERT( glGetShaderInfoLog(vertexShader, length, NULL, infoLog) );
+            GL_ASSERT( glGetShaderInfoLog(build->vertexShader, length, NULL, infoLog) );
             infoLog[length-1] = '\0';
         }
 
         // Write out the expanded shader file.
         if (vshPath)
-            writeShaderToErrorFile(vshPath, shaderSource[2]);
+            writeShaderToErrorFile(vshPath, vertexSource);
 
         GP_ERROR("Compile failed for vertex shader '%s' with error '%s'.", vshPath == NULL ? vshSource : vshPath, infoLog == NULL ? "" : infoLog);
         SAFE_DELETE_ARRAY(infoLog);
 
         // Clean up.
-        GL_ASSERT( glDeleteShader(vertexShader) );
+        GL_ASSERT( glDeleteShader(build->vertexShader) );
+        GL_ASSERT( glDeleteShader(build->fragmentShader) );
+        StateCache::deleteProgram(build->program);
 
-        return NULL;
+        return 0;
     }
 
-    // Compile the fragment shader.
-    std::string fshSourceStr;
-    if (fshPath)
-    {
-        // Replace the #include "xxxxx.xxx" with the sources that come from file paths
-        replaceIncludes(fshPath, fshSource, fshSourceStr);
-        if (fshSource && strlen(fshSource) != 0)
-            fshSourceStr += "\n";
-
-        //writeShaderToErrorFile(fshPath, fshSourceStr.c_str()); // Debugging
-    }
-    shaderSource[2] = fshPath ? fshSourceStr.c_str() : fshSource;
-    GL_ASSERT( fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
-    GL_ASSERT( glShaderSource(fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
-    GL_ASSERT( glCompileShader(fragmentShader) );
-    GL_ASSERT( glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success) );
+    GL_ASSERT( glGetShaderiv(build->fragmentShader, GL_COMPILE_STATUS, &success) );
     if (success != GL_TRUE)
     {
-        GL_ASSERT( glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &length) );
+        GL_ASSERT( glGetShaderiv(build->fragmentShader, GL_INFO_LOG_LENGTH, &length) );
         if (length == 0)
         {
             length = 4096;
@@ -294,34 +411,31 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
         if (length > 0)
         {
             infoLog = new char[length];
-            GL_ASSERT( glGetShaderInfoLog(fragmentShader, length, NULL, infoLog) );
+            GL_ASSERT( glGetShaderInfoLog(build->fragmentShader, length, NULL, infoLog) );
             infoLog[length-1] = '\0';
         }
         
         // Write out the expanded shader file.
         if (fshPath)
-            writeShaderToErrorFile(fshPath, shaderSource[2]);
+            writeShaderToErrorFile(fshPath, fragmentSource);
 
         GP_ERROR("Compile failed for fragment shader (%s): %s", fshPath == NULL ? fshSource : fshPath, infoLog == NULL ? "" : infoLog);
         SAFE_DELETE_ARRAY(infoLog);
 
         // Clean up.
-        GL_ASSERT( glDeleteShader(vertexShader) );
-        GL_ASSERT( glDeleteShader(fragmentShader) );
+        GL_ASSERT( glDeleteShader(build->vertexShader) );
+        GL_ASSERT( glDeleteShader(build->fragmentShader) );
+        StateCache::deleteProgram(build->program);
 
-        return NULL;
+        return 0;
     }
 
-    // Link program.
-    GL_ASSERT( program = glCreateProgram() );
-    GL_ASSERT( glAttachShader(program, vertexShader) );
-    GL_ASSERT( glAttachShader(program, fragmentShader) );
-    GL_ASSERT( glLinkProgram(program) );
+    GLuint program = build->program;
     GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
 
     // Delete shaders after linking.
-    GL_ASSERT( glDeleteShader(vertexShader) );
-    GL_ASSERT( glDeleteShader(fragmentShader) );
+    GL_ASSERT( glDeleteShader(build->vertexShader) );
+    GL_ASSERT( glDeleteShader(build->fragmentShader) );
 
     // Check link status.
     if (success != GL_TRUE)
@@ -341,22 +455,111 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
         SAFE_DELETE_ARRAY(infoLog);
 
         // Clean up.
-        GL_ASSERT( glDeleteProgram(program) );
+        StateCache::deleteProgram(program);
+
+        return 0;
+    }
+
+    return program;
+}
+
+Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
+{
+    GP_ASSERT(vshSource);
+    GP_ASSERT(fshSource);
+
+    // Replace all comma separated definitions with #define prefix and \n suffix
+    std::string definesStr = "";
+    replaceDefines(defines, definesStr);
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    expandSource(vshPath, vshSource, vertexSource);
+    expandSource(fshPath, fshSource, fragmentSource);
+
+    // Reuse the program binary saved by a previous run if the sources and the driver are unchanged.
+    GLuint program = 0;
+    unsigned long long binaryKey = 0;
+    if (ProgramCache::isEnabled())
+    {
+        binaryKey = ProgramCache::computeKey(definesStr.c_str(), vertexSource.c_str(), fragmentSource.c_str());
+        program = ProgramCache::load(binaryKey);
+    }
+    if (program == 0)
+    {
+        ProgramBuild build;
+        beginProgram(definesStr.c_str(), vertexSource.c_str(), fragmentSource.c_str(), &build);
+        program = finishProgram(&build, vshPath, vshSource, fshPath, fshSource, vertexSource.c_str(), fragmentSource.c_str());
+        if (program == 0)
+            return NULL;
+
+        if (ProgramCache::isEnabled())
+            ProgramCache::save(binaryKey, program);
+    }
 
+    return createFromProgram(program);
+}
+
+Effect* Effect::createTransformFeedback(const char* vshPath, const char* fshPath, const char** varyings, unsigned int varyingCount)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+    GP_ASSERT(varyings && varyingCount > 0);
+
+#ifdef USE_TRANSFORM_FEEDBACK
+    char* vshSource = FileSystem::readAll(vshPath);
+    if (vshSource == NULL)
+    {
+        GP_ERROR("Failed to read vertex shader from file '%s'.", vshPath);
         return NULL;
     }
+    char* fshSource = FileSystem::readAll(fshPath);
+    if (fshSource == NULL)
+    {
+        GP_ERROR("Failed to read fragment shader from file '%s'.", fshPath);
+        SAFE_DELETE_ARRAY(vshSource);
+        return NULL;
+    }
+
+    std::string definesStr = "";
+    replaceDefines(NULL, definesStr);
+
+    std::string vertexSource;
+    std::string fragmentSource;
+    expandSource(vshPath, vshSource, vertexSource);
+    expandSource(fshPath, fshSource, fragmentSource);
+
+    ProgramBuild build;
+    beginProgram(definesStr.c_str(), vertexSource.c_str(), fragmentSource.c_str(), &build, varyings, varyingCount);
+    GLuint program = finishProgram(&build, vshPath, vshSource, fshPath, fshSource, vertexSource.c_str(), fragmentSource.c_str());
+
+    SAFE_DELETE_ARRAY(vshSource);
+    SAFE_DELETE_ARRAY(fshSource);
+
+    if (program == 0)
+    {
+        GP_ERROR("Failed to create transform feedback effect from shaders '%s', '%s'.", vshPath, fshPath);
+        return NULL;
+    }
+    return createFromProgram(program);
+#else
+    GP_ERROR("Transform feedback is not supported on this platform.");
+    return NULL;
+#endif
+}
+
+Effect* Effect::createFromProgram(GLuint program)
+{
+    GLint length;
 
     // Create and return the new Effect.
     Effect* effect = new Effect();
     effect->_program = program;
 
     // Query and store vertex attribute meta-data from the program.
-    // NOTE: Rather than using glBindAttribLocation to explicitly specify our own
-    // preferred attribute locations, we're going to query the locations that were
-    // automatically bound by the GPU. While it can sometimes be convenient to use
-    // glBindAttribLocation, some vendors actually reserve certain attribute indices
-    // and therefore using this function can create compatibility issues between
-    // different hardware vendors.
+    // NOTE: The standard attributes are bound to fixed locations before linking, but the
+    // locations are still queried: attributes outside the fixed set are placed by the
+    // linker, and programs loaded from binaries keep the locations they were linked with.
     GLint activeAttributes;
     GL_ASSERT( glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &activeAttributes) );
     if (activeAttributes > 0)
@@ -423,6 +626,7 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
                 uniform->_name = uniformName;
                 uniform->_location = uniformLocation;
                 uniform->_type = uniformType;
+                uniform->_size = uniformSize > 0 ? (unsigned int)uniformSize : 1;
                 if (uniformType == GL_SAMPLER_2D)
                 {
                     uniform->_index = samplerIndex;
@@ -480,79 +684,115 @@ unsigned int Effect::getUniformCount() const
 void Effect::setValue(Uniform* uniform, float value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1f(uniform->_location, value) );
+    if (uniform->updateValue(&value, sizeof(float)))
+    {
+        RenderCommandList::uniform(uniform->_location, &value, 1, 1);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const float* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1fv(uniform->_location, count, values) );
+    if (uniform->updateValue(values, sizeof(float) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, values, count, 1);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, int value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1i(uniform->_location, value) );
+    if (uniform->updateValue(&value, sizeof(int)))
+    {
+        RenderCommandList::uniform(uniform->_location, &value, 1);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const int* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1iv(uniform->_location, count, values) );
+    if (uniform->updateValue(values, sizeof(int) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, values, count);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, value.m) );
+    if (uniform->updateValue(value.m, sizeof(value.m)))
+    {
+        RenderCommandList::uniform(uniform->_location, value.m, 1, 16);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, count, GL_FALSE, (GLfloat*)values) );
+    if (uniform->updateValue(values, sizeof(Matrix) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, (const GLfloat*)values, count, 16);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform2f(uniform->_location, value.x, value.y) );
+    if (uniform->updateValue(&value, sizeof(Vector2)))
+    {
+        RenderCommandList::uniform(uniform->_location, &value.x, 1, 2);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform2fv(uniform->_location, count, (GLfloat*)values) );
+    if (uniform->updateValue(values, sizeof(Vector2) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, (const GLfloat*)values, count, 2);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform3f(uniform->_location, value.x, value.y, value.z) );
+    if (uniform->updateValue(&value, sizeof(Vector3)))
+    {
+        RenderCommandList::uniform(uniform->_location, &value.x, 1, 3);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform3fv(uniform->_location, count, (GLfloat*)values) );
+    if (uniform->updateValue(values, sizeof(Vector3) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, (const GLfloat*)values, count, 3);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform4f(uniform->_location, value.x, value.y, value.z, value.w) );
+    if (uniform->updateValue(&value, sizeof(Vector4)))
+    {
+        RenderCommandList::uniform(uniform->_location, &value.x, 1, 4);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform4fv(uniform->_location, count, (GLfloat*)values) );
+    if (uniform->updateValue(values, sizeof(Vector4) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, (const GLfloat*)values, count, 4);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler* sampler)
@@ -561,12 +801,16 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler* sampler)
     GP_ASSERT(uniform->_type == GL_SAMPLER_2D);
     GP_ASSERT(sampler);
 
-    GL_ASSERT( glActiveTexture(GL_TEXTURE0 + uniform->_index) );
+    Texture::setActiveUnit(uniform->_index);
 
     // Bind the sampler - this binds the texture and applies sampler state
     const_cast<Texture::Sampler*>(sampler)->bind();
 
-    GL_ASSERT( glUniform1i(uniform->_location, uniform->_index) );
+    GLint unit = (GLint)uniform->_index;
+    if (uniform->updateValue(&unit, sizeof(GLint)))
+    {
+        RenderCommandList::uniform(uniform->_location, &unit, 1);
+    }
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigned int count)
@@ -579,7 +823,7 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigne
     GLint units[32];
     for (unsigned int i = 0; i < count; ++i)
     {
-        GL_ASSERT( glActiveTexture(GL_TEXTURE0 + uniform->_index + i) );
+        Texture::setActiveUnit(uniform->_index + i);
 
         // Bind the sampler - this binds the texture and applies sampler state
         const_cast<Texture::Sampler*>(values[i])->bind();
@@ -588,13 +832,51 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigne
     }
 
     // Pass texture unit array to GL
-    GL_ASSERT( glUniform1iv(uniform->_location, count, units) );
+    if (uniform->updateValue(units, sizeof(GLint) * count))
+    {
+        RenderCommandList::uniform(uniform->_location, units, count);
+    }
 }
 
-void Effect::bind()
+bool Effect::setUniformBuffer(const char* blockName, UniformBuffer* buffer, unsigned int bindingPoint)
 {
-   GL_ASSERT( glUseProgram(_program) );
+    GP_ASSERT(blockName);
+    GP_ASSERT(buffer);
+
+#ifdef USE_UNIFORM_BUFFERS
+    if (!UniformBuffer::isSupported())
+        return false;
+
+    std::map<std::string, std::pair<GLuint, unsigned int> >::iterator itr = _uniformBlocks.find(blockName);
+    if (itr == _uniformBlocks.end())
+    {
+        GLuint blockIndex;
+        GL_ASSERT( blockIndex = glGetUniformBlockIndex(_program, blockName) );
+        if (blockIndex == GL_INVALID_INDEX)
+        {
+            GP_WARN("Uniform block '%s' does not exist in effect '%s'.", blockName, _id.c_str());
+            return false;
+        }
+        GL_ASSERT( glUniformBlockBinding(_program, blockIndex, bindingPoint) );
+        _uniformBlocks[blockName] = std::make_pair(blockIndex, bindingPoint);
+    }
+    else if (itr->second.second != bindingPoint)
+    {
+        GL_ASSERT( glUniformBlockBinding(_program, itr->second.first, bindingPoint) );
+        itr->second.second = bindingPoint;
+    }
+
+    buffer->bind(bindingPoint);
+    return true;
+#else
+    return false;
+#endif
+}
 
+void Effect::bind()
+{
+    // The state cache skips redundant program changes; consecutive draws frequently share an effect.
+    StateCache::useProgram(_program);
     __currentEffect = this;
 }
 
@@ -603,14 +885,227 @@ Effect* Effect::getCurrentEffect()
     return __currentEffect;
 }
 
+static bool isParallelCompileSupported()
+{
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    return extensions && (strstr(extensions, "GL_KHR_parallel_shader_compile") || strstr(extensions, "GL_ARB_parallel_shader_compile"));
+}
+
+struct PrecompiledEffect
+{
+    std::string vshPath;
+    std::string fshPath;
+    std::string defines;
+    std::string definesStr;
+    std::string vertexSource;
+    std::string fragmentSource;
+    unsigned long long binaryKey;
+    ProgramBuild build;
+    GLuint program;         // Set when the program was loaded from the program cache.
+};
+
+unsigned int Effect::precompile(const char* manifestPath)
+{
+    GP_ASSERT(manifestPath);
+
+    Properties* manifest = Properties::create(manifestPath);
+    if (manifest == NULL)
+    {
+        GP_ERROR("Failed to load effect manifest '%s'.", manifestPath);
+        return 0;
+    }
+
+    // Submit every effect that is not loaded yet.
+    unsigned int count = 0;
+    std::vector<PrecompiledEffect*> pending;
+    std::set<std::string> submitted;
+    Properties* ns;
+    while ((ns = manifest->getNextNamespace()) != NULL)
+    {
+        if (strcmp(ns->getNamespace(), "effect") != 0)
+            continue;
+
+        const char* vshPath = ns->getString("vertexShader");
+        const char* fshPath = ns->getString("fragmentShader");
+        const char* defines = ns->getString("defines");
+        if (vshPath == NULL || fshPath == NULL)
+        {
+            GP_WARN("Effect in manifest '%s' is missing its vertex or fragment shader.", manifestPath);
+            continue;
+        }
+        std::string skinningDefines;
+        defines = replaceSkinningDefines(defines, skinningDefines);
+
+        // Entries that differ only by their joint count are the same effect with the palette texture.
+        ResourceCache::Key key(vshPath, fshPath, defines ? defines : "");
+        if (__effectCache.find(key))
+        {
+            ++count;
+            continue;
+        }
+        if (!submitted.insert(key.toString()).second)
+            continue;
+
+        char* vshSource = FileSystem::readAll(vshPath);
+        char* fshSource = FileSystem::readAll(fshPath);
+        if (vshSource == NULL || fshSource == NULL)
+        {
+            GP_ERROR("Failed to read shaders '%s', '%s' listed in effect manifest '%s'.", vshPath, fshPath, manifestPath);
+            SAFE_DELETE_ARRAY(vshSource);
+            SAFE_DELETE_ARRAY(fshSource);
+            continue;
+        }
+
+        PrecompiledEffect* effect = new PrecompiledEffect();
+        effect->vshPath = vshPath;
+        effect->fshPath = fshPath;
+        effect->defines = defines ? defines : "";
+        replaceDefines(defines, effect->definesStr);
+        expandSource(vshPath, vshSource, effect->vertexSource);
+        expandSource(fshPath, fshSource, effect->fragmentSource);
+        SAFE_DELETE_ARRAY(vshSource);
+        SAFE_DELETE_ARRAY(fshSource);
+
+        effect->binaryKey = 0;
+        effect->program = 0;
+        if (ProgramCache::isEnabled())
+        {
+            effect->binaryKey = ProgramCache::computeKey(effect->definesStr.c_str(), effect->vertexSource.c_str(), effect->fragmentSource.c_str());
+            effect->program = ProgramCache::load(effect->binaryKey);
+        }
+        if (effect->program == 0)
+        {
+            beginProgram(effect->definesStr.c_str(), effect->vertexSource.c_str(), effect->fragmentSource.c_str(), &effect->build);
+        }
+        pending.push_back(effect);
+    }
+    SAFE_DELETE(manifest);
+
+    // Finish the programs, those that the driver has completed first.
+    bool parallel = isParallelCompileSupported();
+    while (!pending.empty())
+    {
+        size_t index = 0;
+        if (parallel)
+        {
+            for (size_t i = 0, pendingCount = pending.size(); i < pendingCount; ++i)
+            {
+                if (pending[i]->program || isProgramComplete(pending[i]->build))
+                {
+                    index = i;
+                    break;
+                }
+            }
+        }
+
+        PrecompiledEffect* p = pending[index];
+        pending.erase(pending.begin() + index);
+
+        GLuint program = p->program;
+        if (program == 0)
+        {
+            program = finishProgram(&p->build, p->vshPath.c_str(), NULL, p->fshPath.c_str(), NULL, p->vertexSource.c_str(), p->fragmentSource.c_str());
+            if (program && ProgramCache::isEnabled())
+                ProgramCache::save(p->binaryKey, program);
+        }
+
+        if (program)
+        {
+            ResourceCache::Key key(p->vshPath.c_str(), p->fshPath.c_str(), p->defines.c_str());
+            Effect* effect = createFromProgram(program);
+            effect->_id = key.toString();
+            __effectCache.add(key, effect);
+            __precompiledEffects.push_back(effect);
+            ++count;
+        }
+        SAFE_DELETE(p);
+    }
+
+    return count;
+}
+
+void Effect::recordManifest(const char* manifestPath)
+{
+    __manifestEntries.clear();
+    __manifestPath = manifestPath ? manifestPath : "";
+    if (manifestPath == NULL || !FileSystem::fileExists(manifestPath))
+        return;
+
+    // Remember the effects that are already listed.
+    Properties* manifest = Properties::create(manifestPath);
+    if (manifest)
+    {
+        Properties* ns;
+        while ((ns = manifest->getNextNamespace()) != NULL)
+        {
+            const char* vshPath = ns->getString("vertexShader");
+            const char* fshPath = ns->getString("fragmentShader");
+            const char* defines = ns->getString("defines");
+            if (strcmp(ns->getNamespace(), "effect") == 0 && vshPath && fshPath)
+            {
+                __manifestEntries.insert(ResourceCache::Key(vshPath, fshPath, defines ? defines : "").toString());
+            }
+        }
+        SAFE_DELETE(manifest);
+    }
+}
+
+void Effect::recordEffect(const ResourceCache::Key& key, const char* vshPath, const char* fshPath, const char* defines)
+{
+    if (!__manifestEntries.insert(key.toString()).second)
+        return;
+
+    FILE* file = FileSystem::openFile(__manifestPath.c_str(), "ab");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to open effect manifest '%s' for recording.", __manifestPath.c_str());
+        return;
+    }
+
+    fprintf(file, "effect\n{\n    vertexShader = %s\n    fragmentShader = %s\n", vshPath, fshPath);
+    if (defines && strlen(defines) > 0)
+    {
+        fprintf(file, "    defines = %s\n", defines);
+    }
+    fprintf(file, "}\n\n");
+    fclose(file);
+}
+
+void Effect::finalize()
+{
+    for (size_t i = 0, count = __precompiledEffects.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(__precompiledEffects[i]);
+    }
+    __precompiledEffects.clear();
+    recordManifest(NULL);
+}
+
 Uniform::Uniform() :
-    _location(-1), _type(0), _index(0)
+    _location(-1), _type(0), _size(1), _index(0), _effect(NULL), _value(NULL), _valueSize(0)
 {
 }
 
 Uniform::~Uniform()
 {
-    // hidden
+    SAFE_DELETE_ARRAY(_value);
+}
+
+bool Uniform::updateValue(const void* value, unsigned int size)
+{
+    GP_ASSERT(value);
+
+    if (size == _valueSize && memcmp(_value, value, size) == 0)
+        return false;
+
+    if (size != _valueSize)
+    {
+        SAFE_DELETE_ARRAY(_value);
+        _value = new unsigned char[size];
+        _valueSize = size;
+    }
+    memcpy(_value, value, size);
+    return true;
 }
 
 Effect* Uniform::getEffect() const
@@ -628,4 +1123,9 @@ const GLenum Uniform::getType() const
     return _type;
 }
 
+unsigned int Uniform::getSize() const
+{
+    return _size;
+}
+
 }
@@ -7,6 +7,8 @@
 #include "Vector4.h"
 #include "Matrix.h"
 #include "Texture.h"
+#include "UniformBuffer.h"
+#include "ResourceCache.h"
 
 namespace gameplay
 {
@@ -25,6 +27,9 @@ class Uniform;
  */
 class Effect: public Ref
 {
+    friend class Game;
+    friend class ParticleEmitter;
+
 public:
 
     /**
@@ -210,6 +215,21 @@ public:
      */
     void setValue(Uniform* uniform, const Texture::Sampler** values, unsigned int count);
 
+    /**
+     * Binds a uniform buffer to a uniform block of this effect.
+     *
+     * Uniform blocks are only available with OpenGL 3.1 or later and shaders
+     * that declare them; on other devices this method does nothing and returns false.
+     *
+     * @param blockName The name of the uniform block in the shader.
+     * @param buffer The uniform buffer holding the block data.
+     * @param bindingPoint The uniform buffer binding point to use for the block.
+     *
+     * @return true if the buffer was bound to the block, false otherwise.
+     * @script{ignore}
+     */
+    bool setUniformBuffer(const char* blockName, UniformBuffer* buffer, unsigned int bindingPoint = 0);
+
     /**
      * Binds this effect to make it the currently active effect for the rendering system.
      */
@@ -222,6 +242,53 @@ public:
      */
     static Effect* getCurrentEffect();
 
+    /**
+     * Compiles every effect listed in a manifest ahead of its first use.
+     *
+     * The manifest lists one 'effect' namespace for each permutation:
+     *
+     * @verbatim
+        effect
+        {
+            vertexShader = res/shaders/textured.vert
+            fragmentShader = res/shaders/textured.frag
+            defines = DIRECTIONAL_LIGHT_COUNT 1
+        }
+       @endverbatim
+     *
+     * All programs are submitted to the driver before any of them is queried. With
+     * GL_KHR_parallel_shader_compile, they are finished in the order the driver
+     * completes them. The precompiled effects stay loaded until the game shuts down.
+     *
+     * This can be called behind a loading screen, or at startup by setting the
+     * manifest in the 'effects' namespace of the game config:
+     *
+     * @verbatim
+        effects
+        {
+            manifest = res/effects.manifest
+            precompile = true       // Precompile the manifest at startup (default).
+            record = false          // Append the effects created at runtime to the manifest.
+        }
+       @endverbatim
+     *
+     * @param manifestPath The path of the manifest.
+     *
+     * @return The number of effects of the manifest that are loaded.
+     * @script{ignore}
+     */
+    static unsigned int precompile(const char* manifestPath);
+
+    /**
+     * Records the effects created from files to a manifest that can be passed to precompile().
+     *
+     * Effects that are already listed in the manifest are not added again.
+     *
+     * @param manifestPath The path of the manifest, or NULL to stop recording.
+     * @script{ignore}
+     */
+    static void recordManifest(const char* manifestPath);
+
 private:
 
     /**
@@ -241,10 +308,34 @@ private:
 
     static Effect* createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines = NULL);
 
+    /**
+     * Creates an effect for a linked program and queries its attributes and uniforms.
+     */
+    static Effect* createFromProgram(GLuint program);
+
+    /**
+     * Creates an effect whose vertex shader outputs are captured into transform feedback buffers.
+     *
+     * The varyings are captured interleaved into a single buffer, in the order given.
+     * These effects are neither cached nor saved to the program cache.
+     */
+    static Effect* createTransformFeedback(const char* vshPath, const char* fshPath, const char** varyings, unsigned int varyingCount);
+
+    /**
+     * Appends an effect created from files to the recorded manifest.
+     */
+    static void recordEffect(const ResourceCache::Key& key, const char* vshPath, const char* fshPath, const char* defines);
+
+    /**
+     * Called during shutdown to release the precompiled effects.
+     */
+    static void finalize();
+
     GLuint _program;
     std::string _id;
     std::map<std::string, VertexAttribute> _vertexAttributes;
     std::map<std::string, Uniform*> _uniforms;
+    std::map<std::string, std::pair<GLuint, unsigned int> > _uniformBlocks;
     static Uniform _emptyUniform;
 };
 
@@ -271,6 +362,17 @@ public:
      */
     const GLenum getType() const;
 
+    /**
+     * Returns the number of elements of this uniform, which is 1 unless it is an array.
+     *
+     * For an array, this is the number of elements the program uses, which drivers
+     * may report as less than the declared size if the last ones are never read.
+     *
+     * @return The number of elements of the uniform.
+     * @script{ignore}
+     */
+    unsigned int getSize() const;
+
     /**
      * Returns the effect for this uniform.
      *
@@ -300,11 +402,27 @@ private:
      */
     Uniform& operator=(const Uniform&);
 
+    /**
+     * Stores the value last uploaded for this uniform.
+     *
+     * Uniform values are part of the program state, so an upload can be
+     * skipped whenever the new value matches the stored one.
+     *
+     * @param value The new value.
+     * @param size The size of the value in bytes.
+     *
+     * @return true if the value changed and must be uploaded, false otherwise.
+     */
+    bool updateValue(const void* value, unsigned int size);
+
     std::string _name;
     GLint _location;
     GLenum _type;
+    unsigned int _size;
     unsigned int _index;
     Effect* _effect;
+    unsigned char* _value;
+    unsigned int _valueSize;
 };
 
 }
@@ -0,0 +1,138 @@
+#include "Base.h"
+#include "EffectPermutations.h"
+#include "Effect.h"
+
+namespace gameplay
+{
+
+EffectPermutations::EffectPermutations() : _bitCount(0)
+{
+}
+
+EffectPermutations::~EffectPermutations()
+{
+    for (std::map<Key, Effect*>::iterator itr = _effects.begin(); itr != _effects.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+}
+
+EffectPermutations* EffectPermutations::create(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    EffectPermutations* permutations = new EffectPermutations();
+    permutations->_vshPath = vshPath;
+    permutations->_fshPath = fshPath;
+    permutations->_defines = defines ? defines : "";
+    return permutations;
+}
+
+int EffectPermutations::addFeature(const char* define, unsigned int maxValue)
+{
+    GP_ASSERT(define);
+    GP_ASSERT(maxValue > 0);
+
+    unsigned int bits = 0;
+    while (bits < 32 && (maxValue >> bits) != 0)
+        ++bits;
+    if (_bitCount + bits > 64)
+    {
+        GP_ERROR("Permutation key of shaders '%s', '%s' has no room for feature '%s'.", _vshPath.c_str(), _fshPath.c_str(), define);
+        return -1;
+    }
+
+    Feature feature;
+    feature.define = define;
+    feature.shift = _bitCount;
+    feature.bits = bits;
+    feature.maxValue = maxValue;
+    _features.push_back(feature);
+    _bitCount += bits;
+    return (int)_features.size() - 1;
+}
+
+unsigned int EffectPermutations::getFeatureCount() const
+{
+    return (unsigned int)_features.size();
+}
+
+int EffectPermutations::getFeatureIndex(const char* define) const
+{
+    GP_ASSERT(define);
+
+    for (size_t i = 0, count = _features.size(); i < count; ++i)
+    {
+        if (_features[i].define == define)
+            return (int)i;
+    }
+    return -1;
+}
+
+EffectPermutations::Key EffectPermutations::setFeature(Key key, unsigned int feature, unsigned int value) const
+{
+    GP_ASSERT(feature < _features.size());
+
+    const Feature& f = _features[feature];
+    Key mask = ((1ULL << f.bits) - 1) << f.shift;
+    return (key & ~mask) | ((Key)std::min(value, f.maxValue) << f.shift);
+}
+
+unsigned int EffectPermutations::getFeature(Key key, unsigned int feature) const
+{
+    GP_ASSERT(feature < _features.size());
+
+    const Feature& f = _features[feature];
+    return (unsigned int)((key >> f.shift) & ((1ULL << f.bits) - 1));
+}
+
+std::string EffectPermutations::getDefines(Key key) const
+{
+    std::ostringstream defines;
+    defines << _defines;
+    for (size_t i = 0, count = _features.size(); i < count; ++i)
+    {
+        // GLSL does not treat undefined identifiers in #if as zero, so ranged features are always defined.
+        unsigned int value = getFeature(key, (unsigned int)i);
+        if (value == 0 && _features[i].maxValue == 1)
+            continue;
+
+        if (defines.tellp() > 0)
+            defines << ';';
+        defines << _features[i].define;
+        if (_features[i].maxValue > 1)
+            defines << ' ' << value;
+    }
+    return defines.str();
+}
+
+Effect* EffectPermutations::getEffect(Key key)
+{
+    std::map<Key, Effect*>::const_iterator itr = _effects.find(key);
+    if (itr != _effects.end())
+        return itr->second;
+
+    std::string defines = getDefines(key);
+    Effect* effect = Effect::createFromFile(_vshPath.c_str(), _fshPath.c_str(), defines.empty() ? NULL : defines.c_str());
+    if (effect == NULL)
+    {
+        GP_ERROR("Failed to create permutation '%s' of shaders '%s', '%s'.", defines.c_str(), _vshPath.c_str(), _fshPath.c_str());
+        return NULL;
+    }
+    _effects[key] = effect;
+    return effect;
+}
+
+void EffectPermutations::getKeys(std::vector<Key>* keys) const
+{
+    GP_ASSERT(keys);
+
+    keys->clear();
+    for (std::map<Key, Effect*>::const_iterator itr = _effects.begin(); itr != _effects.end(); ++itr)
+    {
+        keys->push_back(itr->first);
+    }
+}
+
+}
@@ -0,0 +1,153 @@
+#ifndef EFFECTPERMUTATIONS_H_
+#define EFFECTPERMUTATIONS_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+class Effect;
+
+/**
+ * Defines the permutations of a pair of shaders, selected by a set of shader features.
+ *
+ * Each feature is a preprocessor define that occupies a field of bits in a 64-bit
+ * permutation key. An on/off feature is defined when its bit is set, and a feature
+ * with a range of values, such as a light or layer count, is always defined to the
+ * value of its field (e.g. "DIRECTIONAL_LIGHT_COUNT 2").
+ *
+ * Effects are looked up by key, so the define string of a permutation is only built
+ * the first time it is used. The effects are created with Effect::createFromFile,
+ * which means that permutations appear in a manifest written by Effect::recordManifest
+ * like any other effect, and Effect::precompile compiles them ahead of time.
+ *
+ * @script{ignore}
+ */
+class EffectPermutations : public Ref
+{
+public:
+
+    /**
+     * A permutation key, made of the values of all features.
+     */
+    typedef unsigned long long Key;
+
+    /**
+     * Creates the permutations of a pair of shaders.
+     *
+     * @param vshPath The path to the vertex shader file.
+     * @param fshPath The path to the fragment shader file.
+     * @param defines Semicolon separated defines shared by every permutation. May be NULL.
+     *
+     * @return The new permutations.
+     */
+    static EffectPermutations* create(const char* vshPath, const char* fshPath, const char* defines = NULL);
+
+    /**
+     * Declares a shader feature.
+     *
+     * @param define The name of the preprocessor define of the feature.
+     * @param maxValue The largest value of the feature, or 1 for an on/off feature.
+     *
+     * @return The index of the feature, or -1 if the key has no bits left for it.
+     */
+    int addFeature(const char* define, unsigned int maxValue = 1);
+
+    /**
+     * Gets the number of declared features.
+     *
+     * @return The number of features.
+     */
+    unsigned int getFeatureCount() const;
+
+    /**
+     * Gets the index of a feature from its define.
+     *
+     * @param define The name of the preprocessor define of the feature.
+     *
+     * @return The index of the feature, or -1 if there is no such feature.
+     */
+    int getFeatureIndex(const char* define) const;
+
+    /**
+     * Returns a key with the value of a feature changed.
+     *
+     * @param key The key to change.
+     * @param feature The index of the feature.
+     * @param value The value of the feature, clamped to its largest value.
+     *
+     * @return The changed key.
+     */
+    Key setFeature(Key key, unsigned int feature, unsigned int value = 1) const;
+
+    /**
+     * Gets the value of a feature in a key.
+     *
+     * @param key The key.
+     * @param feature The index of the feature.
+     *
+     * @return The value of the feature.
+     */
+    unsigned int getFeature(Key key, unsigned int feature) const;
+
+    /**
+     * Builds the semicolon separated define string of a permutation.
+     *
+     * @param key The key of the permutation.
+     *
+     * @return The defines of the permutation, including the shared defines.
+     */
+    std::string getDefines(Key key) const;
+
+    /**
+     * Gets the effect of a permutation, creating it the first time.
+     *
+     * @param key The key of the permutation.
+     *
+     * @return The effect, owned by these permutations, or NULL if it failed to compile.
+     */
+    Effect* getEffect(Key key);
+
+    /**
+     * Gets the keys of the permutations that have been created so far.
+     *
+     * @param keys Populated with the keys, in increasing order.
+     */
+    void getKeys(std::vector<Key>* keys) const;
+
+private:
+
+    struct Feature
+    {
+        std::string define;
+        unsigned int shift;
+        unsigned int bits;
+        unsigned int maxValue;
+    };
+
+    /**
+     * Constructor.
+     */
+    EffectPermutations();
+
+    /**
+     * Destructor.
+     */
+    ~EffectPermutations();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    EffectPermutations& operator=(const EffectPermutations&);
+
+    std::string _vshPath;
+    std::string _fshPath;
+    std::string _defines;
+    std::vector<Feature> _features;
+    unsigned int _bitCount;
+    std::map<Key, Effect*> _effects;
+};
+
+}
+
+#endif
@@ -1,10 +1,12 @@
 #include "Base.h"
 #include "FileSystem.h"
+#include "LoadProfiler.h"
 #include "Properties.h"
 #include "Stream.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <zlib.h>
 
 #ifdef WIN32
     #include <windows.h>
@@ -17,6 +19,9 @@
     #define __EXT_POSIX2
     #include <libgen.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
     #define gp_stat stat
     #define gp_stat_struct struct stat
 #endif
@@ -26,6 +31,13 @@
 extern AAssetManager* __assetManager;
 #endif
 
+// Compression of the files of an archive.
+#define ARCHIVE_COMPRESSION_NONE 0
+#define ARCHIVE_COMPRESSION_ZLIB 1
+
+// The longest path of a file in an archive.
+#define ARCHIVE_MAX_PATH_LENGTH 1024
+
 namespace gameplay
 {
 
@@ -83,12 +95,101 @@ static bool androidFileExists(const char* filePath)
     return false;
 }
 
+static int readAsset(void* cookie, char* buffer, int size)
+{
+    return AAsset_read((AAsset*)cookie, buffer, (size_t)size);
+}
+
+static fpos_t seekAsset(void* cookie, fpos_t offset, int origin)
+{
+    return AAsset_seek((AAsset*)cookie, offset, origin);
+}
+
+static int closeAsset(void* cookie)
+{
+    AAsset_close((AAsset*)cookie);
+    return 0;
+}
+
+/**
+ * Opens a file of the android read-only asset directory as a read-only FILE, which reads the asset in place.
+ */
+static FILE* openAsset(const char* filePath)
+{
+    AAsset* asset = AAssetManager_open(__assetManager, filePath, AASSET_MODE_RANDOM);
+    if (asset == NULL)
+        return NULL;
+
+    FILE* file = funopen(asset, readAsset, NULL, seekAsset, closeAsset);
+    if (file == NULL)
+        AAsset_close(asset);
+    return file;
+}
+
 #endif
 
 /** @script{ignore} */
 static std::string __resourcePath("./");
 static std::map<std::string, std::string> __aliases;
 
+static const unsigned char ARCHIVE_IDENTIFIER[] = { 0xAB, 'G', 'P', 'K', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char ARCHIVE_VERSION[] = { 1, 0 };
+
+/**
+ * A file of a mounted archive.
+ *
+ * @script{ignore}
+ */
+struct ArchiveEntry
+{
+    std::string path;
+    unsigned int offset;
+    unsigned int size;
+    unsigned int storedSize;
+    unsigned char compression;
+
+    bool operator<(const ArchiveEntry& entry) const
+    {
+        return path < entry.path;
+    }
+};
+
+/**
+ * A mounted archive.
+ *
+ * @script{ignore}
+ */
+struct Archive
+{
+    std::string path;
+    Stream* stream;
+    unsigned char* buffer;
+    const unsigned char* data;
+    size_t length;
+    std::vector<ArchiveEntry> entries;
+
+    const ArchiveEntry* find(const std::string& filePath) const
+    {
+        ArchiveEntry key;
+        key.path = filePath;
+        std::vector<ArchiveEntry>::const_iterator itr = std::lower_bound(entries.begin(), entries.end(), key);
+        return itr != entries.end() && itr->path == filePath ? &(*itr) : NULL;
+    }
+};
+
+// The mounted archives, the last mounted first.
+static std::vector<Archive*> __archives;
+
+// Asynchronous reads that have not fired their callback yet (main thread only).
+static std::vector<FileSystem::AsyncRead*> __asyncReads;
+
+// Asynchronous reads waiting for an I/O thread (guarded by __asyncReadMutex).
+static std::deque<FileSystem::AsyncRead*> __asyncReadQueue;
+static std::vector<Thread*> __ioThreads;
+static Mutex __asyncReadMutex;
+static Condition __asyncReadCondition;
+static bool __ioRunning = false;
+
 /**
  * Gets the fully resolved path.
  * If the path is relative then it will be prefixed with the resource path.
@@ -110,6 +211,155 @@ static void getFullPath(const char* path, std::string& fullPath)
     }
 }
 
+/**
+ * Returns the path of a file within an archive, or false if the path can not be in an archive.
+ */
+static bool getArchivePath(const char* path, std::string& archivePath)
+{
+    if (__archives.empty() || FileSystem::isAbsolutePath(path))
+        return false;
+
+    const char* resolvedPath = FileSystem::resolvePath(path);
+    archivePath.assign(resolvedPath);
+    std::replace(archivePath.begin(), archivePath.end(), '\\', '/');
+    while (archivePath.compare(0, 2, "./") == 0)
+        archivePath.erase(0, 2);
+    return !archivePath.empty();
+}
+
+/**
+ * Finds a file in the mounted archives.
+ */
+static const ArchiveEntry* findArchiveEntry(const char* path, const Archive** archive)
+{
+    std::string archivePath;
+    if (!getArchivePath(path, archivePath))
+        return NULL;
+
+    for (size_t i = 0, count = __archives.size(); i < count; ++i)
+    {
+        const ArchiveEntry* entry = __archives[i]->find(archivePath);
+        if (entry)
+        {
+            if (archive)
+                *archive = __archives[i];
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Adds the files of the mounted archives that are in the specified directory to the vector.
+ */
+static bool listArchiveFiles(const char* dirPath, std::vector<std::string>& files)
+{
+    std::string prefix;
+    if (dirPath && dirPath[0] != '\0')
+    {
+        if (!getArchivePath(dirPath, prefix))
+            return false;
+        if (prefix[prefix.size() - 1] != '/')
+            prefix += '/';
+    }
+    else if (__archives.empty())
+    {
+        return false;
+    }
+
+    bool result = false;
+    for (size_t i = 0, count = __archives.size(); i < count; ++i)
+    {
+        const std::vector<ArchiveEntry>& entries = __archives[i]->entries;
+        ArchiveEntry key;
+        key.path = prefix;
+        for (std::vector<ArchiveEntry>::const_iterator itr = std::lower_bound(entries.begin(), entries.end(), key);
+            itr != entries.end() && itr->path.compare(0, prefix.size(), prefix) == 0; ++itr)
+        {
+            result = true;
+
+            // Files in subdirectories are not listed.
+            std::string filename = itr->path.substr(prefix.size());
+            if (filename.find('/') == std::string::npos && std::find(files.begin(), files.end(), filename) == files.end())
+                files.push_back(filename);
+        }
+    }
+    return result;
+}
+
+static unsigned int readArchiveUnsignedInt(const unsigned char* data)
+{
+    unsigned int value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/**
+ * Reads the table of contents of an archive.
+ */
+static bool readArchive(Archive* archive)
+{
+    GP_ASSERT(archive && archive->data);
+
+    const unsigned char* data = archive->data;
+    size_t length = archive->length;
+    size_t position = sizeof(ARCHIVE_IDENTIFIER) + sizeof(ARCHIVE_VERSION) + sizeof(unsigned int);
+    if (length < position || memcmp(data, ARCHIVE_IDENTIFIER, sizeof(ARCHIVE_IDENTIFIER)) != 0)
+    {
+        GP_WARN("Invalid archive identifier in '%s'.", archive->path.c_str());
+        return false;
+    }
+    if (data[sizeof(ARCHIVE_IDENTIFIER)] != ARCHIVE_VERSION[0])
+    {
+        GP_WARN("Unsupported archive version (%d.%d) in '%s'.", data[sizeof(ARCHIVE_IDENTIFIER)], data[sizeof(ARCHIVE_IDENTIFIER) + 1], archive->path.c_str());
+        return false;
+    }
+
+    unsigned int count = readArchiveUnsignedInt(data + position - sizeof(unsigned int));
+    archive->entries.reserve(std::min((size_t)count, length / 16));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (length - position < sizeof(unsigned int))
+            return false;
+        unsigned int pathLength = readArchiveUnsignedInt(data + position);
+        position += sizeof(unsigned int);
+        if (pathLength == 0 || pathLength > ARCHIVE_MAX_PATH_LENGTH || length - position < pathLength + 3 * sizeof(unsigned int) + 1)
+            return false;
+
+        ArchiveEntry entry;
+        entry.path.assign((const char*)data + position, pathLength);
+        position += pathLength;
+        entry.offset = readArchiveUnsignedInt(data + position);
+        entry.size = readArchiveUnsignedInt(data + position + 4);
+        entry.storedSize = readArchiveUnsignedInt(data + position + 8);
+        entry.compression = data[position + 12];
+        position += 3 * sizeof(unsigned int) + 1;
+
+        if (entry.offset > length || entry.storedSize > length - entry.offset ||
+            (entry.compression == ARCHIVE_COMPRESSION_NONE && entry.storedSize != entry.size) ||
+            entry.compression > ARCHIVE_COMPRESSION_ZLIB)
+        {
+            return false;
+        }
+        archive->entries.push_back(entry);
+    }
+
+    // The encoder writes the table sorted, but lookups must not depend on it.
+    std::sort(archive->entries.begin(), archive->entries.end());
+    return true;
+}
+
+static void deleteArchive(Archive* archive)
+{
+    if (archive->stream)
+    {
+        archive->stream->close();
+        SAFE_DELETE(archive->stream);
+    }
+    SAFE_DELETE_ARRAY(archive->buffer);
+    SAFE_DELETE(archive);
+}
+
 /**
  * 
  * @script{ignore}
@@ -144,6 +394,93 @@ private:
     bool _canWrite;
 };
 
+/**
+ * A read-only stream over a memory-mapped file.
+ *
+ * On Android, assets stored without compression in the APK are mapped in place.
+ *
+ * @script{ignore}
+ */
+class MappedFileStream : public Stream
+{
+public:
+    friend class FileSystem;
+
+    ~MappedFileStream();
+    virtual bool canRead();
+    virtual bool canWrite();
+    virtual bool canSeek();
+    virtual void close();
+    virtual size_t read(void* ptr, size_t size, size_t count);
+    virtual char* readLine(char* str, int num);
+    virtual size_t write(const void* ptr, size_t size, size_t count);
+    virtual bool eof();
+    virtual size_t length();
+    virtual long int position();
+    virtual bool seek(long int offset, int origin);
+    virtual bool rewind();
+    virtual const unsigned char* getData();
+
+    static MappedFileStream* create(const char* filePath);
+
+#ifdef __ANDROID__
+    static MappedFileStream* create(AAsset* asset);
+#endif
+
+private:
+    MappedFileStream();
+
+private:
+    const unsigned char* _data;
+    size_t _length;
+    size_t _position;
+    size_t _offset;     // Bytes mapped before the data, to align the mapping to a page.
+#ifdef WIN32
+    HANDLE _file;
+    HANDLE _mapping;
+#endif
+};
+
+/**
+ * A read-only stream over a file of a mounted archive.
+ *
+ * Files stored without compression are read in place from the archive, compressed
+ * files are decompressed into a buffer owned by the stream.
+ *
+ * @script{ignore}
+ */
+class ArchiveStream : public Stream
+{
+public:
+    friend class FileSystem;
+
+    ~ArchiveStream();
+    virtual bool canRead();
+    virtual bool canWrite();
+    virtual bool canSeek();
+    virtual void close();
+    virtual size_t read(void* ptr, size_t size, size_t count);
+    virtual char* readLine(char* str, int num);
+    virtual size_t write(const void* ptr, size_t size, size_t count);
+    virtual bool eof();
+    virtual size_t length();
+    virtual long int position();
+    virtual bool seek(long int offset, int origin);
+    virtual bool rewind();
+    virtual const unsigned char* getData();
+
+    static ArchiveStream* create(const Archive* archive, const ArchiveEntry* entry);
+
+private:
+    ArchiveStream(const unsigned char* data, size_t length, unsigned char* buffer);
+
+private:
+    const unsigned char* _data;
+    size_t _length;
+    size_t _position;
+    unsigned char* _buffer;
+};
+
 #ifdef __ANDROID__
 
 /**
@@ -168,8 +505,7 @@ public:
     virtual long int position();
     virtual bool seek(long int offset, int origin);
     virtual bool rewind();
-
-    static FileStreamAndroid* create(const char* filePath, const char* mode);
+    virtual const unsigned char* getData();
 
 private:
     FileStreamAndroid(AAsset* asset);
@@ -225,6 +561,76 @@ void FileSystem::loadResourceAliases(Properties* properties)
     }
 }
 
+bool FileSystem::mountArchive(const char* path)
+{
+    GP_ASSERT(path);
+
+    Stream* stream = open(path);
+    if (stream == NULL)
+    {
+        GP_ERROR("Failed to open archive '%s'.", path);
+        return false;
+    }
+
+    Archive* archive = new Archive();
+    archive->path = path;
+    archive->stream = stream;
+    archive->buffer = NULL;
+    archive->data = stream->getData();
+    archive->length = stream->length();
+    if (archive->data == NULL)
+    {
+        // The archive can not be used in place, so it is read into memory.
+        archive->buffer = new unsigned char[archive->length + 1];
+        if (stream->read(archive->buffer, 1, archive->length) != archive->length)
+        {
+            GP_ERROR("Failed to read archive '%s'.", path);
+            deleteArchive(archive);
+            return false;
+        }
+        archive->data = archive->buffer;
+        archive->stream->close();
+        SAFE_DELETE(archive->stream);
+    }
+
+    if (!readArchive(archive))
+    {
+        GP_ERROR("Failed to read the table of contents of archive '%s'.", path);
+        deleteArchive(archive);
+        return false;
+    }
+
+    // Mounting an archive again replaces it.
+    unmountArchive(path);
+    __archives.insert(__archives.begin(), archive);
+    return true;
+}
+
+void FileSystem::unmountArchive(const char* path)
+{
+    GP_ASSERT(path);
+
+    for (std::vector<Archive*>::iterator itr = __archives.begin(); itr != __archives.end(); ++itr)
+    {
+        if ((*itr)->path == path)
+        {
+            deleteArchive(*itr);
+            __archives.erase(itr);
+            return;
+        }
+    }
+}
+
+void FileSystem::mountArchives(Properties* properties)
+{
+    GP_ASSERT(properties);
+
+    while (properties->getNextProperty() != NULL)
+    {
+        mountArchive(properties->getString());
+    }
+}
+
 const char* FileSystem::resolvePath(const char* path)
 {
     GP_ASSERT(path);
@@ -259,7 +665,7 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     HANDLE hFind = FindFirstFile(wPath.c_str(), &FindFileData);
     if (hFind == INVALID_HANDLE_VALUE) 
     {
-        return false;
+        return listArchiveFiles(dirPath, files);
     }
     do
     {
@@ -275,6 +681,7 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     } while (FindNextFile(hFind, &FindFileData) != 0);
 
     FindClose(hFind);
+    listArchiveFiles(dirPath, files);
     return true;
 #else
     std::string path(FileSystem::getResourcePath());
@@ -330,6 +737,9 @@ bool FileSystem::listFiles(const char* dirPath, std::vector<std::string>& files)
     }
 #endif
 
+    if (listArchiveFiles(dirPath, files))
+        result = true;
+
     return result;
 #endif
 }
@@ -338,6 +748,9 @@ bool FileSystem::fileExists(const char* filePath)
 {
     GP_ASSERT(filePath);
 
+    if (findArchiveEntry(filePath, NULL))
+        return true;
+
 #ifdef __ANDROID__
     if (androidFileExists(resolvePath(filePath)))
     {
@@ -374,6 +787,15 @@ bool FileSystem::fileExists(const char* filePath)
 
 Stream* FileSystem::open(const char* path, size_t mode)
 {
+    // Files of the mounted archives take precedence over the filesystem.
+    if ((mode & WRITE) == 0)
+    {
+        const Archive* archive = NULL;
+        const ArchiveEntry* entry = findArchiveEntry(path, &archive);
+        if (entry)
+            return ArchiveStream::create(archive, entry);
+    }
+
     char modeStr[] = "rb";
     if ((mode & WRITE) != 0)
         modeStr[0] = 'w';
@@ -396,8 +818,18 @@ Stream* FileSystem::open(const char* path, size_t mode)
     }
     else
     {
-        // Open a file in the read-only asset directory
-        return FileStreamAndroid::create(resolvePath(path), modeStr);
+        // Read the asset in place from the APK: uncompressed assets are memory-mapped and
+        // compressed ones are streamed through the asset manager, so nothing is extracted.
+        AAsset* asset = AAssetManager_open(__assetManager, resolvePath(path), AASSET_MODE_RANDOM);
+        if (asset == NULL)
+            return NULL;
+        MappedFileStream* mappedStream = MappedFileStream::create(asset);
+        if (mappedStream)
+        {
+            AAsset_close(asset);
+            return mappedStream;
+        }
+        return new FileStreamAndroid(asset);
     }
 #else
     std::string fullPath;
@@ -424,6 +856,13 @@ Stream* FileSystem::open(const char* path, size_t mode)
         }
     }
 #endif
+    // Read-only files are memory-mapped when possible, so that large blocks can be used in place.
+    if ((mode & WRITE) == 0)
+    {
+        MappedFileStream* mappedStream = MappedFileStream::create(fullPath.c_str());
+        if (mappedStream)
+            return mappedStream;
+    }
     FileStream* stream = FileStream::create(fullPath.c_str(), modeStr);
     return stream;
 #endif
@@ -437,8 +876,31 @@ FILE* FileSystem::openFile(const char* filePath, const char* mode)
     std::string fullPath;
     getFullPath(filePath, fullPath);
 
-    createFileFromAsset(filePath);
-    
+#ifdef __ANDROID__
+    if (mode[0] == 'r' && strchr(mode, '+') == NULL)
+    {
+        // Read assets in place from the APK rather than extracting them first.
+        if (!isAbsolutePath(filePath))
+        {
+            FILE* asset = openAsset(resolvePath(filePath));
+            if (asset)
+                return asset;
+        }
+    }
+    else
+    {
+        // Create the directory of a file on the SD card.
+        size_t index = fullPath.rfind('/');
+        if (index != std::string::npos)
+        {
+            std::string directoryPath = fullPath.substr(0, index);
+            struct stat s;
+            if (stat(directoryPath.c_str(), &s) != 0)
+                makepath(directoryPath, 0777);
+        }
+    }
+#endif
+
     FILE* fp = fopen(fullPath.c_str(), mode);
     
 #ifdef WIN32
@@ -462,40 +924,195 @@ FILE* FileSystem::openFile(const char* filePath, const char* mode)
     return fp;
 }
 
-char* FileSystem::readAll(const char* filePath, int* fileSize)
+FileSystem::AsyncRead* FileSystem::readAsync(const char* filePath, AsyncReadCallback callback, void* cookie)
 {
     GP_ASSERT(filePath);
 
-    // Open file for reading.
-    std::auto_ptr<Stream> stream(open(filePath));
-    if (stream.get() == NULL)
-    {
-        GP_ERROR("Failed to load file: %s", filePath);
-        return NULL;
-    }
-    size_t size = stream->length();
+    AsyncRead* read = new AsyncRead();
+    read->_path = filePath;
+    read->_callback = callback;
+    read->_cookie = cookie;
 
-    // Read entire file contents.
-    char* buffer = new char[size + 1];
-    size_t read = stream->read(buffer, 1, size);
-    if (read != size)
+    // The pending list holds its own reference until the callback is fired.
+    read->addRef();
+    __asyncReads.push_back(read);
+
+    if (__ioThreads.empty())
     {
-        GP_ERROR("Failed to read complete contents of file '%s' (amount read vs. file size: %u < %u).", filePath, read, size);
-        SAFE_DELETE_ARRAY(buffer);
-        return NULL;
+        performAsyncRead(read);
+        return read;
     }
 
-    // Force the character buffer to be NULL-terminated.
-    buffer[size] = '\0';
+    // The I/O threads never touch the reference count, which is not atomic in
+    // single-threaded builds; the reference of the pending list keeps the read
+    // alive until it has finished.
+    MutexLock lock(__asyncReadMutex);
+    __asyncReadQueue.push_back(read);
+    __asyncReadCondition.signal();
+    return read;
+}
 
-    if (fileSize)
+void FileSystem::initializeAsyncReads(Properties* properties)
+{
+    unsigned int threadCount = 2;
+    if (properties && properties->exists("ioThreads"))
     {
-        *fileSize = (int)size; 
+        threadCount = (unsigned int)std::max(0, properties->getInt("ioThreads"));
     }
-    return buffer;
-}
 
-bool FileSystem::isAbsolutePath(const char* filePath)
+    __ioRunning = true;
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        Thread* thread = Thread::create(ioThreadMain, NULL);
+        if (thread == NULL)
+        {
+            GP_WARN("Failed to create I/O thread %u of %u.", i + 1, threadCount);
+            break;
+        }
+        __ioThreads.push_back(thread);
+    }
+}
+
+void FileSystem::updateAsyncReads()
+{
+    for (size_t i = 0; i < __asyncReads.size();)
+    {
+        AsyncRead* read = __asyncReads[i];
+        if (read->_finished.get() == 0)
+        {
+            ++i;
+            continue;
+        }
+
+        // Callbacks may start new reads, so remove this one first.
+        __asyncReads.erase(__asyncReads.begin() + i);
+        read->_state = read->_failed ? AsyncRead::FAILED : AsyncRead::COMPLETE;
+        if (read->_callback)
+        {
+            read->_callback(read, read->_cookie);
+        }
+        SAFE_RELEASE(read);
+    }
+}
+
+void FileSystem::finalizeAsyncReads()
+{
+    {
+        MutexLock lock(__asyncReadMutex);
+        __ioRunning = false;
+        __asyncReadCondition.broadcast();
+    }
+    for (size_t i = 0, count = __ioThreads.size(); i < count; ++i)
+    {
+        __ioThreads[i]->join();
+        SAFE_DELETE(__ioThreads[i]);
+    }
+    __ioThreads.clear();
+
+    // The I/O threads are gone, so the reads they did not get to fail.
+    for (size_t i = 0, count = __asyncReadQueue.size(); i < count; ++i)
+    {
+        __asyncReadQueue[i]->_failed = true;
+        __asyncReadQueue[i]->_finished.set(1);
+    }
+    __asyncReadQueue.clear();
+
+    for (size_t i = 0, count = __asyncReads.size(); i < count; ++i)
+    {
+        AsyncRead* read = __asyncReads[i];
+        read->_state = read->_failed ? AsyncRead::FAILED : AsyncRead::COMPLETE;
+        SAFE_RELEASE(read);
+    }
+    __asyncReads.clear();
+}
+
+void FileSystem::ioThreadMain(void* arg)
+{
+    while (true)
+    {
+        AsyncRead* read = NULL;
+        {
+            MutexLock lock(__asyncReadMutex);
+            while (__ioRunning && __asyncReadQueue.empty())
+            {
+                __asyncReadCondition.wait(__asyncReadMutex);
+            }
+            if (!__ioRunning)
+                return;
+            read = __asyncReadQueue.front();
+            __asyncReadQueue.pop_front();
+        }
+        performAsyncRead(read);
+    }
+}
+
+void FileSystem::performAsyncRead(AsyncRead* read)
+{
+    GP_ASSERT(read);
+
+    Stream* stream = open(read->_path.c_str());
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open file '%s' for an asynchronous read.", read->_path.c_str());
+        read->_failed = true;
+        read->_finished.set(1);
+        return;
+    }
+
+    size_t size = stream->length();
+    char* data = new char[size + 1];
+    if (stream->read(data, 1, size) != size)
+    {
+        GP_WARN("Failed to read complete contents of file '%s' asynchronously.", read->_path.c_str());
+        SAFE_DELETE_ARRAY(data);
+        read->_failed = true;
+    }
+    else
+    {
+        data[size] = '\0';
+        read->_data = data;
+        read->_size = size;
+    }
+    SAFE_DELETE(stream);
+
+    // Publish the result to the main thread last, the read may be destroyed right after.
+    read->_finished.set(1);
+}
+
+char* FileSystem::readAll(const char* filePath, int* fileSize)
+{
+    GP_ASSERT(filePath);
+
+    // Open file for reading.
+    std::auto_ptr<Stream> stream(open(filePath));
+    if (stream.get() == NULL)
+    {
+        GP_ERROR("Failed to load file: %s", filePath);
+        return NULL;
+    }
+    size_t size = stream->length();
+
+    // Read entire file contents.
+    char* buffer = new char[size + 1];
+    size_t read = stream->read(buffer, 1, size);
+    if (read != size)
+    {
+        GP_ERROR("Failed to read complete contents of file '%s' (amount read vs. file size: %u < %u).", filePath, read, size);
+        SAFE_DELETE_ARRAY(buffer);
+        return NULL;
+    }
+
+    // Force the character buffer to be NULL-terminated.
+    buffer[size] = '\0';
+
+    if (fileSize)
+    {
+        *fileSize = (int)size; 
+    }
+    return buffer;
+}
+
+bool FileSystem::isAbsolutePath(const char* filePath)
 {
     if (filePath == 0 || filePath[0] == '\0')
         return false;
@@ -620,6 +1237,47 @@ std::string FileSystem::getExtension(const char* path)
 
 //////////////////
 
+FileSystem::AsyncRead::AsyncRead()
+    : _callback(NULL), _cookie(NULL), _state(LOADING), _data(NULL), _size(0), _failed(false)
+{
+}
+
+FileSystem::AsyncRead::~AsyncRead()
+{
+    SAFE_DELETE_ARRAY(_data);
+}
+
+FileSystem::AsyncRead::State FileSystem::AsyncRead::getState() const
+{
+    return _state;
+}
+
+const char* FileSystem::AsyncRead::getPath() const
+{
+    return _path.c_str();
+}
+
+const char* FileSystem::AsyncRead::getData() const
+{
+    return _state == COMPLETE ? _data : NULL;
+}
+
+size_t FileSystem::AsyncRead::getSize() const
+{
+    return _state == COMPLETE ? _size : 0;
+}
+
+char* FileSystem::AsyncRead::detachData()
+{
+    if (_state != COMPLETE)
+        return NULL;
+    char* data = _data;
+    _data = NULL;
+    return data;
+}
+
+//////////////////
+
 FileStream::FileStream(FILE* file)
     : _file(file), _canRead(false), _canWrite(false)
 {
@@ -681,14 +1339,19 @@ size_t FileStream::read(void* ptr, size_t size, size_t count)
 {
     if (!_file)
         return 0;
-    return fread(ptr, size, count, _file);
+    size_t result = fread(ptr, size, count, _file);
+    LoadProfiler::addBytesRead(result * size);
+    return result;
 }
 
 char* FileStream::readLine(char* str, int num)
 {
     if (!_file)
         return 0;
-    return fgets(str, num, _file);
+    char* result = fgets(str, num, _file);
+    if (result)
+        LoadProfiler::addBytesRead(strlen(result));
+    return result;
 }
 
 size_t FileStream::write(const void* ptr, size_t size, size_t count)
@@ -746,28 +1409,371 @@ bool FileStream::rewind()
 
 ////////////////////////////////
 
+MappedFileStream::MappedFileStream()
+    : _data(NULL), _length(0), _position(0), _offset(0)
+#ifdef WIN32
+    , _file(INVALID_HANDLE_VALUE), _mapping(NULL)
+#endif
+{
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    close();
+}
+
+MappedFileStream* MappedFileStream::create(const char* filePath)
+{
+#ifdef WIN32
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.HighPart != 0)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return NULL;
+    }
+
+    MappedFileStream* stream = new MappedFileStream();
+    stream->_data = (const unsigned char*)data;
+    stream->_length = (size_t)size.QuadPart;
+    stream->_file = file;
+    stream->_mapping = mapping;
+    return stream;
+#else
+    int file = open(filePath, O_RDONLY);
+    if (file == -1)
+        return NULL;
+
+    // Empty files and anything that is not a regular file are left to FileStream.
+    struct stat s;
+    if (fstat(file, &s) != 0 || !S_ISREG(s.st_mode) || s.st_size == 0)
+    {
+        ::close(file);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping stays valid after the descriptor is closed.
+    ::close(file);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    MappedFileStream* stream = new MappedFileStream();
+    stream->_data = (const unsigned char*)data;
+    stream->_length = (size_t)s.st_size;
+    return stream;
+#endif
+}
+
 #ifdef __ANDROID__
 
-FileStreamAndroid::FileStreamAndroid(AAsset* asset)
-    : _asset(asset)
+MappedFileStream* MappedFileStream::create(AAsset* asset)
 {
+    GP_ASSERT(asset);
+
+    // Only assets stored without compression have a descriptor: the APK itself, at their offset.
+    off_t start = 0;
+    off_t length = 0;
+    int file = AAsset_openFileDescriptor(asset, &start, &length);
+    if (file < 0)
+        return NULL;
+    if (length == 0)
+    {
+        ::close(file);
+        return NULL;
+    }
+
+    // Mappings start on a page boundary, so map from the page holding the first byte.
+    off_t pageSize = (off_t)sysconf(_SC_PAGESIZE);
+    off_t alignedStart = start - (start % pageSize);
+    size_t offset = (size_t)(start - alignedStart);
+    void* data = mmap(NULL, (size_t)length + offset, PROT_READ, MAP_PRIVATE, file, alignedStart);
+    ::close(file);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    MappedFileStream* stream = new MappedFileStream();
+    stream->_data = (const unsigned char*)data + offset;
+    stream->_length = (size_t)length;
+    stream->_offset = offset;
+    return stream;
 }
 
-FileStreamAndroid::~FileStreamAndroid()
+#endif
+
+bool MappedFileStream::canRead()
 {
-    if (_asset)
-        close();
+    return _data != NULL;
 }
 
-FileStreamAndroid* FileStreamAndroid::create(const char* filePath, const char* mode)
+bool MappedFileStream::canWrite()
 {
-    AAsset* asset = AAssetManager_open(__assetManager, filePath, AASSET_MODE_RANDOM);
-    if (asset)
+    return false;
+}
+
+bool MappedFileStream::canSeek()
+{
+    return _data != NULL;
+}
+
+void MappedFileStream::close()
+{
+    if (_data)
     {
-        FileStreamAndroid* stream = new FileStreamAndroid(asset);
-        return stream;
+#ifdef WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+        _mapping = NULL;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        munmap((void*)(_data - _offset), _length + _offset);
+#endif
     }
-    return NULL;
+    _data = NULL;
+    _length = 0;
+    _position = 0;
+    _offset = 0;
+}
+
+size_t MappedFileStream::read(void* ptr, size_t size, size_t count)
+{
+    if (!_data || size == 0)
+        return 0;
+    size_t available = (_length - _position) / size;
+    if (count > available)
+        count = available;
+    memcpy(ptr, _data + _position, size * count);
+    _position += size * count;
+    LoadProfiler::addBytesRead(size * count);
+    return count;
+}
+
+char* MappedFileStream::readLine(char* str, int num)
+{
+    if (!_data || num <= 0 || _position >= _length)
+        return NULL;
+    int i = 0;
+    while (i < num - 1 && _position < _length)
+    {
+        char c = (char)_data[_position++];
+        str[i++] = c;
+        if (c == '\n')
+            break;
+    }
+    str[i] = '\0';
+    LoadProfiler::addBytesRead(i);
+    return str;
+}
+
+size_t MappedFileStream::write(const void* ptr, size_t size, size_t count)
+{
+    return 0;
+}
+
+bool MappedFileStream::eof()
+{
+    return _position >= _length;
+}
+
+size_t MappedFileStream::length()
+{
+    return _length;
+}
+
+long int MappedFileStream::position()
+{
+    if (!_data)
+        return -1;
+    return (long int)_position;
+}
+
+bool MappedFileStream::seek(long int offset, int origin)
+{
+    if (!_data)
+        return false;
+    long int base = origin == SEEK_CUR ? (long int)_position : (origin == SEEK_END ? (long int)_length : 0);
+    if (base + offset < 0 || (size_t)(base + offset) > _length)
+        return false;
+    _position = (size_t)(base + offset);
+    return true;
+}
+
+bool MappedFileStream::rewind()
+{
+    if (!_data)
+        return false;
+    _position = 0;
+    return true;
+}
+
+const unsigned char* MappedFileStream::getData()
+{
+    return _data;
+}
+
+////////////////////////////////
+
+ArchiveStream::ArchiveStream(const unsigned char* data, size_t length, unsigned char* buffer)
+    : _data(data), _length(length), _position(0), _buffer(buffer)
+{
+}
+
+ArchiveStream::~ArchiveStream()
+{
+    close();
+}
+
+ArchiveStream* ArchiveStream::create(const Archive* archive, const ArchiveEntry* entry)
+{
+    GP_ASSERT(archive && entry);
+
+    const unsigned char* data = archive->data + entry->offset;
+    if (entry->compression == ARCHIVE_COMPRESSION_NONE)
+        return new ArchiveStream(data, entry->size, NULL);
+
+    unsigned char* buffer = new unsigned char[entry->size + 1];
+    uLongf size = entry->size;
+    if (uncompress(buffer, &size, data, entry->storedSize) != Z_OK || size != entry->size)
+    {
+        GP_ERROR("Failed to decompress '%s' from archive '%s'.", entry->path.c_str(), archive->path.c_str());
+        SAFE_DELETE_ARRAY(buffer);
+        return NULL;
+    }
+    return new ArchiveStream(buffer, entry->size, buffer);
+}
+
+bool ArchiveStream::canRead()
+{
+    return _data != NULL;
+}
+
+bool ArchiveStream::canWrite()
+{
+    return false;
+}
+
+bool ArchiveStream::canSeek()
+{
+    return _data != NULL;
+}
+
+void ArchiveStream::close()
+{
+    SAFE_DELETE_ARRAY(_buffer);
+    _data = NULL;
+    _length = 0;
+    _position = 0;
+}
+
+size_t ArchiveStream::read(void* ptr, size_t size, size_t count)
+{
+    if (!_data || size == 0)
+        return 0;
+    size_t available = (_length - _position) / size;
+    if (count > available)
+        count = available;
+    memcpy(ptr, _data + _position, size * count);
+    _position += size * count;
+    LoadProfiler::addBytesRead(size * count);
+    return count;
+}
+
+char* ArchiveStream::readLine(char* str, int num)
+{
+    if (!_data || num <= 0 || _position >= _length)
+        return NULL;
+    int i = 0;
+    while (i < num - 1 && _position < _length)
+    {
+        char c = (char)_data[_position++];
+        str[i++] = c;
+        if (c == '\n')
+            break;
+    }
+    str[i] = '\0';
+    LoadProfiler::addBytesRead(i);
+    return str;
+}
+
+size_t ArchiveStream::write(const void* ptr, size_t size, size_t count)
+{
+    return 0;
+}
+
+bool ArchiveStream::eof()
+{
+    return _position >= _length;
+}
+
+size_t ArchiveStream::length()
+{
+    return _length;
+}
+
+long int ArchiveStream::position()
+{
+    if (!_data)
+        return -1;
+    return (long int)_position;
+}
+
+bool ArchiveStream::seek(long int offset, int origin)
+{
+    if (!_data)
+        return false;
+    long int base = origin == SEEK_CUR ? (long int)_position : (origin == SEEK_END ? (long int)_length : 0);
+    if (base + offset < 0 || (size_t)(base + offset) > _length)
+        return false;
+    _position = (size_t)(base + offset);
+    return true;
+}
+
+bool ArchiveStream::rewind()
+{
+    if (!_data)
+        return false;
+    _position = 0;
+    return true;
+}
+
+const unsigned char* ArchiveStream::getData()
+{
+    return _data;
+}
+
+////////////////////////////////
+
+#ifdef __ANDROID__
+
+FileStreamAndroid::FileStreamAndroid(AAsset* asset)
+    : _asset(asset)
+{
+}
+
+FileStreamAndroid::~FileStreamAndroid()
+{
+    if (_asset)
+        close();
 }
 
 bool FileStreamAndroid::canRead()
@@ -795,6 +1801,8 @@ void FileStreamAndroid::close()
 size_t FileStreamAndroid::read(void* ptr, size_t size, size_t count)
 {
     int result = AAsset_read(_asset, ptr, size * count);
+    if (result > 0)
+        LoadProfiler::addBytesRead(result);
     return result > 0 ? ((size_t)result) / size : 0;
 }
 
@@ -891,6 +1899,12 @@ bool FileStreamAndroid::rewind()
     return false;
 }
 
+const unsigned char* FileStreamAndroid::getData()
+{
+    // Uncompressed assets are memory-mapped by the asset manager.
+    return _asset ? (const unsigned char*)AAsset_getBuffer(_asset) : NULL;
+}
+
 #endif
 
 }
@@ -2,6 +2,8 @@
 #define FILESYSTEM_H_
 
 #include "Stream.h"
+#include "Ref.h"
+#include "Thread.h"
 #include <string>
 
 namespace gameplay
@@ -11,11 +13,31 @@ class Properties;
 
 /**
  * Defines a set of functions for interacting with the device filesystem.
+ *
+ * Resources can also be read from archives built with gameplay-encoder, which pack
+ * the files of a resource directory behind a sorted table of contents. Once an
+ * archive is mounted, open(), readAll() and fileExists() find its files by their
+ * path relative to the resource path, without going to the filesystem, and fall back
+ * to the filesystem for files that are not in any mounted archive. Mounted archives
+ * are memory-mapped where possible, and files stored without compression are read
+ * in place.
  */
 class FileSystem
 {
+    friend class Game;
+
 public:
 
+    class AsyncRead;
+
+    /**
+     * Defines the callback fired on the main thread when an asynchronous read finishes.
+     *
+     * @param read The finished read. Its state is COMPLETE or FAILED.
+     * @param cookie The user data passed when the read was started.
+     */
+    typedef void (*AsyncReadCallback)(AsyncRead* read, void* cookie);
+
     /**
      * Mode flags for opening a stream.
      * @script{ignore}
@@ -99,6 +121,39 @@ public:
      */
     static const char* resolvePath(const char* path);
 
+    /**
+     * Mounts a resource archive.
+     *
+     * The files of archives mounted later take precedence over those of archives
+     * mounted earlier, and over the files of the filesystem. Archives should be mounted
+     * and unmounted while no resources are being loaded, and streams opened from an
+     * archive must be closed before the archive is unmounted.
+     *
+     * Archives listed in the 'archives' namespace of the game config are mounted,
+     * in order, when the config is loaded.
+     *
+     * @param path The path to the archive.
+     *
+     * @return True if the archive was mounted, false if it could not be read.
+     */
+    static bool mountArchive(const char* path);
+
+    /**
+     * Unmounts a resource archive.
+     *
+     * @param path The path the archive was mounted with.
+     */
+    static void unmountArchive(const char* path);
+
+    /**
+     * Mounts the archives listed in the specified properties namespace.
+     *
+     * @param properties The namespace whose property values are paths to archives.
+     *
+     * @script{ignore}
+     */
+    static void mountArchives(Properties* properties);
+
     /**
      * Lists the files in the specified directory and adds the files to the vector. Excludes directories.
      * 
@@ -166,6 +221,35 @@ public:
      */
     static char* readAll(const char* filePath, int* fileSize = NULL);
 
+    /**
+     * Starts reading the entire contents of the specified file without blocking.
+     *
+     * Files are read by dedicated I/O threads, so that neither the caller nor the
+     * job scheduler's workers wait on the device, and several reads are in flight
+     * at once with more than one I/O thread. The state of the read can be polled,
+     * and the callback is fired on the main thread during Game::frame once the
+     * read finishes. The number of I/O threads can be set in the game config:
+     * @verbatim
+        filesystem
+        {
+            ioThreads = 2
+        }
+       @endverbatim
+     * With zero I/O threads, or before the game is initialized, the file is read
+     * right away and the callback is still fired during the next frame.
+     *
+     * The returned read must be released when no longer needed; releasing it before
+     * it finishes does not cancel it.
+     *
+     * @param filePath The path to the file to be read.
+     * @param callback The function called on the main thread when the read finishes, or NULL.
+     * @param cookie User data passed to the callback.
+     *
+     * @return The asynchronous read.
+     * @script{ignore}
+     */
+    static AsyncRead* readAsync(const char* filePath, AsyncReadCallback callback = NULL, void* cookie = NULL);
+
     /**
      * Determines if the file path is an absolute path for the current platform.
      * 
@@ -177,6 +261,9 @@ public:
 
     /**
      * Creates a file on the file system from the specified asset (Android-specific).
+     *
+     * This is only needed to pass an asset to code that opens files by path: open,
+     * openFile and readAll read assets in place from the APK.
      * 
      * @param path The path to the file.
      */
@@ -218,6 +305,117 @@ private:
      * Constructor.
      */
     FileSystem();
+
+    /**
+     * Starts the I/O threads (called by Game during startup).
+     */
+    static void initializeAsyncReads(Properties* properties);
+
+    /**
+     * Fires the callbacks of the finished asynchronous reads (called by Game every frame).
+     */
+    static void updateAsyncReads();
+
+    /**
+     * Stops the I/O threads and fails the reads that have not finished (called by Game during shutdown).
+     */
+    static void finalizeAsyncReads();
+
+    static void ioThreadMain(void* arg);
+
+    static void performAsyncRead(AsyncRead* read);
+};
+
+/**
+ * Defines an asynchronous read of a file, started with FileSystem::readAsync.
+ */
+class FileSystem::AsyncRead : public Ref
+{
+    friend class FileSystem;
+
+public:
+
+    /**
+     * Defines the states of a read.
+     */
+    enum State
+    {
+        LOADING,
+        COMPLETE,
+        FAILED
+    };
+
+    /**
+     * Gets the state of the read.
+     *
+     * The state changes on the main thread, when the callback of the read is fired.
+     *
+     * @return The state of the read.
+     */
+    State getState() const;
+
+    /**
+     * Gets the path of the file being read.
+     *
+     * @return The path of the file.
+     */
+    const char* getPath() const;
+
+    /**
+     * Gets the contents of the file.
+     *
+     * As with FileSystem::readAll, the contents are followed by a NULL character.
+     *
+     * @return The contents of the file, or NULL if the read is not complete or the data was detached.
+     */
+    const char* getData() const;
+
+    /**
+     * Gets the size of the file in bytes.
+     *
+     * @return The size of the file.
+     */
+    size_t getSize() const;
+
+    /**
+     * Takes ownership of the contents of the file.
+     *
+     * The returned array is allocated with new[] and must be deleted by the caller using delete[].
+     *
+     * @return The contents of the file, or NULL if the read is not complete or the data was already detached.
+     */
+    char* detachData();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    AsyncRead();
+
+    /**
+     * Destructor.
+     */
+    ~AsyncRead();
+
+    /**
+     * Hidden copy constructor.
+     */
+    AsyncRead(const AsyncRead&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    AsyncRead& operator=(const AsyncRead&);
+
+    std::string _path;
+    AsyncReadCallback _callback;
+    void* _cookie;
+    State _state;
+    char* _data;
+    size_t _size;
+    bool _failed;
+    AtomicInt _finished;
 };
 
 }
@@ -74,7 +74,7 @@ void FlowLayout::update(const Container* container, const Vector2& offset)
         yPosition = rowY + margin.top;
 
         control->setPosition(xPosition, yPosition);
-        control->update(container, offset);
+        control->arrange(container, offset);
 
         xPosition += bounds.width + margin.right;
 
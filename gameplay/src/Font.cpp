@@ -8,6 +8,14 @@
 #define FONT_VSH "res/shaders/font.vert"
 #define FONT_FSH "res/shaders/font.frag"
 
+// Once a font caches more than FONT_LAYOUT_CACHE_SIZE text layouts, the layouts that were
+// not drawn during the last FONT_LAYOUT_CACHE_AGE calls to Font::start are released.
+#define FONT_LAYOUT_CACHE_SIZE 256
+#define FONT_LAYOUT_CACHE_AGE 60
+
+// Empty texels kept between the glyphs of a dynamic font atlas, so that they do not bleed into each other.
+#define FONT_ATLAS_PADDING 1
+
 namespace gameplay
 {
 
@@ -15,8 +23,11 @@ static std::vector<Font*> __fontCache;
 
 static Effect* __fontEffect = NULL;
 
+static Effect* __fontDistanceFieldEffect = NULL;
+
 Font::Font() :
-    _style(PLAIN), _size(0), _glyphs(NULL), _glyphCount(0), _texture(NULL), _batch(NULL)
+    _style(PLAIN), _size(0), _distanceField(false), _glyphs(NULL), _glyphCount(0), _texture(NULL), _batch(NULL), _layoutFrame(0),
+    _rasterizer(NULL), _atlasData(NULL), _atlasSize(0), _atlasVersion(0)
 {
 }
 
@@ -29,8 +40,15 @@ Font::~Font()
         __fontCache.erase(itr);
     }
 
+    for (std::map<LayoutKey, Text*>::iterator itr = _layoutCache.begin(); itr != _layoutCache.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second);
+    }
+    _layoutCache.clear();
+
     SAFE_DELETE(_batch);
     SAFE_DELETE_ARRAY(_glyphs);
+    SAFE_DELETE_ARRAY(_atlasData);
     SAFE_RELEASE(_texture);
 }
 
@@ -90,17 +108,18 @@ Font* Font::create(const char* path, const char* id)
     return font;
 }
 
-Font* Font::create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture)
+Font* Font::create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture, bool distanceField)
 {
     GP_ASSERT(family);
-    GP_ASSERT(glyphs);
+    GP_ASSERT(glyphs || glyphCount == 0);
     GP_ASSERT(texture);
 
     // Create the effect for the font's sprite batch.
-    if (__fontEffect == NULL)
+    Effect*& fontEffect = distanceField ? __fontDistanceFieldEffect : __fontEffect;
+    if (fontEffect == NULL)
     {
-        __fontEffect = Effect::createFromFile(FONT_VSH, FONT_FSH);
-        if (__fontEffect == NULL)
+        fontEffect = Effect::createFromFile(FONT_VSH, FONT_FSH, distanceField ? "DISTANCE_FIELD" : NULL);
+        if (fontEffect == NULL)
         {
             GP_ERROR("Failed to create effect for font.");
             SAFE_RELEASE(texture);
@@ -109,14 +128,14 @@ Font* Font::create(const char* family, Style style, unsigned int size, Glyph* gl
     }
     else
     {
-        __fontEffect->addRef();
+        fontEffect->addRef();
     }
 
     // Create batch for the font.
-    SpriteBatch* batch = SpriteBatch::create(texture, __fontEffect, 128);
+    SpriteBatch* batch = SpriteBatch::create(texture, fontEffect, 128);
     
-    // Release __fontEffect since the SpriteBatch keeps a reference to it
-    SAFE_RELEASE(__fontEffect);
+    // Release the effect since the SpriteBatch keeps a reference to it
+    SAFE_RELEASE(fontEffect);
 
     if (batch == NULL)
     {
@@ -135,35 +154,207 @@ Font* Font::create(const char* family, Style style, unsigned int size, Glyph* gl
     font->_family = family;
     font->_style = style;
     font->_size = size;
+    font->_distanceField = distanceField;
     font->_texture = texture;
     font->_batch = batch;
 
     // Copy the glyphs array.
-    font->_glyphs = new Glyph[glyphCount];
-    memcpy(font->_glyphs, glyphs, sizeof(Glyph) * glyphCount);
+    if (glyphCount > 0)
+    {
+        font->_glyphs = new Glyph[glyphCount];
+        memcpy(font->_glyphs, glyphs, sizeof(Glyph) * glyphCount);
+    }
     font->_glyphCount = glyphCount;
 
     return font;
 }
 
+Font* Font::createDynamic(const char* family, unsigned int size, Rasterizer* rasterizer, unsigned int atlasSize)
+{
+    GP_ASSERT(family);
+    GP_ASSERT(rasterizer);
+
+    if (size == 0 || size + FONT_ATLAS_PADDING > atlasSize)
+    {
+        GP_ERROR("Invalid size (%u) for dynamic font '%s' with an atlas of %u pixels.", size, family, atlasSize);
+        return NULL;
+    }
+
+    // The atlas starts out empty; glyphs are added as they are first drawn or measured.
+    unsigned char* atlasData = new unsigned char[atlasSize * atlasSize];
+    memset(atlasData, 0, atlasSize * atlasSize);
+    Texture* texture = Texture::create(Texture::ALPHA, atlasSize, atlasSize, atlasData, false);
+    if (texture == NULL)
+    {
+        GP_ERROR("Failed to create atlas texture for dynamic font '%s'.", family);
+        SAFE_DELETE_ARRAY(atlasData);
+        return NULL;
+    }
+
+    Font* font = create(family, PLAIN, size, NULL, 0, texture);
+    SAFE_RELEASE(texture);
+    if (font == NULL)
+    {
+        SAFE_DELETE_ARRAY(atlasData);
+        return NULL;
+    }
+
+    font->_rasterizer = rasterizer;
+    font->_atlasData = atlasData;
+    font->_atlasSize = atlasSize;
+
+    // Divide the atlas into shelves as high as the glyphs.
+    const unsigned int shelfHeight = size + FONT_ATLAS_PADDING;
+    for (unsigned int y = 0; y + shelfHeight <= atlasSize; y += shelfHeight)
+    {
+        Shelf shelf;
+        shelf.y = y;
+        shelf.freeSpans.push_back(std::make_pair(0u, atlasSize));
+        shelf.dirtyX1 = atlasSize;
+        shelf.dirtyX2 = 0;
+        font->_shelves.push_back(shelf);
+    }
+
+    return font;
+}
+
 unsigned int Font::getSize()
 {
     return _size;
 }
 
+bool Font::isDistanceField() const
+{
+    return _distanceField;
+}
+
 void Font::start()
 {
     GP_ASSERT(_batch);
     _batch->start();
+
+    // Release the layouts of text that is no longer drawn.
+    ++_layoutFrame;
+    if (_layoutCache.size() > FONT_LAYOUT_CACHE_SIZE)
+    {
+        std::map<LayoutKey, Text*>::iterator itr = _layoutCache.begin();
+        while (itr != _layoutCache.end())
+        {
+            if (_layoutFrame - itr->second->_lastUsed > FONT_LAYOUT_CACHE_AGE)
+            {
+                SAFE_DELETE(itr->second);
+                _layoutCache.erase(itr++);
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+    }
 }
 
 Font::Text* Font::createText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
     bool wrap, bool rightToLeft, const Rectangle* clip)
 {
     GP_ASSERT(text);
-    GP_ASSERT(_glyphs);
+
+    Text* batch = new Text(text);
+    batch->_area = area;
+    batch->_color = color;
+    batch->_size = size;
+    batch->_justify = justify;
+    batch->_wrap = wrap;
+    batch->_rightToLeft = rightToLeft;
+    batch->_clipped = clip != NULL;
+    if (clip)
+        batch->_clip = *clip;
+    batch->_point = false;
+    batch->_partialLines = false;
+    layoutText(batch);
+
+    return batch;
+}
+
+Font::Text* Font::getCachedText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
+    bool wrap, bool rightToLeft, const Rectangle* clip, bool point)
+{
+    LayoutKey key;
+    key.text = text;
+    key.bounds[0] = area.x;
+    key.bounds[1] = area.y;
+    key.bounds[2] = area.width;
+    key.bounds[3] = area.height;
+    key.bounds[4] = clip ? clip->x : 0.0f;
+    key.bounds[5] = clip ? clip->y : 0.0f;
+    key.bounds[6] = clip ? clip->width : 0.0f;
+    key.bounds[7] = clip ? clip->height : 0.0f;
+    key.size = size == 0 ? _size : size;
+    key.flags = (unsigned int)justify | (wrap ? 0x100 : 0) | (rightToLeft ? 0x200 : 0) | (clip ? 0x400 : 0) | (point ? 0x800 : 0);
+
+    Text* batch;
+    std::map<LayoutKey, Text*>::iterator itr = _layoutCache.find(key);
+    if (itr != _layoutCache.end())
+    {
+        batch = itr->second;
+        batch->setColor(color);
+    }
+    else
+    {
+        batch = new Text(text);
+        batch->_area = area;
+        batch->_color = color;
+        batch->_size = key.size;
+        batch->_justify = justify;
+        batch->_wrap = wrap;
+        batch->_rightToLeft = rightToLeft;
+        batch->_clipped = clip != NULL;
+        if (clip)
+            batch->_clip = *clip;
+        batch->_point = point;
+        batch->_partialLines = true;
+        batch->_dirty = true;
+        _layoutCache[key] = batch;
+    }
+    batch->_lastUsed = _layoutFrame;
+
+    return batch;
+}
+
+void Font::layoutText(Text* text)
+{
+    GP_ASSERT(text);
+
+    text->_vertexCount = 0;
+    text->_indexCount = 0;
+    text->_atlasGlyphs.clear();
+    text->_dirty = false;
+    if (text->_point)
+    {
+        layoutPoint(text);
+    }
+    else
+    {
+        layoutArea(text);
+    }
+
+    // Glyphs evicted while laying out other text were not in use by this text.
+    text->_atlasVersion = _atlasVersion;
+}
+
+void Font::layoutArea(Text* batch)
+{
+    GP_ASSERT(batch);
+    GP_ASSERT(_glyphs || _rasterizer);
     GP_ASSERT(_batch);
 
+    const char* text = batch->_text.c_str();
+    const Rectangle& area = batch->_area;
+    const Vector4& color = batch->_color;
+    const Justify justify = batch->_justify;
+    const bool wrap = batch->_wrap;
+    const bool rightToLeft = batch->_rightToLeft;
+    const Rectangle* clip = batch->_clipped ? &batch->_clip : NULL;
+    unsigned int size = batch->_size;
     if (size == 0)
         size = _size;
     GP_ASSERT(_size);
@@ -175,9 +366,9 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
 
     getMeasurementInfo(text, area, size, justify, wrap, rightToLeft, &xPositions, &yPos, &lineLengths);
 
-    Text* batch = new Text(text);
-    GP_ASSERT(batch->_vertices);
-    GP_ASSERT(batch->_indices);
+    // Lines that are partially above the area are either drawn (and clipped) or skipped.
+    const int top = batch->_partialLines ? static_cast<int>(area.y - size) : static_cast<int>(area.y);
+    batch->reserve((unsigned int)strlen(text));
 
     int xPos = area.x;
     std::vector<int>::const_iterator xPositionsIt = xPositions.begin();
@@ -247,7 +438,7 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
         }
 
         bool draw = true;
-        if (yPos < static_cast<int>(area.y))
+        if (yPos < top)
         {
             // Skip drawing until line break or wrap.
             draw = false;
@@ -260,12 +451,10 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
 
         for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
         {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(token + i);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
+                const Glyph& g = *glyph;
 
                 if (xPos + (int)(g.width*scale) > area.x + area.width)
                 {
@@ -278,43 +467,7 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
                     // Draw this character.
                     if (draw)
                     {
-                        if (clip)
-                        {
-                            _batch->addSprite(xPos, yPos, g.width * scale, size, g.uvs[0], g.uvs[1], g.uvs[2], g.uvs[3], color, *clip, &batch->_vertices[batch->_vertexCount]);
-                        }
-                        else
-                        {
-                            _batch->addSprite(xPos, yPos, g.width * scale, size, g.uvs[0], g.uvs[1], g.uvs[2], g.uvs[3], color, &batch->_vertices[batch->_vertexCount]);
-                        }
-
-                        if (batch->_vertexCount == 0)
-                        {
-                            // Simply copy values directly into the start of the index array
-                            batch->_indices[batch->_vertexCount] = batch->_vertexCount;
-                            batch->_indices[batch->_vertexCount + 1] = batch->_vertexCount + 1;
-                            batch->_indices[batch->_vertexCount + 2] = batch->_vertexCount + 2;
-                            batch->_indices[batch->_vertexCount + 3] = batch->_vertexCount + 3;
-                            batch->_vertexCount += 4;
-                            batch->_indexCount += 4;
-                        }
-                        else
-                        {
-                            // Create a degenerate triangle to connect separate triangle strips
-                            // by duplicating the previous and next vertices.
-                            batch->_indices[batch->_indexCount] = batch->_indices[batch->_indexCount - 1];
-                            batch->_indices[batch->_indexCount + 1] = batch->_vertexCount;
-            
-                            // Loop through all indices and insert them, their their value offset by
-                            // 'vertexCount' so that they are relative to the first newly insertted vertex
-                            for (unsigned int i = 0; i < 4; ++i)
-                            {
-                                batch->_indices[batch->_indexCount + 2 + i] = i + batch->_vertexCount;
-                            }
-
-                            batch->_indexCount += 6;
-                            batch->_vertexCount += 4;
-                        }
-
+                        addGlyph(batch, xPos, yPos, g.width * scale, size, g, color, clip);
                     }
                 }
                 xPos += (int)(g.width)*scale + (size >> 3);
@@ -384,23 +537,22 @@ Font::Text* Font::createText(const char* text, const Rectangle& area, const Vect
         }
     }
 
-    return batch;
-}
-
-void Font::drawText(Text* text)
-{
-    GP_ASSERT(_batch);
-    GP_ASSERT(text->_vertices);
-    GP_ASSERT(text->_indices);
-    _batch->draw(text->_vertices, text->_vertexCount, text->_indices, text->_indexCount);
 }
 
-void Font::drawText(const char* text, int x, int y, const Vector4& color, unsigned int size, bool rightToLeft)
+void Font::layoutPoint(Text* batch)
 {
+    GP_ASSERT(batch);
+
+    const char* text = batch->_text.c_str();
+    const int x = (int)batch->_area.x;
+    const int y = (int)batch->_area.y;
+    const Vector4& color = batch->_color;
+    const bool rightToLeft = batch->_rightToLeft;
+    unsigned int size = batch->_size;
     if (size == 0)
         size = _size;
     GP_ASSERT(_size);
-    GP_ASSERT(text);
+    batch->reserve((unsigned int)strlen(text));
     float scale = (float)size / _size;
     const char* cursor = NULL;
 
@@ -463,19 +615,12 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
             iteration = 1;
         }
 
-        GP_ASSERT(_glyphs);
+        GP_ASSERT(_glyphs || _rasterizer);
         GP_ASSERT(_batch);
         for (size_t i = startIndex; i < length; i += (size_t)iteration)
         {
-            char c = 0;
-            if (rightToLeft)
-            {
-                c = cursor[i];
-            }
-            else
-            {
-                c = text[i];
-            }
+            const char* character = rightToLeft ? cursor + i : text + i;
+            char c = character[0];
 
             // Draw this character.
             switch (c)
@@ -492,11 +637,11 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
                 xPos += (size >> 1)*4;
                 break;
             default:
-                int index = c - 32; // HACK for ASCII
-                if (index >= 0 && index < (int)_glyphCount)
+                const Glyph* glyph = getGlyph(character);
+                if (glyph)
                 {
-                    Glyph& g = _glyphs[index];
-                    _batch->draw(xPos, yPos, g.width * scale, size, g.uvs[0], g.uvs[1], g.uvs[2], g.uvs[3], color);
+                    const Glyph& g = *glyph;
+                    addGlyph(batch, xPos, yPos, g.width * scale, size, g, color, NULL);
                     xPos += floor(g.width * scale + (float)(size >> 3));
                     break;
                 }
@@ -515,209 +660,130 @@ void Font::drawText(const char* text, int x, int y, const Vector4& color, unsign
     }
 }
 
-void Font::drawText(const char* text, int x, int y, float red, float green, float blue, float alpha, unsigned int size, bool rightToLeft)
-{
-    drawText(text, x, y, Vector4(red, green, blue, alpha), size, rightToLeft);
-}
-
-void Font::drawText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify, bool wrap, bool rightToLeft, const Rectangle* clip)
+void Font::addGlyph(Text* text, float x, float y, float width, float height, const Glyph& glyph, const Vector4& color, const Rectangle* clip)
 {
     GP_ASSERT(text);
+    GP_ASSERT(text->_vertexCount / 4 < text->_capacity);
 
-    if (size == 0)
-        size = _size;
-    GP_ASSERT(_size);
-    float scale = (float)size / _size;
-    int yPos = area.y;
-    const float areaHeight = area.height - size;
-    std::vector<int> xPositions;
-    std::vector<unsigned int> lineLengths;
+    float u1 = glyph.uvs[0];
+    float v1 = glyph.uvs[1];
+    float u2 = glyph.uvs[2];
+    float v2 = glyph.uvs[3];
 
-    getMeasurementInfo(text, area, size, justify, wrap, rightToLeft, &xPositions, &yPos, &lineLengths);
+    // Glyphs entirely outside of the clip region are left out.
+    if (clip && !_batch->clipSprite(*clip, x, y, width, height, u1, v1, u2, v2))
+        return;
 
-    // Now we have the info we need in order to render.
-    int xPos = area.x;
-    std::vector<int>::const_iterator xPositionsIt = xPositions.begin();
-    if (xPositionsIt != xPositions.end())
+    if (_rasterizer)
     {
-        xPos = *xPositionsIt++;
+        // The glyphs of dynamic fonts are the first member of their AtlasGlyph.
+        text->_atlasGlyphs.push_back((AtlasGlyph*)&glyph);
     }
 
-    const char* token = text;
-    int iteration = 1;
-    unsigned int lineLength;
-    unsigned int currentLineLength = 0;
-    const char* lineStart;
-    std::vector<unsigned int>::const_iterator lineLengthsIt;
-    if (rightToLeft)
+    _batch->addSprite(x, y, width, height, u1, v1, u2, v2, color, &text->_vertices[text->_vertexCount]);
+
+    if (text->_vertexCount == 0)
     {
-        lineStart = token;
-        lineLengthsIt = lineLengths.begin();
-        lineLength = *lineLengthsIt++;
-        token += lineLength - 1;
-        iteration = -1;
+        // Simply copy values directly into the start of the index array
+        text->_indices[0] = 0;
+        text->_indices[1] = 1;
+        text->_indices[2] = 2;
+        text->_indices[3] = 3;
+        text->_vertexCount += 4;
+        text->_indexCount += 4;
     }
-
-    while (token[0] != 0)
+    else
     {
-        // Handle delimiters until next token.
-        if (!handleDelimiters(&token, size, iteration, area.x, &xPos, &yPos, &currentLineLength, &xPositionsIt, xPositions.end()))
+        // Create a degenerate triangle to connect separate triangle strips
+        // by duplicating the previous and next vertices.
+        text->_indices[text->_indexCount] = text->_indices[text->_indexCount - 1];
+        text->_indices[text->_indexCount + 1] = text->_vertexCount;
+
+        // Loop through all indices and insert them, their their value offset by
+        // 'vertexCount' so that they are relative to the first newly insertted vertex
+        for (unsigned int i = 0; i < 4; ++i)
         {
-            break;
+            text->_indices[text->_indexCount + 2 + i] = i + text->_vertexCount;
         }
 
-        bool truncated = false;
-        unsigned int tokenLength;
-        unsigned int tokenWidth;
-        unsigned int startIndex;
-        if (rightToLeft)
-        {
-            tokenLength = getReversedTokenLength(token, text);
-            currentLineLength += tokenLength;
-            token -= (tokenLength - 1);
-            tokenWidth = getTokenWidth(token, tokenLength, size, scale);
-            iteration = -1;
-            startIndex = tokenLength - 1;
-        }
-        else
-        {
-            tokenLength = (unsigned int)strcspn(token, " \r\n\t");
-            tokenWidth = getTokenWidth(token, tokenLength, size, scale);
-            iteration = 1;
-            startIndex = 0;
-        }
+        text->_indexCount += 6;
+        text->_vertexCount += 4;
+    }
+}
 
-        // Wrap if necessary.
-        if (wrap && (xPos + (int)tokenWidth > area.x + area.width || (rightToLeft && currentLineLength > lineLength)))
-        {
-            yPos += (int)size;
-            currentLineLength = tokenLength;
+void Font::drawText(Text* text)
+{
+    drawText(text, Vector2::zero());
+}
 
-            if (xPositionsIt != xPositions.end())
-            {
-                xPos = *xPositionsIt++;
-            }
-            else
-            {
-                xPos = area.x;
-            }
-        }
+void Font::drawText(Text* text, const Vector2& offset)
+{
+    GP_ASSERT(_batch);
+    GP_ASSERT(text);
 
-        bool draw = true;
-        if (yPos < static_cast<int>(area.y - size))
-        {
-            // Skip drawing until line break or wrap.
-            draw = false;
-        }
-        else if (yPos > area.y + areaHeight)
-        {
-            // Truncate below area's vertical limit.
-            break;
-        }
+    // Text is laid out again when the glyphs of a dynamic font have moved in the atlas.
+    if (text->_dirty || text->_atlasVersion != _atlasVersion)
+    {
+        layoutText(text);
+    }
+    for (size_t i = 0, count = text->_atlasGlyphs.size(); i < count; ++i)
+    {
+        text->_atlasGlyphs[i]->lastUsed = _layoutFrame;
+    }
+    if (text->_vertexCount == 0)
+        return;
 
-        GP_ASSERT(_glyphs);
-        GP_ASSERT(_batch);
-        for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
-        {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
-            {
-                Glyph& g = _glyphs[glyphIndex];
+    GP_ASSERT(text->_vertices);
+    GP_ASSERT(text->_indices);
+    if (offset.isZero())
+    {
+        _batch->draw(text->_vertices, text->_vertexCount, text->_indices, text->_indexCount);
+        return;
+    }
 
-                if (xPos + (int)(g.width*scale) > area.x + area.width)
-                {
-                    // Truncate this line and go on to the next one.
-                    truncated = true;
-                    break;
-                }
-                else if (xPos >= area.x)
-                {
-                    // Draw this character.
-                    if (draw)
-                    {
-                        if (clip)
-                        {
-                            _batch->draw(xPos, yPos, g.width * scale, size, g.uvs[0], g.uvs[1], g.uvs[2], g.uvs[3], color, *clip);
-                        }
-                        else
-                        {
-                            _batch->draw(xPos, yPos, g.width * scale, size, g.uvs[0], g.uvs[1], g.uvs[2], g.uvs[3], color);
-                        }
-                    }
-                }
-                xPos += (int)(g.width)*scale + (size >> 3);
-            }
-        }
+    _offsetVertices.assign(text->_vertices, text->_vertices + text->_vertexCount);
+    for (size_t i = 0, count = _offsetVertices.size(); i < count; ++i)
+    {
+        _offsetVertices[i].x += offset.x;
+        _offsetVertices[i].y += offset.y;
+    }
+    _batch->draw(&_offsetVertices[0], text->_vertexCount, text->_indices, text->_indexCount);
+}
 
-        if (!truncated)
-        {
-            if (rightToLeft)
-            {
-                if (token == lineStart)
-                {
-                    token += lineLength;
-                    
-                    // Now handle delimiters going forwards.
-                    if (!handleDelimiters(&token, size, 1, area.x, &xPos, &yPos, &currentLineLength, &xPositionsIt, xPositions.end()))
-                    {
-                        break;
-                    }
+void Font::drawText(const char* text, int x, int y, const Vector4& color, unsigned int size, bool rightToLeft)
+{
+    GP_ASSERT(text);
 
-                    if (lineLengthsIt != lineLengths.end())
-                    {
-                        lineLength = *lineLengthsIt++;
-                    }
-                    lineStart = token;
-                    token += lineLength-1;
-                }
-                else
-                {
-                    token--;
-                }
-            }
-            else
-            {
-                token += tokenLength;
-            }
-        }
-        else
-        {
-            if (rightToLeft)
-            {
-                token = lineStart + lineLength;
-                
-                if (!handleDelimiters(&token, size, 1, area.x, &xPos, &yPos, &currentLineLength, &xPositionsIt, xPositions.end()))
-                {
-                    break;
-                }
+    drawText(getCachedText(text, Rectangle(x, y, 0, 0), color, size, ALIGN_TOP_LEFT, false, rightToLeft, NULL, true));
+}
 
-                if (lineLengthsIt != lineLengths.end())
-                {
-                    lineLength = *lineLengthsIt++;
-                }
-                lineStart = token;
-                token += lineLength-1;
-            }
-            else
-            {
-                // Skip the rest of this line.
-                size_t tokenLength = strcspn(token, "\n");
+void Font::drawText(const char* text, int x, int y, float red, float green, float blue, float alpha, unsigned int size, bool rightToLeft)
+{
+    drawText(text, x, y, Vector4(red, green, blue, alpha), size, rightToLeft);
+}
 
-                if (tokenLength > 0)
-                {                
-                    // Get first token of next line.
-                    token += tokenLength;
-                }
-            }
-        }
-    }
+void Font::drawText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify, bool wrap, bool rightToLeft, const Rectangle* clip)
+{
+    GP_ASSERT(text);
+
+    drawText(getCachedText(text, area, color, size, justify, wrap, rightToLeft, clip, false));
+}
+
+void Font::drawText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
+                    bool wrap, bool rightToLeft, const Rectangle* clip, const Vector2& offset)
+{
+    GP_ASSERT(text);
+
+    drawText(getCachedText(text, area, color, size, justify, wrap, rightToLeft, clip, false), offset);
 }
 
 void Font::finish()
 {
     GP_ASSERT(_batch);
+    if (_rasterizer)
+    {
+        uploadAtlas();
+    }
     _batch->finish();
 }
 
@@ -1406,15 +1472,13 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
             break;
         }
 
-        GP_ASSERT(_glyphs);
+        GP_ASSERT(_glyphs || _rasterizer);
         for (int i = startIndex; i < (int)tokenLength && i >= 0; i += iteration)
         {
-            char c = token[i];
-            int glyphIndex = c - 32; // HACK for ASCII
-        
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(token + i);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
+                const Glyph& g = *glyph;
 
                 if (xPos + (int)(g.width*scale) > area.x + area.width)
                 {
@@ -1522,7 +1586,7 @@ int Font::getIndexOrLocation(const char* text, const Rectangle& area, unsigned i
 unsigned int Font::getTokenWidth(const char* token, unsigned int length, unsigned int size, float scale)
 {
     GP_ASSERT(token);
-    GP_ASSERT(_glyphs);
+    GP_ASSERT(_glyphs || _rasterizer);
 
     // Calculate width of word or line.
     unsigned int tokenWidth = 0;
@@ -1538,11 +1602,10 @@ unsigned int Font::getTokenWidth(const char* token, unsigned int length, unsigne
             tokenWidth += (size >> 1)*4;
             break;
         default:
-            int glyphIndex = c - 32;
-            if (glyphIndex >= 0 && glyphIndex < (int)_glyphCount)
+            const Glyph* glyph = getGlyph(token + i);
+            if (glyph)
             {
-                Glyph& g = _glyphs[glyphIndex];
-                tokenWidth += floor(g.width * scale + (float)(size >> 3));
+                tokenWidth += floor(glyph->width * scale + (float)(size >> 3));
             }
             break;
         }
@@ -1680,6 +1743,212 @@ void Font::addLineInfo(const Rectangle& area, int lineWidth, int lineLength, Jus
     }
 }
 
+static unsigned int decodeCharacter(const char* character)
+{
+    const unsigned char* bytes = (const unsigned char*)character;
+    unsigned int code = bytes[0];
+    unsigned int count = 0;
+    if (code >= 0xF0)
+    {
+        code &= 0x07;
+        count = 3;
+    }
+    else if (code >= 0xE0)
+    {
+        code &= 0x0F;
+        count = 2;
+    }
+    else if (code >= 0xC0)
+    {
+        code &= 0x1F;
+        count = 1;
+    }
+    for (unsigned int i = 1; i <= count; ++i)
+    {
+        // Bytes that do not start a valid UTF-8 sequence are characters of their own.
+        if ((bytes[i] & 0xC0) != 0x80)
+            return bytes[0];
+        code = (code << 6) | (bytes[i] & 0x3F);
+    }
+    return code;
+}
+
+const Font::Glyph* Font::getGlyph(const char* character)
+{
+    GP_ASSERT(character);
+
+    // The continuation bytes of a UTF-8 sequence belong to the character that starts it.
+    if (((unsigned char)character[0] & 0xC0) == 0x80)
+        return NULL;
+
+    unsigned int code = decodeCharacter(character);
+    if (_rasterizer == NULL)
+    {
+        int glyphIndex = (int)code - 32; // HACK for ASCII
+        return (glyphIndex >= 0 && glyphIndex < (int)_glyphCount) ? &_glyphs[glyphIndex] : NULL;
+    }
+
+    std::map<unsigned int, AtlasGlyph>::iterator itr = _atlasGlyphs.find(code);
+    if (itr != _atlasGlyphs.end())
+    {
+        itr->second.lastUsed = _layoutFrame;
+        return itr->second.glyph.width > 0 ? &itr->second.glyph : NULL;
+    }
+    AtlasGlyph* glyph = addAtlasGlyph(code);
+    return (glyph && glyph->glyph.width > 0) ? &glyph->glyph : NULL;
+}
+
+Font::AtlasGlyph* Font::addAtlasGlyph(unsigned int code)
+{
+    GP_ASSERT(_rasterizer);
+    GP_ASSERT(_atlasData);
+
+    unsigned int width = 0;
+    const unsigned char* bitmap = _rasterizer->rasterize(code, _size, &width);
+    if (bitmap == NULL || width == 0)
+    {
+        // Remember characters without a glyph so that they are not rasterized again.
+        AtlasGlyph& glyph = _atlasGlyphs[code];
+        memset(&glyph, 0, sizeof(AtlasGlyph));
+        glyph.glyph.code = code;
+        glyph.lastUsed = _layoutFrame;
+        return &glyph;
+    }
+
+    // Make room by evicting the least recently used glyphs.
+    unsigned int shelf, x;
+    while (!allocateAtlasSpan(width + FONT_ATLAS_PADDING, &shelf, &x))
+    {
+        if (!evictAtlasGlyph())
+        {
+            GP_WARN("The atlas of dynamic font '%s' is too small for the glyphs in use.", _family.c_str());
+            return NULL;
+        }
+    }
+
+    // Copy the bitmap into the atlas, followed by an empty column.
+    Shelf& s = _shelves[shelf];
+    for (unsigned int row = 0; row < _size; ++row)
+    {
+        unsigned char* texels = _atlasData + (s.y + row) * _atlasSize + x;
+        memcpy(texels, bitmap + row * width, width);
+        memset(texels + width, 0, FONT_ATLAS_PADDING);
+    }
+    s.dirtyX1 = std::min(s.dirtyX1, x);
+    s.dirtyX2 = std::max(s.dirtyX2, x + width + FONT_ATLAS_PADDING);
+
+    AtlasGlyph& glyph = _atlasGlyphs[code];
+    glyph.glyph.code = code;
+    glyph.glyph.width = width;
+    glyph.glyph.uvs[0] = (float)x / _atlasSize;
+    glyph.glyph.uvs[1] = (float)s.y / _atlasSize;
+    glyph.glyph.uvs[2] = (float)(x + width) / _atlasSize;
+    glyph.glyph.uvs[3] = (float)(s.y + _size) / _atlasSize;
+    glyph.shelf = shelf;
+    glyph.x = x;
+    glyph.lastUsed = _layoutFrame;
+    return &glyph;
+}
+
+bool Font::allocateAtlasSpan(unsigned int width, unsigned int* shelf, unsigned int* x)
+{
+    for (size_t i = 0, count = _shelves.size(); i < count; ++i)
+    {
+        std::vector<std::pair<unsigned int, unsigned int> >& spans = _shelves[i].freeSpans;
+        for (size_t j = 0, spanCount = spans.size(); j < spanCount; ++j)
+        {
+            if (spans[j].second >= width)
+            {
+                *shelf = (unsigned int)i;
+                *x = spans[j].first;
+                spans[j].first += width;
+                spans[j].second -= width;
+                if (spans[j].second == 0)
+                {
+                    spans.erase(spans.begin() + j);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Font::evictAtlasGlyph()
+{
+    // Glyphs used since the last call to start() may already be in the sprite batch.
+    std::map<unsigned int, AtlasGlyph>::iterator oldest = _atlasGlyphs.end();
+    for (std::map<unsigned int, AtlasGlyph>::iterator itr = _atlasGlyphs.begin(); itr != _atlasGlyphs.end(); ++itr)
+    {
+        if (itr->second.glyph.width > 0 && itr->second.lastUsed != _layoutFrame &&
+            (oldest == _atlasGlyphs.end() || itr->second.lastUsed < oldest->second.lastUsed))
+        {
+            oldest = itr;
+        }
+    }
+    if (oldest == _atlasGlyphs.end())
+        return false;
+
+    // Clear the texels of the glyph and give its span back to the shelf.
+    const unsigned int x = oldest->second.x;
+    const unsigned int width = oldest->second.glyph.width + FONT_ATLAS_PADDING;
+    Shelf& shelf = _shelves[oldest->second.shelf];
+    for (unsigned int row = 0; row < _size; ++row)
+    {
+        memset(_atlasData + (shelf.y + row) * _atlasSize + x, 0, width);
+    }
+    shelf.dirtyX1 = std::min(shelf.dirtyX1, x);
+    shelf.dirtyX2 = std::max(shelf.dirtyX2, x + width);
+
+    std::vector<std::pair<unsigned int, unsigned int> >& spans = shelf.freeSpans;
+    size_t i = 0;
+    while (i < spans.size() && spans[i].first < x)
+    {
+        ++i;
+    }
+    spans.insert(spans.begin() + i, std::make_pair(x, width));
+    if (i + 1 < spans.size() && spans[i].first + spans[i].second == spans[i + 1].first)
+    {
+        spans[i].second += spans[i + 1].second;
+        spans.erase(spans.begin() + i + 1);
+    }
+    if (i > 0 && spans[i - 1].first + spans[i - 1].second == spans[i].first)
+    {
+        spans[i - 1].second += spans[i].second;
+        spans.erase(spans.begin() + i);
+    }
+
+    _atlasGlyphs.erase(oldest);
+
+    // Layouts referencing the glyph must be computed again.
+    ++_atlasVersion;
+    return true;
+}
+
+void Font::uploadAtlas()
+{
+    GP_ASSERT(_texture);
+
+    for (size_t i = 0, count = _shelves.size(); i < count; ++i)
+    {
+        Shelf& shelf = _shelves[i];
+        if (shelf.dirtyX1 >= shelf.dirtyX2)
+            continue;
+
+        // Gather the dirty rectangle of the shelf, since rows of a sub-image must be contiguous.
+        const unsigned int width = shelf.dirtyX2 - shelf.dirtyX1;
+        _uploadData.resize(width * _size);
+        for (unsigned int row = 0; row < _size; ++row)
+        {
+            memcpy(&_uploadData[row * width], _atlasData + (shelf.y + row) * _atlasSize + shelf.dirtyX1, width);
+        }
+        _texture->setData(shelf.dirtyX1, shelf.y, width, _size, &_uploadData[0]);
+
+        shelf.dirtyX1 = _atlasSize;
+        shelf.dirtyX2 = 0;
+    }
+}
+
 SpriteBatch* Font::getSpriteBatch() const
 {
     return _batch;
@@ -1761,11 +2030,25 @@ Font::Justify Font::getJustify(const char* justify)
     return Font::ALIGN_TOP_LEFT;
 }
 
-Font::Text::Text(const char* text) : _text(text ? text : ""), _vertexCount(0), _vertices(NULL), _indexCount(0), _indices(NULL)
+bool Font::LayoutKey::operator<(const LayoutKey& key) const
 {
-    const size_t length = strlen(text);
-    _vertices = new SpriteBatch::SpriteVertex[length * 4];
-    _indices = new unsigned short[((length - 1) * 6) + 4];
+    if (size != key.size)
+        return size < key.size;
+    if (flags != key.flags)
+        return flags < key.flags;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (bounds[i] != key.bounds[i])
+            return bounds[i] < key.bounds[i];
+    }
+    return text < key.text;
+}
+
+Font::Text::Text(const char* text) : _text(text ? text : ""), _vertexCount(0), _vertices(NULL), _indexCount(0), _indices(NULL),
+    _capacity(0), _color(Vector4::one()), _size(0), _justify(ALIGN_TOP_LEFT), _wrap(false), _rightToLeft(false), _clipped(false),
+    _point(true), _partialLines(false), _dirty(false), _lastUsed(0), _atlasVersion(0)
+{
+    reserve((unsigned int)_text.length());
 }
 
 Font::Text::~Text()
@@ -1779,4 +2062,50 @@ const char* Font::Text::getText()
     return _text.c_str();
 }
 
+void Font::Text::setText(const char* text)
+{
+    if (text == NULL)
+        text = "";
+    if (_text != text)
+    {
+        _text = text;
+        _dirty = true;
+    }
+}
+
+const Vector4& Font::Text::getColor() const
+{
+    return _color;
+}
+
+void Font::Text::setColor(const Vector4& color)
+{
+    if (_color == color)
+        return;
+
+    _color = color;
+    for (unsigned int i = 0; i < _vertexCount; ++i)
+    {
+        _vertices[i].r = color.x;
+        _vertices[i].g = color.y;
+        _vertices[i].b = color.z;
+        _vertices[i].a = color.w;
+    }
+}
+
+void Font::Text::reserve(unsigned int glyphCount)
+{
+    if (glyphCount <= _capacity)
+        return;
+
+    // Every glyph is a strip of four vertices, connected to the previous one by a degenerate triangle.
+    SAFE_DELETE_ARRAY(_vertices);
+    SAFE_DELETE_ARRAY(_indices);
+    _vertices = new SpriteBatch::SpriteVertex[glyphCount * 4];
+    _indices = new unsigned short[glyphCount * 6 - 2];
+    _capacity = glyphCount;
+    _vertexCount = 0;
+    _indexCount = 0;
+}
+
 }
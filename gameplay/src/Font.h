@@ -12,6 +12,8 @@ namespace gameplay
 class Font : public Ref
 {
     friend class Bundle;
+    friend class Label;
+    friend class Slider;
     friend class TextBox;
 
 public:
@@ -49,10 +51,53 @@ public:
         ALIGN_BOTTOM_RIGHT = ALIGN_BOTTOM | ALIGN_RIGHT
     };
 
+    /**
+     * Defines the interface through which dynamic fonts rasterize their glyphs.
+     *
+     * Implementations typically wrap a font library such as FreeType or the font
+     * APIs of the platform.
+     *
+     * @script{ignore}
+     */
+    class Rasterizer
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~Rasterizer() { }
+
+        /**
+         * Rasterizes the glyph of a character.
+         *
+         * The bitmap of a glyph is a cell as high as the font size, with the glyph
+         * drawn on the baseline of the font, and as wide as the advance of the glyph.
+         *
+         * @param code The Unicode code point of the character.
+         * @param size The font size, which is the height of the cell in pixels.
+         * @param width Set to the width of the cell in pixels.
+         *
+         * @return The 8-bit coverage of the cell, row by row (width * size bytes), which
+         *      must remain valid until the next call, or NULL if there is no glyph for the character.
+         */
+        virtual const unsigned char* rasterize(unsigned int code, unsigned int size, unsigned int* width) = 0;
+    };
+
+private:
+
+    struct AtlasGlyph;
+
+public:
+
     /**
      * Vertex coordinates, UVs and indices can be computed and stored in a Text object.
      * For static text labels that do not change frequently, this means these computations
      * need not be performed every frame.
+     *
+     * A Text object keeps the area, size and justification it was created with. Changing
+     * its string with setText lays its glyphs out again the next time it is drawn, while
+     * changing its color only updates the colors of the existing vertices.
      */
     class Text
     {
@@ -74,6 +119,29 @@ public:
          */
         const char* getText();
 
+        /**
+         * Sets the string that will be drawn from this Text object.
+         *
+         * The glyphs are laid out again the next time the text is drawn, only if the string changed.
+         *
+         * @param text The new string.
+         */
+        void setText(const char* text);
+
+        /**
+         * Gets the color of this Text object.
+         *
+         * @return The color of the text.
+         */
+        const Vector4& getColor() const;
+
+        /**
+         * Sets the color of this Text object.
+         *
+         * @param color The new color of the text.
+         */
+        void setColor(const Vector4& color);
+
     private:
         /**
          * Hidden copy constructor.
@@ -83,13 +151,32 @@ public:
          * Hidden copy assignment operator.
          */
         Text& operator=(const Text&);
+
+        /**
+         * Makes room for the vertices and indices of the specified number of glyphs.
+         */
+        void reserve(unsigned int glyphCount);
         
         std::string _text;
         unsigned int _vertexCount;
         SpriteBatch::SpriteVertex* _vertices;
         unsigned int _indexCount;
         unsigned short* _indices;
+        unsigned int _capacity;
         Vector4 _color;
+        Rectangle _area;
+        unsigned int _size;
+        Justify _justify;
+        bool _wrap;
+        bool _rightToLeft;
+        Rectangle _clip;
+        bool _clipped;
+        bool _point;
+        bool _partialLines;
+        bool _dirty;
+        unsigned int _lastUsed;
+        unsigned int _atlasVersion;
+        std::vector<AtlasGlyph*> _atlasGlyphs;
     };
 
     /**
@@ -110,11 +197,43 @@ public:
      */
     static Font* create(const char* path, const char* id = NULL);
 
+    /**
+     * Creates a font that rasterizes its glyphs on demand.
+     *
+     * Glyphs are rasterized the first time they are drawn or measured, and packed into
+     * rows of a texture atlas. Once the atlas is full, the least recently used glyphs are
+     * evicted. Only the parts of the atlas that changed are uploaded, when finish() is called.
+     * Text drawn with a dynamic font is decoded as UTF-8, so this suits large character sets,
+     * such as CJK text, that are impractical to bake into a font bundle.
+     *
+     * Glyphs are only evicted if they were not used since the last call to start(), so the
+     * atlas must be large enough for all of the glyphs drawn between start() and finish().
+     *
+     * @param family The font family name.
+     * @param size The font size in pixels.
+     * @param rasterizer The rasterizer of the glyphs, which must remain valid for the lifetime of the font.
+     * @param atlasSize The width and height of the texture atlas in pixels.
+     *
+     * @return The new Font, or NULL if it could not be created.
+     * @script{ignore}
+     */
+    static Font* createDynamic(const char* family, unsigned int size, Rasterizer* rasterizer, unsigned int atlasSize = 512);
+
     /**
      * Returns the font size (max height of glyphs) in pixels.
      */
     unsigned int getSize();
 
+    /**
+     * Determines whether the glyphs of this font are stored as a signed distance field.
+     *
+     * Distance field fonts are created by gameplay-encoder with the -sdf option. They
+     * are drawn crisply at any size, so a single font can be used for all text sizes.
+     *
+     * @return True if the font is a distance field font, false if it is a bitmap font.
+     */
+    bool isDistanceField() const;
+
     /**
      * Starts text drawing for this font.
      */
@@ -123,6 +242,9 @@ public:
     /**
      * Draws the specified text in a solid color, with a scaling factor.
      *
+     * The glyphs laid out for a string are cached by the font, so drawing the same
+     * string at the same position and size again does not lay it out again.
+     *
      * @param text The text to draw.
      * @param x The viewport x position to draw text at.
      * @param y The viewport y position to draw text at.
@@ -166,12 +288,14 @@ public:
     /**
      * Draw a string from a precomputed Text object.
      *
+     * All text drawn between start() and finish() is submitted with a single draw call.
+     *
      * @param text The text to draw.
      */
     void drawText(Text* text);
 
     /**
-     * Create an immutable Text object from a given string.
+     * Create a Text object from a given string.
      * Vertex coordinates, UVs and indices will be computed and stored in the Text object.
      * For static text labels that do not change frequently, this means these computations
      * need not be performed every frame.
@@ -305,10 +429,12 @@ private:
      * @param glyphs An array of font glyphs, defining each character in the font within the texture map.
      * @param glyphCount The number of items in the glyph array.
      * @param texture A texture map containing rendered glyphs.
+     * @param distanceField True if the texture map contains a signed distance field of the glyphs.
      * 
      * @return The new Font.
      */
-    static Font* create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture);
+    static Font* create(const char* family, Style style, unsigned int size, Glyph* glyphs, int glyphCount, Texture* texture,
+                        bool distanceField = false);
 
     void getMeasurementInfo(const char* text, const Rectangle& area, unsigned int size, Justify justify, bool wrap, bool rightToLeft,
                             std::vector<int>* xPositions, int* yPosition, std::vector<unsigned int>* lineLengths);
@@ -327,16 +453,104 @@ private:
     void addLineInfo(const Rectangle& area, int lineWidth, int lineLength, Justify hAlign,
                      std::vector<int>* xPositions, std::vector<unsigned int>* lineLengths, bool rightToLeft);
 
+    /**
+     * Defines a glyph of a dynamic font in the texture atlas.
+     */
+    struct AtlasGlyph
+    {
+        Glyph glyph;
+        unsigned int shelf;
+        unsigned int x;
+        unsigned int lastUsed;
+    };
+
+    /**
+     * Defines a row of glyphs in the texture atlas of a dynamic font.
+     */
+    struct Shelf
+    {
+        unsigned int y;
+        std::vector<std::pair<unsigned int, unsigned int> > freeSpans;     // x and width of the free spans, sorted by x.
+        unsigned int dirtyX1;
+        unsigned int dirtyX2;
+    };
+
+    /**
+     * Returns the glyph of the character starting at the specified byte of a string,
+     * rasterizing it first for dynamic fonts, or NULL if there is no glyph for it.
+     */
+    const Glyph* getGlyph(const char* character);
+
+    AtlasGlyph* addAtlasGlyph(unsigned int code);
+
+    bool allocateAtlasSpan(unsigned int width, unsigned int* shelf, unsigned int* x);
+
+    bool evictAtlasGlyph();
+
+    void uploadAtlas();
+
+    /**
+     * Identifies a cached text layout.
+     */
+    struct LayoutKey
+    {
+        std::string text;
+        float bounds[8];
+        unsigned int size;
+        unsigned int flags;
+
+        bool operator<(const LayoutKey& key) const;
+    };
+
+    /**
+     * Returns the cached layout of a string drawn with drawText, creating it if needed.
+     */
+    Text* getCachedText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
+                        bool wrap, bool rightToLeft, const Rectangle* clip, bool point);
+
+    /**
+     * Computes the vertices and indices of a Text object from its string and layout.
+     */
+    void layoutText(Text* text);
+
+    /**
+     * Draws a string like drawText, translated by an offset after it is laid out.
+     *
+     * Text that moves without changing, such as the text of a control in a scrolling
+     * container, keeps using the layout cached for the area it was first drawn in.
+     */
+    void drawText(const char* text, const Rectangle& area, const Vector4& color, unsigned int size, Justify justify,
+                  bool wrap, bool rightToLeft, const Rectangle* clip, const Vector2& offset);
+
+    void drawText(Text* text, const Vector2& offset);
+
+    void layoutArea(Text* text);
+
+    void layoutPoint(Text* text);
+
+    void addGlyph(Text* text, float x, float y, float width, float height, const Glyph& glyph, const Vector4& color, const Rectangle* clip);
+
     std::string _path;
     std::string _id;
     std::string _family;
     Style _style;
     unsigned int _size;
+    bool _distanceField;
     Glyph* _glyphs;
     unsigned int _glyphCount;
     Texture* _texture;
     SpriteBatch* _batch;
     Rectangle _viewport;
+    std::map<LayoutKey, Text*> _layoutCache;
+    unsigned int _layoutFrame;
+    Rasterizer* _rasterizer;
+    std::map<unsigned int, AtlasGlyph> _atlasGlyphs;
+    std::vector<Shelf> _shelves;
+    unsigned char* _atlasData;
+    unsigned int _atlasSize;
+    unsigned int _atlasVersion;
+    std::vector<unsigned char> _uploadData;
+    std::vector<SpriteBatch::SpriteVertex> _offsetVertices;
 };
 
 }
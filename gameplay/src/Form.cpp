@@ -9,6 +9,7 @@
 #include "Button.h"
 #include "CheckBox.h"
 #include "Scene.h"
+#include "DebugMarkers.h"
 
 // Default form shaders
 #define FORM_VSH "res/shaders/form.vert"
@@ -21,7 +22,7 @@ static Effect* __formEffect = NULL;
 static std::vector<Form*> __forms;
 
 Form::Form() : _theme(NULL), _frameBuffer(NULL), _spriteBatch(NULL), _node(NULL),
-    _nodeQuad(NULL), _nodeMaterial(NULL) , _u2(0), _v1(0), _isGamepad(false)
+    _nodeQuad(NULL), _nodeMaterial(NULL) , _u2(0), _v1(0), _offscreen(true), _isGamepad(false), _layoutCount(0)
 {
 }
 
@@ -150,6 +151,7 @@ Form* Form::create(const char* url)
     {
         style = theme->getEmptyStyle();
     }
+    form->_offscreen = formProperties->getBool("offscreen", true);
     form->initialize(style, formProperties);
 
     form->_consumeInputEvents = formProperties->getBool("consumeInputEvents", false);
@@ -224,48 +226,72 @@ void Form::setSize(float width, float height)
         height = Game::getInstance()->getHeight();
     }
 
-    if (width != 0.0f && height != 0.0f &&
-        (width != _bounds.width || height != _bounds.height))
-    {
-        // Width and height must be powers of two to create a texture.
-        unsigned int w = nextPowerOfTwo(width);
-        unsigned int h = nextPowerOfTwo(height);
-        _u2 = width / (float)w;
-        _v1 = height / (float)h;
-
-        // Create framebuffer if necessary. TODO: Use pool to cache.
-        if (_frameBuffer)
-            SAFE_RELEASE(_frameBuffer)
-        
-        _frameBuffer = FrameBuffer::create(_id.c_str(), w, h);
-        GP_ASSERT(_frameBuffer);
+    bool resized = width != 0.0f && height != 0.0f && (width != _bounds.width || height != _bounds.height);
+    _bounds.width = width;
+    _bounds.height = height;
+    _dirty = true;
 
+    if (resized)
+    {
         // Re-create projection matrix.
         Matrix::createOrthographicOffCenter(0, width, height, 0, 0, 1, &_projectionMatrix);
 
-        // Re-create sprite batch.
-        SAFE_DELETE(_spriteBatch);
-        _spriteBatch = SpriteBatch::create(_frameBuffer->getRenderTarget()->getTexture());
-        GP_ASSERT(_spriteBatch);
+        updateFrameBuffer();
+    }
+}
 
-        // Clear the framebuffer black
-        Game* game = Game::getInstance();
-        FrameBuffer* previousFrameBuffer = _frameBuffer->bind();
-        Rectangle previousViewport = game->getViewport();
+void Form::updateFrameBuffer()
+{
+    // The old framebuffer goes back to the pool.
+    SAFE_RELEASE(_frameBuffer);
+    SAFE_DELETE(_spriteBatch);
+    if ((!_offscreen && !_node) || _bounds.width <= 0.0f || _bounds.height <= 0.0f)
+        return;
 
-        game->setViewport(Rectangle(0, 0, width, height));
-        _theme->setProjectionMatrix(_projectionMatrix);
-        game->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0, 0);
-        _theme->setProjectionMatrix(_defaultProjectionMatrix);
+    // The framebuffer is only sampled clamped and without mipmaps, which every GPU
+    // supports for textures of any size, so it need not be rounded up to powers of two.
+    unsigned int w = (unsigned int)ceil(_bounds.width);
+    unsigned int h = (unsigned int)ceil(_bounds.height);
+    _u2 = _bounds.width / (float)w;
+    _v1 = _bounds.height / (float)h;
 
-        previousFrameBuffer->bind();
-        game->setViewport(previousViewport);
-    }
-    _bounds.width = width;
-    _bounds.height = height;
+    _frameBuffer = Game::getInstance()->getRenderTargetPool()->acquire(w, h);
+    GP_ASSERT(_frameBuffer);
+
+    _spriteBatch = SpriteBatch::create(_frameBuffer->getRenderTarget()->getTexture());
+    GP_ASSERT(_spriteBatch);
+    _spriteBatch->getSampler()->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+
+    // Clear the framebuffer black
+    Game* game = Game::getInstance();
+    FrameBuffer* previousFrameBuffer = _frameBuffer->bind();
+    Rectangle previousViewport = game->getViewport();
+
+    game->setViewport(Rectangle(0, 0, _bounds.width, _bounds.height));
+    _theme->setProjectionMatrix(_projectionMatrix);
+    game->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0, 0);
+    _theme->setProjectionMatrix(_defaultProjectionMatrix);
+
+    previousFrameBuffer->bind();
+    game->setViewport(previousViewport);
     _dirty = true;
 }
 
+bool Form::isOffscreen() const
+{
+    return _offscreen;
+}
+
+void Form::setOffscreen(bool offscreen)
+{
+    if (offscreen != _offscreen)
+    {
+        _offscreen = offscreen;
+        updateFrameBuffer();
+        _dirty = true;
+    }
+}
+
 void Form::setBounds(const Rectangle& bounds)
 {
     setPosition(bounds.x, bounds.y);
@@ -335,6 +361,14 @@ void Form::setNode(Node* node)
     // If the user wants a custom node then we need to create a 3D quad
     if (node && node != _node)
     {
+        // The quad is textured with the framebuffer, so a form drawn directly starts rendering offscreen.
+        if (_frameBuffer == NULL)
+        {
+            _node = node;
+            updateFrameBuffer();
+            GP_ASSERT(_frameBuffer);
+        }
+
         // Set this Form up to be 3D by initializing a quad.
         float x2 = _bounds.width;
         float y2 = _bounds.height;
@@ -391,6 +425,8 @@ void Form::setNode(Node* node)
 
 void Form::update(float elapsedTime)
 {
+    _arrangeCount = 0;
+
     if (isDirty())
     {
         updateBounds();
@@ -409,6 +445,13 @@ void Form::update(float elapsedTime)
             _layout->update(this, Vector2::zero());
         }
     }
+
+    _layoutCount = _arrangeCount;
+}
+
+unsigned int Form::getLayoutCount() const
+{
+    return _layoutCount;
 }
 
 void Form::updateBounds()
@@ -534,6 +577,22 @@ void Form::draw()
     // must be transformed appropriately by the user, unless they call setQuad() themselves.
     // On the other hand, if this form has not been set on a node, SpriteBatch will be used
     // to render the contents of the framebuffer directly to the display.
+    DebugMarkers::Group marker("Form", getId());
+
+    // A form that is not offscreen draws its controls straight to the current framebuffer, every frame.
+    if (!_frameBuffer)
+    {
+        Matrix projectionMatrix(_defaultProjectionMatrix);
+        projectionMatrix.translate(_bounds.x, _bounds.y, 0);
+
+        GP_ASSERT(_theme);
+        _theme->setProjectionMatrix(projectionMatrix);
+        _theme->startBatch();
+        Container::draw(_theme->getSpriteBatch(), Rectangle(0, 0, _bounds.width, _bounds.height), false, true, _bounds.height);
+        _theme->finishBatch();
+        _theme->setProjectionMatrix(_defaultProjectionMatrix);
+        return;
+    }
 
     // Check whether this form has changed since the last call to draw() and if so, render into the framebuffer.
     if (isDirty())
@@ -547,6 +606,9 @@ void Form::draw()
 
         GP_ASSERT(_theme);
         _theme->setProjectionMatrix(_projectionMatrix);
+
+        // Controls add their sprites and text to the batches of the theme, which are drawn together.
+        _theme->startBatch();
         
         // By setting needsClear to true here, an optimization meant to clear and redraw only areas of the form
         // that have changed is disabled.  Currently, repositioning controls can result in areas of the screen being cleared
@@ -554,6 +616,7 @@ void Form::draw()
         // dirty controls were last frame, and another to draw them where they are now.
         Container::draw(_theme->getSpriteBatch(), Rectangle(0, 0, _bounds.width, _bounds.height),
                         /*_skin != NULL*/ true, false, _bounds.height);
+        _theme->finishBatch();
         _theme->setProjectionMatrix(_defaultProjectionMatrix);
 
         // Restore the previous game viewport.
@@ -589,6 +652,8 @@ const char* Form::getType() const
 
 void Form::updateInternal(float elapsedTime)
 {
+    GP_PROFILE_SCOPE("Form::updateInternal");
+
     size_t size = __forms.size();
     for (size_t i = 0; i < size; ++i)
     {
@@ -777,22 +842,4 @@ bool Form::projectPoint(int x, int y, Vector3* point)
     return false;
 }
 
-unsigned int Form::nextPowerOfTwo(unsigned int v)
-{
-    if (!((v & (v - 1)) == 0))
-    {
-        v--;
-        v |= v >> 1;
-        v |= v >> 2;
-        v |= v >> 4;
-        v |= v >> 8;
-        v |= v >> 16;
-        return v + 1;
-    }
-    else
-    {
-        return v;
-    }
-}
-
 }
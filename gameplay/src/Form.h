@@ -34,6 +34,7 @@ class Theme;
         width      = <width>               // Can be used in place of 'size', e.g. with 'autoHeight = true'
         height     = <height>              // Can be used in place of 'size', e.g. with 'autoWidth = true'
         consumeEvents = <bool>             // Whether the form propagates input events to the Game's input event handler. Default is false
+        offscreen  = <bool>                // Whether the form is rendered into a framebuffer and redrawn only when it changes. Default is true
       
         // All the nested controls within this form.
         container { }
@@ -147,11 +148,45 @@ public:
      */
     void setNode(Node* node);
 
+    /**
+     * Determines whether this form is rendered into a framebuffer.
+     *
+     * @return True if the form is rendered offscreen.
+     * @script{ignore}
+     */
+    bool isOffscreen() const;
+
+    /**
+     * Sets whether this form is rendered into a framebuffer.
+     *
+     * An offscreen form is rendered into a framebuffer of its size when its contents change,
+     * and the framebuffer is drawn each frame. A form that is not offscreen draws its controls
+     * straight to the current framebuffer each frame, which saves the memory of the framebuffer
+     * and the fill of copying it, at the cost of drawing the controls every frame. Forms that
+     * change often, or cover little of the screen, are cheaper drawn directly. A form attached
+     * to a node is always rendered offscreen, since its framebuffer textures the quad.
+     *
+     * @param offscreen True to render the form offscreen. Default is true.
+     * @script{ignore}
+     */
+    void setOffscreen(bool offscreen);
+
     /**
      * Updates each control within this form, and positions them according to its layout.
      */
     void update(float elapsedTime);
 
+    /**
+     * Gets the number of controls whose layout was updated by the last call to update.
+     *
+     * Layouts skip the controls that are not dirty and whose container has not changed,
+     * so a change to a single control only updates the controls around it. This is
+     * meant for profiling.
+     *
+     * @return The number of controls updated.
+     */
+    unsigned int getLayoutCount() const;
+
     /**
      * Draws this form.
      */
@@ -227,13 +262,10 @@ private:
     static void gamepadEventInternal(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex);
 
     /**
-     * Get the next highest power of two of an integer.  Used when creating framebuffers.
-     *
-     * @param x The number to start with.
-     *
-     * @return The next highest power of two after x, or x if it is already a power of two.
+     * Takes a framebuffer of the form's size from the render target pool if the form is
+     * rendered offscreen, or gives it back otherwise.
      */
-    static unsigned int nextPowerOfTwo(unsigned int x);
+    void updateFrameBuffer();
 
     /**
      * Unproject a point (from a mouse or touch event) into the scene and then project it onto the form.
@@ -254,9 +286,11 @@ private:
     Material* _nodeMaterial;            // Material for rendering this Form in 3d space.
     float _u2;
     float _v1;
+    bool _offscreen;                    // Whether the Form is rendered into _frameBuffer rather than drawn directly.
     Matrix _projectionMatrix;           // Orthographic projection matrix to be set on SpriteBatch objects when rendering into the FBO.
     Matrix _defaultProjectionMatrix;
     bool _isGamepad;
+    unsigned int _layoutCount;          // Number of controls updated by the last call to update().
 };
 
 }
@@ -1,6 +1,17 @@
 #include "Base.h"
 #include "FrameBuffer.h"
 #include "Game.h"
+#include "RenderCommandList.h"
+
+#ifndef GL_COLOR
+#define GL_COLOR 0x1800
+#endif
+#ifndef GL_DEPTH
+#define GL_DEPTH 0x1801
+#endif
+#ifndef GL_STENCIL
+#define GL_STENCIL 0x1802
+#endif
 
 #define FRAMEBUFFER_ID_DEFAULT "org.gameplay3d.framebuffer.default"
 
@@ -39,7 +50,7 @@ FrameBuffer::~FrameBuffer()
     // Release GL resource.
     if (_handle)
     {
-        GL_ASSERT( glDeleteFramebuffers(1, &_handle) );
+        RenderCommandList::deleteFramebuffer(_handle);
     }
 
     // Remove self from vector.
@@ -263,7 +274,7 @@ bool FrameBuffer::isDefault() const
 
 FrameBuffer* FrameBuffer::bind()
 {
-    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _handle) );
+    bindHandle();
     FrameBuffer* previousFrameBuffer = _currentFrameBuffer;
     _currentFrameBuffer = this;
     return previousFrameBuffer;
@@ -271,11 +282,86 @@ FrameBuffer* FrameBuffer::bind()
 
 FrameBuffer* FrameBuffer::bindDefault()
 {
-    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, _defaultFrameBuffer->_handle) );
+    _defaultFrameBuffer->bindHandle();
     _currentFrameBuffer = _defaultFrameBuffer;
     return _defaultFrameBuffer;
 }
 
+void FrameBuffer::readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                             ReadbackQueue::ReadbackCallback callback, void* cookie)
+{
+    Game::getInstance()->getReadbackQueue()->read(this, x, y, width, height, callback, cookie);
+}
+
+void FrameBuffer::discard(bool color, bool depthStencil)
+{
+    GP_ASSERT(_currentFrameBuffer == this);
+
+#ifdef USE_INVALIDATE_FRAMEBUFFER
+    if (!glInvalidateFramebuffer)
+        return;
+
+    // The default frame buffer names its buffers rather than attachment points.
+    std::vector<GLenum> attachments;
+    if (this == _defaultFrameBuffer)
+    {
+        if (color)
+            attachments.push_back(GL_COLOR);
+        if (depthStencil)
+        {
+            attachments.push_back(GL_DEPTH);
+            attachments.push_back(GL_STENCIL);
+        }
+    }
+    else
+    {
+        if (color)
+        {
+            for (unsigned int i = 0; i < _maxRenderTargets; ++i)
+            {
+                if (_renderTargets[i])
+                    attachments.push_back(GL_COLOR_ATTACHMENT0 + i);
+            }
+        }
+        if (depthStencil && _depthStencilTarget)
+        {
+            attachments.push_back(GL_DEPTH_ATTACHMENT);
+            if (_depthStencilTarget->getFormat() == DepthStencilTarget::DEPTH_STENCIL)
+                attachments.push_back(GL_STENCIL_ATTACHMENT);
+        }
+    }
+    if (!attachments.empty())
+        RenderCommandList::invalidateFramebuffer((GLsizei)attachments.size(), &attachments[0]);
+#endif
+}
+
+void FrameBuffer::bindHandle() const
+{
+    if (this == _defaultFrameBuffer)
+    {
+        RenderCommandList::bindFramebuffer(_handle, NULL, 0, 0, 0);
+        return;
+    }
+
+    std::vector<GLuint> colorTextures(_maxRenderTargets + 1, 0);
+    for (unsigned int i = 0; i < _maxRenderTargets; ++i)
+    {
+        if (_renderTargets[i])
+            colorTextures[i] = _renderTargets[i]->getTexture()->getHandle();
+    }
+    GLuint depthBuffer = 0;
+    GLuint stencilBuffer = 0;
+    if (_depthStencilTarget)
+    {
+        depthBuffer = _depthStencilTarget->_depthBuffer;
+        if (_depthStencilTarget->isPacked())
+            stencilBuffer = _depthStencilTarget->_depthBuffer;
+        else if (_depthStencilTarget->getFormat() == DepthStencilTarget::DEPTH_STENCIL)
+            stencilBuffer = _depthStencilTarget->_stencilBuffer;
+    }
+    RenderCommandList::bindFramebuffer(_handle, &colorTextures[0], _maxRenderTargets, depthBuffer, stencilBuffer);
+}
+
 FrameBuffer* FrameBuffer::getCurrent()
 {
     return _currentFrameBuffer;
@@ -4,6 +4,7 @@
 #include "Base.h"
 #include "RenderTarget.h"
 #include "DepthStencilTarget.h"
+#include "ReadbackQueue.h"
 
 namespace gameplay
 {
@@ -158,6 +159,39 @@ public:
      */
     static FrameBuffer* bindDefault(); 
 
+    /**
+     * Discards the contents of attachments of this frame buffer, which must be bound.
+     *
+     * Tile-based GPUs otherwise load the attachments into tile memory when drawing starts and
+     * store them back when it ends. Discarding the attachments after binding, when their
+     * contents are about to be overwritten, skips the load; discarding them before unbinding,
+     * when nothing reads them afterwards (typically depth and stencil), skips the store.
+     * Does nothing where GL cannot discard frame buffer contents.
+     *
+     * @param color true to discard the color attachments.
+     * @param depthStencil true to discard the depth and stencil attachments.
+     * @script{ignore}
+     */
+    void discard(bool color, bool depthStencil);
+
+    /**
+     * Reads an area of this frame buffer back to the CPU without stalling the frame.
+     *
+     * The pixels are handed to the callback from a later frame, once the GPU has copied them.
+     *
+     * @param x The left edge of the area, in pixels.
+     * @param y The bottom edge of the area, in pixels.
+     * @param width The width of the area.
+     * @param height The height of the area.
+     * @param callback The function called with the RGBA pixels.
+     * @param cookie The user data passed to the callback.
+     *
+     * @see ReadbackQueue::read
+     * @script{ignore}
+     */
+    void readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                    ReadbackQueue::ReadbackCallback callback, void* cookie);
+
     /**
      * Gets the currently bound FrameBuffer.
      *
@@ -188,6 +222,11 @@ private:
 
     static bool isPowerOfTwo(unsigned int value);
 
+    /**
+     * Binds the GL frame buffer, passing its attachments along for a render thread to rebuild it.
+     */
+    void bindHandle() const;
+
     std::string _id;
     unsigned int _width;
     unsigned int _height;
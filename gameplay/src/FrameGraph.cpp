@@ -0,0 +1,241 @@
+#include "Base.h"
+#include "FrameGraph.h"
+#include "Game.h"
+
+namespace gameplay
+{
+
+FrameGraph::FrameGraph()
+    : _culledPassCount(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    reset();
+}
+
+unsigned int FrameGraph::createTarget(unsigned int width, unsigned int height, Texture::Format format, bool depthStencil)
+{
+    GP_ASSERT(width > 0 && height > 0);
+
+    Target target;
+    target.frameBuffer = NULL;
+    target.width = width;
+    target.height = height;
+    target.format = format;
+    target.depthStencil = depthStencil;
+    target.imported = false;
+    target.lastPass = -1;
+    _targets.push_back(target);
+    return (unsigned int)_targets.size() - 1;
+}
+
+unsigned int FrameGraph::importTarget(FrameBuffer* frameBuffer)
+{
+    GP_ASSERT(frameBuffer);
+
+    frameBuffer->addRef();
+    Target target;
+    target.frameBuffer = frameBuffer;
+    target.width = frameBuffer->getWidth();
+    target.height = frameBuffer->getHeight();
+    target.format = Texture::RGBA;
+    target.depthStencil = frameBuffer->getDepthStencilTarget() != NULL;
+    target.imported = true;
+    target.lastPass = -1;
+    _targets.push_back(target);
+    return (unsigned int)_targets.size() - 1;
+}
+
+unsigned int FrameGraph::addPass(const char* name, PassFunction function, void* cookie, unsigned int output, bool preserve)
+{
+    GP_ASSERT(name);
+    GP_ASSERT(function);
+    GP_ASSERT(output < _targets.size());
+
+    _passes.push_back(Pass());
+    Pass& pass = _passes.back();
+    pass.name = name;
+    pass.function = function;
+    pass.cookie = cookie;
+    pass.output = output;
+    pass.preserve = preserve;
+    pass.culled = false;
+    return (unsigned int)_passes.size() - 1;
+}
+
+void FrameGraph::addInput(unsigned int pass, unsigned int target)
+{
+    GP_ASSERT(pass < _passes.size());
+    GP_ASSERT(target < _targets.size());
+
+    if (_passes[pass].output == target)
+    {
+        GP_WARN("Pass '%s' cannot sample the target it draws into.", _passes[pass].name);
+        return;
+    }
+    _passes[pass].inputs.push_back(target);
+}
+
+int FrameGraph::findWriter(unsigned int target, unsigned int before) const
+{
+    for (int i = (int)before - 1; i >= 0; --i)
+    {
+        if (_passes[i].output == target)
+            return i;
+    }
+    return -1;
+}
+
+void FrameGraph::compile()
+{
+    // Walk back from the passes that write imported targets, keeping the passes whose output they use.
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        _passes[i].culled = !_targets[_passes[i].output].imported;
+    }
+    for (int i = (int)_passes.size() - 1; i >= 0; --i)
+    {
+        const Pass& pass = _passes[i];
+        if (pass.culled)
+            continue;
+
+        for (size_t j = 0; j < pass.inputs.size(); ++j)
+        {
+            int writer = findWriter(pass.inputs[j], i);
+            if (writer >= 0)
+                _passes[writer].culled = false;
+            else if (!_targets[pass.inputs[j]].imported)
+                GP_WARN("Pass '%s' reads a target that no pass draws into before it.", pass.name);
+        }
+        if (pass.preserve)
+        {
+            int writer = findWriter(pass.output, i);
+            if (writer >= 0)
+                _passes[writer].culled = false;
+        }
+    }
+
+    _culledPassCount = 0;
+    for (size_t i = 0; i < _targets.size(); ++i)
+    {
+        _targets[i].lastPass = -1;
+    }
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        const Pass& pass = _passes[i];
+        if (pass.culled)
+        {
+            ++_culledPassCount;
+            continue;
+        }
+        _targets[pass.output].lastPass = (int)i;
+        for (size_t j = 0; j < pass.inputs.size(); ++j)
+        {
+            _targets[pass.inputs[j]].lastPass = (int)i;
+        }
+    }
+}
+
+void FrameGraph::execute()
+{
+    compile();
+
+    Game* game = Game::getInstance();
+    RenderTargetPool* pool = game->getRenderTargetPool();
+    FrameBuffer* previousFrameBuffer = FrameBuffer::getCurrent();
+    Rectangle previousViewport = game->getViewport();
+
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        const Pass& pass = _passes[i];
+        if (pass.culled)
+            continue;
+
+        // A transient target is acquired when its first pass runs, so that the pool can hand it the memory of targets already done with.
+        Target& output = _targets[pass.output];
+        if (output.frameBuffer == NULL)
+        {
+            output.frameBuffer = pool->acquire(output.width, output.height, output.format, output.depthStencil);
+            if (output.frameBuffer == NULL)
+            {
+                GP_ERROR("Failed to acquire the target of pass '%s'.", pass.name);
+                continue;
+            }
+        }
+        bool missingInput = false;
+        for (size_t j = 0; j < pass.inputs.size(); ++j)
+        {
+            if (_targets[pass.inputs[j]].frameBuffer == NULL)
+                missingInput = true;
+        }
+        if (missingInput)
+        {
+            GP_ERROR("Skipping pass '%s', whose inputs were not drawn.", pass.name);
+            continue;
+        }
+
+        GP_PROFILE_SCOPE(pass.name);
+        output.frameBuffer->bind();
+        if (output.imported)
+            game->setViewport(previousViewport);
+        else
+            game->setViewport(Rectangle((float)output.width, (float)output.height));
+
+        // Attachments about to be overwritten need not be loaded into tile memory.
+        if (!pass.preserve)
+            output.frameBuffer->discard(true, true);
+
+        pass.function(this, pass.cookie);
+
+        // Depth and stencil of transient targets cannot be sampled, so they never need storing.
+        if (!output.imported && output.depthStencil)
+            output.frameBuffer->discard(false, true);
+
+        // The targets whose last pass this was go back to the pool for the passes that follow.
+        for (size_t j = 0; j < _targets.size(); ++j)
+        {
+            Target& target = _targets[j];
+            if (!target.imported && target.lastPass == (int)i)
+                SAFE_RELEASE(target.frameBuffer);
+        }
+    }
+
+    previousFrameBuffer->bind();
+    game->setViewport(previousViewport);
+}
+
+void FrameGraph::reset()
+{
+    for (size_t i = 0; i < _targets.size(); ++i)
+    {
+        SAFE_RELEASE(_targets[i].frameBuffer);
+    }
+    _targets.clear();
+    _passes.clear();
+}
+
+Texture* FrameGraph::getTexture(unsigned int target) const
+{
+    GP_ASSERT(target < _targets.size());
+
+    FrameBuffer* frameBuffer = _targets[target].frameBuffer;
+    if (frameBuffer == NULL || frameBuffer->getRenderTarget() == NULL)
+        return NULL;
+    return frameBuffer->getRenderTarget()->getTexture();
+}
+
+FrameBuffer* FrameGraph::getFrameBuffer(unsigned int target) const
+{
+    GP_ASSERT(target < _targets.size());
+
+    return _targets[target].frameBuffer;
+}
+
+unsigned int FrameGraph::getCulledPassCount() const
+{
+    return _culledPassCount;
+}
+
+}
@@ -0,0 +1,209 @@
+#ifndef FRAMEGRAPH_H_
+#define FRAMEGRAPH_H_
+
+#include "FrameBuffer.h"
+#include "Rectangle.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a graph of render passes that manages the frame buffers the passes draw into.
+ *
+ * Multi-pass rendering that binds frame buffers by hand keeps every target alive for the
+ * whole frame and leaves tile-based GPUs loading and storing attachments whose contents
+ * nobody needs. A frame graph is told instead what each pass reads and writes:
+ *
+ * - Targets are either transient, created with createTarget(), or imported frame buffers
+ *   that the caller owns, such as the frame buffer current when the graph executes.
+ * - Each pass draws into one target and may read the textures of others. Passes run in
+ *   the order they were added.
+ *
+ * When the graph executes, passes whose output nothing uses are culled: a pass is kept if
+ * it writes an imported target, or if a kept pass reads what it wrote. Transient targets
+ * are acquired from the render target pool when their first kept pass runs and released
+ * after their last one, so targets that are not alive at the same time share memory. Before
+ * each pass draws, the attachments of its target are discarded unless the pass preserves
+ * what was drawn there before, so that tile memory is not loaded; after each pass, the
+ * depth and stencil attachments of transient targets are discarded, so that they are not
+ * stored. Each pass draws with the viewport set to its whole target, or to the viewport
+ * that was current when the graph executed for imported targets.
+ *
+ * A graph is typically rebuilt every frame:
+ *
+ * @verbatim
+    _graph.reset();
+    unsigned int backBuffer = _graph.importTarget(FrameBuffer::getCurrent());
+    unsigned int shadow = _graph.createTarget(1024, 1024, Texture::RGBA, true);
+    unsigned int pass = _graph.addPass("Shadow", drawShadowMap, this, shadow);
+    pass = _graph.addPass("Scene", drawScene, this, backBuffer);
+    _graph.addInput(pass, shadow);
+    _graph.execute();
+   @endverbatim
+ *
+ * A pass function calls getTexture() to find the targets it reads.
+ *
+ * @script{ignore}
+ */
+class FrameGraph
+{
+public:
+
+    /**
+     * The function that draws a pass.
+     *
+     * @param graph The graph the pass belongs to.
+     * @param cookie The cookie given to addPass().
+     */
+    typedef void (*PassFunction)(FrameGraph* graph, void* cookie);
+
+    /**
+     * Constructor.
+     */
+    FrameGraph();
+
+    /**
+     * Destructor.
+     */
+    ~FrameGraph();
+
+    /**
+     * Declares a transient target, which lives only between the passes that use it.
+     *
+     * @param width The width of the target.
+     * @param height The height of the target.
+     * @param format The format of the color attachment; RGB or RGBA.
+     * @param depthStencil true to attach a packed depth-stencil target.
+     *
+     * @return The target.
+     */
+    unsigned int createTarget(unsigned int width, unsigned int height, Texture::Format format = Texture::RGBA, bool depthStencil = false);
+
+    /**
+     * Declares a frame buffer owned by the caller as a target.
+     *
+     * The passes that write an imported target are never culled, and its attachments are
+     * only discarded before passes that overwrite it.
+     *
+     * @param frameBuffer The frame buffer.
+     *
+     * @return The target.
+     */
+    unsigned int importTarget(FrameBuffer* frameBuffer);
+
+    /**
+     * Adds a pass that draws into a target.
+     *
+     * @param name The name of the pass, used in warnings and profiles. The profiler keeps
+     *      the pointer, so this is normally a string literal.
+     * @param function The function that draws the pass.
+     * @param cookie The cookie passed to the function.
+     * @param output The target the pass draws into.
+     * @param preserve true if the pass draws over the current contents of the target,
+     *      false if it overwrites or clears every pixel of it.
+     *
+     * @return The pass.
+     */
+    unsigned int addPass(const char* name, PassFunction function, void* cookie, unsigned int output, bool preserve = false);
+
+    /**
+     * Declares that a pass samples the texture of a target.
+     *
+     * @param pass The pass.
+     * @param target The target.
+     */
+    void addInput(unsigned int pass, unsigned int target);
+
+    /**
+     * Runs the passes that contribute to the imported targets.
+     *
+     * The frame buffer and viewport that were current are current again afterwards.
+     */
+    void execute();
+
+    /**
+     * Removes all the passes and targets.
+     */
+    void reset();
+
+    /**
+     * Gets the texture of the color attachment of a target.
+     *
+     * Only valid while the graph executes, for the targets of the pass that is running.
+     *
+     * @param target The target.
+     *
+     * @return The texture, or NULL if the target has none.
+     */
+    Texture* getTexture(unsigned int target) const;
+
+    /**
+     * Gets the frame buffer of a target.
+     *
+     * Only valid while the graph executes, for the targets of the pass that is running.
+     *
+     * @param target The target.
+     *
+     * @return The frame buffer.
+     */
+    FrameBuffer* getFrameBuffer(unsigned int target) const;
+
+    /**
+     * Gets the number of passes culled by the last execution of the graph.
+     *
+     * @return The number of culled passes.
+     */
+    unsigned int getCulledPassCount() const;
+
+private:
+
+    struct Target
+    {
+        FrameBuffer* frameBuffer;
+        unsigned int width;
+        unsigned int height;
+        Texture::Format format;
+        bool depthStencil;
+        bool imported;
+        int lastPass;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        PassFunction function;
+        void* cookie;
+        unsigned int output;
+        bool preserve;
+        bool culled;
+        std::vector<unsigned int> inputs;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    FrameGraph(const FrameGraph& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    FrameGraph& operator=(const FrameGraph&);
+
+    /**
+     * Marks the passes that no imported target depends on as culled, and finds the last pass that uses each target.
+     */
+    void compile();
+
+    /**
+     * Gets the last pass before a pass that writes a target, or -1.
+     */
+    int findWriter(unsigned int target, unsigned int before) const;
+
+    std::vector<Target> _targets;
+    std::vector<Pass> _passes;
+    unsigned int _culledPassCount;
+};
+
+}
+
+#endif
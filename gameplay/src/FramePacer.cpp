@@ -0,0 +1,147 @@
+#include "Base.h"
+#include "FramePacer.h"
+#include "Game.h"
+#include "Platform.h"
+#include "Thread.h"
+
+#ifdef WIN32
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Largest number of frames the elapsed time can be averaged over.
+#define FRAME_PACER_MAX_SMOOTHING 32
+
+namespace gameplay
+{
+
+FramePacer::FramePacer()
+    : _targetFrameRate(0), _backgroundFrameRate(0), _background(false), _spinTime(2.0), _deadline(0.0),
+      _elapsedTimeIndex(0), _elapsedTimeCount(0)
+{
+    _elapsedTimes.resize(1);
+}
+
+FramePacer::~FramePacer()
+{
+}
+
+void FramePacer::initialize(Properties* properties)
+{
+    if (properties)
+    {
+        setTargetFrameRate((unsigned int)std::max(properties->getInt("targetFps"), 0));
+        setBackgroundFrameRate((unsigned int)std::max(properties->getInt("backgroundFps"), 0));
+        if (properties->exists("smoothing"))
+            setSmoothingFrames((unsigned int)std::max(properties->getInt("smoothing"), 1));
+        if (properties->exists("spinTime"))
+            _spinTime = std::max(properties->getFloat("spinTime"), 0.0f);
+    }
+
+#ifdef WIN32
+    // Sleep() rounds up to the system timer period, which is 15.6 ms by default.
+    timeBeginPeriod(1);
+#endif
+}
+
+void FramePacer::finalize()
+{
+#ifdef WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+unsigned int FramePacer::getTargetFrameRate() const
+{
+    return _targetFrameRate;
+}
+
+void FramePacer::setTargetFrameRate(unsigned int fps)
+{
+    _targetFrameRate = fps;
+}
+
+unsigned int FramePacer::getBackgroundFrameRate() const
+{
+    return _backgroundFrameRate;
+}
+
+void FramePacer::setBackgroundFrameRate(unsigned int fps)
+{
+    _backgroundFrameRate = fps;
+}
+
+bool FramePacer::isBackground() const
+{
+    return _background;
+}
+
+void FramePacer::setBackground(bool background)
+{
+    _background = background;
+}
+
+unsigned int FramePacer::getSmoothingFrames() const
+{
+    return (unsigned int)_elapsedTimes.size();
+}
+
+void FramePacer::setSmoothingFrames(unsigned int frames)
+{
+    _elapsedTimes.assign(MATH_CLAMP(frames, 1u, (unsigned int)FRAME_PACER_MAX_SMOOTHING), 0.0f);
+    _elapsedTimeIndex = 0;
+    _elapsedTimeCount = 0;
+}
+
+void FramePacer::wait()
+{
+    unsigned int fps = (_background && _backgroundFrameRate > 0) ? _backgroundFrameRate : _targetFrameRate;
+    if (fps == 0)
+    {
+        _deadline = 0.0;
+        return;
+    }
+
+    double interval = 1000.0 / fps;
+    double now = Game::getAbsoluteTime();
+    if (_deadline == 0.0 || now - _deadline > interval)
+    {
+        // Restart the schedule rather than rush frames to catch up.
+        _deadline = now + interval;
+        return;
+    }
+
+    double remaining = _deadline - now;
+    while (remaining > 0.0)
+    {
+        long sleepTime = (long)(remaining - _spinTime);
+        if (sleepTime > 0)
+            Platform::sleep(sleepTime);
+        else
+            Thread::yield();
+        remaining = _deadline - Game::getAbsoluteTime();
+    }
+
+    // The next frame is due one interval after this one was due, not after it started.
+    _deadline += interval;
+}
+
+float FramePacer::smooth(float elapsedTime)
+{
+    if (_elapsedTimes.size() == 1)
+        return elapsedTime;
+
+    _elapsedTimes[_elapsedTimeIndex] = elapsedTime;
+    _elapsedTimeIndex = (_elapsedTimeIndex + 1) % _elapsedTimes.size();
+    if (_elapsedTimeCount < _elapsedTimes.size())
+        ++_elapsedTimeCount;
+
+    float sum = 0.0f;
+    for (unsigned int i = 0; i < _elapsedTimeCount; ++i)
+    {
+        sum += _elapsedTimes[i];
+    }
+    return sum / _elapsedTimeCount;
+}
+
+}
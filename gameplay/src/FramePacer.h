@@ -0,0 +1,162 @@
+#ifndef FRAMEPACER_H_
+#define FRAMEPACER_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a frame limiter that paces the frames of the game to a target frame rate
+ * and smooths the elapsed time passed to update() and render().
+ *
+ * Before each frame, the pacer waits until the frame is due: it sleeps while the
+ * deadline is far away and yields the thread for the last part of the wait, since
+ * sleeps can overshoot by a whole timer period. Frames are scheduled one interval
+ * after the previous deadline rather than after the previous frame, so a late frame
+ * does not push back all the frames after it. When the game falls more than a frame
+ * behind, the schedule restarts from the current time instead of catching up.
+ *
+ * While the window is in the background (unfocused or minimized), frames are paced to
+ * the background frame rate instead, which saves power when nobody is watching.
+ *
+ * The elapsed time of a frame can be averaged over the last frames, which evens out
+ * the jitter of the frame times without vsync. The average lags behind real time when
+ * the frame rate changes, so the number of frames should stay small.
+ *
+ * The pacer is configured in the game config:
+ *
+ * @verbatim
+    framePacing
+    {
+        targetFps = 60          // Frame rate to limit the game to, or 0 for no limit.
+        backgroundFps = 10      // Frame rate while in the background, or 0 to use targetFps.
+        smoothing = 4           // Number of frames the elapsed time is averaged over; 1 disables smoothing.
+        spinTime = 2            // Time before a deadline in milliseconds at which waits stop sleeping.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class FramePacer
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Gets the frame rate the game is limited to while in the foreground.
+     *
+     * @return The target frame rate, or 0 if frames are not limited.
+     */
+    unsigned int getTargetFrameRate() const;
+
+    /**
+     * Sets the frame rate the game is limited to while in the foreground.
+     *
+     * @param fps The target frame rate, or 0 to not limit frames.
+     */
+    void setTargetFrameRate(unsigned int fps);
+
+    /**
+     * Gets the frame rate the game is limited to while in the background.
+     *
+     * @return The background frame rate, or 0 if the target frame rate also applies in the background.
+     */
+    unsigned int getBackgroundFrameRate() const;
+
+    /**
+     * Sets the frame rate the game is limited to while in the background.
+     *
+     * @param fps The background frame rate, or 0 to use the target frame rate in the background.
+     */
+    void setBackgroundFrameRate(unsigned int fps);
+
+    /**
+     * Determines if the window of the game is in the background.
+     *
+     * @return True if the window is unfocused or minimized.
+     */
+    bool isBackground() const;
+
+    /**
+     * Gets the number of frames the elapsed time is averaged over.
+     *
+     * @return The number of frames; 1 if the elapsed time is not smoothed.
+     */
+    unsigned int getSmoothingFrames() const;
+
+    /**
+     * Sets the number of frames the elapsed time is averaged over.
+     *
+     * @param frames The number of frames; 1 to not smooth the elapsed time.
+     */
+    void setSmoothingFrames(unsigned int frames);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    FramePacer();
+
+    /**
+     * Destructor.
+     */
+    ~FramePacer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    FramePacer(const FramePacer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    FramePacer& operator=(const FramePacer&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'framePacing' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    void finalize();
+
+    /**
+     * Called before each frame to wait until the frame is due.
+     */
+    void wait();
+
+    /**
+     * Called with the elapsed time of each frame.
+     *
+     * @param elapsedTime The elapsed time since the last frame in milliseconds.
+     *
+     * @return The elapsed time averaged over the last frames.
+     */
+    float smooth(float elapsedTime);
+
+    /**
+     * Called by the platform when the window moves to or from the background.
+     */
+    void setBackground(bool background);
+
+    unsigned int _targetFrameRate;
+    unsigned int _backgroundFrameRate;
+    bool _background;
+    double _spinTime;
+    double _deadline;
+    std::vector<float> _elapsedTimes;
+    unsigned int _elapsedTimeIndex;
+    unsigned int _elapsedTimeCount;
+};
+
+}
+
+#endif
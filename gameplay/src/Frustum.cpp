@@ -130,6 +130,83 @@ float Frustum::intersects(const Ray& ray) const
     return ray.intersects(*this);
 }
 
+unsigned int Frustum::intersects(const BoundingSphere* spheres, unsigned int count, unsigned int* visibility) const
+{
+    GP_ASSERT(count == 0 || (spheres && visibility));
+
+    const Plane* planes[6] = { &_near, &_far, &_left, &_right, &_bottom, &_top };
+    float nx[6], ny[6], nz[6], d[6];
+    for (unsigned int p = 0; p < 6; ++p)
+    {
+        nx[p] = planes[p]->getNormal().x;
+        ny[p] = planes[p]->getNormal().y;
+        nz[p] = planes[p]->getNormal().z;
+        d[p] = planes[p]->getDistance();
+    }
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(unsigned int));
+
+    // A sphere is visible unless it is entirely in the negative half-space of one of the planes.
+    unsigned int visibleCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const Vector3& center = spheres[i].center;
+        const float radius = spheres[i].radius;
+        unsigned int p = 0;
+        while (p < 6 && nx[p] * center.x + ny[p] * center.y + nz[p] * center.z + d[p] >= -radius)
+        {
+            ++p;
+        }
+        if (p == 6)
+        {
+            visibility[i >> 5] |= 1u << (i & 31);
+            ++visibleCount;
+        }
+    }
+    return visibleCount;
+}
+
+unsigned int Frustum::intersects(const BoundingBox* boxes, unsigned int count, unsigned int* visibility) const
+{
+    GP_ASSERT(count == 0 || (boxes && visibility));
+
+    const Plane* planes[6] = { &_near, &_far, &_left, &_right, &_bottom, &_top };
+    float nx[6], ny[6], nz[6], d[6];
+    for (unsigned int p = 0; p < 6; ++p)
+    {
+        nx[p] = planes[p]->getNormal().x;
+        ny[p] = planes[p]->getNormal().y;
+        nz[p] = planes[p]->getNormal().z;
+        d[p] = planes[p]->getDistance();
+    }
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(unsigned int));
+
+    // A box is visible unless its extents projected on the normal of one of the planes
+    // do not reach the plane from the negative half-space.
+    unsigned int visibleCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const Vector3& min = boxes[i].min;
+        const Vector3& max = boxes[i].max;
+        const float cx = (min.x + max.x) * 0.5f;
+        const float cy = (min.y + max.y) * 0.5f;
+        const float cz = (min.z + max.z) * 0.5f;
+        const float ex = (max.x - min.x) * 0.5f;
+        const float ey = (max.y - min.y) * 0.5f;
+        const float ez = (max.z - min.z) * 0.5f;
+        unsigned int p = 0;
+        while (p < 6 && nx[p] * cx + ny[p] * cy + nz[p] * cz + d[p] >= -(fabsf(ex * nx[p]) + fabsf(ey * ny[p]) + fabsf(ez * nz[p])))
+        {
+            ++p;
+        }
+        if (p == 6)
+        {
+            visibility[i >> 5] |= 1u << (i & 31);
+            ++visibleCount;
+        }
+    }
+    return visibleCount;
+}
+
 void Frustum::set(const Frustum& frustum)
 {
     _near = frustum._near;
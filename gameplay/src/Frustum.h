@@ -193,6 +193,32 @@ public:
      */
     float intersects(const Ray& ray) const;
 
+    /**
+     * Tests which of the specified bounding spheres intersect this frustum.
+     *
+     * @param spheres The bounding spheres to test intersection with.
+     * @param count The number of bounding spheres.
+     * @param visibility An array of (count + 31) / 32 words that receives the result: bit (i % 32)
+     *  of word (i / 32) is set if the i-th bounding sphere intersects this frustum.
+     *
+     * @return The number of bounding spheres that intersect this frustum.
+     * @script{ignore}
+     */
+    unsigned int intersects(const BoundingSphere* spheres, unsigned int count, unsigned int* visibility) const;
+
+    /**
+     * Tests which of the specified bounding boxes intersect this frustum.
+     *
+     * @param boxes The bounding boxes to test intersection with.
+     * @param count The number of bounding boxes.
+     * @param visibility An array of (count + 31) / 32 words that receives the result: bit (i % 32)
+     *  of word (i / 32) is set if the i-th bounding box intersects this frustum.
+     *
+     * @return The number of bounding boxes that intersect this frustum.
+     * @script{ignore}
+     */
+    unsigned int intersects(const BoundingBox* boxes, unsigned int count, unsigned int* visibility) const;
+
     /**
      * Sets this frustum to the specified frustum.
      *
@@ -1,10 +1,20 @@
 #include "Base.h"
 #include "Game.h"
+#include "StateCache.h"
 #include "Platform.h"
 #include "RenderState.h"
 #include "FileSystem.h"
 #include "FrameBuffer.h"
 #include "SceneLoader.h"
+#include "Bundle.h"
+#include "ResourceCache.h"
+#include "RenderStats.h"
+#include "Allocator.h"
+#include "ProgramCache.h"
+#include "StreamBuffer.h"
+#include "StartupTrace.h"
+#include "LoadProfiler.h"
+#include "DebugMarkers.h"
 
 /** @script{ignore} */
 GLenum __gl_error_code = GL_NO_ERROR;
@@ -20,15 +30,17 @@ double Game::_pausedTimeTotal = 0.0;
 
 Game::Game()
     : _initialized(false), _state(UNINITIALIZED), _pausedCount(0),
-      _frameLastFPS(0), _frameCount(0), _frameRate(0),
+      _frameLastFPS(0), _frameCount(0), _frameRate(0), _renderingEnabled(true),
+      _fixedTickRate(0), _maxFixedTicks(5), _tickAccumulator(0.0), _interpolationAlpha(1.0f),
       _clearDepth(1.0f), _clearStencil(0), _properties(NULL),
       _animationController(NULL), _audioController(NULL),
-      _physicsController(NULL), _aiController(NULL), _audioListener(NULL),
-      _timeEvents(NULL), _scriptController(NULL), _scriptListeners(NULL)
+      _physicsController(NULL), _aiController(NULL), _audioListener(NULL), _jobScheduler(NULL), _textureStreamer(NULL), _particleManager(NULL), _profiler(NULL), _benchmark(NULL), _dynamicResolution(NULL), _framePacer(NULL), _renderThread(NULL), _inputQueue(NULL), _inputRecorder(NULL), _gpuUploadQueue(NULL), _readbackQueue(NULL), _renderTargetPool(NULL), _debugRenderer(NULL), _postProcessor(NULL), _matrixPaletteTexture(NULL), _tweenManager(NULL),
+      _timeEvents(NULL), _scriptController(NULL), _scriptListeners(NULL),
+      _lazyControllers(0)
 {
     GP_ASSERT(__gameInstance == NULL);
     __gameInstance = this;
-    _timeEvents = new std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >();
+    _timeEvents = new TimerWheel();
 }
 
 Game::~Game()
@@ -70,6 +82,16 @@ bool Game::isVsync()
     return Platform::isVsync();
 }
 
+bool Game::isRenderingEnabled() const
+{
+    return _renderingEnabled;
+}
+
+void Game::setRenderingEnabled(bool enabled)
+{
+    _renderingEnabled = enabled;
+}
+
 int Game::run()
 {
     if (_state != UNINITIALIZED)
@@ -90,42 +112,156 @@ int Game::run()
     return 0;
 }
 
+static bool isLazyController(Properties* properties, const char* name)
+{
+    Properties* controller = properties ? properties->getNamespace(name, true) : NULL;
+    return controller && controller->getBool("lazy");
+}
+
 bool Game::startup()
 {
     if (_state != UNINITIALIZED)
         return false;
 
+    // Objects released on other threads are destroyed on this one.
+    Thread::setMainThread();
+
+    StartupTrace::Scope trace("Game::startup");
+
+    // Start logging asynchronously first, so that the subsystems log through the queue.
+    Logger::initializeAsync(_properties ? _properties->getNamespace("logging", true) : NULL);
+
     setViewport(Rectangle(0.0f, 0.0f, (float)_width, (float)_height));
+
+    _framePacer = new FramePacer();
+    _framePacer->initialize(_properties ? _properties->getNamespace("framePacing", true) : NULL);
+
+    // Recording starts before any GL object is made, so that the subsystems below see whether it runs.
+    _renderThread = new RenderThread();
+    _renderThread->initialize(_properties ? _properties->getNamespace("renderThread", true) : NULL);
+
+#ifdef GP_HEADLESS
+    // Nothing is drawn without a GL context, so headless games only simulate unless asked to render.
+    Properties* headless = _properties ? _properties->getNamespace("headless", true) : NULL;
+    _renderingEnabled = headless && headless->getBool("render");
+#endif
+
+    _inputQueue = new InputQueue();
+    _inputQueue->initialize(_properties ? _properties->getNamespace("input", true) : NULL);
+    _inputRecorder = new InputRecorder();
+    _inputRecorder->initialize(_properties ? _properties->getNamespace("input", true) : NULL);
+
+    _profiler = new Profiler();
+    _profiler->initialize(_properties ? _properties->getNamespace("profiler", true) : NULL);
+    LoadProfiler::initialize(_properties ? _properties->getNamespace("loadProfiler", true) : NULL);
+    DebugMarkers::initialize(_properties ? _properties->getNamespace("debug", true) : NULL);
+
+    // Benchmarks record the profiler scopes of every frame.
+    _benchmark = new Benchmark();
+    _benchmark->initialize(_properties ? _properties->getNamespace("benchmark", true) : NULL);
+    if (_benchmark->isRunning())
+        _profiler->setEnabled(true);
+
+    StateCache::invalidate();
     RenderState::initialize();
     FrameBuffer::initialize();
+    _renderTargetPool = new RenderTargetPool();
+    _renderTargetPool->initialize(_properties ? _properties->getNamespace("renderTargets", true) : NULL);
+    ProgramCache::initialize(_properties ? _properties->getNamespace("programCache", true) : NULL);
 
-    _animationController = new AnimationController();
-    _animationController->initialize();
+    // Skinned effects are built for the palette texture once it is configured, so it comes before any effect.
+    _matrixPaletteTexture = new MatrixPaletteTexture();
+    _matrixPaletteTexture->initialize(_properties ? _properties->getNamespace("skinning", true) : NULL);
 
-    _audioController = new AudioController();
-    _audioController->initialize();
+    _dynamicResolution = new DynamicResolution();
+    _dynamicResolution->initialize(_properties ? _properties->getNamespace("dynamicResolution", true) : NULL);
 
-    _physicsController = new PhysicsController();
-    _physicsController->initialize();
+    // Start the worker threads first so that subsystems can submit jobs.
+    unsigned int workerCount = Thread::getHardwareConcurrency() - 1;
+    Properties* jobs = _properties ? _properties->getNamespace("jobs", true) : NULL;
+    if (jobs && jobs->exists("workers"))
+    {
+        workerCount = (unsigned int)std::max(0, jobs->getInt("workers"));
+    }
+    _jobScheduler = new JobScheduler();
+    _jobScheduler->initialize(workerCount);
 
-    _aiController = new AIController();
-    _aiController->initialize();
+    FileSystem::initializeAsyncReads(_properties ? _properties->getNamespace("filesystem", true) : NULL);
 
-    _scriptController = new ScriptController();
-    _scriptController->initialize();
+    _gpuUploadQueue = new GpuUploadQueue();
+    _gpuUploadQueue->initialize(_properties ? _properties->getNamespace("gpuUploads", true) : NULL);
+
+    _readbackQueue = new ReadbackQueue();
+    _readbackQueue->initialize(_properties ? _properties->getNamespace("readback", true) : NULL);
+
+    _textureStreamer = new TextureStreamer();
+    Properties* textures = _properties ? _properties->getNamespace("textures", true) : NULL;
+    _textureStreamer->initialize(textures);
+    if (textures && textures->exists("premultiplyAlpha"))
+        Texture::setPremultipliedAlpha(textures->getBool("premultiplyAlpha"));
+
+    ResourceCache::initialize(_properties ? _properties->getNamespace("resources", true) : NULL);
+
+    Allocator::initialize(_properties ? _properties->getNamespace("memory", true) : NULL);
+
+    _debugRenderer = new DebugRenderer();
+    _debugRenderer->initialize(_properties ? _properties->getNamespace("debug", true) : NULL);
+
+    _postProcessor = new PostProcessor();
+    _postProcessor->initialize(_properties ? _properties->getNamespace("postProcess", true) : NULL);
+
+    // The controllers the config marks as lazy are created by the first call to their getter.
+    if (isLazyController(_properties, "animations"))
+        _lazyControllers |= LAZY_ANIMATION;
+    else
+        createAnimationController();
+
+    _tweenManager = new TweenManager();
+    _tweenManager->initialize(_properties ? _properties->getNamespace("tweens", true) : NULL);
+
+    _particleManager = new ParticleManager();
+    _particleManager->initialize(_properties ? _properties->getNamespace("particles", true) : NULL);
+
+    if (isLazyController(_properties, "audio"))
+        _lazyControllers |= LAZY_AUDIO;
+    else
+        createAudioController();
+
+    if (isLazyController(_properties, "physics"))
+        _lazyControllers |= LAZY_PHYSICS;
+    else
+        createPhysicsController();
+
+    if (isLazyController(_properties, "ai"))
+        _lazyControllers |= LAZY_AI;
+    else
+        createAIController();
+
+    if (isLazyController(_properties, "scripts"))
+        _lazyControllers |= LAZY_SCRIPT;
+    else
+        createScriptController();
 
     // Load any gamepads, ui or physical.
     loadGamepads();
 
-    // Set the script callback functions.
+    // Timed before the scripts and the game load anything, so that the first load is cold.
+    _benchmark->runLoads();
+
+    // Set the script callback functions; they need the script controller, even a lazy one.
     if (_properties)
     {
         Properties* scripts = _properties->getNamespace("scripts", true);
         if (scripts)
         {
+            StartupTrace::Scope scriptTrace("scripts");
             const char* callback;
             while ((callback = scripts->getNextProperty()) != NULL)
             {
+                // Read by createScriptController.
+                if (strcmp(callback, "gcStepSize") == 0 || strcmp(callback, "gcBudget") == 0 || strcmp(callback, "lazy") == 0)
+                    continue;
+
                 std::string url = scripts->getString();
                 std::string file;
                 std::string id;
@@ -137,13 +273,32 @@ bool Game::startup()
                 }
                 else
                 {
-                    _scriptController->loadScript(file.c_str());
-                    _scriptController->registerCallback(callback, id.c_str());
+                    ScriptController* scriptController = getScriptController();
+                    scriptController->loadScript(file.c_str());
+                    scriptController->registerCallback(callback, id.c_str());
                 }
             }
         }
     }
 
+    // Compile the effects of the precompile manifest before the first frame.
+    Properties* effects = _properties ? _properties->getNamespace("effects", true) : NULL;
+    if (effects && effects->getString("manifest"))
+    {
+        StartupTrace::Scope effectTrace("Effect::precompile");
+        if (effects->getBool("record"))
+            Effect::recordManifest(effects->getString("manifest"));
+        if (effects->getBool("precompile", true))
+            Effect::precompile(effects->getString("manifest"));
+    }
+
+    Properties* simulation = _properties ? _properties->getNamespace("simulation", true) : NULL;
+    if (simulation && simulation->exists("tickRate"))
+    {
+        setFixedTickRate((unsigned int)std::max(0, simulation->getInt("tickRate")),
+            simulation->exists("maxTicks") ? (unsigned int)std::max(1, simulation->getInt("maxTicks")) : 5);
+    }
+
     _state = RUNNING;
 
     return true;
@@ -154,10 +309,8 @@ void Game::shutdown()
     // Call user finalization.
     if (_state != UNINITIALIZED)
     {
-        GP_ASSERT(_animationController);
-        GP_ASSERT(_audioController);
-        GP_ASSERT(_physicsController);
-        GP_ASSERT(_aiController);
+        // The controllers that were never used are not created on the way out.
+        _lazyControllers = 0;
 
         Platform::signalShutdown();
 
@@ -165,16 +318,18 @@ void Game::shutdown()
         finalize();
 
 		// Shutdown scripting system first so that any objects allocated in script are released before our subsystems are released
-		_scriptController->finalizeGame();
+		if (_scriptController)
+			_scriptController->finalizeGame();
 		if (_scriptListeners)
 		{
-			for (size_t i = 0; i < _scriptListeners->size(); i++)
+			for (std::map<std::string, ScriptListener*>::iterator itr = _scriptListeners->begin(); itr != _scriptListeners->end(); ++itr)
 			{
-				SAFE_DELETE((*_scriptListeners)[i]);
+				SAFE_DELETE(itr->second);
 			}
 			SAFE_DELETE(_scriptListeners);
 		}
-		_scriptController->finalize();
+		if (_scriptController)
+			_scriptController->finalize();
 
         unsigned int gamepadCount = Gamepad::getGamepadCount();
         for (unsigned int i = 0; i < gamepadCount; i++)
@@ -183,24 +338,85 @@ void Game::shutdown()
             SAFE_DELETE(gamepad);
         }
 
-        _animationController->finalize();
-        SAFE_DELETE(_animationController);
+        if (_animationController)
+        {
+            _animationController->finalize();
+            SAFE_DELETE(_animationController);
+        }
+
+        _tweenManager->finalize();
+        SAFE_DELETE(_tweenManager);
 
-        _audioController->finalize();
-        SAFE_DELETE(_audioController);
+        _particleManager->finalize();
+        SAFE_DELETE(_particleManager);
 
-        _physicsController->finalize();
-        SAFE_DELETE(_physicsController);
-        _aiController->finalize();
-        SAFE_DELETE(_aiController);
+        if (_audioController)
+        {
+            _audioController->finalize();
+            SAFE_DELETE(_audioController);
+        }
+
+        if (_physicsController)
+        {
+            _physicsController->finalize();
+            SAFE_DELETE(_physicsController);
+        }
+        if (_aiController)
+        {
+            _aiController->finalize();
+            SAFE_DELETE(_aiController);
+        }
+
+        Bundle::finalizeAsyncLoads();
+        FileSystem::finalizeAsyncReads();
+        _gpuUploadQueue->finalize();
+        SAFE_DELETE(_gpuUploadQueue);
+        _readbackQueue->finalize();
+        SAFE_DELETE(_readbackQueue);
+        Effect::finalize();
+        Texture::finalize();
+        ResourceCache::finalize();
+        _textureStreamer->finalize();
+        SAFE_DELETE(_textureStreamer);
+        _jobScheduler->finalize();
+        SAFE_DELETE(_jobScheduler);
+        Ref::destroyDeferred();
 
         // Note: we do not clean up the script controller here
         // because users can call Game::exit() from a script.
 
         SAFE_DELETE(_audioListener);
 
+        _debugRenderer->finalize();
+        SAFE_DELETE(_debugRenderer);
+        _postProcessor->finalize();
+        SAFE_DELETE(_postProcessor);
+        _matrixPaletteTexture->finalize();
+        SAFE_DELETE(_matrixPaletteTexture);
+        _dynamicResolution->finalize();
+        SAFE_DELETE(_dynamicResolution);
+        _renderTargetPool->finalize();
+        SAFE_DELETE(_renderTargetPool);
+
         FrameBuffer::finalize();
         RenderState::finalize();
+        ProgramCache::finalize();
+        StreamBuffer::finalize();
+        _renderThread->finalize();
+        SAFE_DELETE(_renderThread);
+
+        SAFE_DELETE(_benchmark);
+        LoadProfiler::finalize();
+        _profiler->finalize();
+        SAFE_DELETE(_profiler);
+        _framePacer->finalize();
+        SAFE_DELETE(_framePacer);
+        _inputRecorder->finalize();
+        SAFE_DELETE(_inputRecorder);
+        _inputQueue->finalize();
+        SAFE_DELETE(_inputQueue);
+
+        Logger::finalizeAsync();
 
         SAFE_DELETE(_properties);
 
@@ -212,16 +428,16 @@ void Game::pause()
 {
     if (_state == RUNNING)
     {
-        GP_ASSERT(_animationController);
-        GP_ASSERT(_audioController);
-        GP_ASSERT(_physicsController);
-        GP_ASSERT(_aiController);
         _state = PAUSED;
         _pausedTimeLast = Platform::getAbsoluteTime();
-        _animationController->pause();
-        _audioController->pause();
-        _physicsController->pause();
-        _aiController->pause();
+        if (_animationController)
+            _animationController->pause();
+        if (_audioController)
+            _audioController->pause();
+        if (_physicsController)
+            _physicsController->pause();
+        if (_aiController)
+            _aiController->pause();
     }
 
     ++_pausedCount;
@@ -235,16 +451,16 @@ void Game::resume()
 
         if (_pausedCount == 0)
         {
-            GP_ASSERT(_animationController);
-            GP_ASSERT(_audioController);
-            GP_ASSERT(_physicsController);
-            GP_ASSERT(_aiController);
             _state = RUNNING;
             _pausedTimeTotal += Platform::getAbsoluteTime() - _pausedTimeLast;
-            _animationController->resume();
-            _audioController->resume();
-            _physicsController->resume();
-            _aiController->resume();
+            if (_animationController)
+                _animationController->resume();
+            if (_audioController)
+                _audioController->resume();
+            if (_physicsController)
+                _physicsController->resume();
+            if (_aiController)
+                _aiController->resume();
         }
     }
 }
@@ -277,63 +493,143 @@ void Game::exit()
 
 void Game::frame()
 {
+    // The startup trace ends with the first frame.
+    bool firstFrame = !_initialized;
+    if (firstFrame)
+        StartupTrace::begin("first frame");
+
     if (!_initialized)
     {
         // Perform lazy first time initialization
-        initialize();
-        _scriptController->initializeGame();
+        {
+            StartupTrace::Scope trace("Game::initialize");
+            initialize();
+        }
+        if (_scriptController)
+            _scriptController->initializeGame();
         _initialized = true;
 
         // Fire first game resize event
         Platform::resizeEventInternal(_width, _height);
     }
 
+    // Wait until the frame is due, outside of the profiled frame time.
+    _framePacer->wait();
+
+    _profiler->beginFrame();
+    RenderStats::nextFrame();
+    Allocator::nextFrame();
+    _benchmark->beginFrame();
+
+    // Adjust the scene resolution to the GPU time of the frames that have finished.
+    _dynamicResolution->update();
+
+    // Destroy the pooled frame buffers that have been free for too long.
+    _renderTargetPool->update();
+
+    // Start filling the matrix palette texture from its beginning.
+    _matrixPaletteTexture->nextFrame();
+
 	static double lastFrameTime = Game::getGameTime();
 	double frameTime = getGameTime();
 
     // Fire time events to scheduled TimeListeners
     fireTimeEvents(frameTime);
 
-    if (_state == Game::RUNNING)
-    {
-        GP_ASSERT(_animationController);
-        GP_ASSERT(_audioController);
-        GP_ASSERT(_physicsController);
-        GP_ASSERT(_aiController);
+    // A scheduled exit may have shut the game down.
+    if (_state == UNINITIALIZED)
+        return;
 
-        // Update Time.
-        float elapsedTime = (frameTime - lastFrameTime);
-        lastFrameTime = frameTime;
+    // Fire the callbacks of finished file reads, then finish the main thread steps of asynchronous bundle loads.
+    FileSystem::updateAsyncReads();
+    Bundle::updateAsyncLoads();
 
-        // Update the scheduled and running animations.
-        _animationController->update(elapsedTime);
+    // Destroy the objects whose last reference was released by a job or a loader thread.
+    Ref::destroyDeferred();
 
-        // Update the physics.
-        _physicsController->update(elapsedTime);
+    // Hand back the resources the loader thread has finished uploading.
+    _gpuUploadQueue->update();
 
-        // Update AI.
-        _aiController->update(elapsedTime);
+    // Hand the pixels read back from frame buffers to their callbacks once the GPU has copied them.
+    _readbackQueue->update();
 
-        // Update gamepads.
-        Gamepad::updateInternal(elapsedTime);
+    // Upgrade and evict texture mip levels based on the last frame's draws.
+    _textureStreamer->update();
 
-        // Application Update.
-        update(elapsedTime);
+    // Hand out the particle budgets of the scenes for this frame.
+    _particleManager->update();
 
-        // Update forms.
-        Form::updateInternal(elapsedTime);
+    // Retire the cached resources that are no longer referenced.
+    ResourceCache::updateAll();
 
-        // Run script update.
-        _scriptController->update(elapsedTime);
+    // Dispatch the input gathered since the last frame, then replay the recorded input of the frame;
+    // a handler, or the end of the replay, may exit the game.
+    _inputQueue->dispatch();
+    _inputRecorder->beginFrame();
+    if (_state == UNINITIALIZED)
+        return;
+
+    if (_state == Game::RUNNING)
+    {
+        // Update Time.
+        float elapsedTime = _framePacer->smooth((float)(frameTime - lastFrameTime));
+        lastFrameTime = frameTime;
+
+        // Benchmarks advance the game by a fixed timestep so that every run is the same.
+        if (_benchmark->isRunning())
+            elapsedTime = _benchmark->getTimestep();
+
+        // Replays advance the game by the recorded elapsed time of the frame.
+        elapsedTime = _inputRecorder->lockElapsedTime(elapsedTime);
+
+        if (_fixedTickRate > 0)
+        {
+            // Run as many fixed ticks as needed to catch up with the elapsed time.
+            float tick = 1000.0f / _fixedTickRate;
+            _tickAccumulator = std::min(_tickAccumulator + elapsedTime, (double)(tick * _maxFixedTicks));
+            while (_tickAccumulator >= tick)
+            {
+                Transform::storeInterpolationStates();
+                updateSimulation(tick);
+                _tickAccumulator -= tick;
+            }
+            _interpolationAlpha = (float)(_tickAccumulator / tick);
+        }
+        else
+        {
+            updateSimulation(elapsedTime);
+        }
+
+        // Step the physics world on a worker thread while the frame renders (if enabled).
+        if (_physicsController)
+            _physicsController->beginAsyncStep();
 
         // Audio Rendering.
-        _audioController->update(elapsedTime);
+        if (_audioController)
+            _audioController->update(elapsedTime);
 
-        // Graphics Rendering.
-        render(elapsedTime);
+        // Move the benchmark camera after the game has updated its own.
+        _benchmark->updateCamera();
 
-        // Run script render.
-        _scriptController->render(elapsedTime);
+        // Graphics Rendering, with the interpolated transforms between the last two ticks.
+        if (_renderingEnabled)
+        {
+            if (_fixedTickRate > 0)
+                Transform::beginInterpolation(_interpolationAlpha);
+            _debugRenderer->beginOverdraw();
+            {
+                GP_PROFILE_SCOPE("Game::render");
+                GP_PROFILE_GPU_SCOPE("Game::render");
+                render(elapsedTime);
+            }
+
+            // Run script render.
+            if (_scriptController)
+                _scriptController->render(elapsedTime);
+            _debugRenderer->endOverdraw();
+            if (_fixedTickRate > 0)
+                Transform::endInterpolation();
+        }
 
         // Update FPS.
         ++_frameCount;
@@ -349,6 +645,9 @@ void Game::frame()
         // Update gamepads.
         Gamepad::updateInternal(0);
 
+        // Notify the transform listeners.
+        Transform::notifyTransformsChanged();
+
         // Application Update.
         update(0);
 
@@ -356,29 +655,97 @@ void Game::frame()
         Form::updateInternal(0);
 
         // Script update.
-        _scriptController->update(0);
+        if (_scriptController)
+            _scriptController->update(0);
 
         // Graphics Rendering.
-        render(0);
+        if (_renderingEnabled)
+        {
+            _debugRenderer->beginOverdraw();
+            render(0);
+
+            // Script render.
+            if (_scriptController)
+                _scriptController->render(0);
+            _debugRenderer->endOverdraw();
+        }
+    }
+
+    // Collect script garbage at the same point of every frame.
+    if (_scriptController)
+        _scriptController->collectGarbage();
+
+    // Drop the debug primitives that the frame did not flush.
+    _debugRenderer->discard();
+
+    // Write the input and the elapsed time of the frame to the recording.
+    _inputRecorder->endFrame();
+
+    // Hand the recorded frame to the render thread, which presents it.
+    _renderThread->submitFrame();
+
+    _profiler->endFrame();
+
+    if (firstFrame)
+    {
+        Properties* startup = _properties ? _properties->getNamespace("startup", true) : NULL;
+        StartupTrace::finish(startup ? startup->getString("trace") : NULL);
+    }
+}
+
+void Game::updateSimulation(float elapsedTime)
+{
+    // Update the scheduled and running animations.
+    if (_animationController)
+        _animationController->update(elapsedTime);
+
+    // Update the tweens, after the clips so that a tween wins over a clip animating the same property.
+    _tweenManager->update(elapsedTime);
+
+    // Notify the transform listeners of everything that moved since the last tick, before physics reads it.
+    Transform::notifyTransformsChanged();
+
+    // Update the physics.
+    if (_physicsController)
+        _physicsController->update(elapsedTime);
+
+    // Update AI.
+    if (_aiController)
+        _aiController->update(elapsedTime);
 
-        // Script render.
-        _scriptController->render(0);
+    // Update gamepads.
+    Gamepad::updateInternal(elapsedTime);
+
+    // Application Update.
+    {
+        GP_PROFILE_SCOPE("Game::update");
+        update(elapsedTime);
     }
+
+    // Update forms.
+    Form::updateInternal(elapsedTime);
+
+    // Run script update.
+    if (_scriptController)
+        _scriptController->update(elapsedTime);
+}
+
+void Game::setFixedTickRate(unsigned int ticksPerSecond, unsigned int maxTicks)
+{
+    _fixedTickRate = ticksPerSecond;
+    _maxFixedTicks = std::max(maxTicks, 1u);
+    _tickAccumulator = 0.0;
+    _interpolationAlpha = 1.0f;
 }
 
 void Game::renderOnce(const char* function)
 {
-    _scriptController->executeFunction<void>(function, NULL);
+    getScriptController()->executeFunction<void>(function, NULL);
     Platform::swapBuffers();
 }
 
 void Game::updateOnce()
 {
-    GP_ASSERT(_animationController);
-    GP_ASSERT(_audioController);
-    GP_ASSERT(_physicsController);
-    GP_ASSERT(_aiController);
-
     // Update Time.
     static double lastFrameTime = getGameTime();
     double frameTime = getGameTime();
@@ -386,17 +753,23 @@ void Game::updateOnce()
     lastFrameTime = frameTime;
 
     // Update the internal controllers.
-    _animationController->update(elapsedTime);
-    _physicsController->update(elapsedTime);
-    _aiController->update(elapsedTime);
-    _audioController->update(elapsedTime);
-    _scriptController->update(elapsedTime);
+    if (_animationController)
+        _animationController->update(elapsedTime);
+    _tweenManager->update(elapsedTime);
+    if (_physicsController)
+        _physicsController->update(elapsedTime);
+    if (_aiController)
+        _aiController->update(elapsedTime);
+    if (_audioController)
+        _audioController->update(elapsedTime);
+    if (_scriptController)
+        _scriptController->update(elapsedTime);
 }
 
 void Game::setViewport(const Rectangle& viewport)
 {
     _viewport = viewport;
-    glViewport((GLuint)viewport.x, (GLuint)viewport.y, (GLuint)viewport.width, (GLuint)viewport.height);
+    StateCache::setViewport((GLint)viewport.x, (GLint)viewport.y, (GLsizei)viewport.width, (GLsizei)viewport.height);
 }
 
 void Game::clear(ClearFlags flags, const Vector4& clearColor, float clearDepth, int clearStencil)
@@ -409,7 +782,7 @@ void Game::clear(ClearFlags flags, const Vector4& clearColor, float clearDepth,
             clearColor.z != _clearColor.z ||
             clearColor.w != _clearColor.w )
         {
-            glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
+            RenderCommandList::clearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
             _clearColor.set(clearColor);
         }
         bits |= GL_COLOR_BUFFER_BIT;
@@ -419,7 +792,7 @@ void Game::clear(ClearFlags flags, const Vector4& clearColor, float clearDepth,
     {
         if (clearDepth != _clearDepth)
         {
-            glClearDepth(clearDepth);
+            RenderCommandList::clearDepth(clearDepth);
             _clearDepth = clearDepth;
         }
         bits |= GL_DEPTH_BUFFER_BIT;
@@ -434,12 +807,12 @@ void Game::clear(ClearFlags flags, const Vector4& clearColor, float clearDepth,
     {
         if (clearStencil != _clearStencil)
         {
-            glClearStencil(clearStencil);
+            RenderCommandList::clearStencil(clearStencil);
             _clearStencil = clearStencil;
         }
         bits |= GL_STENCIL_BUFFER_BIT;
     }
-    glClear(bits);
+    RenderCommandList::clear(bits);
 }
 
 void Game::clear(ClearFlags flags, float red, float green, float blue, float alpha, float clearDepth, int clearStencil)
@@ -518,38 +891,35 @@ void Game::getArguments(int* argc, char*** argv) const
     Platform::getArguments(argc, argv);
 }
 
-void Game::schedule(float timeOffset, TimeListener* timeListener, void* cookie)
+unsigned int Game::schedule(float timeOffset, TimeListener* timeListener, void* cookie)
 {
     GP_ASSERT(_timeEvents);
-    TimeEvent timeEvent(getGameTime() + timeOffset, timeListener, cookie);
-    _timeEvents->push(timeEvent);
+    return _timeEvents->add(getGameTime() + timeOffset, timeListener, cookie);
 }
 
-void Game::schedule(float timeOffset, const char* function)
+unsigned int Game::schedule(float timeOffset, const char* function)
 {
+    GP_ASSERT(function);
+
     if (!_scriptListeners)
-        _scriptListeners = new std::vector<ScriptListener*>();
+        _scriptListeners = new std::map<std::string, ScriptListener*>();
+
+    // Listeners are shared by all the events that call the same function.
+    ScriptListener*& listener = (*_scriptListeners)[function];
+    if (listener == NULL)
+        listener = new ScriptListener(function);
+    return schedule(timeOffset, listener, NULL);
+}
 
-    ScriptListener* listener = new ScriptListener(function);
-    _scriptListeners->push_back(listener);
-    schedule(timeOffset, listener, NULL);
+bool Game::unschedule(unsigned int handle)
+{
+    GP_ASSERT(_timeEvents);
+    return _timeEvents->remove(handle);
 }
 
 void Game::fireTimeEvents(double frameTime)
 {
-    while (_timeEvents->size() > 0)
-    {
-        const TimeEvent* timeEvent = &_timeEvents->top();
-        if (timeEvent->time > frameTime)
-        {
-            break;
-        }
-        if (timeEvent->listener)
-        {
-            timeEvent->listener->timeEvent(frameTime - timeEvent->time, timeEvent->cookie);
-        }
-        _timeEvents->pop();
-    }
+    _timeEvents->advance(frameTime);
 }
 
 Game::ScriptListener::ScriptListener(const char* url)
@@ -562,17 +932,6 @@ void Game::ScriptListener::timeEvent(long timeDiff, void* cookie)
     Game::getInstance()->getScriptController()->executeFunction<void>(function.c_str(), "l", timeDiff);
 }
 
-Game::TimeEvent::TimeEvent(double time, TimeListener* timeListener, void* cookie)
-    : time(time), listener(timeListener), cookie(cookie)
-{
-}
-
-bool Game::TimeEvent::operator<(const TimeEvent& v) const
-{
-    // The first element of std::priority_queue is the greatest.
-    return time > v.time;
-}
-
 Properties* Game::getConfig() const
 {
     if (_properties == NULL)
@@ -585,6 +944,8 @@ void Game::loadConfig()
 {
     if (_properties == NULL)
     {
+        StartupTrace::Scope trace("Game::loadConfig");
+
         // Try to load custom config from file.
         if (FileSystem::fileExists("game.config"))
         {
@@ -596,6 +957,13 @@ void Game::loadConfig()
             {
                 FileSystem::loadResourceAliases(aliases);
             }
+
+            // Mount resource archives.
+            Properties* archives = _properties->getNamespace("archives", true);
+            if (archives)
+            {
+                FileSystem::mountArchives(archives);
+            }
         }
         else
         {
@@ -635,6 +1003,64 @@ void Game::loadGamepads()
     }
 }
 
+void Game::createAnimationController()
+{
+    StartupTrace::Scope trace("AnimationController::initialize");
+    _lazyControllers &= ~LAZY_ANIMATION;
+    _animationController = new AnimationController();
+    _animationController->initialize(_properties ? _properties->getNamespace("animations", true) : NULL);
+    if (_state == PAUSED)
+        _animationController->pause();
+}
+
+void Game::createAudioController()
+{
+    StartupTrace::Scope trace("AudioController::initialize");
+    _lazyControllers &= ~LAZY_AUDIO;
+    _audioController = new AudioController();
+    _audioController->initialize(_properties ? _properties->getNamespace("audio", true) : NULL);
+    if (_state == PAUSED)
+        _audioController->pause();
+}
+
+void Game::createPhysicsController()
+{
+    StartupTrace::Scope trace("PhysicsController::initialize");
+    _lazyControllers &= ~LAZY_PHYSICS;
+    _physicsController = new PhysicsController();
+    _physicsController->initialize(_properties ? _properties->getNamespace("physics", true) : NULL);
+    if (_state == PAUSED)
+        _physicsController->pause();
+}
+
+void Game::createAIController()
+{
+    StartupTrace::Scope trace("AIController::initialize");
+    _lazyControllers &= ~LAZY_AI;
+    _aiController = new AIController();
+    _aiController->initialize(_properties ? _properties->getNamespace("ai", true) : NULL);
+    if (_state == PAUSED)
+        _aiController->pause();
+}
+
+void Game::createScriptController()
+{
+    StartupTrace::Scope trace("ScriptController::initialize");
+    _lazyControllers &= ~LAZY_SCRIPT;
+    _scriptController = new ScriptController();
+    _scriptController->initialize();
+
+    Properties* scripts = _properties ? _properties->getNamespace("scripts", true) : NULL;
+    if (scripts && scripts->exists("gcStepSize"))
+        _scriptController->setGarbageCollectionStep((unsigned int)std::max(0, scripts->getInt("gcStepSize")));
+    if (scripts && scripts->exists("gcBudget"))
+        _scriptController->setGarbageCollectionBudget(scripts->getFloat("gcBudget"));
+
+    // A controller created after the first frame starts the game's scripts at once.
+    if (_initialized)
+        _scriptController->initializeGame();
+}
+
 void Game::ShutdownListener::timeEvent(long timeDiff, void* cookie)
 {
 	Game::getInstance()->shutdown();
@@ -14,6 +14,24 @@
 #include "Rectangle.h"
 #include "Vector4.h"
 #include "TimeListener.h"
+#include "TimerWheel.h"
+#include "JobScheduler.h"
+#include "ParticleManager.h"
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "RenderThread.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+#include "GpuUploadQueue.h"
+#include "ReadbackQueue.h"
+#include "RenderTargetPool.h"
+#include "DebugRenderer.h"
+#include "PostProcessor.h"
+#include "MatrixPaletteTexture.h"
+#include "TweenManager.h"
 
 namespace gameplay
 {
@@ -80,6 +98,27 @@ public:
      */
     static void setVsync(bool enable);
 
+    /**
+     * Gets whether the frames of the game render.
+     *
+     * @return true if frames call render(), false if they only update the game.
+     * @script{ignore}
+     */
+    bool isRenderingEnabled() const;
+
+    /**
+     * Sets whether the frames of the game render.
+     *
+     * Frames that do not render only update the game, which saves the cost of drawing
+     * when nobody watches, e.g. for a dedicated server or a bot. Headless builds
+     * (GP_HEADLESS) do not render unless the render property of the headless namespace
+     * of the game config is true (see Platform).
+     *
+     * @param enabled true to call render() each frame, false to skip it.
+     * @script{ignore}
+     */
+    void setRenderingEnabled(bool enabled);
+
     /**
      * Gets the total absolute running time (in milliseconds) since Game::run().
      * 
@@ -158,6 +197,46 @@ public:
      */
     inline unsigned int getFrameRate() const;
 
+    /**
+     * Sets the rate of the fixed simulation ticks.
+     *
+     * With a fixed tick rate, the animation, physics, AI and update() calls of a frame
+     * run zero or more times with an elapsed time of exactly one tick, as needed to
+     * catch up with the real time. render() is then called once, and transforms that
+     * have interpolation enabled are drawn between their last two ticks, according to
+     * getInterpolationAlpha(). At most maxTicks ticks run per frame; the time that
+     * cannot be caught up is dropped to keep slow frames from spiraling.
+     *
+     * The tick rate can also be set in the game config:
+     *
+     * @verbatim
+        simulation
+        {
+            tickRate = 60
+            maxTicks = 5
+        }
+       @endverbatim
+     *
+     * @param ticksPerSecond The number of ticks per second, or 0 to update once per frame
+     *      with the variable frame time (the default).
+     * @param maxTicks The maximum number of ticks run in one frame.
+     */
+    void setFixedTickRate(unsigned int ticksPerSecond, unsigned int maxTicks = 5);
+
+    /**
+     * Gets the rate of the fixed simulation ticks.
+     *
+     * @return The number of ticks per second, or 0 if the game updates once per frame.
+     */
+    inline unsigned int getFixedTickRate() const;
+
+    /**
+     * Gets how far the current frame is between the last two simulation ticks.
+     *
+     * @return A value in [0, 1) when a fixed tick rate is set; 1 otherwise.
+     */
+    inline float getInterpolationAlpha() const;
+
     /**
      * Gets the game window width.
      * 
@@ -222,6 +301,20 @@ public:
      * Gets the audio controller for managing control of audio
      * associated with the game.
      *
+     * The controllers are created at startup, unless the game config defers them to their
+     * first use. This saves their startup cost (such as opening the audio device, creating
+     * the physics world or the Lua state) in games that do not use them:
+     *
+     * @verbatim
+        audio
+        {
+            lazy = true
+        }
+       @endverbatim
+     *
+     * The same applies to the animations, physics, ai and scripts namespaces. A deferred
+     * controller is created by the first call to its getter.
+     *
      * @return The audio controller for this game.
      */
     inline AudioController* getAudioController() const;
@@ -230,6 +323,8 @@ public:
      * Gets the animation controller for managing control of animations
      * associated with the game.
      * 
+     * The controller may be created by this call (see getAudioController).
+     *
      * @return The animation controller for this game.
      */
     inline AnimationController* getAnimationController() const;
@@ -238,6 +333,8 @@ public:
      * Gets the physics controller for managing control of physics
      * associated with the game.
      * 
+     * The controller may be created by this call (see getAudioController).
+     *
      * @return The physics controller for this game.
      */
     inline PhysicsController* getPhysicsController() const;
@@ -246,6 +343,8 @@ public:
      * Gets the AI controller for managing control of artificial
      * intelligence associated with the game.
      *
+     * The controller may be created by this call (see getAudioController).
+     *
      * @return The AI controller for this game.
      */
     inline AIController* getAIController() const;
@@ -254,10 +353,148 @@ public:
      * Gets the script controller for managing control of Lua scripts
      * associated with the game.
      * 
+     * The controller may be created by this call (see getAudioController).
+     *
      * @return The script controller for this game.
      */
     inline ScriptController* getScriptController() const;
 
+    /**
+     * Gets the job scheduler for submitting work to the engine's worker threads.
+     *
+     * @return The job scheduler.
+     * @script{ignore}
+     */
+    inline JobScheduler* getJobScheduler() const;
+
+    /**
+     * Gets the texture streamer that manages the resident mip levels of file textures.
+     *
+     * @return The texture streamer.
+     * @script{ignore}
+     */
+    inline TextureStreamer* getTextureStreamer() const;
+
+    /**
+     * Gets the particle manager that pools the particle memory of emitters and limits their particle counts.
+     *
+     * @return The particle manager.
+     * @script{ignore}
+     */
+    inline ParticleManager* getParticleManager() const;
+
+    /**
+     * Gets the frame profiler that records the CPU and GPU scopes of each frame.
+     *
+     * @return The profiler.
+     * @script{ignore}
+     */
+    inline Profiler* getProfiler() const;
+
+    /**
+     * Gets the benchmark that drives the game when it runs in benchmark mode.
+     *
+     * @return The benchmark.
+     * @script{ignore}
+     */
+    inline Benchmark* getBenchmark() const;
+
+    /**
+     * Gets the dynamic resolution mode that scales the resolution of the scene to the GPU time of each frame.
+     *
+     * @return The dynamic resolution mode.
+     * @script{ignore}
+     */
+    inline DynamicResolution* getDynamicResolution() const;
+
+    /**
+     * Gets the frame pacer that limits the frame rate and smooths the elapsed time of each frame.
+     *
+     * @return The frame pacer.
+     * @script{ignore}
+     */
+    inline FramePacer* getFramePacer() const;
+
+    /**
+     * Gets the render thread that replays the GL calls of each frame, if enabled in the game config.
+     *
+     * @return The render thread.
+     * @script{ignore}
+     */
+    inline RenderThread* getRenderThread() const;
+
+    /**
+     * Gets the queue that gathers the input events and dispatches them once per frame.
+     *
+     * @return The input queue.
+     * @script{ignore}
+     */
+    inline InputQueue* getInputQueue() const;
+
+    /**
+     * Gets the recorder that records the input of the game and replays it.
+     *
+     * @return The input recorder.
+     * @script{ignore}
+     */
+    inline InputRecorder* getInputRecorder() const;
+
+    /**
+     * Gets the renderer that batches the debug lines, shapes and text of the frame.
+     *
+     * @return The debug renderer.
+     * @script{ignore}
+     */
+    inline DebugRenderer* getDebugRenderer() const;
+
+    /**
+     * Gets the post-processing stack that applies bloom, tone mapping, FXAA and color grading to the scene.
+     *
+     * @return The post processor.
+     * @script{ignore}
+     */
+    inline PostProcessor* getPostProcessor() const;
+
+    /**
+     * Gets the texture that holds the matrix palettes of the skins drawn in the frame.
+     *
+     * @return The matrix palette texture.
+     * @script{ignore}
+     */
+    inline MatrixPaletteTexture* getMatrixPaletteTexture() const;
+
+    /**
+     * Gets the manager of the tweens of control and node properties.
+     *
+     * @return The tween manager.
+     * @script{ignore}
+     */
+    inline TweenManager* getTweenManager() const;
+
+    /**
+     * Gets the queue that uploads textures and buffers to the GPU on a loader thread.
+     *
+     * @return The GPU upload queue.
+     * @script{ignore}
+     */
+    inline GpuUploadQueue* getGpuUploadQueue() const;
+
+    /**
+     * Gets the queue that reads the pixels of frame buffers back to the CPU.
+     *
+     * @return The readback queue.
+     * @script{ignore}
+     */
+    inline ReadbackQueue* getReadbackQueue() const;
+
+    /**
+     * Gets the pool that recycles transient frame buffers.
+     *
+     * @return The render target pool.
+     * @script{ignore}
+     */
+    inline RenderTargetPool* getRenderTargetPool() const;
+
     /**
      * Gets the audio listener for 3D audio.
      * 
@@ -557,9 +794,11 @@ public:
      * @param timeOffset The number of game milliseconds in the future to schedule the event to be fired.
      * @param timeListener The TimeListener that will receive the event.
      * @param cookie The cookie data that the time event will contain.
+     *
+     * @return The handle of the time event, which can be passed to unschedule().
      * @script{ignore}
      */
-    void schedule(float timeOffset, TimeListener* timeListener, void* cookie = 0);
+    unsigned int schedule(float timeOffset, TimeListener* timeListener, void* cookie = 0);
 
     /**
      * Schedules a time event to be sent to the given TimeListener a given number of game milliseconds from now.
@@ -568,10 +807,24 @@ public:
      * Note: the given Lua function must take a single floating point number, which is the difference between the
      * current game time and the target time (see TimeListener::timeEvent).
      * 
+     * Behaviors that chain many timed steps are better written as coroutines that call wait()
+     * (see ScriptController), which do not look up a function by name for every step.
+     * 
      * @param timeOffset The number of game milliseconds in the future to schedule the event to be fired.
      * @param function The Lua script function that will receive the event.
+     *
+     * @return The handle of the time event, which can be passed to unschedule().
+     */
+    unsigned int schedule(float timeOffset, const char* function);
+
+    /**
+     * Cancels a scheduled time event.
+     *
+     * @param handle The handle returned by schedule().
+     *
+     * @return true if the time event was cancelled, false if it has already been fired or cancelled.
      */
-    void schedule(float timeOffset, const char* function);
+    bool unschedule(unsigned int handle);
 
     /**
      * Opens an URL in an external browser, if available.
@@ -646,6 +899,18 @@ protected:
 
 private:
 
+    /**
+     * The controllers that the game config can defer to their first use.
+     */
+    enum LazyController
+    {
+        LAZY_ANIMATION = 1,
+        LAZY_AUDIO = 2,
+        LAZY_PHYSICS = 4,
+        LAZY_AI = 8,
+        LAZY_SCRIPT = 16
+    };
+
     /**
      * Allows time listener interaction from Lua scripts.
      */
@@ -670,20 +935,6 @@ private:
 		void timeEvent(long timeDiff, void* cookie);
 	};
 
-    /**
-     * TimeEvent represents the event that is sent to TimeListeners as a result of calling Game::schedule().
-     */
-    class TimeEvent
-    {
-    public:
-
-        TimeEvent(double time, TimeListener* timeListener, void* cookie);
-        bool operator<(const TimeEvent& v) const;
-        double time;
-        TimeListener* listener;
-        void* cookie;
-    };
-
     /**
      * Constructor.
      *
@@ -708,6 +959,13 @@ private:
      */
     void fireTimeEvents(double frameTime);
 
+    /**
+     * Advances the controllers and calls update() with the specified elapsed time.
+     *
+     * @param elapsedTime The elapsed time in milliseconds.
+     */
+    void updateSimulation(float elapsedTime);
+
     /**
      * Loads the game configuration.
      */
@@ -718,6 +976,31 @@ private:
      */
     void loadGamepads();
 
+    /**
+     * Creates and initializes the animation controller.
+     */
+    void createAnimationController();
+
+    /**
+     * Creates and initializes the audio controller.
+     */
+    void createAudioController();
+
+    /**
+     * Creates and initializes the physics controller.
+     */
+    void createPhysicsController();
+
+    /**
+     * Creates and initializes the AI controller.
+     */
+    void createAIController();
+
+    /**
+     * Creates and initializes the script controller.
+     */
+    void createScriptController();
+
     bool _initialized;                          // If game has initialized yet.
     State _state;                               // The game state.
     unsigned int _pausedCount;                  // Number of times pause() has been called.
@@ -726,6 +1009,11 @@ private:
     double _frameLastFPS;                       // The last time the frame count was updated.
     unsigned int _frameCount;                   // The current frame count.
     unsigned int _frameRate;                    // The current frame rate.
+    bool _renderingEnabled;                     // If frames call render().
+    unsigned int _fixedTickRate;                // The number of fixed simulation ticks per second, or 0.
+    unsigned int _maxFixedTicks;                // The maximum number of simulation ticks per frame.
+    double _tickAccumulator;                    // The real time not simulated yet, in milliseconds.
+    float _interpolationAlpha;                  // The position of the frame between the last two ticks.
     unsigned int _width;                        // The game's display width.
     unsigned int _height;                       // The game's display height.
     Rectangle _viewport;                        // the games's current viewport.
@@ -738,9 +1026,27 @@ private:
     PhysicsController* _physicsController;      // Controls the simulation of a physics scene and entities.
     AIController* _aiController;                // Controls AI simulation.
     AudioListener* _audioListener;              // The audio listener in 3D space.
-    std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >* _timeEvents;     // Contains the scheduled time events.
-    ScriptController* _scriptController;            // Controls the scripting engine.
-    std::vector<ScriptListener*>* _scriptListeners; // Lua script listeners.
+    JobScheduler* _jobScheduler;                // Schedules jobs on the worker threads.
+    TextureStreamer* _textureStreamer;          // Streams the mip levels of file textures.
+    ParticleManager* _particleManager;          // Pools particle memory and hands out particle budgets.
+    Profiler* _profiler;                        // Records the CPU and GPU scopes of each frame.
+    Benchmark* _benchmark;                      // Runs the game for a fixed number of frames and reports timings.
+    DynamicResolution* _dynamicResolution;      // Scales the resolution of the scene to the GPU time of each frame.
+    FramePacer* _framePacer;                    // Limits the frame rate and smooths the elapsed time.
+    RenderThread* _renderThread;                // Replays the recorded GL calls of each frame on a thread of its own.
+    InputQueue* _inputQueue;                    // Gathers the input events and dispatches them once per frame.
+    InputRecorder* _inputRecorder;              // Records the input and frame times, or replays a recording.
+    GpuUploadQueue* _gpuUploadQueue;            // Uploads resources on a loader thread with a shared GL context.
+    ReadbackQueue* _readbackQueue;              // Reads frame buffers back to the CPU through pixel buffers.
+    RenderTargetPool* _renderTargetPool;        // Recycles transient frame buffers across passes and frames.
+    DebugRenderer* _debugRenderer;              // Batches the debug primitives of the frame.
+    PostProcessor* _postProcessor;              // Applies the post-processing effects to the scene.
+    MatrixPaletteTexture* _matrixPaletteTexture; // Holds the matrix palettes of the skins drawn in the frame.
+    TweenManager* _tweenManager;                // Runs the tweens of control and node properties.
+    TimerWheel* _timeEvents;                    // Contains the scheduled time events.
+    ScriptController* _scriptController;        // Controls the scripting engine.
+    std::map<std::string, ScriptListener*>* _scriptListeners; // Lua script listeners, by function URL.
+    unsigned int _lazyControllers;              // The deferred controllers not created yet (LazyController bits).
 
     // Note: Do not add STL object member variables on the stack; this will cause false memory leaks to be reported.
 
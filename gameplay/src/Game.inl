@@ -19,6 +19,16 @@ inline unsigned int Game::getFrameRate() const
     return _frameRate;
 }
 
+inline unsigned int Game::getFixedTickRate() const
+{
+    return _fixedTickRate;
+}
+
+inline float Game::getInterpolationAlpha() const
+{
+    return _interpolationAlpha;
+}
+
 inline unsigned int Game::getWidth() const
 {
     return _width;
@@ -41,25 +51,120 @@ inline const Rectangle& Game::getViewport() const
 
 inline AnimationController* Game::getAnimationController() const
 {
+    if (_lazyControllers & LAZY_ANIMATION)
+        const_cast<Game*>(this)->createAnimationController();
     return _animationController;
 }
 
 inline AudioController* Game::getAudioController() const
 {
+    if (_lazyControllers & LAZY_AUDIO)
+        const_cast<Game*>(this)->createAudioController();
     return _audioController;
 }
 
 inline PhysicsController* Game::getPhysicsController() const
 {
+    if (_lazyControllers & LAZY_PHYSICS)
+        const_cast<Game*>(this)->createPhysicsController();
     return _physicsController;
 }
 
 inline ScriptController* Game::getScriptController() const
 {
+    if (_lazyControllers & LAZY_SCRIPT)
+        const_cast<Game*>(this)->createScriptController();
     return _scriptController;
 }
+
+inline JobScheduler* Game::getJobScheduler() const
+{
+    return _jobScheduler;
+}
+
+inline ParticleManager* Game::getParticleManager() const
+{
+    return _particleManager;
+}
+
+inline TextureStreamer* Game::getTextureStreamer() const
+{
+    return _textureStreamer;
+}
+
+inline Profiler* Game::getProfiler() const
+{
+    return _profiler;
+}
+
+inline Benchmark* Game::getBenchmark() const
+{
+    return _benchmark;
+}
+
+inline DynamicResolution* Game::getDynamicResolution() const
+{
+    return _dynamicResolution;
+}
+
+inline FramePacer* Game::getFramePacer() const
+{
+    return _framePacer;
+}
+
+inline RenderThread* Game::getRenderThread() const
+{
+    return _renderThread;
+}
+
+inline InputQueue* Game::getInputQueue() const
+{
+    return _inputQueue;
+}
+
+inline InputRecorder* Game::getInputRecorder() const
+{
+    return _inputRecorder;
+}
+
+inline DebugRenderer* Game::getDebugRenderer() const
+{
+    return _debugRenderer;
+}
+
+inline PostProcessor* Game::getPostProcessor() const
+{
+    return _postProcessor;
+}
+
+inline MatrixPaletteTexture* Game::getMatrixPaletteTexture() const
+{
+    return _matrixPaletteTexture;
+}
+
+inline TweenManager* Game::getTweenManager() const
+{
+    return _tweenManager;
+}
+
+inline GpuUploadQueue* Game::getGpuUploadQueue() const
+{
+    return _gpuUploadQueue;
+}
+
+inline ReadbackQueue* Game::getReadbackQueue() const
+{
+    return _readbackQueue;
+}
+
+inline RenderTargetPool* Game::getRenderTargetPool() const
+{
+    return _renderTargetPool;
+}
 inline AIController* Game::getAIController() const
 {
+    if (_lazyControllers & LAZY_AI)
+        const_cast<Game*>(this)->createAIController();
     return _aiController;
 }
 
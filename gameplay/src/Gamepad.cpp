@@ -13,7 +13,7 @@ static std::vector<Gamepad*> __gamepads;
 
 Gamepad::Gamepad(const char* formPath)
     : _handle((GamepadHandle)INT_MAX), _buttonCount(0), _joystickCount(0), _triggerCount(0), _vendorId(0), _productId(0),
-      _form(NULL), _buttons(0)
+      _form(NULL), _buttons(0), _eventTime(0.0)
 {
     GP_ASSERT(formPath);
     _form = Form::create(formPath);
@@ -40,7 +40,7 @@ Gamepad::Gamepad(const char* formPath)
 Gamepad::Gamepad(GamepadHandle handle, unsigned int buttonCount, unsigned int joystickCount, unsigned int triggerCount,
                  unsigned int vendorId, unsigned int productId, const char* vendorString, const char* productString)
     : _handle(handle), _buttonCount(buttonCount), _joystickCount(joystickCount), _triggerCount(triggerCount),
-      _vendorId(vendorId), _productId(productId), _form(NULL), _buttons(0)
+      _vendorId(vendorId), _productId(productId), _form(NULL), _buttons(0), _eventTime(0.0)
 {
     if (vendorString)
     {
@@ -274,7 +274,9 @@ const char* Gamepad::getProductString() const
 
 void Gamepad::update(float elapsedTime)
 {
-    if (!_form)
+    // While a recording is replayed, the state of the physical gamepads comes from the recording.
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (!_form && !(inputRecorder && inputRecorder->isReplaying()))
     {
         Platform::pollGamepadState(this);
     }
@@ -379,6 +381,11 @@ bool Gamepad::isVirtual() const
     return _form;
 }
 
+double Gamepad::getEventTime() const
+{
+    return _eventTime;
+}
+
 Form* Gamepad::getForm() const
 {
     return _form;
@@ -20,6 +20,7 @@ class Gamepad
     friend class Platform;
     friend class Game;
     friend class Button;
+    friend class InputRecorder;
 
 public:
 
@@ -146,6 +147,17 @@ public:
      */
     bool isVirtual() const;
 
+    /**
+     * Gets the time at which the platform received the last input of this gamepad, in the
+     * time base of Game::getAbsoluteTime(). Subtracting it from the absolute time at which
+     * the input takes effect measures the input latency.
+     *
+     * @return The time of the last input in milliseconds, or 0 if the platform does not report
+     *      the times of gamepad input.
+     * @script{ignore}
+     */
+    double getEventTime() const;
+
     /**
      * Gets the Form used to represent this gamepad.
      *
@@ -245,6 +257,7 @@ private:
     unsigned int _buttons;
     Vector2 _joysticks[2];
     float _triggers[2];
+    double _eventTime;
 };
 
 }
@@ -0,0 +1,283 @@
+#include "Base.h"
+#include "GpuUploadQueue.h"
+#include "Platform.h"
+#include "Image.h"
+#include "Texture.h"
+#include "StateCache.h"
+#include "RenderStats.h"
+
+namespace gameplay
+{
+
+/**
+ * The state of an upload submitted by uploadTexture().
+ */
+struct TextureUpload
+{
+    Image* image;
+    bool generateMipmaps;
+    GLuint handle;
+    GpuUploadQueue::TextureCallback callback;
+    void* cookie;
+};
+
+GpuUploadQueue::GpuUploadQueue()
+    : _async(false), _running(false), _thread(NULL), _pendingCount(0)
+{
+}
+
+GpuUploadQueue::~GpuUploadQueue()
+{
+}
+
+void GpuUploadQueue::initialize(Properties* properties)
+{
+    bool loaderThread = true;
+    if (properties && properties->exists("loaderThread"))
+        loaderThread = properties->getBool("loaderThread");
+
+    if (loaderThread && Platform::createLoaderContext())
+    {
+        _running = true;
+        _async = true;
+        _thread = Thread::create(&GpuUploadQueue::loaderThread, this);
+        if (_thread == NULL)
+        {
+            _running = false;
+            _async = false;
+            Platform::destroyLoaderContext();
+        }
+    }
+}
+
+void GpuUploadQueue::finalize()
+{
+    // The loader thread runs the uploads left in the queue before it stops.
+    if (_thread)
+    {
+        {
+            MutexLock lock(_mutex);
+            _running = false;
+            _condition.signal();
+        }
+        _thread->join();
+        SAFE_DELETE(_thread);
+        Platform::destroyLoaderContext();
+    }
+    _async = false;
+    completeUploads(true);
+}
+
+bool GpuUploadQueue::isAsync() const
+{
+    MutexLock lock(_mutex);
+    return _async;
+}
+
+void GpuUploadQueue::submit(UploadFunction upload, CompleteFunction complete, void* cookie)
+{
+    GP_ASSERT(upload);
+
+    Upload entry;
+    entry.upload = upload;
+    entry.complete = complete;
+    entry.cookie = cookie;
+    entry.fence = NULL;
+    ++_pendingCount;
+
+    MutexLock lock(_mutex);
+    _queued.push_back(entry);
+    _condition.signal();
+}
+
+void GpuUploadQueue::uploadTexture(Image* image, bool generateMipmaps, TextureCallback callback, void* cookie)
+{
+    GP_ASSERT(image);
+    GP_ASSERT(callback);
+
+    if (image->getFormat() != Image::RGB && image->getFormat() != Image::RGBA)
+    {
+        GP_ERROR("Unsupported image format (%d).", image->getFormat());
+        callback(NULL, cookie);
+        return;
+    }
+
+    TextureUpload* upload = new TextureUpload();
+    upload->image = image;
+    image->addRef();
+    upload->generateMipmaps = generateMipmaps;
+    upload->handle = 0;
+    upload->callback = callback;
+    upload->cookie = cookie;
+    submit(&GpuUploadQueue::uploadTextureData, &GpuUploadQueue::completeTexture, upload);
+}
+
+unsigned int GpuUploadQueue::getPendingCount() const
+{
+    return _pendingCount;
+}
+
+void GpuUploadQueue::update()
+{
+    completeUploads(false);
+}
+
+void GpuUploadQueue::completeUploads(bool wait)
+{
+    // Without a loader thread the uploads run here, on the context of the game.
+    std::list<Upload> queued;
+    {
+        MutexLock lock(_mutex);
+        if (!_async)
+            queued.swap(_queued);
+    }
+    if (!queued.empty())
+    {
+        for (std::list<Upload>::iterator itr = queued.begin(); itr != queued.end(); ++itr)
+        {
+            itr->upload(itr->cookie);
+        }
+
+        // Uploads bind objects directly, behind the back of the state cache.
+        StateCache::invalidate();
+
+        MutexLock lock(_mutex);
+        _uploaded.splice(_uploaded.end(), queued);
+    }
+
+    while (true)
+    {
+        Upload upload;
+        {
+            MutexLock lock(_mutex);
+            if (_uploaded.empty())
+                break;
+            upload = _uploaded.front();
+        }
+
+#ifdef USE_FENCE_SYNC
+        if (upload.fence)
+        {
+            GLsync fence = (GLsync)upload.fence;
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                if (!wait)
+                    break;
+                do
+                {
+                    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                } while (result == GL_TIMEOUT_EXPIRED);
+            }
+            GL_ASSERT( glDeleteSync(fence) );
+        }
+#endif
+
+        {
+            MutexLock lock(_mutex);
+            _uploaded.pop_front();
+        }
+        --_pendingCount;
+        if (upload.complete)
+            upload.complete(upload.cookie);
+    }
+}
+
+void GpuUploadQueue::loaderThread(void* arg)
+{
+    GpuUploadQueue* queue = (GpuUploadQueue*)arg;
+    GP_ASSERT(queue);
+
+    if (!Platform::makeLoaderContextCurrent(true))
+    {
+        // The main thread takes over the uploads.
+        GP_WARN("Failed to make the loader context current; uploads will run on the main thread.");
+        MutexLock lock(queue->_mutex);
+        queue->_async = false;
+        return;
+    }
+
+    while (true)
+    {
+        Upload upload;
+        {
+            MutexLock lock(queue->_mutex);
+            while (queue->_running && queue->_queued.empty())
+            {
+                queue->_condition.wait(queue->_mutex);
+            }
+            if (queue->_queued.empty())
+                break;
+            upload = queue->_queued.front();
+            queue->_queued.pop_front();
+        }
+
+        upload.upload(upload.cookie);
+        synchronize(upload);
+
+        MutexLock lock(queue->_mutex);
+        queue->_uploaded.push_back(upload);
+    }
+
+    Platform::makeLoaderContextCurrent(false);
+}
+
+void GpuUploadQueue::synchronize(Upload& upload)
+{
+#ifdef USE_FENCE_SYNC
+    if (glFenceSync && glClientWaitSync && glDeleteSync)
+    {
+        // The fence must reach the GPU before the main thread waits on it from its own context.
+        upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GL_ASSERT( glFlush() );
+        return;
+    }
+#endif
+    upload.fence = NULL;
+    GL_ASSERT( glFinish() );
+}
+
+void GpuUploadQueue::uploadTextureData(void* cookie)
+{
+    TextureUpload* upload = (TextureUpload*)cookie;
+    Image* image = upload->image;
+    GLenum format = image->getFormat() == Image::RGBA ? GL_RGBA : GL_RGB;
+
+    GL_ASSERT( glGenTextures(1, &upload->handle) );
+    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, upload->handle) );
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, format, image->getWidth(), image->getHeight(), 0, format, GL_UNSIGNED_BYTE, image->getData()) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, upload->generateMipmaps ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR) );
+    if (upload->generateMipmaps)
+    {
+        GL_ASSERT( glGenerateMipmap(GL_TEXTURE_2D) );
+    }
+    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, 0) );
+}
+
+void GpuUploadQueue::completeTexture(void* cookie)
+{
+    TextureUpload* upload = (TextureUpload*)cookie;
+    Image* image = upload->image;
+
+    Texture* texture = NULL;
+    if (upload->handle)
+    {
+        Texture::Format format = image->getFormat() == Image::RGBA ? Texture::RGBA : Texture::RGB;
+        texture = Texture::create(upload->handle, image->getWidth(), image->getHeight(), format);
+        texture->_minFilter = upload->generateMipmaps ? Texture::NEAREST_MIPMAP_LINEAR : Texture::LINEAR;
+        if (upload->generateMipmaps)
+        {
+            // The mip chain adds a third to the size of the base level.
+            texture->_mipmapped = true;
+            texture->setMemorySize(texture->_memorySize + texture->_memorySize / 3);
+        }
+        RenderStats::addUpload(image->getWidth() * image->getHeight() * (format == Texture::RGBA ? 4 : 3));
+    }
+
+    upload->callback(texture, upload->cookie);
+    SAFE_RELEASE(upload->image);
+    SAFE_DELETE(upload);
+}
+
+}
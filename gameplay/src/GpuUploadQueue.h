@@ -0,0 +1,189 @@
+#ifndef GPUUPLOADQUEUE_H_
+#define GPUUPLOADQUEUE_H_
+
+#include "Properties.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+class Image;
+class Texture;
+
+/**
+ * Defines a queue of GPU uploads that runs on a loader thread with its own GL context.
+ *
+ * Creating textures and buffers on the main thread stalls the frame while the driver
+ * copies the data. Where the platform supports shared GL contexts, the queue creates
+ * a loader context that shares its objects with the context of the game, and runs the
+ * uploads on a loader thread with that context current. After each upload the loader
+ * thread inserts a fence (or waits for the GPU where fences are not available), and the
+ * main thread hands the upload back once the fence has signaled, so the new object is
+ * complete by the time the game uses it. Uploads complete in the order they were
+ * submitted.
+ *
+ * Upload functions run on the loader thread and must only make direct GL calls: the
+ * GL state cache (StateCache) and the objects of the engine belong to the main thread.
+ * Complete functions run on the main thread, from Game::frame(). Where the platform
+ * has no shared contexts, or the loader thread is disabled, the uploads run on the
+ * main thread at the start of the next frame.
+ *
+ * The queue is configured in the game config:
+ *
+ * @verbatim
+    gpuUploads
+    {
+        loaderThread = true     // Upload on a loader thread with a shared context, where supported.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class GpuUploadQueue
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Function that makes the GL calls of an upload.
+     *
+     * @param cookie The cookie passed to submit().
+     */
+    typedef void (*UploadFunction)(void* cookie);
+
+    /**
+     * Function called on the main thread once an upload is complete on the GPU.
+     *
+     * @param cookie The cookie passed to submit().
+     */
+    typedef void (*CompleteFunction)(void* cookie);
+
+    /**
+     * Function called on the main thread with a texture uploaded by uploadTexture().
+     *
+     * @param texture The new texture, or NULL if the upload failed. The callback receives a reference to it.
+     * @param cookie The cookie passed to uploadTexture().
+     */
+    typedef void (*TextureCallback)(Texture* texture, void* cookie);
+
+    /**
+     * Determines if uploads run on the loader thread.
+     *
+     * @return true if uploads run on the loader thread, false if they run on the main thread.
+     */
+    bool isAsync() const;
+
+    /**
+     * Submits an upload.
+     *
+     * @param upload The function that makes the GL calls of the upload.
+     * @param complete The function called on the main thread when the upload is complete, or NULL.
+     * @param cookie The user data passed to both functions.
+     */
+    void submit(UploadFunction upload, CompleteFunction complete, void* cookie);
+
+    /**
+     * Uploads an RGB or RGBA image into a new texture.
+     *
+     * @param image The image. It is referenced until the upload is complete.
+     * @param generateMipmaps true to generate the mipmaps of the texture.
+     * @param callback The function called on the main thread with the new texture.
+     * @param cookie The user data passed to the callback.
+     */
+    void uploadTexture(Image* image, bool generateMipmaps, TextureCallback callback, void* cookie);
+
+    /**
+     * Gets the number of uploads that are submitted but not complete.
+     *
+     * @return The number of pending uploads.
+     */
+    unsigned int getPendingCount() const;
+
+private:
+
+    struct Upload
+    {
+        UploadFunction upload;
+        CompleteFunction complete;
+        void* cookie;
+        void* fence;                // GLsync, or NULL if the loader thread waited for the GPU.
+    };
+
+    /**
+     * Constructor.
+     */
+    GpuUploadQueue();
+
+    /**
+     * Destructor.
+     */
+    ~GpuUploadQueue();
+
+    /**
+     * Hidden copy constructor.
+     */
+    GpuUploadQueue(const GpuUploadQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    GpuUploadQueue& operator=(const GpuUploadQueue&);
+
+    /**
+     * Called during startup to create the loader context and thread.
+     *
+     * @param properties The 'gpuUploads' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to complete the pending uploads and stop the loader thread.
+     */
+    void finalize();
+
+    /**
+     * Called at the start of each frame to hand back the completed uploads.
+     */
+    void update();
+
+    /**
+     * Hands back the uploads the GPU has completed, in order.
+     *
+     * @param wait true to wait for every upload, false to stop at the first one that is not complete.
+     */
+    void completeUploads(bool wait);
+
+    /**
+     * Runs the uploads of the queue until the loader thread is stopped.
+     */
+    static void loaderThread(void* arg);
+
+    /**
+     * Makes an upload complete on the GPU before it is handed back.
+     */
+    static void synchronize(Upload& upload);
+
+    /**
+     * Upload function of uploadTexture().
+     */
+    static void uploadTextureData(void* cookie);
+
+    /**
+     * Complete function of uploadTexture().
+     */
+    static void completeTexture(void* cookie);
+
+    bool _async;
+    bool _running;
+    Thread* _thread;
+    mutable Mutex _mutex;
+    Condition _condition;
+    std::list<Upload> _queued;
+    std::list<Upload> _uploaded;
+    unsigned int _pendingCount;
+};
+
+}
+
+#endif
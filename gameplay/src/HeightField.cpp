@@ -2,24 +2,80 @@
 #include "HeightField.h"
 #include "Image.h"
 #include "FileSystem.h"
+#include "Game.h"
+#include "MathUtilSIMD.h"
+
+// The minimum number of rows converted by one job.
+#define HEIGHTFIELD_ROW_BATCH 32
+
+// The minimum number of points sampled by one job.
+#define HEIGHTFIELD_SAMPLE_BATCH 1024
 
 namespace gameplay
 {
 
-HeightField::HeightField(unsigned int columns, unsigned int rows)
-    : _array(NULL), _cols(columns), _rows(rows)
+/**
+ * The source samples and destination heights of a heightfield conversion.
+ *
+ * @script{ignore}
+ */
+struct HeightConversion
+{
+    const unsigned char* data;
+    float* heights;
+    short* shortHeights;        // Set instead of heights for FORMAT_SHORT heightfields.
+    unsigned int width;
+    unsigned int height;
+    unsigned int sampleSize;    // Bytes per sample: 3 or 4 for images, 1 or 2 for RAW files.
+    float heightMin;
+    float heightScale;
+};
+
+/**
+ * The points and results of a batch of height queries.
+ *
+ * @script{ignore}
+ */
+struct HeightSampling
+{
+    const HeightField* heightfield;
+    const Vector2* points;
+    float* heights;
+    Vector3* normals;           // NULL if only the heights are wanted.
+};
+
+HeightField::HeightField(unsigned int columns, unsigned int rows, Format format, float heightMin, float heightMax)
+    : _array(NULL), _shortArray(NULL), _heightScale(1.0f), _heightOffset(0.0f), _cols(columns), _rows(rows)
 {
-    _array = new float[columns * rows];
+    if (format == FORMAT_SHORT)
+    {
+        // Stored values -32768 to 32767 span the range from heightMin to heightMax
+        _shortArray = new short[columns * rows];
+        _heightScale = (heightMax - heightMin) / 65535.0f;
+        _heightOffset = heightMin + 32768.0f * _heightScale;
+    }
+    else
+    {
+        _array = new float[columns * rows];
+    }
 }
 
 HeightField::~HeightField()
 {
     SAFE_DELETE_ARRAY(_array);
+    SAFE_DELETE_ARRAY(_shortArray);
 }
 
 HeightField* HeightField::create(unsigned int columns, unsigned int rows)
 {
-    return new HeightField(columns, rows);
+    return new HeightField(columns, rows, FORMAT_FLOAT, 0, 1);
+}
+
+HeightField* HeightField::create(unsigned int columns, unsigned int rows, Format format, float heightMin, float heightMax)
+{
+    GP_ASSERT(heightMax >= heightMin);
+
+    return new HeightField(columns, rows, format, heightMin, heightMax);
 }
 
 /**
@@ -35,17 +91,158 @@ float normalizedHeightPacked(float r, float g, float b)
     return (256.0f*r + g + 0.00390625f*b) / 65536.0f;
 }
 
+/**
+ * Converts 8-bit samples to heights.
+ *
+ * @script{ignore}
+ */
+static void convertSamples8(const unsigned char* samples, float* heights, unsigned int count, float scale, float offset)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 s = FLOAT4_SET(scale);
+    float4 o = FLOAT4_SET(offset);
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(heights + i, FLOAT4_MADD(o, float4LoadU8(samples + i), s));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        heights[i] = offset + samples[i] * scale;
+    }
+}
+
+/**
+ * Converts little endian 16-bit samples to heights.
+ *
+ * @script{ignore}
+ */
+static void convertSamples16(const unsigned char* samples, float* heights, unsigned int count, float scale, float offset)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 s = FLOAT4_SET(scale);
+    float4 o = FLOAT4_SET(offset);
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(heights + i, FLOAT4_MADD(o, float4LoadU16(samples + i * 2), s));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        heights[i] = offset + (samples[i * 2] | (int)samples[i * 2 + 1] << 8) * scale;
+    }
+}
+
+/**
+ * Converts little endian 8-bit or 16-bit samples to 16-bit stored heights, which keep their full precision.
+ *
+ * @script{ignore}
+ */
+static void convertSamplesShort(const unsigned char* samples, short* heights, unsigned int count, unsigned int sampleSize)
+{
+    if (sampleSize == 2)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+            heights[i] = (short)((samples[i * 2] | (int)samples[i * 2 + 1] << 8) - 32768);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < count; ++i)
+            heights[i] = (short)(samples[i] * 257 - 32768);
+    }
+}
+
+/**
+ * Converts a range of image rows to heights. Images are stored top row first.
+ *
+ * @script{ignore}
+ */
+static void convertImageRows(unsigned int start, unsigned int end, void* cookie)
+{
+    const HeightConversion* conversion = (const HeightConversion*)cookie;
+    const unsigned int w = conversion->width;
+    for (unsigned int row = start; row < end; ++row)
+    {
+        const unsigned char* data = conversion->data + (conversion->height - 1 - row) * w * conversion->sampleSize;
+        if (conversion->shortHeights)
+        {
+            short* heights = conversion->shortHeights + row * w;
+            for (unsigned int x = 0; x < w; ++x, data += conversion->sampleSize)
+            {
+                heights[x] = (short)((int)(normalizedHeightPacked(data[0], data[1], data[2]) * 65535.0f + 0.5f) - 32768);
+            }
+            continue;
+        }
+
+        float* heights = conversion->heights + row * w;
+        for (unsigned int x = 0; x < w; ++x, data += conversion->sampleSize)
+        {
+            heights[x] = conversion->heightMin + normalizedHeightPacked(data[0], data[1], data[2]) * conversion->heightScale;
+        }
+    }
+}
+
+/**
+ * Converts a range of RAW rows to heights.
+ *
+ * @script{ignore}
+ */
+static void convertRAWRows(unsigned int start, unsigned int end, void* cookie)
+{
+    const HeightConversion* conversion = (const HeightConversion*)cookie;
+    const unsigned int w = conversion->width;
+    const unsigned char* data = conversion->data + start * w * conversion->sampleSize;
+    if (conversion->shortHeights)
+    {
+        convertSamplesShort(data, conversion->shortHeights + start * w, (end - start) * w, conversion->sampleSize);
+        return;
+    }
+
+    float* heights = conversion->heights + start * w;
+    if (conversion->sampleSize == 2)
+        convertSamples16(data, heights, (end - start) * w, conversion->heightScale / 65535.0f, conversion->heightMin);
+    else
+        convertSamples8(data, heights, (end - start) * w, conversion->heightScale / 255.0f, conversion->heightMin);
+}
+
+/**
+ * Runs a conversion over all rows, split over the job scheduler when it is running.
+ *
+ * @script{ignore}
+ */
+static void convertRows(JobScheduler::RangeFunction function, HeightConversion* conversion)
+{
+    Game* game = Game::getInstance();
+    JobScheduler* scheduler = game ? game->getJobScheduler() : NULL;
+    if (scheduler)
+        scheduler->parallelFor(conversion->height, function, conversion, HEIGHTFIELD_ROW_BATCH);
+    else
+        function(0, conversion->height, conversion);
+}
+
 HeightField* HeightField::createFromImage(const char* path, float heightMin, float heightMax)
 {
-    return create(path, 0, 0, heightMin, heightMax);
+    return create(path, 0, 0, heightMin, heightMax, FORMAT_FLOAT);
+}
+
+HeightField* HeightField::createFromImage(const char* path, float heightMin, float heightMax, Format format)
+{
+    return create(path, 0, 0, heightMin, heightMax, format);
 }
 
 HeightField* HeightField::createFromRAW(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax)
 {
-    return create(path, width, height, heightMin, heightMax);
+    return create(path, width, height, heightMin, heightMax, FORMAT_FLOAT);
+}
+
+HeightField* HeightField::createFromRAW(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax, Format format)
+{
+    return create(path, width, height, heightMin, heightMax, format);
 }
 
-HeightField* HeightField::create(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax)
+HeightField* HeightField::create(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax, Format format)
 {
     GP_ASSERT(path);
     GP_ASSERT(heightMax >= heightMin);
@@ -79,18 +276,17 @@ HeightField* HeightField::create(const char* path, unsigned int width, unsigned
         }
 
         // Calculate the heights for each pixel.
-        heightfield = HeightField::create(image->getWidth(), image->getHeight());
-        float* heights = heightfield->getArray();
-        unsigned char* data = image->getData();
-        int idx;
-        for (int y = image->getHeight()-1, i = 0; y >= 0; --y)
-        {
-            for (unsigned int x = 0, w = image->getWidth(); x < w; ++x)
-            {
-                idx = (y*w + x) * pixelSize;
-                heights[i++] = heightMin + normalizedHeightPacked(data[idx], data[idx + 1], data[idx + 2]) * heightScale;
-            }
-        }
+        heightfield = HeightField::create(image->getWidth(), image->getHeight(), format, heightMin, heightMax);
+        HeightConversion conversion;
+        conversion.data = image->getData();
+        conversion.heights = heightfield->getArray();
+        conversion.shortHeights = heightfield->getShortArray();
+        conversion.width = image->getWidth();
+        conversion.height = image->getHeight();
+        conversion.sampleSize = pixelSize;
+        conversion.heightMin = heightMin;
+        conversion.heightScale = heightScale;
+        convertRows(convertImageRows, &conversion);
 
         SAFE_RELEASE(image);
     }
@@ -121,33 +317,18 @@ HeightField* HeightField::create(const char* path, unsigned int width, unsigned
             return NULL;
         }
 
-        heightfield = HeightField::create(width, height);
-        float* heights = heightfield->getArray();
-
-        if (bits == 16)
-        {
-            // 16-bit (0-65535)
-            int idx;
-            for (unsigned int y = 0, i = 0; y < height; ++y)
-            {
-                for (unsigned int x = 0; x < width; ++x, ++i)
-                {
-                    idx = (y * width + x) << 1;
-                    heights[i] = heightMin + ((bytes[idx] | (int)bytes[idx+1] << 8) / 65535.0f) * heightScale;
-                }
-            }
-        }
-        else
-        {
-            // 8-bit (0-255)
-            for (unsigned int y = 0, i = 0; y < height; ++y)
-            {
-                for (unsigned int x = 0; x < width; ++x, ++i)
-                {
-                    heights[i] = heightMin + (bytes[y * width + x] / 255.0f) * heightScale;
-                }
-            }
-        }
+        // 16-bit (0-65535) or 8-bit (0-255) samples
+        heightfield = HeightField::create(width, height, format, heightMin, heightMax);
+        HeightConversion conversion;
+        conversion.data = bytes;
+        conversion.heights = heightfield->getArray();
+        conversion.shortHeights = heightfield->getShortArray();
+        conversion.width = width;
+        conversion.height = height;
+        conversion.sampleSize = bits / 8;
+        conversion.heightMin = heightMin;
+        conversion.heightScale = heightScale;
+        convertRows(convertRAWRows, &conversion);
 
         SAFE_DELETE_ARRAY(bytes);
     }
@@ -159,11 +340,69 @@ HeightField* HeightField::create(const char* path, unsigned int width, unsigned
     return heightfield;
 }
 
+HeightField::Format HeightField::getFormat() const
+{
+    return _shortArray ? FORMAT_SHORT : FORMAT_FLOAT;
+}
+
 float* HeightField::getArray() const
 {
     return _array;
 }
 
+short* HeightField::getShortArray() const
+{
+    return _shortArray;
+}
+
+float HeightField::getHeightScale() const
+{
+    return _heightScale;
+}
+
+float HeightField::getHeightOffset() const
+{
+    return _heightOffset;
+}
+
+void HeightField::setHeight(unsigned int column, unsigned int row, float height)
+{
+    GP_ASSERT(column < _cols && row < _rows);
+
+    unsigned int index = column + row * _cols;
+    if (_array)
+    {
+        _array[index] = height;
+        return;
+    }
+
+    float value = _heightScale > 0.0f ? (height - _heightOffset) / _heightScale : 0.0f;
+    value = value < -32768.0f ? -32768.0f : (value > 32767.0f ? 32767.0f : value);
+    _shortArray[index] = (short)(value < 0.0f ? value - 0.5f : value + 0.5f);
+}
+
+void HeightField::getHeights(float* heights) const
+{
+    GP_ASSERT(heights);
+
+    unsigned int count = _cols * _rows;
+    if (_array)
+    {
+        memcpy(heights, _array, count * sizeof(float));
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        heights[i] = _heightOffset + _shortArray[i] * _heightScale;
+    }
+}
+
+float HeightField::getStoredHeight(unsigned int index) const
+{
+    return _array ? _array[index] : _heightOffset + _shortArray[index] * _heightScale;
+}
+
 float HeightField::getHeight(float column, float row) const
 {
     // Clamp to heightfield boundaries
@@ -182,15 +421,15 @@ float HeightField::getHeight(float column, float row) const
 
     if (x2 >= _cols && y2 >= _rows)
     {
-        return _array[x1 + y1 * _cols];
+        return getStoredHeight(x1 + y1 * _cols);
     }
     else if (x2 >= _cols)
     {
-        return _array[x1 + y1 * _cols] * yFactorI + _array[x1 + y2 * _cols] * yFactor;
+        return getStoredHeight(x1 + y1 * _cols) * yFactorI + getStoredHeight(x1 + y2 * _cols) * yFactor;
     }
     else if (y2 >= _rows)
     {
-        return _array[x1 + y1 * _cols] * xFactorI + _array[x2 + y1 * _cols] * xFactor;
+        return getStoredHeight(x1 + y1 * _cols) * xFactorI + getStoredHeight(x2 + y1 * _cols) * xFactor;
     }
     else
     {
@@ -198,8 +437,128 @@ float HeightField::getHeight(float column, float row) const
         float b = xFactorI * yFactor;
         float c = xFactor * yFactor;
         float d = xFactor * yFactorI;
-        return _array[x1 + y1 * _cols] * a + _array[x1 + y2 * _cols] * b +
-            _array[x2 + y2 * _cols] * c + _array[x2 + y1 * _cols] * d;
+        return getStoredHeight(x1 + y1 * _cols) * a + getStoredHeight(x1 + y2 * _cols) * b +
+            getStoredHeight(x2 + y2 * _cols) * c + getStoredHeight(x2 + y1 * _cols) * d;
+    }
+}
+
+void HeightField::sampleHeights(const Vector2* points, unsigned int count, float* heights, Vector3* normals, bool parallel) const
+{
+    GP_ASSERT(count == 0 || (points && heights));
+
+    Game* game = parallel ? Game::getInstance() : NULL;
+    JobScheduler* scheduler = game ? game->getJobScheduler() : NULL;
+    if (scheduler && count > HEIGHTFIELD_SAMPLE_BATCH)
+    {
+        HeightSampling sampling = { this, points, heights, normals };
+        scheduler->parallelFor(count, sampleJob, &sampling, HEIGHTFIELD_SAMPLE_BATCH);
+    }
+    else
+    {
+        sampleRange(points, 0, count, heights, normals);
+    }
+}
+
+void HeightField::sampleJob(unsigned int start, unsigned int end, void* cookie)
+{
+    const HeightSampling* sampling = (const HeightSampling*)cookie;
+    sampling->heightfield->sampleRange(sampling->points, start, end, sampling->heights, sampling->normals);
+}
+
+void HeightField::sampleRange(const Vector2* points, unsigned int start, unsigned int end, float* heights, Vector3* normals) const
+{
+    // Points are clamped to the heightfield, and the last column and row use their own
+    // heights as their neighbors, which gives the same heights as getHeight.
+    const float maxColumn = (float)(_cols - 1);
+    const float maxRow = (float)(_rows - 1);
+    unsigned int i = start;
+#ifdef GP_SIMD
+    // Four points are interpolated at a time; only the loads of their corner heights are scalar.
+    float columns[4], rows[4], h11[4], h21[4], h12[4], h22[4], gx[4], gz[4], inv[4];
+    const float4 zero = FLOAT4_SET(0.0f);
+    const float4 one = FLOAT4_SET(1.0f);
+    const float4 maxC = FLOAT4_SET(maxColumn);
+    const float4 maxR = FLOAT4_SET(maxRow);
+    for (; i + 4 <= end; i += 4)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            columns[j] = points[i + j].x;
+            rows[j] = points[i + j].y;
+        }
+
+        float4 c = FLOAT4_MIN(FLOAT4_MAX(FLOAT4_LOAD(columns), zero), maxC);
+        float4 r = FLOAT4_MIN(FLOAT4_MAX(FLOAT4_LOAD(rows), zero), maxR);
+        float4 c1 = FLOAT4_TRUNC(c);
+        float4 r1 = FLOAT4_TRUNC(r);
+        float4 fx = FLOAT4_SUB(c, c1);
+        float4 fy = FLOAT4_SUB(r, r1);
+        FLOAT4_STORE(columns, c1);
+        FLOAT4_STORE(rows, r1);
+
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            unsigned int x1 = (unsigned int)columns[j];
+            unsigned int y1 = (unsigned int)rows[j];
+            unsigned int x2 = x1 + 1 < _cols ? x1 + 1 : x1;
+            unsigned int row1 = y1 * _cols;
+            unsigned int row2 = (y1 + 1 < _rows ? y1 + 1 : y1) * _cols;
+            h11[j] = getStoredHeight(x1 + row1);
+            h21[j] = getStoredHeight(x2 + row1);
+            h12[j] = getStoredHeight(x1 + row2);
+            h22[j] = getStoredHeight(x2 + row2);
+        }
+
+        float4 a = FLOAT4_LOAD(h11);
+        float4 b = FLOAT4_LOAD(h12);
+        float4 dxTop = FLOAT4_SUB(FLOAT4_LOAD(h21), a);
+        float4 dxBottom = FLOAT4_SUB(FLOAT4_LOAD(h22), b);
+        float4 top = FLOAT4_MADD(a, dxTop, fx);
+        float4 bottom = FLOAT4_MADD(b, dxBottom, fx);
+        float4 dz = FLOAT4_SUB(bottom, top);
+        FLOAT4_STORE(heights + i, FLOAT4_MADD(top, dz, fy));
+        if (normals)
+        {
+            float4 dx = FLOAT4_MADD(dxTop, FLOAT4_SUB(dxBottom, dxTop), fy);
+            float4 lengthSq = FLOAT4_MADD(FLOAT4_MADD(one, dx, dx), dz, dz);
+            FLOAT4_STORE(gx, dx);
+            FLOAT4_STORE(gz, dz);
+            FLOAT4_STORE(inv, float4ReciprocalSqrt(lengthSq));
+        }
+
+        if (normals)
+        {
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                normals[i + j].set(-gx[j] * inv[j], inv[j], -gz[j] * inv[j]);
+            }
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        float column = std::min(std::max(points[i].x, 0.0f), maxColumn);
+        float row = std::min(std::max(points[i].y, 0.0f), maxRow);
+        unsigned int x1 = (unsigned int)column;
+        unsigned int y1 = (unsigned int)row;
+        float fx = column - x1;
+        float fy = row - y1;
+        unsigned int x2 = x1 + 1 < _cols ? x1 + 1 : x1;
+        unsigned int row1 = y1 * _cols;
+        unsigned int row2 = (y1 + 1 < _rows ? y1 + 1 : y1) * _cols;
+        float a = getStoredHeight(x1 + row1);
+        float b = getStoredHeight(x1 + row2);
+        float dxTop = getStoredHeight(x2 + row1) - a;
+        float dxBottom = getStoredHeight(x2 + row2) - b;
+        float top = a + dxTop * fx;
+        float dz = b + dxBottom * fx - top;
+        heights[i] = top + dz * fy;
+        if (normals)
+        {
+            float dx = dxTop + (dxBottom - dxTop) * fy;
+            normals[i].set(-dx, 1.0f, -dz);
+            normals[i].normalize();
+        }
     }
 }
 
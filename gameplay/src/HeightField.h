@@ -2,6 +2,8 @@
 #define HEIGHTFIELD_H_
 
 #include "Ref.h"
+#include "Vector2.h"
+#include "Vector3.h"
 
 namespace gameplay
 {
@@ -12,11 +14,28 @@ namespace gameplay
      * Heightfields can be used to construct both Terrain objects as well as PhysicsCollisionShape
      * heightfield defintions, which are used in heightfield rigid body creation. Heightfields can
      * be populated manually, or loaded from images and RAW files.
+     *
+     * Terrains and heightfield collision shapes share the same height array: the physics
+     * heightfield reads the heights in place, so a terrain with collision keeps its heights once.
+     * Heights are stored as floats by default. A heightfield with the FORMAT_SHORT format stores
+     * them as 16-bit values instead, quantized over the range of heights it is created with,
+     * which halves its memory at a precision of 1/65535 of that range.
      */
     class HeightField : public Ref
     {
     public:
 
+        /**
+         * Defines the storage formats of heights.
+         *
+         * @script{ignore}
+         */
+        enum Format
+        {
+            FORMAT_FLOAT,
+            FORMAT_SHORT
+        };
+
         /**
          * Creates a new HeightField of the given dimensions, with uninitialized height data.
          *
@@ -27,6 +46,23 @@ namespace gameplay
          */
         static HeightField* create(unsigned int rows, unsigned int columns);
 
+        /**
+         * Creates a new HeightField of the given dimensions and storage format, with uninitialized height data.
+         *
+         * Heights of a FORMAT_SHORT heightfield are clamped to the range between heightMin and heightMax
+         * when they are set. The range is ignored for FORMAT_FLOAT heightfields.
+         *
+         * @param rows Number of rows in the height field.
+         * @param columns Number of columns in the height field.
+         * @param format The storage format of the heights.
+         * @param heightMin The lowest height that can be stored.
+         * @param heightMax The highest height that can be stored (must be >= heightMin).
+         *
+         * @return The new HeightField.
+         * @script{ignore}
+         */
+        static HeightField* create(unsigned int rows, unsigned int columns, Format format, float heightMin = 0, float heightMax = 1);
+
         /**
          * Creates a HeightField from the specified heightfield image.
          *
@@ -45,6 +81,20 @@ namespace gameplay
          */
         static HeightField* createFromImage(const char* path, float heightMin = 0, float heightMax = 1);
 
+        /**
+         * Creates a HeightField from the specified heightfield image, storing its heights in the given format.
+         *
+         * @param path Path to a heightfield image.
+         * @param heightMin Minimum height value for a zero intensity pixel.
+         * @param heightMax Maximum height value for a full intensity heightfield pixel (must be >= minHeight).
+         * @param format The storage format of the heights.
+         *
+         * @return The new HeightField.
+         * @see createFromImage(const char*, float, float)
+         * @script{ignore}
+         */
+        static HeightField* createFromImage(const char* path, float heightMin, float heightMax, Format format);
+
         /**
          * Creates a HeightField from the specified RAW8 or RAW16 file.
          *
@@ -72,16 +122,87 @@ namespace gameplay
          */
         static HeightField* createFromRAW(const char* path, unsigned int width, unsigned int height, float heightMin = 0, float heightMax = 1);
 
+        /**
+         * Creates a HeightField from the specified RAW8 or RAW16 file, storing its heights in the given format.
+         *
+         * 8-bit and 16-bit samples are stored without loss in FORMAT_SHORT heightfields.
+         *
+         * @param path Path to the RAW file (must end in a .raw or .r16 file extension).
+         * @param width Width of the RAW data.
+         * @param height Height of the RAW data.
+         * @param heightMin Minimum height value for a zero intensity pixel.
+         * @param heightMax Maximum height value for a full intensity heightfield pixel (must be >= minHeight).
+         * @param format The storage format of the heights.
+         *
+         * @return The new HeightField.
+         * @see createFromRAW(const char*, unsigned int, unsigned int, float, float)
+         * @script{ignore}
+         */
+        static HeightField* createFromRAW(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax, Format format);
+
+        /**
+         * Returns the storage format of the heights.
+         *
+         * @return The storage format.
+         * @script{ignore}
+         */
+        Format getFormat() const;
+
         /**
          * Returns a pointer to the underying height array.
          *
          * The array is packed in row major order, meaning that the data is aligned in rows,
          * from top left to bottom right.
          *
-         * @return The underlying height array.
+         * @return The underlying height array, or NULL if the heights are stored in FORMAT_SHORT.
          */
         float* getArray() const;
 
+        /**
+         * Returns a pointer to the underlying array of 16-bit heights of a FORMAT_SHORT heightfield.
+         *
+         * The array has the same layout as the float array. A stored value s is the
+         * height getHeightOffset() + s * getHeightScale().
+         *
+         * @return The underlying 16-bit height array, or NULL if the heights are stored in FORMAT_FLOAT.
+         * @script{ignore}
+         */
+        short* getShortArray() const;
+
+        /**
+         * Returns the height step of one unit of a 16-bit stored height.
+         *
+         * @return The height scale, or 1 for FORMAT_FLOAT heightfields.
+         * @script{ignore}
+         */
+        float getHeightScale() const;
+
+        /**
+         * Returns the height of a zero 16-bit stored height.
+         *
+         * @return The height offset, or 0 for FORMAT_FLOAT heightfields.
+         * @script{ignore}
+         */
+        float getHeightOffset() const;
+
+        /**
+         * Sets the height at the specified row and column, in either storage format.
+         *
+         * @param column The column of the height value to set.
+         * @param row The row of the height value to set.
+         * @param height The height value.
+         * @script{ignore}
+         */
+        void setHeight(unsigned int column, unsigned int row, float height);
+
+        /**
+         * Copies all heights into a float array, in either storage format.
+         *
+         * @param heights The array to fill, which must hold getRowCount() * getColumnCount() heights.
+         * @script{ignore}
+         */
+        void getHeights(float* heights) const;
+
         /**
          * Returns the height at the specified row and column.
          *
@@ -99,6 +220,23 @@ namespace gameplay
          */
         float getHeight(float column, float row) const;
 
+        /**
+         * Returns the heights and normals at many points at once.
+         *
+         * Each point is sampled as by getHeight, with its X as the column and its Y as the
+         * row. The normal at a point is that of the interpolated surface, with one unit
+         * between neighboring columns and rows. Four points are interpolated at a time where
+         * SIMD instructions are available.
+         *
+         * @param points The column and row of each point.
+         * @param count The number of points.
+         * @param heights The array receiving the height at each point.
+         * @param normals The array receiving the normal at each point, or NULL.
+         * @param parallel True to split large batches over the worker threads of the job scheduler.
+         * @script{ignore}
+         */
+        void sampleHeights(const Vector2* points, unsigned int count, float* heights, Vector3* normals = NULL, bool parallel = false) const;
+
         /**
          * Returns the number of rows in the heightfield.
          *
@@ -118,7 +256,7 @@ namespace gameplay
         /**
          * Hidden constructor.
          */
-        HeightField(unsigned int columns, unsigned int rows);
+        HeightField(unsigned int columns, unsigned int rows, Format format, float heightMin, float heightMax);
 
         /**
          * Hidden destructor (use Ref::release()).
@@ -128,9 +266,27 @@ namespace gameplay
         /**
          * Internal method for creating a HeightField.
          */
-        static HeightField* create(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax);
+        static HeightField* create(const char* path, unsigned int width, unsigned int height, float heightMin, float heightMax, Format format);
+
+        /**
+         * Returns the height stored at an index of the height array.
+         */
+        float getStoredHeight(unsigned int index) const;
+
+        /**
+         * Samples the heights and normals of a range of points.
+         */
+        void sampleRange(const Vector2* points, unsigned int start, unsigned int end, float* heights, Vector3* normals) const;
+
+        /**
+         * Samples a range of the points of a batch on a job thread.
+         */
+        static void sampleJob(unsigned int start, unsigned int end, void* cookie);
 
         float* _array;
+        short* _shortArray;
+        float _heightScale;
+        float _heightOffset;
         unsigned int _cols;
         unsigned int _rows;
     };
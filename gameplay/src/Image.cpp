@@ -1,9 +1,22 @@
 #include "Base.h"
 #include "FileSystem.h"
 #include "Image.h"
+#include "Game.h"
+#include "LoadProfiler.h"
 
 namespace gameplay
 {
+
+/**
+ * The images decoded by Image::createBatch.
+ */
+struct ImageBatch
+{
+    const char** paths;
+    void* pixels;
+    bool premultiplyAlpha;
+};
+
 // Callback for reading a png image using Stream
 static void readStream(png_structp png, png_bytep data, png_size_t length)
 {
@@ -14,16 +27,79 @@ static void readStream(png_structp png, png_bytep data, png_size_t length)
     }
 }
 
-Image* Image::create(const char* path)
+Image* Image::create(const char* path, bool premultiplyAlpha)
+{
+    GP_ASSERT(path);
+
+    LoadProfiler::Scope profile("image", path);
+    Pixels pixels;
+    {
+        LoadProfiler::Phase decodePhase(LoadProfiler::DECODE);
+        if (!decode(path, premultiplyAlpha, &pixels))
+            return NULL;
+    }
+    return create(pixels);
+}
+
+unsigned int Image::createBatch(const char** paths, unsigned int count, Image** images, bool premultiplyAlpha)
+{
+    GP_ASSERT(paths || count == 0);
+    GP_ASSERT(images || count == 0);
+
+    if (count == 0)
+        return 0;
+
+    // Each file is decoded on its own, the files of a batch usually differ a lot in size.
+    std::vector<Pixels> pixels(count);
+    ImageBatch batch;
+    batch.paths = paths;
+    batch.pixels = &pixels[0];
+    batch.premultiplyAlpha = premultiplyAlpha;
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    {
+        // The decode is timed as a whole, for the load that asked for the batch.
+        LoadProfiler::Phase decodePhase(LoadProfiler::DECODE);
+        if (scheduler)
+            scheduler->parallelFor(count, decodeRange, &batch, 1);
+        else
+            decodeRange(0, count, &batch);
+    }
+
+    // Images are reference counted, so they are only created on the calling thread.
+    unsigned int created = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        images[i] = pixels[i].data ? create(pixels[i]) : NULL;
+        if (images[i])
+            ++created;
+    }
+    return created;
+}
+
+void Image::decodeRange(unsigned int start, unsigned int end, void* cookie)
+{
+    ImageBatch* batch = (ImageBatch*)cookie;
+    GP_ASSERT(batch);
+
+    Pixels* pixels = (Pixels*)batch->pixels;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        if (!decode(batch->paths[i], batch->premultiplyAlpha, &pixels[i]))
+            pixels[i].data = NULL;
+    }
+}
+
+bool Image::decode(const char* path, bool premultiplyAlpha, Pixels* pixels)
 {
     GP_ASSERT(path);
+    GP_ASSERT(pixels);
 
     // Open the file.
     std::auto_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
     {
         GP_ERROR("Failed to open image file '%s'.", path);
-        return NULL;
+        return false;
     }
 
     // Verify PNG signature.
@@ -31,7 +107,7 @@ Image* Image::create(const char* path)
     if (stream->read(sig, 1, 8) != 8 || png_sig_cmp(sig, 0, 8) != 0)
     {
         GP_ERROR("Failed to load file '%s'; not a valid PNG.", path);
-        return NULL;
+        return false;
     }
 
     // Initialize png read struct (last three parameters use stderr+longjump if NULL).
@@ -39,7 +115,7 @@ Image* Image::create(const char* path)
     if (png == NULL)
     {
         GP_ERROR("Failed to create PNG structure for reading PNG file '%s'.", path);
-        return NULL;
+        return false;
     }
 
     // Initialize info struct.
@@ -48,15 +124,21 @@ Image* Image::create(const char* path)
     {
         GP_ERROR("Failed to create PNG info structure for PNG file '%s'.", path);
         png_destroy_read_struct(&png, NULL, NULL);
-        return NULL;
+        return false;
     }
 
+    // The rows are decoded straight into the image data, which is released if decoding fails.
+    unsigned char* volatile data = NULL;
+    png_bytep* volatile rows = NULL;
+
     // Set up error handling (required without using custom error handlers above).
     if (setjmp(png_jmpbuf(png)))
     {
-        GP_ERROR("Failed to set up error handling for reading PNG file '%s'.", path);
+        GP_ERROR("Failed to read PNG file '%s'.", path);
         png_destroy_read_struct(&png, &info, NULL);
-        return NULL;
+        delete[] data;
+        delete[] rows;
+        return false;
     }
 
     // Initialize file io.
@@ -65,45 +147,77 @@ Image* Image::create(const char* path)
     // Indicate that we already read the first 8 bytes (signature).
     png_set_sig_bytes(png, 8);
 
-    // Read the entire image into memory.
-    png_read_png(png, info, PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND, NULL);
-
-    Image* image = new Image();
-    image->_width = png_get_image_width(png, info);
-    image->_height = png_get_image_height(png, info);
-
+    // Decode every file to 8-bit RGB or RGBA.
+    png_read_info(png, info);
+    png_set_strip_16(png);
+    png_set_packing(png);
+    png_set_expand(png);
+    png_set_gray_to_rgb(png);
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    unsigned int width = png_get_image_width(png, info);
+    unsigned int height = png_get_image_height(png, info);
     png_byte colorType = png_get_color_type(png, info);
+    Format format;
     switch (colorType)
     {
     case PNG_COLOR_TYPE_RGBA:
-        image->_format = Image::RGBA;
+        format = Image::RGBA;
         break;
 
     case PNG_COLOR_TYPE_RGB:
-        image->_format = Image::RGB;
+        format = Image::RGB;
         break;
 
     default:
         GP_ERROR("Unsupported PNG color type (%d) for image file '%s'.", (int)colorType, path);
         png_destroy_read_struct(&png, &info, NULL);
-        return NULL;
+        return false;
     }
 
     size_t stride = png_get_rowbytes(png, info);
 
-    // Allocate image data.
-    image->_data = new unsigned char[stride * image->_height];
-
-    // Read rows into image data.
-    png_bytepp rows = png_get_rows(png, info);
-    for (unsigned int i = 0; i < image->_height; ++i)
+    // Allocate image data and read the whole image at once, bottom row first.
+    data = new unsigned char[stride * height];
+    rows = new png_bytep[height];
+    for (unsigned int i = 0; i < height; ++i)
     {
-        memcpy(image->_data+(stride * (image->_height-1-i)), rows[i], stride);
+        rows[i] = data + stride * (height - 1 - i);
     }
+    png_read_image(png, rows);
+    png_read_end(png, NULL);
 
     // Clean up.
     png_destroy_read_struct(&png, &info, NULL);
+    delete[] rows;
+
+    if (premultiplyAlpha && format == Image::RGBA)
+    {
+        unsigned char* pixel = data;
+        for (size_t i = 0, count = (size_t)width * height; i < count; ++i, pixel += 4)
+        {
+            unsigned int alpha = pixel[3];
+            pixel[0] = (unsigned char)((pixel[0] * alpha + 127) / 255);
+            pixel[1] = (unsigned char)((pixel[1] * alpha + 127) / 255);
+            pixel[2] = (unsigned char)((pixel[2] * alpha + 127) / 255);
+        }
+    }
 
+    pixels->data = data;
+    pixels->format = format;
+    pixels->width = width;
+    pixels->height = height;
+    return true;
+}
+
+Image* Image::create(const Pixels& pixels)
+{
+    Image* image = new Image();
+    image->_data = pixels.data;
+    image->_format = pixels.format;
+    image->_width = pixels.width;
+    image->_height = pixels.height;
     return image;
 }
 
@@ -26,10 +26,26 @@ public:
      * Creates an image from the image file at the given path.
      * 
      * @param path The path to the image file.
+     * @param premultiplyAlpha Whether to multiply the color channels of RGBA images by their alpha.
      * @return The newly created image.
      * @script{create}
      */
-    static Image* create(const char* path);
+    static Image* create(const char* path, bool premultiplyAlpha = false);
+
+    /**
+     * Creates images from the image files at the given paths.
+     *
+     * The files are read and decoded in parallel by the worker threads of the job
+     * scheduler, with the calling thread helping until all of them are done.
+     * 
+     * @param paths The paths to the image files.
+     * @param count The number of paths.
+     * @param images The array that receives the images, NULL for the files that failed to load.
+     * @param premultiplyAlpha Whether to multiply the color channels of RGBA images by their alpha.
+     * @return The number of images created.
+     * @script{ignore}
+     */
+    static unsigned int createBatch(const char** paths, unsigned int count, Image** images, bool premultiplyAlpha = false);
 
     /**
      * Gets the image's raw pixel data.
@@ -77,6 +93,29 @@ private:
      */
     Image& operator=(const Image&);
 
+    /**
+     * The pixels of a decoded image file.
+     */
+    struct Pixels
+    {
+        unsigned char* data;
+        Format format;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    /**
+     * Decodes an image file without creating an Image, so that it can run on any thread.
+     */
+    static bool decode(const char* path, bool premultiplyAlpha, Pixels* pixels);
+
+    /**
+     * Creates an image that takes ownership of the decoded pixels.
+     */
+    static Image* create(const Pixels& pixels);
+
+    static void decodeRange(unsigned int start, unsigned int end, void* cookie);
+
     unsigned char* _data;
     Format _format;
     unsigned int _height;
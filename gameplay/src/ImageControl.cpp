@@ -5,14 +5,19 @@ namespace gameplay
 {
 
 ImageControl::ImageControl() :
-    _srcRegion(Rectangle::empty()), _dstRegion(Rectangle::empty()), _batch(NULL),
-    _tw(0.0f), _th(0.0f), _uvs(Theme::UVs::full())
+    _srcRegion(Rectangle::empty()), _dstRegion(Rectangle::empty()), _batch(NULL), _atlas(false),
+    _imageRegion(Rectangle::empty()), _tw(0.0f), _th(0.0f), _uvs(Theme::UVs::full())
 {
+    // The image is drawn with another sprite batch, so it cannot be captured with the border.
+    _cacheGeometry = false;
 }
 
 ImageControl::~ImageControl()
 {
-    SAFE_DELETE(_batch);
+    if (!_atlas)
+    {
+        SAFE_DELETE(_batch);
+    }
 }
 
 ImageControl* ImageControl::create(const char* id, Theme::Style* style)
@@ -70,22 +75,52 @@ void ImageControl::initialize(Theme::Style* style, Properties* properties)
 
 void ImageControl::setImage(const char* path)
 {
-    SAFE_DELETE(_batch);
-    Texture* texture = Texture::create(path);
-    _batch = SpriteBatch::create(texture);
-    _tw = 1.0f / texture->getWidth();
-    _th = 1.0f / texture->getHeight();
-    texture->release();
+    if (!_atlas)
+    {
+        SAFE_DELETE(_batch);
+    }
+
+    // Images packed in the theme's atlas are drawn in the same batch as those of other image controls.
+    Theme* theme = _style ? _style->getTheme() : NULL;
+    _atlas = theme && theme->addAtlasImage(path, &_imageRegion);
+    if (_atlas)
+    {
+        _batch = theme->getAtlasBatch();
+        _tw = 1.0f / _batch->getSampler()->getTexture()->getWidth();
+        _th = 1.0f / _batch->getSampler()->getTexture()->getHeight();
+    }
+    else
+    {
+        Texture* texture = Texture::create(path);
+        _batch = SpriteBatch::create(texture);
+        _imageRegion.set(0, 0, texture->getWidth(), texture->getHeight());
+        _tw = 1.0f / texture->getWidth();
+        _th = 1.0f / texture->getHeight();
+        texture->release();
+    }
+    updateUVs();
+    _dirty = true;
 }
 
 void ImageControl::setRegionSrc(float x, float y, float width, float height)
 {
     _srcRegion.set(x, y, width, height);
+    updateUVs();
+}
+
+void ImageControl::updateUVs()
+{
+    // The whole image is drawn until a source region is set.
+    Rectangle region(_imageRegion);
+    if (!_srcRegion.isEmpty())
+    {
+        region.set(_imageRegion.x + _srcRegion.x, _imageRegion.y + _srcRegion.y, _srcRegion.width, _srcRegion.height);
+    }
 
-    _uvs.u1 = x * _tw;
-    _uvs.u2 = (x + width) * _tw;
-    _uvs.v1 = 1.0f - (y * _th);
-    _uvs.v2 = 1.0f - ((y + height) * _th);
+    _uvs.u1 = region.x * _tw;
+    _uvs.u2 = (region.x + region.width) * _tw;
+    _uvs.v1 = 1.0f - (region.y * _th);
+    _uvs.v2 = 1.0f - ((region.y + region.height) * _th);
 }
 
 void ImageControl::setRegionSrc(const Rectangle& region)
@@ -120,29 +155,49 @@ const char* ImageControl::getType() const
 
 void ImageControl::drawImages(SpriteBatch* spriteBatch, const Rectangle& clip)
 {
+    if (_batch == NULL)
+        return;
+
+    Vector4 color = Vector4::one();
+    color.w *= _opacity;
+
+    // While the form is drawn in one batch, packed images go to the atlas batch of the theme
+    // and the others are drawn right away, after everything collected before them.
+    Theme* theme = getBatchTheme();
+    if (theme && _atlas)
+    {
+        theme->prepareBatch(Theme::BATCH_IMAGES, _viewportClipBounds);
+        drawImage(_batch, color);
+        return;
+    }
+    if (theme)
+        theme->flushBatch();
+
     spriteBatch->finish();
 
     // An ImageControl is not part of the texture atlas but should use the same projection matrix.
     _batch->setProjectionMatrix(spriteBatch->getProjectionMatrix());
 
-    Vector4 color = Vector4::one();
-    color.w *= _opacity;
-
     _batch->start();
+    drawImage(_batch, color);
+    _batch->finish();
+
+    spriteBatch->start();
+}
+
+void ImageControl::drawImage(SpriteBatch* batch, const Vector4& color)
+{
     if (_dstRegion.isEmpty())
     {
-        _batch->draw(_viewportBounds.x, _viewportBounds.y, _viewportBounds.width, _viewportBounds.height,
+        batch->draw(_viewportBounds.x, _viewportBounds.y, _viewportBounds.width, _viewportBounds.height,
             _uvs.u1, _uvs.v1, _uvs.u2, _uvs.v2, color, _viewportClipBounds);
     }
     else
     {
-        _batch->draw(_viewportBounds.x + _dstRegion.x, _viewportBounds.y + _dstRegion.y,
+        batch->draw(_viewportBounds.x + _dstRegion.x, _viewportBounds.y + _dstRegion.y,
             _dstRegion.width, _dstRegion.height,
             _uvs.u1, _uvs.v1, _uvs.u2, _uvs.v2, color, _viewportClipBounds);
     }
-    _batch->finish();
-
-    spriteBatch->start();
 }
 
 }
\ No newline at end of file
@@ -123,11 +123,27 @@ protected:
 
     void drawImages(SpriteBatch* spriteBatch, const Rectangle& clip);
 
+    /**
+     * Computes the UVs of the source region within the texture the image is drawn from.
+     */
+    void updateUVs();
+
+    /**
+     * Adds the image to a sprite batch.
+     */
+    void drawImage(SpriteBatch* batch, const Vector4& color);
+
     // Source region.
     Rectangle _srcRegion;
     // Destination region.
     Rectangle _dstRegion;
     SpriteBatch* _batch;
+
+    // Whether the image is packed in the atlas of the theme, which then owns the batch.
+    bool _atlas;
+
+    // Region of the image in the texture it is drawn from.
+    Rectangle _imageRegion;
     
     // One over texture width and height, for use when calculating UVs from a new source region.
     float _tw;
@@ -0,0 +1,212 @@
+#include "Base.h"
+#include "InputQueue.h"
+#include "Game.h"
+#include "Platform.h"
+
+namespace gameplay
+{
+
+InputQueue::InputQueue()
+    : _enabled(false), _dispatching(false), _pendingCoalescedCount(0), _eventCount(0), _coalescedCount(0), _averageLatency(0.0f), _maxLatency(0.0f)
+{
+}
+
+InputQueue::~InputQueue()
+{
+}
+
+void InputQueue::initialize(Properties* properties)
+{
+    if (properties)
+        _enabled = properties->getBool("queue");
+}
+
+void InputQueue::finalize()
+{
+    _events.clear();
+    _enabled = false;
+}
+
+bool InputQueue::isEnabled() const
+{
+    return _enabled;
+}
+
+void InputQueue::setEnabled(bool enabled)
+{
+    if (_enabled && !enabled && !_dispatching)
+        dispatch();
+    _enabled = enabled;
+}
+
+unsigned int InputQueue::getEventCount() const
+{
+    return _eventCount;
+}
+
+unsigned int InputQueue::getCoalescedCount() const
+{
+    return _coalescedCount;
+}
+
+float InputQueue::getAverageLatency() const
+{
+    return _averageLatency;
+}
+
+float InputQueue::getMaxLatency() const
+{
+    return _maxLatency;
+}
+
+bool InputQueue::isQueuing() const
+{
+    // Events that the handlers raise while the queue is dispatched go straight through.
+    return _enabled && !_dispatching;
+}
+
+void InputQueue::pushKeyEvent(Keyboard::KeyEvent evt, int key)
+{
+    Event event;
+    event.type = KEY;
+    event.event = evt;
+    event.x = 0;
+    event.y = 0;
+    event.param = key;
+    event.scale = 0.0f;
+    event.actuallyMouse = false;
+    push(event);
+}
+
+void InputQueue::pushTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
+{
+    Event event;
+    event.type = TOUCH;
+    event.event = evt;
+    event.x = x;
+    event.y = y;
+    event.param = (int)contactIndex;
+    event.scale = 0.0f;
+    event.actuallyMouse = actuallyMouse;
+    push(event);
+}
+
+void InputQueue::pushMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
+{
+    Event event;
+    event.type = MOUSE;
+    event.event = evt;
+    event.x = x;
+    event.y = y;
+    event.param = wheelDelta;
+    event.scale = 0.0f;
+    event.actuallyMouse = false;
+    push(event);
+}
+
+void InputQueue::pushGestureEvent(Type type, int x, int y, int direction, float scale)
+{
+    Event event;
+    event.type = type;
+    event.event = 0;
+    event.x = x;
+    event.y = y;
+    event.param = direction;
+    event.scale = scale;
+    event.actuallyMouse = false;
+    push(event);
+}
+
+bool InputQueue::isMotion(const Event& event)
+{
+    return (event.type == MOUSE && (event.event == Mouse::MOUSE_MOVE || event.event == Mouse::MOUSE_WHEEL)) ||
+        (event.type == TOUCH && event.event == Touch::TOUCH_MOVE);
+}
+
+void InputQueue::push(const Event& event)
+{
+    // Merge a motion event into the last one of the same pointer, as long as only
+    // motion events came after it. The merged event keeps the time of the first one,
+    // so the latency counts from the oldest motion it stands for.
+    if (isMotion(event))
+    {
+        for (size_t i = _events.size(); i-- > 0;)
+        {
+            Event& queued = _events[i];
+            if (!isMotion(queued))
+                break;
+            if (queued.type != event.type || queued.event != event.event || queued.actuallyMouse != event.actuallyMouse)
+                continue;
+
+            if (event.type == MOUSE && event.event == Mouse::MOUSE_WHEEL)
+                queued.param += event.param;
+            else if (queued.param != event.param)
+                continue;
+            queued.x = event.x;
+            queued.y = event.y;
+            ++_pendingCoalescedCount;
+            return;
+        }
+    }
+
+    _events.push_back(event);
+    _events.back().time = Game::getAbsoluteTime();
+}
+
+void InputQueue::dispatch()
+{
+    // The counts of the frame include the events merged since the last dispatch.
+    _coalescedCount = _pendingCoalescedCount;
+    _pendingCoalescedCount = 0;
+    _eventCount = (unsigned int)_events.size();
+    _averageLatency = 0.0f;
+    _maxLatency = 0.0f;
+    if (_events.empty())
+        return;
+
+    // Handlers may queue events of their own, so the queue is swapped out first.
+    _dispatched.swap(_events);
+    _dispatching = true;
+
+    double now = Game::getAbsoluteTime();
+    double totalLatency = 0.0;
+    bool mouseConsumed = false;
+    for (size_t i = 0; i < _dispatched.size(); ++i)
+    {
+        const Event& event = _dispatched[i];
+        float latency = (float)(now - event.time);
+        totalLatency += latency;
+        _maxLatency = std::max(_maxLatency, latency);
+
+        switch (event.type)
+        {
+        case KEY:
+            Platform::keyEventInternal((Keyboard::KeyEvent)event.event, event.param);
+            break;
+        case TOUCH:
+            // The touch event the platform sends for a mouse event only goes out if the mouse event was not consumed.
+            if (!event.actuallyMouse || !mouseConsumed)
+                Platform::touchEventInternal((Touch::TouchEvent)event.event, event.x, event.y, (unsigned int)event.param, event.actuallyMouse);
+            break;
+        case MOUSE:
+            mouseConsumed = Platform::mouseEventInternal((Mouse::MouseEvent)event.event, event.x, event.y, event.param);
+            continue;
+        case GESTURE_SWIPE:
+            Platform::gestureSwipeEventInternal(event.x, event.y, event.param);
+            break;
+        case GESTURE_PINCH:
+            Platform::gesturePinchEventInternal(event.x, event.y, event.scale);
+            break;
+        case GESTURE_TAP:
+            Platform::gestureTapEventInternal(event.x, event.y);
+            break;
+        }
+        mouseConsumed = false;
+    }
+    _averageLatency = (float)(totalLatency / _dispatched.size());
+
+    _dispatching = false;
+    _dispatched.clear();
+}
+
+}
@@ -0,0 +1,208 @@
+#ifndef INPUTQUEUE_H_
+#define INPUTQUEUE_H_
+
+#include "Keyboard.h"
+#include "Mouse.h"
+#include "Touch.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a queue that gathers the input events of the platform and dispatches them
+ * once per frame, at the start of Game::frame, instead of as each OS event arrives.
+ *
+ * Key, touch, mouse and gesture events are stamped with the time they were received
+ * and kept in order. Motion events (mouse moves, mouse wheel turns and touch moves of
+ * the same contact) that arrive with only other motion events after them are merged
+ * into the last one, so a frame dispatches one move per pointer however many the OS
+ * sent, and forms hit-test each pointer once per frame.
+ *
+ * While events are queued, the platform cannot know if the game consumes a mouse event,
+ * so it also reports the touch event it would send for an unconsumed mouse event. That
+ * touch event is dispatched only if the mouse event before it was not consumed.
+ *
+ * The queue measures the latency of the events it dispatches, from the time they were
+ * received to the time they are dispatched.
+ *
+ * The queue is configured in the game config:
+ *
+ * @verbatim
+    input
+    {
+        queue = true            // Gather the input events and dispatch them once per frame (default false).
+    }
+   @endverbatim
+ *
+ * The same namespace configures the recording and replay of the input (see InputRecorder).
+ *
+ * @script{ignore}
+ */
+class InputQueue
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Determines if input events are gathered and dispatched once per frame.
+     *
+     * @return True if the events are queued, false if they are dispatched as they arrive.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Sets whether input events are gathered and dispatched once per frame.
+     *
+     * Disabling the queue dispatches the events it holds.
+     *
+     * @param enabled True to queue the events, false to dispatch them as they arrive.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Gets the number of input events dispatched during the last frame.
+     *
+     * @return The number of events.
+     */
+    unsigned int getEventCount() const;
+
+    /**
+     * Gets the number of motion events merged into others during the last frame.
+     *
+     * @return The number of merged events.
+     */
+    unsigned int getCoalescedCount() const;
+
+    /**
+     * Gets the average latency of the input events dispatched during the last frame.
+     *
+     * @return The average time between receiving and dispatching an event, in milliseconds.
+     */
+    float getAverageLatency() const;
+
+    /**
+     * Gets the largest latency of the input events dispatched during the last frame.
+     *
+     * @return The longest time between receiving and dispatching an event, in milliseconds.
+     */
+    float getMaxLatency() const;
+
+private:
+
+    /**
+     * The kinds of queued events.
+     */
+    enum Type
+    {
+        KEY,
+        TOUCH,
+        MOUSE,
+        GESTURE_SWIPE,
+        GESTURE_PINCH,
+        GESTURE_TAP
+    };
+
+    /**
+     * A queued event.
+     */
+    struct Event
+    {
+        double time;
+        Type type;
+        int event;
+        int x;
+        int y;
+        int param;
+        float scale;
+        bool actuallyMouse;
+    };
+
+    /**
+     * Constructor.
+     */
+    InputQueue();
+
+    /**
+     * Destructor.
+     */
+    ~InputQueue();
+
+    /**
+     * Hidden copy constructor.
+     */
+    InputQueue(const InputQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    InputQueue& operator=(const InputQueue&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'input' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    void finalize();
+
+    /**
+     * Determines if the platform should queue the events it receives now.
+     */
+    bool isQueuing() const;
+
+    /**
+     * Called by the platform to queue a key event.
+     */
+    void pushKeyEvent(Keyboard::KeyEvent evt, int key);
+
+    /**
+     * Called by the platform to queue a touch event.
+     */
+    void pushTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse);
+
+    /**
+     * Called by the platform to queue a mouse event.
+     */
+    void pushMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
+
+    /**
+     * Called by the platform to queue a gesture event.
+     */
+    void pushGestureEvent(Type type, int x, int y, int direction, float scale);
+
+    /**
+     * Determines if an event only moves a pointer, and can be merged into a later one.
+     */
+    static bool isMotion(const Event& event);
+
+    /**
+     * Queues an event, or merges it into a queued motion event.
+     */
+    void push(const Event& event);
+
+    /**
+     * Called by the game once per frame to dispatch the queued events.
+     */
+    void dispatch();
+
+    bool _enabled;
+    bool _dispatching;
+    std::vector<Event> _events;
+    std::vector<Event> _dispatched;
+    unsigned int _pendingCoalescedCount;
+    unsigned int _eventCount;
+    unsigned int _coalescedCount;
+    float _averageLatency;
+    float _maxLatency;
+};
+
+}
+
+#endif
@@ -0,0 +1,408 @@
+#include "Base.h"
+#include "InputRecorder.h"
+#include "FileSystem.h"
+#include "Game.h"
+#include "Platform.h"
+
+// The version of the file format, written after the magic number.
+#define INPUT_RECORDING_VERSION 1
+
+namespace gameplay
+{
+
+static const char __magic[4] = { 'G', 'P', 'I', 'R' };
+
+InputRecorder::InputRecorder()
+    : _file(NULL), _data(NULL), _size(0), _cursor(0), _replaying(false), _replayExit(true), _injecting(false), _queueEnabled(false),
+      _elapsedTime(0.0f), _frameCount(0)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    finalize();
+}
+
+void InputRecorder::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    if (properties->exists("replayExit"))
+        _replayExit = properties->getBool("replayExit");
+
+    const char* replay = properties->getString("replay");
+    const char* record = properties->getString("record");
+    if (replay && replay[0] != '\0')
+    {
+        if (record && record[0] != '\0')
+            GP_WARN("Input is replayed from '%s' and not recorded to '%s'.", replay, record);
+        startReplay(replay);
+    }
+    else if (record && record[0] != '\0')
+    {
+        startRecording(record);
+    }
+}
+
+void InputRecorder::finalize()
+{
+    if (_file)
+    {
+        if (!_buffer.empty())
+            fwrite(&_buffer[0], 1, _buffer.size(), _file);
+        fclose(_file);
+        _file = NULL;
+    }
+    _buffer.clear();
+    SAFE_DELETE_ARRAY(_data);
+    _size = 0;
+    _cursor = 0;
+    _replaying = false;
+}
+
+bool InputRecorder::isRecording() const
+{
+    return _file != NULL;
+}
+
+bool InputRecorder::isReplaying() const
+{
+    return _replaying;
+}
+
+unsigned int InputRecorder::getFrameCount() const
+{
+    return _frameCount;
+}
+
+bool InputRecorder::startReplay(const char* path)
+{
+    GP_ASSERT(path);
+
+    int size = 0;
+    _data = FileSystem::readAll(path, &size);
+    if (_data == NULL)
+    {
+        GP_WARN("Failed to read input recording '%s'.", path);
+        return false;
+    }
+    _size = (size_t)size;
+    _cursor = 0;
+
+    char magic[4];
+    unsigned int version = 0;
+    unsigned int seed = 0;
+    if (!read(magic, sizeof(magic)) || memcmp(magic, __magic, sizeof(magic)) != 0 ||
+        !read(&version, sizeof(version)) || version != INPUT_RECORDING_VERSION || !read(&seed, sizeof(seed)))
+    {
+        GP_WARN("Invalid input recording '%s'.", path);
+        SAFE_DELETE_ARRAY(_data);
+        return false;
+    }
+
+    // The queued events were merged before they were recorded, so the replay hands them over as they are.
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    _queueEnabled = inputQueue && inputQueue->isEnabled();
+    if (_queueEnabled)
+        inputQueue->setEnabled(false);
+
+    srand(seed);
+    _replayPath = path;
+    _replaying = true;
+    _frameCount = 0;
+    return true;
+}
+
+bool InputRecorder::startRecording(const char* path)
+{
+    GP_ASSERT(path);
+
+    _file = FileSystem::openFile(path, "wb");
+    if (_file == NULL)
+    {
+        GP_WARN("Failed to create input recording '%s'.", path);
+        return false;
+    }
+
+    unsigned int version = INPUT_RECORDING_VERSION;
+    unsigned int seed = (unsigned int)time(NULL);
+    write(__magic, sizeof(__magic));
+    write(&version, sizeof(version));
+    write(&seed, sizeof(seed));
+    srand(seed);
+    _frameCount = 0;
+    return true;
+}
+
+void InputRecorder::stopReplay()
+{
+    SAFE_DELETE_ARRAY(_data);
+    _size = 0;
+    _cursor = 0;
+    _replaying = false;
+
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (_queueEnabled && inputQueue)
+        inputQueue->setEnabled(true);
+}
+
+bool InputRecorder::isLive() const
+{
+    // While replaying, only the replayed events reach the game.
+    return !_replaying || _injecting;
+}
+
+bool InputRecorder::passKeyEvent(Keyboard::KeyEvent evt, int key)
+{
+    if (_file)
+    {
+        unsigned char header[2] = { KEY, (unsigned char)evt };
+        write(header, sizeof(header));
+        write(&key, sizeof(key));
+    }
+    return isLive();
+}
+
+bool InputRecorder::passTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
+{
+    if (_file)
+    {
+        unsigned char header[3] = { TOUCH, (unsigned char)evt, (unsigned char)actuallyMouse };
+        write(header, sizeof(header));
+        write(&x, sizeof(x));
+        write(&y, sizeof(y));
+        write(&contactIndex, sizeof(contactIndex));
+    }
+    return isLive();
+}
+
+bool InputRecorder::passMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
+{
+    if (_file)
+    {
+        unsigned char header[2] = { MOUSE, (unsigned char)evt };
+        write(header, sizeof(header));
+        write(&x, sizeof(x));
+        write(&y, sizeof(y));
+        write(&wheelDelta, sizeof(wheelDelta));
+    }
+    return isLive();
+}
+
+bool InputRecorder::passGestureEvent(Type type, int x, int y, int direction, float scale)
+{
+    if (_file)
+    {
+        unsigned char header = (unsigned char)type;
+        write(&header, sizeof(header));
+        write(&x, sizeof(x));
+        write(&y, sizeof(y));
+        if (type == GESTURE_SWIPE)
+            write(&direction, sizeof(direction));
+        else if (type == GESTURE_PINCH)
+            write(&scale, sizeof(scale));
+    }
+    return isLive();
+}
+
+bool InputRecorder::passGamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
+{
+    GP_ASSERT(gamepad);
+
+    // Virtual gamepads are driven by the touches, which are recorded and replayed themselves.
+    if (gamepad->isVirtual())
+        return true;
+
+    if (_file)
+    {
+        unsigned int index = 0;
+        for (unsigned int count = Gamepad::getGamepadCount(); index < count; ++index)
+        {
+            if (Gamepad::getGamepad(index, false) == gamepad)
+                break;
+        }
+
+        unsigned char header[4] = { GAMEPAD, (unsigned char)evt, (unsigned char)index, (unsigned char)analogIndex };
+        write(header, sizeof(header));
+        switch (evt)
+        {
+        case Gamepad::BUTTON_EVENT:
+            write(&gamepad->_buttons, sizeof(gamepad->_buttons));
+            break;
+        case Gamepad::JOYSTICK_EVENT:
+            write(&gamepad->_joysticks[analogIndex].x, sizeof(float));
+            write(&gamepad->_joysticks[analogIndex].y, sizeof(float));
+            break;
+        case Gamepad::TRIGGER_EVENT:
+            write(&gamepad->_triggers[analogIndex], sizeof(float));
+            break;
+        default:
+            break;
+        }
+    }
+    return isLive();
+}
+
+void InputRecorder::beginFrame()
+{
+    _elapsedTime = 0.0f;
+    if (!_replaying)
+        return;
+
+    // Hand over the events of the frame, up to the record of its elapsed time.
+    _injecting = true;
+    unsigned char type;
+    bool frame = false;
+    while (read(&type, sizeof(type)))
+    {
+        if (type == FRAME)
+        {
+            frame = read(&_elapsedTime, sizeof(_elapsedTime));
+            break;
+        }
+        replayEvent(type);
+        if (!_replaying)
+            break;
+    }
+    _injecting = false;
+
+    if (frame)
+    {
+        ++_frameCount;
+        return;
+    }
+
+    if (_replaying)
+    {
+        print("Input replay of '%s' finished after %u frames.\n", _replayPath.c_str(), _frameCount);
+        stopReplay();
+        if (_replayExit)
+            Game::getInstance()->exit();
+    }
+}
+
+void InputRecorder::replayEvent(unsigned char type)
+{
+    unsigned char header[3];
+    int x, y, param;
+    float values[2];
+    bool valid = true;
+    switch (type)
+    {
+    case KEY:
+        valid = read(header, 1) && read(&param, sizeof(param));
+        if (valid)
+            Platform::keyEventInternal((Keyboard::KeyEvent)header[0], param);
+        break;
+    case TOUCH:
+        valid = read(header, 2) && read(&x, sizeof(x)) && read(&y, sizeof(y)) && read(&param, sizeof(param));
+        if (valid)
+            Platform::touchEventInternal((Touch::TouchEvent)header[0], x, y, (unsigned int)param, header[1] != 0);
+        break;
+    case MOUSE:
+        valid = read(header, 1) && read(&x, sizeof(x)) && read(&y, sizeof(y)) && read(&param, sizeof(param));
+        if (valid)
+            Platform::mouseEventInternal((Mouse::MouseEvent)header[0], x, y, param);
+        break;
+    case GESTURE_SWIPE:
+        valid = read(&x, sizeof(x)) && read(&y, sizeof(y)) && read(&param, sizeof(param));
+        if (valid)
+            Platform::gestureSwipeEventInternal(x, y, param);
+        break;
+    case GESTURE_PINCH:
+        valid = read(&x, sizeof(x)) && read(&y, sizeof(y)) && read(&values[0], sizeof(float));
+        if (valid)
+            Platform::gesturePinchEventInternal(x, y, values[0]);
+        break;
+    case GESTURE_TAP:
+        valid = read(&x, sizeof(x)) && read(&y, sizeof(y));
+        if (valid)
+            Platform::gestureTapEventInternal(x, y);
+        break;
+    case GAMEPAD:
+    {
+        valid = read(header, 3);
+        if (!valid)
+            break;
+        Gamepad::GamepadEvent evt = (Gamepad::GamepadEvent)header[0];
+        unsigned int analogIndex = std::min((unsigned int)header[2], 1u);
+        Gamepad* gamepad = Gamepad::getGamepad(header[1], false);
+        switch (evt)
+        {
+        case Gamepad::BUTTON_EVENT:
+            valid = read(&param, sizeof(param));
+            if (valid && gamepad)
+                gamepad->setButtons((unsigned int)param);
+            break;
+        case Gamepad::JOYSTICK_EVENT:
+            valid = read(values, sizeof(values));
+            if (valid && gamepad)
+                gamepad->setJoystickValue(analogIndex, values[0], values[1]);
+            break;
+        case Gamepad::TRIGGER_EVENT:
+            valid = read(&values[0], sizeof(float));
+            if (valid && gamepad)
+                gamepad->setTriggerValue(analogIndex, values[0]);
+            break;
+        default:
+            if (gamepad)
+                Platform::gamepadEventInternal(evt, gamepad, analogIndex);
+            break;
+        }
+        break;
+    }
+    default:
+        valid = false;
+        break;
+    }
+
+    if (!valid)
+    {
+        GP_WARN("Input recording '%s' is corrupt after %u frames.", _replayPath.c_str(), _frameCount);
+        _cursor = _size;
+    }
+}
+
+float InputRecorder::lockElapsedTime(float elapsedTime)
+{
+    if (_replaying)
+        return _elapsedTime;
+
+    _elapsedTime = elapsedTime;
+    return elapsedTime;
+}
+
+void InputRecorder::endFrame()
+{
+    if (_file == NULL)
+        return;
+
+    // The events of a frame are written along with its elapsed time, in one write.
+    unsigned char type = FRAME;
+    write(&type, sizeof(type));
+    write(&_elapsedTime, sizeof(_elapsedTime));
+    fwrite(&_buffer[0], 1, _buffer.size(), _file);
+    _buffer.clear();
+    ++_frameCount;
+}
+
+void InputRecorder::write(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    _buffer.insert(_buffer.end(), bytes, bytes + size);
+}
+
+bool InputRecorder::read(void* data, size_t size)
+{
+    if (_cursor + size > _size)
+    {
+        _cursor = _size;
+        return false;
+    }
+    memcpy(data, _data + _cursor, size);
+    _cursor += size;
+    return true;
+}
+
+}
@@ -0,0 +1,221 @@
+#ifndef INPUTRECORDER_H_
+#define INPUTRECORDER_H_
+
+#include "Keyboard.h"
+#include "Mouse.h"
+#include "Touch.h"
+#include "Gamepad.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a recorder that writes the input of a game run to a file, and replays it so that
+ * the run can be repeated frame for frame, for profiling and regression benchmarks.
+ *
+ * While recording, the key, touch, mouse, gesture and gamepad events that reach the game
+ * are written as they are handled, along with the elapsed time of each frame. When the
+ * input queue is enabled, the events are recorded as it dispatches them, after their
+ * motion events have been merged.
+ *
+ * While replaying, the events of each recorded frame are handed to the game at the point
+ * of the frame where the input queue dispatches, and the frame is advanced by the recorded
+ * elapsed time instead of the time measured. The input of the platform is ignored, the
+ * input queue is disabled and the physical gamepads are not polled, so the game sees the
+ * same input in the same frames on every run. The state of the physical gamepads is
+ * restored from their recorded events; virtual gamepads follow the replayed touches. The
+ * recorder seeds rand() with the seed of the recording on both runs.
+ *
+ * A replay only repeats the run if the game is started the same way: with the same config,
+ * window size and gamepads. Code that reads the clock itself (Game::getGameTime, timers
+ * scheduled with Game::schedule) is not replayed.
+ *
+ * The recording is a compact binary file: a header with the version of the format and the
+ * seed, followed by the events of each frame and a record of the frame's elapsed time. Values
+ * are written in the byte order of the machine that recorded them.
+ *
+ * The recorder is configured in the game config:
+ *
+ * @verbatim
+    input
+    {
+        record = run.input      // File to record the input and frame times to.
+        replay = run.input      // File to replay the input and frame times from (takes precedence over record).
+        replayExit = true       // Exit the game when the replay ends, rather than returning to live input (default true).
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class InputRecorder
+{
+    friend class Game;
+    friend class Platform;
+
+public:
+
+    /**
+     * Determines if the input of the game is being recorded.
+     *
+     * @return True if the input is recorded.
+     */
+    bool isRecording() const;
+
+    /**
+     * Determines if a recording is being replayed.
+     *
+     * @return True if the input comes from a recording.
+     */
+    bool isReplaying() const;
+
+    /**
+     * Gets the number of frames recorded or replayed so far.
+     *
+     * @return The number of frames.
+     */
+    unsigned int getFrameCount() const;
+
+private:
+
+    /**
+     * The kinds of records of the file.
+     */
+    enum Type
+    {
+        KEY,
+        TOUCH,
+        MOUSE,
+        GESTURE_SWIPE,
+        GESTURE_PINCH,
+        GESTURE_TAP,
+        GAMEPAD,
+        FRAME
+    };
+
+    /**
+     * Constructor.
+     */
+    InputRecorder();
+
+    /**
+     * Destructor.
+     */
+    ~InputRecorder();
+
+    /**
+     * Hidden copy constructor.
+     */
+    InputRecorder(const InputRecorder& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    InputRecorder& operator=(const InputRecorder&);
+
+    /**
+     * Called during startup to read the configuration and open the recording.
+     *
+     * @param properties The 'input' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to close the recording.
+     */
+    void finalize();
+
+    /**
+     * Opens a recording to replay.
+     */
+    bool startReplay(const char* path);
+
+    /**
+     * Creates a recording.
+     */
+    bool startRecording(const char* path);
+
+    /**
+     * Stops replaying and returns to the input of the platform.
+     */
+    void stopReplay();
+
+    /**
+     * Called by the platform before a key event reaches the game.
+     *
+     * @return False if the event must be dropped.
+     */
+    bool passKeyEvent(Keyboard::KeyEvent evt, int key);
+
+    /**
+     * Called by the platform before a touch event reaches the game.
+     *
+     * @return False if the event must be dropped.
+     */
+    bool passTouchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse);
+
+    /**
+     * Called by the platform before a mouse event reaches the game.
+     *
+     * @return False if the event must be dropped.
+     */
+    bool passMouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
+
+    /**
+     * Called by the platform before a gesture event reaches the game.
+     *
+     * @return False if the event must be dropped.
+     */
+    bool passGestureEvent(Type type, int x, int y, int direction, float scale);
+
+    /**
+     * Called by the platform before a gamepad event reaches the game.
+     *
+     * @return False if the event must be dropped.
+     */
+    bool passGamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex);
+
+    /**
+     * Called by the game at the point of the frame where input is dispatched, to replay
+     * the events of the next recorded frame.
+     */
+    void beginFrame();
+
+    /**
+     * Called by the game with the elapsed time of a running frame.
+     *
+     * @return The recorded elapsed time while replaying, the given one otherwise.
+     */
+    float lockElapsedTime(float elapsedTime);
+
+    /**
+     * Called by the game at the end of a frame to write the events and the elapsed time of the frame.
+     */
+    void endFrame();
+
+    /**
+     * Determines if an event from the platform reaches the game.
+     */
+    bool isLive() const;
+
+    void write(const void* data, size_t size);
+    bool read(void* data, size_t size);
+    void replayEvent(unsigned char type);
+
+    FILE* _file;
+    std::vector<unsigned char> _buffer;
+    char* _data;
+    size_t _size;
+    size_t _cursor;
+    std::string _replayPath;
+    bool _replaying;
+    bool _replayExit;
+    bool _injecting;
+    bool _queueEnabled;
+    float _elapsedTime;
+    unsigned int _frameCount;
+};
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include "Base.h"
+#include "InstanceBuffer.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "VertexAttributeBinding.h"
+#include "Mesh.h"
+#include "Effect.h"
+#include "RenderStats.h"
+#include "Allocator.h"
+
+namespace gameplay
+{
+
+InstanceBuffer::InstanceBuffer(const VertexFormat& instanceFormat)
+    : _instanceFormat(instanceFormat), _capacity(0), _instanceCount(0), _dynamic(false), _instanceData(NULL), _vertexBuffer(0)
+{
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    for (size_t i = 0, count = _bindings.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_bindings[i]);
+    }
+    _bindings.clear();
+
+    SAFE_DELETE_ARRAY(_instanceData);
+
+    if (_vertexBuffer)
+    {
+        StateCache::deleteBuffers(1, &_vertexBuffer);
+        _vertexBuffer = 0;
+        Allocator::untrack(Allocator::BUFFER, _instanceFormat.getVertexSize() * _capacity);
+    }
+}
+
+InstanceBuffer* InstanceBuffer::create(const VertexFormat& instanceFormat, unsigned int capacity, bool dynamic)
+{
+    for (unsigned int i = 0, count = instanceFormat.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& e = instanceFormat.getElement(i);
+        if (e.usage != VertexFormat::INSTANCE_MATRIX && e.usage != VertexFormat::INSTANCE_DATA)
+        {
+            GP_ERROR("Unsupported usage '%s' in instance format; only INSTANCE_MATRIX and INSTANCE_DATA are allowed.", VertexFormat::toString(e.usage));
+            return NULL;
+        }
+        if ((e.usage == VertexFormat::INSTANCE_MATRIX && e.size != 16) || (e.usage == VertexFormat::INSTANCE_DATA && (e.size == 0 || e.size > 4)))
+        {
+            GP_ERROR("Invalid size (%u) for instance element '%s'.", e.size, VertexFormat::toString(e.usage));
+            return NULL;
+        }
+    }
+
+    InstanceBuffer* buffer = new InstanceBuffer(instanceFormat);
+    buffer->_capacity = capacity;
+    buffer->_dynamic = dynamic;
+
+    unsigned int size = instanceFormat.getVertexSize() * capacity;
+    buffer->_instanceData = new float[size / sizeof(float)];
+    memset(buffer->_instanceData, 0, size);
+
+    if (isHardwareInstancingSupported())
+    {
+        GL_ASSERT( glGenBuffers(1, &buffer->_vertexBuffer) );
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, buffer->_vertexBuffer);
+        GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, size, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+        Allocator::track(Allocator::BUFFER, size);
+    }
+
+    return buffer;
+}
+
+bool InstanceBuffer::isHardwareInstancingSupported()
+{
+#ifdef USE_INSTANCED_ARRAYS
+    return glDrawElementsInstanced && glDrawArraysInstanced && glVertexAttribDivisor;
+#else
+    return false;
+#endif
+}
+
+const VertexFormat& InstanceBuffer::getInstanceFormat() const
+{
+    return _instanceFormat;
+}
+
+unsigned int InstanceBuffer::getCapacity() const
+{
+    return _capacity;
+}
+
+unsigned int InstanceBuffer::getInstanceCount() const
+{
+    return _instanceCount;
+}
+
+void InstanceBuffer::setInstanceCount(unsigned int count)
+{
+    _instanceCount = std::min(count, _capacity);
+}
+
+void InstanceBuffer::setInstanceData(const float* instanceData, unsigned int instanceStart, unsigned int instanceCount)
+{
+    GP_ASSERT(instanceData);
+
+    if (instanceStart >= _capacity)
+        return;
+    if (instanceStart + instanceCount > _capacity)
+    {
+        GP_WARN("Instance data exceeds the capacity of the instance buffer (%u); extra instances are ignored.", _capacity);
+        instanceCount = _capacity - instanceStart;
+    }
+
+    unsigned int instanceSize = _instanceFormat.getVertexSize();
+    memcpy((unsigned char*)_instanceData + instanceStart * instanceSize, instanceData, instanceCount * instanceSize);
+
+    if (_vertexBuffer)
+    {
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
+        if (instanceStart == 0 && instanceCount == _capacity)
+        {
+            // Orphan the old storage so the driver does not stall on instances still being drawn.
+            RenderCommandList::bufferData(GL_ARRAY_BUFFER, instanceCount * instanceSize, instanceData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        }
+        else
+        {
+            RenderCommandList::bufferSubData(GL_ARRAY_BUFFER, instanceStart * instanceSize, instanceCount * instanceSize, instanceData);
+        }
+        RenderStats::addUpload(instanceCount * instanceSize);
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    _instanceCount = std::max(_instanceCount, instanceStart + instanceCount);
+}
+
+const float* InstanceBuffer::getInstanceData() const
+{
+    return _instanceData;
+}
+
+VertexBufferHandle InstanceBuffer::getVertexBuffer() const
+{
+    return _vertexBuffer;
+}
+
+VertexAttributeBinding* InstanceBuffer::getVertexAttributeBinding(Mesh* mesh, Effect* effect)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(effect);
+
+    for (size_t i = 0, count = _bindings.size(); i < count; ++i)
+    {
+        VertexAttributeBinding* b = _bindings[i];
+        if (b->_mesh == mesh && b->_effect == effect)
+            return b;
+    }
+
+    VertexAttributeBinding* b = VertexAttributeBinding::create(mesh, this, effect);
+    if (b)
+    {
+        _bindings.push_back(b);
+    }
+    return b;
+}
+
+void InstanceBuffer::bindInstanceUniforms(Effect* effect, unsigned int index) const
+{
+    GP_ASSERT(effect);
+    GP_ASSERT(index < _instanceCount);
+
+    const float* data = (const float*)((const unsigned char*)_instanceData + index * _instanceFormat.getVertexSize());
+    for (unsigned int i = 0, count = _instanceFormat.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& e = _instanceFormat.getElement(i);
+        Uniform* uniform = effect->getUniform(e.usage == VertexFormat::INSTANCE_MATRIX ? INSTANCE_UNIFORM_MATRIX_NAME : INSTANCE_UNIFORM_DATA_NAME);
+        if (uniform)
+        {
+            switch (e.size)
+            {
+            case 1:
+                effect->setValue(uniform, data[0]);
+                break;
+            case 2:
+                effect->setValue(uniform, Vector2(data));
+                break;
+            case 3:
+                effect->setValue(uniform, Vector3(data));
+                break;
+            case 4:
+                effect->setValue(uniform, Vector4(data));
+                break;
+            case 16:
+                effect->setValue(uniform, Matrix(data));
+                break;
+            }
+        }
+        data += e.size;
+    }
+}
+
+}
@@ -0,0 +1,161 @@
+#ifndef INSTANCEBUFFER_H_
+#define INSTANCEBUFFER_H_
+
+#include "Ref.h"
+#include "VertexFormat.h"
+
+namespace gameplay
+{
+
+class Mesh;
+class Effect;
+class VertexAttributeBinding;
+
+/**
+ * Defines a buffer of per-instance vertex attributes used to draw many
+ * copies of the same Model with a single draw call.
+ *
+ * The layout of each instance is described by a VertexFormat whose elements
+ * use the VertexFormat::INSTANCE_MATRIX and VertexFormat::INSTANCE_DATA usages.
+ * These are bound to the "a_instanceMatrix" (mat4) and "a_instanceData" vertex
+ * shader attributes. The built-in unlit shaders support instancing when compiled
+ * with the INSTANCED define, in which case they transform positions by
+ * a_instanceMatrix and u_viewProjectionMatrix (VIEW_PROJECTION_MATRIX) instead
+ * of u_worldViewProjectionMatrix.
+ *
+ * When the device supports hardware instancing the instance data is stored in
+ * a vertex buffer object and drawn with glDrawElementsInstanced. Otherwise each
+ * instance is drawn with its own draw call and the instance attributes are
+ * passed through the "u_instanceMatrix" and "u_instanceData" uniforms; shaders
+ * are compiled with INSTANCING_UNIFORM defined in that case.
+ *
+ * @see Model::drawInstanced
+ * @script{ignore}
+ */
+class InstanceBuffer : public Ref
+{
+    friend class VertexAttributeBinding;
+
+public:
+
+    /**
+     * Creates a new instance buffer.
+     *
+     * @param instanceFormat The layout of the attributes of a single instance.
+     * @param capacity The maximum number of instances the buffer can hold.
+     * @param dynamic true if the instance data will be updated frequently.
+     *
+     * @return The new instance buffer, or NULL if the format is invalid.
+     */
+    static InstanceBuffer* create(const VertexFormat& instanceFormat, unsigned int capacity, bool dynamic = true);
+
+    /**
+     * Determines if hardware instancing is supported on the current device.
+     *
+     * @return true if instanced draw calls are available, false if instances are drawn one at a time.
+     */
+    static bool isHardwareInstancingSupported();
+
+    /**
+     * Gets the layout of a single instance.
+     *
+     * @return The instance vertex format.
+     */
+    const VertexFormat& getInstanceFormat() const;
+
+    /**
+     * Gets the maximum number of instances the buffer can hold.
+     *
+     * @return The instance capacity.
+     */
+    unsigned int getCapacity() const;
+
+    /**
+     * Gets the number of instances that are drawn.
+     *
+     * @return The number of instances.
+     */
+    unsigned int getInstanceCount() const;
+
+    /**
+     * Sets the number of instances that are drawn.
+     *
+     * @param count The number of instances, clamped to the capacity.
+     */
+    void setInstanceCount(unsigned int count);
+
+    /**
+     * Sets the attribute data of a range of instances.
+     *
+     * The instance count is raised to include the updated range if needed.
+     *
+     * @param instanceData The instance data, laid out as described by the instance format.
+     * @param instanceStart The index of the first instance to update.
+     * @param instanceCount The number of instances to update.
+     */
+    void setInstanceData(const float* instanceData, unsigned int instanceStart, unsigned int instanceCount);
+
+    /**
+     * Gets the attribute data of the instances.
+     *
+     * @return The instance data.
+     */
+    const float* getInstanceData() const;
+
+    /**
+     * Returns a handle to the vertex buffer holding the instance data.
+     *
+     * @return The vertex buffer object handle, or 0 when hardware instancing is not supported.
+     */
+    VertexBufferHandle getVertexBuffer() const;
+
+    /**
+     * Gets the vertex attribute binding that binds both the given mesh and these
+     * instances to the specified effect, creating it on first use.
+     *
+     * @param mesh The mesh being instanced.
+     * @param effect The effect used to draw the instances.
+     *
+     * @return The vertex attribute binding, owned by this buffer.
+     */
+    VertexAttributeBinding* getVertexAttributeBinding(Mesh* mesh, Effect* effect);
+
+    /**
+     * Sets the uniforms of the specified effect to the attributes of one instance.
+     *
+     * This is used when hardware instancing is not supported.
+     *
+     * @param effect The bound effect.
+     * @param index The index of the instance.
+     */
+    void bindInstanceUniforms(Effect* effect, unsigned int index) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    InstanceBuffer(const VertexFormat& instanceFormat);
+
+    /**
+     * Destructor.
+     */
+    ~InstanceBuffer();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    InstanceBuffer& operator=(const InstanceBuffer&);
+
+    const VertexFormat _instanceFormat;
+    unsigned int _capacity;
+    unsigned int _instanceCount;
+    bool _dynamic;
+    float* _instanceData;
+    VertexBufferHandle _vertexBuffer;
+    std::vector<VertexAttributeBinding*> _bindings;
+};
+
+}
+
+#endif
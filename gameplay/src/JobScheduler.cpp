@@ -0,0 +1,405 @@
+#include "Base.h"
+#include "JobScheduler.h"
+#include <deque>
+
+// Number of times an idle worker polls the queues before going to sleep.
+#define WORKER_SPIN_COUNT 64
+
+// Number of batches parallelFor aims to create per thread, to help balance uneven work.
+#define PARALLEL_FOR_BATCHES_PER_THREAD 4
+
+namespace gameplay
+{
+
+class JobScheduler::Job
+{
+public:
+
+    Job() : function(NULL), cookie(NULL), parent(NULL), firstContinuation(NULL), nextContinuation(NULL), nextFree(NULL) { }
+
+    JobFunction function;
+    void* cookie;
+    Job* parent;
+    Job* firstContinuation;     // Jobs waiting for this job to complete (guarded by _jobMutex).
+    Job* nextContinuation;      // Next job waiting on the same dependency.
+    Job* nextFree;
+    AtomicInt unfinished;       // 1 for the job itself plus one per unfinished child.
+    AtomicInt refs;             // 1 for the caller's handle plus 1 until the job has finished.
+    AtomicInt finished;
+};
+
+struct JobScheduler::Worker
+{
+    Worker(JobScheduler* scheduler, unsigned int index) : scheduler(scheduler), index(index), thread(NULL) { }
+
+    JobScheduler* scheduler;
+    unsigned int index;
+    Thread* thread;
+    Mutex mutex;
+    std::deque<Job*> queue;
+};
+
+struct RangeBatch
+{
+    JobScheduler::RangeFunction function;
+    void* cookie;
+    unsigned int start;
+    unsigned int end;
+};
+
+static void rangeBatchJob(void* cookie)
+{
+    RangeBatch* batch = static_cast<RangeBatch*>(cookie);
+    batch->function(batch->start, batch->end, batch->cookie);
+}
+
+JobScheduler::JobScheduler()
+    : _external(NULL), _freeJobs(NULL), _running(0)
+{
+}
+
+JobScheduler::~JobScheduler()
+{
+    GP_ASSERT(_workers.empty());
+}
+
+void JobScheduler::initialize(unsigned int workerCount)
+{
+    _running.set(1);
+
+    // Threads that are not workers (such as the main thread) share one queue,
+    // stored after the worker queues.
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        _workers.push_back(new Worker(this, i));
+    }
+    _external = new Worker(this, workerCount);
+
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        Worker* worker = _workers[i];
+        worker->thread = Thread::create(workerMain, worker);
+        if (worker->thread == NULL)
+        {
+            GP_WARN("Failed to create job worker thread %u; continuing with %u workers.", i, i);
+            for (unsigned int j = i; j < workerCount; ++j)
+            {
+                SAFE_DELETE(_workers[j]);
+            }
+            _workers.resize(i);
+            _external->index = i;
+            break;
+        }
+    }
+}
+
+void JobScheduler::finalize()
+{
+    if (_pendingCount.get() > 0)
+    {
+        GP_WARN("Job scheduler is shutting down with %d pending jobs.", _pendingCount.get());
+    }
+
+    _sleepMutex.lock();
+    _running.set(0);
+    _sleepCondition.broadcast();
+    _sleepMutex.unlock();
+
+    for (size_t i = 0, count = _workers.size(); i < count; ++i)
+    {
+        Worker* worker = _workers[i];
+        worker->thread->join();
+        SAFE_DELETE(worker->thread);
+        SAFE_DELETE(worker);
+    }
+    _workers.clear();
+    SAFE_DELETE(_external);
+
+    while (_freeJobs)
+    {
+        Job* job = _freeJobs;
+        _freeJobs = job->nextFree;
+        SAFE_DELETE(job);
+    }
+}
+
+JobScheduler::Job* JobScheduler::submit(JobFunction function, void* cookie, Job* parent, Job* dependency)
+{
+    Job* job = createJob(function, cookie, parent);
+
+    if (dependency)
+    {
+        MutexLock lock(_jobMutex);
+        if (!dependency->finished.get())
+        {
+            job->nextContinuation = dependency->firstContinuation;
+            dependency->firstContinuation = job;
+            return job;
+        }
+    }
+
+    enqueue(job);
+    return job;
+}
+
+void JobScheduler::wait(Job* job)
+{
+    GP_ASSERT(job);
+
+    unsigned int queueIndex = getCurrentQueue();
+    while (!job->finished.get())
+    {
+        if (!executeNext(queueIndex))
+            Thread::yield();
+    }
+    releaseRef(job);
+}
+
+void JobScheduler::release(Job* job)
+{
+    GP_ASSERT(job);
+    releaseRef(job);
+}
+
+bool JobScheduler::isFinished(const Job* job) const
+{
+    GP_ASSERT(job);
+    return job->finished.get() != 0;
+}
+
+void JobScheduler::parallelFor(unsigned int count, RangeFunction function, void* cookie, unsigned int batchSize)
+{
+    GP_ASSERT(function);
+
+    if (count == 0)
+        return;
+
+    unsigned int threadCount = (unsigned int)_workers.size() + 1;
+    unsigned int targetBatches = threadCount * PARALLEL_FOR_BATCHES_PER_THREAD;
+    unsigned int size = std::max(std::max(batchSize, 1u), (count + targetBatches - 1) / targetBatches);
+    if (threadCount == 1 || size >= count)
+    {
+        function(0, count, cookie);
+        return;
+    }
+
+    unsigned int batchCount = (count + size - 1) / size;
+    std::vector<RangeBatch> batches(batchCount);
+
+    // The parent is held back until every batch has been attached to it and is
+    // then completed on this thread, joining all batches.
+    Job* parent = createJob(NULL, NULL, NULL);
+    for (unsigned int i = 0; i < batchCount; ++i)
+    {
+        RangeBatch& batch = batches[i];
+        batch.function = function;
+        batch.cookie = cookie;
+        batch.start = i * size;
+        batch.end = std::min(batch.start + size, count);
+        release(submit(rangeBatchJob, &batch, parent));
+    }
+    execute(parent);
+    wait(parent);
+}
+
+unsigned int JobScheduler::getWorkerCount() const
+{
+    return (unsigned int)_workers.size();
+}
+
+void JobScheduler::workerMain(void* arg)
+{
+    Worker* worker = static_cast<Worker*>(arg);
+    JobScheduler* scheduler = worker->scheduler;
+    const unsigned int index = worker->index;
+
+    unsigned int spins = 0;
+    while (scheduler->_running.get())
+    {
+        if (scheduler->executeNext(index))
+        {
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < WORKER_SPIN_COUNT)
+        {
+            Thread::yield();
+            continue;
+        }
+        spins = 0;
+
+        // Sleep until new jobs are enqueued. The sleeping count is raised before
+        // the pending count is checked so that enqueue() never misses a sleeper.
+        scheduler->_sleepMutex.lock();
+        scheduler->_sleepingCount.increment();
+        while (scheduler->_running.get() && scheduler->_pendingCount.get() == 0)
+        {
+            scheduler->_sleepCondition.wait(scheduler->_sleepMutex);
+        }
+        scheduler->_sleepingCount.decrement();
+        scheduler->_sleepMutex.unlock();
+    }
+}
+
+JobScheduler::Job* JobScheduler::createJob(JobFunction function, void* cookie, Job* parent)
+{
+    Job* job = NULL;
+    {
+        MutexLock lock(_jobMutex);
+        if (_freeJobs)
+        {
+            job = _freeJobs;
+            _freeJobs = job->nextFree;
+            job->nextFree = NULL;
+        }
+    }
+    if (job == NULL)
+        job = new Job();
+
+    job->function = function;
+    job->cookie = cookie;
+    job->parent = parent;
+    job->unfinished.set(1);
+    job->refs.set(2);
+    job->finished.set(0);
+
+    if (parent)
+    {
+        GP_ASSERT(!parent->finished.get());
+        parent->unfinished.increment();
+    }
+    return job;
+}
+
+void JobScheduler::freeJob(Job* job)
+{
+    job->function = NULL;
+    job->cookie = NULL;
+    job->parent = NULL;
+    job->firstContinuation = NULL;
+    job->nextContinuation = NULL;
+
+    MutexLock lock(_jobMutex);
+    job->nextFree = _freeJobs;
+    _freeJobs = job;
+}
+
+void JobScheduler::releaseRef(Job* job)
+{
+    if (job->refs.decrement() == 0)
+        freeJob(job);
+}
+
+void JobScheduler::enqueue(Job* job)
+{
+    Worker* worker = _external;
+    unsigned int index = getCurrentQueue();
+    if (index < _workers.size())
+        worker = _workers[index];
+
+    worker->mutex.lock();
+    worker->queue.push_back(job);
+    worker->mutex.unlock();
+
+    _pendingCount.increment();
+    if (_sleepingCount.get() > 0)
+    {
+        _sleepMutex.lock();
+        _sleepCondition.signal();
+        _sleepMutex.unlock();
+    }
+}
+
+JobScheduler::Job* JobScheduler::dequeue(unsigned int queueIndex)
+{
+    const unsigned int queueCount = (unsigned int)_workers.size() + 1;
+    for (unsigned int i = 0; i < queueCount; ++i)
+    {
+        unsigned int index = (queueIndex + i) % queueCount;
+        Worker* worker = index < _workers.size() ? _workers[index] : _external;
+
+        Job* job = NULL;
+        worker->mutex.lock();
+        if (!worker->queue.empty())
+        {
+            // Take the newest job from our own queue and steal the oldest from others.
+            if (i == 0)
+            {
+                job = worker->queue.back();
+                worker->queue.pop_back();
+            }
+            else
+            {
+                job = worker->queue.front();
+                worker->queue.pop_front();
+            }
+        }
+        worker->mutex.unlock();
+
+        if (job)
+        {
+            _pendingCount.decrement();
+            return job;
+        }
+    }
+    return NULL;
+}
+
+bool JobScheduler::executeNext(unsigned int queueIndex)
+{
+    Job* job = dequeue(queueIndex);
+    if (job == NULL)
+        return false;
+
+    execute(job);
+    return true;
+}
+
+void JobScheduler::execute(Job* job)
+{
+    if (job->function)
+        job->function(job->cookie);
+
+    if (job->unfinished.decrement() == 0)
+        finish(job);
+}
+
+void JobScheduler::finish(Job* job)
+{
+    Job* continuation;
+    {
+        MutexLock lock(_jobMutex);
+        job->finished.set(1);
+        continuation = job->firstContinuation;
+        job->firstContinuation = NULL;
+    }
+
+    Job* parent = job->parent;
+
+    while (continuation)
+    {
+        Job* next = continuation->nextContinuation;
+        continuation->nextContinuation = NULL;
+        enqueue(continuation);
+        continuation = next;
+    }
+
+    // Drop the reference held on behalf of the running job.
+    releaseRef(job);
+
+    if (parent && parent->unfinished.decrement() == 0)
+        finish(parent);
+}
+
+unsigned int JobScheduler::getCurrentQueue() const
+{
+    for (size_t i = 0, count = _workers.size(); i < count; ++i)
+    {
+        if (_workers[i]->thread && _workers[i]->thread->isCurrent())
+            return (unsigned int)i;
+    }
+    return (unsigned int)_workers.size();
+}
+
+}
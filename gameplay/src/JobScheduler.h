@@ -0,0 +1,187 @@
+#ifndef JOBSCHEDULER_H_
+#define JOBSCHEDULER_H_
+
+#include "Thread.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a work-stealing job scheduler backed by a pool of worker threads.
+ *
+ * Each worker owns a queue of jobs. Workers execute their own jobs most
+ * recently submitted first and steal the oldest jobs from other workers when
+ * their own queue runs dry. Threads that wait on a job (including the main
+ * thread) help execute pending jobs until the job they wait on completes,
+ * which makes nested fork/join safe.
+ *
+ * Jobs can be grouped under a parent job: a parent completes only once its own
+ * function and all of its children have completed, so waiting on the parent
+ * joins the whole group. A job can also depend on another job, in which case it
+ * is not started before the dependency has completed.
+ *
+ * Every handle returned by submit() must be handed back to the scheduler exactly
+ * once through wait() or release().
+ *
+ * The number of worker threads can be configured in the game config:
+ *
+ * @verbatim
+    jobs
+    {
+        workers = 3
+    }
+   @endverbatim
+ *
+ * By default one worker is created for each additional hardware thread. With
+ * zero workers all jobs are executed by the threads that wait on them.
+ *
+ * @script{ignore}
+ */
+class JobScheduler
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the signature of a job function.
+     *
+     * @param cookie The user data passed when the job was submitted.
+     */
+    typedef void (*JobFunction)(void* cookie);
+
+    /**
+     * Defines the signature of a parallelFor range function.
+     *
+     * @param start The first index of the range to process.
+     * @param end One past the last index of the range to process.
+     * @param cookie The user data passed to parallelFor().
+     */
+    typedef void (*RangeFunction)(unsigned int start, unsigned int end, void* cookie);
+
+    /**
+     * An opaque handle to a submitted job.
+     */
+    class Job;
+
+    /**
+     * Submits a job for execution.
+     *
+     * @param function The function to execute.
+     * @param cookie User data passed to the function.
+     * @param parent Optional parent job that will not complete until this job completes.
+     *      The parent must not have completed yet, so children are typically submitted
+     *      from within the parent's own job function.
+     * @param dependency Optional job that must complete before this job starts.
+     *
+     * @return A handle to the job which must be passed to wait() or release().
+     */
+    Job* submit(JobFunction function, void* cookie, Job* parent = NULL, Job* dependency = NULL);
+
+    /**
+     * Blocks until the specified job (and all its children) have completed and
+     * releases the handle.
+     *
+     * The calling thread executes other pending jobs while it waits.
+     *
+     * @param job The job to wait for.
+     */
+    void wait(Job* job);
+
+    /**
+     * Releases a job handle without waiting for the job to complete.
+     *
+     * @param job The job handle to release.
+     */
+    void release(Job* job);
+
+    /**
+     * Determines whether the specified job (and all its children) have completed.
+     *
+     * @param job The job to query.
+     *
+     * @return true if the job has completed, false otherwise.
+     */
+    bool isFinished(const Job* job) const;
+
+    /**
+     * Splits the range [0, count) into batches and processes the batches in parallel.
+     *
+     * This method returns once the whole range has been processed.
+     *
+     * @param count The number of items to process.
+     * @param function The function that processes a range of items.
+     * @param cookie User data passed to the function.
+     * @param batchSize The minimum number of items to process per batch.
+     */
+    void parallelFor(unsigned int count, RangeFunction function, void* cookie, unsigned int batchSize = 1);
+
+    /**
+     * Gets the number of worker threads owned by the scheduler.
+     *
+     * @return The number of worker threads.
+     */
+    unsigned int getWorkerCount() const;
+
+private:
+
+    struct Worker;
+
+    /**
+     * Constructor.
+     */
+    JobScheduler();
+
+    /**
+     * Destructor.
+     */
+    ~JobScheduler();
+
+    /**
+     * Hidden copy constructor.
+     */
+    JobScheduler(const JobScheduler& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    JobScheduler& operator=(const JobScheduler&);
+
+    /**
+     * Called during startup to create the worker threads.
+     *
+     * @param workerCount The number of worker threads to create.
+     */
+    void initialize(unsigned int workerCount);
+
+    /**
+     * Called during shutdown to stop and destroy the worker threads.
+     */
+    void finalize();
+
+    static void workerMain(void* arg);
+
+    Job* createJob(JobFunction function, void* cookie, Job* parent);
+    void freeJob(Job* job);
+    void releaseRef(Job* job);
+    void enqueue(Job* job);
+    Job* dequeue(unsigned int queueIndex);
+    bool executeNext(unsigned int queueIndex);
+    void execute(Job* job);
+    void finish(Job* job);
+    unsigned int getCurrentQueue() const;
+
+    std::vector<Worker*> _workers;
+    Worker* _external;
+    Job* _freeJobs;
+    Mutex _jobMutex;
+    Mutex _sleepMutex;
+    Condition _sleepCondition;
+    AtomicInt _pendingCount;
+    AtomicInt _sleepingCount;
+    AtomicInt _running;
+};
+
+}
+
+#endif
@@ -1,12 +1,13 @@
 #include "Base.h"
 #include "Joint.h"
 #include "MeshSkin.h"
+#include "Model.h"
 
 namespace gameplay
 {
 
 Joint::Joint(const char* id)
-    : Node(id), _jointMatrixDirty(true)
+    : Node(id)
 {
 }
 
@@ -58,28 +59,39 @@ Scene* Joint::getScene() const
 void Joint::transformChanged()
 {
     Node::transformChanged();
-    _jointMatrixDirty = true;
-}
 
-void Joint::updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette)
-{
-    // Note: If more than one MeshSkin influences this Joint, we need to skip
-    // the _jointMatrixDirty optimization since updateJointMatrix() may be
-    // called multiple times a frame with different bindShape matrices (and
-    // different matrixPallete pointers).
-    if (_skin.next || _jointMatrixDirty)
+    // The matrix palette of every skin influenced by this joint is now stale.
+    for (SkinReference* ref = &_skin; ref && ref->skin; ref = ref->next)
     {
-        _jointMatrixDirty = false;
+        MeshSkin* skin = ref->skin;
+        skin->_paletteDirty = true;
 
-        static Matrix t;
-        Matrix::multiply(Node::getWorldMatrix(), getInverseBindPose(), &t);
-        Matrix::multiply(t, bindShape, &t);
+        // So are the bounds of the models whose skins are bounded by their joints.
+        if (!skin->_jointBounds.empty())
+        {
+            skin->_boundsDirty = true;
+            if (skin->_model && skin->_model->getNode())
+            {
+                skin->_model->getNode()->setBoundsDirty();
+            }
+        }
+    }
+}
 
-        GP_ASSERT(matrixPalette);
-        matrixPalette[0].set(t.m[0], t.m[4], t.m[8], t.m[12]);
-        matrixPalette[1].set(t.m[1], t.m[5], t.m[9], t.m[13]);
-        matrixPalette[2].set(t.m[2], t.m[6], t.m[10], t.m[14]);
+unsigned int Joint::getAnimationLodInterval() const
+{
+    // A joint shared by several skins is animated at the rate of the closest one.
+    unsigned int frameInterval = 0;
+    for (const SkinReference* ref = &_skin; ref && ref->skin; ref = ref->next)
+    {
+        Model* model = ref->skin->getModel();
+        if (model)
+        {
+            unsigned int interval = model->getAnimationLodInterval();
+            frameInterval = frameInterval == 0 ? interval : std::min(frameInterval, interval);
+        }
     }
+    return frameInterval > 0 ? frameInterval : Node::getAnimationLodInterval();
 }
 
 const Matrix& Joint::getInverseBindPose() const
@@ -90,7 +102,12 @@ const Matrix& Joint::getInverseBindPose() const
 void Joint::setInverseBindPose(const Matrix& m)
 {
     _bindPose = m;
-    _jointMatrixDirty = true;
+
+    for (SkinReference* ref = &_skin; ref && ref->skin; ref = ref->next)
+    {
+        ref->skin->_bindMatricesDirty = true;
+        ref->skin->_paletteDirty = true;
+    }
 }
 
 void Joint::addSkin(MeshSkin* skin)
@@ -76,17 +76,16 @@ protected:
     void setInverseBindPose(const Matrix& m);
 
     /**
-     * Updates the joint matrix.
-     * 
-     * @param bindShape The bind shape matrix.
-     * @param matrixPalette The matrix palette to update.
+     * Called when this Joint's transform changes.
      */
-    void updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette);
+    void transformChanged();
 
     /**
-     * Called when this Joint's transform changes.
+     * Gets the smallest animation frame interval of the models skinned by this joint.
+     *
+     * @see AnimationTarget::getAnimationLodInterval
      */
-    void transformChanged();
+    unsigned int getAnimationLodInterval() const;
 
 private:
 
@@ -121,11 +120,6 @@ private:
      */
     Matrix _bindPose;
 
-    /**
-     * Flag used to mark if the Joint's matrix is dirty.
-     */
-    bool _jointMatrixDirty;
-
     /**
      * Linked list of mesh skins that are referenced by this joint.
      */
@@ -102,9 +102,22 @@ void Label::drawText(const Rectangle& clip)
     // Draw the text.
     if (_font)
     {
-        _font->start();
-        _font->drawText(_text.c_str(), _textBounds, _textColor, getFontSize(_state), getTextAlignment(_state), true, getTextRightToLeft(_state), &_viewportClipBounds);
-        _font->finish();
+        // While the control is drawn from geometry generated at another position, its text is
+        // laid out at that position too and then translated, so the layout is reused.
+        if (_geometryOffset.isZero())
+        {
+            _geometryTextBounds = _textBounds;
+            _geometryTextClip = _viewportClipBounds;
+        }
+
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->prepareText(_font, _viewportClipBounds);
+        else
+            _font->start();
+        _font->drawText(_text.c_str(), _geometryTextBounds, _textColor, getFontSize(_state), getTextAlignment(_state), true, getTextRightToLeft(_state), &_geometryTextClip, _geometryOffset);
+        if (!theme)
+            _font->finish();
     }
 }
 
@@ -145,6 +145,9 @@ private:
      * Constructor.
      */
     Label(const Label& copy);
+
+    Rectangle _geometryTextBounds;
+    Rectangle _geometryTextClip;
 };
 
 }
@@ -0,0 +1,381 @@
+#include "Base.h"
+#include "LightClusters.h"
+#include "RenderCommandList.h"
+#include "Scene.h"
+#include "Light.h"
+#include "Camera.h"
+#include "Game.h"
+#include "JobScheduler.h"
+#include "RenderStats.h"
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+
+// Lights listed per cluster. The shaders read the lists four indices per texel,
+// so this must match CLUSTER_MAX_LIGHTS in lighting-clustered.frag.
+#define CLUSTER_MAX_LIGHTS 32
+
+// Texels of light data per light: position and inverse range, color and spot inner
+// cone cosine, direction and spot outer cone cosine.
+#define CLUSTER_LIGHT_ROWS 3
+
+// Cone cosines of point lights, which make the spot attenuation of the shader one.
+#define CLUSTER_POINT_INNER_COS -2.0f
+#define CLUSTER_POINT_OUTER_COS -3.0f
+
+namespace gameplay
+{
+
+LightClusters::LightClusters() :
+    _tileCountX(0), _tileCountY(0), _sliceCount(0), _maxLightCount(0), _lightSampler(NULL), _countSampler(NULL), _indexSampler(NULL),
+    _lightCount(0), _directionalLightCount(0), _overflowed(false)
+{
+}
+
+LightClusters::~LightClusters()
+{
+    SAFE_RELEASE(_lightSampler);
+    SAFE_RELEASE(_countSampler);
+    SAFE_RELEASE(_indexSampler);
+}
+
+bool LightClusters::isSupported()
+{
+    // Detected on first use.
+    static int support = -1;
+    if (support == -1)
+    {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+#ifdef OPENGL_ES
+        support = extensions && strstr(extensions, "GL_OES_texture_float") ? 1 : 0;
+#else
+        const char* version = (const char*)glGetString(GL_VERSION);
+        support = (version && version[0] >= '3' && version[0] <= '9') || (extensions && strstr(extensions, "GL_ARB_texture_float")) ? 1 : 0;
+#endif
+    }
+    return support == 1;
+}
+
+static Texture::Sampler* createSampler(Texture* texture)
+{
+    Texture::Sampler* sampler = Texture::Sampler::create(texture);
+    sampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    SAFE_RELEASE(texture);
+    return sampler;
+}
+
+LightClusters* LightClusters::create(unsigned int tileCountX, unsigned int tileCountY, unsigned int sliceCount, unsigned int maxLightCount)
+{
+    GP_ASSERT(tileCountX > 0 && tileCountY > 0 && sliceCount > 0);
+
+    if (!isSupported())
+    {
+        GP_WARN("Clustered lighting requires floating point textures.");
+        return NULL;
+    }
+    if (maxLightCount == 0 || maxLightCount > 256)
+    {
+        GP_ERROR("Invalid maximum light count (%u) for light clusters; it must be between 1 and 256.", maxLightCount);
+        return NULL;
+    }
+
+    LightClusters* clusters = new LightClusters();
+    clusters->_tileCountX = tileCountX;
+    clusters->_tileCountY = tileCountY;
+    clusters->_sliceCount = sliceCount;
+    clusters->_maxLightCount = maxLightCount;
+
+    unsigned int tileCount = tileCountX * tileCountY;
+    clusters->_lightData.resize(maxLightCount * CLUSTER_LIGHT_ROWS * 4, 0.0f);
+    clusters->_countData.resize(tileCount * sliceCount, 0);
+    clusters->_indexData.resize(tileCount * sliceCount * CLUSTER_MAX_LIGHTS, 0);
+
+    // The light data needs full precision, so its texture is created here rather than by Texture.
+    GLuint handle;
+    GL_ASSERT( glGenTextures(1, &handle) );
+    Texture::bindTexture(handle);
+#ifdef OPENGL_ES
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, maxLightCount, CLUSTER_LIGHT_ROWS, 0, GL_RGBA, GL_FLOAT, &clusters->_lightData[0]) );
+#else
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, maxLightCount, CLUSTER_LIGHT_ROWS, 0, GL_RGBA, GL_FLOAT, &clusters->_lightData[0]) );
+#endif
+    Texture* lightTexture = Texture::create(handle, maxLightCount, CLUSTER_LIGHT_ROWS, Texture::RGBA);
+    lightTexture->setMemorySize(maxLightCount * CLUSTER_LIGHT_ROWS * 4 * sizeof(float));
+    clusters->_lightSampler = createSampler(lightTexture);
+
+    clusters->_countSampler = createSampler(Texture::create(Texture::ALPHA, tileCount, sliceCount, &clusters->_countData[0]));
+    clusters->_indexSampler = createSampler(Texture::create(Texture::RGBA, tileCount * CLUSTER_MAX_LIGHTS / 4, sliceCount, &clusters->_indexData[0]));
+
+    clusters->_size.set((float)tileCountX, (float)tileCountY, (float)sliceCount, (float)maxLightCount);
+    return clusters;
+}
+
+bool LightClusters::gatherLight(Node* node)
+{
+    GP_ASSERT(node);
+
+    Light* light = node->getLight();
+    if (light)
+    {
+        if (light->getLightType() == Light::DIRECTIONAL)
+            _directionalNodes.push_back(node);
+        else
+            _localNodes.push_back(node);
+    }
+    return true;
+}
+
+int LightClusters::addLight(const Vector3& position, float rangeInverse, const Vector3& color, float innerAngleCos, const Vector3& direction, float outerAngleCos)
+{
+    if (_lightCount >= _maxLightCount)
+    {
+        if (!_overflowed)
+        {
+            GP_WARN("Scene has more than %u lights; the remaining lights are ignored by clustered lighting.", _maxLightCount);
+            _overflowed = true;
+        }
+        return -1;
+    }
+
+    // Each row of the texture holds one texel of every light.
+    float* texel = &_lightData[_lightCount * 4];
+    const unsigned int rowSize = _maxLightCount * 4;
+    texel[0] = position.x;
+    texel[1] = position.y;
+    texel[2] = position.z;
+    texel[3] = rangeInverse;
+    texel += rowSize;
+    texel[0] = color.x;
+    texel[1] = color.y;
+    texel[2] = color.z;
+    texel[3] = innerAngleCos;
+    texel += rowSize;
+    texel[0] = direction.x;
+    texel[1] = direction.y;
+    texel[2] = direction.z;
+    texel[3] = outerAngleCos;
+    return (int)_lightCount++;
+}
+
+static unsigned int clampTile(float ndc, unsigned int count)
+{
+    int tile = (int)((ndc * 0.5f + 0.5f) * count);
+    return (unsigned int)std::max(0, std::min(tile, (int)count - 1));
+}
+
+bool LightClusters::findClusters(const Vector3& center, float radius, Camera* camera, ClusterLight* light) const
+{
+    GP_ASSERT(camera);
+    GP_ASSERT(light);
+
+    // The camera looks down -z in view space.
+    const float nearPlane = camera->getNearPlane();
+    const float farPlane = camera->getFarPlane();
+    float depthMin = -center.z - radius;
+    float depthMax = -center.z + radius;
+    if (depthMax < nearPlane || depthMin > farPlane)
+        return false;
+
+    light->sliceMin = (unsigned int)std::max(0.0f, logf(std::max(depthMin, nearPlane)) * _scale.z + _scale.w);
+    light->sliceMax = std::min((unsigned int)std::max(0.0f, logf(std::min(depthMax, farPlane)) * _scale.z + _scale.w), _sliceCount - 1);
+    light->sliceMin = std::min(light->sliceMin, light->sliceMax);
+
+    if (depthMin <= nearPlane)
+    {
+        // The sphere crosses the near plane, where its projection is unbounded.
+        light->tileMinX = 0;
+        light->tileMaxX = _tileCountX - 1;
+        light->tileMinY = 0;
+        light->tileMaxY = _tileCountY - 1;
+        return true;
+    }
+
+    // Project the corners of the sphere's bounding box, which are all in front of the camera.
+    const Matrix& projection = camera->getProjectionMatrix();
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        Vector4 corner(center.x + (i & 1 ? radius : -radius), center.y + (i & 2 ? radius : -radius), center.z + (i & 4 ? radius : -radius), 1.0f);
+        Vector4 clip;
+        projection.transformVector(corner, &clip);
+        float x = clip.x / clip.w;
+        float y = clip.y / clip.w;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+        return false;
+
+    light->tileMinX = clampTile(minX, _tileCountX);
+    light->tileMaxX = clampTile(maxX, _tileCountX);
+    light->tileMinY = clampTile(minY, _tileCountY);
+    light->tileMaxY = clampTile(maxY, _tileCountY);
+    return true;
+}
+
+void LightClusters::binSlices(unsigned int start, unsigned int end, void* cookie)
+{
+    LightClusters* clusters = (LightClusters*)cookie;
+    GP_ASSERT(clusters);
+
+    // Each range of slices owns its clusters, so ranges are binned without synchronization.
+    const unsigned int tileCount = clusters->_tileCountX * clusters->_tileCountY;
+    unsigned char* counts = &clusters->_countData[0];
+    unsigned char* indices = &clusters->_indexData[0];
+    memset(counts + start * tileCount, 0, (end - start) * tileCount);
+
+    for (size_t i = 0, count = clusters->_clusterLights.size(); i < count; ++i)
+    {
+        const ClusterLight& light = clusters->_clusterLights[i];
+        unsigned int sliceMin = std::max(light.sliceMin, start);
+        unsigned int sliceMax = std::min(light.sliceMax + 1, end);
+        for (unsigned int slice = sliceMin; slice < sliceMax; ++slice)
+        {
+            for (unsigned int y = light.tileMinY; y <= light.tileMaxY; ++y)
+            {
+                for (unsigned int x = light.tileMinX; x <= light.tileMaxX; ++x)
+                {
+                    unsigned int cluster = slice * tileCount + y * clusters->_tileCountX + x;
+                    if (counts[cluster] < CLUSTER_MAX_LIGHTS)
+                    {
+                        indices[cluster * CLUSTER_MAX_LIGHTS + counts[cluster]] = (unsigned char)light.index;
+                        ++counts[cluster];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void LightClusters::update(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    _lightCount = 0;
+    _directionalLightCount = 0;
+    _clusterLights.clear();
+
+    Camera* camera = scene->getActiveCamera();
+    if (camera)
+    {
+        const Rectangle& viewport = Game::getInstance()->getViewport();
+        const float nearPlane = camera->getNearPlane();
+        const float farPlane = camera->getFarPlane();
+        _scale.x = viewport.width > 0 ? _tileCountX / viewport.width : 0.0f;
+        _scale.y = viewport.height > 0 ? _tileCountY / viewport.height : 0.0f;
+        _scale.z = _sliceCount / logf(farPlane / nearPlane);
+        _scale.w = -logf(nearPlane) * _scale.z;
+
+        _directionalNodes.clear();
+        _localNodes.clear();
+        scene->visit(this, &LightClusters::gatherLight);
+
+        // Directional lights come first in the light data and reach every cluster.
+        const Matrix& view = camera->getViewMatrix();
+        for (size_t i = 0, count = _directionalNodes.size(); i < count; ++i)
+        {
+            Node* node = _directionalNodes[i];
+            Vector3 direction;
+            view.transformVector(node->getForwardVectorWorld(), &direction);
+            direction.normalize();
+            if (addLight(Vector3::zero(), 0.0f, node->getLight()->getColor(), 0.0f, direction, 0.0f) < 0)
+                break;
+            ++_directionalLightCount;
+        }
+
+        for (size_t i = 0, count = _localNodes.size(); i < count; ++i)
+        {
+            Node* node = _localNodes[i];
+            Light* light = node->getLight();
+            Vector3 position;
+            view.transformPoint(node->getTranslationWorld(), &position);
+
+            ClusterLight clusterLight;
+            if (!findClusters(position, light->getRange(), camera, &clusterLight))
+                continue;
+
+            int index;
+            if (light->getLightType() == Light::SPOT)
+            {
+                Vector3 direction;
+                view.transformVector(node->getForwardVectorWorld(), &direction);
+                direction.normalize();
+                index = addLight(position, light->getRangeInverse(), light->getColor(), light->getInnerAngleCos(), direction, light->getOuterAngleCos());
+            }
+            else
+            {
+                index = addLight(position, light->getRangeInverse(), light->getColor(), CLUSTER_POINT_INNER_COS, Vector3::zero(), CLUSTER_POINT_OUTER_COS);
+            }
+            if (index < 0)
+                break;
+            clusterLight.index = (unsigned int)index;
+            _clusterLights.push_back(clusterLight);
+        }
+    }
+
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler && scheduler->getWorkerCount() > 0 && !_clusterLights.empty())
+    {
+        scheduler->parallelFor(_sliceCount, binSlices, this);
+    }
+    else
+    {
+        binSlices(0, _sliceCount, this);
+    }
+
+    // Upload the data of the lights in use and the lists of every cluster.
+    if (_lightCount > 0)
+    {
+        Texture* texture = _lightSampler->getTexture();
+        Texture::bindTexture(texture->getHandle());
+        for (unsigned int row = 0; row < CLUSTER_LIGHT_ROWS; ++row)
+        {
+            RenderCommandList::texSubImage2D(GL_TEXTURE_2D, 0, 0, row, _lightCount, 1, GL_RGBA, GL_FLOAT, &_lightData[row * _maxLightCount * 4], _lightCount * 4 * sizeof(float));
+        }
+        RenderStats::addUpload(_lightCount * CLUSTER_LIGHT_ROWS * 4 * sizeof(float));
+    }
+    const unsigned int tileCount = _tileCountX * _tileCountY;
+    _countSampler->getTexture()->setData(0, 0, tileCount, _sliceCount, &_countData[0]);
+    if (!_clusterLights.empty())
+    {
+        _indexSampler->getTexture()->setData(0, 0, tileCount * CLUSTER_MAX_LIGHTS / 4, _sliceCount, &_indexData[0]);
+    }
+}
+
+unsigned int LightClusters::getLightCount() const
+{
+    return _lightCount;
+}
+
+void LightClusters::setMaterialParameters(RenderState* renderState)
+{
+    GP_ASSERT(renderState);
+
+    renderState->getParameter("u_clusterLights")->setValue(_lightSampler);
+    renderState->getParameter("u_clusterCounts")->setValue(_countSampler);
+    renderState->getParameter("u_clusterIndices")->setValue(_indexSampler);
+    renderState->getParameter("u_clusterScale")->bindValue(this, &LightClusters::getScale);
+    renderState->getParameter("u_clusterSize")->bindValue(this, &LightClusters::getSize);
+    renderState->getParameter("u_clusterDirectionalLightCount")->bindValue(this, &LightClusters::getDirectionalLightCount);
+}
+
+const Vector4& LightClusters::getScale() const
+{
+    return _scale;
+}
+
+const Vector4& LightClusters::getSize() const
+{
+    return _size;
+}
+
+float LightClusters::getDirectionalLightCount() const
+{
+    return (float)_directionalLightCount;
+}
+
+}
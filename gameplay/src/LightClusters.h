@@ -0,0 +1,157 @@
+#ifndef LIGHTCLUSTERS_H_
+#define LIGHTCLUSTERS_H_
+
+#include "Ref.h"
+#include "Texture.h"
+#include "Vector4.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Camera;
+class Node;
+class RenderState;
+
+/**
+ * Defines the per-frame light lists of the clustered (Forward+) lighting path.
+ *
+ * The view frustum of the active camera is split into a grid of clusters: screen
+ * tiles in x and y, and slices that grow exponentially with the view depth. Each
+ * frame, update() gathers the lights of the scene and lists for every cluster the
+ * point and spot lights whose range overlaps it, on the job scheduler's workers.
+ * Directional lights reach every cluster and are listed once.
+ *
+ * The light data and lists are uploaded to textures, so that materials built with
+ * the CLUSTERED_LIGHTING define shade any number of lights with a single effect
+ * permutation, instead of one permutation per light type and count. Such materials
+ * read the textures through the parameters set by setMaterialParameters().
+ *
+ * The light data is stored in a floating point texture, which requires OpenGL 3.0,
+ * GL_ARB_texture_float or, on OpenGL ES, GL_OES_texture_float.
+ *
+ * @script{ignore}
+ */
+class LightClusters : public Ref
+{
+public:
+
+    /**
+     * Determines whether clustered lighting is supported on this device.
+     *
+     * @return true if the light data texture can be created, false otherwise.
+     */
+    static bool isSupported();
+
+    /**
+     * Creates the light clusters.
+     *
+     * @param tileCountX The number of screen tiles across the viewport.
+     * @param tileCountY The number of screen tiles down the viewport.
+     * @param sliceCount The number of depth slices between the camera's near and far planes.
+     * @param maxLightCount The largest number of lights, at most 256.
+     *
+     * @return The new light clusters, or NULL if clustered lighting is not supported.
+     */
+    static LightClusters* create(unsigned int tileCountX = 16, unsigned int tileCountY = 8, unsigned int sliceCount = 24, unsigned int maxLightCount = 256);
+
+    /**
+     * Rebuilds the light lists for the lights of a scene, as seen from its active camera.
+     *
+     * This should be called once per frame after the scene is updated and before it is drawn.
+     *
+     * @param scene The scene to gather the lights of.
+     */
+    void update(Scene* scene);
+
+    /**
+     * Gets the number of lights gathered by the last update.
+     *
+     * @return The number of lights.
+     */
+    unsigned int getLightCount() const;
+
+    /**
+     * Sets the clustered lighting parameters of a material, technique or pass.
+     *
+     * The parameters refer to these light clusters, which must outlive the render state.
+     *
+     * @param renderState The render state to set the parameters on.
+     */
+    void setMaterialParameters(RenderState* renderState);
+
+private:
+
+    struct ClusterLight
+    {
+        unsigned int index;
+        unsigned int tileMinX;
+        unsigned int tileMaxX;
+        unsigned int tileMinY;
+        unsigned int tileMaxY;
+        unsigned int sliceMin;
+        unsigned int sliceMax;
+    };
+
+    /**
+     * Constructor.
+     */
+    LightClusters();
+
+    /**
+     * Destructor.
+     */
+    ~LightClusters();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    LightClusters& operator=(const LightClusters&);
+
+    /**
+     * Scene visitor that collects the nodes that have a light.
+     */
+    bool gatherLight(Node* node);
+
+    /**
+     * Adds a light to the light data, returning its index or -1 if the data is full.
+     */
+    int addLight(const Vector3& position, float rangeInverse, const Vector3& color, float innerAngleCos, const Vector3& direction, float outerAngleCos);
+
+    /**
+     * Finds the clusters overlapped by a sphere in view space, returning false if there are none.
+     */
+    bool findClusters(const Vector3& center, float radius, Camera* camera, ClusterLight* light) const;
+
+    /**
+     * Job scheduler range function that lists the lights of a range of slices.
+     */
+    static void binSlices(unsigned int start, unsigned int end, void* cookie);
+
+    const Vector4& getScale() const;
+    const Vector4& getSize() const;
+    float getDirectionalLightCount() const;
+
+    unsigned int _tileCountX;
+    unsigned int _tileCountY;
+    unsigned int _sliceCount;
+    unsigned int _maxLightCount;
+    Texture::Sampler* _lightSampler;
+    Texture::Sampler* _countSampler;
+    Texture::Sampler* _indexSampler;
+    std::vector<float> _lightData;
+    std::vector<unsigned char> _countData;
+    std::vector<unsigned char> _indexData;
+    std::vector<Node*> _directionalNodes;
+    std::vector<Node*> _localNodes;
+    std::vector<ClusterLight> _clusterLights;
+    unsigned int _lightCount;
+    unsigned int _directionalLightCount;
+    Vector4 _scale;
+    Vector4 _size;
+    bool _overflowed;
+};
+
+}
+
+#endif
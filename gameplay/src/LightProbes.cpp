@@ -0,0 +1,110 @@
+#include "Base.h"
+#include "LightProbes.h"
+
+// Number of nearest probes blended at a position.
+#define LIGHT_PROBES_BLEND_COUNT 4
+
+namespace gameplay
+{
+
+LightProbes::LightProbes()
+{
+}
+
+LightProbes::~LightProbes()
+{
+}
+
+LightProbes* LightProbes::create(unsigned int count)
+{
+    LightProbes* probes = new LightProbes();
+    probes->_probes.resize(count);
+    return probes;
+}
+
+unsigned int LightProbes::getProbeCount() const
+{
+    return (unsigned int)_probes.size();
+}
+
+void LightProbes::setProbe(unsigned int index, const Vector3& position, const Vector4* irradiance)
+{
+    GP_ASSERT(index < _probes.size());
+    GP_ASSERT(irradiance);
+
+    Probe& probe = _probes[index];
+    probe.position = position;
+    probe.irradiance[0] = irradiance[0];
+    probe.irradiance[1] = irradiance[1];
+    probe.irradiance[2] = irradiance[2];
+}
+
+const Vector3& LightProbes::getProbePosition(unsigned int index) const
+{
+    GP_ASSERT(index < _probes.size());
+    return _probes[index].position;
+}
+
+bool LightProbes::evaluate(const Vector3& position, Vector4* dst) const
+{
+    GP_ASSERT(dst);
+
+    if (_probes.empty())
+        return false;
+
+    // The nearest probes, kept sorted by distance.
+    unsigned int nearest[LIGHT_PROBES_BLEND_COUNT];
+    float distances[LIGHT_PROBES_BLEND_COUNT];
+    unsigned int found = 0;
+    for (unsigned int i = 0, count = (unsigned int)_probes.size(); i < count; ++i)
+    {
+        float d = position.distanceSquared(_probes[i].position);
+        if (found == LIGHT_PROBES_BLEND_COUNT && d >= distances[found - 1])
+            continue;
+
+        unsigned int j = found < LIGHT_PROBES_BLEND_COUNT ? found++ : found - 1;
+        for (; j > 0 && distances[j - 1] > d; --j)
+        {
+            nearest[j] = nearest[j - 1];
+            distances[j] = distances[j - 1];
+        }
+        nearest[j] = i;
+        distances[j] = d;
+    }
+
+    // A position on a probe takes its irradiance alone.
+    if (distances[0] <= MATH_EPSILON)
+    {
+        const Probe& probe = _probes[nearest[0]];
+        dst[0] = probe.irradiance[0];
+        dst[1] = probe.irradiance[1];
+        dst[2] = probe.irradiance[2];
+        return true;
+    }
+
+    // Inverse square distance weights, so that moving between probes blends smoothly.
+    dst[0].set(0, 0, 0, 0);
+    dst[1].set(0, 0, 0, 0);
+    dst[2].set(0, 0, 0, 0);
+    float total = 0.0f;
+    for (unsigned int i = 0; i < found; ++i)
+    {
+        const Probe& probe = _probes[nearest[i]];
+        float weight = 1.0f / distances[i];
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            Vector4 irradiance(probe.irradiance[c]);
+            irradiance.scale(weight);
+            dst[c].add(irradiance);
+        }
+        total += weight;
+    }
+    float scale = 1.0f / total;
+    dst[0].scale(scale);
+    dst[1].scale(scale);
+    dst[2].scale(scale);
+
+    return true;
+}
+
+}
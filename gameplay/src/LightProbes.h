@@ -0,0 +1,107 @@
+#ifndef LIGHTPROBES_H_
+#define LIGHTPROBES_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a set of light probes baked by the encoder for lighting dynamic objects in a lightmapped scene.
+ *
+ * Static geometry gets its lighting from lightmaps, which dynamic objects cannot use. Each probe
+ * stores the irradiance arriving at a point of the scene as first order spherical harmonics: for
+ * each of the red, green and blue channels a Vector4 whose w is the average irradiance and whose
+ * xyz is its linear change with the direction of the normal. The irradiance for a world space
+ * normal n is then dot(probe, vec4(n, 1)), per channel.
+ *
+ * Materials get the probes interpolated at the position of their node through the
+ * SCENE_LIGHT_PROBE auto binding, with the directional part rotated into view space, and the
+ * lighting shaders use them in place of the ambient color when LIGHT_PROBES is defined.
+ *
+ * @script{ignore}
+ */
+class LightProbes : public Ref
+{
+public:
+
+    /**
+     * Creates a set of light probes, all at the origin with no irradiance.
+     *
+     * @param count The number of probes.
+     *
+     * @return The new light probes.
+     */
+    static LightProbes* create(unsigned int count);
+
+    /**
+     * Gets the number of probes.
+     *
+     * @return The number of probes.
+     */
+    unsigned int getProbeCount() const;
+
+    /**
+     * Sets a probe.
+     *
+     * @param index The index of the probe.
+     * @param position The position of the probe, in world space.
+     * @param irradiance The irradiance of the red, green and blue channels.
+     */
+    void setProbe(unsigned int index, const Vector3& position, const Vector4* irradiance);
+
+    /**
+     * Gets the position of a probe.
+     *
+     * @param index The index of the probe.
+     *
+     * @return The position of the probe, in world space.
+     */
+    const Vector3& getProbePosition(unsigned int index) const;
+
+    /**
+     * Interpolates the irradiance of the probes nearest to a position.
+     *
+     * @param position The position, in world space.
+     * @param dst The red, green and blue irradiance; 3 Vector4s.
+     *
+     * @return false if there are no probes, in which case dst is not changed.
+     */
+    bool evaluate(const Vector3& position, Vector4* dst) const;
+
+private:
+
+    struct Probe
+    {
+        Vector3 position;
+        Vector4 irradiance[3];
+    };
+
+    /**
+     * Constructor.
+     */
+    LightProbes();
+
+    /**
+     * Destructor.
+     */
+    ~LightProbes();
+
+    /**
+     * Hidden copy constructor.
+     */
+    LightProbes(const LightProbes& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    LightProbes& operator=(const LightProbes&);
+
+    std::vector<Probe> _probes;
+};
+
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "Base.h"
+#include "ListContainer.h"
+#include "AbsoluteLayout.h"
+
+namespace gameplay
+{
+
+ListContainer::ListContainer()
+    : _createRow(NULL), _bindRow(NULL), _cookie(NULL), _itemCount(0), _itemWidth(0), _itemHeight(0),
+      _columns(1), _rebind(false)
+{
+}
+
+ListContainer::~ListContainer()
+{
+    // The rows are released with the other controls of the container.
+}
+
+ListContainer* ListContainer::create(const char* id, Theme::Style* style)
+{
+    GP_ASSERT(style);
+
+    ListContainer* list = new ListContainer();
+    list->_layout = AbsoluteLayout::create();
+    list->_scroll = SCROLL_VERTICAL;
+    if (id)
+        list->_id = id;
+    list->_style = style;
+    return list;
+}
+
+ListContainer* ListContainer::create(Theme::Style* style, Properties* properties, Theme* theme)
+{
+    GP_ASSERT(properties);
+
+    ListContainer* list = new ListContainer();
+    list->_layout = AbsoluteLayout::create();
+    list->initialize(style, properties);
+    list->initializeScroll(properties);
+    list->_scroll = SCROLL_VERTICAL;
+    list->_itemWidth = properties->getFloat("itemWidth");
+    list->_itemHeight = properties->getFloat("itemHeight");
+    if (list->_itemHeight <= 0.0f)
+        GP_WARN("List '%s' has no item height; it shows no items until setItemSize() is called.", list->getId());
+
+    return list;
+}
+
+void ListContainer::setDataSource(CreateRowFunction createRow, BindRowFunction bindRow, void* cookie)
+{
+    _createRow = createRow;
+    _bindRow = bindRow;
+    _cookie = cookie;
+
+    // Rows made by the previous create function may not suit the new bind function.
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        removeControl(_rows[i]);
+    }
+    _rows.clear();
+    _rowItems.clear();
+    _dirty = true;
+}
+
+unsigned int ListContainer::getItemCount() const
+{
+    return _itemCount;
+}
+
+void ListContainer::setItemCount(unsigned int count)
+{
+    _itemCount = count;
+    _rebind = true;
+    _dirty = true;
+}
+
+float ListContainer::getItemWidth() const
+{
+    return _itemWidth;
+}
+
+float ListContainer::getItemHeight() const
+{
+    return _itemHeight;
+}
+
+void ListContainer::setItemSize(float width, float height)
+{
+    if (width < 0.0f || height < 0.0f)
+    {
+        GP_WARN("Invalid item size %f x %f.", width, height);
+        return;
+    }
+    _itemWidth = width;
+    _itemHeight = height;
+    _rebind = true;
+    _dirty = true;
+}
+
+void ListContainer::refresh()
+{
+    _rebind = true;
+    _dirty = true;
+}
+
+void ListContainer::scrollToItem(unsigned int item)
+{
+    // updateScroll() clamps the position to the content.
+    _scrollPosition.y = -(float)(item / _columns) * _itemHeight;
+    _scrollingVelocity.y = 0;
+    _dirty = true;
+}
+
+int ListContainer::getRowItem(const Control* row) const
+{
+    for (size_t i = 0, count = _rows.size(); i < count; ++i)
+    {
+        if (_rows[i] == row)
+            return _rowItems[i];
+    }
+    return -1;
+}
+
+unsigned int ListContainer::getRowCount() const
+{
+    return (unsigned int)_rows.size();
+}
+
+const char* ListContainer::getType() const
+{
+    return "list";
+}
+
+void ListContainer::getViewSize(float* width, float* height) const
+{
+    GP_ASSERT(width && height);
+
+    const Theme::Border& border = getBorder(_state);
+    const Theme::Padding& padding = getPadding();
+    *width = _bounds.width - border.left - border.right - padding.left - padding.right - getImageRegion("verticalScrollBar", _state).width;
+    *height = _bounds.height - border.top - border.bottom - padding.top - padding.bottom;
+}
+
+void ListContainer::update(const Control* container, const Vector2& offset)
+{
+    // The content is as large as all the items, however few rows exist, so that the scroll range covers them.
+    float viewWidth, viewHeight;
+    getViewSize(&viewWidth, &viewHeight);
+    unsigned int columns = 1;
+    if (_itemWidth > 0.0f && viewWidth > _itemWidth)
+        columns = (unsigned int)(viewWidth / _itemWidth);
+    if (columns != _columns)
+    {
+        _columns = columns;
+        _rebind = true;
+    }
+    _totalWidth = _itemWidth > 0.0f ? _columns * _itemWidth : std::max(viewWidth, 0.0f);
+    _totalHeight = ((_itemCount + _columns - 1) / _columns) * _itemHeight;
+
+    Container::update(container, offset);
+
+    // Scrolling has moved the view; the rows rebound to the items entering it are positioned again.
+    if (bindRows())
+        _layout->update(this, _scrollPosition);
+}
+
+bool ListContainer::bindRows()
+{
+    if (_createRow == NULL || _bindRow == NULL || _itemHeight <= 0.0f)
+        return false;
+
+    float viewWidth, viewHeight;
+    getViewSize(&viewWidth, &viewHeight);
+    if (viewHeight <= 0.0f)
+        return false;
+
+    // The window of items in view, which starts on a partly visible row and may end on one.
+    unsigned int firstRow = (unsigned int)(std::max(-_scrollPosition.y, 0.0f) / _itemHeight);
+    unsigned int visibleRows = (unsigned int)ceil(viewHeight / _itemHeight) + 1;
+    unsigned int capacity = visibleRows * _columns;
+    unsigned int first = std::min(firstRow * _columns, _itemCount);
+    unsigned int count = std::min(capacity, _itemCount - first);
+
+    bool changed = false;
+    if (_rows.size() < capacity)
+    {
+        while (_rows.size() < capacity)
+        {
+            Control* row = _createRow(this, _cookie);
+            if (row == NULL)
+            {
+                GP_ERROR("Failed to create a row of list '%s'.", getId());
+                break;
+            }
+            addControl(row);
+            row->release();
+            _rows.push_back(row);
+            _rowItems.push_back(-1);
+        }
+
+        // The rows map to the items by the size of the pool, which has changed.
+        _rebind = true;
+        changed = true;
+    }
+    if (_rows.empty())
+        return changed;
+
+    // Each item maps to the row of its index modulo the pool size, so a row keeps its item while it is in view.
+    float itemWidth = _itemWidth > 0.0f ? _itemWidth : viewWidth;
+    unsigned int poolSize = (unsigned int)_rows.size();
+    for (unsigned int i = 0; i < poolSize; ++i)
+    {
+        Control* row = _rows[i];
+        unsigned int item = first + (i + poolSize - first % poolSize) % poolSize;
+        if (item >= first + count)
+        {
+            if (row->isVisible())
+            {
+                row->setVisible(false);
+                changed = true;
+            }
+            _rowItems[i] = -1;
+            continue;
+        }
+
+        row->setPosition((item % _columns) * itemWidth, (item / _columns) * _itemHeight);
+        row->setSize(itemWidth, _itemHeight);
+        if (_rebind || _rowItems[i] != (int)item)
+        {
+            _rowItems[i] = (int)item;
+            row->setVisible(true);
+            _bindRow(this, row, item, _cookie);
+            changed = true;
+        }
+    }
+    _rebind = false;
+
+    return changed;
+}
+
+}
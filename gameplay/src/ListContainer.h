@@ -0,0 +1,224 @@
+#ifndef LISTCONTAINER_H_
+#define LISTCONTAINER_H_
+
+#include "Container.h"
+
+namespace gameplay
+{
+
+/**
+ * A list container is a vertically scrolling container that shows a list or grid of items
+ * with a small pool of row controls.
+ *
+ * A container holds a control for each of its children, so a list of thousands of items
+ * built with a plain container creates thousands of controls, each with its own state,
+ * layout and draw cost. A list container instead creates only enough row controls to cover
+ * its visible area, through a create function, and binds them to the items in view through
+ * a bind function. When the list scrolls, the rows that leave the view are bound to the items
+ * that enter it, so memory and update cost depend on the size of the list on screen, not on
+ * the number of items. The rows are ordinary controls: they scroll, take focus and handle
+ * input like the children of any container.
+ *
+ * Items are laid out in rows of the item height. If the item width is set, as many items as
+ * fit side by side share each row, forming a grid; otherwise each item spans the width of
+ * the list. A row that is rebound to another item keeps the state of its controls, so the
+ * bind function must set everything that differs between items.
+ *
+ * The following properties are available for list containers, in addition to the scrolling
+ * properties of containers:
+
+ @verbatim
+    list <listID>
+    {
+         style       = <styleID>
+         alignment   = <Control::Alignment constant> // Note: 'position' will be ignored.
+         position    = <x, y>
+         size        = <width, height>
+         itemWidth   = <width>   // Width of each item, to lay the items out in a grid. Default is the width of the list.
+         itemHeight  = <height>  // Height of each item.
+    }
+ @endverbatim
+ *
+ * @script{ignore}
+ */
+class ListContainer : public Container
+{
+    friend class Container;
+
+public:
+
+    /**
+     * The function that creates a row control.
+     *
+     * @param list The list the row is created for.
+     * @param cookie The cookie given to setDataSource().
+     *
+     * @return A new control, which the list releases when it is destroyed.
+     */
+    typedef Control* (*CreateRowFunction)(ListContainer* list, void* cookie);
+
+    /**
+     * The function that binds a row control to an item.
+     *
+     * @param list The list the row belongs to.
+     * @param row The row control.
+     * @param item The index of the item to show.
+     * @param cookie The cookie given to setDataSource().
+     */
+    typedef void (*BindRowFunction)(ListContainer* list, Control* row, unsigned int item, void* cookie);
+
+    /**
+     * Creates a new list container.
+     *
+     * @param id The list's ID.
+     * @param style The list's style.
+     *
+     * @return The new list.
+     */
+    static ListContainer* create(const char* id, Theme::Style* style);
+
+    /**
+     * Sets the functions that create the row controls and bind them to items.
+     *
+     * @param createRow The function that creates a row control.
+     * @param bindRow The function that binds a row control to an item.
+     * @param cookie The cookie passed to the functions.
+     */
+    void setDataSource(CreateRowFunction createRow, BindRowFunction bindRow, void* cookie);
+
+    /**
+     * Gets the number of items in the list.
+     *
+     * @return The number of items.
+     */
+    unsigned int getItemCount() const;
+
+    /**
+     * Sets the number of items in the list, and rebinds the visible rows.
+     *
+     * @param count The number of items.
+     */
+    void setItemCount(unsigned int count);
+
+    /**
+     * Gets the width of each item.
+     *
+     * @return The item width, or 0 if each item spans the width of the list.
+     */
+    float getItemWidth() const;
+
+    /**
+     * Gets the height of each item.
+     *
+     * @return The item height.
+     */
+    float getItemHeight() const;
+
+    /**
+     * Sets the size of each item.
+     *
+     * @param width The item width, or 0 for each item to span the width of the list.
+     * @param height The item height.
+     */
+    void setItemSize(float width, float height);
+
+    /**
+     * Rebinds the visible rows, after the items they show have changed.
+     */
+    void refresh();
+
+    /**
+     * Scrolls the list so that an item is at the top of the view, or as close as the list allows.
+     *
+     * @param item The index of the item.
+     */
+    void scrollToItem(unsigned int item);
+
+    /**
+     * Gets the item a row control shows.
+     *
+     * @param row A row control of this list.
+     *
+     * @return The index of the item, or -1 if the row is not in use.
+     */
+    int getRowItem(const Control* row) const;
+
+    /**
+     * Gets the number of row controls the list has created.
+     *
+     * @return The number of rows.
+     */
+    unsigned int getRowCount() const;
+
+    /**
+     * @see Control::getType
+     */
+    const char* getType() const;
+
+protected:
+
+    /**
+     * Constructor.
+     */
+    ListContainer();
+
+    /**
+     * Destructor.
+     */
+    ~ListContainer();
+
+    /**
+     * Creates a list container with a given style and properties.
+     *
+     * @param style The style to apply to the list.
+     * @param properties The properties to set on the list.
+     * @param theme The theme of the form.
+     *
+     * @return The new list.
+     */
+    static ListContainer* create(Theme::Style* style, Properties* properties, Theme* theme);
+
+    /**
+     * Sizes the content to the items, then binds the rows to the items in view.
+     *
+     * @see Container::update
+     */
+    void update(const Control* container, const Vector2& offset);
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    ListContainer(const ListContainer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ListContainer& operator=(const ListContainer&);
+
+    /**
+     * Gets the size of the area the items are shown in, inside the border, padding and scroll bar.
+     */
+    void getViewSize(float* width, float* height) const;
+
+    /**
+     * Binds the rows to the items in view, creating rows as needed. Returns true if any row changed.
+     */
+    bool bindRows();
+
+    CreateRowFunction _createRow;
+    BindRowFunction _bindRow;
+    void* _cookie;
+    unsigned int _itemCount;
+    float _itemWidth;
+    float _itemHeight;
+    unsigned int _columns;
+    bool _rebind;
+    std::vector<Control*> _rows;
+    std::vector<int> _rowItems;
+};
+
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include "Base.h"
+#include "LoadProfiler.h"
+#include "FileSystem.h"
+#include "Game.h"
+#include "Thread.h"
+
+namespace gameplay
+{
+
+struct OpenLoad
+{
+    unsigned int asset;
+    double start;
+    double childTime;
+};
+
+static bool __enabled = false;
+static std::string __output;
+static std::vector<LoadProfiler::Asset> __assets;
+static std::map<std::string, unsigned int> __assetIndices;     // Indices of the assets by type and path.
+static std::vector<OpenLoad> __openLoads;                       // Loads that are open, innermost last.
+
+static bool compareAssetTime(const LoadProfiler::Asset* a, const LoadProfiler::Asset* b)
+{
+    return a->time > b->time;
+}
+
+static void writeString(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (const char* c = str; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', file);
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+LoadProfiler::Scope::Scope(const char* type, const char* path, const char* id)
+    : _recording(LoadProfiler::begin(type, path, id))
+{
+}
+
+LoadProfiler::Scope::~Scope()
+{
+    if (_recording)
+        LoadProfiler::end();
+}
+
+LoadProfiler::Phase::Phase(PhaseType type)
+    : _type(type), _start(0.0), _recording(!__openLoads.empty() && Thread::isMainThread())
+{
+    if (_recording)
+        _start = Game::getAbsoluteTime();
+}
+
+LoadProfiler::Phase::~Phase()
+{
+    // The loads may have been cleared in between.
+    if (!_recording || __openLoads.empty())
+        return;
+
+    double time = Game::getAbsoluteTime() - _start;
+    for (size_t i = 0, count = __openLoads.size(); i < count; ++i)
+    {
+        Asset& asset = __assets[__openLoads[i].asset];
+        if (_type == DECODE)
+            asset.decodeTime += time;
+        else
+            asset.uploadTime += time;
+    }
+}
+
+bool LoadProfiler::isEnabled()
+{
+    return __enabled;
+}
+
+void LoadProfiler::setEnabled(bool enabled)
+{
+    __enabled = enabled;
+}
+
+bool LoadProfiler::begin(const char* type, const char* path, const char* id)
+{
+    GP_ASSERT(type);
+    GP_ASSERT(path);
+
+    if (!__enabled || !Thread::isMainThread())
+        return false;
+
+    std::string assetPath = path;
+    if (id)
+    {
+        assetPath += "#";
+        assetPath += id;
+    }
+
+    std::string key = type;
+    key += ":";
+    key += assetPath;
+    std::map<std::string, unsigned int>::iterator itr = __assetIndices.find(key);
+    unsigned int index;
+    if (itr == __assetIndices.end())
+    {
+        Asset asset;
+        asset.type = type;
+        asset.path = assetPath;
+        asset.loads = 0;
+        asset.time = 0.0;
+        asset.selfTime = 0.0;
+        asset.decodeTime = 0.0;
+        asset.uploadTime = 0.0;
+        asset.bytesRead = 0;
+        asset.root = false;
+        index = (unsigned int)__assets.size();
+        __assets.push_back(asset);
+        __assetIndices[key] = index;
+    }
+    else
+    {
+        index = itr->second;
+    }
+
+    Asset& asset = __assets[index];
+    ++asset.loads;
+    if (__openLoads.empty())
+        asset.root = true;
+
+    OpenLoad load;
+    load.asset = index;
+    load.start = Game::getAbsoluteTime();
+    load.childTime = 0.0;
+    __openLoads.push_back(load);
+    return true;
+}
+
+void LoadProfiler::end()
+{
+    if (__openLoads.empty() || !Thread::isMainThread())
+        return;
+
+    OpenLoad load = __openLoads.back();
+    __openLoads.pop_back();
+
+    double time = Game::getAbsoluteTime() - load.start;
+    Asset& asset = __assets[load.asset];
+    asset.time += time;
+    asset.selfTime += time - load.childTime;
+    if (!__openLoads.empty())
+        __openLoads.back().childTime += time;
+}
+
+void LoadProfiler::addBytesRead(size_t bytes)
+{
+    if (__openLoads.empty() || !Thread::isMainThread())
+        return;
+
+    for (size_t i = 0, count = __openLoads.size(); i < count; ++i)
+    {
+        __assets[__openLoads[i].asset].bytesRead += bytes;
+    }
+}
+
+unsigned int LoadProfiler::getAssetCount()
+{
+    return (unsigned int)__assets.size();
+}
+
+const LoadProfiler::Asset& LoadProfiler::getAsset(unsigned int index)
+{
+    GP_ASSERT(index < __assets.size());
+    return __assets[index];
+}
+
+void LoadProfiler::clear()
+{
+    // Loads that are still open stop being recorded.
+    __assets.clear();
+    __assetIndices.clear();
+    __openLoads.clear();
+}
+
+void LoadProfiler::print(unsigned int maxCount)
+{
+    std::vector<const Asset*> sorted(__assets.size());
+    for (size_t i = 0, count = __assets.size(); i < count; ++i)
+    {
+        sorted[i] = &__assets[i];
+    }
+    std::sort(sorted.begin(), sorted.end(), compareAssetTime);
+
+    gameplay::print("[load] %-10s %10s %10s %10s %10s %10s  %s\n", "type", "time ms", "self ms", "decode ms", "upload ms", "KB read", "path");
+    for (size_t i = 0, count = std::min(sorted.size(), (size_t)maxCount); i < count; ++i)
+    {
+        const Asset* asset = sorted[i];
+        gameplay::print("[load] %-10s %10.2f %10.2f %10.2f %10.2f %10.1f  %s\n", asset->type, asset->time, asset->selfTime,
+            asset->decodeTime, asset->uploadTime, asset->bytesRead / 1024.0, asset->path.c_str());
+    }
+}
+
+void LoadProfiler::writeReport(FILE* file)
+{
+    GP_ASSERT(file);
+
+    // The totals count the outermost loads only, since those contain the others.
+    double time = 0.0, decodeTime = 0.0, uploadTime = 0.0;
+    unsigned long long bytesRead = 0;
+    std::map<std::string, Asset> types;
+    std::vector<const Asset*> sorted(__assets.size());
+    for (size_t i = 0, count = __assets.size(); i < count; ++i)
+    {
+        const Asset& asset = __assets[i];
+        sorted[i] = &asset;
+        if (asset.root)
+        {
+            time += asset.time;
+            decodeTime += asset.decodeTime;
+            uploadTime += asset.uploadTime;
+            bytesRead += asset.bytesRead;
+        }
+
+        std::map<std::string, Asset>::iterator itr = types.find(asset.type);
+        if (itr == types.end())
+        {
+            types[asset.type] = asset;
+        }
+        else
+        {
+            itr->second.loads += asset.loads;
+            itr->second.selfTime += asset.selfTime;
+        }
+    }
+    std::sort(sorted.begin(), sorted.end(), compareAssetTime);
+
+    fprintf(file, "{\"time\":%.3f,\"decodeTime\":%.3f,\"uploadTime\":%.3f,\"bytesRead\":%llu,\"types\":[",
+        time, decodeTime, uploadTime, bytesRead);
+    for (std::map<std::string, Asset>::const_iterator itr = types.begin(); itr != types.end(); ++itr)
+    {
+        if (itr != types.begin())
+            fputc(',', file);
+        fputs("{\"type\":", file);
+        writeString(file, itr->first.c_str());
+        fprintf(file, ",\"loads\":%u,\"selfTime\":%.3f}", itr->second.loads, itr->second.selfTime);
+    }
+    fputs("],\"assets\":[", file);
+    for (size_t i = 0, count = sorted.size(); i < count; ++i)
+    {
+        const Asset* asset = sorted[i];
+        fputs(i == 0 ? "\n{\"type\":" : ",\n{\"type\":", file);
+        writeString(file, asset->type);
+        fputs(",\"path\":", file);
+        writeString(file, asset->path.c_str());
+        fprintf(file, ",\"loads\":%u,\"time\":%.3f,\"selfTime\":%.3f,\"decodeTime\":%.3f,\"uploadTime\":%.3f,\"bytesRead\":%llu}",
+            asset->loads, asset->time, asset->selfTime, asset->decodeTime, asset->uploadTime, asset->bytesRead);
+    }
+    fputs("\n]}", file);
+}
+
+bool LoadProfiler::write(const char* path)
+{
+    GP_ASSERT(path);
+
+    FILE* file = FileSystem::openFile(path, "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create load report file '%s'.", path);
+        return false;
+    }
+
+    writeReport(file);
+    fputc('\n', file);
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write load report file '%s'.", path);
+    }
+    return result;
+}
+
+void LoadProfiler::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    __enabled = properties->getBool("enabled");
+    if (properties->exists("output"))
+        __output = properties->getString("output");
+}
+
+void LoadProfiler::finalize()
+{
+    if (__enabled && !__output.empty())
+        write(__output.c_str());
+
+    __enabled = false;
+    __output.clear();
+    clear();
+}
+
+}
@@ -0,0 +1,246 @@
+#ifndef LOADPROFILER_H_
+#define LOADPROFILER_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Records the time spent loading each asset, and the bytes read and the decode and upload
+ * times of the load.
+ *
+ * Loads are recorded by the bundles, the meshes they hold, scenes, textures, images, effects,
+ * audio buffers and properties files. Loads nest: a scene load contains the loads of its
+ * bundle, materials and textures. The wall time, bytes read, decode time and upload time of a
+ * load include those of the loads it contains, while its self time does not. Loading the same
+ * asset again adds to its record; loads served by a resource cache are not recorded.
+ *
+ * The decode time covers decoding the file contents into memory (PNG images and audio files).
+ * The upload time covers handing the data to the GPU or the audio device (textures, vertex and
+ * index buffers, audio buffers) and compiling and linking effects. The bytes read are counted
+ * by the file streams.
+ *
+ * Loads are only recorded on the main thread, so the work of asynchronous loads on the worker
+ * threads is not counted. The profiler is configured in the game config:
+ *
+ * @verbatim
+    loadProfiler
+    {
+        enabled = true
+        output = loads.json     // File the report is written to when the game exits.
+    }
+   @endverbatim
+ *
+ * The benchmark mode also uses it to time the cold and warm loads of a scene (see Benchmark).
+ *
+ * @script{ignore}
+ */
+class LoadProfiler
+{
+    friend class Game;
+    friend class Benchmark;
+
+public:
+
+    /**
+     * The part of a load that a Phase times.
+     */
+    enum PhaseType
+    {
+        DECODE,
+        UPLOAD
+    };
+
+    /**
+     * Defines the record of an asset.
+     */
+    struct Asset
+    {
+        /**
+         * The type of the asset, such as "texture" or "mesh".
+         */
+        const char* type;
+
+        /**
+         * The path or URL of the asset.
+         */
+        std::string path;
+
+        /**
+         * The number of times the asset was loaded.
+         */
+        unsigned int loads;
+
+        /**
+         * The wall time of the loads, in milliseconds.
+         */
+        double time;
+
+        /**
+         * The wall time of the loads minus that of the loads they contain, in milliseconds.
+         */
+        double selfTime;
+
+        /**
+         * The time spent decoding, in milliseconds.
+         */
+        double decodeTime;
+
+        /**
+         * The time spent uploading, in milliseconds.
+         */
+        double uploadTime;
+
+        /**
+         * The number of bytes read from files.
+         */
+        unsigned long long bytesRead;
+
+        /**
+         * Whether the asset was loaded outside of any other recorded load.
+         */
+        bool root;
+    };
+
+    /**
+     * Records the load of an asset until the end of the enclosing block.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Begins the load of an asset.
+         *
+         * @param type The type of the asset, which must outlive the profiler (typically a literal).
+         * @param path The path or URL of the asset.
+         * @param id The id of the asset within the file, or NULL.
+         */
+        Scope(const char* type, const char* path, const char* id = NULL);
+
+        /**
+         * Ends the load.
+         */
+        ~Scope();
+
+    private:
+
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        bool _recording;
+    };
+
+    /**
+     * Times the decode or upload part of the loads that are open until the end of the enclosing block.
+     */
+    class Phase
+    {
+    public:
+
+        /**
+         * Begins the phase.
+         *
+         * @param type The part of the load being timed.
+         */
+        explicit Phase(PhaseType type);
+
+        /**
+         * Ends the phase.
+         */
+        ~Phase();
+
+    private:
+
+        Phase(const Phase&);
+        Phase& operator=(const Phase&);
+
+        PhaseType _type;
+        double _start;
+        bool _recording;
+    };
+
+    /**
+     * Returns whether loads are recorded.
+     *
+     * @return true if loads are recorded.
+     */
+    static bool isEnabled();
+
+    /**
+     * Starts or stops recording loads.
+     *
+     * @param enabled true to record loads.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Adds bytes read from a file to the loads that are open. Called by the file streams.
+     *
+     * @param bytes The number of bytes read.
+     */
+    static void addBytesRead(size_t bytes);
+
+    /**
+     * Gets the number of assets recorded.
+     *
+     * @return The number of assets.
+     */
+    static unsigned int getAssetCount();
+
+    /**
+     * Gets a recorded asset, in the order of their first load.
+     *
+     * @param index The index of the asset.
+     *
+     * @return The asset.
+     */
+    static const Asset& getAsset(unsigned int index);
+
+    /**
+     * Clears the recorded assets.
+     */
+    static void clear();
+
+    /**
+     * Logs the recorded assets, sorted by wall time.
+     *
+     * @param maxCount The number of assets to log.
+     */
+    static void print(unsigned int maxCount = 20);
+
+    /**
+     * Writes a report of the recorded assets as JSON, with the totals of the loads, the
+     * totals of each type and the assets sorted by wall time.
+     *
+     * @param path The path of the file.
+     *
+     * @return true if the file was written, false otherwise.
+     */
+    static bool write(const char* path);
+
+private:
+
+    /**
+     * Reads the settings from the 'loadProfiler' namespace of the game config.
+     */
+    static void initialize(Properties* properties);
+
+    /**
+     * Writes the report named in the config, if any, and clears the records.
+     */
+    static void finalize();
+
+    /**
+     * Writes the report of the recorded assets as a JSON object to an open file.
+     */
+    static void writeReport(FILE* file);
+
+    static bool begin(const char* type, const char* path, const char* id);
+    static void end();
+};
+
+}
+
+#endif
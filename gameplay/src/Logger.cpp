@@ -1,12 +1,338 @@
 #include "Base.h"
 #include "Game.h"
 #include "ScriptController.h"
+#include "Thread.h"
+
+// The size of an entry of the asynchronous queue, including the text stored in place.
+#define LOG_ENTRY_SIZE 256
+
+// The default number of entries of the asynchronous queue.
+#define LOG_DEFAULT_CAPACITY 1024
+
+// Older compilers do not define va_copy; copying the list is enough on their platforms.
+#ifndef va_copy
+#define va_copy(dest, src) ((dest) = (src))
+#endif
 
 namespace gameplay
 {
 
 Logger::State Logger::_state[3];
 
+/**
+ * Formats a message into the given buffer, or into the dynamic buffer if it does not fit.
+ *
+ * @return The formatted message.
+ */
+static char* formatMessage(char* buffer, int size, std::vector<char>& dynamicBuffer, const char* message, va_list args)
+{
+    char* str = buffer;
+    for ( ; ; )
+    {
+        va_list copy;
+        va_copy(copy, args);
+        int needed = vsnprintf(str, size, message, copy);
+        va_end(copy);
+
+        // NOTE: Some platforms return -1 when vsnprintf runs out of room, while others return
+        // the number of characters actually needed to fill the buffer.
+        if (needed >= 0 && needed < size)
+        {
+            // Successfully wrote buffer. Added a NULL terminator in case it wasn't written.
+            str[needed] = '\0';
+            return str;
+        }
+
+        size = needed > 0 ? (needed + 1) : (size * 2);
+        dynamicBuffer.resize(size);
+        str = &dynamicBuffer[0];
+    }
+}
+
+/**
+ * The queue of the asynchronous mode and the background thread that outputs it.
+ *
+ * The queue is a bounded ring of entries that any number of threads write and the
+ * background thread reads. Each entry carries a sequence number that tells whether it
+ * is free for the writer of a given position or ready for the reader, so writers only
+ * contend on the write position and never wait for each other or for the reader.
+ */
+class LogQueue
+{
+public:
+
+    LogQueue(unsigned int capacity);
+
+    ~LogQueue();
+
+    bool start();
+
+    void push(Logger::Level level, const char* message, va_list args);
+
+    void flush();
+
+    void stop();
+
+    bool isLogThread() const;
+
+private:
+
+    struct Entry
+    {
+        AtomicInt sequence;
+        Logger::Level level;
+        char* longText;
+        char text[LOG_ENTRY_SIZE - sizeof(AtomicInt) - sizeof(Logger::Level) - sizeof(char*)];
+    };
+
+    static void threadMain(void* arg);
+
+    bool pop();
+
+    void append(Logger::Level level, const char* text);
+
+    void endLine();
+
+    void reportRepeats();
+
+    void reportDropped();
+
+    Entry* _entries;
+    unsigned int _capacity;
+    AtomicInt _writePosition;
+    unsigned int _readPosition;
+    AtomicInt _dropped;
+    AtomicInt _sleeping;
+    Thread* _thread;
+    Mutex _mutex;
+    Condition _wake;
+    Condition _flushed;
+    unsigned int _flushRequest;
+    unsigned int _flushDone;
+    bool _stopping;
+
+    // The state of the background thread: the line being assembled and the last line output.
+    std::string _line;
+    Logger::Level _lineLevel;
+    std::string _previousLine;
+    Logger::Level _previousLevel;
+    unsigned int _repeats;
+};
+
+static LogQueue* __logQueue = NULL;
+
+LogQueue::LogQueue(unsigned int capacity)
+    : _entries(NULL), _capacity(capacity), _readPosition(0), _thread(NULL), _flushRequest(0), _flushDone(0), _stopping(false),
+    _lineLevel(Logger::LEVEL_INFO), _previousLevel(Logger::LEVEL_INFO), _repeats(0)
+{
+    GP_ASSERT(_capacity > 0 && (_capacity & (_capacity - 1)) == 0);
+
+    _entries = new Entry[_capacity];
+    for (unsigned int i = 0; i < _capacity; ++i)
+    {
+        _entries[i].sequence.set((int)i);
+        _entries[i].longText = NULL;
+    }
+}
+
+LogQueue::~LogQueue()
+{
+    GP_ASSERT(_thread == NULL);
+
+    for (unsigned int i = 0; i < _capacity; ++i)
+    {
+        SAFE_DELETE_ARRAY(_entries[i].longText);
+    }
+    SAFE_DELETE_ARRAY(_entries);
+}
+
+bool LogQueue::start()
+{
+    _thread = Thread::create(threadMain, this);
+    return _thread != NULL;
+}
+
+void LogQueue::push(Logger::Level level, const char* message, va_list args)
+{
+    // Claim the entry at the write position, unless the reader has not freed it yet.
+    unsigned int position = (unsigned int)_writePosition.get();
+    Entry* entry;
+    for ( ; ; )
+    {
+        entry = &_entries[position & (_capacity - 1)];
+        int difference = (int)((unsigned int)entry->sequence.get() - position);
+        if (difference == 0)
+        {
+            if (_writePosition.compareExchange((int)position, (int)(position + 1)))
+                break;
+        }
+        else if (difference < 0)
+        {
+            _dropped.increment();
+            return;
+        }
+        position = (unsigned int)_writePosition.get();
+    }
+
+    // Messages that do not fit in the entry are moved to the heap.
+    entry->level = level;
+    std::vector<char> dynamicBuffer;
+    char* str = formatMessage(entry->text, (int)sizeof(entry->text), dynamicBuffer, message, args);
+    if (str != entry->text)
+    {
+        entry->longText = new char[dynamicBuffer.size()];
+        strcpy(entry->longText, str);
+    }
+
+    // Publish the entry, and wake the background thread if it waits for work.
+    entry->sequence.set((int)(position + 1));
+    if (_sleeping.get())
+    {
+        MutexLock lock(_mutex);
+        _wake.signal();
+    }
+}
+
+void LogQueue::flush()
+{
+    GP_ASSERT(!isLogThread());
+
+    MutexLock lock(_mutex);
+    unsigned int request = ++_flushRequest;
+    _wake.signal();
+    while ((int)(_flushDone - request) < 0)
+    {
+        _flushed.wait(_mutex);
+    }
+}
+
+void LogQueue::stop()
+{
+    {
+        MutexLock lock(_mutex);
+        _stopping = true;
+        _wake.signal();
+    }
+    _thread->join();
+    SAFE_DELETE(_thread);
+}
+
+bool LogQueue::isLogThread() const
+{
+    return _thread && _thread->isCurrent();
+}
+
+void LogQueue::threadMain(void* arg)
+{
+    LogQueue* queue = (LogQueue*)arg;
+    for ( ; ; )
+    {
+        if (queue->pop())
+            continue;
+
+        // The queue is empty: output the rest of an unfinished line.
+        queue->endLine();
+        queue->reportDropped();
+
+        unsigned int request;
+        bool stopping;
+        {
+            MutexLock lock(queue->_mutex);
+            request = queue->_flushRequest;
+            stopping = queue->_stopping;
+        }
+
+        // A flush also reports the repeats, so that they come before the messages that follow it.
+        if (request != queue->_flushDone || stopping)
+        {
+            queue->reportRepeats();
+            queue->_previousLine.clear();
+
+            MutexLock lock(queue->_mutex);
+            queue->_flushDone = request;
+            queue->_flushed.broadcast();
+            if (stopping)
+                return;
+            continue;
+        }
+
+        MutexLock lock(queue->_mutex);
+        queue->_sleeping.set(1);
+        const Entry& next = queue->_entries[queue->_readPosition & (queue->_capacity - 1)];
+        if ((unsigned int)next.sequence.get() != queue->_readPosition + 1 && queue->_flushRequest == queue->_flushDone && !queue->_stopping)
+            queue->_wake.wait(queue->_mutex);
+        queue->_sleeping.set(0);
+    }
+}
+
+bool LogQueue::pop()
+{
+    Entry& entry = _entries[_readPosition & (_capacity - 1)];
+    if ((unsigned int)entry.sequence.get() != _readPosition + 1)
+        return false;
+
+    append(entry.level, entry.longText ? entry.longText : entry.text);
+    SAFE_DELETE_ARRAY(entry.longText);
+
+    // Free the entry for the writer of the same slot in the next round of the ring.
+    entry.sequence.set((int)(_readPosition + _capacity));
+    ++_readPosition;
+    return true;
+}
+
+void LogQueue::append(Logger::Level level, const char* text)
+{
+    if (!_line.empty() && level != _lineLevel)
+        endLine();
+
+    _lineLevel = level;
+    _line += text;
+    if (!_line.empty() && _line[_line.size() - 1] == '\n')
+        endLine();
+}
+
+void LogQueue::endLine()
+{
+    if (_line.empty())
+        return;
+
+    if (_repeats < 0xFFFFFFFF && _lineLevel == _previousLevel && _line == _previousLine)
+    {
+        ++_repeats;
+    }
+    else
+    {
+        reportRepeats();
+        Logger::dispatch(_lineLevel, _line.c_str());
+        _previousLine.swap(_line);
+        _previousLevel = _lineLevel;
+    }
+    _line.clear();
+}
+
+void LogQueue::reportRepeats()
+{
+    if (_repeats == 0)
+        return;
+
+    char str[64];
+    sprintf(str, "(last message repeated %u times)\n", _repeats);
+    _repeats = 0;
+    Logger::dispatch(_previousLevel, str);
+}
+
+void LogQueue::reportDropped()
+{
+    int dropped = _dropped.get();
+    if (dropped == 0)
+        return;
+
+    _dropped.add(-dropped);
+    char str[96];
+    sprintf(str, "(%d log messages dropped because the log queue was full)\n", dropped);
+    Logger::dispatch(Logger::LEVEL_WARN, str);
+}
+
 Logger::State::State() : logFunctionC(NULL), logFunctionLua(NULL), enabled(true)
 {
 }
@@ -28,31 +354,36 @@ void Logger::log(Level level, const char* message, ...)
     va_list args;
     va_start(args, message);
 
-    // Declare a moderately sized buffer on the stack that should be
-    // large enough to accommodate most log requests.
-    int size = 1024;
-    char stackBuffer[1024];
-    std::vector<char> dynamicBuffer;
-    char* str = stackBuffer;
-    for ( ; ; )
+    // Errors end the game and Lua functions run on the main thread, so they are output right away.
+    if (__logQueue && level != LEVEL_ERROR && state.logFunctionLua == NULL && !__logQueue->isLogThread())
     {
-        // Pass one less than size to leave room for NULL terminator
-        int needed = vsnprintf(str, size-1, message, args);
-
-        // NOTE: Some platforms return -1 when vsnprintf runs out of room, while others return
-        // the number of characters actually needed to fill the buffer.
-        if (needed >= 0 && needed < size)
-        {
-            // Successfully wrote buffer. Added a NULL terminator in case it wasn't written.
-            str[needed] = '\0';
-            break;
-        }
+        __logQueue->push(level, message, args);
+    }
+    else
+    {
+        if (__logQueue && !__logQueue->isLogThread())
+            __logQueue->flush();
 
-        size = needed > 0 ? (needed + 1) : (size * 2);
-        dynamicBuffer.resize(size);
-        str = &dynamicBuffer[0];
+        // Declare a moderately sized buffer on the stack that should be
+        // large enough to accommodate most log requests.
+        char stackBuffer[1024];
+        std::vector<char> dynamicBuffer;
+        char* str = formatMessage(stackBuffer, 1024, dynamicBuffer, message, args);
+        dispatch(level, str);
     }
 
+    va_end(args);
+}
+
+void Logger::flush()
+{
+    if (__logQueue && !__logQueue->isLogThread())
+        __logQueue->flush();
+}
+
+void Logger::dispatch(Level level, const char* str)
+{
+    State& state = _state[level];
     if (state.logFunctionC)
     {
         // Pass call to registered C log function
@@ -66,10 +397,8 @@ void Logger::log(Level level, const char* message, ...)
     else
     {
         // Log to the default output
-        gameplay::print(str);
+        gameplay::print("%s", str);
     }
-
-    va_end(args);
 }
 
 bool Logger::isEnabled(Level level)
@@ -84,6 +413,9 @@ void Logger::setEnabled(Level level, bool enabled)
 
 void Logger::set(Level level, void (*logFunction) (Level, const char*))
 {
+    // Queued messages go to the function that was set when they were logged.
+    flush();
+
     State& state = _state[level];
     state.logFunctionC = logFunction;
     state.logFunctionLua = NULL;
@@ -91,9 +423,45 @@ void Logger::set(Level level, void (*logFunction) (Level, const char*))
 
 void Logger::set(Level level, const char* logFunction)
 {
+    flush();
+
     State& state = _state[level];
     state.logFunctionLua = logFunction;
     state.logFunctionC = NULL;
 }
 
+void Logger::initializeAsync(Properties* properties)
+{
+    if (__logQueue || properties == NULL || !properties->getBool("asynchronous"))
+        return;
+
+    // The capacity is rounded up to a power of two so that positions wrap with a mask.
+    unsigned int capacity = LOG_DEFAULT_CAPACITY;
+    if (properties->exists("capacity"))
+    {
+        int requested = std::max(2, std::min(1 << 20, properties->getInt("capacity")));
+        for (capacity = 2; capacity < (unsigned int)requested; capacity <<= 1);
+    }
+    LogQueue* queue = new LogQueue(capacity);
+    if (!queue->start())
+    {
+        SAFE_DELETE(queue);
+        GP_WARN("Failed to create the logging thread; logging stays synchronous.");
+        return;
+    }
+    __logQueue = queue;
+}
+
+void Logger::finalizeAsync()
+{
+    if (__logQueue == NULL)
+        return;
+
+    // Log synchronously from here on, then output what is left in the queue.
+    LogQueue* queue = __logQueue;
+    __logQueue = NULL;
+    queue->stop();
+    SAFE_DELETE(queue);
+}
+
 }
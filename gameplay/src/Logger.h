@@ -4,6 +4,8 @@
 namespace gameplay
 {
 
+class Properties;
+
 /**
  * Provides a basic logging system for the game.
  *
@@ -13,9 +15,37 @@ namespace gameplay
  * can be modified for a specific log level by passing a custom C or Lua logging
  * function to the Logger::set method. Logging can also be toggled using the
  * setEnabled method.
+ *
+ * Logging can be made asynchronous in the game config, so that the output of the
+ * messages, which can be slow on some platforms, no longer stalls the threads that
+ * log them:
+
+ @verbatim
+    logging
+    {
+        asynchronous = true     // queue messages for a background thread (default false)
+        capacity = 1024         // number of messages the queue holds (default 1024)
+    }
+ @endverbatim
+ *
+ * In the asynchronous mode, messages are formatted by the logging thread into a
+ * lock-free queue of fixed-size entries, and the background thread passes them to
+ * the print function or to the C log functions. The pieces of a line are passed
+ * together, and a line that repeats the previous one is counted instead of being
+ * output again; the count is reported once a different line is logged or the log is
+ * flushed. Messages that are logged while the queue is full are dropped and counted.
+ * Errors, levels handled by a Lua function and messages logged by the C log functions
+ * themselves are output right away, after the queue has been flushed.
+ *
+ * GP_LOG_LEVEL sets the lowest level kept by the GP_WARN and GP_ERROR macros at
+ * compile time (see Logger::Level). Defining it to 2 compiles the warnings out of a
+ * build; errors are always kept since they end the game.
  */
 class Logger
 {
+    friend class Game;
+    friend class LogQueue;
+
 public:
 
     /** 
@@ -40,6 +70,13 @@ public:
      */
     static void log(Level level, const char* message, ...);
 
+    /**
+     * Waits until the messages queued by the asynchronous mode have been output.
+     *
+     * This has no effect when logging is synchronous.
+     */
+    static void flush();
+
     /**
      * Determines if logging is currently enabled for the given level.
      *
@@ -66,6 +103,8 @@ public:
      *
      * Passing NULL for logFunction restores the default log behavior for this level.
      *
+     * In the asynchronous mode, the function is called on the background logging thread.
+     *
      * @param level Log level to set logging callback for.
      * @param logFunction Pointer to a C function to call for each log request at the given log level.
      * @script{ignore}
@@ -115,6 +154,21 @@ private:
      */
     Logger& operator=(const Logger&);
 
+    /**
+     * Starts the background logging thread if the config asks for it (called by Game on startup).
+     */
+    static void initializeAsync(Properties* properties);
+
+    /**
+     * Outputs the queued messages and stops the background logging thread (called by Game during shutdown).
+     */
+    static void finalizeAsync();
+
+    /**
+     * Passes a formatted message to the log function of its level, or prints it.
+     */
+    static void dispatch(Level level, const char* str);
+
     static State _state[3];
 
 };
@@ -11,7 +11,7 @@ namespace gameplay
 {
 
 Material::Material() :
-    _currentTechnique(NULL)
+    _currentTechnique(NULL), _shared(false), _depthPrePass(true)
 {
 }
 
@@ -37,6 +37,10 @@ Material* Material::create(const char* url)
 
     Material* material = create((strlen(properties->getNamespace()) > 0) ? properties : properties->getNextNamespace());
     SAFE_DELETE(properties);
+    if (material)
+    {
+        material->_url = url;
+    }
 
     return material;
 }
@@ -70,6 +74,8 @@ Material* Material::create(Properties* materialProperties)
 
     // Load uniform value parameters for this material.
     loadRenderState(material, materialProperties);
+    material->_shared = materialProperties->getBool("shared");
+    material->_depthPrePass = materialProperties->getBool("depthPrePass", true);
 
     // Set the current technique to the first found technique.
     if (material->getTechniqueCount() > 0)
@@ -165,10 +171,59 @@ void Material::setTechnique(const char* id)
     }
 }
 
+Technique* Material::getLodTechnique(float distance, float screenSize) const
+{
+    Technique* technique = _currentTechnique;
+    for (size_t i = 0, count = _techniques.size(); i < count; ++i)
+    {
+        if (_techniques[i]->isLodSelected(distance, screenSize))
+            technique = _techniques[i];
+    }
+    return technique;
+}
+
+bool Material::hasLodTechniques() const
+{
+    for (size_t i = 0, count = _techniques.size(); i < count; ++i)
+    {
+        if (_techniques[i]->getLodDistance() > 0.0f || _techniques[i]->getLodScreenSize() > 0.0f)
+            return true;
+    }
+    return false;
+}
+
+void Material::setShared(bool shared)
+{
+    _shared = shared;
+}
+
+bool Material::isShared() const
+{
+    return _shared;
+}
+
+void Material::setDepthPrePassEnabled(bool enabled)
+{
+    _depthPrePass = enabled;
+}
+
+bool Material::isDepthPrePassEnabled() const
+{
+    return _depthPrePass;
+}
+
+const char* Material::getUrl() const
+{
+    return _url.c_str();
+}
+
 Material* Material::clone(NodeCloneContext &context) const
 {
     Material* material = new Material();
     RenderState::cloneInto(material, context);
+    material->_shared = _shared;
+    material->_depthPrePass = _depthPrePass;
+    material->_url = _url;
 
     for (std::vector<Technique*>::const_iterator it = _techniques.begin(); it != _techniques.end(); ++it)
     {
@@ -211,6 +266,7 @@ bool Material::loadTechnique(Material* material, Properties* techniqueProperties
 
     // Load uniform value parameters for this technique.
     loadRenderState(technique, techniqueProperties);
+    technique->setLod(techniqueProperties->getFloat("lodDistance"), techniqueProperties->getFloat("lodScreenSize"));
 
     // Add the new technique to the material.
     material->_techniques.push_back(technique);
@@ -251,12 +307,15 @@ static bool isMaterialKeyword(const char* str)
 {
     GP_ASSERT(str);
 
-    #define MATERIAL_KEYWORD_COUNT 3
+    #define MATERIAL_KEYWORD_COUNT 6
     static const char* reservedKeywords[MATERIAL_KEYWORD_COUNT] =
     {
         "vertexShader",
         "fragmentShader",
-        "defines"
+        "defines",
+        "shared",
+        "lodDistance",
+        "lodScreenSize"
     };
     for (unsigned int i = 0; i < MATERIAL_KEYWORD_COUNT; ++i)
     {
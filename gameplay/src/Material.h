@@ -25,6 +25,7 @@ class Material : public RenderState
     friend class RenderState;
     friend class Node;
     friend class Model;
+    friend class SceneLoader;
 
 public:
 
@@ -117,6 +118,83 @@ public:
      */
     void setTechnique(const char* id);
 
+    /**
+     * Returns the technique to draw a model with at the specified distance and screen size.
+     *
+     * Techniques with level of detail thresholds (see Technique::setLod) are cheaper versions of
+     * the current technique, declared from the nearest to the farthest, e.g. a technique without
+     * normal mapping followed by an unlit one. The last of them whose threshold is passed is
+     * returned, or the current technique if none is, so a material without thresholds always
+     * draws with its current technique. Models select the technique for each draw, so a material
+     * shared by models at different distances draws each with its own technique.
+     *
+     * @param distance The distance of the model from the camera.
+     * @param screenSize The fraction of the viewport height covered by the model's bounding sphere.
+     *
+     * @return The technique to draw with.
+     * @script{ignore}
+     */
+    Technique* getLodTechnique(float distance, float screenSize) const;
+
+    /**
+     * Determines if any technique of this material has level of detail thresholds.
+     *
+     * @return true if getLodTechnique may select a technique other than the current one.
+     * @script{ignore}
+     */
+    bool hasLodTechniques() const;
+
+    /**
+     * Sets whether this material is shared by the models it is set on.
+     *
+     * A shared material is not cloned along with its model: the clone references the same
+     * material. Models switch the node binding of a shared material each time they draw,
+     * so values that differ between them must be set through Model::getInstanceParameter
+     * rather than on the material. This can be set in a material file with 'shared = true'.
+     *
+     * @param shared true to share the material between models, false to clone it.
+     */
+    void setShared(bool shared);
+
+    /**
+     * Returns whether this material is shared by the models it is set on.
+     *
+     * @return true if the material is shared, false otherwise.
+     */
+    bool isShared() const;
+
+    /**
+     * Sets whether this material is drawn after a depth pre-pass when its render queue has one.
+     *
+     * The pre-pass writes the depth of the opaque materials with a minimal effect, so that the
+     * main pass only shades the visible fragments. Materials whose shaders move or discard
+     * fragments (e.g. vertex animation or alpha testing) must opt out, since the pre-pass would
+     * not write the depth they end up with. This can be set in a material file with
+     * 'depthPrePass = false'.
+     *
+     * @param enabled true to draw the material after the depth pre-pass (the default), false to opt out.
+     * @script{ignore}
+     */
+    void setDepthPrePassEnabled(bool enabled);
+
+    /**
+     * Returns whether this material is drawn after a depth pre-pass when its render queue has one.
+     *
+     * @return true if the material is drawn after the depth pre-pass, false if it opted out.
+     * @script{ignore}
+     */
+    bool isDepthPrePassEnabled() const;
+
+    /**
+     * Gets the URL of the material file this material was loaded from.
+     *
+     * Materials loaded from the same URL start out identical, which lets StaticBatcher
+     * merge the geometry of nodes that each have their own copy of a material.
+     *
+     * @return The URL, or an empty string if the material was not loaded from a file.
+     */
+    const char* getUrl() const;
+
 private:
 
     /**
@@ -161,6 +239,9 @@ private:
 
     Technique* _currentTechnique;
     std::vector<Technique*> _techniques;
+    bool _shared;
+    bool _depthPrePass;
+    std::string _url;
 };
 
 }
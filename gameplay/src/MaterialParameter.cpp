@@ -1,12 +1,14 @@
 #include "Base.h"
 #include "MaterialParameter.h"
+#include "RenderState.h"
 #include "Node.h"
 
 namespace gameplay
 {
 
 MaterialParameter::MaterialParameter(const char* name) :
-    _type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""), _uniform(NULL)
+    _type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""),
+    _handle(RenderState::getParameterHandle(_name.c_str())), _uniform(NULL)
 {
     clearValue();
 }
@@ -446,7 +448,7 @@ void MaterialParameter::setSamplerArray(const Texture::Sampler** values, unsigne
     _type = MaterialParameter::SAMPLER_ARRAY;
 }
 
-void MaterialParameter::bind(Effect* effect)
+Uniform* MaterialParameter::getUniform(Effect* effect)
 {
     GP_ASSERT(effect);
 
@@ -456,13 +458,22 @@ void MaterialParameter::bind(Effect* effect)
     {
         _uniform = effect->getUniform(_name.c_str());
 
+        // The null graphics backend of headless builds reports no uniforms at all.
+#ifndef GP_HEADLESS
         if (!_uniform)
         {
             // This parameter was not found in the specified effect, so do nothing.
             GP_WARN("Warning: Material parameter '%s' not found in effect '%s'.", _name.c_str(), effect->getId());
-            return;
         }
+#endif
     }
+    return _uniform;
+}
+
+void MaterialParameter::bind(Effect* effect)
+{
+    if (!getUniform(effect))
+        return;
 
     switch (_type)
     {
@@ -500,6 +511,9 @@ void MaterialParameter::bind(Effect* effect)
         GP_ASSERT(_value.method);
         _value.method->setValue(effect);
         break;
+    case MaterialParameter::AUTO:
+        // Built-in auto bindings are set by the render state that owns them, which knows its node.
+        break;
     default:
         GP_ERROR("Unsupported material parameter type (%d).", _type);
         break;
@@ -837,6 +851,9 @@ void MaterialParameter::cloneInto(MaterialParameter* materialParameter) const
         GP_ASSERT(materialParameter->_value.method);
         materialParameter->_value.method->addRef();
         break;
+    case AUTO:
+        materialParameter->_value.autoBinding = _value.autoBinding;
+        break;
     default:
         GP_ERROR("Unsupported material parameter type(%d).", _type);
         break;
@@ -2,6 +2,7 @@
 #define MATERIALPARAMETER_H_
 
 #include "AnimationTarget.h"
+#include "Allocator.h"
 #include "Vector2.h"
 #include "Vector3.h"
 #include "Vector4.h"
@@ -37,6 +38,10 @@ namespace gameplay
 class MaterialParameter : public AnimationTarget, public Ref
 {
     friend class RenderState;
+    friend class Model;
+    friend class Picker;
+
+    GP_POOLED_ALLOCATION(MATERIAL)
 
 public:
 
@@ -430,6 +435,11 @@ private:
 
     void clearValue();
 
+    /**
+     * Returns the uniform of this parameter in the specified effect, or NULL if the effect has none.
+     */
+    Uniform* getUniform(Effect* effect);
+
     void bind(Effect* effect);
 
     void applyAnimationValue(AnimationValue* value, float blendWeight, int components);
@@ -452,6 +462,8 @@ private:
         const Texture::Sampler** samplerArrayValue;
         /** @script{ignore} */
         MethodBinding* method;
+        /** @script{ignore} */
+        int autoBinding;
     } _value;
     
     enum
@@ -467,12 +479,14 @@ private:
         MATRIX,
         SAMPLER,
         SAMPLER_ARRAY,
-        METHOD
+        METHOD,
+        AUTO
     } _type;
     
     unsigned int _count;
     bool _dynamic;
     std::string _name;
+    unsigned int _handle;
     Uniform* _uniform;
 };
 
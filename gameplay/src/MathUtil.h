@@ -10,6 +10,7 @@ class MathUtil
 {
     friend class Matrix;
     friend class Vector3;
+    friend class MeshSkin;
 
 public:
 
@@ -54,6 +55,8 @@ private:
 
     inline static void multiplyMatrix(const float* m1, const float* m2, float* dst);
 
+    inline static void multiplyMatrixPalette(const float* m1, const float* m2, float* dst);
+
     inline static void negateMatrix(const float* m, float* dst);
 
     inline static void transposeMatrix(const float* m, float* dst);
@@ -62,6 +65,15 @@ private:
 
     inline static void transformVector4(const float* m, const float* v, float* dst);
 
+    /**
+     * Transforms count three component vectors by m, using w as their fourth component.
+     *
+     * The strides are the distances in bytes between consecutive vectors of v and dst.
+     * v and dst may be the same array if they have the same stride.
+     */
+    inline static void transformVector4Array(const float* m, const float* v, unsigned int vStride, float w,
+                                             float* dst, unsigned int dstStride, unsigned int count);
+
     inline static void crossVector3(const float* v1, const float* v2, float* dst);
 
     MathUtil();
@@ -73,6 +85,8 @@ private:
 
 #ifdef USE_NEON
 #include "MathUtilNeon.inl"
+#elif defined(USE_SSE)
+#include "MathUtilSSE.inl"
 #else
 #include "MathUtil.inl"
 #endif
@@ -109,6 +109,25 @@ inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* ds
     memcpy(dst, product, MATRIX_SIZE);
 }
 
+inline void MathUtil::multiplyMatrixPalette(const float* m1, const float* m2, float* dst)
+{
+    // Stores the first three rows of m1 * m2 as three consecutive row vectors.
+    dst[0]  = m1[0] * m2[0]  + m1[4] * m2[1]  + m1[8]  * m2[2]  + m1[12] * m2[3];
+    dst[1]  = m1[0] * m2[4]  + m1[4] * m2[5]  + m1[8]  * m2[6]  + m1[12] * m2[7];
+    dst[2]  = m1[0] * m2[8]  + m1[4] * m2[9]  + m1[8]  * m2[10] + m1[12] * m2[11];
+    dst[3]  = m1[0] * m2[12] + m1[4] * m2[13] + m1[8]  * m2[14] + m1[12] * m2[15];
+
+    dst[4]  = m1[1] * m2[0]  + m1[5] * m2[1]  + m1[9]  * m2[2]  + m1[13] * m2[3];
+    dst[5]  = m1[1] * m2[4]  + m1[5] * m2[5]  + m1[9]  * m2[6]  + m1[13] * m2[7];
+    dst[6]  = m1[1] * m2[8]  + m1[5] * m2[9]  + m1[9]  * m2[10] + m1[13] * m2[11];
+    dst[7]  = m1[1] * m2[12] + m1[5] * m2[13] + m1[9]  * m2[14] + m1[13] * m2[15];
+
+    dst[8]  = m1[2] * m2[0]  + m1[6] * m2[1]  + m1[10] * m2[2]  + m1[14] * m2[3];
+    dst[9]  = m1[2] * m2[4]  + m1[6] * m2[5]  + m1[10] * m2[6]  + m1[14] * m2[7];
+    dst[10] = m1[2] * m2[8]  + m1[6] * m2[9]  + m1[10] * m2[10] + m1[14] * m2[11];
+    dst[11] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
+}
+
 inline void MathUtil::negateMatrix(const float* m, float* dst)
 {
     dst[0]  = -m[0];
@@ -161,6 +180,27 @@ inline void MathUtil::transformVector4(const float* m, const float* v, float* ds
     dst[3] = w;
 }
 
+inline void MathUtil::transformVector4Array(const float* m, const float* v, unsigned int vStride, float w,
+                                            float* dst, unsigned int dstStride, unsigned int count)
+{
+    const float tx = w * m[12];
+    const float ty = w * m[13];
+    const float tz = w * m[14];
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + tx;
+        float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + ty;
+        float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + tz;
+
+        dst[0] = x;
+        dst[1] = y;
+        dst[2] = z;
+
+        v = (const float*)((const unsigned char*)v + vStride);
+        dst = (float*)((unsigned char*)dst + dstStride);
+    }
+}
+
 inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
 {
     float x = (v1[1] * v2[2]) - (v1[2] * v2[1]);
@@ -123,6 +123,48 @@ inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* ds
     );
 }
 
+inline void MathUtil::multiplyMatrixPalette(const float* m1, const float* m2, float* dst)
+{
+    asm volatile(
+        "vld1.32     {d16 - d19}, [%1]! \n\t"       // M1[m0-m7]
+        "vld1.32     {d20 - d23}, [%1]  \n\t"       // M1[m8-m15]
+        "vld1.32     {d0 - d3}, [%2]!   \n\t"       // M2[m0-m7]
+        "vld1.32     {d4 - d7}, [%2]    \n\t"       // M2[m8-m15]
+
+        "vmul.f32    q12, q8, d0[0]     \n\t"         // P[m0-m3] = M1[m0-m3] * M2[m0]
+        "vmul.f32    q13, q8, d2[0]     \n\t"         // P[m4-m7] = M1[m4-m7] * M2[m4]
+        "vmul.f32    q14, q8, d4[0]     \n\t"         // P[m8-m11] = M1[m8-m11] * M2[m8]
+        "vmul.f32    q15, q8, d6[0]     \n\t"         // P[m12-m15] = M1[m12-m15] * M2[m12]
+
+        "vmla.f32    q12, q9, d0[1]     \n\t"         // P[m0-m3] += M1[m0-m3] * M2[m1]
+        "vmla.f32    q13, q9, d2[1]     \n\t"         // P[m4-m7] += M1[m4-m7] * M2[m5]
+        "vmla.f32    q14, q9, d4[1]     \n\t"         // P[m8-m11] += M1[m8-m11] * M2[m9]
+        "vmla.f32    q15, q9, d6[1]     \n\t"         // P[m12-m15] += M1[m12-m15] * M2[m13]
+
+        "vmla.f32    q12, q10, d1[0]    \n\t"         // P[m0-m3] += M1[m0-m3] * M2[m2]
+        "vmla.f32    q13, q10, d3[0]    \n\t"         // P[m4-m7] += M1[m4-m7] * M2[m6]
+        "vmla.f32    q14, q10, d5[0]    \n\t"         // P[m8-m11] += M1[m8-m11] * M2[m10]
+        "vmla.f32    q15, q10, d7[0]    \n\t"         // P[m12-m15] += M1[m12-m15] * M2[m14]
+
+        "vmla.f32    q12, q11, d1[1]    \n\t"         // P[m0-m3] += M1[m0-m3] * M2[m3]
+        "vmla.f32    q13, q11, d3[1]    \n\t"         // P[m4-m7] += M1[m4-m7] * M2[m7]
+        "vmla.f32    q14, q11, d5[1]    \n\t"         // P[m8-m11] += M1[m8-m11] * M2[m11]
+        "vmla.f32    q15, q11, d7[1]    \n\t"         // P[m12-m15] += M1[m12-m15] * M2[m15]
+
+        "vtrn.32     q12, q13           \n\t"         // Transpose the product columns into rows
+        "vtrn.32     q14, q15           \n\t"
+        "vswp        d25, d28           \n\t"
+        "vswp        d27, d30           \n\t"
+
+        "vst1.32    {d24 - d27}, [%0]!  \n\t"       // DST[row0, row1]
+        "vst1.32    {d28 - d29}, [%0]   \n\t"       // DST[row2]
+
+        : // output
+        : "r"(dst), "r"(m1), "r"(m2) // input - note *value* of pointer doesn't change.
+        : "memory", "q0", "q1", "q2", "q3", "q8", "q9", "q10", "q11", "q12", "q13", "q14", "q15"
+    );
+}
+
 inline void MathUtil::negateMatrix(const float* m, float* dst)
 {
     asm volatile(
@@ -201,6 +243,18 @@ inline void MathUtil::transformVector4(const float* m, const float* v, float* ds
     );
 }
 
+inline void MathUtil::transformVector4Array(const float* m, const float* v, unsigned int vStride, float w,
+                                            float* dst, unsigned int dstStride, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        transformVector4(m, v[0], v[1], v[2], w, dst);
+
+        v = (const float*)((const unsigned char*)v + vStride);
+        dst = (float*)((unsigned char*)dst + dstStride);
+    }
+}
+
 inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
 {
     asm volatile(
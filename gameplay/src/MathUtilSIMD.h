@@ -0,0 +1,156 @@
+#ifndef MATHUTILSIMD_H_
+#define MATHUTILSIMD_H_
+
+// Four-lane float vectors for the batch kernels of the engine (particles, sprites, curves,
+// heightfields and occlusion). GP_SIMD is defined when the NEON or SSE2 backend selected
+// by Base.h is available; each kernel keeps a scalar loop for the other targets and for
+// the elements left over after the last group of four.
+//
+// Loads and stores are unaligned. FLOAT4_ROUND rounds halfway cases away from zero on
+// both backends, like roundf, whatever the rounding mode of the FPU.
+#if defined(USE_NEON)
+    #include <arm_neon.h>
+    #define GP_SIMD
+#elif defined(USE_SSE)
+    #include <emmintrin.h>
+    #define GP_SIMD
+#endif
+
+#ifdef GP_SIMD
+
+namespace gameplay
+{
+
+#if defined(USE_NEON)
+
+typedef float32x4_t float4;
+
+#define FLOAT4_LOAD(p)              vld1q_f32(p)
+#define FLOAT4_STORE(p, v)          vst1q_f32(p, v)
+#define FLOAT4_SET(s)               vdupq_n_f32(s)
+#define FLOAT4_ADD(a, b)            vaddq_f32(a, b)
+#define FLOAT4_SUB(a, b)            vsubq_f32(a, b)
+#define FLOAT4_MUL(a, b)            vmulq_f32(a, b)
+#define FLOAT4_MADD(a, b, c)        vmlaq_f32(a, b, c)
+#define FLOAT4_MIN(a, b)            vminq_f32(a, b)
+#define FLOAT4_MAX(a, b)            vmaxq_f32(a, b)
+#define FLOAT4_ABS(a)               vabsq_f32(a)
+#define FLOAT4_TRUNC(a)             vcvtq_f32_s32(vcvtq_s32_f32(a))
+#define FLOAT4_SELECT_GREATER(a, b, x, y) vbslq_f32(vcgtq_f32(a, b), x, y)
+
+/**
+ * Computes the reciprocal square roots of four floats.
+ *
+ * The estimate is refined with two Newton-Raphson steps, which is accurate to about 1e-7.
+ */
+inline float4 float4ReciprocalSqrt(float4 a)
+{
+    float32x4_t e = vrsqrteq_f32(a);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+    return e;
+}
+
+/**
+ * Loads four unsigned bytes as floats.
+ */
+inline float4 float4LoadU8(const unsigned char* p)
+{
+    uint32_t bits;
+    memcpy(&bits, p, sizeof(bits));
+    uint16x8_t v = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+}
+
+/**
+ * Loads four little endian unsigned shorts, stored as eight bytes, as floats.
+ */
+inline float4 float4LoadU16(const unsigned char* p)
+{
+    return vcvtq_f32_u32(vmovl_u16(vreinterpret_u16_u8(vld1_u8(p))));
+}
+
+#else
+
+typedef __m128 float4;
+
+#define FLOAT4_LOAD(p)              _mm_loadu_ps(p)
+#define FLOAT4_STORE(p, v)          _mm_storeu_ps(p, v)
+#define FLOAT4_SET(s)               _mm_set1_ps(s)
+#define FLOAT4_ADD(a, b)            _mm_add_ps(a, b)
+#define FLOAT4_SUB(a, b)            _mm_sub_ps(a, b)
+#define FLOAT4_MUL(a, b)            _mm_mul_ps(a, b)
+#define FLOAT4_MADD(a, b, c)        _mm_add_ps(a, _mm_mul_ps(b, c))
+#define FLOAT4_MIN(a, b)            _mm_min_ps(a, b)
+#define FLOAT4_MAX(a, b)            _mm_max_ps(a, b)
+#define FLOAT4_ABS(a)               _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define FLOAT4_TRUNC(a)             _mm_cvtepi32_ps(_mm_cvttps_epi32(a))
+#define FLOAT4_SELECT_GREATER(a, b, x, y) gameplay::float4Select(_mm_cmpgt_ps(a, b), x, y)
+
+/**
+ * Selects the lanes of x where the mask is set and the lanes of y elsewhere.
+ */
+inline float4 float4Select(float4 mask, float4 x, float4 y)
+{
+    return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+}
+
+/**
+ * Computes the reciprocal square roots of four floats.
+ */
+inline float4 float4ReciprocalSqrt(float4 a)
+{
+    return _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a));
+}
+
+/**
+ * Loads four unsigned bytes as floats.
+ */
+inline float4 float4LoadU8(const unsigned char* p)
+{
+    int bits;
+    memcpy(&bits, p, sizeof(bits));
+    __m128i zero = _mm_setzero_si128();
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero));
+}
+
+/**
+ * Loads four little endian unsigned shorts, stored as eight bytes, as floats.
+ */
+inline float4 float4LoadU16(const unsigned char* p)
+{
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128()));
+}
+
+#endif
+
+#define FLOAT4_ROUND(a)             gameplay::float4Round(a)
+
+/**
+ * Sets the four lanes of a float4.
+ */
+inline float4 float4Set(float a, float b, float c, float d)
+{
+    const float values[4] = { a, b, c, d };
+    return FLOAT4_LOAD(values);
+}
+
+/**
+ * Rounds four floats to the nearest integer, rounding halfway cases away from zero.
+ *
+ * The fraction is taken exactly from the truncated value, so values just below one half
+ * round down. The floats must be smaller than 2^31 in magnitude.
+ */
+inline float4 float4Round(float4 a)
+{
+    float4 whole = FLOAT4_TRUNC(a);
+    float4 step = FLOAT4_SELECT_GREATER(FLOAT4_SET(0.0f), a, FLOAT4_SET(-1.0f), FLOAT4_SET(1.0f));
+    float4 fraction = FLOAT4_ABS(FLOAT4_SUB(a, whole));
+    return FLOAT4_ADD(whole, FLOAT4_SELECT_GREATER(FLOAT4_SET(0.5f), fraction, FLOAT4_SET(0.0f), step));
+}
+
+}
+
+#endif
+
+#endif
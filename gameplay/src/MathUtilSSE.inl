@@ -0,0 +1,229 @@
+#if defined(__AVX__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace gameplay
+{
+
+// Matrices are not guaranteed to be 16 byte aligned, so all loads and stores are unaligned.
+
+inline void MathUtil::addMatrix(const float* m, float scalar, float* dst)
+{
+#if defined(__AVX__)
+    __m256 s = _mm256_set1_ps(scalar);
+    _mm256_storeu_ps(&dst[0], _mm256_add_ps(_mm256_loadu_ps(&m[0]), s));
+    _mm256_storeu_ps(&dst[8], _mm256_add_ps(_mm256_loadu_ps(&m[8]), s));
+#else
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(&dst[0],  _mm_add_ps(_mm_loadu_ps(&m[0]),  s));
+    _mm_storeu_ps(&dst[4],  _mm_add_ps(_mm_loadu_ps(&m[4]),  s));
+    _mm_storeu_ps(&dst[8],  _mm_add_ps(_mm_loadu_ps(&m[8]),  s));
+    _mm_storeu_ps(&dst[12], _mm_add_ps(_mm_loadu_ps(&m[12]), s));
+#endif
+}
+
+inline void MathUtil::addMatrix(const float* m1, const float* m2, float* dst)
+{
+#if defined(__AVX__)
+    _mm256_storeu_ps(&dst[0], _mm256_add_ps(_mm256_loadu_ps(&m1[0]), _mm256_loadu_ps(&m2[0])));
+    _mm256_storeu_ps(&dst[8], _mm256_add_ps(_mm256_loadu_ps(&m1[8]), _mm256_loadu_ps(&m2[8])));
+#else
+    _mm_storeu_ps(&dst[0],  _mm_add_ps(_mm_loadu_ps(&m1[0]),  _mm_loadu_ps(&m2[0])));
+    _mm_storeu_ps(&dst[4],  _mm_add_ps(_mm_loadu_ps(&m1[4]),  _mm_loadu_ps(&m2[4])));
+    _mm_storeu_ps(&dst[8],  _mm_add_ps(_mm_loadu_ps(&m1[8]),  _mm_loadu_ps(&m2[8])));
+    _mm_storeu_ps(&dst[12], _mm_add_ps(_mm_loadu_ps(&m1[12]), _mm_loadu_ps(&m2[12])));
+#endif
+}
+
+inline void MathUtil::subtractMatrix(const float* m1, const float* m2, float* dst)
+{
+#if defined(__AVX__)
+    _mm256_storeu_ps(&dst[0], _mm256_sub_ps(_mm256_loadu_ps(&m1[0]), _mm256_loadu_ps(&m2[0])));
+    _mm256_storeu_ps(&dst[8], _mm256_sub_ps(_mm256_loadu_ps(&m1[8]), _mm256_loadu_ps(&m2[8])));
+#else
+    _mm_storeu_ps(&dst[0],  _mm_sub_ps(_mm_loadu_ps(&m1[0]),  _mm_loadu_ps(&m2[0])));
+    _mm_storeu_ps(&dst[4],  _mm_sub_ps(_mm_loadu_ps(&m1[4]),  _mm_loadu_ps(&m2[4])));
+    _mm_storeu_ps(&dst[8],  _mm_sub_ps(_mm_loadu_ps(&m1[8]),  _mm_loadu_ps(&m2[8])));
+    _mm_storeu_ps(&dst[12], _mm_sub_ps(_mm_loadu_ps(&m1[12]), _mm_loadu_ps(&m2[12])));
+#endif
+}
+
+inline void MathUtil::multiplyMatrix(const float* m, float scalar, float* dst)
+{
+#if defined(__AVX__)
+    __m256 s = _mm256_set1_ps(scalar);
+    _mm256_storeu_ps(&dst[0], _mm256_mul_ps(_mm256_loadu_ps(&m[0]), s));
+    _mm256_storeu_ps(&dst[8], _mm256_mul_ps(_mm256_loadu_ps(&m[8]), s));
+#else
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(&dst[0],  _mm_mul_ps(_mm_loadu_ps(&m[0]),  s));
+    _mm_storeu_ps(&dst[4],  _mm_mul_ps(_mm_loadu_ps(&m[4]),  s));
+    _mm_storeu_ps(&dst[8],  _mm_mul_ps(_mm_loadu_ps(&m[8]),  s));
+    _mm_storeu_ps(&dst[12], _mm_mul_ps(_mm_loadu_ps(&m[12]), s));
+#endif
+}
+
+// Returns the column c of m1 * m2, for the columns c0-c3 of m1 (sums in the same order as the scalar code).
+#define MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, c) \
+    _mm_add_ps(_mm_add_ps(_mm_add_ps( \
+        _mm_mul_ps(c0, _mm_set1_ps((m2)[(c) * 4])), \
+        _mm_mul_ps(c1, _mm_set1_ps((m2)[(c) * 4 + 1]))), \
+        _mm_mul_ps(c2, _mm_set1_ps((m2)[(c) * 4 + 2]))), \
+        _mm_mul_ps(c3, _mm_set1_ps((m2)[(c) * 4 + 3])))
+
+inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* dst)
+{
+    // Every column is computed before storing, which supports the case where m1 or m2 is the same array as dst.
+#if defined(__AVX__)
+    // Two columns at a time: each lane of the m2 vectors holds one column, which is broadcast within the lane.
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)&m1[0]);
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)&m1[4]);
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)&m1[8]);
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)&m1[12]);
+    __m256 b01 = _mm256_loadu_ps(&m2[0]);
+    __m256 b23 = _mm256_loadu_ps(&m2[8]);
+
+    __m256 p01 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(c0, _mm256_permute_ps(b01, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm256_mul_ps(c1, _mm256_permute_ps(b01, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm256_mul_ps(c2, _mm256_permute_ps(b01, _MM_SHUFFLE(2, 2, 2, 2)))),
+        _mm256_mul_ps(c3, _mm256_permute_ps(b01, _MM_SHUFFLE(3, 3, 3, 3))));
+    __m256 p23 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(c0, _mm256_permute_ps(b23, _MM_SHUFFLE(0, 0, 0, 0))),
+        _mm256_mul_ps(c1, _mm256_permute_ps(b23, _MM_SHUFFLE(1, 1, 1, 1)))),
+        _mm256_mul_ps(c2, _mm256_permute_ps(b23, _MM_SHUFFLE(2, 2, 2, 2)))),
+        _mm256_mul_ps(c3, _mm256_permute_ps(b23, _MM_SHUFFLE(3, 3, 3, 3))));
+
+    _mm256_storeu_ps(&dst[0], p01);
+    _mm256_storeu_ps(&dst[8], p23);
+#else
+    __m128 c0 = _mm_loadu_ps(&m1[0]);
+    __m128 c1 = _mm_loadu_ps(&m1[4]);
+    __m128 c2 = _mm_loadu_ps(&m1[8]);
+    __m128 c3 = _mm_loadu_ps(&m1[12]);
+
+    __m128 p0 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 0);
+    __m128 p1 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 1);
+    __m128 p2 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 2);
+    __m128 p3 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 3);
+
+    _mm_storeu_ps(&dst[0],  p0);
+    _mm_storeu_ps(&dst[4],  p1);
+    _mm_storeu_ps(&dst[8],  p2);
+    _mm_storeu_ps(&dst[12], p3);
+#endif
+}
+
+inline void MathUtil::multiplyMatrixPalette(const float* m1, const float* m2, float* dst)
+{
+    // Stores the first three rows of m1 * m2 as three consecutive row vectors.
+    __m128 c0 = _mm_loadu_ps(&m1[0]);
+    __m128 c1 = _mm_loadu_ps(&m1[4]);
+    __m128 c2 = _mm_loadu_ps(&m1[8]);
+    __m128 c3 = _mm_loadu_ps(&m1[12]);
+
+    __m128 p0 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 0);
+    __m128 p1 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 1);
+    __m128 p2 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 2);
+    __m128 p3 = MATHUTIL_SSE_COLUMN(c0, c1, c2, c3, m2, 3);
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+    _mm_storeu_ps(&dst[0], p0);
+    _mm_storeu_ps(&dst[4], p1);
+    _mm_storeu_ps(&dst[8], p2);
+}
+
+#undef MATHUTIL_SSE_COLUMN
+
+inline void MathUtil::negateMatrix(const float* m, float* dst)
+{
+    // Flipping the sign bit also negates zeros, as the scalar code does.
+#if defined(__AVX__)
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    _mm256_storeu_ps(&dst[0], _mm256_xor_ps(_mm256_loadu_ps(&m[0]), sign));
+    _mm256_storeu_ps(&dst[8], _mm256_xor_ps(_mm256_loadu_ps(&m[8]), sign));
+#else
+    __m128 sign = _mm_set1_ps(-0.0f);
+    _mm_storeu_ps(&dst[0],  _mm_xor_ps(_mm_loadu_ps(&m[0]),  sign));
+    _mm_storeu_ps(&dst[4],  _mm_xor_ps(_mm_loadu_ps(&m[4]),  sign));
+    _mm_storeu_ps(&dst[8],  _mm_xor_ps(_mm_loadu_ps(&m[8]),  sign));
+    _mm_storeu_ps(&dst[12], _mm_xor_ps(_mm_loadu_ps(&m[12]), sign));
+#endif
+}
+
+inline void MathUtil::transposeMatrix(const float* m, float* dst)
+{
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(&dst[0],  c0);
+    _mm_storeu_ps(&dst[4],  c1);
+    _mm_storeu_ps(&dst[8],  c2);
+    _mm_storeu_ps(&dst[12], c3);
+}
+
+inline void MathUtil::transformVector4(const float* m, float x, float y, float z, float w, float* dst)
+{
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(&m[0]),  _mm_set1_ps(x)),
+        _mm_mul_ps(_mm_loadu_ps(&m[4]),  _mm_set1_ps(y))),
+        _mm_mul_ps(_mm_loadu_ps(&m[8]),  _mm_set1_ps(z))),
+        _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(w)));
+
+    // dst only holds three components.
+    _mm_storel_pi((__m64*)&dst[0], r);
+    _mm_store_ss(&dst[2], _mm_movehl_ps(r, r));
+}
+
+inline void MathUtil::transformVector4(const float* m, const float* v, float* dst)
+{
+    // Handle case where v == dst.
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(&m[0]),  _mm_set1_ps(v[0])),
+        _mm_mul_ps(_mm_loadu_ps(&m[4]),  _mm_set1_ps(v[1]))),
+        _mm_mul_ps(_mm_loadu_ps(&m[8]),  _mm_set1_ps(v[2]))),
+        _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(v[3])));
+    _mm_storeu_ps(dst, r);
+}
+
+inline void MathUtil::transformVector4Array(const float* m, const float* v, unsigned int vStride, float w,
+                                            float* dst, unsigned int dstStride, unsigned int count)
+{
+    // The matrix stays in registers for the whole array.
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 t = _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(w));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // The vectors only hold three components, so they are loaded one component at a time.
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(c0, _mm_set1_ps(v[0])),
+            _mm_mul_ps(c1, _mm_set1_ps(v[1]))),
+            _mm_mul_ps(c2, _mm_set1_ps(v[2]))),
+            t);
+        _mm_storel_pi((__m64*)&dst[0], r);
+        _mm_store_ss(&dst[2], _mm_movehl_ps(r, r));
+
+        v = (const float*)((const unsigned char*)v + vStride);
+        dst = (float*)((unsigned char*)dst + dstStride);
+    }
+}
+
+inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
+{
+    // Vectors only hold three components, which cannot be loaded into a register without reading past them.
+    float x = (v1[1] * v2[2]) - (v1[2] * v2[1]);
+    float y = (v1[2] * v2[0]) - (v1[0] * v2[2]);
+    float z = (v1[0] * v2[1]) - (v1[1] * v2[0]);
+
+    dst[0] = x;
+    dst[1] = y;
+    dst[2] = z;
+}
+
+}
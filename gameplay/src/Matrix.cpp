@@ -927,6 +927,32 @@ void Matrix::transformVector(const Vector4& vector, Vector4* dst) const
     MathUtil::transformVector4(m, (const float*) &vector, (float*)dst);
 }
 
+void Matrix::transformPoints(const Vector3* points, unsigned int count, Vector3* dst) const
+{
+    transformPoints((const float*)points, sizeof(Vector3), count, (float*)dst, sizeof(Vector3));
+}
+
+void Matrix::transformPoints(const float* points, unsigned int stride, unsigned int count, float* dst, unsigned int dstStride) const
+{
+    GP_ASSERT(count == 0 || (points && dst));
+
+    MathUtil::transformVector4Array(m, points, stride ? stride : sizeof(float) * 3, 1.0f,
+                                    dst, dstStride ? dstStride : sizeof(float) * 3, count);
+}
+
+void Matrix::transformVectors(const Vector3* vectors, unsigned int count, Vector3* dst) const
+{
+    transformVectors((const float*)vectors, sizeof(Vector3), count, (float*)dst, sizeof(Vector3));
+}
+
+void Matrix::transformVectors(const float* vectors, unsigned int stride, unsigned int count, float* dst, unsigned int dstStride) const
+{
+    GP_ASSERT(count == 0 || (vectors && dst));
+
+    MathUtil::transformVector4Array(m, vectors, stride ? stride : sizeof(float) * 3, 0.0f,
+                                    dst, dstStride ? dstStride : sizeof(float) * 3, count);
+}
+
 void Matrix::translate(float x, float y, float z)
 {
     translate(x, y, z, this);
@@ -798,6 +798,57 @@ public:
      */
     void transformVector(const Vector4& vector, Vector4* dst) const;
 
+    /**
+     * Transforms an array of points by this matrix, and stores the
+     * results in dst.
+     *
+     * @param points The points to transform.
+     * @param count The number of points.
+     * @param dst An array of count points to store the transformed points in (may be points).
+     * @script{ignore}
+     */
+    void transformPoints(const Vector3* points, unsigned int count, Vector3* dst) const;
+
+    /**
+     * Transforms an array of points, stored as consecutive x, y and z coordinates
+     * with the given stride, by this matrix and stores the results in dst.
+     *
+     * This can be used to transform the positions of interleaved vertex data in place.
+     *
+     * @param points The x-coordinate of the first point to transform.
+     * @param stride The distance in bytes between consecutive points, or 0 if they are tightly packed.
+     * @param count The number of points.
+     * @param dst The x-coordinate of the first transformed point (may be points).
+     * @param dstStride The distance in bytes between consecutive transformed points, or 0 if they are tightly packed.
+     * @script{ignore}
+     */
+    void transformPoints(const float* points, unsigned int stride, unsigned int count, float* dst, unsigned int dstStride) const;
+
+    /**
+     * Transforms an array of vectors by this matrix by treating their
+     * fourth (w) coordinate as zero, and stores the results in dst.
+     *
+     * @param vectors The vectors to transform.
+     * @param count The number of vectors.
+     * @param dst An array of count vectors to store the transformed vectors in (may be vectors).
+     * @script{ignore}
+     */
+    void transformVectors(const Vector3* vectors, unsigned int count, Vector3* dst) const;
+
+    /**
+     * Transforms an array of vectors, stored as consecutive x, y and z coordinates
+     * with the given stride, by this matrix by treating their fourth (w) coordinate
+     * as zero, and stores the results in dst.
+     *
+     * @param vectors The x-coordinate of the first vector to transform.
+     * @param stride The distance in bytes between consecutive vectors, or 0 if they are tightly packed.
+     * @param count The number of vectors.
+     * @param dst The x-coordinate of the first transformed vector (may be vectors).
+     * @param dstStride The distance in bytes between consecutive transformed vectors, or 0 if they are tightly packed.
+     * @script{ignore}
+     */
+    void transformVectors(const float* vectors, unsigned int stride, unsigned int count, float* dst, unsigned int dstStride) const;
+
     /**
      * Post-multiplies this matrix by the matrix corresponding to the
      * specified translation.
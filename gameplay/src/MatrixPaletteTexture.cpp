@@ -0,0 +1,234 @@
+#include "Base.h"
+#include "MatrixPaletteTexture.h"
+#include "RenderCommandList.h"
+#include "Effect.h"
+#include "MeshSkin.h"
+#include "RenderStats.h"
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+
+// Define that selects the palette texture in skinning.vert, and the define whose value
+// is the joint count of the uniform palette it replaces.
+#define PALETTE_TEXTURE_DEFINE "SKINNING_TEXTURE"
+#define JOINT_COUNT_DEFINE "SKINNING_JOINT_COUNT"
+// Define that selects dual quaternion palettes in skinning.vert.
+#define DUAL_QUATERNION_DEFINE "SKINNING_DUAL_QUATERNION"
+
+namespace gameplay
+{
+
+MatrixPaletteTexture::MatrixPaletteTexture()
+    : _enabled(false), _size(256), _sampler(NULL), _texelCount(0), _overflowed(false), _paletteCount(0),
+      _lastPaletteCount(0), _lastTexelCount(0)
+{
+}
+
+MatrixPaletteTexture::~MatrixPaletteTexture()
+{
+}
+
+bool MatrixPaletteTexture::isSupported()
+{
+    // Detected on first use.
+    static int support = -1;
+    if (support == -1)
+    {
+        GLint vertexUnits = 0;
+        GL_ASSERT( glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexUnits) );
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+#ifdef OPENGL_ES
+        bool floatTextures = extensions && strstr(extensions, "GL_OES_texture_float");
+#else
+        const char* version = (const char*)glGetString(GL_VERSION);
+        bool floatTextures = (version && version[0] >= '3' && version[0] <= '9') || (extensions && strstr(extensions, "GL_ARB_texture_float"));
+#endif
+        support = vertexUnits > 0 && floatTextures ? 1 : 0;
+    }
+    return support == 1;
+}
+
+void MatrixPaletteTexture::initialize(Properties* properties)
+{
+    MeshSkin::setDualQuaternionEnabled(properties && properties->getBool("dualQuaternion"));
+
+    if (properties == NULL || !properties->getBool("paletteTexture"))
+        return;
+
+    if (!isSupported())
+    {
+        GP_WARN("The matrix palette texture needs vertex texture fetch and floating point textures; skins keep their uniform palettes.");
+        return;
+    }
+    if (properties->exists("paletteTextureSize"))
+    {
+        int size = properties->getInt("paletteTextureSize");
+        if (size < 16 || size > 4096)
+        {
+            GP_WARN("Invalid matrix palette texture size %d; it must be between 16 and 4096.", size);
+        }
+        else
+        {
+            _size = (unsigned int)size;
+        }
+    }
+    _enabled = true;
+}
+
+void MatrixPaletteTexture::finalize()
+{
+    SAFE_RELEASE(_sampler);
+    _offsets.clear();
+    _enabled = false;
+}
+
+bool MatrixPaletteTexture::isEnabled() const
+{
+    return _enabled;
+}
+
+unsigned int MatrixPaletteTexture::getSize() const
+{
+    return _size;
+}
+
+unsigned int MatrixPaletteTexture::getPaletteCount() const
+{
+    return _lastPaletteCount;
+}
+
+unsigned int MatrixPaletteTexture::getTexelCount() const
+{
+    return _lastTexelCount;
+}
+
+void MatrixPaletteTexture::nextFrame()
+{
+    _lastPaletteCount = _paletteCount;
+    _lastTexelCount = _texelCount;
+    _paletteCount = 0;
+    _texelCount = 0;
+    _overflowed = false;
+    _offsets.clear();
+
+    if (_enabled && _sampler == NULL)
+    {
+        // The palettes need full precision, so the texture is created here rather than by Texture.
+        // It is created between frames, since binding it during a draw would replace the
+        // texture bound to the active unit for that draw.
+        GLuint handle;
+        GL_ASSERT( glGenTextures(1, &handle) );
+        Texture::bindTexture(handle);
+#ifdef OPENGL_ES
+        GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _size, _size, 0, GL_RGBA, GL_FLOAT, NULL) );
+#else
+        GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, _size, _size, 0, GL_RGBA, GL_FLOAT, NULL) );
+#endif
+        Texture* texture = Texture::create(handle, _size, _size, Texture::RGBA);
+        texture->setMemorySize(_size * _size * 4 * sizeof(float));
+        _sampler = Texture::Sampler::create(texture);
+        _sampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+        _sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+        SAFE_RELEASE(texture);
+    }
+}
+
+bool MatrixPaletteTexture::replaceDefines(const char* defines, std::string& out) const
+{
+    const bool dualQuaternion = MeshSkin::isDualQuaternionEnabled();
+    if ((!_enabled && !dualQuaternion) || defines == NULL)
+        return false;
+
+    const char* jointCount = strstr(defines, JOINT_COUNT_DEFINE);
+    if (jointCount == NULL || (dualQuaternion && strstr(defines, DUAL_QUATERNION_DEFINE)))
+        return false;
+
+    if (_enabled)
+    {
+        // Drop the joint count define up to the next separator, and add the texture defines.
+        out.assign(defines, jointCount - defines);
+        const char* end = strchr(jointCount, ';');
+        if (end)
+            out += end + 1;
+        else if (!out.empty() && out[out.size() - 1] == ';')
+            out.erase(out.size() - 1);
+        if (!out.empty())
+            out += ';';
+        char size[32];
+        sprintf(size, "%u.0", _size);
+        out += PALETTE_TEXTURE_DEFINE ";" PALETTE_TEXTURE_DEFINE "_SIZE ";
+        out += size;
+    }
+    else
+    {
+        out = defines;
+    }
+    if (dualQuaternion)
+        out += ";" DUAL_QUATERNION_DEFINE;
+    return true;
+}
+
+int MatrixPaletteTexture::upload(MeshSkin* skin)
+{
+    const unsigned int rowCount = skin->getMatrixPaletteSize();
+    const unsigned int capacity = _size * _size;
+    if (_texelCount + rowCount > capacity)
+    {
+        if (!_overflowed)
+        {
+            GP_WARN("The matrix palette texture is full (%u texels); increase the 'paletteTextureSize' of the 'skinning' config.", capacity);
+            _overflowed = true;
+        }
+        return -1;
+    }
+
+    // Upload the rows of the palette, which may wrap onto the following lines of the texture.
+    // The texture is bound to the active unit by bind().
+    const float* data = (const float*)skin->getMatrixPalette();
+    unsigned int texel = _texelCount;
+    unsigned int remaining = rowCount;
+    while (remaining > 0)
+    {
+        unsigned int x = texel % _size;
+        unsigned int y = texel / _size;
+        unsigned int count = std::min(remaining, _size - x);
+        RenderCommandList::texSubImage2D(GL_TEXTURE_2D, 0, x, y, count, 1, GL_RGBA, GL_FLOAT, data, count * 4 * sizeof(float));
+        data += count * 4;
+        texel += count;
+        remaining -= count;
+    }
+    RenderStats::addUpload(rowCount * 4 * sizeof(float));
+
+    int offset = (int)_texelCount;
+    _texelCount += rowCount;
+    ++_paletteCount;
+    return offset;
+}
+
+void MatrixPaletteTexture::bind(Effect* effect, Uniform* uniform, MeshSkin* skin)
+{
+    GP_ASSERT(effect);
+    GP_ASSERT(uniform);
+
+    if (_sampler == NULL)
+        return;
+
+    // Binding the sampler makes its unit active, so the palette is uploaded without
+    // disturbing the textures the draw has already bound to other units.
+    effect->setValue(uniform, _sampler);
+
+    int offset = 0;
+    if (skin)
+    {
+        std::map<MeshSkin*, int>::iterator itr = _offsets.find(skin);
+        if (itr == _offsets.end())
+            itr = _offsets.insert(std::make_pair(skin, upload(skin))).first;
+        offset = std::max(itr->second, 0);
+    }
+    Uniform* offsetUniform = effect->getUniform("u_matrixPaletteOffset");
+    if (offsetUniform)
+        effect->setValue(offsetUniform, (float)offset);
+}
+
+}
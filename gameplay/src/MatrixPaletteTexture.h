@@ -0,0 +1,177 @@
+#ifndef MATRIXPALETTETEXTURE_H_
+#define MATRIXPALETTETEXTURE_H_
+
+#include "Texture.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class Effect;
+class MeshSkin;
+class Uniform;
+
+/**
+ * Defines a texture that holds the matrix palettes of all the skins drawn in a frame.
+ *
+ * By default, a skinned effect reads its matrix palette from a uniform array whose size is
+ * set by the SKINNING_JOINT_COUNT define, so every joint count compiles its own effect and
+ * the number of joints is limited by the vertex uniforms of the device. When the palette
+ * texture is enabled, effects are built with the SKINNING_TEXTURE define instead of the
+ * joint count, and read the rows of their palette from a floating point texture: skins of
+ * any joint count share a single effect, and the only limit is the size of the texture.
+ * Material files do not change; the MATRIX_PALETTE auto binding binds the texture and the
+ * offset of the palette when the effect uses it, and the uniform array when it does not.
+ *
+ * Palettes are appended to the texture the first time their skin is drawn in a frame, and
+ * the texels they fill are uploaded right away; later draws of the skin in the same frame,
+ * such as shadow and depth passes, reuse them. Each frame starts at the beginning of the
+ * texture again. A skin that does not fit in what is left of the texture is drawn with the
+ * palette at its beginning, so the texture should have room for the joints of every skin
+ * drawn in a frame.
+ *
+ * The palette texture needs vertex texture fetch and floating point textures (OpenGL 3.0,
+ * GL_ARB_texture_float or, on OpenGL ES, GL_OES_texture_float). Devices without them keep
+ * the uniform palettes.
+ *
+ * The skinning config also selects dual quaternion palettes (see
+ * MeshSkin::setDualQuaternionEnabled), which take two rows per joint instead of three in
+ * both the uniform palettes and the texture; skinned effects are then built with the
+ * SKINNING_DUAL_QUATERNION define as well.
+ *
+ * The palette texture is configured in the game config:
+ *
+ * @verbatim
+    skinning
+    {
+        paletteTexture = true       // Read the matrix palettes from a texture (default false).
+        paletteTextureSize = 256    // Width and height of the texture, in texels of one palette row (default 256).
+        dualQuaternion = false      // Skin with dual quaternions instead of matrices (default false).
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class MatrixPaletteTexture
+{
+    friend class Game;
+    friend class Effect;
+    friend class RenderState;
+
+public:
+
+    /**
+     * Determines whether the palette texture is supported on this device.
+     *
+     * @return True if vertex shaders can read floating point textures.
+     */
+    static bool isSupported();
+
+    /**
+     * Determines if skinned effects read their matrix palettes from the palette texture.
+     *
+     * This is set by the game config at startup, since it changes the effects that are built.
+     *
+     * @return True if the palette texture is used.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Gets the width and height of the palette texture.
+     *
+     * @return The size of the texture, in texels.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * Gets the number of skins whose palettes were uploaded during the last frame.
+     *
+     * @return The number of palettes.
+     */
+    unsigned int getPaletteCount() const;
+
+    /**
+     * Gets the number of texels filled during the last frame.
+     *
+     * @return The number of texels, three per joint, or two with dual quaternions.
+     */
+    unsigned int getTexelCount() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    MatrixPaletteTexture();
+
+    /**
+     * Destructor.
+     */
+    ~MatrixPaletteTexture();
+
+    /**
+     * Hidden copy constructor.
+     */
+    MatrixPaletteTexture(const MatrixPaletteTexture& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    MatrixPaletteTexture& operator=(const MatrixPaletteTexture&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'skinning' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    void finalize();
+
+    /**
+     * Called by the game at the start of each frame to start filling the texture again.
+     */
+    void nextFrame();
+
+    /**
+     * Called by effects before they are built to replace the joint count of skinned defines
+     * with the palette texture defines, and to add the dual quaternion define.
+     *
+     * @param defines The defines of the effect.
+     * @param out Receives the replaced defines.
+     *
+     * @return True if the defines were replaced, false if they are used as they are.
+     */
+    bool replaceDefines(const char* defines, std::string& out) const;
+
+    /**
+     * Called by the MATRIX_PALETTE auto binding to bind the texture and the palette of a skin.
+     *
+     * @param effect The effect being bound.
+     * @param uniform The sampler uniform of the palette texture.
+     * @param skin The skin to bind the palette of, or NULL.
+     */
+    void bind(Effect* effect, Uniform* uniform, MeshSkin* skin);
+
+    /**
+     * Appends the palette of a skin to the texture, and returns its first texel or -1 if it does not fit.
+     */
+    int upload(MeshSkin* skin);
+
+    bool _enabled;
+    unsigned int _size;
+    Texture::Sampler* _sampler;
+    std::map<MeshSkin*, int> _offsets;
+    unsigned int _texelCount;
+    bool _overflowed;
+    unsigned int _paletteCount;
+    unsigned int _lastPaletteCount;
+    unsigned int _lastTexelCount;
+};
+
+}
+
+#endif
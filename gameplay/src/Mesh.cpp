@@ -1,21 +1,27 @@
 #include "Base.h"
 #include "Mesh.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "MeshPart.h"
 #include "Effect.h"
 #include "Model.h"
 #include "Material.h"
+#include "RenderStats.h"
+#include "Allocator.h"
 
 namespace gameplay
 {
 
 Mesh::Mesh(const VertexFormat& vertexFormat) 
     : _vertexFormat(vertexFormat), _vertexCount(0), _vertexBuffer(0), _primitiveType(TRIANGLES), 
-      _partCount(0), _parts(NULL), _dynamic(false)
+      _partCount(0), _parts(NULL), _indexBuffer(0), _indexBufferSize(0), _indexBufferUsed(0), _dynamic(false), _positionDecode(NULL)
 {
 }
 
 Mesh::~Mesh()
 {
+    SAFE_DELETE(_positionDecode);
+
     if (_parts)
     {
         for (unsigned int i = 0; i < _partCount; ++i)
@@ -25,10 +31,18 @@ Mesh::~Mesh()
         SAFE_DELETE_ARRAY(_parts);
     }
 
+    if (_indexBuffer)
+    {
+        StateCache::deleteBuffers(1, &_indexBuffer);
+        _indexBuffer = 0;
+        Allocator::untrack(Allocator::BUFFER, _indexBufferSize);
+    }
+
     if (_vertexBuffer)
     {
-        glDeleteBuffers(1, &_vertexBuffer);
+        StateCache::deleteBuffers(1, &_vertexBuffer);
         _vertexBuffer = 0;
+        Allocator::untrack(Allocator::BUFFER, _vertexFormat.getVertexSize() * _vertexCount);
     }
 }
 
@@ -36,8 +50,9 @@ Mesh* Mesh::createMesh(const VertexFormat& vertexFormat, unsigned int vertexCoun
 {
     GLuint vbo;
     GL_ASSERT( glGenBuffers(1, &vbo) );
-    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, vbo) );
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, vbo);
     GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, vertexFormat.getVertexSize() * vertexCount, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+    Allocator::track(Allocator::BUFFER, vertexFormat.getVertexSize() * vertexCount);
 
     Mesh* mesh = new Mesh(vertexFormat);
     mesh->_vertexCount = vertexCount;
@@ -221,6 +236,26 @@ Mesh* Mesh::createBoundingBox(const BoundingBox& box)
     return mesh;
 }
 
+bool Mesh::isIndexFormatSupported(IndexFormat format)
+{
+    if (format != INDEX32)
+        return true;
+
+#ifdef OPENGL_ES
+    // Detected on first use.
+    static int support = -1;
+    if (support == -1)
+    {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        const char* version = (const char*)glGetString(GL_VERSION);
+        support = (version && strstr(version, "OpenGL ES 3")) || (extensions && strstr(extensions, "GL_OES_element_index_uint")) ? 1 : 0;
+    }
+    return support == 1;
+#else
+    return true;
+#endif
+}
+
 const char* Mesh::getUrl() const
 {
     return _url.c_str();
@@ -264,11 +299,12 @@ void Mesh::setPrimitiveType(PrimitiveType type)
 
 void Mesh::setVertexData(const float* vertexData, unsigned int vertexStart, unsigned int vertexCount)
 {
-    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer) );
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
 
     if (vertexStart == 0 && vertexCount == 0)
     {
-        GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _vertexFormat.getVertexSize() * _vertexCount, vertexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+        RenderCommandList::bufferData(GL_ARRAY_BUFFER, _vertexFormat.getVertexSize() * _vertexCount, vertexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        RenderStats::addUpload(_vertexFormat.getVertexSize() * _vertexCount);
     }
     else
     {
@@ -277,7 +313,8 @@ void Mesh::setVertexData(const float* vertexData, unsigned int vertexStart, unsi
             vertexCount = _vertexCount - vertexStart;
         }
 
-        GL_ASSERT( glBufferSubData(GL_ARRAY_BUFFER, vertexStart * _vertexFormat.getVertexSize(), vertexCount * _vertexFormat.getVertexSize(), vertexData) );
+        RenderCommandList::bufferSubData(GL_ARRAY_BUFFER, vertexStart * _vertexFormat.getVertexSize(), vertexCount * _vertexFormat.getVertexSize(), vertexData);
+        RenderStats::addUpload(vertexCount * _vertexFormat.getVertexSize());
     }
 }
 
@@ -304,6 +341,26 @@ MeshPart* Mesh::addPart(PrimitiveType primitiveType, IndexFormat indexFormat, un
     return part;
 }
 
+bool Mesh::reserveIndexBuffer(unsigned int size)
+{
+    if (_indexBuffer)
+    {
+        GP_ERROR("Mesh '%s' already has a shared index buffer.", _url.c_str());
+        return false;
+    }
+    if (size == 0)
+        return false;
+
+    GL_ASSERT( glGenBuffers(1, &_indexBuffer) );
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW) );
+    Allocator::track(Allocator::BUFFER, size);
+    _indexBufferSize = size;
+    _indexBufferUsed = 0;
+
+    return true;
+}
+
 unsigned int Mesh::getPartCount() const
 {
     return _partCount;
@@ -335,4 +392,17 @@ void Mesh::setBoundingSphere(const BoundingSphere& sphere)
     _boundingSphere = sphere;
 }
 
+const Matrix* Mesh::getPositionDecode() const
+{
+    return _positionDecode;
+}
+
+void Mesh::setPositionDecode(const Vector3& offset, const Vector3& scale)
+{
+    if (_positionDecode == NULL)
+        _positionDecode = new Matrix();
+    Matrix::createTranslation(offset, _positionDecode);
+    _positionDecode->scale(scale);
+}
+
 }
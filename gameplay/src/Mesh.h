@@ -4,6 +4,7 @@
 #include "Ref.h"
 #include "VertexFormat.h"
 #include "Vector3.h"
+#include "Matrix.h"
 #include "BoundingBox.h"
 #include "BoundingSphere.h"
 
@@ -22,6 +23,7 @@ class Mesh : public Ref
 {
     friend class Model;
     friend class Bundle;
+    friend class MeshPart;
 
 public:
 
@@ -133,6 +135,19 @@ public:
      */
     static Mesh* createBoundingBox(const BoundingBox& box);
 
+    /**
+     * Determines whether the current device can draw mesh parts with indices of the given format.
+     *
+     * 8 and 16-bit indices are always supported. 32-bit indices require OpenGL ES 3.0,
+     * desktop OpenGL or the GL_OES_element_index_uint extension.
+     *
+     * @param format The index format.
+     *
+     * @return true if the format is supported, false otherwise.
+     * @script{ignore}
+     */
+    static bool isIndexFormatSupported(IndexFormat format);
+
     /**
      * Returns a URL from which the mesh was loaded from.
      *
@@ -221,6 +236,21 @@ public:
      */
     MeshPart* addPart(PrimitiveType primitiveType, Mesh::IndexFormat indexFormat, unsigned int indexCount, bool dynamic = false);
 
+    /**
+     * Creates an index buffer that the static parts added afterwards share.
+     *
+     * Each part otherwise has an index buffer of its own, and drawing the parts of a mesh
+     * binds one buffer per part. The parts added after this call take their indices from
+     * consecutive ranges of the shared buffer while it has room, so drawing them one after
+     * another binds the buffer once. Dynamic parts always have their own buffer.
+     *
+     * @param size The size of the buffer in bytes, at least the total size of the indices of the parts.
+     *
+     * @return true if the buffer was created, false otherwise.
+     * @script{ignore}
+     */
+    bool reserveIndexBuffer(unsigned int size);
+
     /**
      * Gets the number of mesh parts contained within the mesh.
      *
@@ -295,6 +325,28 @@ public:
      */
     void setBoundingSphere(const BoundingSphere& sphere);
 
+    /**
+     * Returns the transform that maps the stored vertex positions to model space.
+     *
+     * Meshes encoded with quantized positions store them as normalized integers
+     * relative to the mesh bounds. The world, world-view and world-view-projection
+     * auto bindings include this transform, so materials using them render such
+     * meshes unchanged.
+     *
+     * @return The position decode transform, or NULL if positions are stored in model space.
+     */
+    const Matrix* getPositionDecode() const;
+
+    /**
+     * Sets the transform that maps the stored vertex positions to model space.
+     *
+     * A decoded position is (storedPosition * scale + offset).
+     *
+     * @param offset The offset added to the scaled positions.
+     * @param scale The scale applied to the stored positions.
+     */
+    void setPositionDecode(const Vector3& offset, const Vector3& scale);
+
     /**
      * Destructor.
      */
@@ -324,9 +376,13 @@ private:
     PrimitiveType _primitiveType;
     unsigned int _partCount;
     MeshPart** _parts;
+    IndexBufferHandle _indexBuffer;
+    unsigned int _indexBufferSize;
+    unsigned int _indexBufferUsed;
     bool _dynamic;
     BoundingBox _boundingBox;
     BoundingSphere _boundingSphere;
+    Matrix* _positionDecode;
 };
 
 }
@@ -1,15 +1,21 @@
 #include "Base.h"
 #include "MeshBatch.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "Material.h"
+#include "RenderStats.h"
+#include "StreamBuffer.h"
+#include "Profiler.h"
 
 namespace gameplay
 {
 
 MeshBatch::MeshBatch(const VertexFormat& vertexFormat, Mesh::PrimitiveType primitiveType, Material* material, bool indexed, unsigned int initialCapacity, unsigned int growSize)
     : _vertexFormat(vertexFormat), _primitiveType(primitiveType), _material(material), _indexed(indexed), _capacity(0), _growSize(growSize),
-      _vertexCapacity(0), _indexCapacity(0), _vertexCount(0), _indexCount(0), _vertices(NULL), _verticesPtr(NULL), _indices(NULL), _indicesPtr(NULL)
+      _vertexCapacity(0), _indexCapacity(0), _vertexCount(0), _indexCount(0), _vertices(NULL), _verticesPtr(NULL), _indexFormat(Mesh::INDEX16), _indices(NULL)
 {
     resize(initialCapacity);
+    updateVertexAttributeBinding();
 }
 
 MeshBatch::~MeshBatch()
@@ -70,32 +76,31 @@ void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount,
     if (_indexed)
     {
         GP_ASSERT(indices);
-        GP_ASSERT(_indicesPtr);
+        GP_ASSERT(_indices);
 
-        if (_vertexCount == 0)
+        if (_vertexCount == 0 && _indexFormat == Mesh::INDEX16)
         {
             // Simply copy values directly into the start of the index array.
-            memcpy(_indicesPtr, indices, indexCount * sizeof(unsigned short));
+            memcpy(_indices, indices, indexCount * sizeof(unsigned short));
         }
         else
         {
-            if (_primitiveType == Mesh::TRIANGLE_STRIP)
+            if (_primitiveType == Mesh::TRIANGLE_STRIP && _vertexCount > 0)
             {
                 // Create a degenerate triangle to connect separate triangle strips
                 // by duplicating the previous and next vertices.
-                _indicesPtr[0] = *(_indicesPtr-1);
-                _indicesPtr[1] = _vertexCount;
-                _indicesPtr += 2;
+                setIndex(_indexCount, getIndex(_indexCount - 1));
+                setIndex(_indexCount + 1, _vertexCount);
+                _indexCount += 2;
             }
             
             // Loop through all indices and insert them, with their values offset by
             // 'vertexCount' so that they are relative to the first newly inserted vertex.
             for (unsigned int i = 0; i < indexCount; ++i)
             {
-                _indicesPtr[i] = indices[i] + _vertexCount;
+                setIndex(_indexCount + i, indices[i] + _vertexCount);
             }
         }
-        _indicesPtr += indexCount;
         _indexCount = newIndexCount;
     }
     
@@ -103,11 +108,55 @@ void MeshBatch::add(const void* vertices, size_t size, unsigned int vertexCount,
     _vertexCount = newVertexCount;
 }
 
+bool MeshBatch::append(unsigned int vertexCount, unsigned int indexCount, void** vertices, void** indices, unsigned int* baseVertex)
+{
+    GP_ASSERT(vertices);
+    GP_ASSERT(indices);
+    GP_ASSERT(baseVertex);
+
+    unsigned int newVertexCount = _vertexCount + vertexCount;
+    unsigned int newIndexCount = _indexCount + indexCount;
+    bool connect = _indexed && _primitiveType == Mesh::TRIANGLE_STRIP && _vertexCount > 0;
+    if (connect)
+        newIndexCount += 2;
+
+    // Do we need to grow the batch?
+    while (newVertexCount > _vertexCapacity || (_indexed && newIndexCount > _indexCapacity))
+    {
+        if (_growSize == 0)
+            return false; // growing disabled, just clip batch
+        if (!resize(_capacity + _growSize))
+            return false; // failed to grow
+    }
+
+    GP_ASSERT(_verticesPtr);
+    *vertices = _verticesPtr;
+    *baseVertex = _vertexCount;
+    *indices = NULL;
+    if (_indexed)
+    {
+        GP_ASSERT(_indices);
+        if (connect)
+        {
+            // Connect to the previous triangle strip with a degenerate triangle.
+            setIndex(_indexCount, getIndex(_indexCount - 1));
+            setIndex(_indexCount + 1, _vertexCount);
+        }
+        *indices = _indices + (newIndexCount - indexCount) * (_indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short));
+        _indexCount = newIndexCount;
+    }
+
+    _verticesPtr += vertexCount * _vertexFormat.getVertexSize();
+    _vertexCount = newVertexCount;
+    return true;
+}
+
 void MeshBatch::updateVertexAttributeBinding()
 {
     GP_ASSERT(_material);
 
-    // Update our vertex attribute bindings.
+    // The vertices are streamed to a vertex buffer when drawn, so the bindings hold
+    // offsets into it and do not change when the batch is resized.
     for (unsigned int i = 0, techniqueCount = _material->getTechniqueCount(); i < techniqueCount; ++i)
     {
         Technique* t = _material->getTechniqueByIndex(i);
@@ -116,7 +165,7 @@ void MeshBatch::updateVertexAttributeBinding()
         {
             Pass* p = t->getPassByIndex(j);
             GP_ASSERT(p);
-            VertexAttributeBinding* b = VertexAttributeBinding::create(_vertexFormat, _vertices, p->getEffect());
+            VertexAttributeBinding* b = VertexAttributeBinding::create(_vertexFormat, NULL, p->getEffect());
             p->setVertexAttributeBinding(b);
             SAFE_RELEASE(b);
         }
@@ -146,7 +195,8 @@ bool MeshBatch::resize(unsigned int capacity)
 
     // Store old batch data.
     unsigned char* oldVertices = _vertices;
-    unsigned short* oldIndices = _indices;
+    unsigned char* oldIndices = _indices;
+    Mesh::IndexFormat oldIndexFormat = _indexFormat;
 
     unsigned int vertexCapacity = 0;
     switch (_primitiveType)
@@ -175,10 +225,15 @@ bool MeshBatch::resize(unsigned int capacity)
     // (we only know how many indices will be stored). Assume the worst case
     // for now, which is the same number of vertices as indices.
     unsigned int indexCapacity = vertexCapacity;
+    Mesh::IndexFormat indexFormat = Mesh::INDEX16;
     if (_indexed && indexCapacity > USHRT_MAX)
     {
-        GP_ERROR("Index capacity is greater than the maximum unsigned short value (%d > %d).", indexCapacity, USHRT_MAX);
-        return false;
+        if (!Mesh::isIndexFormatSupported(Mesh::INDEX32))
+        {
+            GP_ERROR("Index capacity is greater than the maximum unsigned short value (%d > %d) and 32-bit indices are not supported.", indexCapacity, USHRT_MAX);
+            return false;
+        }
+        indexFormat = Mesh::INDEX32;
     }
 
     // Allocate new data and reset pointers.
@@ -191,11 +246,10 @@ bool MeshBatch::resize(unsigned int capacity)
 
     if (_indexed)
     {
-        unsigned int ioffset = _indicesPtr - _indices;
-        _indices = new unsigned short[indexCapacity];
-        if (ioffset >= indexCapacity)
-            ioffset = indexCapacity - 1;
-        _indicesPtr = _indices + ioffset;
+        _indexFormat = indexFormat;
+        _indices = new unsigned char[indexCapacity * (indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short))];
+        if (_indexCount > indexCapacity)
+            _indexCount = indexCapacity;
     }
 
     // Copy old data back in
@@ -203,7 +257,16 @@ bool MeshBatch::resize(unsigned int capacity)
         memcpy(_vertices, oldVertices, std::min(_vertexCapacity, vertexCapacity) * _vertexFormat.getVertexSize());
     SAFE_DELETE_ARRAY(oldVertices);
     if (oldIndices)
-        memcpy(_indices, oldIndices, std::min(_indexCapacity, indexCapacity) * sizeof(unsigned short));
+    {
+        // Widen or narrow the indices if the index format changed.
+        unsigned int count = std::min(_indexCapacity, indexCapacity);
+        if (oldIndexFormat == _indexFormat)
+            memcpy(_indices, oldIndices, count * (_indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short)));
+        else if (oldIndexFormat == Mesh::INDEX16)
+            std::copy((unsigned short*)oldIndices, (unsigned short*)oldIndices + count, (unsigned int*)_indices);
+        else
+            std::copy((unsigned int*)oldIndices, (unsigned int*)oldIndices + count, (unsigned short*)_indices);
+    }
     SAFE_DELETE_ARRAY(oldIndices);
 
     // Assign new capacities
@@ -211,12 +274,24 @@ bool MeshBatch::resize(unsigned int capacity)
     _vertexCapacity = vertexCapacity;
     _indexCapacity = indexCapacity;
 
-    // Update our vertex attribute bindings now that our client array pointers have changed
-    updateVertexAttributeBinding();
-
     return true;
 }
 
+unsigned int MeshBatch::getIndex(unsigned int position) const
+{
+    if (_indexFormat == Mesh::INDEX32)
+        return ((const unsigned int*)_indices)[position];
+    return ((const unsigned short*)_indices)[position];
+}
+
+void MeshBatch::setIndex(unsigned int position, unsigned int value)
+{
+    if (_indexFormat == Mesh::INDEX32)
+        ((unsigned int*)_indices)[position] = value;
+    else
+        ((unsigned short*)_indices)[position] = (unsigned short)value;
+}
+
 void MeshBatch::add(const float* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
 {
     add(vertices, sizeof(float), vertexCount, indices, indexCount);
@@ -227,7 +302,6 @@ void MeshBatch::start()
     _vertexCount = 0;
     _indexCount = 0;
     _verticesPtr = _vertices;
-    _indicesPtr = _indices;
 }
 
 void MeshBatch::finish()
@@ -239,14 +313,17 @@ void MeshBatch::draw()
     if (_vertexCount == 0 || (_indexed && _indexCount == 0))
         return; // nothing to draw
 
-    // Not using VBOs, so unbind the element array buffer.
-    // ARRAY_BUFFER will be unbound automatically during pass->bind().
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0 ) );
-
     GP_ASSERT(_material);
     if (_indexed)
         GP_ASSERT(_indices);
 
+    // Stream the batch to the GPU.
+    unsigned int vertexOffset = StreamBuffer::upload(StreamBuffer::VERTEX, _vertices, _vertexCount * _vertexFormat.getVertexSize());
+    unsigned int indexOffset = 0;
+    unsigned int indexSize = _indexFormat == Mesh::INDEX32 ? sizeof(unsigned int) : sizeof(unsigned short);
+    if (_indexed)
+        indexOffset = StreamBuffer::upload(StreamBuffer::INDEX, _indices, _indexCount * indexSize, indexSize);
+
     // Bind the material.
     Technique* technique = _material->getTechnique();
     GP_ASSERT(technique);
@@ -255,19 +332,30 @@ void MeshBatch::draw()
     {
         Pass* pass = technique->getPassByIndex(i);
         GP_ASSERT(pass);
+        if (VertexAttributeBinding* binding = pass->getVertexAttributeBinding())
+            binding->setVertexBuffer(StreamBuffer::getBuffer(StreamBuffer::VERTEX), vertexOffset);
         pass->bind();
 
+        Profiler::GpuDrawScope gpuDraw(pass->getLabel(), pass->getEffect()->getId());
         if (_indexed)
         {
-            GL_ASSERT( glDrawElements(_primitiveType, _indexCount, GL_UNSIGNED_SHORT, (GLvoid*)_indices) );
+            StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, StreamBuffer::getBuffer(StreamBuffer::INDEX));
+            RenderCommandList::drawElements(_primitiveType, _indexCount, _indexFormat, indexOffset);
+            RenderStats::addDrawCall(_primitiveType, _indexCount);
         }
         else
         {
-            GL_ASSERT( glDrawArrays(_primitiveType, 0, _vertexCount) );
+            RenderCommandList::drawArrays(_primitiveType, 0, _vertexCount);
+            RenderStats::addDrawCall(_primitiveType, _vertexCount);
         }
 
         pass->unbind();
     }
+
+    if (_indexed)
+    {
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
 }
     
 
@@ -10,6 +10,9 @@ class Material;
 
 /**
  * Defines a class for rendering multiple mesh into a single draw call on the graphics device.
+ *
+ * Primitives are collected in system memory and streamed to the GPU through the
+ * StreamBuffer ring buffers each time the batch is drawn.
  */
 class MeshBatch
 {
@@ -71,6 +74,18 @@ public:
      */
     inline Material* getMaterial() const;
 
+    /**
+     * Returns the format of the indices stored in the batch.
+     *
+     * Indexed batches store 16-bit indices until they grow to hold more vertices than
+     * 16-bit indices can address. On devices that support 32-bit indices they then switch
+     * to 32-bit indices, otherwise they stop growing at that size.
+     *
+     * @return The index format of the batch.
+     * @script{ignore}
+     */
+    inline Mesh::IndexFormat getIndexFormat() const;
+
     /**
      * Adds a group of primitives to the batch.
      *
@@ -114,6 +129,29 @@ public:
      */
     void add(const float* vertices, unsigned int vertexCount, const unsigned short* indices = NULL, unsigned int indexCount = 0);
 
+    /**
+     * Adds uninitialized vertices and indices to the batch and returns pointers to them.
+     *
+     * This allows primitives to be generated directly into the batch instead of being
+     * copied in by add(). The index values written must be relative to the start of the
+     * batch, which is done by adding the returned base vertex to them. Separate triangle
+     * strips are stitched together like add() does, so the first index written must then
+     * be the base vertex.
+     *
+     * The indices are unsigned shorts or unsigned ints depending on getIndexFormat(),
+     * which must be checked after this call since adding may switch the batch to 32-bit indices.
+     *
+     * @param vertexCount The number of vertices to add.
+     * @param indexCount The number of indices to add.
+     * @param vertices Set to the first vertex to write.
+     * @param indices Set to the first index to write, or NULL if the batch is not indexed.
+     * @param baseVertex Set to the position of the first added vertex in the batch.
+     *
+     * @return true if the vertices and indices were added, false if the batch could not grow to hold them.
+     * @script{ignore}
+     */
+    bool append(unsigned int vertexCount, unsigned int indexCount, void** vertices, void** indices, unsigned int* baseVertex);
+
     /**
      * Starts batching.
      *
@@ -159,6 +197,10 @@ private:
 
     bool resize(unsigned int capacity);
 
+    unsigned int getIndex(unsigned int position) const;
+
+    void setIndex(unsigned int position, unsigned int value);
+
     const VertexFormat _vertexFormat;
     Mesh::PrimitiveType _primitiveType;
     Material* _material;
@@ -171,8 +213,8 @@ private:
     unsigned int _indexCount;
     unsigned char* _vertices;
     unsigned char* _verticesPtr;
-    unsigned short* _indices;
-    unsigned short* _indicesPtr;
+    Mesh::IndexFormat _indexFormat;
+    unsigned char* _indices;
 
 };
 
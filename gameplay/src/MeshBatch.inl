@@ -8,6 +8,11 @@ Material* MeshBatch::getMaterial() const
     return _material;
 }
 
+Mesh::IndexFormat MeshBatch::getIndexFormat() const
+{
+    return _indexFormat;
+}
+
 template <class T>
 void MeshBatch::add(const T* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
 {
@@ -1,59 +1,83 @@
 #include "Base.h"
 #include "MeshPart.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "RenderStats.h"
+#include "Allocator.h"
 
 namespace gameplay
 {
 
+// Gets the size in bytes of an index, or 0 if the format is not supported.
+static unsigned int getIndexSize(Mesh::IndexFormat indexFormat)
+{
+    switch (indexFormat)
+    {
+    case Mesh::INDEX8:
+        return 1;
+    case Mesh::INDEX16:
+        return 2;
+    case Mesh::INDEX32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
 MeshPart::MeshPart() :
-    _mesh(NULL), _meshIndex(0), _primitiveType(Mesh::TRIANGLES), _indexCount(0), _indexBuffer(0), _dynamic(false)
+    _mesh(NULL), _meshIndex(0), _primitiveType(Mesh::TRIANGLES), _indexCount(0), _indexBuffer(0), _indexOffset(0), _sharedIndexBuffer(false), _dynamic(false)
 {
 }
 
 MeshPart::~MeshPart()
 {
-    if (_indexBuffer)
+    if (_indexBuffer && !_sharedIndexBuffer)
     {
-        glDeleteBuffers(1, &_indexBuffer);
+        StateCache::deleteBuffers(1, &_indexBuffer);
+        Allocator::untrack(Allocator::BUFFER, getIndexSize(_indexFormat) * _indexCount);
     }
 }
 
 MeshPart* MeshPart::create(Mesh* mesh, unsigned int meshIndex, Mesh::PrimitiveType primitiveType,
     Mesh::IndexFormat indexFormat, unsigned int indexCount, bool dynamic)
 {
-    // Create a VBO for our index buffer.
-    GLuint vbo;
-    GL_ASSERT( glGenBuffers(1, &vbo) );
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo) );
-
-    unsigned int indexSize = 0;
-    switch (indexFormat)
+    unsigned int indexSize = getIndexSize(indexFormat);
+    if (indexSize == 0)
     {
-    case Mesh::INDEX8:
-        indexSize = 1;
-        break;
-    case Mesh::INDEX16:
-        indexSize = 2;
-        break;
-    case Mesh::INDEX32:
-        indexSize = 4;
-        break;
-    default:
         GP_ERROR("Unsupported index format (%d).", indexFormat);
-        glDeleteBuffers(1, &vbo);
         return NULL;
     }
 
-    GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * indexCount, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
-
     MeshPart* part = new MeshPart();
     part->_mesh = mesh;
     part->_meshIndex = meshIndex;
     part->_primitiveType = primitiveType;
     part->_indexFormat = indexFormat;
     part->_indexCount = indexCount;
-    part->_indexBuffer = vbo;
     part->_dynamic = dynamic;
 
+    // Take the indices from the next range of the mesh's shared index buffer, aligned to the index size, if it has room.
+    if (mesh && mesh->_indexBuffer && !dynamic)
+    {
+        unsigned int offset = (mesh->_indexBufferUsed + indexSize - 1) / indexSize * indexSize;
+        if (offset + indexSize * indexCount <= mesh->_indexBufferSize)
+        {
+            part->_indexBuffer = mesh->_indexBuffer;
+            part->_indexOffset = offset;
+            part->_sharedIndexBuffer = true;
+            mesh->_indexBufferUsed = offset + indexSize * indexCount;
+            return part;
+        }
+    }
+
+    // Create a VBO for our index buffer.
+    GLuint vbo;
+    GL_ASSERT( glGenBuffers(1, &vbo) );
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo);
+    GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * indexCount, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+    Allocator::track(Allocator::BUFFER, indexSize * indexCount);
+    part->_indexBuffer = vbo;
+
     return part;
 }
 
@@ -82,6 +106,11 @@ IndexBufferHandle MeshPart::getIndexBuffer() const
     return _indexBuffer;
 }
 
+unsigned int MeshPart::getIndexOffset() const
+{
+    return _indexOffset;
+}
+
 bool MeshPart::isDynamic() const
 {
     return _dynamic;
@@ -89,28 +118,30 @@ bool MeshPart::isDynamic() const
 
 void MeshPart::setIndexData(const void* indexData, unsigned int indexStart, unsigned int indexCount)
 {
-    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer) );
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
 
-    unsigned int indexSize = 0;
-    switch (_indexFormat)
+    unsigned int indexSize = getIndexSize(_indexFormat);
+    if (indexSize == 0)
     {
-    case Mesh::INDEX8:
-        indexSize = 1;
-        break;
-    case Mesh::INDEX16:
-        indexSize = 2;
-        break;
-    case Mesh::INDEX32:
-        indexSize = 4;
-        break;
-    default:
         GP_ERROR("Unsupported index format (%d).", _indexFormat);
         return;
     }
 
-    if (indexStart == 0 && indexCount == 0)
+    if (_sharedIndexBuffer)
+    {
+        // Replacing the whole buffer would discard the indices of the other parts.
+        if (indexCount == 0)
+        {
+            indexCount = _indexCount - indexStart;
+        }
+
+        RenderCommandList::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, _indexOffset + indexStart * indexSize, indexCount * indexSize, indexData);
+        RenderStats::addUpload(indexCount * indexSize);
+    }
+    else if (indexStart == 0 && indexCount == 0)
     {
-        GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * _indexCount, indexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+        RenderCommandList::bufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * _indexCount, indexData, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        RenderStats::addUpload(indexSize * _indexCount);
     }
     else
     {
@@ -119,7 +150,8 @@ void MeshPart::setIndexData(const void* indexData, unsigned int indexStart, unsi
             indexCount = _indexCount - indexStart;
         }
 
-        GL_ASSERT( glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexStart * indexSize, indexCount * indexSize, indexData) );
+        RenderCommandList::bufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexStart * indexSize, indexCount * indexSize, indexData);
+        RenderStats::addUpload(indexCount * indexSize);
     }
 }
 
@@ -57,6 +57,16 @@ public:
      */
     IndexBufferHandle getIndexBuffer() const;
 
+    /**
+     * Returns the offset in bytes of the indices of the part within its index buffer.
+     *
+     * The offset is nonzero when the parts of the mesh share an index buffer.
+     *
+     * @return The offset of the indices.
+     * @script{ignore}
+     */
+    unsigned int getIndexOffset() const;
+
     /**
      * Determines if the indices are dynamic.
      *
@@ -104,6 +114,8 @@ private:
     Mesh::IndexFormat _indexFormat;
     unsigned int _indexCount;
     IndexBufferHandle _indexBuffer;
+    unsigned int _indexOffset;
+    bool _sharedIndexBuffer;
     bool _dynamic;
 };
 
@@ -1,15 +1,27 @@
 #include "Base.h"
 #include "MeshSkin.h"
 #include "Joint.h"
+#include "Scene.h"
+#include "Game.h"
+#include "MathUtil.h"
 
-// The number of rows in each palette matrix.
+// The number of rows in each palette matrix, and in each palette dual quaternion.
 #define PALETTE_ROWS 3
+#define DUAL_QUATERNION_ROWS 2
 
 namespace gameplay
 {
 
+static bool __dualQuaternion = false;
+
+static inline unsigned int getPaletteRows()
+{
+    return __dualQuaternion ? DUAL_QUATERNION_ROWS : PALETTE_ROWS;
+}
+
 MeshSkin::MeshSkin()
-    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL)
+    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL),
+      _jointOrderDirty(true), _bindMatricesDirty(true), _paletteDirty(true), _boundsDirty(true)
 {
 }
 
@@ -28,6 +40,8 @@ const Matrix& MeshSkin::getBindShape() const
 void MeshSkin::setBindShape(const float* matrix)
 {
     _bindShape.set(matrix);
+    _bindMatricesDirty = true;
+    _paletteDirty = true;
 }
 
 unsigned int MeshSkin::getJointCount() const
@@ -61,6 +75,7 @@ MeshSkin* MeshSkin::clone(NodeCloneContext &context) const
 {
     MeshSkin* skin = new MeshSkin();
     skin->_bindShape = _bindShape;
+    skin->_jointBounds = _jointBounds;
     if (_rootNode && _rootJoint)
     {
         const unsigned int jointCount = getJointCount();
@@ -120,10 +135,19 @@ void MeshSkin::setJointCount(unsigned int jointCount)
         _joints[i] = NULL;
     }
 
-    // Rebuild the matrix palette. Each matrix is 3 rows of Vector4.
+    // Rebuild the matrix palette. Each matrix is 3 rows of Vector4, each dual quaternion 2.
     SAFE_DELETE_ARRAY(_matrixPalette);
 
-    if (jointCount > 0)
+    if (jointCount > 0 && __dualQuaternion)
+    {
+        _matrixPalette = new Vector4[jointCount * DUAL_QUATERNION_ROWS];
+        for (unsigned int i = 0; i < jointCount * DUAL_QUATERNION_ROWS; i+=DUAL_QUATERNION_ROWS)
+        {
+            _matrixPalette[i+0].set(0.0f, 0.0f, 0.0f, 1.0f);
+            _matrixPalette[i+1].set(0.0f, 0.0f, 0.0f, 0.0f);
+        }
+    }
+    else if (jointCount > 0)
     {
         _matrixPalette = new Vector4[jointCount * PALETTE_ROWS];
         for (unsigned int i = 0; i < jointCount * PALETTE_ROWS; i+=PALETTE_ROWS)
@@ -152,23 +176,193 @@ void MeshSkin::setJoint(Joint* joint, unsigned int index)
         joint->addRef();
         joint->addSkin(this);
     }
+
+    _jointOrderDirty = true;
+    _bindMatricesDirty = true;
+    _paletteDirty = true;
 }
 
 Vector4* MeshSkin::getMatrixPalette() const
 {
     GP_ASSERT(_matrixPalette);
 
-    for (size_t i = 0, count = _joints.size(); i < count; i++)
+    if (_paletteDirty)
     {
-        GP_ASSERT(_joints[i]);
-        _joints[i]->updateJointMatrix(getBindShape(), &_matrixPalette[i * PALETTE_ROWS]);
+        _paletteDirty = false;
+        prepareMatrixPalette();
+        computeMatrixPalette(0, (unsigned int)_joints.size());
     }
     return _matrixPalette;
 }
 
+void MeshSkin::updateMatrixPalettes(MeshSkin** skins, unsigned int count)
+{
+    GP_ASSERT(skins || count == 0);
+
+    // Resolving joint transforms writes to the (possibly shared) joint nodes,
+    // so it is done serially. Skins that appear more than once are only kept once.
+    std::vector<MeshSkin*, FrameAllocator<MeshSkin*> > dirtySkins;
+    dirtySkins.reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        MeshSkin* skin = skins[i];
+        if (skin && skin->_paletteDirty && skin->_matrixPalette)
+        {
+            skin->_paletteDirty = false;
+            skin->prepareMatrixPalette();
+            dirtySkins.push_back(skin);
+        }
+    }
+
+    if (dirtySkins.empty())
+        return;
+
+    Game::getInstance()->getJobScheduler()->parallelFor((unsigned int)dirtySkins.size(), computeMatrixPalettes, &dirtySkins[0]);
+}
+
+void MeshSkin::computeMatrixPalettes(unsigned int start, unsigned int end, void* cookie)
+{
+    MeshSkin** skins = static_cast<MeshSkin**>(cookie);
+    for (unsigned int i = start; i < end; ++i)
+    {
+        skins[i]->computeMatrixPalette(0, (unsigned int)skins[i]->_joints.size());
+    }
+}
+
+void MeshSkin::prepareMatrixPalette() const
+{
+    const unsigned int jointCount = (unsigned int)_joints.size();
+
+    if (_jointOrderDirty)
+    {
+        _jointOrderDirty = false;
+
+        // Sort the joints by their depth in the hierarchy.
+        std::vector<std::pair<unsigned int, unsigned int> > depths(jointCount);
+        for (unsigned int i = 0; i < jointCount; ++i)
+        {
+            unsigned int depth = 0;
+            for (Node* node = _joints[i] ? _joints[i]->getParent() : NULL; node != NULL; node = node->getParent())
+            {
+                ++depth;
+            }
+            depths[i] = std::make_pair(depth, i);
+        }
+        std::sort(depths.begin(), depths.end());
+
+        _jointOrder.resize(jointCount);
+        for (unsigned int i = 0; i < jointCount; ++i)
+        {
+            _jointOrder[i] = depths[i].second;
+        }
+    }
+
+    if (_bindMatricesDirty)
+    {
+        _bindMatricesDirty = false;
+        _bindMatrices.resize(jointCount);
+        for (unsigned int i = 0; i < jointCount; ++i)
+        {
+            GP_ASSERT(_joints[i]);
+            Matrix::multiply(_joints[i]->getInverseBindPose(), _bindShape, &_bindMatrices[i]);
+        }
+    }
+
+    // Resolving the joints parent first means that every world matrix costs a
+    // single multiply with its already resolved parent.
+    for (unsigned int i = 0; i < jointCount; ++i)
+    {
+        _joints[_jointOrder[i]]->getWorldMatrix();
+    }
+}
+
+void MeshSkin::computeMatrixPalette(unsigned int start, unsigned int end) const
+{
+    GP_ASSERT(_matrixPalette);
+    GP_ASSERT(end <= _joints.size());
+
+    if (__dualQuaternion)
+    {
+        Matrix matrix;
+        Quaternion rotation;
+        Vector3 translation;
+        for (unsigned int i = start; i < end; ++i)
+        {
+            GP_ASSERT(_joints[i]);
+            Matrix::multiply(_joints[i]->getWorldMatrix(), _bindMatrices[i], &matrix);
+            matrix.decompose(NULL, &rotation, &translation);
+
+            // The dual part is half the translation multiplied by the rotation.
+            Quaternion dual;
+            Quaternion::multiply(Quaternion(translation.x * 0.5f, translation.y * 0.5f, translation.z * 0.5f, 0.0f), rotation, &dual);
+            _matrixPalette[i * DUAL_QUATERNION_ROWS].set(rotation.x, rotation.y, rotation.z, rotation.w);
+            _matrixPalette[i * DUAL_QUATERNION_ROWS + 1].set(dual.x, dual.y, dual.z, dual.w);
+        }
+        return;
+    }
+
+    for (unsigned int i = start; i < end; ++i)
+    {
+        GP_ASSERT(_joints[i]);
+        MathUtil::multiplyMatrixPalette(_joints[i]->getWorldMatrix().m, _bindMatrices[i].m, (float*)&_matrixPalette[i * PALETTE_ROWS]);
+    }
+}
+
+bool MeshSkin::hasJointBounds() const
+{
+    return !_jointBounds.empty();
+}
+
+const BoundingSphere& MeshSkin::getBoundingSphere() const
+{
+    if (_boundsDirty && !_jointBounds.empty())
+    {
+        _boundsDirty = false;
+        prepareMatrixPalette();
+
+        bool empty = true;
+        Matrix matrix;
+        BoundingSphere sphere;
+        for (unsigned int i = 0, count = (unsigned int)_joints.size(); i < count; ++i)
+        {
+            // Joints that influence no vertex have no bounds.
+            if (_jointBounds[i].radius <= 0.0f)
+                continue;
+
+            Matrix::multiply(_joints[i]->getWorldMatrix(), _bindMatrices[i], &matrix);
+            sphere.set(_jointBounds[i]);
+            sphere.transform(matrix);
+            if (empty)
+            {
+                _bounds.set(sphere);
+                empty = false;
+            }
+            else
+            {
+                _bounds.merge(sphere);
+            }
+        }
+        if (empty)
+        {
+            _bounds.set(Vector3::zero(), 0.0f);
+        }
+    }
+    return _bounds;
+}
+
 unsigned int MeshSkin::getMatrixPaletteSize() const
 {
-    return (unsigned int)_joints.size() * PALETTE_ROWS;
+    return (unsigned int)_joints.size() * getPaletteRows();
+}
+
+bool MeshSkin::isDualQuaternionEnabled()
+{
+    return __dualQuaternion;
+}
+
+void MeshSkin::setDualQuaternionEnabled(bool enabled)
+{
+    __dualQuaternion = enabled;
 }
 
 Model* MeshSkin::getModel() const
@@ -196,9 +390,13 @@ void MeshSkin::setRootJoint(Joint* joint)
     // If the root joint has a parent node, register for its transformChanged event
     if (_rootJoint && _rootJoint->getParent())
     {
-        _rootJoint->getParent()->addListener(this, 1);
+        _rootJoint->getParent()->addListener(this, 1, false);
     }
 
+    // Joints are normally parented while the root is being resolved.
+    _jointOrderDirty = true;
+    _paletteDirty = true;
+
     Node* newRootNode = _rootJoint;
     if (newRootNode)
     {
@@ -251,6 +449,11 @@ void MeshSkin::setRootNode(Node* node)
 {
     if (_rootNode != node)
     {
+        // The scene's node ID index includes the joint hierarchy.
+        Scene* scene = (_model && _model->getNode()) ? _model->getNode()->getScene() : NULL;
+        if (scene)
+            scene->_nodeIndexDirty = true;
+
         SAFE_RELEASE(_rootNode);
         _rootNode = node;
         if (_rootNode)
@@ -3,6 +3,7 @@
 
 #include "Matrix.h"
 #include "Transform.h"
+#include "BoundingSphere.h"
 
 namespace gameplay
 {
@@ -23,6 +24,8 @@ class MeshSkin : public Transform::Listener
     friend class Node;
     friend class Scene;
 
+    GP_POOLED_ALLOCATION(ANIMATION)
+
 public:
 
     /**
@@ -95,17 +98,80 @@ public:
     /**
      * Returns the number of elements in the matrix palette array.
      * Each element is a Vector4* that represents a row.
-     * Each matrix palette is represented by 3 rows of Vector4.
+     * Each matrix palette is represented by 3 rows of Vector4,
+     * or 2 rows when dual quaternion skinning is enabled.
      * 
      * @return The matrix palette size.
      */
     unsigned int getMatrixPaletteSize() const;
 
+    /**
+     * Determines if the palettes of skins hold dual quaternions instead of matrices.
+     *
+     * @return True if dual quaternion skinning is enabled.
+     * @script{ignore}
+     */
+    static bool isDualQuaternionEnabled();
+
+    /**
+     * Sets whether the palettes of skins hold dual quaternions instead of matrices.
+     *
+     * A dual quaternion takes 2 rows of the palette instead of the 3 rows of a 4x3 matrix,
+     * which saves a third of the uniforms and of the palette uploads, and blends joints
+     * without the volume loss of linear blending. Dual quaternions only hold rotations and
+     * translations: the scale of the joints and of the bind shape is dropped, so skins that
+     * rely on it should keep matrix skinning. The skinned effects are built with the
+     * SKINNING_DUAL_QUATERNION define, which the built-in skinned shaders support.
+     *
+     * This is set during startup by the 'dualQuaternion' property of the 'skinning' game
+     * config (see MatrixPaletteTexture), and must not change once skins are loaded.
+     *
+     * @param enabled True to enable dual quaternion skinning.
+     * @script{ignore}
+     */
+    static void setDualQuaternionEnabled(bool enabled);
+
     /**
      * Returns our parent Model.
      */
     Model* getModel() const;
 
+    /**
+     * Determines if the skin has a bounding sphere for each joint.
+     *
+     * The encoder computes the sphere of the vertices each joint influences, which lets the
+     * bounds of the skinned mesh follow its pose instead of covering every pose of its animations.
+     *
+     * @return true if the skin has joint bounds, false otherwise.
+     * @script{ignore}
+     */
+    bool hasJointBounds() const;
+
+    /**
+     * Gets the bounding sphere of the skinned mesh in the current pose of its joints.
+     *
+     * The sphere is the union of the bounding spheres of the joints, moved with their joints,
+     * in the local space of the model's node. No vertex is skinned to compute it.
+     *
+     * @return The bounding sphere, which is empty if the skin has no joint bounds.
+     * @script{ignore}
+     */
+    const BoundingSphere& getBoundingSphere() const;
+
+    /**
+     * Updates the matrix palettes of several skins at once.
+     *
+     * Joint world transforms are resolved first, after which the palettes of
+     * all skins that changed are computed in parallel on the job scheduler.
+     * The palettes are cached until one of their joints changes again, so
+     * calling this before rendering moves the work out of the draw calls.
+     *
+     * @param skins The array of skins to update.
+     * @param count The number of skins in the array.
+     * @script{ignore}
+     */
+    static void updateMatrixPalettes(MeshSkin** skins, unsigned int count);
+
     /**
      * Handles transform change events for joints.
      */
@@ -170,6 +236,22 @@ private:
      */
     void clearJoints();
 
+    /**
+     * Resolves the world matrices of all joints (in parent-first order) and the
+     * per joint bind matrices, so the palette can be computed without modifying
+     * any shared node state.
+     */
+    void prepareMatrixPalette() const;
+
+    /**
+     * Computes the matrix palette entries for the joints from start to end.
+     *
+     * Must be called after prepareMatrixPalette().
+     */
+    void computeMatrixPalette(unsigned int start, unsigned int end) const;
+
+    static void computeMatrixPalettes(unsigned int start, unsigned int end, void* cookie);
+
     Matrix _bindShape;
     std::vector<Joint*> _joints;
     Joint* _rootJoint;
@@ -181,10 +263,23 @@ private:
 
     // Pointer to the array of palette matrices.
     // This array is passed to the vertex shader as a uniform.
-    // Each 4x3 row-wise matrix is represented as 3 Vector4's.
-    // The number of Vector4's is (_joints.size() * 3).
+    // Each 4x3 row-wise matrix is represented as 3 Vector4's,
+    // or each dual quaternion as 2 Vector4's (rotation, then dual part).
+    // The number of Vector4's is (_joints.size() * rows).
     Vector4* _matrixPalette;
     Model* _model;
+    // Joint indices sorted so that parents come before their children.
+    mutable std::vector<unsigned int> _jointOrder;
+    // The inverse bind pose of each joint multiplied by the bind shape.
+    mutable std::vector<Matrix> _bindMatrices;
+    mutable bool _jointOrderDirty;
+    mutable bool _bindMatricesDirty;
+    mutable bool _paletteDirty;
+    // The bounding sphere of the vertices influenced by each joint, in mesh space.
+    std::vector<BoundingSphere> _jointBounds;
+    // The union of the joint bounds in the current pose.
+    mutable BoundingSphere _bounds;
+    mutable bool _boundsDirty;
 };
 
 }
@@ -1,16 +1,23 @@
 #include "Base.h"
 #include "Model.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "MeshPart.h"
 #include "Scene.h"
 #include "Technique.h"
 #include "Pass.h"
 #include "Node.h"
+#include "Game.h"
+#include "RenderStats.h"
+#include "DebugMarkers.h"
+#include "Profiler.h"
 
 namespace gameplay
 {
 
 Model::Model(Mesh* mesh) :
-    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _node(NULL), _skin(NULL)
+    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _node(NULL), _skin(NULL),
+    _meshLodLevel(0), _meshLodHysteresis(0.1f), _lodDistance(0.0f), _lodScreenSize(1.0f), _lightmap(NULL)
 {
     GP_ASSERT(mesh);
     _partCount = mesh->getPartCount();
@@ -29,6 +36,18 @@ Model::~Model()
         SAFE_DELETE_ARRAY(_partMaterials);
     }
 
+    clearMeshLods();
+
+    for (size_t i = 0, count = _instanceParameters.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_instanceParameters[i]);
+    }
+    for (size_t i = 0, count = _meshBindings.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_meshBindings[i].second);
+    }
+    SAFE_RELEASE(_lightmap);
+
     SAFE_RELEASE(_mesh);
 
     SAFE_DELETE(_skin);
@@ -208,6 +227,36 @@ bool Model::hasMaterial(unsigned int partIndex) const
     return (partIndex < _partCount && _partMaterials && _partMaterials[partIndex]);
 }
 
+MaterialParameter* Model::getInstanceParameter(const char* name)
+{
+    GP_ASSERT(name);
+
+    for (size_t i = 0, count = _instanceParameters.size(); i < count; ++i)
+    {
+        if (strcmp(_instanceParameters[i]->getName(), name) == 0)
+            return _instanceParameters[i];
+    }
+
+    MaterialParameter* param = new MaterialParameter(name);
+    _instanceParameters.push_back(param);
+    return param;
+}
+
+void Model::clearInstanceParameter(const char* name)
+{
+    GP_ASSERT(name);
+
+    for (size_t i = 0, count = _instanceParameters.size(); i < count; ++i)
+    {
+        if (strcmp(_instanceParameters[i]->getName(), name) == 0)
+        {
+            SAFE_RELEASE(_instanceParameters[i]);
+            _instanceParameters.erase(_instanceParameters.begin() + i);
+            break;
+        }
+    }
+}
+
 MeshSkin* Model::getSkin() const
 {
     return _skin;
@@ -217,6 +266,11 @@ void Model::setSkin(MeshSkin* skin)
 {
     if (_skin != skin)
     {
+        // The scene's node ID index includes the joints of the skin.
+        Scene* scene = _node ? _node->getScene() : NULL;
+        if (scene)
+            scene->_nodeIndexDirty = true;
+
         // Free the old skin
         SAFE_DELETE(_skin);
 
@@ -265,7 +319,7 @@ static bool drawWireframe(Mesh* mesh)
             unsigned int vertexCount = mesh->getVertexCount();
             for (unsigned int i = 0; i < vertexCount; i += 3)
             {
-                GL_ASSERT( glDrawArrays(GL_LINE_LOOP, i, 3) );
+                RenderCommandList::drawArrays(GL_LINE_LOOP, i, 3);
             }
         }
         return true;
@@ -275,7 +329,7 @@ static bool drawWireframe(Mesh* mesh)
             unsigned int vertexCount = mesh->getVertexCount();
             for (unsigned int i = 2; i < vertexCount; ++i)
             {
-                GL_ASSERT( glDrawArrays(GL_LINE_LOOP, i-2, 3) );
+                RenderCommandList::drawArrays(GL_LINE_LOOP, i-2, 3);
             }
         }
         return true;
@@ -312,7 +366,7 @@ static bool drawWireframe(MeshPart* part)
         {
             for (unsigned int i = 0; i < indexCount; i += 3)
             {
-                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), ((const GLvoid*)(i*indexSize))) );
+                RenderCommandList::drawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), part->getIndexOffset() + i*indexSize);
             }
         }
         return true;
@@ -321,7 +375,7 @@ static bool drawWireframe(MeshPart* part)
         {
             for (unsigned int i = 2; i < indexCount; ++i)
             {
-                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), ((const GLvoid*)((i-2)*indexSize))) );
+                RenderCommandList::drawElements(GL_LINE_LOOP, 3, part->getIndexFormat(), part->getIndexOffset() + (i-2)*indexSize);
             }
         }
         return true;
@@ -336,26 +390,22 @@ void Model::draw(bool wireframe)
 {
     GP_ASSERT(_mesh);
 
+    updateMeshLod();
+
     unsigned int partCount = _mesh->getPartCount();
     if (partCount == 0)
     {
         // No mesh parts (index buffers).
         if (_material)
         {
-            Technique* technique = _material->getTechnique();
+            Technique* technique = getLodTechnique(_material);
             GP_ASSERT(technique);
             unsigned int passCount = technique->getPassCount();
             for (unsigned int i = 0; i < passCount; ++i)
             {
                 Pass* pass = technique->getPassByIndex(i);
                 GP_ASSERT(pass);
-                pass->bind();
-                GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0) );
-                if (!wireframe || !drawWireframe(_mesh))
-                {
-                    GL_ASSERT( glDrawArrays(_mesh->getPrimitiveType(), 0, _mesh->getVertexCount()) );
-                }
-                pass->unbind();
+                drawPart(-1, pass, wireframe);
             }
         }
     }
@@ -363,33 +413,226 @@ void Model::draw(bool wireframe)
     {
         for (unsigned int i = 0; i < partCount; ++i)
         {
-            MeshPart* part = _mesh->getPart(i);
-            GP_ASSERT(part);
-
             // Get the material for this mesh part.
             Material* material = getMaterial(i);
             if (material)
             {
-                Technique* technique = material->getTechnique();
+                Technique* technique = getLodTechnique(material);
                 GP_ASSERT(technique);
                 unsigned int passCount = technique->getPassCount();
                 for (unsigned int j = 0; j < passCount; ++j)
                 {
                     Pass* pass = technique->getPassByIndex(j);
                     GP_ASSERT(pass);
-                    pass->bind();
-                    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->_indexBuffer) );
-                    if (!wireframe || !drawWireframe(part))
-                    {
-                        GL_ASSERT( glDrawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), 0) );
-                    }
-                    pass->unbind();
+                    drawPart(i, pass, wireframe);
                 }
             }
         }
     }
 }
 
+void Model::draw(Material* material)
+{
+    GP_ASSERT(_mesh);
+    GP_ASSERT(material);
+
+    updateMeshLod();
+
+    Technique* technique = getLodTechnique(material);
+    GP_ASSERT(technique);
+    unsigned int partCount = _mesh->getPartCount();
+    for (unsigned int i = 0, passCount = technique->getPassCount(); i < passCount; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+        if (partCount == 0)
+        {
+            drawPart(-1, pass, false);
+        }
+        else
+        {
+            for (unsigned int j = 0; j < partCount; ++j)
+            {
+                drawPart(j, pass, false);
+            }
+        }
+    }
+}
+
+void Model::drawPart(int partIndex, Pass* pass, bool wireframe)
+{
+    GP_ASSERT(_mesh);
+    GP_ASSERT(pass);
+
+    TextureStreamer* streamer = Game::getInstance()->getTextureStreamer();
+    if (_node && streamer && streamer->isEnabled())
+    {
+        streamer->notifyDraw(_node, pass);
+    }
+
+    // A simplified level may have dropped all the triangles of a part.
+    Mesh* mesh = _meshLodLevel > 0 ? _meshLods[_meshLodLevel - 1].mesh : _mesh;
+    if (partIndex >= 0 && (partIndex >= (int)mesh->getPartCount() || mesh->getPart(partIndex)->getIndexCount() == 0))
+        return;
+
+    DebugMarkers::Group marker(_node ? _node->getId() : "Model", pass->getLabel());
+
+    // A shared material is bound to the node of the model that drew it last. Built-in
+    // auto bindings read the node when they are bound, so switching it is cheap.
+    RenderState* renderState = pass;
+    if (renderState->_nodeBinding != _node)
+    {
+        for (; renderState; renderState = renderState->_parent)
+        {
+            renderState->setNodeBinding(_node);
+        }
+    }
+
+    pass->bind();
+
+    Effect* effect = pass->getEffect();
+    for (size_t i = 0, count = _instanceParameters.size(); i < count; ++i)
+    {
+        _instanceParameters[i]->bind(effect);
+    }
+    if (_lightmap)
+    {
+        Uniform* uniform = effect->getUniform("u_lightmapTexture");
+        if (uniform)
+            effect->setValue(uniform, _lightmap);
+    }
+
+    // The pass binding normally refers to the model's own mesh; levels of detail share its
+    // vertex format, so their binding enables the same attributes. A shared material's
+    // pass binding may refer to the mesh of another model instead.
+    VertexAttributeBinding* meshBinding = NULL;
+    if (mesh != _mesh)
+    {
+        meshBinding = getMeshLodBinding(effect);
+    }
+    else if (!pass->getVertexAttributeBinding() || pass->getVertexAttributeBinding()->_mesh != _mesh)
+    {
+        meshBinding = getMeshBinding(effect);
+    }
+    if (meshBinding)
+    {
+        meshBinding->bind();
+    }
+
+    Profiler::GpuDrawScope gpuDraw(pass->getLabel(), effect->getId());
+    if (partIndex < 0)
+    {
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        if (!wireframe || !drawWireframe(mesh))
+        {
+            RenderCommandList::drawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount());
+            RenderStats::addDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount());
+        }
+    }
+    else
+    {
+        MeshPart* part = mesh->getPart(partIndex);
+        GP_ASSERT(part);
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, part->_indexBuffer);
+        if (!wireframe || !drawWireframe(part))
+        {
+            RenderCommandList::drawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), part->getIndexOffset());
+            RenderStats::addDrawCall(part->getPrimitiveType(), part->getIndexCount());
+        }
+    }
+
+    if (meshBinding)
+    {
+        meshBinding->unbind();
+    }
+    pass->unbind();
+}
+
+static void drawInstances(Mesh* mesh, MeshPart* part, Pass* pass, InstanceBuffer* instances)
+{
+    unsigned int instanceCount = instances->getInstanceCount();
+    IndexBufferHandle indexBuffer = part ? part->getIndexBuffer() : 0;
+
+    DebugMarkers::Group marker("Instances", pass->getLabel());
+    pass->bind();
+    Profiler::GpuDrawScope gpuDraw(pass->getLabel(), pass->getEffect()->getId());
+
+#ifdef USE_INSTANCED_ARRAYS
+    if (InstanceBuffer::isHardwareInstancingSupported())
+    {
+        VertexAttributeBinding* binding = instances->getVertexAttributeBinding(mesh, pass->getEffect());
+        if (binding)
+        {
+            binding->bind();
+        }
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        if (part)
+        {
+            RenderCommandList::drawElementsInstanced(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), part->getIndexOffset(), instanceCount);
+            RenderStats::addDrawCall(part->getPrimitiveType(), part->getIndexCount(), instanceCount);
+        }
+        else
+        {
+            RenderCommandList::drawArraysInstanced(mesh->getPrimitiveType(), 0, mesh->getVertexCount(), instanceCount);
+            RenderStats::addDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount(), instanceCount);
+        }
+        if (binding)
+        {
+            binding->unbind();
+        }
+    }
+    else
+#endif
+    {
+        // Pseudo-instancing: one draw call per instance with the instance attributes set as uniforms.
+        Effect* effect = pass->getEffect();
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        for (unsigned int i = 0; i < instanceCount; ++i)
+        {
+            instances->bindInstanceUniforms(effect, i);
+            if (part)
+            {
+                RenderCommandList::drawElements(part->getPrimitiveType(), part->getIndexCount(), part->getIndexFormat(), part->getIndexOffset());
+                RenderStats::addDrawCall(part->getPrimitiveType(), part->getIndexCount());
+            }
+            else
+            {
+                RenderCommandList::drawArrays(mesh->getPrimitiveType(), 0, mesh->getVertexCount());
+                RenderStats::addDrawCall(mesh->getPrimitiveType(), mesh->getVertexCount());
+            }
+        }
+    }
+
+    pass->unbind();
+}
+
+void Model::drawInstanced(InstanceBuffer* instances)
+{
+    GP_ASSERT(_mesh);
+    GP_ASSERT(instances);
+
+    if (instances->getInstanceCount() == 0)
+        return;
+
+    unsigned int partCount = _mesh->getPartCount();
+    for (unsigned int i = 0, count = std::max(partCount, 1u); i < count; ++i)
+    {
+        MeshPart* part = partCount ? _mesh->getPart(i) : NULL;
+        Material* material = partCount ? getMaterial(i) : _material;
+        if (material)
+        {
+            Technique* technique = material->getTechnique();
+            GP_ASSERT(technique);
+            for (unsigned int j = 0, passCount = technique->getPassCount(); j < passCount; ++j)
+            {
+                Pass* pass = technique->getPassByIndex(j);
+                GP_ASSERT(pass);
+                drawInstances(_mesh, part, pass, instances);
+            }
+        }
+    }
+}
+
 void Model::validatePartCount()
 {
     GP_ASSERT(_mesh);
@@ -431,7 +674,11 @@ Model* Model::clone(NodeCloneContext &context)
     {
         model->setSkin(getSkin()->clone(context));
     }
-    if (getMaterial())
+    if (getMaterial() && (getMaterial()->isShared() || context.isShareMaterials()))
+    {
+        model->setMaterial(getMaterial());
+    }
+    else if (getMaterial())
     {
         Material* materialClone = getMaterial()->clone(context);
         if (!materialClone)
@@ -442,12 +689,22 @@ Model* Model::clone(NodeCloneContext &context)
         model->setMaterial(materialClone);
         materialClone->release();
     }
+    model->_animationLods = _animationLods;
+    for (size_t i = 0, count = _meshLods.size(); i < count; ++i)
+    {
+        model->addMeshLod(_meshLods[i].mesh, _meshLods[i].screenSize);
+    }
+    model->_meshLodHysteresis = _meshLodHysteresis;
     if (_partMaterials)
     {
         GP_ASSERT(_partCount == model->_partCount);
         for (unsigned int i = 0; i < _partCount; ++i)
         {
-            if (_partMaterials[i])
+            if (_partMaterials[i] && (_partMaterials[i]->isShared() || context.isShareMaterials()))
+            {
+                model->setMaterial(_partMaterials[i], i);
+            }
+            else if (_partMaterials[i])
             {
                 Material* materialClone = _partMaterials[i]->clone(context);
                 model->setMaterial(materialClone, i);
@@ -455,9 +712,245 @@ Model* Model::clone(NodeCloneContext &context)
             }
         }
     }
+    for (size_t i = 0, count = _instanceParameters.size(); i < count; ++i)
+    {
+        MaterialParameter* param = new MaterialParameter(_instanceParameters[i]->getName());
+        _instanceParameters[i]->cloneInto(param);
+        model->_instanceParameters.push_back(param);
+    }
+    model->setLightmap(_lightmap);
     return model;
 }
 
+void Model::setLightmap(Texture::Sampler* lightmap)
+{
+    if (lightmap == _lightmap)
+        return;
+
+    SAFE_RELEASE(_lightmap);
+    _lightmap = lightmap;
+    if (_lightmap)
+        _lightmap->addRef();
+}
+
+Texture::Sampler* Model::getLightmap() const
+{
+    return _lightmap;
+}
+
+void Model::addAnimationLod(float distance, unsigned int frameInterval)
+{
+    GP_ASSERT(frameInterval > 0);
+
+    AnimationLod lod;
+    lod.distance = distance;
+    lod.frameInterval = std::max(frameInterval, 1u);
+
+    std::vector<AnimationLod>::iterator itr = _animationLods.begin();
+    while (itr != _animationLods.end() && itr->distance <= distance)
+    {
+        ++itr;
+    }
+    _animationLods.insert(itr, lod);
+}
+
+void Model::clearAnimationLods()
+{
+    _animationLods.clear();
+}
+
+unsigned int Model::getAnimationLodInterval() const
+{
+    if (_animationLods.empty() || _node == NULL)
+        return 1;
+
+    Scene* scene = _node->getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+        return 1;
+
+    float distanceSquared = _node->getTranslationWorld().distanceSquared(camera->getNode()->getTranslationWorld());
+    unsigned int frameInterval = 1;
+    for (size_t i = 0, count = _animationLods.size(); i < count; ++i)
+    {
+        const AnimationLod& lod = _animationLods[i];
+        if (distanceSquared < lod.distance * lod.distance)
+            break;
+        frameInterval = lod.frameInterval;
+    }
+    return frameInterval;
+}
+
+void Model::addMeshLod(Mesh* mesh, float screenSize)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(mesh->getVertexFormat() == _mesh->getVertexFormat());
+
+    mesh->addRef();
+
+    MeshLod lod;
+    lod.mesh = mesh;
+    lod.screenSize = screenSize;
+
+    std::vector<MeshLod>::iterator itr = _meshLods.begin();
+    while (itr != _meshLods.end() && itr->screenSize >= screenSize)
+    {
+        ++itr;
+    }
+    _meshLods.insert(itr, lod);
+    _meshLodLevel = 0;
+}
+
+void Model::clearMeshLods()
+{
+    for (size_t i = 0, count = _meshLods.size(); i < count; ++i)
+    {
+        MeshLod& lod = _meshLods[i];
+        for (size_t j = 0, bindingCount = lod.bindings.size(); j < bindingCount; ++j)
+        {
+            SAFE_RELEASE(lod.bindings[j].second);
+        }
+        SAFE_RELEASE(lod.mesh);
+    }
+    _meshLods.clear();
+    _meshLodLevel = 0;
+}
+
+unsigned int Model::getMeshLodCount() const
+{
+    return (unsigned int)_meshLods.size();
+}
+
+Mesh* Model::getMeshLod(unsigned int index) const
+{
+    GP_ASSERT(index < _meshLods.size());
+    return _meshLods[index].mesh;
+}
+
+unsigned int Model::getMeshLodLevel() const
+{
+    return _meshLodLevel;
+}
+
+void Model::setMeshLodHysteresis(float hysteresis)
+{
+    _meshLodHysteresis = std::max(hysteresis, 0.0f);
+}
+
+float Model::getMeshLodHysteresis() const
+{
+    return _meshLodHysteresis;
+}
+
+void Model::updateMeshLod()
+{
+    // Without a camera, the model is drawn with its most detailed mesh and techniques.
+    _lodDistance = 0.0f;
+    _lodScreenSize = 1.0f;
+    if (_node == NULL || (_meshLods.empty() && !hasLodTechniques()))
+    {
+        _meshLodLevel = 0;
+        return;
+    }
+
+    Scene* scene = _node->getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+    {
+        _meshLodLevel = 0;
+        return;
+    }
+
+    // Fraction of the viewport height covered by the bounding sphere.
+    const BoundingSphere& sphere = _node->getBoundingSphere();
+    float distance = sphere.center.distance(camera->getNode()->getTranslationWorld());
+    float size;
+    if (camera->getCameraType() == Camera::PERSPECTIVE)
+    {
+        float tanHalfFov = tan(MATH_DEG_TO_RAD(camera->getFieldOfView()) * 0.5f);
+        size = distance > sphere.radius ? sphere.radius / (distance * tanHalfFov) : 1.0f;
+    }
+    else
+    {
+        size = camera->getZoomY() > 0.0f ? 2.0f * sphere.radius / camera->getZoomY() : 1.0f;
+    }
+    _lodDistance = distance;
+    _lodScreenSize = size;
+
+    unsigned int level = _meshLodLevel;
+    unsigned int count = (unsigned int)_meshLods.size();
+    if (level > count)
+        level = 0;
+    while (level < count && size < _meshLods[level].screenSize * (1.0f - _meshLodHysteresis))
+    {
+        ++level;
+    }
+    while (level > 0 && size > _meshLods[level - 1].screenSize * (1.0f + _meshLodHysteresis))
+    {
+        --level;
+    }
+    _meshLodLevel = level;
+}
+
+Technique* Model::getLodTechnique(Material* material) const
+{
+    GP_ASSERT(material);
+    return material->getLodTechnique(_lodDistance, _lodScreenSize);
+}
+
+bool Model::hasLodTechniques() const
+{
+    if (_material && _material->hasLodTechniques())
+        return true;
+    if (_partMaterials)
+    {
+        for (unsigned int i = 0; i < _partCount; ++i)
+        {
+            if (_partMaterials[i] && _partMaterials[i]->hasLodTechniques())
+                return true;
+        }
+    }
+    return false;
+}
+
+VertexAttributeBinding* Model::getMeshLodBinding(Effect* effect)
+{
+    GP_ASSERT(_meshLodLevel > 0 && _meshLodLevel <= _meshLods.size());
+    GP_ASSERT(effect);
+
+    MeshLod& lod = _meshLods[_meshLodLevel - 1];
+    for (size_t i = 0, count = lod.bindings.size(); i < count; ++i)
+    {
+        if (lod.bindings[i].first == effect)
+            return lod.bindings[i].second;
+    }
+
+    VertexAttributeBinding* binding = VertexAttributeBinding::create(lod.mesh, effect);
+    if (binding)
+    {
+        lod.bindings.push_back(std::make_pair(effect, binding));
+    }
+    return binding;
+}
+
+VertexAttributeBinding* Model::getMeshBinding(Effect* effect)
+{
+    GP_ASSERT(effect);
+
+    for (size_t i = 0, count = _meshBindings.size(); i < count; ++i)
+    {
+        if (_meshBindings[i].first == effect)
+            return _meshBindings[i].second;
+    }
+
+    VertexAttributeBinding* binding = VertexAttributeBinding::create(_mesh, effect);
+    if (binding)
+    {
+        _meshBindings.push_back(std::make_pair(effect, binding));
+    }
+    return binding;
+}
+
 void Model::setMaterialNodeBinding(Material *material)
 {
     GP_ASSERT(material);
@@ -4,6 +4,7 @@
 #include "Mesh.h"
 #include "MeshSkin.h"
 #include "Material.h"
+#include "InstanceBuffer.h"
 
 namespace gameplay
 {
@@ -23,6 +24,10 @@ class Model : public Ref
     friend class Scene;
     friend class Mesh;
     friend class Bundle;
+    friend class RenderQueue;
+    friend class Picker;
+
+    GP_POOLED_ALLOCATION(SCENE)
 
 public:
 
@@ -121,6 +126,47 @@ public:
      */
     bool hasMaterial(unsigned int partIndex) const;
 
+    /**
+     * Returns the per-instance value of a material parameter for this model.
+     *
+     * Instance parameters are applied after the parameters of the material each time this
+     * model is drawn. They let models that share a material keep their own values, such as
+     * a tint color, without a material per model. The parameter is created the first time.
+     *
+     * @param name The name of the material parameter.
+     *
+     * @return The instance parameter.
+     */
+    MaterialParameter* getInstanceParameter(const char* name);
+
+    /**
+     * Removes the per-instance value of a material parameter for this model.
+     *
+     * @param name The name of the material parameter.
+     */
+    void clearInstanceParameter(const char* name);
+
+    /**
+     * Sets the lightmap baked for this model by the encoder.
+     *
+     * The lightmap holds the static lighting of the model, laid out by its second set of
+     * texture coordinates. It is bound to the u_lightmapTexture uniform of the materials
+     * that have one, such as the unlit shaders with TEXTURE_LIGHTMAP and TEXCOORD1 defined,
+     * so that models sharing a material keep their own lightmap.
+     *
+     * @param lightmap The lightmap sampler, or NULL to remove the lightmap.
+     * @script{ignore}
+     */
+    void setLightmap(Texture::Sampler* lightmap);
+
+    /**
+     * Returns the lightmap of this model.
+     *
+     * @return The lightmap sampler, or NULL if the model has none.
+     * @script{ignore}
+     */
+    Texture::Sampler* getLightmap() const;
+
     /**
      * Returns the MeshSkin.
      * 
@@ -157,8 +203,153 @@ public:
      */
     void draw(bool wireframe = false);
 
+    /**
+     * Draws this mesh instance with a material other than its own.
+     *
+     * Every mesh part is drawn with the passes of the specified material, which is
+     * bound to the model's node for the draw. This is meant for passes that only need
+     * the geometry of a model, such as rendering the depth of shadow casters.
+     *
+     * @param material The material to draw every mesh part with.
+     * @script{ignore}
+     */
+    void draw(Material* material);
+
+    /**
+     * Draws the instances in the specified instance buffer using this model's mesh and materials.
+     *
+     * Each mesh part is drawn once for all instances using hardware instancing
+     * when it is supported, or once per instance with the instance attributes
+     * passed as uniforms otherwise (see InstanceBuffer). The materials should use
+     * an effect that reads the instance attributes, such as the built-in unlit
+     * shaders compiled with the INSTANCED define.
+     *
+     * @param instances The instances to draw.
+     * @script{ignore}
+     */
+    void drawInstanced(InstanceBuffer* instances);
+
+    /**
+     * Adds an animation level of detail to the model.
+     *
+     * Once the model's node is at least the specified distance away from the active
+     * camera of its scene, the animation clips driving the model's skin are only
+     * evaluated every frameInterval frames. The joints, and so the skin's matrix
+     * palette, are left unchanged on the frames in between. Clips that are cross
+     * fading are always evaluated.
+     *
+     * @param distance The distance from the active camera at which the level starts.
+     * @param frameInterval The number of frames between two evaluations of the clips.
+     * @script{ignore}
+     */
+    void addAnimationLod(float distance, unsigned int frameInterval);
+
+    /**
+     * Removes all animation levels of detail, so that the model is animated every frame.
+     *
+     * @script{ignore}
+     */
+    void clearAnimationLods();
+
+    /**
+     * Gets the number of frames between two evaluations of the animation clips driving
+     * the model, for the current distance of the model from the active camera.
+     *
+     * @return The frame interval; one if the model is animated every frame.
+     * @script{ignore}
+     */
+    unsigned int getAnimationLodInterval() const;
+
+    /**
+     * Adds a mesh level of detail to the model.
+     *
+     * Once the model's bounding sphere covers less than the specified fraction of the
+     * viewport height of the active camera of its scene, the model is drawn with the
+     * given mesh instead of its own. The mesh must have the same vertex format, position
+     * decode (see Mesh::getPositionDecode) and number of parts as the model's mesh, so
+     * that the model's materials and skin apply to it unchanged. The encoder generates
+     * such meshes with its -lod option and they are loaded with the model from bundles.
+     *
+     * @param mesh The simplified mesh.
+     * @param screenSize The fraction of the viewport height below which the mesh is drawn.
+     * @script{ignore}
+     */
+    void addMeshLod(Mesh* mesh, float screenSize);
+
+    /**
+     * Removes all mesh levels of detail, so that the model is always drawn with its own mesh.
+     *
+     * @script{ignore}
+     */
+    void clearMeshLods();
+
+    /**
+     * Gets the number of mesh levels of detail.
+     *
+     * @return The number of mesh levels of detail, not counting the model's own mesh.
+     * @script{ignore}
+     */
+    unsigned int getMeshLodCount() const;
+
+    /**
+     * Gets the mesh of a level of detail.
+     *
+     * @param index The index of the level, from 0 (the most detailed) to getMeshLodCount() - 1.
+     *
+     * @return The mesh of the level.
+     * @script{ignore}
+     */
+    Mesh* getMeshLod(unsigned int index) const;
+
+    /**
+     * Gets the level of detail the model was last drawn with.
+     *
+     * @return 0 if the model was drawn with its own mesh, or the index of the level plus one.
+     * @script{ignore}
+     */
+    unsigned int getMeshLodLevel() const;
+
+    /**
+     * Sets the hysteresis applied when switching between mesh levels of detail.
+     *
+     * A level is only entered once the screen size is below its threshold by this
+     * fraction of the threshold, and only left once it is above it by the same
+     * fraction, which keeps models near a threshold from switching every frame.
+     *
+     * @param hysteresis The fraction of the thresholds, 0.1 by default.
+     * @script{ignore}
+     */
+    void setMeshLodHysteresis(float hysteresis);
+
+    /**
+     * Gets the hysteresis applied when switching between mesh levels of detail.
+     *
+     * @return The fraction of the thresholds.
+     * @script{ignore}
+     */
+    float getMeshLodHysteresis() const;
+
 private:
 
+    /**
+     * Defines an animation level of detail.
+     */
+    struct AnimationLod
+    {
+        float distance;
+        unsigned int frameInterval;
+    };
+
+    /**
+     * Defines a mesh level of detail.
+     */
+    struct MeshLod
+    {
+        Mesh* mesh;
+        float screenSize;
+        std::vector<std::pair<Effect*, VertexAttributeBinding*> > bindings;
+    };
+
     /**
      * Constructor.
      */
@@ -188,6 +379,39 @@ private:
 
     void validatePartCount();
 
+    /**
+     * Selects the mesh level of detail for the current projected size of the model, and
+     * measures the distance and size that select the techniques of its materials.
+     */
+    void updateMeshLod();
+
+    /**
+     * Returns the technique of the specified material for the current distance and projected size of the model.
+     */
+    Technique* getLodTechnique(Material* material) const;
+
+    /**
+     * Determines if any material of the model has techniques selected by distance or size.
+     */
+    bool hasLodTechniques() const;
+
+    /**
+     * Returns the vertex attribute binding of the current mesh level of detail for the specified effect.
+     */
+    VertexAttributeBinding* getMeshLodBinding(Effect* effect);
+
+    /**
+     * Returns the vertex attribute binding of this model's mesh for the specified effect, for
+     * passes of a shared material whose binding was set up by another model.
+     */
+    VertexAttributeBinding* getMeshBinding(Effect* effect);
+
+    /**
+     * Draws a single mesh part (or the whole mesh when partIndex is -1) with the specified pass,
+     * using the mesh of the current level of detail.
+     */
+    void drawPart(int partIndex, Pass* pass, bool wireframe);
+
     /**
      * Clones the model and returns a new model.
      * 
@@ -202,6 +426,15 @@ private:
     Material** _partMaterials;
     Node* _node;
     MeshSkin* _skin;
+    std::vector<AnimationLod> _animationLods;    // Sorted by increasing distance.
+    std::vector<MeshLod> _meshLods;              // Sorted by decreasing screen size.
+    unsigned int _meshLodLevel;
+    float _meshLodHysteresis;
+    float _lodDistance;                          // Distance from the camera when last drawn.
+    float _lodScreenSize;                        // Fraction of the viewport height covered when last drawn.
+    std::vector<MaterialParameter*> _instanceParameters;
+    Texture::Sampler* _lightmap;
+    std::vector<std::pair<Effect*, VertexAttributeBinding*> > _meshBindings;
 };
 
 }
@@ -0,0 +1,508 @@
+#include "Base.h"
+#include "NavigationMesh.h"
+#include "Bundle.h"
+
+// The link of an edge that no other triangle shares, as stored in bundles.
+#define NAVIGATION_NO_LINK 0xFFFFFFFF
+
+// The states of the triangles of a search.
+#define SEARCH_UNVISITED 0
+#define SEARCH_OPEN 1
+#define SEARCH_CLOSED 2
+#define SEARCH_REOPENED 3
+
+namespace gameplay
+{
+
+/**
+ * Orders the open triangles of a search so that the heap keeps the lowest estimate first.
+ */
+static bool compareOpen(const std::pair<float, int>& a, const std::pair<float, int>& b)
+{
+    return a.first > b.first;
+}
+
+/**
+ * Gets twice the signed area of a triangle in the XZ plane, positive when c is to the left of a to b.
+ */
+static float cross2(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+    return (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x);
+}
+
+static bool equals2(const Vector3& a, const Vector3& b)
+{
+    const float dx = a.x - b.x;
+    const float dz = a.z - b.z;
+    return dx * dx + dz * dz < 1e-12f;
+}
+
+NavigationMesh::Search::Search()
+    : goal(-1), target(-1), exhausted(false)
+{
+}
+
+NavigationMesh::NavigationMesh()
+    : _cellSize(1.0f), _columns(0), _rows(0)
+{
+}
+
+NavigationMesh::~NavigationMesh()
+{
+}
+
+NavigationMesh* NavigationMesh::create(const char* path, const char* id)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(id);
+
+    Bundle* bundle = Bundle::create(path);
+    if (bundle == NULL)
+    {
+        GP_ERROR("Failed to load bundle '%s' for navigation mesh '%s'.", path, id);
+        return NULL;
+    }
+    NavigationMesh* mesh = bundle->loadNavigationMesh(id);
+    SAFE_RELEASE(bundle);
+    return mesh;
+}
+
+NavigationMesh* NavigationMesh::create(const char* id, const Data& data)
+{
+    const unsigned int vertexCount = (unsigned int)(data.vertices.size() / 3);
+    const unsigned int triangleCount = (unsigned int)(data.triangles.size() / 3);
+    bool valid = data.vertices.size() % 3 == 0 && data.triangles.size() % 3 == 0 && data.links.size() == data.triangles.size();
+    for (unsigned int i = 0, count = (unsigned int)data.triangles.size(); valid && i < count; ++i)
+    {
+        valid = data.triangles[i] < vertexCount && (data.links[i] < triangleCount || data.links[i] == NAVIGATION_NO_LINK);
+    }
+    if (!valid)
+    {
+        GP_ERROR("Invalid triangles in navigation mesh '%s'.", id);
+        return NULL;
+    }
+
+    NavigationMesh* mesh = new NavigationMesh();
+    mesh->_vertices.resize(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+        mesh->_vertices[i].set(&data.vertices[i * 3]);
+    mesh->_triangles = data.triangles;
+    mesh->_links.resize(data.links.size());
+    for (size_t i = 0, count = data.links.size(); i < count; ++i)
+        mesh->_links[i] = data.links[i] == NAVIGATION_NO_LINK ? -1 : (int)data.links[i];
+    if (triangleCount == 0)
+        return mesh;
+
+    // The cost of moving between two triangles is the distance between their centers.
+    mesh->_centers.resize(triangleCount);
+    Vector3 min(mesh->_vertices[mesh->_triangles[0]]);
+    Vector3 max(min);
+    for (unsigned int i = 0; i < triangleCount; ++i)
+    {
+        const Vector3& a = mesh->_vertices[mesh->_triangles[i * 3]];
+        const Vector3& b = mesh->_vertices[mesh->_triangles[i * 3 + 1]];
+        const Vector3& c = mesh->_vertices[mesh->_triangles[i * 3 + 2]];
+        mesh->_centers[i] = (a + b + c) / 3.0f;
+        min.set(std::min(min.x, std::min(a.x, std::min(b.x, c.x))), std::min(min.y, std::min(a.y, std::min(b.y, c.y))), std::min(min.z, std::min(a.z, std::min(b.z, c.z))));
+        max.set(std::max(max.x, std::max(a.x, std::max(b.x, c.x))), std::max(max.y, std::max(a.y, std::max(b.y, c.y))), std::max(max.z, std::max(a.z, std::max(b.z, c.z))));
+    }
+    mesh->_boundingBox.set(min, max);
+
+    // Sort the triangles into a grid over the XZ plane with about one cell per triangle.
+    const float width = std::max(max.x - min.x, 1e-3f);
+    const float depth = std::max(max.z - min.z, 1e-3f);
+    mesh->_cellSize = sqrt(width * depth / triangleCount);
+    mesh->_columns = std::min((unsigned int)(width / mesh->_cellSize) + 1, 1024u);
+    mesh->_rows = std::min((unsigned int)(depth / mesh->_cellSize) + 1, 1024u);
+    mesh->_cellSize = std::max(width / mesh->_columns, depth / mesh->_rows) * 1.0001f;
+    mesh->_cellStarts.assign(mesh->_columns * mesh->_rows + 1, 0);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            // Turn the counts into the offsets of the cells, then fill them.
+            for (unsigned int i = 1, count = (unsigned int)mesh->_cellStarts.size(); i < count; ++i)
+                mesh->_cellStarts[i] += mesh->_cellStarts[i - 1];
+            mesh->_cellTriangles.resize(mesh->_cellStarts.back());
+        }
+        for (unsigned int i = triangleCount; i-- > 0; )
+        {
+            const Vector3& a = mesh->_vertices[mesh->_triangles[i * 3]];
+            const Vector3& b = mesh->_vertices[mesh->_triangles[i * 3 + 1]];
+            const Vector3& c = mesh->_vertices[mesh->_triangles[i * 3 + 2]];
+            const unsigned int x1 = (unsigned int)((std::min(a.x, std::min(b.x, c.x)) - min.x) / mesh->_cellSize);
+            const unsigned int x2 = std::min((unsigned int)((std::max(a.x, std::max(b.x, c.x)) - min.x) / mesh->_cellSize), mesh->_columns - 1);
+            const unsigned int z1 = (unsigned int)((std::min(a.z, std::min(b.z, c.z)) - min.z) / mesh->_cellSize);
+            const unsigned int z2 = std::min((unsigned int)((std::max(a.z, std::max(b.z, c.z)) - min.z) / mesh->_cellSize), mesh->_rows - 1);
+            for (unsigned int z = z1; z <= z2; ++z)
+            {
+                for (unsigned int x = x1; x <= x2; ++x)
+                {
+                    const unsigned int cell = z * mesh->_columns + x;
+                    if (pass == 0)
+                        ++mesh->_cellStarts[cell + 1];
+                    else
+                        mesh->_cellTriangles[--mesh->_cellStarts[cell + 1]] = i;
+                }
+            }
+        }
+    }
+
+    return mesh;
+}
+
+unsigned int NavigationMesh::getTriangleCount() const
+{
+    return (unsigned int)_centers.size();
+}
+
+const BoundingBox& NavigationMesh::getBoundingBox() const
+{
+    return _boundingBox;
+}
+
+Vector3 NavigationMesh::getClosestPoint(unsigned int triangle, const Vector3& point) const
+{
+    const Vector3& a = _vertices[_triangles[triangle * 3]];
+    const Vector3& b = _vertices[_triangles[triangle * 3 + 1]];
+    const Vector3& c = _vertices[_triangles[triangle * 3 + 2]];
+
+    // Find the region of the triangle the point projects onto: a vertex, an edge or the face.
+    const Vector3 ab(b - a);
+    const Vector3 ac(c - a);
+    const Vector3 ap(point - a);
+    const float d1 = ab.dot(ap);
+    const float d2 = ac.dot(ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    const Vector3 bp(point - b);
+    const float d3 = ab.dot(bp);
+    const float d4 = ac.dot(bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    const Vector3 cp(point - c);
+    const float d5 = ab.dot(cp);
+    const float d6 = ac.dot(cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+int NavigationMesh::findTriangle(const Vector3& point, Vector3* closest) const
+{
+    if (_centers.empty())
+        return -1;
+
+    // Search the cells in rings around the cell of the point, until the rings are farther than the nearest triangle.
+    const Vector3& min = _boundingBox.min;
+    const int column = std::min(std::max((int)floor((point.x - min.x) / _cellSize), 0), (int)_columns - 1);
+    const int row = std::min(std::max((int)floor((point.z - min.z) / _cellSize), 0), (int)_rows - 1);
+    const float outsideX = std::max(std::max(min.x - point.x, point.x - _boundingBox.max.x), 0.0f);
+    const float outsideZ = std::max(std::max(min.z - point.z, point.z - _boundingBox.max.z), 0.0f);
+    const float outside = sqrt(outsideX * outsideX + outsideZ * outsideZ);
+    const int maxRing = (int)std::max(_columns, _rows);
+    int nearest = -1;
+    float nearestDistance = FLT_MAX;
+    for (int ring = 0; ring <= maxRing; ++ring)
+    {
+        for (int z = row - ring; z <= row + ring; ++z)
+        {
+            if (z < 0 || z >= (int)_rows)
+                continue;
+            const int step = (z == row - ring || z == row + ring) ? 1 : ring * 2;
+            for (int x = column - ring; x <= column + ring; x += std::max(step, 1))
+            {
+                if (x < 0 || x >= (int)_columns)
+                    continue;
+                const unsigned int cell = z * _columns + x;
+                for (unsigned int i = _cellStarts[cell], end = _cellStarts[cell + 1]; i < end; ++i)
+                {
+                    const unsigned int triangle = _cellTriangles[i];
+                    const Vector3 candidate(getClosestPoint(triangle, point));
+                    const float distance = candidate.distanceSquared(point);
+                    if (distance < nearestDistance)
+                    {
+                        nearest = (int)triangle;
+                        nearestDistance = distance;
+                        if (closest)
+                            *closest = candidate;
+                    }
+                }
+            }
+        }
+
+        // Every cell beyond this ring is at least this far from the point.
+        const float reach = outside + ring * _cellSize;
+        if (nearest >= 0 && nearestDistance <= reach * reach)
+            break;
+    }
+
+    return nearest;
+}
+
+bool NavigationMesh::findPath(const Vector3& start, const Vector3& end, std::vector<Vector3>* path) const
+{
+    GP_ASSERT(path);
+
+    path->clear();
+    const int startTriangle = findTriangle(start);
+    const int endTriangle = findTriangle(end);
+    if (startTriangle < 0 || endTriangle < 0)
+        return false;
+
+    Search search;
+    beginSearch(&search, endTriangle);
+    unsigned int iterations = UINT_MAX;
+    if (advanceSearch(&search, startTriangle, &iterations) != SEARCH_FOUND)
+        return false;
+
+    buildPath(search, startTriangle, start, end, path);
+    return true;
+}
+
+void NavigationMesh::beginSearch(Search* search, int goal) const
+{
+    GP_ASSERT(search);
+    GP_ASSERT(goal >= 0 && goal < (int)_centers.size());
+
+    const size_t triangleCount = _centers.size();
+    search->goal = goal;
+    search->target = goal;
+    search->exhausted = false;
+    search->costs.assign(triangleCount, 0.0f);
+    search->parents.assign(triangleCount, -1);
+    search->states.assign(triangleCount, SEARCH_UNVISITED);
+    search->open.clear();
+    search->open.push_back(std::make_pair(0.0f, goal));
+    search->states[goal] = SEARCH_OPEN;
+}
+
+NavigationMesh::SearchResult NavigationMesh::advanceSearch(Search* search, int start, unsigned int* iterations) const
+{
+    GP_ASSERT(search);
+    GP_ASSERT(iterations);
+    GP_ASSERT(start >= 0 && start < (int)_centers.size());
+
+    std::vector<unsigned char>& states = search->states;
+    if (states[start] == SEARCH_CLOSED)
+        return SEARCH_FOUND;
+    if (search->exhausted)
+        return SEARCH_FAILED;
+
+    std::vector<std::pair<float, int> >& open = search->open;
+    std::vector<float>& costs = search->costs;
+    if (*iterations == 0 && !open.empty())
+        return SEARCH_PENDING;
+    const Vector3& target = _centers[start];
+    if (search->target != start)
+    {
+        // Aim the search at the new start: estimate the open triangles again, dropping the stale entries.
+        search->target = start;
+        size_t count = 0;
+        for (size_t i = 0, openCount = open.size(); i < openCount; ++i)
+        {
+            const int triangle = open[i].second;
+            if (states[triangle] != SEARCH_OPEN)
+                continue;
+            states[triangle] = SEARCH_REOPENED;
+            open[count++] = std::make_pair(costs[triangle] + _centers[triangle].distance(target), triangle);
+        }
+        open.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            states[open[i].second] = SEARCH_OPEN;
+        std::make_heap(open.begin(), open.end(), compareOpen);
+    }
+
+    // The distance between centers is consistent, so an expanded triangle has its shortest cost and is never expanded again.
+    while (!open.empty())
+    {
+        if (*iterations == 0)
+            return SEARCH_PENDING;
+
+        std::pop_heap(open.begin(), open.end(), compareOpen);
+        const int triangle = open.back().second;
+        open.pop_back();
+        if (states[triangle] == SEARCH_CLOSED)
+            continue;
+        states[triangle] = SEARCH_CLOSED;
+        --*iterations;
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            const int neighbor = _links[triangle * 3 + i];
+            if (neighbor < 0 || states[neighbor] == SEARCH_CLOSED)
+                continue;
+            const float cost = costs[triangle] + _centers[triangle].distance(_centers[neighbor]);
+            if (states[neighbor] == SEARCH_UNVISITED || cost < costs[neighbor])
+            {
+                costs[neighbor] = cost;
+                search->parents[neighbor] = triangle;
+                states[neighbor] = SEARCH_OPEN;
+                open.push_back(std::make_pair(cost + _centers[neighbor].distance(target), neighbor));
+                std::push_heap(open.begin(), open.end(), compareOpen);
+            }
+        }
+
+        if (triangle == start)
+            return SEARCH_FOUND;
+    }
+
+    // Every triangle connected to the destination is expanded.
+    search->exhausted = true;
+    return SEARCH_FAILED;
+}
+
+void NavigationMesh::buildPath(const Search& search, int start, const Vector3& startPoint, const Vector3& endPoint, std::vector<Vector3>* path) const
+{
+    GP_ASSERT(path);
+    GP_ASSERT(search.states[start] == SEARCH_CLOSED);
+
+    // The portals are the edges the path crosses from the start triangle to the destination, left end first.
+    // The triangles are wound clockwise in the XZ plane, so the first vertex of an edge is on the left when leaving.
+    std::vector<int> corridor;
+    std::vector<Vector3> portals;
+    for (int triangle = start; ; triangle = search.parents[triangle])
+    {
+        corridor.push_back(triangle);
+        if (triangle == search.goal)
+            break;
+        const int next = search.parents[triangle];
+        GP_ASSERT(next >= 0);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            if (_links[triangle * 3 + i] == next)
+            {
+                portals.push_back(_vertices[_triangles[triangle * 3 + i]]);
+                portals.push_back(_vertices[_triangles[triangle * 3 + (i + 1) % 3]]);
+                break;
+            }
+        }
+    }
+    portals.push_back(endPoint);
+    portals.push_back(endPoint);
+
+    // Pull the path tight through the portals: narrow a funnel from the apex until one side crosses the other,
+    // which makes the crossed side a corner of the path and the apex of the next funnel.
+    std::vector<Vector3> points;
+    std::vector<int> pointTriangles;
+    points.push_back(startPoint);
+    pointTriangles.push_back(start);
+    Vector3 apex(startPoint), left(startPoint), right(startPoint);
+    unsigned int apexIndex = 0, leftIndex = 0, rightIndex = 0;
+    const unsigned int portalCount = (unsigned int)portals.size() / 2;
+    for (unsigned int i = 0; i < portalCount; ++i)
+    {
+        const Vector3& portalLeft = portals[i * 2];
+        const Vector3& portalRight = portals[i * 2 + 1];
+
+        if (cross2(apex, right, portalRight) >= 0.0f)
+        {
+            if (equals2(apex, right) || cross2(apex, left, portalRight) < 0.0f)
+            {
+                right = portalRight;
+                rightIndex = i;
+            }
+            else
+            {
+                apex = left;
+                apexIndex = leftIndex;
+                if (!equals2(points.back(), apex))
+                {
+                    points.push_back(apex);
+                    pointTriangles.push_back(corridor[apexIndex + 1]);
+                }
+                right = left = apex;
+                rightIndex = leftIndex = i = apexIndex;
+                continue;
+            }
+        }
+
+        if (cross2(apex, left, portalLeft) <= 0.0f)
+        {
+            if (equals2(apex, left) || cross2(apex, right, portalLeft) > 0.0f)
+            {
+                left = portalLeft;
+                leftIndex = i;
+            }
+            else
+            {
+                apex = right;
+                apexIndex = rightIndex;
+                if (!equals2(points.back(), apex))
+                {
+                    points.push_back(apex);
+                    pointTriangles.push_back(corridor[apexIndex + 1]);
+                }
+                right = left = apex;
+                rightIndex = leftIndex = i = apexIndex;
+                continue;
+            }
+        }
+    }
+    if (!equals2(points.back(), endPoint) || points.size() == 1)
+        points.push_back(endPoint);
+
+    // The corridor is one triangle wide, so the path may turn around corners the walkable surface
+    // lets it cut: skip to the farthest point in a straight line of sight from each point.
+    path->clear();
+    path->push_back(startPoint);
+    for (size_t i = 0, last = points.size() - 1; i < last; )
+    {
+        size_t next = i + 1;
+        for (size_t j = last; j > i + 1; --j)
+        {
+            if (raycast(pointTriangles[i], points[i], points[j]))
+            {
+                next = j;
+                break;
+            }
+        }
+        path->push_back(points[next]);
+        i = next;
+    }
+}
+
+bool NavigationMesh::raycast(int triangle, const Vector3& from, const Vector3& to) const
+{
+    // Walk the triangles the segment crosses until one holds its end or the segment leaves the walkable surface.
+    for (size_t step = 0, count = _centers.size(); step < count; ++step)
+    {
+        bool inside = true;
+        int exit = -1;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            const Vector3& a = _vertices[_triangles[triangle * 3 + i]];
+            const Vector3& b = _vertices[_triangles[triangle * 3 + (i + 1) % 3]];
+            if (cross2(a, b, to) > 0.0f)
+            {
+                inside = false;
+                if (exit < 0 && cross2(from, to, a) >= 0.0f && cross2(from, to, b) <= 0.0f)
+                    exit = (int)i;
+            }
+        }
+        if (inside)
+            return true;
+        if (exit < 0 || _links[triangle * 3 + exit] < 0)
+            return false;
+        triangle = _links[triangle * 3 + exit];
+    }
+    return false;
+}
+
+}
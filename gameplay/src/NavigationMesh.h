@@ -0,0 +1,199 @@
+#ifndef NAVIGATIONMESH_H_
+#define NAVIGATIONMESH_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "BoundingBox.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the walkable surface of a scene, made of triangles, that AI agents find their paths on.
+ *
+ * The encoder bakes a navigation mesh when run with the -nav option, from the triangles of
+ * the static meshes of a scene or from a terrain heightmap that are no steeper than a given
+ * slope. The vertices of the triangles are welded and every triangle is linked to the
+ * triangles it shares an edge with, so loading the mesh only builds a grid of the triangles
+ * over the XZ plane to find the triangle under a point.
+ *
+ * A path is searched over the triangles with A*, from the triangle of the destination back to
+ * the triangle of the start, and straightened with the funnel algorithm into the corners the
+ * path turns around. The path runs along the triangles, so it keeps no clearance around the
+ * edges of the walkable surface.
+ *
+ * findPath searches a whole path on the calling thread. Agents rather request their paths
+ * with AIAgent::findPath: the AI controller searches them on worker threads a slice at a time
+ * and shares the searches of agents heading to the same place (see AIController).
+ *
+ * @script{ignore}
+ */
+class NavigationMesh : public Ref
+{
+    friend class Bundle;
+    friend class AIController;
+
+public:
+
+    /**
+     * Loads the navigation mesh of a bundle.
+     *
+     * @param path The path of the bundle.
+     * @param id The ID of the navigation mesh in the bundle.
+     *
+     * @return The navigation mesh, or NULL if it could not be loaded.
+     */
+    static NavigationMesh* create(const char* path, const char* id = "navmesh");
+
+    /**
+     * Gets the number of walkable triangles.
+     *
+     * @return The triangle count.
+     */
+    unsigned int getTriangleCount() const;
+
+    /**
+     * Gets the box bounding the walkable triangles.
+     *
+     * @return The bounding box.
+     */
+    const BoundingBox& getBoundingBox() const;
+
+    /**
+     * Finds the walkable triangle nearest to a point.
+     *
+     * @param point The point.
+     * @param closest Set to the point of the triangle nearest to the point, or NULL.
+     *
+     * @return The index of the triangle, or -1 if the mesh has no triangles.
+     */
+    int findTriangle(const Vector3& point, Vector3* closest = NULL) const;
+
+    /**
+     * Finds the shortest path along the walkable triangles between two points.
+     *
+     * The search runs to completion on the calling thread.
+     *
+     * @param start The start of the path.
+     * @param end The end of the path.
+     * @param path Set to the points of the path, from the start to the end.
+     *
+     * @return true if a path was found, false if the end cannot be reached from the start.
+     */
+    bool findPath(const Vector3& start, const Vector3& end, std::vector<Vector3>* path) const;
+
+private:
+
+    /**
+     * The contents of a navigation mesh, as read from a bundle.
+     */
+    struct Data
+    {
+        std::vector<float> vertices;
+        std::vector<unsigned int> triangles;
+        std::vector<unsigned int> links;
+    };
+
+    /**
+     * The result of advancing a search.
+     */
+    enum SearchResult
+    {
+        SEARCH_PENDING,
+        SEARCH_FOUND,
+        SEARCH_FAILED
+    };
+
+    /**
+     * An A* search from the triangle of a destination, kept to find the paths of other starts to the same destination.
+     *
+     * The search expands the triangles nearest to the start it is aimed at first. Every triangle
+     * it has expanded knows its shortest path to the destination, so the path of any start on
+     * an expanded triangle is found without searching further.
+     */
+    struct Search
+    {
+        Search();
+
+        int goal;
+        int target;
+        bool exhausted;
+        std::vector<float> costs;
+        std::vector<int> parents;
+        std::vector<unsigned char> states;
+        std::vector<std::pair<float, int> > open;
+    };
+
+    /**
+     * Constructor.
+     */
+    NavigationMesh();
+
+    /**
+     * Destructor.
+     */
+    ~NavigationMesh();
+
+    /**
+     * Hidden copy constructor.
+     */
+    NavigationMesh(const NavigationMesh& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    NavigationMesh& operator=(const NavigationMesh&);
+
+    /**
+     * Creates a navigation mesh read by a bundle.
+     */
+    static NavigationMesh* create(const char* id, const Data& data);
+
+    /**
+     * Starts a search from the triangle of a destination.
+     */
+    void beginSearch(Search* search, int goal) const;
+
+    /**
+     * Advances a search until it reaches a start triangle or has expanded a number of triangles.
+     *
+     * @param search The search.
+     * @param start The start triangle.
+     * @param iterations The number of triangles the search may expand, decreased by the number expanded.
+     */
+    SearchResult advanceSearch(Search* search, int start, unsigned int* iterations) const;
+
+    /**
+     * Builds the path of a start triangle the search has reached, through the corners it turns around.
+     */
+    void buildPath(const Search& search, int start, const Vector3& startPoint, const Vector3& endPoint, std::vector<Vector3>* path) const;
+
+    /**
+     * Determines whether a straight line between two points stays on the walkable triangles.
+     *
+     * @param triangle The triangle the line starts on.
+     * @param from The start of the line.
+     * @param to The end of the line.
+     */
+    bool raycast(int triangle, const Vector3& from, const Vector3& to) const;
+
+    /**
+     * Gets the point of a triangle nearest to a point.
+     */
+    Vector3 getClosestPoint(unsigned int triangle, const Vector3& point) const;
+
+    std::vector<Vector3> _vertices;
+    std::vector<unsigned int> _triangles;
+    std::vector<int> _links;
+    std::vector<Vector3> _centers;
+    BoundingBox _boundingBox;
+    float _cellSize;
+    unsigned int _columns;
+    unsigned int _rows;
+    std::vector<unsigned int> _cellStarts;
+    std::vector<unsigned int> _cellTriangles;
+};
+
+}
+
+#endif
@@ -10,19 +10,26 @@
 #include "PhysicsCharacter.h"
 #include "Game.h"
 #include "Terrain.h"
+#include "StringTable.h"
 
 // Node dirty flags
 #define NODE_DIRTY_WORLD 1
 #define NODE_DIRTY_BOUNDS 2
-#define NODE_DIRTY_ALL (NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS)
+#define NODE_DIRTY_WORLD_VIEW_PROJ 4
+#define NODE_DIRTY_BOX 8
+#define NODE_DIRTY_ALL (NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS | NODE_DIRTY_WORLD_VIEW_PROJ | NODE_DIRTY_BOX)
+
+// The registry of interned tag names.
+static StringTable __tagNames;
 
 namespace gameplay
 {
 
 Node::Node(const char* id)
     : _scene(NULL), _firstChild(NULL), _nextSibling(NULL), _prevSibling(NULL), _parent(NULL), _childCount(0),
-    _tags(NULL), _camera(NULL), _light(NULL), _model(NULL), _terrain(NULL), _form(NULL), _audioSource(NULL), _particleEmitter(NULL),
-    _collisionObject(NULL), _agent(NULL), _dirtyBits(NODE_DIRTY_ALL), _notifyHierarchyChanged(true), _userData(NULL)
+    _tags(NULL), _tagMask(0), _camera(NULL), _light(NULL), _model(NULL), _terrain(NULL), _form(NULL), _audioSource(NULL), _particleEmitter(NULL),
+    _collisionObject(NULL), _agent(NULL), _worldViewProjectionVersion(0), _dirtyBits(NODE_DIRTY_ALL), _notifyHierarchyChanged(true), _boxVersion(0), _userData(NULL),
+    _octreeCell(NULL), _octreeIndex(0), _octreeDirty(false)
 {
     if (id)
     {
@@ -34,6 +41,9 @@ Node::~Node()
 {
     removeAllChildren();
 
+    if (_octreeCell)
+        _octreeCell->octree->remove(this);
+
     if (_model)
         _model->setNode(NULL);
     if (_audioSource)
@@ -79,7 +89,14 @@ void Node::setId(const char* id)
 {
     if (id)
     {
+        Scene* scene = getScene();
+        if (scene)
+            scene->unindexNode(this);
+
         _id = id;
+
+        if (scene)
+            scene->indexNode(this);
     }
 }
 
@@ -128,6 +145,16 @@ void Node::addChild(Node* child)
 
     setBoundsDirty();
 
+    // Children of indexed nodes are indexed in the same scene.
+    Scene* scene = getScene();
+    if (scene)
+    {
+        scene->indexNodeTree(child);
+        scene->_transformOrderDirty = true;
+    }
+    if (_octreeCell)
+        _octreeCell->octree->insertTree(child);
+
     if (_notifyHierarchyChanged)
     {
         hierarchyChanged();
@@ -163,6 +190,15 @@ void Node::removeAllChildren()
 
 void Node::remove()
 {
+    Scene* scene = getScene();
+    if (scene)
+    {
+        scene->unindexNodeTree(this);
+        scene->_transformOrderDirty = true;
+    }
+    if (_octreeCell)
+        _octreeCell->octree->removeTree(this);
+
     // Re-link our neighbours.
     if (_prevSibling)
     {
@@ -219,7 +255,12 @@ bool Node::hasTag(const char* name) const
 {
     GP_ASSERT(name);
 
-    return (_tags ? _tags->find(name) != _tags->end() : false);
+    if (!_tags)
+        return false;
+
+    // Names that were never interned cannot be set.
+    unsigned int tagId = __tagNames.find(name);
+    return (tagId == StringTable::INVALID_HANDLE ? false : hasTag(tagId));
 }
 
 const char* Node::getTag(const char* name) const
@@ -229,31 +270,128 @@ const char* Node::getTag(const char* name) const
     if (!_tags)
         return NULL;
 
-    std::map<std::string, std::string>::const_iterator itr = _tags->find(name);
-    return (itr == _tags->end() ? NULL : itr->second.c_str());
+    unsigned int tagId = __tagNames.find(name);
+    return (tagId == StringTable::INVALID_HANDLE ? NULL : getTag(tagId));
 }
 
 void Node::setTag(const char* name, const char* value)
 {
     GP_ASSERT(name);
 
+    if (value == NULL)
+    {
+        // Removing a tag that was never interned has nothing to do.
+        unsigned int tagId = __tagNames.find(name);
+        if (tagId != StringTable::INVALID_HANDLE)
+            setTag(tagId, NULL);
+    }
+    else
+    {
+        setTag(getTagId(name), value);
+    }
+}
+
+unsigned int Node::getTagId(const char* name)
+{
+    GP_ASSERT(name);
+
+    return __tagNames.intern(name);
+}
+
+const char* Node::getTagName(unsigned int tagId)
+{
+    return __tagNames.getString(tagId);
+}
+
+unsigned long long Node::getTagBit(unsigned int tagId)
+{
+    return (tagId < TAG_MASK_BITS ? 1ULL << tagId : 0);
+}
+
+bool Node::hasTag(unsigned int tagId) const
+{
+    if (tagId < TAG_MASK_BITS)
+        return (_tagMask & (1ULL << tagId)) != 0;
+
+    if (!_tags)
+        return false;
+
+    for (size_t i = 0, count = _tags->size(); i < count && (*_tags)[i].id <= tagId; ++i)
+    {
+        if ((*_tags)[i].id == tagId)
+            return true;
+    }
+    return false;
+}
+
+bool Node::hasTags(unsigned long long mask) const
+{
+    return (_tagMask & mask) == mask;
+}
+
+unsigned long long Node::getTagMask() const
+{
+    return _tagMask;
+}
+
+const char* Node::getTag(unsigned int tagId) const
+{
+    if (!_tags)
+        return NULL;
+
+    for (size_t i = 0, count = _tags->size(); i < count && (*_tags)[i].id <= tagId; ++i)
+    {
+        if ((*_tags)[i].id == tagId)
+            return (*_tags)[i].value.c_str();
+    }
+    return NULL;
+}
+
+void Node::setTag(unsigned int tagId, const char* value)
+{
+    GP_ASSERT(tagId < __tagNames.getCount());
+
+    // Find the tag, or where it goes in the sorted list.
+    size_t index = 0;
+    size_t count = _tags ? _tags->size() : 0;
+    while (index < count && (*_tags)[index].id < tagId)
+        ++index;
+    bool found = index < count && (*_tags)[index].id == tagId;
+
     if (value == NULL)
     {
         // Removing tag
-        if (_tags)
-        {
-            _tags->erase(name);
-            if (_tags->size() == 0)
-                SAFE_DELETE(_tags);
-        }
+        if (!found)
+            return;
+
+        _tags->erase(_tags->begin() + index);
+        if (_tags->empty())
+            SAFE_DELETE(_tags);
+        _tagMask &= ~getTagBit(tagId);
+
+        Scene* scene = getScene();
+        if (scene)
+            scene->unindexNodeTag(this, tagId);
+    }
+    else if (found)
+    {
+        (*_tags)[index].value = value;
     }
     else
     {
         // Setting tag
         if (_tags == NULL)
-            _tags = new std::map<std::string, std::string>();
+            _tags = new std::vector<Tag>();
+
+        Tag tag;
+        tag.id = tagId;
+        tag.value = value;
+        _tags->insert(_tags->begin() + index, tag);
+        _tagMask |= getTagBit(tagId);
 
-        (*_tags)[name] = value;
+        Scene* scene = getScene();
+        if (scene)
+            scene->indexNodeTag(this, tagId);
     }
 }
 
@@ -295,6 +433,30 @@ Node* Node::findNode(const char* id, bool recursive, bool exactMatch) const
 {
     GP_ASSERT(id);
 
+    // The scene's node ID index answers the search when it has no match, or a single
+    // match that is a descendant of this node. Other cases fall back to the traversal.
+    Scene* scene = recursive ? getScene() : NULL;
+    if (scene)
+    {
+        Node* match = NULL;
+        unsigned int count = scene->findIndexedNodes(id, exactMatch, NULL, &match);
+        if (count == 0)
+            return NULL;
+        if (count == 1)
+        {
+            for (Node* n = match->_parent; n != NULL; n = n->_parent)
+            {
+                if (n == this)
+                    return match;
+            }
+        }
+    }
+
+    return findNodeInHierarchy(id, recursive, exactMatch);
+}
+
+Node* Node::findNodeInHierarchy(const char* id, bool recursive, bool exactMatch) const
+{
     // If the node has a model with a mesh skin, search the skin's hierarchy as well.
     Node* rootNode = NULL;
     if (_model != NULL && _model->getSkin() != NULL && (rootNode = _model->getSkin()->_rootNode) != NULL)
@@ -302,7 +464,7 @@ Node* Node::findNode(const char* id, bool recursive, bool exactMatch) const
         if ((exactMatch && rootNode->_id == id) || (!exactMatch && rootNode->_id.find(id) == 0))
             return rootNode;
         
-        Node* match = rootNode->findNode(id, true, exactMatch);
+        Node* match = rootNode->findNodeInHierarchy(id, true, exactMatch);
         if (match)
         {
             return match;
@@ -324,7 +486,7 @@ Node* Node::findNode(const char* id, bool recursive, bool exactMatch) const
     {
         for (Node* child = getFirstChild(); child != NULL; child = child->getNextSibling())
         {
-            Node* match = child->findNode(id, true, exactMatch);
+            Node* match = child->findNodeInHierarchy(id, true, exactMatch);
             if (match)
             {
                 return match;
@@ -538,13 +700,23 @@ const Matrix& Node::getInverseViewProjectionMatrix() const
 
 const Matrix& Node::getWorldViewProjectionMatrix() const
 {
-    static Matrix worldViewProj;
+    // Recalculate the matrix when the node has moved or the camera (or its version) has changed.
+    Scene* scene = getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    unsigned int version = camera ? camera->getVersion() : 0;
+    if ((_dirtyBits & NODE_DIRTY_WORLD_VIEW_PROJ) || version != _worldViewProjectionVersion)
+    {
+        const Matrix& world = getWorldMatrix();
+        if (camera)
+            Matrix::multiply(camera->getViewProjectionMatrix(), world, &_worldViewProjection);
+        else
+            _worldViewProjection = world;
 
-    // Always re-calculate worldViewProjection matrix since it's extremely difficult
-    // to track whether the camera has changed (it may frequently change every frame).
-    Matrix::multiply(getViewProjectionMatrix(), getWorldMatrix(), &worldViewProj);
+        _worldViewProjectionVersion = version;
+        _dirtyBits &= ~NODE_DIRTY_WORLD_VIEW_PROJ;
+    }
 
-    return worldViewProj;
+    return _worldViewProjection;
 }
 
 Vector3 Node::getTranslationWorld() const
@@ -638,7 +810,13 @@ void Node::hierarchyChanged()
 void Node::transformChanged()
 {
     // Our local transform was changed, so mark our world matrices dirty.
-    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
+    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS | NODE_DIRTY_BOX | NODE_DIRTY_WORLD_VIEW_PROJ;
+    if (_octreeCell)
+        _octreeCell->octree->setDirty(this);
+
+    // The bounds of our parent contain ours, so they move with us.
+    if (_parent)
+        _parent->setBoundsDirty();
 
     // Notify our children that their transform has also changed (since transforms are inherited).
     for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
@@ -661,16 +839,56 @@ void Node::transformChanged()
     Transform::transformChanged();
 }
 
+bool Node::isWorldMatrixDirty() const
+{
+    return (_dirtyBits & NODE_DIRTY_WORLD) != 0;
+}
+
+void Node::updateWorldMatrix(const Matrix* parentWorld) const
+{
+    // Same as getWorldMatrix, for nodes visited in order from the root by Scene::updateTransforms.
+    _dirtyBits &= ~NODE_DIRTY_WORLD;
+
+    if (!isStatic())
+    {
+        if (parentWorld && (!_collisionObject || _collisionObject->isKinematic()))
+        {
+            Matrix::multiply(*parentWorld, getMatrix(), &_world);
+        }
+        else
+        {
+            _world = getMatrix();
+        }
+    }
+}
+
+bool Node::isBoundingBoxDirty() const
+{
+    return (_dirtyBits & NODE_DIRTY_BOX) != 0;
+}
+
 void Node::setBoundsDirty()
 {
+    // Bounds are only cleaned from a node down to its children, so the parents of a
+    // dirty node are dirty too and the walk up to the root can stop here.
+    if ((_dirtyBits & (NODE_DIRTY_BOUNDS | NODE_DIRTY_BOX)) == (NODE_DIRTY_BOUNDS | NODE_DIRTY_BOX))
+        return;
+
     // Mark ourself and our parent nodes as dirty
-    _dirtyBits |= NODE_DIRTY_BOUNDS;
+    _dirtyBits |= NODE_DIRTY_BOUNDS | NODE_DIRTY_BOX;
+    if (_octreeCell)
+        _octreeCell->octree->setDirty(this);
 
     // Mark our parent bounds as dirty as well
     if (_parent)
         _parent->setBoundsDirty();
 }
 
+unsigned int Node::getAnimationLodInterval() const
+{
+    return _model ? _model->getAnimationLodInterval() : 1;
+}
+
 Animation* Node::getAnimation(const char* id) const
 {
     Animation* animation = ((AnimationTarget*)this)->getAnimation(id);
@@ -779,6 +997,10 @@ void Node::setLight(Light* light)
             _light->setNode(this);
         }
 
+        Scene* scene = getScene();
+        if (scene)
+            scene->_lightsDirty = true;
+
         setBoundsDirty();
     }
 }
@@ -792,6 +1014,14 @@ void Node::setModel(Model* model)
 {
     if (_model != model)
     {
+        // Joint hierarchies of skins are part of the scene's node ID index.
+        if ((_model && _model->_skin) || (model && model->_skin))
+        {
+            Scene* scene = getScene();
+            if (scene)
+                scene->_nodeIndexDirty = true;
+        }
+
         if (_model)
         {
             _model->setNode(NULL);
@@ -878,14 +1108,17 @@ const BoundingSphere& Node::getBoundingSphere() const
         }
         if (_model && _model->getMesh())
         {
+            // A skin with joint bounds is bounded by its current pose rather than by all the poses of its animations.
+            MeshSkin* skin = _model->getSkin();
+            const BoundingSphere& modelSphere = skin && skin->hasJointBounds() ? skin->getBoundingSphere() : _model->getMesh()->getBoundingSphere();
             if (empty)
             {
-                _bounds.set(_model->getMesh()->getBoundingSphere());
+                _bounds.set(modelSphere);
                 empty = false;
             }
             else
             {
-                _bounds.merge(_model->getMesh()->getBoundingSphere());
+                _bounds.merge(modelSphere);
             }
         }
         if (_light)
@@ -893,6 +1126,9 @@ const BoundingSphere& Node::getBoundingSphere() const
             switch (_light->getLightType())
             {
             case Light::POINT:
+            case Light::SPOT:
+                // A spot light is bounded by the sphere of its range; its cone is not
+                // fitted, so the bounds stay valid whichever way the node turns.
                 if (empty)
                 {
                     _bounds.set(Vector3::zero(), _light->getRange());
@@ -903,9 +1139,6 @@ const BoundingSphere& Node::getBoundingSphere() const
                     _bounds.merge(BoundingSphere(Vector3::zero(), _light->getRange()));
                 }
                 break;
-            case Light::SPOT:
-                // TODO: Implement spot light bounds
-                break;
             }
         }
         if (empty)
@@ -918,33 +1151,8 @@ const BoundingSphere& Node::getBoundingSphere() const
         // Transform the sphere (if not empty) into world space.
         if (!empty)
         {
-            bool applyWorldTransform = true;
-            if (_model && _model->getSkin())
-            {
-                // Special case: If the root joint of our mesh skin is parented by any nodes, 
-                // multiply the world matrix of the root joint's parent by this node's
-                // world matrix. This computes a final world matrix used for transforming this
-                // node's bounding volume. This allows us to store a much smaller bounding
-                // volume approximation than would otherwise be possible for skinned meshes,
-                // since joint parent nodes that are not in the matrix palette do not need to
-                // be considered as directly transforming vertices on the GPU (they can instead
-                // be applied directly to the bounding volume transformation below).
-                GP_ASSERT(_model->getSkin()->getRootJoint());
-                Node* jointParent = _model->getSkin()->getRootJoint()->getParent();
-                if (jointParent)
-                {
-                    // TODO: Should we protect against the case where joints are nested directly
-                    // in the node hierachy of the model (this is normally not the case)?
-                    Matrix boundsMatrix;
-                    Matrix::multiply(getWorldMatrix(), jointParent->getWorldMatrix(), &boundsMatrix);
-                    _bounds.transform(boundsMatrix);
-                    applyWorldTransform = false;
-                }
-            }
-            if (applyWorldTransform)
-            {
-                _bounds.transform(getWorldMatrix());
-            }
+            Matrix skinMatrix;
+            _bounds.transform(getBoundsMatrix(&skinMatrix));
         }
 
         // Merge this world-space bounding sphere with our childrens' bounding volumes.
@@ -969,6 +1177,114 @@ const BoundingSphere& Node::getBoundingSphere() const
     return _bounds;
 }
 
+const BoundingBox& Node::getBoundingBox() const
+{
+    if (_dirtyBits & NODE_DIRTY_BOX)
+    {
+        _dirtyBits &= ~NODE_DIRTY_BOX;
+        ++_boxVersion;
+
+        // Start with our local bounding box, gathered from the same data as the bounding sphere.
+        bool empty = true;
+        if (_terrain)
+        {
+            _box.set(_terrain->getBoundingBox());
+            empty = false;
+        }
+        if (_model && _model->getMesh())
+        {
+            MeshSkin* skin = _model->getSkin();
+            if (skin && skin->hasJointBounds())
+            {
+                if (empty)
+                    _box.set(skin->getBoundingSphere());
+                else
+                    _box.merge(skin->getBoundingSphere());
+            }
+            else
+            {
+                if (empty)
+                    _box.set(_model->getMesh()->getBoundingBox());
+                else
+                    _box.merge(_model->getMesh()->getBoundingBox());
+            }
+            empty = false;
+        }
+        if (_light && _light->getLightType() == Light::POINT)
+        {
+            BoundingSphere lightSphere(Vector3::zero(), _light->getRange());
+            if (empty)
+            {
+                _box.set(lightSphere);
+                empty = false;
+            }
+            else
+            {
+                _box.merge(lightSphere);
+            }
+        }
+
+        if (empty)
+        {
+            // Empty bounding box at our world translation.
+            Vector3 translation;
+            getWorldMatrix().getTranslation(&translation);
+            _box.set(translation, translation);
+        }
+        else
+        {
+            Matrix skinMatrix;
+            _box.transform(getBoundsMatrix(&skinMatrix));
+        }
+
+        // Merge this world-space bounding box with our childrens' bounding boxes.
+        for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
+        {
+            const BoundingBox& childBox = n->getBoundingBox();
+            if (!childBox.isEmpty())
+            {
+                if (empty)
+                {
+                    _box.set(childBox);
+                    empty = false;
+                }
+                else
+                {
+                    _box.merge(childBox);
+                }
+            }
+        }
+    }
+
+    return _box;
+}
+
+const Matrix& Node::getBoundsMatrix(Matrix* skinMatrix) const
+{
+    // The joint bounds of a skin are already posed by the whole joint hierarchy.
+    if (_model && _model->getSkin() && !_model->getSkin()->hasJointBounds())
+    {
+        // Special case: If the root joint of our mesh skin is parented by any nodes, 
+        // multiply the world matrix of the root joint's parent by this node's
+        // world matrix. This computes a final world matrix used for transforming this
+        // node's bounding volume. This allows us to store a much smaller bounding
+        // volume approximation than would otherwise be possible for skinned meshes,
+        // since joint parent nodes that are not in the matrix palette do not need to
+        // be considered as directly transforming vertices on the GPU (they can instead
+        // be applied directly to the bounding volume transformation below).
+        GP_ASSERT(_model->getSkin()->getRootJoint());
+        Node* jointParent = _model->getSkin()->getRootJoint()->getParent();
+        if (jointParent)
+        {
+            // TODO: Should we protect against the case where joints are nested directly
+            // in the node hierachy of the model (this is normally not the case)?
+            Matrix::multiply(getWorldMatrix(), jointParent->getWorldMatrix(), skinMatrix);
+            return *skinMatrix;
+        }
+    }
+    return getWorldMatrix();
+}
+
 Node* Node::clone() const
 {
     NodeCloneContext context;
@@ -1046,7 +1362,8 @@ void Node::cloneInto(Node* node, NodeCloneContext &context) const
 
     if (_tags)
     {
-        node->_tags = new std::map<std::string, std::string>(_tags->begin(), _tags->end());
+        node->_tags = new std::vector<Tag>(*_tags);
+        node->_tagMask = _tagMask;
     }
 }
 
@@ -1273,6 +1590,7 @@ void Node::setAgent(AIAgent* agent)
 }
 
 NodeCloneContext::NodeCloneContext()
+    : _shareMaterials(false)
 {
 }
 
@@ -1312,4 +1630,14 @@ void NodeCloneContext::registerClonedNode(const Node* original, Node* clone)
     _clonedNodes[original] = clone;
 }
 
+void NodeCloneContext::setShareMaterials(bool share)
+{
+    _shareMaterials = share;
+}
+
+bool NodeCloneContext::isShareMaterials() const
+{
+    return _shareMaterials;
+}
+
 }
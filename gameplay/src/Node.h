@@ -11,6 +11,7 @@
 #include "PhysicsCollisionObject.h"
 #include "BoundingBox.h"
 #include "AIAgent.h"
+#include "Octree.h"
 
 namespace gameplay
 {
@@ -30,6 +31,9 @@ class Node : public Transform, public Ref
     friend class Bundle;
     friend class MeshSkin;
     friend class Light;
+    friend class Octree;
+    friend class Prefab;
+    friend class SceneSnapshot;
 
 public:
 
@@ -42,6 +46,11 @@ public:
         JOINT
     };
 
+    /**
+     * The number of tag IDs that have a bit in the tag masks of nodes.
+     */
+    static const unsigned int TAG_MASK_BITS = 64;
+
     /**
      * Creates a new node with the specified ID.
      *
@@ -151,6 +160,87 @@ public:
      */
     void setTag(const char* name, const char* value = "");
 
+    /**
+     * Gets the ID of a tag name, interning the name if it has no ID yet.
+     *
+     * Tag names are interned in a registry shared by all nodes, so a tag can be
+     * queried by its ID without comparing strings. IDs start at zero and are never
+     * reused; the first TAG_MASK_BITS IDs also have a bit in the tag masks of nodes.
+     *
+     * @param name The name of the tag.
+     *
+     * @return The ID of the tag.
+     * @script{ignore}
+     */
+    static unsigned int getTagId(const char* name);
+
+    /**
+     * Gets the name of a tag ID.
+     *
+     * @param tagId The ID of the tag.
+     *
+     * @return The name of the tag, or NULL if the ID was not returned by getTagId.
+     * @script{ignore}
+     */
+    static const char* getTagName(unsigned int tagId);
+
+    /**
+     * Gets the bit of a tag ID in the tag masks of nodes.
+     *
+     * @param tagId The ID of the tag.
+     *
+     * @return The bit of the tag, or zero if the ID is not lower than TAG_MASK_BITS.
+     * @script{ignore}
+     */
+    static unsigned long long getTagBit(unsigned int tagId);
+
+    /**
+     * Determines if the tag with the specified ID is set.
+     *
+     * @param tagId The ID of the tag (see getTagId).
+     *
+     * @return true if the tag is set, false otherwise.
+     * @script{ignore}
+     */
+    bool hasTag(unsigned int tagId) const;
+
+    /**
+     * Determines if all the tags of a tag mask are set.
+     *
+     * @param mask The bits of the tags (see getTagBit).
+     *
+     * @return true if every tag of the mask is set, false otherwise.
+     * @script{ignore}
+     */
+    bool hasTags(unsigned long long mask) const;
+
+    /**
+     * Gets the mask of the tags set on this node whose ID is lower than TAG_MASK_BITS.
+     *
+     * @return The tag mask.
+     * @script{ignore}
+     */
+    unsigned long long getTagMask() const;
+
+    /**
+     * Returns the value of the tag with the specified ID.
+     *
+     * @param tagId The ID of the tag (see getTagId).
+     *
+     * @return The value of the tag, or NULL if the tag is not set.
+     * @script{ignore}
+     */
+    const char* getTag(unsigned int tagId) const;
+
+    /**
+     * Sets the tag with the specified ID, or removes it if the value is NULL.
+     *
+     * @param tagId The ID of the tag (see getTagId).
+     * @param value Optional value of the tag (empty string by default).
+     * @script{ignore}
+     */
+    void setTag(unsigned int tagId, const char* value = "");
+
     /**
      * Returns the user pointer for this node.
      *
@@ -318,6 +408,10 @@ public:
      * Gets the world * view * projection matrix corresponding to this node based
      * on the scene's active camera.
      *
+     * The matrix is cached until the node moves or the active camera, its view or
+     * its projection changes, so passes that draw the node several times a frame
+     * compute it once.
+     *
      * @return The world * view * projection matrix of this node.
      */
     const Matrix& getWorldViewProjectionMatrix() const;
@@ -642,6 +736,26 @@ public:
      */
     const BoundingSphere& getBoundingSphere() const;
 
+    /**
+     * Returns the axis-aligned bounding box for the Node, in world space.
+     *
+     * Like the bounding sphere, the box contains the data inside the node and
+     * all of its child nodes, but it is usually much tighter around them and is
+     * therefore better suited to culling. The box of each piece of data is its
+     * local box transformed into world space, and the boxes of the children are
+     * merged into it.
+     *
+     * A node that does not occupy any space will return an empty box located at
+     * the node translation.
+     *
+     * The box is cached, and is only recomputed along the path from a node whose
+     * transform or data changed up to the root of the scene.
+     *
+     * @return The world-space bounding box for the node.
+     * @script{ignore}
+     */
+    const BoundingBox& getBoundingBox() const;
+
     /**
      * Clones the node and all of its child nodes.
      * 
@@ -703,11 +817,45 @@ protected:
      */
     void hierarchyChanged();
 
+    /**
+     * Searches the Node's hierarchy for a matching child without using the scene's node ID index.
+     */
+    Node* findNodeInHierarchy(const char* id, bool recursive, bool exactMatch) const;
+
     /**
      * Marks the bounding volume of the node as dirty.
      */
     void setBoundsDirty();
 
+    /**
+     * Determines whether the world matrix of this node must be recomputed.
+     */
+    bool isWorldMatrixDirty() const;
+
+    /**
+     * Recomputes the world matrix of this node, without visiting its parent or children.
+     *
+     * @param parentWorld The up to date world matrix of the parent, or NULL if the node has no parent.
+     */
+    void updateWorldMatrix(const Matrix* parentWorld) const;
+
+    /**
+     * Determines whether the bounding box of this node must be recomputed.
+     */
+    bool isBoundingBoxDirty() const;
+
+    /**
+     * Gets the matrix that transforms the local bounds of the data inside this node into world space.
+     *
+     * @param skinMatrix Storage for the matrix of skinned models, which is returned if it is used.
+     */
+    const Matrix& getBoundsMatrix(Matrix* skinMatrix) const;
+
+    /**
+     * @see AnimationTarget::getAnimationLodInterval
+     */
+    unsigned int getAnimationLodInterval() const;
+
 private:
 
     /**
@@ -779,9 +927,23 @@ protected:
     unsigned int _childCount;
 
     /**
-     * List of custom tags for a node.
+     * A custom tag of a node.
      */
-    std::map<std::string, std::string>* _tags;
+    struct Tag
+    {
+        unsigned int id;
+        std::string value;
+    };
+
+    /**
+     * List of custom tags for a node, sorted by tag ID.
+     */
+    std::vector<Tag>* _tags;
+
+    /**
+     * Bits of the tags of the node whose ID is lower than TAG_MASK_BITS.
+     */
+    unsigned long long _tagMask;
 
     /**
      * Pointer to the Camera attached to the Node.
@@ -833,6 +995,16 @@ protected:
      */
     mutable Matrix _world;
 
+    /**
+     * World view projection matrix of the Node, cached for the camera version below.
+     */
+    mutable Matrix _worldViewProjection;
+
+    /**
+     * The version of the camera the world view projection matrix was computed with (0 for no camera).
+     */
+    mutable unsigned int _worldViewProjectionVersion;
+
     /**
      * Dirty bits flag for the Node.
      */
@@ -848,11 +1020,36 @@ protected:
      */
     mutable BoundingSphere _bounds;
 
+    /**
+     * The Bounding Box containing the Node.
+     */
+    mutable BoundingBox _box;
+
+    /**
+     * Incremented each time the bounding box is recomputed.
+     */
+    mutable unsigned int _boxVersion;
+
     /**
      * Pointer to custom UserData and cleanup call back that can be stored in a Node.
      */
     UserData* _userData;
 
+    /**
+     * The cell of the scene's spatial index containing the Node, or NULL.
+     */
+    Octree::Cell* _octreeCell;
+
+    /**
+     * The index of the Node in its octree cell.
+     */
+    unsigned int _octreeIndex;
+
+    /**
+     * A flag indicating if the Node must be moved to a new octree cell.
+     */
+    bool _octreeDirty;
+
     /**
      * A linear collection of descendants who wish to advertise themselves, typically
      * to other descendants. This allows nodes of common ancestry to bond. One example
@@ -915,6 +1112,23 @@ public:
      */
     void registerClonedNode(const Node* original, Node* clone);
 
+    /**
+     * Sets whether models cloned with this context share the materials of the original models.
+     *
+     * Shared materials are referenced rather than cloned, as if they were marked with
+     * Material::setShared. Prefab instances share their materials this way.
+     *
+     * @param share true to share materials, false to clone the materials that are not shared.
+     */
+    void setShareMaterials(bool share);
+
+    /**
+     * Determines whether models cloned with this context share the materials of the original models.
+     *
+     * @return true if materials are shared, false otherwise.
+     */
+    bool isShareMaterials() const;
+
 private:
     
     /**
@@ -929,6 +1143,7 @@ private:
 
     std::map<const Animation*, Animation*> _clonedAnimations;
     std::map<const Node*, Node*> _clonedNodes;
+    bool _shareMaterials;
 };
 
 }
@@ -0,0 +1,114 @@
+#include "Base.h"
+#include "NodePool.h"
+#include "PhysicsCollisionObject.h"
+
+namespace gameplay
+{
+
+NodePool::NodePool(Prefab* prefab)
+    : _prefab(prefab)
+{
+    GP_ASSERT(_prefab);
+    _prefab->addRef();
+}
+
+NodePool::~NodePool()
+{
+    // Instances still in a scene are kept alive by the scene.
+    for (size_t i = 0; i < _nodes.size(); ++i)
+    {
+        SAFE_RELEASE(_nodes[i]);
+    }
+    SAFE_RELEASE(_prefab);
+}
+
+NodePool* NodePool::create(Prefab* prefab, unsigned int capacity, const char* collisionObjectUrl)
+{
+    GP_ASSERT(prefab);
+
+    NodePool* pool = new NodePool(prefab);
+    pool->_nodes.reserve(capacity);
+    pool->_available.reserve(capacity);
+    for (unsigned int i = 0; i < capacity; ++i)
+    {
+        Node* node = prefab->instantiate();
+        if (collisionObjectUrl && node->setCollisionObject(collisionObjectUrl) == NULL)
+        {
+            GP_ERROR("Failed to create collision object '%s' for pooled node '%s'.", collisionObjectUrl, node->getId());
+            SAFE_RELEASE(node);
+            SAFE_RELEASE(pool);
+            return NULL;
+        }
+        suspendCollisionObjects(node, true);
+        pool->_nodes.push_back(node);
+        pool->_available.push_back(node);
+    }
+
+    // Sorted by address so that release() can check the nodes it is given.
+    std::sort(pool->_nodes.begin(), pool->_nodes.end());
+    return pool;
+}
+
+Prefab* NodePool::getPrefab() const
+{
+    return _prefab;
+}
+
+Node* NodePool::acquire(Scene* scene, const Vector3& translation, const Quaternion& rotation)
+{
+    if (_available.empty())
+        return NULL;
+
+    Node* node = _available.back();
+    _available.pop_back();
+
+    node->setTranslation(translation);
+    node->setRotation(rotation);
+    if (scene)
+        scene->addNode(node);
+    suspendCollisionObjects(node, false);
+    return node;
+}
+
+void NodePool::release(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (!std::binary_search(_nodes.begin(), _nodes.end(), node))
+    {
+        GP_ERROR("Node '%s' does not belong to the pool.", node->getId());
+        return;
+    }
+    GP_ASSERT(_available.size() < _nodes.size());
+
+    suspendCollisionObjects(node, true);
+    if (node->getParent())
+        node->getParent()->removeChild(node);
+    else if (node->getScene())
+        node->getScene()->removeNode(node);
+    _available.push_back(node);
+}
+
+unsigned int NodePool::getCapacity() const
+{
+    return (unsigned int)_nodes.size();
+}
+
+unsigned int NodePool::getAvailableCount() const
+{
+    return (unsigned int)_available.size();
+}
+
+void NodePool::suspendCollisionObjects(Node* node, bool suspend)
+{
+    GP_ASSERT(node);
+
+    if (node->getCollisionObject())
+        node->getCollisionObject()->setSuspended(suspend);
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        suspendCollisionObjects(child, suspend);
+    }
+}
+
+}
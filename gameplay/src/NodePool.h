@@ -0,0 +1,125 @@
+#ifndef NODEPOOL_H_
+#define NODEPOOL_H_
+
+#include "Prefab.h"
+#include "Scene.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of prefab instances that are recycled instead of being created and
+ * destroyed during gameplay, such as projectiles, debris or enemies.
+ *
+ * All the instances of the pool are created up front. acquire() hands out a free
+ * instance, places it and adds it to a scene; release() takes it out of its scene and
+ * returns it to the pool. Both take constant time: the free instances are kept on a
+ * stack that is allocated with the pool, and no node, model, animation or collision
+ * object is created or destroyed.
+ *
+ * When the pool is created with a collision object, each instance gets its own
+ * collision object once. Released instances keep their collision objects in the
+ * physics world, suspended (see PhysicsCollisionObject::setSuspended), so recycling
+ * them does not add or remove bodies from the world. Collision listeners and
+ * constraints that are set on an instance stay with it across recycling.
+ *
+ * Adding an instance to a scene and removing it still updates the node index and the
+ * spatial partition of the scene. These reuse their storage once the pool has cycled
+ * through its instances, so a warm pool does not allocate.
+ */
+class NodePool : public Ref
+{
+public:
+
+    /**
+     * Creates a pool of instances of a prefab.
+     *
+     * @param prefab The prefab to instantiate.
+     * @param capacity The number of instances of the pool.
+     * @param collisionObjectUrl The URL of the collision object to set on each instance
+     *      (see Node::setCollisionObject), or NULL for none.
+     *
+     * @return The new pool.
+     * @script{create}
+     */
+    static NodePool* create(Prefab* prefab, unsigned int capacity, const char* collisionObjectUrl = NULL);
+
+    /**
+     * Gets the prefab the instances of the pool are created from.
+     *
+     * @return The prefab.
+     */
+    Prefab* getPrefab() const;
+
+    /**
+     * Acquires a free instance of the pool.
+     *
+     * The instance is placed at the given transform before it is added to the scene, so
+     * that its collision object resumes where the instance is spawned.
+     *
+     * @param scene The scene to add the instance to, or NULL to leave it out of any scene.
+     * @param translation The translation of the instance.
+     * @param rotation The rotation of the instance.
+     *
+     * @return The root node of the instance, or NULL if all the instances are in use.
+     */
+    Node* acquire(Scene* scene, const Vector3& translation, const Quaternion& rotation = Quaternion::identity());
+
+    /**
+     * Returns an instance to the pool.
+     *
+     * The instance is removed from its parent or scene and its collision objects are suspended.
+     *
+     * @param node The root node of an instance acquired from this pool.
+     */
+    void release(Node* node);
+
+    /**
+     * Gets the number of instances of the pool.
+     *
+     * @return The number of instances.
+     */
+    unsigned int getCapacity() const;
+
+    /**
+     * Gets the number of free instances of the pool.
+     *
+     * @return The number of free instances.
+     */
+    unsigned int getAvailableCount() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    NodePool(Prefab* prefab);
+
+    /**
+     * Destructor.
+     */
+    ~NodePool();
+
+    /**
+     * Hidden copy constructor.
+     */
+    NodePool(const NodePool& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    NodePool& operator=(const NodePool&);
+
+    /**
+     * Suspends or resumes the collision objects of a node hierarchy.
+     */
+    static void suspendCollisionObjects(Node* node, bool suspend);
+
+    Prefab* _prefab;
+    std::vector<Node*> _nodes;
+    std::vector<Node*> _available;
+};
+
+}
+
+#endif
@@ -0,0 +1,597 @@
+#ifdef GP_HEADLESS
+
+#include "Base.h"
+
+// The names of the GL objects created so far; names are never reused.
+static GLuint __nextName = 1;
+
+// The data of the buffer objects, and the buffer bound to each target.
+static std::map<GLuint, std::vector<unsigned char> > __buffers;
+static std::map<GLenum, GLuint> __boundBuffers;
+
+static GLuint __boundFramebuffer = 0;
+static GLint __viewport[4] = { 0, 0, 0, 0 };
+
+// The fences are never waited on, so they all share one dummy sync object.
+static int __fence;
+
+static void genNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        names[i] = __nextName++;
+    }
+}
+
+static std::vector<unsigned char>* getBoundBuffer(GLenum target)
+{
+    std::map<GLenum, GLuint>::const_iterator itr = __boundBuffers.find(target);
+    if (itr == __boundBuffers.end() || itr->second == 0)
+        return NULL;
+    return &__buffers[itr->second];
+}
+
+extern "C"
+{
+
+void glActiveTexture(GLenum texture)
+{
+}
+
+void glAttachShader(GLuint program, GLuint shader)
+{
+}
+
+void glBeginQuery(GLenum target, GLuint id)
+{
+}
+
+void glBeginTransformFeedback(GLenum primitiveMode)
+{
+}
+
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+}
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+    __boundBuffers[target] = buffer;
+}
+
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    __boundBuffers[target] = buffer;
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    __boundFramebuffer = framebuffer;
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+}
+
+void glBindVertexArray(GLuint array)
+{
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    std::vector<unsigned char>* buffer = getBoundBuffer(target);
+    if (buffer == NULL)
+        return;
+    buffer->assign((size_t)size, 0);
+    if (data && size > 0)
+        memcpy(&(*buffer)[0], data, (size_t)size);
+}
+
+void glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    glBufferData(target, size, data, 0);
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    std::vector<unsigned char>* buffer = getBoundBuffer(target);
+    if (buffer == NULL || data == NULL || size <= 0 || (size_t)(offset + size) > buffer->size())
+        return;
+    memcpy(&(*buffer)[(size_t)offset], data, (size_t)size);
+}
+
+GLenum glCheckFramebufferStatus(GLenum target)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void glClear(GLbitfield mask)
+{
+}
+
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+}
+
+void glClearDepth(GLclampd depth)
+{
+}
+
+void glClearStencil(GLint s)
+{
+}
+
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+    return GL_ALREADY_SIGNALED;
+}
+
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+}
+
+void glCompileShader(GLuint shader)
+{
+}
+
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data)
+{
+}
+
+GLuint glCreateProgram(void)
+{
+    return __nextName++;
+}
+
+GLuint glCreateShader(GLenum type)
+{
+    return __nextName++;
+}
+
+void glCullFace(GLenum mode)
+{
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        __buffers.erase(buffers[i]);
+    }
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+}
+
+void glDeleteProgram(GLuint program)
+{
+}
+
+void glDeleteQueries(GLsizei n, const GLuint* ids)
+{
+}
+
+void glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+}
+
+void glDeleteShader(GLuint shader)
+{
+}
+
+void glDeleteSync(GLsync sync)
+{
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+}
+
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+}
+
+void glDepthFunc(GLenum func)
+{
+}
+
+void glDepthMask(GLboolean flag)
+{
+}
+
+void glDisable(GLenum cap)
+{
+}
+
+void glDisableVertexAttribArray(GLuint index)
+{
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+}
+
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+}
+
+void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+{
+}
+
+void glEnable(GLenum cap)
+{
+}
+
+void glEnableVertexAttribArray(GLuint index)
+{
+}
+
+void glEndQuery(GLenum target)
+{
+}
+
+void glEndTransformFeedback(void)
+{
+}
+
+GLsync glFenceSync(GLenum condition, GLbitfield flags)
+{
+    return (GLsync)&__fence;
+}
+
+void glFinish(void)
+{
+}
+
+void glFlush(void)
+{
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+}
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+    genNames(n, buffers);
+}
+
+void glGenerateMipmap(GLenum target)
+{
+}
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    genNames(n, framebuffers);
+}
+
+void glGenQueries(GLsizei n, GLuint* ids)
+{
+    genNames(n, ids);
+}
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+    genNames(n, renderbuffers);
+}
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+    genNames(n, textures);
+}
+
+void glGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+    genNames(n, arrays);
+}
+
+void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    if (length)
+        *length = 0;
+    if (name && bufSize > 0)
+        name[0] = '\0';
+}
+
+void glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    if (length)
+        *length = 0;
+    if (name && bufSize > 0)
+        name[0] = '\0';
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name)
+{
+    return -1;
+}
+
+GLenum glGetError(void)
+{
+    return GL_NO_ERROR;
+}
+
+void glGetIntegerv(GLenum pname, GLint* params)
+{
+    switch (pname)
+    {
+    case GL_FRAMEBUFFER_BINDING:
+        *params = (GLint)__boundFramebuffer;
+        break;
+    case GL_VIEWPORT:
+        memcpy(params, __viewport, sizeof(__viewport));
+        break;
+    case GL_MAX_TEXTURE_SIZE:
+        *params = 16384;
+        break;
+    case GL_MAX_COLOR_ATTACHMENTS:
+        *params = 8;
+        break;
+    case GL_MAX_VERTEX_ATTRIBS:
+    case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS:
+        *params = 16;
+        break;
+    case GL_STENCIL_BITS:
+        *params = 8;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+{
+    if (length)
+        *length = 0;
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    if (length)
+        *length = 0;
+    if (infoLog && bufSize > 0)
+        infoLog[0] = '\0';
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+    *params = (pname == GL_LINK_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+
+void glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params)
+{
+    *params = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+    *params = 0;
+}
+
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params)
+{
+    *params = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    if (length)
+        *length = 0;
+    if (infoLog && bufSize > 0)
+        infoLog[0] = '\0';
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+    *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+    switch (name)
+    {
+    case GL_VENDOR:
+        return (const GLubyte*)"gameplay";
+    case GL_RENDERER:
+        return (const GLubyte*)"null";
+    case GL_VERSION:
+        return (const GLubyte*)"2.0 null";
+    default:
+        return (const GLubyte*)"";
+    }
+}
+
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName)
+{
+    return GL_INVALID_INDEX;
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name)
+{
+    return -1;
+}
+
+void glHint(GLenum target, GLenum mode)
+{
+}
+
+GLboolean glIsVertexArray(GLuint array)
+{
+    return array != 0 ? GL_TRUE : GL_FALSE;
+}
+
+void glLinkProgram(GLuint program)
+{
+}
+
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    std::vector<unsigned char>* buffer = getBoundBuffer(target);
+    if (buffer == NULL || length <= 0 || (size_t)(offset + length) > buffer->size())
+        return NULL;
+    return &(*buffer)[(size_t)offset];
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+}
+
+void glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+{
+}
+
+void glProgramParameteri(GLuint program, GLenum pname, GLint value)
+{
+}
+
+void glQueryCounter(GLuint id, GLenum target)
+{
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+}
+
+void glStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+}
+
+void glStencilMask(GLuint mask)
+{
+}
+
+void glStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid* pixels)
+{
+}
+
+void glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode)
+{
+}
+
+void glUniform1f(GLint location, GLfloat v0)
+{
+}
+
+void glUniform1fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform1i(GLint location, GLint v0)
+{
+}
+
+void glUniform1iv(GLint location, GLsizei count, const GLint* value)
+{
+}
+
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+}
+
+void glUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+}
+
+void glUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+}
+
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+}
+
+void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+{
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+}
+
+GLboolean glUnmapBuffer(GLenum target)
+{
+    return GL_TRUE;
+}
+
+void glUseProgram(GLuint program)
+{
+}
+
+void glVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    __viewport[0] = x;
+    __viewport[1] = y;
+    __viewport[2] = width;
+    __viewport[3] = height;
+}
+
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef NULLGRAPHICS_H_
+#define NULLGRAPHICS_H_
+
+#ifdef GP_HEADLESS
+
+/**
+ * The OpenGL entry points of the null graphics backend of headless builds (GP_HEADLESS).
+ *
+ * Headless builds have no window and no GL context, and link no GL library: the GL
+ * types and constants come from the system GL headers, and the functions the engine
+ * calls are defined by NullGraphics.cpp. They keep only what the engine reads back:
+ * they hand out object names, keep the data of buffers so that mapped ranges can be
+ * written, and report shaders and programs as compiled and linked with no active
+ * attributes or uniforms, and frame buffers as complete. Nothing is drawn, so textures,
+ * meshes and effects are stubs that hold a name and the CPU-side data of their owners.
+ *
+ * The backend is meant for the main thread only; headless platforms have no loader context.
+ */
+extern "C"
+{
+void glActiveTexture(GLenum texture);
+void glAttachShader(GLuint program, GLuint shader);
+void glBeginQuery(GLenum target, GLuint id);
+void glBeginTransformFeedback(GLenum primitiveMode);
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name);
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer);
+void glBindFramebuffer(GLenum target, GLuint framebuffer);
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer);
+void glBindTexture(GLenum target, GLuint texture);
+void glBindVertexArray(GLuint array);
+void glBlendFunc(GLenum sfactor, GLenum dfactor);
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+GLenum glCheckFramebufferStatus(GLenum target);
+void glClear(GLbitfield mask);
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+void glClearDepth(GLclampd depth);
+void glClearStencil(GLint s);
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+void glCompileShader(GLuint shader);
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid* data);
+GLuint glCreateProgram(void);
+GLuint glCreateShader(GLenum type);
+void glCullFace(GLenum mode);
+void glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+void glDeleteProgram(GLuint program);
+void glDeleteQueries(GLsizei n, const GLuint* ids);
+void glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+void glDeleteShader(GLuint shader);
+void glDeleteSync(GLsync sync);
+void glDeleteTextures(GLsizei n, const GLuint* textures);
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void glDepthFunc(GLenum func);
+void glDepthMask(GLboolean flag);
+void glDisable(GLenum cap);
+void glDisableVertexAttribArray(GLuint index);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount);
+void glEnable(GLenum cap);
+void glEnableVertexAttribArray(GLuint index);
+void glEndQuery(GLenum target);
+void glEndTransformFeedback(void);
+GLsync glFenceSync(GLenum condition, GLbitfield flags);
+void glFinish(void);
+void glFlush(void);
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+void glGenBuffers(GLsizei n, GLuint* buffers);
+void glGenerateMipmap(GLenum target);
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers);
+void glGenQueries(GLsizei n, GLuint* ids);
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+void glGenTextures(GLsizei n, GLuint* textures);
+void glGenVertexArrays(GLsizei n, GLuint* arrays);
+void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+void glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+GLint glGetAttribLocation(GLuint program, const GLchar* name);
+GLenum glGetError(void);
+void glGetIntegerv(GLenum pname, GLint* params);
+void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params);
+void glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params);
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64* params);
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params);
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+const GLubyte* glGetString(GLenum name);
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName);
+GLint glGetUniformLocation(GLuint program, const GLchar* name);
+void glHint(GLenum target, GLenum mode);
+GLboolean glIsVertexArray(GLuint array);
+void glLinkProgram(GLuint program);
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+void glPixelStorei(GLenum pname, GLint param);
+void glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+void glProgramParameteri(GLuint program, GLenum pname, GLint value);
+void glQueryCounter(GLuint id, GLenum target);
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels);
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+void glStencilFunc(GLenum func, GLint ref, GLuint mask);
+void glStencilMask(GLuint mask);
+void glStencilOp(GLenum fail, GLenum zfail, GLenum zpass);
+void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid* pixels);
+void glTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid* pixels);
+void glTexParameteri(GLenum target, GLenum pname, GLint param);
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid* pixels);
+void glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode);
+void glUniform1f(GLint location, GLfloat v0);
+void glUniform1fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniform1i(GLint location, GLint v0);
+void glUniform1iv(GLint location, GLsizei count, const GLint* value);
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void glUniform2fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void glUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+GLboolean glUnmapBuffer(GLenum target);
+void glUseProgram(GLuint program);
+void glVertexAttribDivisor(GLuint index, GLuint divisor);
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,473 @@
+#include "Base.h"
+#include "OcclusionBuffer.h"
+#include "Camera.h"
+#include "Node.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Game.h"
+#include "MathUtilSIMD.h"
+
+// The width and height of the blocks of the hierarchical depth buffer, and of the bands of rows rasterized by one job.
+#define OCCLUSION_BLOCK_SIZE 8
+
+// The minimum number of occluders set up by one job.
+#define OCCLUSION_OCCLUDER_BATCH 4
+
+// Depth tolerance of the visibility test.
+#define OCCLUSION_DEPTH_EPSILON 0.00001f
+
+namespace gameplay
+{
+
+OcclusionBuffer::OcclusionBuffer() :
+    _width(0), _height(0), _blockCountX(0), _blockCountY(0), _triangleCount(0), _rasterized(false)
+{
+}
+
+OcclusionBuffer::~OcclusionBuffer()
+{
+    for (size_t i = 0, count = _occluders.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_occluders[i]->node);
+        SAFE_DELETE(_occluders[i]);
+    }
+}
+
+OcclusionBuffer* OcclusionBuffer::create(unsigned int width, unsigned int height)
+{
+    OcclusionBuffer* buffer = new OcclusionBuffer();
+    buffer->_width = std::max((width + OCCLUSION_BLOCK_SIZE - 1) / OCCLUSION_BLOCK_SIZE, 1u) * OCCLUSION_BLOCK_SIZE;
+    buffer->_height = std::max((height + OCCLUSION_BLOCK_SIZE - 1) / OCCLUSION_BLOCK_SIZE, 1u) * OCCLUSION_BLOCK_SIZE;
+    buffer->_blockCountX = buffer->_width / OCCLUSION_BLOCK_SIZE;
+    buffer->_blockCountY = buffer->_height / OCCLUSION_BLOCK_SIZE;
+    buffer->_depth.resize(buffer->_width * buffer->_height, 1.0f);
+    buffer->_blockDepth.resize(buffer->_blockCountX * buffer->_blockCountY, 1.0f);
+    return buffer;
+}
+
+void OcclusionBuffer::addOccluder(Node* node, const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(vertices);
+    GP_ASSERT(indices);
+
+    if (vertexCount == 0 || indexCount < 3)
+    {
+        GP_WARN("Occluder of node '%s' has no triangles.", node->getId());
+        return;
+    }
+
+    removeOccluder(node);
+
+    Occluder* occluder = new Occluder();
+    occluder->node = node;
+    node->addRef();
+    occluder->vertices.assign(vertices, vertices + vertexCount);
+    occluder->indices.assign(indices, indices + indexCount - indexCount % 3);
+    occluder->clipVertices.resize(vertexCount);
+    occluder->inView = false;
+    occluder->bounds.set(vertices[0], vertices[0]);
+    for (unsigned int i = 1; i < vertexCount; ++i)
+    {
+        occluder->bounds.merge(BoundingBox(vertices[i], vertices[i]));
+    }
+    _occluders.push_back(occluder);
+}
+
+void OcclusionBuffer::addOccluder(Node* node, const BoundingBox& box)
+{
+    const Vector3& a = box.min;
+    const Vector3& b = box.max;
+    Vector3 vertices[] =
+    {
+        Vector3(a.x, a.y, a.z), Vector3(b.x, a.y, a.z), Vector3(b.x, b.y, a.z), Vector3(a.x, b.y, a.z),
+        Vector3(a.x, a.y, b.z), Vector3(b.x, a.y, b.z), Vector3(b.x, b.y, b.z), Vector3(a.x, b.y, b.z)
+    };
+
+    // Faces are counter-clockwise seen from outside the box.
+    static const unsigned short indices[] =
+    {
+        0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,  0, 4, 7, 0, 7, 3,  1, 2, 6, 1, 6, 5
+    };
+    addOccluder(node, vertices, 8, indices, 36);
+}
+
+void OcclusionBuffer::removeOccluder(Node* node)
+{
+    for (size_t i = 0, count = _occluders.size(); i < count; ++i)
+    {
+        if (_occluders[i]->node == node)
+        {
+            SAFE_RELEASE(_occluders[i]->node);
+            SAFE_DELETE(_occluders[i]);
+            _occluders.erase(_occluders.begin() + i);
+            return;
+        }
+    }
+}
+
+unsigned int OcclusionBuffer::getOccluderCount() const
+{
+    return (unsigned int)_occluders.size();
+}
+
+void OcclusionBuffer::rasterize(Camera* camera)
+{
+    _rasterized = false;
+    _triangleCount = 0;
+    if (!camera)
+        return;
+
+    _viewProjection = camera->getViewProjectionMatrix();
+
+    // World matrices are updated on this thread; only the occluders in view are set up.
+    const Frustum& frustum = camera->getFrustum();
+    unsigned int occluderCount = (unsigned int)_occluders.size();
+    for (unsigned int i = 0; i < occluderCount; ++i)
+    {
+        Occluder* occluder = _occluders[i];
+        const Matrix& world = occluder->node->getWorldMatrix();
+        BoundingBox bounds(occluder->bounds);
+        bounds.transform(world);
+        occluder->inView = frustum.intersects(bounds);
+        if (occluder->inView)
+        {
+            Matrix::multiply(_viewProjection, world, &occluder->worldViewProjection);
+        }
+    }
+
+    Game* game = Game::getInstance();
+    JobScheduler* scheduler = game ? game->getJobScheduler() : NULL;
+
+    if (scheduler)
+        scheduler->parallelFor(occluderCount, setupOccluders, this, OCCLUSION_OCCLUDER_BATCH);
+    else
+        setupOccluders(0, occluderCount, this);
+
+    for (unsigned int i = 0; i < occluderCount; ++i)
+    {
+        _triangleCount += (unsigned int)_occluders[i]->triangles.size();
+    }
+
+    if (scheduler)
+        scheduler->parallelFor(_blockCountY, rasterizeBands, this);
+    else
+        rasterizeBands(0, _blockCountY, this);
+
+    _rasterized = true;
+}
+
+void OcclusionBuffer::setupOccluders(unsigned int start, unsigned int end, void* cookie)
+{
+    OcclusionBuffer* buffer = static_cast<OcclusionBuffer*>(cookie);
+
+    for (unsigned int i = start; i < end; ++i)
+    {
+        Occluder* occluder = buffer->_occluders[i];
+        occluder->triangles.clear();
+        if (!occluder->inView)
+            continue;
+
+        const Matrix& worldViewProjection = occluder->worldViewProjection;
+        for (size_t j = 0, count = occluder->vertices.size(); j < count; ++j)
+        {
+            const Vector3& v = occluder->vertices[j];
+            worldViewProjection.transformVector(Vector4(v.x, v.y, v.z, 1.0f), &occluder->clipVertices[j]);
+        }
+
+        const std::vector<Vector4>& clip = occluder->clipVertices;
+        for (size_t j = 0, count = occluder->indices.size(); j < count; j += 3)
+        {
+            buffer->addTriangle(occluder, clip[occluder->indices[j]], clip[occluder->indices[j + 1]], clip[occluder->indices[j + 2]]);
+        }
+    }
+}
+
+void OcclusionBuffer::addTriangle(Occluder* occluder, const Vector4& a, const Vector4& b, const Vector4& c) const
+{
+    // Distances to the near plane (z = -w), positive in front of it.
+    float da = a.z + a.w;
+    float db = b.z + b.w;
+    float dc = c.z + c.w;
+    if (da >= 0.0f && db >= 0.0f && dc >= 0.0f)
+    {
+        setupTriangle(occluder, a, b, c);
+        return;
+    }
+    if (da < 0.0f && db < 0.0f && dc < 0.0f)
+        return;
+
+    // Clip the polygon against the near plane, leaving three or four vertices.
+    const Vector4* input[3] = { &a, &b, &c };
+    const float distances[3] = { da, db, dc };
+    Vector4 output[4];
+    unsigned int outputCount = 0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        unsigned int next = (i + 1) % 3;
+        if (distances[i] >= 0.0f)
+        {
+            output[outputCount++] = *input[i];
+        }
+        if ((distances[i] >= 0.0f) != (distances[next] >= 0.0f))
+        {
+            float t = distances[i] / (distances[i] - distances[next]);
+            output[outputCount++] = *input[i] + (*input[next] - *input[i]) * t;
+        }
+    }
+
+    for (unsigned int i = 2; i < outputCount; ++i)
+    {
+        setupTriangle(occluder, output[0], output[i - 1], output[i]);
+    }
+}
+
+void OcclusionBuffer::setupTriangle(Occluder* occluder, const Vector4& a, const Vector4& b, const Vector4& c) const
+{
+    const Vector4* clip[3] = { &a, &b, &c };
+    float x[3], y[3], z[3];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        float w = clip[i]->w > MATH_EPSILON ? clip[i]->w : MATH_EPSILON;
+        x[i] = (clip[i]->x / w * 0.5f + 0.5f) * _width;
+        y[i] = (clip[i]->y / w * 0.5f + 0.5f) * _height;
+        z[i] = clip[i]->z / w * 0.5f + 0.5f;
+    }
+
+    // Back faces and degenerate triangles have no positive area.
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area <= MATH_EPSILON)
+        return;
+
+    Triangle triangle;
+    triangle.minX = std::max((int)floorf(std::min(x[0], std::min(x[1], x[2]))), 0);
+    triangle.maxX = std::min((int)ceilf(std::max(x[0], std::max(x[1], x[2]))), (int)_width - 1);
+    triangle.minY = std::max((int)floorf(std::min(y[0], std::min(y[1], y[2]))), 0);
+    triangle.maxY = std::min((int)ceilf(std::max(y[0], std::max(y[1], y[2]))), (int)_height - 1);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    // Edge equations, positive inside the triangle.
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        unsigned int j = (i + 1) % 3;
+        triangle.edges[i][0] = y[i] - y[j];
+        triangle.edges[i][1] = x[j] - x[i];
+        triangle.edges[i][2] = x[i] * y[j] - y[i] * x[j];
+    }
+
+    // Depth plane, moved back by its slope over half a pixel so that the depth
+    // written at a pixel center is never nearer than the triangle over the pixel.
+    float dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    float dzdy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    triangle.depth[0] = z[0] - dzdx * x[0] - dzdy * y[0] + 0.5f * (fabs(dzdx) + fabs(dzdy));
+    triangle.depth[1] = dzdx;
+    triangle.depth[2] = dzdy;
+
+    occluder->triangles.push_back(triangle);
+}
+
+void OcclusionBuffer::rasterizeBands(unsigned int start, unsigned int end, void* cookie)
+{
+    OcclusionBuffer* buffer = static_cast<OcclusionBuffer*>(cookie);
+    unsigned int width = buffer->_width;
+
+    for (unsigned int band = start; band < end; ++band)
+    {
+        int minY = band * OCCLUSION_BLOCK_SIZE;
+        int maxY = minY + OCCLUSION_BLOCK_SIZE - 1;
+        std::fill(buffer->_depth.begin() + minY * width, buffer->_depth.begin() + (maxY + 1) * width, 1.0f);
+
+        for (size_t i = 0, count = buffer->_occluders.size(); i < count; ++i)
+        {
+            const std::vector<Triangle>& triangles = buffer->_occluders[i]->triangles;
+            for (size_t j = 0, triangleCount = triangles.size(); j < triangleCount; ++j)
+            {
+                const Triangle& triangle = triangles[j];
+                if (triangle.maxY >= minY && triangle.minY <= maxY)
+                {
+                    buffer->rasterizeTriangle(triangle, std::max(triangle.minY, minY), std::min(triangle.maxY, maxY));
+                }
+            }
+        }
+
+        // The farthest depth of each block of the band.
+        for (unsigned int blockX = 0; blockX < buffer->_blockCountX; ++blockX)
+        {
+            float depth = 0.0f;
+            for (int y = minY; y <= maxY; ++y)
+            {
+                const float* row = &buffer->_depth[y * width + blockX * OCCLUSION_BLOCK_SIZE];
+                for (unsigned int x = 0; x < OCCLUSION_BLOCK_SIZE; ++x)
+                {
+                    depth = std::max(depth, row[x]);
+                }
+            }
+            buffer->_blockDepth[band * buffer->_blockCountX + blockX] = depth;
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeTriangle(const Triangle& triangle, int minY, int maxY)
+{
+    const float (*e)[3] = triangle.edges;
+    const float* d = triangle.depth;
+
+    // Spans start on a multiple of four pixels; the buffer width is a multiple of eight.
+    int minX = triangle.minX & ~3;
+    int maxX = triangle.maxX;
+
+#ifdef GP_SIMD
+    const float4 offsets = float4Set(0.5f, 1.5f, 2.5f, 3.5f);
+    const float4 zero = FLOAT4_SET(0.0f);
+    const float4 step0 = FLOAT4_MUL(FLOAT4_SET(e[0][0]), offsets);
+    const float4 step1 = FLOAT4_MUL(FLOAT4_SET(e[1][0]), offsets);
+    const float4 step2 = FLOAT4_MUL(FLOAT4_SET(e[2][0]), offsets);
+    const float4 stepZ = FLOAT4_MUL(FLOAT4_SET(d[1]), offsets);
+#endif
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float centerY = y + 0.5f;
+        float row0 = e[0][1] * centerY + e[0][2];
+        float row1 = e[1][1] * centerY + e[1][2];
+        float row2 = e[2][1] * centerY + e[2][2];
+        float rowZ = d[2] * centerY + d[0];
+        float* depth = &_depth[y * _width];
+
+        for (int x = minX; x <= maxX; x += 4)
+        {
+            float left = (float)x;
+#ifdef GP_SIMD
+            float4 e0 = FLOAT4_ADD(FLOAT4_SET(row0 + e[0][0] * left), step0);
+            float4 e1 = FLOAT4_ADD(FLOAT4_SET(row1 + e[1][0] * left), step1);
+            float4 e2 = FLOAT4_ADD(FLOAT4_SET(row2 + e[2][0] * left), step2);
+            float4 z = FLOAT4_ADD(FLOAT4_SET(rowZ + d[1] * left), stepZ);
+            float4 current = FLOAT4_LOAD(depth + x);
+            float4 nearest = FLOAT4_MIN(current, z);
+            nearest = FLOAT4_SELECT_GREATER(e2, zero, nearest, current);
+            nearest = FLOAT4_SELECT_GREATER(e1, zero, nearest, current);
+            FLOAT4_STORE(depth + x, FLOAT4_SELECT_GREATER(e0, zero, nearest, current));
+#else
+            for (int i = 0; i < 4; ++i)
+            {
+                float centerX = left + i + 0.5f;
+                if (e[0][0] * centerX + row0 > 0.0f && e[1][0] * centerX + row1 > 0.0f && e[2][0] * centerX + row2 > 0.0f)
+                {
+                    float z = d[1] * centerX + rowZ;
+                    if (z < depth[x + i])
+                        depth[x + i] = z;
+                }
+            }
+#endif
+        }
+    }
+}
+
+bool OcclusionBuffer::isVisible(const BoundingBox& box) const
+{
+    if (!_rasterized || box.isEmpty())
+        return true;
+
+    Vector3 corners[8];
+    box.getCorners(corners);
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        Vector4 clip;
+        _viewProjection.transformVector(Vector4(corners[i].x, corners[i].y, corners[i].z, 1.0f), &clip);
+
+        // A box the near plane clips is too close to be hidden.
+        if (clip.z + clip.w <= 0.0f || clip.w <= MATH_EPSILON)
+            return true;
+
+        float x = (clip.x / clip.w * 0.5f + 0.5f) * _width;
+        float y = (clip.y / clip.w * 0.5f + 0.5f) * _height;
+        float z = clip.z / clip.w * 0.5f + 0.5f;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, z);
+    }
+
+    // Boxes outside the buffer are left to frustum culling.
+    int left = std::max((int)floorf(minX), 0);
+    int right = std::min((int)floorf(maxX), (int)_width - 1);
+    int bottom = std::max((int)floorf(minY), 0);
+    int top = std::min((int)floorf(maxY), (int)_height - 1);
+    if (left > right || bottom > top)
+        return true;
+
+    minZ -= OCCLUSION_DEPTH_EPSILON;
+    for (int blockY = bottom / OCCLUSION_BLOCK_SIZE; blockY <= top / OCCLUSION_BLOCK_SIZE; ++blockY)
+    {
+        for (int blockX = left / OCCLUSION_BLOCK_SIZE; blockX <= right / OCCLUSION_BLOCK_SIZE; ++blockX)
+        {
+            // Blocks entirely nearer than the box hide the part of it they cover.
+            if (_blockDepth[blockY * _blockCountX + blockX] <= minZ)
+                continue;
+
+            int x0 = std::max(blockX * OCCLUSION_BLOCK_SIZE, left);
+            int x1 = std::min(blockX * OCCLUSION_BLOCK_SIZE + OCCLUSION_BLOCK_SIZE - 1, right);
+            int y0 = std::max(blockY * OCCLUSION_BLOCK_SIZE, bottom);
+            int y1 = std::min(blockY * OCCLUSION_BLOCK_SIZE + OCCLUSION_BLOCK_SIZE - 1, top);
+            for (int y = y0; y <= y1; ++y)
+            {
+                const float* row = &_depth[y * _width];
+                for (int x = x0; x <= x1; ++x)
+                {
+                    if (row[x] > minZ)
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool OcclusionBuffer::isVisible(Node* node) const
+{
+    GP_ASSERT(node);
+
+    BoundingBox box;
+    Model* model = node->getModel();
+    if (model && !model->getMesh()->getBoundingBox().isEmpty())
+    {
+        box = model->getMesh()->getBoundingBox();
+        box.transform(node->getWorldMatrix());
+    }
+    else
+    {
+        const BoundingSphere& sphere = node->getBoundingSphere();
+        if (sphere.radius <= 0.0f)
+            return true;
+        Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+        box.set(sphere.center - extent, sphere.center + extent);
+    }
+    return isVisible(box);
+}
+
+unsigned int OcclusionBuffer::getTriangleCount() const
+{
+    return _triangleCount;
+}
+
+const float* OcclusionBuffer::getDepthBuffer() const
+{
+    return &_depth[0];
+}
+
+unsigned int OcclusionBuffer::getWidth() const
+{
+    return _width;
+}
+
+unsigned int OcclusionBuffer::getHeight() const
+{
+    return _height;
+}
+
+}
@@ -0,0 +1,221 @@
+#ifndef OCCLUSIONBUFFER_H_
+#define OCCLUSIONBUFFER_H_
+
+#include "Ref.h"
+#include "BoundingBox.h"
+#include "Matrix.h"
+#include "Vector4.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Node;
+
+/**
+ * Culls nodes hidden behind occluders with a depth buffer rasterized on the CPU.
+ *
+ * This is the occlusion culling path for devices without occlusion queries (see
+ * OcclusionCuller). Occluders are simplified, closed meshes (often boxes) attached to
+ * the nodes of large geometry such as walls, buildings and terrain features. Each
+ * frame, rasterize() draws the occluders in view into a small depth buffer, with four
+ * pixels at a time where SSE or NEON is available and one band of rows per job on the
+ * job scheduler's workers, then builds a hierarchical depth buffer holding the farthest
+ * depth of each 8x8 block of pixels.
+ *
+ * isVisible() then tests the screen rectangle and nearest depth of a bounding box
+ * against the blocks it covers, and only reads single pixels in the blocks that do
+ * not decide the test. A node found hidden is never submitted to the GPU. A RenderQueue
+ * with an occlusion buffer rasterizes it in begin() and tests the nodes added to it.
+ *
+ * Only the front faces of occluders, counter-clockwise, are drawn. The depth written at
+ * each pixel is biased to the farthest depth of the triangle over that pixel, so an
+ * occluder never hides geometry it intersects.
+ *
+ * @script{ignore}
+ */
+class OcclusionBuffer : public Ref
+{
+public:
+
+    /**
+     * Creates an occlusion buffer.
+     *
+     * @param width The width of the depth buffer in pixels, rounded up to a multiple of 8.
+     * @param height The height of the depth buffer in pixels, rounded up to a multiple of 8.
+     *
+     * @return The new occlusion buffer.
+     */
+    static OcclusionBuffer* create(unsigned int width = 256, unsigned int height = 128);
+
+    /**
+     * Adds an occluder mesh to a node, replacing any occluder the node already has.
+     *
+     * @param node The node the occluder moves with.
+     * @param vertices The positions of the occluder, in the local space of the node.
+     * @param vertexCount The number of positions.
+     * @param indices The triangle list of the occluder.
+     * @param indexCount The number of indices, a multiple of 3.
+     */
+    void addOccluder(Node* node, const Vector3* vertices, unsigned int vertexCount, const unsigned short* indices, unsigned int indexCount);
+
+    /**
+     * Adds a box occluder to a node, replacing any occluder the node already has.
+     *
+     * @param node The node the occluder moves with.
+     * @param box The box, in the local space of the node.
+     */
+    void addOccluder(Node* node, const BoundingBox& box);
+
+    /**
+     * Removes the occluder of a node.
+     *
+     * @param node The node.
+     */
+    void removeOccluder(Node* node);
+
+    /**
+     * Gets the number of occluders.
+     *
+     * @return The number of occluders.
+     */
+    unsigned int getOccluderCount() const;
+
+    /**
+     * Rasterizes the occluders as seen from a camera.
+     *
+     * This should be called once per frame after the scene is updated and before
+     * its nodes are tested.
+     *
+     * @param camera The camera to rasterize the occluders for.
+     */
+    void rasterize(Camera* camera);
+
+    /**
+     * Tests whether a box may be visible behind the occluders.
+     *
+     * @param box The box, in world space.
+     *
+     * @return false if the occluders hide the box, true otherwise.
+     */
+    bool isVisible(const BoundingBox& box) const;
+
+    /**
+     * Tests whether a node may be visible behind the occluders.
+     *
+     * The node's model bounding box is tested, or its bounding sphere if it has no model.
+     *
+     * @param node The node.
+     *
+     * @return false if the occluders hide the node, true otherwise.
+     */
+    bool isVisible(Node* node) const;
+
+    /**
+     * Gets the number of triangles rasterized by the last call to rasterize().
+     *
+     * @return The number of triangles.
+     */
+    unsigned int getTriangleCount() const;
+
+    /**
+     * Gets the depth buffer of the last call to rasterize(), one float per pixel
+     * from the bottom row up, with 1 where no occluder was drawn.
+     *
+     * @return The depth buffer.
+     */
+    const float* getDepthBuffer() const;
+
+    /**
+     * Gets the width of the depth buffer.
+     *
+     * @return The width in pixels.
+     */
+    unsigned int getWidth() const;
+
+    /**
+     * Gets the height of the depth buffer.
+     *
+     * @return The height in pixels.
+     */
+    unsigned int getHeight() const;
+
+private:
+
+    struct Triangle
+    {
+        int minX;
+        int maxX;
+        int minY;
+        int maxY;
+        float edges[3][3];
+        float depth[3];
+    };
+
+    struct Occluder
+    {
+        Node* node;
+        BoundingBox bounds;
+        std::vector<Vector3> vertices;
+        std::vector<unsigned short> indices;
+        std::vector<Vector4> clipVertices;
+        std::vector<Triangle> triangles;
+        Matrix worldViewProjection;
+        bool inView;
+    };
+
+    /**
+     * Constructor.
+     */
+    OcclusionBuffer();
+
+    /**
+     * Destructor.
+     */
+    ~OcclusionBuffer();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    OcclusionBuffer& operator=(const OcclusionBuffer&);
+
+    /**
+     * Clips a triangle in clip space against the near plane and adds the visible part.
+     */
+    void addTriangle(Occluder* occluder, const Vector4& a, const Vector4& b, const Vector4& c) const;
+
+    /**
+     * Sets up the edge and depth equations of a triangle in screen space.
+     */
+    void setupTriangle(Occluder* occluder, const Vector4& a, const Vector4& b, const Vector4& c) const;
+
+    /**
+     * Rasterizes the rows of a triangle between minY and maxY into the depth buffer.
+     */
+    void rasterizeTriangle(const Triangle& triangle, int minY, int maxY);
+
+    /**
+     * Job scheduler range function that transforms and sets up the triangles of a range of occluders.
+     */
+    static void setupOccluders(unsigned int start, unsigned int end, void* cookie);
+
+    /**
+     * Job scheduler range function that rasterizes a range of bands of 8 rows.
+     */
+    static void rasterizeBands(unsigned int start, unsigned int end, void* cookie);
+
+    unsigned int _width;
+    unsigned int _height;
+    unsigned int _blockCountX;
+    unsigned int _blockCountY;
+    std::vector<float> _depth;
+    std::vector<float> _blockDepth;
+    std::vector<Occluder*> _occluders;
+    Matrix _viewProjection;
+    unsigned int _triangleCount;
+    bool _rasterized;
+};
+
+}
+
+#endif
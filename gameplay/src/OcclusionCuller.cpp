@@ -0,0 +1,300 @@
+#include "Base.h"
+#include "OcclusionCuller.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "Camera.h"
+#include "Node.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Effect.h"
+#include "VertexAttributeBinding.h"
+#include "RenderState.h"
+#include "RenderStats.h"
+
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED 0x8914
+#endif
+
+// Number of queries generated at a time.
+#define OCCLUSION_QUERY_BLOCK 64
+
+// Frames after which the record of a node that is no longer tested is dropped.
+#define OCCLUSION_RETIRE_FRAMES 4
+
+namespace gameplay
+{
+
+static int __occlusionQueriesSupported = -1;
+static GLenum __occlusionQueryTarget = GL_SAMPLES_PASSED;
+
+OcclusionCuller::OcclusionCuller() :
+    _visibleQueryInterval(1), _camera(NULL), _boxMesh(NULL), _effect(NULL), _matrixUniform(NULL), _binding(NULL), _stateBlock(NULL),
+    _frame(0), _occludedCount(0), _queryCount(0)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+#ifdef USE_OCCLUSION_QUERIES
+    for (std::map<Node*, Record>::iterator itr = _records.begin(); itr != _records.end(); ++itr)
+    {
+        if (itr->second.query)
+        {
+            _freeQueries.push_back(itr->second.query);
+        }
+    }
+    if (!_freeQueries.empty())
+    {
+        GL_ASSERT( glDeleteQueries((GLsizei)_freeQueries.size(), &_freeQueries[0]) );
+    }
+#endif
+    SAFE_RELEASE(_stateBlock);
+    SAFE_RELEASE(_binding);
+    SAFE_RELEASE(_effect);
+    SAFE_RELEASE(_boxMesh);
+    SAFE_RELEASE(_camera);
+}
+
+bool OcclusionCuller::isSupported()
+{
+    if (__occlusionQueriesSupported < 0)
+    {
+        __occlusionQueriesSupported = 0;
+#ifdef USE_OCCLUSION_QUERIES
+        // Queries belong to the context that issues them, so none are made while a render thread replays the frames.
+        if (glGenQueries && glDeleteQueries && glBeginQuery && glEndQuery && glGetQueryObjectuiv && !RenderCommandList::isRecording())
+        {
+            __occlusionQueriesSupported = 1;
+#ifdef OPENGL_ES
+            __occlusionQueryTarget = GL_ANY_SAMPLES_PASSED;
+#else
+            // Boolean queries may finish as soon as one sample passes.
+            if (GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2)
+                __occlusionQueryTarget = GL_ANY_SAMPLES_PASSED;
+#endif
+        }
+#endif
+    }
+    return __occlusionQueriesSupported == 1;
+}
+
+OcclusionCuller* OcclusionCuller::create(unsigned int visibleQueryInterval)
+{
+    if (!isSupported())
+    {
+        GP_WARN("Occlusion queries are not supported; occlusion culling is disabled.");
+        return NULL;
+    }
+
+    // A unit cube, scaled and translated to each box.
+    static const float vertices[] =
+    {
+        -1.0f, -1.0f, -1.0f,  1.0f, -1.0f, -1.0f,  1.0f, 1.0f, -1.0f,  -1.0f, 1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,  1.0f, -1.0f,  1.0f,  1.0f, 1.0f,  1.0f,  -1.0f, 1.0f,  1.0f
+    };
+    static const unsigned short indices[] =
+    {
+        0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,  0, 4, 7, 0, 7, 3,  1, 2, 6, 1, 6, 5
+    };
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3)
+    };
+    Mesh* mesh = Mesh::createMesh(VertexFormat(elements, 1), 8, false);
+    Effect* effect = Effect::createFromFile("res/shaders/colored-unlit.vert", "res/shaders/colored-unlit.frag");
+    if (mesh == NULL || effect == NULL)
+    {
+        GP_ERROR("Failed to create the occlusion query boxes.");
+        SAFE_RELEASE(mesh);
+        SAFE_RELEASE(effect);
+        return NULL;
+    }
+    mesh->setVertexData(vertices, 0, 8);
+    MeshPart* part = mesh->addPart(Mesh::TRIANGLES, Mesh::INDEX16, 36, false);
+    part->setIndexData(indices, 0, 36);
+
+    OcclusionCuller* culler = new OcclusionCuller();
+    culler->_visibleQueryInterval = std::max(visibleQueryInterval, 1u);
+    culler->_boxMesh = mesh;
+    culler->_effect = effect;
+    culler->_matrixUniform = effect->getUniform("u_worldViewProjectionMatrix");
+    culler->_binding = VertexAttributeBinding::create(mesh, effect);
+
+    // Boxes are tested against the depth of the frame without changing it.
+    culler->_stateBlock = RenderState::StateBlock::create();
+    culler->_stateBlock->setDepthTest(true);
+    culler->_stateBlock->setDepthWrite(false);
+    culler->_stateBlock->setCullFace(false);
+    culler->_stateBlock->setBlend(false);
+    return culler;
+}
+
+void OcclusionCuller::begin(Camera* camera)
+{
+    if (camera != _camera)
+    {
+        SAFE_RELEASE(_camera);
+        _camera = camera;
+        if (_camera)
+        {
+            _camera->addRef();
+        }
+    }
+    ++_frame;
+    _occludedCount = 0;
+    _queries.clear();
+
+#ifdef USE_OCCLUSION_QUERIES
+    // Collect the results that are ready without waiting for the others.
+    for (std::map<Node*, Record>::iterator itr = _records.begin(); itr != _records.end();)
+    {
+        Record& record = itr->second;
+        if (record.pending)
+        {
+            GLuint available = 0;
+            GL_ASSERT( glGetQueryObjectuiv(record.query, GL_QUERY_RESULT_AVAILABLE, &available) );
+            if (available)
+            {
+                GLuint samples = 0;
+                GL_ASSERT( glGetQueryObjectuiv(record.query, GL_QUERY_RESULT, &samples) );
+                record.visible = samples > 0;
+                record.pending = false;
+                _freeQueries.push_back(record.query);
+                record.query = 0;
+            }
+        }
+
+        // Nodes may have been destroyed since they were last tested.
+        if (!record.pending && _frame - record.lastTestFrame > OCCLUSION_RETIRE_FRAMES)
+        {
+            _records.erase(itr++);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+#endif
+}
+
+bool OcclusionCuller::test(Node* node)
+{
+    GP_ASSERT(node);
+
+    std::map<Node*, Record>::iterator itr = _records.find(node);
+    bool added = itr == _records.end();
+    if (added)
+    {
+        Record record;
+        record.query = 0;
+        record.lastTestFrame = 0;
+        record.visible = true;
+        record.pending = false;
+        itr = _records.insert(std::make_pair(node, record)).first;
+    }
+    Record& record = itr->second;
+    record.lastTestFrame = _frame;
+
+    // Visible nodes are queried again every few frames, each at its own frame.
+    if (record.pending || !_camera || (record.visible && !added && (_frame + ((size_t)node >> 4)) % _visibleQueryInterval != 0))
+    {
+        if (!record.visible)
+            ++_occludedCount;
+        return record.visible;
+    }
+
+    BoundingBox box;
+    Model* model = node->getModel();
+    if (model && !model->getMesh()->getBoundingBox().isEmpty())
+    {
+        box = model->getMesh()->getBoundingBox();
+        box.transform(node->getWorldMatrix());
+    }
+    else
+    {
+        const BoundingSphere& sphere = node->getBoundingSphere();
+        Vector3 extent(sphere.radius, sphere.radius, sphere.radius);
+        box.set(sphere.center - extent, sphere.center + extent);
+    }
+
+    // A box the near plane may clip cannot be tested.
+    Vector3 position = _camera->getNode() ? _camera->getNode()->getTranslationWorld() : Vector3::zero();
+    float margin = _camera->getNearPlane() * 2.0f;
+    if (position.x > box.min.x - margin && position.y > box.min.y - margin && position.z > box.min.z - margin &&
+        position.x < box.max.x + margin && position.y < box.max.y + margin && position.z < box.max.z + margin)
+    {
+        record.visible = true;
+        return true;
+    }
+
+    Query query;
+    query.record = &record;
+    query.box = box;
+    _queries.push_back(query);
+
+    if (!record.visible)
+        ++_occludedCount;
+    return record.visible;
+}
+
+void OcclusionCuller::end()
+{
+    _queryCount = (unsigned int)_queries.size();
+    if (_queries.empty() || !_camera)
+        return;
+
+#ifdef USE_OCCLUSION_QUERIES
+    if (_freeQueries.size() < _queries.size())
+    {
+        size_t first = _freeQueries.size();
+        size_t count = std::max(_queries.size() - first, (size_t)OCCLUSION_QUERY_BLOCK);
+        _freeQueries.resize(first + count);
+        GL_ASSERT( glGenQueries((GLsizei)count, &_freeQueries[first]) );
+    }
+
+    _stateBlock->bind();
+    StateCache::setColorMask(false, false, false, false);
+    _effect->bind();
+    _binding->bind();
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _boxMesh->getPart(0)->getIndexBuffer());
+
+    const Matrix& viewProjection = _camera->getViewProjectionMatrix();
+    for (size_t i = 0, count = _queries.size(); i < count; ++i)
+    {
+        const BoundingBox& box = _queries[i].box;
+        Vector3 center = box.getCenter();
+        Matrix matrix(viewProjection);
+        matrix.translate(center);
+        matrix.scale((box.max - box.min) * 0.5f);
+        _effect->setValue(_matrixUniform, matrix);
+
+        Record* record = _queries[i].record;
+        record->query = _freeQueries.back();
+        record->pending = true;
+        _freeQueries.pop_back();
+
+        GL_ASSERT( glBeginQuery(__occlusionQueryTarget, record->query) );
+        RenderCommandList::drawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+        GL_ASSERT( glEndQuery(__occlusionQueryTarget) );
+        RenderStats::addDrawCall(GL_TRIANGLES, 36);
+    }
+
+    _binding->unbind();
+    StateCache::setColorMask(true, true, true, true);
+#endif
+    _queries.clear();
+}
+
+unsigned int OcclusionCuller::getOccludedCount() const
+{
+    return _occludedCount;
+}
+
+unsigned int OcclusionCuller::getQueryCount() const
+{
+    return _queryCount;
+}
+
+}
@@ -0,0 +1,155 @@
+#ifndef OCCLUSIONCULLER_H_
+#define OCCLUSIONCULLER_H_
+
+#include "Ref.h"
+#include "BoundingBox.h"
+#include "RenderState.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Node;
+class Mesh;
+class Effect;
+class Uniform;
+class VertexAttributeBinding;
+
+/**
+ * Culls nodes hidden behind other geometry with hardware occlusion queries.
+ *
+ * After the visible nodes of a frame are drawn, end() draws the world bounding boxes of
+ * the nodes being queried against the depth buffer, with color and depth writes off,
+ * each inside an occlusion query. The results are read at the next begin(), only once
+ * they are available, so the CPU never waits on the GPU; a node keeps its last known
+ * visibility until its query completes.
+ *
+ * Queries are temporally coherent: nodes found occluded are queried every frame, so
+ * they reappear one frame after they become visible, while nodes found visible stay
+ * visible and are only queried again every few frames (at staggered frames per node).
+ * Nodes whose box contains the camera are always visible and never queried.
+ *
+ * The nodes to test are usually the result of frustum culling, e.g. Scene::findVisibleNodes,
+ * which uses the spatial index of the scene. A RenderQueue with an occlusion culler tests
+ * the nodes added to it and issues the queries after it draws:
+ *
+ * @verbatim
+    _renderQueue->setOcclusionCuller(_occlusionCuller);
+    _renderQueue->begin(scene->getActiveCamera());      // calls _occlusionCuller->begin()
+    scene->findVisibleNodes(camera->getFrustum(), _nodes);
+    for (size_t i = 0; i < _nodes.size(); ++i)
+        _renderQueue->add(_nodes[i]);                   // skips nodes that test occluded
+    _renderQueue->end();
+    _renderQueue->draw();                               // calls _occlusionCuller->end()
+   @endverbatim
+ *
+ * Occlusion queries require OpenGL 1.5 or, on OpenGL ES 2.0, GL_EXT_occlusion_query_boolean.
+ *
+ * @script{ignore}
+ */
+class OcclusionCuller : public Ref
+{
+public:
+
+    /**
+     * Determines whether occlusion queries are supported on this device.
+     *
+     * @return true if occlusion queries are supported, false otherwise.
+     */
+    static bool isSupported();
+
+    /**
+     * Creates an occlusion culler.
+     *
+     * @param visibleQueryInterval The number of frames between queries of a visible node.
+     *
+     * @return The new occlusion culler, or NULL if occlusion queries are not supported.
+     */
+    static OcclusionCuller* create(unsigned int visibleQueryInterval = 8);
+
+    /**
+     * Starts a frame, collecting the results of the queries that have completed.
+     *
+     * @param camera The camera the frame is drawn with.
+     */
+    void begin(Camera* camera);
+
+    /**
+     * Tests whether a node should be drawn this frame, and queues it for a query if needed.
+     *
+     * @param node The node to test.
+     *
+     * @return false if the node was found occluded, true otherwise.
+     */
+    bool test(Node* node);
+
+    /**
+     * Issues the queries of the frame against the current depth buffer.
+     *
+     * This must be called after the visible nodes of the frame are drawn.
+     */
+    void end();
+
+    /**
+     * Gets the number of nodes found occluded by the tests of the last frame.
+     *
+     * @return The number of occluded nodes.
+     */
+    unsigned int getOccludedCount() const;
+
+    /**
+     * Gets the number of queries issued by the last frame.
+     *
+     * @return The number of queries.
+     */
+    unsigned int getQueryCount() const;
+
+private:
+
+    struct Record
+    {
+        unsigned int query;
+        unsigned int lastTestFrame;
+        bool visible;
+        bool pending;
+    };
+
+    struct Query
+    {
+        Record* record;
+        BoundingBox box;
+    };
+
+    /**
+     * Constructor.
+     */
+    OcclusionCuller();
+
+    /**
+     * Destructor.
+     */
+    ~OcclusionCuller();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    OcclusionCuller& operator=(const OcclusionCuller&);
+
+    unsigned int _visibleQueryInterval;
+    Camera* _camera;
+    Mesh* _boxMesh;
+    Effect* _effect;
+    Uniform* _matrixUniform;
+    VertexAttributeBinding* _binding;
+    RenderState::StateBlock* _stateBlock;
+    std::map<Node*, Record> _records;
+    std::vector<Query> _queries;
+    std::vector<unsigned int> _freeQueries;
+    unsigned int _frame;
+    unsigned int _occludedCount;
+    unsigned int _queryCount;
+};
+
+}
+
+#endif
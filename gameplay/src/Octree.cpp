@@ -0,0 +1,345 @@
+#include "Base.h"
+#include "Octree.h"
+#include "Node.h"
+
+namespace gameplay
+{
+
+// Result of classifying a box against a frustum.
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_INTERSECTING 1
+#define FRUSTUM_INSIDE 2
+
+static int classify(const BoundingBox& box, const Frustum& frustum)
+{
+    const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(), &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+    int result = FRUSTUM_INSIDE;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        float side = box.intersects(*planes[i]);
+        if (side == Plane::INTERSECTS_BACK)
+            return FRUSTUM_OUTSIDE;
+        if (side == Plane::INTERSECTS_INTERSECTING)
+            result = FRUSTUM_INTERSECTING;
+    }
+    return result;
+}
+
+Octree::Cell::Cell(Octree* octree, Cell* parent, const Vector3& center, float halfSize)
+    : octree(octree), parent(parent), center(center), halfSize(halfSize), nodeCount(0)
+{
+    memset(children, 0, sizeof(children));
+
+    // Loose cells extend half their size past the region they partition on every side.
+    Vector3 extent(halfSize * 2.0f, halfSize * 2.0f, halfSize * 2.0f);
+    looseBounds.set(center - extent, center + extent);
+}
+
+Octree::Cell::~Cell()
+{
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        SAFE_DELETE(children[i]);
+    }
+}
+
+Octree::Octree(const BoundingBox& bounds, unsigned int maxDepth)
+    : _root(NULL), _bounds(bounds), _maxDepth(maxDepth)
+{
+    Vector3 center;
+    bounds.getCenter(&center);
+    float halfSize = std::max(std::max(bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y), bounds.max.z - bounds.min.z) * 0.5f;
+    _root = new Cell(this, NULL, center, halfSize);
+}
+
+Octree::~Octree()
+{
+    // Detach every node that is still stored in the octree.
+    std::vector<Cell*> cells;
+    cells.push_back(_root);
+    while (!cells.empty())
+    {
+        Cell* cell = cells.back();
+        cells.pop_back();
+        for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+        {
+            cell->nodes[i]->_octreeCell = NULL;
+            cell->nodes[i]->_octreeDirty = false;
+        }
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (cell->children[i])
+                cells.push_back(cell->children[i]);
+        }
+    }
+    SAFE_DELETE(_root);
+}
+
+unsigned int Octree::getNodeCount() const
+{
+    return _root->nodeCount;
+}
+
+const BoundingBox& Octree::getBounds() const
+{
+    return _bounds;
+}
+
+void Octree::insertTree(Node* node)
+{
+    GP_ASSERT(node);
+
+    insert(node);
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        insertTree(child);
+    }
+}
+
+void Octree::removeTree(Node* node)
+{
+    GP_ASSERT(node);
+
+    remove(node);
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        removeTree(child);
+    }
+}
+
+void Octree::setDirty(Node* node)
+{
+    GP_ASSERT(node && node->_octreeCell);
+
+    if (!node->_octreeDirty)
+    {
+        node->_octreeDirty = true;
+        _dirtyNodes.push_back(node);
+    }
+}
+
+void Octree::update()
+{
+    for (size_t i = 0, count = _dirtyNodes.size(); i < count; ++i)
+    {
+        Node* node = _dirtyNodes[i];
+        node->_octreeDirty = false;
+
+        Cell* cell = findCell(node->getBoundingSphere());
+        if (cell != node->_octreeCell)
+        {
+            remove(node);
+            insert(node);
+        }
+    }
+    _dirtyNodes.clear();
+}
+
+void Octree::insert(Node* node)
+{
+    if (node->_octreeCell)
+        return;
+
+    Cell* cell = findCell(node->getBoundingSphere());
+    node->_octreeCell = cell;
+    node->_octreeIndex = (unsigned int)cell->nodes.size();
+    cell->nodes.push_back(node);
+    for (Cell* c = cell; c != NULL; c = c->parent)
+    {
+        ++c->nodeCount;
+    }
+}
+
+void Octree::remove(Node* node)
+{
+    Cell* cell = node->_octreeCell;
+    if (cell == NULL)
+        return;
+
+    if (node->_octreeDirty)
+    {
+        std::vector<Node*>::iterator itr = std::find(_dirtyNodes.begin(), _dirtyNodes.end(), node);
+        if (itr != _dirtyNodes.end())
+            _dirtyNodes.erase(itr);
+        node->_octreeDirty = false;
+    }
+
+    // Swap the last node of the cell into the removed slot.
+    GP_ASSERT(cell->nodes[node->_octreeIndex] == node);
+    Node* last = cell->nodes.back();
+    cell->nodes[node->_octreeIndex] = last;
+    last->_octreeIndex = node->_octreeIndex;
+    cell->nodes.pop_back();
+
+    node->_octreeCell = NULL;
+    for (Cell* c = cell; c != NULL; c = c->parent)
+    {
+        --c->nodeCount;
+    }
+    pruneCell(cell);
+}
+
+Octree::Cell* Octree::findCell(const BoundingSphere& sphere)
+{
+    // Nodes that are not inside the partitioned region stay in the root.
+    const Vector3& p = sphere.center;
+    if (p.x < _bounds.min.x || p.y < _bounds.min.y || p.z < _bounds.min.z ||
+        p.x > _bounds.max.x || p.y > _bounds.max.y || p.z > _bounds.max.z)
+    {
+        return _root;
+    }
+
+    Cell* cell = _root;
+    for (unsigned int depth = 0; depth < _maxDepth; ++depth)
+    {
+        float childHalfSize = cell->halfSize * 0.5f;
+        if (sphere.radius > childHalfSize)
+            break;
+
+        unsigned int octant = (p.x >= cell->center.x ? 1 : 0) | (p.y >= cell->center.y ? 2 : 0) | (p.z >= cell->center.z ? 4 : 0);
+        if (cell->children[octant] == NULL)
+        {
+            Vector3 center(cell->center.x + ((octant & 1) ? childHalfSize : -childHalfSize),
+                           cell->center.y + ((octant & 2) ? childHalfSize : -childHalfSize),
+                           cell->center.z + ((octant & 4) ? childHalfSize : -childHalfSize));
+            cell->children[octant] = new Cell(this, cell, center, childHalfSize);
+        }
+        cell = cell->children[octant];
+    }
+    return cell;
+}
+
+void Octree::pruneCell(Cell* cell)
+{
+    // Delete empty leaf cells up to (but excluding) the root.
+    while (cell != _root && cell->nodeCount == 0)
+    {
+        Cell* parent = cell->parent;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (parent->children[i] == cell)
+            {
+                parent->children[i] = NULL;
+                break;
+            }
+        }
+        SAFE_DELETE(cell);
+        cell = parent;
+    }
+}
+
+void Octree::findNodes(const Frustum& frustum, std::vector<Node*>& nodes)
+{
+    update();
+
+    // The root holds the nodes outside the partitioned region, so it is never culled.
+    for (size_t i = 0, count = _root->nodes.size(); i < count; ++i)
+    {
+        Node* node = _root->nodes[i];
+        if (frustum.intersects(node->getBoundingSphere()))
+            nodes.push_back(node);
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (_root->children[i])
+            findNodes(_root->children[i], frustum, false, nodes);
+    }
+}
+
+void Octree::findNodes(Cell* cell, const Frustum& frustum, bool inside, std::vector<Node*>& nodes)
+{
+    if (!inside)
+    {
+        int result = classify(cell->looseBounds, frustum);
+        if (result == FRUSTUM_OUTSIDE)
+            return;
+        inside = (result == FRUSTUM_INSIDE);
+    }
+
+    for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+    {
+        Node* node = cell->nodes[i];
+        if (inside || frustum.intersects(node->getBoundingSphere()))
+            nodes.push_back(node);
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            findNodes(cell->children[i], frustum, inside, nodes);
+    }
+}
+
+void Octree::findNodes(const BoundingBox& box, std::vector<Node*>& nodes)
+{
+    update();
+
+    for (size_t i = 0, count = _root->nodes.size(); i < count; ++i)
+    {
+        Node* node = _root->nodes[i];
+        if (box.intersects(node->getBoundingSphere()))
+            nodes.push_back(node);
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (_root->children[i])
+            findNodes(_root->children[i], box, nodes);
+    }
+}
+
+void Octree::findNodes(Cell* cell, const BoundingBox& box, std::vector<Node*>& nodes)
+{
+    if (!box.intersects(cell->looseBounds))
+        return;
+
+    for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+    {
+        Node* node = cell->nodes[i];
+        if (box.intersects(node->getBoundingSphere()))
+            nodes.push_back(node);
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            findNodes(cell->children[i], box, nodes);
+    }
+}
+
+void Octree::findNodes(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits)
+{
+    update();
+
+    for (size_t i = 0, count = _root->nodes.size(); i < count; ++i)
+    {
+        Node* node = _root->nodes[i];
+        float distance = ray.intersects(node->getBoundingSphere());
+        if (distance != Ray::INTERSECTS_NONE && distance <= maxDistance)
+            hits.push_back(std::make_pair(distance, node));
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (_root->children[i])
+            findNodes(_root->children[i], ray, maxDistance, hits);
+    }
+}
+
+void Octree::findNodes(Cell* cell, const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits)
+{
+    float cellDistance = ray.intersects(cell->looseBounds);
+    if (cellDistance == Ray::INTERSECTS_NONE || cellDistance > maxDistance)
+        return;
+
+    for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+    {
+        Node* node = cell->nodes[i];
+        float distance = ray.intersects(node->getBoundingSphere());
+        if (distance != Ray::INTERSECTS_NONE && distance <= maxDistance)
+            hits.push_back(std::make_pair(distance, node));
+    }
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        if (cell->children[i])
+            findNodes(cell->children[i], ray, maxDistance, hits);
+    }
+}
+
+}
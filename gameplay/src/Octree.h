@@ -0,0 +1,136 @@
+#ifndef OCTREE_H_
+#define OCTREE_H_
+
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a loose octree used by a Scene to accelerate spatial queries on its nodes.
+ *
+ * Each node is stored in the deepest cell whose size can hold the node's
+ * bounding sphere, and cells are loose: their bounds are twice the size of
+ * the region they partition, so a node only has to lie in a cell by its center.
+ * Queries test whole cells first and skip every node in cells that fail.
+ *
+ * Nodes are re-inserted lazily: a transform or bounds change only marks the
+ * node as dirty, and dirty nodes are moved to their new cell before the next query.
+ *
+ * @script{ignore}
+ */
+class Octree
+{
+    friend class Node;
+    friend class Scene;
+
+public:
+
+    /**
+     * Defines a cell of the octree.
+     */
+    class Cell
+    {
+    public:
+
+        Cell(Octree* octree, Cell* parent, const Vector3& center, float halfSize);
+        ~Cell();
+
+        Octree* octree;
+        Cell* parent;
+        Cell* children[8];
+        Vector3 center;
+        float halfSize;
+        std::vector<Node*> nodes;
+        unsigned int nodeCount;     // Number of nodes in this cell and its children.
+        BoundingBox looseBounds;
+    };
+
+    /**
+     * Gets the number of nodes stored in the octree.
+     *
+     * @return The number of nodes.
+     */
+    unsigned int getNodeCount() const;
+
+    /**
+     * Gets the bounds of the region partitioned by the octree.
+     *
+     * Nodes outside the region are kept in the root cell.
+     *
+     * @return The bounds of the octree.
+     */
+    const BoundingBox& getBounds() const;
+
+private:
+
+    /**
+     * Constructor.
+     *
+     * @param bounds The region to partition.
+     * @param maxDepth The maximum depth of the tree.
+     */
+    Octree(const BoundingBox& bounds, unsigned int maxDepth);
+
+    /**
+     * Destructor. Detaches all nodes.
+     */
+    ~Octree();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Octree(const Octree& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Octree& operator=(const Octree&);
+
+    /**
+     * Inserts a node and all of its descendants.
+     */
+    void insertTree(Node* node);
+
+    /**
+     * Removes a node and all of its descendants.
+     */
+    void removeTree(Node* node);
+
+    /**
+     * Marks a node so that it is moved to its new cell before the next query.
+     */
+    void setDirty(Node* node);
+
+    /**
+     * Moves every dirty node to the cell matching its current bounds.
+     */
+    void update();
+
+    void findNodes(const Frustum& frustum, std::vector<Node*>& nodes);
+    void findNodes(const BoundingBox& box, std::vector<Node*>& nodes);
+    void findNodes(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits);
+
+    void insert(Node* node);
+    void remove(Node* node);
+    Cell* findCell(const BoundingSphere& sphere);
+    void pruneCell(Cell* cell);
+
+    static void findNodes(Cell* cell, const Frustum& frustum, bool inside, std::vector<Node*>& nodes);
+    static void findNodes(Cell* cell, const BoundingBox& box, std::vector<Node*>& nodes);
+    static void findNodes(Cell* cell, const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits);
+
+    Cell* _root;
+    BoundingBox _bounds;
+    unsigned int _maxDepth;
+    std::vector<Node*> _dirtyNodes;
+};
+
+}
+
+#endif
@@ -1,20 +1,200 @@
 #include "Base.h"
 #include "ParticleEmitter.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "Game.h"
 #include "Node.h"
 #include "Scene.h"
 #include "Quaternion.h"
 #include "Properties.h"
+#include "RenderStats.h"
+#include "ParticleManager.h"
+#include "MathUtilSIMD.h"
 
 #define PARTICLE_COUNT_MAX                       100
 #define PARTICLE_EMISSION_RATE                   10
 #define PARTICLE_EMISSION_RATE_TIME_INTERVAL     1000.0f / (float)PARTICLE_EMISSION_RATE
 
+// GPU simulation.
+#define PARTICLE_SIMULATE_VSH                    "res/shaders/particle-simulate.vert"
+#define PARTICLE_SIMULATE_FSH                    "res/shaders/particle-simulate.frag"
+#define PARTICLE_VSH                             "res/shaders/particle.vert"
+#define PARTICLE_FSH                             "res/shaders/sprite.frag"
+#define PARTICLE_GPU_FRAME_COUNT_MAX             64
+#define PARTICLE_GPU_STATE_SIZE                  12      // Floats per particle in the simulated buffers.
+#define PARTICLE_GPU_ATTRIBUTE_SIZE              16      // Floats per particle in the constant buffer.
+
+// The most sprites drawn in one batch, so that their indices fit in unsigned shorts.
+#define PARTICLE_SPRITE_BATCH_MAX                10240
+// The most sprites drawn in one batch on devices that support 32-bit indices.
+#define PARTICLE_SPRITE_BATCH_MAX_INDEX32        65536
+
+// The time step, in milliseconds, used to fast-forward particles that rotate about an axis.
+#define PARTICLE_CATCH_UP_STEP                   50.0f
+
 namespace gameplay
 {
 
+// The properties of the CPU particles, each stored in its own array.
+enum ParticleStream
+{
+    STREAM_POSITION_X,
+    STREAM_POSITION_Y,
+    STREAM_POSITION_Z,
+    STREAM_VELOCITY_X,
+    STREAM_VELOCITY_Y,
+    STREAM_VELOCITY_Z,
+    STREAM_ACCELERATION_X,
+    STREAM_ACCELERATION_Y,
+    STREAM_ACCELERATION_Z,
+    STREAM_COLOR_START_R,
+    STREAM_COLOR_START_G,
+    STREAM_COLOR_START_B,
+    STREAM_COLOR_START_A,
+    STREAM_COLOR_DELTA_R,       // End color minus start color.
+    STREAM_COLOR_DELTA_G,
+    STREAM_COLOR_DELTA_B,
+    STREAM_COLOR_DELTA_A,
+    STREAM_COLOR_R,
+    STREAM_COLOR_G,
+    STREAM_COLOR_B,
+    STREAM_COLOR_A,
+    STREAM_SIZE_START,
+    STREAM_SIZE_DELTA,          // End size minus start size.
+    STREAM_SIZE,
+    STREAM_ROTATION_AXIS_X,
+    STREAM_ROTATION_AXIS_Y,
+    STREAM_ROTATION_AXIS_Z,
+    STREAM_ROTATION_SPEED,
+    STREAM_ROTATION_PER_PARTICLE_SPEED,
+    STREAM_ANGLE,
+    STREAM_ENERGY,
+    STREAM_ENERGY_START_INVERSE,
+    STREAM_PERCENT,             // The fraction of its lifetime the particle has lived.
+    STREAM_TIME_ON_CURRENT_FRAME,
+    STREAM_COUNT
+};
+
+// dst[i] += value
+static void addScalar(float* dst, float value, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 v = FLOAT4_SET(value);
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(dst + i, FLOAT4_ADD(FLOAT4_LOAD(dst + i), v));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        dst[i] += value;
+    }
+}
+
+// dst[i] += src[i] * scale
+static void multiplyAdd(float* dst, const float* src, float scale, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 s = FLOAT4_SET(scale);
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(dst + i, FLOAT4_MADD(FLOAT4_LOAD(dst + i), FLOAT4_LOAD(src + i), s));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        dst[i] += src[i] * scale;
+    }
+}
+
+// dst[i] = start[i] + delta[i] * t[i]
+static void interpolate(float* dst, const float* start, const float* delta, const float* t, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(dst + i, FLOAT4_MADD(FLOAT4_LOAD(start + i), FLOAT4_LOAD(delta + i), FLOAT4_LOAD(t + i)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        dst[i] = start[i] + delta[i] * t[i];
+    }
+}
+
+// dst[i] = 1 - energy[i] * energyStartInverse[i]
+static void computePercent(float* dst, const float* energy, const float* energyStartInverse, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 one = FLOAT4_SET(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        FLOAT4_STORE(dst + i, FLOAT4_SUB(one, FLOAT4_MUL(FLOAT4_LOAD(energy + i), FLOAT4_LOAD(energyStartInverse + i))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        dst[i] = 1.0f - energy[i] * energyStartInverse[i];
+    }
+}
+
+// dst[i] = x[i] * v.x + y[i] * v.y + z[i] * v.z + offset
+static void dotProduct(float* dst, const float* x, const float* y, const float* z, const Vector3& v, float offset, unsigned int count)
+{
+    unsigned int i = 0;
+#ifdef GP_SIMD
+    float4 vx = FLOAT4_SET(v.x);
+    float4 vy = FLOAT4_SET(v.y);
+    float4 vz = FLOAT4_SET(v.z);
+    float4 o = FLOAT4_SET(offset);
+    for (; i + 4 <= count; i += 4)
+    {
+        float4 d = FLOAT4_MADD(o, FLOAT4_LOAD(x + i), vx);
+        d = FLOAT4_MADD(d, FLOAT4_LOAD(y + i), vy);
+        FLOAT4_STORE(dst + i, FLOAT4_MADD(d, FLOAT4_LOAD(z + i), vz));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        dst[i] = x[i] * v.x + y[i] * v.y + z[i] * v.z + offset;
+    }
+}
+
+/**
+ * The GPU buffers of an emitter simulated with transform feedback.
+ *
+ * The simulated state (position and energy, velocity and angle, acceleration and
+ * initial frame) is ping-ponged between two buffers; the properties that never
+ * change after emission (colors, rotation axis and speed, sizes and start energy)
+ * live in a third buffer. Particles are emitted into a ring of slots.
+ */
+struct ParticleEmitter::GpuSimulation
+{
+    GLuint stateBuffers[2];
+    GLuint attributeBuffer;
+    unsigned int current;               // The state buffer holding the current particles.
+    unsigned int nextSlot;              // The slot the next particle is emitted into.
+    double time;                        // Time simulated so far, in milliseconds.
+    double activeUntil;                 // The time at which the last emitted particle dies.
+    std::vector<double> expiry;         // The time at which the particle in each slot dies.
+    std::vector<float> stateData;       // Staging memory for emitted particles.
+    std::vector<float> attributeData;
+};
+
+// Resources shared by all GPU simulated emitters.
+static unsigned int __gpuEmitterCount = 0;
+static Effect* __simulateEffect = NULL;
+static Effect* __particleEffect = NULL;
+static GLuint __cornerBuffer = 0;
+
 ParticleEmitter::ParticleEmitter(SpriteBatch* batch, unsigned int particleCountMax) :
-    _particleCountMax(particleCountMax), _particleCount(0), _particles(NULL),
+    _particleCountMax(particleCountMax), _particleCount(0),
+    _particleMemory(NULL), _particleMemorySize(0), _particleStreams(NULL), _particleStride(0), _particleFrames(NULL), _particleOrder(NULL), _particleVisible(NULL),
+    _particleVisibleCount(0), _particleBudget(particleCountMax), _priority(1.0f),
     _emissionRate(PARTICLE_EMISSION_RATE), _started(false), _ellipsoid(false),
     _sizeStartMin(1.0f), _sizeStartMax(1.0f), _sizeEndMin(1.0f), _sizeEndMax(1.0f),
     _energyMin(1000L), _energyMax(1000L),
@@ -28,10 +208,19 @@ ParticleEmitter::ParticleEmitter(SpriteBatch* batch, unsigned int particleCountM
     _spriteBatch(batch), _spriteTextureBlending(BLEND_TRANSPARENT),  _spriteTextureWidth(0), _spriteTextureHeight(0), _spriteTextureWidthRatio(0), _spriteTextureHeightRatio(0), _spriteTextureCoords(NULL),
     _spriteAnimated(false),  _spriteLooped(false), _spriteFrameCount(1), _spriteFrameRandomOffset(0),_spriteFrameDuration(0L), _spriteFrameDurationSecs(0.0f), _spritePercentPerFrame(0.0f),
     _node(NULL), _orbitPosition(false), _orbitVelocity(false), _orbitAcceleration(false),
-    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _timeRunning(0)
+    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _timeRunning(0), _gpu(NULL),
+    _culling(true), _skippedTime(0.0), _boundsMaxSpeed(0.0f), _boundsMaxAcceleration(0.0f), _boundsMaxSize(0.0f),
+    _sorted(false), _particleRevision(0), _particleDrift(0.0)
 {
     GP_ASSERT(particleCountMax);
-    _particles = new Particle[particleCountMax];
+    _particleStride = (particleCountMax + 3) & ~3;
+    _particleMemorySize = (_particleStride * STREAM_COUNT * sizeof(float)) + (2 * particleCountMax * sizeof(unsigned int)) + (particleCountMax * sizeof(bool));
+    _sort.valid = false;
+    _sceneSort.valid = false;
+
+    ParticleManager* manager = Game::getInstance() ? Game::getInstance()->getParticleManager() : NULL;
+    if (manager)
+        manager->addEmitter(this);
 
     GP_ASSERT(_spriteBatch);
     GP_ASSERT(_spriteBatch->getStateBlock());
@@ -41,8 +230,12 @@ ParticleEmitter::ParticleEmitter(SpriteBatch* batch, unsigned int particleCountM
 
 ParticleEmitter::~ParticleEmitter()
 {
+    setSimulationMode(SIMULATION_CPU);
     SAFE_DELETE(_spriteBatch);
-    SAFE_DELETE_ARRAY(_particles);
+    releaseParticleMemory();
+    ParticleManager* manager = Game::getInstance() ? Game::getInstance()->getParticleManager() : NULL;
+    if (manager)
+        manager->removeEmitter(this);
     SAFE_DELETE_ARRAY(_spriteTextureCoords);
 }
 
@@ -182,6 +375,7 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
     bool orbitPosition = properties->getBool("orbitPosition");
     bool orbitVelocity = properties->getBool("orbitVelocity");
     bool orbitAcceleration = properties->getBool("orbitAcceleration");
+    const char* simulation = properties->getString("simulation");
 
     // Apply all properties to a newly created ParticleEmitter.
     ParticleEmitter* emitter = ParticleEmitter::create(texturePath.c_str(), textureBlending, particleCountMax);
@@ -209,6 +403,17 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
 
     emitter->setOrbit(orbitPosition, orbitVelocity, orbitAcceleration);
 
+    if (simulation && strcmp(simulation, "GPU") == 0)
+        emitter->setSimulationMode(SIMULATION_GPU);
+
+    if (properties->exists("priority"))
+        emitter->setPriority(properties->getFloat("priority"));
+
+    if (properties->exists("culling"))
+        emitter->setCulling(properties->getBool("culling"));
+
+    emitter->setSorted(properties->getBool("sorted"));
+
     return emitter;
 }
 
@@ -247,11 +452,17 @@ bool ParticleEmitter::isActive() const
     if (!_node)
         return false;
 
-    GP_ASSERT(_particles);
+    if (_gpu)
+        return _gpu->activeUntil > _gpu->time;
+
+    if (_particleStreams == NULL)
+        return false;
+
+    const float* energy = getParticleStream(STREAM_ENERGY);
     bool active = false;
     for (unsigned int i = 0; i < _particleCount; i++)
     {
-        if (_particles[i]._energy > 0)
+        if (energy[i] > 0.0f)
         {
             active = true;
             break;
@@ -261,92 +472,278 @@ bool ParticleEmitter::isActive() const
     return active;
 }
 
+void ParticleEmitter::getEmissionTransform(Matrix* world, Vector3* translation) const
+{
+    GP_ASSERT(_node);
+    GP_ASSERT(world);
+    GP_ASSERT(translation);
+
+    world->set(_node->getWorldMatrix());
+    world->getTranslation(translation);
+
+    // Take translation out of world matrix so it can be used to rotate orbiting properties.
+    world->m[12] = 0.0f;
+    world->m[13] = 0.0f;
+    world->m[14] = 0.0f;
+}
+
 void ParticleEmitter::emitOnce(unsigned int particleCount)
 {
     GP_ASSERT(_node);
-    GP_ASSERT(_particles);
 
-    // Limit particleCount so as not to go over _particleCountMax.
-    if (particleCount + _particleCount > _particleCountMax)
+    Matrix world;
+    Vector3 translation;
+    getEmissionTransform(&world, &translation);
+
+    if (_gpu)
     {
-        particleCount = _particleCountMax - _particleCount;
+        // GPU emitters culled by the particle manager stop emitting too.
+        if (_particleBudget > 0)
+            emitGpu(particleCount, world, translation);
+        return;
     }
 
-    Vector3 translation;
-    Matrix world = _node->getWorldMatrix();
-    world.getTranslation(&translation);
+    // Limit particleCount so as not to go over _particleCountMax, or the budget given by the particle manager.
+    unsigned int particleCountMax = std::min(_particleCountMax, _particleBudget);
+    if (_particleCount >= particleCountMax || particleCount == 0)
+        return;
+    if (particleCount + _particleCount > particleCountMax)
+    {
+        particleCount = particleCountMax - _particleCount;
+    }
 
-    // Take translation out of world matrix so it can be used to rotate orbiting properties.
-    world.m[12] = 0.0f;
-    world.m[13] = 0.0f;
-    world.m[14] = 0.0f;
+    if (_particleStreams == NULL && !acquireParticleMemory())
+        return;
 
     // Emit the new particles.
+    Particle p;
     for (unsigned int i = 0; i < particleCount; i++)
     {
-        Particle* p = &_particles[_particleCount];
-        p->_visible = true;
-
-        generateColor(_colorStart, _colorStartVar, &p->_colorStart);
-        generateColor(_colorEnd, _colorEndVar, &p->_colorEnd);
-        p->_color.set(p->_colorStart);
-
-        p->_energy = p->_energyStart = generateScalar(_energyMin, _energyMax);
-        p->_size = p->_sizeStart = generateScalar(_sizeStartMin, _sizeStartMax);
-        p->_sizeEnd = generateScalar(_sizeEndMin, _sizeEndMax);
-        p->_rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
-        p->_angle = generateScalar(0.0f, p->_rotationPerParticleSpeed);
-        p->_rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
-
-        // Only initial position can be generated within an ellipsoidal domain.
-        generateVector(_position, _positionVar, &p->_position, _ellipsoid);
-        generateVector(_velocity, _velocityVar, &p->_velocity, false);
-        generateVector(_acceleration, _accelerationVar, &p->_acceleration, false);
-        generateVector(_rotationAxis, _rotationAxisVar, &p->_rotationAxis, false);
-
-        // Initial position, velocity and acceleration can all be relative to the emitter's transform.
-        // Rotate specified properties by the node's rotation.
-        if (_orbitPosition)
-        {
-            world.transformPoint(p->_position, &p->_position);
-        }
+        initializeParticle(&p, world, translation);
+        storeParticle(&p, _particleCount);
+        ++_particleCount;
+    }
+}
 
-        if (_orbitVelocity)
-        {
-            world.transformPoint(p->_velocity, &p->_velocity);
-        }
+void ParticleEmitter::initializeParticle(Particle* p, const Matrix& world, const Vector3& translation)
+{
+    p->_visible = true;
 
-        if (_orbitAcceleration)
-        {
-            world.transformPoint(p->_acceleration, &p->_acceleration);
-        }
+    generateColor(_colorStart, _colorStartVar, &p->_colorStart);
+    generateColor(_colorEnd, _colorEndVar, &p->_colorEnd);
+    p->_color.set(p->_colorStart);
 
-        // The rotation axis always orbits the node.
-        if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
-        {
-            world.transformPoint(p->_rotationAxis, &p->_rotationAxis);
-        }
+    p->_energy = p->_energyStart = generateScalar(_energyMin, _energyMax);
+    p->_size = p->_sizeStart = generateScalar(_sizeStartMin, _sizeStartMax);
+    p->_sizeEnd = generateScalar(_sizeEndMin, _sizeEndMax);
+    p->_rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
+    p->_angle = generateScalar(0.0f, p->_rotationPerParticleSpeed);
+    p->_rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
 
-        // Translate position relative to the node's world space.
-        p->_position.add(translation);
+    // Only initial position can be generated within an ellipsoidal domain.
+    generateVector(_position, _positionVar, &p->_position, _ellipsoid);
+    generateVector(_velocity, _velocityVar, &p->_velocity, false);
+    generateVector(_acceleration, _accelerationVar, &p->_acceleration, false);
+    generateVector(_rotationAxis, _rotationAxisVar, &p->_rotationAxis, false);
 
-        // Initial sprite frame.
-        if (_spriteFrameRandomOffset > 0)
-        {
-            p->_frame = rand() % _spriteFrameRandomOffset;
-        }
-        else
+    // Initial position, velocity and acceleration can all be relative to the emitter's transform.
+    // Rotate specified properties by the node's rotation.
+    if (_orbitPosition)
+    {
+        world.transformPoint(p->_position, &p->_position);
+    }
+
+    if (_orbitVelocity)
+    {
+        world.transformPoint(p->_velocity, &p->_velocity);
+    }
+
+    if (_orbitAcceleration)
+    {
+        world.transformPoint(p->_acceleration, &p->_acceleration);
+    }
+
+    // The rotation axis always orbits the node.
+    if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
+    {
+        world.transformPoint(p->_rotationAxis, &p->_rotationAxis);
+    }
+
+    // Translate position relative to the node's world space.
+    p->_position.add(translation);
+
+    // Initial sprite frame.
+    if (_spriteFrameRandomOffset > 0)
+    {
+        p->_frame = rand() % _spriteFrameRandomOffset;
+    }
+    else
+    {
+        p->_frame = 0;
+    }
+    p->_timeOnCurrentFrame = 0.0f;
+}
+
+bool ParticleEmitter::acquireParticleMemory()
+{
+    GP_ASSERT(_particleMemory == NULL);
+
+    ParticleManager* manager = Game::getInstance() ? Game::getInstance()->getParticleManager() : NULL;
+    _particleMemory = manager ? manager->acquireMemory(_particleMemorySize) : new unsigned char[_particleMemorySize];
+    if (_particleMemory == NULL)
+        return false;
+
+    // The streams come first so that they stay aligned to the block.
+    _particleStreams = (float*)_particleMemory;
+    _particleFrames = (unsigned int*)(_particleStreams + _particleStride * STREAM_COUNT);
+    _particleOrder = _particleFrames + _particleCountMax;
+    _particleVisible = (bool*)(_particleOrder + _particleCountMax);
+    return true;
+}
+
+void ParticleEmitter::releaseParticleMemory()
+{
+    if (_particleMemory == NULL)
+        return;
+
+    ParticleManager* manager = Game::getInstance() ? Game::getInstance()->getParticleManager() : NULL;
+    if (manager)
+    {
+        manager->releaseMemory(_particleMemory, _particleMemorySize);
+        _particleMemory = NULL;
+    }
+    else
+    {
+        SAFE_DELETE_ARRAY(_particleMemory);
+    }
+    _particleStreams = NULL;
+    _particleFrames = NULL;
+    _particleOrder = NULL;
+    _particleVisible = NULL;
+    _particleCount = 0;
+    _particleVisibleCount = 0;
+    ++_particleRevision;
+}
+
+unsigned int ParticleEmitter::getParticleDemand() const
+{
+    // Emitters that are emitted manually may burst up to their maximum at any time.
+    if (!_started || _emissionRate == 0)
+        return _particleCountMax;
+
+    unsigned int demand = (unsigned int)(_emissionRate * _energyMax * 0.001f) + 1;
+    return std::min(_particleCountMax, std::max(demand, _particleCount));
+}
+
+void ParticleEmitter::setPriority(float priority)
+{
+    _priority = std::max(0.0f, priority);
+}
+
+float ParticleEmitter::getPriority() const
+{
+    return _priority;
+}
+
+float* ParticleEmitter::getParticleStream(unsigned int stream) const
+{
+    GP_ASSERT(stream < STREAM_COUNT);
+    return _particleStreams + stream * _particleStride;
+}
+
+void ParticleEmitter::storeParticle(const Particle* p, unsigned int index)
+{
+    GP_ASSERT(p);
+    GP_ASSERT(index < _particleCountMax);
+
+    float* s = _particleStreams + index;
+    const unsigned int stride = _particleStride;
+    s[STREAM_POSITION_X * stride] = p->_position.x;
+    s[STREAM_POSITION_Y * stride] = p->_position.y;
+    s[STREAM_POSITION_Z * stride] = p->_position.z;
+    s[STREAM_VELOCITY_X * stride] = p->_velocity.x;
+    s[STREAM_VELOCITY_Y * stride] = p->_velocity.y;
+    s[STREAM_VELOCITY_Z * stride] = p->_velocity.z;
+    s[STREAM_ACCELERATION_X * stride] = p->_acceleration.x;
+    s[STREAM_ACCELERATION_Y * stride] = p->_acceleration.y;
+    s[STREAM_ACCELERATION_Z * stride] = p->_acceleration.z;
+    s[STREAM_COLOR_START_R * stride] = p->_colorStart.x;
+    s[STREAM_COLOR_START_G * stride] = p->_colorStart.y;
+    s[STREAM_COLOR_START_B * stride] = p->_colorStart.z;
+    s[STREAM_COLOR_START_A * stride] = p->_colorStart.w;
+    s[STREAM_COLOR_DELTA_R * stride] = p->_colorEnd.x - p->_colorStart.x;
+    s[STREAM_COLOR_DELTA_G * stride] = p->_colorEnd.y - p->_colorStart.y;
+    s[STREAM_COLOR_DELTA_B * stride] = p->_colorEnd.z - p->_colorStart.z;
+    s[STREAM_COLOR_DELTA_A * stride] = p->_colorEnd.w - p->_colorStart.w;
+    s[STREAM_COLOR_R * stride] = p->_color.x;
+    s[STREAM_COLOR_G * stride] = p->_color.y;
+    s[STREAM_COLOR_B * stride] = p->_color.z;
+    s[STREAM_COLOR_A * stride] = p->_color.w;
+    s[STREAM_SIZE_START * stride] = p->_sizeStart;
+    s[STREAM_SIZE_DELTA * stride] = p->_sizeEnd - p->_sizeStart;
+    s[STREAM_SIZE * stride] = p->_size;
+    s[STREAM_ROTATION_AXIS_X * stride] = p->_rotationAxis.x;
+    s[STREAM_ROTATION_AXIS_Y * stride] = p->_rotationAxis.y;
+    s[STREAM_ROTATION_AXIS_Z * stride] = p->_rotationAxis.z;
+    s[STREAM_ROTATION_SPEED * stride] = p->_rotationSpeed;
+    s[STREAM_ROTATION_PER_PARTICLE_SPEED * stride] = p->_rotationPerParticleSpeed;
+    s[STREAM_ANGLE * stride] = p->_angle;
+    s[STREAM_ENERGY * stride] = (float)p->_energy;
+    s[STREAM_ENERGY_START_INVERSE * stride] = p->_energyStart > 0L ? 1.0f / (float)p->_energyStart : 0.0f;
+    s[STREAM_PERCENT * stride] = 0.0f;
+    s[STREAM_TIME_ON_CURRENT_FRAME * stride] = p->_timeOnCurrentFrame;
+    _particleFrames[index] = p->_frame;
+    _particleVisible[index] = p->_visible;
+    ++_particleRevision;
+
+    // Particles emitted outside of update() must count for culling before the next simulated frame.
+    if (index == 0)
+    {
+        _bounds.set(p->_position, p->_position);
+        _boundsMaxSpeed = 0.0f;
+        _boundsMaxAcceleration = 0.0f;
+        _boundsMaxSize = 0.0f;
+    }
+    else
+    {
+        _bounds.merge(BoundingBox(p->_position, p->_position));
+    }
+    _boundsMaxSpeed = std::max(_boundsMaxSpeed, p->_velocity.length());
+    _boundsMaxAcceleration = std::max(_boundsMaxAcceleration, p->_acceleration.length());
+    _boundsMaxSize = std::max(_boundsMaxSize, std::max(p->_sizeStart, p->_sizeEnd));
+}
+
+void ParticleEmitter::removeParticle(unsigned int index)
+{
+    GP_ASSERT(index < _particleCount);
+
+    unsigned int last = _particleCount - 1;
+    if (index != last)
+    {
+        for (unsigned int stream = 0; stream < STREAM_COUNT; ++stream)
         {
-            p->_frame = 0;
+            float* s = _particleStreams + stream * _particleStride;
+            s[index] = s[last];
         }
-        p->_timeOnCurrentFrame = 0.0f;
-
-        ++_particleCount;
+        _particleFrames[index] = _particleFrames[last];
+        _particleVisible[index] = _particleVisible[last];
     }
+    --_particleCount;
+    ++_particleRevision;
 }
 
 unsigned int ParticleEmitter::getParticlesCount() const
 {
+    if (_gpu)
+    {
+        unsigned int count = 0;
+        for (size_t i = 0, size = _gpu->expiry.size(); i < size; ++i)
+        {
+            if (_gpu->expiry[i] > _gpu->time)
+                ++count;
+        }
+        return count;
+    }
     return _particleCount;
 }
 
@@ -799,6 +1196,21 @@ void ParticleEmitter::update(float elapsedTime)
     // Calculate the time passed since last update.
     float elapsedSecs = elapsedTime * 0.001f;
 
+    if (_gpu == NULL)
+    {
+        // Emitters whose particles cannot reach the view are not simulated; they catch up once they can.
+        if (isCulled(elapsedTime))
+        {
+            _skippedTime += elapsedTime;
+            _particleVisibleCount = 0;
+            return;
+        }
+        if (_skippedTime > 0.0)
+        {
+            catchUp();
+        }
+    }
+
     if (_started && _emissionRate)
     {
         // Calculate how much time has passed since we last emitted particles.
@@ -818,99 +1230,393 @@ void ParticleEmitter::update(float elapsedTime)
         }
     }
 
-    GP_ASSERT(_node && _node->getScene() && _node->getScene()->getActiveCamera());
-    const Frustum& frustum = _node->getScene()->getActiveCamera()->getFrustum();
-
-    // Now update all currently living particles.
-    GP_ASSERT(_particles);
-    for (unsigned int particlesIndex = 0; particlesIndex < _particleCount; ++particlesIndex)
+    if (_gpu)
     {
-        Particle* p = &_particles[particlesIndex];
-        p->_energy -= elapsedTime;
+        updateGpu(elapsedTime);
+        return;
+    }
+
+    // Without a camera every particle is treated as visible.
+    Camera* camera = (_node && _node->getScene()) ? _node->getScene()->getActiveCamera() : NULL;
+    const Frustum* frustum = camera ? &camera->getFrustum() : NULL;
 
-        if (p->_energy > 0L)
+    // Now update all currently living particles, one property at a time.
+    if (_particleStreams == NULL)
+        return;
+    const unsigned int count = _particleCount;
+    float* px = getParticleStream(STREAM_POSITION_X);
+    float* py = getParticleStream(STREAM_POSITION_Y);
+    float* pz = getParticleStream(STREAM_POSITION_Z);
+    float* vx = getParticleStream(STREAM_VELOCITY_X);
+    float* vy = getParticleStream(STREAM_VELOCITY_Y);
+    float* vz = getParticleStream(STREAM_VELOCITY_Z);
+    float* ax = getParticleStream(STREAM_ACCELERATION_X);
+    float* ay = getParticleStream(STREAM_ACCELERATION_Y);
+    float* az = getParticleStream(STREAM_ACCELERATION_Z);
+    float* energy = getParticleStream(STREAM_ENERGY);
+    float* percent = getParticleStream(STREAM_PERCENT);
+    float* timeOnCurrentFrame = getParticleStream(STREAM_TIME_ON_CURRENT_FRAME);
+
+    addScalar(energy, -elapsedTime, count);
+
+    // Velocity and acceleration rotate about each particle's axis.
+    const float* rotationSpeed = getParticleStream(STREAM_ROTATION_SPEED);
+    const float* rotationAxisX = getParticleStream(STREAM_ROTATION_AXIS_X);
+    const float* rotationAxisY = getParticleStream(STREAM_ROTATION_AXIS_Y);
+    const float* rotationAxisZ = getParticleStream(STREAM_ROTATION_AXIS_Z);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (rotationSpeed[i] != 0.0f && energy[i] > 0.0f)
         {
-            if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
+            Vector3 axis(rotationAxisX[i], rotationAxisY[i], rotationAxisZ[i]);
+            if (!axis.isZero())
             {
-                Matrix::createRotation(p->_rotationAxis, p->_rotationSpeed * elapsedSecs, &_rotation);
-
-                _rotation.transformPoint(p->_velocity, &p->_velocity);
-                _rotation.transformPoint(p->_acceleration, &p->_acceleration);
-            }
-
-            // Particle is still alive.
-            p->_velocity.x += p->_acceleration.x * elapsedSecs;
-            p->_velocity.y += p->_acceleration.y * elapsedSecs;
-            p->_velocity.z += p->_acceleration.z * elapsedSecs;
+                Matrix::createRotation(axis, rotationSpeed[i] * elapsedSecs, &_rotation);
 
-            p->_position.x += p->_velocity.x * elapsedSecs;
-            p->_position.y += p->_velocity.y * elapsedSecs;
-            p->_position.z += p->_velocity.z * elapsedSecs;
+                Vector3 v(vx[i], vy[i], vz[i]);
+                _rotation.transformPoint(&v);
+                vx[i] = v.x; vy[i] = v.y; vz[i] = v.z;
 
-            if (!frustum.intersects(p->_position))
-            {
-                p->_visible = false;
-                continue;
+                Vector3 a(ax[i], ay[i], az[i]);
+                _rotation.transformPoint(&a);
+                ax[i] = a.x; ay[i] = a.y; az[i] = a.z;
             }
+        }
+    }
 
-            p->_angle += p->_rotationPerParticleSpeed * elapsedSecs;
+    multiplyAdd(vx, ax, elapsedSecs, count);
+    multiplyAdd(vy, ay, elapsedSecs, count);
+    multiplyAdd(vz, az, elapsedSecs, count);
 
-            // Simple linear interpolation of color and size.
-            float percent = 1.0f - ((float)p->_energy / (float)p->_energyStart);
+    multiplyAdd(px, vx, elapsedSecs, count);
+    multiplyAdd(py, vy, elapsedSecs, count);
+    multiplyAdd(pz, vz, elapsedSecs, count);
 
-            p->_color.x = p->_colorStart.x + (p->_colorEnd.x - p->_colorStart.x) * percent;
-            p->_color.y = p->_colorStart.y + (p->_colorEnd.y - p->_colorStart.y) * percent;
-            p->_color.z = p->_colorStart.z + (p->_colorEnd.z - p->_colorStart.z) * percent;
-            p->_color.w = p->_colorStart.w + (p->_colorEnd.w - p->_colorStart.w) * percent;
+    multiplyAdd(getParticleStream(STREAM_ANGLE), getParticleStream(STREAM_ROTATION_PER_PARTICLE_SPEED), elapsedSecs, count);
 
-            p->_size = p->_sizeStart + (p->_sizeEnd - p->_sizeStart) * percent;
+    // Simple linear interpolation of color and size.
+    computePercent(percent, energy, getParticleStream(STREAM_ENERGY_START_INVERSE), count);
+    for (unsigned int c = 0; c < 4; ++c)
+    {
+        interpolate(getParticleStream(STREAM_COLOR_R + c), getParticleStream(STREAM_COLOR_START_R + c), getParticleStream(STREAM_COLOR_DELTA_R + c), percent, count);
+    }
+    interpolate(getParticleStream(STREAM_SIZE), getParticleStream(STREAM_SIZE_START), getParticleStream(STREAM_SIZE_DELTA), percent, count);
+
+    const float* size = getParticleStream(STREAM_SIZE);
+    _particleVisibleCount = 0;
+    _bounds.set(Vector3(FLT_MAX, FLT_MAX, FLT_MAX), Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+    float maxSpeedSq = 0.0f;
+    float maxAccelerationSq = 0.0f;
+    _boundsMaxSize = 0.0f;
+    unsigned int i = 0;
+    while (i < _particleCount)
+    {
+        if (energy[i] <= 0.0f)
+        {
+            // Particle is dead. The last living particle, which has already been updated, takes its slot.
+            removeParticle(i);
+            continue;
+        }
 
-            // Handle sprite animations.
-            if (_spriteAnimated)
+        // Gather the bounds that decide whether the emitter is simulated next frame.
+        _bounds.min.x = std::min(_bounds.min.x, px[i]);
+        _bounds.min.y = std::min(_bounds.min.y, py[i]);
+        _bounds.min.z = std::min(_bounds.min.z, pz[i]);
+        _bounds.max.x = std::max(_bounds.max.x, px[i]);
+        _bounds.max.y = std::max(_bounds.max.y, py[i]);
+        _bounds.max.z = std::max(_bounds.max.z, pz[i]);
+        maxSpeedSq = std::max(maxSpeedSq, vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+        maxAccelerationSq = std::max(maxAccelerationSq, ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        _boundsMaxSize = std::max(_boundsMaxSize, size[i]);
+
+        _particleVisible[i] = frustum == NULL || frustum->intersects(Vector3(px[i], py[i], pz[i]));
+        if (_particleVisible[i])
+            ++_particleVisibleCount;
+
+        // Handle sprite animations.
+        if (_particleVisible[i] && _spriteAnimated)
+        {
+            unsigned int& frame = _particleFrames[i];
+            if (!_spriteLooped)
             {
-                if (!_spriteLooped)
+                // The last frame should finish exactly when the particle dies.
+                timeOnCurrentFrame[i] = percent[i] - (float)frame * _spritePercentPerFrame;
+                if (frame < _spriteFrameCount - 1 &&
+                    timeOnCurrentFrame[i] >= _spritePercentPerFrame)
                 {
-                    // The last frame should finish exactly when the particle dies.
-                    float percentSpent = 0.0f;
-                    for (unsigned int i = 0; i < p->_frame; i++)
-                    {
-                        percentSpent += _spritePercentPerFrame;
-                    }
-                    p->_timeOnCurrentFrame = percent - percentSpent;
-                    if (p->_frame < _spriteFrameCount - 1 &&
-                        p->_timeOnCurrentFrame >= _spritePercentPerFrame)
-                    {
-                        ++p->_frame;
-                    }
+                    ++frame;
                 }
-                else
+            }
+            else
+            {
+                // _spriteFrameDurationSecs is an absolute time measured in seconds,
+                // and the animation repeats indefinitely.
+                timeOnCurrentFrame[i] += elapsedSecs;
+                if (timeOnCurrentFrame[i] >= _spriteFrameDurationSecs)
                 {
-                    // _spriteFrameDurationSecs is an absolute time measured in seconds,
-                    // and the animation repeats indefinitely.
-                    p->_timeOnCurrentFrame += elapsedSecs;
-                    if (p->_timeOnCurrentFrame >= _spriteFrameDurationSecs)
+                    timeOnCurrentFrame[i] -= _spriteFrameDurationSecs;
+                    ++frame;
+                    if (frame == _spriteFrameCount)
                     {
-                        p->_timeOnCurrentFrame -= _spriteFrameDurationSecs;
-                        ++p->_frame;
-                        if (p->_frame == _spriteFrameCount)
-                        {
-                            p->_frame = 0;
-                        }
+                        frame = 0;
                     }
                 }
             }
         }
+        ++i;
+    }
+    _boundsMaxSpeed = sqrt(maxSpeedSq);
+    _boundsMaxAcceleration = sqrt(maxAccelerationSq);
+
+    // The positions were advanced by the new velocities, so no particle moved farther than this.
+    _particleDrift += _boundsMaxSpeed * elapsedSecs;
+}
+
+bool ParticleEmitter::isCulled(float elapsedTime) const
+{
+    if (!_culling || _node == NULL || _node->getScene() == NULL)
+        return false;
+    Camera* camera = _node->getScene()->getActiveCamera();
+    if (camera == NULL)
+        return false;
+
+    // Start from the living particles and the region new particles are emitted in.
+    BoundingBox bounds;
+    bool hasBounds = _particleCount > 0;
+    float maxSpeed = 0.0f;
+    float maxAcceleration = 0.0f;
+    float maxSize = 0.0f;
+    if (_particleCount > 0)
+    {
+        bounds = _bounds;
+        maxSpeed = _boundsMaxSpeed;
+        maxAcceleration = _boundsMaxAcceleration;
+        maxSize = _boundsMaxSize;
+    }
+    if (_started && _emissionRate)
+    {
+        Vector3 scale;
+        _node->getWorldMatrix().getScale(&scale);
+        float maxScale = std::max(1.0f, std::max(std::max(fabs(scale.x), fabs(scale.y)), fabs(scale.z)));
+        float radius = (_position.length() + _positionVar.length()) * maxScale;
+        Vector3 center = _node->getTranslationWorld();
+        BoundingBox emission(center - Vector3(radius, radius, radius), center + Vector3(radius, radius, radius));
+        if (hasBounds)
+            bounds.merge(emission);
         else
+            bounds = emission;
+        hasBounds = true;
+
+        maxSpeed = std::max(maxSpeed, (_velocity.length() + _velocityVar.length()) * maxScale);
+        maxAcceleration = std::max(maxAcceleration, (_acceleration.length() + _accelerationVar.length()) * maxScale);
+        maxSize = std::max(maxSize, std::max(_sizeStartMax, _sizeEndMax));
+    }
+    if (!hasBounds)
+        return false;
+
+    // Grow the bounds by the farthest any particle can travel until now. No particle
+    // lives longer than the maximum energy, so older particles are already dead.
+    float t = (float)std::min(_skippedTime + elapsedTime, (double)_energyMax) * 0.001f;
+    float growth = maxSpeed * t + 0.5f * maxAcceleration * t * t + maxSize * 0.5f;
+    bounds.min -= Vector3(growth, growth, growth);
+    bounds.max += Vector3(growth, growth, growth);
+
+    return !camera->getFrustum().intersects(bounds);
+}
+
+void ParticleEmitter::catchUp()
+{
+    GP_ASSERT(_node);
+
+    float skippedTime = (float)_skippedTime;
+    _skippedTime = 0.0;
+    ++_particleRevision;
+
+    // Age the living particles by the time they were not simulated.
+    for (unsigned int i = 0; i < _particleCount; ++i)
+    {
+        fastForwardParticle(i, skippedTime);
+    }
+
+    if (!_started || _emissionRate == 0)
+        return;
+
+    // Only the particles emitted within the maximum energy of now can still be alive,
+    // so at most that many are emitted, youngest first, and aged to where they would be.
+    GP_ASSERT(_timePerEmission);
+    _timeRunning += skippedTime;
+    double span = std::min(_timeRunning, (double)_energyMax);
+    unsigned int emitCount = (unsigned int)(span / _timePerEmission);
+    if ((int)_timePerEmission > 0)
+    {
+        _timeRunning = fmod(_timeRunning, (double)_timePerEmission);
+    }
+
+    unsigned int particleCountMax = std::min(_particleCountMax, _particleBudget);
+    if (emitCount == 0 || _particleCount >= particleCountMax)
+        return;
+    if (_particleStreams == NULL && !acquireParticleMemory())
+        return;
+
+    Matrix world;
+    Vector3 translation;
+    getEmissionTransform(&world, &translation);
+
+    Particle p;
+    for (unsigned int i = 0; i < emitCount && _particleCount < particleCountMax; ++i)
+    {
+        float age = (float)_timeRunning + (float)i * _timePerEmission;
+        initializeParticle(&p, world, translation);
+        if ((float)p._energy <= age)
+            continue;
+
+        storeParticle(&p, _particleCount);
+        fastForwardParticle(_particleCount, age);
+        ++_particleCount;
+    }
+}
+
+void ParticleEmitter::fastForwardParticle(unsigned int index, float time)
+{
+    GP_ASSERT(index < _particleCountMax);
+
+    float* s = _particleStreams + index;
+    const unsigned int stride = _particleStride;
+    float& energy = s[STREAM_ENERGY * stride];
+    float lifeTime = std::min(time, energy);
+    energy -= time;
+    if (lifeTime <= 0.0f || energy <= 0.0f)
+        return;
+
+    Vector3 position(s[STREAM_POSITION_X * stride], s[STREAM_POSITION_Y * stride], s[STREAM_POSITION_Z * stride]);
+    Vector3 velocity(s[STREAM_VELOCITY_X * stride], s[STREAM_VELOCITY_Y * stride], s[STREAM_VELOCITY_Z * stride]);
+    Vector3 acceleration(s[STREAM_ACCELERATION_X * stride], s[STREAM_ACCELERATION_Y * stride], s[STREAM_ACCELERATION_Z * stride]);
+    Vector3 axis(s[STREAM_ROTATION_AXIS_X * stride], s[STREAM_ROTATION_AXIS_Y * stride], s[STREAM_ROTATION_AXIS_Z * stride]);
+    float rotationSpeed = s[STREAM_ROTATION_SPEED * stride];
+    float t = lifeTime * 0.001f;
+
+    if (rotationSpeed != 0.0f && !axis.isZero())
+    {
+        // Velocity and acceleration turn about the axis, so step through the time.
+        for (float remaining = lifeTime; remaining > 0.0f; remaining -= PARTICLE_CATCH_UP_STEP)
         {
-            // Particle is dead.  Move the particle furthest from the start of the array
-            // down to take its place, and re-use the slot at the end of the list of living particles.
-            if (particlesIndex != _particleCount - 1)
-            {
-                _particles[particlesIndex] = _particles[_particleCount - 1];
-            }
-            --_particleCount;
+            float step = std::min(remaining, PARTICLE_CATCH_UP_STEP) * 0.001f;
+            Matrix::createRotation(axis, rotationSpeed * step, &_rotation);
+            _rotation.transformPoint(&velocity);
+            _rotation.transformPoint(&acceleration);
+            velocity += acceleration * step;
+            position += velocity * step;
         }
     }
+    else
+    {
+        position += velocity * t + acceleration * (0.5f * t * t);
+        velocity += acceleration * t;
+    }
+
+    s[STREAM_POSITION_X * stride] = position.x;
+    s[STREAM_POSITION_Y * stride] = position.y;
+    s[STREAM_POSITION_Z * stride] = position.z;
+    s[STREAM_VELOCITY_X * stride] = velocity.x;
+    s[STREAM_VELOCITY_Y * stride] = velocity.y;
+    s[STREAM_VELOCITY_Z * stride] = velocity.z;
+    s[STREAM_ACCELERATION_X * stride] = acceleration.x;
+    s[STREAM_ACCELERATION_Y * stride] = acceleration.y;
+    s[STREAM_ACCELERATION_Z * stride] = acceleration.z;
+    s[STREAM_ANGLE * stride] += s[STREAM_ROTATION_PER_PARTICLE_SPEED * stride] * t;
+
+    // Looped sprite animations advance by whole frames; the others follow the particle's energy.
+    if (_spriteAnimated && _spriteLooped && _spriteFrameDurationSecs > 0.0f)
+    {
+        float& timeOnCurrentFrame = s[STREAM_TIME_ON_CURRENT_FRAME * stride];
+        timeOnCurrentFrame += t;
+        unsigned int frames = (unsigned int)(timeOnCurrentFrame / _spriteFrameDurationSecs);
+        timeOnCurrentFrame -= (float)frames * _spriteFrameDurationSecs;
+        _particleFrames[index] = (_particleFrames[index] + frames) % _spriteFrameCount;
+    }
+}
+
+void ParticleEmitter::setCulling(bool culling)
+{
+    _culling = culling;
+    if (!culling && _skippedTime > 0.0)
+    {
+        catchUp();
+    }
+}
+
+bool ParticleEmitter::isCulling() const
+{
+    return _culling;
+}
+
+void ParticleEmitter::setSorted(bool sorted)
+{
+    _sorted = sorted;
+}
+
+bool ParticleEmitter::isSorted() const
+{
+    return _sorted;
+}
+
+void ParticleEmitter::computeDepths(const Vector3& eye, const Vector3& forward, float* depths) const
+{
+    GP_ASSERT(depths);
+
+    if (_particleStreams == NULL)
+        return;
+
+    dotProduct(depths, getParticleStream(STREAM_POSITION_X), getParticleStream(STREAM_POSITION_Y), getParticleStream(STREAM_POSITION_Z),
+        forward, -eye.dot(forward), _particleCount);
+}
+
+bool ParticleEmitter::isSortCurrent(const SortState& sort, const Vector3& eye, const Vector3& forward) const
+{
+    if (!sort.valid || sort.revision != _particleRevision)
+        return false;
+    if (_particleCount < 2)
+        return true;
+
+    // The depth of a particle changes by at most the distance it moved, plus the distance the
+    // eye moved, plus its distance from the eye times the turn of the view direction.
+    Vector3 reach(std::max(fabs(_bounds.min.x - sort.eye.x), fabs(_bounds.max.x - sort.eye.x)),
+                  std::max(fabs(_bounds.min.y - sort.eye.y), fabs(_bounds.max.y - sort.eye.y)),
+                  std::max(fabs(_bounds.min.z - sort.eye.z), fabs(_bounds.max.z - sort.eye.z)));
+    float change = (float)(_particleDrift - sort.drift) + eye.distance(sort.eye) + forward.distance(sort.forward) * reach.length();
+    return change <= sort.tolerance;
+}
+
+void ParticleEmitter::setSortState(SortState* sort, const Vector3& eye, const Vector3& forward, float tolerance) const
+{
+    GP_ASSERT(sort);
+
+    sort->eye = eye;
+    sort->forward = forward;
+    sort->tolerance = tolerance;
+    sort->revision = _particleRevision;
+    sort->drift = _particleDrift;
+    sort->valid = true;
+}
+
+const unsigned int* ParticleEmitter::sortParticles(const Vector3& eye, const Vector3& forward)
+{
+    if (_particleStreams == NULL)
+        return NULL;
+    if (isSortCurrent(_sort, eye, forward))
+        return _particleOrder;
+
+    ParticleManager* manager = Game::getInstance() ? Game::getInstance()->getParticleManager() : NULL;
+    if (manager == NULL)
+        return NULL;
+
+    float* depths = manager->prepareSort(_particleCount);
+    computeDepths(eye, forward, depths);
+    float tolerance = manager->sortByDepth(_particleCount);
+    if (_particleCount > 0)
+        memcpy(_particleOrder, manager->getSortedValues(), _particleCount * sizeof(unsigned int));
+    setSortState(&_sort, eye, forward, tolerance);
+    return _particleOrder;
 }
 
 void ParticleEmitter::draw()
@@ -920,11 +1626,15 @@ void ParticleEmitter::draw()
         return;
     }
 
-    if (_particleCount > 0)
+    if (_gpu)
+    {
+        drawGpu();
+        return;
+    }
+
+    if (_particleVisibleCount > 0)
     {
         GP_ASSERT(_spriteBatch);
-        GP_ASSERT(_particles);
-        GP_ASSERT(_spriteTextureCoords);
 
         // Set our node's view projection matrix to this emitter's effect.
         if (_node)
@@ -932,12 +1642,6 @@ void ParticleEmitter::draw()
             _spriteBatch->setProjectionMatrix(_node->getViewProjectionMatrix());
         }
 
-        // Begin sprite batch drawing
-        _spriteBatch->start();
-
-        // 2D Rotation.
-        static const Vector2 pivot(0.5f, 0.5f);
-
         // 3D Rotation so that particles always face the camera.
         GP_ASSERT(_node && _node->getScene() && _node->getScene()->getActiveCamera() && _node->getScene()->getActiveCamera()->getNode());
         const Matrix& cameraWorldMatrix = _node->getScene()->getActiveCamera()->getNode()->getWorldMatrix();
@@ -947,21 +1651,466 @@ void ParticleEmitter::draw()
         Vector3 up;
         cameraWorldMatrix.getUpVector(&up);
 
-        for (unsigned int i = 0; i < _particleCount; i++)
+        const unsigned int* order = NULL;
+        if (_sorted)
+        {
+            Vector3 eye;
+            cameraWorldMatrix.getTranslation(&eye);
+            Vector3 forward;
+            cameraWorldMatrix.getForwardVector(&forward);
+            forward.normalize();
+            order = sortParticles(eye, forward);
+        }
+
+        // Begin sprite batch drawing
+        _spriteBatch->start();
+        unsigned int batchedCount = 0;
+        addSprites(_spriteBatch, &batchedCount, right, up, order, order ? _particleCount : 0);
+
+        // Render.
+        if (batchedCount > 0)
+        {
+            _spriteBatch->finish();
+        }
+    }
+}
+
+unsigned int ParticleEmitter::addSprites(SpriteBatch* batch, unsigned int* batchedCount, const Vector3& right, const Vector3& up,
+                                         const unsigned int* order, unsigned int orderCount)
+{
+    GP_ASSERT(batch);
+    GP_ASSERT(batchedCount);
+    GP_ASSERT(_spriteTextureCoords);
+
+    if (_particleStreams == NULL)
+        return 0;
+
+    const float* px = getParticleStream(STREAM_POSITION_X);
+    const float* py = getParticleStream(STREAM_POSITION_Y);
+    const float* pz = getParticleStream(STREAM_POSITION_Z);
+    const float* r = getParticleStream(STREAM_COLOR_R);
+    const float* g = getParticleStream(STREAM_COLOR_G);
+    const float* b = getParticleStream(STREAM_COLOR_B);
+    const float* a = getParticleStream(STREAM_COLOR_A);
+    const float* size = getParticleStream(STREAM_SIZE);
+    const float* angle = getParticleStream(STREAM_ANGLE);
+
+    // The billboard vertices are written straight into the sprite batch, which is drawn
+    // whenever it holds as many sprites as its indices can address.
+    const unsigned int batchMax = Mesh::isIndexFormatSupported(Mesh::INDEX32) ? PARTICLE_SPRITE_BATCH_MAX_INDEX32 : PARTICLE_SPRITE_BATCH_MAX;
+    const unsigned int count = order ? orderCount : _particleCount;
+    unsigned int drawCount = 0;
+    unsigned int first = 0;
+    while (first < count)
+    {
+        if (*batchedCount >= batchMax)
+        {
+            batch->finish();
+            batch->start();
+            *batchedCount = 0;
+            ++drawCount;
+        }
+
+        unsigned int end = first;
+        unsigned int visibleCount = 0;
+        while (end < count && *batchedCount + visibleCount < batchMax)
         {
-            Particle* p = &_particles[i];
+            if (_particleVisible[order ? order[end] : end])
+                ++visibleCount;
+            ++end;
+        }
 
-            if (p->_visible)
+        SpriteBatch::SpriteVertex* v = visibleCount > 0 ? batch->addSprites(visibleCount) : NULL;
+        if (v)
+        {
+            *batchedCount += visibleCount;
+            for (unsigned int k = first; k < end; ++k)
             {
-                _spriteBatch->draw(p->_position, right, up, p->_size, p->_size,
-                                   _spriteTextureCoords[p->_frame * 4], _spriteTextureCoords[p->_frame * 4 + 1], _spriteTextureCoords[p->_frame * 4 + 2], _spriteTextureCoords[p->_frame * 4 + 3],
-                                   p->_color, pivot, p->_angle);
+                unsigned int i = order ? order[k] : k;
+                if (!_particleVisible[i])
+                    continue;
+
+                // The half extents of the sprite, rotated by the particle's angle about the view direction.
+                float halfSize = size[i] * 0.5f;
+                float c = halfSize;
+                float s = 0.0f;
+                if (angle[i] != 0.0f)
+                {
+                    c = cos(angle[i]) * halfSize;
+                    s = sin(angle[i]) * halfSize;
+                }
+                Vector3 sr(right.x * c + up.x * s, right.y * c + up.y * s, right.z * c + up.z * s);
+                Vector3 su(up.x * c - right.x * s, up.y * c - right.y * s, up.z * c - right.z * s);
+
+                const float* uv = &_spriteTextureCoords[_particleFrames[i] * 4];
+                v[0].x = px[i] - sr.x - su.x; v[0].y = py[i] - sr.y - su.y; v[0].z = pz[i] - sr.z - su.z;
+                v[1].x = px[i] + sr.x - su.x; v[1].y = py[i] + sr.y - su.y; v[1].z = pz[i] + sr.z - su.z;
+                v[2].x = px[i] - sr.x + su.x; v[2].y = py[i] - sr.y + su.y; v[2].z = pz[i] - sr.z + su.z;
+                v[3].x = px[i] + sr.x + su.x; v[3].y = py[i] + sr.y + su.y; v[3].z = pz[i] + sr.z + su.z;
+                v[0].u = uv[0]; v[0].v = uv[1];
+                v[1].u = uv[2]; v[1].v = uv[1];
+                v[2].u = uv[0]; v[2].v = uv[3];
+                v[3].u = uv[2]; v[3].v = uv[3];
+                for (unsigned int k = 0; k < 4; ++k)
+                {
+                    v[k].r = r[i]; v[k].g = g[i]; v[k].b = b[i]; v[k].a = a[i];
+                }
+                v += 4;
             }
         }
+        first = end;
+    }
+    return drawCount;
+}
 
-        // Render.
-        _spriteBatch->finish();
+ParticleEmitter::SimulationMode ParticleEmitter::getSimulationMode() const
+{
+    return _gpu ? SIMULATION_GPU : SIMULATION_CPU;
+}
+
+bool ParticleEmitter::isGpuSimulationSupported()
+{
+#if defined(USE_TRANSFORM_FEEDBACK) && defined(USE_INSTANCED_ARRAYS)
+    return glTransformFeedbackVaryings && glBeginTransformFeedback && glEndTransformFeedback && glBindBufferBase &&
+           glDrawArraysInstanced && glVertexAttribDivisor;
+#else
+    return false;
+#endif
+}
+
+#if defined(USE_TRANSFORM_FEEDBACK) && defined(USE_INSTANCED_ARRAYS)
+
+bool ParticleEmitter::acquireGpuResources()
+{
+    if (__gpuEmitterCount++ > 0)
+        return true;
+
+    static const char* varyings[] = { "v_position", "v_velocity", "v_acceleration" };
+    __simulateEffect = Effect::createTransformFeedback(PARTICLE_SIMULATE_VSH, PARTICLE_SIMULATE_FSH, varyings, 3);
+    __particleEffect = Effect::createFromFile(PARTICLE_VSH, PARTICLE_FSH);
+    if (__simulateEffect == NULL || __particleEffect == NULL)
+    {
+        GP_ERROR("Failed to load the particle simulation effects.");
+        SAFE_RELEASE(__simulateEffect);
+        SAFE_RELEASE(__particleEffect);
+        __gpuEmitterCount = 0;
+        return false;
+    }
+
+    // The corners of a billboard, drawn as a triangle strip.
+    static const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+    GL_ASSERT( glGenBuffers(1, &__cornerBuffer) );
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, __cornerBuffer);
+    GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW) );
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void ParticleEmitter::releaseGpuResources()
+{
+    GP_ASSERT(__gpuEmitterCount > 0);
+    if (--__gpuEmitterCount > 0)
+        return;
+
+    SAFE_RELEASE(__simulateEffect);
+    SAFE_RELEASE(__particleEffect);
+    if (__cornerBuffer)
+    {
+        StateCache::deleteBuffers(1, &__cornerBuffer);
+        __cornerBuffer = 0;
+    }
+}
+
+// Binds a vec4 attribute of the effect to a buffer, returning the attribute so that it can be disabled again.
+static VertexAttribute bindParticleAttribute(Effect* effect, const char* name, GLsizei stride, unsigned int offset, GLuint divisor)
+{
+    VertexAttribute attrib = effect->getVertexAttribute(name);
+    if (attrib != -1)
+    {
+        RenderCommandList::vertexAttribPointer(attrib, 4, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(offset * sizeof(float)));
+        RenderCommandList::setVertexAttribArrayEnabled(attrib, true);
+        if (divisor)
+        {
+            RenderCommandList::vertexAttribDivisor(attrib, divisor);
+        }
+    }
+    return attrib;
+}
+
+static void unbindParticleAttributes(const VertexAttribute* attribs, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (attribs[i] != -1)
+        {
+            RenderCommandList::setVertexAttribArrayEnabled(attribs[i], false);
+            RenderCommandList::vertexAttribDivisor(attribs[i], 0);
+        }
+    }
+}
+
+void ParticleEmitter::setSimulationMode(SimulationMode mode)
+{
+    if (mode == getSimulationMode())
+        return;
+
+    if (mode == SIMULATION_CPU)
+    {
+        StateCache::deleteBuffers(2, _gpu->stateBuffers);
+        StateCache::deleteBuffers(1, &_gpu->attributeBuffer);
+        SAFE_DELETE(_gpu);
+        releaseGpuResources();
+        return;
+    }
+
+    if (!isGpuSimulationSupported())
+    {
+        GP_WARN("GPU particle simulation is not supported; particles are simulated on the CPU.");
+        return;
+    }
+    if (!acquireGpuResources())
+        return;
+    if (_spriteFrameCount > PARTICLE_GPU_FRAME_COUNT_MAX)
+    {
+        GP_WARN("GPU simulated emitters support at most %d sprite frames; the remaining %d frames are ignored.",
+            PARTICLE_GPU_FRAME_COUNT_MAX, _spriteFrameCount - PARTICLE_GPU_FRAME_COUNT_MAX);
+    }
+
+    // The living CPU particles are discarded.
+    releaseParticleMemory();
+
+    _gpu = new GpuSimulation();
+    _gpu->current = 0;
+    _gpu->nextSlot = 0;
+    _gpu->time = 0.0;
+    _gpu->activeUntil = 0.0;
+    _gpu->expiry.resize(_particleCountMax, 0.0);
+
+    // All slots start out dead (zero energy).
+    std::vector<float> zero(_particleCountMax * PARTICLE_GPU_ATTRIBUTE_SIZE, 0.0f);
+    GL_ASSERT( glGenBuffers(2, _gpu->stateBuffers) );
+    GL_ASSERT( glGenBuffers(1, &_gpu->attributeBuffer) );
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->stateBuffers[i]);
+        GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _particleCountMax * PARTICLE_GPU_STATE_SIZE * sizeof(float), &zero[0], GL_DYNAMIC_COPY) );
     }
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->attributeBuffer);
+    GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _particleCountMax * PARTICLE_GPU_ATTRIBUTE_SIZE * sizeof(float), &zero[0], GL_DYNAMIC_DRAW) );
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void ParticleEmitter::emitGpu(unsigned int particleCount, const Matrix& world, const Vector3& translation)
+{
+    GP_ASSERT(_gpu);
+
+    // Emit into consecutive slots, stopping at the first slot whose particle is still alive.
+    unsigned int first = _gpu->nextSlot;
+    unsigned int count = 0;
+    while (count < particleCount && count < _particleCountMax && _gpu->expiry[(first + count) % _particleCountMax] <= _gpu->time)
+    {
+        ++count;
+    }
+    if (count == 0)
+        return;
+
+    _gpu->stateData.resize(count * PARTICLE_GPU_STATE_SIZE);
+    _gpu->attributeData.resize(count * PARTICLE_GPU_ATTRIBUTE_SIZE);
+    Particle p;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        initializeParticle(&p, world, translation);
+
+        float* state = &_gpu->stateData[i * PARTICLE_GPU_STATE_SIZE];
+        state[0] = p._position.x;
+        state[1] = p._position.y;
+        state[2] = p._position.z;
+        state[3] = (float)p._energy;
+        state[4] = p._velocity.x;
+        state[5] = p._velocity.y;
+        state[6] = p._velocity.z;
+        state[7] = p._angle;
+        state[8] = p._acceleration.x;
+        state[9] = p._acceleration.y;
+        state[10] = p._acceleration.z;
+        state[11] = (float)std::min(p._frame, PARTICLE_GPU_FRAME_COUNT_MAX - 1u);
+
+        float* attribute = &_gpu->attributeData[i * PARTICLE_GPU_ATTRIBUTE_SIZE];
+        memcpy(attribute, &p._colorStart.x, 4 * sizeof(float));
+        memcpy(attribute + 4, &p._colorEnd.x, 4 * sizeof(float));
+        attribute[8] = p._rotationAxis.x;
+        attribute[9] = p._rotationAxis.y;
+        attribute[10] = p._rotationAxis.z;
+        attribute[11] = p._rotationSpeed;
+        attribute[12] = p._sizeStart;
+        attribute[13] = p._sizeEnd;
+        attribute[14] = p._rotationPerParticleSpeed;
+        attribute[15] = (float)std::max(p._energyStart, 1L);
+
+        double expiry = _gpu->time + p._energy;
+        _gpu->expiry[(first + i) % _particleCountMax] = expiry;
+        if (expiry > _gpu->activeUntil)
+            _gpu->activeUntil = expiry;
+    }
+
+    // Upload the new particles, in two parts when they wrap around the end of the ring.
+    unsigned int tail = std::min(count, _particleCountMax - first);
+    unsigned int ranges[2][3] = { { first, 0, tail }, { 0, tail, count - tail } };
+    for (unsigned int r = 0; r < 2; ++r)
+    {
+        unsigned int slot = ranges[r][0];
+        unsigned int offset = ranges[r][1];
+        unsigned int size = ranges[r][2];
+        if (size == 0)
+            continue;
+
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->stateBuffers[_gpu->current]);
+        RenderCommandList::bufferSubData(GL_ARRAY_BUFFER, slot * PARTICLE_GPU_STATE_SIZE * sizeof(float), size * PARTICLE_GPU_STATE_SIZE * sizeof(float),
+            &_gpu->stateData[offset * PARTICLE_GPU_STATE_SIZE]);
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->attributeBuffer);
+        RenderCommandList::bufferSubData(GL_ARRAY_BUFFER, slot * PARTICLE_GPU_ATTRIBUTE_SIZE * sizeof(float), size * PARTICLE_GPU_ATTRIBUTE_SIZE * sizeof(float),
+            &_gpu->attributeData[offset * PARTICLE_GPU_ATTRIBUTE_SIZE]);
+        RenderStats::addUpload(size * (PARTICLE_GPU_STATE_SIZE + PARTICLE_GPU_ATTRIBUTE_SIZE) * sizeof(float));
+    }
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    _gpu->nextSlot = (first + count) % _particleCountMax;
+}
+
+void ParticleEmitter::updateGpu(float elapsedTime)
+{
+    GP_ASSERT(_gpu);
+    GP_ASSERT(__simulateEffect);
+
+    _gpu->time += elapsedTime;
+
+    Effect* effect = __simulateEffect;
+    effect->bind();
+    Uniform* uniform = effect->getUniform("u_elapsedTime");
+    if (uniform)
+        effect->setValue(uniform, elapsedTime);
+
+#ifdef USE_VAO
+    StateCache::bindVertexArray(0);
+#endif
+    const GLsizei stateStride = PARTICLE_GPU_STATE_SIZE * sizeof(float);
+    const GLsizei attributeStride = PARTICLE_GPU_ATTRIBUTE_SIZE * sizeof(float);
+    VertexAttribute attribs[5];
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->stateBuffers[_gpu->current]);
+    attribs[0] = bindParticleAttribute(effect, "a_position", stateStride, 0, 0);
+    attribs[1] = bindParticleAttribute(effect, "a_velocity", stateStride, 4, 0);
+    attribs[2] = bindParticleAttribute(effect, "a_acceleration", stateStride, 8, 0);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->attributeBuffer);
+    attribs[3] = bindParticleAttribute(effect, "a_rotation", attributeStride, 8, 0);
+    attribs[4] = bindParticleAttribute(effect, "a_size", attributeStride, 12, 0);
+
+    // Write the simulated particles into the other state buffer without rasterizing anything.
+    unsigned int next = 1 - _gpu->current;
+    RenderCommandList::setEnabled(GL_RASTERIZER_DISCARD, true);
+    RenderCommandList::bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _gpu->stateBuffers[next]);
+    RenderCommandList::beginTransformFeedback(GL_POINTS);
+    RenderCommandList::drawArrays(GL_POINTS, 0, _particleCountMax);
+    RenderCommandList::endTransformFeedback();
+    RenderCommandList::bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    RenderCommandList::setEnabled(GL_RASTERIZER_DISCARD, false);
+
+    unbindParticleAttributes(attribs, 5);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+    _gpu->current = next;
+}
+
+void ParticleEmitter::drawGpu()
+{
+    GP_ASSERT(_gpu);
+    GP_ASSERT(__particleEffect);
+    GP_ASSERT(_spriteBatch);
+    GP_ASSERT(_spriteTextureCoords);
+    GP_ASSERT(_node && _node->getScene() && _node->getScene()->getActiveCamera() && _node->getScene()->getActiveCamera()->getNode());
+
+    Effect* effect = __particleEffect;
+    effect->bind();
+
+    // Particles always face the camera.
+    const Matrix& cameraWorldMatrix = _node->getScene()->getActiveCamera()->getNode()->getWorldMatrix();
+    Vector3 right;
+    cameraWorldMatrix.getRightVector(&right);
+    Vector3 up;
+    cameraWorldMatrix.getUpVector(&up);
+
+    unsigned int frameCount = std::min(_spriteFrameCount, (unsigned int)PARTICLE_GPU_FRAME_COUNT_MAX);
+    float animation = 0.0f;
+    if (_spriteAnimated)
+        animation = _spriteLooped ? (_spriteFrameDuration > 0 ? 2.0f : 0.0f) : 1.0f;
+    Vector4 spriteAnimation((float)frameCount, _spritePercentPerFrame > 0.0f ? _spritePercentPerFrame : 1.0f, (float)_spriteFrameDuration, animation);
+
+    Uniform* uniform;
+    if ((uniform = effect->getUniform("u_viewProjectionMatrix")) != NULL)
+        effect->setValue(uniform, _node->getViewProjectionMatrix());
+    if ((uniform = effect->getUniform("u_cameraRight")) != NULL)
+        effect->setValue(uniform, right);
+    if ((uniform = effect->getUniform("u_cameraUp")) != NULL)
+        effect->setValue(uniform, up);
+    if ((uniform = effect->getUniform("u_spriteAnimation")) != NULL)
+        effect->setValue(uniform, spriteAnimation);
+    if ((uniform = effect->getUniform("u_frameCoords")) != NULL)
+        effect->setValue(uniform, (const Vector4*)_spriteTextureCoords, frameCount);
+    if ((uniform = effect->getUniform("u_texture")) != NULL)
+        effect->setValue(uniform, _spriteBatch->getSampler());
+
+    GP_ASSERT(_spriteBatch->getStateBlock());
+    _spriteBatch->getStateBlock()->bind();
+
+#ifdef USE_VAO
+    StateCache::bindVertexArray(0);
+#endif
+    const GLsizei stateStride = PARTICLE_GPU_STATE_SIZE * sizeof(float);
+    const GLsizei attributeStride = PARTICLE_GPU_ATTRIBUTE_SIZE * sizeof(float);
+    VertexAttribute attribs[7];
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, __cornerBuffer);
+    attribs[0] = effect->getVertexAttribute("a_corner");
+    if (attribs[0] != -1)
+    {
+        RenderCommandList::vertexAttribPointer(attribs[0], 2, GL_FLOAT, GL_FALSE, 0, 0);
+        RenderCommandList::setVertexAttribArrayEnabled(attribs[0], true);
+    }
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->stateBuffers[_gpu->current]);
+    attribs[1] = bindParticleAttribute(effect, "a_position", stateStride, 0, 1);
+    attribs[2] = bindParticleAttribute(effect, "a_velocity", stateStride, 4, 1);
+    attribs[3] = bindParticleAttribute(effect, "a_acceleration", stateStride, 8, 1);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, _gpu->attributeBuffer);
+    attribs[4] = bindParticleAttribute(effect, "a_colorStart", attributeStride, 0, 1);
+    attribs[5] = bindParticleAttribute(effect, "a_colorEnd", attributeStride, 4, 1);
+    attribs[6] = bindParticleAttribute(effect, "a_size", attributeStride, 12, 1);
+
+    RenderCommandList::drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, _particleCountMax);
+    RenderStats::addDrawCall(GL_TRIANGLE_STRIP, 4, _particleCountMax);
+
+    unbindParticleAttributes(attribs, 7);
+    StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+#else
+
+void ParticleEmitter::setSimulationMode(SimulationMode mode)
+{
+    if (mode == SIMULATION_GPU)
+    {
+        GP_WARN("GPU particle simulation is not supported; particles are simulated on the CPU.");
+    }
+}
+
+void ParticleEmitter::emitGpu(unsigned int particleCount, const Matrix& world, const Vector3& translation)
+{
+}
+
+void ParticleEmitter::updateGpu(float elapsedTime)
+{
+}
+
+void ParticleEmitter::drawGpu()
+{
+}
+
+#endif
+
 }
@@ -135,9 +135,40 @@ class Node;
  * be set before rendering the particle system and then will be reset to their original
  * values.  Accepts the same symbolic constants as glBlendFunc().
  *
+ * <h2>Simulation:</h2>
+ *
+ * By default particles are simulated on the CPU. On platforms that support transform
+ * feedback and instanced drawing, an emitter can instead keep its particles in GPU
+ * buffers and simulate them in a vertex shader (set 'simulation = GPU' in the
+ * particle namespace, or call setSimulationMode()). Only newly emitted particles are
+ * written by the CPU then, which allows far larger particle counts. GPU particles
+ * are not culled individually, and getParticlesCount() is computed from the lifetimes
+ * of the emitted particles. At most 64 sprite frames are supported in this mode.
+ *
+ * <h2>Memory and budgets:</h2>
+ *
+ * CPU particles are stored in memory taken from the game's ParticleManager when
+ * the emitter first emits, and given back once it is stopped and all of its
+ * particles have died. The manager also limits how many particles the emitters of
+ * a scene may have alive; emitters with a higher priority (set 'priority' in the
+ * particle namespace, or call setPriority()) get their share of the budget first.
+ *
+ * <h2>Sorting:</h2>
+ *
+ * Particles are drawn in the order they are stored, which blends wrongly where
+ * transparent particles overlap. A sorted emitter (set 'sorted = true' in the particle
+ * namespace, or call setSorted()) draws its CPU particles back to front from the active
+ * camera instead. The particles are sorted on their view depth with a radix sort, run on
+ * the worker threads of the JobScheduler for large emitters. The order is kept from one
+ * frame to the next while no particle has been emitted or has died, and neither the
+ * camera nor the particles have moved enough to change the depths by more than a small
+ * fraction of their range. To sort the particles of several emitters together, see
+ * ParticleManager::setSorted.
+ *
  */
 class ParticleEmitter : public Ref
 {
+    friend class ParticleManager;
     friend class Node;
 
 public:
@@ -153,6 +184,15 @@ public:
         BLEND_MULTIPLIED
     };
 
+    /**
+     * Defines where the particles of an emitter are simulated.
+     */
+    enum SimulationMode
+    {
+        SIMULATION_CPU,
+        SIMULATION_GPU
+    };
+
     /**
      * Creates a particle emitter using the data from the Properties object defined at the specified URL, 
      * where the URL is of the format "<file-path>.<extension>#<namespace-id>/<namespace-id>/.../<namespace-id>"
@@ -628,8 +668,113 @@ public:
      */
     void setTextureBlending(TextureBlending blending);
 
+    /**
+     * Sets where the particles of this emitter are simulated.
+     *
+     * Changing the mode discards the particles that are currently alive. If GPU
+     * simulation is not supported, the emitter keeps simulating on the CPU.
+     *
+     * @param mode The simulation mode.
+     * @script{ignore}
+     */
+    void setSimulationMode(SimulationMode mode);
+
+    /**
+     * Gets where the particles of this emitter are simulated.
+     *
+     * @return The simulation mode.
+     * @script{ignore}
+     */
+    SimulationMode getSimulationMode() const;
+
+    /**
+     * Determines whether particles can be simulated on the GPU on this platform.
+     *
+     * @return true if SIMULATION_GPU is supported.
+     * @script{ignore}
+     */
+    static bool isGpuSimulationSupported();
+
+    /**
+     * Sets the priority of this emitter for the particle budget of its scene.
+     *
+     * Visible emitters are served first, and among them the emitters with the
+     * highest priority divided by their distance to the camera.
+     *
+     * @param priority The priority, 1 by default.
+     * @script{ignore}
+     */
+    void setPriority(float priority);
+
+    /**
+     * Gets the priority of this emitter for the particle budget of its scene.
+     *
+     * @return The priority.
+     * @script{ignore}
+     */
+    float getPriority() const;
+
+    /**
+     * Sets whether this emitter stops simulating its CPU particles while none of them can be seen.
+     *
+     * The emitter keeps conservative world bounds of its particles, grown by how far they
+     * can have moved since the last simulated frame. While the bounds are outside the
+     * frustum of the active camera, update() does nothing. Once they can be seen again, the
+     * living particles are advanced analytically by the time that was skipped, and the
+     * particles that would have been emitted in the meantime and are still alive are emitted
+     * and advanced to their age. Particles that rotate about an axis are advanced in 50ms steps.
+     *
+     * Culling is enabled by default.
+     *
+     * @param culling true to skip the simulation of emitters that cannot be seen.
+     * @script{ignore}
+     */
+    void setCulling(bool culling);
+
+    /**
+     * Determines whether this emitter stops simulating its CPU particles while none of them can be seen.
+     *
+     * @return true if culling is enabled.
+     * @script{ignore}
+     */
+    bool isCulling() const;
+
+    /**
+     * Sets whether the CPU particles of this emitter are drawn back to front from the camera.
+     *
+     * Sorting is disabled by default. It has no effect on emitters simulated on the GPU.
+     *
+     * @param sorted true to sort the particles by their distance along the view direction.
+     * @script{ignore}
+     */
+    void setSorted(bool sorted);
+
+    /**
+     * Determines whether the CPU particles of this emitter are drawn back to front from the camera.
+     *
+     * @return true if the particles are sorted.
+     * @script{ignore}
+     */
+    bool isSorted() const;
+
 private:
 
+    class Particle;
+    struct GpuSimulation;
+
+    /**
+     * The viewpoint an order of the particles was sorted from, and the state of the particles then.
+     */
+    struct SortState
+    {
+        Vector3 eye;
+        Vector3 forward;
+        float tolerance;                    // The change of depth for which the order is kept.
+        unsigned int revision;
+        double drift;
+        bool valid;
+    };
+
     /**
      * Constructor.
      */
@@ -666,8 +811,78 @@ private:
     // Generates a color within the domain defined by a base vector and its variance.
     void generateColor(const Vector4& base, const Vector4& variance, Vector4* dst);
 
+    // Generates the properties of a newly emitted particle.
+    void initializeParticle(Particle* p, const Matrix& world, const Vector3& translation);
+
+    // Gets the array of one property of the living CPU particles.
+    float* getParticleStream(unsigned int stream) const;
+
+    // Takes the memory of the CPU particle arrays from the particle manager.
+    bool acquireParticleMemory();
+
+    // Gives the memory of the CPU particle arrays back to the particle manager.
+    void releaseParticleMemory();
+
+    // Gets the number of particles this emitter keeps alive when emitting continuously.
+    unsigned int getParticleDemand() const;
+
+    // Adds the visible CPU particles to a started sprite batch, drawing and restarting the
+    // batch whenever it is full. Returns the number of times the batch was drawn.
+    // When an order is given, only the particles it lists are added, in that order.
+    unsigned int addSprites(SpriteBatch* batch, unsigned int* batchedCount, const Vector3& right, const Vector3& up,
+                            const unsigned int* order = NULL, unsigned int orderCount = 0);
+
+    // Writes the distance of every CPU particle from the eye, along the view direction.
+    void computeDepths(const Vector3& eye, const Vector3& forward, float* depths) const;
+
+    // Determines whether an order sorted earlier is still back to front, within the tolerance of its sort.
+    bool isSortCurrent(const SortState& sort, const Vector3& eye, const Vector3& forward) const;
+
+    // Records the viewpoint and the state of the particles of a sort.
+    void setSortState(SortState* sort, const Vector3& eye, const Vector3& forward, float tolerance) const;
+
+    // Sorts the CPU particles back to front, unless the order of the last sort is still current.
+    // Returns the order, or NULL if the particles could not be sorted.
+    const unsigned int* sortParticles(const Vector3& eye, const Vector3& forward);
+
+    // Gets the node's rotation and scale, and its translation, for orienting emitted particles.
+    void getEmissionTransform(Matrix* world, Vector3* translation) const;
+
+    // Determines whether the particles cannot be in view after the skipped time and the elapsed time.
+    bool isCulled(float elapsedTime) const;
+
+    // Catches up on the time skipped while the emitter was culled.
+    void catchUp();
+
+    // Advances a CPU particle by a length of time in one go.
+    void fastForwardParticle(unsigned int index, float time);
+
+    // Stores a particle in the CPU particle arrays.
+    void storeParticle(const Particle* p, unsigned int index);
+
+    // Removes a CPU particle by moving the last living particle into its place.
+    void removeParticle(unsigned int index);
+
+    // Emits particles into the GPU buffers.
+    void emitGpu(unsigned int particleCount, const Matrix& world, const Vector3& translation);
+
+    // Simulates the particles in the GPU buffers.
+    void updateGpu(float elapsedTime);
+
+    // Draws the particles in the GPU buffers.
+    void drawGpu();
+
+    // Loads the effects and buffers shared by every GPU simulated emitter.
+    static bool acquireGpuResources();
+
+    // Releases the shared GPU resources once the last GPU simulated emitter is gone.
+    static void releaseGpuResources();
+
     /**
      * Defines the data for a single particle in the system.
+     *
+     * Emitted particles are generated into this structure and then stored,
+     * one property per array, in the CPU particle arrays or the GPU buffers.
      */
     class Particle
     {
@@ -695,7 +910,16 @@ private:
 
     unsigned int _particleCountMax;
     unsigned int _particleCount;
-    Particle* _particles;
+    unsigned char* _particleMemory;         // Holds the CPU particle arrays below while particles are alive.
+    unsigned int _particleMemorySize;
+    float* _particleStreams;                // One array of _particleStride floats per particle property.
+    unsigned int _particleStride;
+    unsigned int* _particleFrames;
+    unsigned int* _particleOrder;           // The particles back to front, as of the last sort.
+    bool* _particleVisible;
+    unsigned int _particleVisibleCount;
+    unsigned int _particleBudget;           // The most particles the particle manager lets this emitter have alive.
+    float _priority;
     unsigned int _emissionRate;
     bool _started;
     bool _ellipsoid;
@@ -742,6 +966,18 @@ private:
     bool _orbitAcceleration;
     float _timePerEmission;
     double _timeRunning;
+    GpuSimulation* _gpu;
+    bool _culling;
+    double _skippedTime;                    // Time not simulated while culled, in milliseconds.
+    BoundingBox _bounds;                    // Bounds of the particle positions after the last simulated frame.
+    float _boundsMaxSpeed;
+    float _boundsMaxAcceleration;
+    float _boundsMaxSize;
+    bool _sorted;
+    unsigned int _particleRevision;         // Changed whenever particles are emitted, removed or moved outside of update().
+    double _particleDrift;                  // The farthest any particle can have moved, summed over the simulated frames.
+    SortState _sort;                        // The sort of _particleOrder.
+    SortState _sceneSort;                   // The sort of the particles of the scene, by the particle manager.
 };
 
 }
@@ -0,0 +1,554 @@
+#include "Base.h"
+#include "ParticleManager.h"
+#include "ParticleEmitter.h"
+#include "Node.h"
+#include "Scene.h"
+#include "Game.h"
+
+// The smallest block of particle memory handed out by the pool is 2^PARTICLE_MEMORY_CLASS_MIN bytes.
+#define PARTICLE_MEMORY_CLASS_MIN 8
+
+// The fewest values counted and scattered by one job of a depth sort.
+#define PARTICLE_SORT_BLOCK_MIN 4096
+
+// The change in the depths of sorted particles, as a fraction of their range, for which their order is kept.
+#define PARTICLE_SORT_TOLERANCE (1.0f / 256.0f)
+
+namespace gameplay
+{
+
+ParticleManager::ParticleManager()
+    : _sortCount(0), _sortBlockSize(0), _sortPass(0), _sortMin(0.0f), _sortScale(0.0f), _sorted(false),
+      _budget(0), _cullDistance(0.0f), _poolSize(8 * 1024 * 1024)
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
+
+ParticleManager::~ParticleManager()
+{
+    finalize();
+}
+
+void ParticleManager::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    if (properties->exists("budget"))
+    {
+        _budget = (unsigned int)std::max(0, properties->getInt("budget"));
+    }
+    if (properties->exists("cullDistance"))
+    {
+        _cullDistance = std::max(0.0f, properties->getFloat("cullDistance"));
+    }
+    if (properties->exists("poolSize"))
+    {
+        _poolSize = (unsigned int)std::max(0, properties->getInt("poolSize")) * 1024 * 1024;
+    }
+    _sorted = properties->getBool("sorted");
+}
+
+void ParticleManager::finalize()
+{
+    for (size_t i = 0, count = _freeMemory.size(); i < count; ++i)
+    {
+        for (size_t j = 0, blocks = _freeMemory[i].size(); j < blocks; ++j)
+        {
+            SAFE_DELETE_ARRAY(_freeMemory[i][j]);
+        }
+    }
+    _freeMemory.clear();
+    _statistics.pooledMemory = 0;
+}
+
+unsigned int ParticleManager::getBudget() const
+{
+    return _budget;
+}
+
+void ParticleManager::setBudget(unsigned int budget)
+{
+    _budget = budget;
+}
+
+float ParticleManager::getCullDistance() const
+{
+    return _cullDistance;
+}
+
+void ParticleManager::setCullDistance(float distance)
+{
+    _cullDistance = std::max(0.0f, distance);
+}
+
+bool ParticleManager::isSorted() const
+{
+    return _sorted;
+}
+
+void ParticleManager::setSorted(bool sorted)
+{
+    _sorted = sorted;
+}
+
+const ParticleManager::Statistics& ParticleManager::getStatistics() const
+{
+    return _statistics;
+}
+
+void ParticleManager::addEmitter(ParticleEmitter* emitter)
+{
+    GP_ASSERT(emitter);
+    _emitters.push_back(emitter);
+}
+
+void ParticleManager::removeEmitter(ParticleEmitter* emitter)
+{
+    std::vector<ParticleEmitter*>::iterator itr = std::find(_emitters.begin(), _emitters.end(), emitter);
+    if (itr != _emitters.end())
+    {
+        // Order does not matter, the emitters are ranked on every update.
+        *itr = _emitters.back();
+        _emitters.pop_back();
+    }
+    _sceneEmitters.clear();
+}
+
+unsigned int ParticleManager::getSizeClass(unsigned int size)
+{
+    unsigned int sizeClass = PARTICLE_MEMORY_CLASS_MIN;
+    while ((1u << sizeClass) < size)
+    {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+unsigned char* ParticleManager::acquireMemory(unsigned int size)
+{
+    unsigned int sizeClass = getSizeClass(size);
+    if (sizeClass < _freeMemory.size() && !_freeMemory[sizeClass].empty())
+    {
+        unsigned char* memory = _freeMemory[sizeClass].back();
+        _freeMemory[sizeClass].pop_back();
+        _statistics.pooledMemory -= 1u << sizeClass;
+        return memory;
+    }
+    return new unsigned char[1u << sizeClass];
+}
+
+void ParticleManager::releaseMemory(unsigned char* memory, unsigned int size)
+{
+    if (memory == NULL)
+        return;
+
+    // Keep the block for another emitter unless the pool is full.
+    unsigned int sizeClass = getSizeClass(size);
+    if (_statistics.pooledMemory + (1u << sizeClass) > _poolSize)
+    {
+        SAFE_DELETE_ARRAY(memory);
+        return;
+    }
+    if (sizeClass >= _freeMemory.size())
+    {
+        _freeMemory.resize(sizeClass + 1);
+    }
+    _freeMemory[sizeClass].push_back(memory);
+    _statistics.pooledMemory += 1u << sizeClass;
+}
+
+bool ParticleManager::compareRanks(const Rank& a, const Rank& b)
+{
+    if (a.scene != b.scene)
+        return a.scene < b.scene;
+    if (a.visible != b.visible)
+        return a.visible;
+    return a.score > b.score;
+}
+
+void ParticleManager::update()
+{
+    _statistics.emitterCount = (unsigned int)_emitters.size();
+    _statistics.activeEmitterCount = 0;
+    _statistics.culledEmitterCount = 0;
+    _statistics.particleCount = 0;
+    _statistics.usedMemory = 0;
+
+    _ranks.clear();
+    for (size_t i = 0, count = _emitters.size(); i < count; ++i)
+    {
+        ParticleEmitter* emitter = _emitters[i];
+
+        // Give the memory of emitters that are done back to the pool.
+        if (emitter->_particleMemory && !emitter->_started && emitter->_particleCount == 0)
+        {
+            emitter->releaseParticleMemory();
+        }
+        if (emitter->_particleMemory)
+        {
+            ++_statistics.activeEmitterCount;
+            _statistics.usedMemory += emitter->_particleMemorySize;
+        }
+        _statistics.particleCount += emitter->getParticlesCount();
+
+        // Emitters outside of a scene with a camera are not limited.
+        Scene* scene = emitter->_node ? emitter->_node->getScene() : NULL;
+        Camera* camera = scene ? scene->getActiveCamera() : NULL;
+        if (camera == NULL || camera->getNode() == NULL)
+        {
+            emitter->_particleBudget = emitter->_particleCountMax;
+            continue;
+        }
+
+        Vector3 position = emitter->_node->getTranslationWorld();
+        float distance = position.distance(camera->getNode()->getTranslationWorld());
+        if (_cullDistance > 0.0f && distance > _cullDistance)
+        {
+            emitter->_particleBudget = 0;
+            ++_statistics.culledEmitterCount;
+            continue;
+        }
+
+        Rank rank;
+        rank.emitter = emitter;
+        rank.scene = scene;
+        rank.visible = emitter->_particleVisibleCount > 0 || camera->getFrustum().intersects(position);
+        rank.score = emitter->_priority / (1.0f + distance);
+        _ranks.push_back(rank);
+    }
+
+    // Hand out the budget of each scene to its visible, then highest scoring, emitters first.
+    std::sort(_ranks.begin(), _ranks.end(), compareRanks);
+    Scene* scene = NULL;
+    unsigned int remaining = 0;
+    bool limited = false;
+    for (size_t i = 0, count = _ranks.size(); i < count; ++i)
+    {
+        const Rank& rank = _ranks[i];
+        if (rank.scene != scene)
+        {
+            scene = rank.scene;
+            remaining = scene->getParticleBudget() > 0 ? scene->getParticleBudget() : _budget;
+            limited = remaining > 0;
+        }
+
+        ParticleEmitter* emitter = rank.emitter;
+        if (!limited)
+        {
+            emitter->_particleBudget = emitter->_particleCountMax;
+            continue;
+        }
+
+        unsigned int share = std::min(emitter->getParticleDemand(), remaining);
+        emitter->_particleBudget = share;
+        remaining -= share;
+        if (share == 0)
+            ++_statistics.culledEmitterCount;
+    }
+}
+
+bool ParticleManager::compareBatches(const ParticleEmitter* a, const ParticleEmitter* b)
+{
+    const Texture* textureA = a->_spriteBatch->getSampler()->getTexture();
+    const Texture* textureB = b->_spriteBatch->getSampler()->getTexture();
+    if (textureA != textureB)
+        return textureA < textureB;
+    return a->_spriteTextureBlending < b->_spriteTextureBlending;
+}
+
+void ParticleManager::draw(Scene* scene)
+{
+    _statistics.drawCalls = 0;
+
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+        return;
+
+    _batches.clear();
+    _sortedEmitters.clear();
+    for (size_t i = 0, count = _emitters.size(); i < count; ++i)
+    {
+        ParticleEmitter* emitter = _emitters[i];
+        if (emitter->_node == NULL || emitter->_node->getScene() != scene || !emitter->isActive())
+            continue;
+
+        if (emitter->_gpu)
+        {
+            emitter->draw();
+            ++_statistics.drawCalls;
+        }
+        else if (emitter->_particleVisibleCount > 0)
+        {
+            if (_sorted && emitter->_sorted)
+                _sortedEmitters.push_back(emitter);
+            else
+                _batches.push_back(emitter);
+        }
+    }
+    std::sort(_batches.begin(), _batches.end(), compareBatches);
+
+    // Particles always face the camera.
+    const Matrix& cameraWorldMatrix = camera->getNode()->getWorldMatrix();
+    Vector3 right;
+    cameraWorldMatrix.getRightVector(&right);
+    Vector3 up;
+    cameraWorldMatrix.getUpVector(&up);
+    Vector3 eye;
+    cameraWorldMatrix.getTranslation(&eye);
+    Vector3 forward;
+    cameraWorldMatrix.getForwardVector(&forward);
+    forward.normalize();
+
+    // Every run of emitters with the same texture and blend mode goes into the sprite batch of its first emitter.
+    for (size_t i = 0, count = _batches.size(); i < count; )
+    {
+        ParticleEmitter* first = _batches[i];
+        SpriteBatch* batch = first->_spriteBatch;
+        batch->setProjectionMatrix(camera->getViewProjectionMatrix());
+        batch->start();
+
+        unsigned int batchedCount = 0;
+        size_t j = i;
+        for (; j < count && !compareBatches(first, _batches[j]) && !compareBatches(_batches[j], first); ++j)
+        {
+            ParticleEmitter* emitter = _batches[j];
+            const unsigned int* order = emitter->_sorted ? emitter->sortParticles(eye, forward) : NULL;
+            _statistics.drawCalls += emitter->addSprites(batch, &batchedCount, right, up, order, order ? emitter->_particleCount : 0);
+        }
+        if (batchedCount > 0)
+        {
+            batch->finish();
+            ++_statistics.drawCalls;
+        }
+        i = j;
+    }
+
+    if (!_sortedEmitters.empty())
+    {
+        drawSorted(camera->getViewProjectionMatrix(), eye, forward, right, up);
+    }
+}
+
+void ParticleManager::drawSorted(const Matrix& viewProjection, const Vector3& eye, const Vector3& forward, const Vector3& right, const Vector3& up)
+{
+    // The order of the last sort is kept while it holds the same emitters and all of them are still in order.
+    bool current = _sortedEmitters == _sceneEmitters;
+    for (size_t i = 0, count = _sortedEmitters.size(); current && i < count; ++i)
+    {
+        current = _sortedEmitters[i]->isSortCurrent(_sortedEmitters[i]->_sceneSort, eye, forward);
+    }
+
+    if (!current)
+    {
+        _sceneEmitters = _sortedEmitters;
+        _sceneOffsets.resize(_sceneEmitters.size());
+        unsigned int total = 0;
+        for (size_t i = 0, count = _sceneEmitters.size(); i < count; ++i)
+        {
+            _sceneOffsets[i] = total;
+            total += _sceneEmitters[i]->_particleCount;
+        }
+
+        float* depths = prepareSort(total);
+        for (size_t i = 0, count = _sceneEmitters.size(); i < count; ++i)
+        {
+            _sceneEmitters[i]->computeDepths(eye, forward, depths + _sceneOffsets[i]);
+        }
+        float tolerance = sortByDepth(total);
+
+        // Split every sorted value back into its emitter and the index of the particle in it.
+        const unsigned int* values = getSortedValues();
+        _sceneEmitterIndices.resize(total);
+        _sceneParticleIndices.resize(total);
+        for (unsigned int i = 0; i < total; ++i)
+        {
+            unsigned int emitterIndex = (unsigned int)(std::upper_bound(_sceneOffsets.begin(), _sceneOffsets.end(), values[i]) - _sceneOffsets.begin()) - 1;
+            _sceneEmitterIndices[i] = emitterIndex;
+            _sceneParticleIndices[i] = values[i] - _sceneOffsets[emitterIndex];
+        }
+
+        for (size_t i = 0, count = _sceneEmitters.size(); i < count; ++i)
+        {
+            _sceneEmitters[i]->setSortState(&_sceneEmitters[i]->_sceneSort, eye, forward, tolerance);
+        }
+    }
+
+    // Every run of particles of one emitter is added in order, switching sprite batches when the texture or blend mode changes.
+    ParticleEmitter* batchEmitter = NULL;
+    SpriteBatch* batch = NULL;
+    unsigned int batchedCount = 0;
+    for (size_t i = 0, count = _sceneParticleIndices.size(); i < count; )
+    {
+        unsigned int emitterIndex = _sceneEmitterIndices[i];
+        size_t end = i + 1;
+        while (end < count && _sceneEmitterIndices[end] == emitterIndex)
+        {
+            ++end;
+        }
+
+        ParticleEmitter* emitter = _sceneEmitters[emitterIndex];
+        if (batchEmitter == NULL || compareBatches(batchEmitter, emitter) || compareBatches(emitter, batchEmitter))
+        {
+            if (batchedCount > 0)
+            {
+                batch->finish();
+                ++_statistics.drawCalls;
+            }
+            batchEmitter = emitter;
+            batch = emitter->_spriteBatch;
+            batch->setProjectionMatrix(viewProjection);
+            batch->start();
+            batchedCount = 0;
+        }
+        _statistics.drawCalls += emitter->addSprites(batch, &batchedCount, right, up, &_sceneParticleIndices[i], (unsigned int)(end - i));
+        i = end;
+    }
+    if (batchedCount > 0)
+    {
+        batch->finish();
+        ++_statistics.drawCalls;
+    }
+}
+
+float* ParticleManager::prepareSort(unsigned int count)
+{
+    // The arrays are kept at their largest size, so sorting every frame does not allocate.
+    unsigned int size = std::max(count, 1u);
+    if (_sortDepths.size() < size)
+    {
+        _sortDepths.resize(size);
+        _sortKeys[0].resize(size);
+        _sortKeys[1].resize(size);
+        _sortValues[0].resize(size);
+        _sortValues[1].resize(size);
+    }
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _sortValues[0][i] = i;
+    }
+    return &_sortDepths[0];
+}
+
+float ParticleManager::sortByDepth(unsigned int count)
+{
+    if (count == 0)
+        return 0.0f;
+
+    float minDepth = FLT_MAX;
+    float maxDepth = -FLT_MAX;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        minDepth = std::min(minDepth, _sortDepths[i]);
+        maxDepth = std::max(maxDepth, _sortDepths[i]);
+    }
+    _sortCount = count;
+    _sortMin = minDepth;
+    _sortScale = maxDepth > minDepth ? 65535.0f / (maxDepth - minDepth) : 0.0f;
+
+    // Every block keeps the order of its values within each digit, so the sort is stable across passes.
+    JobScheduler* scheduler = Game::getInstance() ? Game::getInstance()->getJobScheduler() : NULL;
+    unsigned int blockCount = 1;
+    if (scheduler && count >= 2 * PARTICLE_SORT_BLOCK_MIN)
+    {
+        blockCount = std::min(scheduler->getWorkerCount() + 1, count / PARTICLE_SORT_BLOCK_MIN);
+    }
+    _sortBlockSize = (count + blockCount - 1) / blockCount;
+    _sortCounts.resize(blockCount * 256);
+
+    for (_sortPass = 0; _sortPass < 2; ++_sortPass)
+    {
+        if (blockCount > 1)
+            scheduler->parallelFor(blockCount, countDigits, this);
+        else
+            countDigits(0, 1, this);
+
+        // Each block writes its values of a digit after those of the smaller digits and of the blocks before it.
+        unsigned int offset = 0;
+        for (unsigned int digit = 0; digit < 256; ++digit)
+        {
+            for (unsigned int block = 0; block < blockCount; ++block)
+            {
+                unsigned int& digitCount = _sortCounts[block * 256 + digit];
+                unsigned int blockOffset = offset;
+                offset += digitCount;
+                digitCount = blockOffset;
+            }
+        }
+
+        if (blockCount > 1)
+            scheduler->parallelFor(blockCount, scatterDigits, this);
+        else
+            scatterDigits(0, 1, this);
+    }
+
+    return (maxDepth - minDepth) * PARTICLE_SORT_TOLERANCE;
+}
+
+const unsigned int* ParticleManager::getSortedValues() const
+{
+    return &_sortValues[0][0];
+}
+
+void ParticleManager::countDigits(unsigned int start, unsigned int end, void* cookie)
+{
+    ParticleManager* manager = static_cast<ParticleManager*>(cookie);
+
+    for (unsigned int block = start; block < end; ++block)
+    {
+        unsigned int first = std::min(block * manager->_sortBlockSize, manager->_sortCount);
+        unsigned int last = std::min(first + manager->_sortBlockSize, manager->_sortCount);
+        unsigned int* counts = &manager->_sortCounts[block * 256];
+        memset(counts, 0, 256 * sizeof(unsigned int));
+
+        if (manager->_sortPass == 0)
+        {
+            // The depths are quantized on the first pass; the farthest gets the smallest key.
+            const float* depths = &manager->_sortDepths[0];
+            unsigned short* keys = &manager->_sortKeys[0][0];
+            for (unsigned int i = first; i < last; ++i)
+            {
+                float depth = std::min(std::max((depths[i] - manager->_sortMin) * manager->_sortScale, 0.0f), 65535.0f);
+                keys[i] = (unsigned short)(65535 - (unsigned int)depth);
+                ++counts[keys[i] & 0xff];
+            }
+        }
+        else
+        {
+            const unsigned short* keys = &manager->_sortKeys[1][0];
+            for (unsigned int i = first; i < last; ++i)
+            {
+                ++counts[keys[i] >> 8];
+            }
+        }
+    }
+}
+
+void ParticleManager::scatterDigits(unsigned int start, unsigned int end, void* cookie)
+{
+    ParticleManager* manager = static_cast<ParticleManager*>(cookie);
+
+    // The first pass moves the keys and values from the first arrays to the second, the last pass moves the values back.
+    const unsigned int pass = manager->_sortPass;
+    const unsigned int shift = pass * 8;
+    const unsigned short* srcKeys = &manager->_sortKeys[pass][0];
+    unsigned short* dstKeys = pass == 0 ? &manager->_sortKeys[1][0] : NULL;
+    const unsigned int* srcValues = &manager->_sortValues[pass][0];
+    unsigned int* dstValues = &manager->_sortValues[1 - pass][0];
+
+    for (unsigned int block = start; block < end; ++block)
+    {
+        unsigned int first = std::min(block * manager->_sortBlockSize, manager->_sortCount);
+        unsigned int last = std::min(first + manager->_sortBlockSize, manager->_sortCount);
+        unsigned int* offsets = &manager->_sortCounts[block * 256];
+        for (unsigned int i = first; i < last; ++i)
+        {
+            unsigned int position = offsets[(srcKeys[i] >> shift) & 0xff]++;
+            dstValues[position] = srcValues[i];
+            if (dstKeys)
+                dstKeys[position] = srcKeys[i];
+        }
+    }
+}
+
+}
@@ -0,0 +1,311 @@
+#ifndef PARTICLEMANAGER_H_
+#define PARTICLEMANAGER_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class ParticleEmitter;
+class Scene;
+class Matrix;
+class Vector3;
+
+/**
+ * Defines the particle manager, which owns the particle memory of all emitters,
+ * limits the number of particles in each scene and draws emitters in batches.
+ *
+ * Emitters no longer allocate storage for their maximum particle count when
+ * they are created. Storage is taken from a shared pool the first time an
+ * emitter emits, and returned to the pool once the emitter is stopped and its
+ * last particle has died, so idle emitters hold no particle memory.
+ *
+ * Once per frame, the emitters of every scene are ranked by their priority,
+ * whether they are visible to the active camera and their distance from it.
+ * Emitters are then given, in that order, a share of the particle budget of
+ * their scene. An emitter that gets no share, or is farther than the cull
+ * distance, stops emitting until it gets one again; its living particles still
+ * run out their lifetime.
+ *
+ * draw(Scene*) draws all emitters of a scene that share a texture and blend
+ * mode with a single sprite batch, instead of one draw per emitter.
+ *
+ * The manager is configured in the game config:
+ *
+ * @verbatim
+    particles
+    {
+        budget = 20000          // Particles per scene, or 0 for no limit.
+        cullDistance = 200      // Emitters farther from the camera stop emitting, or 0 for no limit.
+        poolSize = 8            // Free particle memory kept for reuse, in megabytes.
+        sorted = false          // Whether the particles of the sorted emitters of a scene are sorted together.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class ParticleManager
+{
+    friend class Game;
+    friend class ParticleEmitter;
+
+public:
+
+    /**
+     * Defines the counters gathered by the manager.
+     */
+    struct Statistics
+    {
+        /**
+         * The number of emitters.
+         */
+        unsigned int emitterCount;
+
+        /**
+         * The number of emitters holding particle memory.
+         */
+        unsigned int activeEmitterCount;
+
+        /**
+         * The number of emitters that were not allowed to emit in the last update.
+         */
+        unsigned int culledEmitterCount;
+
+        /**
+         * The number of living particles of all emitters.
+         */
+        unsigned int particleCount;
+
+        /**
+         * The size in bytes of the particle memory in use by emitters.
+         */
+        unsigned int usedMemory;
+
+        /**
+         * The size in bytes of the free particle memory kept in the pool.
+         */
+        unsigned int pooledMemory;
+
+        /**
+         * The number of sprite batches drawn by the last call to draw().
+         */
+        unsigned int drawCalls;
+    };
+
+    /**
+     * Gets the default particle budget of a scene.
+     *
+     * @return The maximum number of particles in a scene, or 0 if there is no limit.
+     */
+    unsigned int getBudget() const;
+
+    /**
+     * Sets the default particle budget of a scene.
+     *
+     * Scenes with a budget of their own (see Scene::setParticleBudget) ignore this value.
+     *
+     * @param budget The maximum number of particles in a scene, or 0 for no limit.
+     */
+    void setBudget(unsigned int budget);
+
+    /**
+     * Gets the distance from the camera beyond which emitters stop emitting.
+     *
+     * @return The cull distance, or 0 if emitters are never culled by distance.
+     */
+    float getCullDistance() const;
+
+    /**
+     * Sets the distance from the camera beyond which emitters stop emitting.
+     *
+     * @param distance The cull distance, or 0 to never cull emitters by distance.
+     */
+    void setCullDistance(float distance);
+
+    /**
+     * Determines whether draw(Scene*) sorts the particles of the sorted emitters of a scene together.
+     *
+     * @return true if the particles of the sorted emitters are sorted together.
+     */
+    bool isSorted() const;
+
+    /**
+     * Sets whether draw(Scene*) sorts the particles of the sorted emitters of a scene together.
+     *
+     * By default every sorted emitter (see ParticleEmitter::setSorted) orders its own
+     * particles back to front, but the emitters themselves are drawn in the order of their
+     * batches, so the particles of overlapping emitters still blend wrongly. When sorting
+     * together, the particles of all sorted emitters of the scene are merged into one back
+     * to front order, and the sprite batch is switched whenever the next particles belong to
+     * an emitter with another texture or blend mode. Where such emitters interleave, this
+     * costs a draw call per switch. The emitters that are not sorted are drawn first.
+     *
+     * @param sorted true to sort the particles of the sorted emitters together.
+     */
+    void setSorted(bool sorted);
+
+    /**
+     * Draws the CPU simulated emitters attached to the nodes of a scene.
+     *
+     * Emitters with the same texture and blend mode are drawn together. Emitters
+     * drawn this way should not also be drawn with ParticleEmitter::draw.
+     * Emitters simulated on the GPU are drawn individually.
+     *
+     * @param scene The scene whose emitters are drawn.
+     */
+    void draw(Scene* scene);
+
+    /**
+     * Gets the statistics of the manager.
+     *
+     * @return The statistics.
+     */
+    const Statistics& getStatistics() const;
+
+private:
+
+    /**
+     * Defines an emitter ranked for the particle budget of its scene.
+     */
+    struct Rank
+    {
+        ParticleEmitter* emitter;
+        Scene* scene;
+        bool visible;
+        float score;
+    };
+
+    /**
+     * Constructor.
+     */
+    ParticleManager();
+
+    /**
+     * Destructor.
+     */
+    ~ParticleManager();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ParticleManager(const ParticleManager& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ParticleManager& operator=(const ParticleManager&);
+
+    /**
+     * Called during startup to read the particle configuration.
+     *
+     * @param properties The 'particles' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to release the pooled particle memory.
+     */
+    void finalize();
+
+    /**
+     * Called once per frame to hand out the particle budgets.
+     */
+    void update();
+
+    /**
+     * Adds an emitter to the manager.
+     */
+    void addEmitter(ParticleEmitter* emitter);
+
+    /**
+     * Removes an emitter from the manager.
+     */
+    void removeEmitter(ParticleEmitter* emitter);
+
+    /**
+     * Takes a block of particle memory from the pool.
+     *
+     * @param size The size of the block in bytes.
+     *
+     * @return The block, which holds at least size bytes.
+     */
+    unsigned char* acquireMemory(unsigned int size);
+
+    /**
+     * Returns a block of particle memory to the pool.
+     *
+     * @param memory The block returned by acquireMemory.
+     * @param size The size passed to acquireMemory.
+     */
+    void releaseMemory(unsigned char* memory, unsigned int size);
+
+    static unsigned int getSizeClass(unsigned int size);
+
+    static bool compareRanks(const Rank& a, const Rank& b);
+
+    static bool compareBatches(const ParticleEmitter* a, const ParticleEmitter* b);
+
+    /**
+     * Draws the particles of the sorted emitters together, back to front.
+     */
+    void drawSorted(const Matrix& viewProjection, const Vector3& eye, const Vector3& forward, const Vector3& right, const Vector3& up);
+
+    /**
+     * Sizes the arrays of a sort and numbers the values to sort from 0.
+     *
+     * @param count The number of values to sort.
+     *
+     * @return The array to write the depth of each value to.
+     */
+    float* prepareSort(unsigned int count);
+
+    /**
+     * Sorts the values numbered by prepareSort() by decreasing depth.
+     *
+     * The depths are quantized to 16 bits over their range and sorted with two passes
+     * of a radix sort. Large sorts are split into blocks that are counted and scattered
+     * on the worker threads of the JobScheduler.
+     *
+     * @param count The number of values to sort.
+     *
+     * @return The change of the depths for which the order is kept, a small fraction of their range.
+     */
+    float sortByDepth(unsigned int count);
+
+    /**
+     * Gets the values sorted by the last call to sortByDepth(), farthest first.
+     */
+    const unsigned int* getSortedValues() const;
+
+    static void countDigits(unsigned int start, unsigned int end, void* cookie);
+
+    static void scatterDigits(unsigned int start, unsigned int end, void* cookie);
+
+    std::vector<ParticleEmitter*> _emitters;
+    std::vector<Rank> _ranks;
+    std::vector<ParticleEmitter*> _batches;
+    std::vector<ParticleEmitter*> _sortedEmitters;             // The sorted emitters of the scene being drawn.
+    std::vector<ParticleEmitter*> _sceneEmitters;              // The emitters of the last sort of a scene.
+    std::vector<unsigned int> _sceneOffsets;                   // The first value of each emitter in that sort.
+    std::vector<unsigned int> _sceneEmitterIndices;            // The emitter of each particle, back to front.
+    std::vector<unsigned int> _sceneParticleIndices;           // The index of each particle in its emitter, back to front.
+    std::vector<float> _sortDepths;
+    std::vector<unsigned short> _sortKeys[2];
+    std::vector<unsigned int> _sortValues[2];
+    std::vector<unsigned int> _sortCounts;                     // The count, then the offset, of each digit in each block.
+    unsigned int _sortCount;
+    unsigned int _sortBlockSize;
+    unsigned int _sortPass;
+    float _sortMin;
+    float _sortScale;
+    bool _sorted;
+    std::vector<std::vector<unsigned char*> > _freeMemory;     // Free blocks by size class.
+    unsigned int _budget;
+    float _cullDistance;
+    unsigned int _poolSize;
+    Statistics _statistics;
+};
+
+}
+
+#endif
@@ -38,6 +38,27 @@ const char* Pass::getId() const
     return _id.c_str();
 }
 
+const char* Pass::getLabel() const
+{
+    // Built on first use, since materials are created before their URL is set.
+    if (_label.empty())
+    {
+        Material* material = _technique ? _technique->_material : NULL;
+        if (material && material->getUrl() && material->getUrl()[0] != '\0')
+            _label = material->getUrl();
+        else
+            _label = "material";
+        _label += ":";
+        if (_technique && !_technique->_id.empty())
+        {
+            _label += _technique->_id;
+            _label += "/";
+        }
+        _label += _id;
+    }
+    return _label.c_str();
+}
+
 Effect* Pass::getEffect() const
 {
     return _effect;
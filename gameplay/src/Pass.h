@@ -35,6 +35,15 @@ public:
      */
     Effect* getEffect() const;
 
+    /**
+     * Returns a label that identifies this pass in profiles and frame debuggers: the URL
+     * of its material, followed by the ids of its technique and of the pass.
+     *
+     * @return The label.
+     * @script{ignore}
+     */
+    const char* getLabel() const;
+
     /**
      * Sets a vertex attribute binding for this pass.
      *
@@ -109,6 +118,7 @@ private:
     Technique* _technique;
     Effect* _effect;
     VertexAttributeBinding* _vaBinding;
+    mutable std::string _label;
 };
 
 }
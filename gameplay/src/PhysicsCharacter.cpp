@@ -9,6 +9,10 @@
 #include "Scene.h"
 #include "Game.h"
 #include "PhysicsController.h"
+#include "PhysicsRigidBody.h"
+
+// The distance below which the movement of a character without velocity is dropped, so that it comes to rest.
+#define CHARACTER_REST_DISTANCE 0.0001f
 
 namespace gameplay
 {
@@ -53,7 +57,9 @@ PhysicsCharacter::PhysicsCharacter(Node* node, const PhysicsCollisionShape::Defi
     : PhysicsGhostObject(node, shape), _moveVelocity(0,0,0), _forwardVelocity(0.0f), _rightVelocity(0.0f),
     _verticalVelocity(0, 0, 0), _currentVelocity(0,0,0), _normalizedVelocity(0,0,0),
     _colliding(false), _collisionNormal(0,0,0), _currentPosition(0,0,0), _stepHeight(0.1f),
-    _slopeAngle(0.0f), _cosSlopeAngle(0.0f), _physicsEnabled(true), _mass(mass), _actionInterface(NULL)
+    _slopeAngle(0.0f), _cosSlopeAngle(0.0f), _physicsEnabled(true), _mass(mass),
+    _deferredTranslation(Vector3::zero()), _stepStart(0,0,0), _stepSkipped(false), _resting(false),
+    _restPosition(0,0,0), _forwardHit(false), _groundStatic(false), _cachedDistance(0.0f)
 {
     setMaxSlopeAngle(45.0f);
 
@@ -61,19 +67,15 @@ PhysicsCharacter::PhysicsCharacter(Node* node, const PhysicsCollisionShape::Defi
     GP_ASSERT(_ghostObject);
     _ghostObject->setCollisionFlags(_ghostObject->getCollisionFlags() | btCollisionObject::CF_CHARACTER_OBJECT | btCollisionObject::CF_NO_CONTACT_RESPONSE);
 
-    // Register ourselves as an action on the physics world so we are called back during physics ticks.
-    GP_ASSERT(Game::getInstance()->getPhysicsController() && Game::getInstance()->getPhysicsController()->_world);
-    _actionInterface = new ActionInterface(this);
-    Game::getInstance()->getPhysicsController()->_world->addAction(_actionInterface);
+    // The controller steps all the characters together during physics ticks.
+    GP_ASSERT(Game::getInstance()->getPhysicsController());
+    Game::getInstance()->getPhysicsController()->addCharacter(this);
 }
 
 PhysicsCharacter::~PhysicsCharacter()
 {
-    // Unregister ourselves as action from world.
-    GP_ASSERT(Game::getInstance()->getPhysicsController() && Game::getInstance()->getPhysicsController()->_world);
-    Game::getInstance()->getPhysicsController()->_world->removeAction(_actionInterface);
-    SAFE_DELETE(_actionInterface);
-
+    GP_ASSERT(Game::getInstance()->getPhysicsController());
+    Game::getInstance()->getPhysicsController()->removeCharacter(this);
 }
 
 PhysicsCharacter* PhysicsCharacter::create(Node* node, Properties* properties)
@@ -320,8 +322,6 @@ void PhysicsCharacter::stepUp(btCollisionWorld* collisionWorld, btScalar time)
 
 void PhysicsCharacter::stepForwardAndStrafe(btCollisionWorld* collisionWorld, float time)
 {
-    updateCurrentVelocity();
-
     // Calculate final velocity
     btVector3 velocity(_currentVelocity);
     velocity *= time; // since velocity is in meters per second
@@ -380,14 +380,16 @@ void PhysicsCharacter::stepForwardAndStrafe(btCollisionWorld* collisionWorld, fl
         if (callback.hasHit())
         {
             Vector3 normal(callback.m_hitNormalWorld.x(), callback.m_hitNormalWorld.y(), callback.m_hitNormalWorld.z());
+            _forwardHit = true;
             PhysicsCollisionObject* o = Game::getInstance()->getPhysicsController()->getCollisionObject(callback.m_hitCollisionObject);
             GP_ASSERT(o);
             if (o->getType() == PhysicsCollisionObject::RIGID_BODY && o->isDynamic())
             {
-                PhysicsRigidBody* rb = static_cast<PhysicsRigidBody*>(o);
-                GP_ASSERT(rb);
                 normal.normalize();
-                rb->applyImpulse(_mass * -normal * velocity.length());
+                Impulse impulse;
+                impulse.body = static_cast<PhysicsRigidBody*>(o);
+                impulse.impulse = _mass * -normal * velocity.length();
+                _impulses.push_back(impulse);
             }
 
             updateTargetPositionFromCollision(targetPosition, callback.m_hitNormalWorld);
@@ -460,24 +462,26 @@ void PhysicsCharacter::stepDown(btCollisionWorld* collisionWorld, btScalar time)
             normal.normalize();
 
             float dot = normal.dot(Vector3::unitY());
+            PhysicsCollisionObject* o = Game::getInstance()->getPhysicsController()->getCollisionObject(callback.m_hitCollisionObject);
+            GP_ASSERT(o);
             if (dot > 1.0f - MATH_EPSILON)
             {
                 targetPosition.setInterpolate3(_currentPosition, targetPosition, callback.m_closestHitFraction);
 
                 // Zero out fall velocity when we hit an object going straight down.
                 _verticalVelocity.setZero();
+                _groundStatic = o->isStatic();
                 break;
             }
             else
             {
-                PhysicsCollisionObject* o = Game::getInstance()->getPhysicsController()->getCollisionObject(callback.m_hitCollisionObject);
-                GP_ASSERT(o);
                 if (o->getType() == PhysicsCollisionObject::RIGID_BODY && o->isDynamic())
                 {
-                    PhysicsRigidBody* rb = static_cast<PhysicsRigidBody*>(o);
-                    GP_ASSERT(rb);
                     normal.normalize();
-                    rb->applyImpulse(_mass * -normal * sqrt(BV(normal).dot(_verticalVelocity)));
+                    Impulse impulse;
+                    impulse.body = static_cast<PhysicsRigidBody*>(o);
+                    impulse.impulse = _mass * -normal * sqrt(BV(normal).dot(_verticalVelocity));
+                    _impulses.push_back(impulse);
                 }
 
                 updateTargetPositionFromCollision(targetPosition, BV(normal));
@@ -569,6 +573,7 @@ bool PhysicsCharacter::fixCollision(btCollisionWorld* world)
     // Store our current world position.
     Vector3 startPosition;
     _node->getWorldMatrix().getTranslation(&startPosition);
+    startPosition += _deferredTranslation;
     btVector3 currentPosition = BV(startPosition);
 
     // Handle all collisions/overlapping pairs.
@@ -626,30 +631,64 @@ bool PhysicsCharacter::fixCollision(btCollisionWorld* world)
     // Set the new world transformation to apply to fix the collision.
     Vector3 newPosition = Vector3(currentPosition.x(), currentPosition.y(), currentPosition.z()) - startPosition;
     if (newPosition != Vector3::zero())
-        _node->translate(newPosition);
+        translate(newPosition);
 
     return collision;
 }
 
-PhysicsCharacter::ActionInterface::ActionInterface(PhysicsCharacter* character) : character(character)
+bool PhysicsCharacter::isDisturbed() const
 {
-}
+    GP_ASSERT(_ghostObject);
+    GP_ASSERT(Game::getInstance()->getPhysicsController());
 
-void PhysicsCharacter::ActionInterface::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
-{
-    character->updateAction(collisionWorld, deltaTimeStep);
-}
+    btOverlappingPairCache* pairCache = _ghostObject->getOverlappingPairCache();
+    GP_ASSERT(pairCache);
+    for (int i = 0, count = pairCache->getNumOverlappingPairs(); i < count; ++i)
+    {
+        const btBroadphasePair& pair = pairCache->getOverlappingPairArray()[i];
+        const btCollisionObject* other = (const btCollisionObject*)(pair.m_pProxy0->m_clientObject == _ghostObject ? pair.m_pProxy1->m_clientObject : pair.m_pProxy0->m_clientObject);
+        PhysicsCollisionObject* object = Game::getInstance()->getPhysicsController()->getCollisionObject(other);
+        if (!object || object->getType() == PhysicsCollisionObject::GHOST_OBJECT)
+            continue;
 
-void PhysicsCharacter::ActionInterface::debugDraw(btIDebugDraw* debugDrawer)
-{
-    // Not used yet.
+        if (object->getType() == PhysicsCollisionObject::CHARACTER)
+        {
+            if (!static_cast<PhysicsCharacter*>(object)->_resting)
+                return true;
+        }
+        else if (!other->isStaticObject() && other->isActive())
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+void PhysicsCharacter::resolveCollisions(btCollisionWorld* collisionWorld)
 {
     GP_ASSERT(_ghostObject);
     GP_ASSERT(_node);
 
+    // Characters out of the world have no broadphase proxy to sweep with.
+    _stepSkipped = !_enabled || _suspended;
+    if (_stepSkipped)
+    {
+        _resting = false;
+        return;
+    }
+
+    // Nodes are only read here, on a single thread.
+    updateCurrentVelocity();
+
+    // A character that came to rest, has not been moved and is only touched by objects at rest
+    // would find the same contacts and sweep results as in the last step, so it keeps its place.
+    if (_resting && _currentVelocity.isZero() && _verticalVelocity.isZero() &&
+        _ghostObject->getWorldTransform().getOrigin() == _restPosition && !isDisturbed())
+    {
+        _stepSkipped = true;
+        return;
+    }
+
     // First check for existing collisions and attempt to respond/fix them.
     // Basically we are trying to move the character so that it does not penetrate
     // any other collision objects in the scene. We need to do this to ensure that
@@ -671,27 +710,100 @@ void PhysicsCharacter::updateAction(btCollisionWorld* collisionWorld, btScalar d
             }
         }
     }
+}
+
+void PhysicsCharacter::computeMovement(btCollisionWorld* collisionWorld, btScalar time, btScalar cacheDistance)
+{
+    GP_ASSERT(_ghostObject);
+
+    _impulses.clear();
 
     // Update current and target world positions.
-    btVector3 startPosition = _ghostObject->getWorldTransform().getOrigin();
-    _currentPosition = startPosition;
+    _stepStart = _ghostObject->getWorldTransform().getOrigin();
+    _currentPosition = _stepStart;
+    if (_stepSkipped)
+        return;
+
+    // Small moves over static ground, with nothing hit in the last sweep, reuse its results
+    // until the moves add up to the cache distance.
+    btScalar distance = (_currentVelocity * time).length();
+    if (_physicsEnabled && _groundStatic && !_forwardHit && !_colliding && _verticalVelocity.isZero() &&
+        _cachedDistance + distance < cacheDistance)
+    {
+        _cachedDistance += distance;
+        _currentPosition += _currentVelocity * time;
+        return;
+    }
+    _cachedDistance = 0.0f;
+    _forwardHit = false;
+    _groundStatic = false;
 
     // Process movement in the up direction.
     if (_physicsEnabled)
-        stepUp(collisionWorld, deltaTimeStep);
+        stepUp(collisionWorld, time);
     
     // Process horizontal movement.
-    stepForwardAndStrafe(collisionWorld, deltaTimeStep);
+    stepForwardAndStrafe(collisionWorld, time);
 
     // Process movement in the down direction.
     if (_physicsEnabled)
-        stepDown(collisionWorld, deltaTimeStep);
+        stepDown(collisionWorld, time);
+}
+
+void PhysicsCharacter::applyMovement()
+{
+    for (size_t i = 0, count = _impulses.size(); i < count; ++i)
+    {
+        _impulses[i].body->applyImpulse(_impulses[i].impulse);
+    }
+    _impulses.clear();
+
+    // A character without velocity that only moved by the rounding of its sweeps comes to rest.
+    btVector3 newPosition = _currentPosition - _stepStart;
+    if (!_stepSkipped)
+    {
+        _resting = _physicsEnabled && !_colliding && _currentVelocity.isZero() && _verticalVelocity.isZero() &&
+            newPosition.length2() < CHARACTER_REST_DISTANCE * CHARACTER_REST_DISTANCE;
+        if (_resting)
+            newPosition.setZero();
+    }
 
     // Set new position.
-    btVector3 newPosition = _currentPosition - startPosition;
     Vector3 translation = Vector3(newPosition.x(), newPosition.y(), newPosition.z());
     if (translation !=  Vector3::zero())
+        translate(translation);
+
+    if (_resting)
+        _restPosition = _ghostObject->getWorldTransform().getOrigin();
+}
+
+void PhysicsCharacter::translate(const Vector3& translation)
+{
+    if (Game::getInstance()->getPhysicsController()->isStepping())
+    {
+        // Nodes must not be modified from a worker thread, so only the ghost object
+        // is moved and the node is translated after the step.
+        _ghostObject->getWorldTransform().getOrigin() += BV(translation);
+        _deferredTranslation += translation;
+    }
+    else
+    {
+        // The ghost object listens to its node once per tick, but the collision
+        // steps read it right away, so move it along with the node.
+        _ghostObject->getWorldTransform().getOrigin() += BV(translation);
         _node->translate(translation);
+    }
+}
+
+void PhysicsCharacter::applyDeferredTranslation()
+{
+    GP_ASSERT(_node);
+
+    if (_deferredTranslation != Vector3::zero())
+    {
+        _node->translate(_deferredTranslation);
+        _deferredTranslation = Vector3::zero();
+    }
 }
 
 
@@ -22,6 +22,7 @@ namespace gameplay
 class PhysicsCharacter : public PhysicsGhostObject
 {
     friend class Node;
+    friend class PhysicsController;
 
 public:
 
@@ -228,24 +229,31 @@ private:
 
     bool fixCollision(btCollisionWorld* world);
 
-    /**
-     * Hides the callback interfaces within the PhysicsCharacter.
-     * @script{ignore}
-     */
-    class ActionInterface : public btActionInterface
-    {
-    public:
+    // Whether an object that touches the character may have moved since the last step.
+    bool isDisturbed() const;
 
-        ActionInterface(PhysicsCharacter* character);
+    void translate(const Vector3& translation);
 
-        void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+    void applyDeferredTranslation();
 
-        void debugDraw(btIDebugDraw* debugDrawer);
-        
-        PhysicsCharacter* character;
-    };
+    // First pass of a step: pushes the character out of the objects it penetrates.
+    void resolveCollisions(btCollisionWorld* world);
+
+    // Second pass of a step: sweeps the character along its velocity. Only reads the world,
+    // so the characters are swept in parallel; the results are applied by applyMovement().
+    void computeMovement(btCollisionWorld* world, btScalar time, btScalar cacheDistance);
 
-    void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+    // Last pass of a step: moves the character and applies the impulses of its collisions.
+    void applyMovement();
+
+    /**
+     * An impulse applied by the character to a dynamic rigid body it walks into.
+     */
+    struct Impulse
+    {
+        PhysicsRigidBody* body;
+        Vector3 impulse;
+    };
 
     btVector3 _moveVelocity;
     float _forwardVelocity;
@@ -262,7 +270,15 @@ private:
     float _cosSlopeAngle;
     bool _physicsEnabled;
     float _mass;
-    ActionInterface* _actionInterface;
+    Vector3 _deferredTranslation;
+    btVector3 _stepStart;
+    std::vector<Impulse> _impulses;
+    bool _stepSkipped;
+    bool _resting;
+    btVector3 _restPosition;
+    bool _forwardHit;
+    bool _groundStatic;
+    btScalar _cachedDistance;
 };
 
 }
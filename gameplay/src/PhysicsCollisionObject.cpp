@@ -35,7 +35,7 @@ struct CollidesWithCallback : public btCollisionWorld::ContactResultCallback
 };
 
 PhysicsCollisionObject::PhysicsCollisionObject(Node* node)
-    : _node(node), _collisionShape(NULL), _enabled(true), _scriptListeners(NULL), _motionState(NULL)
+    : _node(node), _collisionShape(NULL), _enabled(true), _suspended(false), _scriptListeners(NULL), _motionState(NULL)
 {
 }
 
@@ -117,6 +117,8 @@ void PhysicsCollisionObject::setEnabled(bool enable)
         {
             Game::getInstance()->getPhysicsController()->addCollisionObject(this);
             _motionState->updateTransformFromNode();
+            if (_suspended)
+                Game::getInstance()->getPhysicsController()->suspendCollisionObject(this, true);
             _enabled = true;
         }
     }
@@ -130,6 +132,33 @@ void PhysicsCollisionObject::setEnabled(bool enable)
     }
 }
 
+bool PhysicsCollisionObject::isSuspended() const
+{
+    return _suspended;
+}
+
+void PhysicsCollisionObject::setSuspended(bool suspend)
+{
+    if (suspend == _suspended)
+        return;
+
+    if (!suspend)
+        _motionState->updateTransformFromNode();
+    Game::getInstance()->getPhysicsController()->suspendCollisionObject(this, suspend);
+    _suspended = suspend;
+}
+
+void PhysicsCollisionObject::warpToNode()
+{
+    PhysicsController* physicsController = Game::getInstance()->getPhysicsController();
+    GP_ASSERT(physicsController);
+
+    // A step running on a worker thread would write its transform over the node afterwards.
+    physicsController->finishAsyncStep();
+    _motionState->updateTransformFromNode();
+    physicsController->placeCollisionObject(this);
+}
+
 void PhysicsCollisionObject::addCollisionListener(CollisionListener* listener, PhysicsCollisionObject* object)
 {
     GP_ASSERT(Game::getInstance()->getPhysicsController());
@@ -231,7 +260,7 @@ bool PhysicsCollisionObject::CollisionPair::operator < (const CollisionPair& col
 }
 
 PhysicsCollisionObject::PhysicsMotionState::PhysicsMotionState(Node* node, PhysicsCollisionObject* collisionObject, const Vector3* centerOfMassOffset) :
-    _node(node), _collisionObject(collisionObject), _centerOfMassOffset(btTransform::getIdentity())
+    _node(node), _collisionObject(collisionObject), _centerOfMassOffset(btTransform::getIdentity()), _pending(false)
 {
     if (centerOfMassOffset)
     {
@@ -251,7 +280,8 @@ void PhysicsCollisionObject::PhysicsMotionState::getWorldTransform(btTransform &
     GP_ASSERT(_node);
     GP_ASSERT(_collisionObject);
 
-    if (_collisionObject->isKinematic())
+    // Kinematic transforms are synchronized on the game thread before an asynchronous step.
+    if (_collisionObject->isKinematic() && !Game::getInstance()->getPhysicsController()->isStepping())
         updateTransformFromNode();
 
     transform = _centerOfMassOffset.inverse() * _worldTransform;
@@ -262,6 +292,13 @@ void PhysicsCollisionObject::PhysicsMotionState::setWorldTransform(const btTrans
     GP_ASSERT(_node);
 
     _worldTransform = transform * _centerOfMassOffset;
+
+    // Nodes must not be modified from a worker thread, so the transform is applied after the step.
+    if (Game::getInstance()->getPhysicsController()->isStepping())
+    {
+        _pending = true;
+        return;
+    }
         
     const btQuaternion& rot = _worldTransform.getRotation();
     const btVector3& pos = _worldTransform.getOrigin();
@@ -301,6 +338,21 @@ void PhysicsCollisionObject::PhysicsMotionState::setCenterOfMassOffset(const Vec
     _centerOfMassOffset.setOrigin(BV(centerOfMassOffset));
 }
 
+void PhysicsCollisionObject::PhysicsMotionState::applyPendingTransform()
+{
+    GP_ASSERT(_node);
+
+    if (!_pending)
+        return;
+    _pending = false;
+
+    const btQuaternion& rot = _worldTransform.getRotation();
+    const btVector3& pos = _worldTransform.getOrigin();
+
+    _node->setRotation(rot.x(), rot.y(), rot.z(), rot.w());
+    _node->setTranslation(pos.x(), pos.y(), pos.z());
+}
+
 PhysicsCollisionObject::ScriptListener::ScriptListener(const char* url)
     : url(url)
 {
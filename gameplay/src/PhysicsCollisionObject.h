@@ -212,6 +212,40 @@ public:
      */
     void setEnabled(bool enable);
 
+    /**
+     * Returns whether this collision object is suspended.
+     *
+     * @return true if the collision object is suspended.
+     */
+    bool isSuspended() const;
+
+    /**
+     * Suspends or resumes the collision object in place.
+     *
+     * A suspended collision object stays in the physics world, but it does not collide
+     * with anything, is not hit by ray and sweep tests, and is not simulated. Unlike
+     * setEnabled(false), which removes the object from the world, suspending does not
+     * touch the broadphase or the collision listeners of the object, so objects that are
+     * taken out of play and brought back often, such as pooled objects, can be suspended
+     * without any allocation. A resumed object is placed at the transform of its node
+     * and, for rigid bodies, starts at rest.
+     *
+     * @param suspend true suspends the collision object, false resumes it.
+     */
+    void setSuspended(bool suspend);
+
+    /**
+     * Moves the collision object to the transform of its node at once.
+     *
+     * The physics system drives the nodes of dynamic objects, so moving such a node does
+     * not move its object. This places the object where its node is instead, without
+     * sweeping through the space in between, and wakes it up. The velocities of rigid
+     * bodies are kept.
+     *
+     * @script{ignore}
+     */
+    void warpToNode();
+
     /**
      * Adds a collision listener for this collision object.
      * 
@@ -351,6 +385,11 @@ protected:
      */
     bool _enabled;
 
+    /**
+     * If the collision object is suspended or not.
+     */
+    bool _suspended;
+
     /**
      * The list of script listeners.
      */
@@ -402,6 +441,11 @@ private:
          * Sets the center of mass offset for the associated collision shape.
          */
         void setCenterOfMassOffset(const Vector3& centerOfMassOffset);
+
+        /**
+         * Applies the transform set by Bullet during an asynchronous step to the node.
+         */
+        void applyPendingTransform();
         
     private:
         
@@ -409,6 +453,7 @@ private:
         PhysicsCollisionObject* _collisionObject;
         btTransform _centerOfMassOffset;
         mutable btTransform _worldTransform;
+        bool _pending;
     };
 
     /** 
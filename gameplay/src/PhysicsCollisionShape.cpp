@@ -19,6 +19,8 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
 {
     if (_shape)
     {
+        void* bvhData = NULL;
+
         // Cleanup shape-specific cached data.
         switch (_type)
         {
@@ -30,6 +32,7 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
                 {
                     SAFE_DELETE_ARRAY(_shapeData.meshData->indexData[i]);
                 }
+                bvhData = _shapeData.meshData->bvhData;
                 SAFE_DELETE(_shapeData.meshData);
             }
 
@@ -48,6 +51,10 @@ PhysicsCollisionShape::~PhysicsCollisionShape()
 
         // Free the bullet shape.
         SAFE_DELETE(_shape);
+
+        // The baked hierarchy is referenced by the mesh shape, so it is freed after it.
+        if (bvhData)
+            btAlignedFree(bvhData);
     }
 }
 
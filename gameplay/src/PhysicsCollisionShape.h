@@ -241,6 +241,9 @@ private:
     {
         float* vertexData;
         std::vector<unsigned char*> indexData;
+        std::string url;        // URL of the mesh the shape was created from.
+        Vector3 scale;          // Scale applied to the vertices.
+        void* bvhData;          // Baked hierarchy used by the shape, or NULL if it was built at runtime.
     };
 
     struct HeightfieldData
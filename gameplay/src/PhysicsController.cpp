@@ -2,10 +2,13 @@
 #include "PhysicsController.h"
 #include "PhysicsRigidBody.h"
 #include "PhysicsCharacter.h"
+#include "PhysicsVehicle.h"
 #include "Game.h"
 #include "MeshPart.h"
 #include "Bundle.h"
 #include "Terrain.h"
+#include "Scene.h"
+#include "Allocator.h"
 
 #ifdef GAMEPLAY_MEM_LEAK_DETECTION
 #undef new
@@ -18,6 +21,18 @@
 // The initial capacity of the Bullet debug drawer's vertex batch.
 #define INITIAL_CAPACITY 280
 
+// The minimum number of overlapping pairs processed per job by the parallel dispatcher.
+#define PARALLEL_DISPATCH_BATCH_SIZE 32
+
+// The minimum number of queries processed per job by the batched ray and sweep tests.
+#define QUERY_BATCH_SIZE 16
+
+// The minimum number of characters swept per job by the batched character pass.
+#define CHARACTER_BATCH_SIZE 8
+
+// The size of the header that holds the size of Bullet allocations, which keeps them aligned to 16 bytes.
+#define BULLET_ALLOCATION_HEADER_SIZE 16
+
 namespace gameplay
 {
 
@@ -26,21 +41,329 @@ const int PhysicsController::COLLISION     = 0x02;
 const int PhysicsController::REGISTERED    = 0x04;
 const int PhysicsController::REMOVE        = 0x08;
 
+// Bullet frees memory without its size, so the size is stored in front of every allocation.
+static void* allocateBulletMemory(size_t size)
+{
+    size += BULLET_ALLOCATION_HEADER_SIZE;
+    unsigned char* memory = (unsigned char*)Allocator::allocate(size, Allocator::PHYSICS);
+    if (memory == NULL)
+        return NULL;
+    *(size_t*)memory = size;
+    return memory + BULLET_ALLOCATION_HEADER_SIZE;
+}
+
+static void freeBulletMemory(void* memory)
+{
+    if (memory == NULL)
+        return;
+    unsigned char* block = (unsigned char*)memory - BULLET_ALLOCATION_HEADER_SIZE;
+    Allocator::deallocate(block, *(size_t*)block, Allocator::PHYSICS);
+}
+
+/**
+ * Collision dispatcher that runs the narrowphase of the overlapping pairs in parallel
+ * on the job scheduler. Manifold and algorithm allocation is serialized by a mutex.
+ */
+class ParallelCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+
+    ParallelCollisionDispatcher(btCollisionConfiguration* collisionConfiguration)
+        : btCollisionDispatcher(collisionConfiguration)
+    {
+    }
+
+    btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1)
+    {
+        MutexLock lock(_mutex);
+        return btCollisionDispatcher::getNewManifold(b0, b1);
+    }
+
+    void releaseManifold(btPersistentManifold* manifold)
+    {
+        MutexLock lock(_mutex);
+        btCollisionDispatcher::releaseManifold(manifold);
+    }
+
+    void* allocateCollisionAlgorithm(int size)
+    {
+        MutexLock lock(_mutex);
+        return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+    }
+
+    void freeCollisionAlgorithm(void* ptr)
+    {
+        MutexLock lock(_mutex);
+        btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+    }
+
+    void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher)
+    {
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        unsigned int pairCount = (unsigned int)pairCache->getNumOverlappingPairs();
+        if (scheduler->getWorkerCount() == 0 || pairCount < PARALLEL_DISPATCH_BATCH_SIZE * 2)
+        {
+            btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+            return;
+        }
+
+        DispatchData data;
+        data.dispatcher = this;
+        data.pairs = pairCache->getOverlappingPairArrayPtr();
+        data.dispatchInfo = &dispatchInfo;
+        scheduler->parallelFor(pairCount, dispatchPairs, &data, PARALLEL_DISPATCH_BATCH_SIZE);
+    }
+
+private:
+
+    struct DispatchData
+    {
+        ParallelCollisionDispatcher* dispatcher;
+        btBroadphasePair* pairs;
+        const btDispatcherInfo* dispatchInfo;
+    };
+
+    static void dispatchPairs(unsigned int start, unsigned int end, void* cookie)
+    {
+        DispatchData* data = (DispatchData*)cookie;
+        ParallelCollisionDispatcher* dispatcher = data->dispatcher;
+        for (unsigned int i = start; i < end; ++i)
+        {
+            btBroadphasePair& pair = data->pairs[i];
+            btCollisionObject* colObj0 = (btCollisionObject*)pair.m_pProxy0->m_clientObject;
+            btCollisionObject* colObj1 = (btCollisionObject*)pair.m_pProxy1->m_clientObject;
+            if (dispatcher->needsCollision(colObj0, colObj1))
+                dispatcher->getNearCallback()(pair, *dispatcher, *data->dispatchInfo);
+        }
+    }
+
+    Mutex _mutex;
+};
+
+/**
+ * Closest hit ray test of a batched query, run on the leaves of the broadphase trees hit by the ray.
+ *
+ * The static btDbvt::rayTest is used since, unlike the world and broadphase ray tests,
+ * it keeps its traversal stack local and can run on several threads at once.
+ */
+class BatchRayTest : public btCollisionWorld::ClosestRayResultCallback, public btDbvt::ICollide
+{
+public:
+
+    BatchRayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, int mask)
+        : btCollisionWorld::ClosestRayResultCallback(rayFromWorld, rayToWorld)
+    {
+        m_collisionFilterMask = mask;
+        _rayFromTrans.setIdentity();
+        _rayFromTrans.setOrigin(rayFromWorld);
+        _rayToTrans.setIdentity();
+        _rayToTrans.setOrigin(rayToWorld);
+    }
+
+    bool needsCollision(btBroadphaseProxy* proxy0) const
+    {
+        if (!btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy0))
+            return false;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        return co->getUserPointer() != NULL;
+    }
+
+    void Process(const btDbvtNode* leaf)
+    {
+        btBroadphaseProxy* proxy = reinterpret_cast<btBroadphaseProxy*>(leaf->data);
+        if (!needsCollision(proxy))
+            return;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy->m_clientObject);
+        btCollisionWorld::rayTestSingle(_rayFromTrans, _rayToTrans, co, co->getCollisionShape(), co->getWorldTransform(), *this);
+    }
+
+private:
+
+    btTransform _rayFromTrans;
+    btTransform _rayToTrans;
+};
+
+/**
+ * Ray test of a vehicle wheel, which ignores the chassis of the vehicle.
+ */
+class WheelRayTest : public BatchRayTest
+{
+public:
+
+    WheelRayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, const btCollisionObject* me)
+        : BatchRayTest(rayFromWorld, rayToWorld, -1), _me(me)
+    {
+    }
+
+    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
+    {
+        if (rayResult.m_collisionObject == _me)
+            return 1.0f;
+
+        return BatchRayTest::addSingleResult(rayResult, normalInWorldSpace);
+    }
+
+private:
+
+    const btCollisionObject* _me;
+};
+
+/**
+ * Closest hit sweep test of a batched query, run on the leaves of the broadphase trees overlapping the sweep.
+ */
+class BatchSweepTest : public btCollisionWorld::ClosestConvexResultCallback, public btDbvt::ICollide
+{
+public:
+
+    BatchSweepTest(PhysicsCollisionObject* me, const btConvexShape* shape, const btTransform& start, const btTransform& end, int mask, btScalar allowedPenetration)
+        : btCollisionWorld::ClosestConvexResultCallback(start.getOrigin(), end.getOrigin()),
+        _me(me), _shape(shape), _start(start), _end(end), _allowedPenetration(allowedPenetration)
+    {
+        m_collisionFilterMask = mask;
+    }
+
+    bool needsCollision(btBroadphaseProxy* proxy0) const
+    {
+        if (!btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0))
+            return false;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        PhysicsCollisionObject* object = reinterpret_cast<PhysicsCollisionObject*>(co->getUserPointer());
+        return object != NULL && object != _me;
+    }
+
+    void Process(const btDbvtNode* leaf)
+    {
+        btBroadphaseProxy* proxy = reinterpret_cast<btBroadphaseProxy*>(leaf->data);
+        if (!needsCollision(proxy))
+            return;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy->m_clientObject);
+        btCollisionWorld::objectQuerySingle(_shape, _start, _end, co, co->getCollisionShape(), co->getWorldTransform(), *this, _allowedPenetration);
+    }
+
+private:
+
+    PhysicsCollisionObject* _me;
+    const btConvexShape* _shape;
+    btTransform _start;
+    btTransform _end;
+    btScalar _allowedPenetration;
+};
+
+struct QueryBatch
+{
+    btDbvtBroadphase* broadphase;
+    btScalar allowedPenetration;
+    const void* queries;
+    PhysicsController::HitResult* results;
+};
+
+static void setHitResult(PhysicsController::HitResult* result, const btCollisionObject* object, const btVector3& point, btScalar fraction, const btVector3& normal)
+{
+    if (object)
+    {
+        result->object = reinterpret_cast<PhysicsCollisionObject*>(object->getUserPointer());
+        result->point.set(point.x(), point.y(), point.z());
+        result->fraction = fraction;
+        result->normal.set(normal.x(), normal.y(), normal.z());
+    }
+    else
+    {
+        result->object = NULL;
+        result->point.set(0.0f, 0.0f, 0.0f);
+        result->fraction = 1.0f;
+        result->normal.set(0.0f, 0.0f, 0.0f);
+    }
+}
+
+static void rayTestRange(unsigned int start, unsigned int end, void* cookie)
+{
+    QueryBatch* batch = (QueryBatch*)cookie;
+    const PhysicsController::RayQuery* queries = (const PhysicsController::RayQuery*)batch->queries;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        const PhysicsController::RayQuery& query = queries[i];
+        btVector3 rayFromWorld(BV(query.ray.getOrigin()));
+        btVector3 rayToWorld(rayFromWorld + BV(query.ray.getDirection() * query.distance));
+
+        BatchRayTest test(rayFromWorld, rayToWorld, query.mask);
+        btDbvt::rayTest(batch->broadphase->m_sets[0].m_root, rayFromWorld, rayToWorld, test);
+        btDbvt::rayTest(batch->broadphase->m_sets[1].m_root, rayFromWorld, rayToWorld, test);
+
+        setHitResult(&batch->results[i], test.hasHit() ? test.m_collisionObject : NULL, test.m_hitPointWorld, test.m_closestHitFraction, test.m_hitNormalWorld);
+    }
+}
+
+static void sweepTestRange(unsigned int start, unsigned int end, void* cookie)
+{
+    QueryBatch* batch = (QueryBatch*)cookie;
+    const PhysicsController::SweepQuery* queries = (const PhysicsController::SweepQuery*)batch->queries;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        const PhysicsController::SweepQuery& query = queries[i];
+        PhysicsCollisionShape* shape = query.object->getCollisionShape();
+        PhysicsCollisionShape::Type type = shape->getType();
+        if (type != PhysicsCollisionShape::SHAPE_BOX && type != PhysicsCollisionShape::SHAPE_SPHERE && type != PhysicsCollisionShape::SHAPE_CAPSULE)
+        {
+            setHitResult(&batch->results[i], NULL, btVector3(), 0.0f, btVector3());
+            continue;
+        }
+
+        // Define the start and end transforms (node world matrices were resolved before the batch started).
+        btTransform startTransform;
+        startTransform.setIdentity();
+        if (query.object->getNode())
+        {
+            Vector3 translation;
+            Quaternion rotation;
+            const Matrix& m = query.object->getNode()->getWorldMatrix();
+            m.getTranslation(&translation);
+            m.getRotation(&rotation);
+            startTransform.setOrigin(BV(translation));
+            startTransform.setRotation(BQ(rotation));
+        }
+        btTransform endTransform(startTransform);
+        endTransform.setOrigin(BV(query.endPosition));
+
+        // The bounds of a translation-only sweep are the union of the bounds at both ends.
+        const btConvexShape* convexShape = static_cast<const btConvexShape*>(shape->getShape());
+        btVector3 min, max, endMin, endMax;
+        convexShape->getAabb(startTransform, min, max);
+        convexShape->getAabb(endTransform, endMin, endMax);
+        min.setMin(endMin);
+        max.setMax(endMax);
+        btDbvtVolume volume = btDbvtVolume::FromMM(min, max);
+
+        BatchSweepTest test(query.object, convexShape, startTransform, endTransform, query.mask, batch->allowedPenetration);
+        batch->broadphase->m_sets[0].collideTV(batch->broadphase->m_sets[0].m_root, volume, test);
+        batch->broadphase->m_sets[1].collideTV(batch->broadphase->m_sets[1].m_root, volume, test);
+
+        setHitResult(&batch->results[i], test.hasHit() ? test.m_hitCollisionObject : NULL, test.m_hitPointWorld, test.m_closestHitFraction, test.m_hitNormalWorld);
+    }
+}
+
 PhysicsController::PhysicsController()
   : _isUpdating(false), _collisionConfiguration(NULL), _dispatcher(NULL),
     _overlappingPairCache(NULL), _solver(NULL), _world(NULL), _ghostPairCallback(NULL),
     _debugDrawer(NULL), _status(PhysicsController::Listener::DEACTIVATED), _listeners(NULL),
-    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _collisionCallback(NULL)
+    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _statusEventCallbacks(NULL),
+    _asyncStep(false), _stepping(false), _stepTime(0.0f), _pendingStepTime(0.0f), _stepJob(NULL),
+    _lodDistance(0.0f), _characterAction(NULL), _parallelCharacters(false), _characterCacheDistance(0.01f),
+    _vehicleAction(NULL), _vehicleLodDistance(0.0f), _vehicleLodInterval(4),
+    _activeBodyCount(0), _skippedBodyCount(0)
 {
     // Default gravity is 9.8 along the negative Y axis.
-    _collisionCallback = new CollisionCallback(this);
-
     addScriptEvent("statusEvent", "[PhysicsController::Listener::EventType]");
+
+    // Keep the callback slot of the status event to avoid a lookup every update.
+    _statusEventCallbacks = &_callbacks["statusEvent"];
 }
 
 PhysicsController::~PhysicsController()
 {
-    SAFE_DELETE(_collisionCallback);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_debugDrawer);
     SAFE_DELETE(_listeners);
@@ -154,11 +477,60 @@ void PhysicsController::setGravity(const Vector3& gravity)
         _world->setGravity(BV(_gravity));
 }
 
+void PhysicsController::setAsyncStepEnabled(bool enabled)
+{
+    if (!enabled)
+    {
+        finishAsyncStep();
+
+        // Step the time that was accumulated for the next asynchronous step.
+        if (_world && _pendingStepTime > 0.0f)
+            _world->stepSimulation(_pendingStepTime * 0.001f, 10);
+        _pendingStepTime = 0.0f;
+    }
+    _asyncStep = enabled;
+}
+
+bool PhysicsController::isAsyncStepEnabled() const
+{
+    return _asyncStep;
+}
+
+bool PhysicsController::isStepping() const
+{
+    return _stepping;
+}
+
+void PhysicsController::setLodDistance(float distance)
+{
+    _lodDistance = distance;
+}
+
+float PhysicsController::getLodDistance() const
+{
+    return _lodDistance;
+}
+
+unsigned int PhysicsController::getActiveBodyCount() const
+{
+    return _activeBodyCount;
+}
+
+unsigned int PhysicsController::getSkippedBodyCount() const
+{
+    return _skippedBodyCount;
+}
+
 void PhysicsController::drawDebug(const Matrix& viewProjection)
 {
     GP_ASSERT(_debugDrawer);
     GP_ASSERT(_world);
 
+    if (!Game::getInstance()->getDebugRenderer()->isEnabled(DebugRenderer::CATEGORY_PHYSICS))
+        return;
+
+    finishAsyncStep();
+
     _debugDrawer->begin(viewProjection);
     _world->debugDrawWorld();
     _debugDrawer->end();
@@ -217,6 +589,8 @@ bool PhysicsController::rayTest(const Ray& ray, float distance, PhysicsControlle
 
     GP_ASSERT(_world);
 
+    finishAsyncStep();
+
     btVector3 rayFromWorld(BV(ray.getOrigin()));
     btVector3 rayToWorld(rayFromWorld + BV(ray.getDirection() * distance));
 
@@ -296,6 +670,8 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     if (type != PhysicsCollisionShape::SHAPE_BOX && type != PhysicsCollisionShape::SHAPE_SPHERE && type != PhysicsCollisionShape::SHAPE_CAPSULE)
         return false; // unsupported type
 
+    finishAsyncStep();
+
     // Define the start transform.
     btTransform start;
     start.setIdentity();
@@ -354,83 +730,86 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     return false;
 }
 
-btScalar PhysicsController::CollisionCallback::addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, 
-    const btCollisionObjectWrapper* b, int partIdB, int indexB)
+unsigned int PhysicsController::rayTestBatch(const RayQuery* queries, unsigned int count, HitResult* results)
 {
-    GP_ASSERT(_pc);
+    GP_ASSERT(queries || count == 0);
+    GP_ASSERT(results || count == 0);
+    GP_ASSERT(_world);
 
-    // Get pointers to the PhysicsCollisionObject objects.
-    PhysicsCollisionObject* objectA = _pc->getCollisionObject(a->m_collisionObject);
-    PhysicsCollisionObject* objectB = _pc->getCollisionObject(b->m_collisionObject);
+    finishAsyncStep();
 
-    // If the given collision object pair has collided in the past, then
-    // we notify the listeners only if the pair was not colliding
-    // during the previous frame. Otherwise, it's a new pair, so add a
-    // new entry to the cache with the appropriate listeners and notify them.
-    PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
+    QueryBatch batch;
+    batch.broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    batch.allowedPenetration = _world->getDispatchInfo().m_allowedCcdPenetration;
+    batch.queries = queries;
+    batch.results = results;
+    Game::getInstance()->getJobScheduler()->parallelFor(count, rayTestRange, &batch, QUERY_BATCH_SIZE);
 
-    CollisionInfo* collisionInfo;
-    if (_pc->_collisionStatus.count(pair) > 0)
+    unsigned int hitCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
     {
-        collisionInfo = &_pc->_collisionStatus[pair];
+        if (results[i].object)
+            ++hitCount;
     }
-    else
-    {
-        // Add a new collision pair for these objects.
-        collisionInfo = &_pc->_collisionStatus[pair];
+    return hitCount;
+}
 
-        // Add the appropriate listeners.
-        PhysicsCollisionObject::CollisionPair p1(pair.objectA, NULL);
-        if (_pc->_collisionStatus.count(p1) > 0)
-        {
-            const CollisionInfo& ci = _pc->_collisionStatus[p1];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
-        }
-        PhysicsCollisionObject::CollisionPair p2(pair.objectB, NULL);
-        if (_pc->_collisionStatus.count(p2) > 0)
-        {
-            const CollisionInfo& ci = _pc->_collisionStatus[p2];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
-        }
-    }
+unsigned int PhysicsController::sweepTestBatch(const SweepQuery* queries, unsigned int count, HitResult* results)
+{
+    GP_ASSERT(queries || count == 0);
+    GP_ASSERT(results || count == 0);
+    GP_ASSERT(_world);
 
-    // Fire collision event.
-    if ((collisionInfo->_status & COLLISION) == 0)
+    finishAsyncStep();
+
+    // Resolve the lazily computed node world matrices here, so the workers only read them.
+    for (unsigned int i = 0; i < count; ++i)
     {
-        std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = collisionInfo->_listeners.begin();
-        for (; iter != collisionInfo->_listeners.end(); iter++)
-        {
-            GP_ASSERT(*iter);
-            if ((collisionInfo->_status & REMOVE) == 0)
-            {
-                (*iter)->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, Vector3(cp.getPositionWorldOnA().x(), cp.getPositionWorldOnA().y(), cp.getPositionWorldOnA().z()),
-                    Vector3(cp.getPositionWorldOnB().x(), cp.getPositionWorldOnB().y(), cp.getPositionWorldOnB().z()));
-            }
-        }
+        GP_ASSERT(queries[i].object && queries[i].object->getCollisionShape());
+        if (queries[i].object->getNode())
+            queries[i].object->getNode()->getWorldMatrix();
     }
 
-    // Update the collision status cache (we remove the dirty bit
-    // set in the controller's update so that this particular collision pair's
-    // status is not reset to 'no collision' when the controller's update completes).
-    collisionInfo->_status &= ~DIRTY;
-    collisionInfo->_status |= COLLISION;
-    return 0.0f;
+    QueryBatch batch;
+    batch.broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    batch.allowedPenetration = _world->getDispatchInfo().m_allowedCcdPenetration;
+    batch.queries = queries;
+    batch.results = results;
+    Game::getInstance()->getJobScheduler()->parallelFor(count, sweepTestRange, &batch, QUERY_BATCH_SIZE);
+
+    unsigned int hitCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (results[i].object)
+            ++hitCount;
+    }
+    return hitCount;
 }
 
-void PhysicsController::initialize()
+void PhysicsController::initialize(Properties* properties)
 {
+    // Route the memory of Bullet through the allocator, before any Bullet object is created.
+    btAlignedAllocSetCustom(allocateBulletMemory, freeBulletMemory);
+
+    bool parallelCollision = false;
+    if (properties)
+    {
+        parallelCollision = properties->getBool("parallelCollision");
+        _asyncStep = properties->getBool("asyncStep");
+        _lodDistance = properties->getFloat("lodDistance");
+        _parallelCharacters = properties->getBool("parallelCharacters");
+        if (properties->exists("characterCacheDistance"))
+            _characterCacheDistance = properties->getFloat("characterCacheDistance");
+        _vehicleLodDistance = properties->getFloat("vehicleLodDistance");
+        if (properties->exists("vehicleLodInterval"))
+            _vehicleLodInterval = (unsigned int)std::max(1, properties->getInt("vehicleLodInterval"));
+    }
+
     _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>();
-    _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
+    if (parallelCollision)
+        _dispatcher = bullet_new<ParallelCollisionDispatcher>(_collisionConfiguration);
+    else
+        _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
     _overlappingPairCache = bullet_new<btDbvtBroadphase>();
     _solver = bullet_new<btSequentialImpulseConstraintSolver>();
 
@@ -444,6 +823,14 @@ void PhysicsController::initialize()
     _world->getPairCache()->setInternalGhostPairCallback(_ghostPairCallback);
     _world->getDispatchInfo().m_allowedCcdPenetration = 0.0001f;
 
+    // A single action steps all the characters, so that they can be processed together.
+    _characterAction = new CharacterAction(this);
+    _world->addAction(_characterAction);
+
+    // Likewise for the vehicles, so that the rays of their wheels are cast in one batch.
+    _vehicleAction = new VehicleAction(this);
+    _world->addAction(_vehicleAction);
+
     // Set up debug drawing.
     _debugDrawer = new DebugDrawer();
     _world->setDebugDrawer(_debugDrawer);
@@ -451,7 +838,15 @@ void PhysicsController::initialize()
 
 void PhysicsController::finalize()
 {
+    finishAsyncStep();
+
     // Clean up the world and its various components.
+    if (_world && _characterAction)
+        _world->removeAction(_characterAction);
+    SAFE_DELETE(_characterAction);
+    if (_world && _vehicleAction)
+        _world->removeAction(_vehicleAction);
+    SAFE_DELETE(_vehicleAction);
     SAFE_DELETE(_world);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_solver);
@@ -462,7 +857,7 @@ void PhysicsController::finalize()
 
 void PhysicsController::pause()
 {
-    // Unused
+    finishAsyncStep();
 }
 
 void PhysicsController::resume()
@@ -472,18 +867,38 @@ void PhysicsController::resume()
 
 void PhysicsController::update(float elapsedTime)
 {
+    GP_PROFILE_SCOPE("PhysicsController::update");
+
     GP_ASSERT(_world);
-    _isUpdating = true;
 
-    // Update the physics simulation, with a maximum
-    // of 10 simulation steps being performed in a given frame.
-    //
-    // Note that stepSimulation takes elapsed time in seconds
-    // so we divide by 1000 to convert from milliseconds.
-    _world->stepSimulation(elapsedTime * 0.001f, 10);
+    if (_asyncStep)
+    {
+        // Apply the results of the step that ran during the last frame and
+        // accumulate the time for the next one, which starts in beginAsyncStep().
+        finishAsyncStep();
+        updateVehicleWheels(elapsedTime);
+        updateLod();
+        updateVehicleLod();
+        _pendingStepTime += elapsedTime;
+        _isUpdating = true;
+    }
+    else
+    {
+        updateLod();
+        updateVehicleLod();
+        _isUpdating = true;
+
+        // Update the physics simulation, with a maximum
+        // of 10 simulation steps being performed in a given frame.
+        //
+        // Note that stepSimulation takes elapsed time in seconds
+        // so we divide by 1000 to convert from milliseconds.
+        _world->stepSimulation(elapsedTime * 0.001f, 10);
+        updateVehicleWheels(elapsedTime);
+    }
 
     // If we have status listeners, then check if our status has changed.
-    if (_listeners || _callbacks["statusEvent"])
+    if (_listeners || *_statusEventCallbacks)
     {
         Listener::EventType oldStatus = _status;
 
@@ -539,61 +954,353 @@ void PhysicsController::update(float elapsedTime)
     //
     // If an entry was marked for removal in the last frame, remove it now.
 
-    // Dirty the collision status cache entries.
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end();)
+    // Remove the entries marked for removal and dirty the rest of the collision status cache entries.
+    bool removed = false;
+    for (size_t i = 0; i < _collisionStatus.size();)
     {
-        if ((iter->second._status & REMOVE) != 0)
+        CollisionInfo& info = _collisionStatus[i];
+        if ((info._status & REMOVE) != 0)
         {
-            std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator eraseIter = iter;
-            iter++;
-            _collisionStatus.erase(eraseIter);
+            // Move the last entry into the removed one's place.
+            CollisionInfo& last = _collisionStatus.back();
+            info._pair = last._pair;
+            info._status = last._status;
+            info._listeners.swap(last._listeners);
+            _collisionStatus.pop_back();
+            removed = true;
         }
         else
         {
-            iter->second._status |= DIRTY;
-            iter++;
+            info._status |= DIRTY;
+            ++i;
         }
     }
+    if (removed)
+        rebuildCollisionSlots(_collisionSlots.size());
 
-    // Go through the collision status cache and perform all registered collision tests.
-    iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end(); iter++)
+    // Fire the collision events from the contact manifolds that Bullet keeps for every
+    // overlapping pair, instead of running a separate contact test per registered pair.
+    if (!_collisionStatus.empty())
     {
-        // If this collision pair was one that was registered for listening, then perform the collision test.
-        // (In the case where we register for all collisions with a rigid body, there will be a lot
-        // of collision pairs in the status cache that we did not explicitly register for.)
-        if ((iter->second._status & REGISTERED) != 0 && (iter->second._status & REMOVE) == 0)
+        btDispatcher* dispatcher = _world->getDispatcher();
+        GP_ASSERT(dispatcher);
+        for (int i = 0; i < dispatcher->getNumManifolds(); ++i)
         {
-            if (iter->first.objectB)
-                _world->contactPairTest(iter->first.objectA->getCollisionObject(), iter->first.objectB->getCollisionObject(), *_collisionCallback);
-            else
-                _world->contactTest(iter->first.objectA->getCollisionObject(), *_collisionCallback);
+            btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+            GP_ASSERT(manifold);
+            if (manifold->getNumContacts() > 0)
+                processManifold(manifold);
         }
     }
 
     // Update all the collision status cache entries.
-    iter = _collisionStatus.begin();
-    for ( ; iter != _collisionStatus.end(); iter++)
+    for (size_t i = 0; i < _collisionStatus.size(); ++i)
     {
-        if ((iter->second._status & DIRTY) != 0)
+        if ((_collisionStatus[i]._status & DIRTY) != 0)
         {
-            if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
+            if ((_collisionStatus[i]._status & COLLISION) != 0 && _collisionStatus[i]._pair.objectB)
             {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
+                // Listeners may add entries to the cache, so the pair is copied and the entry is not referenced across calls.
+                PhysicsCollisionObject::CollisionPair pair = _collisionStatus[i]._pair;
+                for (size_t j = 0; j < _collisionStatus[i]._listeners.size(); ++j)
                 {
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, iter->first);
+                    _collisionStatus[i]._listeners[j]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, pair);
                 }
             }
 
-            iter->second._status &= ~COLLISION;
+            _collisionStatus[i]._status &= ~COLLISION;
         }
     }
 
     _isUpdating = false;
 }
 
+void PhysicsController::updateLod()
+{
+    GP_ASSERT(_world);
+
+    // Distances are measured from the active camera of the scene.
+    bool lod = false;
+    btVector3 eye(0.0f, 0.0f, 0.0f);
+    if (_lodDistance > 0.0f)
+    {
+        Scene* scene = Scene::getScene();
+        Camera* camera = scene ? scene->getActiveCamera() : NULL;
+        if (camera && camera->getNode())
+        {
+            eye = BV(camera->getNode()->getTranslationWorld());
+            lod = true;
+        }
+    }
+    btScalar lodDistanceSquared = _lodDistance * _lodDistance;
+
+    _activeBodyCount = 0;
+    _skippedBodyCount = 0;
+    bool frozen = false;
+    btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+    for (int i = 0, count = objects.size(); i < count; ++i)
+    {
+        PhysicsCollisionObject* object = getCollisionObject(objects[i]);
+        if (object == NULL || object->getType() != PhysicsCollisionObject::RIGID_BODY)
+            continue;
+
+        PhysicsRigidBody* body = static_cast<PhysicsRigidBody*>(object);
+        btRigidBody* rigidBody = body->_body;
+        GP_ASSERT(rigidBody);
+        if (body->_suspended || rigidBody->isStaticObject() || (rigidBody->isKinematicObject() && !body->_frozen))
+            continue;
+
+        // Put bodies beyond the distance to sleep and wake them when they come back.
+        bool distant = !body->_frozen && lod && rigidBody->getActivationState() != DISABLE_DEACTIVATION &&
+            rigidBody->getWorldTransform().getOrigin().distance2(eye) > lodDistanceSquared;
+        if (distant)
+        {
+            if (rigidBody->isActive())
+            {
+                rigidBody->forceActivationState(ISLAND_SLEEPING);
+                body->_lodSleeping = true;
+            }
+        }
+        else if (body->_lodSleeping)
+        {
+            body->_lodSleeping = false;
+            rigidBody->activate(true);
+        }
+
+        // Freeze freezable bodies that came to rest on their own.
+        if (body->_freezable && !body->_frozen && !body->_lodSleeping && rigidBody->getActivationState() == ISLAND_SLEEPING)
+            body->freeze();
+
+        if (body->_frozen)
+            frozen = true;
+        if (body->_frozen || !rigidBody->isActive())
+            ++_skippedBodyCount;
+        else
+            ++_activeBodyCount;
+    }
+
+    // Unfreeze the frozen bodies that are touched by an active dynamic body.
+    if (frozen)
+    {
+        btDispatcher* dispatcher = _world->getDispatcher();
+        GP_ASSERT(dispatcher);
+        for (int i = 0; i < dispatcher->getNumManifolds(); ++i)
+        {
+            btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+            GP_ASSERT(manifold);
+            if (manifold->getNumContacts() == 0)
+                continue;
+
+            const btCollisionObject* bodies[2] = { manifold->getBody0(), manifold->getBody1() };
+            for (int j = 0; j < 2; ++j)
+            {
+                PhysicsCollisionObject* object = getCollisionObject(bodies[j]);
+                const btCollisionObject* other = bodies[1 - j];
+                if (object && object->getType() == PhysicsCollisionObject::RIGID_BODY && static_cast<PhysicsRigidBody*>(object)->_frozen &&
+                    !other->isStaticOrKinematicObject() && other->isActive())
+                {
+                    static_cast<PhysicsRigidBody*>(object)->unfreeze();
+                    --_skippedBodyCount;
+                    ++_activeBodyCount;
+                }
+            }
+        }
+    }
+}
+
+void PhysicsController::processManifold(btPersistentManifold* manifold)
+{
+    PhysicsCollisionObject* objectA = getCollisionObject(manifold->getBody0());
+    PhysicsCollisionObject* objectB = getCollisionObject(manifold->getBody1());
+    if (objectA == NULL || objectB == NULL)
+        return;
+
+    // If the given collision object pair has collided in the past, then
+    // we notify the listeners only if the pair was not colliding
+    // during the previous frame. Otherwise, if either object has listeners for
+    // all of its collisions, add a new entry to the cache with those listeners.
+    int index = findCollisionInfo(PhysicsCollisionObject::CollisionPair(objectA, objectB));
+    if (index < 0)
+    {
+        int indexA = findCollisionInfo(PhysicsCollisionObject::CollisionPair(objectA, NULL));
+        int indexB = findCollisionInfo(PhysicsCollisionObject::CollisionPair(objectB, NULL));
+        if (indexA >= 0 && (_collisionStatus[indexA]._status & REMOVE) != 0)
+            indexA = -1;
+        if (indexB >= 0 && (_collisionStatus[indexB]._status & REMOVE) != 0)
+            indexB = -1;
+        if (indexA < 0 && indexB < 0)
+            return;
+
+        // The object with the listeners comes first in the pair.
+        if (indexA >= 0)
+            index = insertCollisionInfo(PhysicsCollisionObject::CollisionPair(objectA, objectB));
+        else
+            index = insertCollisionInfo(PhysicsCollisionObject::CollisionPair(objectB, objectA));
+
+        std::vector<PhysicsCollisionObject::CollisionListener*>& listeners = _collisionStatus[index]._listeners;
+        if (indexA >= 0)
+            listeners.insert(listeners.end(), _collisionStatus[indexA]._listeners.begin(), _collisionStatus[indexA]._listeners.end());
+        if (indexB >= 0)
+            listeners.insert(listeners.end(), _collisionStatus[indexB]._listeners.begin(), _collisionStatus[indexB]._listeners.end());
+    }
+
+    // Fire collision event.
+    if ((_collisionStatus[index]._status & (COLLISION | REMOVE)) == 0)
+    {
+        PhysicsCollisionObject::CollisionPair pair = _collisionStatus[index]._pair;
+        const btManifoldPoint& point = manifold->getContactPoint(0);
+        btVector3 pointA = point.getPositionWorldOnA();
+        btVector3 pointB = point.getPositionWorldOnB();
+        if (pair.objectA != objectA)
+            std::swap(pointA, pointB);
+        Vector3 contactPointA(pointA.x(), pointA.y(), pointA.z());
+        Vector3 contactPointB(pointB.x(), pointB.y(), pointB.z());
+
+        // Listeners may add entries to the cache, so the entry is looked up again after every call.
+        for (size_t i = 0; i < _collisionStatus[index]._listeners.size(); ++i)
+        {
+            if ((_collisionStatus[index]._status & REMOVE) != 0)
+                break;
+
+            GP_ASSERT(_collisionStatus[index]._listeners[i]);
+            _collisionStatus[index]._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, contactPointA, contactPointB);
+        }
+    }
+
+    // Update the collision status cache (we remove the dirty bit
+    // set in the controller's update so that this particular collision pair's
+    // status is not reset to 'no collision' when the controller's update completes).
+    _collisionStatus[index]._status &= ~DIRTY;
+    _collisionStatus[index]._status |= COLLISION;
+}
+
+static size_t hashCollisionPair(const PhysicsCollisionObject::CollisionPair& pair)
+{
+    // The hash must not depend on the order of the objects in the pair.
+    size_t a = (size_t)pair.objectA;
+    size_t b = (size_t)pair.objectB;
+    size_t value = (a < b ? a : b) * 31 + (a < b ? b : a);
+    value ^= value >> 16;
+    value *= 0x45d9f3b;
+    value ^= value >> 16;
+    return value;
+}
+
+static bool equalCollisionPairs(const PhysicsCollisionObject::CollisionPair& a, const PhysicsCollisionObject::CollisionPair& b)
+{
+    return (a.objectA == b.objectA && a.objectB == b.objectB) || (a.objectA == b.objectB && a.objectB == b.objectA);
+}
+
+int PhysicsController::findCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) const
+{
+    if (_collisionSlots.empty())
+        return -1;
+
+    // Open addressing with linear probing.
+    size_t mask = _collisionSlots.size() - 1;
+    for (size_t slot = hashCollisionPair(pair) & mask; _collisionSlots[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        if (equalCollisionPairs(_collisionStatus[_collisionSlots[slot]]._pair, pair))
+            return _collisionSlots[slot];
+    }
+    return -1;
+}
+
+int PhysicsController::insertCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair)
+{
+    GP_ASSERT(findCollisionInfo(pair) < 0);
+
+    // Keep the load factor of the slots at or below one half.
+    if ((_collisionStatus.size() + 1) * 2 > _collisionSlots.size())
+        rebuildCollisionSlots(std::max(_collisionSlots.size() * 2, (size_t)16));
+
+    int index = (int)_collisionStatus.size();
+    _collisionStatus.push_back(CollisionInfo(pair));
+
+    size_t mask = _collisionSlots.size() - 1;
+    size_t slot = hashCollisionPair(pair) & mask;
+    while (_collisionSlots[slot] >= 0)
+        slot = (slot + 1) & mask;
+    _collisionSlots[slot] = index;
+    return index;
+}
+
+void PhysicsController::rebuildCollisionSlots(size_t slotCount)
+{
+    _collisionSlots.assign(slotCount, -1);
+
+    size_t mask = slotCount - 1;
+    for (size_t i = 0, count = _collisionStatus.size(); i < count; ++i)
+    {
+        size_t slot = hashCollisionPair(_collisionStatus[i]._pair) & mask;
+        while (_collisionSlots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        _collisionSlots[slot] = (int)i;
+    }
+}
+
+void PhysicsController::beginAsyncStep()
+{
+    GP_ASSERT(_world);
+
+    if (!_asyncStep || _stepping || _pendingStepTime <= 0.0f)
+        return;
+
+    // Synchronize kinematic and ghost objects with their nodes on this thread,
+    // which also resolves the lazily computed node world matrices read during the step.
+    btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+    for (int i = 0, count = objects.size(); i < count; ++i)
+    {
+        PhysicsCollisionObject* object = getCollisionObject(objects[i]);
+        if (object && object->_motionState && object->isKinematic())
+            object->_motionState->updateTransformFromNode();
+    }
+
+    _stepTime = _pendingStepTime;
+    _pendingStepTime = 0.0f;
+    _stepping = true;
+    _stepJob = Game::getInstance()->getJobScheduler()->submit(stepJob, this);
+}
+
+void PhysicsController::finishAsyncStep()
+{
+    if (!_stepping)
+        return;
+
+    Game::getInstance()->getJobScheduler()->wait(_stepJob);
+    _stepJob = NULL;
+    _stepping = false;
+
+    // Apply the transforms that were deferred during the step.
+    btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+    for (int i = 0, count = objects.size(); i < count; ++i)
+    {
+        PhysicsCollisionObject* object = getCollisionObject(objects[i]);
+        if (object == NULL)
+            continue;
+
+        if (object->getType() == PhysicsCollisionObject::CHARACTER)
+        {
+            static_cast<PhysicsCharacter*>(object)->applyDeferredTranslation();
+            continue;
+        }
+
+        if (object->getType() == PhysicsCollisionObject::VEHICLE)
+            object = static_cast<PhysicsVehicle*>(object)->getRigidBody();
+        if (object->_motionState)
+            object->_motionState->applyPendingTransform();
+    }
+}
+
+void PhysicsController::stepJob(void* cookie)
+{
+    PhysicsController* controller = (PhysicsController*)cookie;
+    GP_ASSERT(controller && controller->_world);
+
+    // Note that stepSimulation takes elapsed time in seconds.
+    controller->_world->stepSimulation(controller->_stepTime * 0.001f, 10);
+}
+
 void PhysicsController::addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
 {
     GP_ASSERT(listener);
@@ -603,7 +1310,10 @@ void PhysicsController::addCollisionListener(PhysicsCollisionObject::CollisionLi
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
     // Add the listener and ensure the status includes that this collision pair is registered.
-    CollisionInfo& info = _collisionStatus[pair];
+    int index = findCollisionInfo(pair);
+    if (index < 0)
+        index = insertCollisionInfo(pair);
+    CollisionInfo& info = _collisionStatus[index];
     info._listeners.push_back(listener);
     info._status |= PhysicsController::REGISTERED;
 }
@@ -615,34 +1325,297 @@ void PhysicsController::removeCollisionListener(PhysicsCollisionObject::Collisio
     PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
 
     // Mark the collision pair for these objects for removal.
-    if (_collisionStatus.count(pair) > 0)
+    int index = findCollisionInfo(pair);
+    if (index >= 0)
+    {
+        _collisionStatus[index]._status |= REMOVE;
+    }
+}
+
+void PhysicsController::addCharacter(PhysicsCharacter* character)
+{
+    GP_ASSERT(character);
+
+    finishAsyncStep();
+    _characters.push_back(character);
+}
+
+void PhysicsController::removeCharacter(PhysicsCharacter* character)
+{
+    finishAsyncStep();
+
+    std::vector<PhysicsCharacter*>::iterator itr = std::find(_characters.begin(), _characters.end(), character);
+    if (itr != _characters.end())
+        _characters.erase(itr);
+}
+
+/**
+ * The arguments of the parallel pass of PhysicsController::updateCharacters.
+ */
+struct CharacterStep
+{
+    PhysicsController* controller;
+    btCollisionWorld* world;
+    btScalar timeStep;
+    btScalar cacheDistance;
+};
+
+void PhysicsController::updateCharacters(btCollisionWorld* world, btScalar timeStep)
+{
+    GP_PROFILE_SCOPE("PhysicsController::updateCharacters");
+
+    unsigned int count = (unsigned int)_characters.size();
+    if (count == 0)
+        return;
+
+    // Penetrations are resolved one character at a time, since they dispatch the
+    // contacts of the ghost objects and move the characters.
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _characters[i]->resolveCollisions(world);
+    }
+
+    // The sweeps only read the world, and every character sweeps from the position
+    // all characters had at the start of the pass, so the result does not depend on
+    // how the characters are split between the jobs.
+    CharacterStep step;
+    step.controller = this;
+    step.world = world;
+    step.timeStep = timeStep;
+    step.cacheDistance = _characterCacheDistance;
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (_parallelCharacters && scheduler->getWorkerCount() > 0 && count >= CHARACTER_BATCH_SIZE * 2)
+        scheduler->parallelFor(count, stepCharacters, &step, CHARACTER_BATCH_SIZE);
+    else
+        stepCharacters(0, count, &step);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _characters[i]->applyMovement();
+    }
+}
+
+void PhysicsController::stepCharacters(unsigned int start, unsigned int end, void* cookie)
+{
+    CharacterStep* step = (CharacterStep*)cookie;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        step->controller->_characters[i]->computeMovement(step->world, step->timeStep, step->cacheDistance);
+    }
+}
+
+PhysicsController::CharacterAction::CharacterAction(PhysicsController* controller)
+    : controller(controller)
+{
+}
+
+void PhysicsController::CharacterAction::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+{
+    controller->updateCharacters(collisionWorld, deltaTimeStep);
+}
+
+void PhysicsController::CharacterAction::debugDraw(btIDebugDraw* debugDrawer)
+{
+    // Not used.
+}
+
+void PhysicsController::addVehicle(PhysicsVehicle* vehicle)
+{
+    GP_ASSERT(vehicle);
+
+    finishAsyncStep();
+    _vehicles.push_back(vehicle);
+}
+
+void PhysicsController::removeVehicle(PhysicsVehicle* vehicle)
+{
+    finishAsyncStep();
+
+    std::vector<PhysicsVehicle*>::iterator itr = std::find(_vehicles.begin(), _vehicles.end(), vehicle);
+    if (itr != _vehicles.end())
+        _vehicles.erase(itr);
+}
+
+void PhysicsController::updateVehicleLod()
+{
+    // Vehicles outside of the view or beyond the distance from the active camera are simplified.
+    Camera* camera = NULL;
+    if (_vehicleLodDistance > 0.0f && !_vehicles.empty())
+    {
+        Scene* scene = Scene::getScene();
+        camera = scene ? scene->getActiveCamera() : NULL;
+        if (camera && !camera->getNode())
+            camera = NULL;
+    }
+    Vector3 eye = camera ? camera->getNode()->getTranslationWorld() : Vector3::zero();
+    float lodDistanceSquared = _vehicleLodDistance * _vehicleLodDistance;
+
+    for (size_t i = 0; i < _vehicles.size(); ++i)
+    {
+        PhysicsVehicle* vehicle = _vehicles[i];
+        vehicle->_visible = true;
+        vehicle->_simplified = false;
+        if (camera && vehicle->getNode())
+        {
+            const BoundingSphere& sphere = vehicle->getNode()->getBoundingSphere();
+            vehicle->_visible = camera->getFrustumPlanes().intersects(sphere);
+            vehicle->_simplified = !vehicle->_visible || sphere.center.distanceSquared(eye) > lodDistanceSquared;
+        }
+    }
+}
+
+/**
+ * The arguments of the parallel pass of PhysicsController::updateVehicles.
+ */
+struct WheelRayBatch
+{
+    btDbvtBroadphase* broadphase;
+    const std::pair<PhysicsVehicle*, int>* rays;
+};
+
+void PhysicsController::updateVehicles(btCollisionWorld* world, btScalar timeStep)
+{
+    GP_PROFILE_SCOPE("PhysicsController::updateVehicles");
+
+    // Gather the wheels whose rays are cast in this tick. Simplified vehicles cast their
+    // rays every few ticks, and in between intersect their wheels with the ground planes
+    // found by the last rays, unless one of their wheels stands on a body that can move.
+    _wheelRays.clear();
+    for (size_t i = 0; i < _vehicles.size(); ++i)
+    {
+        PhysicsVehicle* vehicle = _vehicles[i];
+        vehicle->_nextContact = 0;
+        if (!vehicle->_rigidBody->isEnabled() || vehicle->isSuspended())
+            continue;
+
+        btRaycastVehicle* raycastVehicle = vehicle->_vehicle;
+        int wheelCount = raycastVehicle->getNumWheels();
+        bool cast = !vehicle->_simplified || vehicle->_rayCountdown == 0 || vehicle->_contacts.size() != wheelCount;
+        for (int j = 0; j < vehicle->_contacts.size() && !cast; ++j)
+        {
+            const btRigidBody* body = vehicle->_contacts[j].body;
+            if (body && !body->isStaticObject())
+                cast = true;
+        }
+        if (!cast)
+        {
+            --vehicle->_rayCountdown;
+            continue;
+        }
+
+        vehicle->_rayCountdown = vehicle->_simplified ? _vehicleLodInterval - 1 : 0;
+        vehicle->_contacts.resize(wheelCount);
+        for (int j = 0; j < wheelCount; ++j)
+        {
+            raycastVehicle->updateWheelTransformsWS(raycastVehicle->getWheelInfo(j), false);
+            _wheelRays.push_back(std::make_pair(vehicle, j));
+        }
+    }
+
+    // The rays only read the world, so they are cast in parallel when there are enough of them.
+    unsigned int rayCount = (unsigned int)_wheelRays.size();
+    if (rayCount > 0)
+    {
+        WheelRayBatch batch;
+        batch.broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+        batch.rays = &_wheelRays[0];
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (scheduler->getWorkerCount() > 0 && rayCount >= QUERY_BATCH_SIZE * 2)
+            scheduler->parallelFor(rayCount, castWheelRays, &batch, QUERY_BATCH_SIZE);
+        else
+            castWheelRays(0, rayCount, &batch);
+    }
+
+    // The raycaster of each vehicle hands out the contacts of its wheels in order.
+    for (size_t i = 0; i < _vehicles.size(); ++i)
     {
-        _collisionStatus[pair]._status |= REMOVE;
+        PhysicsVehicle* vehicle = _vehicles[i];
+        if (vehicle->_rigidBody->isEnabled() && !vehicle->isSuspended())
+            vehicle->_vehicle->updateVehicle(timeStep);
     }
 }
 
+void PhysicsController::castWheelRays(unsigned int start, unsigned int end, void* cookie)
+{
+    WheelRayBatch* batch = (WheelRayBatch*)cookie;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        PhysicsVehicle* vehicle = batch->rays[i].first;
+        int index = batch->rays[i].second;
+
+        // The ray of the wheel, as cast by btRaycastVehicle::rayCast.
+        const btWheelInfo& wheel = vehicle->_vehicle->getWheelInfo(index);
+        const btVector3& rayFromWorld = wheel.m_raycastInfo.m_hardPointWS;
+        btVector3 rayToWorld = rayFromWorld + wheel.m_raycastInfo.m_wheelDirectionWS * (wheel.getSuspensionRestLength() + wheel.m_wheelsRadius);
+
+        WheelRayTest test(rayFromWorld, rayToWorld, vehicle->getCollisionObject());
+        btDbvt::rayTest(batch->broadphase->m_sets[0].m_root, rayFromWorld, rayToWorld, test);
+        btDbvt::rayTest(batch->broadphase->m_sets[1].m_root, rayFromWorld, rayToWorld, test);
+
+        PhysicsVehicle::WheelContact& contact = vehicle->_contacts[index];
+        contact.body = NULL;
+        contact.fresh = true;
+        if (test.hasHit())
+        {
+            const btRigidBody* body = btRigidBody::upcast(test.m_collisionObject);
+            if (body && body->hasContactResponse())
+            {
+                contact.point = test.m_hitPointWorld;
+                contact.normal = test.m_hitNormalWorld.normalized();
+                contact.fraction = test.m_closestHitFraction;
+                contact.body = body;
+            }
+        }
+    }
+}
+
+void PhysicsController::updateVehicleWheels(float elapsedTime)
+{
+    for (size_t i = 0; i < _vehicles.size(); ++i)
+    {
+        if (_vehicles[i]->_visible)
+            _vehicles[i]->updateWheels(elapsedTime);
+    }
+}
+
+PhysicsController::VehicleAction::VehicleAction(PhysicsController* controller)
+    : controller(controller)
+{
+}
+
+void PhysicsController::VehicleAction::updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep)
+{
+    controller->updateVehicles(collisionWorld, deltaTimeStep);
+}
+
+void PhysicsController::VehicleAction::debugDraw(btIDebugDraw* debugDrawer)
+{
+    // Not used.
+}
+
 void PhysicsController::addCollisionObject(PhysicsCollisionObject* object)
 {
     GP_ASSERT(object && object->getCollisionObject());
     GP_ASSERT(_world);
 
+    finishAsyncStep();
+
     // Assign user pointer for the bullet collision object to allow efficient
     // lookups of bullet objects -> gameplay objects.
     object->getCollisionObject()->setUserPointer(object);
 
     // Add the object to the physics world.
+    short group, mask;
+    getCollisionFilter(object->getType(), &group, &mask);
     switch (object->getType())
     {
     case PhysicsCollisionObject::RIGID_BODY:
-        _world->addRigidBody(static_cast<btRigidBody*>(object->getCollisionObject()), btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::StaticFilter | btBroadphaseProxy::CharacterFilter | btBroadphaseProxy::AllFilter);
+        _world->addRigidBody(static_cast<btRigidBody*>(object->getCollisionObject()), group, mask);
         break;
 
     case PhysicsCollisionObject::CHARACTER:
-        _world->addCollisionObject(object->getCollisionObject(), btBroadphaseProxy::CharacterFilter, btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::StaticFilter | btBroadphaseProxy::CharacterFilter | btBroadphaseProxy::AllFilter);
-        break;
-
     case PhysicsCollisionObject::GHOST_OBJECT:
-        _world->addCollisionObject(object->getCollisionObject(), btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::StaticFilter | btBroadphaseProxy::CharacterFilter | btBroadphaseProxy::AllFilter);
+        _world->addCollisionObject(object->getCollisionObject(), group, mask);
         break;
 
     default:
@@ -651,12 +1624,95 @@ void PhysicsController::addCollisionObject(PhysicsCollisionObject* object)
     }
 }
 
+void PhysicsController::suspendCollisionObject(PhysicsCollisionObject* object, bool suspend)
+{
+    GP_ASSERT(object && object->getCollisionObject());
+    GP_ASSERT(_world);
+    GP_ASSERT(!_isUpdating);
+
+    finishAsyncStep();
+
+    btCollisionObject* collisionObject = object->getCollisionObject();
+    PhysicsRigidBody* body = object->getType() == PhysicsCollisionObject::RIGID_BODY ? static_cast<PhysicsRigidBody*>(object) : NULL;
+    if (body && body->_frozen)
+        body->unfreeze();
+
+    // Disabled objects have no broadphase proxy; their filter is set when they are added back.
+    btBroadphaseProxy* proxy = collisionObject->getBroadphaseHandle();
+    if (suspend)
+    {
+        // An empty mask keeps the proxy out of new pairs and out of ray and sweep tests.
+        if (proxy)
+        {
+            proxy->m_collisionFilterGroup = 0;
+            proxy->m_collisionFilterMask = 0;
+            _world->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(proxy, _world->getDispatcher());
+        }
+        collisionObject->forceActivationState(DISABLE_SIMULATION);
+        if (body)
+        {
+            body->_lodSleeping = false;
+            body->_body->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+            body->_body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+            body->_body->clearForces();
+        }
+    }
+    else
+    {
+        if (proxy)
+        {
+            short group, mask;
+            getCollisionFilter(object->getType(), &group, &mask);
+            proxy->m_collisionFilterGroup = group;
+            proxy->m_collisionFilterMask = mask;
+        }
+
+        // Place the object where its node was moved while it was suspended.
+        placeCollisionObject(object);
+    }
+}
+
+void PhysicsController::placeCollisionObject(PhysicsCollisionObject* object)
+{
+    GP_ASSERT(object && object->getCollisionObject() && object->_motionState);
+    GP_ASSERT(_world);
+
+    btCollisionObject* collisionObject = object->getCollisionObject();
+    PhysicsRigidBody* body = object->getType() == PhysicsCollisionObject::RIGID_BODY ? static_cast<PhysicsRigidBody*>(object) : NULL;
+    if (body && body->_frozen)
+        body->unfreeze();
+
+    btTransform transform;
+    object->_motionState->getWorldTransform(transform);
+    collisionObject->setWorldTransform(transform);
+    collisionObject->setInterpolationWorldTransform(transform);
+    if (body)
+    {
+        body->_body->setInterpolationLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+        body->_body->setInterpolationAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+    }
+    collisionObject->forceActivationState(ACTIVE_TAG);
+    collisionObject->setDeactivationTime(0.0f);
+    if (collisionObject->getBroadphaseHandle())
+        _world->updateSingleAabb(collisionObject);
+}
+
+void PhysicsController::getCollisionFilter(PhysicsCollisionObject::Type type, short* group, short* mask)
+{
+    GP_ASSERT(group && mask);
+
+    *group = type == PhysicsCollisionObject::CHARACTER ? btBroadphaseProxy::CharacterFilter : btBroadphaseProxy::DefaultFilter;
+    *mask = btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::StaticFilter | btBroadphaseProxy::CharacterFilter | btBroadphaseProxy::AllFilter;
+}
+
 void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bool removeListeners)
 {
     GP_ASSERT(object);
     GP_ASSERT(_world);
     GP_ASSERT(!_isUpdating);
 
+    finishAsyncStep();
+
     // Remove the collision object from the world.
     if (object->getCollisionObject())
     {
@@ -680,11 +1736,10 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
     // Find all references to the object in the collision status cache and mark them for removal.
     if (removeListeners)
     {
-        std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-        for (; iter != _collisionStatus.end(); iter++)
+        for (size_t i = 0, count = _collisionStatus.size(); i < count; ++i)
         {
-            if (iter->first.objectA == object || iter->first.objectB == object)
-                iter->second._status |= REMOVE;
+            if (_collisionStatus[i]._pair.objectA == object || _collisionStatus[i]._pair.objectB == object)
+                _collisionStatus[i]._status |= REMOVE;
         }
     }
 }
@@ -760,6 +1815,16 @@ static void computeCenterOfMass(const Vector3& center, const Vector3& scale, Vec
     centerOfMassOffset->negate();
 }
 
+/**
+ * Gets the platform identifier written by the encoder with baked mesh hierarchies,
+ * which are only valid for the pointer size, float size and byte order they were built with.
+ */
+static unsigned int getBvhPlatform()
+{
+    unsigned short endianTest = 1;
+    return (unsigned int)sizeof(void*) | ((unsigned int)sizeof(btScalar) << 8) | ((*(unsigned char*)&endianTest == 0 ? 1u : 0u) << 16);
+}
+
 PhysicsCollisionShape* PhysicsController::createShape(Node* node, const PhysicsCollisionShape::Definition& shape, Vector3* centerOfMassOffset)
 {
     GP_ASSERT(node);
@@ -876,6 +1941,8 @@ PhysicsCollisionShape* PhysicsController::createShape(Node* node, const PhysicsC
                 // Build the heightfield from an attached terrain's height array
                 if (node->getTerrain() == NULL)
                     GP_ERROR("Empty heightfield collision shapes can only be used on nodes that have an attached Terrain.");
+                else if (node->getTerrain()->_heightfield == NULL)
+                    GP_ERROR("Empty heightfield collision shapes cannot be used with paged terrains.");
                 else
                     collisionShape = createHeightfield(node, node->getTerrain()->_heightfield, centerOfMassOffset);
             }
@@ -1002,16 +2069,36 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     GP_ASSERT(heightfield);
     GP_ASSERT(centerOfMassOffset);
 
-    // Inspect the height array for the min and max values
-    float* heights = heightfield->getArray();
+    // Inspect the height array for the min and max values. 16-bit heights are compared as stored
+    // and the extremes converted afterwards.
+    unsigned int count = heightfield->getColumnCount() * heightfield->getRowCount();
     float minHeight = FLT_MAX, maxHeight = -FLT_MAX;
-    for (unsigned int i = 0, count = heightfield->getColumnCount()*heightfield->getRowCount(); i < count; ++i)
+    if (heightfield->getFormat() == HeightField::FORMAT_SHORT)
     {
-        float h = heights[i];
-        if (h < minHeight)
-            minHeight = h;
-        if (h > maxHeight)
-            maxHeight = h;
+        const short* heights = heightfield->getShortArray();
+        short minValue = std::numeric_limits<short>::max(), maxValue = std::numeric_limits<short>::min();
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            short h = heights[i];
+            if (h < minValue)
+                minValue = h;
+            if (h > maxValue)
+                maxValue = h;
+        }
+        minHeight = heightfield->getHeightOffset() + minValue * heightfield->getHeightScale();
+        maxHeight = heightfield->getHeightOffset() + maxValue * heightfield->getHeightScale();
+    }
+    else
+    {
+        const float* heights = heightfield->getArray();
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            float h = heights[i];
+            if (h < minHeight)
+                minHeight = h;
+            if (h > maxHeight)
+                maxHeight = h;
+        }
     }
 
     // Compute initial heightfield scale by pulling the current world scale out of the node
@@ -1037,9 +2124,22 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     heightfieldData->minHeight = minHeight;
     heightfieldData->maxHeight = maxHeight;
 
-    // Create the bullet terrain shape
-    btHeightfieldTerrainShape* terrainShape = bullet_new<btHeightfieldTerrainShape>(
-        heightfield->getColumnCount(), heightfield->getRowCount(), heightfield->getArray(), 1.0f, minHeight, maxHeight, 1, PHY_FLOAT, false);
+    // Create the bullet terrain shape over the heightfield's own array. Bullet reads 16-bit heights
+    // as the stored value times the height scale, so the offset of the heights is left out of its
+    // height range; bullet centers the shape on that range either way, so the center of mass
+    // offset above still moves the shape to the real heights.
+    btHeightfieldTerrainShape* terrainShape;
+    if (heightfield->getFormat() == HeightField::FORMAT_SHORT)
+    {
+        float offset = heightfield->getHeightOffset();
+        terrainShape = bullet_new<btHeightfieldTerrainShape>(heightfield->getColumnCount(), heightfield->getRowCount(), heightfield->getShortArray(),
+            heightfield->getHeightScale(), minHeight - offset, maxHeight - offset, 1, PHY_SHORT, false);
+    }
+    else
+    {
+        terrainShape = bullet_new<btHeightfieldTerrainShape>(heightfield->getColumnCount(), heightfield->getRowCount(), heightfield->getArray(),
+            1.0f, minHeight, maxHeight, 1, PHY_FLOAT, false);
+    }
 
     // Set initial bullet local scaling for the heightfield
     terrainShape->setLocalScaling(BV(scale));
@@ -1089,6 +2189,24 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         return NULL;
     }
 
+    PhysicsCollisionShape* shape;
+
+    // Return the mesh shape from the cache if it was already created for the mesh at this scale.
+    for (unsigned int i = 0; i < _shapes.size(); ++i)
+    {
+        shape = _shapes[i];
+        GP_ASSERT(shape);
+        if (shape->getType() == PhysicsCollisionShape::SHAPE_MESH)
+        {
+            PhysicsCollisionShape::MeshData* meshData = shape->_shapeData.meshData;
+            if (meshData && meshData->scale == scale && meshData->url == mesh->getUrl())
+            {
+                shape->addRef();
+                return shape;
+            }
+        }
+    }
+
     Bundle::MeshData* data = Bundle::readMeshData(mesh->getUrl());
     if (data == NULL)
     {
@@ -1099,20 +2217,29 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     // Create mesh data to be populated and store in returned collision shape.
     PhysicsCollisionShape::MeshData* shapeMeshData = new PhysicsCollisionShape::MeshData();
     shapeMeshData->vertexData = NULL;
+    shapeMeshData->url = mesh->getUrl();
+    shapeMeshData->scale = scale;
+    shapeMeshData->bvhData = NULL;
 
     // Copy the scaled vertex position data to the rigid body's local buffer.
     Matrix m;
     Matrix::createScale(scale, &m);
     unsigned int vertexCount = data->vertexCount;
     shapeMeshData->vertexData = new float[vertexCount * 3];
+    if (data->hasPositionDecode)
+    {
+        m.translate(data->positionOffset);
+        m.scale(data->positionScale);
+    }
     Vector3 v;
+    float values[4];
+    const VertexFormat::Element& positionElement = data->vertexFormat.getElement(0);
     int vertexStride = data->vertexFormat.getVertexSize();
     for (unsigned int i = 0; i < data->vertexCount; i++)
     {
-        v.set(*((float*)&data->vertexData[i * vertexStride + 0 * sizeof(float)]),
-              *((float*)&data->vertexData[i * vertexStride + 1 * sizeof(float)]),
-              *((float*)&data->vertexData[i * vertexStride + 2 * sizeof(float)]));
-        v *= m;
+        VertexFormat::decode(positionElement, &data->vertexData[i * vertexStride], values);
+        v.set(values[0], values[1], values[2]);
+        m.transformPoint(&v);
         memcpy(&(shapeMeshData->vertexData[i * 3]), &v, sizeof(float) * 3);
     }
 
@@ -1197,9 +2324,41 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
         meshInterface->addIndexedMesh(indexedMesh, indexedMesh.m_indexType);
     }
 
+    // Use the hierarchy baked by the encoder instead of building one, if it was built
+    // over the same (unscaled) vertices for this platform.
+    btBvhTriangleMeshShape* meshShape = NULL;
+    if (data->bvhData && scale == Vector3::one())
+    {
+        if (data->bvhPlatform == getBvhPlatform() && data->bvhVersion == (unsigned int)btGetVersion())
+        {
+            // Bullet requires the serialized hierarchy to be 16-byte aligned.
+            void* bvhData = btAlignedAlloc(data->bvhSize, 16);
+            memcpy(bvhData, data->bvhData, data->bvhSize);
+            btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(bvhData, data->bvhSize, false);
+            if (bvh)
+            {
+                meshShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true, false);
+                meshShape->setOptimizedBvh(bvh);
+                shapeMeshData->bvhData = bvhData;
+            }
+            else
+            {
+                GP_WARN("Failed to load the baked collision hierarchy of mesh '%s'; building it instead.", mesh->getUrl());
+                btAlignedFree(bvhData);
+            }
+        }
+        else
+        {
+            GP_WARN("The baked collision hierarchy of mesh '%s' was built for another platform or Bullet version; building it instead.", mesh->getUrl());
+        }
+    }
+    if (meshShape == NULL)
+    {
+        meshShape = bullet_new<btBvhTriangleMeshShape>(meshInterface, true);
+    }
+
     // Create our collision shape object and store shapeMeshData in it.
-    PhysicsCollisionShape* shape =
-        new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_MESH, bullet_new<btBvhTriangleMeshShape>(meshInterface, true), meshInterface);
+    shape = new PhysicsCollisionShape(PhysicsCollisionShape::SHAPE_MESH, meshShape, meshInterface);
     shape->_shapeData.meshData = shapeMeshData;
 
     _shapes.push_back(shape);
@@ -1282,100 +2441,28 @@ void PhysicsController::removeConstraint(PhysicsConstraint* constraint)
 
 PhysicsController::DebugDrawer::DebugDrawer()
     : _mode(btIDebugDraw::DBG_DrawAabb | btIDebugDraw::DBG_DrawConstraintLimits | btIDebugDraw::DBG_DrawConstraints | 
-       btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawWireframe), _meshBatch(NULL), _lineCount(0)
-{
-    // Vertex shader for drawing colored lines.
-    const char* vs_str = 
-    {
-        "uniform mat4 u_viewProjectionMatrix;\n"
-        "attribute vec4 a_position;\n"
-        "attribute vec4 a_color;\n"
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "    v_color = a_color;\n"
-        "    gl_Position = u_viewProjectionMatrix * a_position;\n"
-        "}"
-    };
-
-    // Fragment shader for drawing colored lines.
-    const char* fs_str = 
-    {
-    #ifdef OPENGL_ES
-        "precision highp float;\n"
-    #endif
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "   gl_FragColor = v_color;\n"
-        "}"
-    };
-
-    Effect* effect = Effect::createFromSource(vs_str, fs_str);
-    Material* material = Material::create(effect);
-    GP_ASSERT(material && material->getStateBlock());
-    material->getStateBlock()->setDepthTest(true);
-    material->getStateBlock()->setDepthFunction(RenderState::DEPTH_LEQUAL);
-
-    VertexFormat::Element elements[] =
-    {
-        VertexFormat::Element(VertexFormat::POSITION, 3),
-        VertexFormat::Element(VertexFormat::COLOR, 4),
-    };
-    _meshBatch = MeshBatch::create(VertexFormat(elements, 2), Mesh::LINES, material, false, 4096, 4096);
-    SAFE_RELEASE(material);
-    SAFE_RELEASE(effect);
+       btIDebugDraw::DBG_DrawContactPoints | btIDebugDraw::DBG_DrawWireframe)
+{
 }
 
 PhysicsController::DebugDrawer::~DebugDrawer()
 {
-    SAFE_DELETE(_meshBatch);
 }
 
 void PhysicsController::DebugDrawer::begin(const Matrix& viewProjection)
 {
-    GP_ASSERT(_meshBatch);
-    _meshBatch->start();
-    _meshBatch->getMaterial()->getParameter("u_viewProjectionMatrix")->setValue(viewProjection);
+    _viewProjection = viewProjection;
 }
 
 void PhysicsController::DebugDrawer::end()
 {
-    GP_ASSERT(_meshBatch && _meshBatch->getMaterial());
-    _meshBatch->finish();
-    _meshBatch->draw();
-    _lineCount = 0;
+    Game::getInstance()->getDebugRenderer()->flush(_viewProjection);
 }
 
 void PhysicsController::DebugDrawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& fromColor, const btVector3& toColor)
 {
-    GP_ASSERT(_meshBatch);
-
-    static DebugDrawer::DebugVertex vertices[2];
-
-    vertices[0].x = from.getX();
-    vertices[0].y = from.getY();
-    vertices[0].z = from.getZ();
-    vertices[0].r = fromColor.getX();
-    vertices[0].g = fromColor.getY();
-    vertices[0].b = fromColor.getZ();
-    vertices[0].a = 1.0f;
-
-    vertices[1].x = to.getX();
-    vertices[1].y = to.getY();
-    vertices[1].z = to.getZ();
-    vertices[1].r = toColor.getX();
-    vertices[1].g = toColor.getY();
-    vertices[1].b = toColor.getZ();
-    vertices[1].a = 1.0f;
-
-    _meshBatch->add(vertices, 2);
-
-    ++_lineCount;
-    if (_lineCount >= 4096)
-    {
-        // Flush the batch when it gets full (don't want to to grow infinitely)
-        end();
-        _meshBatch->start();
-    }
+    Game::getInstance()->getDebugRenderer()->drawLine(Vector3(from.x(), from.y(), from.z()), Vector3(to.x(), to.y(), to.z()), Vector4(fromColor.x(), fromColor.y(), fromColor.z(), 1.0f),
+        Vector4(toColor.x(), toColor.y(), toColor.z(), 1.0f), DebugRenderer::CATEGORY_PHYSICS);
 }
 
 void PhysicsController::DebugDrawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& color)
@@ -1395,7 +2482,7 @@ void PhysicsController::DebugDrawer::reportErrorWarning(const char* warningStrin
 
 void PhysicsController::DebugDrawer::draw3dText(const btVector3& location, const char* textString)
 {
-    GP_WARN("Physics debug drawing: 3D text is not supported.");
+    Game::getInstance()->getDebugRenderer()->drawText(Vector3(location.x(), location.y(), location.z()), textString, Vector4::one(), DebugRenderer::CATEGORY_PHYSICS);
 }
 
 void PhysicsController::DebugDrawer::setDebugMode(int mode)
@@ -1418,6 +2505,26 @@ PhysicsController::HitFilter::HitFilter()
 {
 }
 
+PhysicsController::RayQuery::RayQuery()
+    : distance(0.0f), mask(-1)
+{
+}
+
+PhysicsController::RayQuery::RayQuery(const Ray& ray, float distance, int mask)
+    : ray(ray), distance(distance), mask(mask)
+{
+}
+
+PhysicsController::SweepQuery::SweepQuery()
+    : object(NULL), mask(-1)
+{
+}
+
+PhysicsController::SweepQuery::SweepQuery(PhysicsCollisionObject* object, const Vector3& endPosition, int mask)
+    : object(object), endPosition(endPosition), mask(mask)
+{
+}
+
 PhysicsController::HitFilter::~HitFilter()
 {
 }
@@ -11,6 +11,7 @@
 #include "MeshBatch.h"
 #include "HeightField.h"
 #include "ScriptTarget.h"
+#include "JobScheduler.h"
 
 namespace gameplay
 {
@@ -29,6 +30,7 @@ class PhysicsController : public ScriptTarget
     friend class PhysicsVehicle;
     friend class PhysicsCollisionObject;
     friend class PhysicsGhostObject;
+    friend class SceneSnapshot;
 
 public:
 
@@ -142,6 +144,86 @@ public:
         virtual bool hit(const HitResult& result);
     };
 
+    /**
+     * Defines a single ray of a batched ray test.
+     *
+     * @see PhysicsController::rayTestBatch
+     * @script{ignore}
+     */
+    struct RayQuery
+    {
+        /**
+         * Constructor.
+         */
+        RayQuery();
+
+        /**
+         * Constructor.
+         *
+         * @param ray The ray to test.
+         * @param distance How far along the given ray to test for intersections.
+         * @param mask The collision groups to test against.
+         */
+        RayQuery(const Ray& ray, float distance, int mask = -1);
+
+        /**
+         * The ray to test.
+         */
+        Ray ray;
+
+        /**
+         * How far along the ray to test for intersections.
+         */
+        float distance;
+
+        /**
+         * Bit mask of the collision groups to test against (all by default).
+         *
+         * Rigid bodies and ghost objects belong to group 1 and characters to group 32.
+         */
+        int mask;
+    };
+
+    /**
+     * Defines a single sweep of a batched sweep test.
+     *
+     * @see PhysicsController::sweepTestBatch
+     * @script{ignore}
+     */
+    struct SweepQuery
+    {
+        /**
+         * Constructor.
+         */
+        SweepQuery();
+
+        /**
+         * Constructor.
+         *
+         * @param object The collision object to sweep.
+         * @param endPosition The end position of the sweep, in world space.
+         * @param mask The collision groups to test against.
+         */
+        SweepQuery(PhysicsCollisionObject* object, const Vector3& endPosition, int mask = -1);
+
+        /**
+         * The collision object to sweep from its current world position.
+         */
+        PhysicsCollisionObject* object;
+
+        /**
+         * The end position of the sweep, in world space.
+         */
+        Vector3 endPosition;
+
+        /**
+         * Bit mask of the collision groups to test against (all by default).
+         *
+         * Rigid bodies and ghost objects belong to group 1 and characters to group 32.
+         */
+        int mask;
+    };
+
     /**
      * Adds a listener to the physics controller.
      * 
@@ -287,8 +369,73 @@ public:
      */
     void setGravity(const Vector3& gravity);
 
+    /**
+     * Sets whether the simulation is stepped asynchronously on a worker thread.
+     *
+     * When enabled, the world is stepped on the job scheduler while the frame is
+     * being rendered and the results are applied at the start of the next physics
+     * update, which adds one frame of latency between forces and node transforms.
+     * Queries and changes to the physics world wait for a running step to finish.
+     *
+     * @param enabled true to step the simulation asynchronously, false to step it on the game thread.
+     */
+    void setAsyncStepEnabled(bool enabled);
+
+    /**
+     * Determines whether the simulation is stepped asynchronously on a worker thread.
+     *
+     * @return true if the simulation is stepped asynchronously, false otherwise.
+     */
+    bool isAsyncStepEnabled() const;
+
+    /**
+     * Determines whether an asynchronous simulation step is currently running.
+     *
+     * @return true if a step is running on a worker thread, false otherwise.
+     */
+    bool isStepping() const;
+
+    /**
+     * Sets the distance from the active camera of the scene beyond which dynamic rigid
+     * bodies are put to sleep.
+     *
+     * Rigid bodies put to sleep this way keep their velocities and are woken up when
+     * they come back within the distance. Bodies that never deactivate (such as vehicles)
+     * are always simulated.
+     *
+     * @param distance The distance, or zero to simulate bodies at any distance (the default).
+     */
+    void setLodDistance(float distance);
+
+    /**
+     * Gets the distance from the active camera beyond which dynamic rigid bodies are put to sleep.
+     *
+     * @return The distance, or zero if bodies are simulated at any distance.
+     */
+    float getLodDistance() const;
+
+    /**
+     * Gets the number of dynamic rigid bodies that were simulated by the last update.
+     *
+     * @return The number of active rigid bodies.
+     */
+    unsigned int getActiveBodyCount() const;
+
+    /**
+     * Gets the number of dynamic rigid bodies that were skipped by the last update
+     * because they were sleeping, out of range or frozen.
+     *
+     * @return The number of skipped rigid bodies.
+     * @see PhysicsRigidBody::setFreezable
+     */
+    unsigned int getSkippedBodyCount() const;
+
     /**
      * Draws debugging information (rigid body outlines, etc.) using the given view projection matrix.
+     *
+     * The outlines are drawn through the game's DebugRenderer, in its physics category,
+     * together with the other debug primitives drawn since its last flush. The world is
+     * not visited when the physics category is disabled.
      * 
      * @param viewProjection The view projection matrix to use when drawing.
      */
@@ -327,30 +474,39 @@ public:
      */
     bool sweepTest(PhysicsCollisionObject* object, const Vector3& endPosition, PhysicsController::HitResult* result = NULL, PhysicsController::HitFilter* filter = NULL);
 
-private:
-
     /**
-     * Internal class used to integrate with Bullet collision callbacks.
+     * Performs a batch of ray tests against the physics world.
+     *
+     * The queries are split across the worker threads of the job scheduler and each one
+     * traverses the broadphase directly, so the call returns once all of them are done.
+     * Each result holds the closest object hit by the corresponding query, or a NULL
+     * object if the query hit nothing.
+     *
+     * @param queries The ray queries to perform.
+     * @param count The number of queries.
+     * @param results The array of count hit results to fill in.
+     *
+     * @return The number of queries that hit an object.
+     * @script{ignore}
      */
-    class CollisionCallback : public btCollisionWorld::ContactResultCallback
-    {
-    public:
-        /**
-         * Constructor.
-         * 
-         * @param pc The physics controller that owns the callback.
-         */
-        CollisionCallback(PhysicsController* pc) : _pc(pc) {}
+    unsigned int rayTestBatch(const RayQuery* queries, unsigned int count, HitResult* results);
 
-    protected:
-        /**
-            * Internal function used for Bullet integration (do not use or override).
-            */
-        btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, const btCollisionObjectWrapper* b, int partIdB, int indexB);    
+    /**
+     * Performs a batch of sweep tests against the physics world.
+     *
+     * Like sweepTest, only box, sphere and capsule shapes are supported; queries
+     * of other shapes never hit anything. The queries run in parallel as in rayTestBatch.
+     *
+     * @param queries The sweep queries to perform.
+     * @param count The number of queries.
+     * @param results The array of count hit results to fill in.
+     *
+     * @return The number of queries that hit an object.
+     * @script{ignore}
+     */
+    unsigned int sweepTestBatch(const SweepQuery* queries, unsigned int count, HitResult* results);
 
-    private:
-        PhysicsController* _pc;
-    };
+private:
 
     // Internal constants for the collision status cache.
     static const int DIRTY;
@@ -361,8 +517,9 @@ private:
     // Represents the collision listeners and status for a given collision pair (used by the collision status cache).
     struct CollisionInfo
     {
-        CollisionInfo() : _status(0) { }
+        CollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) : _pair(pair), _status(0) { }
 
+        PhysicsCollisionObject::CollisionPair _pair;
         std::vector<PhysicsCollisionObject::CollisionListener*> _listeners;
         int _status;
     };
@@ -379,8 +536,10 @@ private:
 
     /**
      * Controller initialize.
+     *
+     * @param properties The physics configuration namespace, or NULL to use the defaults.
      */
-    void initialize();
+    void initialize(Properties* properties);
 
     /**
      * Controller finalize.
@@ -402,6 +561,53 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Starts stepping the simulation on a worker thread with the time
+     * accumulated by update() since the last step (asynchronous mode only).
+     */
+    void beginAsyncStep();
+
+    /**
+     * Waits for a running asynchronous step and applies its results to the nodes.
+     */
+    void finishAsyncStep();
+
+    // Job function that steps the simulation.
+    static void stepJob(void* cookie);
+
+    // Puts distant rigid bodies to sleep, freezes and unfreezes freezable ones and counts the active bodies.
+    void updateLod();
+
+    // Registers a character to be stepped with the others.
+    void addCharacter(PhysicsCharacter* character);
+
+    // Unregisters a character.
+    void removeCharacter(PhysicsCharacter* character);
+
+    // Steps all the characters in one batched pass, called by the character action during each tick.
+    void updateCharacters(btCollisionWorld* world, btScalar timeStep);
+
+    // parallelFor function that computes the movement of a range of characters.
+    static void stepCharacters(unsigned int start, unsigned int end, void* cookie);
+
+    // Registers a vehicle to be stepped with the others.
+    void addVehicle(PhysicsVehicle* vehicle);
+
+    // Unregisters a vehicle.
+    void removeVehicle(PhysicsVehicle* vehicle);
+
+    // Picks the vehicles that are simulated in the simplified mode and the ones whose wheels are drawn.
+    void updateVehicleLod();
+
+    // Steps all the vehicles with one batch of wheel ray casts, called by the vehicle action during each tick.
+    void updateVehicles(btCollisionWorld* world, btScalar timeStep);
+
+    // parallelFor function that casts the rays of a range of wheels.
+    static void castWheelRays(unsigned int start, unsigned int end, void* cookie);
+
+    // Moves the wheel nodes of the visible vehicles to the result of the last step, once per frame.
+    void updateVehicleWheels(float elapsedTime);
+
     // Adds the given collision listener for the two given collision objects.
     void addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
 
@@ -413,10 +619,31 @@ private:
     
     // Removes the given collision object from the simulated physics world.
     void removeCollisionObject(PhysicsCollisionObject* object, bool removeListeners);
+
+    // Suspends the given collision object in place, or resumes it.
+    void suspendCollisionObject(PhysicsCollisionObject* object, bool suspend);
+
+    // Moves the given collision object to the transform of its motion state at once.
+    void placeCollisionObject(PhysicsCollisionObject* object);
+
+    // Gets the broadphase collision filter group and mask of the given type of collision object.
+    static void getCollisionFilter(PhysicsCollisionObject::Type type, short* group, short* mask);
     
     // Gets the corresponding GamePlay object for the given Bullet object.
     PhysicsCollisionObject* getCollisionObject(const btCollisionObject* collisionObject) const;
 
+    // Gets the index of the collision status cache entry for the given pair, or -1 if there is none.
+    int findCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair) const;
+
+    // Adds a collision status cache entry for the given pair and returns its index.
+    int insertCollisionInfo(const PhysicsCollisionObject::CollisionPair& pair);
+
+    // Rebuilds the hash slots of the collision status cache with the given (power of two) slot count.
+    void rebuildCollisionSlots(size_t slotCount);
+
+    // Fires the collision events for the contacts of the given manifold.
+    void processManifold(btPersistentManifold* manifold);
+
     // Creates a collision shape for the given node and gameplay shape definition.
     // Populates 'centerOfMassOffset' with the correct calculated center of mass offset.
     PhysicsCollisionShape* createShape(Node* node, const PhysicsCollisionShape::Definition& shape, Vector3* centerOfMassOffset);
@@ -439,12 +666,6 @@ private:
     // Destroys a collision shape created through PhysicsController
     void destroyShape(PhysicsCollisionShape* shape);
 
-    // Legacy method for grayscale heightmaps: r + g + b, normalized.
-    static float normalizedHeightGrayscale(float r, float g, float b);
-
-    // Higher precision method for heightmaps: 65536*r + 256*g + b, normalized.
-    static float normalizedHeightPacked(float r, float g, float b);
-
     // Sets up the given constraint for the given two rigid bodies.
     void addConstraint(PhysicsRigidBody* a, PhysicsRigidBody* b, PhysicsConstraint* constraint);
 
@@ -455,54 +676,46 @@ private:
     void removeConstraint(PhysicsConstraint* constraint);
     
     /**
-     * Draws Bullet debug information.
+     * Steps the characters from within the simulation ticks of the world.
      * @script{ignore}
      */
-    class DebugDrawer : public btIDebugDraw
+    class CharacterAction : public btActionInterface
     {
     public:
 
-        /** 
-         * DebugVertex.
-         * @script{ignore}
-         */
-        struct DebugVertex
-        {
-            /**
-             * The x coordinate of the vertex.
-             */
-            float x;
-    
-            /**
-             * The y coordinate of the vertex.
-             */
-            float y;
-    
-            /**
-             * The z coordinate of the vertex.
-             */
-            float z;
+        CharacterAction(PhysicsController* controller);
 
-            /**
-             * The red color component of the vertex.
-             */
-            float r;
-    
-            /**
-             * The green color component of the vertex.
-             */
-            float g;
-    
-            /**
-             * The blue color component of the vertex.
-             */
-            float b;
-    
-            /**
-             * The alpha component of the vertex.
-             */
-            float a;
-        };
+        void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+
+        void debugDraw(btIDebugDraw* debugDrawer);
+
+        PhysicsController* controller;
+    };
+
+    /**
+     * Steps the vehicles from within the simulation ticks of the world.
+     * @script{ignore}
+     */
+    class VehicleAction : public btActionInterface
+    {
+    public:
+
+        VehicleAction(PhysicsController* controller);
+
+        void updateAction(btCollisionWorld* collisionWorld, btScalar deltaTimeStep);
+
+        void debugDraw(btIDebugDraw* debugDrawer);
+
+        PhysicsController* controller;
+    };
+
+    /**
+     * Draws Bullet debug information.
+     * @script{ignore}
+     */
+    class DebugDrawer : public btIDebugDraw
+    {
+    public:
 
         /**
          * Constructor.
@@ -529,8 +742,7 @@ private:
     private:
         
         int _mode;
-        MeshBatch* _meshBatch;
-        int _lineCount;
+        Matrix _viewProjection;
     };
 
     bool _isUpdating;
@@ -545,8 +757,26 @@ private:
     Listener::EventType _status;
     std::vector<Listener*>* _listeners;
     Vector3 _gravity;
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo> _collisionStatus;
-    CollisionCallback* _collisionCallback;
+    std::vector<CollisionInfo> _collisionStatus;
+    std::vector<int> _collisionSlots;
+    std::vector<Callback>** _statusEventCallbacks;
+    bool _asyncStep;
+    bool _stepping;
+    float _stepTime;
+    float _pendingStepTime;
+    JobScheduler::Job* _stepJob;
+    float _lodDistance;
+    std::vector<PhysicsCharacter*> _characters;
+    CharacterAction* _characterAction;
+    bool _parallelCharacters;
+    float _characterCacheDistance;
+    std::vector<PhysicsVehicle*> _vehicles;
+    std::vector<std::pair<PhysicsVehicle*, int> > _wheelRays;
+    VehicleAction* _vehicleAction;
+    float _vehicleLodDistance;
+    unsigned int _vehicleLodInterval;
+    unsigned int _activeBodyCount;
+    unsigned int _skippedBodyCount;
 };
 
 }
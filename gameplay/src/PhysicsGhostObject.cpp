@@ -95,6 +95,11 @@ void PhysicsGhostObject::transformChanged(Transform* transform, long cookie)
     GP_ASSERT(_motionState);
     GP_ASSERT(_ghostObject);
 
+    // The ghost object is read by a running asynchronous step, so wait for it first.
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    if (controller->isStepping())
+        controller->finishAsyncStep();
+
     // Update the motion state with the transform from the node.
     _motionState->updateTransformFromNode();
 
@@ -11,7 +11,8 @@ namespace gameplay
 {
 
 PhysicsRigidBody::PhysicsRigidBody(Node* node, const PhysicsCollisionShape::Definition& shape, const Parameters& parameters)
-        : PhysicsCollisionObject(node), _body(NULL), _mass(parameters.mass), _constraints(NULL), _inDestructor(false)
+        : PhysicsCollisionObject(node), _body(NULL), _mass(parameters.mass), _constraints(NULL), _inDestructor(false),
+        _freezable(false), _frozen(false), _lodSleeping(false)
 {
     GP_ASSERT(Game::getInstance()->getPhysicsController());
     GP_ASSERT(_node);
@@ -191,6 +192,7 @@ PhysicsRigidBody* PhysicsRigidBody::create(Node* node, Properties* properties, c
     // Set the rigid body parameters to their defaults.
     Parameters parameters;
     Vector3* gravity = NULL;
+    bool freezable = false;
 
     // Load the defined rigid body parameters.
     properties->rewind();
@@ -225,6 +227,10 @@ PhysicsRigidBody* PhysicsRigidBody::create(Node* node, Properties* properties, c
         {
             properties->getVector3(NULL, &parameters.anisotropicFriction);
         }
+        else if (strcmp(name, "freezable") == 0)
+        {
+            freezable = properties->getBool();
+        }
         else if (strcmp(name, "gravity") == 0)
         {
             gravity = new Vector3();
@@ -252,6 +258,7 @@ PhysicsRigidBody* PhysicsRigidBody::create(Node* node, Properties* properties, c
         body->setGravity(*gravity);
         SAFE_DELETE(gravity);
     }
+    body->setFreezable(freezable);
 
     return body;
 }
@@ -260,6 +267,7 @@ void PhysicsRigidBody::setKinematic(bool kinematic)
 {
     GP_ASSERT(_body);
 
+    _frozen = false;
     if (kinematic)
     {
         _body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
@@ -272,6 +280,35 @@ void PhysicsRigidBody::setKinematic(bool kinematic)
     }
 }
 
+void PhysicsRigidBody::setFreezable(bool freezable)
+{
+    _freezable = freezable;
+    if (!freezable && _frozen)
+        unfreeze();
+}
+
+void PhysicsRigidBody::freeze()
+{
+    GP_ASSERT(_body);
+
+    // Sleeping kinematic bodies neither move nor wake the bodies they touch.
+    _frozen = true;
+    _body->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+    _body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+    _body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+    _body->forceActivationState(ISLAND_SLEEPING);
+}
+
+void PhysicsRigidBody::unfreeze()
+{
+    GP_ASSERT(_body);
+
+    _frozen = false;
+    _body->setCollisionFlags(_body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT);
+    _body->forceActivationState(ACTIVE_TAG);
+    _body->setDeactivationTime(0.0f);
+}
+
 void PhysicsRigidBody::setEnabled(bool enable)
 {
     PhysicsCollisionObject::setEnabled(enable);
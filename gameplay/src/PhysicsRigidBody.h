@@ -325,6 +325,34 @@ public:
      */
     void setKinematic(bool kinematic);
 
+    /**
+     * Sets whether the rigid body is frozen when it comes to rest.
+     *
+     * A frozen rigid body is turned into a sleeping kinematic body, so it no longer
+     * joins the simulation islands of the bodies resting against it, and it is turned
+     * back into a dynamic body as soon as an active dynamic body touches it.
+     * This suits static-ish clutter such as crates and debris.
+     *
+     * @param freezable Whether the rigid body is frozen when it comes to rest.
+     */
+    void setFreezable(bool freezable);
+
+    /**
+     * Gets whether the rigid body is frozen when it comes to rest.
+     *
+     * @return Whether the rigid body is freezable.
+     * @see setFreezable
+     */
+    inline bool isFreezable() const;
+
+    /**
+     * Gets whether the rigid body is currently frozen.
+     *
+     * @return Whether the rigid body is frozen.
+     * @see setFreezable
+     */
+    inline bool isFrozen() const;
+
     /**
      * Sets whether the rigid body is enabled or disabled in the physics world.
      *
@@ -431,10 +459,19 @@ private:
     // Used for implementing getHeight() when the heightfield has a transform that can change.
     void transformChanged(Transform* transform, long cookie);
 
+    // Turns the resting rigid body into a sleeping kinematic body.
+    void freeze();
+
+    // Turns the frozen rigid body back into an active dynamic body.
+    void unfreeze();
+
     btRigidBody* _body;
     float _mass;
     std::vector<PhysicsConstraint*>* _constraints;
     bool _inDestructor;
+    bool _freezable;
+    bool _frozen;
+    bool _lodSleeping;
 
 };
 
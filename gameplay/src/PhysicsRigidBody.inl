@@ -171,4 +171,14 @@ inline bool PhysicsRigidBody::isStatic() const
     return _body->isStaticObject();
 }
 
+inline bool PhysicsRigidBody::isFreezable() const
+{
+    return _freezable;
+}
+
+inline bool PhysicsRigidBody::isFrozen() const
+{
+    return _frozen;
+}
+
 }
@@ -41,6 +41,9 @@ private:
 };
 
 /**
+  * Hands out the wheel contacts found by the batched wheel rays of the physics controller,
+  * and casts the rays itself when the vehicle is updated outside of the controller.
+  *
   * @script{ignore}
   */
 class VehicleNotMeRaycaster : public btVehicleRaycaster
@@ -48,13 +51,44 @@ class VehicleNotMeRaycaster : public btVehicleRaycaster
 
 public:
 
-    VehicleNotMeRaycaster(btDynamicsWorld* world, btCollisionObject* me)
-        : _dynamicsWorld(world), _me(me)
+    VehicleNotMeRaycaster(btDynamicsWorld* world, PhysicsVehicle* host)
+        : _dynamicsWorld(world), _host(host), _me(host->getCollisionObject())
     {
     }
 
     void* castRay(const btVector3& from, const btVector3& to, btVehicleRaycasterResult& result)
     {
+        // The controller calls btRaycastVehicle::updateVehicle, which casts the rays of the wheels in order.
+        if (_host->_nextContact < (unsigned int)_host->_contacts.size())
+        {
+            PhysicsVehicle::WheelContact& contact = _host->_contacts[_host->_nextContact++];
+            if (contact.body == NULL)
+                return 0;
+
+            if (contact.fresh)
+            {
+                contact.fresh = false;
+                result.m_hitPointInWorld = contact.point;
+                result.m_hitNormalInWorld = contact.normal;
+                result.m_distFraction = contact.fraction;
+                return (void*)contact.body;
+            }
+
+            // Between the rays of a simplified vehicle, intersect the ray with the ground plane of the last contact.
+            btVector3 ray = to - from;
+            btScalar approach = ray.dot(contact.normal);
+            if (approach >= -SIMD_EPSILON)
+                return 0;
+            btScalar fraction = btMax(btScalar(0), (contact.point - from).dot(contact.normal) / approach);
+            if (fraction > 1)
+                return 0;
+
+            result.m_hitPointInWorld = from + ray * fraction;
+            result.m_hitNormalInWorld = contact.normal;
+            result.m_distFraction = fraction;
+            return (void*)contact.body;
+        }
+
         ClosestNotMeRayResultCallback rayCallback(from, to, _me);
         _dynamicsWorld->rayTest(from, to, rayCallback);
 
@@ -76,11 +110,12 @@ public:
 private:
 
     btDynamicsWorld* _dynamicsWorld;
+    PhysicsVehicle* _host;
     btCollisionObject* _me;
 };
 
 PhysicsVehicle::PhysicsVehicle(Node* node, const PhysicsCollisionShape::Definition& shape, const PhysicsRigidBody::Parameters& parameters)
-    : PhysicsCollisionObject(node), _speedSmoothed(0)
+    : PhysicsCollisionObject(node), _speedSmoothed(0), _nextContact(0), _rayCountdown(0), _simplified(false), _visible(true)
 {
     // Note that the constructor for PhysicsRigidBody calls addCollisionObject and so
     // that is where the rigid body gets added to the dynamics world.
@@ -90,7 +125,7 @@ PhysicsVehicle::PhysicsVehicle(Node* node, const PhysicsCollisionShape::Definiti
 }
 
 PhysicsVehicle::PhysicsVehicle(Node* node, PhysicsRigidBody* rigidBody)
-    : PhysicsCollisionObject(node), _speedSmoothed(0)
+    : PhysicsCollisionObject(node), _speedSmoothed(0), _nextContact(0), _rayCountdown(0), _simplified(false), _visible(true)
 {
     _rigidBody = rigidBody;
 
@@ -180,13 +215,13 @@ void PhysicsVehicle::initialize()
     setBoost(0, 1);
     setDownforce(0);
 
-    // Create the vehicle and add it to world
+    // Create the vehicle and register it with the controller, which steps all the vehicles together.
     btRigidBody* body = static_cast<btRigidBody*>(_rigidBody->getCollisionObject());
-    btDynamicsWorld* dynamicsWorld = Game::getInstance()->getPhysicsController()->_world;
-    _vehicleRaycaster = new VehicleNotMeRaycaster(dynamicsWorld, body);
+    PhysicsController* controller = Game::getInstance()->getPhysicsController();
+    _vehicleRaycaster = new VehicleNotMeRaycaster(controller->_world, this);
     _vehicle = bullet_new<btRaycastVehicle>(_vehicleTuning, body, _vehicleRaycaster);
     body->setActivationState(DISABLE_DEACTIVATION);
-    dynamicsWorld->addVehicle(_vehicle);
+    controller->addVehicle(this);
     _vehicle->setCoordinateSystem(0, 1, 2);
 
     // Advertise self among ancestor nodes so that wheels can bind to self.
@@ -201,7 +236,8 @@ PhysicsVehicle::~PhysicsVehicle()
 {
     // Note that the destructor for PhysicsRigidBody calls removeCollisionObject and so
     // that is where the rigid body gets removed from the dynamics world. The vehicle
-    // itself is just an action interface in the dynamics world.
+    // itself is stepped by the controller.
+    Game::getInstance()->getPhysicsController()->removeVehicle(this);
     SAFE_DELETE(_vehicle);
     SAFE_DELETE(_vehicleRaycaster);
     SAFE_DELETE(_rigidBody);
@@ -294,7 +330,15 @@ void PhysicsVehicle::update(float elapsedTime, float steering, float braking, fl
             _vehicle->applyEngineForce(driving * _drivingForce, i);
             _vehicle->setBrake(braking * _brakingForce, i);
         }
+    }
+}
 
+void PhysicsVehicle::updateWheels(float elapsedTime)
+{
+    PhysicsVehicleWheel* wheel;
+    for (int i = 0; i < _vehicle->getNumWheels(); i++)
+    {
+        wheel = getWheel(i);
         wheel->update(elapsedTime);
         wheel->transform(wheel->getNode());
     }
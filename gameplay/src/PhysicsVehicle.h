@@ -54,11 +54,21 @@ class PhysicsVehicleWheel;
         downforce      = <float>    // proportional control of downforce
     }
  @endverbatim
+ *
+ * All the vehicles are stepped together by the physics controller, which casts the
+ * rays of their wheels in one batch during each tick of the simulation. Vehicles that
+ * are outside of the view, or farther from the active camera than the vehicleLodDistance
+ * of the physics configuration, are simplified: they cast their wheel rays only every
+ * vehicleLodInterval ticks (4 by default) and rest on the ground planes found by the
+ * last rays in between. The wheel nodes are moved once per frame, after the simulation
+ * has been stepped, and only for vehicles in view.
  */
 class PhysicsVehicle : public PhysicsCollisionObject
 {
     friend class Node;
+    friend class PhysicsController;
     friend class PhysicsVehicleWheel;
+    friend class VehicleNotMeRaycaster;
 
 public:
 
@@ -115,7 +125,8 @@ public:
 
     /**
      * Updates the vehicle state using the specified normalized command
-     * inputs, and updates the transform on the visual node for each wheel.
+     * inputs. The visual nodes of the wheels are updated by the physics
+     * controller after the simulation is stepped.
      *
      * @param elapsedTime The elapsed game time.
      * @param steering steering command (-1 to 1).
@@ -404,6 +415,25 @@ private:
      */
     void applyDownforce();
 
+    /**
+     * Moves the wheel nodes to the wheel transforms of the last simulation step.
+     *
+     * @param elapsedTime The elapsed game time.
+     */
+    void updateWheels(float elapsedTime);
+
+    /**
+     * The ground contact of a wheel, found by the batched wheel rays of the physics controller.
+     */
+    struct WheelContact
+    {
+        btVector3 point;
+        btVector3 normal;
+        btScalar fraction;
+        const btRigidBody* body;
+        bool fresh;
+    };
+
     float _steeringGain;
     float _brakingForce;
     float _drivingForce;
@@ -422,6 +452,11 @@ private:
     btVehicleRaycaster* _vehicleRaycaster;
     btRaycastVehicle* _vehicle;
     std::vector<PhysicsVehicleWheel*> _wheels;
+    btAlignedObjectArray<WheelContact> _contacts;
+    unsigned int _nextContact;
+    unsigned int _rayCountdown;
+    bool _simplified;
+    bool _visible;
 };
 
 }
@@ -0,0 +1,328 @@
+#include "Base.h"
+#include "Picker.h"
+#include "Game.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Model.h"
+#include "MeshSkin.h"
+#include "Material.h"
+#include "Technique.h"
+#include "Pass.h"
+#include "FrameBuffer.h"
+#include "DepthStencilTarget.h"
+#include "ReadbackQueue.h"
+#include "RenderCommandList.h"
+#include "DebugMarkers.h"
+
+#define PICKER_ID "org.gameplay3d.picker"
+#define PICKER_VSH "res/shaders/picking.vert"
+#define PICKER_FSH "res/shaders/picking.frag"
+
+// Texture defines of a pass that the picking materials reproduce.
+#define PICKER_DISCARD_ALPHA 1
+#define PICKER_TEXTURE_REPEAT 2
+#define PICKER_TEXTURE_OFFSET 4
+
+// Node indices are packed into the red, green and blue channels; 0 is the background.
+#define PICKER_MAX_NODES 0xFFFFFF
+
+namespace gameplay
+{
+
+struct Picker::Request
+{
+    Picker* picker;
+    PickCallback callback;
+    void* cookie;
+    std::vector<Node*> nodes;
+};
+
+Picker::Picker()
+    : _radius(0), _frameBuffer(NULL), _drawCount(0)
+{
+}
+
+Picker::~Picker()
+{
+    for (std::map<unsigned int, Material*>::iterator itr = _materials.begin(); itr != _materials.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    SAFE_RELEASE(_frameBuffer);
+}
+
+Picker* Picker::create(unsigned int radius)
+{
+    unsigned int size = radius * 2 + 1;
+    FrameBuffer* frameBuffer = FrameBuffer::create(PICKER_ID, size, size);
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(PICKER_ID, DepthStencilTarget::DEPTH, size, size);
+    if (frameBuffer == NULL || depthTarget == NULL)
+    {
+        GP_ERROR("Failed to create the target of the picker.");
+        SAFE_RELEASE(frameBuffer);
+        SAFE_RELEASE(depthTarget);
+        return NULL;
+    }
+    frameBuffer->setDepthStencilTarget(depthTarget);
+    SAFE_RELEASE(depthTarget);
+
+    Picker* picker = new Picker();
+    picker->_radius = radius;
+    picker->_frameBuffer = frameBuffer;
+    return picker;
+}
+
+bool Picker::pick(Scene* scene, int x, int y, PickCallback callback, void* cookie)
+{
+    GP_ASSERT(scene);
+    GP_ASSERT(callback);
+
+    Game* game = Game::getInstance();
+    Camera* camera = scene->getActiveCamera();
+    ReadbackQueue* readbackQueue = game->getReadbackQueue();
+    if (camera == NULL || readbackQueue == NULL)
+        return false;
+    if (RenderCommandList::isRecording())
+    {
+        GP_WARN("Nodes cannot be picked while the frame is recorded for the render thread.");
+        return false;
+    }
+
+    // The center of the pixel under the point, relative to the viewport, with Y up as in GL.
+    Rectangle viewport = game->getViewport();
+    float px = x + 0.5f - viewport.x;
+    float py = game->getHeight() - (y + 0.5f) - viewport.y;
+    if (px < 0.0f || py < 0.0f || px >= viewport.width || py >= viewport.height)
+        return false;
+
+    // Scale and move the projection so that the pixels around the point fill the target.
+    float size = (float)(_radius * 2 + 1);
+    float scaleX = viewport.width / size;
+    float scaleY = viewport.height / size;
+    float ndcX = px * 2.0f / viewport.width - 1.0f;
+    float ndcY = py * 2.0f / viewport.height - 1.0f;
+    Matrix area(scaleX, 0.0f, 0.0f, -ndcX * scaleX,
+                0.0f, scaleY, 0.0f, -ndcY * scaleY,
+                0.0f, 0.0f, 1.0f, 0.0f,
+                0.0f, 0.0f, 0.0f, 1.0f);
+    Matrix::multiply(area, camera->getViewProjectionMatrix(), &_viewProjection);
+
+    _nodes.clear();
+    scene->findVisibleNodes(Frustum(_viewProjection), _nodes);
+
+    Request* request = new Request();
+    request->picker = this;
+    request->callback = callback;
+    request->cookie = cookie;
+    addRef();
+
+    DebugMarkers::Group marker("Picking");
+    FrameBuffer* previousFrameBuffer = _frameBuffer->bind();
+    game->setViewport(Rectangle(0, 0, size, size));
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
+
+    // The nodes keep their index until the pixels are read, so they are held until then.
+    static const unsigned int noPickTag = Node::getTagId("noPick");
+    for (size_t i = 0, count = _nodes.size(); i < count && request->nodes.size() < PICKER_MAX_NODES; ++i)
+    {
+        Node* node = _nodes[i];
+        if (node->getModel() == NULL || node->hasTag(noPickTag))
+            continue;
+
+        request->nodes.push_back(node);
+        node->addRef();
+        unsigned int id = (unsigned int)request->nodes.size();
+        drawNode(node, Vector4((id & 0xFF) / 255.0f, ((id >> 8) & 0xFF) / 255.0f, ((id >> 16) & 0xFF) / 255.0f, 1.0f));
+    }
+    _drawCount = (unsigned int)request->nodes.size();
+
+    readbackQueue->read(NULL, 0, 0, (unsigned int)size, (unsigned int)size, readComplete, request);
+
+    previousFrameBuffer->bind();
+    game->setViewport(viewport);
+    return true;
+}
+
+void Picker::drawNode(Node* node, const Vector4& color)
+{
+    Model* model = node->getModel();
+    MeshSkin* skin = model->getSkin();
+    unsigned int jointCount = skin ? skin->getJointCount() : 0;
+
+    // Each part is drawn with the first pass its own material draws it with, whose
+    // culling and alpha test the picking material reproduces.
+    unsigned int partCount = model->getMeshPartCount();
+    for (int i = partCount > 0 ? 0 : -1; i < (int)partCount; ++i)
+    {
+        Material* material = model->getMaterial(i);
+        if (material == NULL)
+            continue;
+        Technique* technique = model->getLodTechnique(material);
+        Pass* pass = technique ? technique->getPassByIndex(0) : NULL;
+        if (pass == NULL)
+            continue;
+
+        bool transparent;
+        bool depthWritten;
+        int culledSide;
+        pass->getStateKey(&transparent, &depthWritten, &culledSide);
+
+        unsigned int textureFlags = 0;
+        MaterialParameter* diffuse = NULL;
+        const char* effectId = pass->getEffect()->getId();
+        if (strstr(effectId, "TEXTURE_DISCARD_ALPHA"))
+        {
+            diffuse = findParameter(pass, "u_diffuseTexture");
+            if (diffuse && diffuse->getSampler())
+            {
+                textureFlags = PICKER_DISCARD_ALPHA;
+                if (strstr(effectId, "TEXTURE_REPEAT"))
+                    textureFlags |= PICKER_TEXTURE_REPEAT;
+                if (strstr(effectId, "TEXTURE_OFFSET"))
+                    textureFlags |= PICKER_TEXTURE_OFFSET;
+            }
+        }
+
+        Material* pickMaterial = getMaterial(jointCount, culledSide, textureFlags);
+        if (pickMaterial == NULL)
+            continue;
+
+        pickMaterial->getParameter("u_pickColor")->setValue(color);
+        if (textureFlags & PICKER_DISCARD_ALPHA)
+        {
+            pickMaterial->getParameter("u_diffuseTexture")->setValue(diffuse->getSampler());
+
+            // Tiling set as a single value is copied; tiling bound to a method is not.
+            const char* names[2] = { "u_textureRepeat", "u_textureOffset" };
+            const unsigned int flags[2] = { PICKER_TEXTURE_REPEAT, PICKER_TEXTURE_OFFSET };
+            for (unsigned int j = 0; j < 2; ++j)
+            {
+                if ((textureFlags & flags[j]) == 0)
+                    continue;
+                MaterialParameter* parameter = findParameter(pass, names[j]);
+                Vector2 value = j == 0 ? Vector2::one() : Vector2::zero();
+                if (parameter && parameter->_type == MaterialParameter::VECTOR2 && parameter->_count == 1)
+                    value = *reinterpret_cast<const Vector2*>(parameter->_value.floatPtrValue);
+                pickMaterial->getParameter(names[j])->setValue(value);
+            }
+        }
+
+        model->drawPart(i, pickMaterial->getTechnique()->getPassByIndex(0), false);
+    }
+}
+
+Material* Picker::getMaterial(unsigned int jointCount, int culledSide, unsigned int textureFlags)
+{
+    unsigned int side = culledSide == RenderState::CULL_FACE_SIDE_BACK ? 1 : culledSide == RenderState::CULL_FACE_SIDE_FRONT ? 2 : culledSide ? 3 : 0;
+    unsigned int key = (jointCount << 5) | (side << 3) | textureFlags;
+    std::map<unsigned int, Material*>::const_iterator itr = _materials.find(key);
+    if (itr != _materials.end())
+        return itr->second;
+
+    std::ostringstream defines;
+    if (jointCount > 0)
+        defines << "SKINNING;SKINNING_JOINT_COUNT " << jointCount << ";";
+    if (textureFlags & PICKER_DISCARD_ALPHA)
+        defines << "TEXTURE_DISCARD_ALPHA;";
+    if (textureFlags & PICKER_TEXTURE_REPEAT)
+        defines << "TEXTURE_REPEAT;";
+    if (textureFlags & PICKER_TEXTURE_OFFSET)
+        defines << "TEXTURE_OFFSET;";
+    std::string definesString = defines.str();
+    if (!definesString.empty())
+        definesString.erase(definesString.size() - 1);
+
+    // A failed material is kept as NULL so that it is not created again for every node.
+    Material* material = Material::create(PICKER_VSH, PICKER_FSH, definesString.empty() ? NULL : definesString.c_str());
+    _materials[key] = material;
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create the picking material with defines '%s'.", definesString.c_str());
+        return NULL;
+    }
+
+    // Faces are culled as the material of the pass culls them.
+    RenderState::StateBlock* state = material->getStateBlock();
+    state->setDepthTest(true);
+    state->setDepthWrite(true);
+    if (culledSide)
+    {
+        state->setCullFace(true);
+        state->setCullFaceSide((RenderState::CullFaceSide)culledSide);
+    }
+    material->setParameterAutoBinding("u_worldMatrix", RenderState::WORLD_MATRIX);
+    material->getParameter("u_pickViewProjectionMatrix")->bindValue(this, &Picker::getViewProjectionMatrix);
+    if (jointCount > 0)
+    {
+        material->setParameterAutoBinding("u_matrixPalette", RenderState::MATRIX_PALETTE);
+    }
+    return material;
+}
+
+const Matrix& Picker::getViewProjectionMatrix() const
+{
+    return _viewProjection;
+}
+
+MaterialParameter* Picker::findParameter(RenderState* renderState, const char* name)
+{
+    // Parameters of a pass override those of its technique and material.
+    for (RenderState* rs = renderState; rs; rs = rs->_parent)
+    {
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        {
+            if (strcmp(rs->_parameters[i]->getName(), name) == 0)
+                return rs->_parameters[i];
+        }
+    }
+    return NULL;
+}
+
+void Picker::readComplete(const unsigned char* pixels, unsigned int width, unsigned int height, void* cookie)
+{
+    Request* request = (Request*)cookie;
+    GP_ASSERT(request);
+
+    // The pixel under the point wins; otherwise the closest pixel covered by a node.
+    Node* node = NULL;
+    if (pixels)
+    {
+        int centerX = (int)width / 2;
+        int centerY = (int)height / 2;
+        int closest = INT_MAX;
+        for (unsigned int y = 0; y < height; ++y)
+        {
+            for (unsigned int x = 0; x < width; ++x)
+            {
+                const unsigned char* pixel = pixels + (y * width + x) * 4;
+                unsigned int id = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+                if (id == 0 || id > request->nodes.size())
+                    continue;
+
+                int distance = ((int)x - centerX) * ((int)x - centerX) + ((int)y - centerY) * ((int)y - centerY);
+                if (distance < closest)
+                {
+                    closest = distance;
+                    node = request->nodes[id - 1];
+                }
+            }
+        }
+    }
+
+    request->callback(node, request->cookie);
+
+    for (size_t i = 0, count = request->nodes.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(request->nodes[i]);
+    }
+    Picker* picker = request->picker;
+    delete request;
+    SAFE_RELEASE(picker);
+}
+
+unsigned int Picker::getDrawCount() const
+{
+    return _drawCount;
+}
+
+}
@@ -0,0 +1,164 @@
+#ifndef PICKER_H_
+#define PICKER_H_
+
+#include "Ref.h"
+#include "Matrix.h"
+#include "Vector4.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+class Model;
+class Material;
+class MaterialParameter;
+class RenderState;
+class FrameBuffer;
+
+/**
+ * Defines a picker that finds the node under a point of the screen by drawing the
+ * nodes around it into a small offscreen target, instead of testing a ray against
+ * the collision objects of the physics world.
+ *
+ * Picking with PhysicsController::rayTest requires a collision object on every node
+ * that can be picked. The picker only needs the models: it culls the scene against the
+ * frustum of the few pixels around the point, draws the models found there with the
+ * index of their node as their color, and reads the pixels back through the
+ * ReadbackQueue. Where the platform has pixel buffers, the read does not stall the
+ * frame, and the node is handed to a callback a frame or two later.
+ *
+ * The nodes are drawn as they appear on the screen: skinned models are drawn in their
+ * current pose, and the fragments of materials built with TEXTURE_DISCARD_ALPHA are
+ * discarded where their diffuse texture is transparent, so the cut out parts of a model
+ * cannot be picked. The point itself is picked first; if no node covers it, the node
+ * closest to it within the radius of the picker is picked instead, which makes thin
+ * objects easier to select. Nodes with the "noPick" tag are not drawn.
+ *
+ * @verbatim
+    static void picked(Node* node, void* cookie)
+    {
+        ((MyGame*)cookie)->select(node);
+    }
+
+    _picker = Picker::create();
+    ...
+    _picker->pick(_scene, x, y, picked, this);
+   @endverbatim
+ *
+ * Like the reads of the ReadbackQueue, picks are refused while the frame is recorded
+ * for the render thread; pick from Game::update or from input events.
+ *
+ * @script{ignore}
+ */
+class Picker : public Ref
+{
+public:
+
+    /**
+     * Function called with the node picked.
+     *
+     * @param node The node under the point, or NULL if there is none. The picker holds a
+     *      reference to the node during the call, so it is valid even if it has been
+     *      removed from the scene since the pick.
+     * @param cookie The cookie passed to pick().
+     */
+    typedef void (*PickCallback)(Node* node, void* cookie);
+
+    /**
+     * Creates a picker.
+     *
+     * @param radius The distance from the point, in pixels, within which nodes are picked
+     *      when none covers the point itself. The picker reads a square of 2 * radius + 1
+     *      pixels around the point.
+     *
+     * @return The new picker, or NULL if its target could not be created.
+     */
+    static Picker* create(unsigned int radius = 2);
+
+    /**
+     * Picks the node of a scene under a point of the screen.
+     *
+     * The scene is seen through its active camera and the current viewport of the game.
+     *
+     * @param scene The scene.
+     * @param x The X coordinate of the point, in pixels from the left of the window.
+     * @param y The Y coordinate of the point, in pixels from the top of the window.
+     * @param callback The function called with the node picked, once the pixels have been read.
+     * @param cookie The user data passed to the callback.
+     *
+     * @return true if the pick was started, false if the scene has no camera, the point is
+     *      outside the viewport or the pixels cannot be read; the callback is not called then.
+     */
+    bool pick(Scene* scene, int x, int y, PickCallback callback, void* cookie);
+
+    /**
+     * Gets the number of models drawn by the last pick.
+     *
+     * @return The number of models drawn.
+     */
+    unsigned int getDrawCount() const;
+
+private:
+
+    /**
+     * A pick whose pixels have not been read yet.
+     */
+    struct Request;
+
+    /**
+     * Constructor.
+     */
+    Picker();
+
+    /**
+     * Destructor.
+     */
+    ~Picker();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Picker(const Picker& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Picker& operator=(const Picker&);
+
+    /**
+     * Draws the parts of the model of a node with the color of its index.
+     */
+    void drawNode(Node* node, const Vector4& color);
+
+    /**
+     * Gets the picking material for a skin, a culled side and the texture defines of a pass.
+     */
+    Material* getMaterial(unsigned int jointCount, int culledSide, unsigned int textureFlags);
+
+    /**
+     * Gets the view projection matrix of the area picked, for the materials.
+     */
+    const Matrix& getViewProjectionMatrix() const;
+
+    /**
+     * Finds a parameter set on a render state or on one of its parents, without creating it.
+     */
+    static MaterialParameter* findParameter(RenderState* renderState, const char* name);
+
+    /**
+     * Called by the ReadbackQueue with the pixels of a pick.
+     */
+    static void readComplete(const unsigned char* pixels, unsigned int width, unsigned int height, void* cookie);
+
+    unsigned int _radius;
+    FrameBuffer* _frameBuffer;
+    Matrix _viewProjection;
+    std::map<unsigned int, Material*> _materials;
+    std::vector<Node*> _nodes;
+    unsigned int _drawCount;
+};
+
+}
+
+#endif
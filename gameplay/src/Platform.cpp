@@ -10,24 +10,64 @@ namespace gameplay
 
 void Platform::touchEventInternal(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex, bool actuallyMouse)
 {
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushTouchEvent(evt, x, y, contactIndex, actuallyMouse);
+        return;
+    }
+
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passTouchEvent(evt, x, y, contactIndex, actuallyMouse))
+        return;
+
     if (actuallyMouse || !Form::touchEventInternal(evt, x, y, contactIndex))
     {
         Game::getInstance()->touchEvent(evt, x, y, contactIndex);
-        Game::getInstance()->getScriptController()->touchEvent(evt, x, y, contactIndex);
+        ScriptController* scriptController = Game::getInstance()->_scriptController;
+        if (scriptController)
+            scriptController->touchEvent(evt, x, y, contactIndex);
     }
 }
 
 void Platform::keyEventInternal(Keyboard::KeyEvent evt, int key)
 {
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushKeyEvent(evt, key);
+        return;
+    }
+
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passKeyEvent(evt, key))
+        return;
+
     if (!Form::keyEventInternal(evt, key))
     {
         Game::getInstance()->keyEvent(evt, key);
-        Game::getInstance()->getScriptController()->keyEvent(evt, key);
+        ScriptController* scriptController = Game::getInstance()->_scriptController;
+        if (scriptController)
+            scriptController->keyEvent(evt, key);
     }
 }
 
 bool Platform::mouseEventInternal(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
 {
+    // Queued mouse events are not consumed yet, so the platform also reports the matching
+    // touch event, which the queue drops if the mouse event is consumed when dispatched.
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushMouseEvent(evt, x, y, wheelDelta);
+        return false;
+    }
+
+    // A dropped mouse event is not consumed; the platform's matching touch event is dropped as well.
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passMouseEvent(evt, x, y, wheelDelta))
+        return false;
+
     if (Form::mouseEventInternal(evt, x, y, wheelDelta))
     {
         return true;
@@ -38,29 +78,69 @@ bool Platform::mouseEventInternal(Mouse::MouseEvent evt, int x, int y, int wheel
     }
     else
     {
-        return Game::getInstance()->getScriptController()->mouseEvent(evt, x, y, wheelDelta);
+        ScriptController* scriptController = Game::getInstance()->_scriptController;
+        return scriptController && scriptController->mouseEvent(evt, x, y, wheelDelta);
     }
 }
 
 void Platform::gestureSwipeEventInternal(int x, int y, int direction)
 {
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushGestureEvent(InputQueue::GESTURE_SWIPE, x, y, direction, 0.0f);
+        return;
+    }
+
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passGestureEvent(InputRecorder::GESTURE_SWIPE, x, y, direction, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gestureSwipeEvent(x, y, direction);
-    Game::getInstance()->getScriptController()->gestureSwipeEvent(x, y, direction);
+    ScriptController* scriptController = Game::getInstance()->_scriptController;
+    if (scriptController)
+        scriptController->gestureSwipeEvent(x, y, direction);
 }
 
 void Platform::gesturePinchEventInternal(int x, int y, float scale)
 {
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushGestureEvent(InputQueue::GESTURE_PINCH, x, y, 0, scale);
+        return;
+    }
+
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passGestureEvent(InputRecorder::GESTURE_PINCH, x, y, 0, scale))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gesturePinchEvent(x, y, scale);
-    Game::getInstance()->getScriptController()->gesturePinchEvent(x, y, scale);
+    ScriptController* scriptController = Game::getInstance()->_scriptController;
+    if (scriptController)
+        scriptController->gesturePinchEvent(x, y, scale);
 }
 
 void Platform::gestureTapEventInternal(int x, int y)
 {
+    InputQueue* inputQueue = Game::getInstance()->getInputQueue();
+    if (inputQueue && inputQueue->isQueuing())
+    {
+        inputQueue->pushGestureEvent(InputQueue::GESTURE_TAP, x, y, 0, 0.0f);
+        return;
+    }
+
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passGestureEvent(InputRecorder::GESTURE_TAP, x, y, 0, 0.0f))
+        return;
+
     // TODO: Add support to Form for gestures
     Game::getInstance()->gestureTapEvent(x, y);
-    Game::getInstance()->getScriptController()->gestureTapEvent(x, y);
+    ScriptController* scriptController = Game::getInstance()->_scriptController;
+    if (scriptController)
+        scriptController->gestureTapEvent(x, y);
 }
 
 void Platform::resizeEventInternal(unsigned int width, unsigned int height)
@@ -72,18 +152,33 @@ void Platform::resizeEventInternal(unsigned int width, unsigned int height)
         game->_width = width;
         game->_height = height;
         game->resizeEvent(width, height);
-        game->getScriptController()->resizeEvent(width, height);
+        ScriptController* scriptController = game->_scriptController;
+        if (scriptController)
+            scriptController->resizeEvent(width, height);
     }
 }
 
+void Platform::backgroundEventInternal(bool background)
+{
+    // The frame pacer only exists while the game is running.
+    FramePacer* framePacer = Game::getInstance()->getFramePacer();
+    if (framePacer)
+        framePacer->setBackground(background);
+}
+
 void Platform::gamepadEventInternal(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
 {
+    InputRecorder* inputRecorder = Game::getInstance()->getInputRecorder();
+    if (inputRecorder && !inputRecorder->passGamepadEvent(evt, gamepad, analogIndex))
+        return;
+
 	switch(evt)
 	{
 	case Gamepad::CONNECTED_EVENT:
 	case Gamepad::DISCONNECTED_EVENT:
 		Game::getInstance()->gamepadEvent(evt, gamepad);
-        Game::getInstance()->getScriptController()->gamepadEvent(evt, gamepad);
+		if (Game::getInstance()->_scriptController)
+			Game::getInstance()->_scriptController->gamepadEvent(evt, gamepad);
 		break;
 	case Gamepad::BUTTON_EVENT:
 	case Gamepad::JOYSTICK_EVENT:
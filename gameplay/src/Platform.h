@@ -18,6 +18,26 @@ class Game;
  * 
  * This class has only a few public methods for creating a platform 
  *
+ * Headless builds (the GP_HEADLESS option of the CMake build, on Linux) use a platform
+ * with no window, no GL context and no input devices, and a null graphics backend (see
+ * NullGraphics.h), to run the simulation of a game on servers, for bots and in automated
+ * runs. The frames run back to back unless the frame pacer limits them, and by default
+ * they do not render (see Game::setRenderingEnabled). SIGINT and SIGTERM exit the game.
+ * The platform is configured in the game config:
+ *
+ * @verbatim
+    headless
+    {
+        width = 1280        // Display size reported to the game (default 1280x720).
+        height = 720
+        timestep = 0        // Milliseconds the game clock advances each frame, or 0 to follow real time.
+        frames = 0          // Frames to run before exiting, or 0 to run until the game exits.
+        render = false      // Call Game::render each frame, on the null graphics backend.
+    }
+   @endverbatim
+ *
+ * With a timestep, the game runs as fast as it can on a simulated clock, so every run of
+ * the same input simulates the same times; the frame pacer is then disabled.
  */
 class Platform
 {
@@ -127,6 +147,63 @@ private:
      */
     static void sleep(long ms);
 
+    /**
+     * Creates a GL context that shares its objects with the context of the game, for
+     * uploading resources on a loader thread.
+     *
+     * Called on the main thread.
+     *
+     * @return true if the context exists, false if the platform does not support shared contexts.
+     * @script{ignore}
+     */
+    static bool createLoaderContext();
+
+    /**
+     * Makes the loader context current on the calling thread, or releases it.
+     *
+     * @param current true to make the loader context current, false to release it.
+     *
+     * @return true on success, false otherwise.
+     * @script{ignore}
+     */
+    static bool makeLoaderContextCurrent(bool current);
+
+    /**
+     * Destroys the loader context once no thread has it current.
+     *
+     * @script{ignore}
+     */
+    static void destroyLoaderContext();
+
+    /**
+     * Creates a GL context that shares its objects with the context of the game and draws
+     * to the window, for replaying frames on a render thread (see RenderThread).
+     *
+     * Called on the main thread. While the render context exists, swapBuffers() only
+     * presents on the thread that has the render context current.
+     *
+     * @return true if the context exists, false if the platform cannot draw to the window from another thread.
+     * @script{ignore}
+     */
+    static bool createRenderContext();
+
+    /**
+     * Makes the render context current on the calling thread, or releases it.
+     *
+     * @param current true to make the render context current, false to release it.
+     *
+     * @return true on success, false otherwise.
+     * @script{ignore}
+     */
+    static bool makeRenderContextCurrent(bool current);
+
+    /**
+     * Destroys the render context once no thread has it current.
+     *
+     * @script{ignore}
+     */
+    static void destroyRenderContext();
+
     /**
      * Set if multi-sampling is enabled on the platform.
      *
@@ -344,6 +421,13 @@ public:
      */
     static void resizeEventInternal(unsigned int width, unsigned int height);
 
+    /**
+     * Internal method used only from static code in various platform implementation.
+     *
+     * @script{ignore}
+     */
+    static void backgroundEventInternal(bool background);
+
     /**
      * Internal method used only from static code in various platform implementation.
      *
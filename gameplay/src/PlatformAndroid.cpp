@@ -21,6 +21,8 @@ static EGLDisplay __eglDisplay = EGL_NO_DISPLAY;
 static EGLContext __eglContext = EGL_NO_CONTEXT;
 static EGLSurface __eglSurface = EGL_NO_SURFACE;
 static EGLConfig __eglConfig = 0;
+static EGLContext __eglLoaderContext = EGL_NO_CONTEXT;
+static EGLSurface __eglLoaderSurface = EGL_NO_SURFACE;
 static int __width;
 static int __height;
 static struct timespec __timespec;
@@ -50,6 +52,20 @@ PFNGLBINDVERTEXARRAYOESPROC glBindVertexArray = NULL;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArrays = NULL;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArrays = NULL;
 PFNGLISVERTEXARRAYOESPROC glIsVertexArray = NULL;
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYOESPROC glProgramBinary = NULL;
+PFNGLGENQUERIESEXTPROC glGenQueries = NULL;
+PFNGLDELETEQUERIESEXTPROC glDeleteQueries = NULL;
+PFNGLQUERYCOUNTEREXTPROC glQueryCounter = NULL;
+PFNGLGETQUERYOBJECTIVEXTPROC glGetQueryObjectiv = NULL;
+PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v = NULL;
+PFNGLBEGINQUERYEXTPROC glBeginQuery = NULL;
+PFNGLENDQUERYEXTPROC glEndQuery = NULL;
+PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuiv = NULL;
+PFNGLDISCARDFRAMEBUFFEREXTPROC glInvalidateFramebuffer = NULL;
+PFNGLPUSHDEBUGGROUPKHRPROC glPushDebugGroup = NULL;
+PFNGLPOPDEBUGGROUPKHRPROC glPopDebugGroup = NULL;
+PFNGLOBJECTLABELKHRPROC glObjectLabel = NULL;
 
 #define GESTURE_TAP_DURATION_MAX    200
 #define GESTURE_SWIPE_DURATION_MAX  400
@@ -312,6 +328,42 @@ static bool initEGL()
         glGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
         glIsVertexArray = (PFNGLISVERTEXARRAYOESPROC)eglGetProcAddress("glIsVertexArrayOES");
     }
+
+    if (strstr(__glExtensions, "GL_OES_get_program_binary"))
+    {
+        glGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+        glProgramBinary = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+    }
+
+    if (strstr(__glExtensions, "GL_EXT_disjoint_timer_query"))
+    {
+        glGenQueries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+        glDeleteQueries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+        glQueryCounter = (PFNGLQUERYCOUNTEREXTPROC)eglGetProcAddress("glQueryCounterEXT");
+        glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVEXTPROC)eglGetProcAddress("glGetQueryObjectivEXT");
+        glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    }
+
+    if (strstr(__glExtensions, "GL_EXT_occlusion_query_boolean"))
+    {
+        glGenQueries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+        glDeleteQueries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+        glBeginQuery = (PFNGLBEGINQUERYEXTPROC)eglGetProcAddress("glBeginQueryEXT");
+        glEndQuery = (PFNGLENDQUERYEXTPROC)eglGetProcAddress("glEndQueryEXT");
+        glGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+    }
+
+    if (strstr(__glExtensions, "GL_EXT_discard_framebuffer"))
+    {
+        glInvalidateFramebuffer = (PFNGLDISCARDFRAMEBUFFEREXTPROC)eglGetProcAddress("glDiscardFramebufferEXT");
+    }
+
+    if (strstr(__glExtensions, "GL_KHR_debug"))
+    {
+        glPushDebugGroup = (PFNGLPUSHDEBUGGROUPKHRPROC)eglGetProcAddress("glPushDebugGroupKHR");
+        glPopDebugGroup = (PFNGLPOPDEBUGGROUPKHRPROC)eglGetProcAddress("glPopDebugGroupKHR");
+        glObjectLabel = (PFNGLOBJECTLABELKHRPROC)eglGetProcAddress("glObjectLabelKHR");
+    }
     
     return true;
     
@@ -336,6 +388,7 @@ static void destroyEGLSurface()
 static void destroyEGLMain()
 {
     destroyEGLSurface();
+    Platform::destroyLoaderContext();
 
     if (__eglContext != EGL_NO_CONTEXT)
     {
@@ -1182,6 +1235,65 @@ void Platform::sleep(long ms)
     usleep(ms * 1000);
 }
 
+bool Platform::createLoaderContext()
+{
+    if (__eglLoaderContext != EGL_NO_CONTEXT)
+        return true;
+    if (__eglContext == EGL_NO_CONTEXT)
+        return false;
+
+    const EGLint contextAttrs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    __eglLoaderContext = eglCreateContext(__eglDisplay, __eglConfig, __eglContext, contextAttrs);
+    if (__eglLoaderContext == EGL_NO_CONTEXT)
+    {
+        checkErrorEGL("eglCreateContext");
+        return false;
+    }
+
+    // The loader context never draws, but some drivers need a surface to make a context current.
+    const EGLint surfaceAttrs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    __eglLoaderSurface = eglCreatePbufferSurface(__eglDisplay, __eglConfig, surfaceAttrs);
+    return true;
+}
+
+bool Platform::makeLoaderContextCurrent(bool current)
+{
+    GP_ASSERT(__eglLoaderContext != EGL_NO_CONTEXT);
+
+    if (current)
+        return eglMakeCurrent(__eglDisplay, __eglLoaderSurface, __eglLoaderSurface, __eglLoaderContext) == EGL_TRUE;
+    return eglMakeCurrent(__eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE;
+}
+
+void Platform::destroyLoaderContext()
+{
+    if (__eglLoaderSurface != EGL_NO_SURFACE)
+    {
+        eglDestroySurface(__eglDisplay, __eglLoaderSurface);
+        __eglLoaderSurface = EGL_NO_SURFACE;
+    }
+    if (__eglLoaderContext != EGL_NO_CONTEXT)
+    {
+        eglDestroyContext(__eglDisplay, __eglLoaderContext);
+        __eglLoaderContext = EGL_NO_CONTEXT;
+    }
+}
+
+bool Platform::createRenderContext()
+{
+    // The window surface can only be current to one context, which the game thread keeps.
+    return false;
+}
+
+bool Platform::makeRenderContextCurrent(bool current)
+{
+    return false;
+}
+
+void Platform::destroyRenderContext()
+{
+}
+
 void Platform::setMultiSampling(bool enabled)
 {
     if (enabled == __multiSampling)
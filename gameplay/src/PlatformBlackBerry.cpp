@@ -60,6 +60,9 @@ PFNGLBINDVERTEXARRAYOESPROC glBindVertexArray = NULL;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArrays = NULL;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArrays = NULL;
 PFNGLISVERTEXARRAYOESPROC glIsVertexArray = NULL;
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinary = NULL;
+PFNGLPROGRAMBINARYOESPROC glProgramBinary = NULL;
+PFNGLDISCARDFRAMEBUFFEREXTPROC glInvalidateFramebuffer = NULL;
 
 namespace gameplay
 {
@@ -990,6 +993,17 @@ Platform* Platform::create(Game* game, void* attachToWindow)
         glIsVertexArray = (PFNGLISVERTEXARRAYOESPROC)eglGetProcAddress("glIsVertexArrayOES");
     }
 
+    if (strstr(__glExtensions, "GL_OES_get_program_binary"))
+    {
+        glGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+        glProgramBinary = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+    }
+
+    if (strstr(__glExtensions, "GL_EXT_discard_framebuffer"))
+    {
+        glInvalidateFramebuffer = (PFNGLDISCARDFRAMEBUFFEREXTPROC)eglGetProcAddress("glDiscardFramebufferEXT");
+    }
+
  #ifdef USE_BLACKBERRY_GAMEPAD
 
     screen_device_t* screenDevs;
@@ -1428,6 +1442,36 @@ void Platform::sleep(long ms)
     usleep(ms * 1000);
 }
 
+bool Platform::createLoaderContext()
+{
+    // Shared contexts are not implemented on this platform; uploads run on the main thread.
+    return false;
+}
+
+bool Platform::makeLoaderContextCurrent(bool current)
+{
+    return false;
+}
+
+void Platform::destroyLoaderContext()
+{
+}
+
+bool Platform::createRenderContext()
+{
+    // Shared contexts are not implemented on this platform; frames render on the game thread.
+    return false;
+}
+
+bool Platform::makeRenderContextCurrent(bool current)
+{
+    return false;
+}
+
+void Platform::destroyRenderContext()
+{
+}
+
 void Platform::setMultiSampling(bool enabled)
 {
     if (enabled == __multiSampling)
@@ -0,0 +1,332 @@
+#ifdef GP_HEADLESS
+
+#include "Base.h"
+#include "Platform.h"
+#include "FileSystem.h"
+#include "Game.h"
+
+#include <sys/time.h>
+#include <signal.h>
+#include <unistd.h>
+
+// The display size reported when the config does not set one.
+#define HEADLESS_DEFAULT_WIDTH 1280
+#define HEADLESS_DEFAULT_HEIGHT 720
+
+int __argc = 0;
+char** __argv = 0;
+
+struct timespec __timespec;
+static double __timeStart;
+static double __timeAbsolute;
+static double __timestep = 0.0;
+static unsigned int __frameLimit = 0;
+static unsigned int __width = HEADLESS_DEFAULT_WIDTH;
+static unsigned int __height = HEADLESS_DEFAULT_HEIGHT;
+static volatile sig_atomic_t __exitSignaled = 0;
+
+static double timespec2millis(struct timespec* a)
+{
+    GP_ASSERT(a);
+    return (1000.0 * a->tv_sec) + (0.000001 * a->tv_nsec);
+}
+
+static void exitSignalHandler(int signal)
+{
+    __exitSignaled = 1;
+}
+
+namespace gameplay
+{
+    extern void print(const char* format, ...)
+    {
+        GP_ASSERT(format);
+        va_list argptr;
+        va_start(argptr, format);
+        vfprintf(stderr, format, argptr);
+        va_end(argptr);
+    }
+
+    Platform::Platform(Game* game) : _game(game)
+    {
+    }
+
+    Platform::~Platform()
+    {
+    }
+
+    Platform* Platform::create(Game* game, void* attachToWindow)
+    {
+        GP_ASSERT(game);
+
+        FileSystem::setResourcePath("./");
+        Platform* platform = new Platform(game);
+
+        if (game->getConfig())
+        {
+            Properties* config = game->getConfig()->getNamespace("headless", true);
+            if (config)
+            {
+                int width = config->getInt("width");
+                int height = config->getInt("height");
+                if (width > 0) __width = width;
+                if (height > 0) __height = height;
+                __timestep = std::max(0.0f, config->getFloat("timestep"));
+                __frameLimit = (unsigned int)std::max(0, config->getInt("frames"));
+            }
+        }
+
+        // Play audio to OpenAL's null device unless another one is asked for, since servers have no sound card.
+        setenv("ALSOFT_DRIVERS", "null", 0);
+
+        // Shut the game down on the signals a server is stopped with.
+        signal(SIGINT, exitSignalHandler);
+        signal(SIGTERM, exitSignalHandler);
+
+        return platform;
+    }
+
+    int Platform::enterMessagePump()
+    {
+        GP_ASSERT(_game);
+
+        // Get the initial time.
+        clock_gettime(CLOCK_REALTIME, &__timespec);
+        __timeStart = timespec2millis(&__timespec);
+        __timeAbsolute = 0L;
+
+        // Run the game.
+        _game->run();
+
+        // With a fixed timestep the game clock only moves between frames, so the frame pacer cannot wait on it.
+        FramePacer* framePacer = _game->getFramePacer();
+        if (__timestep > 0.0 && framePacer)
+        {
+            framePacer->setTargetFrameRate(0);
+            framePacer->setBackgroundFrameRate(0);
+        }
+
+        unsigned int frameCount = 0;
+        bool exiting = false;
+        while (_game->getState() != Game::UNINITIALIZED)
+        {
+            if (!exiting && (__exitSignaled || (__frameLimit > 0 && frameCount >= __frameLimit)))
+            {
+                // The shutdown may be scheduled for the next frame, so keep running frames until it happens.
+                exiting = true;
+                _game->exit();
+                continue;
+            }
+
+            _game->frame();
+            ++frameCount;
+
+            if (__timestep > 0.0)
+                __timeAbsolute += __timestep;
+        }
+
+        return 0;
+    }
+
+    void Platform::signalShutdown()
+    {
+    }
+
+    bool Platform::canExit()
+    {
+        return true;
+    }
+
+    unsigned int Platform::getDisplayWidth()
+    {
+        return __width;
+    }
+
+    unsigned int Platform::getDisplayHeight()
+    {
+        return __height;
+    }
+
+    double Platform::getAbsoluteTime()
+    {
+        if (__timestep > 0.0)
+            return __timeAbsolute;
+
+        clock_gettime(CLOCK_REALTIME, &__timespec);
+        double now = timespec2millis(&__timespec);
+        __timeAbsolute = now - __timeStart;
+
+        return __timeAbsolute;
+    }
+
+    void Platform::setAbsoluteTime(double time)
+    {
+        __timeAbsolute = time;
+    }
+
+    bool Platform::isVsync()
+    {
+        return false;
+    }
+
+    void Platform::setVsync(bool enable)
+    {
+    }
+
+    void Platform::swapBuffers()
+    {
+    }
+
+    void Platform::sleep(long ms)
+    {
+        usleep(ms * 1000);
+    }
+
+    bool Platform::createLoaderContext()
+    {
+        // The null graphics backend is not thread safe, so uploads stay on the main thread.
+        return false;
+    }
+
+    bool Platform::makeLoaderContextCurrent(bool current)
+    {
+        return false;
+    }
+
+    void Platform::destroyLoaderContext()
+    {
+    }
+
+    bool Platform::createRenderContext()
+    {
+        // There is no window to present to, so frames stay on the game thread.
+        return false;
+    }
+
+    bool Platform::makeRenderContextCurrent(bool current)
+    {
+        return false;
+    }
+
+    void Platform::destroyRenderContext()
+    {
+    }
+
+    void Platform::setMultiSampling(bool enabled)
+    {
+    }
+
+    bool Platform::isMultiSampling()
+    {
+        return false;
+    }
+
+    void Platform::setMultiTouch(bool enabled)
+    {
+    }
+
+    bool Platform::isMultiTouch()
+    {
+        return false;
+    }
+
+    bool Platform::hasAccelerometer()
+    {
+        return false;
+    }
+
+    void Platform::getAccelerometerValues(float* pitch, float* roll)
+    {
+        GP_ASSERT(pitch);
+        GP_ASSERT(roll);
+
+        *pitch = 0;
+        *roll = 0;
+    }
+
+    void Platform::getRawSensorValues(float* accelX, float* accelY, float* accelZ, float* gyroX, float* gyroY, float* gyroZ)
+    {
+        if (accelX)
+            *accelX = 0;
+        if (accelY)
+            *accelY = 0;
+        if (accelZ)
+            *accelZ = 0;
+        if (gyroX)
+            *gyroX = 0;
+        if (gyroY)
+            *gyroY = 0;
+        if (gyroZ)
+            *gyroZ = 0;
+    }
+
+    void Platform::getArguments(int* argc, char*** argv)
+    {
+        if (argc)
+            *argc = __argc;
+        if (argv)
+            *argv = __argv;
+    }
+
+    bool Platform::hasMouse()
+    {
+        return false;
+    }
+
+    void Platform::setMouseCaptured(bool captured)
+    {
+    }
+
+    bool Platform::isMouseCaptured()
+    {
+        return false;
+    }
+
+    void Platform::setCursorVisible(bool visible)
+    {
+    }
+
+    bool Platform::isCursorVisible()
+    {
+        return false;
+    }
+
+    void Platform::displayKeyboard(bool display)
+    {
+    }
+
+    void Platform::shutdownInternal()
+    {
+        Game::getInstance()->shutdown();
+    }
+
+    bool Platform::isGestureSupported(Gesture::GestureEvent evt)
+    {
+        return false;
+    }
+
+    void Platform::registerGesture(Gesture::GestureEvent evt)
+    {
+    }
+
+    void Platform::unregisterGesture(Gesture::GestureEvent evt)
+    {
+    }
+
+    bool Platform::isGestureRegistered(Gesture::GestureEvent evt)
+    {
+        return false;
+    }
+
+    void Platform::pollGamepadState(Gamepad* gamepad)
+    {
+    }
+
+    bool Platform::launchURL(const char* url)
+    {
+        return false;
+    }
+
+}
+
+#endif
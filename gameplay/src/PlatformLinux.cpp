@@ -1,4 +1,4 @@
-#ifdef __linux__
+#if defined(__linux__) && !defined(GP_HEADLESS)
 
 #include "Base.h"
 #include "Platform.h"
@@ -6,6 +6,7 @@
 #include "Game.h"
 #include "Form.h"
 #include "ScriptController.h"
+#include "StartupTrace.h"
 
 #include <X11/X.h>
 #include <X11/Xlib.h>
@@ -18,7 +19,6 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
-#include <fstream>
 
 #define TOUCH_COUNT_MAX     4
 #define MAX_GAMEPADS 4
@@ -28,52 +28,24 @@ using namespace std;
 int __argc = 0;
 char** __argv = 0;
 
-enum GamepadAxisInfoFlags
-{
-    GP_AXIS_SKIP = 0x1,
-    GP_AXIS_IS_DPAD = 0x2,
-    GP_AXIS_IS_NEG = 0x4,
-    GP_AXIS_IS_XAXIS = 0x8,
-    GP_AXIS_IS_TRIGGER = 0x10
-};
-
-enum GamepadAxisInfoNormalizeFunction
-{
-    NEG_TO_POS,
-    ZERO_TO_POS
-};
-
-struct GamepadJoystickAxisInfo
-{
-    int axisIndex;
-    unsigned int joystickIndex;
-    unsigned long flags;
-    int mappedPosArg;
-    int mappedNegArg;
-    float deadZone;
-    GamepadAxisInfoNormalizeFunction mapFunc;
-};
-
-struct GamepadInfoEntry
-{
-    unsigned int vendorId;
-    unsigned int productId;
-    const char* productName;
-    unsigned int numberOfJS;
-    unsigned int numberOfAxes;
-    unsigned int numberOfButtons;
-    unsigned int numberOfTriggers;
-
-    GamepadJoystickAxisInfo* axes;
-    long* buttons;
-};
+// The number of absolute axes of a gamepad that are mapped (see __gamepadAxes).
+#define GAMEPAD_AXIS_COUNT 8
 
+// The dead zone of the joysticks of gamepads whose driver reports none, as a fraction of the axis range.
+#define GAMEPAD_DEAD_ZONE 0.07f
 
 struct ConnectedGamepadDevInfo
 {
     dev_t deviceId;
     gameplay::GamepadHandle fd;
-    const GamepadInfoEntry& gamepadInfo;
+    bool ready;                                 // Events are waiting to be read.
+    bool dropped;                               // Events were lost, so the state is read again at the next report.
+    int axisMin[GAMEPAD_AXIS_COUNT];            // Equal to axisMax if the gamepad does not have the axis.
+    int axisMax[GAMEPAD_AXIS_COUNT];
+    int axisFlat[GAMEPAD_AXIS_COUNT];
+    int axisValue[GAMEPAD_AXIS_COUNT];
+    unsigned int buttons;
+    double eventTime;                           // The time of the last report, in the time base of getAbsoluteTime.
 };
 
 struct timespec __timespec;
@@ -89,6 +61,9 @@ static Display* __display;
 static Window   __window;
 static int __windowSize[2];
 static GLXContext __context;
+static GLXContext __loaderContext = NULL;
+static GLXContext __renderContext = NULL;
+static XVisualInfo* __visualInfo = NULL;
 static Window __attachToWindow;
 static Atom __atomWmDeleteWindow;
 static list<ConnectedGamepadDevInfo> __connectedGamepads;
@@ -531,7 +506,18 @@ static int getUnicode(gameplay::Keyboard::Key key)
             return 0;
     }
 }
-#include <linux/joystick.h> //included here so i avoid the naming conflict between KEY_* defined in input.h and the ones defined in gameplay/Keyboard.h 
+// Included here to avoid the naming conflict between the KEY_* macros of input.h and the keys of gameplay/Keyboard.h
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <dirent.h>
+
+// Older kernel headers only name the time of an event through its timeval
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
 namespace gameplay
 {
     extern void print(const char* format, ...)
@@ -560,6 +546,9 @@ namespace gameplay
         FileSystem::setResourcePath("./");
         Platform* platform = new Platform(game);
 
+        // The loader and render threads make their GL contexts current through the same display connection.
+        XInitThreads();
+
         // Get the display and initialize
         __display = XOpenDisplay(NULL);
         if (__display == NULL)
@@ -655,13 +644,14 @@ namespace gameplay
         // Create the windows
         XVisualInfo* visualInfo;
         visualInfo = glXGetVisualFromFBConfig(__display, configs[0]);
+        __visualInfo = visualInfo;
 
         XSetWindowAttributes winAttribs;
         long eventMask;
         eventMask = ExposureMask | VisibilityChangeMask | StructureNotifyMask |
             KeyPressMask | KeyReleaseMask | PointerMotionMask |
             ButtonPressMask | ButtonReleaseMask |
-            EnterWindowMask | LeaveWindowMask;
+            EnterWindowMask | LeaveWindowMask | FocusChangeMask;
         winAttribs.event_mask = eventMask;
         winAttribs.border_pixel = 0;
         winAttribs.bit_gravity = StaticGravity;
@@ -702,6 +692,7 @@ namespace gameplay
 
         XStoreName(__display, __window, title ? title : "");
 
+        StartupTrace::begin("GL context");
         __context = glXCreateContext(__display, visualInfo, NULL, True);
         if (!__context)
         {
@@ -718,6 +709,7 @@ namespace gameplay
             perror("glewInit");
             return NULL;
         }
+        StartupTrace::end();
 
         // GL Version
         int versionGL[2] = {-1, -1};
@@ -740,6 +732,10 @@ namespace gameplay
         {
             glXMakeCurrent(__display, None, NULL);
 
+            if (__loaderContext)
+                glXDestroyContext(__display, __loaderContext);
+            if (__renderContext)
+                glXDestroyContext(__display, __renderContext);
             if (__context)
                 glXDestroyContext(__display, __context);
             if (__window)
@@ -766,102 +762,92 @@ namespace gameplay
     }
 
 
-    //Will need to be dynamic, also should be handled in Gamepad class
-    static const GamepadInfoEntry gamepadLookupTable[] = 
-    {
-        {0x0,0x0,"GENERIC XBOX360",2,6,20,2, 
-                                             (GamepadJoystickAxisInfo[]) {
-                                                                     {0,0,GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {1,0,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {2,1,GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {3,1,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {4,2,GP_AXIS_IS_TRIGGER,0,0,2240,ZERO_TO_POS},
-                                                                     {5,2,GP_AXIS_IS_TRIGGER,1,0,2240,ZERO_TO_POS},
-                                                                     {-1,0,0,0,0,0,NEG_TO_POS}
-                                                                 },
-                                             (long[]) {
-                                                                          -1,    
-                                                                          -1,  
-                                                                          -1,  
-                                                                          -1, 
-                                                                          -1, 
-                                                                          Gamepad::BUTTON_UP,
-                                                                          Gamepad::BUTTON_DOWN,
-                                                                          Gamepad::BUTTON_LEFT,
-                                                                          Gamepad::BUTTON_RIGHT,
-                                                                          Gamepad::BUTTON_MENU2,
-                                                                          Gamepad::BUTTON_MENU1,
-                                                                          Gamepad::BUTTON_L3,
-                                                                          Gamepad::BUTTON_R3,
-                                                                          Gamepad::BUTTON_L1,
-                                                                          Gamepad::BUTTON_R1,
-                                                                          Gamepad::BUTTON_MENU3,
-                                                                          Gamepad::BUTTON_A,
-                                                                          Gamepad::BUTTON_B,
-                                                                          Gamepad::BUTTON_X,
-                                                                          Gamepad::BUTTON_Y
-                                                                         }
-        },
-        {0x79,0x6,"DragonRise Inc. Generic USB Joystick",2,7,12,0, 
-                                             (GamepadJoystickAxisInfo[]) {
-                                                                     {0,1, GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {1,1,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {2,0,GP_AXIS_SKIP,0,0,2240,NEG_TO_POS},
-                                                                     {3,0,GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {4,0,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {5,2,GP_AXIS_IS_DPAD, Gamepad::BUTTON_RIGHT, Gamepad::BUTTON_LEFT,2240,NEG_TO_POS},
-                                                                     {6,2,GP_AXIS_IS_DPAD, Gamepad::BUTTON_DOWN, Gamepad::BUTTON_UP,2240,NEG_TO_POS},
-                                                                     {-1,0,0,0,0,0,NEG_TO_POS}
-                                                                 },
-                                             (long[]) {
-                                                                          Gamepad::BUTTON_Y,    
-                                                                          Gamepad::BUTTON_B,  
-                                                                          Gamepad::BUTTON_A,  
-                                                                          Gamepad::BUTTON_X, 
-                                                                          Gamepad::BUTTON_L1, 
-                                                                          Gamepad::BUTTON_R1, 
-                                                                          Gamepad::BUTTON_L2,    
-                                                                          Gamepad::BUTTON_R2,   
-                                                                          Gamepad::BUTTON_MENU1,   
-                                                                          Gamepad::BUTTON_MENU2,   
-                                                                          Gamepad::BUTTON_L3,
-                                                                          Gamepad::BUTTON_R3,
-                                                                         }
-        },
-        {0x54c,0x268,"Sony Corp. Batoh Device / PlayStation 3 Controller",2,27,19,2, 
-                                             (GamepadJoystickAxisInfo[]) {
-                                                                     {0,0,GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {1,0,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {2,1,GP_AXIS_IS_XAXIS,0,0,2240,NEG_TO_POS},
-                                                                     {3,1,GP_AXIS_IS_NEG,0,0,2240,NEG_TO_POS},
-                                                                     {12,1,GP_AXIS_IS_TRIGGER,0,0,2240,ZERO_TO_POS},
-                                                                     {13,2,GP_AXIS_IS_TRIGGER,1,0,2240,ZERO_TO_POS},
-                                                                     {-1,0,0,0,0,0,NEG_TO_POS}
-                                                                 },
-                                             (long[]) {
-                                                                          Gamepad::BUTTON_MENU1,    
-                                                                          Gamepad::BUTTON_L3,  
-                                                                          Gamepad::BUTTON_R3,  
-                                                                          Gamepad::BUTTON_MENU2, 
-                                                                          Gamepad::BUTTON_UP, 
-                                                                          Gamepad::BUTTON_RIGHT, 
-                                                                          Gamepad::BUTTON_DOWN,    
-                                                                          Gamepad::BUTTON_LEFT,   
-                                                                          Gamepad::BUTTON_L2,  //Use Trigger Instead of BUTTON_L2? or both should be called
-                                                                          Gamepad::BUTTON_R2,  //Use Trigger Instead of BUTTON_R2? or both should be called                                                                        
-                                                                          Gamepad::BUTTON_L1,
-                                                                          Gamepad::BUTTON_R1,
-                                                                          Gamepad::BUTTON_Y,    
-                                                                          Gamepad::BUTTON_B,  
-                                                                          Gamepad::BUTTON_A,  
-                                                                          Gamepad::BUTTON_X, 
-                                                                          Gamepad::BUTTON_MENU3, 
-                                                                          -1,
-                                                                          -1
-                                                                         }
-        }
+    // The axes and buttons of the Linux gamepad API (Documentation/input/gamepad.rst in the kernel
+    // sources), which the kernel drivers of common gamepads report in the same layout.
+    enum GamepadAxisTarget
+    {
+        GP_AXIS_JOYSTICK_X,
+        GP_AXIS_JOYSTICK_Y,
+        GP_AXIS_TRIGGER,
+        GP_AXIS_DPAD_X,
+        GP_AXIS_DPAD_Y
+    };
+
+    struct GamepadAxisMapping
+    {
+        unsigned int code;
+        GamepadAxisTarget target;
+        unsigned int index;
+    };
+
+    struct GamepadButtonMapping
+    {
+        unsigned int code;
+        Gamepad::ButtonMapping mapping;
+    };
+
+    static const GamepadAxisMapping __gamepadAxes[GAMEPAD_AXIS_COUNT] =
+    {
+        { ABS_X, GP_AXIS_JOYSTICK_X, 0 },
+        { ABS_Y, GP_AXIS_JOYSTICK_Y, 0 },
+        { ABS_RX, GP_AXIS_JOYSTICK_X, 1 },
+        { ABS_RY, GP_AXIS_JOYSTICK_Y, 1 },
+        { ABS_Z, GP_AXIS_TRIGGER, 0 },
+        { ABS_RZ, GP_AXIS_TRIGGER, 1 },
+        { ABS_HAT0X, GP_AXIS_DPAD_X, 0 },
+        { ABS_HAT0Y, GP_AXIS_DPAD_Y, 0 }
+    };
+
+    static const GamepadButtonMapping __gamepadButtons[] =
+    {
+        { BTN_A, Gamepad::BUTTON_A },
+        { BTN_B, Gamepad::BUTTON_B },
+        { BTN_C, Gamepad::BUTTON_C },
+        { BTN_X, Gamepad::BUTTON_X },
+        { BTN_Y, Gamepad::BUTTON_Y },
+        { BTN_Z, Gamepad::BUTTON_Z },
+        { BTN_SELECT, Gamepad::BUTTON_MENU1 },
+        { BTN_START, Gamepad::BUTTON_MENU2 },
+        { BTN_MODE, Gamepad::BUTTON_MENU3 },
+        { BTN_TL, Gamepad::BUTTON_L1 },
+        { BTN_TL2, Gamepad::BUTTON_L2 },
+        { BTN_THUMBL, Gamepad::BUTTON_L3 },
+        { BTN_TR, Gamepad::BUTTON_R1 },
+        { BTN_TR2, Gamepad::BUTTON_R2 },
+        { BTN_THUMBR, Gamepad::BUTTON_R3 },
+        { BTN_DPAD_UP, Gamepad::BUTTON_UP },
+        { BTN_DPAD_DOWN, Gamepad::BUTTON_DOWN },
+        { BTN_DPAD_LEFT, Gamepad::BUTTON_LEFT },
+        { BTN_DPAD_RIGHT, Gamepad::BUTTON_RIGHT }
     };
 
+    static const unsigned int __gamepadButtonCount = sizeof(__gamepadButtons) / sizeof(GamepadButtonMapping);
+
+    static int __gamepadPoll = -1;              // The epoll instance waiting on the gamepads and on the hotplug watch.
+    static int __gamepadWatch = -1;             // The inotify instance watching /dev/input for new devices.
+    static bool __gamepadsInitialized = false;
+
+    static bool testBit(const unsigned long* bits, unsigned int bit)
+    {
+        const unsigned int bitsPerLong = 8 * sizeof(unsigned long);
+        return ((bits[bit / bitsPerLong] >> (bit % bitsPerLong)) & 1) != 0;
+    }
+
+    static bool hasGamepadAxis(const ConnectedGamepadDevInfo& info, unsigned int axis)
+    {
+        return info.axisMax[axis] > info.axisMin[axis];
+    }
+
+    ConnectedGamepadDevInfo* findGamepad(GamepadHandle handle)
+    {
+        for(list<ConnectedGamepadDevInfo>::iterator it = __connectedGamepads.begin(); it != __connectedGamepads.end();++it)
+        {
+            if(handle == (*it).fd)
+                return &(*it);
+        }
+        return NULL;
+    }
+
     bool isGamepadDevRegistered(dev_t devId)
     {
         for(list<ConnectedGamepadDevInfo>::iterator it = __connectedGamepads.begin(); it != __connectedGamepads.end();++it)
@@ -873,6 +859,7 @@ namespace gameplay
 
     void closeGamepad(const ConnectedGamepadDevInfo& gamepadDevInfo)
     {
+        // Closing the device also removes it from the epoll instance
         ::close(gamepadDevInfo.fd);
     }
 
@@ -894,215 +881,257 @@ namespace gameplay
         for(list<ConnectedGamepadDevInfo>::iterator it = __connectedGamepads.begin(); it != __connectedGamepads.end();++it)
         {
             closeGamepad(*it);
-            __connectedGamepads.erase(it);
         }
+        __connectedGamepads.clear();
+
+        if (__gamepadWatch >= 0)
+            ::close(__gamepadWatch);
+        if (__gamepadPoll >= 0)
+            ::close(__gamepadPoll);
+        __gamepadWatch = -1;
+        __gamepadPoll = -1;
+        __gamepadsInitialized = false;
     }
 
-    const GamepadInfoEntry& getGamepadMappedInfo(unsigned int vendorId, unsigned int productId, unsigned int numberOfAxes, unsigned int numberOfButtons)
+    bool isBlackListed(unsigned int vendorId, unsigned int productId)
     {
-        for(int i=0;i<sizeof(gamepadLookupTable)/sizeof(GamepadInfoEntry);i++)
+        switch(vendorId)
         {
-            const GamepadInfoEntry& curEntry = gamepadLookupTable[i];
-            if(curEntry.vendorId == vendorId && curEntry.productId == productId)
-            {
-                return curEntry;
-            }
+            case 0x0e0f: //virtual machine devices
+                if(productId == 0x0003) // Virtual Mouse
+                    return true;
         }
+        return false;
+    }
 
-        for(int i=0;i<sizeof(gamepadLookupTable)/sizeof(GamepadInfoEntry);i++)
+    void syncGamepadState(ConnectedGamepadDevInfo& info)
+    {
+        // Reads the whole state of the device, when it is connected or after the kernel dropped events
+        unsigned long keyBits[KEY_MAX / (8 * sizeof(unsigned long)) + 1];
+        memset(keyBits, 0, sizeof(keyBits));
+        ioctl(info.fd, EVIOCGKEY(sizeof(keyBits)), keyBits);
+
+        info.buttons = 0;
+        for (unsigned int i = 0; i < __gamepadButtonCount; ++i)
         {
-            const GamepadInfoEntry& curEntry = gamepadLookupTable[i];
-            if(curEntry.vendorId == 0 && curEntry.productId == 0 && curEntry.numberOfAxes == numberOfAxes && curEntry.numberOfButtons == numberOfButtons)
-            {
-                return curEntry;
-            }
+            if (testBit(keyBits, __gamepadButtons[i].code))
+                info.buttons |= (1 << __gamepadButtons[i].mapping);
         }
 
-        return gamepadLookupTable[0];
+        for (unsigned int i = 0; i < GAMEPAD_AXIS_COUNT; ++i)
+        {
+            struct input_absinfo absInfo;
+            if (hasGamepadAxis(info, i) && ioctl(info.fd, EVIOCGABS(__gamepadAxes[i].code), &absInfo) == 0)
+                info.axisValue[i] = absInfo.value;
+        }
+        info.dropped = false;
     }
 
-    const GamepadInfoEntry& getGamepadMappedInfo(const GamepadHandle handle)
+    void handleConnectedGamepad(dev_t devId, const char* devPath)
     {
-        GP_ASSERT(handle >= 0);
+        GP_ASSERT(devPath);
 
-        for(list<ConnectedGamepadDevInfo>::iterator it = __connectedGamepads.begin(); it != __connectedGamepads.end();++it)
+        // Most input devices are not readable by the user, and new gamepads only become
+        // readable once udev has set their permissions, which the hotplug watch reports.
+        GamepadHandle handle = ::open(devPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if(handle < 0)
+            return;
+
+        // Only devices with the buttons of the gamepad API are gamepads
+        unsigned long keyBits[KEY_MAX / (8 * sizeof(unsigned long)) + 1];
+        unsigned long absBits[ABS_MAX / (8 * sizeof(unsigned long)) + 1];
+        struct input_id id;
+        memset(keyBits, 0, sizeof(keyBits));
+        memset(absBits, 0, sizeof(absBits));
+        memset(&id, 0, sizeof(id));
+        if (ioctl(handle, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0 || !testBit(keyBits, BTN_GAMEPAD) ||
+            ioctl(handle, EVIOCGID, &id) < 0 || isBlackListed(id.vendor, id.product))
         {
-            if(handle == (*it).fd)
+            ::close(handle);
+            return;
+        }
+        ioctl(handle, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits);
+
+        ConnectedGamepadDevInfo info;
+        memset(&info, 0, sizeof(info));
+        info.deviceId = devId;
+        info.fd = handle;
+        info.ready = true;
+        for (unsigned int i = 0; i < GAMEPAD_AXIS_COUNT; ++i)
+        {
+            struct input_absinfo absInfo;
+            if (testBit(absBits, __gamepadAxes[i].code) && ioctl(handle, EVIOCGABS(__gamepadAxes[i].code), &absInfo) == 0)
             {
-                return it->gamepadInfo;
+                info.axisMin[i] = absInfo.minimum;
+                info.axisMax[i] = absInfo.maximum;
+                info.axisFlat[i] = absInfo.flat;
             }
         }
-        GP_WARN("Gamepad not connected but yet trying to get its data. Falling back to generic one.");
-        return gamepadLookupTable[0];
-    }
+        syncGamepadState(info);
 
-    const GamepadJoystickAxisInfo* tryGetGamepadMappedAxisInfo(const GamepadInfoEntry& gpinfo, unsigned int axisNumber)
-    {
-        if(axisNumber >= 0 && axisNumber < gpinfo.numberOfAxes)
+        unsigned int buttonCount = 0;
+        for (unsigned int i = 0; i < __gamepadButtonCount; ++i)
         {
-            int i = 0;
-            while(true)
-            {
-                const GamepadJoystickAxisInfo* curAxisInfo = &gpinfo.axes[i++];
-                if(curAxisInfo->axisIndex == axisNumber)
-                    return curAxisInfo;
-                else if(curAxisInfo->axisIndex < 0)
-                    return NULL;
-            }
+            if (testBit(keyBits, __gamepadButtons[i].code))
+                ++buttonCount;
         }
-        return NULL;
+        if (hasGamepadAxis(info, 6) && !testBit(keyBits, BTN_DPAD_UP))
+            buttonCount += 4;
+        unsigned int numJS = hasGamepadAxis(info, 0) ? (hasGamepadAxis(info, 2) ? 2 : 1) : 0;
+        unsigned int numTR = hasGamepadAxis(info, 4) ? (hasGamepadAxis(info, 5) ? 2 : 1) : 0;
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = handle;
+        if (epoll_ctl(__gamepadPoll, EPOLL_CTL_ADD, handle, &event) < 0)
+        {
+            GP_WARN("Failed to wait on gamepad device '%s'.", devPath);
+            ::close(handle);
+            return;
+        }
+
+        char name[256] = "";
+        ioctl(handle, EVIOCGNAME(sizeof(name)), name);
+
+        __connectedGamepads.push_back(info);
+        Platform::gamepadEventConnectedInternal(handle,buttonCount,numJS,numTR,id.vendor,id.product,"",name);
     }
 
-    bool tryGetGamepadMappedButton(const GamepadInfoEntry& gpinfo, unsigned long btnNumber, long& outMap)
+    static float normalizeJoystickAxis(const ConnectedGamepadDevInfo& info, unsigned int axis)
     {
-        if(btnNumber >= 0 && btnNumber < gpinfo.numberOfButtons )
-        {
-            if(gpinfo.buttons[btnNumber] >= 0)
-            {
-                outMap = gpinfo.buttons[btnNumber];
-                return true;
-            }
-            else
-            {
-                return false;
-            }
-        }
-        GP_WARN("Unmapped gamepad button: %u.",btnNumber);
-        return false;
+        float halfRange = (info.axisMax[axis] - info.axisMin[axis]) * 0.5f;
+        float value = (info.axisValue[axis] - info.axisMin[axis] - halfRange) / halfRange;
+        float deadZone = info.axisFlat[axis] > 0 ? info.axisFlat[axis] / halfRange : GAMEPAD_DEAD_ZONE;
+        float magnitude = fabs(value);
+        if (magnitude <= deadZone || deadZone >= 1.0f)
+            return 0.0f;
+
+        magnitude = std::min((magnitude - deadZone) / (1.0f - deadZone), 1.0f);
+        return value < 0 ? -magnitude : magnitude;
     }
 
-    unsigned int readIntegerGamepadIdPropery(const char* sysFSIdPath, const char* propertyName)
+    static float normalizeTriggerAxis(const ConnectedGamepadDevInfo& info, unsigned int axis)
     {
-        unsigned int ret = 0;
-        try {
-            ifstream propStream;
-            propStream.open((string(sysFSIdPath) + propertyName).c_str(),ifstream::in);
-            propStream >> std::hex >> ret;
-            propStream.close();
-        } catch (exception e) {
-            GP_WARN("Could not read propery from SysFS for Gamepad: %s", propertyName);
-        }
-        return ret;
+        float range = (float)(info.axisMax[axis] - info.axisMin[axis]);
+        float value = (info.axisValue[axis] - info.axisMin[axis]) / range;
+        float deadZone = info.axisFlat[axis] / range;
+        if (value <= deadZone || deadZone >= 1.0f)
+            return 0.0f;
+
+        return std::min((value - deadZone) / (1.0f - deadZone), 1.0f);
     }
 
-    bool isBlackListed(unsigned int vendorId, unsigned int productId)
+    void openGamepadDevice(const char* devPath)
     {
-        switch(vendorId)
-        {
-            case 0x0e0f: //virtual machine devices
-                if(productId == 0x0003) // Virtual Mouse
-                    return true;
-        }
-        return false;
+        struct stat gpstat;
+        if(::stat(devPath,&gpstat) == 0 && S_ISCHR(gpstat.st_mode) && !isGamepadDevRegistered(gpstat.st_rdev))
+            handleConnectedGamepad(gpstat.st_rdev,devPath);
     }
 
-    void handleConnectedGamepad(dev_t devId, const char* devPath, const char* sysFSIdPath)
+    void enumGamepads()
     {
-        GP_ASSERT(devPath);
+        DIR* dir = opendir("/dev/input");
+        if (dir == NULL)
+            return;
 
-        unsigned int vendorId =readIntegerGamepadIdPropery(sysFSIdPath,"vendor");
-        unsigned int productId =readIntegerGamepadIdPropery(sysFSIdPath,"product");
+        char devPath[64];
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if (strncmp(entry->d_name, "event", 5) == 0)
+            {
+                snprintf(devPath, sizeof(devPath), "/dev/input/%s", entry->d_name);
+                openGamepadDevice(devPath);
+            }
+        }
+        closedir(dir);
+    }
 
-        if(isBlackListed(vendorId,productId)) return;
+    void initializeGamepads()
+    {
+        __gamepadsInitialized = true;
 
-        GamepadHandle handle = ::open(devPath,O_RDONLY | O_NONBLOCK);
-        if(handle < 0)
+        __gamepadPoll = epoll_create1(EPOLL_CLOEXEC);
+        if (__gamepadPoll < 0)
         {
-            GP_WARN("Could not open Gamepad device.");
+            GP_WARN("Failed to create the epoll instance for gamepads; gamepads are disabled.");
             return;
         }
 
-        if(!(fcntl(handle, F_GETFL) != -1 || errno != EBADF))
-            return;
-
-        char axesNum, btnsNum, name[256];
-        ioctl(handle, JSIOCGNAME(256), name);
-        ioctl (handle, JSIOCGAXES, &axesNum);
-        ioctl (handle, JSIOCGBUTTONS, &btnsNum);
-
-        const GamepadInfoEntry& gpInfo = getGamepadMappedInfo(vendorId,productId,(unsigned int)axesNum,(unsigned int)btnsNum);
-        unsigned int numJS = gpInfo.numberOfJS;
-        unsigned int numTR = gpInfo.numberOfTriggers;
-
-
-        Platform::gamepadEventConnectedInternal(handle,btnsNum,numJS,numTR,vendorId,productId,"",name);
+        // Gamepads connected later are found when udev creates their device node or sets its permissions
+        __gamepadWatch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = __gamepadWatch;
+        if (__gamepadWatch < 0 || inotify_add_watch(__gamepadWatch, "/dev/input", IN_CREATE | IN_ATTRIB) < 0 ||
+            epoll_ctl(__gamepadPoll, EPOLL_CTL_ADD, __gamepadWatch, &event) < 0)
+        {
+            GP_WARN("Failed to watch /dev/input; gamepads connected after the start are not detected.");
+            if (__gamepadWatch >= 0)
+                ::close(__gamepadWatch);
+            __gamepadWatch = -1;
+        }
 
-        ConnectedGamepadDevInfo info = {devId,handle,gpInfo}; 
-        __connectedGamepads.push_back(info);
+        enumGamepads();
     }
 
-    static float normalizeJoystickAxis(int axisValue, int deadZone, bool zeroToOne)
+    void handleGamepadHotplug()
     {
-        int absAxisValue = 0;
-        if(zeroToOne)
-            absAxisValue = (axisValue + 32767) / 2.0;
-        else
-             absAxisValue = abs(axisValue);
-
-        if (absAxisValue < deadZone)
-        {
-            return 0.0f;
-        }
-        else
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t size;
+        while ((size = read(__gamepadWatch, buffer, sizeof(buffer))) > 0)
         {
-            int maxVal = 0;
-            int value = 0;
-            if(!zeroToOne)
+            for (char* p = buffer; p < buffer + size; )
             {
-                value = axisValue;
-                if (value < 0)
+                const struct inotify_event* event = (const struct inotify_event*)p;
+                if (event->len > 0 && strncmp(event->name, "event", 5) == 0)
                 {
-                    value = -1;
-                    maxVal = 32768;
+                    char devPath[64];
+                    snprintf(devPath, sizeof(devPath), "/dev/input/%s", event->name);
+                    openGamepadDevice(devPath);
                 }
-                else if (value > 0)
-                {
-                    value = 1;
-                    maxVal = 32767;
-                }
-                else
-                {
-                    return 0.0f;
-                }
-            }
-            else
-            {
-                value = 1;
-                maxVal = 32767;
+                p += sizeof(struct inotify_event) + event->len;
             }
-
-            float ret = value * (absAxisValue - deadZone) / (float)(maxVal - deadZone);
-            return ret;
         }
     }
 
-    void enumGamepads()
+    void gamepadHandlingLoop()
     {
-        const int maxDevs = 16;
-        const char* devPathFormat = "/dev/input/js%u";
-        const char* sysfsPathFormat = "/sys/class/input/js%u/device/id/";
-        char curDevPath[20];
+        if (!__gamepadsInitialized)
+            initializeGamepads();
+        if (__gamepadPoll < 0)
+            return;
 
-        for(int i=0;i<maxDevs;i++)
+        // One call, which does not block, finds the gamepads with pending input, the
+        // disconnected gamepads and the new devices. The input itself is read when the
+        // gamepads are updated, so that replays can keep the physical gamepads out.
+        struct epoll_event events[16];
+        int count = epoll_wait(__gamepadPoll, events, 16, 0);
+        for (int i = 0; i < count; ++i)
         {
-            sprintf(curDevPath,devPathFormat,i);
-            struct stat gpstat;
-            if(::stat(curDevPath,&gpstat) == 0)
+            int fd = events[i].data.fd;
+            if (fd == __gamepadWatch)
             {
-                dev_t devid = gpstat.st_rdev;
-                if(!isGamepadDevRegistered(devid))
-                {
-                    char cursysFSPath[35];
-                    sprintf(cursysFSPath,sysfsPathFormat,i);
-                    handleConnectedGamepad(devid,curDevPath,cursysFSPath);
-                }
+                handleGamepadHotplug();
+                continue;
             }
-        }
-    }
 
-    void gamepadHandlingLoop()
-    {
-        enumGamepads();
+            ConnectedGamepadDevInfo* info = findGamepad(fd);
+            if (info == NULL)
+                continue;
+
+            if (events[i].events & (EPOLLHUP | EPOLLERR))
+            {
+                unregisterGamepad(fd);
+                Platform::gamepadEventDisconnectedInternal(fd);
+            }
+            else
+            {
+                info->ready = true;
+            }
+        }
     }
 
     int Platform::enterMessagePump()
@@ -1113,6 +1142,8 @@ namespace gameplay
 
         static bool shiftDown = false;
         static bool capsOn = false;
+        static bool focused = true;
+        static bool mapped = true;
         static XEvent evt;
 
         // Get the initial time.
@@ -1133,7 +1164,8 @@ namespace gameplay
         // Message loop.
         while (true)
         {
-            poll( xpolls, 1, 16 );
+            // Don't block on events; the frame pacer of the game waits when frames are limited.
+            poll( xpolls, 1, 0 );
             // handle all pending events in one block
             while (XPending(__display))
             {
@@ -1150,6 +1182,19 @@ namespace gameplay
                             }
                         }
                         break;
+                    case FocusIn:
+                    case FocusOut:
+                    case MapNotify:
+                    case UnmapNotify:
+                        {
+                            // The game is in the background while the window is unfocused or minimized.
+                            if (evt.type == FocusIn || evt.type == FocusOut)
+                                focused = (evt.type == FocusIn);
+                            else
+                                mapped = (evt.type == MapNotify);
+                            gameplay::Platform::backgroundEventInternal(!focused || !mapped);
+                        }
+                        break;
                     case DestroyNotify :
                         {
                             cleanupX11();
@@ -1314,7 +1359,7 @@ namespace gameplay
                 _game->frame();
             }
 
-            glXSwapBuffers(__display, __window);
+            swapBuffers();
         }
 
         cleanupX11();
@@ -1373,6 +1418,9 @@ namespace gameplay
 
     void Platform::swapBuffers()
     {
+        // While a render thread replays the frames, it presents them.
+        if (__renderContext && glXGetCurrentContext() != __renderContext)
+            return;
         glXSwapBuffers(__display, __window);
     }
 
@@ -1381,6 +1429,58 @@ namespace gameplay
         usleep(ms * 1000);
     }
 
+    bool Platform::createLoaderContext()
+    {
+        if (__loaderContext == NULL)
+            __loaderContext = glXCreateContext(__display, __visualInfo, __context, True);
+        return __loaderContext != NULL;
+    }
+
+    bool Platform::makeLoaderContextCurrent(bool current)
+    {
+        GP_ASSERT(__loaderContext);
+
+        // The loader context never draws, so it can share the window as its drawable.
+        if (current)
+            return glXMakeCurrent(__display, __window, __loaderContext) == True;
+        return glXMakeCurrent(__display, None, NULL) == True;
+    }
+
+    void Platform::destroyLoaderContext()
+    {
+        if (__loaderContext)
+        {
+            glXDestroyContext(__display, __loaderContext);
+            __loaderContext = NULL;
+        }
+    }
+
+    bool Platform::createRenderContext()
+    {
+        if (__renderContext == NULL)
+            __renderContext = glXCreateContext(__display, __visualInfo, __context, True);
+        return __renderContext != NULL;
+    }
+
+    bool Platform::makeRenderContextCurrent(bool current)
+    {
+        GP_ASSERT(__renderContext);
+
+        // A window can be current to several contexts, so the game thread keeps its own context on it.
+        if (current)
+            return glXMakeCurrent(__display, __window, __renderContext) == True;
+        return glXMakeCurrent(__display, None, NULL) == True;
+    }
+
+    void Platform::destroyRenderContext()
+    {
+        if (__renderContext)
+        {
+            glXDestroyContext(__display, __renderContext);
+            __renderContext = NULL;
+        }
+    }
+
     void Platform::setMultiSampling(bool enabled)
     {
         if (enabled == __multiSampling)
@@ -1562,88 +1662,105 @@ namespace gameplay
     {
         GP_ASSERT(gamepad);
 
-        struct js_event jevent;
-        const GamepadInfoEntry& gpInfo = getGamepadMappedInfo(gamepad->_handle);
+        ConnectedGamepadDevInfo* info = findGamepad(gamepad->_handle);
+        if (info == NULL || !info->ready)
+            return;
 
-        while (read(gamepad->_handle, &jevent, sizeof(struct js_event)) > 0)
+        // The kernel queues whole reports, so everything read ends with a report
+        struct input_event events[64];
+        ssize_t size;
+        while ((size = read(info->fd, events, sizeof(events))) > 0)
         {
-            switch (jevent.type)
+            for (size_t i = 0, count = size / sizeof(struct input_event); i < count; ++i)
             {
-                case JS_EVENT_BUTTON:
-                case JS_EVENT_BUTTON | JS_EVENT_INIT:
+                const struct input_event& evt = events[i];
+                if (evt.type == EV_SYN)
+                {
+                    if (evt.code == SYN_DROPPED)
+                    {
+                        info->dropped = true;
+                    }
+                    else if (evt.code == SYN_REPORT)
                     {
-                        long curMappingIndex = -1;
-                        if(tryGetGamepadMappedButton(gpInfo, jevent.number, curMappingIndex))
+                        if (info->dropped)
+                            syncGamepadState(*info);
+
+                        // Event times are taken from the same clock as getAbsoluteTime
+                        info->eventTime = evt.input_event_sec * 1000.0 + evt.input_event_usec * 0.001 - __timeStart;
+                    }
+                }
+                else if (info->dropped)
+                {
+                    continue;
+                }
+                else if (evt.type == EV_KEY)
+                {
+                    for (unsigned int j = 0; j < __gamepadButtonCount; ++j)
+                    {
+                        if (__gamepadButtons[j].code == evt.code)
                         {
-                            unsigned int buttons = 0;
-                            if (jevent.value)
-                                buttons |= (1 << curMappingIndex);
+                            if (evt.value)
+                                info->buttons |= (1 << __gamepadButtons[j].mapping);
                             else
-                                buttons &= ~(1 << curMappingIndex);
-                            gamepad->setButtons(buttons);
+                                info->buttons &= ~(1 << __gamepadButtons[j].mapping);
+                            break;
                         }
-                        break;
                     }
-                case JS_EVENT_AXIS:
-                case JS_EVENT_AXIS | JS_EVENT_INIT:
+                }
+                else if (evt.type == EV_ABS)
+                {
+                    for (unsigned int j = 0; j < GAMEPAD_AXIS_COUNT; ++j)
                     {
-                        if(jevent.number < gpInfo.numberOfAxes)
+                        if (__gamepadAxes[j].code == evt.code)
                         {
-                            const GamepadJoystickAxisInfo* jsInfo = tryGetGamepadMappedAxisInfo(gpInfo,jevent.number);
-                            if(jsInfo)
-                            {
-                                float val = normalizeJoystickAxis(jevent.value,jsInfo->deadZone,jsInfo->mapFunc == ZERO_TO_POS);
-                                if(!(jsInfo->flags & GP_AXIS_SKIP))
-                                {
-                                    if((jsInfo->flags & GP_AXIS_IS_NEG))
-                                        val = -1.0f * val;
-
-                                    bool not_js_axis = false;
-                                    if((jsInfo->flags & GP_AXIS_IS_DPAD))
-                                    {
-                                        unsigned int buttons = 0;
-                                        if(jevent.value != 0)
-                                            buttons |= (1 << (jevent.value > 0 ? jsInfo->mappedPosArg : jsInfo->mappedNegArg));
-                                        else
-                                        {
-                                            buttons &= ~(1 << jsInfo->mappedPosArg);
-                                            buttons &= ~(1 << jsInfo->mappedNegArg);
-                                        }
-                                        gamepad->setButtons(buttons);
-                                        not_js_axis = true;
-                                    }
-                                    if((jsInfo->flags & GP_AXIS_IS_TRIGGER))
-                                    {
-                                        gamepad->setTriggerValue(jsInfo->mappedPosArg, val);
-                                        not_js_axis = true;
-                                    }
-
-                                    if(!not_js_axis)
-                                    {
-                                        Vector2 jsVals;
-                                        gamepad->getJoystickValues(jsInfo->joystickIndex,&jsVals);
-                                        if(jsInfo->flags & GP_AXIS_IS_XAXIS)
-                                            jsVals.x = val;
-                                        else
-                                            jsVals.y = val;
-                                        gamepad->setJoystickValue(jsInfo->joystickIndex,jsVals.x,jsVals.y);
-                                    }
-                                }
-                            }
+                            info->axisValue[j] = evt.value;
+                            break;
                         }
                     }
-                    break;
-
-                default: 
-                    GP_WARN("unhandled gamepad event: %x\n", jevent.type);
+                }
             }
         }
-        if(errno == ENODEV)
+        info->ready = false;
+
+        // Hand the state over; the gamepad only raises events for the values that changed
+        unsigned int buttons = info->buttons;
+        Vector2 joysticks[2];
+        float triggers[2] = { 0.0f, 0.0f };
+        for (unsigned int i = 0; i < GAMEPAD_AXIS_COUNT; ++i)
         {
-            unregisterGamepad(gamepad->_handle);
-            gamepadEventDisconnectedInternal(gamepad->_handle);
+            if (!hasGamepadAxis(*info, i))
+                continue;
+
+            const GamepadAxisMapping& axis = __gamepadAxes[i];
+            int value = info->axisValue[i];
+            switch (axis.target)
+            {
+                case GP_AXIS_JOYSTICK_X:
+                    joysticks[axis.index].x = normalizeJoystickAxis(*info, i);
+                    break;
+                case GP_AXIS_JOYSTICK_Y:
+                    joysticks[axis.index].y = -normalizeJoystickAxis(*info, i);
+                    break;
+                case GP_AXIS_TRIGGER:
+                    triggers[axis.index] = normalizeTriggerAxis(*info, i);
+                    break;
+                case GP_AXIS_DPAD_X:
+                    if (value != 0)
+                        buttons |= (1 << (value > 0 ? Gamepad::BUTTON_RIGHT : Gamepad::BUTTON_LEFT));
+                    break;
+                case GP_AXIS_DPAD_Y:
+                    if (value != 0)
+                        buttons |= (1 << (value > 0 ? Gamepad::BUTTON_DOWN : Gamepad::BUTTON_UP));
+                    break;
+            }
         }
 
+        gamepad->_eventTime = info->eventTime;
+        gamepad->setButtons(buttons);
+        for (unsigned int i = 0; i < gamepad->_joystickCount && i < 2; ++i)
+            gamepad->setJoystickValue(i, joysticks[i].x, joysticks[i].y);
+        for (unsigned int i = 0; i < gamepad->_triggerCount && i < 2; ++i)
+            gamepad->setTriggerValue(i, triggers[i]);
     }
 
     bool Platform::launchURL(const char* url)
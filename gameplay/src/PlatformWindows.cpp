@@ -7,6 +7,7 @@
 #include "Form.h"
 #include "Vector2.h"
 #include "ScriptController.h"
+#include "StartupTrace.h"
 #include <GL/wglew.h>
 #include <windowsx.h>
 #include <shellapi.h>
@@ -32,6 +33,8 @@ static HWND __attachToWindow = 0;
 static HWND __hwnd = 0;
 static HDC __hdc = 0;
 static HGLRC __hrc = 0;
+static HGLRC __loaderContext = 0;
+static HGLRC __renderContext = 0;
 static bool __mouseCaptured = false;
 static POINT __mouseCapturePoint = { 0, 0 };
 static bool __multiSampling = false;
@@ -470,9 +473,11 @@ LRESULT CALLBACK __WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         break;
 
     case WM_SETFOCUS:
+        gameplay::Platform::backgroundEventInternal(false);
         break;
 
     case WM_KILLFOCUS:
+        gameplay::Platform::backgroundEventInternal(true);
         break;
 
     case WM_SIZE:
@@ -588,6 +593,8 @@ bool createWindow(WindowCreationParams* params, HWND* hwnd, HDC* hdc)
 
 bool initializeGL(WindowCreationParams* params)
 {
+    StartupTrace::Scope trace("GL context");
+
     // Create a temporary window and context to we can initialize GLEW and get access
     // to additional OpenGL extension functions. This is a neccessary evil since the
     // function for querying GL extensions is a GL extension itself.
@@ -996,7 +1003,7 @@ int Platform::enterMessagePump()
             }
 #endif
             _game->frame();
-            SwapBuffers(__hdc);
+            Platform::swapBuffers();
         }
 
         // If we are done, then exit.
@@ -1058,6 +1065,9 @@ void Platform::setVsync(bool enable)
 
 void Platform::swapBuffers()
 {
+    // While a render thread replays the frames, it presents them.
+    if (__renderContext && wglGetCurrentContext() != __renderContext)
+        return;
     if (__hdc)
         SwapBuffers(__hdc);
 }
@@ -1067,6 +1077,70 @@ void Platform::sleep(long ms)
     Sleep(ms);
 }
 
+bool Platform::createLoaderContext()
+{
+    if (__loaderContext == 0)
+    {
+        int attribs[] =
+        {
+            WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+            WGL_CONTEXT_MINOR_VERSION_ARB, 1,
+            0
+        };
+        __loaderContext = wglCreateContextAttribsARB(__hdc, __hrc, attribs);
+    }
+    return __loaderContext != 0;
+}
+
+bool Platform::makeLoaderContextCurrent(bool current)
+{
+    GP_ASSERT(__loaderContext);
+
+    // The loader context never draws, so it can share the device context of the window.
+    return wglMakeCurrent(current ? __hdc : NULL, current ? __loaderContext : NULL) == TRUE;
+}
+
+void Platform::destroyLoaderContext()
+{
+    if (__loaderContext)
+    {
+        wglDeleteContext(__loaderContext);
+        __loaderContext = 0;
+    }
+}
+
+bool Platform::createRenderContext()
+{
+    if (__renderContext == 0)
+    {
+        int attribs[] =
+        {
+            WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+            WGL_CONTEXT_MINOR_VERSION_ARB, 1,
+            0
+        };
+        __renderContext = wglCreateContextAttribsARB(__hdc, __hrc, attribs);
+    }
+    return __renderContext != 0;
+}
+
+bool Platform::makeRenderContextCurrent(bool current)
+{
+    GP_ASSERT(__renderContext);
+
+    // A device context can be used by several rendering contexts, so the game thread keeps its own.
+    return wglMakeCurrent(current ? __hdc : NULL, current ? __renderContext : NULL) == TRUE;
+}
+
+void Platform::destroyRenderContext()
+{
+    if (__renderContext)
+    {
+        wglDeleteContext(__renderContext);
+        __renderContext = 0;
+    }
+}
+
 void Platform::setMultiSampling(bool enabled)
 {
     if (enabled == __multiSampling)
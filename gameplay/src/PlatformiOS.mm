@@ -1407,6 +1407,36 @@ void Platform::sleep(long ms)
     usleep(ms * 1000);
 }
 
+bool Platform::createLoaderContext()
+{
+    // Shared contexts are not implemented on this platform; uploads run on the main thread.
+    return false;
+}
+
+bool Platform::makeLoaderContextCurrent(bool current)
+{
+    return false;
+}
+
+void Platform::destroyLoaderContext()
+{
+}
+
+bool Platform::createRenderContext()
+{
+    // Shared contexts are not implemented on this platform; frames render on the game thread.
+    return false;
+}
+
+bool Platform::makeRenderContextCurrent(bool current)
+{
+    return false;
+}
+
+void Platform::destroyRenderContext()
+{
+}
+
 bool Platform::hasAccelerometer()
 {
     return true;
@@ -0,0 +1,389 @@
+#include "Base.h"
+#include "PostProcessor.h"
+#include "Game.h"
+#include "FrameBuffer.h"
+#include "Material.h"
+#include "Model.h"
+
+#define POSTPROCESS_VSH "res/shaders/postprocess.vert"
+#define POSTPROCESS_FSH "res/shaders/postprocess.frag"
+#define POSTPROCESS_BLOOM_FSH "res/shaders/postprocess-bloom.frag"
+
+// Divisor of the viewport size that bloom is drawn at.
+#define POSTPROCESS_BLOOM_DIVISOR 4
+
+namespace gameplay
+{
+
+/**
+ * Creates the material of a full screen pass, which replaces whatever is under it.
+ */
+static Material* createPassMaterial(const char* fshPath, const char* defines)
+{
+    Material* material = Material::create(POSTPROCESS_VSH, fshPath, defines);
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create the post-processing material for '%s' with defines '%s'.", fshPath, defines ? defines : "");
+        return NULL;
+    }
+    RenderState::StateBlock* stateBlock = material->getStateBlock();
+    stateBlock->setCullFace(false);
+    stateBlock->setDepthTest(false);
+    stateBlock->setDepthWrite(false);
+    stateBlock->setBlend(false);
+    return material;
+}
+
+/**
+ * Binds a texture to a sampler parameter, keeping the sampler of the previous frame when the
+ * pool handed out the same target again.
+ */
+static void setTexture(Material* material, const char* name, Texture* texture)
+{
+    MaterialParameter* parameter = material->getParameter(name);
+    Texture::Sampler* sampler = parameter->getSampler();
+    if (sampler && sampler->getTexture() == texture)
+        return;
+
+    sampler = Texture::Sampler::create(texture);
+    sampler->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    parameter->setValue(sampler);
+    SAFE_RELEASE(sampler);
+}
+
+PostProcessor::PostProcessor()
+    : _enabled(false), _rendering(false), _bloom(false), _bloomThreshold(0.8f), _bloomIntensity(1.0f),
+      _toneMapping(false), _exposure(1.0f), _fxaa(false), _colorGrading(NULL), _quad(NULL), _brightPass(NULL),
+      _frameBuffer(NULL), _previousFrameBuffer(NULL), _features(0), _sceneTarget(0), _bloomTarget(0), _scratchTarget(0)
+{
+    _blur[0] = _blur[1] = NULL;
+    for (unsigned int i = 0; i < FEATURE_COMBINATIONS; ++i)
+    {
+        _fused[i] = NULL;
+    }
+}
+
+PostProcessor::~PostProcessor()
+{
+}
+
+void PostProcessor::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    _enabled = properties->getBool("enabled");
+    _bloom = properties->getBool("bloom");
+    if (properties->exists("bloomThreshold"))
+        setBloomThreshold(properties->getFloat("bloomThreshold"));
+    if (properties->exists("bloomIntensity"))
+        setBloomIntensity(properties->getFloat("bloomIntensity"));
+    _toneMapping = properties->getBool("toneMapping");
+    if (properties->exists("exposure"))
+        setExposure(properties->getFloat("exposure"));
+    _fxaa = properties->getBool("fxaa");
+    if (properties->exists("colorGrading"))
+    {
+        _colorGrading = Texture::create(properties->getString("colorGrading"), false);
+        if (_colorGrading == NULL)
+            GP_WARN("Failed to load the color grading lookup table '%s'.", properties->getString("colorGrading"));
+    }
+}
+
+void PostProcessor::finalize()
+{
+    for (unsigned int i = 0; i < FEATURE_COMBINATIONS; ++i)
+    {
+        SAFE_RELEASE(_fused[i]);
+    }
+    SAFE_RELEASE(_blur[0]);
+    SAFE_RELEASE(_blur[1]);
+    SAFE_RELEASE(_brightPass);
+    SAFE_RELEASE(_quad);
+    SAFE_RELEASE(_colorGrading);
+    _graph.reset();
+    SAFE_RELEASE(_frameBuffer);
+}
+
+bool PostProcessor::isEnabled() const
+{
+    return _enabled;
+}
+
+void PostProcessor::setEnabled(bool enabled)
+{
+    GP_ASSERT(!_rendering);
+    _enabled = enabled;
+}
+
+bool PostProcessor::isBloomEnabled() const
+{
+    return _bloom;
+}
+
+void PostProcessor::setBloomEnabled(bool enabled)
+{
+    _bloom = enabled;
+}
+
+float PostProcessor::getBloomThreshold() const
+{
+    return _bloomThreshold;
+}
+
+void PostProcessor::setBloomThreshold(float threshold)
+{
+    _bloomThreshold = MATH_CLAMP(threshold, 0.0f, 1.0f);
+}
+
+float PostProcessor::getBloomIntensity() const
+{
+    return _bloomIntensity;
+}
+
+void PostProcessor::setBloomIntensity(float intensity)
+{
+    if (intensity < 0.0f)
+    {
+        GP_WARN("Invalid bloom intensity %f.", intensity);
+        return;
+    }
+    _bloomIntensity = intensity;
+}
+
+bool PostProcessor::isToneMappingEnabled() const
+{
+    return _toneMapping;
+}
+
+void PostProcessor::setToneMappingEnabled(bool enabled)
+{
+    _toneMapping = enabled;
+}
+
+float PostProcessor::getExposure() const
+{
+    return _exposure;
+}
+
+void PostProcessor::setExposure(float exposure)
+{
+    if (exposure <= 0.0f)
+    {
+        GP_WARN("Invalid exposure %f.", exposure);
+        return;
+    }
+    _exposure = exposure;
+}
+
+bool PostProcessor::isFxaaEnabled() const
+{
+    return _fxaa;
+}
+
+void PostProcessor::setFxaaEnabled(bool enabled)
+{
+    _fxaa = enabled;
+}
+
+Texture* PostProcessor::getColorGradingTexture() const
+{
+    return _colorGrading;
+}
+
+void PostProcessor::setColorGradingTexture(Texture* texture)
+{
+    if (texture == _colorGrading)
+        return;
+
+    if (texture)
+        texture->addRef();
+    SAFE_RELEASE(_colorGrading);
+    _colorGrading = texture;
+}
+
+unsigned int PostProcessor::getFeatures() const
+{
+    unsigned int features = 0;
+    if (_bloom && _bloomIntensity > 0.0f)
+        features |= FEATURE_BLOOM;
+    if (_toneMapping)
+        features |= FEATURE_TONE_MAPPING;
+    if (_fxaa)
+        features |= FEATURE_FXAA;
+    if (_colorGrading)
+        features |= FEATURE_COLOR_GRADING;
+    return features;
+}
+
+Material* PostProcessor::getFusedMaterial(unsigned int features)
+{
+    GP_ASSERT(features < FEATURE_COMBINATIONS);
+
+    if (_fused[features] == NULL)
+    {
+        std::string defines;
+        if (features & FEATURE_BLOOM)
+            defines += "BLOOM;";
+        if (features & FEATURE_TONE_MAPPING)
+            defines += "TONE_MAPPING;";
+        if (features & FEATURE_FXAA)
+            defines += "FXAA;";
+        if (features & FEATURE_COLOR_GRADING)
+            defines += "COLOR_GRADING;";
+        if (!defines.empty())
+            defines.erase(defines.size() - 1);
+        _fused[features] = createPassMaterial(POSTPROCESS_FSH, defines.c_str());
+    }
+    return _fused[features];
+}
+
+bool PostProcessor::createBloomMaterials()
+{
+    if (_brightPass == NULL)
+    {
+        _brightPass = createPassMaterial(POSTPROCESS_BLOOM_FSH, "BRIGHT_PASS");
+        _blur[0] = createPassMaterial(POSTPROCESS_BLOOM_FSH, NULL);
+        _blur[1] = createPassMaterial(POSTPROCESS_BLOOM_FSH, NULL);
+    }
+    return _brightPass && _blur[0] && _blur[1];
+}
+
+void PostProcessor::drawBrightPass(FrameGraph* graph, void* cookie)
+{
+    PostProcessor* postProcessor = (PostProcessor*)cookie;
+    Texture* scene = graph->getTexture(postProcessor->_sceneTarget);
+    Material* material = postProcessor->_brightPass;
+    setTexture(material, "u_texture", scene);
+    material->getParameter("u_texelSize")->setValue(Vector2(1.0f / scene->getWidth(), 1.0f / scene->getHeight()));
+    material->getParameter("u_threshold")->setValue(postProcessor->_bloomThreshold);
+    postProcessor->_quad->draw(material);
+}
+
+void PostProcessor::drawHorizontalBlur(FrameGraph* graph, void* cookie)
+{
+    PostProcessor* postProcessor = (PostProcessor*)cookie;
+    Texture* bloom = graph->getTexture(postProcessor->_bloomTarget);
+    Material* material = postProcessor->_blur[0];
+    setTexture(material, "u_texture", bloom);
+    material->getParameter("u_direction")->setValue(Vector2(1.0f / bloom->getWidth(), 0.0f));
+    postProcessor->_quad->draw(material);
+}
+
+void PostProcessor::drawVerticalBlur(FrameGraph* graph, void* cookie)
+{
+    PostProcessor* postProcessor = (PostProcessor*)cookie;
+    Texture* scratch = graph->getTexture(postProcessor->_scratchTarget);
+    Material* material = postProcessor->_blur[1];
+    setTexture(material, "u_texture", scratch);
+    material->getParameter("u_direction")->setValue(Vector2(0.0f, 1.0f / scratch->getHeight()));
+    postProcessor->_quad->draw(material);
+}
+
+void PostProcessor::drawFusedPass(FrameGraph* graph, void* cookie)
+{
+    PostProcessor* postProcessor = (PostProcessor*)cookie;
+    unsigned int features = postProcessor->_features;
+    Material* material = postProcessor->getFusedMaterial(features);
+    if (material == NULL)
+        return;
+
+    Texture* scene = graph->getTexture(postProcessor->_sceneTarget);
+    setTexture(material, "u_texture", scene);
+    material->getParameter("u_texelSize")->setValue(Vector2(1.0f / scene->getWidth(), 1.0f / scene->getHeight()));
+    if (features & FEATURE_BLOOM)
+    {
+        setTexture(material, "u_bloomTexture", graph->getTexture(postProcessor->_bloomTarget));
+        material->getParameter("u_bloomIntensity")->setValue(postProcessor->_bloomIntensity);
+    }
+    if (features & FEATURE_TONE_MAPPING)
+        material->getParameter("u_exposure")->setValue(postProcessor->_exposure);
+    if (features & FEATURE_COLOR_GRADING)
+        setTexture(material, "u_colorGradingTexture", postProcessor->_colorGrading);
+    postProcessor->_quad->draw(material);
+}
+
+void PostProcessor::begin()
+{
+    GP_ASSERT(!_rendering);
+
+    // The overdraw view only counts the fragments drawn to the frame buffer the frame ends in.
+    if (!_enabled || getFeatures() == 0 || Game::getInstance()->getDebugRenderer()->isOverdrawEnabled())
+        return;
+
+    if (_quad == NULL)
+    {
+        Mesh* mesh = Mesh::createQuadFullscreen();
+        if (mesh == NULL)
+            return;
+        _quad = Model::create(mesh);
+        SAFE_RELEASE(mesh);
+    }
+
+    Game* game = Game::getInstance();
+    _previousViewport = game->getViewport();
+    unsigned int width = std::max((unsigned int)(_previousViewport.width + 0.5f), 1u);
+    unsigned int height = std::max((unsigned int)(_previousViewport.height + 0.5f), 1u);
+    _frameBuffer = game->getRenderTargetPool()->acquire(width, height, Texture::RGBA, true);
+    if (_frameBuffer == NULL)
+    {
+        GP_ERROR("Failed to create the post-processing frame buffer.");
+        return;
+    }
+    _rendering = true;
+
+    _previousFrameBuffer = _frameBuffer->bind();
+    game->setViewport(Rectangle((float)width, (float)height));
+}
+
+void PostProcessor::end()
+{
+    if (!_rendering)
+        return;
+    _rendering = false;
+
+    // Only the colors of the scene are read from here on.
+    if (FrameBuffer::getCurrent() == _frameBuffer)
+        _frameBuffer->discard(false, true);
+
+    _features = getFeatures();
+    if ((_features & FEATURE_BLOOM) && !createBloomMaterials())
+        _features &= ~FEATURE_BLOOM;
+
+    // The fused pass draws to the viewport of the frame buffer bound before begin(), over whatever is around it.
+    Game* game = Game::getInstance();
+    _previousFrameBuffer->bind();
+    game->setViewport(_previousViewport);
+
+    _graph.reset();
+    _sceneTarget = _graph.importTarget(_frameBuffer);
+    unsigned int output = _graph.importTarget(_previousFrameBuffer);
+    _previousFrameBuffer = NULL;
+    if (_features & FEATURE_BLOOM)
+    {
+        Texture* scene = _frameBuffer->getRenderTarget()->getTexture();
+        unsigned int width = std::max(scene->getWidth() / POSTPROCESS_BLOOM_DIVISOR, 1u);
+        unsigned int height = std::max(scene->getHeight() / POSTPROCESS_BLOOM_DIVISOR, 1u);
+        _bloomTarget = _graph.createTarget(width, height);
+        _scratchTarget = _graph.createTarget(width, height);
+
+        unsigned int pass = _graph.addPass("PostProcessor::brightPass", drawBrightPass, this, _bloomTarget);
+        _graph.addInput(pass, _sceneTarget);
+        pass = _graph.addPass("PostProcessor::horizontalBlur", drawHorizontalBlur, this, _scratchTarget);
+        _graph.addInput(pass, _bloomTarget);
+        pass = _graph.addPass("PostProcessor::verticalBlur", drawVerticalBlur, this, _bloomTarget);
+        _graph.addInput(pass, _scratchTarget);
+    }
+    unsigned int pass = _graph.addPass("PostProcessor::fusedPass", drawFusedPass, this, output, true);
+    _graph.addInput(pass, _sceneTarget);
+    if (_features & FEATURE_BLOOM)
+        _graph.addInput(pass, _bloomTarget);
+    _graph.execute();
+
+    // The targets go back to the pool for the passes that follow.
+    _graph.reset();
+    SAFE_RELEASE(_frameBuffer);
+}
+
+}
@@ -0,0 +1,295 @@
+#ifndef POSTPROCESSOR_H_
+#define POSTPROCESSOR_H_
+
+#include "Properties.h"
+#include "Rectangle.h"
+#include "Texture.h"
+#include "FrameGraph.h"
+
+namespace gameplay
+{
+
+class Material;
+class Model;
+
+/**
+ * Defines the engine's post-processing stack: bloom, tone mapping, FXAA and color grading.
+ *
+ * The game renders its scene between begin() and end(). begin() redirects the drawing to
+ * a frame buffer of the viewport size taken from the render target pool; end() applies the
+ * enabled effects and draws the result to the frame buffer and viewport that were bound
+ * before. Everything drawn after end(), such as forms and text, is not post-processed.
+ * When post-processing is disabled, or no effect is enabled, begin() and end() do nothing.
+ *
+ * Effects that work per pixel are fused into a single full resolution pass: the scene is
+ * read once per tap, the bloom is added, the color is tone mapped, FXAA filters the tone
+ * mapped colors and the result is color graded before it is written. The shader of this
+ * pass is compiled with only the enabled effects, one variant per combination, so disabled
+ * effects cost nothing. Bloom needs a blur, which does not fuse; it runs at a quarter of
+ * the resolution in three passes (a bright pass that also downsamples, then a horizontal
+ * and a vertical blur). The passes run in a FrameGraph, so the blur targets go back to the
+ * render target pool as soon as the passes that read them are done, and the depth of the
+ * scene is discarded rather than stored once the scene is drawn.
+ *
+ * The scene is rendered to an RGBA target with 8 bits per channel, so tone mapping only
+ * compresses the range the scene can store, scaled by the exposure.
+ *
+ * Color grading uses a 256x16 lookup table of 16 slices of 16x16 texels: blue selects the
+ * slice, and red and green increase along the s and t texture coordinates of each slice.
+ *
+ * Post-processing is configured in the game config:
+ *
+ * @verbatim
+    postProcess
+    {
+        enabled = true
+        bloom = true
+        bloomThreshold = 0.8        // Brightness above which colors bloom (default 0.8).
+        bloomIntensity = 1.0        // Scale of the bloom added to the scene (default 1.0).
+        toneMapping = true
+        exposure = 1.0              // Scale of the scene colors before tone mapping (default 1.0).
+        fxaa = true
+        colorGrading = res/lut.png  // Lookup table to grade the colors with (default none).
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class PostProcessor
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Determines if post-processing is enabled.
+     *
+     * @return True if the scene is post-processed.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Enables or disables post-processing.
+     *
+     * @param enabled True to post-process the scene.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Determines if bloom is enabled.
+     *
+     * @return True if bright parts of the scene bloom.
+     */
+    bool isBloomEnabled() const;
+
+    /**
+     * Enables or disables bloom.
+     *
+     * @param enabled True to make bright parts of the scene bloom.
+     */
+    void setBloomEnabled(bool enabled);
+
+    /**
+     * Gets the brightness above which colors bloom.
+     *
+     * @return The bloom threshold.
+     */
+    float getBloomThreshold() const;
+
+    /**
+     * Sets the brightness above which colors bloom.
+     *
+     * @param threshold The bloom threshold, from 0 to 1.
+     */
+    void setBloomThreshold(float threshold);
+
+    /**
+     * Gets the scale of the bloom added to the scene.
+     *
+     * @return The bloom intensity.
+     */
+    float getBloomIntensity() const;
+
+    /**
+     * Sets the scale of the bloom added to the scene.
+     *
+     * @param intensity The bloom intensity.
+     */
+    void setBloomIntensity(float intensity);
+
+    /**
+     * Determines if tone mapping is enabled.
+     *
+     * @return True if the scene colors are tone mapped.
+     */
+    bool isToneMappingEnabled() const;
+
+    /**
+     * Enables or disables tone mapping.
+     *
+     * @param enabled True to tone map the scene colors.
+     */
+    void setToneMappingEnabled(bool enabled);
+
+    /**
+     * Gets the scale of the scene colors before tone mapping.
+     *
+     * @return The exposure.
+     */
+    float getExposure() const;
+
+    /**
+     * Sets the scale of the scene colors before tone mapping.
+     *
+     * @param exposure The exposure.
+     */
+    void setExposure(float exposure);
+
+    /**
+     * Determines if FXAA is enabled.
+     *
+     * @return True if the edges of the scene are antialiased.
+     */
+    bool isFxaaEnabled() const;
+
+    /**
+     * Enables or disables FXAA.
+     *
+     * @param enabled True to antialias the edges of the scene.
+     */
+    void setFxaaEnabled(bool enabled);
+
+    /**
+     * Gets the lookup table the colors are graded with.
+     *
+     * @return The lookup table, or NULL if color grading is disabled.
+     */
+    Texture* getColorGradingTexture() const;
+
+    /**
+     * Sets the lookup table to grade the colors with.
+     *
+     * @param texture A 256x16 lookup table, or NULL to disable color grading.
+     */
+    void setColorGradingTexture(Texture* texture);
+
+    /**
+     * Starts rendering the scene to be post-processed.
+     *
+     * Binds a frame buffer of the size of the current viewport and sets the viewport to cover it.
+     */
+    void begin();
+
+    /**
+     * Post-processes the scene rendered since begin() and draws it to the
+     * frame buffer and viewport that were bound when begin() was called.
+     */
+    void end();
+
+private:
+
+    /**
+     * The effects, as the bits of a variant of the fused pass.
+     */
+    enum Feature
+    {
+        FEATURE_BLOOM = 0x01,
+        FEATURE_TONE_MAPPING = 0x02,
+        FEATURE_FXAA = 0x04,
+        FEATURE_COLOR_GRADING = 0x08,
+        FEATURE_COMBINATIONS = 0x10
+    };
+
+    /**
+     * Constructor.
+     */
+    PostProcessor();
+
+    /**
+     * Destructor.
+     */
+    ~PostProcessor();
+
+    /**
+     * Hidden copy constructor.
+     */
+    PostProcessor(const PostProcessor& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    PostProcessor& operator=(const PostProcessor&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'postProcess' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    void finalize();
+
+    /**
+     * Gets the features of the enabled effects.
+     */
+    unsigned int getFeatures() const;
+
+    /**
+     * Gets the material of the fused pass for a combination of features, creating it on first use.
+     */
+    Material* getFusedMaterial(unsigned int features);
+
+    /**
+     * Creates the materials of the bloom passes on first use, returning false on failure.
+     */
+    bool createBloomMaterials();
+
+    /**
+     * Draws the bright pass of the bloom, from the scene to the bloom target.
+     */
+    static void drawBrightPass(FrameGraph* graph, void* cookie);
+
+    /**
+     * Draws the horizontal blur of the bloom, from the bloom target to the scratch target.
+     */
+    static void drawHorizontalBlur(FrameGraph* graph, void* cookie);
+
+    /**
+     * Draws the vertical blur of the bloom, from the scratch target back to the bloom target.
+     */
+    static void drawVerticalBlur(FrameGraph* graph, void* cookie);
+
+    /**
+     * Draws the fused pass, from the scene and bloom to the frame buffer bound before begin().
+     */
+    static void drawFusedPass(FrameGraph* graph, void* cookie);
+
+    bool _enabled;
+    bool _rendering;
+    bool _bloom;
+    float _bloomThreshold;
+    float _bloomIntensity;
+    bool _toneMapping;
+    float _exposure;
+    bool _fxaa;
+    Texture* _colorGrading;
+    Model* _quad;
+    Material* _brightPass;
+    Material* _blur[2];
+    Material* _fused[FEATURE_COMBINATIONS];
+    FrameBuffer* _frameBuffer;
+    FrameBuffer* _previousFrameBuffer;
+    Rectangle _previousViewport;
+    FrameGraph _graph;
+    unsigned int _features;
+    unsigned int _sceneTarget;
+    unsigned int _bloomTarget;
+    unsigned int _scratchTarget;
+};
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "Base.h"
+#include "Prefab.h"
+#include "Bundle.h"
+
+namespace gameplay
+{
+
+Prefab::Prefab(Node* node)
+    : _node(node)
+{
+    GP_ASSERT(_node);
+    _node->addRef();
+}
+
+Prefab::~Prefab()
+{
+    SAFE_RELEASE(_node);
+}
+
+Prefab* Prefab::create(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->getScene())
+    {
+        GP_WARN("Prefab template node '%s' is part of a scene.", node->getId());
+    }
+    return new Prefab(node);
+}
+
+Prefab* Prefab::create(const char* url)
+{
+    GP_ASSERT(url);
+
+    // Parse URL (formatted as 'bundle#id').
+    std::string urlstring(url);
+    size_t pos = urlstring.find('#');
+    if (pos == std::string::npos)
+    {
+        GP_ERROR("Invalid prefab URL '%s' (must be of the form 'bundle#id').", url);
+        return NULL;
+    }
+    std::string file = urlstring.substr(0, pos);
+    std::string id = urlstring.substr(pos + 1);
+
+    Bundle* bundle = Bundle::create(file.c_str());
+    if (bundle == NULL)
+    {
+        GP_ERROR("Failed to load bundle '%s'.", file.c_str());
+        return NULL;
+    }
+    Node* node = bundle->loadNode(id.c_str());
+    SAFE_RELEASE(bundle);
+    if (node == NULL)
+    {
+        GP_ERROR("Failed to load prefab node '%s' from bundle '%s'.", id.c_str(), file.c_str());
+        return NULL;
+    }
+
+    Prefab* prefab = new Prefab(node);
+    SAFE_RELEASE(node);
+    return prefab;
+}
+
+Node* Prefab::getNode() const
+{
+    return _node;
+}
+
+Node* Prefab::instantiate(const char* id) const
+{
+    NodeCloneContext context;
+    context.setShareMaterials(true);
+
+    Node* node = _node->cloneRecursive(context);
+    GP_ASSERT(node);
+    if (id)
+    {
+        node->setId(id);
+    }
+    return node;
+}
+
+}
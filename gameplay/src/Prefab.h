@@ -0,0 +1,102 @@
+#ifndef PREFAB_H_
+#define PREFAB_H_
+
+#include "Node.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a template node hierarchy that is instantiated many times, such as an enemy
+ * or a pickup that is spawned during gameplay.
+ *
+ * Node::clone copies everything a node references, including the materials of its
+ * models, so spawning a character clones its techniques, passes, state blocks and
+ * parameters each time. A prefab instead shares the immutable data of the template
+ * between its instances:
+ *
+ * - meshes, levels of detail and collision hierarchies are referenced,
+ * - materials are referenced, as if they were marked shared (see Material::setShared),
+ * - animation curves are referenced by the cloned animation channels.
+ *
+ * Only the per-instance state is created: the nodes and joints, the models and mesh
+ * skins, and the animation channels and clips that target the new nodes. These objects
+ * are allocated from the pools of the Allocator, so spawning and destroying instances
+ * during gameplay reuses their memory.
+ *
+ * Since the instances use the materials of the template, material parameters that
+ * differ between instances must be set with Model::getInstanceParameter. Collision
+ * objects are not part of an instance, as with Node::clone; collision shapes set on
+ * the instances are shared by the physics controller.
+ *
+ * The template node is owned by the prefab and must not be added to a scene.
+ */
+class Prefab : public Ref
+{
+public:
+
+    /**
+     * Creates a prefab from a template node hierarchy.
+     *
+     * @param node The template node. The prefab keeps a reference to it.
+     *
+     * @return The new prefab.
+     * @script{create}
+     */
+    static Prefab* create(Node* node);
+
+    /**
+     * Creates a prefab from a node of a bundle.
+     *
+     * @param url The URL of the node, of the form 'bundle#id'.
+     *
+     * @return The new prefab, or NULL if the node could not be loaded.
+     * @script{create}
+     */
+    static Prefab* create(const char* url);
+
+    /**
+     * Gets the template node of the prefab.
+     *
+     * @return The template node.
+     */
+    Node* getNode() const;
+
+    /**
+     * Creates a new instance of the prefab.
+     *
+     * @param id The ID of the root node of the instance, or NULL to use the ID of the template node.
+     *
+     * @return The root node of the new instance.
+     * @script{create}
+     */
+    Node* instantiate(const char* id = NULL) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    Prefab(Node* node);
+
+    /**
+     * Destructor.
+     */
+    ~Prefab();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Prefab(const Prefab& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Prefab& operator=(const Prefab&);
+
+    Node* _node;
+};
+
+}
+
+#endif
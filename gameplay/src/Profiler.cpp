@@ -0,0 +1,640 @@
+#include "Base.h"
+#include "Profiler.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "Font.h"
+#include "SpriteBatch.h"
+#include "Texture.h"
+#include "Thread.h"
+#include "RenderCommandList.h"
+
+// Number of frames a GPU query set may stay in flight before its results are dropped.
+#define PROFILER_GPU_LATENCY 4
+
+// Number of timestamp queries generated at once when a frame runs out of queries.
+#define PROFILER_QUERY_BLOCK 32
+
+// Number of passes and effects listed in the overlay.
+#define PROFILER_OVERLAY_DRAW_TOTALS 8
+
+// Overlay layout in pixels.
+#define PROFILER_BAR_WIDTH 2
+#define PROFILER_GRAPH_HEIGHT 100
+#define PROFILER_GRAPH_SCALE 2.0f
+
+namespace gameplay
+{
+
+static Profiler* __profiler = NULL;
+
+Profiler::Scope::Scope(const char* name)
+    : _active(__profiler && __profiler->begin(name))
+{
+}
+
+Profiler::Scope::~Scope()
+{
+    if (_active)
+        __profiler->end();
+}
+
+Profiler::GpuScope::GpuScope(const char* name)
+    : _active(__profiler && __profiler->beginGpu(name))
+{
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+    if (_active)
+        __profiler->endGpu();
+}
+
+Profiler::GpuDrawScope::GpuDrawScope(const char* pass, const char* effect)
+    : _active(__profiler && __profiler->beginGpuDraw(pass, effect))
+{
+}
+
+Profiler::GpuDrawScope::~GpuDrawScope()
+{
+    if (_active)
+        __profiler->endGpuDraw();
+}
+
+Profiler::Profiler()
+    : _enabled(false), _recording(false), _gpuEnabled(false), _gpuDraws(false), _frameIndex(0), _frameCount(0), _gpuFrame(NULL), _overlayBatch(NULL)
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+void Profiler::initialize(Properties* properties)
+{
+    int frames = 120;
+    bool gpu = true;
+    bool gpuDraws = false;
+    if (properties)
+    {
+        _enabled = properties->getBool("enabled");
+        if (properties->exists("frames"))
+            frames = properties->getInt("frames");
+        if (properties->exists("gpu"))
+            gpu = properties->getBool("gpu");
+        gpuDraws = properties->getBool("gpuDraws");
+    }
+    _frames.resize(std::max(frames, 1));
+
+#ifdef USE_TIMER_QUERIES
+    // Timer queries belong to the context that issues them, so GPU scopes are off while a render thread replays the frames.
+    _gpuEnabled = gpu && glGenQueries && glDeleteQueries && glQueryCounter && glGetQueryObjectiv && glGetQueryObjectui64v &&
+        !RenderCommandList::isRecording();
+#endif
+    _gpuDraws = _gpuEnabled && gpuDraws;
+    if (_gpuEnabled)
+    {
+        _gpuFrames.resize(PROFILER_GPU_LATENCY);
+        for (size_t i = 0; i < _gpuFrames.size(); ++i)
+        {
+            _gpuFrames[i].frameIndex = 0;
+            _gpuFrames[i].pending = false;
+            _gpuFrames[i].queryCount = 0;
+        }
+    }
+    else if (gpu && _enabled)
+    {
+        GP_WARN("GPU timer queries are not supported; only CPU scopes will be profiled.");
+    }
+
+    __profiler = this;
+}
+
+void Profiler::finalize()
+{
+    __profiler = NULL;
+    _recording = false;
+
+#ifdef USE_TIMER_QUERIES
+    for (size_t i = 0; i < _gpuFrames.size(); ++i)
+    {
+        std::vector<GLuint>& queries = _gpuFrames[i].queries;
+        if (!queries.empty())
+        {
+            GL_ASSERT( glDeleteQueries((GLsizei)queries.size(), &queries[0]) );
+        }
+    }
+#endif
+    _gpuFrames.clear();
+    _gpuFrame = NULL;
+
+    SAFE_DELETE(_overlayBatch);
+}
+
+bool Profiler::isEnabled() const
+{
+    return _enabled;
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+}
+
+bool Profiler::isGpuProfilingEnabled() const
+{
+    return _gpuEnabled;
+}
+
+unsigned int Profiler::getFrameCount() const
+{
+    return _frameCount;
+}
+
+const Profiler::Frame* Profiler::getFrame(unsigned int age) const
+{
+    if (age >= _frameCount)
+        return NULL;
+    return &_frames[(_frameIndex - 1 - age) % _frames.size()];
+}
+
+Profiler::Frame* Profiler::findFrame(unsigned int index)
+{
+    if (index >= _frameIndex || _frameIndex - index > _frameCount)
+        return NULL;
+    return &_frames[index % _frames.size()];
+}
+
+void Profiler::beginFrame()
+{
+    _recording = _enabled;
+    if (!_recording)
+        return;
+
+    _current.index = _frameIndex;
+    _current.start = Game::getAbsoluteTime();
+    _current.duration = 0.0;
+    _current.cpuSamples.clear();
+    _current.gpuSamples.clear();
+    _current.gpuPasses.clear();
+    _current.gpuEffects.clear();
+    _current.counters.clear();
+    _stack.clear();
+
+    if (_gpuEnabled)
+    {
+        // Reuse the oldest query set; if its results are still not available they are dropped.
+        GpuFrame& gpuFrame = _gpuFrames[_frameIndex % _gpuFrames.size()];
+        if (gpuFrame.pending)
+        {
+            readGpuFrame(gpuFrame);
+            gpuFrame.pending = false;
+        }
+        gpuFrame.frameIndex = _frameIndex;
+        gpuFrame.queryCount = 0;
+        gpuFrame.scopes.clear();
+        gpuFrame.draws.clear();
+        _gpuStack.clear();
+
+        // The first timestamp is the reference the scopes of the frame are measured from.
+        issueTimestamp(gpuFrame);
+        _gpuFrame = &gpuFrame;
+    }
+}
+
+void Profiler::endFrame()
+{
+    if (!_recording)
+        return;
+    _recording = false;
+
+    GP_ASSERT(_stack.empty());
+    GP_ASSERT(_gpuStack.empty());
+
+    _current.duration = Game::getAbsoluteTime() - _current.start;
+
+    // Swap the samples into the ring so that the slot's vectors are reused by the next frame.
+    Frame& slot = _frames[_frameIndex % _frames.size()];
+    slot.index = _current.index;
+    slot.start = _current.start;
+    slot.duration = _current.duration;
+    slot.cpuSamples.swap(_current.cpuSamples);
+    slot.gpuSamples.swap(_current.gpuSamples);
+    slot.gpuPasses.swap(_current.gpuPasses);
+    slot.gpuEffects.swap(_current.gpuEffects);
+    slot.counters.swap(_current.counters);
+    ++_frameIndex;
+    if (_frameCount < _frames.size())
+        ++_frameCount;
+
+    if (_gpuFrame)
+    {
+        _gpuFrame->pending = true;
+        _gpuFrame = NULL;
+    }
+    for (size_t i = 0; i < _gpuFrames.size(); ++i)
+    {
+        if (_gpuFrames[i].pending)
+            readGpuFrame(_gpuFrames[i]);
+    }
+}
+
+bool Profiler::begin(const char* name)
+{
+    if (!_recording || !Thread::isMainThread())
+        return false;
+
+    Sample sample;
+    sample.name = name;
+    sample.depth = (unsigned int)_stack.size();
+    sample.start = Game::getAbsoluteTime() - _current.start;
+    sample.duration = 0.0;
+    _stack.push_back((unsigned int)_current.cpuSamples.size());
+    _current.cpuSamples.push_back(sample);
+    return true;
+}
+
+void Profiler::end()
+{
+    GP_ASSERT(!_stack.empty());
+
+    Sample& sample = _current.cpuSamples[_stack.back()];
+    sample.duration = Game::getAbsoluteTime() - _current.start - sample.start;
+    _stack.pop_back();
+}
+
+void Profiler::setCounter(const char* name, double value)
+{
+    if (!_recording || !Thread::isMainThread())
+        return;
+
+    for (size_t i = 0, count = _current.counters.size(); i < count; ++i)
+    {
+        if (_current.counters[i].name == name || strcmp(_current.counters[i].name, name) == 0)
+        {
+            _current.counters[i].value = value;
+            return;
+        }
+    }
+    Counter counter;
+    counter.name = name;
+    counter.value = value;
+    _current.counters.push_back(counter);
+}
+
+void Profiler::counter(const char* name, double value)
+{
+    if (__profiler)
+        __profiler->setCounter(name, value);
+}
+
+bool Profiler::beginGpu(const char* name)
+{
+    if (!_recording || !_gpuFrame || !Thread::isMainThread())
+        return false;
+
+    GpuQuery query;
+    query.name = name;
+    query.depth = (unsigned int)_gpuStack.size();
+    query.begin = issueTimestamp(*_gpuFrame);
+    query.end = query.begin;
+    _gpuStack.push_back((unsigned int)_gpuFrame->scopes.size());
+    _gpuFrame->scopes.push_back(query);
+    return true;
+}
+
+void Profiler::endGpu()
+{
+    GP_ASSERT(_gpuFrame && !_gpuStack.empty());
+
+    _gpuFrame->scopes[_gpuStack.back()].end = issueTimestamp(*_gpuFrame);
+    _gpuStack.pop_back();
+}
+
+bool Profiler::beginGpuDraw(const char* pass, const char* effect)
+{
+    if (!_gpuDraws || !_recording || !_gpuFrame || !Thread::isMainThread())
+        return false;
+
+    GpuDraw draw;
+    draw.pass = findLabel(pass);
+    draw.effect = findLabel(effect);
+    draw.begin = issueTimestamp(*_gpuFrame);
+    draw.end = draw.begin;
+    _gpuFrame->draws.push_back(draw);
+    return true;
+}
+
+void Profiler::endGpuDraw()
+{
+    GP_ASSERT(_gpuFrame && !_gpuFrame->draws.empty());
+
+    _gpuFrame->draws.back().end = issueTimestamp(*_gpuFrame);
+}
+
+unsigned int Profiler::findLabel(const char* label)
+{
+    // Labels are kept for the life of the profiler, so frames can refer to them after their pass is gone.
+    std::string key = label && label[0] != '\0' ? label : "(unnamed)";
+    std::map<std::string, unsigned int>::iterator itr = _labelIndices.find(key);
+    if (itr != _labelIndices.end())
+        return itr->second;
+
+    unsigned int index = (unsigned int)_labels.size();
+    itr = _labelIndices.insert(std::make_pair(key, index)).first;
+    _labels.push_back(itr->first.c_str());
+    return index;
+}
+
+static bool compareDrawTotals(const Profiler::GpuDrawTotal& a, const Profiler::GpuDrawTotal& b)
+{
+    return a.duration > b.duration;
+}
+
+static void addDrawTotal(std::vector<Profiler::GpuDrawTotal>& totals, std::vector<unsigned int>& indices, const char* name, unsigned int label, double duration)
+{
+    if (indices[label] == (unsigned int)-1)
+    {
+        indices[label] = (unsigned int)totals.size();
+        Profiler::GpuDrawTotal total;
+        total.name = name;
+        total.draws = 0;
+        total.duration = 0.0;
+        totals.push_back(total);
+    }
+    Profiler::GpuDrawTotal& total = totals[indices[label]];
+    ++total.draws;
+    total.duration += duration;
+}
+
+void Profiler::sumGpuDraws(const GpuFrame& gpuFrame, Frame* frame)
+{
+    frame->gpuPasses.clear();
+    frame->gpuEffects.clear();
+    if (gpuFrame.draws.empty())
+        return;
+
+#ifdef USE_TIMER_QUERIES
+    std::vector<unsigned int> passIndices(_labels.size(), (unsigned int)-1);
+    std::vector<unsigned int> effectIndices(_labels.size(), (unsigned int)-1);
+    for (size_t i = 0, count = gpuFrame.draws.size(); i < count; ++i)
+    {
+        const GpuDraw& draw = gpuFrame.draws[i];
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        GL_ASSERT( glGetQueryObjectui64v(gpuFrame.queries[draw.begin], GL_QUERY_RESULT, &begin) );
+        GL_ASSERT( glGetQueryObjectui64v(gpuFrame.queries[draw.end], GL_QUERY_RESULT, &end) );
+        double duration = (double)(end - begin) * 1.0e-6;
+        addDrawTotal(frame->gpuPasses, passIndices, _labels[draw.pass], draw.pass, duration);
+        addDrawTotal(frame->gpuEffects, effectIndices, _labels[draw.effect], draw.effect, duration);
+    }
+    std::sort(frame->gpuPasses.begin(), frame->gpuPasses.end(), compareDrawTotals);
+    std::sort(frame->gpuEffects.begin(), frame->gpuEffects.end(), compareDrawTotals);
+#endif
+}
+
+unsigned int Profiler::issueTimestamp(GpuFrame& gpuFrame)
+{
+#ifdef USE_TIMER_QUERIES
+    if (gpuFrame.queryCount == gpuFrame.queries.size())
+    {
+        size_t first = gpuFrame.queries.size();
+        gpuFrame.queries.resize(first + PROFILER_QUERY_BLOCK);
+        GL_ASSERT( glGenQueries(PROFILER_QUERY_BLOCK, &gpuFrame.queries[first]) );
+    }
+    GL_ASSERT( glQueryCounter(gpuFrame.queries[gpuFrame.queryCount], GL_TIMESTAMP) );
+#endif
+    return gpuFrame.queryCount++;
+}
+
+void Profiler::readGpuFrame(GpuFrame& gpuFrame)
+{
+#ifdef USE_TIMER_QUERIES
+    // Queries complete in order, so the last one tells whether the whole frame is available.
+    GLint available = 0;
+    GL_ASSERT( glGetQueryObjectiv(gpuFrame.queries[gpuFrame.queryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available) );
+    if (!available)
+        return;
+    gpuFrame.pending = false;
+
+#ifdef GL_GPU_DISJOINT
+    // A disjoint operation (e.g. a frequency change) invalidates the timestamps.
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT, &disjoint);
+    if (disjoint)
+        return;
+#endif
+
+    Frame* frame = findFrame(gpuFrame.frameIndex);
+    if (frame == NULL)
+        return;
+
+    GLuint64 reference = 0;
+    GL_ASSERT( glGetQueryObjectui64v(gpuFrame.queries[0], GL_QUERY_RESULT, &reference) );
+
+    frame->gpuSamples.clear();
+    for (size_t i = 0, count = gpuFrame.scopes.size(); i < count; ++i)
+    {
+        const GpuQuery& query = gpuFrame.scopes[i];
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        GL_ASSERT( glGetQueryObjectui64v(gpuFrame.queries[query.begin], GL_QUERY_RESULT, &begin) );
+        GL_ASSERT( glGetQueryObjectui64v(gpuFrame.queries[query.end], GL_QUERY_RESULT, &end) );
+
+        Sample sample;
+        sample.name = query.name;
+        sample.depth = query.depth;
+        sample.start = (double)(begin - reference) * 1.0e-6;
+        sample.duration = (double)(end - begin) * 1.0e-6;
+        frame->gpuSamples.push_back(sample);
+    }
+    sumGpuDraws(gpuFrame, frame);
+#else
+    gpuFrame.pending = false;
+#endif
+}
+
+static void drawSamples(Font* font, const char* title, const std::vector<Profiler::Sample>& samples, int x, int& y, unsigned int size)
+{
+    static const Vector4 titleColor(1.0f, 1.0f, 1.0f, 1.0f);
+    static const Vector4 sampleColor(0.8f, 0.8f, 0.8f, 1.0f);
+
+    font->drawText(title, x, y, titleColor, size);
+    y += size;
+
+    char text[128];
+    for (size_t i = 0, count = samples.size(); i < count; ++i)
+    {
+        const Profiler::Sample& sample = samples[i];
+        sprintf(text, "%*s%.64s %.2f ms", (int)(sample.depth + 1) * 2, "", sample.name, sample.duration);
+        font->drawText(text, x, y, sampleColor, size);
+        y += size;
+    }
+}
+
+static void drawDrawTotals(Font* font, const char* title, const std::vector<Profiler::GpuDrawTotal>& totals, int x, int& y, unsigned int size)
+{
+    static const Vector4 titleColor(1.0f, 1.0f, 1.0f, 1.0f);
+    static const Vector4 totalColor(0.8f, 0.8f, 0.8f, 1.0f);
+
+    if (totals.empty())
+        return;
+
+    font->drawText(title, x, y, titleColor, size);
+    y += size;
+
+    // The labels end with the most telling part (the pass or the shader), so long ones keep their tail.
+    char text[128];
+    for (size_t i = 0, count = std::min(totals.size(), (size_t)PROFILER_OVERLAY_DRAW_TOTALS); i < count; ++i)
+    {
+        const Profiler::GpuDrawTotal& total = totals[i];
+        size_t length = strlen(total.name);
+        const char* name = length > 64 ? total.name + length - 64 : total.name;
+        sprintf(text, "  %.64s %.2f ms (%u)", name, total.duration, total.draws);
+        font->drawText(text, x, y, totalColor, size);
+        y += size;
+    }
+}
+
+void Profiler::drawOverlay(Font* font, int x, int y)
+{
+    GP_ASSERT(font);
+
+    if (_frameCount == 0)
+        return;
+
+    if (_overlayBatch == NULL)
+    {
+        unsigned char white[4] = { 255, 255, 255, 255 };
+        Texture* texture = Texture::create(Texture::RGBA, 1, 1, white);
+        _overlayBatch = SpriteBatch::create(texture);
+        SAFE_RELEASE(texture);
+    }
+
+    // Frame time history, oldest frame on the left.
+    static const Vector4 backgroundColor(0.0f, 0.0f, 0.0f, 0.5f);
+    static const Vector4 fastColor(0.2f, 0.8f, 0.2f, 1.0f);
+    static const Vector4 slowColor(0.9f, 0.8f, 0.1f, 1.0f);
+    static const Vector4 stallColor(0.9f, 0.2f, 0.1f, 1.0f);
+
+    double total = 0.0;
+    double max = 0.0;
+    _overlayBatch->start();
+    _overlayBatch->draw((float)x, (float)y, (float)(_frames.size() * PROFILER_BAR_WIDTH), (float)PROFILER_GRAPH_HEIGHT, 0, 0, 1, 1, backgroundColor);
+    for (unsigned int i = 0; i < _frameCount; ++i)
+    {
+        const Frame* frame = getFrame(_frameCount - 1 - i);
+        total += frame->duration;
+        max = std::max(max, frame->duration);
+
+        float height = std::min((float)frame->duration * PROFILER_GRAPH_SCALE, (float)PROFILER_GRAPH_HEIGHT);
+        const Vector4& color = frame->duration < 16.7 ? fastColor : (frame->duration < 33.4 ? slowColor : stallColor);
+        _overlayBatch->draw((float)(x + i * PROFILER_BAR_WIDTH), (float)(y + PROFILER_GRAPH_HEIGHT) - height, (float)PROFILER_BAR_WIDTH, height, 0, 0, 1, 1, color);
+    }
+    _overlayBatch->finish();
+
+    // Scopes of the last completed frame. GPU samples come from an older frame, since they arrive with latency.
+    unsigned int size = font->getSize();
+    int textY = y + PROFILER_GRAPH_HEIGHT + (int)size / 2;
+    const Frame* last = getFrame(0);
+
+    char text[128];
+    sprintf(text, "Frame %.2f ms (avg %.2f, max %.2f)", last->duration, total / _frameCount, max);
+
+    font->start();
+    font->drawText(text, x, textY, Vector4::one(), size);
+    textY += size;
+    drawSamples(font, "CPU", last->cpuSamples, x, textY, size);
+    for (size_t i = 0, count = last->counters.size(); i < count; ++i)
+    {
+        sprintf(text, "%.64s %.2f", last->counters[i].name, last->counters[i].value);
+        font->drawText(text, x, textY, Vector4::one(), size);
+        textY += size;
+    }
+    if (_gpuEnabled)
+    {
+        for (unsigned int age = 0; age < _frameCount; ++age)
+        {
+            const Frame* frame = getFrame(age);
+            if (!frame->gpuSamples.empty())
+            {
+                drawSamples(font, "GPU", frame->gpuSamples, x, textY, size);
+                drawDrawTotals(font, "GPU by pass", frame->gpuPasses, x, textY, size);
+                drawDrawTotals(font, "GPU by effect", frame->gpuEffects, x, textY, size);
+                break;
+            }
+        }
+    }
+    font->finish();
+}
+
+static void writeTraceName(FILE* file, const char* name)
+{
+    fputc('"', file);
+    for (const char* c = name; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*c >= 0x20)
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static void writeTraceEvents(FILE* file, const Profiler::Frame& frame, const std::vector<Profiler::Sample>& samples, const char* category, int tid, bool& first)
+{
+    for (size_t i = 0, count = samples.size(); i < count; ++i)
+    {
+        const Profiler::Sample& sample = samples[i];
+        fputs(first ? "\n{\"name\":" : ",\n{\"name\":", file);
+        writeTraceName(file, sample.name);
+        fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+            category, (frame.start + sample.start) * 1000.0, sample.duration * 1000.0, tid);
+        first = false;
+    }
+}
+
+bool Profiler::exportChromeTrace(const char* path) const
+{
+    GP_ASSERT(path);
+
+    FILE* file = FileSystem::openFile(path, "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create trace file '%s'.", path);
+        return false;
+    }
+
+    // Times are written in microseconds; GPU scopes are placed relative to the start of their frame.
+    bool first = true;
+    fputs("{\"traceEvents\":[", file);
+    for (unsigned int age = _frameCount; age-- > 0;)
+    {
+        const Frame* frame = getFrame(age);
+        fputs(first ? "\n{\"name\":\"Frame\"" : ",\n{\"name\":\"Frame\"", file);
+        fprintf(file, ",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"index\":%u}}",
+            frame->start * 1000.0, frame->duration * 1000.0, frame->index);
+        first = false;
+        writeTraceEvents(file, *frame, frame->cpuSamples, "cpu", 1, first);
+        writeTraceEvents(file, *frame, frame->gpuSamples, "gpu", 2, first);
+
+        // Counters are written at the end of their frame.
+        for (size_t i = 0, count = frame->counters.size(); i < count; ++i)
+        {
+            fputs(",\n{\"name\":", file);
+            writeTraceName(file, frame->counters[i].name);
+            fprintf(file, ",\"cat\":\"counter\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%g}}",
+                (frame->start + frame->duration) * 1000.0, frame->counters[i].value);
+        }
+    }
+    fputs("\n]}\n", file);
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write trace file '%s'.", path);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,477 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class Font;
+class SpriteBatch;
+class Texture;
+
+/**
+ * Defines a frame profiler that records hierarchical CPU scopes and GPU timer queries.
+ *
+ * Scopes are opened with the GP_PROFILE_SCOPE and GP_PROFILE_GPU_SCOPE macros
+ * and closed at the end of the enclosing block. Per-frame values, such as memory
+ * sizes, are recorded with the GP_PROFILE_COUNTER macro. CPU scopes are only recorded on
+ * the main thread. GPU scopes use timestamp queries (GL_ARB_timer_query or
+ * GL_EXT_disjoint_timer_query); their results are read back a few frames later
+ * and attached to the frame that issued them.
+ *
+ * The draws of models and mesh batches can also be timed one by one on the GPU; their
+ * times are summed by material pass and by effect, so that the overlay shows which
+ * passes and effects cost the most GPU time.
+ *
+ * The profiler keeps the samples of the last frames in a ring buffer. They can be
+ * drawn as an overlay with drawOverlay() or exported to the Chrome trace event
+ * format (chrome://tracing) with exportChromeTrace().
+ *
+ * The profiler is configured in the game config:
+ *
+ * @verbatim
+    profiler
+    {
+        enabled = true
+        frames = 120        // Number of frames kept in the ring buffer.
+        gpu = true          // Record GPU scopes when timer queries are supported.
+        gpuDraws = false    // Time every draw on the GPU, summed by pass and effect.
+    }
+   @endverbatim
+ *
+ * Defining GP_NO_PROFILER compiles all profiling scopes out.
+ *
+ * @script{ignore}
+ */
+class Profiler
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines a recorded scope.
+     */
+    struct Sample
+    {
+        /**
+         * The name of the scope.
+         */
+        const char* name;
+
+        /**
+         * The nesting depth of the scope, where 0 is a top-level scope.
+         */
+        unsigned int depth;
+
+        /**
+         * The start time of the scope in milliseconds, relative to the start of the frame.
+         */
+        double start;
+
+        /**
+         * The duration of the scope in milliseconds.
+         */
+        double duration;
+    };
+
+    /**
+     * Defines a value recorded once per frame, such as a memory size.
+     */
+    struct Counter
+    {
+        /**
+         * The name of the counter.
+         */
+        const char* name;
+
+        /**
+         * The value of the counter at the end of the frame.
+         */
+        double value;
+    };
+
+    /**
+     * Defines the GPU time of the draws made with one pass or effect during a frame.
+     */
+    struct GpuDrawTotal
+    {
+        /**
+         * The label of the pass or effect.
+         */
+        const char* name;
+
+        /**
+         * The number of draws.
+         */
+        unsigned int draws;
+
+        /**
+         * The GPU time of the draws in milliseconds.
+         */
+        double duration;
+    };
+
+    /**
+     * Defines the samples recorded during one frame.
+     */
+    struct Frame
+    {
+        /**
+         * The index of the frame, counted from the start of profiling.
+         */
+        unsigned int index;
+
+        /**
+         * The start time of the frame in milliseconds (absolute time).
+         */
+        double start;
+
+        /**
+         * The CPU duration of the frame in milliseconds.
+         */
+        double duration;
+
+        /**
+         * The CPU scopes, in the order they were opened.
+         */
+        std::vector<Sample> cpuSamples;
+
+        /**
+         * The GPU scopes, in the order they were opened. Empty until the timer queries are read back.
+         */
+        std::vector<Sample> gpuSamples;
+
+        /**
+         * The GPU time of the timed draws by pass, longest first. Empty until the timer queries are read back.
+         */
+        std::vector<GpuDrawTotal> gpuPasses;
+
+        /**
+         * The GPU time of the timed draws by effect, longest first. Empty until the timer queries are read back.
+         */
+        std::vector<GpuDrawTotal> gpuEffects;
+
+        /**
+         * The counters recorded during the frame, in the order they were first set.
+         */
+        std::vector<Counter> counters;
+    };
+
+    /**
+     * Records a CPU scope for the lifetime of the object. Use GP_PROFILE_SCOPE instead.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Constructor. Opens the scope.
+         *
+         * @param name The name of the scope, which must remain valid while the profiler runs.
+         */
+        Scope(const char* name);
+
+        /**
+         * Destructor. Closes the scope.
+         */
+        ~Scope();
+
+    private:
+
+        Scope(const Scope& copy);
+        Scope& operator=(const Scope&);
+
+        bool _active;
+    };
+
+    /**
+     * Records a GPU scope for the lifetime of the object. Use GP_PROFILE_GPU_SCOPE instead.
+     */
+    class GpuScope
+    {
+    public:
+
+        /**
+         * Constructor. Opens the scope.
+         *
+         * @param name The name of the scope, which must remain valid while the profiler runs.
+         */
+        GpuScope(const char* name);
+
+        /**
+         * Destructor. Closes the scope.
+         */
+        ~GpuScope();
+
+    private:
+
+        GpuScope(const GpuScope& copy);
+        GpuScope& operator=(const GpuScope&);
+
+        bool _active;
+    };
+
+    /**
+     * Times a draw on the GPU for the lifetime of the object, when draws are profiled.
+     */
+    class GpuDrawScope
+    {
+    public:
+
+        /**
+         * Constructor. Starts timing the draw.
+         *
+         * @param pass The label of the pass the draw is made with.
+         * @param effect The label of the effect the draw is made with.
+         */
+        GpuDrawScope(const char* pass, const char* effect);
+
+        /**
+         * Destructor. Stops timing the draw.
+         */
+        ~GpuDrawScope();
+
+    private:
+
+        GpuDrawScope(const GpuDrawScope& copy);
+        GpuDrawScope& operator=(const GpuDrawScope&);
+
+        bool _active;
+    };
+
+    /**
+     * Determines if the profiler records frames.
+     *
+     * @return True if the profiler is enabled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Enables or disables recording. Recording starts or stops at the next frame.
+     *
+     * @param enabled True to record frames.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Determines if GPU scopes are recorded.
+     *
+     * @return True if GPU timer queries are supported and enabled.
+     */
+    bool isGpuProfilingEnabled() const;
+
+    /**
+     * Gets the number of frames available in the ring buffer.
+     *
+     * @return The number of recorded frames.
+     */
+    unsigned int getFrameCount() const;
+
+    /**
+     * Gets a recorded frame.
+     *
+     * @param age The age of the frame, where 0 is the last completed frame.
+     *
+     * @return The frame, or NULL if age is not less than getFrameCount().
+     */
+    const Frame* getFrame(unsigned int age) const;
+
+    /**
+     * Opens a CPU scope. Prefer the GP_PROFILE_SCOPE macro.
+     *
+     * @param name The name of the scope.
+     *
+     * @return True if the scope is recorded and must be closed with end().
+     */
+    bool begin(const char* name);
+
+    /**
+     * Closes the last CPU scope opened with begin().
+     */
+    void end();
+
+    /**
+     * Sets the value of a counter for the current frame. Prefer the GP_PROFILE_COUNTER macro.
+     *
+     * @param name The name of the counter, which must remain valid while the profiler runs.
+     * @param value The value of the counter.
+     */
+    void setCounter(const char* name, double value);
+
+    /**
+     * Sets the value of a counter for the current frame, if a profiler is recording.
+     *
+     * @param name The name of the counter, which must remain valid while the profiler runs.
+     * @param value The value of the counter.
+     */
+    static void counter(const char* name, double value);
+
+    /**
+     * Opens a GPU scope. Prefer the GP_PROFILE_GPU_SCOPE macro.
+     *
+     * @param name The name of the scope.
+     *
+     * @return True if the scope is recorded and must be closed with endGpu().
+     */
+    bool beginGpu(const char* name);
+
+    /**
+     * Closes the last GPU scope opened with beginGpu().
+     */
+    void endGpu();
+
+    /**
+     * Starts timing a draw on the GPU. Prefer a GpuDrawScope. Draws do not nest.
+     *
+     * @param pass The label of the pass the draw is made with.
+     * @param effect The label of the effect the draw is made with.
+     *
+     * @return True if the draw is timed and must be closed with endGpuDraw().
+     */
+    bool beginGpuDraw(const char* pass, const char* effect);
+
+    /**
+     * Stops timing the draw started with beginGpuDraw().
+     */
+    void endGpuDraw();
+
+    /**
+     * Draws the frame time history and the scopes of the last completed frame.
+     *
+     * @param font The font used to draw the scope timings.
+     * @param x The x position of the overlay, in pixels.
+     * @param y The y position of the overlay, in pixels.
+     */
+    void drawOverlay(Font* font, int x = 10, int y = 10);
+
+    /**
+     * Writes the recorded frames to a file in the Chrome trace event format.
+     *
+     * @param path The path of the file to write.
+     *
+     * @return True if the file was written.
+     */
+    bool exportChromeTrace(const char* path) const;
+
+private:
+
+    struct GpuQuery
+    {
+        const char* name;
+        unsigned int depth;
+        unsigned int begin;     // Index of the begin timestamp query.
+        unsigned int end;       // Index of the end timestamp query.
+    };
+
+    struct GpuDraw
+    {
+        unsigned int pass;      // Index of the pass label.
+        unsigned int effect;    // Index of the effect label.
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    struct GpuFrame
+    {
+        unsigned int frameIndex;
+        bool pending;
+        std::vector<GLuint> queries;
+        unsigned int queryCount;
+        std::vector<GpuQuery> scopes;
+        std::vector<GpuDraw> draws;
+    };
+
+    /**
+     * Constructor.
+     */
+    Profiler();
+
+    /**
+     * Destructor.
+     */
+    ~Profiler();
+
+    /**
+     * Hidden copy constructor.
+     */
+    Profiler(const Profiler& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Profiler& operator=(const Profiler&);
+
+    /**
+     * Called during startup to read the profiler configuration.
+     *
+     * @param properties The 'profiler' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to delete the timer queries.
+     */
+    void finalize();
+
+    /**
+     * Called at the start of each frame.
+     */
+    void beginFrame();
+
+    /**
+     * Called at the end of each frame to store the frame in the ring buffer.
+     */
+    void endFrame();
+
+    unsigned int issueTimestamp(GpuFrame& gpuFrame);
+    unsigned int findLabel(const char* label);
+    void sumGpuDraws(const GpuFrame& gpuFrame, Frame* frame);
+    void readGpuFrame(GpuFrame& gpuFrame);
+    Frame* findFrame(unsigned int index);
+
+    bool _enabled;
+    bool _recording;
+    bool _gpuEnabled;
+    bool _gpuDraws;
+    unsigned int _frameIndex;
+    Frame _current;
+    std::vector<unsigned int> _stack;
+    std::vector<Frame> _frames;
+    unsigned int _frameCount;
+    std::vector<GpuFrame> _gpuFrames;
+    GpuFrame* _gpuFrame;
+    std::vector<unsigned int> _gpuStack;
+    std::map<std::string, unsigned int> _labelIndices;
+    std::vector<const char*> _labels;      // The keys of _labelIndices, by index.
+    SpriteBatch* _overlayBatch;
+};
+
+}
+
+#ifdef GP_NO_PROFILER
+#define GP_PROFILE_SCOPE(name)
+#define GP_PROFILE_GPU_SCOPE(name)
+#define GP_PROFILE_COUNTER(name, value)
+#else
+#define GP_PROFILE_CONCAT_(a, b) a##b
+#define GP_PROFILE_CONCAT(a, b) GP_PROFILE_CONCAT_(a, b)
+
+/**
+ * Records a CPU scope named 'name' until the end of the enclosing block.
+ */
+#define GP_PROFILE_SCOPE(name) gameplay::Profiler::Scope GP_PROFILE_CONCAT(__profileScope, __LINE__)(name)
+
+/**
+ * Records a GPU scope named 'name' until the end of the enclosing block.
+ */
+#define GP_PROFILE_GPU_SCOPE(name) gameplay::Profiler::GpuScope GP_PROFILE_CONCAT(__profileGpuScope, __LINE__)(name)
+
+/**
+ * Records the value of the counter named 'name' for the current frame.
+ */
+#define GP_PROFILE_COUNTER(name, value) gameplay::Profiler::counter((name), (value))
+#endif
+
+#endif
@@ -0,0 +1,275 @@
+#include "Base.h"
+#include "ProgramCache.h"
+#include "StateCache.h"
+#include "FileSystem.h"
+
+// Identifies a program cache file and the version of its layout.
+#define PROGRAM_CACHE_MAGIC     0x43505047
+#define PROGRAM_CACHE_VERSION   1
+
+// Default path of the cache file.
+#define PROGRAM_CACHE_PATH      "programs.cache"
+
+namespace gameplay
+{
+
+struct ProgramCacheHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long driverHash;
+};
+
+struct ProgramCacheEntryHeader
+{
+    unsigned long long key;
+    unsigned int format;
+    unsigned int length;
+};
+
+struct ProgramCacheEntry
+{
+    long offset;
+    unsigned int format;
+    unsigned int length;
+};
+
+static bool __enabled = false;
+static std::string __path;
+static unsigned long long __driverHash = 0;
+static std::map<unsigned long long, ProgramCacheEntry> __entries;
+
+static unsigned long long hash(unsigned long long value, const char* str)
+{
+    // 64-bit FNV-1a; the terminator is included so that consecutive strings cannot run together.
+    const char* c = str ? str : "";
+    do
+    {
+        value ^= (unsigned long long)(unsigned char)*c;
+        value *= 1099511628211ull;
+    } while (*c++);
+    return value;
+}
+
+bool ProgramCache::isSupported()
+{
+#ifdef USE_PROGRAM_BINARY
+    if (glGetProgramBinary == NULL || glProgramBinary == NULL)
+        return false;
+
+    GLint formatCount = 0;
+    GL_ASSERT( glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount) );
+    return formatCount > 0;
+#else
+    return false;
+#endif
+}
+
+void ProgramCache::initialize(Properties* properties)
+{
+    __enabled = false;
+    __entries.clear();
+
+    if (properties && !properties->getBool("enabled", true))
+        return;
+    if (!isSupported())
+        return;
+
+    const char* path = properties ? properties->getString("path") : NULL;
+    __path = path ? path : PROGRAM_CACHE_PATH;
+
+    // Binaries are only valid for the driver that created them.
+    __driverHash = 14695981039346656037ull;
+    __driverHash = hash(__driverHash, (const char*)glGetString(GL_VENDOR));
+    __driverHash = hash(__driverHash, (const char*)glGetString(GL_RENDERER));
+    __driverHash = hash(__driverHash, (const char*)glGetString(GL_VERSION));
+
+    __enabled = readIndex() || reset();
+}
+
+void ProgramCache::finalize()
+{
+    __enabled = false;
+    __entries.clear();
+}
+
+bool ProgramCache::isEnabled()
+{
+    return __enabled;
+}
+
+const char* ProgramCache::getPath()
+{
+    return __path.c_str();
+}
+
+void ProgramCache::clear()
+{
+    if (__enabled)
+    {
+        __enabled = reset();
+    }
+}
+
+bool ProgramCache::readIndex()
+{
+    FILE* file = FileSystem::openFile(__path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    ProgramCacheHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != PROGRAM_CACHE_MAGIC ||
+        header.version != PROGRAM_CACHE_VERSION || header.driverHash != __driverHash)
+    {
+        // Missing, outdated or written by another driver.
+        fclose(file);
+        return false;
+    }
+
+    // Later entries replace earlier ones with the same key; a truncated last entry is ignored.
+    ProgramCacheEntryHeader entryHeader;
+    while (fread(&entryHeader, sizeof(entryHeader), 1, file) == 1)
+    {
+        ProgramCacheEntry entry;
+        entry.offset = ftell(file);
+        entry.format = entryHeader.format;
+        entry.length = entryHeader.length;
+        if (fseek(file, entryHeader.length, SEEK_CUR) != 0)
+            break;
+        __entries[entryHeader.key] = entry;
+    }
+    fclose(file);
+
+    return true;
+}
+
+bool ProgramCache::reset()
+{
+    __entries.clear();
+
+    FILE* file = FileSystem::openFile(__path.c_str(), "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create program cache file '%s'.", __path.c_str());
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    header.driverHash = __driverHash;
+    bool result = fwrite(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+
+    return result;
+}
+
+unsigned long long ProgramCache::computeKey(const char* defines, const char* vertexSource, const char* fragmentSource)
+{
+    unsigned long long key = hash(__driverHash, defines);
+    key = hash(key, vertexSource);
+    key = hash(key, fragmentSource);
+    return key;
+}
+
+void ProgramCache::prepareProgram(GLuint program)
+{
+#if defined(USE_PROGRAM_BINARY) && defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    if (__enabled && glProgramParameteri)
+    {
+        GL_ASSERT( glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE) );
+    }
+#endif
+}
+
+GLuint ProgramCache::load(unsigned long long key)
+{
+#ifdef USE_PROGRAM_BINARY
+    if (!__enabled)
+        return 0;
+
+    std::map<unsigned long long, ProgramCacheEntry>::iterator itr = __entries.find(key);
+    if (itr == __entries.end())
+        return 0;
+    const ProgramCacheEntry& entry = itr->second;
+
+    FILE* file = FileSystem::openFile(__path.c_str(), "rb");
+    if (file == NULL)
+        return 0;
+
+    GLubyte* binary = new GLubyte[entry.length];
+    bool read = fseek(file, entry.offset, SEEK_SET) == 0 && fread(binary, 1, entry.length, file) == entry.length;
+    fclose(file);
+
+    GLuint program = 0;
+    if (read)
+    {
+        GL_ASSERT( program = glCreateProgram() );
+
+        // Drivers report rejected binaries through the link status (and an error for unknown formats).
+        glProgramBinary(program, (GLenum)entry.format, binary, (GLsizei)entry.length);
+        glGetError();
+
+        GLint success = GL_FALSE;
+        GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
+        if (success != GL_TRUE)
+        {
+            StateCache::deleteProgram(program);
+            program = 0;
+        }
+    }
+    SAFE_DELETE_ARRAY(binary);
+
+    if (program == 0)
+    {
+        // The program is rebuilt from source and saved again.
+        __entries.erase(itr);
+    }
+    return program;
+#else
+    return 0;
+#endif
+}
+
+void ProgramCache::save(unsigned long long key, GLuint program)
+{
+#ifdef USE_PROGRAM_BINARY
+    if (!__enabled)
+        return;
+
+    GLint length = 0;
+    GL_ASSERT( glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length) );
+    if (length <= 0)
+        return;
+
+    GLubyte* binary = new GLubyte[length];
+    GLsizei written = 0;
+    GLenum format = 0;
+    GL_ASSERT( glGetProgramBinary(program, length, &written, &format, binary) );
+
+    FILE* file = written > 0 ? FileSystem::openFile(__path.c_str(), "ab") : NULL;
+    if (file)
+    {
+        ProgramCacheEntryHeader entryHeader;
+        entryHeader.key = key;
+        entryHeader.format = (unsigned int)format;
+        entryHeader.length = (unsigned int)written;
+
+        ProgramCacheEntry entry;
+        entry.format = entryHeader.format;
+        entry.length = entryHeader.length;
+        if (fseek(file, 0, SEEK_END) == 0 && fwrite(&entryHeader, sizeof(entryHeader), 1, file) == 1)
+        {
+            entry.offset = ftell(file);
+            if (fwrite(binary, 1, written, file) == (size_t)written)
+            {
+                __entries[key] = entry;
+            }
+        }
+        fclose(file);
+    }
+    SAFE_DELETE_ARRAY(binary);
+#endif
+}
+
+}
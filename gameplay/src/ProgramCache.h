@@ -0,0 +1,119 @@
+#ifndef PROGRAMCACHE_H_
+#define PROGRAMCACHE_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a persistent cache of linked shader program binaries.
+ *
+ * When the driver supports program binaries (GL_OES_get_program_binary or
+ * GL_ARB_get_program_binary), every program linked by Effect is saved to a
+ * cache file, and later runs load the binary instead of compiling and linking
+ * the shaders again. Binaries are keyed by a hash of the defines, the expanded
+ * shader sources and the driver vendor, renderer and version strings. A
+ * binary that the driver rejects is dropped and the program is rebuilt from
+ * source, and the whole file is discarded when it was written by a different
+ * driver.
+ *
+ * The cache file is a path relative to the resource path, and it can be configured in the game config:
+ *
+ * @verbatim
+    programCache
+    {
+        enabled = true
+        path = programs.cache
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class ProgramCache
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Determines if program binaries are cached.
+     *
+     * @return True if the cache is enabled and supported by the driver.
+     */
+    static bool isEnabled();
+
+    /**
+     * Gets the path of the cache file.
+     *
+     * @return The path of the cache file.
+     */
+    static const char* getPath();
+
+    /**
+     * Removes every binary from the cache.
+     */
+    static void clear();
+
+    /**
+     * Computes the cache key of a program.
+     *
+     * @param defines The expanded #define lines of the program.
+     * @param vertexSource The expanded vertex shader source.
+     * @param fragmentSource The expanded fragment shader source.
+     *
+     * @return The key of the program.
+     */
+    static unsigned long long computeKey(const char* defines, const char* vertexSource, const char* fragmentSource);
+
+    /**
+     * Prepares a program that is about to be linked so that its binary can be retrieved.
+     *
+     * @param program The program to prepare.
+     */
+    static void prepareProgram(GLuint program);
+
+    /**
+     * Creates a program from its cached binary.
+     *
+     * @param key The key of the program.
+     *
+     * @return The linked program, or 0 if the binary is not cached or was rejected by the driver.
+     */
+    static GLuint load(unsigned long long key);
+
+    /**
+     * Saves the binary of a linked program to the cache.
+     *
+     * @param key The key of the program.
+     * @param program The linked program.
+     */
+    static void save(unsigned long long key, GLuint program);
+
+private:
+
+    /**
+     * Hidden constructor.
+     */
+    ProgramCache();
+
+    /**
+     * Called during startup to read the index of the cache file.
+     *
+     * @param properties The 'programCache' namespace of the game config, or NULL.
+     */
+    static void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown.
+     */
+    static void finalize();
+
+    static bool isSupported();
+    static bool readIndex();
+    static bool reset();
+};
+
+}
+
+#endif
@@ -1,11 +1,85 @@
 #include "Base.h"
 #include "Properties.h"
 #include "FileSystem.h"
+#include "LoadProfiler.h"
 #include "Quaternion.h"
+#include "StringTable.h"
+#include "Thread.h"
+
+// The value of Properties::_propertiesIndex before the first and after the last property.
+#define PROPERTIES_END ((size_t)-1)
+
+// The largest number of strings, properties or namespaces accepted in a binary properties file.
+#define PROPERTIES_BINARY_MAX_COUNT (16 * 1024 * 1024)
+
+// The number of properties from which a namespace looks its properties up in a hash table.
+#define PROPERTIES_TABLE_MIN_COUNT 8
 
 namespace gameplay
 {
 
+static const unsigned char PROPERTIES_BINARY_IDENTIFIER[] = { 0xAB, 'G', 'P', 'P', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char PROPERTIES_BINARY_VERSION[] = { 1, 0 };
+
+// Property names, shared by all namespaces.
+static StringTable __propertyNames;
+static Mutex __propertyNamesMutex;
+
+static const char* internPropertyName(const char* name)
+{
+    MutexLock lock(__propertyNamesMutex);
+    return __propertyNames.getString(__propertyNames.intern(name));
+}
+
+struct Properties::NamespaceIndex
+{
+    /**
+     * A namespace, sorted by the hash of its ID or name, then by depth-first order.
+     */
+    struct Entry
+    {
+        unsigned int hash;
+        unsigned int order;
+        Properties* space;
+
+        bool operator<(const Entry& entry) const
+        {
+            return hash < entry.hash || (hash == entry.hash && order < entry.order);
+        }
+    };
+
+    Properties* owner;
+    std::vector<Entry> ids;
+    std::vector<Entry> names;
+};
+
+/**
+ * Parses up to count comma separated floats, like sscanf with "%f,%f,...".
+ *
+ * @return The number of floats parsed.
+ */
+static unsigned int parseFloats(const char* str, float* values, unsigned int count)
+{
+    unsigned int parsed = 0;
+    while (parsed < count)
+    {
+        char* end;
+        double value = strtod(str, &end);
+        if (end == str)
+            break;
+        values[parsed++] = (float)value;
+        if (*end != ',')
+            break;
+        str = end + 1;
+    }
+    return parsed;
+}
+
+static bool readUnsignedInt(Stream* stream, unsigned int* value)
+{
+    return stream->read(value, sizeof(unsigned int), 1) == 1;
+}
+
 /**
  * Reads the next character from the stream. Returns EOF if the end of the stream is reached.
  */
@@ -25,13 +99,26 @@ void calculateNamespacePath(const std::string& urlString, std::string& fileStrin
 /** @script{ignore} */
 Properties* getPropertiesFromNamespacePath(Properties* properties, const std::vector<std::string>& namespacePath);
 
+Properties::Property::Property(const char* name, const char* value)
+    : name(internPropertyName(name)), hash(StringTable::hash(name)), value(value), floatCount(-1)
+{
+}
+
+unsigned int Properties::Property::getFloats() const
+{
+    if (floatCount < 0)
+        floatCount = (int)parseFloats(value.c_str(), floats, 4);
+    return (unsigned int)floatCount;
+}
+
 Properties::Properties()
-    : _dirPath(NULL), _parent(NULL)
+    : _propertiesIndex(PROPERTIES_END), _namespaceIndex(NULL), _order(0), _orderEnd(0), _dirPath(NULL), _parent(NULL)
 {
 }
 
 Properties::Properties(const Properties& copy)
-    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _dirPath(NULL), _parent(copy._parent)
+    : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _propertyTable(copy._propertyTable),
+      _propertiesIndex(PROPERTIES_END), _namespaceIndex(NULL), _order(0), _orderEnd(0), _dirPath(NULL), _parent(copy._parent)
 {
     setDirectoryPath(copy._dirPath);
     _namespaces = std::vector<Properties*>();
@@ -46,14 +133,14 @@ Properties::Properties(const Properties& copy)
 
 
 Properties::Properties(Stream* stream)
-    : _dirPath(NULL), _parent(NULL)
+    : _propertiesIndex(PROPERTIES_END), _namespaceIndex(NULL), _order(0), _orderEnd(0), _dirPath(NULL), _parent(NULL)
 {
     readProperties(stream);
     rewind();
 }
 
 Properties::Properties(Stream* stream, const char* name, const char* id, const char* parentID, Properties* parent)
-    : _namespace(name), _dirPath(NULL), _parent(parent)
+    : _namespace(name), _propertiesIndex(PROPERTIES_END), _namespaceIndex(NULL), _order(0), _orderEnd(0), _dirPath(NULL), _parent(parent)
 {
     if (id)
     {
@@ -75,6 +162,8 @@ Properties* Properties::create(const char* url)
         return NULL;
     }
 
+    LoadProfiler::Scope profile("properties", url);
+
     // Calculate the file and full namespace path from the specified url.
     std::string urlString = url;
     std::string fileString;
@@ -88,7 +177,54 @@ Properties* Properties::create(const char* url)
         return NULL;
     }
 
-    Properties* properties = new Properties(stream.get());
+    // Binary files start with an identifier, text files are parsed.
+    Properties* properties = NULL;
+    unsigned char identifier[sizeof(PROPERTIES_BINARY_IDENTIFIER)];
+    if (stream->read(identifier, 1, sizeof(identifier)) == sizeof(identifier) &&
+        memcmp(identifier, PROPERTIES_BINARY_IDENTIFIER, sizeof(identifier)) == 0)
+    {
+        unsigned char version[2];
+        unsigned int stringCount;
+        if (stream->read(version, 1, 2) != 2 || version[0] != PROPERTIES_BINARY_VERSION[0] ||
+            !readUnsignedInt(stream.get(), &stringCount) || stringCount > PROPERTIES_BINARY_MAX_COUNT)
+        {
+            GP_ERROR("Unsupported version or invalid header in binary properties file '%s'.", fileString.c_str());
+            return NULL;
+        }
+
+        // All names, ids and values are stored once in the string table.
+        std::vector<std::string> strings(stringCount);
+        std::vector<char> buffer;
+        for (unsigned int i = 0; i < stringCount; ++i)
+        {
+            unsigned int length;
+            if (!readUnsignedInt(stream.get(), &length) || length > stream->length())
+            {
+                GP_ERROR("Failed to read the string table of binary properties file '%s'.", fileString.c_str());
+                return NULL;
+            }
+            buffer.resize(length + 1);
+            if (length > 0 && stream->read(&buffer[0], 1, length) != length)
+            {
+                GP_ERROR("Failed to read the string table of binary properties file '%s'.", fileString.c_str());
+                return NULL;
+            }
+            strings[i].assign(&buffer[0], length);
+        }
+
+        properties = new Properties();
+        if (!properties->readBinary(stream.get(), strings))
+        {
+            GP_ERROR("Failed to read binary properties file '%s'.", fileString.c_str());
+            SAFE_DELETE(properties);
+            return NULL;
+        }
+    }
+    else
+    {
+        stream->rewind();
+        properties = new Properties(stream.get());
+    }
     properties->resolveInheritance();
     stream->close();
 
@@ -109,6 +245,7 @@ Properties* Properties::create(const char* url)
         SAFE_DELETE(properties);
     }
     p->setDirectoryPath(FileSystem::getDirectoryName(fileString.c_str()));
+    p->buildIndex();
     return p;
 }
 
@@ -175,7 +312,7 @@ void Properties::readProperties(Stream* stream)
                 value = trimWhiteSpace(value);
 
                 // Store name/value pair.
-                _properties[name] = value;
+                setProperty(name, value);
 
                 if (rc != NULL)
                 {
@@ -326,14 +463,7 @@ void Properties::readProperties(Stream* stream)
                                 GP_ERROR("Failed to seek backwards a single character after testing if the next line starts with '{'.");
 
                             // Store "name value" as a name/value pair, or even just "name".
-                            if (value != NULL)
-                            {
-                                _properties[name] = value;
-                            }
-                            else
-                            {
-                                _properties[name] = std::string();
-                            }
+                            setProperty(name, value != NULL ? value : "");
                         }
                     }
                 }
@@ -342,6 +472,167 @@ void Properties::readProperties(Stream* stream)
     }
 }
 
+bool Properties::readBinary(Stream* stream, const std::vector<std::string>& strings)
+{
+    GP_ASSERT(stream);
+
+    unsigned int name, id, parentID, count;
+    if (!readUnsignedInt(stream, &name) || !readUnsignedInt(stream, &id) || !readUnsignedInt(stream, &parentID) ||
+        name >= strings.size() || id >= strings.size() || parentID >= strings.size())
+    {
+        return false;
+    }
+    _namespace = strings[name];
+    _id = strings[id];
+    _parentID = strings[parentID];
+
+    if (!readUnsignedInt(stream, &count) || count > PROPERTIES_BINARY_MAX_COUNT)
+        return false;
+    _properties.reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        unsigned int value;
+        unsigned char floatCount;
+        if (!readUnsignedInt(stream, &name) || !readUnsignedInt(stream, &value) || name >= strings.size() || value >= strings.size() ||
+            stream->read(&floatCount, 1, 1) != 1 || floatCount > 4)
+        {
+            return false;
+        }
+
+        // The numbers of the value were parsed by the encoder.
+        Property& property = setProperty(strings[name].c_str(), strings[value].c_str());
+        if (floatCount > 0 && stream->read(property.floats, sizeof(float), floatCount) != floatCount)
+            return false;
+        property.floatCount = floatCount;
+    }
+
+    if (!readUnsignedInt(stream, &count) || count > PROPERTIES_BINARY_MAX_COUNT)
+        return false;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Properties* space = new Properties();
+        space->_parent = this;
+        _namespaces.push_back(space);
+        if (!space->readBinary(stream, strings))
+            return false;
+        space->rewind();
+    }
+    rewind();
+    return true;
+}
+
+const Properties::Property* Properties::getProperty(const char* name) const
+{
+    if (name == NULL)
+        return _propertiesIndex < _properties.size() ? &_properties[_propertiesIndex] : NULL;
+
+    // Most namespaces hold few properties, for which a linear search is faster than hashing the name.
+    if (_propertyTable.empty())
+    {
+        for (size_t i = 0, count = _properties.size(); i < count; ++i)
+        {
+            const char* propertyName = _properties[i].name;
+            if (propertyName[0] == name[0] && strcmp(propertyName, name) == 0)
+                return &_properties[i];
+        }
+        return NULL;
+    }
+
+    unsigned int hash = StringTable::hash(name);
+    size_t mask = _propertyTable.size() - 1;
+    for (size_t i = hash & mask; _propertyTable[i] != 0; i = (i + 1) & mask)
+    {
+        const Property& property = _properties[_propertyTable[i] - 1];
+        if (property.hash == hash && strcmp(property.name, name) == 0)
+            return &property;
+    }
+    return NULL;
+}
+
+Properties::Property& Properties::setProperty(const char* name, const char* value)
+{
+    GP_ASSERT(name && value);
+
+    Property* property = const_cast<Property*>(getProperty(name));
+    if (property)
+    {
+        property->value = value;
+        property->floatCount = -1;
+        return *property;
+    }
+    _properties.push_back(Property(name, value));
+    indexProperty(_properties.size() - 1);
+    return _properties.back();
+}
+
+void Properties::indexProperty(size_t index)
+{
+    size_t count = _properties.size();
+    if (count < PROPERTIES_TABLE_MIN_COUNT)
+        return;
+
+    // Keep the table at most half full, rebuilding it with all the properties when it grows.
+    size_t first = index;
+    if (_propertyTable.size() < count * 2)
+    {
+        size_t size = 16;
+        while (size < count * 2)
+            size *= 2;
+        _propertyTable.assign(size, 0);
+        first = 0;
+    }
+
+    size_t mask = _propertyTable.size() - 1;
+    for (size_t i = first; i <= index; ++i)
+    {
+        size_t slot = _properties[i].hash & mask;
+        while (_propertyTable[slot] != 0)
+            slot = (slot + 1) & mask;
+        _propertyTable[slot] = (unsigned int)i + 1;
+    }
+}
+
+void Properties::buildIndex()
+{
+    GP_ASSERT(_namespaceIndex == NULL);
+
+    NamespaceIndex* index = new NamespaceIndex();
+    index->owner = this;
+    unsigned int order = 0;
+    indexNamespaces(index, order);
+    std::sort(index->ids.begin(), index->ids.end());
+    std::sort(index->names.begin(), index->names.end());
+    _namespaceIndex = index;
+}
+
+void Properties::indexNamespaces(NamespaceIndex* index, unsigned int& order)
+{
+    GP_ASSERT(index);
+
+    // Parse the numbers now, so that concurrent reads do not parse them on first use.
+    for (size_t i = 0, count = _properties.size(); i < count; ++i)
+    {
+        _properties[i].getFloats();
+    }
+
+    _namespaceIndex = index;
+    _order = order++;
+    for (size_t i = 0, count = _namespaces.size(); i < count; ++i)
+    {
+        Properties* space = _namespaces[i];
+        GP_ASSERT(space);
+        NamespaceIndex::Entry entry;
+        entry.order = order;
+        entry.space = space;
+        entry.hash = StringTable::hash(space->_id.c_str());
+        index->ids.push_back(entry);
+        entry.hash = StringTable::hash(space->_namespace.c_str());
+        index->names.push_back(entry);
+        space->indexNamespaces(index, order);
+    }
+    _orderEnd = order;
+}
+
 Properties::~Properties()
 {
     SAFE_DELETE(_dirPath);
@@ -349,6 +640,12 @@ Properties::~Properties()
     {
         SAFE_DELETE(_namespaces[i]);
     }
+
+    // The namespaces within this one share the index, delete it after them.
+    if (_namespaceIndex && _namespaceIndex->owner == this)
+    {
+        SAFE_DELETE(_namespaceIndex);
+    }
 }
 
 void Properties::skipWhiteSpace(Stream* stream)
@@ -437,6 +734,7 @@ void Properties::resolveInheritance(const char* id)
 
                 // Copy data from the parent into the child.
                 derived->_properties = parent->_properties;
+                derived->_propertyTable = parent->_propertyTable;
                 derived->_namespaces = std::vector<Properties*>();
                 std::vector<Properties*>::const_iterator itt;
                 for (itt = parent->_namespaces.begin(); itt < parent->_namespaces.end(); ++itt)
@@ -473,17 +771,13 @@ void Properties::mergeWith(Properties* overrides)
 {
     GP_ASSERT(overrides);
 
-    // Overwrite or add each property found in child.
-    char* value = new char[255];
-    overrides->rewind();
-    const char* name = overrides->getNextProperty(&value);
-    while (name)
+    // Overwrite or add each property found in child, along with its parsed numbers.
+    for (size_t i = 0, count = overrides->_properties.size(); i < count; ++i)
     {
-        this->_properties[name] = value;
-        name = overrides->getNextProperty(&value);
+        const Property& property = overrides->_properties[i];
+        setProperty(property.name, property.value.c_str()) = property;
     }
-    SAFE_DELETE_ARRAY(value);
-    this->_propertiesItr = this->_properties.end();
+    this->_propertiesIndex = PROPERTIES_END;
 
     // Merge all common nested namespaces, add new ones.
     Properties* overridesNamespace = overrides->getNextNamespace();
@@ -520,29 +814,33 @@ void Properties::mergeWith(Properties* overrides)
 
 const char* Properties::getNextProperty(char** value)
 {
-    if (_propertiesItr == _properties.end())
+    if (_propertiesIndex == PROPERTIES_END)
     {
         // Restart from the beginning
-        _propertiesItr = _properties.begin();
+        _propertiesIndex = 0;
     }
     else
     {
         // Move to the next property
-        ++_propertiesItr;
+        ++_propertiesIndex;
     }
 
-    if (_propertiesItr != _properties.end())
+    if (_propertiesIndex < _properties.size())
     {
-        const std::string& name = _propertiesItr->first;
-        if (!name.empty())
+        const Property& property = _properties[_propertiesIndex];
+        if (property.name[0] != '\0')
         {
             if (value)
             {
-                strcpy(*value, _propertiesItr->second.c_str());
+                strcpy(*value, property.value.c_str());
             }
-            return name.c_str();
+            return property.name;
         }
     }
+    else
+    {
+        _propertiesIndex = PROPERTIES_END;
+    }
 
     return NULL;
 }
@@ -570,14 +868,51 @@ Properties* Properties::getNextNamespace()
 
 void Properties::rewind()
 {
-    _propertiesItr = _properties.end();
+    _propertiesIndex = PROPERTIES_END;
     _namespacesItr = _namespaces.end();
 }
 
+unsigned int Properties::getPropertyCount() const
+{
+    return (unsigned int)_properties.size();
+}
+
+const char* Properties::getPropertyName(unsigned int index) const
+{
+    return index < _properties.size() ? _properties[index].name : NULL;
+}
+
+unsigned int Properties::getNamespaceCount() const
+{
+    return (unsigned int)_namespaces.size();
+}
+
+Properties* Properties::getNamespaceAt(unsigned int index) const
+{
+    return index < _namespaces.size() ? _namespaces[index] : NULL;
+}
+
 Properties* Properties::getNamespace(const char* id, bool searchNames) const
 {
     GP_ASSERT(id);
 
+    if (_namespaceIndex)
+    {
+        // The first match within this namespace in depth-first order, as found by the search below.
+        const std::vector<NamespaceIndex::Entry>& entries = searchNames ? _namespaceIndex->names : _namespaceIndex->ids;
+        NamespaceIndex::Entry key;
+        key.hash = StringTable::hash(id);
+        key.order = _order + 1;
+        key.space = NULL;
+        std::vector<NamespaceIndex::Entry>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), key);
+        for (; it != entries.end() && it->hash == key.hash && it->order < _orderEnd; ++it)
+        {
+            if (strcmp(searchNames ? it->space->_namespace.c_str() : it->space->_id.c_str(), id) == 0)
+                return it->space;
+        }
+        return NULL;
+    }
+
     Properties* ret = NULL;
     std::vector<Properties*>::const_iterator it;
     
@@ -613,7 +948,7 @@ const char* Properties::getId() const
 bool Properties::exists(const char* name) const
 {
     GP_ASSERT(name);
-    return _properties.find(name) != _properties.end();
+    return getProperty(name) != NULL;
 }
 
 static const bool isStringNumeric(const char* str)
@@ -686,23 +1021,8 @@ Properties::Type Properties::getType(const char* name) const
 
 const char* Properties::getString(const char* name) const
 {
-    if (name)
-    {
-        std::map<std::string, std::string>::const_iterator itr = _properties.find(name);
-        if (itr != _properties.end())
-        {
-            return itr->second.c_str();
-        }
-    }
-    else
-    {
-        if (_propertiesItr != _properties.end())
-        {
-            return _propertiesItr->second.c_str();
-        }
-    }
-
-    return NULL;
+    const Property* property = getProperty(name);
+    return property ? property->value.c_str() : NULL;
 }
 
 bool Properties::getBool(const char* name, bool defaultValue) const
@@ -721,15 +1041,14 @@ int Properties::getInt(const char* name) const
     const char* valueString = getString(name);
     if (valueString)
     {
-        int value;
-        int scanned;
-        scanned = sscanf(valueString, "%d", &value);
-        if (scanned != 1)
+        char* end;
+        long value = strtol(valueString, &end, 10);
+        if (end == valueString)
         {
             GP_ERROR("Error attempting to parse property '%s' as an integer.", name);
             return 0;
         }
-        return value;
+        return (int)value;
     }
 
     return 0;
@@ -737,18 +1056,15 @@ int Properties::getInt(const char* name) const
 
 float Properties::getFloat(const char* name) const
 {
-    const char* valueString = getString(name);
-    if (valueString)
+    const Property* property = getProperty(name);
+    if (property)
     {
-        float value;
-        int scanned;
-        scanned = sscanf(valueString, "%f", &value);
-        if (scanned != 1)
+        if (property->getFloats() < 1)
         {
             GP_ERROR("Error attempting to parse property '%s' as a float.", name);
             return 0.0f;
         }
-        return value;
+        return property->floats[0];
     }
 
     return 0.0f;
@@ -759,10 +1075,9 @@ long Properties::getLong(const char* name) const
     const char* valueString = getString(name);
     if (valueString)
     {
-        long value;
-        int scanned;
-        scanned = sscanf(valueString, "%ld", &value);
-        if (scanned != 1)
+        char* end;
+        long value = strtol(valueString, &end, 10);
+        if (end == valueString)
         {
             GP_ERROR("Error attempting to parse property '%s' as a long integer.", name);
             return 0L;
@@ -781,12 +1096,7 @@ bool Properties::getMatrix(const char* name, Matrix* out) const
     if (valueString)
     {
         float m[16];
-        int scanned;
-        scanned = sscanf(valueString, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
-                &m[0], &m[1], &m[2], &m[3], &m[4], &m[5], &m[6], &m[7],
-                &m[8], &m[9], &m[10], &m[11], &m[12], &m[13], &m[14], &m[15]);
-
-        if (scanned != 16)
+        if (parseFloats(valueString, m, 16) != 16)
         {
             GP_ERROR("Error attempting to parse property '%s' as a matrix.", name);
             out->setIdentity();
@@ -805,20 +1115,17 @@ bool Properties::getVector2(const char* name, Vector2* out) const
 {
     GP_ASSERT(out);
 
-    const char* valueString = getString(name);
-    if (valueString)
+    const Property* property = getProperty(name);
+    if (property)
     {
-        float x, y;
-        int scanned;
-        scanned = sscanf(valueString, "%f,%f", &x, &y);
-        if (scanned != 2)
+        if (property->getFloats() < 2)
         {
             GP_ERROR("Error attempting to parse property '%s' as a two-dimensional vector.", name);
             out->set(0.0f, 0.0f);
             return false;
         }
 
-        out->set(x, y);
+        out->set(property->floats);
         return true;
     }
     
@@ -830,20 +1137,17 @@ bool Properties::getVector3(const char* name, Vector3* out) const
 {
     GP_ASSERT(out);
 
-    const char* valueString = getString(name);
-    if (valueString)
+    const Property* property = getProperty(name);
+    if (property)
     {
-        float x, y, z;
-        int scanned;
-        scanned = sscanf(valueString, "%f,%f,%f", &x, &y, &z);
-        if (scanned != 3)
+        if (property->getFloats() < 3)
         {
             GP_ERROR("Error attempting to parse property '%s' as a three-dimensional vector.", name);
             out->set(0.0f, 0.0f, 0.0f);
             return false;
         }
 
-        out->set(x, y, z);
+        out->set(property->floats);
         return true;
     }
     
@@ -855,20 +1159,17 @@ bool Properties::getVector4(const char* name, Vector4* out) const
 {
     GP_ASSERT(out);
 
-    const char* valueString = getString(name);
-    if (valueString)
+    const Property* property = getProperty(name);
+    if (property)
     {
-        float x, y, z, w;
-        int scanned;
-        scanned = sscanf(valueString, "%f,%f,%f,%f", &x, &y, &z, &w);
-        if (scanned != 4)
+        if (property->getFloats() < 4)
         {
             GP_ERROR("Error attempting to parse property '%s' as a four-dimensional vector.", name);
             out->set(0.0f, 0.0f, 0.0f, 0.0f);
             return false;
         }
 
-        out->set(x, y, z, w);
+        out->set(property->floats);
         return true;
     }
     
@@ -880,20 +1181,18 @@ bool Properties::getQuaternionFromAxisAngle(const char* name, Quaternion* out) c
 {
     GP_ASSERT(out);
 
-    const char* valueString = getString(name);
-    if (valueString)
+    const Property* property = getProperty(name);
+    if (property)
     {
-        float x, y, z, theta;
-        int scanned;
-        scanned = sscanf(valueString, "%f,%f,%f,%f", &x, &y, &z, &theta);
-        if (scanned != 4)
+        if (property->getFloats() < 4)
         {
             GP_ERROR("Error attempting to parse property '%s' as an axis-angle rotation.", name);
             out->set(0.0f, 0.0f, 0.0f, 1.0f);
             return false;
         }
 
-        out->set(Vector3(x, y, z), MATH_DEG_TO_RAD(theta));
+        const float* v = property->floats;
+        out->set(Vector3(v[0], v[1], v[2]), MATH_DEG_TO_RAD(v[3]));
         return true;
     }
     
@@ -1010,7 +1309,8 @@ Properties* Properties::clone()
     p->_id = _id;
     p->_parentID = _parentID;
     p->_properties = _properties;
-    p->_propertiesItr = p->_properties.end();
+    p->_propertyTable = _propertyTable;
+    p->_propertiesIndex = PROPERTIES_END;
     p->setDirectoryPath(_dirPath);
 
     for (size_t i = 0, count = _namespaces.size(); i < count; i++)
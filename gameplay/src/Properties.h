@@ -124,6 +124,22 @@ class Properties;
  * modified to do so.  Also note that nothing in a properties file indicates the type
  * of a property. If the type is unknown, its string can be retrieved and interpreted
  * as necessary.
+ *
+ * Properties are returned by getNextProperty() in the order they appear in the file.
+ * The numbers of a value are parsed the first time they are read with one of the
+ * typed getters and kept with the value for the following reads.
+ *
+ * Once create() returns, the properties are not modified anymore: the numbers of
+ * every value have been parsed, and the namespaces of the file are indexed by ID and
+ * by name, so getNamespace() does not search the whole file. Loaders running on
+ * several threads can read the same properties concurrently, as long as they use
+ * getPropertyName() and getNamespaceAt() to iterate, instead of getNextProperty()
+ * and getNextNamespace(), which move an iterator stored in the object, and pass the
+ * name of each property to the getters.
+ *
+ * Properties files can be compiled to a binary form with gameplay-encoder, which
+ * stores the parsed numbers of the values. Binary files are recognized by their
+ * content, so they can be loaded in place of a text file with the same name.
  */
 class Properties
 {
@@ -181,6 +197,42 @@ public:
      */
     void rewind();
 
+    /**
+     * Gets the number of properties of this namespace.
+     *
+     * @return The number of properties.
+     * @script{ignore}
+     */
+    unsigned int getPropertyCount() const;
+
+    /**
+     * Gets the name of a property of this namespace, without moving the getNextProperty() iterator.
+     *
+     * @param index The index of the property, in the order of the file.
+     *
+     * @return The name of the property, or NULL if index is out of range.
+     * @script{ignore}
+     */
+    const char* getPropertyName(unsigned int index) const;
+
+    /**
+     * Gets the number of namespaces directly within this namespace.
+     *
+     * @return The number of namespaces.
+     * @script{ignore}
+     */
+    unsigned int getNamespaceCount() const;
+
+    /**
+     * Gets a namespace directly within this namespace, without moving the getNextNamespace() iterator.
+     *
+     * @param index The index of the namespace, in the order of the file.
+     *
+     * @return The namespace, or NULL if index is out of range.
+     * @script{ignore}
+     */
+    Properties* getNamespaceAt(unsigned int index) const;
+
     /**
      * Get a specific namespace by ID or name. This method will perform
      * a depth-first search on all namespaces and inner namespaces within
@@ -393,7 +445,36 @@ public:
     bool getPath(const char* name, std::string* path) const;
 
 private:
-    
+
+    /**
+     * Defines a name/value pair of a namespace.
+     */
+    struct Property
+    {
+        /**
+         * Constructor.
+         */
+        Property(const char* name, const char* value);
+
+        /**
+         * Gets the numbers of the value, parsing them on first use.
+         *
+         * @return The number of leading comma separated numbers of the value, up to 4.
+         */
+        unsigned int getFloats() const;
+
+        const char* name;           // Interned, shared by all properties with the same name.
+        unsigned int hash;          // The hash of the name.
+        std::string value;
+        mutable int floatCount;     // The number of parsed floats, or -1 if the value has not been parsed.
+        mutable float floats[4];
+    };
+
+    /**
+     * The namespaces of a file by the hash of their ID and of their name, shared by all of its namespaces.
+     */
+    struct NamespaceIndex;
+
     /**
      * Constructor.
      */
@@ -414,6 +495,40 @@ private:
 
     void readProperties(Stream* stream);
 
+    /**
+     * Reads a namespace of a binary properties file.
+     *
+     * @param stream The stream, positioned on the namespace.
+     * @param strings The string table of the file.
+     *
+     * @return true if the namespace was read.
+     */
+    bool readBinary(Stream* stream, const std::vector<std::string>& strings);
+
+    /**
+     * Finds a property by name, or returns the current property of getNextProperty() if name is NULL.
+     */
+    const Property* getProperty(const char* name) const;
+
+    /**
+     * Sets a property, replacing the value of an existing property with the same name.
+     */
+    Property& setProperty(const char* name, const char* value);
+
+    /**
+     * Adds a property to the hash table of the properties, rebuilding the table when it is too small.
+     */
+    void indexProperty(size_t index);
+
+    /**
+     * Parses the numbers of the values and indexes the namespaces of this namespace and of all
+     * namespaces within it. Called once the properties are not modified anymore.
+     */
+    void buildIndex();
+
+    // Called by buildIndex(); numbers this namespace and the namespaces within it in depth-first order.
+    void indexNamespaces(NamespaceIndex* index, unsigned int& order);
+
     void skipWhiteSpace(Stream* stream);
 
     char* trimWhiteSpace(char* str);
@@ -433,10 +548,14 @@ private:
     std::string _namespace;
     std::string _id;
     std::string _parentID;
-    std::map<std::string, std::string> _properties;
-    std::map<std::string, std::string>::const_iterator _propertiesItr;
+    std::vector<Property> _properties;
+    std::vector<unsigned int> _propertyTable;   // Open addressed by name hash, property index + 1; empty for few properties.
+    size_t _propertiesIndex;        // The current property of getNextProperty(), or PROPERTIES_END.
     std::vector<Properties*> _namespaces;
     std::vector<Properties*>::const_iterator _namespacesItr;
+    NamespaceIndex* _namespaceIndex;    // Owned by the namespace that built it, or NULL if not indexed.
+    unsigned int _order;            // The depth-first index of this namespace in _namespaceIndex.
+    unsigned int _orderEnd;         // The depth-first index following the last namespace within this one.
     std::string* _dirPath;
     Properties* _parent;
 };
@@ -67,11 +67,13 @@ bool RadioButton::isSelected() const
 void RadioButton::setSelected(bool selected)
 {
     _selected = selected;
+    _dirty = true;
 }
 
 void RadioButton::setImageSize(float width, float height)
 {
     _imageSize.set(width, height);
+    _dirty = true;
 }
 
 const Vector2& RadioButton::getImageSize() const
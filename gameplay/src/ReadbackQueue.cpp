@@ -0,0 +1,216 @@
+#include "Base.h"
+#include "ReadbackQueue.h"
+#include "FrameBuffer.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+
+namespace gameplay
+{
+
+ReadbackQueue::ReadbackQueue()
+    : _async(false), _poolSize(3)
+{
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+}
+
+void ReadbackQueue::initialize(Properties* properties)
+{
+    if (properties && properties->exists("poolSize"))
+        _poolSize = (unsigned int)std::max(properties->getInt("poolSize"), 0);
+
+#if defined(USE_MAPPED_BUFFERS) && defined(USE_FENCE_SYNC)
+    _async = glMapBufferRange && glUnmapBuffer && glFenceSync && glClientWaitSync && glDeleteSync;
+#endif
+}
+
+void ReadbackQueue::finalize()
+{
+    completeReads(true);
+
+    for (size_t i = 0, count = _pool.size(); i < count; ++i)
+    {
+        StateCache::deleteBuffers(1, &_pool[i].buffer);
+    }
+    _pool.clear();
+}
+
+void ReadbackQueue::update()
+{
+    completeReads(false);
+}
+
+bool ReadbackQueue::isAsync() const
+{
+    return _async;
+}
+
+unsigned int ReadbackQueue::getPendingCount() const
+{
+    return (unsigned int)_pending.size();
+}
+
+void ReadbackQueue::read(FrameBuffer* frameBuffer, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+                         ReadbackCallback callback, void* cookie)
+{
+    GP_ASSERT(callback);
+
+    if (width == 0 || height == 0)
+    {
+        GP_ERROR("Invalid readback area of %u x %u pixels.", width, height);
+        callback(NULL, width, height, cookie);
+        return;
+    }
+    if (RenderCommandList::isRecording())
+    {
+        // The game thread's context cannot see the frame buffers the render thread draws into.
+        GP_WARN("Pixels cannot be read back while the frame is recorded for the render thread.");
+        callback(NULL, width, height, cookie);
+        return;
+    }
+
+    FrameBuffer* previous = frameBuffer ? frameBuffer->bind() : NULL;
+
+    Readback readback;
+    readback.callback = callback;
+    readback.cookie = cookie;
+    readback.width = width;
+    readback.height = height;
+    readback.buffer = 0;
+    readback.size = width * height * 4;
+    readback.fence = NULL;
+    readback.pixels = NULL;
+
+#if defined(USE_MAPPED_BUFFERS) && defined(USE_FENCE_SYNC)
+    if (_async)
+    {
+        PixelBuffer buffer = acquireBuffer(readback.size);
+        readback.buffer = buffer.buffer;
+        readback.size = buffer.size;
+        StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        GL_ASSERT( glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0) );
+        StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+#endif
+    if (readback.buffer == 0)
+    {
+        readback.pixels = new unsigned char[readback.size];
+        GL_ASSERT( glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, readback.pixels) );
+    }
+
+    if (previous)
+        previous->bind();
+
+    _pending.push_back(readback);
+}
+
+void ReadbackQueue::completeReads(bool wait)
+{
+    while (!_pending.empty())
+    {
+        Readback readback = _pending.front();
+        const unsigned char* pixels = readback.pixels;
+
+#if defined(USE_MAPPED_BUFFERS) && defined(USE_FENCE_SYNC)
+        if (readback.buffer)
+        {
+            GLsync fence = (GLsync)readback.fence;
+            if (fence)
+            {
+                GLenum result = glClientWaitSync(fence, 0, 0);
+                if (result == GL_TIMEOUT_EXPIRED)
+                {
+                    if (!wait)
+                        break;
+                    do
+                    {
+                        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                    } while (result == GL_TIMEOUT_EXPIRED);
+                }
+                GL_ASSERT( glDeleteSync(fence) );
+            }
+
+            // The read is complete, so mapping the buffer does not wait for the GPU.
+            StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.width * readback.height * 4, GL_MAP_READ_BIT);
+            if (pixels == NULL)
+                GP_ERROR("Failed to map the pixel buffer of a readback of %u x %u pixels.", readback.width, readback.height);
+        }
+#endif
+
+        _pending.pop_front();
+        readback.callback(pixels, readback.width, readback.height, readback.cookie);
+
+#if defined(USE_MAPPED_BUFFERS) && defined(USE_FENCE_SYNC)
+        if (readback.buffer)
+        {
+            if (pixels)
+            {
+                GL_ASSERT( glUnmapBuffer(GL_PIXEL_PACK_BUFFER) );
+            }
+            StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            PixelBuffer buffer;
+            buffer.buffer = readback.buffer;
+            buffer.size = readback.size;
+            releaseBuffer(buffer);
+        }
+#endif
+        SAFE_DELETE_ARRAY(readback.pixels);
+    }
+}
+
+ReadbackQueue::PixelBuffer ReadbackQueue::acquireBuffer(unsigned int size)
+{
+    // The smallest idle buffer that fits, so that large buffers stay available for large reads.
+    int best = -1;
+    for (size_t i = 0, count = _pool.size(); i < count; ++i)
+    {
+        if (_pool[i].size >= size && (best < 0 || _pool[i].size < _pool[best].size))
+            best = (int)i;
+    }
+    if (best >= 0)
+    {
+        PixelBuffer buffer = _pool[best];
+        _pool.erase(_pool.begin() + best);
+        return buffer;
+    }
+
+    PixelBuffer buffer;
+    buffer.size = size;
+    GL_ASSERT( glGenBuffers(1, &buffer.buffer) );
+    StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+    GL_ASSERT( glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ) );
+    StateCache::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return buffer;
+}
+
+void ReadbackQueue::releaseBuffer(const PixelBuffer& buffer)
+{
+    if (_pool.size() < _poolSize)
+    {
+        _pool.push_back(buffer);
+        return;
+    }
+
+    // The pool is full; the smallest buffer is the least useful to keep.
+    size_t smallest = 0;
+    for (size_t i = 1, count = _pool.size(); i < count; ++i)
+    {
+        if (_pool[i].size < _pool[smallest].size)
+            smallest = i;
+    }
+    if (!_pool.empty() && _pool[smallest].size < buffer.size)
+    {
+        StateCache::deleteBuffers(1, &_pool[smallest].buffer);
+        _pool[smallest] = buffer;
+    }
+    else
+    {
+        StateCache::deleteBuffers(1, &buffer.buffer);
+    }
+}
+
+}
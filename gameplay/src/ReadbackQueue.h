@@ -0,0 +1,168 @@
+#ifndef READBACKQUEUE_H_
+#define READBACKQUEUE_H_
+
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class FrameBuffer;
+
+/**
+ * Defines a queue that reads the pixels of frame buffers back to the CPU without stalling the frame.
+ *
+ * Reading pixels with glReadPixels into client memory makes the CPU wait until the GPU has
+ * drawn everything submitted before the read, and drains the pipeline every time it is used.
+ * Where the platform has pixel buffer objects and fences, the queue instead reads the pixels
+ * into a pixel buffer, inserts a fence after the read and returns at once. The pixels are
+ * handed to a callback from Game::frame() once the fence has signaled, typically a frame or
+ * two later, so screenshots, picking and video capture cost no more than the copy itself.
+ * Pixel buffers are recycled through a small pool of idle buffers.
+ *
+ * Where pixel buffers or fences are not available, the pixels are read immediately and the
+ * callback is still called at the start of the next frame, so the results arrive the same way
+ * on every platform. Reads are refused while the frame is recorded for the render thread,
+ * whose context is the only one that can read its frame buffers.
+ *
+ * The queue is configured in the game config:
+ *
+ * @verbatim
+    readback
+    {
+        poolSize = 3        // Number of idle pixel buffers kept for reuse.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class ReadbackQueue
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Function called on the main thread with the pixels of a read.
+     *
+     * @param pixels The RGBA pixels, 4 bytes each, with the bottom row first, or NULL if the read failed.
+     *      They are only valid during the call.
+     * @param width The width of the area read.
+     * @param height The height of the area read.
+     * @param cookie The cookie passed to read().
+     */
+    typedef void (*ReadbackCallback)(const unsigned char* pixels, unsigned int width, unsigned int height, void* cookie);
+
+    /**
+     * Reads an area of a frame buffer back to the CPU.
+     *
+     * The read captures the contents of the frame buffer at the time of the call; drawing
+     * into it afterwards does not change the pixels handed to the callback.
+     *
+     * @param frameBuffer The frame buffer to read from, or NULL for the one currently bound.
+     * @param x The left edge of the area, in pixels.
+     * @param y The bottom edge of the area, in pixels.
+     * @param width The width of the area.
+     * @param height The height of the area.
+     * @param callback The function called with the pixels.
+     * @param cookie The user data passed to the callback.
+     */
+    void read(FrameBuffer* frameBuffer, unsigned int x, unsigned int y, unsigned int width, unsigned int height,
+              ReadbackCallback callback, void* cookie);
+
+    /**
+     * Determines if reads complete asynchronously through pixel buffers.
+     *
+     * @return true if reads do not stall the frame, false if they read the pixels immediately.
+     */
+    bool isAsync() const;
+
+    /**
+     * Gets the number of reads whose callback has not been called yet.
+     *
+     * @return The number of pending reads.
+     */
+    unsigned int getPendingCount() const;
+
+private:
+
+    struct Readback
+    {
+        ReadbackCallback callback;
+        void* cookie;
+        unsigned int width;
+        unsigned int height;
+        unsigned int buffer;        // Pixel buffer the pixels are read into, or 0 if they were read immediately.
+        unsigned int size;          // Size of the pixel buffer.
+        void* fence;                // GLsync signaled once the read is complete.
+        unsigned char* pixels;      // Pixels read immediately, where pixel buffers are not available.
+    };
+
+    struct PixelBuffer
+    {
+        unsigned int buffer;
+        unsigned int size;
+    };
+
+    /**
+     * Constructor.
+     */
+    ReadbackQueue();
+
+    /**
+     * Destructor.
+     */
+    ~ReadbackQueue();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ReadbackQueue(const ReadbackQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ReadbackQueue& operator=(const ReadbackQueue&);
+
+    /**
+     * Called during startup to detect pixel buffer support.
+     *
+     * @param properties The 'readback' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to complete the pending reads and delete the pixel buffers.
+     */
+    void finalize();
+
+    /**
+     * Called at the start of each frame to hand back the completed reads.
+     */
+    void update();
+
+    /**
+     * Hands back the reads the GPU has completed, in order.
+     *
+     * @param wait true to wait for every read, false to stop at the first one that is not complete.
+     */
+    void completeReads(bool wait);
+
+    /**
+     * Takes an idle pixel buffer of at least the given size from the pool, or creates one.
+     */
+    PixelBuffer acquireBuffer(unsigned int size);
+
+    /**
+     * Returns a pixel buffer to the pool, or deletes it if the pool is full.
+     */
+    void releaseBuffer(const PixelBuffer& buffer);
+
+    bool _async;
+    unsigned int _poolSize;
+    std::vector<PixelBuffer> _pool;
+    std::list<Readback> _pending;
+};
+
+}
+
+#endif
@@ -10,6 +10,10 @@ void* trackRef(Ref* ref);
 void untrackRef(Ref* ref, void* record);
 #endif
 
+// Objects whose last reference was released on another thread, destroyed by destroyDeferred().
+static std::vector<Ref*> __deferredRefs;
+static Mutex __deferredRefsMutex;
+
 Ref::Ref() :
     _refCount(1)
 {
@@ -26,29 +30,82 @@ Ref::Ref(const Ref& copy) :
 #endif
 }
 
+Ref& Ref::operator=(const Ref& copy)
+{
+    return *this;
+}
+
 Ref::~Ref()
 {
 }
 
 void Ref::addRef()
 {
+#ifdef GAMEPLAY_ATOMIC_REF
+    _refCount.increment();
+#else
     ++_refCount;
+#endif
 }
 
 void Ref::release()
 {
+#ifdef GAMEPLAY_ATOMIC_REF
+    if (_refCount.decrement() <= 0)
+#else
     if ((--_refCount) <= 0)
-    {
-#ifdef GAMEPLAY_MEM_LEAK_DETECTION
-        untrackRef(this, __record);
 #endif
-        delete this;
+    {
+        if (Thread::isMainThread())
+        {
+            destroy();
+        }
+        else
+        {
+            MutexLock lock(__deferredRefsMutex);
+            __deferredRefs.push_back(this);
+        }
     }
 }
 
 unsigned int Ref::getRefCount() const
 {
+#ifdef GAMEPLAY_ATOMIC_REF
+    return (unsigned int)_refCount.get();
+#else
     return _refCount;
+#endif
+}
+
+void Ref::destroy()
+{
+#ifdef GAMEPLAY_MEM_LEAK_DETECTION
+    untrackRef(this, __record);
+#endif
+    delete this;
+}
+
+void Ref::destroyDeferred()
+{
+    GP_ASSERT(Thread::isMainThread());
+
+    std::vector<Ref*> refs;
+    while (true)
+    {
+        {
+            MutexLock lock(__deferredRefsMutex);
+            if (__deferredRefs.empty())
+                break;
+            refs.swap(__deferredRefs);
+        }
+
+        // Destructors may release further objects, which are destroyed right away on this thread.
+        for (size_t i = 0, count = refs.size(); i < count; ++i)
+        {
+            refs[i]->destroy();
+        }
+        refs.clear();
+    }
 }
 
 #ifdef GAMEPLAY_MEM_LEAK_DETECTION
@@ -62,6 +119,7 @@ struct RefAllocationRecord
 
 RefAllocationRecord* __refAllocations = 0;
 int __refAllocationCount = 0;
+static Mutex __refAllocationsMutex;
 
 void Ref::printLeaks()
 {
@@ -87,6 +145,8 @@ void* trackRef(Ref* ref)
 {
     GP_ASSERT(ref);
 
+    MutexLock lock(__refAllocationsMutex);
+
     // Create memory allocation record.
     RefAllocationRecord* rec = (RefAllocationRecord*)malloc(sizeof(RefAllocationRecord));
     rec->ref = ref;
@@ -109,6 +169,7 @@ void untrackRef(Ref* ref, void* record)
         return;
     }
 
+    MutexLock lock(__refAllocationsMutex);
     RefAllocationRecord* rec = (RefAllocationRecord*)record;
     if (rec->ref != ref)
     {
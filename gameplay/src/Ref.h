@@ -1,6 +1,14 @@
 #ifndef REF_H_
 #define REF_H_
 
+#include "Thread.h"
+
+// Reference counts are atomic unless the engine is built with GAMEPLAY_SINGLE_THREADED_REF,
+// for games that never share engine objects with other threads.
+#ifndef GAMEPLAY_SINGLE_THREADED_REF
+#define GAMEPLAY_ATOMIC_REF
+#endif
+
 namespace gameplay
 {
 
@@ -13,9 +21,18 @@ namespace gameplay
  * reference counting eliminates the need for programmers to manually
  * keep track of object ownership and having to worry about when to
  * safely delete such objects.
+ *
+ * References may be added and released from any thread. When the last
+ * reference to an object is released on a thread other than the main thread,
+ * for example by a job or an asynchronous load, the object is not destroyed
+ * on that thread: it is queued and destroyed on the main thread at the start
+ * of the next frame, so destructors may release GPU, audio and scene resources
+ * as usual.
  */
 class Ref
 {
+    friend class Game;
+
 public:
 
     /**
@@ -57,6 +74,17 @@ protected:
      */
     Ref(const Ref& copy);
 
+    /**
+     * Copy assignment operator.
+     *
+     * The reference count of this object is not changed.
+     *
+     * @param copy The Ref object to copy.
+     *
+     * @return This object.
+     */
+    Ref& operator=(const Ref& copy);
+
     /**
      * Destructor.
      */
@@ -64,11 +92,26 @@ protected:
 
 private:
 
+    /**
+     * Destroys the object once its last reference has been released.
+     */
+    void destroy();
+
+    /**
+     * Destroys the objects whose last reference was released on another thread.
+     *
+     * Called by the game on the main thread at the start of each frame and on shutdown.
+     */
+    static void destroyDeferred();
+
+#ifdef GAMEPLAY_ATOMIC_REF
+    AtomicInt _refCount;
+#else
     unsigned int _refCount;
+#endif
 
     // Memory leak diagnostic data (only included when GAMEPLAY_MEM_LEAK_DETECTION is defined)
 #ifdef GAMEPLAY_MEM_LEAK_DETECTION
-    friend class Game;
     static void printLeaks();
     void* __record;
 #endif
@@ -0,0 +1,923 @@
+#include "Base.h"
+#include "RenderCommandList.h"
+
+namespace gameplay
+{
+
+static RenderCommandList* __recording = NULL;
+std::map<GLuint, RenderCommandList::ReplayFramebuffer> RenderCommandList::_replayFramebuffers;
+
+RenderCommandList::RenderCommandList()
+{
+}
+
+RenderCommandList::~RenderCommandList()
+{
+}
+
+bool RenderCommandList::isRecording()
+{
+    return __recording != NULL;
+}
+
+void RenderCommandList::setRecording(RenderCommandList* list)
+{
+    __recording = list;
+}
+
+RenderCommandList::Command* RenderCommandList::record(Op op)
+{
+    if (__recording == NULL)
+        return NULL;
+
+    __recording->_commands.push_back(Command());
+    Command* command = &__recording->_commands.back();
+    command->op = op;
+    return command;
+}
+
+RenderCommandList::Command* RenderCommandList::record(Op op, const void* data, size_t size)
+{
+    Command* command = record(op);
+    if (command == NULL)
+        return NULL;
+
+    // Keep every copy 4-byte aligned, so that floats and integers can be read in place.
+    std::vector<unsigned char>& buffer = __recording->_data;
+    size_t offset = buffer.size();
+    buffer.resize(offset + ((size + 3) & ~(size_t)3));
+    if (data && size)
+        memcpy(&buffer[offset], data, size);
+    command->dataOffset = (unsigned int)offset;
+    command->dataSize = (unsigned int)size;
+    return command;
+}
+
+void RenderCommandList::useProgram(GLuint program)
+{
+    GL_ASSERT( glUseProgram(program) );
+    Command* command = record(USE_PROGRAM);
+    if (command)
+        command->args[0].u = program;
+}
+
+void RenderCommandList::activeTexture(unsigned int unit)
+{
+    GL_ASSERT( glActiveTexture(GL_TEXTURE0 + unit) );
+    Command* command = record(ACTIVE_TEXTURE);
+    if (command)
+        command->args[0].u = unit;
+}
+
+void RenderCommandList::bindTexture(GLenum target, GLuint texture)
+{
+    GL_ASSERT( glBindTexture(target, texture) );
+    Command* command = record(BIND_TEXTURE);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].u = texture;
+    }
+}
+
+#ifdef USE_SAMPLER_OBJECTS
+void RenderCommandList::bindSampler(GLuint unit, GLuint sampler)
+{
+    GL_ASSERT( glBindSampler(unit, sampler) );
+    Command* command = record(BIND_SAMPLER);
+    if (command)
+    {
+        command->args[0].u = unit;
+        command->args[1].u = sampler;
+    }
+}
+#endif
+
+void RenderCommandList::bindBuffer(GLenum target, GLuint buffer)
+{
+    GL_ASSERT( glBindBuffer(target, buffer) );
+    Command* command = record(BIND_BUFFER);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].u = buffer;
+    }
+}
+
+void RenderCommandList::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    Command* command = record(BIND_BUFFER_BASE);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].u = index;
+        command->args[2].u = buffer;
+        return;
+    }
+    GL_ASSERT( glBindBufferBase(target, index, buffer) );
+}
+
+void RenderCommandList::bindVertexArray(GLuint array)
+{
+    GP_ASSERT(array == 0 || __recording == NULL);
+    GL_ASSERT( glBindVertexArray(array) );
+}
+
+void RenderCommandList::bindFramebuffer(GLuint framebuffer, const GLuint* colorTextures, unsigned int colorCount, GLuint depthBuffer, GLuint stencilBuffer)
+{
+    if (__recording)
+    {
+        Command* command;
+        if (colorTextures)
+        {
+            // The replaying context builds its own frame buffer from the attachments.
+            std::vector<GLuint> attachments(colorTextures, colorTextures + colorCount);
+            attachments.push_back(depthBuffer);
+            attachments.push_back(stencilBuffer);
+            command = record(BIND_FRAMEBUFFER, &attachments[0], attachments.size() * sizeof(GLuint));
+        }
+        else
+        {
+            command = record(BIND_FRAMEBUFFER, NULL, 0);
+        }
+        command->args[0].u = framebuffer;
+        command->args[1].u = colorTextures ? colorCount : 0;
+        command->args[2].u = colorTextures ? 0 : 1;
+        return;
+    }
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, framebuffer) );
+}
+
+#ifdef USE_INVALIDATE_FRAMEBUFFER
+void RenderCommandList::invalidateFramebuffer(GLsizei count, const GLenum* attachments)
+{
+    GP_ASSERT(attachments);
+
+    Command* command = record(INVALIDATE_FRAMEBUFFER, attachments, count * sizeof(GLenum));
+    if (command)
+    {
+        command->args[0].i = count;
+        return;
+    }
+    GL_ASSERT( glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments) );
+}
+#endif
+
+void RenderCommandList::setEnabled(GLenum capability, bool enabled)
+{
+    Command* command = record(enabled ? ENABLE : DISABLE);
+    if (command)
+    {
+        command->args[0].u = capability;
+        return;
+    }
+    if (enabled)
+        GL_ASSERT( glEnable(capability) );
+    else
+        GL_ASSERT( glDisable(capability) );
+}
+
+void RenderCommandList::blendFunc(GLenum source, GLenum destination)
+{
+    Command* command = record(BLEND_FUNC);
+    if (command)
+    {
+        command->args[0].u = source;
+        command->args[1].u = destination;
+        return;
+    }
+    GL_ASSERT( glBlendFunc(source, destination) );
+}
+
+void RenderCommandList::cullFace(GLenum side)
+{
+    Command* command = record(CULL_FACE);
+    if (command)
+    {
+        command->args[0].u = side;
+        return;
+    }
+    GL_ASSERT( glCullFace(side) );
+}
+
+void RenderCommandList::depthFunc(GLenum function)
+{
+    Command* command = record(DEPTH_FUNC);
+    if (command)
+    {
+        command->args[0].u = function;
+        return;
+    }
+    GL_ASSERT( glDepthFunc(function) );
+}
+
+void RenderCommandList::depthMask(bool enabled)
+{
+    Command* command = record(DEPTH_MASK);
+    if (command)
+    {
+        command->args[0].u = enabled ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    GL_ASSERT( glDepthMask(enabled ? GL_TRUE : GL_FALSE) );
+}
+
+void RenderCommandList::colorMask(bool red, bool green, bool blue, bool alpha)
+{
+    Command* command = record(COLOR_MASK);
+    if (command)
+    {
+        command->args[0].u = red ? GL_TRUE : GL_FALSE;
+        command->args[1].u = green ? GL_TRUE : GL_FALSE;
+        command->args[2].u = blue ? GL_TRUE : GL_FALSE;
+        command->args[3].u = alpha ? GL_TRUE : GL_FALSE;
+        return;
+    }
+    GL_ASSERT( glColorMask(red ? GL_TRUE : GL_FALSE, green ? GL_TRUE : GL_FALSE, blue ? GL_TRUE : GL_FALSE, alpha ? GL_TRUE : GL_FALSE) );
+}
+
+void RenderCommandList::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    Command* command = record(SCISSOR);
+    if (command)
+    {
+        command->args[0].i = x;
+        command->args[1].i = y;
+        command->args[2].i = width;
+        command->args[3].i = height;
+        return;
+    }
+    GL_ASSERT( glScissor(x, y, width, height) );
+}
+
+void RenderCommandList::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    Command* command = record(VIEWPORT);
+    if (command)
+    {
+        command->args[0].i = x;
+        command->args[1].i = y;
+        command->args[2].i = width;
+        command->args[3].i = height;
+        return;
+    }
+    GL_ASSERT( glViewport(x, y, width, height) );
+}
+
+void RenderCommandList::clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    Command* command = record(CLEAR_COLOR);
+    if (command)
+    {
+        command->args[0].f = red;
+        command->args[1].f = green;
+        command->args[2].f = blue;
+        command->args[3].f = alpha;
+        return;
+    }
+    GL_ASSERT( glClearColor(red, green, blue, alpha) );
+}
+
+void RenderCommandList::clearDepth(GLfloat depth)
+{
+    Command* command = record(CLEAR_DEPTH);
+    if (command)
+    {
+        command->args[0].f = depth;
+        return;
+    }
+    GL_ASSERT( glClearDepth(depth) );
+}
+
+void RenderCommandList::clearStencil(GLint stencil)
+{
+    Command* command = record(CLEAR_STENCIL);
+    if (command)
+    {
+        command->args[0].i = stencil;
+        return;
+    }
+    GL_ASSERT( glClearStencil(stencil) );
+}
+
+void RenderCommandList::clear(GLbitfield mask)
+{
+    Command* command = record(CLEAR);
+    if (command)
+    {
+        command->args[0].u = mask;
+        return;
+    }
+    GL_ASSERT( glClear(mask) );
+}
+
+void RenderCommandList::stencilFunc(GLenum function, GLint reference, GLuint mask)
+{
+    Command* command = record(STENCIL_FUNC);
+    if (command)
+    {
+        command->args[0].u = function;
+        command->args[1].i = reference;
+        command->args[2].u = mask;
+        return;
+    }
+    GL_ASSERT( glStencilFunc(function, reference, mask) );
+}
+
+void RenderCommandList::stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass)
+{
+    Command* command = record(STENCIL_OP);
+    if (command)
+    {
+        command->args[0].u = fail;
+        command->args[1].u = depthFail;
+        command->args[2].u = depthPass;
+        return;
+    }
+    GL_ASSERT( glStencilOp(fail, depthFail, depthPass) );
+}
+
+void RenderCommandList::stencilMask(GLuint mask)
+{
+    Command* command = record(STENCIL_MASK);
+    if (command)
+    {
+        command->args[0].u = mask;
+        return;
+    }
+    GL_ASSERT( glStencilMask(mask) );
+}
+
+void RenderCommandList::uniform(GLint location, const GLfloat* values, GLsizei count, unsigned int components)
+{
+    GP_ASSERT(values);
+    GP_ASSERT((components >= 1 && components <= 4) || components == 16);
+
+    Command* command = record(UNIFORM_FLOAT, values, count * components * sizeof(GLfloat));
+    if (command)
+    {
+        command->args[0].i = location;
+        command->args[1].i = count;
+        command->args[2].u = components;
+        return;
+    }
+    switch (components)
+    {
+    case 1:
+        GL_ASSERT( glUniform1fv(location, count, values) );
+        break;
+    case 2:
+        GL_ASSERT( glUniform2fv(location, count, values) );
+        break;
+    case 3:
+        GL_ASSERT( glUniform3fv(location, count, values) );
+        break;
+    case 4:
+        GL_ASSERT( glUniform4fv(location, count, values) );
+        break;
+    default:
+        GL_ASSERT( glUniformMatrix4fv(location, count, GL_FALSE, values) );
+        break;
+    }
+}
+
+void RenderCommandList::uniform(GLint location, const GLint* values, GLsizei count)
+{
+    GP_ASSERT(values);
+
+    Command* command = record(UNIFORM_INT, values, count * sizeof(GLint));
+    if (command)
+    {
+        command->args[0].i = location;
+        command->args[1].i = count;
+        return;
+    }
+    GL_ASSERT( glUniform1iv(location, count, values) );
+}
+
+void RenderCommandList::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer)
+{
+    Command* command = record(VERTEX_ATTRIB_POINTER);
+    if (command)
+    {
+        command->args[0].u = index;
+        command->args[1].i = size;
+        command->args[2].u = type;
+        command->args[3].u = normalized;
+        command->args[4].i = stride;
+        command->args[5].u = (GLuint)(size_t)pointer;
+        return;
+    }
+    GL_ASSERT( glVertexAttribPointer(index, size, type, normalized, stride, pointer) );
+}
+
+void RenderCommandList::setVertexAttribArrayEnabled(GLuint index, bool enabled)
+{
+    Command* command = record(enabled ? ENABLE_VERTEX_ATTRIB_ARRAY : DISABLE_VERTEX_ATTRIB_ARRAY);
+    if (command)
+    {
+        command->args[0].u = index;
+        return;
+    }
+    if (enabled)
+        GL_ASSERT( glEnableVertexAttribArray(index) );
+    else
+        GL_ASSERT( glDisableVertexAttribArray(index) );
+}
+
+#ifdef USE_INSTANCED_ARRAYS
+void RenderCommandList::vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+    Command* command = record(VERTEX_ATTRIB_DIVISOR);
+    if (command)
+    {
+        command->args[0].u = index;
+        command->args[1].u = divisor;
+        return;
+    }
+    GL_ASSERT( glVertexAttribDivisor(index, divisor) );
+}
+#endif
+
+void RenderCommandList::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    Command* command = record(DRAW_ARRAYS);
+    if (command)
+    {
+        command->args[0].u = mode;
+        command->args[1].i = first;
+        command->args[2].i = count;
+        return;
+    }
+    GL_ASSERT( glDrawArrays(mode, first, count) );
+}
+
+void RenderCommandList::drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset)
+{
+    Command* command = record(DRAW_ELEMENTS);
+    if (command)
+    {
+        command->args[0].u = mode;
+        command->args[1].i = count;
+        command->args[2].u = type;
+        command->args[3].u = (GLuint)offset;
+        return;
+    }
+    GL_ASSERT( glDrawElements(mode, count, type, (const GLvoid*)offset) );
+}
+
+#ifdef USE_INSTANCED_ARRAYS
+void RenderCommandList::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount)
+{
+    Command* command = record(DRAW_ARRAYS_INSTANCED);
+    if (command)
+    {
+        command->args[0].u = mode;
+        command->args[1].i = first;
+        command->args[2].i = count;
+        command->args[3].i = instanceCount;
+        return;
+    }
+    GL_ASSERT( glDrawArraysInstanced(mode, first, count, instanceCount) );
+}
+
+void RenderCommandList::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, size_t offset, GLsizei instanceCount)
+{
+    Command* command = record(DRAW_ELEMENTS_INSTANCED);
+    if (command)
+    {
+        command->args[0].u = mode;
+        command->args[1].i = count;
+        command->args[2].u = type;
+        command->args[3].u = (GLuint)offset;
+        command->args[4].i = instanceCount;
+        return;
+    }
+    GL_ASSERT( glDrawElementsInstanced(mode, count, type, (const GLvoid*)offset, instanceCount) );
+}
+#endif
+
+#ifdef USE_TRANSFORM_FEEDBACK
+void RenderCommandList::beginTransformFeedback(GLenum mode)
+{
+    Command* command = record(BEGIN_TRANSFORM_FEEDBACK);
+    if (command)
+    {
+        command->args[0].u = mode;
+        return;
+    }
+    GL_ASSERT( glBeginTransformFeedback(mode) );
+}
+
+void RenderCommandList::endTransformFeedback()
+{
+    if (record(END_TRANSFORM_FEEDBACK))
+        return;
+    GL_ASSERT( glEndTransformFeedback() );
+}
+#endif
+
+#ifdef USE_DEBUG_MARKERS
+void RenderCommandList::pushDebugGroup(const char* name)
+{
+    GP_ASSERT(name);
+
+    // The copy keeps the terminating null, so the group is replayed with a length of -1.
+    if (record(PUSH_DEBUG_GROUP, name, strlen(name) + 1))
+        return;
+    GL_ASSERT( glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name) );
+}
+
+void RenderCommandList::popDebugGroup()
+{
+    if (record(POP_DEBUG_GROUP))
+        return;
+    GL_ASSERT( glPopDebugGroup() );
+}
+#endif
+
+void RenderCommandList::bufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+    Command* command = record(BUFFER_DATA, data, data ? size : 0);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].u = (GLuint)size;
+        command->args[2].u = usage;
+        return;
+    }
+    GL_ASSERT( glBufferData(target, size, data, usage) );
+}
+
+void RenderCommandList::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+    GP_ASSERT(data);
+
+    Command* command = record(BUFFER_SUB_DATA, data, size);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].u = (GLuint)offset;
+        return;
+    }
+    GL_ASSERT( glBufferSubData(target, offset, size, data) );
+}
+
+void RenderCommandList::texSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data, size_t size)
+{
+    GP_ASSERT(data);
+
+    Command* command = record(TEX_SUB_IMAGE_2D, data, size);
+    if (command)
+    {
+        command->args[0].u = target;
+        command->args[1].i = level;
+        command->args[2].i = x;
+        command->args[3].i = y;
+        command->args[4].i = width;
+        command->args[5].i = height;
+        command->args[6].u = format;
+        command->args[7].u = type;
+        return;
+    }
+    GL_ASSERT( glTexSubImage2D(target, level, x, y, width, height, format, type, data) );
+}
+
+void RenderCommandList::generateMipmap(GLenum target)
+{
+    Command* command = record(GENERATE_MIPMAP);
+    if (command)
+    {
+        command->args[0].u = target;
+        return;
+    }
+    GL_ASSERT( glGenerateMipmap(target) );
+}
+
+void RenderCommandList::deleteProgram(GLuint program)
+{
+    Command* command = record(DELETE_PROGRAM);
+    if (command)
+    {
+        command->args[0].u = program;
+        return;
+    }
+    GL_ASSERT( glDeleteProgram(program) );
+}
+
+void RenderCommandList::deleteTexture(GLuint texture)
+{
+    Command* command = record(DELETE_TEXTURE);
+    if (command)
+    {
+        command->args[0].u = texture;
+        return;
+    }
+    GL_ASSERT( glDeleteTextures(1, &texture) );
+}
+
+#ifdef USE_SAMPLER_OBJECTS
+void RenderCommandList::deleteSampler(GLuint sampler)
+{
+    Command* command = record(DELETE_SAMPLER);
+    if (command)
+    {
+        command->args[0].u = sampler;
+        return;
+    }
+    GL_ASSERT( glDeleteSamplers(1, &sampler) );
+}
+#endif
+
+void RenderCommandList::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+    if (__recording)
+    {
+        for (GLsizei i = 0; i < count; ++i)
+        {
+            Command* command = record(DELETE_BUFFER);
+            command->args[0].u = buffers[i];
+        }
+        return;
+    }
+    GL_ASSERT( glDeleteBuffers(count, buffers) );
+}
+
+void RenderCommandList::deleteFramebuffer(GLuint framebuffer)
+{
+    // Frame buffers are not shared, so the one of the game thread's context goes right away.
+    GL_ASSERT( glDeleteFramebuffers(1, &framebuffer) );
+    Command* command = record(DELETE_FRAMEBUFFER);
+    if (command)
+        command->args[0].u = framebuffer;
+}
+
+unsigned int RenderCommandList::getCommandCount() const
+{
+    return (unsigned int)_commands.size();
+}
+
+unsigned int RenderCommandList::getDataSize() const
+{
+    return (unsigned int)_data.size();
+}
+
+void RenderCommandList::reset()
+{
+    _commands.clear();
+    _data.clear();
+}
+
+void RenderCommandList::execute()
+{
+    const unsigned char* data = _data.empty() ? NULL : &_data[0];
+    for (std::vector<Command>::const_iterator itr = _commands.begin(); itr != _commands.end(); ++itr)
+    {
+        const Command& c = *itr;
+        const Arg* a = c.args;
+        const void* payload = c.dataSize ? data + c.dataOffset : NULL;
+        switch (c.op)
+        {
+        case USE_PROGRAM:
+            GL_ASSERT( glUseProgram(a[0].u) );
+            break;
+        case ACTIVE_TEXTURE:
+            GL_ASSERT( glActiveTexture(GL_TEXTURE0 + a[0].u) );
+            break;
+        case BIND_TEXTURE:
+            GL_ASSERT( glBindTexture(a[0].u, a[1].u) );
+            break;
+#ifdef USE_SAMPLER_OBJECTS
+        case BIND_SAMPLER:
+            GL_ASSERT( glBindSampler(a[0].u, a[1].u) );
+            break;
+#endif
+        case BIND_BUFFER:
+            GL_ASSERT( glBindBuffer(a[0].u, a[1].u) );
+            break;
+        case BIND_BUFFER_BASE:
+            GL_ASSERT( glBindBufferBase(a[0].u, a[1].u, a[2].u) );
+            break;
+        case BIND_FRAMEBUFFER:
+            bindReplayFramebuffer(c);
+            break;
+#ifdef USE_INVALIDATE_FRAMEBUFFER
+        case INVALIDATE_FRAMEBUFFER:
+            GL_ASSERT( glInvalidateFramebuffer(GL_FRAMEBUFFER, a[0].i, (const GLenum*)payload) );
+            break;
+#endif
+        case ENABLE:
+            GL_ASSERT( glEnable(a[0].u) );
+            break;
+        case DISABLE:
+            GL_ASSERT( glDisable(a[0].u) );
+            break;
+        case BLEND_FUNC:
+            GL_ASSERT( glBlendFunc(a[0].u, a[1].u) );
+            break;
+        case CULL_FACE:
+            GL_ASSERT( glCullFace(a[0].u) );
+            break;
+        case DEPTH_FUNC:
+            GL_ASSERT( glDepthFunc(a[0].u) );
+            break;
+        case DEPTH_MASK:
+            GL_ASSERT( glDepthMask((GLboolean)a[0].u) );
+            break;
+        case COLOR_MASK:
+            GL_ASSERT( glColorMask((GLboolean)a[0].u, (GLboolean)a[1].u, (GLboolean)a[2].u, (GLboolean)a[3].u) );
+            break;
+        case SCISSOR:
+            GL_ASSERT( glScissor(a[0].i, a[1].i, a[2].i, a[3].i) );
+            break;
+        case VIEWPORT:
+            GL_ASSERT( glViewport(a[0].i, a[1].i, a[2].i, a[3].i) );
+            break;
+        case CLEAR_COLOR:
+            GL_ASSERT( glClearColor(a[0].f, a[1].f, a[2].f, a[3].f) );
+            break;
+        case CLEAR_DEPTH:
+            GL_ASSERT( glClearDepth(a[0].f) );
+            break;
+        case CLEAR_STENCIL:
+            GL_ASSERT( glClearStencil(a[0].i) );
+            break;
+        case CLEAR:
+            GL_ASSERT( glClear(a[0].u) );
+            break;
+        case STENCIL_FUNC:
+            GL_ASSERT( glStencilFunc(a[0].u, a[1].i, a[2].u) );
+            break;
+        case STENCIL_OP:
+            GL_ASSERT( glStencilOp(a[0].u, a[1].u, a[2].u) );
+            break;
+        case STENCIL_MASK:
+            GL_ASSERT( glStencilMask(a[0].u) );
+            break;
+        case UNIFORM_FLOAT:
+            {
+                const GLfloat* values = (const GLfloat*)payload;
+                switch (a[2].u)
+                {
+                case 1:
+                    GL_ASSERT( glUniform1fv(a[0].i, a[1].i, values) );
+                    break;
+                case 2:
+                    GL_ASSERT( glUniform2fv(a[0].i, a[1].i, values) );
+                    break;
+                case 3:
+                    GL_ASSERT( glUniform3fv(a[0].i, a[1].i, values) );
+                    break;
+                case 4:
+                    GL_ASSERT( glUniform4fv(a[0].i, a[1].i, values) );
+                    break;
+                default:
+                    GL_ASSERT( glUniformMatrix4fv(a[0].i, a[1].i, GL_FALSE, values) );
+                    break;
+                }
+            }
+            break;
+        case UNIFORM_INT:
+            GL_ASSERT( glUniform1iv(a[0].i, a[1].i, (const GLint*)payload) );
+            break;
+        case VERTEX_ATTRIB_POINTER:
+            GL_ASSERT( glVertexAttribPointer(a[0].u, a[1].i, a[2].u, (GLboolean)a[3].u, a[4].i, (const GLvoid*)(size_t)a[5].u) );
+            break;
+        case ENABLE_VERTEX_ATTRIB_ARRAY:
+            GL_ASSERT( glEnableVertexAttribArray(a[0].u) );
+            break;
+        case DISABLE_VERTEX_ATTRIB_ARRAY:
+            GL_ASSERT( glDisableVertexAttribArray(a[0].u) );
+            break;
+#ifdef USE_INSTANCED_ARRAYS
+        case VERTEX_ATTRIB_DIVISOR:
+            GL_ASSERT( glVertexAttribDivisor(a[0].u, a[1].u) );
+            break;
+#endif
+        case DRAW_ARRAYS:
+            GL_ASSERT( glDrawArrays(a[0].u, a[1].i, a[2].i) );
+            break;
+        case DRAW_ELEMENTS:
+            GL_ASSERT( glDrawElements(a[0].u, a[1].i, a[2].u, (const GLvoid*)(size_t)a[3].u) );
+            break;
+#ifdef USE_INSTANCED_ARRAYS
+        case DRAW_ARRAYS_INSTANCED:
+            GL_ASSERT( glDrawArraysInstanced(a[0].u, a[1].i, a[2].i, a[3].i) );
+            break;
+        case DRAW_ELEMENTS_INSTANCED:
+            GL_ASSERT( glDrawElementsInstanced(a[0].u, a[1].i, a[2].u, (const GLvoid*)(size_t)a[3].u, a[4].i) );
+            break;
+#endif
+#ifdef USE_TRANSFORM_FEEDBACK
+        case BEGIN_TRANSFORM_FEEDBACK:
+            GL_ASSERT( glBeginTransformFeedback(a[0].u) );
+            break;
+        case END_TRANSFORM_FEEDBACK:
+            GL_ASSERT( glEndTransformFeedback() );
+            break;
+#endif
+#ifdef USE_DEBUG_MARKERS
+        case PUSH_DEBUG_GROUP:
+            GL_ASSERT( glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, (const GLchar*)payload) );
+            break;
+        case POP_DEBUG_GROUP:
+            GL_ASSERT( glPopDebugGroup() );
+            break;
+#endif
+        case BUFFER_DATA:
+            GL_ASSERT( glBufferData(a[0].u, a[1].u, payload, a[2].u) );
+            break;
+        case BUFFER_SUB_DATA:
+            GL_ASSERT( glBufferSubData(a[0].u, a[1].u, c.dataSize, payload) );
+            break;
+        case TEX_SUB_IMAGE_2D:
+            GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+            GL_ASSERT( glTexSubImage2D(a[0].u, a[1].i, a[2].i, a[3].i, a[4].i, a[5].i, a[6].u, a[7].u, payload) );
+            break;
+        case GENERATE_MIPMAP:
+            GL_ASSERT( glGenerateMipmap(a[0].u) );
+            break;
+        case DELETE_PROGRAM:
+            GL_ASSERT( glDeleteProgram(a[0].u) );
+            break;
+        case DELETE_TEXTURE:
+            GL_ASSERT( glDeleteTextures(1, &a[0].u) );
+            break;
+#ifdef USE_SAMPLER_OBJECTS
+        case DELETE_SAMPLER:
+            GL_ASSERT( glDeleteSamplers(1, &a[0].u) );
+            break;
+#endif
+        case DELETE_BUFFER:
+            GL_ASSERT( glDeleteBuffers(1, &a[0].u) );
+            break;
+        case DELETE_FRAMEBUFFER:
+            {
+                std::map<GLuint, ReplayFramebuffer>::iterator fb = _replayFramebuffers.find(a[0].u);
+                if (fb != _replayFramebuffers.end())
+                {
+                    GL_ASSERT( glDeleteFramebuffers(1, &fb->second.handle) );
+                    _replayFramebuffers.erase(fb);
+                }
+            }
+            break;
+        default:
+            GP_ERROR("Unsupported render command (%u).", c.op);
+            break;
+        }
+    }
+}
+
+void RenderCommandList::bindReplayFramebuffer(const Command& command)
+{
+    // The default frame buffer is the window of whichever context replays the list.
+    if (command.args[2].u)
+    {
+        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, 0) );
+        return;
+    }
+
+    const GLuint* attachments = (const GLuint*)(&_data[0] + command.dataOffset);
+    const unsigned int colorCount = command.args[1].u;
+    ReplayFramebuffer& fb = _replayFramebuffers[command.args[0].u];
+    if (fb.handle && fb.attachments.size() == colorCount + 2 && std::equal(fb.attachments.begin(), fb.attachments.end(), attachments))
+    {
+        GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, fb.handle) );
+        return;
+    }
+
+    // Build the frame buffer again whenever the targets of the recorded one changed.
+    if (fb.handle)
+    {
+        GL_ASSERT( glDeleteFramebuffers(1, &fb.handle) );
+    }
+    GL_ASSERT( glGenFramebuffers(1, &fb.handle) );
+    GL_ASSERT( glBindFramebuffer(GL_FRAMEBUFFER, fb.handle) );
+    for (unsigned int i = 0; i < colorCount; ++i)
+    {
+        if (attachments[i])
+        {
+            GL_ASSERT( glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, attachments[i], 0) );
+        }
+    }
+    if (attachments[colorCount])
+    {
+        GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, attachments[colorCount]) );
+    }
+    if (attachments[colorCount + 1])
+    {
+        GL_ASSERT( glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, attachments[colorCount + 1]) );
+    }
+    fb.attachments.assign(attachments, attachments + colorCount + 2);
+}
+
+void RenderCommandList::releaseReplayFramebuffers()
+{
+    for (std::map<GLuint, ReplayFramebuffer>::iterator itr = _replayFramebuffers.begin(); itr != _replayFramebuffers.end(); ++itr)
+    {
+        GL_ASSERT( glDeleteFramebuffers(1, &itr->second.handle) );
+    }
+    _replayFramebuffers.clear();
+}
+
+}
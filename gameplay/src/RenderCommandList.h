@@ -0,0 +1,618 @@
+#ifndef RENDERCOMMANDLIST_H_
+#define RENDERCOMMANDLIST_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a list of recorded GL commands, and the functions through which the engine
+ * submits the GL calls of a frame.
+ *
+ * The engine makes the GL calls that draw a frame through the static functions of this
+ * class rather than calling GL directly: the state changes that get past the StateCache,
+ * the uniforms set by Effect, the vertex attribute setup, the draw calls, the clears and
+ * frame buffer binds, and the updates of dynamic buffers and textures. Normally each
+ * function simply makes its GL call. While a list is recording (see RenderThread), the
+ * calls are appended to the list instead, with copies of their data, and the list is later
+ * replayed in the same order on the context of the render thread with execute().
+ *
+ * Object creation stays on the game thread: the GL objects of the two contexts are shared,
+ * and the binds that creation code relies on (programs, textures, samplers and buffers)
+ * are made on the game thread's context as well as recorded. Deletions of shared objects
+ * are recorded, so that their names are not reused before the frames that still draw with
+ * them have been replayed. Vertex arrays and frame buffers are not shared between contexts:
+ * vertex array objects are not created while a list is recording, and frame buffers are
+ * recorded with their attachments, from which the replaying context builds frame buffers of
+ * its own.
+ *
+ * Vertex data must come from buffer objects while a list is recording; client side vertex
+ * and index arrays cannot be recorded.
+ *
+ * @script{ignore}
+ */
+class RenderCommandList
+{
+    friend class RenderThread;
+
+public:
+
+    /**
+     * Determines if the GL calls of the game thread are being recorded.
+     *
+     * @return true if a list is recording, false if GL calls are made directly.
+     */
+    static bool isRecording();
+
+    /**
+     * Sets the current shader program, on the game thread's context and in the recording list.
+     *
+     * @param program The program, or 0 for none.
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * Sets the active texture unit, on the game thread's context and in the recording list.
+     *
+     * @param unit The index of the texture unit.
+     */
+    static void activeTexture(unsigned int unit);
+
+    /**
+     * Binds a texture to the active texture unit, on the game thread's context and in the recording list.
+     *
+     * @param target The texture target.
+     * @param texture The texture, or 0 for none.
+     */
+    static void bindTexture(GLenum target, GLuint texture);
+
+#ifdef USE_SAMPLER_OBJECTS
+    /**
+     * Binds a sampler object to a texture unit, on the game thread's context and in the recording list.
+     *
+     * @param unit The index of the texture unit.
+     * @param sampler The sampler object, or 0 for none.
+     */
+    static void bindSampler(GLuint unit, GLuint sampler);
+#endif
+
+    /**
+     * Binds a buffer, on the game thread's context and in the recording list.
+     *
+     * @param target The buffer target.
+     * @param buffer The buffer, or 0 for none.
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Binds a buffer to an indexed binding point.
+     *
+     * @param target The buffer target.
+     * @param index The index of the binding point.
+     * @param buffer The buffer, or 0 for none.
+     */
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    /**
+     * Binds a vertex array object.
+     *
+     * Vertex arrays are not shared between contexts, so they are never bound while a list is recording.
+     *
+     * @param array The vertex array, or 0 for none.
+     */
+    static void bindVertexArray(GLuint array);
+
+    /**
+     * Binds a frame buffer.
+     *
+     * @param framebuffer The frame buffer.
+     * @param colorTextures The textures attached to the color attachments, in order, or NULL for the default frame buffer.
+     * @param colorCount The number of color attachments.
+     * @param depthBuffer The render buffer attached to the depth attachment, or 0.
+     * @param stencilBuffer The render buffer attached to the stencil attachment, or 0.
+     */
+    static void bindFramebuffer(GLuint framebuffer, const GLuint* colorTextures, unsigned int colorCount, GLuint depthBuffer, GLuint stencilBuffer);
+
+#ifdef USE_INVALIDATE_FRAMEBUFFER
+    /**
+     * Discards the contents of attachments of the bound frame buffer.
+     *
+     * @param count The number of attachments.
+     * @param attachments The attachments.
+     */
+    static void invalidateFramebuffer(GLsizei count, const GLenum* attachments);
+#endif
+
+    /**
+     * Enables or disables a GL capability.
+     *
+     * @param capability The capability.
+     * @param enabled true to enable the capability, false to disable it.
+     */
+    static void setEnabled(GLenum capability, bool enabled);
+
+    /**
+     * Sets the blend function.
+     *
+     * @param source The source factor.
+     * @param destination The destination factor.
+     */
+    static void blendFunc(GLenum source, GLenum destination);
+
+    /**
+     * Sets the face culled when face culling is enabled.
+     *
+     * @param side The side to cull.
+     */
+    static void cullFace(GLenum side);
+
+    /**
+     * Sets the depth comparison function.
+     *
+     * @param function The depth function.
+     */
+    static void depthFunc(GLenum function);
+
+    /**
+     * Enables or disables writing to the depth buffer.
+     *
+     * @param enabled true to write depth, false otherwise.
+     */
+    static void depthMask(bool enabled);
+
+    /**
+     * Enables or disables writing to the color channels of the frame buffer.
+     *
+     * @param red true to write the red channel.
+     * @param green true to write the green channel.
+     * @param blue true to write the blue channel.
+     * @param alpha true to write the alpha channel.
+     */
+    static void colorMask(bool red, bool green, bool blue, bool alpha);
+
+    /**
+     * Sets the scissor rectangle.
+     *
+     * @param x The left of the rectangle, in pixels.
+     * @param y The bottom of the rectangle, in pixels.
+     * @param width The width of the rectangle.
+     * @param height The height of the rectangle.
+     */
+    static void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Sets the viewport rectangle.
+     *
+     * @param x The left of the rectangle, in pixels.
+     * @param y The bottom of the rectangle, in pixels.
+     * @param width The width of the rectangle.
+     * @param height The height of the rectangle.
+     */
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Sets the value the color buffer is cleared to.
+     *
+     * @param red The red value.
+     * @param green The green value.
+     * @param blue The blue value.
+     * @param alpha The alpha value.
+     */
+    static void clearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+
+    /**
+     * Sets the value the depth buffer is cleared to.
+     *
+     * @param depth The depth value.
+     */
+    static void clearDepth(GLfloat depth);
+
+    /**
+     * Sets the value the stencil buffer is cleared to.
+     *
+     * @param stencil The stencil value.
+     */
+    static void clearStencil(GLint stencil);
+
+    /**
+     * Clears buffers of the bound frame buffer.
+     *
+     * @param mask The buffers to clear.
+     */
+    static void clear(GLbitfield mask);
+
+    /**
+     * Sets the stencil test function.
+     *
+     * @param function The stencil function.
+     * @param reference The reference value.
+     * @param mask The mask applied to the reference and stored values.
+     */
+    static void stencilFunc(GLenum function, GLint reference, GLuint mask);
+
+    /**
+     * Sets the stencil test actions.
+     *
+     * @param fail The action when the stencil test fails.
+     * @param depthFail The action when the depth test fails.
+     * @param depthPass The action when both tests pass.
+     */
+    static void stencilOp(GLenum fail, GLenum depthFail, GLenum depthPass);
+
+    /**
+     * Sets the bits of the stencil buffer that can be written.
+     *
+     * @param mask The write mask.
+     */
+    static void stencilMask(GLuint mask);
+
+    /**
+     * Sets float uniforms of the current program.
+     *
+     * @param location The location of the uniform.
+     * @param values The values, count times components of them.
+     * @param count The number of array elements.
+     * @param components The number of floats per element: 1 to 4, or 16 for a 4x4 matrix.
+     */
+    static void uniform(GLint location, const GLfloat* values, GLsizei count, unsigned int components);
+
+    /**
+     * Sets integer uniforms of the current program.
+     *
+     * @param location The location of the uniform.
+     * @param values The values.
+     * @param count The number of array elements.
+     */
+    static void uniform(GLint location, const GLint* values, GLsizei count);
+
+    /**
+     * Sets the layout of a vertex attribute in the bound array buffer.
+     *
+     * @param index The index of the attribute.
+     * @param size The number of components.
+     * @param type The type of the components.
+     * @param normalized GL_TRUE to normalize integer components.
+     * @param stride The distance between vertices, in bytes.
+     * @param pointer The offset of the attribute in the buffer.
+     */
+    static void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid* pointer);
+
+    /**
+     * Enables or disables a vertex attribute array.
+     *
+     * @param index The index of the attribute.
+     * @param enabled true to enable the array, false to disable it.
+     */
+    static void setVertexAttribArrayEnabled(GLuint index, bool enabled);
+
+#ifdef USE_INSTANCED_ARRAYS
+    /**
+     * Sets the number of instances each element of a vertex attribute array is used for.
+     *
+     * @param index The index of the attribute.
+     * @param divisor The divisor, or 0 to advance per vertex.
+     */
+    static void vertexAttribDivisor(GLuint index, GLuint divisor);
+#endif
+
+    /**
+     * Draws primitives from the enabled vertex attribute arrays.
+     *
+     * @param mode The primitive type.
+     * @param first The first vertex.
+     * @param count The number of vertices.
+     */
+    static void drawArrays(GLenum mode, GLint first, GLsizei count);
+
+    /**
+     * Draws indexed primitives from the bound element array buffer.
+     *
+     * @param mode The primitive type.
+     * @param count The number of indices.
+     * @param type The type of the indices.
+     * @param offset The offset of the first index in the buffer, in bytes.
+     */
+    static void drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset);
+
+#ifdef USE_INSTANCED_ARRAYS
+    /**
+     * Draws instances of primitives from the enabled vertex attribute arrays.
+     *
+     * @param mode The primitive type.
+     * @param first The first vertex.
+     * @param count The number of vertices.
+     * @param instanceCount The number of instances.
+     */
+    static void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+
+    /**
+     * Draws instances of indexed primitives from the bound element array buffer.
+     *
+     * @param mode The primitive type.
+     * @param count The number of indices.
+     * @param type The type of the indices.
+     * @param offset The offset of the first index in the buffer, in bytes.
+     * @param instanceCount The number of instances.
+     */
+    static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, size_t offset, GLsizei instanceCount);
+#endif
+
+#ifdef USE_TRANSFORM_FEEDBACK
+    /**
+     * Starts capturing the vertices of the following draws into the transform feedback buffer.
+     *
+     * @param mode The primitive type of the draws.
+     */
+    static void beginTransformFeedback(GLenum mode);
+
+    /**
+     * Stops capturing vertices into the transform feedback buffer.
+     */
+    static void endTransformFeedback();
+#endif
+
+#ifdef USE_DEBUG_MARKERS
+    /**
+     * Opens a debug group that frame debuggers show around the following calls.
+     *
+     * @param name The name of the group.
+     */
+    static void pushDebugGroup(const char* name);
+
+    /**
+     * Closes the last debug group opened.
+     */
+    static void popDebugGroup();
+#endif
+
+    /**
+     * Replaces the storage of the buffer bound to a target.
+     *
+     * @param target The buffer target.
+     * @param size The size of the storage, in bytes.
+     * @param data The data to copy into the storage, or NULL.
+     * @param usage The usage hint.
+     */
+    static void bufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+
+    /**
+     * Writes a range of the buffer bound to a target.
+     *
+     * @param target The buffer target.
+     * @param offset The offset of the range, in bytes.
+     * @param size The size of the range, in bytes.
+     * @param data The data.
+     */
+    static void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data);
+
+    /**
+     * Writes a rectangle of the texture bound to the active unit.
+     *
+     * Recorded rows are tightly packed, as with an unpack alignment of 1.
+     *
+     * @param target The texture target.
+     * @param level The mip level.
+     * @param x The left of the rectangle.
+     * @param y The bottom of the rectangle.
+     * @param width The width of the rectangle.
+     * @param height The height of the rectangle.
+     * @param format The format of the data.
+     * @param type The type of the data.
+     * @param data The data.
+     * @param size The size of the data, in bytes.
+     */
+    static void texSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data, size_t size);
+
+    /**
+     * Generates the mip levels of the texture bound to the active unit.
+     *
+     * @param target The texture target.
+     */
+    static void generateMipmap(GLenum target);
+
+    /**
+     * Deletes a shader program.
+     *
+     * @param program The program.
+     */
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Deletes a texture.
+     *
+     * @param texture The texture.
+     */
+    static void deleteTexture(GLuint texture);
+
+#ifdef USE_SAMPLER_OBJECTS
+    /**
+     * Deletes a sampler object.
+     *
+     * @param sampler The sampler object.
+     */
+    static void deleteSampler(GLuint sampler);
+#endif
+
+    /**
+     * Deletes buffers.
+     *
+     * @param count The number of buffers.
+     * @param buffers The buffers.
+     */
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+    /**
+     * Deletes a frame buffer, along with the frame buffer built for it by the replaying context.
+     *
+     * @param framebuffer The frame buffer.
+     */
+    static void deleteFramebuffer(GLuint framebuffer);
+
+    /**
+     * Gets the number of commands in the list.
+     *
+     * @return The number of commands.
+     */
+    unsigned int getCommandCount() const;
+
+    /**
+     * Gets the number of bytes of data copied into the list.
+     *
+     * @return The size of the data, in bytes.
+     */
+    unsigned int getDataSize() const;
+
+private:
+
+    /**
+     * The recorded GL calls.
+     */
+    enum Op
+    {
+        USE_PROGRAM,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        BIND_SAMPLER,
+        BIND_BUFFER,
+        BIND_BUFFER_BASE,
+        BIND_FRAMEBUFFER,
+        INVALIDATE_FRAMEBUFFER,
+        ENABLE,
+        DISABLE,
+        BLEND_FUNC,
+        CULL_FACE,
+        DEPTH_FUNC,
+        DEPTH_MASK,
+        COLOR_MASK,
+        SCISSOR,
+        VIEWPORT,
+        CLEAR_COLOR,
+        CLEAR_DEPTH,
+        CLEAR_STENCIL,
+        CLEAR,
+        STENCIL_FUNC,
+        STENCIL_OP,
+        STENCIL_MASK,
+        UNIFORM_FLOAT,
+        UNIFORM_INT,
+        VERTEX_ATTRIB_POINTER,
+        ENABLE_VERTEX_ATTRIB_ARRAY,
+        DISABLE_VERTEX_ATTRIB_ARRAY,
+        VERTEX_ATTRIB_DIVISOR,
+        DRAW_ARRAYS,
+        DRAW_ELEMENTS,
+        DRAW_ARRAYS_INSTANCED,
+        DRAW_ELEMENTS_INSTANCED,
+        BEGIN_TRANSFORM_FEEDBACK,
+        END_TRANSFORM_FEEDBACK,
+        PUSH_DEBUG_GROUP,
+        POP_DEBUG_GROUP,
+        BUFFER_DATA,
+        BUFFER_SUB_DATA,
+        TEX_SUB_IMAGE_2D,
+        GENERATE_MIPMAP,
+        DELETE_PROGRAM,
+        DELETE_TEXTURE,
+        DELETE_SAMPLER,
+        DELETE_BUFFER,
+        DELETE_FRAMEBUFFER
+    };
+
+    /**
+     * An argument of a recorded call.
+     */
+    union Arg
+    {
+        GLuint u;
+        GLint i;
+        GLfloat f;
+    };
+
+    /**
+     * A recorded call. Calls with data refer to a copy of it in _data.
+     */
+    struct Command
+    {
+        unsigned int op;
+        Arg args[8];
+        unsigned int dataOffset;
+        unsigned int dataSize;
+    };
+
+    /**
+     * A frame buffer built by the replaying context for a frame buffer of the game thread.
+     */
+    struct ReplayFramebuffer
+    {
+        GLuint handle;
+        std::vector<GLuint> attachments;
+    };
+
+    /**
+     * Constructor.
+     */
+    RenderCommandList();
+
+    /**
+     * Destructor.
+     */
+    ~RenderCommandList();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderCommandList(const RenderCommandList& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderCommandList& operator=(const RenderCommandList&);
+
+    /**
+     * Sets the list that the GL calls of the main thread are recorded into.
+     *
+     * @param list The list, or NULL to make GL calls directly.
+     */
+    static void setRecording(RenderCommandList* list);
+
+    /**
+     * Appends a command to the list being recorded.
+     *
+     * @return The new command, or NULL if no list is recording.
+     */
+    static Command* record(Op op);
+
+    /**
+     * Appends a command with a copy of some data to the list being recorded.
+     *
+     * @return The new command, or NULL if no list is recording.
+     */
+    static Command* record(Op op, const void* data, size_t size);
+
+    /**
+     * Removes every command from the list, keeping its memory for the next frame.
+     */
+    void reset();
+
+    /**
+     * Makes the GL calls of the list, in order, on the current context.
+     */
+    void execute();
+
+    /**
+     * Binds the frame buffer the replaying context built for a recorded frame buffer bind.
+     */
+    void bindReplayFramebuffer(const Command& command);
+
+    /**
+     * Deletes the frame buffers built by the replaying context. Called with that context current.
+     */
+    static void releaseReplayFramebuffers();
+
+    std::vector<Command> _commands;
+    std::vector<unsigned char> _data;
+    static std::map<GLuint, ReplayFramebuffer> _replayFramebuffers;
+};
+
+}
+
+#endif
@@ -0,0 +1,478 @@
+#include "Base.h"
+#include "RenderQueue.h"
+#include "Camera.h"
+#include "Node.h"
+#include "Scene.h"
+#include "Game.h"
+#include "Technique.h"
+#include "Pass.h"
+#include "OcclusionCuller.h"
+#include "OcclusionBuffer.h"
+#include "MeshSkin.h"
+#include "StateCache.h"
+#include "DebugMarkers.h"
+
+// Bit layout of the 64-bit sort keys.
+#define KEY_TRANSPARENT_BIT     63
+#define KEY_EFFECT_BITS         16
+#define KEY_TEXTURE_BITS        16
+#define KEY_STATE_BITS          12
+#define KEY_OPAQUE_DEPTH_BITS   19
+#define KEY_BLEND_DEPTH_BITS    24
+
+// Shaders of the depth pre-pass.
+#define DEPTH_PRE_PASS_VSH "res/shaders/depth-prepass.vert"
+#define DEPTH_PRE_PASS_FSH "res/shaders/depth-prepass.frag"
+
+namespace gameplay
+{
+
+static unsigned long long hashPointer(const void* pointer, unsigned int bits)
+{
+    size_t value = (size_t)pointer;
+    value ^= value >> 16;
+    value *= 0x45d9f3b;
+    value ^= value >> 16;
+    return (unsigned long long)(value & ((1u << bits) - 1));
+}
+
+static unsigned long long quantizeDepth(float depth, unsigned int bits)
+{
+    // Depth is normalized to [0, 1], where 0 is the near plane.
+    unsigned int max = (1u << bits) - 1;
+    return (unsigned long long)(MATH_CLAMP(depth, 0.0f, 1.0f) * max);
+}
+
+const void* RenderQueue::findPrimaryTexture(RenderState* renderState)
+{
+    // The first sampler found from the pass upwards is used to group items.
+    for (RenderState* rs = renderState; rs; rs = rs->_parent)
+    {
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        {
+            Texture::Sampler* sampler = rs->_parameters[i]->getSampler();
+            if (sampler && sampler->getTexture())
+                return sampler->getTexture();
+        }
+    }
+    return NULL;
+}
+
+RenderQueue::RenderQueue()
+    : _camera(NULL), _occlusionCuller(NULL), _occlusionBuffer(NULL), _depthPrePass(false)
+{
+    memset(&_statistics, 0, sizeof(_statistics));
+}
+
+RenderQueue::~RenderQueue()
+{
+    clearViews();
+    for (std::map<unsigned int, Material*>::iterator itr = _depthMaterials.begin(); itr != _depthMaterials.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    SAFE_RELEASE(_occlusionBuffer);
+    SAFE_RELEASE(_occlusionCuller);
+    SAFE_RELEASE(_camera);
+}
+
+RenderQueue* RenderQueue::create(unsigned int initialCapacity)
+{
+    RenderQueue* queue = new RenderQueue();
+    queue->_items.reserve(initialCapacity);
+    return queue;
+}
+
+void RenderQueue::begin(Camera* camera)
+{
+    _items.clear();
+    _depthItems.clear();
+    clearViews();
+    setCamera(camera);
+
+    if (_occlusionCuller)
+    {
+        _occlusionCuller->begin(camera);
+    }
+
+    if (_occlusionBuffer)
+    {
+        _occlusionBuffer->rasterize(camera);
+    }
+}
+
+void RenderQueue::begin(Camera* const* cameras, const Rectangle* viewports, unsigned int viewCount)
+{
+    GP_ASSERT(viewCount == 0 || (cameras && viewports));
+
+    begin(viewCount > 0 ? cameras[0] : NULL);
+
+    for (unsigned int i = 0; i < viewCount; ++i)
+    {
+        GP_ASSERT(cameras[i]);
+        View view;
+        view.camera = cameras[i];
+        view.camera->addRef();
+        view.viewport = viewports[i];
+        _views.push_back(view);
+    }
+}
+
+void RenderQueue::setCamera(Camera* camera)
+{
+    if (camera != _camera)
+    {
+        SAFE_RELEASE(_camera);
+        _camera = camera;
+        if (_camera)
+        {
+            _camera->addRef();
+        }
+    }
+}
+
+void RenderQueue::clearViews()
+{
+    for (size_t i = 0, count = _views.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_views[i].camera);
+    }
+    _views.clear();
+}
+
+bool RenderQueue::isVisible(Node* node) const
+{
+    GP_ASSERT(node);
+
+    const BoundingSphere& sphere = node->getBoundingSphere();
+    if (_views.empty())
+        return _camera == NULL || _camera->getFrustumPlanes().intersects(sphere);
+
+    for (size_t i = 0, count = _views.size(); i < count; ++i)
+    {
+        if (_views[i].camera->getFrustumPlanes().intersects(sphere))
+            return true;
+    }
+    return false;
+}
+
+void RenderQueue::setOcclusionCuller(OcclusionCuller* culler)
+{
+    if (culler != _occlusionCuller)
+    {
+        SAFE_RELEASE(_occlusionCuller);
+        _occlusionCuller = culler;
+        if (_occlusionCuller)
+        {
+            _occlusionCuller->addRef();
+        }
+    }
+}
+
+void RenderQueue::setOcclusionBuffer(OcclusionBuffer* buffer)
+{
+    if (buffer != _occlusionBuffer)
+    {
+        SAFE_RELEASE(_occlusionBuffer);
+        _occlusionBuffer = buffer;
+        if (_occlusionBuffer)
+        {
+            _occlusionBuffer->addRef();
+        }
+    }
+}
+
+void RenderQueue::setDepthPrePassEnabled(bool enabled)
+{
+    _depthPrePass = enabled;
+}
+
+bool RenderQueue::isDepthPrePassEnabled() const
+{
+    return _depthPrePass;
+}
+
+Material* RenderQueue::getDepthMaterial(Model* model, int culledSide)
+{
+    MeshSkin* skin = model->getSkin();
+    unsigned int jointCount = skin ? skin->getJointCount() : 0;
+    unsigned int side = culledSide == RenderState::CULL_FACE_SIDE_BACK ? 1 : culledSide == RenderState::CULL_FACE_SIDE_FRONT ? 2 : culledSide ? 3 : 0;
+    unsigned int key = (jointCount << 2) | side;
+    std::map<unsigned int, Material*>::const_iterator itr = _depthMaterials.find(key);
+    if (itr != _depthMaterials.end())
+        return itr->second;
+
+    std::ostringstream defines;
+    if (jointCount > 0)
+        defines << "SKINNING;SKINNING_JOINT_COUNT " << jointCount;
+    std::string definesString = defines.str();
+
+    // A failed material is kept as NULL so that it is not created again for every item.
+    Material* material = Material::create(DEPTH_PRE_PASS_VSH, DEPTH_PRE_PASS_FSH, definesString.empty() ? NULL : definesString.c_str());
+    _depthMaterials[key] = material;
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create the depth material with defines '%s'.", definesString.c_str());
+        return NULL;
+    }
+
+    // Faces are culled as in the main pass, so that the depth written is the depth it draws.
+    RenderState::StateBlock* state = material->getStateBlock();
+    state->setDepthTest(true);
+    state->setDepthWrite(true);
+    if (culledSide)
+    {
+        state->setCullFace(true);
+        state->setCullFaceSide((RenderState::CullFaceSide)culledSide);
+    }
+    material->setParameterAutoBinding("u_worldViewProjectionMatrix", RenderState::WORLD_VIEW_PROJECTION_MATRIX);
+    if (jointCount > 0)
+    {
+        material->setParameterAutoBinding("u_matrixPalette", RenderState::MATRIX_PALETTE);
+    }
+    return material;
+}
+
+void RenderQueue::add(Node* node)
+{
+    GP_ASSERT(node);
+
+    Model* model = node->getModel();
+    if (model && (!_occlusionBuffer || _occlusionBuffer->isVisible(node)) && (!_occlusionCuller || _occlusionCuller->test(node)))
+    {
+        add(model);
+    }
+}
+
+void RenderQueue::add(Model* model)
+{
+    GP_ASSERT(model);
+    GP_ASSERT(model->getMesh());
+
+    model->updateMeshLod();
+
+    // Normalized view depth of the model origin.
+    float depth = 0.0f;
+    Node* node = model->getNode();
+    if (_camera && node)
+    {
+        const Matrix& view = _camera->getViewMatrix();
+        Vector3 position = node->getTranslationWorld();
+        float viewZ = view.m[2] * position.x + view.m[6] * position.y + view.m[10] * position.z + view.m[14];
+        float range = _camera->getFarPlane() - _camera->getNearPlane();
+        depth = range > 0.0f ? (-viewZ - _camera->getNearPlane()) / range : 0.0f;
+    }
+
+    unsigned int partCount = model->getMesh()->getPartCount();
+    if (partCount == 0)
+    {
+        if (model->_material)
+        {
+            add(model, -1, model->_material, depth);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < partCount; ++i)
+        {
+            Material* material = model->getMaterial(i);
+            if (material)
+            {
+                add(model, i, material, depth);
+            }
+        }
+    }
+}
+
+void RenderQueue::add(Model* model, int partIndex, Material* material, float depth)
+{
+    // The key groups the item by the effect of the technique selected for its distance.
+    Technique* technique = model->getLodTechnique(material);
+    GP_ASSERT(technique);
+
+    // Multi-pass techniques must draw their passes in order, so all passes share
+    // the key of the first pass and keep their relative order in the stable sort.
+    unsigned long long key = 0;
+    unsigned int passCount = technique->getPassCount();
+    for (unsigned int i = 0; i < passCount; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+
+        bool transparent;
+        bool depthWritten;
+        int culledSide;
+        unsigned int stateKey = pass->getStateKey(&transparent, &depthWritten, &culledSide);
+        const void* texture = findPrimaryTexture(pass);
+
+        if (i == 0)
+        {
+            unsigned long long effectKey = hashPointer(pass->getEffect(), KEY_EFFECT_BITS);
+            unsigned long long textureKey = hashPointer(texture, KEY_TEXTURE_BITS);
+            if (transparent)
+            {
+                unsigned long long depthKey = ((1ull << KEY_BLEND_DEPTH_BITS) - 1) - quantizeDepth(depth, KEY_BLEND_DEPTH_BITS);
+                key = (1ull << KEY_TRANSPARENT_BIT) |
+                      (depthKey << (KEY_TRANSPARENT_BIT - KEY_BLEND_DEPTH_BITS)) |
+                      (effectKey << (KEY_TRANSPARENT_BIT - KEY_BLEND_DEPTH_BITS - KEY_EFFECT_BITS)) |
+                      (textureKey << (KEY_TRANSPARENT_BIT - KEY_BLEND_DEPTH_BITS - KEY_EFFECT_BITS - KEY_TEXTURE_BITS));
+            }
+            else
+            {
+                key = (effectKey << (KEY_TRANSPARENT_BIT - KEY_EFFECT_BITS)) |
+                      (textureKey << (KEY_TRANSPARENT_BIT - KEY_EFFECT_BITS - KEY_TEXTURE_BITS)) |
+                      ((unsigned long long)(stateKey & ((1u << KEY_STATE_BITS) - 1)) << KEY_OPAQUE_DEPTH_BITS) |
+                      quantizeDepth(depth, KEY_OPAQUE_DEPTH_BITS);
+            }
+        }
+
+        Item item;
+        item.key = key;
+        item.model = model;
+        item.partIndex = partIndex;
+        item.pass = pass;
+        item.texture = texture;
+        item.state = stateKey;
+        item.depth = depth;
+        item.depthMaterial = NULL;
+        if (_depthPrePass && passCount == 1 && !transparent && depthWritten && material->isDepthPrePassEnabled())
+        {
+            item.depthMaterial = getDepthMaterial(model, culledSide);
+        }
+        _items.push_back(item);
+    }
+}
+
+bool RenderQueue::compareItems(const Item& a, const Item& b)
+{
+    return a.key < b.key;
+}
+
+void RenderQueue::end()
+{
+    std::stable_sort(_items.begin(), _items.end(), compareItems);
+
+    // The pre-pass draws strictly front-to-back, regardless of the state of the items.
+    _depthItems.clear();
+    for (size_t i = 0, count = _items.size(); i < count; ++i)
+    {
+        if (_items[i].depthMaterial)
+            _depthItems.push_back(std::make_pair(_items[i].depth, (unsigned int)i));
+    }
+    std::sort(_depthItems.begin(), _depthItems.end());
+}
+
+void RenderQueue::draw(bool wireframe)
+{
+    DebugMarkers::Group marker("RenderQueue");
+    memset(&_statistics, 0, sizeof(_statistics));
+
+    if (_views.empty())
+    {
+        drawItems(wireframe);
+
+        // Query the occluded nodes against the depth of the visible ones.
+        if (_occlusionCuller)
+        {
+            _occlusionCuller->end();
+        }
+    }
+    else
+    {
+        // Replay the sorted items for each view, with the view's camera standing in for the
+        // active camera of its scene so that nodes bind the view's matrices.
+        Game* game = Game::getInstance();
+        Rectangle viewport = game->getViewport();
+        for (size_t i = 0, count = _views.size(); i < count; ++i)
+        {
+            const View& view = _views[i];
+            Scene* scene = view.camera->getNode() ? view.camera->getNode()->getScene() : NULL;
+            game->setViewport(view.viewport);
+            if (scene)
+                scene->_viewCamera = view.camera;
+
+            drawItems(wireframe);
+
+            // The occlusion culler tests the nodes from the first view, so it queries them in its viewport.
+            if (i == 0 && _occlusionCuller)
+            {
+                _occlusionCuller->end();
+            }
+
+            if (scene)
+                scene->_viewCamera = NULL;
+        }
+        game->setViewport(viewport);
+    }
+}
+
+void RenderQueue::drawItems(bool wireframe)
+{
+    bool depthPrePass = !wireframe && !_depthItems.empty();
+    if (depthPrePass)
+    {
+        StateCache::setColorMask(false, false, false, false);
+        for (size_t i = 0, count = _depthItems.size(); i < count; ++i)
+        {
+            const Item& item = _items[_depthItems[i].second];
+            item.model->drawPart(item.partIndex, item.depthMaterial->getTechnique()->getPassByIndex(0), false);
+            ++_statistics.drawCalls;
+            ++_statistics.depthPrePassDrawCalls;
+        }
+        StateCache::setColorMask(true, true, true, true);
+    }
+
+    const Item* previous = NULL;
+    for (size_t i = 0, count = _items.size(); i < count; ++i)
+    {
+        const Item& item = _items[i];
+
+        if (previous && previous->pass->getEffect() == item.pass->getEffect())
+            ++_statistics.effectChangesSaved;
+        else
+            ++_statistics.effectChanges;
+
+        if (previous && previous->texture == item.texture)
+            ++_statistics.textureChangesSaved;
+        else
+            ++_statistics.textureChanges;
+
+        if (previous && previous->state == item.state)
+            ++_statistics.stateChangesSaved;
+        else
+            ++_statistics.stateChanges;
+
+        drawPart(item, item.pass, wireframe, depthPrePass && item.depthMaterial);
+        ++_statistics.drawCalls;
+
+        previous = &item;
+    }
+}
+
+void RenderQueue::drawPart(const Item& item, Pass* pass, bool wireframe, bool equalDepth)
+{
+    if (!equalDepth)
+    {
+        item.model->drawPart(item.partIndex, pass, wireframe);
+        return;
+    }
+
+    // The pre-pass wrote the depth of the item, so the pass is drawn with an equal depth test
+    // and without depth writes. The override is applied when the state is bound, so the
+    // state blocks of the material are not changed for the draw.
+    RenderState::setEqualDepthOverride(true);
+    item.model->drawPart(item.partIndex, pass, wireframe);
+    RenderState::setEqualDepthOverride(false);
+}
+
+unsigned int RenderQueue::getItemCount() const
+{
+    return (unsigned int)_items.size();
+}
+
+const RenderQueue::Statistics& RenderQueue::getStatistics() const
+{
+    return _statistics;
+}
+
+}
@@ -0,0 +1,317 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include "Model.h"
+#include "Rectangle.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Node;
+class OcclusionCuller;
+class OcclusionBuffer;
+
+/**
+ * Collects draw items and submits them in an order that minimizes GL state changes.
+ *
+ * Each item is a single mesh part drawn with one pass of its material. During
+ * end() the items are sorted by a 64-bit key: opaque items are grouped by
+ * effect, then texture, then render state, and drawn front-to-back within a
+ * group; transparent items (those with blending enabled) are drawn after all
+ * opaque items, back-to-front.
+ *
+ * Redundant program, texture and render state changes between consecutive
+ * items are skipped by Effect::bind, the texture unit bindings and the
+ * RenderState::StateBlock, so grouping similar items together directly reduces
+ * the number of GL calls. The statistics report how many changes were saved.
+ *
+ * A typical frame looks like:
+ *
+ * @verbatim
+    _renderQueue->begin(scene->getActiveCamera());
+    scene->visit(this, &MyGame::queueNode);    // calls _renderQueue->add(node)
+    _renderQueue->end();
+    _renderQueue->draw();
+   @endverbatim
+ *
+ * When expensive fragment shaders run on overdrawn pixels, the queue can draw the depth
+ * of its opaque items in a pre-pass before shading them; see setDepthPrePassEnabled().
+ *
+ * For split-screen and stereo rendering, the queue can collect the items once for
+ * several views and draw them into each view's viewport with each view's camera.
+ * Nodes are culled once against all the views with isVisible(), mesh LODs are
+ * selected and items sorted once, and only the drawing is repeated per view:
+ *
+ * @verbatim
+    Camera* cameras[2] = { leftEye, rightEye };
+    Rectangle viewports[2] = { leftViewport, rightViewport };
+    _renderQueue->begin(cameras, viewports, 2);
+    scene->visit(this, &MyGame::queueNode);    // adds the nodes for which _renderQueue->isVisible(node)
+    _renderQueue->end();
+    _renderQueue->draw();
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class RenderQueue
+{
+public:
+
+    /**
+     * Defines the counters gathered while drawing the queue.
+     */
+    struct Statistics
+    {
+        /**
+         * The number of draw calls issued.
+         */
+        unsigned int drawCalls;
+
+        /**
+         * The number of times the effect changed between consecutive items.
+         */
+        unsigned int effectChanges;
+
+        /**
+         * The number of effect binds that were skipped because the effect did not change.
+         */
+        unsigned int effectChangesSaved;
+
+        /**
+         * The number of times the primary texture changed between consecutive items.
+         */
+        unsigned int textureChanges;
+
+        /**
+         * The number of texture binds that were skipped because the primary texture did not change.
+         */
+        unsigned int textureChangesSaved;
+
+        /**
+         * The number of times the render state changed between consecutive items.
+         */
+        unsigned int stateChanges;
+
+        /**
+         * The number of render state changes that were skipped because the state did not change.
+         */
+        unsigned int stateChangesSaved;
+
+        /**
+         * The number of draw calls of the depth pre-pass, which are included in drawCalls.
+         */
+        unsigned int depthPrePassDrawCalls;
+    };
+
+    /**
+     * Creates a new render queue.
+     *
+     * @param initialCapacity The initial number of items the queue can hold without reallocating.
+     *
+     * @return A new render queue.
+     */
+    static RenderQueue* create(unsigned int initialCapacity = 256);
+
+    /**
+     * Destructor.
+     */
+    ~RenderQueue();
+
+    /**
+     * Clears the queue and starts collecting items for the specified camera.
+     *
+     * @param camera The camera used to compute item depths; may be NULL, in which case
+     *      items are not depth sorted.
+     */
+    void begin(Camera* camera);
+
+    /**
+     * Clears the queue and starts collecting items for several views.
+     *
+     * Each view is drawn with its own camera into its own viewport. Item depths, the
+     * occlusion culler and the occlusion buffer use the camera of the first view.
+     *
+     * @param cameras The cameras of the views. The cameras must belong to the scene of the nodes added.
+     * @param viewports The viewports of the views, in the coordinates of Game::setViewport.
+     * @param viewCount The number of views.
+     */
+    void begin(Camera* const* cameras, const Rectangle* viewports, unsigned int viewCount);
+
+    /**
+     * Determines whether a node is inside the frustum of any view of the queue.
+     *
+     * Testing each node once against all the views replaces culling the scene once
+     * per view.
+     *
+     * @param node The node to test.
+     *
+     * @return True if the node's bounding sphere intersects the frustum of a view,
+     *      or if the queue has no camera.
+     */
+    bool isVisible(Node* node) const;
+
+    /**
+     * Sets the occlusion culler that tests the nodes added to the queue.
+     *
+     * When set, begin() starts a frame of the culler, add(Node*) skips the nodes it
+     * finds occluded, and the first draw() after begin() issues its queries once the
+     * items are drawn.
+     *
+     * @param culler The occlusion culler, or NULL to draw every node added.
+     */
+    void setOcclusionCuller(OcclusionCuller* culler);
+
+    /**
+     * Sets the software occlusion buffer that tests the nodes added to the queue.
+     *
+     * When set, begin() rasterizes the occluders of the buffer for the camera, and
+     * add(Node*) skips the nodes the occluders hide. This is the occlusion culling
+     * path for devices without occlusion queries.
+     *
+     * @param buffer The occlusion buffer, or NULL to draw every node added.
+     */
+    void setOcclusionBuffer(OcclusionBuffer* buffer);
+
+    /**
+     * Sets whether the opaque items are drawn in a depth pre-pass before they are shaded.
+     *
+     * The pre-pass draws the depth of the opaque items front-to-back with a minimal effect
+     * and the color writes masked off. The main pass then draws them in the usual order
+     * with a DEPTH_EQUAL test and without depth writes, so their fragment shaders only run
+     * for the visible fragment of each pixel. The pre-pass transforms the opaque geometry
+     * a second time, so it pays off when fragment shading dominates; the overdraw view of
+     * the DebugRenderer shows how many fragments each pixel shades with and without it.
+     *
+     * An item takes part in the pre-pass when its material has not opted out with
+     * Material::setDepthPrePassEnabled, its technique has a single pass, and its render
+     * state tests depth with DEPTH_LESS or DEPTH_LEQUAL and writes it. The pre-pass
+     * computes positions the way the built-in shaders do, so materials whose vertex
+     * shaders move the vertices or whose fragment shaders discard fragments must opt out.
+     * Other items are drawn as without the pre-pass. The setting applies to the items
+     * added after it is set.
+     *
+     * @param enabled True to draw the opaque items in a depth pre-pass.
+     */
+    void setDepthPrePassEnabled(bool enabled);
+
+    /**
+     * Determines if the opaque items are drawn in a depth pre-pass before they are shaded.
+     *
+     * @return True if the queue draws a depth pre-pass.
+     */
+    bool isDepthPrePassEnabled() const;
+
+    /**
+     * Adds every mesh part of the model attached to the node, with each pass of its technique
+     * for the node's distance (see Material::getLodTechnique).
+     *
+     * @param node The node to add. Nodes without a model, or found occluded by the
+     *      occlusion culler or occlusion buffer, are ignored.
+     */
+    void add(Node* node);
+
+    /**
+     * Adds every mesh part of the model, with each pass of its technique for the model's distance.
+     *
+     * @param model The model to add.
+     */
+    void add(Model* model);
+
+    /**
+     * Sorts the items collected since begin().
+     */
+    void end();
+
+    /**
+     * Draws the sorted items.
+     *
+     * When the queue was begun with views, the items are drawn once per view, after
+     * setting the game viewport and the scene's camera for the view. The viewport
+     * and camera are restored afterwards, and the statistics add up all the views.
+     *
+     * The queue is left unchanged, so its items can be drawn again.
+     *
+     * @param wireframe If true, draw the items in wireframe mode.
+     */
+    void draw(bool wireframe = false);
+
+    /**
+     * Gets the number of items in the queue.
+     *
+     * @return The number of items.
+     */
+    unsigned int getItemCount() const;
+
+    /**
+     * Gets the statistics of the last call to draw().
+     *
+     * @return The render statistics.
+     */
+    const Statistics& getStatistics() const;
+
+private:
+
+    struct View
+    {
+        Camera* camera;
+        Rectangle viewport;
+    };
+
+    struct Item
+    {
+        unsigned long long key;
+        Model* model;
+        int partIndex;
+        Pass* pass;
+        const void* texture;
+        unsigned int state;
+        float depth;
+        Material* depthMaterial;
+    };
+
+    /**
+     * Constructor.
+     */
+    RenderQueue();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderQueue(const RenderQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderQueue& operator=(const RenderQueue&);
+
+    void add(Model* model, int partIndex, Material* material, float depth);
+
+    void setCamera(Camera* camera);
+
+    void clearViews();
+
+    void drawItems(bool wireframe);
+
+    void drawPart(const Item& item, Pass* pass, bool wireframe, bool equalDepth);
+
+    Material* getDepthMaterial(Model* model, int culledSide);
+
+    static const void* findPrimaryTexture(RenderState* renderState);
+
+    static bool compareItems(const Item& a, const Item& b);
+
+    std::vector<Item> _items;
+    std::vector<View> _views;
+    Camera* _camera;
+    OcclusionCuller* _occlusionCuller;
+    OcclusionBuffer* _occlusionBuffer;
+    Statistics _statistics;
+    bool _depthPrePass;
+    std::vector<std::pair<float, unsigned int> > _depthItems;
+    std::map<unsigned int, Material*> _depthMaterials;
+};
+
+}
+
+#endif
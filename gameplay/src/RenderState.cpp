@@ -1,10 +1,13 @@
 #include "Base.h"
 #include "RenderState.h"
+#include "StateCache.h"
+#include "StringTable.h"
 #include "Node.h"
 #include "Pass.h"
 #include "Technique.h"
 #include "Node.h"
 #include "Scene.h"
+#include "Game.h"
 
 // Render state override bits
 #define RS_BLEND 1
@@ -15,20 +18,33 @@
 #define RS_DEPTH_FUNC 32
 #define RS_CULL_FACE_SIDE 64
 
+// Most lights bound by the NODE_LIGHTS auto binding.
+#define RS_MAX_NODE_LIGHTS 8
+
 namespace gameplay
 {
 
 RenderState::StateBlock* RenderState::StateBlock::_defaultState = NULL;
+RenderState::StateBlock* RenderState::StateBlock::_boundPipelineState = NULL;
+unsigned int RenderState::StateBlock::_revision = 0;
+bool RenderState::StateBlock::_equalDepth = false;
+RenderState::StateBlock* RenderState::StateBlock::_equalDepthState = NULL;
+RenderState::StateBlock* RenderState::StateBlock::_equalDepthSource = NULL;
+unsigned int RenderState::StateBlock::_equalDepthRevision = 0;
 std::vector<RenderState::ResolveAutoBindingCallback> RenderState::_customAutoBindingResolvers;
 
+// The registry of interned parameter names.
+static StringTable __parameterNames;
+
 RenderState::RenderState()
-    : _nodeBinding(NULL), _state(NULL), _parent(NULL)
+    : _nodeBinding(NULL), _state(NULL), _parent(NULL), _pipelineState(NULL), _pipelineRevision(0)
 {
 }
 
 RenderState::~RenderState()
 {
     SAFE_RELEASE(_state);
+    SAFE_RELEASE(_pipelineState);
 
     // Destroy all the material parameters
     for (size_t i = 0, count = _parameters.size(); i < count; ++i)
@@ -48,6 +64,9 @@ void RenderState::initialize()
 void RenderState::finalize()
 {
     SAFE_RELEASE(StateBlock::_defaultState);
+    SAFE_RELEASE(StateBlock::_equalDepthState);
+    StateBlock::_equalDepthSource = NULL;
+    StateBlock::_boundPipelineState = NULL;
 }
 
 void RenderState::registerAutoBindingResolver(ResolveAutoBindingCallback callback)
@@ -59,31 +78,53 @@ MaterialParameter* RenderState::getParameter(const char* name) const
 {
     GP_ASSERT(name);
 
-    // Search for an existing parameter with this name.
+    return getParameter(getParameterHandle(name));
+}
+
+MaterialParameter* RenderState::getParameter(unsigned int handle) const
+{
+    GP_ASSERT(handle < __parameterNames.getCount());
+
+    // Search for an existing parameter with this name, comparing handles only.
     MaterialParameter* param;
     for (size_t i = 0, count = _parameters.size(); i < count; ++i)
     {
         param = _parameters[i];
         GP_ASSERT(param);
-        if (strcmp(param->getName(), name) == 0)
+        if (param->_handle == handle)
         {
             return param;
         }
     }
 
     // Create a new parameter and store it in our list.
-    param = new MaterialParameter(name);
+    param = new MaterialParameter(__parameterNames.getString(handle));
     _parameters.push_back(param);
 
     return param;
 }
 
+unsigned int RenderState::getParameterHandle(const char* name)
+{
+    GP_ASSERT(name);
+
+    return __parameterNames.intern(name);
+}
+
+const char* RenderState::getParameterName(unsigned int handle)
+{
+    return __parameterNames.getString(handle);
+}
+
 void RenderState::clearParameter(const char* name)
 {
+    GP_ASSERT(name);
+
+    unsigned int handle = getParameterHandle(name);
     for (size_t i = 0, count = _parameters.size(); i < count; ++i)
     {
         MaterialParameter* p = _parameters[i];
-        if (p->_name == name)
+        if (p->_handle == handle)
         {
             _parameters.erase(_parameters.begin() + i);
             SAFE_RELEASE(p);
@@ -103,6 +144,9 @@ const char* autoBindingToString(RenderState::AutoBinding autoBinding)
     case RenderState::NONE:
         return NULL;
 
+    case RenderState::WORLD_MATRIX:
+        return "WORLD_MATRIX";
+
     case RenderState::VIEW_MATRIX:
         return "VIEW_MATRIX";
 
@@ -142,11 +186,30 @@ const char* autoBindingToString(RenderState::AutoBinding autoBinding)
     case RenderState::SCENE_LIGHT_DIRECTION:
         return "SCENE_LIGHT_DIRECTION";
 
+    case RenderState::SCENE_LIGHT_PROBE:
+        return "SCENE_LIGHT_PROBE";
+
+    case RenderState::NODE_LIGHTS:
+        return "NODE_LIGHTS";
+
     default:
         return "";
     }
 }
 
+/**
+ * Returns the built-in auto binding named by the specified string, or NONE.
+ */
+static RenderState::AutoBinding parseAutoBinding(const char* autoBinding)
+{
+    for (int i = RenderState::WORLD_MATRIX; i <= RenderState::NODE_LIGHTS; ++i)
+    {
+        if (strcmp(autoBinding, autoBindingToString((RenderState::AutoBinding)i)) == 0)
+            return (RenderState::AutoBinding)i;
+    }
+    return RenderState::NONE;
+}
+
 void RenderState::setParameterAutoBinding(const char* name, AutoBinding autoBinding)
 {
     setParameterAutoBinding(name, autoBindingToString(autoBinding));
@@ -189,6 +252,7 @@ void RenderState::setStateBlock(StateBlock* state)
         {
             _state->addRef();
         }
+        ++StateBlock::_revision;
     }
 }
 
@@ -206,9 +270,13 @@ void RenderState::setNodeBinding(Node* node)
 {
     if (_nodeBinding != node)
     {
+        Node* previous = _nodeBinding;
         _nodeBinding = node;
 
-        if (_nodeBinding)
+        // Built-in auto bindings read the node each time they are bound, so a model sharing this
+        // render state can switch nodes cheaply. Bindings only need resolving for the first node,
+        // and for custom resolvers, which may hold on to the node they were given.
+        if (_nodeBinding && (previous == NULL || !_customAutoBindingResolvers.empty()))
         {
             // Apply all existing auto-bindings using this node.
             std::map<std::string, std::string>::const_iterator itr = _autoBindings.begin();
@@ -244,85 +312,117 @@ void RenderState::applyAutoBinding(const char* uniformName, const char* autoBind
         }
     }
 
-    // Perform built-in resolution
+    // Perform built-in resolution. The binding is stored as its integer id and evaluated
+    // against the current node by bindAutoBinding, without a method binding per parameter.
     if (!bound)
     {
-        bound = true;
-
-        if (strcmp(autoBinding, "WORLD_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetWorldMatrix);
-        }
-        else if (strcmp(autoBinding, "VIEW_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetViewMatrix);
-        }
-        else if (strcmp(autoBinding, "PROJECTION_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "WORLD_VIEW_MATRIX") == 0)
+        AutoBinding id = parseAutoBinding(autoBinding);
+        if (id != NONE)
         {
-            param->bindValue(this, &RenderState::autoBindingGetWorldViewMatrix);
+            param->clearValue();
+            param->_value.autoBinding = id;
+            param->_type = MaterialParameter::AUTO;
         }
-        else if (strcmp(autoBinding, "VIEW_PROJECTION_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetViewProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "WORLD_VIEW_PROJECTION_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetWorldViewProjectionMatrix);
-        }
-        else if (strcmp(autoBinding, "INVERSE_TRANSPOSE_WORLD_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetInverseTransposeWorldMatrix);
-        }
-        else if (strcmp(autoBinding, "INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetInverseTransposeWorldViewMatrix);
-        }
-        else if (strcmp(autoBinding, "CAMERA_WORLD_POSITION") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetCameraWorldPosition);
-        }
-        else if (strcmp(autoBinding, "CAMERA_VIEW_POSITION") == 0)
-        {
-            param->bindValue(this, &RenderState::autoBindingGetCameraViewPosition);
-        }
-        else if (strcmp(autoBinding, "MATRIX_PALETTE") == 0)
+        else
         {
-            param->bindValue(this, &RenderState::autoBindingGetMatrixPalette, &RenderState::autoBindingGetMatrixPaletteSize);
+            GP_WARN("Unsupported auto binding type (%s).", autoBinding);
         }
-        else if (strcmp(autoBinding, "SCENE_AMBIENT_COLOR") == 0)
+    }
+    else
+    {
+        // Mark parameter as an auto binding
+        if (param->_type == MaterialParameter::METHOD && param->_value.method)
+            param->_value.method->_autoBinding = true;
+    }
+}
+
+void RenderState::bindAutoBinding(MaterialParameter* param, Effect* effect) const
+{
+    GP_ASSERT(param && param->_type == MaterialParameter::AUTO);
+
+    Uniform* uniform = param->getUniform(effect);
+    if (!uniform)
+        return;
+
+    switch (param->_value.autoBinding)
+    {
+    case WORLD_MATRIX:
+        effect->setValue(uniform, autoBindingGetWorldMatrix());
+        break;
+    case VIEW_MATRIX:
+        effect->setValue(uniform, autoBindingGetViewMatrix());
+        break;
+    case PROJECTION_MATRIX:
+        effect->setValue(uniform, autoBindingGetProjectionMatrix());
+        break;
+    case WORLD_VIEW_MATRIX:
+        effect->setValue(uniform, autoBindingGetWorldViewMatrix());
+        break;
+    case VIEW_PROJECTION_MATRIX:
+        effect->setValue(uniform, autoBindingGetViewProjectionMatrix());
+        break;
+    case WORLD_VIEW_PROJECTION_MATRIX:
+        effect->setValue(uniform, autoBindingGetWorldViewProjectionMatrix());
+        break;
+    case INVERSE_TRANSPOSE_WORLD_MATRIX:
+        effect->setValue(uniform, autoBindingGetInverseTransposeWorldMatrix());
+        break;
+    case INVERSE_TRANSPOSE_WORLD_VIEW_MATRIX:
+        effect->setValue(uniform, autoBindingGetInverseTransposeWorldViewMatrix());
+        break;
+    case CAMERA_WORLD_POSITION:
+        effect->setValue(uniform, autoBindingGetCameraWorldPosition());
+        break;
+    case CAMERA_VIEW_POSITION:
+        effect->setValue(uniform, autoBindingGetCameraViewPosition());
+        break;
+    case MATRIX_PALETTE:
+        // Effects built with the palette texture declare the palette as a sampler.
+        if (uniform->getType() == GL_SAMPLER_2D)
         {
-            param->bindValue(this, &RenderState::autoBindingGetAmbientColor);
+            Model* model = _nodeBinding ? _nodeBinding->getModel() : NULL;
+            Game::getInstance()->getMatrixPaletteTexture()->bind(effect, uniform, model ? model->getSkin() : NULL);
         }
-        else if (strcmp(autoBinding, "SCENE_LIGHT_COLOR") == 0)
+        else
         {
-            param->bindValue(this, &RenderState::autoBindingGetLightColor);
+            effect->setValue(uniform, autoBindingGetMatrixPalette(), autoBindingGetMatrixPaletteSize());
         }
-        else if (strcmp(autoBinding, "SCENE_LIGHT_DIRECTION") == 0)
+        break;
+    case SCENE_AMBIENT_COLOR:
+        effect->setValue(uniform, autoBindingGetAmbientColor());
+        break;
+    case SCENE_LIGHT_COLOR:
+        effect->setValue(uniform, autoBindingGetLightColor());
+        break;
+    case SCENE_LIGHT_DIRECTION:
+        effect->setValue(uniform, autoBindingGetLightDirection());
+        break;
+    case SCENE_LIGHT_PROBE:
         {
-            param->bindValue(this, &RenderState::autoBindingGetLightDirection);
+            Vector4 irradiance[3];
+            autoBindingGetLightProbe(irradiance);
+            effect->setValue(uniform, irradiance, 3);
         }
-        else
+        break;
+    case NODE_LIGHTS:
         {
-            bound = false;
-            GP_WARN("Unsupported auto binding type (%d).", autoBinding);
+            Vector4 lights[RS_MAX_NODE_LIGHTS * 3];
+            unsigned int count = std::min(uniform->getSize() / 3, (unsigned int)RS_MAX_NODE_LIGHTS);
+            if (count > 0)
+            {
+                autoBindingGetNodeLights(lights, count);
+                effect->setValue(uniform, lights, count * 3);
+            }
         }
-    }
-
-    if (bound)
-    {
-        // Mark parameter as an auto binding
-        if (param->_type == MaterialParameter::METHOD && param->_value.method)
-            param->_value.method->_autoBinding = true;
+        break;
+    default:
+        break;
     }
 }
 
 const Matrix& RenderState::autoBindingGetWorldMatrix() const
 {
-    return _nodeBinding ? _nodeBinding->getWorldMatrix() : Matrix::identity();
+    return _nodeBinding ? decodePositions(_nodeBinding->getWorldMatrix()) : Matrix::identity();
 }
 
 const Matrix& RenderState::autoBindingGetViewMatrix() const
@@ -337,7 +437,7 @@ const Matrix& RenderState::autoBindingGetProjectionMatrix() const
 
 const Matrix& RenderState::autoBindingGetWorldViewMatrix() const
 {
-    return _nodeBinding ? _nodeBinding->getWorldViewMatrix() : Matrix::identity();
+    return _nodeBinding ? decodePositions(_nodeBinding->getWorldViewMatrix()) : Matrix::identity();
 }
 
 const Matrix& RenderState::autoBindingGetViewProjectionMatrix() const
@@ -347,7 +447,19 @@ const Matrix& RenderState::autoBindingGetViewProjectionMatrix() const
 
 const Matrix& RenderState::autoBindingGetWorldViewProjectionMatrix() const
 {
-    return _nodeBinding ? _nodeBinding->getWorldViewProjectionMatrix() : Matrix::identity();
+    return _nodeBinding ? decodePositions(_nodeBinding->getWorldViewProjectionMatrix()) : Matrix::identity();
+}
+
+const Matrix& RenderState::decodePositions(const Matrix& matrix) const
+{
+    // Meshes with quantized positions need their decode transform applied ahead of the
+    // node's transform. Normals are unaffected, so the inverse transpose bindings are not.
+    Model* model = _nodeBinding->getModel();
+    const Matrix* decode = (model && model->getMesh()) ? model->getMesh()->getPositionDecode() : NULL;
+    if (decode == NULL)
+        return matrix;
+    Matrix::multiply(matrix, *decode, &_decodedMatrix);
+    return _decodedMatrix;
 }
 
 const Matrix& RenderState::autoBindingGetInverseTransposeWorldMatrix() const
@@ -403,41 +515,198 @@ const Vector3& RenderState::autoBindingGetLightDirection() const
     return scene ? scene->getLightDirection() : down;
 }
 
-void RenderState::bind(Pass* pass)
+void RenderState::autoBindingGetLightProbe(Vector4* dst) const
 {
-    GP_ASSERT(pass);
+    GP_ASSERT(dst);
 
-    // Get the combined modified state bits for our RenderState hierarchy.
-    long stateOverrideBits = _state ? _state->_bits : 0;
-    RenderState* rs = _parent;
-    while (rs)
+    Scene* scene = _nodeBinding ? _nodeBinding->getScene() : NULL;
+    LightProbes* probes = scene ? scene->getLightProbes() : NULL;
+    if (probes && probes->evaluate(_nodeBinding->getTranslationWorld(), dst))
     {
-        if (rs->_state)
+        // The shaders light with normals in view space.
+        const Matrix& view = _nodeBinding->getViewMatrix();
+        for (unsigned int i = 0; i < 3; ++i)
         {
-            stateOverrideBits |= rs->_state->_bits;
+            Vector3 direction(dst[i].x, dst[i].y, dst[i].z);
+            view.transformVector(&direction);
+            dst[i].set(direction.x, direction.y, direction.z, dst[i].w);
         }
-        rs = rs->_parent;
+        return;
     }
 
-    // Restore renderer state to its default, except for explicitly specified states
-    StateBlock::restore(stateOverrideBits);
+    const Vector3& ambient = autoBindingGetAmbientColor();
+    dst[0].set(0, 0, 0, ambient.x);
+    dst[1].set(0, 0, 0, ambient.y);
+    dst[2].set(0, 0, 0, ambient.z);
+}
+
+void RenderState::autoBindingGetNodeLights(Vector4* dst, unsigned int count) const
+{
+    GP_ASSERT(dst || count == 0);
 
-    // Apply parameter bindings and renderer state for the entire hierarchy, top-down.
-    rs = NULL;
+    Node* lights[RS_MAX_NODE_LIGHTS];
+    unsigned int lightCount = 0;
+    Scene* scene = _nodeBinding ? _nodeBinding->getScene() : NULL;
+    if (scene)
+        lightCount = scene->selectLights(_nodeBinding->getBoundingSphere(), lights, std::min(count, (unsigned int)RS_MAX_NODE_LIGHTS));
+
+    // The shaders light in view space, as with clustered lighting.
+    const Matrix& view = _nodeBinding ? _nodeBinding->getViewMatrix() : Matrix::identity();
+    for (unsigned int i = 0; i < lightCount; ++i, dst += 3)
+    {
+        Node* node = lights[i];
+        Light* light = node->getLight();
+        const Vector3& color = light->getColor();
+        if (light->getLightType() == Light::DIRECTIONAL)
+        {
+            Vector3 direction;
+            view.transformVector(node->getForwardVectorWorld(), &direction);
+            direction.normalize();
+            dst[0].set(0, 0, 0, 0);
+            dst[1].set(color.x, color.y, color.z, 0);
+            dst[2].set(direction.x, direction.y, direction.z, 0);
+            continue;
+        }
+
+        Vector3 position;
+        view.transformPoint(node->getTranslationWorld(), &position);
+        dst[0].set(position.x, position.y, position.z, light->getRangeInverse());
+        if (light->getLightType() == Light::SPOT)
+        {
+            Vector3 direction;
+            view.transformVector(node->getForwardVectorWorld(), &direction);
+            direction.normalize();
+            dst[1].set(color.x, color.y, color.z, light->getInnerAngleCos());
+            dst[2].set(direction.x, direction.y, direction.z, light->getOuterAngleCos());
+        }
+        else
+        {
+            // Cone cosines below -1, so that the cone of a point light never attenuates.
+            dst[1].set(color.x, color.y, color.z, -2.0f);
+            dst[2].set(0, 0, 0, -3.0f);
+        }
+    }
+
+    // Lights with a zero color add nothing.
+    for (unsigned int i = lightCount; i < count; ++i, dst += 3)
+    {
+        dst[0].set(0, 0, 0, 0);
+        dst[1].set(0, 0, 0, 0);
+        dst[2].set(0, 0, 0, 0);
+    }
+}
+
+void RenderState::bind(Pass* pass)
+{
+    GP_ASSERT(pass);
+
+    // Apply the merged state of the hierarchy, unless it is the state bound last.
+    StateBlock* pipelineState = getPipelineState();
+    if (StateBlock::_equalDepth)
+        pipelineState = StateBlock::getEqualDepthState(pipelineState);
+    if (pipelineState != StateBlock::_boundPipelineState)
+    {
+        StateBlock::restore(pipelineState->_bits);
+        pipelineState->bindNoRestore();
+        StateBlock::_boundPipelineState = pipelineState;
+    }
+
+    // Apply parameter bindings for the entire hierarchy, top-down.
+    RenderState* rs = NULL;
     Effect* effect = pass->getEffect();
     while ((rs = getTopmost(rs)))
     {
         for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
         {
-            GP_ASSERT(rs->_parameters[i]);
-            rs->_parameters[i]->bind(effect);
+            MaterialParameter* param = rs->_parameters[i];
+            GP_ASSERT(param);
+            if (param->_type == MaterialParameter::AUTO)
+                rs->bindAutoBinding(param, effect);
+            else
+                param->bind(effect);
         }
+    }
+}
+
+RenderState::StateBlock* RenderState::getPipelineState()
+{
+    if (_pipelineState && _pipelineRevision == StateBlock::_revision)
+        return _pipelineState;
+
+    if (_pipelineState == NULL)
+        _pipelineState = StateBlock::create();
+    else if (_pipelineState == StateBlock::_boundPipelineState)
+        StateBlock::_boundPipelineState = NULL;
+
+    // Merge the state blocks of the hierarchy top-down, each overriding the states it sets.
+    StateBlock* merged = _pipelineState;
+    merged->_blendEnabled = false;
+    merged->_blendSrc = BLEND_ONE;
+    merged->_blendDst = BLEND_ZERO;
+    merged->_cullFaceEnabled = false;
+    merged->_cullFaceSide = CULL_FACE_SIDE_BACK;
+    merged->_depthTestEnabled = false;
+    merged->_depthWriteEnabled = true;
+    merged->_depthFunction = DEPTH_LESS;
+    merged->_bits = 0;
+    RenderState* rs = NULL;
+    while ((rs = getTopmost(rs)))
+    {
+        StateBlock* state = rs->_state;
+        if (state == NULL)
+            continue;
 
-        if (rs->_state)
+        if (state->_bits & RS_BLEND)
+            merged->_blendEnabled = state->_blendEnabled;
+        if (state->_bits & RS_BLEND_FUNC)
         {
-            rs->_state->bindNoRestore();
+            merged->_blendSrc = state->_blendSrc;
+            merged->_blendDst = state->_blendDst;
         }
-    }
+        if (state->_bits & RS_CULL_FACE)
+            merged->_cullFaceEnabled = state->_cullFaceEnabled;
+        if (state->_bits & RS_CULL_FACE_SIDE)
+            merged->_cullFaceSide = state->_cullFaceSide;
+        if (state->_bits & RS_DEPTH_TEST)
+            merged->_depthTestEnabled = state->_depthTestEnabled;
+        if (state->_bits & RS_DEPTH_WRITE)
+            merged->_depthWriteEnabled = state->_depthWriteEnabled;
+        if (state->_bits & RS_DEPTH_FUNC)
+            merged->_depthFunction = state->_depthFunction;
+        merged->_bits |= state->_bits;
+    }
+    _pipelineRevision = StateBlock::_revision;
+    return merged;
+}
+
+void RenderState::setEqualDepthOverride(bool enabled)
+{
+    StateBlock::_equalDepth = enabled;
+}
+
+unsigned int RenderState::getStateKey(bool* blendEnabled, bool* depthWritten, int* culledSide)
+{
+    GP_ASSERT(blendEnabled);
+
+    // The key is taken from the merged state bind() applies.
+    const StateBlock* merged = getPipelineState();
+    bool blend = merged->_blendEnabled, cullFace = merged->_cullFaceEnabled;
+    bool depthTest = merged->_depthTestEnabled, depthWrite = merged->_depthWriteEnabled;
+    int blendSrc = merged->_blendSrc, blendDst = merged->_blendDst;
+    int depthFunction = merged->_depthFunction, cullFaceSide = merged->_cullFaceSide;
+
+    *blendEnabled = blend;
+    if (depthWritten)
+        *depthWritten = depthTest && depthWrite && (depthFunction == DEPTH_LESS || depthFunction == DEPTH_LEQUAL);
+    if (culledSide)
+        *culledSide = cullFace ? cullFaceSide : 0;
+
+    unsigned int key = (blend ? 1 : 0) | (cullFace ? 2 : 0) | (depthTest ? 4 : 0) | (depthWrite ? 8 : 0);
+    key = key * 31 + (unsigned int)blendSrc;
+    key = key * 31 + (unsigned int)blendDst;
+    key = key * 31 + (unsigned int)depthFunction;
+    key = key * 31 + (unsigned int)cullFaceSide;
+    return key;
 }
 
 RenderState* RenderState::getTopmost(RenderState* below)
@@ -478,7 +747,8 @@ void RenderState::cloneInto(RenderState* renderState, NodeCloneContext& context)
 
         // If this parameter is a method binding auto binding, don't clone it - it will get setup automatically
         // via the cloned auto bindings instead.
-        if (param->_type == MaterialParameter::METHOD && param->_value.method && param->_value.method->_autoBinding)
+        if (param->_type == MaterialParameter::AUTO ||
+            (param->_type == MaterialParameter::METHOD && param->_value.method && param->_value.method->_autoBinding))
             continue;
 
         MaterialParameter* paramCopy = new MaterialParameter(param->getName());
@@ -512,6 +782,10 @@ RenderState::StateBlock::StateBlock(const StateBlock& copy)
 
 RenderState::StateBlock::~StateBlock()
 {
+    if (_boundPipelineState == this)
+        _boundPipelineState = NULL;
+    if (_equalDepthSource == this)
+        _equalDepthSource = NULL;
 }
 
 RenderState::StateBlock* RenderState::StateBlock::create()
@@ -535,50 +809,43 @@ void RenderState::StateBlock::bindNoRestore()
 {
     GP_ASSERT(_defaultState);
 
+    _boundPipelineState = NULL;
+
     // Update any state that differs from _defaultState and flip _defaultState bits
     if ((_bits & RS_BLEND) && (_blendEnabled != _defaultState->_blendEnabled))
     {
-        if (_blendEnabled)
-            GL_ASSERT( glEnable(GL_BLEND) );
-        else
-            GL_ASSERT( glDisable(GL_BLEND) );
+        StateCache::setEnabled(GL_BLEND, _blendEnabled);
         _defaultState->_blendEnabled = _blendEnabled;
     }
     if ((_bits & RS_BLEND_FUNC) && (_blendSrc != _defaultState->_blendSrc || _blendDst != _defaultState->_blendDst))
     {
-        GL_ASSERT( glBlendFunc((GLenum)_blendSrc, (GLenum)_blendDst) );
+        StateCache::setBlendFunction((GLenum)_blendSrc, (GLenum)_blendDst);
         _defaultState->_blendSrc = _blendSrc;
         _defaultState->_blendDst = _blendDst;
     }
     if ((_bits & RS_CULL_FACE) && (_cullFaceEnabled != _defaultState->_cullFaceEnabled))
     {
-        if (_cullFaceEnabled)
-            GL_ASSERT( glEnable(GL_CULL_FACE) );
-        else
-            GL_ASSERT( glDisable(GL_CULL_FACE) );
+        StateCache::setEnabled(GL_CULL_FACE, _cullFaceEnabled);
         _defaultState->_cullFaceEnabled = _cullFaceEnabled;
     }
     if ((_bits & RS_CULL_FACE_SIDE) && (_cullFaceSide != _defaultState->_cullFaceSide))
     {
-        GL_ASSERT( glCullFace((GLenum)_cullFaceSide) );
+        StateCache::setCullFaceSide((GLenum)_cullFaceSide);
         _defaultState->_cullFaceSide = _cullFaceSide;
     }
     if ((_bits & RS_DEPTH_TEST) && (_depthTestEnabled != _defaultState->_depthTestEnabled))
     {
-        if (_depthTestEnabled) 
-            GL_ASSERT( glEnable(GL_DEPTH_TEST) );
-        else 
-            GL_ASSERT( glDisable(GL_DEPTH_TEST) );
+        StateCache::setEnabled(GL_DEPTH_TEST, _depthTestEnabled);
         _defaultState->_depthTestEnabled = _depthTestEnabled;
     }
     if ((_bits & RS_DEPTH_WRITE) && (_depthWriteEnabled != _defaultState->_depthWriteEnabled))
     {
-        GL_ASSERT( glDepthMask(_depthWriteEnabled ? GL_TRUE : GL_FALSE) );
+        StateCache::setDepthWrite(_depthWriteEnabled);
         _defaultState->_depthWriteEnabled = _depthWriteEnabled;
     }
     if ((_bits & RS_DEPTH_FUNC) && (_depthFunction != _defaultState->_depthFunction))
     {
-        GL_ASSERT( glDepthFunc((GLenum)_depthFunction) );
+        StateCache::setDepthFunction((GLenum)_depthFunction);
         _defaultState->_depthFunction = _depthFunction;
     }
 
@@ -589,6 +856,8 @@ void RenderState::StateBlock::restore(long stateOverrideBits)
 {
     GP_ASSERT(_defaultState);
 
+    _boundPipelineState = NULL;
+
     // If there is no state to restore (i.e. no non-default state), do nothing.
     if (_defaultState->_bits == 0)
     {
@@ -598,44 +867,44 @@ void RenderState::StateBlock::restore(long stateOverrideBits)
     // Restore any state that is not overridden and is not default
     if (!(stateOverrideBits & RS_BLEND) && (_defaultState->_bits & RS_BLEND))
     {
-        GL_ASSERT( glDisable(GL_BLEND) );
+        StateCache::setEnabled(GL_BLEND, false);
         _defaultState->_bits &= ~RS_BLEND;
         _defaultState->_blendEnabled = false;
     }
     if (!(stateOverrideBits & RS_BLEND_FUNC) && (_defaultState->_bits & RS_BLEND_FUNC))
     {
-        GL_ASSERT( glBlendFunc(GL_ONE, GL_ZERO) );
+        StateCache::setBlendFunction(GL_ONE, GL_ZERO);
         _defaultState->_bits &= ~RS_BLEND_FUNC;
         _defaultState->_blendSrc = RenderState::BLEND_ONE;
         _defaultState->_blendDst = RenderState::BLEND_ZERO;
     }
     if (!(stateOverrideBits & RS_CULL_FACE) && (_defaultState->_bits & RS_CULL_FACE))
     {
-        GL_ASSERT( glDisable(GL_CULL_FACE) );
+        StateCache::setEnabled(GL_CULL_FACE, false);
         _defaultState->_bits &= ~RS_CULL_FACE;
         _defaultState->_cullFaceEnabled = false;
     }
     if (!(stateOverrideBits & RS_CULL_FACE_SIDE) && (_defaultState->_bits & RS_CULL_FACE_SIDE))
     {
-        GL_ASSERT( glCullFace((GLenum)GL_BACK) );
+        StateCache::setCullFaceSide((GLenum)GL_BACK);
         _defaultState->_bits &= ~RS_CULL_FACE_SIDE;
         _defaultState->_cullFaceSide = RenderState::CULL_FACE_SIDE_BACK;
     }
     if (!(stateOverrideBits & RS_DEPTH_TEST) && (_defaultState->_bits & RS_DEPTH_TEST))
     {
-        GL_ASSERT( glDisable(GL_DEPTH_TEST) );
+        StateCache::setEnabled(GL_DEPTH_TEST, false);
         _defaultState->_bits &= ~RS_DEPTH_TEST;
         _defaultState->_depthTestEnabled = false;
     }
     if (!(stateOverrideBits & RS_DEPTH_WRITE) && (_defaultState->_bits & RS_DEPTH_WRITE))
     {
-        GL_ASSERT( glDepthMask(GL_TRUE) );
+        StateCache::setDepthWrite(true);
         _defaultState->_bits &= ~RS_DEPTH_WRITE;
         _defaultState->_depthWriteEnabled = true;
     }
     if (!(stateOverrideBits & RS_DEPTH_FUNC) && (_defaultState->_bits & RS_DEPTH_FUNC))
     {
-        GL_ASSERT( glDepthFunc((GLenum)GL_LESS) );
+        StateCache::setDepthFunction((GLenum)GL_LESS);
         _defaultState->_bits &= ~RS_DEPTH_FUNC;
         _defaultState->_depthFunction = RenderState::DEPTH_LESS;
     }
@@ -650,7 +919,8 @@ void RenderState::StateBlock::enableDepthWrite()
     // next frame leaves depth writing disabled.
     if (!_defaultState->_depthWriteEnabled)
     {
-        GL_ASSERT( glDepthMask(GL_TRUE) );
+        _boundPipelineState = NULL;
+        StateCache::setDepthWrite(true);
         _defaultState->_bits &= ~RS_DEPTH_WRITE;
         _defaultState->_depthWriteEnabled = true;
     }
@@ -669,6 +939,36 @@ void RenderState::StateBlock::cloneInto(StateBlock* state)
     state->_blendDst = _blendDst;
     state->_cullFaceSide = _cullFaceSide;
     state->_bits = _bits;
+    ++_revision;
+}
+
+RenderState::StateBlock* RenderState::StateBlock::getEqualDepthState(StateBlock* state)
+{
+    GP_ASSERT(state);
+
+    // The overridden state is kept until another state is overridden or a state block changes,
+    // so consecutive draws of one pass with the override still skip binding the state.
+    if (_equalDepthState == NULL)
+        _equalDepthState = StateBlock::create();
+    if (_equalDepthSource != state || _equalDepthRevision != _revision)
+    {
+        if (_boundPipelineState == _equalDepthState)
+            _boundPipelineState = NULL;
+
+        StateBlock* overridden = _equalDepthState;
+        overridden->_cullFaceEnabled = state->_cullFaceEnabled;
+        overridden->_depthTestEnabled = state->_depthTestEnabled;
+        overridden->_depthWriteEnabled = false;
+        overridden->_depthFunction = DEPTH_EQUAL;
+        overridden->_blendEnabled = state->_blendEnabled;
+        overridden->_blendSrc = state->_blendSrc;
+        overridden->_blendDst = state->_blendDst;
+        overridden->_cullFaceSide = state->_cullFaceSide;
+        overridden->_bits = state->_bits | RS_DEPTH_WRITE | RS_DEPTH_FUNC;
+        _equalDepthSource = state;
+        _equalDepthRevision = _revision;
+    }
+    return _equalDepthState;
 }
 
 static bool parseBoolean(const char* value)
@@ -821,6 +1121,7 @@ void RenderState::StateBlock::setState(const char* name, const char* value)
 
 void RenderState::StateBlock::setBlend(bool enabled)
 {
+    ++_revision;
     _blendEnabled = enabled;
     if (!enabled)
     {
@@ -834,6 +1135,7 @@ void RenderState::StateBlock::setBlend(bool enabled)
 
 void RenderState::StateBlock::setBlendSrc(Blend blend)
 {
+    ++_revision;
     _blendSrc = blend;
     if (_blendSrc == BLEND_ONE && _blendDst == BLEND_ZERO)
     {
@@ -848,6 +1150,7 @@ void RenderState::StateBlock::setBlendSrc(Blend blend)
 
 void RenderState::StateBlock::setBlendDst(Blend blend)
 {
+    ++_revision;
     _blendDst = blend;
     if (_blendSrc == BLEND_ONE && _blendDst == BLEND_ZERO)
     {
@@ -862,6 +1165,7 @@ void RenderState::StateBlock::setBlendDst(Blend blend)
 
 void RenderState::StateBlock::setCullFace(bool enabled)
 {
+    ++_revision;
     _cullFaceEnabled = enabled;
     if (!enabled)
     {
@@ -875,6 +1179,7 @@ void RenderState::StateBlock::setCullFace(bool enabled)
 
 void RenderState::StateBlock::setCullFaceSide(CullFaceSide side)
 {
+    ++_revision;
     _cullFaceSide = side;
     if (_cullFaceSide == CULL_FACE_SIDE_BACK)
     {
@@ -889,6 +1194,7 @@ void RenderState::StateBlock::setCullFaceSide(CullFaceSide side)
 
 void RenderState::StateBlock::setDepthTest(bool enabled)
 {
+    ++_revision;
     _depthTestEnabled = enabled;
     if (!enabled)
     {
@@ -902,6 +1208,7 @@ void RenderState::StateBlock::setDepthTest(bool enabled)
 
 void RenderState::StateBlock::setDepthWrite(bool enabled)
 {
+    ++_revision;
     _depthWriteEnabled = enabled;
     if (enabled)
     {
@@ -915,6 +1222,7 @@ void RenderState::StateBlock::setDepthWrite(bool enabled)
 
 void RenderState::StateBlock::setDepthFunction(DepthFunction func)
 {
+    ++_revision;
     _depthFunction = func;
     if (_depthFunction == DEPTH_LESS)
     {
@@ -9,6 +9,7 @@ namespace gameplay
 {
 
 class MaterialParameter;
+class Effect;
 class Node;
 class NodeCloneContext;
 class Pass;
@@ -23,6 +24,9 @@ class RenderState : public Ref
     friend class Technique;
     friend class Pass;
     friend class Model;
+    friend class RenderQueue;
+    friend class TextureStreamer;
+    friend class Picker;
 
 public:
 
@@ -85,6 +89,9 @@ public:
 
         /**
          * Binds the matrix palette of MeshSkin attached to a node's model.
+         *
+         * When the effect reads its palette from the palette texture (see MatrixPaletteTexture),
+         * this binds the texture and the offset of the palette in it instead.
          */
         MATRIX_PALETTE,
 
@@ -105,7 +112,27 @@ public:
          *
          * This is typically used for the main directional light in a scene, such as the Sun.
          */
-        SCENE_LIGHT_DIRECTION
+        SCENE_LIGHT_DIRECTION,
+
+        /**
+         * Binds the irradiance of the scene's light probes at the node (Vector4[3]).
+         *
+         * The red, green and blue irradiance are first order spherical harmonics, with the
+         * directional part in view space. Without light probes the scene's ambient color
+         * is bound as the constant part.
+         */
+        SCENE_LIGHT_PROBE,
+
+        /**
+         * Binds the lights that contribute the most to the node (Vector4[3 * N]).
+         *
+         * The uniform is an array of three vectors per light, and as many lights are bound
+         * as it holds, up to 8. They are selected by Scene::selectLights for the bounding
+         * sphere of the node, and each is packed in view space as its position and inverse
+         * range (zero for a directional light), its color and inner cone cosine, and its
+         * direction and outer cone cosine. Unused lights have a zero color.
+         */
+        NODE_LIGHTS
     };
 
     /**
@@ -188,6 +215,7 @@ public:
     {
         friend class RenderState;
         friend class Game;
+        friend class RenderQueue;
 
     public:
 
@@ -308,6 +336,11 @@ public:
 
         void cloneInto(StateBlock* state);
 
+        /**
+         * Gets a state block with the states of the given one, drawn with an equal depth test and without depth writes.
+         */
+        static StateBlock* getEqualDepthState(StateBlock* state);
+
         // States
         bool _cullFaceEnabled;
         bool _depthTestEnabled;
@@ -320,6 +353,12 @@ public:
         long _bits;
 
         static StateBlock* _defaultState;
+        static StateBlock* _boundPipelineState;
+        static unsigned int _revision;
+        static bool _equalDepth;
+        static StateBlock* _equalDepthState;
+        static StateBlock* _equalDepthSource;
+        static unsigned int _equalDepthRevision;
     };
 
     /**
@@ -337,6 +376,44 @@ public:
      */
     MaterialParameter* getParameter(const char* name) const;
 
+    /**
+     * Gets the handle of a material parameter name.
+     *
+     * Parameter names are interned in a hashed registry shared by all render states, and
+     * each name keeps the same handle for the life of the game. Code that sets the same
+     * parameters every frame can look the handles up once and address the parameters
+     * with getParameter(unsigned int) without any string work.
+     *
+     * @param name Material parameter (uniform) name.
+     *
+     * @return The handle of the name.
+     * @script{ignore}
+     */
+    static unsigned int getParameterHandle(const char* name);
+
+    /**
+     * Gets the material parameter name of a handle.
+     *
+     * @param handle The handle of the name.
+     *
+     * @return The name, or NULL if the handle was not returned by getParameterHandle.
+     * @script{ignore}
+     */
+    static const char* getParameterName(unsigned int handle);
+
+    /**
+     * Returns the MaterialParameter for the specified name handle.
+     *
+     * Like getParameter(const char*), this creates the MaterialParameter if one does
+     * not already exist for the name.
+     *
+     * @param handle The handle of the parameter name (see getParameterHandle).
+     *
+     * @return A MaterialParameter for the specified name.
+     * @script{ignore}
+     */
+    MaterialParameter* getParameter(unsigned int handle) const;
+
     /**
      * Clears the MaterialParameter with the given name.
      *
@@ -467,17 +544,58 @@ protected:
      */
     void applyAutoBinding(const char* uniformName, const char* autoBinding);
 
+    /**
+     * Sets the value of a built-in auto binding parameter for the current node binding.
+     *
+     * @param param The parameter, of the built-in auto binding type.
+     * @param effect The effect being bound.
+     */
+    void bindAutoBinding(MaterialParameter* param, Effect* effect) const;
+
     /**
      * Binds the render state for this RenderState and any of its parents, top-down, 
      * for the given pass.
      */
     void bind(Pass* pass);
 
+    /**
+     * Gets the state blocks of this RenderState and its parents merged into one, the way
+     * bind() applies them, rebuilding it if any state block changed since it was built.
+     *
+     * @return The merged state block.
+     */
+    StateBlock* getPipelineState();
+
+    /**
+     * Sets whether bind() draws with an equal depth test and without depth writes, whatever
+     * the state blocks of the hierarchy set.
+     *
+     * This is used to draw items whose depth was written by a depth pre-pass. The override
+     * is applied to the merged state at bind time, so the state blocks are left unchanged.
+     *
+     * @param enabled true to override the depth states, false to use the state blocks.
+     */
+    static void setEqualDepthOverride(bool enabled);
+
     /**
      * Returns the topmost RenderState in the hierarchy below the given RenderState.
      */
     RenderState* getTopmost(RenderState* below);
 
+    /**
+     * Computes a key identifying the combined render state of this render state
+     * hierarchy, so that draws sharing the same state can be grouped together.
+     *
+     * @param blendEnabled Set to whether blending is enabled in the combined state.
+     * @param depthWritten If not NULL, set to whether the combined state tests depth with
+     *      DEPTH_LESS or DEPTH_LEQUAL and writes it, so that a depth pre-pass can draw it.
+     * @param culledSide If not NULL, set to the culled side of the combined state, or 0
+     *      if face culling is disabled.
+     *
+     * @return The state key.
+     */
+    unsigned int getStateKey(bool* blendEnabled, bool* depthWritten = NULL, int* culledSide = NULL);
+
     /**
      * Copies the data from this RenderState into the given RenderState.
      * 
@@ -514,6 +632,9 @@ private:
     const Vector3& autoBindingGetAmbientColor() const;
     const Vector3& autoBindingGetLightColor() const;
     const Vector3& autoBindingGetLightDirection() const;
+    void autoBindingGetLightProbe(Vector4* dst) const;
+    void autoBindingGetNodeLights(Vector4* dst, unsigned int count) const;
+    const Matrix& decodePositions(const Matrix& matrix) const;
 
 protected:
 
@@ -532,6 +653,11 @@ protected:
      */
     Node* _nodeBinding;
 
+    /**
+     * Scratch matrix for auto bindings that include a mesh's position decode.
+     */
+    mutable Matrix _decodedMatrix;
+
     /**
      * The StateBlock of fixed-function render states that can be applied to the RenderState.
      */
@@ -542,6 +668,16 @@ protected:
      */
     RenderState* _parent;
 
+    /**
+     * The state blocks of the hierarchy merged into one, built on first bind.
+     */
+    StateBlock* _pipelineState;
+
+    /**
+     * The state block revision _pipelineState was built at.
+     */
+    unsigned int _pipelineRevision;
+
     /**
      * Map of custom auto binding resolvers.
      */
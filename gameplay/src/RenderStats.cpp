@@ -0,0 +1,110 @@
+#include "Base.h"
+#include "RenderStats.h"
+
+namespace gameplay
+{
+
+struct Counters
+{
+    unsigned int drawCalls;
+    unsigned int triangles;
+    unsigned int effectBinds;
+    unsigned int textureBinds;
+    unsigned int redundantStateChanges;
+    unsigned int uploads;
+    unsigned int uploadSize;
+};
+
+static Counters __current = { 0, 0, 0, 0, 0, 0, 0 };
+static Counters __last = { 0, 0, 0, 0, 0, 0, 0 };
+
+RenderStats::RenderStats()
+{
+}
+
+unsigned int RenderStats::getDrawCalls()
+{
+    return __last.drawCalls;
+}
+
+unsigned int RenderStats::getTriangleCount()
+{
+    return __last.triangles;
+}
+
+unsigned int RenderStats::getEffectBinds()
+{
+    return __last.effectBinds;
+}
+
+unsigned int RenderStats::getTextureBinds()
+{
+    return __last.textureBinds;
+}
+
+unsigned int RenderStats::getRedundantStateChanges()
+{
+    return __last.redundantStateChanges;
+}
+
+unsigned int RenderStats::getUploads()
+{
+    return __last.uploads;
+}
+
+unsigned int RenderStats::getUploadSize()
+{
+    return __last.uploadSize;
+}
+
+void RenderStats::reset()
+{
+    memset(&__current, 0, sizeof(__current));
+}
+
+void RenderStats::nextFrame()
+{
+    __last = __current;
+    memset(&__current, 0, sizeof(__current));
+}
+
+void RenderStats::addDrawCall(GLenum primitiveType, unsigned int count, unsigned int instanceCount)
+{
+    ++__current.drawCalls;
+
+    switch (primitiveType)
+    {
+    case GL_TRIANGLES:
+        __current.triangles += (count / 3) * instanceCount;
+        break;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+        __current.triangles += (count > 2 ? count - 2 : 0) * instanceCount;
+        break;
+    default:
+        break;
+    }
+}
+
+void RenderStats::addEffectBind()
+{
+    ++__current.effectBinds;
+}
+
+void RenderStats::addTextureBind()
+{
+    ++__current.textureBinds;
+}
+
+void RenderStats::addRedundantStateChange()
+{
+    ++__current.redundantStateChanges;
+}
+
+void RenderStats::addUpload(unsigned int size)
+{
+    ++__current.uploads;
+    __current.uploadSize += size;
+}
+
+}
@@ -0,0 +1,136 @@
+#ifndef RENDERSTATS_H_
+#define RENDERSTATS_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines the rendering counters gathered over a frame.
+ *
+ * The counters are incremented by the engine where it issues GL calls: draw
+ * calls and triangles in Model and MeshBatch (and so SpriteBatch and Font),
+ * program and texture binds in StateCache, and buffer and texture uploads where
+ * the data is sent to GL. Redundant binds and state changes that StateCache skips
+ * are not counted as binds, but are counted by getRedundantStateChanges().
+ *
+ * The game starts a new frame of counters at the beginning of each Game::frame,
+ * and the getters return the totals of the last completed frame, so they can
+ * be read anywhere, including from Lua scripts, to check against a budget.
+ */
+class RenderStats
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Gets the number of draw calls issued during the last frame.
+     *
+     * @return The number of draw calls.
+     */
+    static unsigned int getDrawCalls();
+
+    /**
+     * Gets the number of triangles drawn during the last frame, including every instance.
+     *
+     * Point and line primitives are not counted.
+     *
+     * @return The number of triangles.
+     */
+    static unsigned int getTriangleCount();
+
+    /**
+     * Gets the number of shader program changes during the last frame.
+     *
+     * @return The number of program binds.
+     */
+    static unsigned int getEffectBinds();
+
+    /**
+     * Gets the number of texture binds during the last frame.
+     *
+     * @return The number of texture binds.
+     */
+    static unsigned int getTextureBinds();
+
+    /**
+     * Gets the number of GL state changes and binds that StateCache skipped during the
+     * last frame because they would not have changed the GL state.
+     *
+     * @return The number of redundant state changes.
+     */
+    static unsigned int getRedundantStateChanges();
+
+    /**
+     * Gets the number of buffer and texture uploads during the last frame.
+     *
+     * @return The number of uploads.
+     */
+    static unsigned int getUploads();
+
+    /**
+     * Gets the number of bytes uploaded to buffers and textures during the last frame.
+     *
+     * @return The number of uploaded bytes.
+     */
+    static unsigned int getUploadSize();
+
+    /**
+     * Clears the counters of the frame in progress.
+     *
+     * The totals of the last completed frame are not affected.
+     */
+    static void reset();
+
+    /**
+     * Counts a draw call.
+     *
+     * @param primitiveType The GL primitive type of the draw call.
+     * @param count The number of vertices or indices drawn.
+     * @param instanceCount The number of instances drawn.
+     * @script{ignore}
+     */
+    static void addDrawCall(GLenum primitiveType, unsigned int count, unsigned int instanceCount = 1);
+
+    /**
+     * Counts a shader program bind.
+     * @script{ignore}
+     */
+    static void addEffectBind();
+
+    /**
+     * Counts a texture bind.
+     * @script{ignore}
+     */
+    static void addTextureBind();
+
+    /**
+     * Counts a state change or bind skipped by StateCache.
+     * @script{ignore}
+     */
+    static void addRedundantStateChange();
+
+    /**
+     * Counts an upload of data to a buffer or texture.
+     *
+     * @param size The number of bytes uploaded.
+     * @script{ignore}
+     */
+    static void addUpload(unsigned int size);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    RenderStats();
+
+    /**
+     * Stores the counters of the frame in progress as the last frame's totals and clears them.
+     */
+    static void nextFrame();
+};
+
+}
+
+#endif
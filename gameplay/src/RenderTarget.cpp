@@ -1,5 +1,6 @@
 #include "Base.h"
 #include "RenderTarget.h"
+#include "DebugMarkers.h"
 
 namespace gameplay
 {
@@ -44,6 +45,8 @@ RenderTarget* RenderTarget::create(const char* id, Texture* texture)
     RenderTarget* renderTarget = new RenderTarget(id);
     renderTarget->_texture = texture;
     renderTarget->_texture->addRef();
+    if (texture->getPath()[0] == '\0')
+        DebugMarkers::setLabel(GL_TEXTURE, texture->getHandle(), id);
 
     __renderTargets.push_back(renderTarget);
 
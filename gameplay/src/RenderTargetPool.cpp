@@ -0,0 +1,157 @@
+#include "Base.h"
+#include "RenderTargetPool.h"
+#include "RenderTarget.h"
+#include "DepthStencilTarget.h"
+#include "Profiler.h"
+
+namespace gameplay
+{
+
+RenderTargetPool::RenderTargetPool()
+    : _maxIdleFrames(60), _frame(0)
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+}
+
+void RenderTargetPool::initialize(Properties* properties)
+{
+    if (properties && properties->exists("maxIdleFrames"))
+        _maxIdleFrames = (unsigned int)std::max(properties->getInt("maxIdleFrames"), 0);
+}
+
+void RenderTargetPool::finalize()
+{
+    // Frame buffers still held by their users are destroyed when they release them.
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        SAFE_RELEASE(_entries[i].frameBuffer);
+    }
+    _entries.clear();
+}
+
+FrameBuffer* RenderTargetPool::acquire(unsigned int width, unsigned int height, Texture::Format format, bool depthStencil)
+{
+    GP_ASSERT(width > 0 && height > 0);
+
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        Entry& entry = _entries[i];
+        if (entry.frameBuffer->getRefCount() == 1 && entry.width == width && entry.height == height &&
+            entry.format == format && entry.depthStencil == depthStencil)
+        {
+            entry.lastUsedFrame = _frame;
+            entry.frameBuffer->addRef();
+            return entry.frameBuffer;
+        }
+    }
+
+    if (format != Texture::RGB && format != Texture::RGBA)
+    {
+        GP_ERROR("Unsupported render target format (%d).", format);
+        return NULL;
+    }
+
+    Entry entry;
+    entry.frameBuffer = createFrameBuffer(width, height, format, depthStencil);
+    if (entry.frameBuffer == NULL)
+        return NULL;
+    entry.width = width;
+    entry.height = height;
+    entry.format = format;
+    entry.depthStencil = depthStencil;
+    entry.memorySize = width * height * ((format == Texture::RGBA ? 4 : 3) + (depthStencil ? 4 : 0));
+    entry.lastUsedFrame = _frame;
+    _entries.push_back(entry);
+
+    entry.frameBuffer->addRef();
+    return entry.frameBuffer;
+}
+
+void RenderTargetPool::purge()
+{
+    for (size_t i = 0; i < _entries.size();)
+    {
+        if (_entries[i].frameBuffer->getRefCount() == 1)
+        {
+            SAFE_RELEASE(_entries[i].frameBuffer);
+            _entries.erase(_entries.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+unsigned int RenderTargetPool::getCount() const
+{
+    return (unsigned int)_entries.size();
+}
+
+unsigned int RenderTargetPool::getMemorySize() const
+{
+    unsigned int size = 0;
+    for (size_t i = 0; i < _entries.size(); ++i)
+    {
+        size += _entries[i].memorySize;
+    }
+    return size;
+}
+
+void RenderTargetPool::update()
+{
+    ++_frame;
+    for (size_t i = 0; i < _entries.size();)
+    {
+        Entry& entry = _entries[i];
+        if (entry.frameBuffer->getRefCount() > 1)
+        {
+            // Frame buffers held across frames count as used until they are released.
+            entry.lastUsedFrame = _frame;
+        }
+        else if (_frame - entry.lastUsedFrame > _maxIdleFrames)
+        {
+            SAFE_RELEASE(entry.frameBuffer);
+            _entries.erase(_entries.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+
+    GP_PROFILE_COUNTER("Render target pool (KB)", getMemorySize() / 1024);
+}
+
+FrameBuffer* RenderTargetPool::createFrameBuffer(unsigned int width, unsigned int height, Texture::Format format, bool depthStencil)
+{
+    Texture* texture = Texture::create(format, width, height, NULL, false);
+    if (texture == NULL)
+    {
+        GP_ERROR("Failed to create texture for pooled render target.");
+        return NULL;
+    }
+    RenderTarget* renderTarget = RenderTarget::create("RenderTargetPool", texture);
+    SAFE_RELEASE(texture);
+
+    FrameBuffer* frameBuffer = FrameBuffer::create("RenderTargetPool");
+    frameBuffer->setRenderTarget(renderTarget);
+    SAFE_RELEASE(renderTarget);
+
+    if (depthStencil)
+    {
+        DepthStencilTarget* depthStencilTarget = DepthStencilTarget::create("RenderTargetPool", DepthStencilTarget::DEPTH_STENCIL, width, height);
+        if (depthStencilTarget == NULL)
+        {
+            GP_ERROR("Failed to create depth-stencil target for pooled render target.");
+            SAFE_RELEASE(frameBuffer);
+            return NULL;
+        }
+        frameBuffer->setDepthStencilTarget(depthStencilTarget);
+        SAFE_RELEASE(depthStencilTarget);
+    }
+    return frameBuffer;
+}
+
+}
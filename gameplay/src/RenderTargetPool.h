@@ -0,0 +1,139 @@
+#ifndef RENDERTARGETPOOL_H_
+#define RENDERTARGETPOOL_H_
+
+#include "Properties.h"
+#include "FrameBuffer.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of transient frame buffers that are recycled instead of being created
+ * and destroyed by each user.
+ *
+ * Post-processing chains and offscreen passes need frame buffers of a given size and
+ * format for part of a frame. Creating them on demand allocates GPU memory in the middle
+ * of the frame. The pool keeps the frame buffers it creates and hands them out again to
+ * later requests with the same size and format.
+ *
+ * acquire() returns a frame buffer with a reference held by the caller, which releases
+ * it with SAFE_RELEASE like any other frame buffer. A frame buffer is free again as soon
+ * as the pool holds the last reference to it, so passes that do not overlap within a
+ * frame share the same memory: a pass that releases its target before the next pass
+ * acquires one of the same size and format hands it over directly. The contents of an
+ * acquired frame buffer are undefined, and its targets must not be replaced.
+ *
+ * Free frame buffers that have not been used for a number of frames are destroyed, so
+ * that targets of an old resolution do not stay around after a resize.
+ *
+ * The pool is configured in the game config:
+ *
+ * @verbatim
+    renderTargets
+    {
+        maxIdleFrames = 60      // Number of frames a free frame buffer is kept before it is destroyed.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class RenderTargetPool
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Acquires a frame buffer with a single render target and, optionally, a depth-stencil target.
+     *
+     * @param width The width of the frame buffer.
+     * @param height The height of the frame buffer.
+     * @param format The format of the render target; RGB or RGBA.
+     * @param depthStencil true to attach a packed depth-stencil target.
+     *
+     * @return A frame buffer the caller must release, or NULL if it could not be created.
+     */
+    FrameBuffer* acquire(unsigned int width, unsigned int height, Texture::Format format = Texture::RGBA, bool depthStencil = false);
+
+    /**
+     * Destroys all the free frame buffers of the pool.
+     */
+    void purge();
+
+    /**
+     * Gets the number of frame buffers in the pool, free or in use.
+     *
+     * @return The number of frame buffers.
+     */
+    unsigned int getCount() const;
+
+    /**
+     * Gets the GPU memory held by the frame buffers of the pool, free or in use.
+     *
+     * @return The memory size in bytes.
+     */
+    unsigned int getMemorySize() const;
+
+private:
+
+    struct Entry
+    {
+        FrameBuffer* frameBuffer;
+        unsigned int width;
+        unsigned int height;
+        Texture::Format format;
+        bool depthStencil;
+        unsigned int memorySize;
+        unsigned int lastUsedFrame;
+    };
+
+    /**
+     * Constructor.
+     */
+    RenderTargetPool();
+
+    /**
+     * Destructor.
+     */
+    ~RenderTargetPool();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderTargetPool(const RenderTargetPool& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderTargetPool& operator=(const RenderTargetPool&);
+
+    /**
+     * Called during startup to read the configuration.
+     *
+     * @param properties The 'renderTargets' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to release the frame buffers of the pool.
+     */
+    void finalize();
+
+    /**
+     * Called at the start of each frame to destroy the frame buffers that have been free for too long.
+     */
+    void update();
+
+    /**
+     * Creates a frame buffer for a new entry of the pool.
+     */
+    static FrameBuffer* createFrameBuffer(unsigned int width, unsigned int height, Texture::Format format, bool depthStencil);
+
+    std::vector<Entry> _entries;
+    unsigned int _maxIdleFrames;
+    unsigned int _frame;
+};
+
+}
+
+#endif
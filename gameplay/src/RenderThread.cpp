@@ -0,0 +1,199 @@
+#include "Base.h"
+#include "RenderThread.h"
+#include "Platform.h"
+#include "Profiler.h"
+
+namespace gameplay
+{
+
+RenderThread::RenderThread()
+    : _running(false), _async(false), _thread(NULL), _submitted(NULL), _recordIndex(0), _frameCommandCount(0)
+{
+    _lists[0] = NULL;
+    _lists[1] = NULL;
+}
+
+RenderThread::~RenderThread()
+{
+    SAFE_DELETE(_lists[0]);
+    SAFE_DELETE(_lists[1]);
+}
+
+void RenderThread::initialize(Properties* properties)
+{
+    if (properties == NULL || !properties->getBool("enabled"))
+        return;
+
+    if (!Platform::createRenderContext())
+    {
+        GP_WARN("The render thread is not supported on this platform; frames render on the game thread.");
+        return;
+    }
+
+    _lists[0] = new RenderCommandList();
+    _lists[1] = new RenderCommandList();
+    _running = true;
+    _async = true;
+    _thread = Thread::create(&RenderThread::renderThread, this);
+    if (_thread == NULL)
+    {
+        _running = false;
+        _async = false;
+        SAFE_DELETE(_lists[0]);
+        SAFE_DELETE(_lists[1]);
+        Platform::destroyRenderContext();
+        return;
+    }
+
+    RenderCommandList::setRecording(_lists[_recordIndex]);
+}
+
+void RenderThread::finalize()
+{
+    if (_lists[0] == NULL)
+        return;
+
+    RenderCommandList::setRecording(NULL);
+    RenderCommandList* missed = NULL;
+    {
+        MutexLock lock(_mutex);
+        while (_submitted && _async)
+            _condition.wait(_mutex);
+        if (!_async)
+            missed = _submitted;
+        _submitted = NULL;
+        _running = false;
+        _condition.signal();
+    }
+    if (_thread)
+    {
+        _thread->join();
+        SAFE_DELETE(_thread);
+    }
+    _async = false;
+
+    // The commands recorded since the last frame, such as the deletions of the shutdown, run on the game thread.
+    if (missed)
+        missed->execute();
+    _lists[_recordIndex]->execute();
+    RenderCommandList::releaseReplayFramebuffers();
+
+    Platform::destroyRenderContext();
+    SAFE_DELETE(_lists[0]);
+    SAFE_DELETE(_lists[1]);
+}
+
+bool RenderThread::isRunning() const
+{
+    MutexLock lock(_mutex);
+    return _async;
+}
+
+unsigned int RenderThread::getFrameCommandCount() const
+{
+    return _frameCommandCount;
+}
+
+void RenderThread::submitFrame()
+{
+    if (_lists[0] == NULL)
+        return;
+
+    RenderCommandList* list = _lists[_recordIndex];
+    _frameCommandCount = list->getCommandCount();
+
+    // The objects created and written by the game thread must reach the GPU before the render thread draws with them.
+    GL_ASSERT( glFlush() );
+
+    RenderCommandList* missed = NULL;
+    bool async;
+    {
+        GP_PROFILE_SCOPE("RenderThread::submitFrame");
+
+        // At most one frame is replayed while the next one is recorded.
+        MutexLock lock(_mutex);
+        while (_submitted && _async)
+            _condition.wait(_mutex);
+        async = _async;
+        if (async)
+        {
+            _submitted = list;
+            _condition.signal();
+        }
+        else
+        {
+            missed = _submitted;
+            _submitted = NULL;
+        }
+    }
+
+    if (!async)
+    {
+        // The platform presents the frame replayed here, as without a render thread.
+        stop(missed);
+        list->execute();
+        SAFE_DELETE(_lists[0]);
+        SAFE_DELETE(_lists[1]);
+        return;
+    }
+
+    _recordIndex = 1 - _recordIndex;
+    _lists[_recordIndex]->reset();
+    RenderCommandList::setRecording(_lists[_recordIndex]);
+}
+
+void RenderThread::stop(RenderCommandList* missed)
+{
+    // Replaying the frames leaves the context of the game in the state the StateCache expects.
+    RenderCommandList::setRecording(NULL);
+    if (_thread)
+    {
+        _thread->join();
+        SAFE_DELETE(_thread);
+    }
+    _running = false;
+    Platform::destroyRenderContext();
+    if (missed)
+        missed->execute();
+}
+
+void RenderThread::renderThread(void* arg)
+{
+    RenderThread* renderThread = (RenderThread*)arg;
+    GP_ASSERT(renderThread);
+
+    if (!Platform::makeRenderContextCurrent(true))
+    {
+        // The game thread takes over the frames.
+        GP_WARN("Failed to make the render context current; frames will render on the game thread.");
+        MutexLock lock(renderThread->_mutex);
+        renderThread->_async = false;
+        renderThread->_condition.signal();
+        return;
+    }
+
+    while (true)
+    {
+        RenderCommandList* list;
+        {
+            MutexLock lock(renderThread->_mutex);
+            while (renderThread->_running && renderThread->_submitted == NULL)
+                renderThread->_condition.wait(renderThread->_mutex);
+            if (renderThread->_submitted == NULL)
+                break;
+            list = renderThread->_submitted;
+        }
+
+        list->execute();
+        Platform::swapBuffers();
+
+        MutexLock lock(renderThread->_mutex);
+        renderThread->_submitted = NULL;
+        renderThread->_condition.signal();
+    }
+
+    RenderCommandList::releaseReplayFramebuffers();
+    Platform::makeRenderContextCurrent(false);
+}
+
+}
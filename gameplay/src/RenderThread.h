@@ -0,0 +1,129 @@
+#ifndef RENDERTHREAD_H_
+#define RENDERTHREAD_H_
+
+#include "Properties.h"
+#include "Thread.h"
+#include "RenderCommandList.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines the render thread, which makes the GL calls of each frame on a context of its own.
+ *
+ * Without a render thread the game thread makes every GL call of a frame inline, so the
+ * simulation of a frame and the driver work of submitting it add up. With the render thread
+ * enabled, the GL calls that the game thread makes through RenderCommandList (every state
+ * change, uniform, draw and dynamic update of the Model, MeshBatch, SpriteBatch, Font, Form,
+ * terrain and particle code) are recorded into a command list instead. At the end of each
+ * frame the list is handed to the render thread, which replays it on a GL context that shares
+ * its objects with the context of the game and presents it, while the game thread simulates
+ * and records the next frame into the other list. Rendering thus lags the simulation by one
+ * frame, and the game thread waits if the render thread is still replaying the previous frame
+ * when the next one is complete.
+ *
+ * The game thread keeps its own context current: resources are still created, and read back,
+ * on the game thread, and are flushed to the GPU before each frame is handed over. GL queries
+ * belong to the context they are issued on, so the GPU timings of the profiler, dynamic
+ * resolution, occlusion culling and the overdraw view are disabled while the render thread runs.
+ *
+ * The render thread needs a platform with shared contexts that can draw to the window from
+ * another thread (Linux and Windows). Elsewhere, or if its context cannot be made current,
+ * frames are rendered on the game thread as usual.
+ *
+ * The render thread is configured in the game config:
+ *
+ * @verbatim
+    renderThread
+    {
+        enabled = false     // Replay the frames on a render thread, where the platform supports it.
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class RenderThread
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Determines if frames are replayed on the render thread.
+     *
+     * @return true if the render thread runs, false if frames render on the game thread.
+     */
+    bool isRunning() const;
+
+    /**
+     * Gets the number of commands recorded for the last frame handed to the render thread.
+     *
+     * @return The number of commands.
+     */
+    unsigned int getFrameCommandCount() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    RenderThread();
+
+    /**
+     * Destructor.
+     */
+    ~RenderThread();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderThread(const RenderThread& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderThread& operator=(const RenderThread&);
+
+    /**
+     * Called during startup to create the render context and thread, and start recording.
+     *
+     * @param properties The 'renderThread' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to replay the last commands and stop the render thread.
+     */
+    void finalize();
+
+    /**
+     * Called at the end of each frame to hand the recorded frame to the render thread.
+     */
+    void submitFrame();
+
+    /**
+     * Stops recording after the render thread failed, replaying the frames it did not take on the game thread.
+     *
+     * @param missed The frame that was handed to the render thread but not replayed, or NULL.
+     */
+    void stop(RenderCommandList* missed);
+
+    /**
+     * Replays the submitted frames until the render thread is stopped.
+     */
+    static void renderThread(void* arg);
+
+    bool _running;
+    bool _async;
+    Thread* _thread;
+    mutable Mutex _mutex;
+    Condition _condition;
+    RenderCommandList* _lists[2];
+    RenderCommandList* _submitted;
+    unsigned int _recordIndex;
+    unsigned int _frameCommandCount;
+};
+
+}
+
+#endif
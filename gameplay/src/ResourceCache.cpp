@@ -0,0 +1,361 @@
+#include "Base.h"
+#include "ResourceCache.h"
+#include "Profiler.h"
+#include "StringTable.h"
+
+// Number of buckets allocated when the first resource is added.
+#define INITIAL_BUCKET_COUNT 64
+
+namespace gameplay
+{
+
+ResourceCache::Key::Key(const char* first, const char* second, const char* third)
+    : _partCount(0), _hash(StringTable::HASH_SEED)
+{
+    GP_ASSERT(first);
+
+    _parts[0] = first;
+    _parts[1] = second;
+    _parts[2] = third;
+
+    // Hash the parts joined with ';', so a key hashes like its joined string.
+    for (; _partCount < 3 && _parts[_partCount]; ++_partCount)
+    {
+        if (_partCount > 0)
+            _hash = StringTable::hash(";", 1, _hash);
+        _hash = StringTable::hash(_parts[_partCount], strlen(_parts[_partCount]), _hash);
+    }
+}
+
+unsigned int ResourceCache::Key::getHash() const
+{
+    return _hash;
+}
+
+std::string ResourceCache::Key::toString() const
+{
+    std::string id;
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        if (i > 0)
+            id += ';';
+        id += _parts[i];
+    }
+    return id;
+}
+
+bool ResourceCache::Key::equals(const std::string& id) const
+{
+    size_t position = 0;
+    for (unsigned int i = 0; i < _partCount; ++i)
+    {
+        if (i > 0)
+        {
+            if (position >= id.size() || id[position] != ';')
+                return false;
+            ++position;
+        }
+        size_t length = strlen(_parts[i]);
+        if (id.compare(position, length, _parts[i]) != 0)
+            return false;
+        position += length;
+    }
+    return position == id.size();
+}
+
+ResourceCache::ResourceCache(const char* name)
+    : _name(name ? name : ""), _entryCount(0), _capacity(0), _retiredCount(0), _oldestRetired(NULL), _newestRetired(NULL)
+{
+    getCaches().push_back(this);
+}
+
+ResourceCache::~ResourceCache()
+{
+    std::vector<ResourceCache*>& caches = getCaches();
+    std::vector<ResourceCache*>::iterator itr = std::find(caches.begin(), caches.end(), this);
+    if (itr != caches.end())
+    {
+        caches.erase(itr);
+    }
+
+    // Resources still in the cache at this point are leaked on purpose, since the
+    // graphics context they belong to no longer exists.
+    for (size_t i = 0, count = _buckets.size(); i < count; ++i)
+    {
+        Entry* entry = _buckets[i];
+        while (entry)
+        {
+            Entry* next = entry->next;
+            SAFE_DELETE(entry);
+            entry = next;
+        }
+    }
+}
+
+std::vector<ResourceCache*>& ResourceCache::getCaches()
+{
+    static std::vector<ResourceCache*> caches;
+    return caches;
+}
+
+void ResourceCache::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    std::vector<ResourceCache*>& caches = getCaches();
+    for (size_t i = 0, count = caches.size(); i < count; ++i)
+    {
+        ResourceCache* cache = caches[i];
+        if (properties->exists(cache->getName()))
+        {
+            cache->setRetainedCapacity((unsigned int)std::max(0, properties->getInt(cache->getName())));
+        }
+    }
+}
+
+void ResourceCache::finalize()
+{
+    std::vector<ResourceCache*>& caches = getCaches();
+    for (size_t i = 0, count = caches.size(); i < count; ++i)
+    {
+        caches[i]->setRetainedCapacity(0);
+    }
+}
+
+void ResourceCache::updateAll()
+{
+    GP_PROFILE_SCOPE("ResourceCache::updateAll");
+
+    std::vector<ResourceCache*>& caches = getCaches();
+    for (size_t i = 0, count = caches.size(); i < count; ++i)
+    {
+        caches[i]->update();
+    }
+}
+
+Ref* ResourceCache::find(const Key& key)
+{
+    if (_buckets.empty())
+        return NULL;
+
+    unsigned int hash = key.getHash();
+    for (Entry* entry = _buckets[hash & (_buckets.size() - 1)]; entry; entry = entry->next)
+    {
+        if (entry->hash == hash && key.equals(entry->id))
+        {
+            if (entry->retired)
+                revive(entry);
+            return entry->resource;
+        }
+    }
+    return NULL;
+}
+
+void ResourceCache::add(const Key& key, Ref* resource)
+{
+    GP_ASSERT(resource);
+
+    if (_buckets.empty())
+        rehash(INITIAL_BUCKET_COUNT);
+    else if (_entryCount >= _buckets.size())
+        rehash(_buckets.size() * 2);
+
+    Entry* entry = new Entry();
+    entry->hash = key.getHash();
+    entry->id = key.toString();
+    entry->resource = resource;
+    entry->retired = false;
+    entry->olderRetired = NULL;
+    entry->newerRetired = NULL;
+
+    Entry*& bucket = _buckets[entry->hash & (_buckets.size() - 1)];
+    entry->next = bucket;
+    bucket = entry;
+    ++_entryCount;
+
+    // Retaining caches hold a reference to each of their resources.
+    if (_capacity > 0)
+        resource->addRef();
+}
+
+void ResourceCache::remove(const Key& key, Ref* resource)
+{
+    if (_buckets.empty())
+        return;
+
+    unsigned int hash = key.getHash();
+    for (Entry* entry = _buckets[hash & (_buckets.size() - 1)]; entry; entry = entry->next)
+    {
+        if (entry->resource == resource)
+        {
+            unlink(entry);
+            SAFE_DELETE(entry);
+            return;
+        }
+    }
+}
+
+const char* ResourceCache::getName() const
+{
+    return _name.c_str();
+}
+
+unsigned int ResourceCache::getRetainedCapacity() const
+{
+    return _capacity;
+}
+
+void ResourceCache::setRetainedCapacity(unsigned int capacity)
+{
+    if (capacity > 0 && _capacity == 0)
+    {
+        for (size_t i = 0, count = _buckets.size(); i < count; ++i)
+        {
+            for (Entry* entry = _buckets[i]; entry; entry = entry->next)
+            {
+                entry->resource->addRef();
+            }
+        }
+    }
+    else if (capacity == 0 && _capacity > 0)
+    {
+        // Unused resources remove themselves from the cache when they are destroyed.
+        std::vector<Ref*> resources;
+        resources.reserve(_entryCount);
+        for (size_t i = 0, count = _buckets.size(); i < count; ++i)
+        {
+            for (Entry* entry = _buckets[i]; entry; entry = entry->next)
+            {
+                resources.push_back(entry->resource);
+            }
+        }
+        _capacity = 0;
+        for (size_t i = 0, count = resources.size(); i < count; ++i)
+        {
+            resources[i]->release();
+        }
+        return;
+    }
+
+    _capacity = capacity;
+    trim(_capacity);
+}
+
+unsigned int ResourceCache::getResourceCount() const
+{
+    return _entryCount;
+}
+
+unsigned int ResourceCache::getRetiredCount() const
+{
+    return _retiredCount;
+}
+
+void ResourceCache::purge()
+{
+    trim(0);
+}
+
+void ResourceCache::update()
+{
+    if (_capacity == 0)
+        return;
+
+    // Resources only referenced by the cache are unused.
+    for (size_t i = 0, count = _buckets.size(); i < count; ++i)
+    {
+        for (Entry* entry = _buckets[i]; entry; entry = entry->next)
+        {
+            unsigned int refCount = entry->resource->getRefCount();
+            if (!entry->retired && refCount == 1)
+                retire(entry);
+            else if (entry->retired && refCount > 1)
+                revive(entry);
+        }
+    }
+    trim(_capacity);
+}
+
+void ResourceCache::retire(Entry* entry)
+{
+    GP_ASSERT(!entry->retired);
+
+    entry->retired = true;
+    entry->olderRetired = _newestRetired;
+    entry->newerRetired = NULL;
+    if (_newestRetired)
+        _newestRetired->newerRetired = entry;
+    else
+        _oldestRetired = entry;
+    _newestRetired = entry;
+    ++_retiredCount;
+}
+
+void ResourceCache::revive(Entry* entry)
+{
+    GP_ASSERT(entry->retired);
+
+    if (entry->olderRetired)
+        entry->olderRetired->newerRetired = entry->newerRetired;
+    else
+        _oldestRetired = entry->newerRetired;
+    if (entry->newerRetired)
+        entry->newerRetired->olderRetired = entry->olderRetired;
+    else
+        _newestRetired = entry->olderRetired;
+
+    entry->retired = false;
+    entry->olderRetired = NULL;
+    entry->newerRetired = NULL;
+    --_retiredCount;
+}
+
+void ResourceCache::unlink(Entry* entry)
+{
+    if (entry->retired)
+        revive(entry);
+
+    Entry** link = &_buckets[entry->hash & (_buckets.size() - 1)];
+    while (*link != entry)
+    {
+        GP_ASSERT(*link);
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    --_entryCount;
+}
+
+void ResourceCache::rehash(size_t bucketCount)
+{
+    // The bucket count must be a power of two.
+    std::vector<Entry*> buckets(bucketCount, (Entry*)NULL);
+    for (size_t i = 0, count = _buckets.size(); i < count; ++i)
+    {
+        Entry* entry = _buckets[i];
+        while (entry)
+        {
+            Entry* next = entry->next;
+            Entry*& bucket = buckets[entry->hash & (bucketCount - 1)];
+            entry->next = bucket;
+            bucket = entry;
+            entry = next;
+        }
+    }
+    _buckets.swap(buckets);
+}
+
+void ResourceCache::trim(unsigned int capacity)
+{
+    // Destroy the least recently retired resources.
+    while (_retiredCount > capacity)
+    {
+        Entry* entry = _oldestRetired;
+        Ref* resource = entry->resource;
+        unlink(entry);
+        SAFE_DELETE(entry);
+        resource->release();
+    }
+}
+
+}
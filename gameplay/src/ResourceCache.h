@@ -0,0 +1,234 @@
+#ifndef RESOURCECACHE_H_
+#define RESOURCECACHE_H_
+
+#include "Ref.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a cache of shared resources, such as textures and effects, keyed by
+ * the paths (and defines) they were created from.
+ *
+ * Keys are hashed once and looked up in a hash table, so finding a resource
+ * only compares the full key strings of entries with the same hash.
+ *
+ * By default a resource is destroyed as soon as its last reference is released.
+ * A cache can instead retain a number of unused resources: it then holds a
+ * reference to each of its resources, and once per frame the resources that
+ * are only referenced by the cache are retired. Retired resources stay loaded
+ * until more than the retained number are retired, at which point the least
+ * recently retired ones are destroyed. Finding a retired resource revives it,
+ * so reloading a recently unloaded level does not read its files again.
+ *
+ * The number of retained resources of each cache can be configured in the game config:
+ *
+ * @verbatim
+    resources
+    {
+        textures = 64
+        effects = 32
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class ResourceCache
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the key of a cached resource, made of up to three strings.
+     *
+     * The key is equivalent to its strings joined with ';'.
+     */
+    class Key
+    {
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param first The first string of the key.
+         * @param second The optional second string of the key.
+         * @param third The optional third string of the key.
+         */
+        Key(const char* first, const char* second = NULL, const char* third = NULL);
+
+        /**
+         * Gets the hash of the key.
+         *
+         * @return The hash of the key.
+         */
+        unsigned int getHash() const;
+
+        /**
+         * Gets the key as a single string.
+         *
+         * @return The strings of the key joined with ';'.
+         */
+        std::string toString() const;
+
+        /**
+         * Determines if the key is equal to the specified string.
+         *
+         * @param id The string to compare the key with.
+         *
+         * @return True if the key is equal to the string.
+         */
+        bool equals(const std::string& id) const;
+
+    private:
+
+        const char* _parts[3];
+        unsigned int _partCount;
+        unsigned int _hash;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param name The name of the cache, used to configure it in the game config.
+     */
+    ResourceCache(const char* name);
+
+    /**
+     * Destructor.
+     */
+    ~ResourceCache();
+
+    /**
+     * Finds a resource, reviving it if it was retired.
+     *
+     * The reference count of the returned resource is not changed.
+     *
+     * @param key The key of the resource.
+     *
+     * @return The resource, or NULL if it is not in the cache.
+     */
+    Ref* find(const Key& key);
+
+    /**
+     * Adds a resource to the cache.
+     *
+     * @param key The key of the resource.
+     * @param resource The resource to add.
+     */
+    void add(const Key& key, Ref* resource);
+
+    /**
+     * Removes a resource from the cache without releasing it.
+     *
+     * This is called when a cached resource is destroyed.
+     *
+     * @param key The key of the resource.
+     * @param resource The resource to remove.
+     */
+    void remove(const Key& key, Ref* resource);
+
+    /**
+     * Gets the name of the cache.
+     *
+     * @return The name of the cache.
+     */
+    const char* getName() const;
+
+    /**
+     * Gets the maximum number of unused resources retained by the cache.
+     *
+     * @return The number of retained resources.
+     */
+    unsigned int getRetainedCapacity() const;
+
+    /**
+     * Sets the maximum number of unused resources retained by the cache.
+     *
+     * A capacity of zero destroys resources as soon as they are no longer referenced.
+     *
+     * @param capacity The number of retained resources.
+     */
+    void setRetainedCapacity(unsigned int capacity);
+
+    /**
+     * Gets the number of resources in the cache, including retired ones.
+     *
+     * @return The number of resources.
+     */
+    unsigned int getResourceCount() const;
+
+    /**
+     * Gets the number of retired resources in the cache.
+     *
+     * @return The number of retired resources.
+     */
+    unsigned int getRetiredCount() const;
+
+    /**
+     * Destroys every retired resource.
+     */
+    void purge();
+
+private:
+
+    struct Entry
+    {
+        unsigned int hash;
+        std::string id;
+        Ref* resource;
+        Entry* next;            // Next entry in the same bucket.
+        bool retired;
+        Entry* olderRetired;
+        Entry* newerRetired;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    ResourceCache(const ResourceCache& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ResourceCache& operator=(const ResourceCache&);
+
+    /**
+     * Called during startup to configure the registered caches.
+     *
+     * @param properties The 'resources' namespace of the game config, or NULL.
+     */
+    static void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to release the resources held by the registered caches.
+     */
+    static void finalize();
+
+    /**
+     * Called once per frame to retire unused resources of the registered caches.
+     */
+    static void updateAll();
+
+    static std::vector<ResourceCache*>& getCaches();
+
+    void update();
+    void retire(Entry* entry);
+    void revive(Entry* entry);
+    void unlink(Entry* entry);
+    void rehash(size_t bucketCount);
+    void trim(unsigned int capacity);
+
+    std::string _name;
+    std::vector<Entry*> _buckets;
+    unsigned int _entryCount;
+    unsigned int _capacity;
+    unsigned int _retiredCount;
+    Entry* _oldestRetired;
+    Entry* _newestRetired;
+};
+
+}
+
+#endif
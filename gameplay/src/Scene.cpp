@@ -6,6 +6,12 @@
 #include "Joint.h"
 #include "Terrain.h"
 #include "Bundle.h"
+#include "Game.h"
+#include "StartupTrace.h"
+#include "StringTable.h"
+
+// Dirty subtrees with more nodes than this are split into the subtrees of their children.
+#define SCENE_TRANSFORM_SPLIT_SIZE 256
 
 namespace gameplay
 {
@@ -60,8 +66,9 @@ static bool endsWith(const char* str, const char* suffix, bool ignoreCase)
 
 
 Scene::Scene(const char* id)
-    : _id(id ? id : ""), _activeCamera(NULL), _firstNode(NULL), _lastNode(NULL), _nodeCount(0), 
-    _lightColor(1,1,1), _lightDirection(0,-1,0), _bindAudioListenerToCamera(true), _debugBatch(NULL)
+    : _id(id ? id : ""), _activeCamera(NULL), _viewCamera(NULL), _firstNode(NULL), _lastNode(NULL), _nodeCount(0), 
+    _lightProbes(NULL), _lightColor(1,1,1), _lightDirection(0,-1,0), _bindAudioListenerToCamera(true), _octree(NULL), _particleBudget(0), _nodeIndexDirty(false),
+    _transformOrderDirty(true), _lightsDirty(true)
 {
     __sceneList.push_back(this);
 }
@@ -82,7 +89,8 @@ Scene::~Scene()
 
     // Remove all nodes from the scene
     removeAllNodes();
-    SAFE_DELETE(_debugBatch);
+    SAFE_DELETE(_octree);
+    SAFE_RELEASE(_lightProbes);
 
     // Remove the scene from global list
     std::vector<Scene*>::iterator itr = std::find(__sceneList.begin(), __sceneList.end(), this);
@@ -97,6 +105,7 @@ Scene* Scene::create(const char* id)
 
 Scene* Scene::load(const char* filePath)
 {
+    StartupTrace::Scope trace("Scene::load");
     if (endsWith(filePath, ".gpb", true))
     {
         Scene* scene = NULL;
@@ -139,6 +148,16 @@ Node* Scene::findNode(const char* id, bool recursive, bool exactMatch) const
 {
     GP_ASSERT(id);
 
+    // Recursive searches with a single match are served by the node ID index; the
+    // traversal below only decides which node to return when several nodes match.
+    if (recursive)
+    {
+        Node* match = NULL;
+        unsigned int count = findIndexedNodes(id, exactMatch, NULL, &match);
+        if (count <= 1)
+            return match;
+    }
+
     // Search immediate children first.
     for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
     {
@@ -154,7 +173,7 @@ Node* Scene::findNode(const char* id, bool recursive, bool exactMatch) const
     {
         for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
         {
-            Node* match = child->findNode(id, true, exactMatch);
+            Node* match = child->findNodeInHierarchy(id, true, exactMatch);
             if (match)
             {
                 return match;
@@ -169,9 +188,14 @@ unsigned int Scene::findNodes(const char* id, std::vector<Node*>& nodes, bool re
 {
     GP_ASSERT(id);
 
+    if (recursive)
+    {
+        return findIndexedNodes(id, exactMatch, &nodes, NULL);
+    }
+
     unsigned int count = 0;
 
-    // Search immediate children first.
+    // Search immediate children only.
     for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
     {
         // Does this child's ID match?
@@ -182,24 +206,285 @@ unsigned int Scene::findNodes(const char* id, std::vector<Node*>& nodes, bool re
         }
     }
 
-    // Recurse.
-    if (recursive)
+    return count;
+}
+
+void Scene::indexNodeTree(Node* node, bool tags)
+{
+    if (_nodeIndexDirty)
+        return;
+
+    indexNode(node);
+    if (tags && node->_tags)
     {
-        for (Node* child = getFirstNode(); child != NULL; child = child->getNextSibling())
+        for (size_t i = 0, count = node->_tags->size(); i < count; ++i)
+            indexNodeTag(node, (*node->_tags)[i].id);
+    }
+
+    // Joint hierarchies are not part of the scene but are searched by findNode.
+    // Their nodes do not know the scene, so their tags are not indexed.
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        indexNodeTree(node->_model->_skin->_rootNode, false);
+    }
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        indexNodeTree(child, tags);
+    }
+}
+
+void Scene::unindexNodeTree(Node* node, bool tags)
+{
+    if (_nodeIndexDirty)
+        return;
+
+    unindexNode(node);
+    if (tags && node->_tags)
+    {
+        for (size_t i = 0, count = node->_tags->size(); i < count; ++i)
+            unindexNodeTag(node, (*node->_tags)[i].id);
+    }
+
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        unindexNodeTree(node->_model->_skin->_rootNode, false);
+    }
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        unindexNodeTree(child, tags);
+    }
+}
+
+void Scene::indexNodeTag(Node* node, unsigned int tagId)
+{
+    if (_nodeIndexDirty)
+        return;
+
+    if (tagId >= _tagIndex.size())
+        _tagIndex.resize(tagId + 1);
+    _tagIndex[tagId].push_back(node);
+}
+
+void Scene::unindexNodeTag(Node* node, unsigned int tagId)
+{
+    if (_nodeIndexDirty || tagId >= _tagIndex.size())
+        return;
+
+    std::vector<Node*>& nodes = _tagIndex[tagId];
+    std::vector<Node*>::iterator itr = std::find(nodes.begin(), nodes.end(), node);
+    if (itr == nodes.end())
+        return;
+    *itr = nodes.back();
+    nodes.pop_back();
+}
+
+unsigned int Scene::findNodesWithTag(const char* name, std::vector<Node*>& nodes) const
+{
+    GP_ASSERT(name);
+
+    const std::vector<Node*>& tagged = getNodesWithTag(Node::getTagId(name));
+    nodes.insert(nodes.end(), tagged.begin(), tagged.end());
+    return (unsigned int)tagged.size();
+}
+
+const std::vector<Node*>& Scene::getNodesWithTag(unsigned int tagId) const
+{
+    static const std::vector<Node*> empty;
+
+    updateNodeIndex();
+    return (tagId < _tagIndex.size() ? _tagIndex[tagId] : empty);
+}
+
+void Scene::indexNode(Node* node)
+{
+    if (_nodeIndexDirty)
+        return;
+
+    _nodeIndex[StringTable::hash(node->_id.c_str())].push_back(node);
+    _nodeIds.insert(node->_id);
+}
+
+void Scene::unindexNode(Node* node)
+{
+    if (_nodeIndexDirty)
+        return;
+
+    std::map<unsigned int, std::vector<Node*> >::iterator itr = _nodeIndex.find(StringTable::hash(node->_id.c_str()));
+    if (itr == _nodeIndex.end())
+        return;
+
+    std::vector<Node*>& bucket = itr->second;
+    std::vector<Node*>::iterator nodeItr = std::find(bucket.begin(), bucket.end(), node);
+    if (nodeItr == bucket.end())
+        return;
+    *nodeItr = bucket.back();
+    bucket.pop_back();
+
+    // Keep the ID for prefix searches while another node still uses it.
+    bool shared = false;
+    for (size_t i = 0, count = bucket.size(); i < count; ++i)
+    {
+        if (bucket[i]->_id == node->_id)
         {
-            count += child->findNodes(id, nodes, true, exactMatch);
+            shared = true;
+            break;
         }
     }
+    if (!shared)
+        _nodeIds.erase(node->_id);
+    if (bucket.empty())
+        _nodeIndex.erase(itr);
+}
+
+void Scene::updateNodeIndex() const
+{
+    if (!_nodeIndexDirty)
+        return;
+
+    _nodeIndex.clear();
+    _nodeIds.clear();
+    for (size_t i = 0, count = _tagIndex.size(); i < count; ++i)
+        _tagIndex[i].clear();
+    _nodeIndexDirty = false;
+
+    Scene* scene = const_cast<Scene*>(this);
+    for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+    {
+        scene->indexNodeTree(node);
+    }
+}
+
+unsigned int Scene::findIndexedNodes(const char* id, bool exactMatch, std::vector<Node*>* nodes, Node** first) const
+{
+    updateNodeIndex();
 
+    unsigned int count = 0;
+    std::set<std::string>::const_iterator idItr = exactMatch ? _nodeIds.find(id) : _nodeIds.lower_bound(id);
+    size_t length = strlen(id);
+    for (; idItr != _nodeIds.end() && idItr->compare(0, length, id) == 0; ++idItr)
+    {
+        std::map<unsigned int, std::vector<Node*> >::const_iterator itr = _nodeIndex.find(StringTable::hash(idItr->c_str()));
+        GP_ASSERT(itr != _nodeIndex.end());
+
+        const std::vector<Node*>& bucket = itr->second;
+        for (size_t i = 0, bucketSize = bucket.size(); i < bucketSize; ++i)
+        {
+            // Skip nodes whose ID only shares the hash.
+            if (bucket[i]->_id != *idItr)
+                continue;
+
+            if (count == 0 && first)
+                *first = bucket[i];
+            if (nodes)
+                nodes->push_back(bucket[i]);
+            else if (count == 1)
+                return 2;   // Only uniqueness is needed without an output vector.
+            ++count;
+        }
+
+        if (exactMatch)
+            break;
+    }
     return count;
 }
 
-void Scene::visitNode(Node* node, const char* visitMethod)
+void Scene::visit(const char* visitMethod)
+{
+    // Resolve the function once for the whole traversal.
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int function = sc->beginObjectCalls(visitMethod, NULL);
+    if (function == 0)
+        return;
+
+    DebugMarkers::Group marker("Scene", getId());
+
+    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        visitNode(node, visitMethod, function);
+    }
+    sc->endObjectCalls(function);
+}
+
+void Scene::visit(const char* visitMethod, unsigned int filter, const char* tag, const Frustum* frustum)
+{
+    GP_ASSERT(visitMethod);
+
+    std::vector<Node*> nodes;
+    if (frustum)
+    {
+        findVisibleNodes(*frustum, nodes);
+    }
+    else if (tag)
+    {
+        findNodesWithTag(tag, nodes);
+    }
+    else
+    {
+        for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+            collectNodes(node, nodes);
+    }
+
+    // Keep the nodes that match the rest of the filter.
+    unsigned int tagId = tag ? Node::getTagId(tag) : 0;
+    size_t count = 0;
+    for (size_t i = 0, nodeCount = nodes.size(); i < nodeCount; ++i)
+    {
+        Node* node = nodes[i];
+        if (frustum && tag && !node->hasTag(tagId))
+            continue;
+        if (filter && !(((filter & VISIT_MODELS) && node->getModel()) ||
+                        ((filter & VISIT_LIGHTS) && node->getLight()) ||
+                        ((filter & VISIT_CAMERAS) && node->getCamera())))
+            continue;
+        nodes[count++] = node;
+    }
+    nodes.resize(count);
+    if (nodes.empty())
+        return;
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int function = sc->beginObjectCalls(visitMethod, "Node");
+    if (function == 0)
+        return;
+
+    DebugMarkers::Group marker("Scene", getId());
+
+    // The function may remove nodes from the scene, so they are kept alive until the visit ends.
+    for (size_t i = 0; i < count; ++i)
+        nodes[i]->addRef();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!sc->callObjectFunction(function, visitMethod, NULL, nodes[i]))
+            break;
+    }
+    for (size_t i = 0; i < count; ++i)
+        nodes[i]->release();
+    sc->endObjectCalls(function);
+}
+
+void Scene::collectNodes(Node* node, std::vector<Node*>& nodes) const
+{
+    nodes.push_back(node);
+
+    if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
+    {
+        collectNodes(node->_model->_skin->_rootNode, nodes);
+    }
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        collectNodes(child, nodes);
+    }
+}
+
+void Scene::visitNode(Node* node, const char* visitMethod, int function)
 {
     ScriptController* sc = Game::getInstance()->getScriptController();
 
     // Invoke the visit method for this node.
-    if (!sc->executeFunction<bool>(visitMethod, "<Node>", node))
+    if (!sc->callObjectFunction(function, visitMethod, "Node", node))
         return;
 
     // If this node has a model with a mesh skin, visit the joint hierarchy within it
@@ -208,13 +493,13 @@ void Scene::visitNode(Node* node, const char* visitMethod)
     // models will never get visited (and therefore never get drawn).
     if (node->_model && node->_model->_skin && node->_model->_skin->_rootNode)
     {
-        visitNode(node->_model->_skin->_rootNode, visitMethod);
+        visitNode(node->_model->_skin->_rootNode, visitMethod, function);
     }
 
     // Recurse for all children.
     for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
     {
-        visitNode(child, visitMethod);
+        visitNode(child, visitMethod, function);
     }
 }
 
@@ -270,6 +555,12 @@ void Scene::addNode(Node* node)
 
     ++_nodeCount;
 
+    indexNodeTree(node);
+    _transformOrderDirty = true;
+
+    if (_octree)
+        _octree->insertTree(node);
+
     // If we don't have an active camera set, then check for one and set it.
     if (_activeCamera == NULL)
     {
@@ -325,7 +616,7 @@ Node* Scene::getFirstNode() const
 
 Camera* Scene::getActiveCamera() const
 {
-    return _activeCamera;
+    return _viewCamera ? _viewCamera : _activeCamera;
 }
 
 void Scene::setActiveCamera(Camera* camera)
@@ -383,6 +674,22 @@ void Scene::setAmbientColor(float red, float green, float blue)
     _ambientColor.set(red, green, blue);
 }
 
+LightProbes* Scene::getLightProbes() const
+{
+    return _lightProbes;
+}
+
+void Scene::setLightProbes(LightProbes* probes)
+{
+    if (probes == _lightProbes)
+        return;
+
+    SAFE_RELEASE(_lightProbes);
+    _lightProbes = probes;
+    if (_lightProbes)
+        _lightProbes->addRef();
+}
+
 const Vector3& Scene::getLightColor() const
 {
     return _lightColor;
@@ -403,192 +710,10 @@ void Scene::setLightDirection(const Vector3& direction)
     _lightDirection = direction;
 }
 
-static Material* createDebugMaterial()
-{
-    // Vertex shader for drawing colored lines.
-    const char* vs_str = 
-    {
-        "uniform mat4 u_viewProjectionMatrix;\n"
-        "attribute vec4 a_position;\n"
-        "attribute vec4 a_color;\n"
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "    v_color = a_color;\n"
-        "    gl_Position = u_viewProjectionMatrix * a_position;\n"
-        "}"
-    };
-
-    // Fragment shader for drawing colored lines.
-    const char* fs_str = 
-    {
-    #ifdef OPENGL_ES
-        "precision highp float;\n"
-    #endif
-        "varying vec4 v_color;\n"
-        "void main(void) {\n"
-        "   gl_FragColor = v_color;\n"
-        "}"
-    };
-
-    Effect* effect = Effect::createFromSource(vs_str, fs_str);
-    Material* material = Material::create(effect);
-    GP_ASSERT(material && material->getStateBlock());
-    material->getStateBlock()->setDepthTest(true);
-
-    SAFE_RELEASE(effect);
-
-    return material;
-}
-
-/**
- * DebugVertex structure.
- * @script{ignore}
- */
-struct DebugVertex
-{
-    /**
-     * The x coordinate of the vertex.
-     */
-    float x;
-
-    /**
-     * The y coordinate of the vertex.
-     */
-    float y;
-    
-    /**
-     * The z coordinate of the vertex.
-     */
-    float z;
-    
-    /** 
-     * The red color component of the vertex.
-     */
-    float r;
-
-    /** 
-     * The green color component of the vertex.
-     */
-    float g;
-    
-    /** 
-     * The blue color component of the vertex.
-     */
-    float b;
-    
-    /** 
-     * The alpha component of the vertex.
-     */
-    float a;
-};
-
-static void drawDebugLine(MeshBatch* batch, const Vector3& point1, const Vector3& point2, const Vector3& color)
-{
-    GP_ASSERT(batch);
-
-    static DebugVertex verts[2];
-
-    verts[0].x = point1.x;
-    verts[0].y = point1.y;
-    verts[0].z = point1.z;
-    verts[0].r = color.x;
-    verts[0].g = color.y;
-    verts[0].b = color.z;
-    verts[0].a = 1.0f;
-
-    verts[1].x = point2.x;
-    verts[1].y = point2.y;
-    verts[1].z = point2.z;
-    verts[1].r = color.x;
-    verts[1].g = color.y;
-    verts[1].b = color.z;
-    verts[1].a = 1.0f;
-
-    batch->add(verts, 2);
-}
-
-#define DEBUG_BOX_COLOR Vector3(0, 1, 0)
-#define DEBUG_SPHERE_COLOR Vector3(0, 1, 0)
-
-static void drawDebugBox(MeshBatch* batch, const BoundingBox& box, const Matrix& matrix)
-{
-    if (box.isEmpty())
-        return;
-
-    // Transform box into world space (since we only store local boxes on mesh)
-    BoundingBox worldSpaceBox(box);
-    worldSpaceBox.transform(matrix);
-
-    // Get box corners
-    static Vector3 corners[8];
-    worldSpaceBox.getCorners(corners);
-
-    // Draw box lines
-    drawDebugLine(batch, corners[0], corners[1], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[1], corners[2], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[2], corners[3], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[3], corners[0], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[4], corners[5], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[5], corners[6], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[6], corners[7], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[7], corners[4], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[0], corners[7], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[1], corners[6], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[2], corners[5], DEBUG_BOX_COLOR);
-    drawDebugLine(batch, corners[3], corners[4], DEBUG_BOX_COLOR);
-}
-
-static void drawDebugSphere(MeshBatch* batch, const BoundingSphere& sphere)
-{
-    if (sphere.isEmpty())
-        return;
-
-    // Draw three rings for the sphere (one for the x, y and z axes)
-    Vector3 pos1, pos2;
-    float step = MATH_PI * 0.2f;
-    float max = MATH_PIX2 + step;
-
-    // X ring
-    for (float r = 0.0f; r < max; r += step)
-    {
-        pos2.x = sphere.center.x;
-        pos2.y = sphere.center.y + std::cos(r) * sphere.radius;
-        pos2.z = sphere.center.z + std::sin(r) * sphere.radius;
-
-        if (r > 0)
-            drawDebugLine(batch, pos1, pos2, DEBUG_SPHERE_COLOR);
-
-        pos1 = pos2;
-    }
-
-    // Y ring
-    for (float r = 0.0f; r < max; r += step)
-    {
-        pos2.x = sphere.center.x + std::cos(r) * sphere.radius;
-        pos2.y = sphere.center.y;
-        pos2.z = sphere.center.z + std::sin(r) * sphere.radius;
-
-        if (r > 0)
-            drawDebugLine(batch, pos1, pos2, DEBUG_SPHERE_COLOR);
-
-        pos1 = pos2;
-    }
-
-    // Z ring
-    for (float r = 0.0f; r < max; r += step)
-    {
-        pos2.x = sphere.center.x + std::cos(r) * sphere.radius;
-        pos2.y = sphere.center.y + std::sin(r) * sphere.radius;
-        pos2.z = sphere.center.z;
+#define DEBUG_BOX_COLOR Vector4(0, 1, 0, 1)
+#define DEBUG_SPHERE_COLOR Vector4(0, 1, 0, 1)
 
-        if (r > 0)
-            drawDebugLine(batch, pos1, pos2, DEBUG_SPHERE_COLOR);
-
-        pos1 = pos2;
-    }
-}
-
-static void drawDebugNode(Scene* scene, MeshBatch* batch, Node* node, unsigned int debugFlags)
+static void drawDebugNode(Scene* scene, DebugRenderer* renderer, Node* node, unsigned int debugFlags)
 {
     GP_ASSERT(node);
 
@@ -597,7 +722,7 @@ static void drawDebugNode(Scene* scene, MeshBatch* batch, Node* node, unsigned i
     if (camera)
     {
         const BoundingSphere& sphere = node->getBoundingSphere();
-        if (!sphere.isEmpty() && !camera->getFrustum().intersects(sphere))
+        if (!sphere.isEmpty() && !camera->getFrustumPlanes().intersects(sphere))
             return;
     }
 
@@ -614,65 +739,447 @@ static void drawDebugNode(Scene* scene, MeshBatch* batch, Node* node, unsigned i
                 // For skinned meshes that have a parent node to the skin's root joint,
                 // we need to transform the bounding volume by that parent node's transform
                 // as well to get the full skinned bounding volume.
-                drawDebugBox(batch, model->getMesh()->getBoundingBox(), node->getWorldMatrix() * skin->getRootJoint()->getParent()->getWorldMatrix());
+                renderer->drawBox(model->getMesh()->getBoundingBox(), node->getWorldMatrix() * skin->getRootJoint()->getParent()->getWorldMatrix(), DEBUG_BOX_COLOR, DebugRenderer::CATEGORY_BOUNDS);
             }
             else
             {
-                drawDebugBox(batch, model->getMesh()->getBoundingBox(), node->getWorldMatrix());
+                renderer->drawBox(model->getMesh()->getBoundingBox(), node->getWorldMatrix(), DEBUG_BOX_COLOR, DebugRenderer::CATEGORY_BOUNDS);
             }
         }
 
         if (node->getTerrain())
         {
-            drawDebugBox(batch, node->getTerrain()->getBoundingBox(), node->getWorldMatrix());
+            renderer->drawBox(node->getTerrain()->getBoundingBox(), node->getWorldMatrix(), DEBUG_BOX_COLOR, DebugRenderer::CATEGORY_BOUNDS);
         }
     }
 
     if (debugFlags & Scene::DEBUG_SPHERES)
     {
-        drawDebugSphere(batch, node->getBoundingSphere());
+        renderer->drawSphere(node->getBoundingSphere(), DEBUG_SPHERE_COLOR, DebugRenderer::CATEGORY_BOUNDS);
     }
 
     for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
     {
-        drawDebugNode(scene, batch, child, debugFlags);
+        drawDebugNode(scene, renderer, child, debugFlags);
     }
 }
 
-void Scene::drawDebug(unsigned int debugFlags)
+static void collectSkins(Node* node, std::vector<MeshSkin*, FrameAllocator<MeshSkin*> >& skins)
 {
-    if (_debugBatch == NULL)
+    Model* model = node->getModel();
+    if (model && model->getSkin())
+        skins.push_back(model->getSkin());
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
     {
-        Material* material = createDebugMaterial();
+        collectSkins(child, skins);
+    }
+}
+
+void Scene::updateMatrixPalettes()
+{
+    std::vector<MeshSkin*, FrameAllocator<MeshSkin*> > skins;
+    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        collectSkins(node, skins);
+    }
+
+    if (!skins.empty())
+        MeshSkin::updateMatrixPalettes(&skins[0], (unsigned int)skins.size());
+}
 
-        VertexFormat::Element elements[] =
+void Scene::buildTransformOrder()
+{
+    _transformNodes.clear();
+    _transformParents.clear();
+    _transformEnds.clear();
+    for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+    {
+        addTransformOrder(node, -1);
+    }
+    _transformWorlds.resize(_transformNodes.size());
+    _transformBoxes.resize(_transformNodes.size());
+    _transformBoxVersions.assign(_transformNodes.size(), 0);
+    _transformOrderDirty = false;
+    _lightsDirty = true;
+}
+
+void Scene::addTransformOrder(Node* node, int parent)
+{
+    unsigned int index = (unsigned int)_transformNodes.size();
+    _transformNodes.push_back(node);
+    _transformParents.push_back(parent);
+    _transformEnds.push_back(0);
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        addTransformOrder(child, (int)index);
+    }
+    _transformEnds[index] = (unsigned int)_transformNodes.size();
+}
+
+void Scene::addTransformRange(unsigned int start, bool split)
+{
+    unsigned int end = _transformEnds[start];
+    if (!split || end - start <= SCENE_TRANSFORM_SPLIT_SIZE)
+    {
+        _transformRanges.push_back(start);
+        return;
+    }
+
+    // The subtrees of the children only depend on the root, so update it now and queue them separately.
+    int parent = _transformParents[start];
+    _transformNodes[start]->updateWorldMatrix(parent >= 0 ? &_transformNodes[parent]->getWorldMatrix() : NULL);
+    _transformWorlds[start] = _transformNodes[start]->_world;
+    for (unsigned int child = start + 1; child < end; child = _transformEnds[child])
+    {
+        addTransformRange(child, true);
+    }
+}
+
+void Scene::updateTransformRange(unsigned int start)
+{
+    for (unsigned int i = start, end = _transformEnds[start]; i < end; ++i)
+    {
+        // Parents inside the range were just written to the contiguous array. The parent of
+        // the first node is outside of it and already up to date.
+        int parent = _transformParents[i];
+        const Matrix* parentWorld = NULL;
+        if (parent >= (int)start)
+            parentWorld = &_transformWorlds[parent];
+        else if (parent >= 0)
+            parentWorld = &_transformNodes[parent]->getWorldMatrix();
+
+        Node* node = _transformNodes[i];
+        node->updateWorldMatrix(parentWorld);
+        _transformWorlds[i] = node->_world;
+    }
+}
+
+void Scene::updateTransformRanges(unsigned int start, unsigned int end, void* cookie)
+{
+    Scene* scene = (Scene*)cookie;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        scene->updateTransformRange(scene->_transformRanges[i]);
+    }
+}
+
+void Scene::updateTransforms()
+{
+    if (_transformOrderDirty)
+        buildTransformOrder();
+
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    bool parallel = scheduler && scheduler->getWorkerCount() > 0;
+
+    // Changing the transform of a node dirties all of its descendants, so the first dirty
+    // node found in depth-first order starts a range that holds its whole subtree.
+    _transformRanges.clear();
+    unsigned int dirtyCount = 0;
+    for (unsigned int i = 0, count = (unsigned int)_transformNodes.size(); i < count; )
+    {
+        if (_transformNodes[i]->isWorldMatrixDirty())
+        {
+            addTransformRange(i, parallel);
+            dirtyCount += _transformEnds[i] - i;
+            i = _transformEnds[i];
+        }
+        else
         {
-            VertexFormat::Element(VertexFormat::POSITION, 3),
-            VertexFormat::Element(VertexFormat::COLOR, 4)
-        };
+            ++i;
+        }
+    }
+
+    unsigned int rangeCount = (unsigned int)_transformRanges.size();
+    if (parallel && rangeCount > 1 && dirtyCount > SCENE_TRANSFORM_SPLIT_SIZE)
+    {
+        scheduler->parallelFor(rangeCount, updateTransformRanges, this);
+    }
+    else
+    {
+        updateTransformRanges(0, rangeCount, this);
+    }
+
+    updateBounds();
+}
+
+void Scene::updateBounds()
+{
+    if (_transformOrderDirty)
+        buildTransformOrder();
 
-        _debugBatch = MeshBatch::create(VertexFormat(elements, 2), Mesh::LINES, material, false);
+    // The parents of a node with dirty bounds are dirty too, so a node that is clean and
+    // whose box was already stored heads a subtree that has not changed.
+    _boundsPath.clear();
+    for (unsigned int i = 0, count = (unsigned int)_transformNodes.size(); i < count; )
+    {
+        Node* node = _transformNodes[i];
+        if (!node->isBoundingBoxDirty() && node->_boxVersion == _transformBoxVersions[i])
+        {
+            i = _transformEnds[i];
+        }
+        else
+        {
+            _boundsPath.push_back(i);
+            ++i;
+        }
+    }
 
-        SAFE_RELEASE(material);
+    // Refit children before their parents, so that each node only merges up to date volumes.
+    for (size_t j = _boundsPath.size(); j-- > 0; )
+    {
+        unsigned int i = _boundsPath[j];
+        Node* node = _transformNodes[i];
+        node->getBoundingSphere();
+        _transformBoxes[i] = node->getBoundingBox();
+        _transformBoxVersions[i] = node->_boxVersion;
     }
+}
 
-    _debugBatch->start();
+void Scene::enableSpatialIndex(const BoundingBox& bounds, unsigned int maxDepth)
+{
+    SAFE_DELETE(_octree);
+    _octree = new Octree(bounds, maxDepth);
 
     for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
     {
-        drawDebugNode(this, _debugBatch, node, debugFlags);
+        _octree->insertTree(node);
+    }
+}
+
+void Scene::disableSpatialIndex()
+{
+    SAFE_DELETE(_octree);
+}
+
+bool Scene::isSpatialIndexEnabled() const
+{
+    return _octree != NULL;
+}
+
+// Tests a box against the planes of a frustum, using the corner of the box furthest along each plane normal.
+static bool isBoxInside(const BoundingBox& box, const Plane* const* planes)
+{
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        const Vector3& n = planes[i]->getNormal();
+        float x = n.x >= 0.0f ? box.max.x : box.min.x;
+        float y = n.y >= 0.0f ? box.max.y : box.min.y;
+        float z = n.z >= 0.0f ? box.max.z : box.min.z;
+        if (n.x * x + n.y * y + n.z * z + planes[i]->getDistance() < 0.0f)
+            return false;
     }
+    return true;
+}
 
-    _debugBatch->finish();
+// Node bounding spheres contain their children, so subtrees failing a test are skipped.
+static void raycastNodes(Node* node, const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits)
+{
+    float distance = ray.intersects(node->getBoundingSphere());
+    if (distance == Ray::INTERSECTS_NONE || distance > maxDistance)
+        return;
 
-    if (_activeCamera)
+    hits.push_back(std::make_pair(distance, node));
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        raycastNodes(child, ray, maxDistance, hits);
+    }
+}
+
+static bool compareHits(const std::pair<float, Node*>& a, const std::pair<float, Node*>& b)
+{
+    return a.first < b.first;
+}
+
+unsigned int Scene::findVisibleNodes(const Frustum& frustum, std::vector<Node*>& nodes)
+{
+    size_t count = nodes.size();
+    if (_octree)
+    {
+        _octree->findNodes(frustum, nodes);
+    }
+    else
+    {
+        updateBounds();
+
+        const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(), &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+        for (unsigned int i = 0, nodeCount = (unsigned int)_transformNodes.size(); i < nodeCount; )
+        {
+            // Node boxes contain their children, so subtrees of boxes outside the frustum are skipped.
+            if (!isBoxInside(_transformBoxes[i], planes))
+            {
+                i = _transformEnds[i];
+                continue;
+            }
+            nodes.push_back(_transformNodes[i]);
+            ++i;
+        }
+    }
+    return (unsigned int)(nodes.size() - count);
+}
+
+unsigned int Scene::queryNodes(const BoundingBox& box, std::vector<Node*>& nodes)
+{
+    size_t count = nodes.size();
+    if (_octree)
+    {
+        _octree->findNodes(box, nodes);
+    }
+    else
+    {
+        updateBounds();
+
+        for (unsigned int i = 0, nodeCount = (unsigned int)_transformNodes.size(); i < nodeCount; )
+        {
+            if (!box.intersects(_transformBoxes[i]))
+            {
+                i = _transformEnds[i];
+                continue;
+            }
+            nodes.push_back(_transformNodes[i]);
+            ++i;
+        }
+    }
+    return (unsigned int)(nodes.size() - count);
+}
+
+static float getLuminance(const Vector3& color)
+{
+    return 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+}
+
+static void insertLight(Node* node, float score, Node** lights, float* scores, unsigned int* count, unsigned int maxCount)
+{
+    if (score <= 0.0f)
+        return;
+
+    // Keep the lights sorted by score; a full list drops its last light.
+    unsigned int i = *count;
+    if (i == maxCount)
+    {
+        if (score <= scores[i - 1])
+            return;
+        --i;
+    }
+    else
+    {
+        ++(*count);
+    }
+    for (; i > 0 && scores[i - 1] < score; --i)
+    {
+        lights[i] = lights[i - 1];
+        scores[i] = scores[i - 1];
+    }
+    lights[i] = node;
+    scores[i] = score;
+}
+
+unsigned int Scene::selectLights(const BoundingSphere& bounds, Node** lights, unsigned int maxCount)
+{
+    GP_ASSERT(lights || maxCount == 0);
+
+    if (maxCount == 0)
+        return 0;
+
+    if (_transformOrderDirty)
+        buildTransformOrder();
+    if (_lightsDirty)
+    {
+        _directionalLights.clear();
+        for (size_t i = 0, count = _transformNodes.size(); i < count; ++i)
+        {
+            Light* light = _transformNodes[i]->getLight();
+            if (light && light->getLightType() == Light::DIRECTIONAL)
+                _directionalLights.push_back(_transformNodes[i]);
+        }
+        _lightsDirty = false;
+    }
+
+    _lightScores.resize(maxCount);
+    float* scores = &_lightScores[0];
+    unsigned int count = 0;
+
+    for (size_t i = 0, lightCount = _directionalLights.size(); i < lightCount; ++i)
+    {
+        Node* node = _directionalLights[i];
+        insertLight(node, getLuminance(node->getLight()->getColor()), lights, scores, &count, maxCount);
+    }
+
+    // The bounds of the nodes of point and spot lights include the sphere of their range.
+    Vector3 extent(bounds.radius, bounds.radius, bounds.radius);
+    BoundingBox box(bounds.center - extent, bounds.center + extent);
+    _lightQuery.clear();
+    queryNodes(box, _lightQuery);
+    for (size_t i = 0, nodeCount = _lightQuery.size(); i < nodeCount; ++i)
+    {
+        Node* node = _lightQuery[i];
+        Light* light = node->getLight();
+        if (!light || light->getLightType() == Light::DIRECTIONAL)
+            continue;
+
+        float range = light->getRange();
+        float distance = node->getTranslationWorld().distance(bounds.center) - bounds.radius;
+        if (distance >= range)
+            continue;
+
+        float attenuation = 1.0f;
+        if (distance > 0.0f)
+        {
+            float scaled = distance / range;
+            attenuation -= scaled * scaled;
+        }
+        insertLight(node, getLuminance(light->getColor()) * attenuation, lights, scores, &count, maxCount);
+    }
+    return count;
+}
+
+unsigned int Scene::raycast(const Ray& ray, std::vector<Node*>& nodes, float maxDistance)
+{
+    std::vector<std::pair<float, Node*> > hits;
+    if (_octree)
+    {
+        _octree->findNodes(ray, maxDistance, hits);
+    }
+    else
+    {
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            raycastNodes(node, ray, maxDistance, hits);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), compareHits);
+    for (size_t i = 0, count = hits.size(); i < count; ++i)
+    {
+        nodes.push_back(hits[i].second);
+    }
+    return (unsigned int)hits.size();
+}
+
+void Scene::setParticleBudget(unsigned int budget)
+{
+    _particleBudget = budget;
+}
+
+unsigned int Scene::getParticleBudget() const
+{
+    return _particleBudget;
+}
+
+void Scene::drawDebug(unsigned int debugFlags)
+{
+    DebugRenderer* renderer = Game::getInstance()->getDebugRenderer();
+    GP_ASSERT(renderer);
+    if (!renderer->isEnabled(DebugRenderer::CATEGORY_BOUNDS))
+        return;
+
+    for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
     {
-        GP_ASSERT(_debugBatch->getMaterial());
-        GP_ASSERT(_debugBatch->getMaterial()->getParameter("u_viewProjectionMatrix"));
-        _debugBatch->getMaterial()->getParameter("u_viewProjectionMatrix")->setValue(_activeCamera->getViewProjectionMatrix());
+        drawDebugNode(this, renderer, node, debugFlags);
     }
 
-    _debugBatch->draw();
+    renderer->flush(_activeCamera ? _activeCamera->getViewProjectionMatrix() : Matrix::identity());
 }
 
 }
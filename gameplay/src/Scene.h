@@ -5,6 +5,8 @@
 #include "MeshBatch.h"
 #include "ScriptController.h"
 #include "Light.h"
+#include "LightProbes.h"
+#include "DebugMarkers.h"
 
 namespace gameplay
 {
@@ -14,6 +16,11 @@ namespace gameplay
  */
 class Scene : public Ref
 {
+    friend class Node;
+    friend class Model;
+    friend class MeshSkin;
+    friend class RenderQueue;
+
 public:
 
     /**
@@ -25,6 +32,16 @@ public:
         DEBUG_SPHERES = 2
     };
 
+    /**
+     * Enumeration of the components that select the nodes visited by a filtered Lua visit.
+     */
+    enum VisitFilter
+    {
+        VISIT_MODELS = 1,
+        VISIT_LIGHTS = 2,
+        VISIT_CAMERAS = 4
+    };
+
     /**
      * Creates a new empty scene.
      * 
@@ -37,6 +54,10 @@ public:
 
     /**
      * Loads a scene from the given '.scene' or '.gpb' file.
+     *
+     * The files a '.scene' file references are each parsed once, on the worker threads.
+     * Setting 'logLoadTimes = true' in the 'scenes' namespace of the game config prints
+     * the time taken by each stage of the load.
      * 
      * @param filePath The path to the '.scene' or '.gpb' file to load from.
      * @return The loaded scene or <code>NULL</code> if the scene
@@ -85,6 +106,9 @@ public:
     /**
      * Returns all nodes in the scene that match the given ID.
      *
+     * Recursive searches are served by the scene's node ID index and return the
+     * matches in no particular order.
+     *
      * @param id The ID of the node to find.
      * @param nodes Vector of nodes to be populated with matches.
      * @param recursive true if a recursive search should be performed, false otherwise.
@@ -96,6 +120,34 @@ public:
      */
     unsigned int findNodes(const char* id, std::vector<Node*>& nodes, bool recursive = true, bool exactMatch = true) const;
 
+    /**
+     * Returns all nodes in the scene that have the specified tag.
+     *
+     * The scene keeps an index of its tagged nodes, so the matches are found without
+     * visiting the scene, in no particular order. Nodes of the joint hierarchies of
+     * skins are not included.
+     *
+     * @param name The name of the tag.
+     * @param nodes Vector of nodes to be populated with matches.
+     *
+     * @return The number of matches found.
+     * @script{ignore}
+     */
+    unsigned int findNodesWithTag(const char* name, std::vector<Node*>& nodes) const;
+
+    /**
+     * Gets the nodes in the scene that have the tag with the specified ID.
+     *
+     * The vector is the index of the scene itself: it must not be kept across changes to
+     * the scene, its hierarchy or the tags of its nodes.
+     *
+     * @param tagId The ID of the tag (see Node::getTagId).
+     *
+     * @return The nodes with the tag, in no particular order.
+     * @script{ignore}
+     */
+    const std::vector<Node*>& getNodesWithTag(unsigned int tagId) const;
+
     /**
      * Creates and adds a new node to the scene.
      *
@@ -141,6 +193,9 @@ public:
     /**
      * Gets the active camera for the scene.
      *
+     * While a RenderQueue with several views draws one of them, this is the camera
+     * of that view, so that the matrices bound to materials are the view's.
+     *
      * @return The active camera for the scene.
      */
     Camera* getActiveCamera() const;
@@ -182,6 +237,25 @@ public:
      */
     void setAmbientColor(float red, float green, float blue);
 
+    /**
+     * Gets the light probes that light the dynamic objects of the scene.
+     *
+     * The probes are baked by the encoder for scenes whose static geometry is lit by lightmaps,
+     * and bound to materials through the SCENE_LIGHT_PROBE auto binding.
+     *
+     * @return The light probes, or NULL if the scene has none.
+     * @script{ignore}
+     */
+    LightProbes* getLightProbes() const;
+
+    /**
+     * Sets the light probes that light the dynamic objects of the scene.
+     *
+     * @param probes The light probes, or NULL to light dynamic objects with the ambient color.
+     * @script{ignore}
+     */
+    void setLightProbes(LightProbes* probes);
+
     /**
      * Returns the light color of the scene.
      *
@@ -286,16 +360,181 @@ public:
      *
      * @param visitMethod The name of the Lua function to call for each node in the scene.
      */
-    inline void visit(const char* visitMethod);
+    void visit(const char* visitMethod);
+
+    /**
+     * Visits the nodes of the scene that match a filter and calls the specified Lua function for each of them.
+     *
+     * The nodes are selected natively and the function is only called for the matching ones. It is
+     * resolved once for the whole visit, and it is passed the same Node userdata every time, pointing
+     * at the node being visited, so it must not keep the node it is given beyond the call.
+     *
+     * With a frustum, the nodes are found as by findVisibleNodes; with a tag but no frustum, from the
+     * tag index of the scene. Otherwise the whole hierarchy is walked, joint hierarchies included.
+     * The visit stops when the function returns false.
+     *
+     * @param visitMethod The name of the Lua function to call for each matching node.
+     * @param filter Bitwise combination of VisitFilter values; a node matches if it has any of the
+     *      components, or 0 to match nodes regardless of their components.
+     * @param tag The name of a tag the nodes must have, or NULL.
+     * @param frustum A frustum the bounding volumes of the nodes must intersect, or NULL.
+     */
+    void visit(const char* visitMethod, unsigned int filter, const char* tag = NULL, const Frustum* frustum = NULL);
 
     /**
      * Draws debugging information (bounding volumes, etc.) for the scene.
      *
+     * The volumes are drawn through the game's DebugRenderer, in its bounds category,
+     * together with the other debug primitives drawn since its last flush. Nothing is
+     * visited when the bounds category is disabled.
+     *
      * @param debugFlags Bitwise combination of debug flags from the DebugFlags
      *        enumeration, specifying which debugging information to draw.
      */
     void drawDebug(unsigned int debugFlags);
 
+    /**
+     * Computes the matrix palettes of all skinned models in the scene.
+     *
+     * The palettes of skins whose joints have changed are computed in parallel
+     * on the job scheduler. Calling this once per frame, after updating and
+     * before rendering, keeps the palette work out of the individual draw calls.
+     */
+    void updateMatrixPalettes();
+
+    /**
+     * Computes the world matrices of all nodes in the scene whose transform has changed.
+     *
+     * The nodes are kept in a depth-first array, rebuilt when the hierarchy changes,
+     * in which each subtree is a contiguous range. Dirty subtrees are updated in a
+     * single pass over their range, parents first and without recursion, and large
+     * subtrees are split across the job scheduler. Calling this once per frame, after
+     * updating and before rendering, turns the lazy updates otherwise done by
+     * Node::getWorldMatrix during rendering into simple lookups.
+     */
+    void updateTransforms();
+
+    /**
+     * Refits the world bounding volumes of the nodes whose transform or data has changed.
+     *
+     * The world-space bounding boxes of the nodes are kept in a contiguous array in the
+     * same depth-first order as updateTransforms. Only the nodes on the paths from the
+     * changed nodes up to the roots are refitted, children first, so each node merges
+     * the volumes of its children without recursing into them. The bounding spheres of
+     * those nodes are refitted in the same pass.
+     *
+     * This is called by updateTransforms, and by findVisibleNodes and queryNodes before
+     * they walk the array.
+     */
+    void updateBounds();
+
+    /**
+     * Enables a spatial index (a loose octree) over the nodes of the scene.
+     *
+     * Once enabled, findVisibleNodes, queryNodes and raycast only test the nodes in
+     * the cells of the index that pass the query, instead of every node in the scene.
+     * Nodes move between cells automatically when their transform or bounds change.
+     *
+     * Nodes outside the given bounds are still indexed, but are tested by every query.
+     * Calling this again rebuilds the index with the new bounds.
+     *
+     * @param bounds The region of the scene to partition.
+     * @param maxDepth The maximum depth of the octree.
+     */
+    void enableSpatialIndex(const BoundingBox& bounds, unsigned int maxDepth = 8);
+
+    /**
+     * Disables the spatial index of the scene.
+     */
+    void disableSpatialIndex();
+
+    /**
+     * Determines whether the scene has a spatial index.
+     *
+     * @return true if the spatial index is enabled, false otherwise.
+     */
+    bool isSpatialIndexEnabled() const;
+
+    /**
+     * Finds all nodes whose bounding volumes intersect the specified frustum.
+     *
+     * Without a spatial index, the world bounding boxes of the nodes are tested, and
+     * the subtrees of nodes whose boxes are outside the frustum are skipped. With a
+     * spatial index, the bounding spheres of the nodes are tested.
+     *
+     * @param frustum The frustum to test, typically the frustum of the active camera.
+     * @param nodes Vector of nodes to be populated with the visible nodes.
+     *
+     * @return The number of nodes found.
+     * @script{ignore}
+     */
+    unsigned int findVisibleNodes(const Frustum& frustum, std::vector<Node*>& nodes);
+
+    /**
+     * Finds all nodes whose bounding volumes intersect the specified box.
+     *
+     * Without a spatial index, the world bounding boxes of the nodes are tested, and
+     * with one, their bounding spheres.
+     *
+     * @param box The box to test.
+     * @param nodes Vector of nodes to be populated with matches.
+     *
+     * @return The number of nodes found.
+     * @script{ignore}
+     */
+    unsigned int queryNodes(const BoundingBox& box, std::vector<Node*>& nodes);
+
+    /**
+     * Selects the lights that contribute the most to a bounding volume.
+     *
+     * This is how forward materials are lit when clustered lighting is not used: each drawn
+     * node binds only the few lights that matter to it, through the NODE_LIGHTS auto binding.
+     *
+     * The point and spot lights are found with queryNodes, and are kept if the sphere of
+     * their range reaches the volume. Each light is scored by the luminance of its color,
+     * attenuated by the distance from the light to the volume as the shaders attenuate it;
+     * directional lights reach everything and are scored by their luminance alone. The
+     * lights with the highest scores are returned, best first.
+     *
+     * @param bounds The bounding volume to light, in world space.
+     * @param lights The array to populate with the nodes of the selected lights.
+     * @param maxCount The maximum number of lights to select.
+     *
+     * @return The number of lights selected.
+     * @script{ignore}
+     */
+    unsigned int selectLights(const BoundingSphere& bounds, Node** lights, unsigned int maxCount);
+
+    /**
+     * Finds all nodes whose bounding spheres are hit by the specified ray.
+     *
+     * @param ray The ray to test.
+     * @param nodes Vector of nodes to be populated with the hit nodes, sorted from nearest to farthest.
+     * @param maxDistance The maximum distance along the ray.
+     *
+     * @return The number of nodes found.
+     * @script{ignore}
+     */
+    unsigned int raycast(const Ray& ray, std::vector<Node*>& nodes, float maxDistance = FLT_MAX);
+
+    /**
+     * Sets the maximum number of particles that the emitters in this scene may have alive.
+     *
+     * The budget is shared out by the game's ParticleManager.
+     *
+     * @param budget The particle budget, or 0 to use the default budget of the particle manager.
+     * @script{ignore}
+     */
+    void setParticleBudget(unsigned int budget);
+
+    /**
+     * Gets the maximum number of particles that the emitters in this scene may have alive.
+     *
+     * @return The particle budget, or 0 if the default budget of the particle manager is used.
+     * @script{ignore}
+     */
+    unsigned int getParticleBudget() const;
+
 private:
 
     /**
@@ -331,25 +570,124 @@ private:
     void visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*,C), C cookie);
 
     /**
-     * Visits the given node and all of its children recursively.
+     * Visits the given node and all of its children recursively, calling the Lua function
+     * pushed at the given stack position by ScriptController::beginObjectCalls.
+     */
+    void visitNode(Node* node, const char* visitMethod, int function);
+
+    /**
+     * Adds the given node and all of its children recursively, joint hierarchies included, to a list.
+     */
+    void collectNodes(Node* node, std::vector<Node*>& nodes) const;
+
+    /**
+     * Adds the node, its descendants and the joint hierarchies of their skins to the node ID index,
+     * and the tags of the node and its descendants to the tag index unless tags is false.
+     */
+    void indexNodeTree(Node* node, bool tags = true);
+
+    /**
+     * Removes the node, its descendants and the joint hierarchies of their skins from the node ID index,
+     * and the tags of the node and its descendants from the tag index unless tags is false.
      */
-    void visitNode(Node* node, const char* visitMethod);
+    void unindexNodeTree(Node* node, bool tags = true);
+
+    /**
+     * Adds a single node to the node ID index.
+     */
+    void indexNode(Node* node);
+
+    /**
+     * Removes a single node from the node ID index.
+     */
+    void unindexNode(Node* node);
+
+    /**
+     * Adds a node to the tag index for one of its tags.
+     */
+    void indexNodeTag(Node* node, unsigned int tagId);
+
+    /**
+     * Removes a node from the tag index for one of its tags.
+     */
+    void unindexNodeTag(Node* node, unsigned int tagId);
+
+    /**
+     * Rebuilds the node ID and tag indices if they are dirty.
+     */
+    void updateNodeIndex() const;
+
+    /**
+     * Finds the indexed nodes whose ID matches the given ID.
+     *
+     * @param id The ID to match.
+     * @param exactMatch true to match the ID exactly, false to match IDs starting with it.
+     * @param nodes Vector to populate with the matches, or NULL to stop counting after two matches.
+     * @param first Populated with the first match, if not NULL.
+     *
+     * @return The number of matches.
+     */
+    unsigned int findIndexedNodes(const char* id, bool exactMatch, std::vector<Node*>* nodes, Node** first) const;
+
+    /**
+     * Rebuilds the depth-first node array used by updateTransforms.
+     */
+    void buildTransformOrder();
+
+    /**
+     * Appends the node and its descendants to the depth-first node array.
+     */
+    void addTransformOrder(Node* node, int parent);
+
+    /**
+     * Queues the dirty subtree starting at the given index for updateTransforms,
+     * splitting it into the subtrees of its children if it is large.
+     */
+    void addTransformRange(unsigned int start, bool split);
+
+    /**
+     * Computes the world matrices of the nodes of a subtree.
+     */
+    void updateTransformRange(unsigned int start);
+
+    static void updateTransformRanges(unsigned int start, unsigned int end, void* cookie);
 
     std::string _id;
     Camera* _activeCamera;
+    Camera* _viewCamera;
     Node* _firstNode;
     Node* _lastNode;
     unsigned int _nodeCount;
     Vector3 _ambientColor;
+    LightProbes* _lightProbes;
     Vector3 _lightColor;
     Vector3 _lightDirection;
     bool _bindAudioListenerToCamera;
-    MeshBatch* _debugBatch;
+    Octree* _octree;
+    unsigned int _particleBudget;
+    mutable std::map<unsigned int, std::vector<Node*> > _nodeIndex;
+    mutable std::set<std::string> _nodeIds;
+    mutable std::vector<std::vector<Node*> > _tagIndex; // Nodes with each tag, by tag ID.
+    mutable bool _nodeIndexDirty;
+    std::vector<Node*> _transformNodes;                 // All nodes of the scene, depth first.
+    std::vector<int> _transformParents;                 // Index of the parent of each node, or -1.
+    std::vector<unsigned int> _transformEnds;           // One past the index of the last descendant of each node.
+    std::vector<Matrix> _transformWorlds;               // World matrix of each node, written by updateTransforms.
+    std::vector<unsigned int> _transformRanges;         // Start index of each dirty subtree.
+    std::vector<BoundingBox> _transformBoxes;           // World bounding box of each node, written by updateBounds.
+    std::vector<unsigned int> _transformBoxVersions;    // Bounding box version of each node when its box was stored.
+    std::vector<unsigned int> _boundsPath;              // Nodes refitted by updateBounds, parents first.
+    bool _transformOrderDirty;
+    std::vector<Node*> _directionalLights;              // Nodes with a directional light, for selectLights.
+    std::vector<Node*> _lightQuery;                     // Nodes found by selectLights, reused between calls.
+    std::vector<float> _lightScores;                    // Scores of the lights selected by selectLights.
+    bool _lightsDirty;
 };
 
 template <class T>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*))
 {
+    DebugMarkers::Group marker("Scene", getId());
     for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
     {
         visitNode(node, instance, visitMethod);
@@ -359,20 +697,13 @@ void Scene::visit(T* instance, bool (T::*visitMethod)(Node*))
 template <class T, class C>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*,C), C cookie)
 {
+    DebugMarkers::Group marker("Scene", getId());
     for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
     {
         visitNode(node, instance, visitMethod, cookie);
     }
 }
 
-inline void Scene::visit(const char* visitMethod)
-{
-    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
-    {
-        visitNode(node, visitMethod);
-    }
-}
-
 template <class T>
 void Scene::visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*))
 {
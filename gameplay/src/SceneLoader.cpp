@@ -3,6 +3,8 @@
 #include "Game.h"
 #include "Bundle.h"
 #include "SceneLoader.h"
+#include "LoadProfiler.h"
+#include "StaticBatcher.h"
 #include "Terrain.h"
 #include "Light.h"
 
@@ -13,14 +15,30 @@ namespace gameplay
 extern void calculateNamespacePath(const std::string& urlString, std::string& fileString, std::vector<std::string>& namespacePath);
 extern Properties* getPropertiesFromNamespacePath(Properties* properties, const std::vector<std::string>& namespacePath);
 
+SceneLoader::SceneLoader()
+    : _stageStart(0.0)
+{
+}
+
+SceneLoader::~SceneLoader()
+{
+    for (std::map<std::string, Bundle*>::iterator itr = _bundles.begin(); itr != _bundles.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+}
+
 Scene* SceneLoader::load(const char* url)
 {
+    LoadProfiler::Scope profile("scene", url);
     SceneLoader loader;
     return loader.loadInternal(url);
 }
 
 Scene* SceneLoader::loadInternal(const char* url)
 {
+    _stageStart = Game::getAbsoluteTime();
+
     // Get the file part of the url that we are loading the scene from.
     std::string urlStr = url ? url : "";
     std::string id;
@@ -52,7 +70,9 @@ Scene* SceneLoader::loadInternal(const char* url)
 
     // Build the node URL/property and animation reference tables and load the referenced files/store the inline properties objects.
     buildReferenceTables(sceneProperties);
+    endStage("scene file");
     loadReferencedFiles();
+    endStage("referenced files");
 
     // Load the main scene data from GPB and apply the global scene properties.
     Scene* scene = NULL;
@@ -72,6 +92,7 @@ Scene* SceneLoader::loadInternal(const char* url)
         // Create a new empty scene
         scene = Scene::create(sceneProperties->getId());
     }
+    endStage("main bundle");
 
     // First apply the node url properties. Following that,
     // apply the normal node properties and create the animations.
@@ -79,6 +100,13 @@ Scene* SceneLoader::loadInternal(const char* url)
     // so that the transform (SRT) properties get applied before
     // processing physics collision objects.
     applyNodeUrls(scene);
+    endStage("node urls");
+
+    // The textures of all materials are decoded together, ahead of the materials that use them.
+    std::vector<Texture*> preloadedTextures;
+    preloadTextures(&preloadedTextures);
+    endStage("textures");
+
     applyNodeProperties(scene, sceneProperties, 
         SceneNodeProperty::AUDIO | 
         SceneNodeProperty::MATERIAL | 
@@ -90,6 +118,12 @@ Scene* SceneLoader::loadInternal(const char* url)
         SceneNodeProperty::SCALE |
         SceneNodeProperty::TRANSLATE);
     applyNodeProperties(scene, sceneProperties, SceneNodeProperty::COLLISION_OBJECT);
+    endStage("node properties");
+
+    for (size_t i = 0, count = preloadedTextures.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(preloadedTextures[i]);
+    }
 
     // Apply node tags
     for (size_t i = 0, sncount = _sceneNodes.size(); i < sncount; ++i)
@@ -122,6 +156,7 @@ Scene* SceneLoader::loadInternal(const char* url)
 
     // Create animations for scene
     createAnimations(scene);
+    endStage("animations");
 
     // Find the physics properties object.
     Properties* physics = NULL;
@@ -139,6 +174,12 @@ Scene* SceneLoader::loadInternal(const char* url)
     // Load physics properties and constraints.
     if (physics)
         loadPhysics(physics, scene);
+    endStage("physics");
+
+    // Merge the static geometry once the collision objects that mark nodes static exist.
+    if (sceneProperties->getBool("staticBatching"))
+        StaticBatcher::batch(scene, sceneProperties->exists("staticBatchCellSize") ? sceneProperties->getFloat("staticBatchCellSize") : 32.0f);
+    endStage("static batching");
 
     // Clean up all loaded properties objects.
     std::map<std::string, Properties*>::iterator iter = _propertiesFromFile.begin();
@@ -150,6 +191,7 @@ Scene* SceneLoader::loadInternal(const char* url)
     // Clean up the .scene file's properties object.
     SAFE_DELETE(properties);
 
+    logStageTimes();
     return scene;
 }
 
@@ -249,6 +291,10 @@ void SceneLoader::applyNodeProperty(SceneNode& sceneNode, Node* node, const Prop
             else
             {
                 Material* material = Material::create(p);
+                if (material)
+                {
+                    material->_url = snp._url;
+                }
                 node->getModel()->setMaterial(material, snp._index);
                 SAFE_RELEASE(material);
             }
@@ -454,10 +500,8 @@ void SceneLoader::applyNodeUrls(Scene* scene)
             {
                 // An external file was referenced, so load the node(s) from file and then insert it into the scene with the new ID.
 
-                // TODO: Revisit this to determine if we should cache Bundle objects for the duration of the scene
-                // load to prevent constantly creating/destroying the same externally referenced bundles each time
-                // a url with a file is encountered.
-                Bundle* tmpBundle = Bundle::create(file.c_str());
+                // Bundles stay open for the rest of the load, since several nodes often come from the same one.
+                Bundle* tmpBundle = getBundle(file);
                 if (tmpBundle)
                 {
                     if (sceneNode._exactMatch)
@@ -506,8 +550,6 @@ void SceneLoader::applyNodeUrls(Scene* scene)
                             GP_ERROR("Could not find any nodes matching '%s' in GPB file '%s'.", id.c_str(), file.c_str());
                         }
                     }
-
-                    SAFE_RELEASE(tmpBundle);
                 }
                 else
                 {
@@ -872,7 +914,7 @@ Scene* SceneLoader::loadMainSceneData(const Properties* sceneProperties)
     GP_ASSERT(sceneProperties);
 
     // Load the main scene from the specified path.
-    Bundle* bundle = Bundle::create(_gpbPath.c_str());
+    Bundle* bundle = getBundle(_gpbPath);
     if (!bundle)
     {
         GP_ERROR("Failed to load scene GPB file '%s'.", _gpbPath.c_str());
@@ -884,11 +926,9 @@ Scene* SceneLoader::loadMainSceneData(const Properties* sceneProperties)
     if (!scene)
     {
         GP_ERROR("Failed to load scene from '%s'.", _gpbPath.c_str());
-        SAFE_RELEASE(bundle);
         return NULL;
     }
 
-    SAFE_RELEASE(bundle);
     return scene;
 }
 
@@ -1001,9 +1041,66 @@ void SceneLoader::loadPhysics(Properties* physics, Scene* scene)
     }
 }
 
+void SceneLoader::preloadTextures(std::vector<Texture*>* textures)
+{
+    GP_ASSERT(textures);
+
+    std::vector<std::string> paths;
+    for (size_t i = 0, sncount = _sceneNodes.size(); i < sncount; ++i)
+    {
+        const SceneNode& sceneNode = _sceneNodes[i];
+        for (size_t p = 0, pcount = sceneNode._properties.size(); p < pcount; ++p)
+        {
+            const SceneNodeProperty& snp = sceneNode._properties[p];
+            if (snp._type != SceneNodeProperty::MATERIAL || sceneNode._nodes.empty())
+                continue;
+
+            Properties* properties = _properties[snp._url];
+            if (properties)
+            {
+                gatherTexturePaths((strlen(properties->getNamespace()) > 0) ? properties : properties->getNamespaceAt(0), &paths);
+            }
+        }
+    }
+    if (paths.empty())
+        return;
+
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    std::vector<const char*> pathStrings(paths.size());
+    for (size_t i = 0, count = paths.size(); i < count; ++i)
+        pathStrings[i] = paths[i].c_str();
+
+    // Failures are reported again when the materials are created.
+    textures->resize(paths.size());
+    Texture::createBatch(&pathStrings[0], (unsigned int)pathStrings.size(), &(*textures)[0]);
+}
+
+void SceneLoader::gatherTexturePaths(Properties* properties, std::vector<std::string>* paths)
+{
+    if (properties == NULL)
+        return;
+
+    for (unsigned int i = 0, count = properties->getNamespaceCount(); i < count; ++i)
+    {
+        Properties* ns = properties->getNamespaceAt(i);
+        std::string path;
+        if (strcmp(ns->getNamespace(), "sampler") == 0)
+        {
+            if (ns->getPath("path", &path))
+                paths->push_back(path);
+        }
+        else
+        {
+            gatherTexturePaths(ns, paths);
+        }
+    }
+}
+
 void SceneLoader::loadReferencedFiles()
 {
-    // Load all referenced properties files.
+    // Gather the files referenced by the URLs, each of them once.
+    std::vector<ReferencedFile> files;
     std::map<std::string, Properties*>::iterator iter = _properties.begin();
     for (; iter != _properties.end(); ++iter)
     {
@@ -1012,26 +1109,59 @@ void SceneLoader::loadReferencedFiles()
             std::string fileString;
             std::vector<std::string> namespacePath;
             calculateNamespacePath(iter->first, fileString, namespacePath);
-
-            // Check if the referenced properties file has already been loaded.
-            Properties* properties = NULL;
-            std::map<std::string, Properties*>::iterator pffIter = _propertiesFromFile.find(fileString);
-            if (pffIter != _propertiesFromFile.end() && pffIter->second)
+            if (_propertiesFromFile.find(fileString) == _propertiesFromFile.end())
             {
-                properties = pffIter->second;
+                _propertiesFromFile[fileString] = NULL;
+                ReferencedFile file;
+                file._path = fileString;
+                file._properties = NULL;
+                files.push_back(file);
             }
-            else
-            {
-                properties = Properties::create(fileString.c_str());
-                if (properties == NULL)
-                {
-                    GP_ERROR("Failed to load referenced properties file '%s'.", fileString.c_str());
-                    continue;
-                }
+        }
+    }
 
-                // Add the properties object to the cache.
-                _propertiesFromFile.insert(std::make_pair(fileString, properties));
-            }
+    // Parse the files on the worker threads. Parsing does not touch GL or any other main thread state.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    if (scheduler && scheduler->getWorkerCount() > 0 && files.size() > 1)
+    {
+        std::vector<JobScheduler::Job*> jobs(files.size());
+        for (size_t i = 0, count = files.size(); i < count; ++i)
+        {
+            jobs[i] = scheduler->submit(parseReferencedFile, &files[i]);
+        }
+        for (size_t i = 0, count = jobs.size(); i < count; ++i)
+        {
+            scheduler->wait(jobs[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0, count = files.size(); i < count; ++i)
+        {
+            parseReferencedFile(&files[i]);
+        }
+    }
+    for (size_t i = 0, count = files.size(); i < count; ++i)
+    {
+        if (files[i]._properties == NULL)
+        {
+            GP_ERROR("Failed to load referenced properties file '%s'.", files[i]._path.c_str());
+        }
+        _propertiesFromFile[files[i]._path] = files[i]._properties;
+    }
+
+    // Resolve the namespaces the URLs point to in the parsed files.
+    for (iter = _properties.begin(); iter != _properties.end(); ++iter)
+    {
+        if (iter->second == NULL)
+        {
+            std::string fileString;
+            std::vector<std::string> namespacePath;
+            calculateNamespacePath(iter->first, fileString, namespacePath);
+
+            Properties* properties = _propertiesFromFile[fileString];
+            if (properties == NULL)
+                continue;
 
             Properties* p = getPropertiesFromNamespacePath(properties, namespacePath);
             if (!p)
@@ -1044,6 +1174,52 @@ void SceneLoader::loadReferencedFiles()
     }
 }
 
+void SceneLoader::parseReferencedFile(void* cookie)
+{
+    ReferencedFile* file = (ReferencedFile*)cookie;
+    GP_ASSERT(file);
+
+    file->_properties = Properties::create(file->_path.c_str());
+}
+
+Bundle* SceneLoader::getBundle(const std::string& path)
+{
+    std::map<std::string, Bundle*>::iterator itr = _bundles.find(path);
+    if (itr != _bundles.end())
+        return itr->second;
+
+    // Failures are cached too, so that they are reported once.
+    Bundle* bundle = Bundle::create(path.c_str());
+    _bundles[path] = bundle;
+    return bundle;
+}
+
+void SceneLoader::endStage(const char* name)
+{
+    double now = Game::getAbsoluteTime();
+    _stageTimes.push_back(std::make_pair(name, now - _stageStart));
+    _stageStart = now;
+}
+
+void SceneLoader::logStageTimes() const
+{
+    Properties* config = Game::getInstance()->getConfig();
+    config = config ? config->getNamespace("scenes", true) : NULL;
+    if (config == NULL || !config->getBool("logLoadTimes"))
+        return;
+
+    double total = 0.0;
+    for (size_t i = 0, count = _stageTimes.size(); i < count; ++i)
+    {
+        total += _stageTimes[i].second;
+    }
+    print("[scene] Loaded '%s' in %.2f ms:\n", _path.c_str(), total);
+    for (size_t i = 0, count = _stageTimes.size(); i < count; ++i)
+    {
+        print("[scene]   %-18s %8.2f ms\n", _stageTimes[i].first, _stageTimes[i].second);
+    }
+}
+
 PhysicsConstraint* SceneLoader::loadSocketConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB)
 {
     GP_ASSERT(rbA);
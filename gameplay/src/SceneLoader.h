@@ -10,6 +10,8 @@
 namespace gameplay
 {
 
+class Bundle;
+
 /**
  * Helper class for loading scenes from .scene files.
  * @script{ignore}
@@ -77,6 +79,16 @@ private:
         std::map<std::string, std::string> _tags;
     };
 
+    struct ReferencedFile
+    {
+        std::string _path;
+        Properties* _properties;
+    };
+
+    SceneLoader();
+
+    ~SceneLoader();
+
     Scene* loadInternal(const char* url);
 
     void addSceneAnimation(const char* animationID, const char* targetID, const char* url);
@@ -105,6 +117,18 @@ private:
 
     void loadReferencedFiles();
 
+    static void parseReferencedFile(void* cookie);
+
+    Bundle* getBundle(const std::string& path);
+
+    void endStage(const char* name);
+
+    void logStageTimes() const;
+
+    void preloadTextures(std::vector<Texture*>* textures);
+
+    static void gatherTexturePaths(Properties* properties, std::vector<std::string>* paths);
+
     PhysicsConstraint* loadSocketConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB);
 
     PhysicsConstraint* loadSpringConstraint(const Properties* constraint, PhysicsRigidBody* rbA, PhysicsRigidBody* rbB);
@@ -115,6 +139,9 @@ private:
     std::vector<SceneNode> _sceneNodes;                          // Holds all the nodes+properties declared in the .scene file.
     std::string _gpbPath;                                        // The path of the main GPB for the scene being loaded.
     std::string _path;                                           // The path of the scene file being loaded.
+    std::map<std::string, Bundle*> _bundles;                     // Holds the bundles opened during the load, by path.
+    std::vector<std::pair<const char*, double> > _stageTimes;    // Holds the time taken by each stage of the load.
+    double _stageStart;                                          // The time the current stage of the load started.
 };
 
 /**
@@ -0,0 +1,498 @@
+#include "Base.h"
+#include "SceneSnapshot.h"
+#include "Scene.h"
+#include "Node.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "AnimationClip.h"
+#include "ParticleEmitter.h"
+#include "PhysicsRigidBody.h"
+#include "StringTable.h"
+
+// The version of the snapshot format, written after the magic number.
+#define SCENE_SNAPSHOT_VERSION 1
+
+// The size of the header: the magic number, the version and the node count.
+#define SCENE_SNAPSHOT_HEADER_SIZE 12
+
+// The flags of a node record.
+#define NODE_COLLISION_OBJECT 0x01
+#define NODE_COLLISION_ENABLED 0x02
+#define NODE_COLLISION_SUSPENDED 0x04
+#define NODE_RIGID_BODY 0x08
+#define NODE_PARTICLE_EMITTER 0x10
+#define NODE_PARTICLE_EMITTER_STARTED 0x20
+
+// The state bits of a clip that a snapshot keeps.
+#define CLIP_SNAPSHOT_BITS (AnimationClip::CLIP_IS_PLAYING_BIT | AnimationClip::CLIP_IS_STARTED_BIT | AnimationClip::CLIP_IS_PAUSED_BIT)
+
+namespace gameplay
+{
+
+static const char __magic[4] = { 'G', 'P', 'S', 'S' };
+
+class SceneSnapshot::Reader
+{
+public:
+
+    Reader(const std::vector<unsigned char>& data)
+        : _data(data.empty() ? NULL : &data[0]), _size(data.size()), _position(0)
+    {
+    }
+
+    bool read(void* data, size_t size)
+    {
+        if (_position + size > _size)
+        {
+            _position = _size;
+            return false;
+        }
+        memcpy(data, _data + _position, size);
+        _position += size;
+        return true;
+    }
+
+    bool readString(std::string& str)
+    {
+        unsigned short length;
+        if (!read(&length, sizeof(length)) || _position + length > _size)
+            return false;
+        str.assign((const char*)_data + _position, length);
+        _position += length;
+        return true;
+    }
+
+    bool isAtEnd() const
+    {
+        return _position == _size;
+    }
+
+private:
+
+    const unsigned char* _data;
+    size_t _size;
+    size_t _position;
+};
+
+struct SceneSnapshot::Warp
+{
+    PhysicsCollisionObject* object;
+    Vector3 linearVelocity;
+    Vector3 angularVelocity;
+};
+
+SceneSnapshot::SceneSnapshot()
+    : _nodeCount(0)
+{
+}
+
+SceneSnapshot::~SceneSnapshot()
+{
+}
+
+SceneSnapshot* SceneSnapshot::create(Scene* scene)
+{
+    SceneSnapshot* snapshot = new SceneSnapshot();
+    snapshot->capture(scene);
+    return snapshot;
+}
+
+SceneSnapshot* SceneSnapshot::create(const char* path)
+{
+    GP_ASSERT(path);
+
+    int size = 0;
+    char* data = FileSystem::readAll(path, &size);
+    if (data == NULL)
+    {
+        GP_WARN("Failed to read scene snapshot '%s'.", path);
+        return NULL;
+    }
+
+    unsigned int version = 0;
+    if (size >= SCENE_SNAPSHOT_HEADER_SIZE)
+        memcpy(&version, data + 4, sizeof(version));
+    if (size < SCENE_SNAPSHOT_HEADER_SIZE || memcmp(data, __magic, sizeof(__magic)) != 0 || version != SCENE_SNAPSHOT_VERSION)
+    {
+        GP_WARN("Invalid scene snapshot '%s'.", path);
+        SAFE_DELETE_ARRAY(data);
+        return NULL;
+    }
+
+    SceneSnapshot* snapshot = new SceneSnapshot();
+    snapshot->_data.assign((unsigned char*)data, (unsigned char*)data + size);
+    memcpy(&snapshot->_nodeCount, data + 8, sizeof(snapshot->_nodeCount));
+    SAFE_DELETE_ARRAY(data);
+    return snapshot;
+}
+
+void SceneSnapshot::capture(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    // The vector keeps its capacity, so capturing the same scene again does not allocate.
+    _data.clear();
+    _nodeCount = 0;
+    unsigned int version = SCENE_SNAPSHOT_VERSION;
+    write(__magic, sizeof(__magic));
+    write(&version, sizeof(version));
+    write(&_nodeCount, sizeof(_nodeCount));
+
+    std::set<Animation*> animations;
+    for (Node* node = scene->getFirstNode(); node; node = node->getNextSibling())
+    {
+        captureNode(node, animations);
+    }
+    memcpy(&_data[8], &_nodeCount, sizeof(_nodeCount));
+}
+
+void SceneSnapshot::captureNode(Node* node, std::set<Animation*>& animations)
+{
+    GP_ASSERT(node);
+    ++_nodeCount;
+
+    unsigned int hash = StringTable::hash(node->getId());
+    write(&hash, sizeof(hash));
+    write(&node->getScale().x, sizeof(float) * 3);
+    write(&node->getRotation().x, sizeof(float) * 4);
+    write(&node->getTranslation().x, sizeof(float) * 3);
+
+    unsigned char flags = 0;
+    PhysicsCollisionObject* object = node->getCollisionObject();
+    PhysicsRigidBody* body = NULL;
+    if (object)
+    {
+        flags |= NODE_COLLISION_OBJECT;
+        if (object->isEnabled())
+            flags |= NODE_COLLISION_ENABLED;
+        if (object->isSuspended())
+            flags |= NODE_COLLISION_SUSPENDED;
+        if (object->getType() == PhysicsCollisionObject::RIGID_BODY && !object->isKinematic())
+        {
+            flags |= NODE_RIGID_BODY;
+            body = static_cast<PhysicsRigidBody*>(object);
+        }
+    }
+    ParticleEmitter* emitter = node->getParticleEmitter();
+    if (emitter)
+    {
+        flags |= NODE_PARTICLE_EMITTER;
+        if (emitter->isStarted())
+            flags |= NODE_PARTICLE_EMITTER_STARTED;
+    }
+    write(&flags, sizeof(flags));
+    if (body)
+    {
+        Vector3 linearVelocity = body->getLinearVelocity();
+        Vector3 angularVelocity = body->getAngularVelocity();
+        write(&linearVelocity.x, sizeof(float) * 3);
+        write(&angularVelocity.x, sizeof(float) * 3);
+    }
+
+    unsigned short tagCount = node->_tags ? (unsigned short)node->_tags->size() : 0;
+    write(&tagCount, sizeof(tagCount));
+    for (unsigned short i = 0; i < tagCount; ++i)
+    {
+        const Node::Tag& tag = (*node->_tags)[i];
+        writeString(Node::getTagName(tag.id));
+        writeString(tag.value.c_str());
+    }
+
+    // The clips of an animation are kept with the first node it targets, since the
+    // animation of a skin targets all of its joints.
+    std::vector<Animation*> nodeAnimations;
+    node->getAnimations(nodeAnimations);
+    unsigned short animationCount = 0;
+    size_t countOffset = _data.size();
+    write(&animationCount, sizeof(animationCount));
+    for (size_t i = 0; i < nodeAnimations.size(); ++i)
+    {
+        Animation* animation = nodeAnimations[i];
+        if (!animations.insert(animation).second)
+            continue;
+
+        ++animationCount;
+        unsigned short clipCount = (unsigned short)animation->getClipCount();
+        write(&clipCount, sizeof(clipCount));
+        for (unsigned short j = 0; j < clipCount; ++j)
+        {
+            captureClip(animation->getClip(j));
+        }
+    }
+    memcpy(&_data[countOffset], &animationCount, sizeof(animationCount));
+
+    for (Node* child = node->getFirstChild(); child; child = child->getNextSibling())
+    {
+        captureNode(child, animations);
+    }
+}
+
+void SceneSnapshot::captureClip(AnimationClip* clip)
+{
+    GP_ASSERT(clip);
+
+    // A clip that was stopped is removed at its next update, so it is kept as stopped.
+    unsigned char bits = clip->_stateBits & CLIP_SNAPSHOT_BITS;
+    if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_MARKED_FOR_REMOVAL_BIT))
+        bits = 0;
+    float timeSinceStart = (float)(Game::getGameTime() - clip->_timeStarted);
+    unsigned int listenerIndex = (unsigned int)clip->_listenerIndex;
+    write(&bits, sizeof(bits));
+    write(&clip->_elapsedTime, sizeof(float));
+    write(&clip->_speed, sizeof(float));
+    write(&clip->_blendWeight, sizeof(float));
+    write(&timeSinceStart, sizeof(timeSinceStart));
+    write(&listenerIndex, sizeof(listenerIndex));
+}
+
+bool SceneSnapshot::restore(Scene* scene) const
+{
+    GP_ASSERT(scene);
+
+    // The scene is checked against the whole snapshot before any of it is changed.
+    if (!restoreNodes(scene, false))
+    {
+        GP_WARN("Scene snapshot does not match the nodes of scene '%s'.", scene->getId());
+        return false;
+    }
+    return restoreNodes(scene, true);
+}
+
+bool SceneSnapshot::restoreNodes(Scene* scene, bool apply) const
+{
+    Reader reader(_data);
+    char header[SCENE_SNAPSHOT_HEADER_SIZE];
+    if (!reader.read(header, sizeof(header)))
+        return false;
+
+    // A step running on a worker thread would write its transforms over the restored nodes.
+    PhysicsController* physicsController = Game::getInstance()->getPhysicsController();
+    if (apply && physicsController)
+        physicsController->finishAsyncStep();
+
+    std::set<Animation*> animations;
+    std::vector<Warp> warps;
+    for (Node* node = scene->getFirstNode(); node; node = node->getNextSibling())
+    {
+        if (!restoreNode(node, reader, animations, warps, apply))
+            return false;
+    }
+    if (!reader.isAtEnd())
+        return false;
+
+    // The collision objects are placed once every node has its transform, since their
+    // world transforms depend on those of the parents of their nodes.
+    for (size_t i = 0, count = warps.size(); i < count; ++i)
+    {
+        const Warp& warp = warps[i];
+        warp.object->warpToNode();
+        if (warp.object->getType() == PhysicsCollisionObject::RIGID_BODY)
+        {
+            PhysicsRigidBody* body = static_cast<PhysicsRigidBody*>(warp.object);
+            body->setLinearVelocity(warp.linearVelocity);
+            body->setAngularVelocity(warp.angularVelocity);
+        }
+    }
+    return true;
+}
+
+bool SceneSnapshot::restoreNode(Node* node, Reader& reader, std::set<Animation*>& animations, std::vector<Warp>& warps, bool apply) const
+{
+    GP_ASSERT(node);
+
+    unsigned int hash;
+    float transform[10];
+    unsigned char flags;
+    if (!reader.read(&hash, sizeof(hash)) || hash != StringTable::hash(node->getId()) ||
+        !reader.read(transform, sizeof(transform)) || !reader.read(&flags, sizeof(flags)))
+        return false;
+
+    PhysicsCollisionObject* object = node->getCollisionObject();
+    ParticleEmitter* emitter = node->getParticleEmitter();
+    if (((flags & NODE_COLLISION_OBJECT) != 0) != (object != NULL) || ((flags & NODE_PARTICLE_EMITTER) != 0) != (emitter != NULL))
+        return false;
+
+    Warp warp;
+    warp.object = object;
+    if ((flags & NODE_RIGID_BODY) && (!reader.read(&warp.linearVelocity.x, sizeof(float) * 3) || !reader.read(&warp.angularVelocity.x, sizeof(float) * 3)))
+        return false;
+
+    if (apply)
+    {
+        node->set(Vector3(transform[0], transform[1], transform[2]), Quaternion(transform[3], transform[4], transform[5], transform[6]),
+            Vector3(transform[7], transform[8], transform[9]));
+
+        if (object)
+        {
+            object->setEnabled((flags & NODE_COLLISION_ENABLED) != 0);
+            object->setSuspended((flags & NODE_COLLISION_SUSPENDED) != 0);
+
+            // Disabled and suspended objects are placed at their nodes when they are brought back.
+            if (object->isEnabled() && !object->isSuspended() && object->getType() != PhysicsCollisionObject::VEHICLE_WHEEL)
+            {
+                if (!(flags & NODE_RIGID_BODY))
+                {
+                    warp.linearVelocity.set(0.0f, 0.0f, 0.0f);
+                    warp.angularVelocity.set(0.0f, 0.0f, 0.0f);
+                }
+                warps.push_back(warp);
+            }
+        }
+
+        if (emitter)
+        {
+            bool started = (flags & NODE_PARTICLE_EMITTER_STARTED) != 0;
+            if (started && !emitter->isStarted())
+                emitter->start();
+            else if (!started && emitter->isStarted())
+                emitter->stop();
+        }
+    }
+
+    unsigned short tagCount;
+    if (!reader.read(&tagCount, sizeof(tagCount)))
+        return false;
+    std::vector<unsigned int> tagIds;
+    std::string name, value;
+    for (unsigned short i = 0; i < tagCount; ++i)
+    {
+        if (!reader.readString(name) || !reader.readString(value))
+            return false;
+        if (apply)
+        {
+            unsigned int tagId = Node::getTagId(name.c_str());
+            tagIds.push_back(tagId);
+            node->setTag(tagId, value.c_str());
+        }
+    }
+    if (apply && node->_tags)
+    {
+        // Remove the tags set since the snapshot was taken.
+        for (size_t i = node->_tags->size(); i-- > 0;)
+        {
+            unsigned int tagId = (*node->_tags)[i].id;
+            if (std::find(tagIds.begin(), tagIds.end(), tagId) == tagIds.end())
+                node->setTag(tagId, NULL);
+        }
+    }
+
+    std::vector<Animation*> nodeAnimations;
+    node->getAnimations(nodeAnimations);
+    unsigned short animationCount;
+    if (!reader.read(&animationCount, sizeof(animationCount)))
+        return false;
+    unsigned short restoredCount = 0;
+    for (size_t i = 0; i < nodeAnimations.size(); ++i)
+    {
+        Animation* animation = nodeAnimations[i];
+        if (!animations.insert(animation).second)
+            continue;
+
+        unsigned short clipCount;
+        if (++restoredCount > animationCount || !reader.read(&clipCount, sizeof(clipCount)) || clipCount != animation->getClipCount())
+            return false;
+        for (unsigned short j = 0; j < clipCount; ++j)
+        {
+            if (!restoreClip(animation->getClip(j), reader, apply))
+                return false;
+        }
+    }
+    if (restoredCount != animationCount)
+        return false;
+
+    for (Node* child = node->getFirstChild(); child; child = child->getNextSibling())
+    {
+        if (!restoreNode(child, reader, animations, warps, apply))
+            return false;
+    }
+    return true;
+}
+
+bool SceneSnapshot::restoreClip(AnimationClip* clip, Reader& reader, bool apply) const
+{
+    GP_ASSERT(clip);
+
+    unsigned char bits;
+    float elapsedTime, speed, blendWeight, timeSinceStart;
+    unsigned int listenerIndex;
+    if (!reader.read(&bits, sizeof(bits)) || !reader.read(&elapsedTime, sizeof(elapsedTime)) || !reader.read(&speed, sizeof(speed)) ||
+        !reader.read(&blendWeight, sizeof(blendWeight)) || !reader.read(&timeSinceStart, sizeof(timeSinceStart)) ||
+        !reader.read(&listenerIndex, sizeof(listenerIndex)))
+        return false;
+
+    if (!apply)
+        return true;
+
+    // Cross fades in progress are dropped.
+    SAFE_RELEASE(clip->_crossFadeToClip);
+    clip->_speed = speed;
+    if (bits & AnimationClip::CLIP_IS_PLAYING_BIT)
+    {
+        // Clips that are not running are scheduled on the animation controller first.
+        if (!clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
+        {
+            clip->play();
+            if (!clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
+                return true;
+        }
+        clip->_stateBits = bits;
+        clip->_elapsedTime = elapsedTime;
+        clip->_blendWeight = blendWeight;
+        clip->_timeStarted = Game::getGameTime() - timeSinceStart;
+        clip->_listenerIndex = std::min((size_t)listenerIndex, clip->_listeners.size());
+    }
+    else
+    {
+        clip->_stateBits &= ~(AnimationClip::CLIP_IS_FADING_OUT_STARTED_BIT | AnimationClip::CLIP_IS_FADING_OUT_BIT |
+            AnimationClip::CLIP_IS_FADING_IN_BIT);
+        clip->stop();
+    }
+    return true;
+}
+
+bool SceneSnapshot::write(const char* path) const
+{
+    GP_ASSERT(path);
+
+    FILE* file = FileSystem::openFile(path, "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create scene snapshot '%s'.", path);
+        return false;
+    }
+
+    bool result = _data.empty() || fwrite(&_data[0], 1, _data.size(), file) == _data.size();
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write scene snapshot '%s'.", path);
+    }
+    return result;
+}
+
+unsigned int SceneSnapshot::getNodeCount() const
+{
+    return _nodeCount;
+}
+
+unsigned int SceneSnapshot::getSize() const
+{
+    return (unsigned int)_data.size();
+}
+
+void SceneSnapshot::write(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    _data.insert(_data.end(), bytes, bytes + size);
+}
+
+void SceneSnapshot::writeString(const char* str)
+{
+    GP_ASSERT(str);
+
+    unsigned short length = (unsigned short)std::min(strlen(str), (size_t)0xFFFF);
+    write(&length, sizeof(length));
+    write(str, length);
+}
+
+}
@@ -0,0 +1,150 @@
+#ifndef SCENESNAPSHOT_H_
+#define SCENESNAPSHOT_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+class Animation;
+class AnimationClip;
+
+/**
+ * Defines a snapshot of the mutable state of a scene, which is restored in place to
+ * restart a level or load a quick save without loading the scene again.
+ *
+ * A snapshot holds, for every node of the scene in depth first order:
+ *
+ * - the local scale, rotation and translation of the node,
+ * - the tags of the node, which scripts read and write as properties,
+ * - whether its collision object is enabled and suspended, and the linear and angular
+ *   velocities of its rigid body,
+ * - whether its particle emitter is started,
+ * - the state of the clips of the animations targeting the node: whether they are
+ *   playing or paused, their elapsed time, speed and blend weight.
+ *
+ * Restoring a snapshot only sets this state on the nodes and objects of the scene; no
+ * resource is loaded or created. The scene must therefore hold the same nodes, in the same
+ * order, as when the snapshot was taken: the nodes are matched by their position in the
+ * hierarchy and their IDs are checked before anything is changed. Nodes spawned after the
+ * snapshot should be removed, and pooled nodes returned, before restoring it. Cross fades
+ * in progress are not kept, and the rigid bodies are placed at their restored transforms
+ * without being swept through the space in between.
+ *
+ * The state is kept in a compact binary blob that can also be written to a file and read
+ * back, for quick saves. The blob is written in the byte order of the machine.
+ *
+ * @script{ignore}
+ */
+class SceneSnapshot : public Ref
+{
+public:
+
+    /**
+     * Creates a snapshot of the current state of a scene.
+     *
+     * @param scene The scene.
+     *
+     * @return The new snapshot.
+     */
+    static SceneSnapshot* create(Scene* scene);
+
+    /**
+     * Reads a snapshot from a file written by write().
+     *
+     * @param path The path of the file.
+     *
+     * @return The snapshot, or NULL if the file could not be read or is not a snapshot.
+     */
+    static SceneSnapshot* create(const char* path);
+
+    /**
+     * Replaces the contents of the snapshot with the current state of a scene, reusing its memory.
+     *
+     * @param scene The scene.
+     */
+    void capture(Scene* scene);
+
+    /**
+     * Restores the state of the snapshot on a scene.
+     *
+     * @param scene The scene the snapshot was taken from, or one loaded from the same file.
+     *
+     * @return true if the state was restored, false if the nodes of the scene do not match
+     *      those of the snapshot, in which case the scene is left unchanged.
+     */
+    bool restore(Scene* scene) const;
+
+    /**
+     * Writes the snapshot to a file.
+     *
+     * @param path The path of the file.
+     *
+     * @return true if the file was written, false otherwise.
+     */
+    bool write(const char* path) const;
+
+    /**
+     * Gets the number of nodes in the snapshot.
+     *
+     * @return The number of nodes.
+     */
+    unsigned int getNodeCount() const;
+
+    /**
+     * Gets the size of the snapshot data.
+     *
+     * @return The size in bytes.
+     */
+    unsigned int getSize() const;
+
+private:
+
+    /**
+     * Reads the data of a snapshot in order.
+     */
+    class Reader;
+
+    /**
+     * A collision object to place at the restored transform of its node.
+     */
+    struct Warp;
+
+    /**
+     * Constructor.
+     */
+    SceneSnapshot();
+
+    /**
+     * Destructor.
+     */
+    ~SceneSnapshot();
+
+    /**
+     * Hidden copy constructor.
+     */
+    SceneSnapshot(const SceneSnapshot& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    SceneSnapshot& operator=(const SceneSnapshot&);
+
+    void captureNode(Node* node, std::set<Animation*>& animations);
+    void captureClip(AnimationClip* clip);
+    bool restoreNodes(Scene* scene, bool apply) const;
+    bool restoreNode(Node* node, Reader& reader, std::set<Animation*>& animations, std::vector<Warp>& warps, bool apply) const;
+    bool restoreClip(AnimationClip* clip, Reader& reader, bool apply) const;
+
+    void write(const void* data, size_t size);
+    void writeString(const char* str);
+
+    std::vector<unsigned char> _data;
+    unsigned int _nodeCount;
+};
+
+}
+
+#endif
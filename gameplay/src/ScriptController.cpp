@@ -1,10 +1,18 @@
 #include "Base.h"
 #include "FileSystem.h"
 #include "ScriptController.h"
+#include "StringTable.h"
 
 #ifndef NO_LUA_BINDINGS
 #include "lua/lua_all_bindings.h"
 #endif
+#ifdef GP_LUAJIT
+#include "lua/lua_all_ffi.h"
+#endif
+
+// Compiled scripts written by gameplay-luagen start with this magic, followed by the size and hash of their source.
+#define LUA_CHUNK_MAGIC "GPLC"
+#define LUA_CHUNK_HEADER_SIZE 12
 
 #define GENERATE_LUA_GET_POINTER(type, checkFunc) \
     ScriptController* sc = Game::getInstance()->getScriptController(); \
@@ -132,6 +140,9 @@ namespace gameplay
 
 extern void splitURL(const std::string& url, std::string* file, std::string* id);
 
+// The key of the number of a class in its metatable; only its address is used.
+static const char __typeIdKey = 0;
+
 void ScriptUtil::registerLibrary(const char* name, const luaL_Reg* functions)
 {
     ScriptController* sc = Game::getInstance()->getScriptController();
@@ -288,6 +299,12 @@ void ScriptUtil::registerClass(const char* name, const luaL_Reg* members, lua_CF
     // Create the metatable and populate it with the member functions.
     lua_pushliteral(sc->_lua, "__metatable");
     luaL_newmetatable(sc->_lua, name);
+
+    // Number the class for the type checks of object arguments.
+    std::map<std::string, unsigned int>::iterator typeId = sc->_typeIds.insert(std::make_pair(std::string(name), (unsigned int)sc->_typeIds.size())).first;
+    lua_pushinteger(sc->_lua, (lua_Integer)typeId->second);
+    lua_rawsetp(sc->_lua, -2, &__typeIdKey);
+    sc->_typeAncestors.clear();
     if (members)
         luaL_setfuncs(sc->_lua, members, 0);
     lua_pushstring(sc->_lua, "__index");
@@ -341,7 +358,9 @@ void ScriptUtil::registerFunction(const char* luaFunction, lua_CFunction cppFunc
 
 void ScriptUtil::setGlobalHierarchyPair(const std::string& base, const std::string& derived)
 {
-    Game::getInstance()->getScriptController()->_hierarchy[base].push_back(derived);
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    sc->_hierarchy[base].push_back(derived);
+    sc->_typeAncestors.clear();
 }
 
 void ScriptUtil::addStringFromEnumConversionFunction(luaStringEnumConversionFunction stringFromEnum)
@@ -412,6 +431,50 @@ const char* ScriptUtil::getString(int index, bool isStdString)
     }
 }
 
+void ScriptUtil::pushMetatable(lua_State* state, const char* type, int* ref, unsigned int* generation)
+{
+    // Metatables live as long as the Lua state they were registered in.
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    if (*ref == LUA_NOREF || *generation < sc->_stateGeneration)
+    {
+        luaL_getmetatable(state, type);
+        lua_pushvalue(state, -1);
+        *ref = luaL_ref(state, LUA_REGISTRYINDEX);
+        *generation = sc->_stateGeneration;
+        return;
+    }
+    lua_rawgeti(state, LUA_REGISTRYINDEX, *ref);
+}
+
+bool ScriptUtil::isObjectOfType(int index, const char* type)
+{
+    ScriptController* sc = Game::getInstance()->getScriptController();
+
+    // Get the number of the object's class from its metatable.
+    if (!lua_getmetatable(sc->_lua, index))
+        return false;
+    lua_rawgetp(sc->_lua, -1, &__typeIdKey);
+    int isNumber = 0;
+    lua_Integer objectType = lua_tointegerx(sc->_lua, -1, &isNumber);
+    lua_pop(sc->_lua, 2);
+    if (!isNumber || objectType < 0 || (size_t)objectType >= sc->_typeIds.size())
+        return false;
+
+    std::map<const char*, unsigned int>::const_iterator cached = sc->_typeIdCache.find(type);
+    if (cached == sc->_typeIdCache.end())
+    {
+        std::map<std::string, unsigned int>::const_iterator itr = sc->_typeIds.find(type);
+        if (itr == sc->_typeIds.end())
+            return false;
+        cached = sc->_typeIdCache.insert(std::make_pair(type, itr->second)).first;
+    }
+
+    if (sc->_typeAncestors.empty())
+        sc->buildTypeAncestors();
+    unsigned int typeId = cached->second;
+    return (sc->_typeAncestors[(size_t)objectType * sc->_typeWords + (typeId >> 5)] & (1u << (typeId & 31))) != 0;
+}
+
 bool ScriptUtil::luaCheckBool(lua_State* state, int n)
 {
     if (!lua_isboolean(state, n))
@@ -430,30 +493,120 @@ void ScriptController::loadScript(const char* path, bool forceReload)
     std::set<std::string>::iterator iter = _loadedScripts.find(path);
     if (iter == _loadedScripts.end() || forceReload)
     {
-#ifdef __ANDROID__
-        const char* scriptContents = FileSystem::readAll(path);
-        if (luaL_dostring(_lua, scriptContents))
+        int top = lua_gettop(_lua);
+        if (!loadChunk(path) || lua_pcall(_lua, 0, 0, 0) != 0)
         {
             GP_WARN("Failed to run Lua script with error: '%s'.", lua_tostring(_lua, -1));
         }
-        SAFE_DELETE_ARRAY(scriptContents);
-#else
-        std::string fullPath;
-        if (!FileSystem::isAbsolutePath(path))
+        lua_settop(_lua, top);
+
+        // The script may have redefined functions that callbacks hold references to.
+        ++_generation;
+        if (iter == _loadedScripts.end())
         {
-            fullPath.append(FileSystem::getResourcePath());
+            _loadedScripts.insert(path);
         }
-        fullPath.append(path);
-        if (luaL_dofile(_lua, fullPath.c_str()))
+    }
+}
+
+bool ScriptController::loadChunk(const char* path)
+{
+    // Read the source, if it is present, to check the cached and compiled chunks against.
+    char* source = NULL;
+    int sourceSize = 0;
+    unsigned int sourceHash = 0;
+    if (FileSystem::fileExists(path))
+    {
+        source = FileSystem::readAll(path, &sourceSize);
+        if (source)
         {
-            GP_WARN("Failed to run Lua script with error: '%s'.", lua_tostring(_lua, -1));
+            // The hash tells whether a compiled chunk was compiled from this source;
+            // it must match the hash written by the script compiler of gameplay-luagen.
+            sourceHash = StringTable::hash(source, (size_t)sourceSize);
         }
-#endif
-        if (iter == _loadedScripts.end())
+    }
+
+    // Reuse the chunk compiled by an earlier load of the same source.
+    std::map<std::string, Chunk>::iterator itr = _chunks.find(path);
+    if (itr != _chunks.end() && (source == NULL || (itr->second.sourceSize == (unsigned int)sourceSize && itr->second.sourceHash == sourceHash)))
+    {
+        SAFE_DELETE_ARRAY(source);
+        lua_rawgeti(_lua, LUA_REGISTRYINDEX, itr->second.ref);
+        return true;
+    }
+
+    std::string chunkName = "@";
+    chunkName += path;
+    bool loaded = false;
+
+    // Prefer the precompiled chunk (path + "c") written by gameplay-luagen, unless it was compiled from another source.
+    std::string compiledPath = path;
+    compiledPath += "c";
+    if (FileSystem::fileExists(compiledPath.c_str()))
+    {
+        int compiledSize = 0;
+        char* compiled = FileSystem::readAll(compiledPath.c_str(), &compiledSize);
+        if (compiled && compiledSize >= LUA_CHUNK_HEADER_SIZE && memcmp(compiled, LUA_CHUNK_MAGIC, 4) == 0)
         {
-            _loadedScripts.insert(path);
+            unsigned int compiledSourceSize;
+            unsigned int compiledSourceHash;
+            memcpy(&compiledSourceSize, compiled + 4, sizeof(unsigned int));
+            memcpy(&compiledSourceHash, compiled + 8, sizeof(unsigned int));
+            if (source == NULL || (compiledSourceSize == (unsigned int)sourceSize && compiledSourceHash == sourceHash))
+            {
+                if (luaL_loadbuffer(_lua, compiled + LUA_CHUNK_HEADER_SIZE, compiledSize - LUA_CHUNK_HEADER_SIZE, chunkName.c_str()) == 0)
+                {
+                    loaded = true;
+                    sourceSize = compiledSourceSize;
+                    sourceHash = compiledSourceHash;
+                }
+                else
+                {
+                    GP_WARN("Failed to load compiled Lua script '%s' with error: '%s'.", compiledPath.c_str(), lua_tostring(_lua, -1));
+                    lua_pop(_lua, 1);
+                }
+            }
+            else
+            {
+                GP_WARN("Compiled Lua script '%s' is out of date; loading '%s' instead.", compiledPath.c_str(), path);
+            }
+        }
+        else
+        {
+            GP_WARN("Invalid compiled Lua script '%s'.", compiledPath.c_str());
         }
+        SAFE_DELETE_ARRAY(compiled);
     }
+
+    if (!loaded)
+    {
+        if (source == NULL)
+        {
+            lua_pushfstring(_lua, "cannot read %s", path);
+            return false;
+        }
+        if (luaL_loadbuffer(_lua, source, sourceSize, chunkName.c_str()) != 0)
+        {
+            SAFE_DELETE_ARRAY(source);
+            return false;
+        }
+    }
+    SAFE_DELETE_ARRAY(source);
+
+    // Keep the chunk for later loads of the same script.
+    if (itr == _chunks.end())
+    {
+        itr = _chunks.insert(std::make_pair(std::string(path), Chunk())).first;
+    }
+    else
+    {
+        luaL_unref(_lua, LUA_REGISTRYINDEX, itr->second.ref);
+    }
+    lua_pushvalue(_lua, -1);
+    itr->second.ref = luaL_ref(_lua, LUA_REGISTRYINDEX);
+    itr->second.sourceSize = (unsigned int)sourceSize;
+    itr->second.sourceHash = sourceHash;
+    return true;
 }
 
 std::string ScriptController::loadUrl(const char* url)
@@ -477,6 +630,68 @@ std::string ScriptController::loadUrl(const char* url)
     return id;
 }
 
+unsigned int ScriptController::getGarbageCollectionStep() const
+{
+    return _gcStepSize;
+}
+
+void ScriptController::setGarbageCollectionStep(unsigned int kilobytes)
+{
+    _gcStepSize = kilobytes;
+}
+
+float ScriptController::getGarbageCollectionBudget() const
+{
+    return _gcBudget;
+}
+
+void ScriptController::setGarbageCollectionBudget(float milliseconds)
+{
+    _gcBudget = std::max(0.0f, milliseconds);
+    if (_lua)
+    {
+        lua_gc(_lua, _gcBudget > 0.0f ? LUA_GCSTOP : LUA_GCRESTART, 0);
+        _gcBaseline = lua_gc(_lua, LUA_GCCOUNT, 0);
+    }
+}
+
+void ScriptController::collectGarbage()
+{
+    if (!_lua)
+        return;
+
+    if (_gcBudget > 0.0f)
+    {
+        GP_PROFILE_SCOPE("ScriptController::collectGarbage");
+
+        // Fall back to a full collection if the budget cannot keep up with the garbage.
+        if (lua_gc(_lua, LUA_GCCOUNT, 0) > std::max(_gcBaseline, 1024) * 4)
+        {
+            lua_gc(_lua, LUA_GCCOLLECT, 0);
+            _gcBaseline = lua_gc(_lua, LUA_GCCOUNT, 0);
+        }
+        else
+        {
+            double end = Game::getAbsoluteTime() + _gcBudget;
+            do
+            {
+                if (lua_gc(_lua, LUA_GCSTEP, (int)_gcStepSize))
+                {
+                    _gcBaseline = lua_gc(_lua, LUA_GCCOUNT, 0);
+                    break;
+                }
+            } while (Game::getAbsoluteTime() < end);
+        }
+    }
+    else if (_gcStepSize > 0)
+    {
+        GP_PROFILE_SCOPE("ScriptController::collectGarbage");
+        lua_gc(_lua, LUA_GCSTEP, (int)_gcStepSize);
+    }
+
+    GP_PROFILE_COUNTER("Lua memory (KB)", lua_gc(_lua, LUA_GCCOUNT, 0) + lua_gc(_lua, LUA_GCCOUNTB, 0) / 1024.0);
+}
+
 bool ScriptController::getBool(const char* name, bool defaultValue)
 {
     PUSH_NESTED_VARIABLE(name, defaultValue);
@@ -655,12 +870,15 @@ void ScriptController::print(const char* str1, const char* str2)
     gameplay::print("%s%s", str1, str2);
 }
 
-ScriptController::ScriptController() : _lua(NULL)
+ScriptController::ScriptController() : _lua(NULL), _typeWords(0), _generation(0), _stateGeneration(0), _gcStepSize(0), _gcBudget(0.0f), _gcBaseline(0),
+    _coroutineTimers(NULL), _updateCount(0)
 {
+    _coroutineTimers = new TimerWheel();
 }
 
 ScriptController::~ScriptController()
 {
+    SAFE_DELETE(_coroutineTimers);
 }
 
 static const char* lua_print_function = 
@@ -673,8 +891,7 @@ static const char* lua_loadfile_function =
     "    local oldLoadfile = loadfile\n"
     "    loadfile = function(filename)\n"
     "        if filename ~= nil and not FileSystem.isAbsolutePath(filename) then\n"
-    "            FileSystem.createFileFromAsset(filename)\n"
-    "            filename = FileSystem.getResourcePath() .. filename\n"
+    "            return loadResource(filename)\n"
     "        end\n"
     "        return oldLoadfile(filename)\n"
     "    end\n"
@@ -685,13 +902,135 @@ static const char* lua_dofile_function =
     "    local oldDofile = dofile\n"
     "    dofile = function(filename)\n"
     "        if filename ~= nil and not FileSystem.isAbsolutePath(filename) then\n"
-    "            FileSystem.createFileFromAsset(filename)\n"
-    "            filename = FileSystem.getResourcePath() .. filename\n"
+    "            return assert(loadResource(filename))()\n"
     "        end\n"
     "        return oldDofile(filename)\n"
     "    end\n"
     "end\n";
 
+#ifdef GP_LUAJIT
+// Declares the plain math classes to the LuaJIT FFI and gives them the common operations, in the global FFI table.
+static const char* lua_ffi_math_functions =
+    "local cdef = ...\n"
+    "local ffi = require(\"ffi\")\n"
+    "ffi.cdef(cdef)\n"
+    "local sqrt = math.sqrt\n"
+    "local Vector2, Vector3, Vector4, Quaternion, Matrix\n"
+    "Vector2 = ffi.metatype(\"Vector2\", {\n"
+    "    __add = function(a, b) return Vector2(a.x + b.x, a.y + b.y) end,\n"
+    "    __sub = function(a, b) return Vector2(a.x - b.x, a.y - b.y) end,\n"
+    "    __mul = function(a, b)\n"
+    "        if type(a) == \"number\" then return Vector2(a * b.x, a * b.y) end\n"
+    "        if type(b) == \"number\" then return Vector2(a.x * b, a.y * b) end\n"
+    "        return Vector2(a.x * b.x, a.y * b.y)\n"
+    "    end,\n"
+    "    __div = function(a, s) return Vector2(a.x / s, a.y / s) end,\n"
+    "    __unm = function(a) return Vector2(-a.x, -a.y) end,\n"
+    "    __index = {\n"
+    "        dot = function(a, b) return a.x * b.x + a.y * b.y end,\n"
+    "        lengthSquared = function(a) return a.x * a.x + a.y * a.y end,\n"
+    "        length = function(a) return sqrt(a.x * a.x + a.y * a.y) end,\n"
+    "        distance = function(a, b) local x, y = a.x - b.x, a.y - b.y return sqrt(x * x + y * y) end,\n"
+    "        normalize = function(a)\n"
+    "            local n = sqrt(a.x * a.x + a.y * a.y)\n"
+    "            if n > 0 then return Vector2(a.x / n, a.y / n) end\n"
+    "            return Vector2(a)\n"
+    "        end\n"
+    "    }\n"
+    "})\n"
+    "Vector3 = ffi.metatype(\"Vector3\", {\n"
+    "    __add = function(a, b) return Vector3(a.x + b.x, a.y + b.y, a.z + b.z) end,\n"
+    "    __sub = function(a, b) return Vector3(a.x - b.x, a.y - b.y, a.z - b.z) end,\n"
+    "    __mul = function(a, b)\n"
+    "        if type(a) == \"number\" then return Vector3(a * b.x, a * b.y, a * b.z) end\n"
+    "        if type(b) == \"number\" then return Vector3(a.x * b, a.y * b, a.z * b) end\n"
+    "        return Vector3(a.x * b.x, a.y * b.y, a.z * b.z)\n"
+    "    end,\n"
+    "    __div = function(a, s) return Vector3(a.x / s, a.y / s, a.z / s) end,\n"
+    "    __unm = function(a) return Vector3(-a.x, -a.y, -a.z) end,\n"
+    "    __index = {\n"
+    "        dot = function(a, b) return a.x * b.x + a.y * b.y + a.z * b.z end,\n"
+    "        cross = function(a, b) return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x) end,\n"
+    "        lengthSquared = function(a) return a.x * a.x + a.y * a.y + a.z * a.z end,\n"
+    "        length = function(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z) end,\n"
+    "        distance = function(a, b) local x, y, z = a.x - b.x, a.y - b.y, a.z - b.z return sqrt(x * x + y * y + z * z) end,\n"
+    "        normalize = function(a)\n"
+    "            local n = sqrt(a.x * a.x + a.y * a.y + a.z * a.z)\n"
+    "            if n > 0 then return Vector3(a.x / n, a.y / n, a.z / n) end\n"
+    "            return Vector3(a)\n"
+    "        end\n"
+    "    }\n"
+    "})\n"
+    "Vector4 = ffi.metatype(\"Vector4\", {\n"
+    "    __add = function(a, b) return Vector4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w) end,\n"
+    "    __sub = function(a, b) return Vector4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w) end,\n"
+    "    __mul = function(a, b)\n"
+    "        if type(a) == \"number\" then return Vector4(a * b.x, a * b.y, a * b.z, a * b.w) end\n"
+    "        if type(b) == \"number\" then return Vector4(a.x * b, a.y * b, a.z * b, a.w * b) end\n"
+    "        return Vector4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w)\n"
+    "    end,\n"
+    "    __div = function(a, s) return Vector4(a.x / s, a.y / s, a.z / s, a.w / s) end,\n"
+    "    __unm = function(a) return Vector4(-a.x, -a.y, -a.z, -a.w) end,\n"
+    "    __index = {\n"
+    "        dot = function(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end,\n"
+    "        lengthSquared = function(a) return a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w end,\n"
+    "        length = function(a) return sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w) end,\n"
+    "        normalize = function(a)\n"
+    "            local n = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)\n"
+    "            if n > 0 then return Vector4(a.x / n, a.y / n, a.z / n, a.w / n) end\n"
+    "            return Vector4(a)\n"
+    "        end\n"
+    "    }\n"
+    "})\n"
+    "Quaternion = ffi.metatype(\"Quaternion\", {\n"
+    "    __mul = function(a, b)\n"
+    "        return Quaternion(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,\n"
+    "                          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,\n"
+    "                          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,\n"
+    "                          a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z)\n"
+    "    end,\n"
+    "    __index = {\n"
+    "        dot = function(a, b) return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w end,\n"
+    "        conjugate = function(a) return Quaternion(-a.x, -a.y, -a.z, a.w) end,\n"
+    "        normalize = function(a)\n"
+    "            local n = sqrt(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w)\n"
+    "            if n > 0 then return Quaternion(a.x / n, a.y / n, a.z / n, a.w / n) end\n"
+    "            return Quaternion(a)\n"
+    "        end,\n"
+    "        rotate = function(q, v)\n"
+    "            local x, y, z = 2 * (q.y * v.z - q.z * v.y), 2 * (q.z * v.x - q.x * v.z), 2 * (q.x * v.y - q.y * v.x)\n"
+    "            return Vector3(v.x + q.w * x + q.y * z - q.z * y, v.y + q.w * y + q.z * x - q.x * z, v.z + q.w * z + q.x * y - q.y * x)\n"
+    "        end\n"
+    "    }\n"
+    "})\n"
+    "Matrix = ffi.metatype(\"Matrix\", {\n"
+    "    __mul = function(a, b)\n"
+    "        local d = Matrix()\n"
+    "        for c = 0, 12, 4 do\n"
+    "            for r = 0, 3 do\n"
+    "                d.m[c + r] = a.m[r] * b.m[c] + a.m[4 + r] * b.m[c + 1] + a.m[8 + r] * b.m[c + 2] + a.m[12 + r] * b.m[c + 3]\n"
+    "            end\n"
+    "        end\n"
+    "        return d\n"
+    "    end,\n"
+    "    __index = {\n"
+    "        setIdentity = function(a)\n"
+    "            for i = 0, 15 do a.m[i] = (i % 5 == 0) and 1 or 0 end\n"
+    "            return a\n"
+    "        end,\n"
+    "        transformPoint = function(a, v)\n"
+    "            local m = a.m\n"
+    "            return Vector3(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12], m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13], m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14])\n"
+    "        end,\n"
+    "        transformVector = function(a, v)\n"
+    "            local m = a.m\n"
+    "            return Vector3(m[0] * v.x + m[4] * v.y + m[8] * v.z, m[1] * v.x + m[5] * v.y + m[9] * v.z, m[2] * v.x + m[6] * v.y + m[10] * v.z)\n"
+    "        end\n"
+    "    }\n"
+    "})\n"
+    "FFI = { Vector2 = Vector2, Vector3 = Vector3, Vector4 = Vector4, Quaternion = Quaternion, Matrix = Matrix, istype = ffi.istype }\n";
+#endif
+
 /**
  * @script{ignore}
  */
@@ -715,17 +1054,54 @@ void appendLuaPath(lua_State* state, const char* path)
     lua_pop(state, 1);
 }
 
+#ifndef GP_LUAJIT
+// Routes the memory of the Lua state through the engine's allocator.
+static void* allocateScriptMemory(void* userData, void* memory, size_t size, size_t newSize)
+{
+    // Lua passes the type of a new object in size when memory is NULL.
+    return Allocator::reallocate(memory, memory ? size : 0, newSize, Allocator::SCRIPT);
+}
+#endif
+
+// Called on errors outside of a protected call, like the panic function of luaL_newstate.
+static int panic(lua_State* state)
+{
+    GP_ERROR("Unprotected error in call to Lua API (%s).", lua_tostring(state, -1));
+    return 0;
+}
+
 void ScriptController::initialize()
 {
+#ifdef GP_LUAJIT
+    // LuaJIT keeps its memory close to the JIT-compiled code, so it uses its own allocator.
     _lua = luaL_newstate();
+#else
+    _lua = lua_newstate(allocateScriptMemory, NULL);
+#endif
+    if (_lua)
+        lua_atpanic(_lua, panic);
     if (!_lua)
         GP_ERROR("Failed to initialize Lua scripting engine.");
     luaL_openlibs(_lua);
+    _stateGeneration = ++_generation;
+
+    // The bindings register their classes and hierarchy again in the new state.
+    _hierarchy.clear();
+    _typeIds.clear();
+    _typeIdCache.clear();
+    _typeAncestors.clear();
+    if (_gcBudget > 0.0f)
+        lua_gc(_lua, LUA_GCSTOP, 0);
 
 #ifndef NO_LUA_BINDINGS
     lua_RegisterAllBindings();
     ScriptUtil::registerFunction("convert", ScriptController::convert);
+    ScriptUtil::registerFunction("loadResource", ScriptController::loadResource);
 #endif
+    ScriptUtil::registerFunction("startCoroutine", ScriptController::startCoroutine);
+    ScriptUtil::registerFunction("wait", ScriptController::wait);
+    ScriptUtil::registerFunction("waitFrames", ScriptController::waitFrames);
+    ScriptUtil::registerFunction("waitForClip", ScriptController::waitForClip);
 
     // Append to the LUA_PATH to allow scripts to be found in the resource folder on all platforms
     appendLuaPath(_lua, FileSystem::getResourcePath());
@@ -734,12 +1110,16 @@ void ScriptController::initialize()
     if (luaL_dostring(_lua, lua_print_function))
         GP_ERROR("Failed to load custom print() function with error: '%s'.", lua_tostring(_lua, -1));
 
-    // Change the functions that read a file to use FileSystem.getResourcePath as their base path.
+    // Change the functions that read a file to read relative paths from the resources in place.
     if (luaL_dostring(_lua, lua_loadfile_function))
         GP_ERROR("Failed to load custom loadfile() function with error: '%s'.", lua_tostring(_lua, -1));
     if (luaL_dostring(_lua, lua_dofile_function))
         GP_ERROR("Failed to load custom dofile() function with error: '%s'.", lua_tostring(_lua, -1));
 
+#ifdef GP_LUAJIT
+    initializeFFI();
+#endif
+
     // Write game command-line arguments to a global lua "arg" table
     std::ostringstream args;
     int argc;
@@ -758,82 +1138,171 @@ void ScriptController::initialize()
     }
 }
 
+// The enumeration types of the global callback arguments (pushEnum caches by their address).
+static const char* __keyEventType = "Keyboard::KeyEvent";
+static const char* __keyType = "Keyboard::Key";
+static const char* __touchEventType = "Touch::TouchEvent";
+static const char* __mouseEventType = "Mouse::MouseEvent";
+static const char* __gamepadEventType = "Gamepad::GamepadEvent";
+
 void ScriptController::initializeGame()
 {
-    std::vector<std::string>& list = _callbacks[INITIALIZE];
+    std::vector<Callback>& list = _callbacks[INITIALIZE];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str());
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+            callFunction(list[i].function.c_str(), 0, 0);
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::finalize()
 {
+    clearCoroutines();
     if (_lua)
 	{
         lua_close(_lua);
 		_lua = NULL;
 	}
+    _chunks.clear();
 }
 
 void ScriptController::finalizeGame()
 {
-    std::vector<std::string> finalizeCallbacks = _callbacks[FINALIZE]; // no & : makes a copy of the vector
+    std::vector<Callback> finalizeCallbacks;
+    finalizeCallbacks.swap(_callbacks[FINALIZE]);
 
-	// Remove any registered callbacks so they don't get called after shutdown
-	for (unsigned int i = 0; i < CALLBACK_COUNT; i++)
+    // Remove any registered callbacks so they don't get called after shutdown
+    for (unsigned int i = 0; i < CALLBACK_COUNT; i++)
+    {
+        for (size_t j = 0; j < _callbacks[i].size(); ++j)
+            releaseFunction(&_callbacks[i][j].ref, _callbacks[i][j].generation);
         _callbacks[i].clear();
+    }
 
-	// Fire script finalize callbacks
+    // Fire script finalize callbacks
     for (size_t i = 0; i < finalizeCallbacks.size(); ++i)
-        executeFunction<void>(finalizeCallbacks[i].c_str());
+    {
+        Callback& callback = finalizeCallbacks[i];
+        int top = lua_gettop(_lua);
+        if (pushFunction(callback.function, &callback.ref, &callback.generation))
+            callFunction(callback.function.c_str(), 0, 0);
+        lua_settop(_lua, top);
+        releaseFunction(&callback.ref, callback.generation);
+    }
 
     // Perform a full garbage collection cycle.
-	// Note that this does NOT free any global variables declared in scripts, since 
-	// they are stored in the global state and are still referenced. Only after 
-	// closing the state (lua_close) will those variables be released.
+    // Note that this does NOT free any global variables declared in scripts, since 
+    // they are stored in the global state and are still referenced. Only after 
+    // closing the state (lua_close) will those variables be released.
     lua_gc(_lua, LUA_GCCOLLECT, 0);
 }
 
 void ScriptController::update(float elapsedTime)
 {
-    std::vector<std::string>& list = _callbacks[UPDATE];
+    GP_PROFILE_SCOPE("ScriptController::update");
+
+    updateCoroutines();
+
+    std::vector<Callback>& list = _callbacks[UPDATE];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "f", elapsedTime);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushnumber(_lua, elapsedTime);
+            callFunction(list[i].function.c_str(), 1, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::render(float elapsedTime)
 {
-    std::vector<std::string>& list = _callbacks[RENDER];
+    GP_PROFILE_SCOPE("ScriptController::render");
+
+    std::vector<Callback>& list = _callbacks[RENDER];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "f", elapsedTime);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushnumber(_lua, elapsedTime);
+            callFunction(list[i].function.c_str(), 1, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::resizeEvent(unsigned int width, unsigned int height)
 {
-    std::vector<std::string>& list = _callbacks[RESIZE_EVENT];
+    std::vector<Callback>& list = _callbacks[RESIZE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "uiui", width, height);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushunsigned(_lua, width);
+            lua_pushunsigned(_lua, height);
+            callFunction(list[i].function.c_str(), 2, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::keyEvent(Keyboard::KeyEvent evt, int key)
 {
-    std::vector<std::string>& list = _callbacks[KEY_EVENT];
+    std::vector<Callback>& list = _callbacks[KEY_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Keyboard::KeyEvent][Keyboard::Key]", evt, key);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            pushEnum(__keyEventType, evt);
+            pushEnum(__keyType, key);
+            callFunction(list[i].function.c_str(), 2, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::touchEvent(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex)
 {
-    std::vector<std::string>& list = _callbacks[TOUCH_EVENT];
+    std::vector<Callback>& list = _callbacks[TOUCH_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Touch::TouchEvent]iiui", evt, x, y, contactIndex);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            pushEnum(__touchEventType, evt);
+            lua_pushinteger(_lua, x);
+            lua_pushinteger(_lua, y);
+            lua_pushunsigned(_lua, contactIndex);
+            callFunction(list[i].function.c_str(), 4, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 bool ScriptController::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheelDelta)
 {
-    std::vector<std::string>& list = _callbacks[MOUSE_EVENT];
+    std::vector<Callback>& list = _callbacks[MOUSE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
     {
-        if (executeFunction<bool>(list[i].c_str(), "[Mouse::MouseEvent]iii", evt, x, y, wheelDelta))
+        int top = lua_gettop(_lua);
+        bool consumed = false;
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            pushEnum(__mouseEventType, evt);
+            lua_pushinteger(_lua, x);
+            lua_pushinteger(_lua, y);
+            lua_pushinteger(_lua, wheelDelta);
+            if (callFunction(list[i].function.c_str(), 4, 1))
+                consumed = ScriptUtil::luaCheckBool(_lua, -1);
+        }
+        lua_settop(_lua, top);
+        if (consumed)
             return true;
     }
     return false;
@@ -841,36 +1310,74 @@ bool ScriptController::mouseEvent(Mouse::MouseEvent evt, int x, int y, int wheel
 
 void ScriptController::gestureSwipeEvent(int x, int y, int direction)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_SWIPE_EVENT];
+    std::vector<Callback>& list = _callbacks[GESTURE_SWIPE_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "iii", x, y, direction);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushinteger(_lua, x);
+            lua_pushinteger(_lua, y);
+            lua_pushinteger(_lua, direction);
+            callFunction(list[i].function.c_str(), 3, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::gesturePinchEvent(int x, int y, float scale)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_PINCH_EVENT];
+    std::vector<Callback>& list = _callbacks[GESTURE_PINCH_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "iif", x, y, scale);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushinteger(_lua, x);
+            lua_pushinteger(_lua, y);
+            lua_pushnumber(_lua, scale);
+            callFunction(list[i].function.c_str(), 3, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::gestureTapEvent(int x, int y)
 {
-    std::vector<std::string>& list = _callbacks[GESTURE_TAP_EVENT];
+    std::vector<Callback>& list = _callbacks[GESTURE_TAP_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "ii", x, y);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            lua_pushinteger(_lua, x);
+            lua_pushinteger(_lua, y);
+            callFunction(list[i].function.c_str(), 2, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::gamepadEvent(Gamepad::GamepadEvent evt, Gamepad* gamepad, unsigned int analogIndex)
 {
-    std::vector<std::string>& list = _callbacks[GAMEPAD_EVENT];
+    std::vector<Callback>& list = _callbacks[GAMEPAD_EVENT];
     for (size_t i = 0; i < list.size(); ++i)
-        executeFunction<void>(list[i].c_str(), "[Gamepad::GamepadEvent]<Gamepad>", evt, gamepad);
+    {
+        int top = lua_gettop(_lua);
+        if (pushFunction(list[i].function, &list[i].ref, &list[i].generation))
+        {
+            pushEnum(__gamepadEventType, evt);
+            pushObject("Gamepad", gamepad);
+            callFunction(list[i].function.c_str(), 2, 0);
+        }
+        lua_settop(_lua, top);
+    }
 }
 
 void ScriptController::executeFunctionHelper(int resultCount, const char* func, const char* args, va_list* list)
 {
-	if (!_lua)
-		return; // handles calling this method after script is finalized
+    if (!_lua)
+        return; // handles calling this method after script is finalized
 
     if (func == NULL)
     {
@@ -884,6 +1391,14 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
         return;
     }
 
+    int argumentCount = pushArguments(args, list);
+
+    // Perform the function call.
+    callFunction(func, argumentCount, resultCount);
+}
+
+int ScriptController::pushArguments(const char* args, va_list* list)
+{
     const char* sig = args;
     int argumentCount = 0;
 
@@ -965,19 +1480,7 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
                     i = type.find("::");
                 }
 
-                void* ptr = va_arg(*list, void*);
-                if (ptr == NULL)
-                {
-                    lua_pushnil(_lua);
-                }
-                else
-                {
-                    ScriptUtil::LuaObject* object = (ScriptUtil::LuaObject*)lua_newuserdata(_lua, sizeof(ScriptUtil::LuaObject));
-                    object->instance = ptr;
-                    object->owns = false;
-                    luaL_getmetatable(_lua, type.c_str());
-                    lua_setmetatable(_lua, -2);
-                }
+                pushObject(type.c_str(), va_arg(*list, void*));
                 break;
             }
             default:
@@ -990,9 +1493,149 @@ void ScriptController::executeFunctionHelper(int resultCount, const char* func,
         }
     }
 
-    // Perform the function call.
+    return argumentCount;
+}
+
+bool ScriptController::pushFunction(const std::string& function, int* ref, unsigned int* generation)
+{
+    GP_ASSERT(ref);
+    GP_ASSERT(generation);
+
+    if (!_lua)
+        return false; // handles calling this method after script is finalized
+
+    // Use the cached reference unless a script has been loaded since it was resolved.
+    if (*ref != LUA_NOREF && *generation == _generation)
+    {
+        lua_rawgeti(_lua, LUA_REGISTRYINDEX, *ref);
+        return true;
+    }
+    releaseFunction(ref, *generation);
+
+    int top = lua_gettop(_lua);
+    if (!getNestedVariable(_lua, function.c_str()) || lua_isnil(_lua, -1))
+    {
+        lua_settop(_lua, top);
+        GP_WARN("Failed to call function '%s'", function.c_str());
+        return false;
+    }
+
+    // Leave only the function on the stack (getNestedVariable also leaves the tables it went through).
+    if (lua_gettop(_lua) > top + 1)
+    {
+        lua_replace(_lua, top + 1);
+        lua_settop(_lua, top + 1);
+    }
+    lua_pushvalue(_lua, -1);
+    *ref = luaL_ref(_lua, LUA_REGISTRYINDEX);
+    *generation = _generation;
+    return true;
+}
+
+void ScriptController::releaseFunction(int* ref, unsigned int generation)
+{
+    GP_ASSERT(ref);
+
+    // References resolved in a Lua state that has since been closed went away with it.
+    if (*ref != LUA_NOREF && _lua && generation >= _stateGeneration)
+        luaL_unref(_lua, LUA_REGISTRYINDEX, *ref);
+    *ref = LUA_NOREF;
+}
+
+bool ScriptController::callFunction(const char* function, int argumentCount, int resultCount)
+{
     if (lua_pcall(_lua, argumentCount, resultCount, 0) != 0)
-        GP_WARN("Failed to call function '%s' with error '%s'.", func, lua_tostring(_lua, -1));
+    {
+        GP_WARN("Failed to call function '%s' with error '%s'.", function, lua_tostring(_lua, -1));
+        return false;
+    }
+    return true;
+}
+
+void ScriptController::pushEnum(const char* type, unsigned int value)
+{
+    std::pair<const char*, unsigned int> key(type, value);
+    std::map<std::pair<const char*, unsigned int>, std::string>::iterator itr = _enumStrings.find(key);
+    if (itr == _enumStrings.end())
+    {
+        std::string typeName = type;
+        std::string enumStr = "";
+        for (unsigned int i = 0; enumStr.size() == 0 && i < _stringFromEnum.size(); i++)
+        {
+            enumStr = (*_stringFromEnum[i])(typeName, value);
+        }
+        itr = _enumStrings.insert(std::make_pair(key, enumStr)).first;
+    }
+    lua_pushstring(_lua, itr->second.c_str());
+}
+
+void ScriptController::pushObject(const char* type, void* ptr)
+{
+    if (ptr == NULL)
+    {
+        lua_pushnil(_lua);
+    }
+    else
+    {
+        ScriptUtil::LuaObject* object = (ScriptUtil::LuaObject*)lua_newuserdata(_lua, sizeof(ScriptUtil::LuaObject));
+        object->instance = ptr;
+        object->owns = false;
+        luaL_getmetatable(_lua, type);
+        lua_setmetatable(_lua, -2);
+    }
+}
+
+int ScriptController::beginObjectCalls(const char* function, const char* reusedType)
+{
+    int ref = LUA_NOREF;
+    unsigned int generation = 0;
+    if (!pushFunction(function, &ref, &generation))
+        return 0;
+
+    // The function stays on the stack, so the registry reference is not needed.
+    releaseFunction(&ref, generation);
+    int base = lua_gettop(_lua);
+
+    if (reusedType)
+    {
+        ScriptUtil::LuaObject* object = (ScriptUtil::LuaObject*)lua_newuserdata(_lua, sizeof(ScriptUtil::LuaObject));
+        object->instance = NULL;
+        object->owns = false;
+        luaL_getmetatable(_lua, reusedType);
+        lua_setmetatable(_lua, -2);
+    }
+    return base;
+}
+
+bool ScriptController::callObjectFunction(int base, const char* function, const char* type, void* object)
+{
+    GP_ASSERT(base > 0);
+
+    lua_pushvalue(_lua, base);
+    if (type)
+    {
+        pushObject(type, object);
+    }
+    else
+    {
+        ((ScriptUtil::LuaObject*)lua_touserdata(_lua, base + 1))->instance = object;
+        lua_pushvalue(_lua, base + 1);
+    }
+
+    if (!callFunction(function, 1, 1))
+    {
+        lua_pop(_lua, 1);
+        return false;
+    }
+    bool result = lua_toboolean(_lua, -1) != 0;
+    lua_pop(_lua, 1);
+    return result;
+}
+
+void ScriptController::endObjectCalls(int base)
+{
+    GP_ASSERT(base > 0);
+    lua_settop(_lua, base - 1);
 }
 
 void ScriptController::registerCallback(const char* callback, const char* function)
@@ -1000,7 +1643,7 @@ void ScriptController::registerCallback(const char* callback, const char* functi
     ScriptCallback scb = toCallback(callback);
     if (scb < INVALID_CALLBACK)
     {
-        _callbacks[scb].push_back(function);
+        _callbacks[scb].push_back(Callback(function));
     }
     else
     {
@@ -1013,10 +1656,16 @@ void ScriptController::unregisterCallback(const char* callback, const char* func
     ScriptCallback scb = toCallback(callback);
     if (scb < INVALID_CALLBACK)
     {
-        std::vector<std::string>& list = _callbacks[scb];
-        std::vector<std::string>::iterator itr = std::find(list.begin(), list.end(), std::string(function));
-        if (itr != list.end())
-            list.erase(itr);
+        std::vector<Callback>& list = _callbacks[scb];
+        for (std::vector<Callback>::iterator itr = list.begin(); itr != list.end(); ++itr)
+        {
+            if (itr->function == function)
+            {
+                releaseFunction(&itr->ref, itr->generation);
+                list.erase(itr);
+                break;
+            }
+        }
     }
     else
     {
@@ -1024,6 +1673,11 @@ void ScriptController::unregisterCallback(const char* callback, const char* func
     }
 }
 
+ScriptController::Callback::Callback(const std::string& function)
+    : function(function), ref(LUA_NOREF), generation(0)
+{
+}
+
 ScriptController::ScriptCallback ScriptController::toCallback(const char* name)
 {
     if (strcmp(name, "initialize") == 0)
@@ -1054,6 +1708,264 @@ ScriptController::ScriptCallback ScriptController::toCallback(const char* name)
         return ScriptController::INVALID_CALLBACK;
 }
 
+int ScriptController::loadResource(lua_State* state)
+{
+    const char* path = luaL_checkstring(state, 1);
+
+    int size = 0;
+    char* source = FileSystem::readAll(path, &size);
+    if (source == NULL)
+    {
+        lua_pushnil(state);
+        lua_pushfstring(state, "cannot open %s", path);
+        return 2;
+    }
+
+    std::string chunkName("@");
+    chunkName += path;
+    int result = luaL_loadbuffer(state, source, size, chunkName.c_str());
+    SAFE_DELETE_ARRAY(source);
+    if (result != 0)
+    {
+        // The error message is on the top of the stack.
+        lua_pushnil(state);
+        lua_insert(state, -2);
+        return 2;
+    }
+    return 1;
+}
+
+int ScriptController::startCoroutine(lua_State* state)
+{
+    luaL_checktype(state, 1, LUA_TFUNCTION);
+    int argumentCount = lua_gettop(state) - 1;
+
+    // Move the function and its arguments to a new thread and anchor it until it is resumed.
+    lua_State* thread = lua_newthread(state);
+    lua_insert(state, 1);
+    lua_xmove(state, thread, argumentCount + 1);
+    int ref = luaL_ref(state, LUA_REGISTRYINDEX);
+
+    Game::getInstance()->getScriptController()->resumeCoroutine(ref);
+    return 0;
+}
+
+int ScriptController::wait(lua_State* state)
+{
+    double seconds = luaL_checknumber(state, 1);
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int ref = sc->suspendCoroutine(state);
+    if (sc->_coroutineTimers->add(Game::getGameTime() + seconds * 1000.0, &sc->_coroutineTimer, (void*)(size_t)ref) == 0)
+        sc->_resumeQueue.push_back(ref);
+    return lua_yield(state, 0);
+}
+
+int ScriptController::waitFrames(lua_State* state)
+{
+    int count = luaL_checkint(state, 1);
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int ref = sc->suspendCoroutine(state);
+    sc->_frameWaits.push_back(std::make_pair(sc->_updateCount + (unsigned int)std::max(count, 1), ref));
+    return lua_yield(state, 0);
+}
+
+int ScriptController::waitForClip(lua_State* state)
+{
+    AnimationClip* clip = (AnimationClip*)((ScriptUtil::LuaObject*)luaL_checkudata(state, 1, "AnimationClip"))->instance;
+    luaL_argcheck(state, clip != NULL, 1, "NULL animation clip");
+
+    ScriptController* sc = Game::getInstance()->getScriptController();
+    int ref = sc->suspendCoroutine(state);
+    clip->addRef();
+    sc->_clipWaits.push_back(std::make_pair(clip, ref));
+    return lua_yield(state, 0);
+}
+
+int ScriptController::suspendCoroutine(lua_State* state)
+{
+    if (lua_pushthread(state))
+    {
+        lua_pop(state, 1);
+        luaL_error(state, "Only coroutines started with startCoroutine can wait.");
+    }
+    return luaL_ref(state, LUA_REGISTRYINDEX);
+}
+
+void ScriptController::resumeCoroutine(int ref)
+{
+    lua_State* caller = _lua;
+    lua_rawgeti(caller, LUA_REGISTRYINDEX, ref);
+    lua_State* thread = lua_tothread(caller, -1);
+    luaL_unref(caller, LUA_REGISTRYINDEX, ref);
+    GP_ASSERT(thread);
+
+    // A new coroutine has its function and arguments on its stack; a suspended one is resumed without values.
+    int argumentCount = lua_status(thread) == LUA_YIELD ? 0 : lua_gettop(thread) - 1;
+    _lua = thread;
+    int status = lua_resume(thread, caller, argumentCount);
+    _lua = caller;
+    if (status != LUA_OK && status != LUA_YIELD)
+        GP_WARN("Coroutine failed with error '%s'.", lua_tostring(thread, -1));
+
+    // The coroutine stays anchored only if it waits again.
+    lua_pop(caller, 1);
+}
+
+void ScriptController::updateCoroutines()
+{
+    ++_updateCount;
+    _coroutineTimers->advance(Game::getGameTime());
+
+    size_t count = 0;
+    for (size_t i = 0, waitCount = _frameWaits.size(); i < waitCount; ++i)
+    {
+        if (_frameWaits[i].first <= _updateCount)
+            _resumeQueue.push_back(_frameWaits[i].second);
+        else
+            _frameWaits[count++] = _frameWaits[i];
+    }
+    _frameWaits.resize(count);
+
+    count = 0;
+    for (size_t i = 0, waitCount = _clipWaits.size(); i < waitCount; ++i)
+    {
+        if (!_clipWaits[i].first->isPlaying())
+        {
+            _clipWaits[i].first->release();
+            _resumeQueue.push_back(_clipWaits[i].second);
+        }
+        else
+        {
+            _clipWaits[count++] = _clipWaits[i];
+        }
+    }
+    _clipWaits.resize(count);
+
+    // Coroutines that wait again while being resumed are queued for a later update.
+    if (_resumeQueue.empty())
+        return;
+    _resuming.swap(_resumeQueue);
+    for (size_t i = 0, resumeCount = _resuming.size(); i < resumeCount; ++i)
+        resumeCoroutine(_resuming[i]);
+    _resuming.clear();
+}
+
+void ScriptController::clearCoroutines()
+{
+    // The registry references go away with the Lua state.
+    _coroutineTimers->clear();
+    for (size_t i = 0, waitCount = _clipWaits.size(); i < waitCount; ++i)
+        _clipWaits[i].first->release();
+    _clipWaits.clear();
+    _frameWaits.clear();
+    _resumeQueue.clear();
+}
+
+void ScriptController::CoroutineTimer::timeEvent(long timeDiff, void* cookie)
+{
+    Game::getInstance()->getScriptController()->_resumeQueue.push_back((int)(size_t)cookie);
+}
+
+#ifdef GP_LUAJIT
+void ScriptController::initializeFFI()
+{
+    _ffiTypes.clear();
+    _ffiIsType = LUA_NOREF;
+
+    if (luaL_loadbuffer(_lua, lua_ffi_math_functions, strlen(lua_ffi_math_functions), "=FFI") != 0)
+    {
+        GP_ERROR("Failed to load the FFI math functions with error: '%s'.", lua_tostring(_lua, -1));
+        return;
+    }
+    lua_pushstring(_lua, lua_ffi_cdef);
+    if (lua_pcall(_lua, 1, 0, 0) != 0)
+    {
+        GP_ERROR("Failed to declare the math classes to the FFI with error: '%s'.", lua_tostring(_lua, -1));
+        return;
+    }
+
+    // Keep the ctypes of the math classes to check the cdata passed to the bindings.
+    static const char* types[] = { "Vector2", "Vector3", "Vector4", "Quaternion", "Matrix" };
+    lua_getglobal(_lua, "FFI");
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+    {
+        lua_getfield(_lua, -1, types[i]);
+        _ffiTypes[types[i]] = luaL_ref(_lua, LUA_REGISTRYINDEX);
+    }
+    lua_getfield(_lua, -1, "istype");
+    _ffiIsType = luaL_ref(_lua, LUA_REGISTRYINDEX);
+    lua_pop(_lua, 1);
+}
+
+void* ScriptController::toFFIPointer(int index, const char* type)
+{
+    std::map<std::string, int>::const_iterator itr = _ffiTypes.find(type);
+    if (itr == _ffiTypes.end())
+        return NULL;
+
+    if (index < 0)
+        index += lua_gettop(_lua) + 1;
+    lua_rawgeti(_lua, LUA_REGISTRYINDEX, _ffiIsType);
+    lua_rawgeti(_lua, LUA_REGISTRYINDEX, itr->second);
+    lua_pushvalue(_lua, index);
+    lua_call(_lua, 2, 1);
+    bool matched = lua_toboolean(_lua, -1) != 0;
+    lua_pop(_lua, 1);
+
+    // The address of cdata is the address of its data.
+    return matched ? const_cast<void*>(lua_topointer(_lua, index)) : NULL;
+}
+#endif
+
+void ScriptController::buildTypeAncestors()
+{
+    unsigned int count = (unsigned int)_typeIds.size();
+    _typeWords = (count + 31) / 32;
+    _typeAncestors.assign((size_t)count * _typeWords, 0);
+    for (unsigned int i = 0; i < count; ++i)
+        _typeAncestors[i * _typeWords + (i >> 5)] |= 1u << (i & 31);
+
+    for (std::map<std::string, std::vector<std::string> >::const_iterator itr = _hierarchy.begin(); itr != _hierarchy.end(); ++itr)
+    {
+        std::map<std::string, unsigned int>::const_iterator base = _typeIds.find(itr->first);
+        if (base == _typeIds.end())
+            continue;
+        for (size_t i = 0, derivedCount = itr->second.size(); i < derivedCount; ++i)
+        {
+            std::map<std::string, unsigned int>::const_iterator derived = _typeIds.find(itr->second[i]);
+            if (derived != _typeIds.end())
+                _typeAncestors[derived->second * _typeWords + (base->second >> 5)] |= 1u << (base->second & 31);
+        }
+    }
+
+    // The generated pairs already list every descendant of a class, but close the sets in case some do not.
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            unsigned int* ancestors = &_typeAncestors[i * _typeWords];
+            for (unsigned int j = 0; j < count; ++j)
+            {
+                if (j == i || (ancestors[j >> 5] & (1u << (j & 31))) == 0)
+                    continue;
+                const unsigned int* inherited = &_typeAncestors[j * _typeWords];
+                for (unsigned int w = 0; w < _typeWords; ++w)
+                {
+                    if ((ancestors[w] | inherited[w]) != ancestors[w])
+                    {
+                        ancestors[w] |= inherited[w];
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
 int ScriptController::convert(lua_State* state)
 {
     // Get the number of parameters.
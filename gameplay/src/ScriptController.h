@@ -327,6 +327,53 @@ LuaArray<T> getObjectPointer(int index, const char* type, bool nonNull, bool* su
  */
 const char* getString(int index, bool isStdString);
 
+/**
+ * Pushes a copy of a value onto the Lua stack, stored in the userdata of its LuaObject.
+ *
+ * This is used by the generated bindings for the math classes (Vector2, Vector3, Vector4,
+ * Quaternion and Matrix), which scripts create in large numbers as temporaries. Compared to
+ * an owned heap object, the value costs a single garbage collected allocation and no delete.
+ * The LuaObject is not marked as owning the instance, so its destructor is never called;
+ * T must not need it.
+ *
+ * @param state The Lua state.
+ * @param value The value.
+ * @param type The unique Lua type name of the value (its metatable name).
+ *
+ * @script{ignore}
+ */
+template <typename T>
+void pushValue(lua_State* state, const T& value, const char* type);
+
+/**
+ * Pushes the metatable of the given type onto the Lua stack, from a cached registry reference.
+ *
+ * @param state The Lua state.
+ * @param type The unique Lua type name.
+ * @param ref The cached reference to the metatable; resolved on first use.
+ * @param generation The Lua state generation of the cached reference.
+ *
+ * @script{ignore}
+ */
+void pushMetatable(lua_State* state, const char* type, int* ref, unsigned int* generation);
+
+/**
+ * Determines whether the value at the given stack index is an object of the given type or of a type derived from it.
+ *
+ * Classes are numbered as they are registered, and the number is kept in their metatable. The check looks
+ * up the number of the object's class in a table of the ancestors of every class, so no class names are
+ * compared. The number of the given type is cached by the address of its name, so the name must live as
+ * long as the program, as the literals of the generated bindings do.
+ *
+ * @param index The stack index.
+ * @param type The unique Lua type name.
+ *
+ * @return true if the value is an object of the type.
+ *
+ * @script{ignore}
+ */
+bool isObjectOfType(int index, const char* type);
+
 /**
  * Checks that the parameter at the given stack position is a boolean and returns it.
  * 
@@ -343,17 +390,37 @@ bool luaCheckBool(lua_State* state, int n);
 
 /**
  * Controls and manages all scripts.
+ *
+ * Scripts can run long behaviors as coroutines instead of chains of scheduled functions.
+ * startCoroutine(function, ...) runs a function as a coroutine, which can suspend itself with
+ * wait(seconds) for an amount of game time, waitFrames(count) for a number of script updates
+ * or waitForClip(clip) until an animation clip is no longer playing. Suspended coroutines are
+ * resumed at the start of the script update in which they become due; their game time is kept
+ * in a timer wheel of the controller, so waiting neither resolves functions by name nor
+ * allocates closures. A coroutine that yields other than through these functions is dropped.
+ *
+ * Games built with GP_LUAJIT run their scripts on LuaJIT. The plain math classes (Vector2, Vector3,
+ * Vector4, Quaternion and Matrix) are then also declared to the FFI from the declarations generated
+ * by gameplay-luagen, and the global FFI table holds their constructors (FFI.Vector3(x, y, z)) with
+ * the arithmetic operators and common methods. Math on these values is compiled by the JIT without
+ * allocating userdata, and they can be passed to the bindings wherever the class is expected.
  */
 class ScriptController
 {
     friend class Game;
     friend class Platform;
+    friend class Scene;
+    friend class ScriptTarget;
 
 public:
 
     /**
      * Loads the given script file and executes its global code.
      * 
+     * If a script compiled by 'gameplay-luagen -c' (the path with a 'c' appended) is present and was
+     * compiled from the current source, it is loaded instead of the source. Scripts that are loaded
+     * again are not parsed again unless their source has changed.
+     * 
      * @param path The path to the script.
      * @param forceReload Whether the script should be reloaded if it has already been loaded.
      */
@@ -368,6 +435,51 @@ public:
      */
     std::string loadUrl(const char* url);
 
+    /**
+     * Gets the size of the incremental garbage collection step performed every frame.
+     *
+     * @return The step size in kilobytes, or 0 if no step is performed.
+     */
+    unsigned int getGarbageCollectionStep() const;
+
+    /**
+     * Sets the size of an incremental garbage collection step to perform every frame.
+     *
+     * The collector still runs automatically while scripts allocate (unless a budget is set
+     * with setGarbageCollectionBudget). The step performed at the end of each frame collects
+     * garbage ahead of that, so that less of the collection work falls on the script code
+     * that happens to allocate. It can also be set with the
+     * 'gcStepSize' property of the 'scripts' namespace of the game config.
+     *
+     * @param kilobytes The step size in kilobytes (as for Lua's collectgarbage("step")), or 0 for none.
+     */
+    void setGarbageCollectionStep(unsigned int kilobytes);
+
+    /**
+     * Gets the time the garbage collector may run for every frame.
+     *
+     * @return The time budget in milliseconds, or 0 if the collector runs automatically.
+     */
+    float getGarbageCollectionBudget() const;
+
+    /**
+     * Sets the time the garbage collector may run for every frame.
+     *
+     * With a budget, the automatic collector is stopped and garbage is only collected at the
+     * end of each frame, in incremental steps (of the size set with setGarbageCollectionStep)
+     * until the budget is used up or a collection cycle completes. If scripts produce garbage
+     * faster than the budget allows it to be collected, and the memory in use grows to four
+     * times what it was after the last complete cycle, a full collection is performed.
+     * It can also be set with the 'gcBudget' property of the 'scripts' namespace of the
+     * game config.
+     *
+     * The collector time is recorded by the profiler as the ScriptController::collectGarbage
+     * scope, and the memory in use by Lua as the "Lua memory (KB)" counter.
+     *
+     * @param milliseconds The time budget in milliseconds, or 0 to let the collector run automatically.
+     */
+    void setGarbageCollectionBudget(float milliseconds);
+
     /**
      * Registers the given script callback.
      *
@@ -778,6 +890,46 @@ private:
         INVALID_CALLBACK = CALLBACK_COUNT
     };
 
+    /**
+     * A loaded script chunk and the source it was loaded from.
+     */
+    struct Chunk
+    {
+        /** Holds the registry reference of the chunk's function. */
+        int ref;
+        /** Holds the size of the source. */
+        unsigned int sourceSize;
+        /** Holds the hash of the source. */
+        unsigned int sourceHash;
+    };
+
+    /**
+     * A registered callback function and its cached reference in the Lua registry.
+     */
+    struct Callback
+    {
+        /** Constructor. */
+        Callback(const std::string& function);
+
+        /** Holds the name of the Lua script function. */
+        std::string function;
+        /** Holds the registry reference of the function, or LUA_NOREF if it is not resolved. */
+        int ref;
+        /** Holds the script generation the reference was resolved in. */
+        unsigned int generation;
+    };
+
+    /**
+     * Queues the coroutines waiting for game time when their timer fires.
+     */
+    struct CoroutineTimer : public TimeListener
+    {
+        /**
+         * @see TimeListener#timeEvent(long, void*)
+         */
+        void timeEvent(long timeDiff, void* cookie);
+    };
+
     /**
      * Constructor.
      */
@@ -818,6 +970,12 @@ private:
      */
     void update(float elapsedTime);
 
+    /**
+     * Collects garbage at the end of a frame, as set with setGarbageCollectionStep and
+     * setGarbageCollectionBudget, and records the memory in use by Lua in the profiler.
+     */
+    void collectGarbage();
+
     /**
      * Renders the game using the appropriate callback script (if it was specified).
      */
@@ -935,6 +1093,116 @@ private:
      */
     void executeFunctionHelper(int resultCount, const char* func, const char* args, va_list* list);
 
+    /**
+     * Pushes the chunk of the given script onto the Lua stack without running it.
+     *
+     * The chunk is reused if the script was loaded before and its source has not changed.
+     * Otherwise it is loaded from the compiled script (the path with a 'c' appended) if that
+     * was compiled from the current source, or from the source if not.
+     *
+     * @param path The path to the script.
+     *
+     * @return True if the chunk was pushed, false if it failed to load (in which case the
+     *      error message is pushed instead).
+     */
+    bool loadChunk(const char* path);
+
+    /**
+     * Pushes the given arguments onto the Lua stack.
+     *
+     * @param args The argument signature (see executeFunctionHelper).
+     * @param list The variable argument list.
+     *
+     * @return The number of values pushed.
+     */
+    int pushArguments(const char* args, va_list* list);
+
+    /**
+     * Pushes the given Lua function onto the stack.
+     *
+     * The function is looked up by name only the first time and after a script has been
+     * loaded (which may redefine it); otherwise it is pushed from its registry reference.
+     *
+     * @param function The name of the function.
+     * @param ref The cached registry reference of the function; updated if it is resolved again.
+     * @param generation The script generation of the cached reference; updated with ref.
+     *
+     * @return True if a function was pushed, false if the name does not refer to a function
+     *      (in which case nothing is pushed).
+     */
+    bool pushFunction(const std::string& function, int* ref, unsigned int* generation);
+
+    /**
+     * Releases a registry reference returned by pushFunction.
+     *
+     * @param ref The registry reference; set to LUA_NOREF.
+     * @param generation The script generation of the reference.
+     */
+    void releaseFunction(int* ref, unsigned int generation);
+
+    /**
+     * Calls the function pushed by pushFunction with the arguments pushed after it.
+     *
+     * @param function The name of the function (for error reporting).
+     * @param argumentCount The number of arguments pushed after the function.
+     * @param resultCount The expected number of returned values.
+     *
+     * @return True if the call succeeded, false if it raised an error (which is logged).
+     */
+    bool callFunction(const char* function, int argumentCount, int resultCount);
+
+    /**
+     * Pushes the string of an enumeration value onto the Lua stack.
+     *
+     * The strings are cached, so the type must be a string that lives as long as the controller.
+     *
+     * @param type The qualified name of the enumeration type.
+     * @param value The enumeration value.
+     */
+    void pushEnum(const char* type, unsigned int value);
+
+    /**
+     * Pushes a pointer to an object onto the Lua stack, or nil for a NULL pointer.
+     *
+     * @param type The unique Lua type name of the object (without "::" scope separators).
+     * @param ptr The object.
+     */
+    void pushObject(const char* type, void* ptr);
+
+    /**
+     * Pushes a Lua function that is about to be called for many objects.
+     *
+     * The function is resolved once and stays on the stack until endObjectCalls.
+     * If a type is given, one userdata of that type is pushed after the function and
+     * reused by callObjectFunction for every object, so scripts must not keep it.
+     *
+     * @param function The name of the function.
+     * @param reusedType The unique Lua type name of the reused object, or NULL to push
+     *      a new userdata for every call.
+     *
+     * @return The stack index of the function, or 0 if it was not found.
+     */
+    int beginObjectCalls(const char* function, const char* reusedType);
+
+    /**
+     * Calls the function pushed by beginObjectCalls with an object.
+     *
+     * @param base The stack index returned by beginObjectCalls.
+     * @param function The name of the function (for error reporting).
+     * @param type The unique Lua type name of the object, or NULL to pass it in the reused userdata.
+     * @param object The object.
+     *
+     * @return The boolean returned by the function, or false if the call failed.
+     */
+    bool callObjectFunction(int base, const char* function, const char* type, void* object);
+
+    /**
+     * Pops what beginObjectCalls pushed.
+     *
+     * @param base The stack index returned by beginObjectCalls.
+     */
+    void endObjectCalls(int base);
+
     /**
      * Converts the given string to a valid script callback enumeration value
      * or to ScriptController::INVALID_CALLBACK if there is no valid conversion.
@@ -971,6 +1239,148 @@ private:
      */
     static int convert(lua_State* state);
 
+    /**
+     * Loads a script file of the resources as a Lua chunk, without running it.
+     *
+     * The file is read with FileSystem::readAll, so scripts in mounted archives and in the
+     * Android APK are loaded in place. The loadfile and dofile functions use it for relative
+     * paths.
+     *
+     * <code>
+     * -- The signature of the lua function:
+     * -- param: filename The path of the script file.
+     * -- return: The chunk, or nil and an error message.
+     * function loadResource(filename)
+     * </code>
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     *
+     * @script{ignore}
+     */
+    static int loadResource(lua_State* state);
+
+    /**
+     * Runs a function as a coroutine, until it ends or waits.
+     *
+     * <code>
+     * -- The signature of the lua function:
+     * -- param: func The function to run.
+     * -- param: ...  The arguments to pass to the function.
+     * function startCoroutine(func, ...)
+     * </code>
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     *
+     * @script{ignore}
+     */
+    static int startCoroutine(lua_State* state);
+
+    /**
+     * Suspends the running coroutine for an amount of game time.
+     *
+     * <code>
+     * -- The signature of the lua function:
+     * -- param: seconds The game time to wait for, in seconds.
+     * function wait(seconds)
+     * </code>
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     *
+     * @script{ignore}
+     */
+    static int wait(lua_State* state);
+
+    /**
+     * Suspends the running coroutine for a number of script updates.
+     *
+     * <code>
+     * -- The signature of the lua function:
+     * -- param: count The number of updates to wait for (at least one).
+     * function waitFrames(count)
+     * </code>
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     *
+     * @script{ignore}
+     */
+    static int waitFrames(lua_State* state);
+
+    /**
+     * Suspends the running coroutine until an animation clip is no longer playing.
+     *
+     * <code>
+     * -- The signature of the lua function:
+     * -- param: clip The animation clip.
+     * function waitForClip(clip)
+     * </code>
+     *
+     * @param state The Lua state.
+     *
+     * @return The number of values being returned by this function.
+     *
+     * @script{ignore}
+     */
+    static int waitForClip(lua_State* state);
+
+    /**
+     * Anchors the running coroutine of the given state in the registry before it yields.
+     *
+     * Raises a Lua error if the state is not a coroutine.
+     *
+     * @return The registry reference of the coroutine.
+     */
+    int suspendCoroutine(lua_State* state);
+
+    /**
+     * Resumes a coroutine anchored in the registry and releases its reference.
+     *
+     * The coroutine becomes the state of the controller while it runs, since the bindings
+     * read their arguments from it.
+     *
+     * @param ref The registry reference of the coroutine.
+     */
+    void resumeCoroutine(int ref);
+
+    /**
+     * Resumes the suspended coroutines that are due.
+     */
+    void updateCoroutines();
+
+    /**
+     * Drops all the suspended coroutines.
+     */
+    void clearCoroutines();
+
+#ifdef GP_LUAJIT
+    /**
+     * Declares the math classes to the LuaJIT FFI and defines their operations in the global FFI table.
+     */
+    void initializeFFI();
+
+    /**
+     * Gets the data of FFI cdata of a math class.
+     *
+     * @param index The stack index of the cdata.
+     * @param type The unique Lua type name of the class.
+     *
+     * @return The data, or NULL if the cdata is not of the class.
+     */
+    void* toFFIPointer(int index, const char* type);
+#endif
+
+    /**
+     * Builds the bit sets of the ancestors of the registered classes from the hierarchy pairs.
+     */
+    void buildTypeAncestors();
+
     // Friend functions (used by Lua script bindings).
     friend void ScriptUtil::registerLibrary(const char* name, const luaL_Reg* functions);
     friend void ScriptUtil::registerConstantBool(const std::string& name, bool value, const std::vector<std::string>& scopePath);
@@ -993,13 +1403,37 @@ private:
     friend ScriptUtil::LuaArray<double> ScriptUtil::getDoublePointer(int index);
     template<typename T> friend ScriptUtil::LuaArray<T> ScriptUtil::getObjectPointer(int index, const char* type, bool nonNull, bool* success);
     friend const char* ScriptUtil::getString(int index, bool isStdString);
+    friend void ScriptUtil::pushMetatable(lua_State* state, const char* type, int* ref, unsigned int* generation);
+    friend bool ScriptUtil::isObjectOfType(int index, const char* type);
 
     lua_State* _lua;
     unsigned int _returnCount;
     std::map<std::string, std::vector<std::string> > _hierarchy;
-    std::vector<std::string> _callbacks[CALLBACK_COUNT];
+    std::map<std::string, unsigned int> _typeIds;       // The number of each registered class.
+    std::map<const char*, unsigned int> _typeIdCache;   // The numbers of the type names checked, by address.
+    std::vector<unsigned int> _typeAncestors;           // A bit set of the ancestors of each class, including itself; empty when stale.
+    unsigned int _typeWords;                            // The size of the bit set of a class, in words.
+    std::vector<Callback> _callbacks[CALLBACK_COUNT];
     std::set<std::string> _loadedScripts;
+    std::map<std::string, Chunk> _chunks;
     std::vector<luaStringEnumConversionFunction> _stringFromEnum;
+    std::map<std::pair<const char*, unsigned int>, std::string> _enumStrings;
+    unsigned int _generation;           // Incremented whenever scripts may have redefined functions.
+    unsigned int _stateGeneration;      // The generation the current Lua state was created in.
+    unsigned int _gcStepSize;
+    float _gcBudget;
+    int _gcBaseline;                    // Memory in kilobytes after the last complete collection cycle.
+    TimerWheel* _coroutineTimers;       // The coroutines waiting for game time, by their registry reference.
+    CoroutineTimer _coroutineTimer;
+    std::vector<std::pair<unsigned int, int> > _frameWaits;         // The coroutines waiting for an update count.
+    std::vector<std::pair<AnimationClip*, int> > _clipWaits;        // The coroutines waiting for a clip to stop.
+    std::vector<int> _resumeQueue;      // The coroutines to resume in the next update.
+    std::vector<int> _resuming;         // The coroutines being resumed.
+    unsigned int _updateCount;
+#ifdef GP_LUAJIT
+    std::map<std::string, int> _ffiTypes;   // The registry references of the ctypes of the math classes.
+    int _ffiIsType;                         // The registry reference of ffi.istype.
+#endif
 };
 
 /** Template specialization. */
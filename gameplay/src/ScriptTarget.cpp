@@ -13,36 +13,58 @@ ScriptTarget::ScriptTarget()
 
 ScriptTarget::~ScriptTarget()
 {
+    // Only targets with callbacks ask for the script controller, so that destroying the
+    // others does not create it when the game config defers it to its first use.
+    Game* game = Game::getInstance();
+    ScriptController* sc = NULL;
     std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.begin();
     for (; iter != _callbacks.end(); iter++)
     {
+        if (iter->second && !iter->second->empty() && !sc && game)
+            sc = game->getScriptController();
+        if (iter->second && sc)
+        {
+            for (unsigned int i = 0; i < iter->second->size(); i++)
+                sc->releaseFunction(&(*iter->second)[i].ref, (*iter->second)[i].generation);
+        }
         SAFE_DELETE(iter->second);
     }
 }
 
+bool ScriptTarget::hasScriptCallbacks(const char* eventName) const
+{
+    std::map<std::string, std::vector<Callback>* >::const_iterator iter = _callbacks.find(eventName);
+    return iter != _callbacks.end() && iter->second != NULL && iter->second->size() > 0;
+}
+
 template<> void ScriptTarget::fireScriptEvent<void>(const char* eventName, ...)
 {
     va_list list;
     va_start(list, eventName);
 
     std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end() && iter->second != NULL)
+    if (iter != _callbacks.end() && iter->second != NULL && iter->second->size() > 0)
     {
         ScriptController* sc = Game::getInstance()->getScriptController();
-
-        if (_events[eventName].size() > 0)
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                sc->executeFunction<void>((*iter->second)[i].function.c_str(), _events[eventName].c_str(), &list);
-            }
-        }
-        else
+        lua_State* lua = sc->_lua;
+        if (lua)
         {
+            // Push the arguments once and pass a copy of them to every callback.
+            int top = lua_gettop(lua);
+            int argumentCount = sc->pushArguments(_events[eventName].c_str(), &list);
+
             for (unsigned int i = 0; i < iter->second->size(); i++)
             {
-                sc->executeFunction<void>((*iter->second)[i].function.c_str(), _events[eventName].c_str());
+                Callback& callback = (*iter->second)[i];
+                if (sc->pushFunction(callback.function, &callback.ref, &callback.generation))
+                {
+                    for (int j = 1; j <= argumentCount; j++)
+                        lua_pushvalue(lua, top + j);
+                    sc->callFunction(callback.function.c_str(), argumentCount, 0);
+                    lua_settop(lua, top + argumentCount);
+                }
             }
+            lua_settop(lua, top);
         }
     }
 
@@ -54,37 +76,36 @@ template<> bool ScriptTarget::fireScriptEvent<bool>(const char* eventName, ...)
     va_list list;
     va_start(list, eventName);
 
+    bool consumed = false;
     std::map<std::string, std::vector<Callback>* >::iterator iter = _callbacks.find(eventName);
-    if (iter != _callbacks.end() && iter->second)
+    if (iter != _callbacks.end() && iter->second && iter->second->size() > 0)
     {
         ScriptController* sc = Game::getInstance()->getScriptController();
-
-        if (_events[eventName].size() > 0)
-        {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
-            {
-                if (sc->executeFunction<bool>((*iter->second)[i].function.c_str(), _events[eventName].c_str(), &list))
-                {
-                    va_end(list);
-                    return true;
-                }
-            }
-        }
-        else
+        lua_State* lua = sc->_lua;
+        if (lua)
         {
-            for (unsigned int i = 0; i < iter->second->size(); i++)
+            // Push the arguments once and pass a copy of them to every callback.
+            int top = lua_gettop(lua);
+            int argumentCount = sc->pushArguments(_events[eventName].c_str(), &list);
+
+            for (unsigned int i = 0; !consumed && i < iter->second->size(); i++)
             {
-                if (sc->executeFunction<bool>((*iter->second)[i].function.c_str(), _events[eventName].c_str()))
+                Callback& callback = (*iter->second)[i];
+                if (sc->pushFunction(callback.function, &callback.ref, &callback.generation))
                 {
-                    va_end(list);
-                    return true;
+                    for (int j = 1; j <= argumentCount; j++)
+                        lua_pushvalue(lua, top + j);
+                    if (sc->callFunction(callback.function.c_str(), argumentCount, 1))
+                        consumed = ScriptUtil::luaCheckBool(lua, -1);
+                    lua_settop(lua, top + argumentCount);
                 }
             }
+            lua_settop(lua, top);
         }
     }
 
     va_end(list);
-    return false;
+    return consumed;
 }
 
 void ScriptTarget::addScriptCallback(const std::string& eventName, const std::string& function)
@@ -126,6 +147,7 @@ void ScriptTarget::removeScriptCallback(const std::string& eventName, const std:
         {
             if ((*iter->second)[i].function == id)
             {
+                Game::getInstance()->getScriptController()->releaseFunction(&(*iter->second)[i].ref, (*iter->second)[i].generation);
                 iter->second->erase(iter->second->begin() + i);
                 return;
             }
@@ -143,7 +165,7 @@ void ScriptTarget::addScriptEvent(const std::string& eventName, const char* args
     _callbacks[eventName] = NULL;
 }
 
-ScriptTarget::Callback::Callback(const std::string& function) : function(function)
+ScriptTarget::Callback::Callback(const std::string& function) : function(function), ref(LUA_NOREF), generation(0)
 {
 }
 
@@ -59,6 +59,14 @@ protected:
      */
     template<typename T> T fireScriptEvent(const char* eventName, ...);
 
+    /**
+     * Determines whether any script callbacks are registered for the given event.
+     *
+     * @param eventName The name of the event.
+     * @return true if the event has script callbacks, false otherwise.
+     */
+    bool hasScriptCallbacks(const char* eventName) const;
+
     /** Used to store a script callbacks for given event. */
     struct Callback
     {
@@ -67,6 +75,10 @@ protected:
 
         /** Holds the Lua script callback function. */
         std::string function;
+        /** Holds the cached Lua registry reference of the function (see ScriptController::pushFunction). */
+        int ref;
+        /** Holds the script generation the reference was resolved in. */
+        unsigned int generation;
     };
 
     /** Holds the supported events for this script target. */
@@ -0,0 +1,631 @@
+#include "Base.h"
+#include "ShadowMaps.h"
+#include "StateCache.h"
+#include "Game.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Light.h"
+#include "Model.h"
+#include "MeshSkin.h"
+#include "Material.h"
+#include "FrameBuffer.h"
+
+#define SHADOWMAPS_STATIC_ID "org.gameplay3d.shadowmaps.static"
+#define SHADOWMAPS_DYNAMIC_ID "org.gameplay3d.shadowmaps.dynamic"
+#define SHADOWMAPS_DEPTH_VSH "res/shaders/shadow-depth.vert"
+#define SHADOWMAPS_DEPTH_FSH "res/shaders/shadow-depth.frag"
+
+// Tiles taken by a point light, one per cube face ordered +X, -X, +Y, -Y, +Z, -Z.
+#define SHADOWMAPS_CUBE_FACES 6
+
+// Near plane of spot and point light projections, as a fraction of the light range.
+#define SHADOWMAPS_NEAR_RATIO 0.01f
+
+namespace gameplay
+{
+
+static const Vector3 __cubeFaceDirections[SHADOWMAPS_CUBE_FACES] =
+{
+    Vector3(1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+    Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f),
+    Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 0.0f, -1.0f)
+};
+
+ShadowMaps::ShadowMaps() :
+    _atlasSize(0), _tileSize(0), _cascadeCount(0), _staticFrameBuffer(NULL), _dynamicFrameBuffer(NULL),
+    _staticSampler(NULL), _dynamicSampler(NULL), _depthMaterial(NULL), _shadowDistance(100.0f), _cascadeSplitLambda(0.75f),
+    _cascadeUpdateInterval(1), _directionalCasterDistance(50.0f), _depthBias(0.002f), _frame(0), _staticUpdateCount(0), _dynamicUpdateCount(0)
+{
+}
+
+ShadowMaps::~ShadowMaps()
+{
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_lights[i]->node);
+        SAFE_DELETE(_lights[i]);
+    }
+    for (std::set<Node*>::iterator itr = _staticCasters.begin(); itr != _staticCasters.end(); ++itr)
+    {
+        Node* node = *itr;
+        node->removeListener(this);
+        SAFE_RELEASE(node);
+    }
+    for (std::map<unsigned int, Material*>::iterator itr = _skinnedDepthMaterials.begin(); itr != _skinnedDepthMaterials.end(); ++itr)
+    {
+        SAFE_RELEASE(itr->second);
+    }
+    SAFE_RELEASE(_depthMaterial);
+    SAFE_RELEASE(_staticSampler);
+    SAFE_RELEASE(_dynamicSampler);
+    SAFE_RELEASE(_staticFrameBuffer);
+    SAFE_RELEASE(_dynamicFrameBuffer);
+}
+
+static FrameBuffer* createAtlas(const char* id, unsigned int atlasSize, DepthStencilTarget* depthTarget, Texture::Sampler** sampler)
+{
+    FrameBuffer* frameBuffer = FrameBuffer::create(id, atlasSize, atlasSize);
+    if (frameBuffer == NULL)
+        return NULL;
+    frameBuffer->setDepthStencilTarget(depthTarget);
+
+    // Packed depth cannot be filtered.
+    *sampler = Texture::Sampler::create(frameBuffer->getRenderTarget(0)->getTexture());
+    (*sampler)->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    (*sampler)->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    return frameBuffer;
+}
+
+static Material* createDepthMaterial(const char* defines)
+{
+    Material* material = Material::create(SHADOWMAPS_DEPTH_VSH, SHADOWMAPS_DEPTH_FSH, defines);
+    if (material == NULL)
+        return NULL;
+
+    RenderState::StateBlock* state = material->getStateBlock();
+    state->setDepthTest(true);
+    state->setDepthWrite(true);
+    state->setCullFace(true);
+    material->setParameterAutoBinding("u_worldMatrix", RenderState::WORLD_MATRIX);
+    if (defines)
+    {
+        material->setParameterAutoBinding("u_matrixPalette", RenderState::MATRIX_PALETTE);
+    }
+    return material;
+}
+
+ShadowMaps* ShadowMaps::create(unsigned int atlasSize, unsigned int tileSize, unsigned int cascadeCount)
+{
+    GP_ASSERT(tileSize > 0);
+
+    if (tileSize > atlasSize)
+    {
+        GP_ERROR("Shadow map tiles (%u) are larger than the shadow atlas (%u).", tileSize, atlasSize);
+        return NULL;
+    }
+    if (cascadeCount == 0 || cascadeCount > 4)
+    {
+        GP_ERROR("Invalid cascade count (%u) for shadow maps; it must be between 1 and 4.", cascadeCount);
+        return NULL;
+    }
+
+    ShadowMaps* shadowMaps = new ShadowMaps();
+    shadowMaps->_atlasSize = atlasSize;
+    shadowMaps->_tileSize = tileSize;
+    shadowMaps->_cascadeCount = cascadeCount;
+
+    // Both atlases are cleared before each tile is drawn, so they share a depth buffer.
+    DepthStencilTarget* depthTarget = DepthStencilTarget::create(SHADOWMAPS_STATIC_ID, DepthStencilTarget::DEPTH, atlasSize, atlasSize);
+    shadowMaps->_staticFrameBuffer = createAtlas(SHADOWMAPS_STATIC_ID, atlasSize, depthTarget, &shadowMaps->_staticSampler);
+    shadowMaps->_dynamicFrameBuffer = createAtlas(SHADOWMAPS_DYNAMIC_ID, atlasSize, depthTarget, &shadowMaps->_dynamicSampler);
+    SAFE_RELEASE(depthTarget);
+    shadowMaps->_depthMaterial = createDepthMaterial(NULL);
+    if (!shadowMaps->_staticFrameBuffer || !shadowMaps->_dynamicFrameBuffer || !shadowMaps->_depthMaterial)
+    {
+        GP_ERROR("Failed to create the shadow atlases.");
+        SAFE_RELEASE(shadowMaps);
+        return NULL;
+    }
+    shadowMaps->_depthMaterial->getParameter("u_lightViewProjectionMatrix")->bindValue(shadowMaps, &ShadowMaps::getRenderMatrix);
+
+    unsigned int tilesPerRow = atlasSize / tileSize;
+    unsigned int tileCount = tilesPerRow * tilesPerRow;
+    shadowMaps->_tiles.resize(tileCount);
+    for (unsigned int i = 0; i < tileCount; ++i)
+    {
+        Tile& tile = shadowMaps->_tiles[i];
+        tile.x = (i % tilesPerRow) * tileSize;
+        tile.y = (i / tilesPerRow) * tileSize;
+        tile.staticDirty = true;
+
+        // Tiles are taken from the back.
+        shadowMaps->_freeTiles.push_back(tileCount - 1 - i);
+    }
+
+    // Clear the atlases, so that tiles of lights that were never in view cast no shadow.
+    Game* game = Game::getInstance();
+    Rectangle viewport = game->getViewport();
+    FrameBuffer* previousFrameBuffer = shadowMaps->_staticFrameBuffer->bind();
+    game->setViewport(Rectangle(0, 0, atlasSize, atlasSize));
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::one(), 1.0f, 0);
+    shadowMaps->_dynamicFrameBuffer->bind();
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::one(), 1.0f, 0);
+    previousFrameBuffer->bind();
+    game->setViewport(viewport);
+
+    return shadowMaps;
+}
+
+ShadowMaps::ShadowLight* ShadowMaps::findLight(Node* node) const
+{
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        if (_lights[i]->node == node)
+            return _lights[i];
+    }
+    return NULL;
+}
+
+bool ShadowMaps::addLight(Node* node)
+{
+    GP_ASSERT(node);
+
+    Light* light = node->getLight();
+    if (light == NULL)
+    {
+        GP_ERROR("Node '%s' has no light to cast shadows.", node->getId());
+        return false;
+    }
+    if (findLight(node))
+        return true;
+
+    unsigned int tileCount;
+    switch (light->getLightType())
+    {
+    case Light::DIRECTIONAL:
+        tileCount = _cascadeCount;
+        break;
+    case Light::POINT:
+        tileCount = SHADOWMAPS_CUBE_FACES;
+        break;
+    default:
+        tileCount = 1;
+        break;
+    }
+    if (_freeTiles.size() < tileCount)
+    {
+        GP_WARN("Shadow atlas has no room for the shadow maps of light '%s'.", node->getId());
+        return false;
+    }
+
+    ShadowLight* shadowLight = new ShadowLight();
+    shadowLight->node = node;
+    node->addRef();
+    for (unsigned int i = 0; i < tileCount; ++i)
+    {
+        unsigned int index = _freeTiles.back();
+        _freeTiles.pop_back();
+        _tiles[index].staticDirty = true;
+        _tiles[index].staticCasters.clear();
+        shadowLight->tiles.push_back(index);
+    }
+    shadowLight->matrices.resize(tileCount, Matrix::identity());
+    _lights.push_back(shadowLight);
+    return true;
+}
+
+void ShadowMaps::removeLight(Node* node)
+{
+    for (std::vector<ShadowLight*>::iterator itr = _lights.begin(); itr != _lights.end(); ++itr)
+    {
+        ShadowLight* light = *itr;
+        if (light->node == node)
+        {
+            _freeTiles.insert(_freeTiles.end(), light->tiles.begin(), light->tiles.end());
+            SAFE_RELEASE(light->node);
+            SAFE_DELETE(light);
+            _lights.erase(itr);
+            return;
+        }
+    }
+}
+
+void ShadowMaps::addStaticCaster(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (_staticCasters.insert(node).second)
+    {
+        node->addRef();
+        node->addListener(this);
+
+        // The caster was drawn with the dynamic casters until now.
+        transformChanged(node, 0);
+    }
+}
+
+void ShadowMaps::removeStaticCaster(Node* node)
+{
+    std::set<Node*>::iterator itr = _staticCasters.find(node);
+    if (itr != _staticCasters.end())
+    {
+        transformChanged(node, 0);
+        _staticCasters.erase(itr);
+        node->removeListener(this);
+        SAFE_RELEASE(node);
+    }
+}
+
+void ShadowMaps::setShadowDistance(float distance)
+{
+    _shadowDistance = distance;
+}
+
+float ShadowMaps::getShadowDistance() const
+{
+    return _shadowDistance;
+}
+
+void ShadowMaps::setCascadeSplitLambda(float lambda)
+{
+    _cascadeSplitLambda = lambda;
+}
+
+void ShadowMaps::setCascadeUpdateInterval(unsigned int interval)
+{
+    _cascadeUpdateInterval = std::max(interval, 1u);
+}
+
+void ShadowMaps::setDirectionalCasterDistance(float distance)
+{
+    _directionalCasterDistance = distance;
+}
+
+void ShadowMaps::setDepthBias(float bias)
+{
+    _depthBias = bias;
+}
+
+void ShadowMaps::invalidate()
+{
+    for (size_t i = 0, count = _tiles.size(); i < count; ++i)
+    {
+        _tiles[i].staticDirty = true;
+    }
+}
+
+void ShadowMaps::transformChanged(Transform* transform, long cookie)
+{
+    // A static caster moved: redraw the cached tiles it was drawn in or moved into.
+    Node* node = static_cast<Node*>(transform);
+    const BoundingSphere& sphere = node->getBoundingSphere();
+    for (size_t i = 0, count = _tiles.size(); i < count; ++i)
+    {
+        Tile& tile = _tiles[i];
+        if (tile.staticDirty)
+            continue;
+        if (std::find(tile.staticCasters.begin(), tile.staticCasters.end(), node) != tile.staticCasters.end() || tile.frustum.intersects(sphere))
+        {
+            tile.staticDirty = true;
+        }
+    }
+}
+
+void ShadowMaps::computeCascades(ShadowLight* light, Camera* camera, Matrix* viewProjections)
+{
+    Vector3 nearCorners[4];
+    Vector3 farCorners[4];
+    camera->getFrustum().getNearCorners(nearCorners);
+    camera->getFrustum().getFarCorners(farCorners);
+    const float nearPlane = camera->getNearPlane();
+    const float farPlane = camera->getFarPlane();
+    const float distance = std::min(_shadowDistance, farPlane);
+
+    Vector3 direction = light->node->getForwardVectorWorld();
+    direction.normalize();
+    const Vector3& up = fabs(direction.y) > 0.99f ? Vector3::unitZ() : Vector3::unitY();
+    Matrix rotation;
+    Matrix::createLookAt(Vector3::zero(), direction, up, &rotation);
+    Matrix inverseRotation;
+    rotation.invert(&inverseRotation);
+
+    light->cascadeSplits.set(0.0f, 0.0f, 0.0f, 0.0f);
+    float* splits = &light->cascadeSplits.x;
+    float start = nearPlane;
+    for (unsigned int i = 0; i < _cascadeCount; ++i)
+    {
+        // Blend logarithmic and uniform splits of the shadow distance.
+        float t = (float)(i + 1) / _cascadeCount;
+        float end = _cascadeSplitLambda * nearPlane * powf(distance / nearPlane, t) + (1.0f - _cascadeSplitLambda) * (nearPlane + (distance - nearPlane) * t);
+        splits[i] = end;
+
+        // The corners of the slice lie on the edges from the near to the far corners
+        // (which are stored in reverse order).
+        Vector3 corners[8];
+        Vector3 center;
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            const Vector3& a = nearCorners[j];
+            const Vector3& b = farCorners[3 - j];
+            corners[j] = a + (b - a) * ((start - nearPlane) / (farPlane - nearPlane));
+            corners[j + 4] = a + (b - a) * ((end - nearPlane) / (farPlane - nearPlane));
+            center += corners[j] + corners[j + 4];
+        }
+        center *= 0.125f;
+        float radius = 0.0f;
+        for (unsigned int j = 0; j < 8; ++j)
+        {
+            radius = std::max(radius, center.distanceSquared(corners[j]));
+        }
+        radius = ceilf(sqrtf(radius) * 16.0f) / 16.0f;
+
+        // Bound the slice with a sphere, whose size does not change as the camera turns,
+        // and snap its center to texels, so that cached cascades stay valid and shadow
+        // edges do not shimmer as the camera moves.
+        float texel = 2.0f * radius / _tileSize;
+        rotation.transformPoint(&center);
+        center.x = floorf(center.x / texel) * texel;
+        center.y = floorf(center.y / texel) * texel;
+        center.z = floorf(center.z / texel) * texel;
+        inverseRotation.transformPoint(&center);
+
+        Matrix view;
+        Matrix::createLookAt(center - direction * (radius + _directionalCasterDistance), center, up, &view);
+        Matrix projection;
+        Matrix::createOrthographicOffCenter(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + _directionalCasterDistance, &projection);
+        Matrix::multiply(projection, view, &viewProjections[i]);
+
+        start = end;
+    }
+}
+
+void ShadowMaps::setTileMatrix(ShadowLight* light, unsigned int index, const Matrix& viewProjection)
+{
+    Tile& tile = _tiles[light->tiles[index]];
+    tile.viewProjection = viewProjection;
+    tile.frustum.set(viewProjection);
+
+    // Map clip space to the texture coordinates and depth range of the tile.
+    const float scale = 0.5f * _tileSize / _atlasSize;
+    Matrix atlas(scale, 0.0f, 0.0f, scale + (float)tile.x / _atlasSize,
+                 0.0f, scale, 0.0f, scale + (float)tile.y / _atlasSize,
+                 0.0f, 0.0f, 0.5f, 0.5f,
+                 0.0f, 0.0f, 0.0f, 1.0f);
+    Matrix::multiply(atlas, viewProjection, &light->matrices[index]);
+}
+
+Material* ShadowMaps::getDepthMaterial(Node* node)
+{
+    MeshSkin* skin = node->getModel()->getSkin();
+    if (skin == NULL)
+        return _depthMaterial;
+
+    unsigned int jointCount = skin->getJointCount();
+    std::map<unsigned int, Material*>::const_iterator itr = _skinnedDepthMaterials.find(jointCount);
+    if (itr != _skinnedDepthMaterials.end())
+        return itr->second;
+
+    std::ostringstream defines;
+    defines << "SKINNING;SKINNING_JOINT_COUNT " << jointCount;
+    Material* material = createDepthMaterial(defines.str().c_str());
+    if (material)
+    {
+        material->getParameter("u_lightViewProjectionMatrix")->bindValue(this, &ShadowMaps::getRenderMatrix);
+    }
+    _skinnedDepthMaterials[jointCount] = material;
+    return material;
+}
+
+void ShadowMaps::drawTile(Tile& tile, Scene* scene, bool staticCasters)
+{
+    Game* game = Game::getInstance();
+    game->setViewport(Rectangle(tile.x, tile.y, _tileSize, _tileSize));
+    StateCache::setScissor(tile.x, tile.y, _tileSize, _tileSize);
+    game->clear(Game::CLEAR_COLOR_DEPTH, Vector4::one(), 1.0f, 0);
+    _renderMatrix = tile.viewProjection;
+
+    if (staticCasters)
+    {
+        tile.staticCasters.clear();
+        for (std::set<Node*>::const_iterator itr = _staticCasters.begin(); itr != _staticCasters.end(); ++itr)
+        {
+            Node* node = *itr;
+            if (node->getModel() && tile.frustum.intersects(node->getBoundingSphere()))
+            {
+                tile.staticCasters.push_back(node);
+                Material* material = getDepthMaterial(node);
+                if (material)
+                    node->getModel()->draw(material);
+            }
+        }
+    }
+    else
+    {
+        static const unsigned int noShadowTag = Node::getTagId("noShadow");
+        _casters.clear();
+        scene->findVisibleNodes(tile.frustum, _casters);
+        for (size_t i = 0, count = _casters.size(); i < count; ++i)
+        {
+            Node* node = _casters[i];
+            if (!node->getModel() || node->hasTag(noShadowTag) || _staticCasters.find(node) != _staticCasters.end())
+                continue;
+            Material* material = getDepthMaterial(node);
+            if (material)
+                node->getModel()->draw(material);
+        }
+    }
+}
+
+void ShadowMaps::update(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    _staticUpdateCount = 0;
+    _dynamicUpdateCount = 0;
+    Camera* camera = scene->getActiveCamera();
+    if (camera == NULL || _lights.empty())
+        return;
+    ++_frame;
+
+    // Place the tiles of the lights that need shadows this frame.
+    const Frustum& viewFrustum = camera->getFrustum();
+    std::vector<unsigned int> updates;
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        ShadowLight* shadowLight = _lights[i];
+        Node* node = shadowLight->node;
+        Light* light = node->getLight();
+        if (light == NULL)
+            continue;
+
+        if (light->getLightType() == Light::DIRECTIONAL)
+        {
+            Matrix viewProjections[4];
+            computeCascades(shadowLight, camera, viewProjections);
+            for (unsigned int j = 0; j < _cascadeCount; ++j)
+            {
+                if (j > 0 && (_frame + j) % _cascadeUpdateInterval != 0)
+                    continue;
+                setTileMatrix(shadowLight, j, viewProjections[j]);
+                updates.push_back(shadowLight->tiles[j]);
+            }
+            continue;
+        }
+
+        // Lights out of view keep their shadow maps until they come back.
+        const Vector3 position = node->getTranslationWorld();
+        const float range = light->getRange();
+        if (!viewFrustum.intersects(BoundingSphere(position, range)))
+            continue;
+        shadowLight->position = position;
+
+        Matrix projection;
+        Matrix view;
+        Matrix viewProjection;
+        if (light->getLightType() == Light::SPOT)
+        {
+            Vector3 direction = node->getForwardVectorWorld();
+            direction.normalize();
+            const Vector3& up = fabs(direction.y) > 0.99f ? Vector3::unitZ() : Vector3::unitY();
+            float fieldOfView = std::min(MATH_RAD_TO_DEG(2.0f * acosf(light->getOuterAngleCos())), 179.0f);
+            Matrix::createPerspective(fieldOfView, 1.0f, range * SHADOWMAPS_NEAR_RATIO, range, &projection);
+            Matrix::createLookAt(position, position + direction, up, &view);
+            Matrix::multiply(projection, view, &viewProjection);
+            setTileMatrix(shadowLight, 0, viewProjection);
+            updates.push_back(shadowLight->tiles[0]);
+        }
+        else
+        {
+            Matrix::createPerspective(90.0f, 1.0f, range * SHADOWMAPS_NEAR_RATIO, range, &projection);
+            for (unsigned int j = 0; j < SHADOWMAPS_CUBE_FACES; ++j)
+            {
+                const Vector3& direction = __cubeFaceDirections[j];
+                const Vector3& up = direction.y != 0.0f ? Vector3::unitZ() : Vector3::unitY();
+                Matrix::createLookAt(position, position + direction, up, &view);
+                Matrix::multiply(projection, view, &viewProjection);
+                setTileMatrix(shadowLight, j, viewProjection);
+                updates.push_back(shadowLight->tiles[j]);
+            }
+        }
+    }
+    if (updates.empty())
+        return;
+
+    Game* game = Game::getInstance();
+    Rectangle viewport = game->getViewport();
+    StateCache::setEnabled(GL_SCISSOR_TEST, true);
+
+    // Redraw the cached static tiles whose light or casters moved.
+    FrameBuffer* previousFrameBuffer = _staticFrameBuffer->bind();
+    for (size_t i = 0, count = updates.size(); i < count; ++i)
+    {
+        Tile& tile = _tiles[updates[i]];
+        if (tile.staticDirty || memcmp(tile.viewProjection.m, tile.staticViewProjection.m, sizeof(tile.viewProjection.m)) != 0)
+        {
+            drawTile(tile, scene, true);
+            tile.staticViewProjection = tile.viewProjection;
+            tile.staticDirty = false;
+            ++_staticUpdateCount;
+        }
+    }
+
+    _dynamicFrameBuffer->bind();
+    for (size_t i = 0, count = updates.size(); i < count; ++i)
+    {
+        drawTile(_tiles[updates[i]], scene, false);
+        ++_dynamicUpdateCount;
+    }
+
+    StateCache::setEnabled(GL_SCISSOR_TEST, false);
+    previousFrameBuffer->bind();
+    game->setViewport(viewport);
+}
+
+unsigned int ShadowMaps::getStaticUpdateCount() const
+{
+    return _staticUpdateCount;
+}
+
+unsigned int ShadowMaps::getDynamicUpdateCount() const
+{
+    return _dynamicUpdateCount;
+}
+
+void ShadowMaps::setMaterialParameters(RenderState* renderState, Node* node)
+{
+    GP_ASSERT(renderState);
+    GP_ASSERT(node);
+
+    ShadowLight* light = findLight(node);
+    if (light == NULL)
+    {
+        GP_ERROR("Node '%s' is not a shadow casting light.", node->getId());
+        return;
+    }
+
+    renderState->getParameter("u_shadowStaticMap")->setValue(_staticSampler);
+    renderState->getParameter("u_shadowDynamicMap")->setValue(_dynamicSampler);
+    renderState->getParameter("u_shadowBias")->bindValue(this, &ShadowMaps::getDepthBias);
+    renderState->getParameter("u_shadowMatrices")->bindValue(light, &ShadowLight::getMatrices, &ShadowLight::getMatrixCount);
+    if (node->getLight()->getLightType() == Light::DIRECTIONAL)
+    {
+        renderState->getParameter("u_shadowCascadeSplits")->bindValue(light, &ShadowLight::getCascadeSplits);
+    }
+    else if (node->getLight()->getLightType() == Light::POINT)
+    {
+        renderState->getParameter("u_shadowLightPosition")->bindValue(light, &ShadowLight::getPosition);
+    }
+    renderState->setParameterAutoBinding("u_worldMatrix", RenderState::WORLD_MATRIX);
+}
+
+float ShadowMaps::getDepthBias() const
+{
+    return _depthBias;
+}
+
+const Matrix& ShadowMaps::getRenderMatrix() const
+{
+    return _renderMatrix;
+}
+
+const Matrix* ShadowMaps::ShadowLight::getMatrices() const
+{
+    return &matrices[0];
+}
+
+unsigned int ShadowMaps::ShadowLight::getMatrixCount() const
+{
+    return (unsigned int)matrices.size();
+}
+
+const Vector4& ShadowMaps::ShadowLight::getCascadeSplits() const
+{
+    return cascadeSplits;
+}
+
+const Vector3& ShadowMaps::ShadowLight::getPosition() const
+{
+    return position;
+}
+
+}
@@ -0,0 +1,279 @@
+#ifndef SHADOWMAPS_H_
+#define SHADOWMAPS_H_
+
+#include "Ref.h"
+#include "Transform.h"
+#include "Texture.h"
+#include "Frustum.h"
+#include "Matrix.h"
+#include "Vector4.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Camera;
+class Node;
+class Material;
+class RenderState;
+class FrameBuffer;
+
+/**
+ * Defines the shadow maps of a set of lights, packed into a shadow atlas.
+ *
+ * The atlas is a grid of square tiles. A directional light takes one tile per cascade,
+ * each cascade covering a range of view depths of the active camera, a spot light takes
+ * one tile and a point light takes six, one per cube face. Casters are culled against
+ * the frustum of each tile (through the scene's spatial index when it is enabled), and
+ * any node with a model casts a shadow unless it has the "noShadow" tag.
+ *
+ * There are two atlases with the same layout. The static atlas caches the depth of the
+ * casters added with addStaticCaster(), and a tile of it is only redrawn when its light
+ * or cascade moves, or when a static caster in it moves. The dynamic atlas holds the
+ * depth of every other caster and is redrawn each update. Tiles of lights that are out
+ * of view are not redrawn, and the cascades after the first can be redrawn at a lower
+ * rate with setCascadeUpdateInterval(), which bounds the cost of shadows per frame.
+ *
+ * Depth is packed into RGBA textures, so shadows work on OpenGL ES 2.0 devices without
+ * depth textures. Materials built with the SHADOWS define read the shadow maps of one
+ * light through the parameters set by setMaterialParameters().
+ *
+ * @script{ignore}
+ */
+class ShadowMaps : public Ref, public Transform::Listener
+{
+public:
+
+    /**
+     * Creates the shadow maps.
+     *
+     * @param atlasSize The width and height of the shadow atlases, in pixels.
+     * @param tileSize The width and height of each shadow map in the atlases, in pixels.
+     * @param cascadeCount The number of cascades of directional lights, between 1 and 4.
+     *
+     * @return The new shadow maps, or NULL if the atlases could not be created.
+     */
+    static ShadowMaps* create(unsigned int atlasSize = 2048, unsigned int tileSize = 512, unsigned int cascadeCount = 4);
+
+    /**
+     * Adds a shadow casting light.
+     *
+     * @param node The node of the light.
+     *
+     * @return true if the light was added, false if the atlas has no room for its shadow maps.
+     */
+    bool addLight(Node* node);
+
+    /**
+     * Removes a shadow casting light, freeing its tiles in the atlas.
+     *
+     * @param node The node of the light.
+     */
+    void removeLight(Node* node);
+
+    /**
+     * Adds a static shadow caster, whose depth is cached in the static atlas.
+     *
+     * Static casters may still move; the tiles they are drawn in are redrawn when they do.
+     *
+     * @param node The node of the caster.
+     */
+    void addStaticCaster(Node* node);
+
+    /**
+     * Removes a static shadow caster. It is drawn as a dynamic caster from then on.
+     *
+     * @param node The node of the caster.
+     */
+    void removeStaticCaster(Node* node);
+
+    /**
+     * Sets the view distance up to which directional lights cast shadows.
+     *
+     * The cascades split this distance, or the distance to the camera's far plane if
+     * it is nearer. The default is 100.
+     *
+     * @param distance The shadow distance.
+     */
+    void setShadowDistance(float distance);
+
+    /**
+     * Gets the view distance up to which directional lights cast shadows.
+     *
+     * @return The shadow distance.
+     */
+    float getShadowDistance() const;
+
+    /**
+     * Sets how the cascades split the shadow distance, from 0 for equal lengths to 1 for
+     * lengths that grow logarithmically with the distance. The default is 0.75.
+     *
+     * @param lambda The blend between uniform and logarithmic splits.
+     */
+    void setCascadeSplitLambda(float lambda);
+
+    /**
+     * Sets the number of updates between redraws of the cascades after the first.
+     *
+     * The first cascade is redrawn every update. Cascade i is redrawn every interval
+     * updates, at an offset of i, so that the far cascades take turns. The default is 1.
+     *
+     * @param interval The update interval of the far cascades.
+     */
+    void setCascadeUpdateInterval(unsigned int interval);
+
+    /**
+     * Sets the distance casters are extruded towards a directional light, so that
+     * casters outside the view still cast shadows into it. The default is 50.
+     *
+     * @param distance The caster distance.
+     */
+    void setDirectionalCasterDistance(float distance);
+
+    /**
+     * Sets the bias subtracted from the depth of a fragment before it is compared with
+     * the depth of the shadow maps. The default is 0.002.
+     *
+     * @param bias The depth bias.
+     */
+    void setDepthBias(float bias);
+
+    /**
+     * Marks every tile of the static atlas to be redrawn by the next update.
+     */
+    void invalidate();
+
+    /**
+     * Redraws the shadow maps of the lights for the active camera of a scene.
+     *
+     * This should be called once per frame after the scene is updated and before it is drawn.
+     *
+     * @param scene The scene to draw the shadow casters of.
+     */
+    void update(Scene* scene);
+
+    /**
+     * Gets the number of static atlas tiles redrawn by the last update.
+     *
+     * @return The number of static tiles redrawn.
+     */
+    unsigned int getStaticUpdateCount() const;
+
+    /**
+     * Gets the number of dynamic atlas tiles redrawn by the last update.
+     *
+     * @return The number of dynamic tiles redrawn.
+     */
+    unsigned int getDynamicUpdateCount() const;
+
+    /**
+     * Sets the shadow parameters of a material, technique or pass for one of the lights.
+     *
+     * The parameters refer to these shadow maps, which must outlive the render state.
+     *
+     * @param renderState The render state to set the parameters on.
+     * @param node The node of the light, which must have been added with addLight().
+     */
+    void setMaterialParameters(RenderState* renderState, Node* node);
+
+    /**
+     * @see Transform::Listener::transformChanged
+     *
+     * Internal use only.
+     */
+    void transformChanged(Transform* transform, long cookie);
+
+private:
+
+    struct Tile
+    {
+        unsigned int x;
+        unsigned int y;
+        Matrix viewProjection;
+        Matrix staticViewProjection;
+        Frustum frustum;
+        std::vector<Node*> staticCasters;
+        bool staticDirty;
+    };
+
+    class ShadowLight
+    {
+    public:
+
+        const Matrix* getMatrices() const;
+        unsigned int getMatrixCount() const;
+        const Vector4& getCascadeSplits() const;
+        const Vector3& getPosition() const;
+
+        Node* node;
+        std::vector<unsigned int> tiles;
+        std::vector<Matrix> matrices;
+        Vector4 cascadeSplits;
+        Vector3 position;
+    };
+
+    /**
+     * Constructor.
+     */
+    ShadowMaps();
+
+    /**
+     * Destructor.
+     */
+    ~ShadowMaps();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ShadowMaps& operator=(const ShadowMaps&);
+
+    ShadowLight* findLight(Node* node) const;
+
+    /**
+     * Computes the view projection of the cascades of a directional light.
+     */
+    void computeCascades(ShadowLight* light, Camera* camera, Matrix* viewProjections);
+
+    /**
+     * Sets the view projection of a tile and the matrix that maps world positions into it.
+     */
+    void setTileMatrix(ShadowLight* light, unsigned int index, const Matrix& viewProjection);
+
+    /**
+     * Draws the casters of a tile into the bound atlas.
+     */
+    void drawTile(Tile& tile, Scene* scene, bool staticCasters);
+
+    Material* getDepthMaterial(Node* node);
+
+    float getDepthBias() const;
+    const Matrix& getRenderMatrix() const;
+
+    unsigned int _atlasSize;
+    unsigned int _tileSize;
+    unsigned int _cascadeCount;
+    FrameBuffer* _staticFrameBuffer;
+    FrameBuffer* _dynamicFrameBuffer;
+    Texture::Sampler* _staticSampler;
+    Texture::Sampler* _dynamicSampler;
+    std::vector<Tile> _tiles;
+    std::vector<unsigned int> _freeTiles;
+    std::vector<ShadowLight*> _lights;
+    std::set<Node*> _staticCasters;
+    Material* _depthMaterial;
+    std::map<unsigned int, Material*> _skinnedDepthMaterials;
+    std::vector<Node*> _casters;
+    Matrix _renderMatrix;
+    float _shadowDistance;
+    float _cascadeSplitLambda;
+    unsigned int _cascadeUpdateInterval;
+    float _directionalCasterDistance;
+    float _depthBias;
+    unsigned int _frame;
+    unsigned int _staticUpdateCount;
+    unsigned int _dynamicUpdateCount;
+};
+
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "Slider.h"
+#include "StateCache.h"
 #include "Game.h"
 
 namespace gameplay
@@ -487,20 +488,21 @@ void Slider::draw(SpriteBatch* spriteBatch, const Rectangle& clip, bool needsCle
 {
     if (needsClear)
     {
-        GL_ASSERT( glEnable(GL_SCISSOR_TEST) );
-        GL_ASSERT( glScissor(_clearBounds.x, targetHeight - _clearBounds.y - _clearBounds.height, _clearBounds.width, _clearBounds.height) );
+        // Draw what is collected before clearing under it.
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->flushBatch();
+
+        StateCache::setEnabled(GL_SCISSOR_TEST, true);
+        StateCache::setScissor(_clearBounds.x, targetHeight - _clearBounds.y - _clearBounds.height, _clearBounds.width, _clearBounds.height);
         Game::getInstance()->clear(Game::CLEAR_COLOR, Vector4::zero(), 1.0f, 0);
-        GL_ASSERT( glDisable(GL_SCISSOR_TEST) );
+        StateCache::setEnabled(GL_SCISSOR_TEST, false);
     }
 
     if (!_visible)
         return;
 
-    spriteBatch->start();
-    drawBorder(spriteBatch, clip);
-    drawImages(spriteBatch, clip);
-    spriteBatch->finish();
-
+    drawGeometry(spriteBatch, clip);
     drawText(clip);
     if (_delta == 0.0f)
     {
@@ -567,9 +569,14 @@ void Slider::drawText(const Rectangle& clip)
 
     if (_valueTextVisible && _font)
     {
-        _font->start();
+        Theme* theme = getBatchTheme();
+        if (theme)
+            theme->prepareText(_font, _viewportClipBounds);
+        else
+            _font->start();
         _font->drawText(_valueText.c_str(), _textBounds, _textColor, getFontSize(_state), _valueTextAlignment, true, getTextRightToLeft(_state), &_viewportClipBounds);
-        _font->finish();
+        if (!theme)
+            _font->finish();
     }
 }
 
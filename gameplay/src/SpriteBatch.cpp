@@ -2,6 +2,9 @@
 #include "SpriteBatch.h"
 #include "Game.h"
 #include "Material.h"
+#include "Image.h"
+#include "DebugMarkers.h"
+#include "MathUtilSIMD.h"
 
 // Default size of a newly created sprite batch
 #define SPRITE_BATCH_DEFAULT_SIZE 128
@@ -19,20 +22,77 @@
 #define SPRITE_VSH "res/shaders/sprite.vert"
 #define SPRITE_FSH "res/shaders/sprite.frag"
 
+// The most sprites the bulk draw method clips at a time before adding them to the batch.
+#define SPRITE_CLIP_CHUNK 1024
+
 namespace gameplay
 {
 
+/**
+ * Computes the sines and cosines of four angles, in radians.
+ *
+ * The SIMD version reduces the angles to [-pi/2, pi/2] and evaluates Taylor
+ * polynomials, which are accurate to about 1e-7 over that range.
+ */
+static void sinCos4(const float* angles, float* sines, float* cosines)
+{
+#ifdef GP_SIMD
+    // Take out whole turns, in two steps so that the remainder keeps its precision.
+    float4 a = FLOAT4_LOAD(angles);
+    float4 turns = FLOAT4_ROUND(FLOAT4_MUL(a, FLOAT4_SET(0.15915494309189535f)));
+    a = FLOAT4_SUB(a, FLOAT4_MUL(turns, FLOAT4_SET(6.28125f)));
+    a = FLOAT4_SUB(a, FLOAT4_MUL(turns, FLOAT4_SET(0.0019353071795864769f)));
+
+    // Reflect angles beyond pi/2 around it: the sine stays the same and the cosine changes sign.
+    float4 halfTurn = FLOAT4_SELECT_GREATER(a, FLOAT4_SET(0.0f), FLOAT4_SET(MATH_PI), FLOAT4_SET(-MATH_PI));
+    float4 reflect = FLOAT4_ABS(a);
+    a = FLOAT4_SELECT_GREATER(reflect, FLOAT4_SET(MATH_PIOVER2), FLOAT4_SUB(halfTurn, a), a);
+    float4 cosineSign = FLOAT4_SELECT_GREATER(reflect, FLOAT4_SET(MATH_PIOVER2), FLOAT4_SET(-1.0f), FLOAT4_SET(1.0f));
+
+    float4 a2 = FLOAT4_MUL(a, a);
+    float4 s = FLOAT4_SET(1.0f / 6227020800.0f);
+    s = FLOAT4_MADD(FLOAT4_SET(-1.0f / 39916800.0f), s, a2);
+    s = FLOAT4_MADD(FLOAT4_SET(1.0f / 362880.0f), s, a2);
+    s = FLOAT4_MADD(FLOAT4_SET(-1.0f / 5040.0f), s, a2);
+    s = FLOAT4_MADD(FLOAT4_SET(1.0f / 120.0f), s, a2);
+    s = FLOAT4_MADD(FLOAT4_SET(-1.0f / 6.0f), s, a2);
+    s = FLOAT4_MADD(FLOAT4_SET(1.0f), s, a2);
+    FLOAT4_STORE(sines, FLOAT4_MUL(s, a));
+
+    float4 c = FLOAT4_SET(1.0f / 479001600.0f);
+    c = FLOAT4_MADD(FLOAT4_SET(-1.0f / 3628800.0f), c, a2);
+    c = FLOAT4_MADD(FLOAT4_SET(1.0f / 40320.0f), c, a2);
+    c = FLOAT4_MADD(FLOAT4_SET(-1.0f / 720.0f), c, a2);
+    c = FLOAT4_MADD(FLOAT4_SET(1.0f / 24.0f), c, a2);
+    c = FLOAT4_MADD(FLOAT4_SET(-0.5f), c, a2);
+    c = FLOAT4_MADD(FLOAT4_SET(1.0f), c, a2);
+    FLOAT4_STORE(cosines, FLOAT4_MUL(c, cosineSign));
+#else
+    for (int i = 0; i < 4; ++i)
+    {
+        sines[i] = sin(angles[i]);
+        cosines[i] = cos(angles[i]);
+    }
+#endif
+}
+
 static Effect* __spriteEffect = NULL;
 
 SpriteBatch::SpriteBatch()
-    : _batch(NULL), _sampler(NULL), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f)
+    : _batch(NULL), _sampler(NULL), _samplerIndex(0), _samplerParameter(NULL), _deferred(false), _started(false), _layer(0),
+      _arrayBatch(NULL), _arraySampler(NULL), _arraySamplerCount(0), _textureWidthRatio(0.0f), _textureHeightRatio(0.0f), _capture(NULL)
 {
 }
 
 SpriteBatch::~SpriteBatch()
 {
     SAFE_DELETE(_batch);
-    SAFE_RELEASE(_sampler);
+    SAFE_DELETE(_arrayBatch);
+    SAFE_RELEASE(_arraySampler);
+    for (size_t i = 0; i < _samplers.size(); ++i)
+    {
+        SAFE_RELEASE(_samplers[i]);
+    }
     if (!_customEffect)
     {
         if (__spriteEffect && __spriteEffect->getRefCount() == 1)
@@ -126,6 +186,8 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
     // Create the batch
     SpriteBatch* batch = new SpriteBatch();
     batch->_sampler = sampler;
+    batch->_samplers.push_back(sampler);
+    batch->_samplerParameter = material->getParameter(samplerUniform->getName());
     batch->_customEffect = customEffect;
     batch->_batch = meshBatch;
     batch->_textureWidthRatio = 1.0f / (float)texture->getWidth();
@@ -141,6 +203,9 @@ SpriteBatch* SpriteBatch::create(Texture* texture,  Effect* effect, unsigned int
 
 void SpriteBatch::start()
 {
+    _started = true;
+    _deferredSprites.clear();
+    _deferredVertices.clear();
     _batch->start();
 }
 
@@ -221,9 +286,7 @@ void SpriteBatch::draw(float x, float y, float z, float width, float height, flo
     SPRITE_ADD_VERTEX(v[2], downRight.x, downRight.y, z, u2, v1, color.x, color.y, color.z, color.w);
     SPRITE_ADD_VERTEX(v[3], upRight.x, upRight.y, z, u2, v2, color.x, color.y, color.z, color.w);
     
-    static unsigned short indices[4] = { 0, 1, 2, 3 };
-
-    _batch->add(v, 4, indices, 4);
+    addQuad(v);
 }
 
 void SpriteBatch::draw(const Vector3& position, const Vector3& right, const Vector3& forward, float width, float height,
@@ -287,8 +350,7 @@ void SpriteBatch::draw(const Vector3& position, const Vector3& right, const Vect
     SPRITE_ADD_VERTEX(v[2], p2.x, p2.y, p2.z, u1, v2, color.x, color.y, color.z, color.w);
     SPRITE_ADD_VERTEX(v[3], p3.x, p3.y, p3.z, u2, v2, color.x, color.y, color.z, color.w);
     
-    static const unsigned short indices[4] = { 0, 1, 2, 3 };
-    _batch->add(v, 4, const_cast<unsigned short*>(indices), 4);
+    addQuad(v);
 }
 
 void SpriteBatch::draw(float x, float y, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color)
@@ -336,9 +398,118 @@ void SpriteBatch::draw(SpriteBatch::SpriteVertex* vertices, unsigned int vertexC
     GP_ASSERT(vertices);
     GP_ASSERT(indices);
 
+    // Sprite geometry is made of quads, which are kept as separate sprites in deferred mode.
+    if (_deferred)
+    {
+        GP_ASSERT(vertexCount % 4 == 0);
+        if (vertexCount >= 4)
+            memcpy(deferSprites(vertexCount / 4), vertices, (vertexCount & ~3u) * sizeof(SpriteVertex));
+        return;
+    }
+
     _batch->add(vertices, vertexCount, indices, indexCount);
 }
 
+template <class T>
+static void writeSpriteIndices(T* indices, unsigned int count, unsigned int base)
+{
+    for (unsigned int i = 0; i < count; ++i, base += 4)
+    {
+        if (i > 0)
+        {
+            *indices++ = (T)(base - 1);
+            *indices++ = (T)base;
+        }
+        *indices++ = (T)base;
+        *indices++ = (T)(base + 1);
+        *indices++ = (T)(base + 2);
+        *indices++ = (T)(base + 3);
+    }
+}
+
+SpriteBatch::SpriteVertex* SpriteBatch::addSprites(unsigned int count)
+{
+    GP_ASSERT(count);
+
+    return _deferred ? deferSprites(count) : appendSprites(count);
+}
+
+SpriteBatch::SpriteVertex* SpriteBatch::deferSprites(unsigned int count)
+{
+    unsigned int first = (unsigned int)_deferredVertices.size();
+    _deferredVertices.resize(first + count * 4);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        DeferredSprite sprite;
+        sprite.layer = _layer;
+        sprite.sampler = _samplerIndex;
+        sprite.depth = 0.0f;
+        sprite.first = first + i * 4;
+        _deferredSprites.push_back(sprite);
+    }
+    return &_deferredVertices[first];
+}
+
+SpriteBatch::SpriteVertex* SpriteBatch::appendSprites(unsigned int count)
+{
+    GP_ASSERT(count);
+
+    // Every sprite is a triangle strip of four vertices, connected to the previous one by a degenerate triangle.
+    void* vertices;
+    void* indices;
+    unsigned int base;
+    if (!_batch->append(count * 4, count * 6 - 2, &vertices, &indices, &base))
+        return NULL;
+
+    GP_ASSERT(indices);
+    if (_batch->getIndexFormat() == Mesh::INDEX32)
+        writeSpriteIndices((unsigned int*)indices, count, base);
+    else
+        writeSpriteIndices((unsigned short*)indices, count, base);
+    return (SpriteVertex*)vertices;
+}
+
+void SpriteBatch::addSprites(const SpriteBatch::SpriteVertex* vertices, unsigned int count, const Vector2& offset)
+{
+    GP_ASSERT(vertices);
+
+    if (count == 0)
+        return;
+
+    SpriteVertex* v = addSprites(count);
+    if (v == NULL)
+        return;
+
+    for (unsigned int i = 0, vertexCount = count * 4; i < vertexCount; ++i)
+    {
+        v[i] = vertices[i];
+        v[i].x += offset.x;
+        v[i].y += offset.y;
+    }
+}
+
+void SpriteBatch::setCapture(std::vector<SpriteBatch::SpriteVertex>* vertices)
+{
+    _capture = vertices;
+}
+
+void SpriteBatch::addQuad(const SpriteBatch::SpriteVertex* vertices)
+{
+    if (_capture)
+    {
+        _capture->insert(_capture->end(), vertices, vertices + 4);
+        return;
+    }
+    if (_deferred)
+    {
+        memcpy(deferSprites(1), vertices, 4 * sizeof(SpriteVertex));
+        return;
+    }
+
+    static const unsigned short indices[4] = { 0, 1, 2, 3 };
+    _batch->add(vertices, 4, indices, 4);
+}
+
 void SpriteBatch::draw(float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color, bool positionIsCenter)
 {
     // Treat the given position as the center if the user specified it as such.
@@ -357,16 +528,431 @@ void SpriteBatch::draw(float x, float y, float z, float width, float height, flo
     SPRITE_ADD_VERTEX(v[2], x2, y, z, u2, v1, color.x, color.y, color.z, color.w);
     SPRITE_ADD_VERTEX(v[3], x2, y2, z, u2, v2, color.x, color.y, color.z, color.w);
 
-    static unsigned short indices[4] = { 0, 1, 2, 3 };
+    addQuad(v);
+}
 
-    _batch->add(v, 4, indices, 4);
+void SpriteBatch::draw(const SpriteBatch::Sprite* sprites, unsigned int count, const Rectangle* clip)
+{
+    GP_ASSERT(sprites || count == 0);
+
+    if (count == 0)
+        return;
+
+    // Unclipped sprites are all drawn, so they are written straight into the batch.
+    if (clip == NULL)
+    {
+        SpriteVertex* vertices = reserveSprites(count);
+        if (vertices)
+            expandSprites(sprites, count, NULL, vertices);
+        return;
+    }
+
+    // Clipped sprites are written to a scratch buffer first, since some of them may be left out.
+    for (unsigned int first = 0; first < count; first += SPRITE_CLIP_CHUNK)
+    {
+        unsigned int chunk = std::min(count - first, (unsigned int)SPRITE_CLIP_CHUNK);
+        _clippedVertices.resize(chunk * 4);
+        unsigned int visible = expandSprites(sprites + first, chunk, clip, &_clippedVertices[0]);
+        if (visible == 0)
+            continue;
+
+        SpriteVertex* vertices = reserveSprites(visible);
+        if (vertices == NULL)
+            return;
+        memcpy(vertices, &_clippedVertices[0], visible * 4 * sizeof(SpriteVertex));
+    }
+}
+
+SpriteBatch::SpriteVertex* SpriteBatch::reserveSprites(unsigned int count)
+{
+    if (_capture)
+    {
+        size_t first = _capture->size();
+        _capture->resize(first + count * 4);
+        return &(*_capture)[first];
+    }
+    return addSprites(count);
+}
+
+unsigned int SpriteBatch::expandSprites(const SpriteBatch::Sprite* sprites, unsigned int count, const Rectangle* clip, SpriteBatch::SpriteVertex* vertices)
+{
+    GP_ASSERT(sprites);
+    GP_ASSERT(vertices);
+
+    unsigned int written = 0;
+    float angles[4];
+    float sines[4];
+    float cosines[4];
+    float edges[4];
+    float uv[4];
+    float x[4];
+    float y[4];
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        // The rotations of four sprites are computed together.
+        unsigned int n = std::min(count - i, 4u);
+        bool rotated = false;
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            angles[j] = j < n ? sprites[i + j].rotation : 0.0f;
+            rotated |= (angles[j] != 0.0f);
+        }
+        if (rotated)
+            sinCos4(angles, sines, cosines);
+
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            const Sprite& sprite = sprites[i + j];
+            if (sprite.rotation == 0.0f)
+            {
+                // The edges are left, top, right and bottom, and the texture coordinates u1, v1, u2 and v2.
+#ifdef GP_SIMD
+                float4 corners = float4Set(sprite.x, sprite.y, sprite.x + sprite.width, sprite.y + sprite.height);
+                float4 coords = float4Set(sprite.u1, sprite.v1, sprite.u2, sprite.v2);
+                if (clip)
+                {
+                    // Clamp both corners into the clip rectangle and move the texture coordinates along.
+                    float4 clipped = FLOAT4_MIN(FLOAT4_MAX(corners, float4Set(clip->x, clip->y, clip->x, clip->y)),
+                        float4Set(clip->x + clip->width, clip->y + clip->height, clip->x + clip->width, clip->y + clip->height));
+                    float4 scale = float4Set((sprite.u2 - sprite.u1) / sprite.width, (sprite.v2 - sprite.v1) / sprite.height,
+                        (sprite.u2 - sprite.u1) / sprite.width, (sprite.v2 - sprite.v1) / sprite.height);
+                    coords = FLOAT4_MADD(float4Set(sprite.u1, sprite.v1, sprite.u1, sprite.v1),
+                        FLOAT4_SUB(clipped, float4Set(sprite.x, sprite.y, sprite.x, sprite.y)), scale);
+                    corners = clipped;
+                }
+                FLOAT4_STORE(edges, corners);
+                FLOAT4_STORE(uv, coords);
+#else
+                edges[0] = sprite.x;
+                edges[1] = sprite.y;
+                edges[2] = sprite.x + sprite.width;
+                edges[3] = sprite.y + sprite.height;
+                uv[0] = sprite.u1;
+                uv[1] = sprite.v1;
+                uv[2] = sprite.u2;
+                uv[3] = sprite.v2;
+                if (clip)
+                {
+                    const float clipX[2] = { clip->x, clip->x + clip->width };
+                    const float clipY[2] = { clip->y, clip->y + clip->height };
+                    for (int k = 0; k < 4; k += 2)
+                    {
+                        edges[k] = std::min(std::max(edges[k], clipX[0]), clipX[1]);
+                        edges[k + 1] = std::min(std::max(edges[k + 1], clipY[0]), clipY[1]);
+                        uv[k] = sprite.u1 + (edges[k] - sprite.x) * (sprite.u2 - sprite.u1) / sprite.width;
+                        uv[k + 1] = sprite.v1 + (edges[k + 1] - sprite.y) * (sprite.v2 - sprite.v1) / sprite.height;
+                    }
+                }
+#endif
+                if (clip && (edges[2] <= edges[0] || edges[3] <= edges[1]))
+                    continue;
+
+                SpriteVertex* v = vertices + written * 4;
+                SPRITE_ADD_VERTEX(v[0], edges[0], edges[1], 0, uv[0], uv[1], sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[1], edges[0], edges[3], 0, uv[0], uv[3], sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[2], edges[2], edges[1], 0, uv[2], uv[1], sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[3], edges[2], edges[3], 0, uv[2], uv[3], sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+            }
+            else
+            {
+                // Rotate the four corners around the center, in the order of the vertices.
+                const float halfWidth = 0.5f * sprite.width;
+                const float halfHeight = 0.5f * sprite.height;
+                const float centerX = sprite.x + halfWidth;
+                const float centerY = sprite.y + halfHeight;
+#ifdef GP_SIMD
+                float4 dx = float4Set(-halfWidth, -halfWidth, halfWidth, halfWidth);
+                float4 dy = float4Set(-halfHeight, halfHeight, -halfHeight, halfHeight);
+                float4 sine = FLOAT4_SET(sines[j]);
+                float4 cosine = FLOAT4_SET(cosines[j]);
+                FLOAT4_STORE(x, FLOAT4_ADD(FLOAT4_SET(centerX), FLOAT4_SUB(FLOAT4_MUL(dx, cosine), FLOAT4_MUL(dy, sine))));
+                FLOAT4_STORE(y, FLOAT4_ADD(FLOAT4_SET(centerY), FLOAT4_ADD(FLOAT4_MUL(dx, sine), FLOAT4_MUL(dy, cosine))));
+#else
+                const float dx[4] = { -halfWidth, -halfWidth, halfWidth, halfWidth };
+                const float dy[4] = { -halfHeight, halfHeight, -halfHeight, halfHeight };
+                for (int k = 0; k < 4; ++k)
+                {
+                    x[k] = centerX + dx[k] * cosines[j] - dy[k] * sines[j];
+                    y[k] = centerY + dx[k] * sines[j] + dy[k] * cosines[j];
+                }
+#endif
+                if (clip)
+                {
+                    float minX = std::min(std::min(x[0], x[1]), std::min(x[2], x[3]));
+                    float maxX = std::max(std::max(x[0], x[1]), std::max(x[2], x[3]));
+                    float minY = std::min(std::min(y[0], y[1]), std::min(y[2], y[3]));
+                    float maxY = std::max(std::max(y[0], y[1]), std::max(y[2], y[3]));
+                    if (maxX < clip->x || minX > clip->x + clip->width || maxY < clip->y || minY > clip->y + clip->height)
+                        continue;
+                }
+
+                SpriteVertex* v = vertices + written * 4;
+                SPRITE_ADD_VERTEX(v[0], x[0], y[0], 0, sprite.u1, sprite.v1, sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[1], x[1], y[1], 0, sprite.u1, sprite.v2, sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[2], x[2], y[2], 0, sprite.u2, sprite.v1, sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+                SPRITE_ADD_VERTEX(v[3], x[3], y[3], 0, sprite.u2, sprite.v2, sprite.color.x, sprite.color.y, sprite.color.z, sprite.color.w);
+            }
+            ++written;
+        }
+    }
+    return written;
 }
 
 void SpriteBatch::finish()
 {
-    // Finish and draw the batch
-    _batch->finish();
-    _batch->draw();
+    DebugMarkers::Group marker("SpriteBatch", _sampler && _sampler->getTexture() ? _sampler->getTexture()->getPath() : NULL);
+    if (_deferred)
+    {
+        drawDeferred();
+    }
+    else
+    {
+        // Finish and draw the batch
+        _batch->finish();
+        _batch->draw();
+    }
+
+    _started = false;
+    _layer = 0;
+    if (_samplerIndex != 0)
+        selectSampler(0);
+}
+
+void SpriteBatch::setDeferred(bool deferred)
+{
+    if (_started)
+    {
+        GP_WARN("The deferred mode of a sprite batch cannot change between start() and finish().");
+        return;
+    }
+    _deferred = deferred;
+}
+
+bool SpriteBatch::isDeferred() const
+{
+    return _deferred;
+}
+
+void SpriteBatch::setTexture(Texture* texture)
+{
+    if (texture == NULL)
+        texture = _samplers[0]->getTexture();
+
+    unsigned int index = 0;
+    while (index < _samplers.size() && _samplers[index]->getTexture() != texture)
+    {
+        ++index;
+    }
+    if (index == _samplerIndex)
+        return;
+    if (index == _samplers.size())
+        _samplers.push_back(Texture::Sampler::create(texture));
+
+    // Sprites already in the batch are drawn with the texture they were drawn with.
+    if (_started && !_deferred)
+    {
+        _batch->finish();
+        _batch->draw();
+        _batch->start();
+    }
+    selectSampler(index);
+}
+
+void SpriteBatch::setLayer(int layer)
+{
+    _layer = layer;
+}
+
+int SpriteBatch::getLayer() const
+{
+    return _layer;
+}
+
+void SpriteBatch::selectSampler(unsigned int index)
+{
+    GP_ASSERT(index < _samplers.size());
+
+    _samplerIndex = index;
+    _sampler = _samplers[index];
+    _samplerParameter->setValue(_sampler);
+
+    Texture* texture = _sampler->getTexture();
+    _textureWidthRatio = 1.0f / (float)texture->getWidth();
+    _textureHeightRatio = 1.0f / (float)texture->getHeight();
+}
+
+bool SpriteBatch::sortDeferredSprites(const DeferredSprite& a, const DeferredSprite& b)
+{
+    if (a.layer != b.layer)
+        return a.layer < b.layer;
+    if (a.sampler != b.sampler)
+        return a.sampler < b.sampler;
+    if (a.depth != b.depth)
+        return a.depth < b.depth;
+    return a.first < b.first;
+}
+
+void SpriteBatch::drawDeferred()
+{
+    // The depth is read now, since the callers of addSprites() fill in the vertices after adding them.
+    for (size_t i = 0; i < _deferredSprites.size(); ++i)
+    {
+        _deferredSprites[i].depth = _deferredVertices[_deferredSprites[i].first].z;
+    }
+    std::sort(_deferredSprites.begin(), _deferredSprites.end(), &sortDeferredSprites);
+
+    size_t count = drawDeferredArray() ? 0 : _deferredSprites.size();
+    for (size_t start = 0; start < count; )
+    {
+        unsigned int sampler = _deferredSprites[start].sampler;
+        size_t end = start + 1;
+        while (end < count && _deferredSprites[end].sampler == sampler)
+        {
+            ++end;
+        }
+
+        _samplerParameter->setValue(_samplers[sampler]);
+        _batch->start();
+        SpriteVertex* vertices = appendSprites((unsigned int)(end - start));
+        if (vertices)
+        {
+            for (size_t i = start; i < end; ++i, vertices += 4)
+            {
+                memcpy(vertices, &_deferredVertices[_deferredSprites[i].first], 4 * sizeof(SpriteVertex));
+            }
+        }
+        _batch->finish();
+        _batch->draw();
+        start = end;
+    }
+    _samplerParameter->setValue(_sampler);
+
+    _deferredSprites.clear();
+    _deferredVertices.clear();
+}
+
+bool SpriteBatch::drawDeferredArray()
+{
+#ifdef USE_TEXTURE_ARRAYS
+    // Sprites of a single texture need no array, and custom effects sample 2D textures.
+    if (_customEffect || _deferredSprites.empty())
+        return false;
+    size_t other = 1;
+    while (other < _deferredSprites.size() && _deferredSprites[other].sampler == _deferredSprites[0].sampler)
+    {
+        ++other;
+    }
+    if (other == _deferredSprites.size())
+        return false;
+
+    if (_arraySamplerCount != _samplers.size())
+        createTextureArray();
+    if (_arrayBatch == NULL)
+        return false;
+
+    unsigned int count = (unsigned int)_deferredSprites.size();
+    void* vertices;
+    void* indices;
+    unsigned int base;
+    _arrayBatch->start();
+    if (!_arrayBatch->append(count * 4, count * 6 - 2, &vertices, &indices, &base))
+    {
+        _arrayBatch->finish();
+        return false;
+    }
+
+    GP_ASSERT(indices);
+    if (_arrayBatch->getIndexFormat() == Mesh::INDEX32)
+        writeSpriteIndices((unsigned int*)indices, count, base);
+    else
+        writeSpriteIndices((unsigned short*)indices, count, base);
+
+    // Each sprite samples the layer of its texture, which is the index of its sampler.
+    ArrayVertex* v = (ArrayVertex*)vertices;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const SpriteVertex* source = &_deferredVertices[_deferredSprites[i].first];
+        float layer = (float)_deferredSprites[i].sampler;
+        for (unsigned int j = 0; j < 4; ++j, ++v)
+        {
+            v->x = source[j].x;
+            v->y = source[j].y;
+            v->z = source[j].z;
+            v->u = source[j].u;
+            v->v = source[j].v;
+            v->layer = layer;
+            v->r = source[j].r;
+            v->g = source[j].g;
+            v->b = source[j].b;
+            v->a = source[j].a;
+        }
+    }
+    _arrayBatch->finish();
+    _arrayBatch->draw();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SpriteBatch::createTextureArray()
+{
+    // The array is packed once per set of textures, whether or not the packing succeeds.
+    _arraySamplerCount = (unsigned int)_samplers.size();
+    SAFE_DELETE(_arrayBatch);
+    SAFE_RELEASE(_arraySampler);
+
+    // The layers are loaded again from the files of the textures.
+    std::vector<const char*> paths(_samplers.size());
+    for (size_t i = 0, count = _samplers.size(); i < count; ++i)
+    {
+        Texture* texture = _samplers[i]->getTexture();
+        if (texture->getPath()[0] == '\0' || texture->isCompressed() || texture->getLayerCount() != 1)
+            return;
+        paths[i] = texture->getPath();
+    }
+    std::vector<Image*> images(paths.size());
+    unsigned int created = Image::createBatch(&paths[0], (unsigned int)paths.size(), &images[0], Texture::isPremultipliedAlpha());
+
+    Texture* texture = NULL;
+    if (created == images.size())
+        texture = Texture::createArray(&images[0], (unsigned int)images.size(), _samplers[0]->getTexture()->isMipmapped());
+    for (size_t i = 0, count = images.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(images[i]);
+    }
+    if (texture == NULL)
+    {
+        GP_WARN("Failed to pack the sprite batch textures into a texture array; drawing each texture separately.");
+        return;
+    }
+
+    Effect* effect = Effect::createFromFile(SPRITE_VSH, SPRITE_FSH, "TEXTURE_ARRAY");
+    if (effect == NULL)
+    {
+        GP_WARN("Unable to load the texture array sprite effect.");
+        texture->release();
+        return;
+    }
+    Material* material = Material::create(effect); // +ref effect
+    effect->release();
+
+    // The array material shares the state block of the batch, so changes made through getStateBlock() apply to it.
+    material->setStateBlock(_batch->getMaterial()->getStateBlock());
+    _arraySampler = Texture::Sampler::create(texture); // +ref texture
+    texture->release();
+    material->getParameter("u_texture")->setValue(_arraySampler);
+    material->getParameter("u_projectionMatrix")->bindValue(this, &SpriteBatch::getProjectionMatrix);
+
+    VertexFormat::Element vertexElements[] =
+    {
+        VertexFormat::Element(VertexFormat::POSITION, 3),
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 3),
+        VertexFormat::Element(VertexFormat::COLOR, 4)
+    };
+    VertexFormat vertexFormat(vertexElements, 3);
+    _arrayBatch = MeshBatch::create(vertexFormat, Mesh::TRIANGLE_STRIP, material, true, SPRITE_BATCH_DEFAULT_SIZE);
+    material->release();
 }
 
 RenderState::StateBlock* SpriteBatch::getStateBlock() const
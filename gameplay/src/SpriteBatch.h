@@ -12,23 +12,72 @@
 namespace gameplay
 {
 
+class MaterialParameter;
+
 /**
  * Enables groups of sprites to be drawn with common settings.
  *
  * This class provides efficient rendering and sorting of two-dimensional
- * sprites. Only a single texture and effect can be used with a SpriteBatch.
- * This limitation promotes efficient batching by using texture atlases and
- * implicit sorting to minimize state changes. Therefore, it is highly
- * recommended to combine multiple small textures into larger texture atlases
- * where possible when drawing sprites.
+ * sprites. A SpriteBatch draws with a single effect, and each draw call uses
+ * a single texture. Sprites of other textures can be drawn with setTexture(),
+ * and in deferred mode the batch sorts the sprites by texture so that each
+ * texture costs one draw call, or draws them all with one call from a texture
+ * array where texture arrays are available. It is still highly recommended to combine
+ * multiple small textures into larger texture atlases where possible when
+ * drawing sprites.
  */
 class SpriteBatch
 {
     friend class Bundle;
+    friend class Control;
     friend class Font;
+    friend class ParticleEmitter;
 
 public:
 
+    /**
+     * Defines a sprite to draw with the bulk draw method.
+     *
+     * @script{ignore}
+     */
+    struct Sprite
+    {
+        /**
+         * The x coordinate of the left edge of the sprite, before rotation.
+         */
+        float x;
+
+        /**
+         * The y coordinate of the top edge of the sprite, before rotation.
+         */
+        float y;
+
+        /**
+         * The width of the sprite.
+         */
+        float width;
+
+        /**
+         * The height of the sprite.
+         */
+        float height;
+
+        /**
+         * The texture coordinates of the corners of the sprite.
+         */
+        float u1, v1, u2, v2;
+
+        /**
+         * The color to tint the sprite. Use white for no tint.
+         */
+        Vector4 color;
+
+        /**
+         * The rotation of the sprite around its center, in radians.
+         */
+        float rotation;
+    };
+
     /**
      * Creates a new SpriteBatch for drawing sprites with the given texture.
      *
@@ -237,6 +286,25 @@ public:
      */
     void draw(float x, float y, float z, float width, float height, float u1, float v1, float u2, float v2, const Vector4& color, bool positionIsCenter = false);
 
+    /**
+     * Draws an array of sprites.
+     *
+     * This is the fastest way to draw many sprites: the quads are computed with SIMD
+     * instructions where they are available, the rotations of four sprites at a time,
+     * and the vertices are written straight into the batch.
+     *
+     * Sprites that are not rotated are clipped within the clip rectangle, with their
+     * texture coordinates adjusted to match. Rotated sprites are only culled when they
+     * are entirely outside of it. Sprites with nothing left to draw are skipped.
+     *
+     * @param sprites The sprites to draw.
+     * @param count The number of sprites.
+     * @param clip The clip rectangle, or NULL to draw the sprites whole.
+     *
+     * @script{ignore}
+     */
+    void draw(const Sprite* sprites, unsigned int count, const Rectangle* clip = NULL);
+
     /**
      * Finishes sprite drawing.
      *
@@ -245,12 +313,74 @@ public:
      */
     void finish();
 
+    /**
+     * Sets whether the sprites are drawn at finish() in sorted order instead of in the order they are drawn.
+     *
+     * In deferred mode, the batch keeps the sprites drawn between start() and finish()
+     * along with their layer and texture, and sorts them at finish() by layer, then by
+     * texture, then by depth (the z coordinate, lowest first). Sprites with the same
+     * layer, texture and depth keep the order they were drawn in. Each run of sprites
+     * with the same texture is then drawn with one draw call, so sprites of several
+     * textures can be drawn in any order between a single start() and finish().
+     *
+     * On platforms with texture arrays, a batch using the default effect packs its
+     * textures into one texture array the first time it draws sprites of several
+     * textures, and draws all the sorted sprites with a single draw call. The textures
+     * are loaded again from their files for this, so they must all be loaded from
+     * uncompressed images of the same size and format; otherwise, and on other platforms,
+     * each run of one texture is drawn separately. The texture array is sampled with the
+     * default sampler settings, and is packed again when the batch is given a new texture.
+     *
+     * The mode cannot be changed between start() and finish(). Default is false.
+     *
+     * @param deferred true to sort the sprites at finish(), false to draw them in order.
+     */
+    void setDeferred(bool deferred);
+
+    /**
+     * Determines whether the sprites are sorted and drawn at finish().
+     *
+     * @return true if the batch is in deferred mode.
+     */
+    bool isDeferred() const;
+
+    /**
+     * Sets the texture of the sprites drawn from now on.
+     *
+     * The batch creates a sampler for each texture it is given, with the default
+     * sampler settings, and keeps it for later use. While a texture is set, getSampler()
+     * returns its sampler, and source rectangles are measured in its pixels. In
+     * immediate mode, the sprites drawn so far are drawn before the texture changes.
+     * The batch goes back to the texture it was created with at finish().
+     *
+     * @param texture The texture, or NULL for the texture the batch was created with.
+     */
+    void setTexture(Texture* texture);
+
+    /**
+     * Sets the layer of the sprites drawn from now on, in deferred mode.
+     *
+     * Sprites of lower layers are drawn before sprites of higher layers, whatever their
+     * texture. The layer goes back to 0 at finish().
+     *
+     * @param layer The layer.
+     */
+    void setLayer(int layer);
+
+    /**
+     * Gets the layer of the sprites drawn from now on.
+     *
+     * @return The layer.
+     */
+    int getLayer() const;
+
     /**
      * Gets the texture sampler. 
      *
      * This return texture sampler is used when sampling the texture in the
      * effect. This can be modified for controlling sampler setting such as
-     * filtering modes.
+     * filtering modes. When a texture is set with setTexture(), this is the
+     * sampler of that texture.
      */
     Texture::Sampler* getSampler() const;
 
@@ -314,6 +444,34 @@ private:
      */
     SpriteBatch();
 
+    /**
+     * Sprite vertex structure used for drawing from a texture array.
+     */
+    struct ArrayVertex
+    {
+        float x;
+        float y;
+        float z;
+        float u;
+        float v;
+        float layer;
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /**
+     * A sprite kept for sorting in deferred mode.
+     */
+    struct DeferredSprite
+    {
+        int layer;
+        unsigned int sampler;
+        float depth;
+        unsigned int first;
+    };
+
     /**
      * Copy constructor.
      * 
@@ -321,6 +479,55 @@ private:
      */
     SpriteBatch(const SpriteBatch& copy);
 
+    /**
+     * Makes one of the samplers of the batch the current one.
+     */
+    void selectSampler(unsigned int index);
+
+    /**
+     * Keeps sprites for deferred drawing and returns their vertices to be filled in by the caller.
+     */
+    SpriteBatch::SpriteVertex* deferSprites(unsigned int count);
+
+    /**
+     * Adds sprites to the mesh batch and returns their vertices to be filled in by the caller.
+     */
+    SpriteBatch::SpriteVertex* appendSprites(unsigned int count);
+
+    /**
+     * Sorts the deferred sprites and draws each run of sprites with the same texture.
+     */
+    void drawDeferred();
+
+    /**
+     * Draws the sorted deferred sprites with one draw call from a texture array of all the textures of the batch.
+     *
+     * @return true if the sprites were drawn, false if they must be drawn by texture.
+     */
+    bool drawDeferredArray();
+
+    /**
+     * Packs the textures of the batch into a texture array, and creates the mesh batch drawing from it.
+     */
+    void createTextureArray();
+
+    /**
+     * Adds sprites to the batch, or to the capture vector, and returns their vertices to be filled in by the caller.
+     */
+    SpriteBatch::SpriteVertex* reserveSprites(unsigned int count);
+
+    /**
+     * Computes the vertices of an array of sprites, clipped within a rectangle if one is given.
+     *
+     * @return The number of sprites written, leaving out those with nothing to draw.
+     */
+    static unsigned int expandSprites(const Sprite* sprites, unsigned int count, const Rectangle* clip, SpriteBatch::SpriteVertex* vertices);
+
+    /**
+     * Orders deferred sprites by layer, then texture, then depth, then drawing order.
+     */
+    static bool sortDeferredSprites(const DeferredSprite& a, const DeferredSprite& b);
+
     /**
      * Adds a single sprite to a SpriteVertex array.
      * 
@@ -364,6 +571,43 @@ private:
      */
     void draw(SpriteBatch::SpriteVertex* vertices, unsigned int vertexCount, unsigned short* indices, unsigned int indexCount);
 
+    /**
+     * Adds sprites to the batch and returns their vertices to be filled in by the caller.
+     *
+     * Each sprite has four vertices, ordered bottom-left, bottom-right, top-left and top-right;
+     * the indices connecting them are generated by this method.
+     *
+     * @param count The number of sprites to add.
+     *
+     * @return The vertices of the added sprites, or NULL if the batch could not hold them.
+     */
+    SpriteBatch::SpriteVertex* addSprites(unsigned int count);
+
+    /**
+     * Adds previously captured sprites to the batch, translated by an offset.
+     *
+     * @param vertices The vertices of the sprites, four per sprite in the order used by addSprites.
+     * @param count The number of sprites.
+     * @param offset The offset added to the position of every vertex.
+     */
+    void addSprites(const SpriteBatch::SpriteVertex* vertices, unsigned int count, const Vector2& offset);
+
+    /**
+     * Starts or stops capturing sprites.
+     *
+     * While capturing, the sprites drawn with the quad drawing methods are appended
+     * to the given vector instead of being added to the batch, so that they can be
+     * added again later with addSprites without clipping or computing them again.
+     *
+     * @param vertices The vector receiving the sprite vertices, or NULL to stop capturing.
+     */
+    void setCapture(std::vector<SpriteBatch::SpriteVertex>* vertices);
+
+    /**
+     * Adds the four vertices of a sprite to the batch, or to the capture vector.
+     */
+    void addQuad(const SpriteBatch::SpriteVertex* vertices);
+
     /**
      * Clip position and size to fit within clip region.
      *
@@ -373,10 +617,23 @@ private:
 
     MeshBatch* _batch;
     Texture::Sampler* _sampler;
+    std::vector<Texture::Sampler*> _samplers;
+    unsigned int _samplerIndex;
+    MaterialParameter* _samplerParameter;
+    bool _deferred;
+    bool _started;
+    int _layer;
+    std::vector<DeferredSprite> _deferredSprites;
+    std::vector<SpriteVertex> _deferredVertices;
+    std::vector<SpriteVertex> _clippedVertices;
+    MeshBatch* _arrayBatch;
+    Texture::Sampler* _arraySampler;
+    unsigned int _arraySamplerCount;
     bool _customEffect;
     float _textureWidthRatio;
     float _textureHeightRatio;
     mutable Matrix _projectionMatrix;
+    std::vector<SpriteVertex>* _capture;
 };
 
 }
@@ -0,0 +1,163 @@
+#include "Base.h"
+#include "StartupTrace.h"
+#include "FileSystem.h"
+#include "Thread.h"
+
+#ifdef WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+namespace gameplay
+{
+
+struct StartupStage
+{
+    const char* name;
+    unsigned int depth;
+    double start;
+    double duration;
+};
+
+static std::vector<StartupStage> __stages;
+static std::vector<unsigned int> __openStages;  // Indices of the stages that are open, innermost last.
+static bool __finished = false;
+static bool __started = false;
+static double __startTime = 0.0;
+
+// The platform timers only start with the message pump, so the trace reads a monotonic clock itself.
+static double getClockTime()
+{
+#ifdef WIN32
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (double)mach_absolute_time() * timebase.numer / timebase.denom / 1000000.0;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+#endif
+}
+
+StartupTrace::Scope::Scope(const char* name)
+    : _recording(StartupTrace::begin(name))
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    if (_recording)
+        StartupTrace::end();
+}
+
+bool StartupTrace::begin(const char* name)
+{
+    GP_ASSERT(name);
+
+    if (__finished || !Thread::isMainThread())
+        return false;
+
+    StartupStage stage;
+    stage.name = name;
+    stage.depth = (unsigned int)__openStages.size();
+    stage.start = getTime();
+    stage.duration = 0.0;
+    __openStages.push_back((unsigned int)__stages.size());
+    __stages.push_back(stage);
+    return true;
+}
+
+void StartupTrace::end()
+{
+    if (__finished || __openStages.empty() || !Thread::isMainThread())
+        return;
+
+    StartupStage& stage = __stages[__openStages.back()];
+    stage.duration = getTime() - stage.start;
+    __openStages.pop_back();
+}
+
+bool StartupTrace::isRecording()
+{
+    return !__finished;
+}
+
+double StartupTrace::getTime()
+{
+    if (!__started)
+    {
+        __startTime = getClockTime();
+        __started = true;
+    }
+    return getClockTime() - __startTime;
+}
+
+bool StartupTrace::write(const char* path)
+{
+    GP_ASSERT(path);
+
+    FILE* file = FileSystem::openFile(path, "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create startup trace file '%s'.", path);
+        return false;
+    }
+
+    // Times are written in microseconds.
+    fputs("{\"traceEvents\":[", file);
+    for (size_t i = 0, count = __stages.size(); i < count; ++i)
+    {
+        const StartupStage& stage = __stages[i];
+        fputs(i == 0 ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+        for (const char* c = stage.name; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                fputc('\\', file);
+            fputc(*c, file);
+        }
+        fprintf(file, "\",\"cat\":\"startup\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"depth\":%u}}",
+            stage.start * 1000.0, stage.duration * 1000.0, stage.depth);
+    }
+    fputs("\n]}\n", file);
+
+    bool result = ferror(file) == 0;
+    fclose(file);
+    if (!result)
+    {
+        GP_WARN("Failed to write startup trace file '%s'.", path);
+    }
+    return result;
+}
+
+void StartupTrace::finish(const char* path)
+{
+    if (__finished)
+        return;
+
+    while (!__openStages.empty())
+    {
+        end();
+    }
+    if (path)
+    {
+        write(path);
+    }
+
+    // The stages are not needed anymore.
+    __finished = true;
+    std::vector<StartupStage>().swap(__stages);
+    std::vector<unsigned int>().swap(__openStages);
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef STARTUPTRACE_H_
+#define STARTUPTRACE_H_
+
+namespace gameplay
+{
+
+/**
+ * Records the time spent in each stage of the startup of the game, up to the end of its first frame.
+ *
+ * Stages are opened with begin() or a Scope and may nest. The engine traces the creation of the
+ * platform and of the GL context, the loading of the config, Game::startup and the subsystems it
+ * initializes, the loading of the scripts, Game::initialize (where games usually load their first
+ * scene), the scenes loaded during startup and the first frame. Once the first frame ends, the
+ * trace is written to the file named in the game config, in the Chrome trace event format
+ * (chrome://tracing), and nothing more is recorded.
+ *
+ * @verbatim
+    startup
+    {
+        trace = startup.json    // File to write the trace to, relative to the resource path.
+    }
+   @endverbatim
+ *
+ * The stages are timed from the first stage recorded, on the main thread only.
+ *
+ * @script{ignore}
+ */
+class StartupTrace
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Records a stage until the end of the enclosing block.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * Begins a stage.
+         *
+         * @param name The name of the stage, which must outlive the trace (typically a literal).
+         */
+        explicit Scope(const char* name);
+
+        /**
+         * Ends the stage.
+         */
+        ~Scope();
+
+    private:
+
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        bool _recording;
+    };
+
+    /**
+     * Begins a stage, nested in the stage that is open.
+     *
+     * @param name The name of the stage, which must outlive the trace (typically a literal).
+     *
+     * @return true if the stage is recorded, false if the startup is over.
+     */
+    static bool begin(const char* name);
+
+    /**
+     * Ends the innermost open stage.
+     */
+    static void end();
+
+    /**
+     * Returns whether the startup is still being traced.
+     *
+     * @return true until the end of the first frame.
+     */
+    static bool isRecording();
+
+    /**
+     * Returns the time elapsed since the first stage was recorded.
+     *
+     * @return The time, in milliseconds.
+     */
+    static double getTime();
+
+    /**
+     * Writes the stages recorded so far to a file, in the Chrome trace event format.
+     *
+     * @param path The path of the file.
+     *
+     * @return true if the file was written, false otherwise.
+     */
+    static bool write(const char* path);
+
+private:
+
+    /**
+     * Stops recording, ending the stages that are still open, and writes the trace if the
+     * config names a file. Called by Game at the end of the first frame.
+     */
+    static void finish(const char* path);
+};
+
+}
+
+#endif
@@ -0,0 +1,363 @@
+#include "Base.h"
+#include "StateCache.h"
+#include "RenderStats.h"
+#include "RenderCommandList.h"
+
+// The number of texture units whose bindings are cached.
+#define MAX_TEXTURE_UNITS 32
+
+namespace gameplay
+{
+
+/**
+ * The cached GL state. Every field is set to all ones bits while unknown, which is
+ * never a valid name, enum, flag or rectangle, so the next call always differs.
+ */
+struct CachedState
+{
+    GLuint program;
+    unsigned int activeTexture;
+    TextureHandle textures[MAX_TEXTURE_UNITS];
+    GLuint samplers[MAX_TEXTURE_UNITS];
+    GLuint arrayBuffer;
+    GLuint elementArrayBuffer;
+    GLuint vertexArray;
+    unsigned char blend;
+    unsigned char cullFace;
+    unsigned char depthTest;
+    unsigned char scissorTest;
+    unsigned char depthWrite;
+    unsigned char colorMask;
+    GLenum blendSource;
+    GLenum blendDestination;
+    GLenum cullFaceSide;
+    GLenum depthFunction;
+    GLint scissor[4];
+    GLint viewport[4];
+};
+
+static CachedState createUnknownState()
+{
+    CachedState state;
+    memset(&state, 0xff, sizeof(state));
+    return state;
+}
+
+static CachedState __state = createUnknownState();
+
+StateCache::StateCache()
+{
+}
+
+void StateCache::invalidate()
+{
+    __state = createUnknownState();
+}
+
+void StateCache::useProgram(GLuint program)
+{
+    if (__state.program != program)
+    {
+        RenderCommandList::useProgram(program);
+        __state.program = program;
+        RenderStats::addEffectBind();
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setActiveTexture(unsigned int unit)
+{
+    if (__state.activeTexture != unit)
+    {
+        RenderCommandList::activeTexture(unit);
+        __state.activeTexture = unit;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::bindTexture(GLenum target, TextureHandle handle)
+{
+    if (__state.activeTexture >= MAX_TEXTURE_UNITS)
+    {
+        RenderCommandList::bindTexture(target, handle);
+        return;
+    }
+
+    // Texture names are unique across targets, so the cached name identifies the binding.
+    TextureHandle& bound = __state.textures[__state.activeTexture];
+    if (bound != handle)
+    {
+        RenderCommandList::bindTexture(target, handle);
+        bound = handle;
+        RenderStats::addTextureBind();
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+#ifdef USE_SAMPLER_OBJECTS
+void StateCache::bindSampler(GLuint sampler)
+{
+    if (__state.activeTexture >= MAX_TEXTURE_UNITS)
+    {
+        RenderCommandList::bindSampler(__state.activeTexture, sampler);
+        return;
+    }
+
+    GLuint& bound = __state.samplers[__state.activeTexture];
+    if (bound != sampler)
+    {
+        RenderCommandList::bindSampler(__state.activeTexture, sampler);
+        bound = sampler;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+#endif
+
+void StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* bound;
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:
+        bound = &__state.arrayBuffer;
+        break;
+    case GL_ELEMENT_ARRAY_BUFFER:
+        bound = &__state.elementArrayBuffer;
+        break;
+    default:
+        RenderCommandList::bindBuffer(target, buffer);
+        return;
+    }
+
+    if (*bound != buffer)
+    {
+        RenderCommandList::bindBuffer(target, buffer);
+        *bound = buffer;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::bindVertexArray(GLuint array)
+{
+    if (__state.vertexArray != array)
+    {
+        RenderCommandList::bindVertexArray(array);
+        __state.vertexArray = array;
+        __state.elementArrayBuffer = (GLuint)-1;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setEnabled(GLenum capability, bool enabled)
+{
+    unsigned char* current;
+    switch (capability)
+    {
+    case GL_BLEND:
+        current = &__state.blend;
+        break;
+    case GL_CULL_FACE:
+        current = &__state.cullFace;
+        break;
+    case GL_DEPTH_TEST:
+        current = &__state.depthTest;
+        break;
+    case GL_SCISSOR_TEST:
+        current = &__state.scissorTest;
+        break;
+    default:
+        current = NULL;
+        break;
+    }
+
+    unsigned char value = enabled ? 1 : 0;
+    if (current && *current == value)
+    {
+        RenderStats::addRedundantStateChange();
+        return;
+    }
+
+    RenderCommandList::setEnabled(capability, enabled);
+    if (current)
+        *current = value;
+}
+
+void StateCache::setBlendFunction(GLenum source, GLenum destination)
+{
+    if (__state.blendSource != source || __state.blendDestination != destination)
+    {
+        RenderCommandList::blendFunc(source, destination);
+        __state.blendSource = source;
+        __state.blendDestination = destination;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setCullFaceSide(GLenum side)
+{
+    if (__state.cullFaceSide != side)
+    {
+        RenderCommandList::cullFace(side);
+        __state.cullFaceSide = side;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setDepthFunction(GLenum function)
+{
+    if (__state.depthFunction != function)
+    {
+        RenderCommandList::depthFunc(function);
+        __state.depthFunction = function;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setDepthWrite(bool enabled)
+{
+    unsigned char value = enabled ? 1 : 0;
+    if (__state.depthWrite != value)
+    {
+        RenderCommandList::depthMask(enabled);
+        __state.depthWrite = value;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setColorMask(bool red, bool green, bool blue, bool alpha)
+{
+    unsigned char value = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0);
+    if (__state.colorMask != value)
+    {
+        RenderCommandList::colorMask(red, green, blue, alpha);
+        __state.colorMask = value;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint* scissor = __state.scissor;
+    if (scissor[0] != x || scissor[1] != y || scissor[2] != width || scissor[3] != height)
+    {
+        RenderCommandList::scissor(x, y, width, height);
+        scissor[0] = x;
+        scissor[1] = y;
+        scissor[2] = width;
+        scissor[3] = height;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::setViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint* viewport = __state.viewport;
+    if (viewport[0] != x || viewport[1] != y || viewport[2] != width || viewport[3] != height)
+    {
+        RenderCommandList::viewport(x, y, width, height);
+        viewport[0] = x;
+        viewport[1] = y;
+        viewport[2] = width;
+        viewport[3] = height;
+    }
+    else
+    {
+        RenderStats::addRedundantStateChange();
+    }
+}
+
+void StateCache::deleteProgram(GLuint program)
+{
+    // A current program is only deleted once it is no longer in use.
+    if (__state.program == program)
+    {
+        RenderCommandList::useProgram(0);
+        __state.program = 0;
+    }
+    RenderCommandList::deleteProgram(program);
+}
+
+void StateCache::deleteTexture(TextureHandle handle)
+{
+    // Deleting a texture unbinds it from every unit.
+    for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        if (__state.textures[i] == handle)
+            __state.textures[i] = 0;
+    }
+    RenderCommandList::deleteTexture(handle);
+}
+
+#ifdef USE_SAMPLER_OBJECTS
+void StateCache::deleteSampler(GLuint sampler)
+{
+    // Deleting a sampler object unbinds it from every unit.
+    for (unsigned int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        if (__state.samplers[i] == sampler)
+            __state.samplers[i] = 0;
+    }
+    RenderCommandList::deleteSampler(sampler);
+}
+#endif
+
+void StateCache::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+    // Deleting a buffer unbinds it from the bindings of the context.
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        if (__state.arrayBuffer == buffers[i])
+            __state.arrayBuffer = 0;
+        if (__state.elementArrayBuffer == buffers[i])
+            __state.elementArrayBuffer = (GLuint)-1;
+    }
+    RenderCommandList::deleteBuffers(count, buffers);
+}
+
+void StateCache::deleteVertexArray(GLuint array)
+{
+    if (__state.vertexArray == array)
+    {
+        __state.vertexArray = 0;
+        __state.elementArrayBuffer = (GLuint)-1;
+    }
+    GL_ASSERT( glDeleteVertexArrays(1, &array) );
+}
+
+}
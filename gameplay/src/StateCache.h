@@ -0,0 +1,209 @@
+#ifndef STATECACHE_H_
+#define STATECACHE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a shadow copy of the GL state that the engine changes, which filters out
+ * redundant GL calls.
+ *
+ * The engine routes its program, texture, sampler, buffer and vertex array binds,
+ * its fixed function states (blend, depth, cull face and scissor) and its scissor and viewport
+ * rectangles through this class. Each call compares the requested state with the
+ * cached one and only calls GL when they differ. Calls that are skipped are counted
+ * by RenderStats::getRedundantStateChanges().
+ *
+ * Higher level caches build on this one: RenderState::StateBlock still tracks which
+ * states to restore to their defaults, and Effect still tracks the current effect.
+ *
+ * The cache assumes that no other code changes the cached GL state. Code that calls
+ * GL directly, e.g. a third party renderer, should call invalidate() afterwards so the
+ * next call of each kind reaches GL. Buffers, textures, samplers, programs and vertex
+ * arrays must be deleted through this class so that cached bindings of their names are
+ * forgotten, since GL may reuse the names.
+ *
+ * @script{ignore}
+ */
+class StateCache
+{
+public:
+
+    /**
+     * Forgets all cached state, so that the next call of each kind reaches GL.
+     *
+     * This is called when the GL context is created.
+     */
+    static void invalidate();
+
+    /**
+     * Sets the current shader program.
+     *
+     * @param program The program, or 0 for none.
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * Sets the active texture unit, which bindTexture() binds to.
+     *
+     * @param unit The index of the texture unit.
+     */
+    static void setActiveTexture(unsigned int unit);
+
+    /**
+     * Binds a texture to the active texture unit.
+     *
+     * @param target The texture target.
+     * @param handle The texture, or 0 for none.
+     */
+    static void bindTexture(GLenum target, TextureHandle handle);
+
+#ifdef USE_SAMPLER_OBJECTS
+    /**
+     * Binds a sampler object to the active texture unit.
+     *
+     * @param sampler The sampler object, or 0 to sample with the parameters of the texture.
+     */
+    static void bindSampler(GLuint sampler);
+#endif
+
+    /**
+     * Binds a buffer.
+     *
+     * Array and element array buffer bindings are cached; other targets are passed
+     * through, since indexed binds also change their generic bindings.
+     *
+     * @param target The buffer target.
+     * @param buffer The buffer, or 0 for none.
+     */
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    /**
+     * Binds a vertex array object.
+     *
+     * The element array buffer binding is part of the vertex array state, so it is
+     * no longer known after a different vertex array is bound.
+     *
+     * @param array The vertex array, or 0 for none.
+     */
+    static void bindVertexArray(GLuint array);
+
+    /**
+     * Enables or disables a GL capability.
+     *
+     * GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST and GL_SCISSOR_TEST are cached; other
+     * capabilities are passed through.
+     *
+     * @param capability The capability.
+     * @param enabled true to enable the capability, false to disable it.
+     */
+    static void setEnabled(GLenum capability, bool enabled);
+
+    /**
+     * Sets the blend function.
+     *
+     * @param source The source factor.
+     * @param destination The destination factor.
+     */
+    static void setBlendFunction(GLenum source, GLenum destination);
+
+    /**
+     * Sets the face culled when face culling is enabled.
+     *
+     * @param side The side to cull.
+     */
+    static void setCullFaceSide(GLenum side);
+
+    /**
+     * Sets the depth comparison function.
+     *
+     * @param function The depth function.
+     */
+    static void setDepthFunction(GLenum function);
+
+    /**
+     * Enables or disables writing to the depth buffer.
+     *
+     * @param enabled true to write depth, false otherwise.
+     */
+    static void setDepthWrite(bool enabled);
+
+    /**
+     * Enables or disables writing to the color channels of the frame buffer.
+     *
+     * @param red true to write the red channel.
+     * @param green true to write the green channel.
+     * @param blue true to write the blue channel.
+     * @param alpha true to write the alpha channel.
+     */
+    static void setColorMask(bool red, bool green, bool blue, bool alpha);
+
+    /**
+     * Sets the scissor rectangle.
+     *
+     * @param x The left of the rectangle, in pixels.
+     * @param y The bottom of the rectangle, in pixels.
+     * @param width The width of the rectangle.
+     * @param height The height of the rectangle.
+     */
+    static void setScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Sets the viewport rectangle.
+     *
+     * @param x The left of the rectangle, in pixels.
+     * @param y The bottom of the rectangle, in pixels.
+     * @param width The width of the rectangle.
+     * @param height The height of the rectangle.
+     */
+    static void setViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * Deletes a shader program, first unbinding it if it is current.
+     *
+     * @param program The program.
+     */
+    static void deleteProgram(GLuint program);
+
+    /**
+     * Deletes a texture and forgets its bindings.
+     *
+     * @param handle The texture.
+     */
+    static void deleteTexture(TextureHandle handle);
+
+#ifdef USE_SAMPLER_OBJECTS
+    /**
+     * Deletes a sampler object and forgets its bindings.
+     *
+     * @param sampler The sampler object.
+     */
+    static void deleteSampler(GLuint sampler);
+#endif
+
+    /**
+     * Deletes buffers and forgets their bindings.
+     *
+     * @param count The number of buffers.
+     * @param buffers The buffers.
+     */
+    static void deleteBuffers(GLsizei count, const GLuint* buffers);
+
+    /**
+     * Deletes a vertex array object and forgets its binding.
+     *
+     * @param array The vertex array.
+     */
+    static void deleteVertexArray(GLuint array);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    StateCache();
+};
+
+}
+
+#endif
@@ -0,0 +1,394 @@
+#include "Base.h"
+#include "StaticBatcher.h"
+#include "Bundle.h"
+#include "Scene.h"
+#include "Node.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Material.h"
+
+// Batches use 16-bit indices, which every device supports.
+#define STATIC_BATCH_MAX_VERTICES 65535
+
+// The most floats a vertex element decodes to.
+#define STATIC_BATCH_MAX_ELEMENT_SIZE 16
+
+namespace gameplay
+{
+
+/**
+ * An index buffer of a mesh read back from its bundle.
+ */
+struct SourcePart
+{
+    Mesh::IndexFormat indexFormat;
+    unsigned int indexCount;
+    const unsigned char* indexData;
+};
+
+/**
+ * The vertex data of a mesh read back from its bundle.
+ */
+struct SourceMesh
+{
+    SourceMesh() : format(NULL), vertexCount(0), vertexData(NULL), hasPositionDecode(false) { }
+
+    const VertexFormat* format;
+    unsigned int vertexCount;
+    const unsigned char* vertexData;
+    bool hasPositionDecode;
+    Vector3 positionOffset;
+    Vector3 positionScale;
+    std::vector<SourcePart> parts;
+};
+
+/**
+ * A mesh part of a static node, waiting to be merged.
+ */
+struct StaticPart
+{
+    const SourceMesh* mesh;
+    unsigned int partIndex;
+    Matrix world;
+};
+
+/**
+ * The static mesh parts merged into the batches of one material, vertex layout and cell.
+ */
+struct StaticGroup
+{
+    std::string materialUrl;
+    std::vector<VertexFormat::Element> elements;
+    int cell[3];
+    Material* material;
+    std::vector<StaticPart> parts;
+};
+
+/**
+ * The vertices and indices of the batch being built.
+ */
+struct BatchBuilder
+{
+    std::vector<float> vertices;
+    std::vector<unsigned short> indices;
+    unsigned int vertexCount;
+    BoundingBox bounds;
+};
+
+static void gatherModelNodes(Node* node, std::vector<Node*>* nodes)
+{
+    for (; node != NULL; node = node->getNextSibling())
+    {
+        if (node->getModel())
+            nodes->push_back(node);
+        gatherModelNodes(node->getFirstChild(), nodes);
+    }
+}
+
+static bool isTriangleList(Model* model)
+{
+    Mesh* mesh = model->getMesh();
+    GP_ASSERT(mesh);
+
+    unsigned int partCount = mesh->getPartCount();
+    if (partCount == 0)
+        return false;
+    for (unsigned int i = 0; i < partCount; ++i)
+    {
+        if (mesh->getPart(i)->getPrimitiveType() != Mesh::TRIANGLES)
+            return false;
+        Material* material = model->getMaterial((int)i);
+        if (material == NULL || *material->getUrl() == '\0')
+            return false;
+    }
+    return true;
+}
+
+static bool getBatchElements(const VertexFormat& format, std::vector<VertexFormat::Element>* elements)
+{
+    // Batches store every element as floats, so that vertices of differently encoded meshes can be merged.
+    for (unsigned int i = 0; i < format.getElementCount(); ++i)
+    {
+        const VertexFormat::Element& e = format.getElement(i);
+        if (e.usage == VertexFormat::BLENDWEIGHTS || e.usage == VertexFormat::BLENDINDICES ||
+            e.usage == VertexFormat::INSTANCE_MATRIX || e.usage == VertexFormat::INSTANCE_DATA ||
+            e.size > STATIC_BATCH_MAX_ELEMENT_SIZE)
+        {
+            return false;
+        }
+        elements->push_back(VertexFormat::Element(e.usage, e.size));
+    }
+    return true;
+}
+
+static unsigned int readIndex(const SourcePart& part, unsigned int i)
+{
+    switch (part.indexFormat)
+    {
+    case Mesh::INDEX8:
+        return part.indexData[i];
+    case Mesh::INDEX16:
+        return ((const unsigned short*)part.indexData)[i];
+    default:
+        return ((const unsigned int*)part.indexData)[i];
+    }
+}
+
+static void appendVertex(BatchBuilder* builder, const SourceMesh& mesh, unsigned int index, const Matrix& world, const Matrix& normalMatrix)
+{
+    const unsigned char* data = mesh.vertexData + index * mesh.format->getVertexSize();
+    float values[STATIC_BATCH_MAX_ELEMENT_SIZE];
+    for (unsigned int i = 0; i < mesh.format->getElementCount(); ++i)
+    {
+        const VertexFormat::Element& e = mesh.format->getElement(i);
+        VertexFormat::decode(e, data, values);
+        data += e.getByteSize();
+
+        if (e.size >= 3)
+        {
+            Vector3 v(values[0], values[1], values[2]);
+            switch (e.usage)
+            {
+            case VertexFormat::POSITION:
+                if (mesh.hasPositionDecode)
+                {
+                    v.set(mesh.positionOffset.x + mesh.positionScale.x * v.x,
+                          mesh.positionOffset.y + mesh.positionScale.y * v.y,
+                          mesh.positionOffset.z + mesh.positionScale.z * v.z);
+                }
+                world.transformPoint(&v);
+                if (builder->vertexCount == 0)
+                    builder->bounds.set(v, v);
+                else
+                    builder->bounds.merge(BoundingBox(v, v));
+                break;
+            case VertexFormat::NORMAL:
+                normalMatrix.transformVector(&v);
+                v.normalize();
+                break;
+            case VertexFormat::TANGENT:
+            case VertexFormat::BINORMAL:
+                world.transformVector(&v);
+                v.normalize();
+                break;
+            default:
+                break;
+            }
+            values[0] = v.x;
+            values[1] = v.y;
+            values[2] = v.z;
+        }
+        builder->vertices.insert(builder->vertices.end(), values, values + e.size);
+    }
+    builder->vertexCount++;
+}
+
+static void appendPart(BatchBuilder* builder, const StaticPart& part, std::vector<int>* remap)
+{
+    const SourceMesh& mesh = *part.mesh;
+    const SourcePart& source = mesh.parts[part.partIndex];
+
+    Matrix normalMatrix;
+    part.world.invert(&normalMatrix);
+    normalMatrix.transpose();
+
+    // A mirroring transform turns the triangles inside out, so their winding is reversed.
+    bool flip = part.world.determinant() < 0.0f;
+
+    // Only the vertices the part references are copied, once each.
+    remap->assign(mesh.vertexCount, -1);
+    unsigned int triangleIndexCount = source.indexCount - source.indexCount % 3;
+    for (unsigned int i = 0; i < triangleIndexCount; i += 3)
+    {
+        for (unsigned int k = 0; k < 3; ++k)
+        {
+            unsigned int index = readIndex(source, i + (flip && k > 0 ? 3 - k : k));
+            if (index >= mesh.vertexCount)
+            {
+                GP_WARN("Replacing out of range vertex index %u with 0 in static batch.", index);
+                index = 0;
+            }
+            int& batchIndex = (*remap)[index];
+            if (batchIndex < 0)
+            {
+                batchIndex = (int)builder->vertexCount;
+                appendVertex(builder, mesh, index, part.world, normalMatrix);
+            }
+            builder->indices.push_back((unsigned short)batchIndex);
+        }
+    }
+}
+
+static bool flushBatch(Scene* scene, BatchBuilder* builder, const StaticGroup& group)
+{
+    if (builder->indices.empty())
+        return false;
+
+    VertexFormat format(&group.elements[0], (unsigned int)group.elements.size());
+    Mesh* mesh = Mesh::createMesh(format, builder->vertexCount, false);
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to create static batch mesh.");
+        return false;
+    }
+    mesh->setVertexData(&builder->vertices[0], 0, builder->vertexCount);
+    MeshPart* part = mesh->addPart(Mesh::TRIANGLES, Mesh::INDEX16, (unsigned int)builder->indices.size(), false);
+    part->setIndexData(&builder->indices[0], 0, (unsigned int)builder->indices.size());
+    mesh->setBoundingBox(builder->bounds);
+    mesh->setBoundingSphere(BoundingSphere(builder->bounds.getCenter(), builder->bounds.max.distance(builder->bounds.getCenter())));
+
+    Model* model = Model::create(mesh);
+    model->setMaterial(group.material);
+    Node* node = Node::create("staticBatch");
+    node->setModel(model);
+    scene->addNode(node);
+    SAFE_RELEASE(node);
+    SAFE_RELEASE(model);
+    SAFE_RELEASE(mesh);
+
+    builder->vertices.clear();
+    builder->indices.clear();
+    builder->vertexCount = 0;
+    return true;
+}
+
+StaticBatcher::StaticBatcher()
+{
+}
+
+unsigned int StaticBatcher::batch(Scene* scene, float cellSize)
+{
+    GP_ASSERT(scene);
+
+    std::vector<Node*> nodes;
+    gatherModelNodes(scene->getFirstNode(), &nodes);
+
+    std::map<std::string, Bundle::MeshData*> meshData;
+    std::map<std::string, SourceMesh> sourceMeshes;
+    std::vector<StaticGroup*> groups;
+    std::vector<Node*> batchedNodes;
+
+    for (size_t n = 0; n < nodes.size(); ++n)
+    {
+        Node* node = nodes[n];
+        Model* model = node->getModel();
+        if (!node->isStatic() && !node->hasTag("static"))
+            continue;
+        Mesh* mesh = model->getMesh();
+        if (model->getSkin() || model->getMeshLodCount() > 0 || mesh->getUrl() == NULL || *mesh->getUrl() == '\0' || !isTriangleList(model))
+            continue;
+
+        // Read the vertex and index data of the mesh back from its bundle, once per mesh.
+        std::string url = mesh->getUrl();
+        std::map<std::string, SourceMesh>::iterator itr = sourceMeshes.find(url);
+        if (itr == sourceMeshes.end())
+        {
+            SourceMesh source;
+            Bundle::MeshData* data = Bundle::readMeshData(url.c_str());
+            if (data)
+            {
+                meshData[url] = data;
+                source.format = &data->vertexFormat;
+                source.vertexCount = data->vertexCount;
+                source.vertexData = data->vertexData;
+                source.hasPositionDecode = data->hasPositionDecode;
+                source.positionOffset = data->positionOffset;
+                source.positionScale = data->positionScale;
+                for (size_t i = 0; i < data->parts.size(); ++i)
+                {
+                    SourcePart part;
+                    part.indexFormat = data->parts[i]->indexFormat;
+                    part.indexCount = data->parts[i]->indexCount;
+                    part.indexData = data->parts[i]->indexData;
+                    source.parts.push_back(part);
+                }
+            }
+            itr = sourceMeshes.insert(std::make_pair(url, source)).first;
+        }
+        const SourceMesh& source = itr->second;
+        std::vector<VertexFormat::Element> elements;
+        if (source.format == NULL || source.vertexCount != mesh->getVertexCount() || source.vertexCount > STATIC_BATCH_MAX_VERTICES ||
+            source.parts.size() != mesh->getPartCount() || !getBatchElements(*source.format, &elements))
+        {
+            continue;
+        }
+
+        int cell[3] = { 0, 0, 0 };
+        if (cellSize > 0.0f)
+        {
+            const Vector3& center = node->getBoundingSphere().center;
+            cell[0] = (int)floorf(center.x / cellSize);
+            cell[1] = (int)floorf(center.y / cellSize);
+            cell[2] = (int)floorf(center.z / cellSize);
+        }
+
+        StaticPart part;
+        part.mesh = &source;
+        part.world = node->getWorldMatrix();
+        for (unsigned int i = 0; i < mesh->getPartCount(); ++i)
+        {
+            Material* material = model->getMaterial((int)i);
+            StaticGroup* group = NULL;
+            for (size_t g = 0; g < groups.size(); ++g)
+            {
+                StaticGroup* candidate = groups[g];
+                if (candidate->materialUrl == material->getUrl() && candidate->elements == elements &&
+                    candidate->cell[0] == cell[0] && candidate->cell[1] == cell[1] && candidate->cell[2] == cell[2])
+                {
+                    group = candidate;
+                    break;
+                }
+            }
+            if (group == NULL)
+            {
+                group = new StaticGroup();
+                group->materialUrl = material->getUrl();
+                group->elements = elements;
+                memcpy(group->cell, cell, sizeof(cell));
+                group->material = material;
+                material->addRef();
+                groups.push_back(group);
+            }
+            part.partIndex = i;
+            group->parts.push_back(part);
+        }
+        batchedNodes.push_back(node);
+    }
+
+    // The batched nodes keep their transforms and collision objects but no longer draw.
+    for (size_t i = 0; i < batchedNodes.size(); ++i)
+    {
+        batchedNodes[i]->setModel(NULL);
+    }
+
+    unsigned int batchCount = 0;
+    BatchBuilder builder;
+    builder.vertexCount = 0;
+    std::vector<int> remap;
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        StaticGroup* group = groups[g];
+        for (size_t i = 0; i < group->parts.size(); ++i)
+        {
+            const StaticPart& part = group->parts[i];
+            unsigned int maxVertices = std::min(part.mesh->parts[part.partIndex].indexCount, part.mesh->vertexCount);
+            if (builder.vertexCount + maxVertices > STATIC_BATCH_MAX_VERTICES && flushBatch(scene, &builder, *group))
+                ++batchCount;
+            appendPart(&builder, part, &remap);
+        }
+        if (flushBatch(scene, &builder, *group))
+            ++batchCount;
+        SAFE_RELEASE(group->material);
+        SAFE_DELETE(group);
+    }
+
+    for (std::map<std::string, Bundle::MeshData*>::iterator itr = meshData.begin(); itr != meshData.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second);
+    }
+
+    return batchCount;
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef STATICBATCHER_H_
+#define STATICBATCHER_H_
+
+namespace gameplay
+{
+
+class Scene;
+
+/**
+ * Merges the static geometry of a scene into a few large meshes, to draw it in
+ * fewer draw calls.
+ *
+ * A node is static if its collision object is static or if it has the "static" tag.
+ * The mesh parts of static nodes are grouped by the URL of their material, their
+ * vertex layout and the cell of a grid they are in, and each group is baked in world
+ * space into the vertex and index buffers of a new node, named "staticBatch", at the
+ * root of the scene. The grid keeps each batch compact so it can still be culled.
+ * The static nodes keep their transforms and collision objects but lose their models.
+ *
+ * Only models loaded from a bundle are batched, since their vertex data is read back
+ * from the bundle: models with a skin, mesh LODs or a part that is not an indexed
+ * triangle list are left as they are, as are models with a material that was not
+ * loaded from a material file. Materials loaded from the same URL are assumed to be
+ * identical, so batching should happen right after the scene is loaded. SceneLoader
+ * does it when the scene file sets 'staticBatching = true', with the cell size set
+ * by 'staticBatchCellSize'. Scenes loaded with Bundle::loadScene can be batched by
+ * calling batch() directly.
+ *
+ * @script{ignore}
+ */
+class StaticBatcher
+{
+public:
+
+    /**
+     * Merges the static nodes of a scene into batches.
+     *
+     * @param scene The scene to batch.
+     * @param cellSize The size of the grid cells that split batches, in world units,
+     *      or 0 to batch each material into one mesh regardless of distance.
+     *
+     * @return The number of batches created.
+     */
+    static unsigned int batch(Scene* scene, float cellSize = 32.0f);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    StaticBatcher();
+};
+
+}
+
+#endif
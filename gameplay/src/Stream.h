@@ -155,6 +155,17 @@ public:
      */
     virtual bool rewind() = 0;
 
+    /**
+     * Returns a pointer to the contents of the stream, if they are directly accessible.
+     *
+     * Streams backed by memory, such as memory-mapped files, return a pointer to their
+     * first byte so that readers can use large blocks of data in place instead of
+     * copying them with read(). The pointer remains valid until the stream is closed.
+     *
+     * @return A pointer to the contents of the stream, or NULL if they are not directly accessible.
+     */
+    virtual const unsigned char* getData() { return NULL; }
+
 protected:
     Stream() {};
 private:
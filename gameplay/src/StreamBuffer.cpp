@@ -0,0 +1,224 @@
+#include "Base.h"
+#include "StreamBuffer.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "RenderStats.h"
+#include "Allocator.h"
+
+// Initial sizes of the stream buffers, in bytes.
+#define STREAM_BUFFER_VERTEX_SIZE       (4 * 1024 * 1024)
+#define STREAM_BUFFER_INDEX_SIZE        (1024 * 1024)
+
+// Persistently mapped buffers are fenced in this many segments, which lets the
+// GPU draw from the previous segments while the current one is written.
+#define STREAM_BUFFER_SEGMENT_COUNT     3
+
+namespace gameplay
+{
+
+struct StreamRing
+{
+    GLenum target;
+    GLuint buffer;
+    unsigned int size;
+    unsigned int offset;
+    unsigned char* mapped;
+#ifdef USE_MAPPED_BUFFERS
+    unsigned int segment;
+    GLsync fences[STREAM_BUFFER_SEGMENT_COUNT];
+#endif
+};
+
+static StreamRing __rings[2];
+static int __mode = -1;
+
+static StreamBuffer::Mode detectMode()
+{
+    if (__mode == -1)
+    {
+        __mode = StreamBuffer::ORPHAN;
+#ifdef USE_MAPPED_BUFFERS
+        // Mapped writes and their fences would be made on the game thread's context, not the one that draws.
+        if (glMapBufferRange && glUnmapBuffer && !RenderCommandList::isRecording())
+        {
+            __mode = StreamBuffer::MAP_UNSYNCHRONIZED;
+            if (glBufferStorage && glFenceSync && glClientWaitSync && glDeleteSync)
+                __mode = StreamBuffer::MAP_PERSISTENT;
+        }
+#endif
+    }
+    return (StreamBuffer::Mode)__mode;
+}
+
+static void destroyRing(StreamRing& ring)
+{
+    if (ring.buffer == 0)
+        return;
+
+    StateCache::bindBuffer(ring.target, ring.buffer);
+#ifdef USE_MAPPED_BUFFERS
+    if (ring.mapped)
+    {
+        GL_ASSERT( glUnmapBuffer(ring.target) );
+    }
+    for (unsigned int i = 0; i < STREAM_BUFFER_SEGMENT_COUNT; ++i)
+    {
+        if (ring.fences[i])
+        {
+            GL_ASSERT( glDeleteSync(ring.fences[i]) );
+        }
+    }
+#endif
+    StateCache::bindBuffer(ring.target, 0);
+    StateCache::deleteBuffers(1, &ring.buffer);
+    Allocator::untrack(Allocator::BUFFER, ring.size);
+    memset(&ring, 0, sizeof(StreamRing));
+}
+
+static bool createRing(StreamRing& ring, GLenum target, unsigned int size)
+{
+    memset(&ring, 0, sizeof(StreamRing));
+    ring.target = target;
+    ring.size = size;
+
+    GL_ASSERT( glGenBuffers(1, &ring.buffer) );
+    StateCache::bindBuffer(target, ring.buffer);
+#ifdef USE_MAPPED_BUFFERS
+    if (detectMode() == StreamBuffer::MAP_PERSISTENT)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GL_ASSERT( glBufferStorage(target, size, NULL, flags) );
+        ring.mapped = (unsigned char*)glMapBufferRange(target, 0, size, flags);
+        if (ring.mapped == NULL)
+        {
+            GP_ERROR("Failed to map stream buffer of %u bytes.", size);
+            StateCache::deleteBuffers(1, &ring.buffer);
+            ring.buffer = 0;
+            return false;
+        }
+    }
+    else
+#endif
+    {
+        GL_ASSERT( glBufferData(target, size, NULL, GL_STREAM_DRAW) );
+    }
+    Allocator::track(Allocator::BUFFER, size);
+    return true;
+}
+
+#ifdef USE_MAPPED_BUFFERS
+/**
+ * Makes the segments of a persistently mapped ring that the range [begin, end)
+ * touches available for writing, fencing each segment that writing moves past.
+ */
+static void enterSegments(StreamRing& ring, unsigned int begin, unsigned int end)
+{
+    const unsigned int segmentSize = ring.size / STREAM_BUFFER_SEGMENT_COUNT;
+    const unsigned int last = std::min((end - 1) / segmentSize, (unsigned int)STREAM_BUFFER_SEGMENT_COUNT - 1);
+    for (unsigned int segment = std::min(begin / segmentSize, last); segment <= last; ++segment)
+    {
+        if (segment == ring.segment)
+            continue;
+
+        // Everything written to the current segment has been drawn from by now.
+        if (ring.fences[ring.segment] == 0)
+            ring.fences[ring.segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring.segment = segment;
+
+        GLsync fence = ring.fences[segment];
+        if (fence)
+        {
+            GLenum result;
+            do
+            {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            GL_ASSERT( glDeleteSync(fence) );
+            ring.fences[segment] = 0;
+        }
+    }
+}
+#endif
+
+unsigned int StreamBuffer::upload(Type type, const void* data, unsigned int size, unsigned int alignment)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(size);
+    GP_ASSERT(alignment);
+
+    StreamRing& ring = __rings[type];
+    const GLenum target = type == VERTEX ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
+    const Mode mode = detectMode();
+
+    // Keep every upload within one segment, so that a wrap never waits on data of the current frame.
+    if (ring.buffer == 0 || size > ring.size / STREAM_BUFFER_SEGMENT_COUNT)
+    {
+        unsigned int ringSize = type == VERTEX ? STREAM_BUFFER_VERTEX_SIZE : STREAM_BUFFER_INDEX_SIZE;
+        while (size > ringSize / STREAM_BUFFER_SEGMENT_COUNT)
+            ringSize *= 2;
+        destroyRing(ring);
+        if (!createRing(ring, target, ringSize))
+            return 0;
+    }
+
+    StateCache::bindBuffer(target, ring.buffer);
+
+    unsigned int offset = (ring.offset + alignment - 1) / alignment * alignment;
+    bool wrap = offset + size > ring.size;
+    if (wrap)
+        offset = 0;
+
+    switch (mode)
+    {
+#ifdef USE_MAPPED_BUFFERS
+    case MAP_PERSISTENT:
+        enterSegments(ring, offset, offset + size);
+        memcpy(ring.mapped + offset, data, size);
+        break;
+    case MAP_UNSYNCHRONIZED:
+        {
+            // Writes never overlap data the GPU may still read until the buffer wraps,
+            // and then the whole buffer is invalidated, which the driver orphans.
+            GLbitfield access = GL_MAP_WRITE_BIT | (wrap ? GL_MAP_INVALIDATE_BUFFER_BIT : (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+            void* mapped = glMapBufferRange(target, offset, size, access);
+            if (mapped == NULL)
+            {
+                GP_ERROR("Failed to map %u bytes of stream buffer.", size);
+                return 0;
+            }
+            memcpy(mapped, data, size);
+            GL_ASSERT( glUnmapBuffer(target) );
+        }
+        break;
+#endif
+    default:
+        if (wrap)
+        {
+            RenderCommandList::bufferData(target, ring.size, NULL, GL_STREAM_DRAW);
+        }
+        RenderCommandList::bufferSubData(target, offset, size, data);
+        break;
+    }
+
+    ring.offset = offset + size;
+    RenderStats::addUpload(size);
+    return offset;
+}
+
+GLuint StreamBuffer::getBuffer(Type type)
+{
+    return __rings[type].buffer;
+}
+
+StreamBuffer::Mode StreamBuffer::getMode()
+{
+    return detectMode();
+}
+
+void StreamBuffer::finalize()
+{
+    destroyRing(__rings[VERTEX]);
+    destroyRing(__rings[INDEX]);
+}
+
+}
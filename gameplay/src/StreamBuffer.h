@@ -0,0 +1,98 @@
+#ifndef STREAMBUFFER_H_
+#define STREAMBUFFER_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines the ring buffers that stream dynamic vertex and index data to the GPU.
+ *
+ * Geometry that is rebuilt every frame, such as the contents of a MeshBatch, is
+ * appended to one buffer object per type that wraps around once it is full, so that
+ * uploads never wait for the GPU to finish drawing earlier data and never reallocate
+ * a buffer. How the data is written depends on the device:
+ *
+ * - With buffer storage (OpenGL 4.4 or GL_ARB_buffer_storage) the buffers stay
+ *   persistently mapped. They are split in segments, and a fence is placed whenever
+ *   writing moves past a segment, so that a segment is only overwritten once the GPU
+ *   is done with it.
+ * - With glMapBufferRange (OpenGL 3.0 or GL_ARB_map_buffer_range) each upload maps
+ *   its range unsynchronized, and the buffer is invalidated when it wraps around.
+ * - Elsewhere each upload is a glBufferSubData, and the buffer is orphaned with
+ *   glBufferData when it wraps around.
+ *
+ * A buffer grows, once, when a single upload does not fit in one of its segments.
+ *
+ * @script{ignore}
+ */
+class StreamBuffer
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the types of stream buffers.
+     */
+    enum Type
+    {
+        VERTEX,
+        INDEX
+    };
+
+    /**
+     * Defines how data is written to the stream buffers.
+     */
+    enum Mode
+    {
+        ORPHAN,
+        MAP_UNSYNCHRONIZED,
+        MAP_PERSISTENT
+    };
+
+    /**
+     * Copies data into the stream buffer of the given type.
+     *
+     * The buffer is left bound to GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER.
+     *
+     * @param type The type of the buffer.
+     * @param data The data to copy.
+     * @param size The size of the data, in bytes.
+     * @param alignment The alignment of the data in the buffer, in bytes.
+     *
+     * @return The offset of the data in the buffer, in bytes.
+     */
+    static unsigned int upload(Type type, const void* data, unsigned int size, unsigned int alignment = 4);
+
+    /**
+     * Gets the handle of the stream buffer of the given type.
+     *
+     * @param type The type of the buffer.
+     *
+     * @return The buffer object handle, or 0 if nothing was uploaded yet.
+     */
+    static GLuint getBuffer(Type type);
+
+    /**
+     * Gets how data is written to the stream buffers on this device.
+     *
+     * @return The streaming mode.
+     */
+    static Mode getMode();
+
+private:
+
+    /**
+     * Hidden constructor.
+     */
+    StreamBuffer();
+
+    /**
+     * Called during shutdown to delete the buffers.
+     */
+    static void finalize();
+};
+
+}
+
+#endif
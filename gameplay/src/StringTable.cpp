@@ -0,0 +1,123 @@
+#include "Base.h"
+#include "StringTable.h"
+
+// Number of slots allocated when the first string is interned.
+#define INITIAL_SLOT_COUNT 64
+
+namespace gameplay
+{
+
+StringTable::StringTable()
+{
+}
+
+StringTable::~StringTable()
+{
+    for (size_t i = 0, count = _strings.size(); i < count; ++i)
+    {
+        SAFE_DELETE_ARRAY(_strings[i]);
+    }
+}
+
+unsigned int StringTable::intern(const char* str)
+{
+    GP_ASSERT(str);
+
+    // Keep the table at most half full, so probe sequences stay short.
+    if ((_strings.size() + 1) * 2 > _slots.size())
+        grow();
+
+    unsigned int h = hash(str);
+    unsigned int slot = findSlot(str, h);
+    if (_slots[slot] != 0)
+        return _slots[slot] - 1;
+
+    size_t length = strlen(str);
+    char* copy = new char[length + 1];
+    memcpy(copy, str, length + 1);
+
+    unsigned int handle = (unsigned int)_strings.size();
+    _strings.push_back(copy);
+    _hashes.push_back(h);
+    _slots[slot] = handle + 1;
+    return handle;
+}
+
+unsigned int StringTable::find(const char* str) const
+{
+    GP_ASSERT(str);
+
+    if (_slots.empty())
+        return INVALID_HANDLE;
+
+    unsigned int slot = findSlot(str, hash(str));
+    return (_slots[slot] != 0 ? _slots[slot] - 1 : INVALID_HANDLE);
+}
+
+const char* StringTable::getString(unsigned int handle) const
+{
+    return (handle < _strings.size() ? _strings[handle] : NULL);
+}
+
+unsigned int StringTable::getCount() const
+{
+    return (unsigned int)_strings.size();
+}
+
+unsigned int StringTable::hash(const char* str)
+{
+    GP_ASSERT(str);
+
+    unsigned int h = HASH_SEED;
+    for (const unsigned char* p = (const unsigned char*)str; *p != '\0'; ++p)
+    {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+unsigned int StringTable::hash(const void* data, size_t size, unsigned int seed)
+{
+    GP_ASSERT(data || size == 0);
+
+    unsigned int h = seed;
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+unsigned int StringTable::findSlot(const char* str, unsigned int hash) const
+{
+    // Linear probing; the table always has an empty slot, so the search ends.
+    unsigned int mask = (unsigned int)_slots.size() - 1;
+    for (unsigned int slot = hash & mask; ; slot = (slot + 1) & mask)
+    {
+        unsigned int entry = _slots[slot];
+        if (entry == 0)
+            return slot;
+        if (_hashes[entry - 1] == hash && strcmp(_strings[entry - 1], str) == 0)
+            return slot;
+    }
+}
+
+void StringTable::grow()
+{
+    size_t slotCount = _slots.empty() ? INITIAL_SLOT_COUNT : _slots.size() * 2;
+    _slots.assign(slotCount, 0);
+
+    unsigned int mask = (unsigned int)slotCount - 1;
+    for (unsigned int handle = 0, count = (unsigned int)_strings.size(); handle < count; ++handle)
+    {
+        unsigned int slot = _hashes[handle] & mask;
+        while (_slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        _slots[slot] = handle + 1;
+    }
+}
+
+}
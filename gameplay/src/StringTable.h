@@ -0,0 +1,135 @@
+#ifndef STRINGTABLE_H_
+#define STRINGTABLE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a table of interned strings.
+ *
+ * Each distinct string added to the table is given a handle: the handles are
+ * dense indices starting at zero, in the order the strings were first added,
+ * and stay valid for the life of the table. Each string is copied once and the
+ * copy never moves, so the pointers returned by getString can be kept for the
+ * life of the table too. The strings are found through an open-addressed hash
+ * table, so interning or finding a string hashes it once and only compares it
+ * with the strings that have the same hash.
+ *
+ * The table also provides the string hash (FNV-1a) used throughout the engine
+ * for hashed lookups, so every hashed index hashes strings the same way.
+ *
+ * A table is not synchronized: strings must not be interned while other threads
+ * find strings in the same table.
+ *
+ * @script{ignore}
+ */
+class StringTable
+{
+public:
+
+    /**
+     * The handle returned when a string is not in the table.
+     */
+    static const unsigned int INVALID_HANDLE = 0xFFFFFFFF;
+
+    /**
+     * The initial value of a hash, before any data is hashed.
+     */
+    static const unsigned int HASH_SEED = 2166136261u;
+
+    /**
+     * Constructor.
+     */
+    StringTable();
+
+    /**
+     * Destructor.
+     */
+    ~StringTable();
+
+    /**
+     * Gets the handle of a string, adding the string to the table if it is not in it.
+     *
+     * @param str The string to intern.
+     *
+     * @return The handle of the string.
+     */
+    unsigned int intern(const char* str);
+
+    /**
+     * Finds the handle of a string without adding it to the table.
+     *
+     * @param str The string to find.
+     *
+     * @return The handle of the string, or INVALID_HANDLE if it is not in the table.
+     */
+    unsigned int find(const char* str) const;
+
+    /**
+     * Gets the string of a handle.
+     *
+     * @param handle The handle of the string.
+     *
+     * @return The string, or NULL if the handle is not in the table.
+     */
+    const char* getString(unsigned int handle) const;
+
+    /**
+     * Gets the number of strings in the table.
+     *
+     * @return The number of strings, which is also the next handle.
+     */
+    unsigned int getCount() const;
+
+    /**
+     * Hashes a null-terminated string.
+     *
+     * @param str The string to hash.
+     *
+     * @return The FNV-1a hash of the string.
+     */
+    static unsigned int hash(const char* str);
+
+    /**
+     * Hashes a block of data, continuing from a previous hash.
+     *
+     * Hashing two blocks one after the other gives the hash of their concatenation.
+     *
+     * @param data The data to hash.
+     * @param size The size of the data, in bytes.
+     * @param seed The hash of the preceding data, or HASH_SEED.
+     *
+     * @return The FNV-1a hash of the data.
+     */
+    static unsigned int hash(const void* data, size_t size, unsigned int seed = HASH_SEED);
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    StringTable(const StringTable& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    StringTable& operator=(const StringTable&);
+
+    /**
+     * Gets the slot of a string: the slot holding it, or the empty slot it would go in.
+     */
+    unsigned int findSlot(const char* str, unsigned int hash) const;
+
+    /**
+     * Doubles the number of slots and re-inserts the handles.
+     */
+    void grow();
+
+    std::vector<char*> _strings;            // The string of each handle.
+    std::vector<unsigned int> _hashes;      // The hash of each handle.
+    std::vector<unsigned int> _slots;       // Handle + 1 of the string in each slot, or 0 for empty slots (power of two in size).
+};
+
+}
+
+#endif
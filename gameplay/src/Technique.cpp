@@ -7,7 +7,7 @@ namespace gameplay
 {
 
 Technique::Technique(const char* id, Material* material)
-    : _id(id ? id : ""), _material(material)
+    : _id(id ? id : ""), _material(material), _lodDistance(0.0f), _lodScreenSize(0.0f)
 {
     RenderState::_parent = material;
 }
@@ -53,9 +53,32 @@ Pass* Technique::getPass(const char* id) const
     return NULL;
 }
 
+void Technique::setLod(float distance, float screenSize)
+{
+    _lodDistance = std::max(distance, 0.0f);
+    _lodScreenSize = std::max(screenSize, 0.0f);
+}
+
+float Technique::getLodDistance() const
+{
+    return _lodDistance;
+}
+
+float Technique::getLodScreenSize() const
+{
+    return _lodScreenSize;
+}
+
+bool Technique::isLodSelected(float distance, float screenSize) const
+{
+    return (_lodDistance > 0.0f && distance >= _lodDistance) || (_lodScreenSize > 0.0f && screenSize <= _lodScreenSize);
+}
+
 Technique* Technique::clone(Material* material, NodeCloneContext &context) const
 {
     Technique* technique = new Technique(getId(), material);
+    technique->_lodDistance = _lodDistance;
+    technique->_lodScreenSize = _lodScreenSize;
     for (std::vector<Pass*>::const_iterator it = _passes.begin(); it != _passes.end(); ++it)
     {
         Pass* pass = *it;
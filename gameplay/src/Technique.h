@@ -42,6 +42,47 @@ public:
      */
     Pass* getPass(const char* id) const;
 
+    /**
+     * Sets the thresholds at which Material::getLodTechnique selects this technique.
+     *
+     * The technique is selected for models farther from the camera than the distance, or
+     * whose bounding sphere covers less than the screen size (as a fraction of the viewport
+     * height, as for Model::addMeshLod). These can be set in a material file with
+     * 'lodDistance' and 'lodScreenSize' in the technique.
+     *
+     * @param distance The distance from the camera, or 0 to ignore the distance.
+     * @param screenSize The fraction of the viewport height, or 0 to ignore the screen size.
+     * @script{ignore}
+     */
+    void setLod(float distance, float screenSize);
+
+    /**
+     * Gets the distance beyond which this technique is selected.
+     *
+     * @return The distance, or 0 if the technique is not selected by distance.
+     * @script{ignore}
+     */
+    float getLodDistance() const;
+
+    /**
+     * Gets the screen size below which this technique is selected.
+     *
+     * @return The fraction of the viewport height, or 0 if the technique is not selected by screen size.
+     * @script{ignore}
+     */
+    float getLodScreenSize() const;
+
+    /**
+     * Determines if this technique is selected for the specified distance and screen size.
+     *
+     * @param distance The distance of the model from the camera.
+     * @param screenSize The fraction of the viewport height covered by the model.
+     *
+     * @return true if either threshold of the technique is passed.
+     * @script{ignore}
+     */
+    bool isLodSelected(float distance, float screenSize) const;
+
 private:
 
     /**
@@ -69,6 +110,8 @@ private:
     std::string _id;
     Material* _material;
     std::vector<Pass*> _passes;
+    float _lodDistance;
+    float _lodScreenSize;
 };
 
 }
@@ -1,8 +1,14 @@
 #include "Base.h"
 #include "Terrain.h"
 #include "TerrainPatch.h"
+#include "TerrainPager.h"
 #include "Node.h"
+#include "Scene.h"
 #include "FileSystem.h"
+#include "Image.h"
+#include "Bundle.h"
+#include "DebugMarkers.h"
+#include "Game.h"
 
 namespace gameplay
 {
@@ -25,13 +31,40 @@ namespace gameplay
 #define TERRAIN_DIRTY_INV_WORLD_MATRIX 2
 #define TERRAIN_DIRTY_NORMAL_MATRIX 4
 
+// The number of positions converted to heightfield coordinates at a time on the stack.
+#define TERRAIN_SAMPLE_CHUNK 256
+
+// The minimum number of positions sampled by one job.
+#define TERRAIN_SAMPLE_BATCH 1024
+
 /**
  * @script{ignore}
  */
 float getDefaultHeight(unsigned int width, unsigned int height);
 
+/**
+ * Parses the channel of a blend or density map, given as R, G, B, A or 0 to 3.
+ *
+ * @script{ignore}
+ */
+static int parseChannel(const char* channel)
+{
+    if (channel && strlen(channel) > 0)
+    {
+        char c = std::toupper(channel[0]);
+        if (c == 'G' || c == '1')
+            return 1;
+        else if (c == 'B' || c == '2')
+            return 2;
+        else if (c == 'A' || c == '3')
+            return 3;
+    }
+    return 0;
+}
+
 Terrain::Terrain() :
-    _heightfield(NULL), _node(NULL), _normalMap(NULL), _flags(FRUSTUM_CULLING | LEVEL_OF_DETAIL),
+    _heightfield(NULL), _pager(NULL), _node(NULL), _quadtree(NULL), _drawDistance(0.0f), _normalMap(NULL), _geomorphing(false),
+    _layerArray(NULL), _layerArrayEffects(NULL), _blankBlendMap(NULL), _arrayLayerCount(0), _flags(FRUSTUM_CULLING | LEVEL_OF_DETAIL),
     _dirtyFlags(TERRAIN_DIRTY_WORLD_MATRIX | TERRAIN_DIRTY_INV_WORLD_MATRIX | TERRAIN_DIRTY_NORMAL_MATRIX)
 {
 }
@@ -40,15 +73,30 @@ Terrain::~Terrain()
 {
     _listeners.clear();
 
+    for (size_t i = 0, count = _details.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_details[i]);
+    }
+
+    SAFE_DELETE(_quadtree);
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
     {
         SAFE_DELETE(_patches[i]);
     }
+    SAFE_DELETE(_pager);
+
+    for (size_t i = 0, count = _sharedLevels.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_sharedLevels[i]);
+    }
 
     if (_node)
         _node->removeListener(this);
 
     SAFE_RELEASE(_normalMap);
+    SAFE_RELEASE(_layerArray);
+    SAFE_RELEASE(_layerArrayEffects);
+    SAFE_RELEASE(_blankBlendMap);
     SAFE_RELEASE(_heightfield);
 }
 
@@ -69,6 +117,7 @@ Terrain* Terrain::create(const char* path, Properties* properties)
     Properties* pTerrain = NULL;
     bool externalProperties = (p != NULL);
     HeightField* heightfield = NULL;
+    TerrainPager* pager = NULL;
     Vector3 terrainSize;
     int patchSize = 0;
     int detailLevels = 1;
@@ -92,8 +141,29 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         }
 
         // Read heightmap info
+        Properties* pTiles = pTerrain->getNamespace("tiles", true);
         Properties* pHeightmap = pTerrain->getNamespace("heightmap", true);
-        if (pHeightmap)
+        if (pTiles)
+        {
+            // Paged terrains stream their heights from a tile file instead
+            std::string tiles;
+            if (!pTiles->getPath("path", &tiles))
+            {
+                GP_WARN("No 'path' property supplied in tiles section of terrain definition: %s", path);
+                if (!externalProperties)
+                    SAFE_DELETE(p);
+                return NULL;
+            }
+
+            pager = TerrainPager::create(tiles.c_str(), pTiles);
+            if (pager == NULL)
+            {
+                if (!externalProperties)
+                    SAFE_DELETE(p);
+                return NULL;
+            }
+        }
+        else if (pHeightmap)
         {
             // Read heightmap path
             std::string heightmap;
@@ -105,11 +175,19 @@ Terrain* Terrain::create(const char* path, Properties* properties)
                 return NULL;
             }
 
+            // Heights are stored as floats unless 16-bit heights are asked for
+            HeightField::Format format = HeightField::FORMAT_FLOAT;
+            const char* formatString = pHeightmap->getString("format");
+            if (formatString && strcmp(formatString, "SHORT") == 0)
+                format = HeightField::FORMAT_SHORT;
+            else if (formatString && strcmp(formatString, "FLOAT") != 0)
+                GP_WARN("Invalid heightmap 'format' ('%s') in terrain definition: %s", formatString, path);
+
             std::string ext = FileSystem::getExtension(heightmap.c_str());
             if (ext == ".PNG")
             {
                 // Read normalized height values from heightmap image
-                heightfield = HeightField::createFromImage(heightmap.c_str(), 0, 1);
+                heightfield = HeightField::createFromImage(heightmap.c_str(), 0, 1, format);
             }
             else if (ext == ".RAW" || ext == ".R16")
             {
@@ -124,7 +202,7 @@ Terrain* Terrain::create(const char* path, Properties* properties)
                 }
 
                 // Read normalized height values from RAW file
-                heightfield = HeightField::createFromRAW(heightmap.c_str(), (unsigned int)imageSize.x, (unsigned int)imageSize.y, 0, 1);
+                heightfield = HeightField::createFromRAW(heightmap.c_str(), (unsigned int)imageSize.x, (unsigned int)imageSize.y, 0, 1, format);
             }
             else
             {
@@ -200,7 +278,7 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         normalMap = pTerrain->getString("normalMap");
     }
 
-    if (heightfield == NULL)
+    if (heightfield == NULL && pager == NULL)
     {
         GP_WARN("Failed to read heightfield heights for terrain definition: %s", path);
         if (!externalProperties)
@@ -208,14 +286,16 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         return NULL;
     }
 
+    unsigned int columns = pager ? pager->_columns : heightfield->getColumnCount();
+    unsigned int rows = pager ? pager->_rows : heightfield->getRowCount();
     if (terrainSize.isZero())
     {
-        terrainSize.set(heightfield->getColumnCount(), getDefaultHeight(heightfield->getColumnCount(), heightfield->getRowCount()), heightfield->getRowCount());
+        terrainSize.set(columns, getDefaultHeight(columns, rows), rows);
     }
 
-    if (patchSize <= 0 || patchSize > (int)heightfield->getColumnCount() || patchSize > (int)heightfield->getRowCount())
+    if (patchSize <= 0 || patchSize > (int)columns || patchSize > (int)rows)
     {
-        patchSize = std::min(heightfield->getRowCount(), std::min(heightfield->getColumnCount(), (unsigned int)DEFAULT_TERRAIN_PATCH_SIZE));
+        patchSize = std::min(rows, std::min(columns, (unsigned int)DEFAULT_TERRAIN_PATCH_SIZE));
     }
 
     if (detailLevels <= 0)
@@ -225,10 +305,20 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         skirtScale = 0;
 
     // Compute terrain scale
-    Vector3 scale(terrainSize.x / (heightfield->getColumnCount()-1), terrainSize.y, terrainSize.z / (heightfield->getRowCount()-1));
+    Vector3 scale(terrainSize.x / (columns-1), terrainSize.y, terrainSize.z / (rows-1));
 
     // Create terrain
-    Terrain* terrain = create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, pTerrain);
+    Terrain* terrain;
+    if (pager)
+        terrain = create(pager, scale, skirtScale, pTerrain);
+    else
+        terrain = create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, pTerrain);
+
+    // Read 'drawDistance'
+    if (terrain && pTerrain && pTerrain->exists("drawDistance"))
+    {
+        terrain->_drawDistance = std::max(0.0f, pTerrain->getFloat("drawDistance"));
+    }
 
     if (!externalProperties)
         SAFE_DELETE(p);
@@ -252,6 +342,7 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
     Terrain* terrain = new Terrain();
     terrain->_heightfield = heightfield;
     terrain->_localScale = scale;
+    terrain->_geomorphing = properties && properties->getBool("geomorphing");
 
     // Store reference to bounding box (it is calculated and updated from TerrainPatch)
     BoundingBox& bounds = terrain->_boundingBox;
@@ -259,6 +350,14 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
     if (normalMapPath)
         terrain->_normalMap = Texture::Sampler::create(normalMapPath, true);
 
+    // Patches are built from float heights, so 16-bit heights are expanded for as long as the patches are built
+    float* heights = heightfield->getArray();
+    if (heights == NULL)
+    {
+        heights = new float[width * height];
+        heightfield->getHeights(heights);
+    }
+
     float halfWidth = (width - 1) * 0.5f;
     float halfHeight = (height - 1) * 0.5f;
     unsigned int maxStep = (unsigned int)std::pow(2.0, (double)(detailLevels-1));
@@ -277,7 +376,8 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
             x2 = std::min(x1 + patchSize, width-1);
 
             // Create this patch
-            TerrainPatch* patch = TerrainPatch::create(terrain, row, column, heightfield->getArray(), width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale);
+            TerrainPatch* patch = TerrainPatch::create(terrain, row, column, heights, width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale,
+                1.0f, terrain->_normalMap, NULL);
             terrain->_patches.push_back(patch);
 
             // Append the new patch's local bounds to the terrain local bounds
@@ -285,10 +385,44 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
         }
     }
 
+    // Row-major patches form a grid that the quadtree splits in halves
+    unsigned int rows = (height - 2) / patchSize + 1;
+    unsigned int columns = (width - 2) / patchSize + 1;
+    terrain->_quadtree = terrain->createQuadNode(0, 0, rows, columns, columns, patchSize, heights);
+
+    if (heights != heightfield->getArray())
+        SAFE_DELETE_ARRAY(heights);
+
+    terrain->loadLayers(properties);
+
+    return terrain;
+}
+
+void Terrain::loadLayers(Properties* properties)
+{
+    // Pack all layer textures up front, so patches never see a partial texture array
+    if (properties && properties->getBool("textureArray"))
+    {
+        std::vector<std::string> paths;
+        Properties* lp;
+        while ((lp = properties->getNextNamespace()) != NULL)
+        {
+            Properties* t = strcmp(lp->getNamespace(), "layer") == 0 ? lp->getNamespace("texture", true) : NULL;
+            std::string path;
+            if (t && t->getPath("path", &path) && std::find(paths.begin(), paths.end(), path) == paths.end())
+                paths.push_back(path);
+        }
+        properties->rewind();
+
+        if (!paths.empty() && !createLayerArray(paths))
+            GP_WARN("Failed to pack the terrain layers into a texture array; using separate layer textures.");
+    }
+
     // Read additional layer information from properties (if specified)
     if (properties)
     {
-        // Parse terrain layers
+        // Parse terrain layers, noting the blend maps that detail layers can take their density from
+        std::map<int, std::pair<std::string, int> > blendMaps;
         Properties* lp;
         int index = -1;
         while ((lp = properties->getNextNamespace()) != NULL)
@@ -329,19 +463,7 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
                     {
                         blendMapPtr = blendMap.c_str();
                     }
-                    const char* channel = b->getString("channel");
-                    if (channel && strlen(channel) > 0)
-                    {
-                        char c = std::toupper(channel[0]);
-                        if (c == 'R' || c == '0')
-                            blendChannel = 0;
-                        else if (c == 'G' || c == '1')
-                            blendChannel = 1;
-                        else if (c == 'B' || c == '2')
-                            blendChannel = 2;
-                        else if (c == 'A' || c == '3')
-                            blendChannel = 3;
-                    }
+                    blendChannel = parseChannel(b->getString("channel"));
                 }
 
                 // Get patch row/columns that this layer applies to.
@@ -350,17 +472,53 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigne
                 if (lp->exists("column"))
                     column = lp->getInt("column");
 
-                if (!terrain->setLayer(index, textureMapPtr, textureRepeat, blendMapPtr, blendChannel, row, column))
+                if (!setLayer(index, textureMapPtr, textureRepeat, blendMapPtr, blendChannel, row, column))
                 {
                     GP_WARN("Failed to load terrain layer: %s", textureMap.c_str());
                 }
+                else if (blendMapPtr && row == -1 && column == -1)
+                {
+                    blendMaps[index] = std::make_pair(blendMap, blendChannel);
+                }
             }
         }
+
+        // Parse detail layers once all layers are known
+        properties->rewind();
+        while ((lp = properties->getNextNamespace()) != NULL)
+        {
+            if (strcmp(lp->getNamespace(), "detail") == 0)
+                loadDetail(lp, blendMaps);
+        }
     }
 
     // Load materials for all patches
-    for (size_t i = 0, count = terrain->_patches.size(); i < count; ++i)
-        terrain->_patches[i]->updateMaterial();
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+        _patches[i]->updateMaterial();
+}
+
+Terrain* Terrain::create(TerrainPager* pager, const Vector3& scale, float skirtScale, Properties* properties)
+{
+    GP_ASSERT(pager);
+
+    // Create the terrain object
+    Terrain* terrain = new Terrain();
+    terrain->_pager = pager;
+    terrain->_localScale = scale;
+
+    // Load the coarsest tiles, the others are streamed in while drawing
+    if (!pager->initialize(terrain, skirtScale))
+    {
+        SAFE_RELEASE(terrain);
+        return NULL;
+    }
+
+    // Most tiles are not loaded yet, so the bounds span the full height range
+    float halfWidth = (pager->_columns - 1) * 0.5f * scale.x;
+    float halfHeight = (pager->_rows - 1) * 0.5f * scale.z;
+    terrain->_boundingBox.set(Vector3(-halfWidth, 0.0f, -halfHeight), Vector3(halfWidth, scale.y, halfHeight));
+
+    terrain->loadLayers(properties);
 
     return terrain;
 }
@@ -375,7 +533,7 @@ void Terrain::setNode(Node* node)
         _node = node;
 
         if (_node)
-            _node->addListener(this);
+            _node->addListener(this, 0, false);
 
         _dirtyFlags |= TERRAIN_DIRTY_WORLD_MATRIX | TERRAIN_DIRTY_INV_WORLD_MATRIX | TERRAIN_DIRTY_NORMAL_MATRIX;
     }
@@ -386,6 +544,10 @@ bool Terrain::setLayer(int index, const char* texturePath, const Vector2& textur
     if (!texturePath)
         return false;
 
+    // Paged terrains apply layers to every tile, including those that are not loaded yet
+    if (_pager)
+        return _pager->setLayer(index, texturePath, textureRepeat, blendPath, blendChannel);
+
     // Set layer on applicable patches
     bool result = true;
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
@@ -436,47 +598,271 @@ void Terrain::setFlag(Flags flag, bool on)
     if (flag == DEBUG_PATCHES && changed)
     {
         // Dirty all materials since they need to be updated to support debug drawing
-        for (size_t i = 0, count = _patches.size(); i < count; ++i)
-            _patches[i]->_materialDirty = true;
+        setMaterialsDirty();
     }
 }
 
-unsigned int Terrain::getPatchCount() const
+void Terrain::setMaterialsDirty()
 {
-    return _patches.size();
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+        _patches[i]->_materialDirty = true;
+    if (_pager)
+    {
+        for (size_t i = 0, count = _pager->_tiles.size(); i < count; ++i)
+        {
+            if (_pager->_tiles[i]->patch)
+                _pager->_tiles[i]->patch->_materialDirty = true;
+        }
+    }
 }
 
-unsigned int Terrain::getVisiblePatchCount() const
+bool Terrain::createLayerArray(const std::vector<std::string>& paths)
 {
-    unsigned int visibleCount = 0;
-    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    if (paths.empty())
+        return false;
+
+    // The layers are decoded in parallel.
+    std::vector<const char*> pathStrings(paths.size());
+    for (size_t i = 0, count = paths.size(); i < count; ++i)
+        pathStrings[i] = paths[i].c_str();
+    std::vector<Image*> images(paths.size());
+    unsigned int created = Image::createBatch(&pathStrings[0], (unsigned int)pathStrings.size(), &images[0], Texture::isPremultipliedAlpha());
+
+    Texture* texture = NULL;
+    if (created == images.size())
+        texture = Texture::createArray(&images[0], (unsigned int)images.size(), true);
+    for (size_t i = 0, count = images.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(images[i]);
+    }
+    if (texture == NULL)
+        return false;
+
+    SAFE_RELEASE(_layerArray);
+    _layerArray = Texture::Sampler::create(texture);
+    _layerArray->setWrapMode(Texture::REPEAT, Texture::REPEAT);
+    _layerArray->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    texture->release();
+    _layerArrayPaths = paths;
+
+    // Layers without a blend map are padded with a blend map that is never read
+    if (_blankBlendMap == NULL)
+    {
+        unsigned char white[4] = { 255, 255, 255, 255 };
+        Texture* blank = Texture::create(Texture::RGBA, 1, 1, white);
+        _blankBlendMap = Texture::Sampler::create(blank);
+        _blankBlendMap->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+        _blankBlendMap->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+        blank->release();
+    }
+
+    setMaterialsDirty();
+    return true;
+}
+
+int Terrain::getArrayLayer(const char* path)
+{
+    GP_ASSERT(path);
+
+    for (size_t i = 0, count = _layerArrayPaths.size(); i < count; ++i)
+    {
+        if (_layerArrayPaths[i] == path)
+            return (int)i;
+    }
+
+    // Layers added after creation grow the array, which is rebuilt from all of its textures
+    std::vector<std::string> paths(_layerArrayPaths);
+    paths.push_back(path);
+    if (!createLayerArray(paths))
     {
-        if (_patches[i]->isVisible())
-            ++visibleCount;
+        GP_WARN("Failed to add texture '%s' to the terrain texture array.", path);
+        return -1;
     }
-    return visibleCount;
+    return (int)paths.size() - 1;
+}
+
+unsigned int Terrain::getPatchCount() const
+{
+    return getPatches().size();
+}
+
+unsigned int Terrain::getVisiblePatchCount() const
+{
+    return getVisiblePatches().size();
 }
 
 unsigned int Terrain::getTriangleCount() const
 {
+    const std::vector<TerrainPatch*>& patches = getPatches();
     unsigned int triangleCount = 0;
-    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    for (size_t i = 0, count = patches.size(); i < count; ++i)
     {
-        triangleCount += _patches[i]->getTriangleCount();
+        triangleCount += patches[i]->getTriangleCount();
     }
     return triangleCount;
 }
 
 unsigned int Terrain::getVisibleTriangleCount() const
 {
+    const std::vector<TerrainPatch*>& patches = getVisiblePatches();
     unsigned int triangleCount = 0;
-    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    for (size_t i = 0, count = patches.size(); i < count; ++i)
     {
-        triangleCount += _patches[i]->getVisibleTriangleCount();
+        triangleCount += patches[i]->getVisibleTriangleCount();
     }
     return triangleCount;
 }
 
+const std::vector<TerrainPatch*>& Terrain::getPatches() const
+{
+    // Paged terrains report the tiles selected by the last draw
+    return _pager ? _pager->_drawPatches : _patches;
+}
+
+Terrain::QuadNode::QuadNode() :
+    minHeight(0.0f), maxHeight(0.0f), x1(0), z1(0), x2(0), z2(0), patch(NULL)
+{
+    memset(children, 0, sizeof(children));
+}
+
+Terrain::QuadNode::~QuadNode()
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        SAFE_DELETE(children[i]);
+    }
+}
+
+Terrain::QuadNode* Terrain::createQuadNode(unsigned int row1, unsigned int column1, unsigned int row2, unsigned int column2,
+                                           unsigned int columns, unsigned int patchSize, const float* heights)
+{
+    QuadNode* node = new QuadNode();
+    unsigned int width = _heightfield->getColumnCount();
+    unsigned int height = _heightfield->getRowCount();
+    node->x1 = column1 * patchSize;
+    node->z1 = row1 * patchSize;
+    node->x2 = std::min(column2 * patchSize, width - 1);
+    node->z2 = std::min(row2 * patchSize, height - 1);
+
+    if (row2 - row1 == 1 && column2 - column1 == 1)
+    {
+        node->patch = _patches[row1 * columns + column1];
+        node->bounds = node->patch->getBoundingBox(false);
+
+        // Leaves scan the heights of their patch, inner nodes merge the range of their children
+        node->minHeight = node->maxHeight = heights[node->z1 * width + node->x1];
+        for (unsigned int z = node->z1; z <= node->z2; ++z)
+        {
+            for (unsigned int x = node->x1; x <= node->x2; ++x)
+            {
+                float h = heights[z * width + x];
+                node->minHeight = std::min(node->minHeight, h);
+                node->maxHeight = std::max(node->maxHeight, h);
+            }
+        }
+        return node;
+    }
+
+    unsigned int rowSplit = row1 + (row2 - row1 + 1) / 2;
+    unsigned int columnSplit = column1 + (column2 - column1 + 1) / 2;
+    unsigned int rows[3] = { row1, rowSplit, row2 };
+    unsigned int cols[3] = { column1, columnSplit, column2 };
+    unsigned int childCount = 0;
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+            if (rows[i] == rows[i + 1] || cols[j] == cols[j + 1])
+                continue;
+
+            QuadNode* child = createQuadNode(rows[i], cols[j], rows[i + 1], cols[j + 1], columns, patchSize, heights);
+            if (childCount == 0)
+            {
+                node->bounds = child->bounds;
+                node->minHeight = child->minHeight;
+                node->maxHeight = child->maxHeight;
+            }
+            else
+            {
+                node->bounds.merge(child->bounds);
+                node->minHeight = std::min(node->minHeight, child->minHeight);
+                node->maxHeight = std::max(node->maxHeight, child->maxHeight);
+            }
+            node->children[childCount++] = child;
+        }
+    }
+    return node;
+}
+
+bool Terrain::isCulled(const BoundingBox& worldBounds, Camera* camera) const
+{
+    if ((_flags & FRUSTUM_CULLING) && !camera->getFrustum().intersects(worldBounds))
+        return true;
+
+    if (_drawDistance > 0.0f)
+    {
+        // Distance from the camera to the closest point of the bounds
+        Vector3 position = camera->getNode()->getTranslationWorld();
+        Vector3 closest(std::max(worldBounds.min.x, std::min(position.x, worldBounds.max.x)),
+                        std::max(worldBounds.min.y, std::min(position.y, worldBounds.max.y)),
+                        std::max(worldBounds.min.z, std::min(position.z, worldBounds.max.z)));
+        if (position.distanceSquared(closest) > _drawDistance * _drawDistance)
+            return true;
+    }
+
+    return false;
+}
+
+void Terrain::findVisiblePatches(const QuadNode* node, Camera* camera, std::vector<TerrainPatch*>* patches) const
+{
+    // Node bounds already include the local scale, like the patch bounds
+    BoundingBox bounds(node->bounds);
+    if (_node)
+        bounds.transform(_node->getWorldMatrix());
+    if (isCulled(bounds, camera))
+        return;
+
+    if (node->patch)
+    {
+        patches->push_back(node->patch);
+        return;
+    }
+    for (unsigned int i = 0; i < 4 && node->children[i]; ++i)
+    {
+        findVisiblePatches(node->children[i], camera, patches);
+    }
+}
+
+const std::vector<TerrainPatch*>& Terrain::getVisiblePatches() const
+{
+    _visiblePatches.clear();
+
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+    {
+        // Without a camera, patches are only visible when nothing is culled
+        if ((_flags & FRUSTUM_CULLING) == 0 && _drawDistance == 0.0f)
+            _visiblePatches = getPatches();
+        return _visiblePatches;
+    }
+
+    if (_quadtree)
+    {
+        findVisiblePatches(_quadtree, camera, &_visiblePatches);
+        return _visiblePatches;
+    }
+
+    // Paged terrains have selected their tiles already, which only need culling
+    const std::vector<TerrainPatch*>& patches = getPatches();
+    for (size_t i = 0, count = patches.size(); i < count; ++i)
+    {
+        if (!isCulled(patches[i]->getBoundingBox(true), camera))
+            _visiblePatches.push_back(patches[i]);
+    }
+    return _visiblePatches;
+}
+
 const BoundingBox& Terrain::getBoundingBox() const
 {
     return _boundingBox;
@@ -485,8 +871,8 @@ const BoundingBox& Terrain::getBoundingBox() const
 float Terrain::getHeight(float x, float z) const
 {
     // Calculate the correct x, z position relative to the heightfield data.
-    float cols = _heightfield->getColumnCount();
-    float rows = _heightfield->getRowCount();
+    float cols = _pager ? _pager->_columns : _heightfield->getColumnCount();
+    float rows = _pager ? _pager->_rows : _heightfield->getRowCount();
 
     GP_ASSERT(cols > 0);
     GP_ASSERT(rows > 0);
@@ -498,8 +884,33 @@ float Terrain::getHeight(float x, float z) const
     x = v.x + (cols - 1) * 0.5f;
     z = v.z + (rows - 1) * 0.5f;
 
-    // Get the unscaled height value from the HeightField
-    float height = _heightfield->getHeight(x, z);
+    // Get the unscaled height value from the HeightField, unless the quadtree
+    // reaches a flat node around the point first.
+    float height = 0.0f;
+    const QuadNode* node = _quadtree;
+    if (node)
+    {
+        float px = std::max(0.0f, std::min(x, cols - 1));
+        float pz = std::max(0.0f, std::min(z, rows - 1));
+        while (node && node->minHeight != node->maxHeight)
+        {
+            const QuadNode* parent = node;
+            node = NULL;
+            for (unsigned int i = 0; i < 4 && parent->children[i]; ++i)
+            {
+                const QuadNode* child = parent->children[i];
+                if (px >= child->x1 && px <= child->x2 && pz >= child->z1 && pz <= child->z2)
+                {
+                    node = child;
+                    break;
+                }
+            }
+        }
+    }
+    if (node)
+        height = node->minHeight;
+    else
+        height = _pager ? _pager->getHeight(x, z) : _heightfield->getHeight(x, z);
 
     // Now apply world scale (this includes local terrain scale) to the heightfield value
     Vector3 worldScale;
@@ -509,17 +920,246 @@ float Terrain::getHeight(float x, float z) const
     return height;
 }
 
+struct Terrain::Sampling
+{
+    const Terrain* terrain;
+    const Vector3* positions;
+    float* heights;
+    Vector3* normals;
+    const Matrix* inverseWorld;
+    const Matrix* normalMatrix;
+    float scaleY;
+    float cols;
+    float rows;
+};
+
+void Terrain::sampleHeights(const Vector3* positions, unsigned int count, float* heights, Vector3* normals, bool parallel) const
+{
+    GP_ASSERT(count == 0 || (positions && heights));
+
+    Sampling sampling;
+    sampling.terrain = this;
+    sampling.positions = positions;
+    sampling.heights = heights;
+    sampling.normals = normals;
+    sampling.cols = _pager ? _pager->_columns : _heightfield->getColumnCount();
+    sampling.rows = _pager ? _pager->_rows : _heightfield->getRowCount();
+
+    // The cached matrices are updated here, so the jobs only read them.
+    Vector3 worldScale;
+    getWorldMatrix().getScale(&worldScale);
+    sampling.scaleY = worldScale.y;
+    sampling.inverseWorld = &getInverseWorldMatrix();
+    sampling.normalMatrix = normals ? &getNormalMatrix() : NULL;
+
+    Game* game = parallel && _pager == NULL ? Game::getInstance() : NULL;
+    JobScheduler* scheduler = game ? game->getJobScheduler() : NULL;
+    if (scheduler && count > TERRAIN_SAMPLE_BATCH)
+        scheduler->parallelFor(count, sampleRange, &sampling, TERRAIN_SAMPLE_BATCH);
+    else
+        sampleRange(0, count, &sampling);
+}
+
+void Terrain::sampleRange(unsigned int start, unsigned int end, void* cookie)
+{
+    const Sampling* sampling = (const Sampling*)cookie;
+    const Terrain* terrain = sampling->terrain;
+    const float* m = sampling->inverseWorld->m;
+    const float offsetX = (sampling->cols - 1) * 0.5f;
+    const float offsetZ = (sampling->rows - 1) * 0.5f;
+    float* heights = sampling->heights;
+    Vector3* normals = sampling->normals;
+
+    // The positions are transformed to heightfield coordinates as getHeight does.
+    Vector2 points[TERRAIN_SAMPLE_CHUNK];
+    for (unsigned int first = start; first < end; first += TERRAIN_SAMPLE_CHUNK)
+    {
+        unsigned int count = std::min(end - first, (unsigned int)TERRAIN_SAMPLE_CHUNK);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const Vector3& p = sampling->positions[first + i];
+            points[i].set(m[0] * p.x + m[8] * p.z + offsetX, m[2] * p.x + m[10] * p.z + offsetZ);
+        }
+
+        if (terrain->_pager)
+        {
+            // Normals of paged terrains come from central differences of the loaded heights.
+            const TerrainPager* pager = terrain->_pager;
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                float x = points[i].x;
+                float z = points[i].y;
+                heights[first + i] = pager->getHeight(x, z);
+                if (normals)
+                {
+                    float dx = (pager->getHeight(x + 1.0f, z) - pager->getHeight(x - 1.0f, z)) * 0.5f;
+                    float dz = (pager->getHeight(x, z + 1.0f) - pager->getHeight(x, z - 1.0f)) * 0.5f;
+                    normals[first + i].set(-dx, 1.0f, -dz);
+                }
+            }
+        }
+        else
+        {
+            terrain->_heightfield->sampleHeights(points, count, heights + first, normals ? normals + first : NULL);
+        }
+
+        for (unsigned int i = first; i < first + count; ++i)
+            heights[i] *= sampling->scaleY;
+
+        if (normals)
+        {
+            for (unsigned int i = first; i < first + count; ++i)
+            {
+                sampling->normalMatrix->transformVector(&normals[i]);
+                normals[i].normalize();
+            }
+        }
+    }
+}
+
 void Terrain::draw(bool wireframe)
 {
-    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    if (_pager)
+        _pager->update();
+
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+        return;
+
+    DebugMarkers::Group marker("Terrain", _node ? _node->getId() : NULL);
+
+    // Patches that pass the quadtree culling are not culled again
+    const std::vector<TerrainPatch*>& patches = getVisiblePatches();
+    for (size_t i = 0, count = patches.size(); i < count; ++i)
+    {
+        TerrainPatch* patch = patches[i];
+        patch->draw(camera, patch->getBoundingBox(true), wireframe);
+    }
+
+    // Detail layers are drawn over the visible patches near the camera
+    for (size_t i = 0, count = _details.size(); i < count; ++i)
+        _details[i]->draw(camera, patches);
+}
+
+TerrainDetail* Terrain::addDetail(Mesh* mesh, unsigned int capacity)
+{
+    GP_ASSERT(mesh);
+
+    if (_pager)
     {
-        _patches[i]->draw(wireframe);
+        GP_WARN("Paged terrains do not support detail layers.");
+        return NULL;
     }
+
+    TerrainDetail* detail = TerrainDetail::create(this, mesh, capacity);
+    if (detail)
+        _details.push_back(detail);
+    return detail;
+}
+
+void Terrain::removeDetail(TerrainDetail* detail)
+{
+    std::vector<TerrainDetail*>::iterator itr = std::find(_details.begin(), _details.end(), detail);
+    if (itr != _details.end())
+    {
+        _details.erase(itr);
+        detail->release();
+    }
+}
+
+unsigned int Terrain::getDetailCount() const
+{
+    return (unsigned int)_details.size();
+}
+
+TerrainDetail* Terrain::getDetail(unsigned int index) const
+{
+    GP_ASSERT(index < _details.size());
+
+    return _details[index];
+}
+
+void Terrain::loadDetail(Properties* properties, const std::map<int, std::pair<std::string, int> >& blendMaps)
+{
+    GP_ASSERT(properties);
+
+    // Parse the mesh URL (formatted as 'bundle#id')
+    const char* url = properties->getString("mesh");
+    std::string urlstring(url ? url : "");
+    size_t pos = urlstring.find('#');
+    if (pos == std::string::npos)
+    {
+        GP_WARN("Invalid or missing 'mesh' URL ('%s') in terrain detail definition (must be of the form 'bundle#id').", urlstring.c_str());
+        return;
+    }
+    Bundle* bundle = Bundle::create(urlstring.substr(0, pos).c_str());
+    Mesh* mesh = bundle ? bundle->loadMesh(urlstring.substr(pos + 1).c_str()) : NULL;
+    SAFE_RELEASE(bundle);
+    if (mesh == NULL)
+    {
+        GP_WARN("Failed to load the mesh of a terrain detail layer: %s", urlstring.c_str());
+        return;
+    }
+
+    unsigned int capacity = 65536;
+    if (properties->exists("capacity"))
+        capacity = (unsigned int)std::max(1, properties->getInt("capacity"));
+    TerrainDetail* detail = addDetail(mesh, capacity);
+    SAFE_RELEASE(mesh);
+    if (detail == NULL)
+        return;
+
+    // Material: either a material file or the default material with a texture
+    std::string path;
+    if (properties->getPath("material", &path))
+    {
+        Material* material = Material::create(path.c_str());
+        if (material)
+        {
+            detail->setMaterial(material);
+            SAFE_RELEASE(material);
+        }
+        else
+        {
+            GP_WARN("Failed to load the material of a terrain detail layer: %s", path.c_str());
+        }
+    }
+    else if (properties->getPath("texture", &path))
+    {
+        detail->getMaterial()->getParameter("u_diffuseTexture")->setValue(path.c_str(), true);
+    }
+
+    // Density: the blend map of a layer or a density map of its own
+    if (properties->exists("layer"))
+    {
+        std::map<int, std::pair<std::string, int> >::const_iterator itr = blendMaps.find(properties->getInt("layer"));
+        if (itr != blendMaps.end())
+            detail->setDensityMap(itr->second.first.c_str(), itr->second.second);
+        else
+            GP_WARN("Terrain detail layer refers to layer %d, which has no blend map covering the terrain.", properties->getInt("layer"));
+    }
+    else if (properties->getPath("density", &path))
+    {
+        detail->setDensityMap(path.c_str(), parseChannel(properties->getString("channel")));
+    }
+
+    if (properties->exists("spacing"))
+        detail->setSpacing(std::max(0.01f, properties->getFloat("spacing")));
+    Vector2 range;
+    if (properties->getVector2("scale", &range))
+        detail->setScaleRange(range.x, range.y);
+    if (properties->getVector2("distance", &range))
+        detail->setDistance(range.x, range.y);
 }
 
 void Terrain::transformChanged(Transform* transform, long cookie)
 {
     _dirtyFlags |= TERRAIN_DIRTY_WORLD_MATRIX | TERRAIN_DIRTY_INV_WORLD_MATRIX | TERRAIN_DIRTY_NORMAL_MATRIX;
+
+    // Detail instances are generated in world space
+    for (size_t i = 0, count = _details.size(); i < count; ++i)
+        _details[i]->clearInstances();
 }
 
 void Terrain::addListener(Terrain::Listener* listener)
@@ -527,13 +1167,23 @@ void Terrain::addListener(Terrain::Listener* listener)
     _listeners.push_back(listener);
 
     // Fire initial events in case this listener may have missed them
-    for (size_t i = 0, patchCount = _patches.size(); i < patchCount; ++i)
+    std::vector<TerrainPatch*> patches(_patches);
+    if (_pager)
     {
-        TerrainPatch* patch = _patches[i];
-        for (size_t j = 0, levelCount = patch->_levels.size(); j < levelCount; ++j)
+        for (size_t i = 0, count = _pager->_tiles.size(); i < count; ++i)
+        {
+            if (_pager->_tiles[i]->patch)
+                patches.push_back(_pager->_tiles[i]->patch);
+        }
+    }
+    for (size_t i = 0, patchCount = patches.size(); i < patchCount; ++i)
+    {
+        TerrainPatch* patch = patches[i];
+        size_t modelCount = patch->_morphModel ? 1 : patch->_levels.size();
+        for (size_t j = 0; j < modelCount; ++j)
         {
-            TerrainPatch::Level* level = patch->_levels[j];
-            Material* material = level->model ? level->model->getMaterial() : NULL;
+            Model* model = patch->_morphModel ? patch->_morphModel : patch->_levels[j]->model;
+            Material* material = model ? model->getMaterial() : NULL;
             if (material)
             {
                 // Fire materialUpdated event for materials that are already active
@@ -7,12 +7,15 @@
 #include "Texture.h"
 #include "BoundingBox.h"
 #include "TerrainPatch.h"
+#include "TerrainDetail.h"
+#include "EffectPermutations.h"
 
 namespace gameplay
 {
 
 class Node;
 class TerrainPatch;
+class TerrainPager;
 
 /**
  * Defines a Terrain that is capable of rendering large landscapes from 2D heightmap images.
@@ -32,7 +35,10 @@ class TerrainPatch;
  * PhysicsCollisionShape::heightfield(), which will utilize the internal height array of the
  * terrain to define the collision shape. Define a collision object in this way will allow
  * the terrain to automatically interact with other rigid bodies, characters and vehicles in
- * the scene.
+ * the scene. The collision shape reads the heights of the terrain in place rather than
+ * copying them. Setting "format = SHORT" in the heightmap block of the terrain properties
+ * file stores the heights as 16-bit values, which halves their memory; RAW8 and RAW16
+ * heightmaps keep their full precision.
  *
  * Surface detail is provided via texture splatting, where multiple texture layers can be added
  * along with blend maps to define how different layers blend with each other. These layers
@@ -57,6 +63,11 @@ class TerrainPatch;
  * via the patchSize property. Patches can be previewed by enabling the DEBUG_PATCHES flag
  * via the setFlag method. Other terrain behavior can also be enabled and disabled using terrain
  * flags.
+ *
+ * The patches are kept in a quadtree whose nodes store the bounds and the height range of the
+ * patches below them. Culling walks the quadtree, so a node outside of the view frustum, or farther
+ * from the camera than the optional drawDistance property, rejects all of its patches with a single
+ * test. Height queries stop at the first node that is entirely flat.
  * 
  * Level of detail (LOD) is supported using a technique that is similar to texture mipmapping.
  * A distance-to-camera based test, using a simple screen-space error metric is used to decide
@@ -76,11 +87,80 @@ class TerrainPatch;
  * zero extra CPU time or draw calls, which are often needed for more complex stitching 
  * approaches. In practice, the skirts are often not noticable at all unless the LOD variation
  * is very large and the terrain is excessively hilly on the edge of a LOD transition.
+ *
+ * LOD transitions can also be smoothed by setting "geomorphing = true" in the terrain
+ * properties file. Each patch then keeps a single vertex buffer at full resolution and
+ * draws every LOD level with index buffers that are shared by all patches of the same
+ * size. The vertex shader gradually moves the vertices that are dropped by the next level
+ * onto its surface as the patch approaches that level, so patches no longer pop when their
+ * LOD changes. This uses more vertex memory, since coarse levels keep the vertices they
+ * skip, and the skirts still fill the cracks between patches.
+ *
+ * Setting "textureArray = true" in the terrain properties file packs the layer textures of
+ * all patches into a single texture array, on platforms that support texture arrays (see
+ * USE_TEXTURE_ARRAYS). Layer selection, texture repeats and blend channels are then passed
+ * to the shader as uniforms instead of preprocessor definitions, so every patch of the
+ * terrain uses the same effect and samples the same layer texture, regardless of which
+ * layers it has. All layer textures must then have the same size and format. When texture
+ * arrays are not available, each patch keeps separate samplers for its layers.
+ *
+ * Terrains too large to keep in memory can be paged. gameplay-encoder splits a heightmap,
+ * along with its normals and an optional blend map, into a file of tiles (see the -tiles
+ * encoder option), which the terrain definition references instead of a heightmap:
+ *
+ * @verbatim
+    terrain
+    {
+        tiles
+        {
+            path = res/world.tiles
+            budget = 64             // Memory for loaded tiles, in megabytes.
+            detail = 2              // Tiles closer than this many times their size are refined.
+            uploadsPerFrame = 2     // Maximum number of tiles turned into patches per frame.
+        }
+        size = 4096, 600, 4096
+        skirtScale = 0.02
+    }
+   @endverbatim
+ *
+ * The tiles form a quadtree: each level halves the resolution of the one below it. The
+ * coarsest level is loaded with the terrain, finer tiles are read by the job scheduler as
+ * the camera approaches and a coarse tile keeps being drawn until all of its children are
+ * loaded. Tiles are unloaded, least recently used first, when the budget is exceeded. In a
+ * paged terrain, layer texture repeats count the repeats across one tile of the finest level,
+ * layers without a blend map use the blend map of the tile, and patch size, detail levels,
+ * geomorphing, heightfield collision shapes and detail layers are not supported.
+ *
+ * Grass, flowers, rocks and other small objects are scattered over a terrain by detail layers
+ * (see TerrainDetail), which draw every instance of a mesh near the camera with one instanced
+ * draw call. A detail layer usually takes its density from the blend map of a terrain layer:
+ *
+ * @verbatim
+    terrain
+    {
+        ...
+        detail
+        {
+            mesh = res/grass.gpb#grass      // The mesh of the instances, as 'bundle#id'.
+            texture = res/grass.png         // The texture of the default material.
+            material = res/grass.material   // A material to use instead of the default one.
+            layer = 1                       // Place instances where the blend map of layer 1 is painted,
+            density = res/flowers.png       // or where this density map is (instances go everywhere otherwise).
+            channel = R                     // The channel of the density map.
+            spacing = 0.5                   // Distance between the grid points instances are placed on.
+            scale = 0.8, 1.2                // Range of the random scale of the instances.
+            distance = 40, 80               // Distances the instances thin out between.
+            capacity = 65536                // Maximum number of instances drawn per frame.
+        }
+    }
+   @endverbatim
  */
 class Terrain : public Ref, public Transform::Listener
 {
     friend class Node;
     friend class TerrainPatch;
+    friend class TerrainPager;
+    friend class TerrainDetail;
     friend class PhysicsController;
     friend class PhysicsRigidBody;
 
@@ -307,6 +387,24 @@ public:
      */
     float getHeight(float x, float z) const;
 
+    /**
+     * Returns the world-space heights and normals of the terrain at many positions at once.
+     *
+     * Each height is the one getHeight returns for the X and Z coordinates of the position;
+     * the Y coordinates are ignored. The normals are those of the interpolated surface, in world
+     * space. Terrains loaded from a heightfield interpolate four positions at a time where SIMD
+     * instructions are available; paged terrains sample each position from their loaded tiles.
+     *
+     * @param positions The positions, in world space.
+     * @param count The number of positions.
+     * @param heights The array receiving the height at each position.
+     * @param normals The array receiving the normal at each position, or NULL.
+     * @param parallel True to split large batches over the worker threads of the job scheduler.
+     *      Paged terrains always sample on the calling thread.
+     * @script{ignore}
+     */
+    void sampleHeights(const Vector3* positions, unsigned int count, float* heights, Vector3* normals = NULL, bool parallel = false) const;
+
     /**
      * Draws the terrain.
      *
@@ -314,6 +412,43 @@ public:
      */
     void draw(bool wireframe = false);
 
+    /**
+     * Adds a detail layer of instances of a mesh scattered over the terrain.
+     *
+     * @param mesh The mesh of the instances.
+     * @param capacity The maximum number of instances drawn per frame.
+     *
+     * @return The detail layer, owned by the terrain, or NULL if it could not be created or the terrain is paged.
+     * @script{ignore}
+     */
+    TerrainDetail* addDetail(Mesh* mesh, unsigned int capacity = 65536);
+
+    /**
+     * Removes a detail layer from the terrain.
+     *
+     * @param detail The detail layer.
+     * @script{ignore}
+     */
+    void removeDetail(TerrainDetail* detail);
+
+    /**
+     * Returns the number of detail layers of the terrain.
+     *
+     * @return The detail layer count.
+     * @script{ignore}
+     */
+    unsigned int getDetailCount() const;
+
+    /**
+     * Returns a detail layer of the terrain.
+     *
+     * @param index The index of the detail layer.
+     *
+     * @return The detail layer.
+     * @script{ignore}
+     */
+    TerrainDetail* getDetail(unsigned int index) const;
+
     /**
      * @see Transform::Listener::transformChanged.
      *
@@ -394,26 +529,127 @@ private:
      */
     ~Terrain();
 
+    /**
+     * The positions, results and transforms of a batch of height queries.
+     */
+    struct Sampling;
+
+    /**
+     * Samples the heights and normals of a range of the positions of a batch.
+     */
+    static void sampleRange(unsigned int start, unsigned int end, void* cookie);
+
     /**
      * Internal method for creating terrain.
      */
     static Terrain* create(HeightField* heightfield, const Vector3& scale, unsigned int patchSize, unsigned int detailLevels, float skirtScale, const char* normalMapPath, Properties* properties);
 
+    /**
+     * A node of the quadtree over the terrain patches.
+     */
+    struct QuadNode
+    {
+        QuadNode();
+        ~QuadNode();
+
+        BoundingBox bounds;     // Local bounds of the patches below the node, including skirts.
+        float minHeight;        // Lowest heightfield value below the node.
+        float maxHeight;        // Highest heightfield value below the node.
+        unsigned int x1, z1, x2, z2;
+        TerrainPatch* patch;    // The patch of a leaf node, or NULL.
+        QuadNode* children[4];
+    };
+
     /**
      * Internal method for creating terrain.
      */
     static Terrain* create(const char* path, Properties* properties);
 
+    /**
+     * Internal method for creating a paged terrain.
+     */
+    static Terrain* create(TerrainPager* pager, const Vector3& scale, float skirtScale, Properties* properties);
+
+    /**
+     * Reads the layers of a terrain definition and loads the patch materials.
+     */
+    void loadLayers(Properties* properties);
+
+    /**
+     * Reads a detail layer of a terrain definition.
+     *
+     * @param properties The detail namespace.
+     * @param blendMaps The blend map path and channel of each layer covering the whole terrain, by layer index.
+     */
+    void loadDetail(Properties* properties, const std::map<int, std::pair<std::string, int> >& blendMaps);
+
+    /**
+     * Returns the patches that make up the terrain, or the tiles last drawn for a paged terrain.
+     */
+    const std::vector<TerrainPatch*>& getPatches() const;
+
+    /**
+     * Marks the materials of all patches, including loaded tiles of a paged terrain, for rebuilding.
+     */
+    void setMaterialsDirty();
+
+    /**
+     * Packs the layer textures into the texture array of the terrain.
+     *
+     * @return True if the texture array was created.
+     */
+    bool createLayerArray(const std::vector<std::string>& paths);
+
+    /**
+     * Returns the layer of the texture array holding a texture, adding the texture if needed.
+     *
+     * @return The layer, or -1 if the texture could not be added.
+     */
+    int getArrayLayer(const char* path);
+
+    /**
+     * Builds the quadtree node for a range of patch rows and columns, from the float heights of the heightfield.
+     */
+    QuadNode* createQuadNode(unsigned int row1, unsigned int column1, unsigned int row2, unsigned int column2,
+                             unsigned int columns, unsigned int patchSize, const float* heights);
+
+    /**
+     * Returns whether world-space bounds are culled by the frustum or draw distance of a camera.
+     */
+    bool isCulled(const BoundingBox& worldBounds, Camera* camera) const;
+
+    /**
+     * Appends the patches below a quadtree node that are visible to a camera.
+     */
+    void findVisiblePatches(const QuadNode* node, Camera* camera, std::vector<TerrainPatch*>* patches) const;
+
+    /**
+     * Returns the patches that are visible to the active camera of the scene.
+     */
+    const std::vector<TerrainPatch*>& getVisiblePatches() const;
+
     /**
      * Sets the node that the terrain is attached to.
      */
     void setNode(Node* node);
 
     HeightField* _heightfield;
+    TerrainPager* _pager;
     Node* _node;
     std::vector<TerrainPatch*> _patches;
+    QuadNode* _quadtree;
+    mutable std::vector<TerrainPatch*> _visiblePatches;
+    float _drawDistance;
     Vector3 _localScale;
     Texture::Sampler* _normalMap;
+    bool _geomorphing;
+    Texture::Sampler* _layerArray;
+    std::vector<std::string> _layerArrayPaths;
+    EffectPermutations* _layerArrayEffects;
+    Texture::Sampler* _blankBlendMap;
+    unsigned int _arrayLayerCount;
+    std::vector<TerrainPatch::SharedLevel*> _sharedLevels;
+    std::vector<TerrainDetail*> _details;
     unsigned int _flags;
     mutable Matrix _worldMatrix;
     mutable Matrix _inverseWorldMatrix;
@@ -0,0 +1,405 @@
+#include "Base.h"
+#include "TerrainDetail.h"
+#include "Terrain.h"
+#include "TerrainPatch.h"
+#include "InstanceBuffer.h"
+#include "Image.h"
+#include "Model.h"
+#include "Material.h"
+#include "Camera.h"
+#include "Game.h"
+
+// Floats of an instance: its world matrix, then its rank and three unused floats.
+#define INSTANCE_FLOATS 20
+
+// Generated patches farther than this many times the draw distance drop their instances.
+#define TERRAIN_DETAIL_DROP_DISTANCE 1.5f
+
+namespace gameplay
+{
+
+/**
+ * Returns a random number for a value, the same every time.
+ *
+ * @script{ignore}
+ */
+static unsigned int hashValue(unsigned int value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352d;
+    value ^= value >> 15;
+    value *= 0x846ca68b;
+    value ^= value >> 16;
+    return value;
+}
+
+/**
+ * Advances a random sequence and returns its next number, between 0 and 1.
+ *
+ * @script{ignore}
+ */
+static float nextRandom(unsigned int* state)
+{
+    *state = hashValue(*state + 0x9e3779b9);
+    return (*state >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * Returns the distance from a point to a box, or 0 if the point is inside it.
+ *
+ * @script{ignore}
+ */
+static float distanceToBox(const BoundingBox& box, const Vector3& point)
+{
+    Vector3 d(std::max(0.0f, std::max(box.min.x - point.x, point.x - box.max.x)),
+              std::max(0.0f, std::max(box.min.y - point.y, point.y - box.max.y)),
+              std::max(0.0f, std::max(box.min.z - point.z, point.z - box.max.z)));
+    return d.length();
+}
+
+TerrainDetail::PatchInstances::PatchInstances()
+    : generated(false), count(0)
+{
+}
+
+bool TerrainDetail::VisiblePatch::operator<(const VisiblePatch& other) const
+{
+    return distance < other.distance;
+}
+
+TerrainDetail::TerrainDetail()
+    : _terrain(NULL), _model(NULL), _instances(NULL), _densityMap(NULL), _densityChannel(0), _spacing(1.0f),
+    _scaleRange(1.0f, 1.0f), _distance(50.0f, 100.0f), _generatePerFrame(4), _drawnCount(0)
+{
+}
+
+TerrainDetail::~TerrainDetail()
+{
+    SAFE_RELEASE(_densityMap);
+    SAFE_RELEASE(_instances);
+    SAFE_RELEASE(_model);
+}
+
+TerrainDetail* TerrainDetail::create(Terrain* terrain, Mesh* mesh, unsigned int capacity)
+{
+    GP_ASSERT(terrain);
+    GP_ASSERT(mesh);
+
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::INSTANCE_MATRIX, 16),
+        VertexFormat::Element(VertexFormat::INSTANCE_DATA, 4)
+    };
+    InstanceBuffer* instances = InstanceBuffer::create(VertexFormat(elements, 2), capacity, true);
+    if (instances == NULL)
+    {
+        GP_ERROR("Failed to create the instance buffer of a terrain detail layer.");
+        return NULL;
+    }
+
+    Model* model = Model::create(mesh);
+    Material* material = model->setMaterial("res/shaders/terrain-detail.vert", "res/shaders/crowd.frag", "INSTANCED;TEXTURE_DISCARD_ALPHA");
+    if (material == NULL)
+    {
+        GP_ERROR("Failed to create the material of a terrain detail layer.");
+        SAFE_RELEASE(model);
+        SAFE_RELEASE(instances);
+        return NULL;
+    }
+    material->getStateBlock()->setCullFace(false);
+    material->getStateBlock()->setDepthTest(true);
+    material->getStateBlock()->setDepthWrite(true);
+    material->getParameter("u_ambientColor")->setValue(Vector3(0.2f, 0.2f, 0.2f));
+    material->getParameter("u_lightColor")->setValue(Vector3::one());
+    material->getParameter("u_lightDirection")->setValue(Vector3(0.0f, -1.0f, 0.0f));
+
+    TerrainDetail* detail = new TerrainDetail();
+    detail->_terrain = terrain;
+    detail->_model = model;
+    detail->_instances = instances;
+    detail->_patches.resize(terrain->_patches.size());
+    for (size_t i = 0, count = terrain->_patches.size(); i < count; ++i)
+        detail->_patchIndices[terrain->_patches[i]] = (unsigned int)i;
+    detail->_upload.resize(capacity * INSTANCE_FLOATS);
+    return detail;
+}
+
+Terrain* TerrainDetail::getTerrain() const
+{
+    return _terrain;
+}
+
+Material* TerrainDetail::getMaterial() const
+{
+    return _model->getMaterial();
+}
+
+void TerrainDetail::setMaterial(Material* material)
+{
+    GP_ASSERT(material);
+
+    _model->setMaterial(material);
+}
+
+unsigned int TerrainDetail::getCapacity() const
+{
+    return _instances->getCapacity();
+}
+
+bool TerrainDetail::setDensityMap(const char* path, int channel)
+{
+    SAFE_RELEASE(_densityMap);
+    _densityChannel = 0;
+    if (path == NULL)
+        return true;
+
+    _densityMap = Image::create(path);
+    if (_densityMap == NULL)
+    {
+        GP_WARN("Failed to load the density map of a terrain detail layer: %s", path);
+        return false;
+    }
+
+    unsigned int pixelSize = _densityMap->getFormat() == Image::RGBA ? 4 : 3;
+    if (channel < 0 || channel >= (int)pixelSize)
+    {
+        GP_WARN("Invalid channel (%d) for the density map of a terrain detail layer: %s", channel, path);
+        channel = 0;
+    }
+    _densityChannel = channel;
+    return true;
+}
+
+float TerrainDetail::getSpacing() const
+{
+    return _spacing;
+}
+
+void TerrainDetail::setSpacing(float spacing)
+{
+    GP_ASSERT(spacing > 0.0f);
+
+    _spacing = spacing;
+}
+
+void TerrainDetail::setScaleRange(float scaleMin, float scaleMax)
+{
+    _scaleRange.set(std::min(scaleMin, scaleMax), std::max(scaleMin, scaleMax));
+}
+
+const Vector2& TerrainDetail::getDistance() const
+{
+    return _distance;
+}
+
+void TerrainDetail::setDistance(float fadeStart, float distance)
+{
+    distance = std::max(0.0f, distance);
+    _distance.set(std::min(std::max(0.0f, fadeStart), distance), distance);
+}
+
+void TerrainDetail::setGeneratePerFrame(unsigned int patches)
+{
+    _generatePerFrame = std::max(1u, patches);
+}
+
+void TerrainDetail::clearInstances()
+{
+    for (size_t i = 0, count = _generated.size(); i < count; ++i)
+    {
+        PatchInstances& instances = _patches[_generated[i]];
+        instances.generated = false;
+        instances.count = 0;
+        std::vector<float>().swap(instances.data);
+    }
+    _generated.clear();
+}
+
+unsigned int TerrainDetail::getDrawnInstanceCount() const
+{
+    return _drawnCount;
+}
+
+float TerrainDetail::getDensity(float column, float row) const
+{
+    if (_densityMap == NULL)
+        return 1.0f;
+
+    // Density maps cover the heightfield like the heightmap, whose first row is the last row of its image.
+    const HeightField* heightfield = _terrain->_heightfield;
+    unsigned int width = _densityMap->getWidth();
+    unsigned int height = _densityMap->getHeight();
+    unsigned int x = (unsigned int)(column / (heightfield->getColumnCount() - 1) * (width - 1) + 0.5f);
+    unsigned int y = (unsigned int)(row / (heightfield->getRowCount() - 1) * (height - 1) + 0.5f);
+    x = std::min(x, width - 1);
+    y = height - 1 - std::min(y, height - 1);
+
+    unsigned int pixelSize = _densityMap->getFormat() == Image::RGBA ? 4 : 3;
+    return _densityMap->getData()[(y * width + x) * pixelSize + _densityChannel] * (1.0f / 255.0f);
+}
+
+void TerrainDetail::generatePatches(unsigned int start, unsigned int end, void* cookie)
+{
+    TerrainDetail* detail = (TerrainDetail*)cookie;
+    for (unsigned int i = start; i < end; ++i)
+        detail->generatePatch(detail->_generating[i]);
+}
+
+void TerrainDetail::generatePatch(unsigned int index)
+{
+    PatchInstances& instances = _patches[index];
+    const BoundingBox& bounds = _terrain->_patches[index]->_boundingBox;
+    const HeightField* heightfield = _terrain->_heightfield;
+    const Vector3& scale = _terrain->_localScale;
+    float halfWidth = (heightfield->getColumnCount() - 1) * 0.5f;
+    float halfHeight = (heightfield->getRowCount() - 1) * 0.5f;
+
+    // Grid points lie on multiples of the spacing, so every point belongs to the one patch whose
+    // bounds contain it and neighbouring patches place the same instances wherever they are generated.
+    std::vector<float>& data = instances.data;
+    data.clear();
+    int x1 = (int)std::ceil(bounds.min.x / _spacing), x2 = (int)std::ceil(bounds.max.x / _spacing);
+    int z1 = (int)std::ceil(bounds.min.z / _spacing), z2 = (int)std::ceil(bounds.max.z / _spacing);
+    for (int gz = z1; gz < z2; ++gz)
+    {
+        for (int gx = x1; gx < x2; ++gx)
+        {
+            unsigned int random = hashValue((unsigned int)gx * 73856093u ^ (unsigned int)gz * 19349663u);
+            float x = (gx + nextRandom(&random)) * _spacing;
+            float z = (gz + nextRandom(&random)) * _spacing;
+            float column = x / scale.x + halfWidth;
+            float row = z / scale.z + halfHeight;
+            if (column > halfWidth * 2.0f || row > halfHeight * 2.0f || nextRandom(&random) >= getDensity(column, row))
+                continue;
+
+            Matrix world(_world);
+            world.translate(x, heightfield->getHeight(column, row) * scale.y, z);
+            world.rotateY(nextRandom(&random) * MATH_PIX2);
+            world.scale(_scaleRange.x + (_scaleRange.y - _scaleRange.x) * nextRandom(&random));
+
+            size_t offset = data.size();
+            data.resize(offset + INSTANCE_FLOATS, 0.0f);
+            memcpy(&data[offset], world.m, 16 * sizeof(float));
+        }
+    }
+
+    // Shuffle the instances, then rank them in order so that every prefix is spread over the whole patch.
+    unsigned int count = (unsigned int)(data.size() / INSTANCE_FLOATS);
+    unsigned int random = hashValue(index);
+    for (unsigned int i = count; i > 1; --i)
+    {
+        unsigned int j = std::min((unsigned int)(nextRandom(&random) * i), i - 1);
+        if (j != i - 1)
+            std::swap_ranges(&data[j * INSTANCE_FLOATS], &data[j * INSTANCE_FLOATS] + 16, &data[(i - 1) * INSTANCE_FLOATS]);
+    }
+    for (unsigned int i = 0; i < count; ++i)
+        data[i * INSTANCE_FLOATS + 16] = (i + 0.5f) / count;
+
+    instances.count = count;
+}
+
+void TerrainDetail::draw(Camera* camera, const std::vector<TerrainPatch*>& patches)
+{
+    GP_ASSERT(camera && camera->getNode());
+
+    _drawnCount = 0;
+    Vector3 cameraPosition = camera->getNode()->getTranslationWorld();
+    float fadeStart = _distance.x;
+    float distance = _distance.y;
+
+    // Drop the instances of the patches left far behind
+    for (size_t i = 0; i < _generated.size(); )
+    {
+        unsigned int index = _generated[i];
+        if (distanceToBox(_terrain->_patches[index]->getBoundingBox(true), cameraPosition) > distance * TERRAIN_DETAIL_DROP_DISTANCE)
+        {
+            PatchInstances& instances = _patches[index];
+            instances.generated = false;
+            instances.count = 0;
+            std::vector<float>().swap(instances.data);
+            _generated[i] = _generated.back();
+            _generated.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Find the visible patches within the draw distance, nearest first
+    _visible.clear();
+    for (size_t i = 0, count = patches.size(); i < count; ++i)
+    {
+        std::map<const TerrainPatch*, unsigned int>::const_iterator itr = _patchIndices.find(patches[i]);
+        if (itr == _patchIndices.end())
+            continue;
+        VisiblePatch visible;
+        visible.distance = distanceToBox(patches[i]->getBoundingBox(true), cameraPosition);
+        visible.index = itr->second;
+        if (visible.distance < distance)
+            _visible.push_back(visible);
+    }
+    std::sort(_visible.begin(), _visible.end());
+
+    // Generate the instances of a few of the nearest patches that have none yet
+    _generating.clear();
+    for (size_t i = 0, count = _visible.size(); i < count && _generating.size() < _generatePerFrame; ++i)
+    {
+        if (!_patches[_visible[i].index].generated)
+            _generating.push_back(_visible[i].index);
+    }
+    if (!_generating.empty())
+    {
+        if (_terrain->_node)
+            _world = _terrain->_node->getWorldMatrix();
+        else
+            _world.setIdentity();
+
+        JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+        if (scheduler)
+            scheduler->parallelFor((unsigned int)_generating.size(), generatePatches, this);
+        else
+            generatePatches(0, (unsigned int)_generating.size(), this);
+
+        for (size_t i = 0, count = _generating.size(); i < count; ++i)
+        {
+            _patches[_generating[i]].generated = true;
+            _generated.push_back(_generating[i]);
+        }
+    }
+
+    // Gather the instances that can be seen from each patch, nearest patches first. Instances of
+    // higher rank are cut off closer, so past the fade start only a prefix of a patch is visible.
+    const unsigned int capacity = _instances->getCapacity();
+    const float fadeRange = distance - fadeStart;
+    unsigned int count = 0;
+    for (size_t i = 0, visibleCount = _visible.size(); i < visibleCount && count < capacity; ++i)
+    {
+        const PatchInstances& instances = _patches[_visible[i].index];
+        unsigned int n = instances.count;
+        if (_visible[i].distance > fadeStart && fadeRange > 0.0f)
+            n = std::min(n, (unsigned int)std::ceil(instances.count * (distance - _visible[i].distance) / fadeRange));
+        n = std::min(n, capacity - count);
+        if (n == 0)
+            continue;
+        memcpy(&_upload[count * INSTANCE_FLOATS], &instances.data[0], n * INSTANCE_FLOATS * sizeof(float));
+        count += n;
+    }
+    _instances->setInstanceCount(count);
+    if (count == 0)
+        return;
+    _instances->setInstanceData(&_upload[0], 0, count);
+
+    static const unsigned int viewProjectionMatrixHandle = RenderState::getParameterHandle("u_viewProjectionMatrix");
+    static const unsigned int cameraPositionHandle = RenderState::getParameterHandle("u_cameraPosition");
+    static const unsigned int fadeDistanceHandle = RenderState::getParameterHandle("u_fadeDistance");
+    Material* material = _model->getMaterial();
+    GP_ASSERT(material);
+    material->getParameter(viewProjectionMatrixHandle)->setValue(camera->getViewProjectionMatrix());
+    material->getParameter(cameraPositionHandle)->setValue(cameraPosition);
+    material->getParameter(fadeDistanceHandle)->setValue(_distance);
+    _model->drawInstanced(_instances);
+    _drawnCount = count;
+}
+
+}
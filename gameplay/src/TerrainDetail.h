@@ -0,0 +1,254 @@
+#ifndef TERRAINDETAIL_H_
+#define TERRAINDETAIL_H_
+
+#include "Ref.h"
+#include "Vector2.h"
+#include "Matrix.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Image;
+class InstanceBuffer;
+class Material;
+class Mesh;
+class Model;
+class Terrain;
+class TerrainPatch;
+
+/**
+ * Defines a layer of small objects, such as grass, flowers or rocks, scattered over a terrain.
+ *
+ * The objects of a detail layer are instances of one mesh, drawn with a single instanced draw
+ * call (see InstanceBuffer). They are placed on a jittered grid with the given spacing and kept
+ * where a density map allows: each grid point holds an instance with the probability given by
+ * a channel of the density map, which is usually the blend map of a terrain layer so that grass
+ * grows where the grass texture is painted. Instances get a random rotation around the up axis
+ * and a random scale within a range.
+ *
+ * Instances only exist for the patches near the camera. The instances of a patch are generated
+ * the first time the patch comes within the draw distance, on the job scheduler and a few patches
+ * per frame, and dropped when the patch is well beyond the draw distance again. So the memory of
+ * a detail layer depends on its draw distance rather than on the size of the terrain.
+ *
+ * Detail layers thin out with distance instead of switching meshes. Every instance of a patch has
+ * a rank, and the instances of higher rank stop being drawn closer to the camera, between the
+ * fade start distance and the draw distance. The instances of a patch are stored by rank, so only
+ * the ones that can still be seen from the nearest point of the patch are uploaded, and the vertex
+ * shader shrinks each instance into the ground as it reaches its own cut-off distance. The number
+ * of instances uploaded per frame never exceeds the capacity of the layer; the nearest patches are
+ * served first.
+ *
+ * The default material draws the instances with res/shaders/terrain-detail.vert and crowd.frag,
+ * lit by an ambient color and a directional light, with alpha tested textures and no face culling.
+ * It must be given a "u_diffuseTexture" sampler, and its "u_ambientColor", "u_lightColor" and
+ * "u_lightDirection" parameters can be changed or bound to the SCENE_AMBIENT_COLOR,
+ * SCENE_LIGHT_COLOR and SCENE_LIGHT_DIRECTION auto bindings. A material set with setMaterial
+ * must use the same vertex shader inputs.
+ *
+ * Detail layers are created with Terrain::addDetail or in the terrain properties file (see
+ * Terrain). Paged terrains do not support detail layers.
+ *
+ * @script{ignore}
+ */
+class TerrainDetail : public Ref
+{
+    friend class Terrain;
+
+public:
+
+    /**
+     * Gets the terrain the detail layer is scattered over.
+     *
+     * @return The terrain.
+     */
+    Terrain* getTerrain() const;
+
+    /**
+     * Gets the material the instances are drawn with.
+     *
+     * @return The material.
+     */
+    Material* getMaterial() const;
+
+    /**
+     * Sets the material the instances are drawn with.
+     *
+     * @param material The material.
+     */
+    void setMaterial(Material* material);
+
+    /**
+     * Gets the maximum number of instances drawn per frame.
+     *
+     * @return The capacity of the detail layer.
+     */
+    unsigned int getCapacity() const;
+
+    /**
+     * Sets the density map that decides where instances are placed.
+     *
+     * The density map covers the whole terrain, like the heightmap and the blend maps.
+     *
+     * @param path The path of the image, or NULL to place instances everywhere.
+     * @param channel The channel of the image holding the density (0 to 3).
+     *
+     * @return true if the density map was loaded.
+     */
+    bool setDensityMap(const char* path, int channel = 0);
+
+    /**
+     * Gets the distance between the grid points that instances are placed on.
+     *
+     * @return The spacing, in the units of the terrain.
+     */
+    float getSpacing() const;
+
+    /**
+     * Sets the distance between the grid points that instances are placed on.
+     *
+     * @param spacing The spacing, in the units of the terrain.
+     */
+    void setSpacing(float spacing);
+
+    /**
+     * Sets the range of the random scale of the instances.
+     *
+     * @param scaleMin The smallest scale.
+     * @param scaleMax The largest scale.
+     */
+    void setScaleRange(float scaleMin, float scaleMax);
+
+    /**
+     * Gets the distances the instances thin out between.
+     *
+     * @return The distance instances start thinning out at (x) and the draw distance (y).
+     */
+    const Vector2& getDistance() const;
+
+    /**
+     * Sets the distances the instances thin out between.
+     *
+     * @param fadeStart The distance from the camera at which instances start thinning out.
+     * @param distance The draw distance, beyond which no instance is drawn.
+     */
+    void setDistance(float fadeStart, float distance);
+
+    /**
+     * Sets the number of patches whose instances may be generated per frame.
+     *
+     * @param patches The number of patches.
+     */
+    void setGeneratePerFrame(unsigned int patches);
+
+    /**
+     * Drops the instances of every patch, so that they are generated again.
+     *
+     * Changing the density map, spacing or scale range only affects the patches
+     * generated afterwards, so the instances are usually dropped after changing them.
+     */
+    void clearInstances();
+
+    /**
+     * Gets the number of instances drawn by the last frame.
+     *
+     * @return The number of instances.
+     */
+    unsigned int getDrawnInstanceCount() const;
+
+private:
+
+    /**
+     * The instances generated for a patch, ordered by rank.
+     */
+    struct PatchInstances
+    {
+        PatchInstances();
+
+        bool generated;
+        std::vector<float> data;
+        unsigned int count;
+    };
+
+    /**
+     * A patch in reach of the camera, with its distance from the camera.
+     */
+    struct VisiblePatch
+    {
+        float distance;
+        unsigned int index;
+
+        bool operator<(const VisiblePatch& other) const;
+    };
+
+    /**
+     * Constructor.
+     */
+    TerrainDetail();
+
+    /**
+     * Destructor.
+     */
+    ~TerrainDetail();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TerrainDetail(const TerrainDetail& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TerrainDetail& operator=(const TerrainDetail&);
+
+    /**
+     * Creates a detail layer of instances of a mesh.
+     */
+    static TerrainDetail* create(Terrain* terrain, Mesh* mesh, unsigned int capacity);
+
+    /**
+     * Generates the instances of a range of patches waiting in _generating, on the job scheduler.
+     */
+    static void generatePatches(unsigned int start, unsigned int end, void* cookie);
+
+    /**
+     * Generates the instances of a patch.
+     */
+    void generatePatch(unsigned int index);
+
+    /**
+     * Gets the density at a point of the heightfield, between 0 and 1.
+     */
+    float getDensity(float column, float row) const;
+
+    /**
+     * Draws the instances of the visible patches near a camera.
+     *
+     * @param camera The camera.
+     * @param patches The patches of the terrain visible to the camera.
+     */
+    void draw(Camera* camera, const std::vector<TerrainPatch*>& patches);
+
+    Terrain* _terrain;
+    Model* _model;
+    InstanceBuffer* _instances;
+    Image* _densityMap;
+    int _densityChannel;
+    float _spacing;
+    Vector2 _scaleRange;
+    Vector2 _distance;
+    unsigned int _generatePerFrame;
+    Matrix _world;
+    std::map<const TerrainPatch*, unsigned int> _patchIndices;
+    std::vector<PatchInstances> _patches;
+    std::vector<unsigned int> _generated;
+    std::vector<unsigned int> _generating;
+    std::vector<VisiblePatch> _visible;
+    std::vector<float> _upload;
+    unsigned int _drawnCount;
+};
+
+}
+
+#endif
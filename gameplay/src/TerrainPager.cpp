@@ -0,0 +1,543 @@
+#include "Base.h"
+#include "TerrainPager.h"
+#include "Terrain.h"
+#include "TerrainPatch.h"
+#include "FileSystem.h"
+#include "Scene.h"
+#include "Game.h"
+
+// Identifier and version of terrain tile files written by gameplay-encoder
+#define TERRAIN_TILES_VERSION_MAJOR 1
+#define TERRAIN_TILES_VERSION_MINOR 0
+
+// Optional data stored with the heights of every tile
+#define TERRAIN_TILES_NORMALS 1
+#define TERRAIN_TILES_BLEND 2
+
+// Default memory budget, in megabytes
+#define TERRAIN_TILES_DEFAULT_BUDGET 64
+
+namespace gameplay
+{
+
+static const unsigned char TERRAIN_TILES_IDENTIFIER[] = { 0xAB, 'G', 'P', 'T', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+TerrainPager::Tile::Tile() :
+    pager(NULL), level(0), row(0), column(0), state(TILE_UNLOADED), failed(false), data(NULL), heights(NULL),
+    patch(NULL), job(NULL), memorySize(0), lastUsedFrame(0)
+{
+    memset(children, 0, sizeof(children));
+}
+
+TerrainPager::TerrainPager() :
+    _terrain(NULL), _stream(NULL), _tileSize(0), _columns(0), _rows(0), _levelCount(0), _flags(0), _dataOffset(0),
+    _tileDataSize(0), _verticalSkirtSize(0.0f), _budget(TERRAIN_TILES_DEFAULT_BUDGET * 1024 * 1024), _memoryUsed(0),
+    _detail(2.0f), _uploadsPerFrame(2), _frame(0)
+{
+}
+
+TerrainPager::~TerrainPager()
+{
+    // Jobs still reading tiles must finish before the tiles and the stream go away.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0, count = _loadingTiles.size(); i < count; ++i)
+    {
+        GP_ASSERT(scheduler);
+        scheduler->wait(_loadingTiles[i]->job);
+    }
+
+    for (size_t i = 0, count = _tiles.size(); i < count; ++i)
+    {
+        Tile* tile = _tiles[i];
+        SAFE_DELETE(tile->patch);
+        SAFE_DELETE_ARRAY(tile->data);
+        SAFE_DELETE_ARRAY(tile->heights);
+        SAFE_DELETE(tile);
+    }
+
+    SAFE_DELETE(_stream);
+}
+
+TerrainPager* TerrainPager::create(const char* path, Properties* properties)
+{
+    GP_ASSERT(path);
+
+    Stream* stream = FileSystem::open(path);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open terrain tile file: %s", path);
+        return NULL;
+    }
+
+    // Read and validate the header
+    unsigned char identifier[sizeof(TERRAIN_TILES_IDENTIFIER)];
+    unsigned char version[2];
+    unsigned int header[5];
+    if (stream->read(identifier, 1, sizeof(identifier)) != sizeof(identifier) ||
+        memcmp(identifier, TERRAIN_TILES_IDENTIFIER, sizeof(identifier)) != 0 ||
+        stream->read(version, 1, 2) != 2 ||
+        stream->read(header, sizeof(unsigned int), 5) != 5)
+    {
+        GP_WARN("Invalid terrain tile file: %s", path);
+        SAFE_DELETE(stream);
+        return NULL;
+    }
+    if (version[0] != TERRAIN_TILES_VERSION_MAJOR || version[1] != TERRAIN_TILES_VERSION_MINOR)
+    {
+        GP_WARN("Unsupported version (%d.%d) for terrain tile file: %s (expected %d.%d)",
+            (int)version[0], (int)version[1], path, TERRAIN_TILES_VERSION_MAJOR, TERRAIN_TILES_VERSION_MINOR);
+        SAFE_DELETE(stream);
+        return NULL;
+    }
+    if (header[0] < 2 || header[1] < 2 || header[2] < 2 || header[3] == 0 || !stream->canSeek())
+    {
+        GP_WARN("Invalid terrain tile file: %s", path);
+        SAFE_DELETE(stream);
+        return NULL;
+    }
+
+    TerrainPager* pager = new TerrainPager();
+    pager->_stream = stream;
+    pager->_tileSize = header[0];
+    pager->_columns = header[1];
+    pager->_rows = header[2];
+    pager->_levelCount = header[3];
+    pager->_flags = header[4];
+    pager->_dataOffset = sizeof(TERRAIN_TILES_IDENTIFIER) + 2 + sizeof(header);
+
+    unsigned int sampleCount = (pager->_tileSize + 1) * (pager->_tileSize + 1);
+    pager->_tileDataSize = sampleCount * sizeof(unsigned short);
+    if (pager->_flags & TERRAIN_TILES_NORMALS)
+        pager->_tileDataSize += sampleCount * 3;
+    if (pager->_flags & TERRAIN_TILES_BLEND)
+        pager->_tileDataSize += sampleCount * 4;
+
+    if (properties)
+    {
+        if (properties->exists("budget"))
+            pager->_budget = (unsigned int)std::max(0, properties->getInt("budget")) * 1024 * 1024;
+        if (properties->exists("detail"))
+            pager->_detail = std::max(0.0f, properties->getFloat("detail"));
+        if (properties->exists("uploadsPerFrame"))
+            pager->_uploadsPerFrame = (unsigned int)std::max(1, properties->getInt("uploadsPerFrame"));
+    }
+
+    // Create the tiles of all levels, finest level first as in the file.
+    for (unsigned int level = 0; level < pager->_levelCount; ++level)
+    {
+        pager->_levelOffsets.push_back((unsigned int)pager->_tiles.size());
+        for (unsigned int row = 0, rows = pager->getTileRows(level); row < rows; ++row)
+        {
+            for (unsigned int column = 0, columns = pager->getTileColumns(level); column < columns; ++column)
+            {
+                Tile* tile = new Tile();
+                tile->pager = pager;
+                tile->level = level;
+                tile->row = row;
+                tile->column = column;
+                if (level > 0)
+                {
+                    for (unsigned int i = 0; i < 4; ++i)
+                    {
+                        unsigned int childRow = row * 2 + i / 2;
+                        unsigned int childColumn = column * 2 + i % 2;
+                        if (childRow < pager->getTileRows(level - 1) && childColumn < pager->getTileColumns(level - 1))
+                            tile->children[i] = pager->getTile(level - 1, childRow, childColumn);
+                    }
+                }
+                pager->_tiles.push_back(tile);
+            }
+        }
+    }
+
+    return pager;
+}
+
+bool TerrainPager::initialize(Terrain* terrain, float verticalSkirtSize)
+{
+    _terrain = terrain;
+    _verticalSkirtSize = verticalSkirtSize;
+
+    // The coarsest level is always resident, so there is something to draw everywhere.
+    unsigned int level = _levelCount - 1;
+    for (size_t i = _levelOffsets[level], count = _tiles.size(); i < count; ++i)
+    {
+        Tile* tile = _tiles[i];
+        loadTile(tile);
+        if (tile->failed)
+        {
+            GP_WARN("Failed to read terrain tile (level %d, row %d, column %d).", tile->level, tile->row, tile->column);
+            return false;
+        }
+        createPatch(tile);
+    }
+    return true;
+}
+
+unsigned int TerrainPager::getTileColumns(unsigned int level) const
+{
+    unsigned int extent = _tileSize << level;
+    return std::max(1u, (_columns - 1 + extent - 1) / extent);
+}
+
+unsigned int TerrainPager::getTileRows(unsigned int level) const
+{
+    unsigned int extent = _tileSize << level;
+    return std::max(1u, (_rows - 1 + extent - 1) / extent);
+}
+
+TerrainPager::Tile* TerrainPager::getTile(unsigned int level, unsigned int row, unsigned int column) const
+{
+    GP_ASSERT(level < _levelCount);
+    return _tiles[_levelOffsets[level] + row * getTileColumns(level) + column];
+}
+
+void TerrainPager::loadTile(void* cookie)
+{
+    Tile* tile = (Tile*)cookie;
+    TerrainPager* pager = tile->pager;
+
+    unsigned int index = pager->_levelOffsets[tile->level] + tile->row * pager->getTileColumns(tile->level) + tile->column;
+    unsigned char* data = new unsigned char[pager->_tileDataSize];
+    bool result;
+    {
+        MutexLock lock(pager->_streamMutex);
+        result = pager->_stream->seek((long int)pager->_dataOffset + (long int)index * pager->_tileDataSize, SEEK_SET) &&
+            pager->_stream->read(data, 1, pager->_tileDataSize) == pager->_tileDataSize;
+    }
+    if (!result)
+    {
+        SAFE_DELETE_ARRAY(data);
+        tile->failed = true;
+        return;
+    }
+
+    // Heights are stored as normalized 16-bit values, little endian.
+    unsigned int sampleCount = (pager->_tileSize + 1) * (pager->_tileSize + 1);
+    float* heights = new float[sampleCount];
+    for (unsigned int i = 0; i < sampleCount; ++i)
+    {
+        heights[i] = (data[i * 2] | ((unsigned int)data[i * 2 + 1] << 8)) / 65535.0f;
+    }
+    tile->data = data;
+    tile->heights = heights;
+}
+
+void TerrainPager::requestTile(Tile* tile)
+{
+    GP_ASSERT(tile->state == TILE_UNLOADED);
+    if (tile->failed)
+        return;
+
+    // Without worker threads jobs only run when waited on, so the tile is read right away.
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    tile->state = TILE_LOADING;
+    if (scheduler && scheduler->getWorkerCount() > 0)
+    {
+        tile->job = scheduler->submit(loadTile, tile);
+        _loadingTiles.push_back(tile);
+    }
+    else
+    {
+        loadTile(tile);
+        finishLoad(tile);
+    }
+}
+
+void TerrainPager::finishLoad(Tile* tile)
+{
+    if (tile->failed)
+    {
+        GP_WARN("Failed to read terrain tile (level %d, row %d, column %d).", tile->level, tile->row, tile->column);
+        tile->state = TILE_UNLOADED;
+        return;
+    }
+
+    tile->state = TILE_LOADED;
+    tile->memorySize = _tileDataSize + (_tileSize + 1) * (_tileSize + 1) * sizeof(float);
+    _memoryUsed += tile->memorySize;
+    _loadedTiles.push_back(tile);
+}
+
+void TerrainPager::createPatch(Tile* tile)
+{
+    GP_ASSERT(tile->data && tile->heights);
+
+    unsigned int samples = _tileSize + 1;
+    unsigned int sampleCount = samples * samples;
+    unsigned char* normals = NULL;
+    unsigned char* blend = NULL;
+    unsigned char* data = tile->data + sampleCount * sizeof(unsigned short);
+    if (_flags & TERRAIN_TILES_NORMALS)
+    {
+        normals = data;
+        data += sampleCount * 3;
+    }
+    if (_flags & TERRAIN_TILES_BLEND)
+    {
+        blend = data;
+    }
+
+    // Normal and blend maps cover exactly one tile and are not a power of two, so they have no mipmaps.
+    Texture::Sampler* normalMap = NULL;
+    if (normals)
+    {
+        Texture* texture = Texture::create(Texture::RGB, samples, samples, normals, false);
+        normalMap = Texture::Sampler::create(texture);
+        SAFE_RELEASE(texture);
+        normalMap->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+        normalMap->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    }
+    Texture* blendMap = blend ? Texture::create(Texture::RGBA, samples, samples, blend, false) : NULL;
+
+    // Tiles on the far edges of the terrain can extend past it, those quads are left out.
+    unsigned int spacing = 1u << tile->level;
+    unsigned int extent = _tileSize << tile->level;
+    unsigned int x1 = tile->column * extent;
+    unsigned int z1 = tile->row * extent;
+    unsigned int quadsX = (std::min(x1 + extent, _columns - 1) - x1 + spacing - 1) / spacing;
+    unsigned int quadsZ = (std::min(z1 + extent, _rows - 1) - z1 + spacing - 1) / spacing;
+    float xOffset = x1 - (_columns - 1) * 0.5f;
+    float zOffset = z1 - (_rows - 1) * 0.5f;
+    tile->patch = TerrainPatch::create(_terrain, tile->row, tile->column, tile->heights, samples, samples,
+        0, 0, quadsX, quadsZ, xOffset, zOffset, 1, _verticalSkirtSize, (float)spacing, normalMap, blendMap);
+    SAFE_RELEASE(normalMap);
+    SAFE_RELEASE(blendMap);
+
+    // Layers repeat their textures across every tile of the finest level.
+    for (size_t i = 0, count = _layers.size(); i < count; ++i)
+    {
+        const Layer& layer = _layers[i];
+        tile->patch->setLayer(layer.index, layer.texturePath.c_str(), layer.textureRepeat * (float)spacing,
+            layer.blendPath.empty() ? NULL : layer.blendPath.c_str(), layer.blendChannel);
+    }
+
+    // The texture data is on the GPU now, only the heights are kept for height queries.
+    SAFE_DELETE_ARRAY(tile->data);
+    unsigned int vertexCount = (quadsX + 3) * (quadsZ + 3);
+    _memoryUsed -= tile->memorySize;
+    tile->memorySize = sampleCount * sizeof(float) +
+        vertexCount * (normalMap ? 5 : 8) * sizeof(float) + vertexCount * 2 * sizeof(unsigned short) +
+        (normals ? sampleCount * 3 : 0) + (blend ? sampleCount * 4 : 0);
+    _memoryUsed += tile->memorySize;
+    tile->state = TILE_RESIDENT;
+}
+
+void TerrainPager::unloadTile(Tile* tile)
+{
+    GP_ASSERT(tile->state == TILE_LOADED || tile->state == TILE_RESIDENT);
+
+    SAFE_DELETE(tile->patch);
+    SAFE_DELETE_ARRAY(tile->data);
+    SAFE_DELETE_ARRAY(tile->heights);
+    _memoryUsed -= tile->memorySize;
+    tile->memorySize = 0;
+    tile->state = TILE_UNLOADED;
+}
+
+bool TerrainPager::setLayer(int index, const char* texturePath, const Vector2& textureRepeat, const char* blendPath, int blendChannel)
+{
+    GP_ASSERT(texturePath);
+
+    Layer layer;
+    layer.index = index;
+    layer.texturePath = texturePath;
+    layer.textureRepeat = textureRepeat;
+    layer.blendPath = blendPath ? blendPath : "";
+    layer.blendChannel = blendChannel;
+
+    // Replace an existing layer with the same index
+    bool found = false;
+    for (size_t i = 0, count = _layers.size(); i < count && !found; ++i)
+    {
+        if (_layers[i].index == index)
+        {
+            _layers[i] = layer;
+            found = true;
+        }
+    }
+    if (!found)
+        _layers.push_back(layer);
+
+    bool result = true;
+    for (size_t i = 0, count = _tiles.size(); i < count; ++i)
+    {
+        Tile* tile = _tiles[i];
+        if (tile->patch && !tile->patch->setLayer(index, texturePath, textureRepeat * (float)(1u << tile->level), blendPath, blendChannel))
+            result = false;
+    }
+    return result;
+}
+
+void TerrainPager::update()
+{
+    ++_frame;
+
+    // Collect the tiles that finished loading
+    JobScheduler* scheduler = Game::getInstance()->getJobScheduler();
+    for (size_t i = 0; i < _loadingTiles.size(); )
+    {
+        Tile* tile = _loadingTiles[i];
+        if (!scheduler->isFinished(tile->job))
+        {
+            ++i;
+            continue;
+        }
+        scheduler->release(tile->job);
+        tile->job = NULL;
+        finishLoad(tile);
+        _loadingTiles[i] = _loadingTiles.back();
+        _loadingTiles.pop_back();
+    }
+
+    // Select the tiles to draw from the coarsest level down
+    _drawPatches.clear();
+    Scene* scene = _terrain->_node ? _terrain->_node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    Vector3 cameraPosition;
+    bool hasCamera = camera && camera->getNode();
+    if (hasCamera)
+        cameraPosition = camera->getNode()->getTranslationWorld();
+    for (size_t i = _levelOffsets[_levelCount - 1], count = _tiles.size(); i < count; ++i)
+    {
+        if (hasCamera)
+        {
+            select(_tiles[i], cameraPosition);
+        }
+        else
+        {
+            _tiles[i]->lastUsedFrame = _frame;
+            _drawPatches.push_back(_tiles[i]->patch);
+        }
+    }
+
+    // Create the patches of loaded tiles that are still wanted, a few per frame
+    unsigned int uploads = 0;
+    for (size_t i = 0; i < _loadedTiles.size() && uploads < _uploadsPerFrame; )
+    {
+        Tile* tile = _loadedTiles[i];
+        if (tile->state == TILE_LOADED && tile->lastUsedFrame == _frame)
+        {
+            createPatch(tile);
+            ++uploads;
+        }
+        if (tile->state != TILE_LOADED)
+        {
+            _loadedTiles.erase(_loadedTiles.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+
+    if (_memoryUsed > _budget)
+        evictTiles();
+}
+
+void TerrainPager::select(Tile* tile, const Vector3& cameraPosition)
+{
+    tile->lastUsedFrame = _frame;
+    GP_ASSERT(tile->patch);
+
+    // Refine the tile when the camera is closer than its size times the detail factor.
+    bool refine = false;
+    if (tile->level > 0)
+    {
+        BoundingBox bounds = tile->patch->getBoundingBox(true);
+        Vector3 closest(std::min(std::max(cameraPosition.x, bounds.min.x), bounds.max.x),
+                        std::min(std::max(cameraPosition.y, bounds.min.y), bounds.max.y),
+                        std::min(std::max(cameraPosition.z, bounds.min.z), bounds.max.z));
+        float size = std::max(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z);
+        refine = cameraPosition.distance(closest) < size * _detail;
+    }
+
+    if (refine)
+    {
+        // Keep drawing this tile until all of its children can replace it.
+        bool ready = true;
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            Tile* child = tile->children[i];
+            if (child == NULL)
+                continue;
+
+            child->lastUsedFrame = _frame;
+            if (child->state == TILE_UNLOADED)
+                requestTile(child);
+            if (child->state != TILE_RESIDENT)
+                ready = false;
+        }
+        if (ready)
+        {
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                if (tile->children[i])
+                    select(tile->children[i], cameraPosition);
+            }
+            return;
+        }
+    }
+
+    _drawPatches.push_back(tile->patch);
+}
+
+bool TerrainPager::compareLastUsed(const Tile* a, const Tile* b)
+{
+    return a->lastUsedFrame < b->lastUsedFrame;
+}
+
+void TerrainPager::evictTiles()
+{
+    // Tiles of the coarsest level and the tiles used this frame are never evicted.
+    _evictableTiles.clear();
+    for (size_t i = 0, count = _levelOffsets[_levelCount - 1]; i < count; ++i)
+    {
+        Tile* tile = _tiles[i];
+        if ((tile->state == TILE_LOADED || tile->state == TILE_RESIDENT) && tile->lastUsedFrame != _frame)
+            _evictableTiles.push_back(tile);
+    }
+    std::sort(_evictableTiles.begin(), _evictableTiles.end(), compareLastUsed);
+
+    for (size_t i = 0, count = _evictableTiles.size(); i < count && _memoryUsed > _budget; ++i)
+    {
+        unloadTile(_evictableTiles[i]);
+    }
+}
+
+float TerrainPager::getHeight(float x, float z) const
+{
+    x = std::min(std::max(x, 0.0f), (float)(_columns - 1));
+    z = std::min(std::max(z, 0.0f), (float)(_rows - 1));
+
+    // Find the finest loaded tile that contains the point
+    unsigned int level = _levelCount - 1;
+    unsigned int extent = _tileSize << level;
+    const Tile* tile = getTile(level, std::min((unsigned int)z / extent, getTileRows(level) - 1),
+        std::min((unsigned int)x / extent, getTileColumns(level) - 1));
+    while (tile->level > 0)
+    {
+        unsigned int childExtent = _tileSize << (tile->level - 1);
+        unsigned int i = (x >= tile->column * extent + childExtent ? 1 : 0) + (z >= tile->row * extent + childExtent ? 2 : 0);
+        const Tile* child = tile->children[i];
+        if (child == NULL || child->heights == NULL)
+            break;
+        tile = child;
+        extent = childExtent;
+    }
+    GP_ASSERT(tile->heights);
+
+    // Interpolate the heights of the tile samples around the point
+    float spacing = (float)(1u << tile->level);
+    float u = (x - tile->column * extent) / spacing;
+    float v = (z - tile->row * extent) / spacing;
+    unsigned int x1 = std::min((unsigned int)u, _tileSize - 1);
+    unsigned int z1 = std::min((unsigned int)v, _tileSize - 1);
+    u -= x1;
+    v -= z1;
+    unsigned int samples = _tileSize + 1;
+    const float* h = tile->heights + z1 * samples + x1;
+    float top = h[0] + (h[1] - h[0]) * u;
+    float bottom = h[samples] + (h[samples + 1] - h[samples]) * u;
+    return top + (bottom - top) * v;
+}
+
+}
@@ -0,0 +1,199 @@
+#ifndef TERRAINPAGER_H_
+#define TERRAINPAGER_H_
+
+#include "Stream.h"
+#include "Thread.h"
+#include "JobScheduler.h"
+#include "BoundingBox.h"
+#include "Properties.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+class Terrain;
+class TerrainPatch;
+
+/**
+ * Streams the tiles of a paged terrain from a tile file produced by gameplay-encoder.
+ *
+ * The tile file stores the heights, and optionally the normals and blend weights, of
+ * the terrain as a quadtree of tiles. Every tile has the same number of samples, so a
+ * tile of level L covers 2^L times the area of a tile of the finest level (level 0).
+ * The tiles of the coarsest level are loaded with the terrain and never unloaded,
+ * all other tiles are loaded by the job scheduler when the camera gets close enough
+ * and unloaded, least recently used first, once the memory budget is exceeded. A tile
+ * is drawn in place of its children until all of them are loaded.
+ *
+ * This is an internal class used exclusively by Terrain.
+ *
+ * @script{ignore}
+ */
+class TerrainPager
+{
+    friend class Terrain;
+
+private:
+
+    enum TileState
+    {
+        TILE_UNLOADED,
+        TILE_LOADING,
+        TILE_LOADED,
+        TILE_RESIDENT
+    };
+
+    struct Tile
+    {
+        TerrainPager* pager;
+        unsigned int level;
+        unsigned int row;
+        unsigned int column;
+        TileState state;
+        bool failed;
+        unsigned char* data;
+        float* heights;
+        TerrainPatch* patch;
+        JobScheduler::Job* job;
+        unsigned int memorySize;
+        unsigned int lastUsedFrame;
+        Tile* children[4];
+
+        Tile();
+    };
+
+    struct Layer
+    {
+        int index;
+        std::string texturePath;
+        Vector2 textureRepeat;
+        std::string blendPath;
+        int blendChannel;
+    };
+
+    /**
+     * Constructor.
+     */
+    TerrainPager();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TerrainPager(const TerrainPager&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TerrainPager& operator=(const TerrainPager&);
+
+    /**
+     * Destructor.
+     */
+    ~TerrainPager();
+
+    /**
+     * Opens a tile file and reads its header.
+     *
+     * @param path The path of the tile file.
+     * @param properties The 'tiles' namespace of the terrain definition, or NULL.
+     *
+     * @return The new pager, or NULL if the file is not a valid tile file.
+     */
+    static TerrainPager* create(const char* path, Properties* properties);
+
+    /**
+     * Loads the tiles of the coarsest level and creates their patches.
+     */
+    bool initialize(Terrain* terrain, float verticalSkirtSize);
+
+    /**
+     * Loads, uploads and unloads tiles for the active camera and selects the patches to draw.
+     */
+    void update();
+
+    /**
+     * Sets a layer on all current and future tile patches.
+     */
+    bool setLayer(int index, const char* texturePath, const Vector2& textureRepeat, const char* blendPath, int blendChannel);
+
+    /**
+     * Returns the height at the specified heightfield coordinates, from the finest loaded tile.
+     */
+    float getHeight(float x, float z) const;
+
+    /**
+     * Returns the tile of the specified level at the specified row and column.
+     */
+    Tile* getTile(unsigned int level, unsigned int row, unsigned int column) const;
+
+    /**
+     * Returns the number of tiles along the x and z axes at the specified level.
+     */
+    unsigned int getTileColumns(unsigned int level) const;
+    unsigned int getTileRows(unsigned int level) const;
+
+    /**
+     * Adds the tile, or its children if they are needed and loaded, to the draw list.
+     */
+    void select(Tile* tile, const Vector3& cameraPosition);
+
+    /**
+     * Starts to load a tile.
+     */
+    void requestTile(Tile* tile);
+
+    /**
+     * Reads and decodes the data of a tile (called from a job).
+     */
+    static void loadTile(void* cookie);
+
+    /**
+     * Accounts for a tile whose data has been read.
+     */
+    void finishLoad(Tile* tile);
+
+    /**
+     * Creates the patch of a loaded tile.
+     */
+    void createPatch(Tile* tile);
+
+    /**
+     * Releases the patch and data of a tile.
+     */
+    void unloadTile(Tile* tile);
+
+    /**
+     * Unloads the least recently used tiles until the memory budget is met.
+     */
+    void evictTiles();
+
+    static bool compareLastUsed(const Tile* a, const Tile* b);
+
+    Terrain* _terrain;
+    Stream* _stream;
+    Mutex _streamMutex;
+    unsigned int _tileSize;
+    unsigned int _columns;
+    unsigned int _rows;
+    unsigned int _levelCount;
+    unsigned int _flags;
+    unsigned int _dataOffset;
+    unsigned int _tileDataSize;
+    float _verticalSkirtSize;
+    std::vector<Tile*> _tiles;
+    std::vector<unsigned int> _levelOffsets;
+    std::vector<Tile*> _loadingTiles;
+    std::vector<Tile*> _loadedTiles;
+    std::vector<Tile*> _evictableTiles;
+    std::vector<TerrainPatch*> _drawPatches;
+    std::vector<Layer> _layers;
+    unsigned int _budget;
+    unsigned int _memoryUsed;
+    float _detail;
+    unsigned int _uploadsPerFrame;
+    unsigned int _frame;
+};
+
+}
+
+#endif
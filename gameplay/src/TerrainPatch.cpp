@@ -1,14 +1,24 @@
 #include "Base.h"
 #include "TerrainPatch.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "Terrain.h"
 #include "MeshPart.h"
 #include "Scene.h"
 #include "Game.h"
+#include "RenderStats.h"
+#include "EffectPermutations.h"
 
 // Default terrain shaders
 #define TERRAIN_VSH "res/shaders/terrain.vert"
 #define TERRAIN_FSH "res/shaders/terrain.frag"
 
+// Features of the terrain effect permutations used with a layer texture array.
+#define TERRAIN_FEATURE_LAYER_COUNT 0
+#define TERRAIN_FEATURE_DEBUG_PATCHES 1
+#define TERRAIN_FEATURE_NORMAL_MAP 2
+#define TERRAIN_FEATURE_GEOMORPHING 3
+
 namespace gameplay
 {
 
@@ -22,8 +32,128 @@ float calculateHeight(float* heights, unsigned int width, unsigned int height, u
  */
 template <class T> T clamp(T value, T min, T max) { return value < min ? min : (value > max ? max : value); }
 
+/**
+ * Returns the coarsest of the first levelCount LOD levels whose vertices include coordinate c of the span [c1, c2].
+ *
+ * @script{ignore}
+ */
+static unsigned int calculateMorphLevel(unsigned int c, unsigned int c1, unsigned int c2, unsigned int levelCount)
+{
+    if (c == c2)
+        return levelCount - 1;
+
+    unsigned int level = 0;
+    while (level + 1 < levelCount && (c - c1) % (1u << (level + 1)) == 0)
+        ++level;
+    return level;
+}
+
+/**
+ * Returns the height at (x, z) of the surface drawn by the LOD level with the specified step.
+ *
+ * The height is interpolated on the triangle of the coarse level that contains the point,
+ * split along the same diagonal as the triangle strips built for the level.
+ *
+ * @script{ignore}
+ */
+static float calculateMorphHeight(float* heights, unsigned int width, unsigned int height, unsigned int x, unsigned int z,
+    unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2, unsigned int step)
+{
+    unsigned int xa = x1 + (x - x1) / step * step;
+    unsigned int za = z1 + (z - z1) / step * step;
+    unsigned int xb = std::min(xa + step, x2);
+    unsigned int zb = std::min(za + step, z2);
+    float u = xb > xa ? (float)(x - xa) / (xb - xa) : 0.0f;
+    float v = zb > za ? (float)(z - za) / (zb - za) : 0.0f;
+
+    float h01 = calculateHeight(heights, width, height, xa, zb);
+    float h10 = calculateHeight(heights, width, height, xb, za);
+    if (u + v <= 1.0f)
+    {
+        float h00 = calculateHeight(heights, width, height, xa, za);
+        return h00 + u * (h10 - h00) + v * (h01 - h00);
+    }
+    float h11 = calculateHeight(heights, width, height, xb, zb);
+    return h11 + (1.0f - u) * (h01 - h11) + (1.0f - v) * (h10 - h11);
+}
+
+// The minimum number of vertex normals computed by one job.
+#define TERRAIN_NORMAL_BATCH 256
+
+/**
+ * The heights and vertices that the jobs computing the normals of a patch level work on.
+ *
+ * @script{ignore}
+ */
+struct NormalBatch
+{
+    float* heights;
+    unsigned int width;
+    unsigned int height;
+    unsigned int step;
+    float spacing;
+    const unsigned int* coordinates;    // Heightfield x and z of each vertex.
+    float* normals;                     // Normal of the first vertex.
+    unsigned int stride;                // Floats between the normals of consecutive vertices.
+};
+
+/**
+ * Computes the normals of a range of vertices from their neighbors at the level's step.
+ *
+ * @script{ignore}
+ */
+static void calculateNormalRange(unsigned int start, unsigned int end, void* cookie)
+{
+    const NormalBatch* batch = (const NormalBatch*)cookie;
+    float* heights = batch->heights;
+    const unsigned int width = batch->width;
+    const unsigned int height = batch->height;
+    const unsigned int step = batch->step;
+    const float spacing = batch->spacing;
+    for (unsigned int i = start; i < end; ++i)
+    {
+        unsigned int x = batch->coordinates[i * 2];
+        unsigned int z = batch->coordinates[i * 2 + 1];
+        unsigned int xw = x>=step ? x-step : x;
+        unsigned int xe = x<width-step ? x+step : x;
+        unsigned int zs = z>=step ? z-step : z;
+        unsigned int zn = z<height-step ? z+step : z;
+        Vector3 p(x * spacing, calculateHeight(heights, width, height, x, z), z * spacing);
+        Vector3 w(Vector3(xw * spacing, calculateHeight(heights, width, height, xw, z), z * spacing), p);
+        Vector3 e(Vector3(xe * spacing, calculateHeight(heights, width, height, xe, z), z * spacing), p);
+        Vector3 s(Vector3(x * spacing, calculateHeight(heights, width, height, x, zs), zs * spacing), p);
+        Vector3 n(Vector3(x * spacing, calculateHeight(heights, width, height, x, zn), zn * spacing), p);
+        Vector3 normals[4];
+        Vector3::cross(n, w, &normals[0]);
+        Vector3::cross(w, s, &normals[1]);
+        Vector3::cross(e, n, &normals[2]);
+        Vector3::cross(s, e, &normals[3]);
+        Vector3 normal = -(normals[0] + normals[1] + normals[2] + normals[3]);
+        normal.normalize();
+        float* v = batch->normals + i * batch->stride;
+        v[0] = normal.x;
+        v[1] = normal.y;
+        v[2] = normal.z;
+    }
+}
+
+/**
+ * Computes the normals of all vertices of a patch level, split over the job scheduler when it is running.
+ *
+ * @script{ignore}
+ */
+static void calculateNormals(NormalBatch* batch, unsigned int vertexCount)
+{
+    Game* game = Game::getInstance();
+    JobScheduler* scheduler = game ? game->getJobScheduler() : NULL;
+    if (scheduler)
+        scheduler->parallelFor(vertexCount, calculateNormalRange, batch, TERRAIN_NORMAL_BATCH);
+    else
+        calculateNormalRange(0, vertexCount, batch);
+}
+
 TerrainPatch::TerrainPatch() :
-    _terrain(NULL), _row(0), _column(0), _materialDirty(true)
+    _terrain(NULL), _morphModel(NULL), _row(0), _column(0), _materialDirty(true), _spacing(1.0f), _normalMap(NULL), _blendMap(NULL)
 {
 }
 
@@ -37,10 +167,16 @@ TerrainPatch::~TerrainPatch()
         SAFE_DELETE(level);
     }
 
+    // Shared levels are owned by the terrain.
+    SAFE_RELEASE(_morphModel);
+
     while (_layers.size() > 0)
     {
         deleteLayer(*_layers.begin());
     }
+
+    SAFE_RELEASE(_normalMap);
+    SAFE_RELEASE(_blendMap);
 }
 
 TerrainPatch* TerrainPatch::create(Terrain* terrain,
@@ -48,23 +184,39 @@ TerrainPatch* TerrainPatch::create(Terrain* terrain,
     float* heights, unsigned int width, unsigned int height,
     unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
     float xOffset, float zOffset,
-    unsigned int maxStep, float verticalSkirtSize)
+    unsigned int maxStep, float verticalSkirtSize,
+    float spacing, Texture::Sampler* normalMap, Texture* blendMap)
 {
     // Create patch
     TerrainPatch* patch = new TerrainPatch();
     patch->_terrain = terrain;
     patch->_row = row;
     patch->_column = column;
+    patch->_spacing = spacing;
+    patch->_normalMap = normalMap;
+    if (normalMap)
+        normalMap->addRef();
+    patch->_blendMap = blendMap;
+    if (blendMap)
+        blendMap->addRef();
 
     // Add patch lods
-    for (unsigned int step = 1; step <= maxStep; step *= 2)
+    if (terrain->_geomorphing)
     {
-        patch->addLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, step, verticalSkirtSize);
+        patch->addMorphLevels(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, maxStep, verticalSkirtSize);
+    }
+    else
+    {
+        for (unsigned int step = 1; step <= maxStep; step *= 2)
+        {
+            patch->addLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, step, verticalSkirtSize);
+        }
     }
 
     // Set our bounding box using the base LOD mesh
     BoundingBox& bounds = patch->_boundingBox;
-    bounds.set(patch->_levels[0]->model->getMesh()->getBoundingBox());
+    Model* baseModel = patch->_morphModel ? patch->_morphModel : patch->_levels[0]->model;
+    bounds.set(baseModel->getMesh()->getBoundingBox());
 
     // Apply the terrain's local scale to our bounds
     const Vector3& localScale = terrain->_localScale;
@@ -106,8 +258,9 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     }
 
     unsigned int vertexCount = patchHeight * patchWidth;
-    unsigned int vertexElements = _terrain->_normalMap ? 5 : 8; //<x,y,z>[i,j,k]<u,v>
+    unsigned int vertexElements = _normalMap ? 5 : 8; //<x,y,z>[i,j,k]<u,v>
     float* vertices = new float[vertexCount * vertexElements];
+    unsigned int* coordinates = _normalMap ? NULL : new unsigned int[vertexCount * 2];
     unsigned int index = 0;
     Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
     Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
@@ -123,11 +276,11 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
             index++;
 
             // Compute position
-            v[0] = x + xOffset;
+            v[0] = x * _spacing + xOffset;
             v[1] = calculateHeight(heights, width, height, x, z);
             if (xskirt || zskirt)
                 v[1] -= verticalSkirtSize;
-            v[2] = z + zOffset;
+            v[2] = z * _spacing + zOffset;
 
             // Update bounding box min/max (don't include vertical skirt vertices in bounding box)
             if (!(xskirt || zskirt))
@@ -147,24 +300,11 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
             }
             v += 3;
 
-            // Compute normal
-            if (!_terrain->_normalMap)
+            // Normals are computed in parallel once all vertices are placed
+            if (!_normalMap)
             {
-                Vector3 p(x, calculateHeight(heights, width, height, x, z), z);
-                Vector3 w(Vector3(x>=step ? x-step : x, calculateHeight(heights, width, height, x>=step ? x-step : x, z), z), p);
-                Vector3 e(Vector3(x<width-step ? x+step : x, calculateHeight(heights, width, height, x<width-step ? x+step : x, z), z), p);
-                Vector3 s(Vector3(x, calculateHeight(heights, width, height, x, z>=step ? z-step : z), z>=step ? z-step : z), p);
-                Vector3 n(Vector3(x, calculateHeight(heights, width, height, x, z<height-step ? z+step : z), z<height-step ? z+step : z), p);
-                Vector3 normals[4];
-                Vector3::cross(n, w, &normals[0]);
-                Vector3::cross(w, s, &normals[1]);
-                Vector3::cross(e, n, &normals[2]);
-                Vector3::cross(s, e, &normals[3]);
-                Vector3 normal = -(normals[0] + normals[1] + normals[2] + normals[3]);
-                normal.normalize();
-                v[0] = normal.x;
-                v[1] = normal.y;
-                v[2] = normal.z;
+                coordinates[(index - 1) * 2] = x;
+                coordinates[(index - 1) * 2 + 1] = z;
                 v += 3;
             }
 
@@ -217,12 +357,19 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     }
     GP_ASSERT(index == vertexCount);
 
+    if (!_normalMap)
+    {
+        NormalBatch batch = { heights, width, height, step, _spacing, coordinates, vertices + 3, vertexElements };
+        calculateNormals(&batch, vertexCount);
+        SAFE_DELETE_ARRAY(coordinates);
+    }
+
     Vector3 center(min + ((max - min) * 0.5f));
 
     // Create mesh
     VertexFormat::Element elements[3];
     elements[0] = VertexFormat::Element(VertexFormat::POSITION, 3);
-    if (_terrain->_normalMap)
+    if (_normalMap)
     {
         elements[1] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
     }
@@ -231,7 +378,7 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
         elements[1] = VertexFormat::Element(VertexFormat::NORMAL, 3);
         elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
     }
-    VertexFormat format(elements, _terrain->_normalMap ? 2 : 3);
+    VertexFormat format(elements, _normalMap ? 2 : 3);
     Mesh* mesh = Mesh::createMesh(format, vertexCount);
     mesh->setVertexData(vertices);
     mesh->setBoundingBox(BoundingBox(min, max));
@@ -314,6 +461,241 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     _levels.push_back(level);
 }
 
+void TerrainPatch::addMorphLevels(float* heights, unsigned int width, unsigned int height,
+    unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+    float xOffset, float zOffset,
+    unsigned int maxStep, float verticalSkirtSize)
+{
+    unsigned int levelCount = 0;
+    for (unsigned int step = 1; step <= maxStep; step *= 2)
+        ++levelCount;
+
+    // Every level draws a subset of the full resolution vertices, so the patch stores
+    // them once. The vertical skirts add one column and row on each side.
+    bool skirts = verticalSkirtSize > 0.0f;
+    unsigned int border = skirts ? 1 : 0;
+    unsigned int patchWidth = (x2 - x1) + 1 + border * 2;
+    unsigned int patchHeight = (z2 - z1) + 1 + border * 2;
+    unsigned int vertexCount = patchHeight * patchWidth;
+    if (vertexCount > USHRT_MAX + 1)
+    {
+        GP_WARN("Vertex count of %d for terrain patch exceeds the limit of 65536. Please specifiy a smaller patch size.", vertexCount);
+        GP_ASSERT(vertexCount <= USHRT_MAX + 1);
+    }
+
+    // Besides the usual elements, each vertex stores its height offset to the surface of the next
+    // coarser level and the finest level in which it is not also a vertex of that coarser level.
+    unsigned int vertexElements = _normalMap ? 7 : 10; //<x,y,z>[i,j,k]<u,v><dh,level>
+    float* vertices = new float[vertexCount * vertexElements];
+    unsigned int* coordinates = _normalMap ? NULL : new unsigned int[vertexCount * 2];
+    unsigned int* c = coordinates;
+    float* v = vertices;
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (unsigned int row = 0; row < patchHeight; ++row)
+    {
+        bool zskirt = skirts && (row == 0 || row == patchHeight - 1);
+        unsigned int z = row < border ? z1 : std::min(z1 + row - border, z2);
+        for (unsigned int column = 0; column < patchWidth; ++column)
+        {
+            bool xskirt = skirts && (column == 0 || column == patchWidth - 1);
+            unsigned int x = column < border ? x1 : std::min(x1 + column - border, x2);
+            float h = calculateHeight(heights, width, height, x, z);
+
+            // Compute position
+            v[0] = x + xOffset;
+            v[1] = h;
+            if (xskirt || zskirt)
+                v[1] -= verticalSkirtSize;
+            v[2] = z + zOffset;
+
+            // Update bounding box min/max (don't include vertical skirt vertices in bounding box)
+            if (!(xskirt || zskirt))
+            {
+                min.set(std::min(min.x, v[0]), std::min(min.y, v[1]), std::min(min.z, v[2]));
+                max.set(std::max(max.x, v[0]), std::max(max.y, v[1]), std::max(max.z, v[2]));
+            }
+            v += 3;
+
+            // Normals are computed in parallel once all vertices are placed
+            if (!_normalMap)
+            {
+                *c++ = x;
+                *c++ = z;
+                v += 3;
+            }
+
+            // Compute texture coord
+            v[0] = (float)x / width;
+            v[1] = 1.0f - (float)z / height;
+            if (xskirt)
+            {
+                float offset = verticalSkirtSize / width;
+                v[0] = x == x1 ? v[0]-offset : v[0]+offset;
+            }
+            else if (zskirt)
+            {
+                float offset = verticalSkirtSize / height;
+                v[1] = z == z1 ? v[1]-offset : v[1]+offset;
+            }
+            v += 2;
+
+            // Compute morph target. Skirt vertices follow the edge vertex above them.
+            unsigned int level = std::min(calculateMorphLevel(x, x1, x2, levelCount), calculateMorphLevel(z, z1, z2, levelCount));
+            v[0] = 0.0f;
+            if (level + 1 < levelCount)
+                v[0] = calculateMorphHeight(heights, width, height, x, z, x1, z1, x2, z2, 1u << (level + 1)) - h;
+            v[1] = (float)level;
+            v += 2;
+        }
+    }
+
+    if (!_normalMap)
+    {
+        NormalBatch batch = { heights, width, height, 1, 1.0f, coordinates, vertices + 3, vertexElements };
+        calculateNormals(&batch, vertexCount);
+        SAFE_DELETE_ARRAY(coordinates);
+    }
+
+    Vector3 center(min + ((max - min) * 0.5f));
+
+    // Create mesh
+    VertexFormat::Element elements[4];
+    elements[0] = VertexFormat::Element(VertexFormat::POSITION, 3);
+    if (_normalMap)
+    {
+        elements[1] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
+        elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD1, 2);
+    }
+    else
+    {
+        elements[1] = VertexFormat::Element(VertexFormat::NORMAL, 3);
+        elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
+        elements[3] = VertexFormat::Element(VertexFormat::TEXCOORD1, 2);
+    }
+    VertexFormat format(elements, _normalMap ? 3 : 4);
+    Mesh* mesh = Mesh::createMesh(format, vertexCount);
+    mesh->setVertexData(vertices);
+    mesh->setBoundingBox(BoundingBox(min, max));
+    mesh->setBoundingSphere(BoundingSphere(center, center.distance(max)));
+    SAFE_DELETE_ARRAY(vertices);
+
+    _morphModel = Model::create(mesh);
+    mesh->release();
+
+    // Use the shared index buffer of each level
+    for (unsigned int step = 1; step <= maxStep; step *= 2)
+    {
+        _sharedLevels.push_back(getSharedLevel(x2 - x1, z2 - z1, step, skirts));
+    }
+}
+
+TerrainPatch::SharedLevel* TerrainPatch::getSharedLevel(unsigned int columns, unsigned int rows, unsigned int step, bool skirts)
+{
+    std::vector<SharedLevel*>& sharedLevels = _terrain->_sharedLevels;
+    for (size_t i = 0, count = sharedLevels.size(); i < count; ++i)
+    {
+        SharedLevel* level = sharedLevels[i];
+        if (level->columns == columns && level->rows == rows && level->step == step && level->skirts == skirts)
+            return level;
+    }
+
+    // Map the columns and rows of this level to those of the full resolution vertices.
+    unsigned int border = skirts ? 1 : 0;
+    unsigned int vertexWidth = columns + 1 + border * 2;
+    std::vector<unsigned int> levelColumns;
+    std::vector<unsigned int> levelRows;
+    if (skirts)
+    {
+        levelColumns.push_back(0);
+        levelRows.push_back(0);
+    }
+    for (unsigned int x = 0; ; x = std::min(x + step, columns))
+    {
+        levelColumns.push_back(x + border);
+        if (x == columns)
+            break;
+    }
+    for (unsigned int z = 0; ; z = std::min(z + step, rows))
+    {
+        levelRows.push_back(z + border);
+        if (z == rows)
+            break;
+    }
+    if (skirts)
+    {
+        levelColumns.push_back(columns + 2);
+        levelRows.push_back(rows + 2);
+    }
+
+    unsigned int patchWidth = (unsigned int)levelColumns.size();
+    unsigned int patchHeight = (unsigned int)levelRows.size();
+    unsigned int indexCount =
+        (patchWidth * 2) *      // # indices per row of tris
+        (patchHeight - 1) +     // # rows of tris
+        (patchHeight-2) * 2;    // # degenerate tris
+
+    // Build the same triangle strips as addLOD does.
+    unsigned short* indices = new unsigned short[indexCount];
+    unsigned int index = 0;
+    for (unsigned int z = 0; z < patchHeight-1; ++z)
+    {
+        unsigned int i1 = levelRows[z] * vertexWidth;
+        unsigned int i2 = levelRows[z+1] * vertexWidth;
+
+        if (z % 2 == 0)
+        {
+            if (z > 0)
+            {
+                // Add degenerate indices to connect strips
+                indices[index] = indices[index-1];
+                ++index;
+                indices[index++] = i1 + levelColumns[0];
+            }
+
+            // Add row strip
+            for (unsigned int x = 0; x < patchWidth; ++x)
+            {
+                indices[index++] = i1 + levelColumns[x];
+                indices[index++] = i2 + levelColumns[x];
+            }
+        }
+        else
+        {
+            // Add degenerate indices to connect strips
+            if (z > 0)
+            {
+                indices[index] = indices[index-1];
+                ++index;
+                indices[index++] = i2 + levelColumns[patchWidth-1];
+            }
+
+            // Add row strip
+            for (int x = (int)patchWidth-1; x >= 0; --x)
+            {
+                indices[index++] = i2 + levelColumns[x];
+                indices[index++] = i1 + levelColumns[x];
+            }
+        }
+    }
+    GP_ASSERT(index == indexCount);
+
+    SharedLevel* level = new SharedLevel();
+    level->columns = columns;
+    level->rows = rows;
+    level->step = step;
+    level->skirts = skirts;
+    level->indexCount = indexCount;
+    GL_ASSERT( glGenBuffers(1, &level->indexBuffer) );
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, level->indexBuffer);
+    GL_ASSERT( glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned short), indices, GL_STATIC_DRAW) );
+    StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    SAFE_DELETE_ARRAY(indices);
+
+    sharedLevels.push_back(level);
+    return level;
+}
+
 void TerrainPatch::deleteLayer(Layer* layer)
 {
     // Release layer samplers
@@ -356,6 +738,15 @@ int TerrainPatch::addSampler(const char* path)
     if (!texture)
         return -1;
 
+    int index = addSampler(texture);
+    texture->release();
+    return index;
+}
+
+int TerrainPatch::addSampler(Texture* texture)
+{
+    GP_ASSERT(texture);
+
     int firstAvailableIndex = -1;
     for (size_t i = 0, count = _samplers.size(); i < count; ++i)
     {
@@ -370,7 +761,6 @@ int TerrainPatch::addSampler(const char* path)
             // A sampler was already added for this texture.
             // Increase the ref count for the sampler to indicate that a new
             // layer will be referencing it.
-            texture->release();
             sampler->addRef();
             return (int)i;
         }
@@ -378,9 +768,17 @@ int TerrainPatch::addSampler(const char* path)
 
     // Add a new sampler to the list
     Texture::Sampler* sampler = Texture::Sampler::create(texture);
-    texture->release();
-    sampler->setWrapMode(Texture::REPEAT, Texture::REPEAT);
-    sampler->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    if (texture->isMipmapped())
+    {
+        sampler->setWrapMode(Texture::REPEAT, Texture::REPEAT);
+        sampler->setFilterMode(Texture::LINEAR_MIPMAP_LINEAR, Texture::LINEAR);
+    }
+    else
+    {
+        // Textures without mipmaps, such as the blend maps of terrain tiles, may not be a power of two.
+        sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+        sampler->setFilterMode(Texture::LINEAR, Texture::LINEAR);
+    }
     if (firstAvailableIndex != -1)
     {
         _samplers[firstAvailableIndex] = sampler;
@@ -404,10 +802,21 @@ bool TerrainPatch::setLayer(int index, const char* texturePath, const Vector2& t
         }
     }
 
-    // Load texture sampler
-    int textureIndex = addSampler(texturePath);
-    if (textureIndex == -1)
-        return false;
+    // Load texture sampler, or find the texture in the texture array of the terrain
+    int textureIndex = -1;
+    int arrayLayer = -1;
+    if (_terrain->_layerArray)
+    {
+        arrayLayer = _terrain->getArrayLayer(texturePath);
+        if (arrayLayer == -1)
+            return false;
+    }
+    else
+    {
+        textureIndex = addSampler(texturePath);
+        if (textureIndex == -1)
+            return false;
+    }
 
     // Load blend sampler
     int blendIndex = -1;
@@ -415,11 +824,16 @@ bool TerrainPatch::setLayer(int index, const char* texturePath, const Vector2& t
     {
         blendIndex = addSampler(blendPath);
     }
+    else if (_blendMap)
+    {
+        blendIndex = addSampler(_blendMap);
+    }
 
     // Create the layer
     Layer* layer = new Layer();
     layer->index = index;
     layer->textureIndex = textureIndex;
+    layer->arrayLayer = arrayLayer;
     layer->textureRepeat = textureRepeat;
     layer->blendIndex = blendIndex;
     layer->blendChannel = blendChannel;
@@ -428,6 +842,13 @@ bool TerrainPatch::setLayer(int index, const char* texturePath, const Vector2& t
 
     _materialDirty = true;
 
+    // All patches of a texture array terrain are drawn with as many layers as the patch with the most
+    if (_terrain->_layerArray && _layers.size() > _terrain->_arrayLayerCount)
+    {
+        _terrain->_arrayLayerCount = (unsigned int)_layers.size();
+        _terrain->setMaterialsDirty();
+    }
+
     return true;
 }
 
@@ -438,43 +859,94 @@ bool TerrainPatch::updateMaterial()
 
     _materialDirty = false;
 
-    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    // Texture array terrains pass the layers as uniforms, padding missing layers
+    // with layers that are never blended in.
+    unsigned int layerCount = _terrain->_layerArray ? _terrain->_arrayLayerCount : (unsigned int)_layers.size();
+    if (_terrain->_layerArray)
     {
-        // Build preprocessor string to pass to shader.
-        // NOTE: I make heavy use of preprocessor definitions, rather than passing in arrays and doing
-        // non-constant array access in the shader. This is due to the fact that non-constant array access
-        // in GLES is very slow on some GLES 2.x hardware.
-        std::ostringstream defines;
-        defines << "LAYER_COUNT " << _layers.size();
-        defines << ";SAMPLER_COUNT " << _samplers.size();
-        if (_terrain->isFlagSet(Terrain::DEBUG_PATCHES))
-            defines << ";DEBUG_PATCHES";
-        if (_terrain->_normalMap)
-            defines << ";NORMAL_MAP";
-
-        // Append texture and blend index constants to preprocessor definition.
-        // We need to do this since older versions of GLSL only allow sampler arrays
-        // to be indexed using constant expressions (otherwise we could simply pass an
-        // array of indices to use for sampler lookup).
-        //
-        // Rebuild layer lists while we're at it.
-        //
-        int layerIndex = 0;
+        _layerParameters.assign(layerCount, Vector4::zero());
+        _blendChannels.assign(layerCount > 1 ? layerCount - 1 : 0, Vector4::zero());
+        _blendSamplers.assign(_blendChannels.size(), _terrain->_blankBlendMap);
+        unsigned int layerIndex = 0;
         for (std::set<Layer*, LayerCompare>::iterator itr = _layers.begin(); itr != _layers.end(); ++itr, ++layerIndex)
         {
             Layer* layer = *itr;
-
-            defines << ";TEXTURE_INDEX_" << layerIndex << " " << layer->textureIndex;
-            defines << ";TEXTURE_REPEAT_" << layerIndex << " vec2(" << layer->textureRepeat.x << "," << layer->textureRepeat.y << ")";
-
+            _layerParameters[layerIndex].set(layer->textureRepeat.x, layer->textureRepeat.y, (float)layer->arrayLayer, 0.0f);
             if (layerIndex > 0)
             {
-                defines << ";BLEND_INDEX_" << layerIndex << " " << layer->blendIndex;
-                defines << ";BLEND_CHANNEL_" << layerIndex << " " << layer->blendChannel;
+                float channel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                channel[std::min(std::max(layer->blendChannel, 0), 3)] = 1.0f;
+                _blendChannels[layerIndex - 1].set(channel);
+                if (layer->blendIndex != -1)
+                    _blendSamplers[layerIndex - 1] = _samplers[layer->blendIndex];
             }
         }
+    }
 
-        Material* material = Material::create(TERRAIN_VSH, TERRAIN_FSH, defines.str().c_str());
+    // All levels of a geomorphing patch draw the same model.
+    size_t materialCount = _morphModel ? 1 : _levels.size();
+    for (size_t i = 0; i < materialCount; ++i)
+    {
+        Material* material = NULL;
+        if (_terrain->_layerArray)
+        {
+            // Every patch of the terrain uses one of a few permutations, which are looked up by
+            // key so that their definitions are only built once per terrain.
+            EffectPermutations* effects = _terrain->_layerArrayEffects;
+            if (effects == NULL)
+            {
+                effects = _terrain->_layerArrayEffects = EffectPermutations::create(TERRAIN_VSH, TERRAIN_FSH, "TEXTURE_ARRAY");
+                effects->addFeature("LAYER_COUNT", 255);
+                effects->addFeature("DEBUG_PATCHES");
+                effects->addFeature("NORMAL_MAP");
+                effects->addFeature("GEOMORPHING");
+            }
+            EffectPermutations::Key key = effects->setFeature(0, TERRAIN_FEATURE_LAYER_COUNT, layerCount);
+            key = effects->setFeature(key, TERRAIN_FEATURE_DEBUG_PATCHES, _terrain->isFlagSet(Terrain::DEBUG_PATCHES) ? 1 : 0);
+            key = effects->setFeature(key, TERRAIN_FEATURE_NORMAL_MAP, _normalMap ? 1 : 0);
+            key = effects->setFeature(key, TERRAIN_FEATURE_GEOMORPHING, _morphModel ? 1 : 0);
+
+            Effect* effect = effects->getEffect(key);
+            if (effect)
+                material = Material::create(effect);
+        }
+        else
+        {
+            // Build preprocessor string to pass to shader.
+            // NOTE: I make heavy use of preprocessor definitions, rather than passing in arrays and doing
+            // non-constant array access in the shader. This is due to the fact that non-constant array access
+            // in GLES is very slow on some GLES 2.x hardware.
+            std::ostringstream defines;
+            defines << "LAYER_COUNT " << layerCount;
+            defines << ";SAMPLER_COUNT " << _samplers.size();
+            if (_terrain->isFlagSet(Terrain::DEBUG_PATCHES))
+                defines << ";DEBUG_PATCHES";
+            if (_normalMap)
+                defines << ";NORMAL_MAP";
+            if (_morphModel)
+                defines << ";GEOMORPHING";
+
+            // Append texture and blend index constants to preprocessor definition.
+            // We need to do this since older versions of GLSL only allow sampler arrays
+            // to be indexed using constant expressions (otherwise we could simply pass an
+            // array of indices to use for sampler lookup).
+            int layerIndex = 0;
+            for (std::set<Layer*, LayerCompare>::iterator itr = _layers.begin(); itr != _layers.end(); ++itr, ++layerIndex)
+            {
+                Layer* layer = *itr;
+
+                defines << ";TEXTURE_INDEX_" << layerIndex << " " << layer->textureIndex;
+                defines << ";TEXTURE_REPEAT_" << layerIndex << " vec2(" << layer->textureRepeat.x << "," << layer->textureRepeat.y << ")";
+
+                if (layerIndex > 0)
+                {
+                    defines << ";BLEND_INDEX_" << layerIndex << " " << layer->blendIndex;
+                    defines << ";BLEND_CHANNEL_" << layerIndex << " " << layer->blendChannel;
+                }
+            }
+
+            material = Material::create(TERRAIN_VSH, TERRAIN_FSH, defines.str().c_str());
+        }
         if (!material)
             return false;
         material->getStateBlock()->setCullFace(true);
@@ -482,15 +954,29 @@ bool TerrainPatch::updateMaterial()
 
         // Set material parameter bindings
         material->getParameter("u_worldViewProjectionMatrix")->bindValue(_terrain, &Terrain::getWorldViewProjectionMatrix);
-        if (_terrain->_normalMap)
-            material->getParameter("u_normalMap")->setValue(_terrain->_normalMap);
+        if (_normalMap)
+            material->getParameter("u_normalMap")->setValue(_normalMap);
         else
             material->getParameter("u_normalMatrix")->bindValue(_terrain, &Terrain::getNormalMatrix);
         material->getParameter("u_ambientColor")->bindValue(this, &TerrainPatch::getAmbientColor);
         material->getParameter("u_lightColor")->bindValue(this, &TerrainPatch::getLightColor);
         material->getParameter("u_lightDirection")->bindValue(this, &TerrainPatch::getLightDirection);
-        if (_layers.size() > 0)
+        if (_morphModel)
+            material->getParameter("u_morph")->bindValue(this, &TerrainPatch::getMorph);
+        if (_terrain->_layerArray && layerCount > 0)
+        {
+            material->getParameter("u_layerArray")->setValue(_terrain->_layerArray);
+            material->getParameter("u_layers")->setValue(&_layerParameters[0], layerCount);
+            if (layerCount > 1)
+            {
+                material->getParameter("u_blendChannels")->setValue(&_blendChannels[0], layerCount - 1);
+                material->getParameter("u_blendMaps")->setValue((const Texture::Sampler**)&_blendSamplers[0], layerCount - 1);
+            }
+        }
+        else if (_layers.size() > 0)
+        {
             material->getParameter("u_samplers")->setValue((const Texture::Sampler**)&_samplers[0], (unsigned int)_samplers.size());
+        }
 
         if (_terrain->isFlagSet(Terrain::DEBUG_PATCHES))
         {
@@ -505,7 +991,10 @@ bool TerrainPatch::updateMaterial()
         }
 
         // Set material on this lod level
-        _levels[i]->model->setMaterial(material);
+        if (_morphModel)
+            _morphModel->setMaterial(material);
+        else
+            _levels[i]->model->setMaterial(material);
 
         material->release();
     }
@@ -527,14 +1016,43 @@ void TerrainPatch::draw(bool wireframe)
     if (_terrain->isFlagSet(Terrain::FRUSTUM_CULLING) && !camera->getFrustum().intersects(bounds))
         return;
 
+    draw(camera, bounds, wireframe);
+}
+
+void TerrainPatch::draw(Camera* camera, const BoundingBox& bounds, bool wireframe)
+{
     if (!updateMaterial())
         return;
 
-    // Compute the LOD level from the camera's perspective
-    size_t lod = computeLOD(camera, bounds);
+    if (!_morphModel)
+    {
+        // Compute the LOD level from the camera's perspective
+        size_t lod = computeLOD(camera, bounds);
 
-    // Draw the model for the current LOD
-    _levels[lod]->model->draw(wireframe);
+        // Draw the model for the current LOD
+        _levels[lod]->model->draw(wireframe);
+        return;
+    }
+
+    // Draw the shared indices of the current LOD, morphing towards the next level
+    float value = computeLODValue(camera, bounds);
+    size_t lod = (size_t)value;
+    _morph.set((float)lod, value - lod);
+
+    const SharedLevel* level = _sharedLevels[lod];
+    GLenum primitiveType = wireframe ? GL_LINE_STRIP : GL_TRIANGLE_STRIP;
+    Technique* technique = _morphModel->getMaterial()->getTechnique();
+    GP_ASSERT(technique);
+    for (unsigned int i = 0, passCount = technique->getPassCount(); i < passCount; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+        pass->bind();
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, level->indexBuffer);
+        RenderCommandList::drawElements(primitiveType, level->indexCount, GL_UNSIGNED_SHORT, 0);
+        RenderStats::addDrawCall(primitiveType, level->indexCount);
+        pass->unbind();
+    }
 }
 
 bool TerrainPatch::isVisible() const
@@ -555,7 +1073,7 @@ bool TerrainPatch::isVisible() const
 unsigned int TerrainPatch::getTriangleCount() const
 {
     // Patches are made up of a single mesh part using triangle strips
-    return _levels[0]->model->getMesh()->getPart(0)->getIndexCount() - 2;
+    return getIndexCount(0) - 2;
 }
 
 unsigned int TerrainPatch::getVisibleTriangleCount() const
@@ -575,7 +1093,19 @@ unsigned int TerrainPatch::getVisibleTriangleCount() const
 
     // Return the triangle count of the LOD level depending on the camera
     size_t lod = computeLOD(camera, bounds);
-    return _levels[lod]->model->getMesh()->getPart(0)->getIndexCount() - 2;
+    return getIndexCount(lod) - 2;
+}
+
+size_t TerrainPatch::getLevelCount() const
+{
+    return _morphModel ? _sharedLevels.size() : _levels.size();
+}
+
+unsigned int TerrainPatch::getIndexCount(size_t lod) const
+{
+    if (_morphModel)
+        return _sharedLevels[lod]->indexCount;
+    return _levels[lod]->model->getMesh()->getPart(0)->getIndexCount();
 }
 
 BoundingBox TerrainPatch::getBoundingBox(bool worldSpace) const
@@ -620,10 +1150,20 @@ const Vector3& TerrainPatch::getLightDirection() const
     return scene->getLightDirection();
 }
 
+const Vector2& TerrainPatch::getMorph() const
+{
+    return _morph;
+}
+
 size_t TerrainPatch::computeLOD(Camera* camera, const BoundingBox& worldBounds) const
 {
-    if (!_terrain->isFlagSet(Terrain::LEVEL_OF_DETAIL) || _levels.size() == 0)
-        return 0; // base level
+    return (size_t)computeLODValue(camera, worldBounds);
+}
+
+float TerrainPatch::computeLODValue(Camera* camera, const BoundingBox& worldBounds) const
+{
+    if (!_terrain->isFlagSet(Terrain::LEVEL_OF_DETAIL) || getLevelCount() == 0)
+        return 0.0f; // base level
 
     // Compute LOD to use based on very simple distance metric.
     // TODO: Optimize this.
@@ -652,11 +1192,8 @@ size_t TerrainPatch::computeLOD(Camera* camera, const BoundingBox& worldBounds)
     float error = screenArea / area;
 
     // Level LOD based on distance from camera
-    size_t maxLod = _levels.size()-1;
-    size_t lod = (size_t)error;
-    lod = std::max(lod, (size_t)0);
-    lod = std::min(lod, maxLod);
-    return lod;
+    float maxLod = (float)(getLevelCount()-1);
+    return clamp(error, 0.0f, maxLod);
 }
 
 float calculateHeight(float* heights, unsigned int width, unsigned int height, unsigned int x, unsigned int z)
@@ -665,7 +1202,7 @@ float calculateHeight(float* heights, unsigned int width, unsigned int height, u
 }
 
 TerrainPatch::Layer::Layer() :
-    index(0), row(-1), column(-1), textureIndex(-1), blendIndex(-1)
+    index(0), row(-1), column(-1), textureIndex(-1), arrayLayer(-1), blendIndex(-1)
 {
 }
 
@@ -677,6 +1214,20 @@ TerrainPatch::Level::Level() : model(NULL)
 {
 }
 
+TerrainPatch::SharedLevel::SharedLevel() :
+    columns(0), rows(0), step(0), skirts(false), indexBuffer(0), indexCount(0)
+{
+}
+
+TerrainPatch::SharedLevel::~SharedLevel()
+{
+    if (indexBuffer)
+    {
+        StateCache::deleteBuffers(1, &indexBuffer);
+        indexBuffer = 0;
+    }
+}
+
 bool TerrainPatch::LayerCompare::operator() (const Layer* lhs, const Layer* rhs) const
 {
     return (lhs->index < rhs->index);
@@ -19,6 +19,8 @@ class Terrain;
 class TerrainPatch
 {
     friend class Terrain;
+    friend class TerrainPager;
+    friend class TerrainDetail;
 
 private:
 
@@ -33,6 +35,7 @@ private:
         int row;
         int column;
         int textureIndex;
+        int arrayLayer;
         Vector2 textureRepeat;
         int blendIndex;
         int blendChannel;
@@ -45,6 +48,26 @@ private:
         Level();
     };
 
+    /**
+     * Index buffer for one LOD level of a geomorphing patch.
+     *
+     * Patches of the same size index their full resolution vertices the same
+     * way, so the index buffer of each level is created once and shared by
+     * all patches through the terrain.
+     */
+    struct SharedLevel
+    {
+        unsigned int columns;
+        unsigned int rows;
+        unsigned int step;
+        bool skirts;
+        IndexBufferHandle indexBuffer;
+        unsigned int indexCount;
+
+        SharedLevel();
+        ~SharedLevel();
+    };
+
     struct LayerCompare
     {
         bool operator() (const Layer* lhs, const Layer* rhs) const;
@@ -77,7 +100,8 @@ private:
                                 unsigned int row, unsigned int column,
                                 float* heights, unsigned int width, unsigned int height,
                                 unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
-                                float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize);
+                                float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize,
+                                float spacing, Texture::Sampler* normalMap, Texture* blendMap);
 
     /**
      * Adds a single LOD level to the terrain patch.
@@ -86,6 +110,18 @@ private:
                 unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
                 float xOffset, float zOffset, unsigned int step, float verticalSkirtSize);
 
+    /**
+     * Adds the full resolution geometry and the shared LOD levels of a geomorphing patch.
+     */
+    void addMorphLevels(float* heights, unsigned int width, unsigned int height,
+                        unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+                        float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize);
+
+    /**
+     * Returns the shared LOD level for a patch of the given size, creating it if needed.
+     */
+    SharedLevel* getSharedLevel(unsigned int columns, unsigned int rows, unsigned int step, bool skirts);
+
     /**
      * Sets details for a layer of this patch.
      */
@@ -96,6 +132,11 @@ private:
      */
     int addSampler(const char* path);
 
+    /**
+     * Adds a sampler for a loaded texture to the patch.
+     */
+    int addSampler(Texture* texture);
+
     /**
      * Deletes the specified layer.
      */
@@ -121,6 +162,11 @@ private:
      */
     void draw(bool wireframe);
 
+    /**
+     * Draws the terrain patch for a camera, without culling it.
+     */
+    void draw(Camera* camera, const BoundingBox& worldBounds, bool wireframe);
+
     /**
      * Updates the material for the patch.
      */
@@ -131,6 +177,21 @@ private:
      */
     size_t computeLOD(Camera* camera, const BoundingBox& worldBounds) const;
 
+    /**
+     * Computes the continuous LOD for this patch, whose fraction is the morph towards the next level.
+     */
+    float computeLODValue(Camera* camera, const BoundingBox& worldBounds) const;
+
+    /**
+     * Returns the number of LOD levels of this patch.
+     */
+    size_t getLevelCount() const;
+
+    /**
+     * Returns the index count of the specified LOD level.
+     */
+    unsigned int getIndexCount(size_t lod) const;
+
     /**
      * Returns the local bounding box for this patch, at the base LOD level.
      */
@@ -142,14 +203,25 @@ private:
 
     const Vector3& getLightDirection() const;
 
+    const Vector2& getMorph() const;
+
     Terrain* _terrain;
     std::vector<Level*> _levels;
+    Model* _morphModel;
+    std::vector<SharedLevel*> _sharedLevels;
+    Vector2 _morph;
     unsigned int _row;
     unsigned int _column;
     std::set<Layer*, LayerCompare> _layers;
     std::vector<Texture::Sampler*> _samplers;
     bool _materialDirty;
     BoundingBox _boundingBox;
+    float _spacing;
+    Texture::Sampler* _normalMap;
+    Texture* _blendMap;
+    std::vector<Vector4> _layerParameters;          // Texture repeat and array layer of each layer, in a texture array terrain.
+    std::vector<Vector4> _blendChannels;
+    std::vector<Texture::Sampler*> _blendSamplers;
 
 };
 
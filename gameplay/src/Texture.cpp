@@ -2,6 +2,14 @@
 #include "Image.h"
 #include "Texture.h"
 #include "FileSystem.h"
+#include "Game.h"
+#include "LoadProfiler.h"
+#include "DebugMarkers.h"
+#include "ResourceCache.h"
+#include "RenderStats.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "Allocator.h"
 
 // PVRTC (GL_IMG_texture_compression_pvrtc) : Imagination based gpus
 #ifndef GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG
@@ -39,33 +47,150 @@
 #define ATC_RGBA_INTERPOLATED_ALPHA_AMD 0x87EE
 #endif
 
+// S3TC/DXT1 without alpha (GL_EXT_texture_compression_s3tc)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+// sRGB S3TC/DXT (GL_EXT_texture_sRGB, GL_EXT_texture_compression_s3tc_srgb)
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// RGTC/BC4-5 (GL_ARB_texture_compression_rgtc) : Desktop gpus
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+#ifndef GL_COMPRESSED_SIGNED_RED_RGTC1
+#define GL_COMPRESSED_SIGNED_RED_RGTC1 0x8DBC
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+#ifndef GL_COMPRESSED_SIGNED_RG_RGTC2
+#define GL_COMPRESSED_SIGNED_RG_RGTC2 0x8DBE
+#endif
+
+// BPTC/BC6H-7 (GL_ARB_texture_compression_bptc) : Desktop gpus
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+#define GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT 0x8E8E
+#endif
+#ifndef GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+#define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT 0x8E8F
+#endif
+
+// ETC1 (GL_OES_compressed_ETC1_RGB8_texture) : Most GL ES 2 gpus
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+// ETC2/EAC (GL ES 3, GL_ARB_ES3_compatibility) : Most GL ES 3 gpus
+#ifndef GL_COMPRESSED_R11_EAC
+#define GL_COMPRESSED_R11_EAC 0x9270
+#endif
+#ifndef GL_COMPRESSED_SIGNED_R11_EAC
+#define GL_COMPRESSED_SIGNED_R11_EAC 0x9271
+#endif
+#ifndef GL_COMPRESSED_RG11_EAC
+#define GL_COMPRESSED_RG11_EAC 0x9272
+#endif
+#ifndef GL_COMPRESSED_SIGNED_RG11_EAC
+#define GL_COMPRESSED_SIGNED_RG11_EAC 0x9273
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC 0x9279
+#endif
+
+// ASTC LDR (GL_KHR_texture_compression_astc_ldr) : Recent mobile gpus
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_12x12_KHR
+#define GL_COMPRESSED_RGBA_ASTC_12x12_KHR 0x93BD
+#endif
+#ifndef GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+#endif
+#ifndef GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR
+#define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR 0x93DD
+#endif
+
 namespace gameplay
 {
 
-static std::vector<Texture*> __textureCache;
+static ResourceCache __textureCache("textures");
 static TextureHandle __currentTextureId;
+static bool __premultipliedAlpha = false;
+
+// The shared sampler objects, by their packed wrap and filter modes.
+static std::map<unsigned long long, GLuint> __samplerObjects;
 
-Texture::Texture() : _handle(0), _format(UNKNOWN), _width(0), _height(0), _mipmapped(false), _cached(false), _compressed(false),
-    _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _minFilter(Texture::NEAREST_MIPMAP_LINEAR), _magFilter(Texture::LINEAR)
+// The preprocessed variants of a PNG file that are looked for, 'name.<family>.ktx',
+// in order of preference, with a format of the family to check for GPU support.
+// The uncompressed "raw" variant has no format to check and is always supported.
+static const struct
+{
+    const char* family;
+    GLenum format;
+} __compressedVariants[] =
+{
+    { "astc", GL_COMPRESSED_RGBA_ASTC_4x4_KHR },
+    { "bc", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },
+    { "etc2", GL_COMPRESSED_RGBA8_ETC2_EAC },
+    { "etc1", GL_ETC1_RGB8_OES },
+    { "raw", 0 }
+};
+
+static const unsigned char KTX_IDENTIFIER[] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char KTX2_IDENTIFIER[] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// Gets the number of bytes per pixel of an uncompressed texture format.
+static unsigned int getBytesPerPixel(Texture::Format format)
+{
+    return format == Texture::RGBA ? 4 : (format == Texture::RGB ? 3 : 1);
+}
+
+Texture::Texture() : _handle(0), _format(UNKNOWN), _width(0), _height(0), _layerCount(1), _target(GL_TEXTURE_2D), _mipmapped(false), _cached(false), _compressed(false),
+    _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _minFilter(Texture::NEAREST_MIPMAP_LINEAR), _magFilter(Texture::LINEAR),
+    _mipLevelCount(1), _residentLevel(0), _memorySize(0), _streamed(false), _lastUsedFrame(0), _requestedSize(0.0f), _requestedLevel(0)
 {
 }
 
 Texture::~Texture()
 {
+    if (_streamed)
+    {
+        TextureStreamer* streamer = Game::getInstance()->getTextureStreamer();
+        if (streamer)
+            streamer->remove(this);
+    }
+
     if (_handle)
     {
-        GL_ASSERT( glDeleteTextures(1, &_handle) );
+        StateCache::deleteTexture(_handle);
         _handle = 0;
     }
+    setMemorySize(0);
 
     // Remove ourself from the texture cache.
     if (_cached)
     {
-        std::vector<Texture*>::iterator itr = std::find(__textureCache.begin(), __textureCache.end(), this);
-        if (itr != __textureCache.end())
-        {
-            __textureCache.erase(itr);
-        }
+        __textureCache.remove(ResourceCache::Key(_path.c_str()), this);
     }
 }
 
@@ -74,69 +199,141 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
     GP_ASSERT(path);
 
     // Search texture cache first.
-    for (size_t i = 0, count = __textureCache.size(); i < count; ++i)
+    ResourceCache::Key key(path);
+    Texture* t = static_cast<Texture*>(__textureCache.find(key));
+    if (t)
     {
-        Texture* t = __textureCache[i];
-        GP_ASSERT(t);
-        if (t->_path == path)
+        // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the 
+        // texture to generate its mipmap chain if it hasn't already done so.
+        if (generateMipmaps)
         {
-            // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the 
-            // texture to generate its mipmap chain if it hasn't already done so.
-            if (generateMipmaps)
-            {
-                t->generateMipmaps();
-            }
+            t->generateMipmaps();
+        }
 
-            // Found a match.
-            t->addRef();
+        // Found a match.
+        t->addRef();
 
-            return t;
-        }
+        return t;
     }
 
+    LoadProfiler::Scope profile("texture", path);
     Texture* texture = NULL;
 
+    // Streamed textures start with their small mip levels only.
+    TextureStreamer* streamer = Game::getInstance()->getTextureStreamer();
+    unsigned int maxSize = (streamer && streamer->isEnabled()) ? streamer->getInitialSize() : 0;
+
     // Filter loading based on file extension.
-    const char* ext = strrchr(FileSystem::resolvePath(path), '.');
-    if (ext)
+    std::string filePath = getCompressedVariant(path);
+    const char* ext = strrchr(FileSystem::resolvePath(filePath.c_str()), '.');
+    if (ext && strlen(ext) == 4 && tolower(ext[1]) == 'p' && tolower(ext[2]) == 'n' && tolower(ext[3]) == 'g')
+    {
+        Image* image = Image::create(path, __premultipliedAlpha);
+        if (image)
+            texture = create(image, generateMipmaps);
+        SAFE_RELEASE(image);
+    }
+    else
     {
-        switch (strlen(ext))
+        texture = createCompressed(filePath.c_str(), maxSize, NULL);
+    }
+
+    if (texture)
+    {
+        addLoaded(path, texture);
+        return texture;
+    }
+
+    GP_ERROR("Failed to load texture from file '%s'.", path);
+    return NULL;
+}
+
+unsigned int Texture::createBatch(const char** paths, unsigned int count, Texture** textures, bool generateMipmaps)
+{
+    GP_ASSERT(paths || count == 0);
+    GP_ASSERT(textures || count == 0);
+
+    // Collect the PNG files that are not loaded yet, every file only once.
+    std::vector<const char*> decodePaths;
+    std::vector<unsigned int> decodeIndices;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        textures[i] = NULL;
+        const char* path = paths[i];
+        if (path == NULL || __textureCache.find(ResourceCache::Key(path)))
+            continue;
+        const char* ext = strrchr(FileSystem::resolvePath(path), '.');
+        if (ext == NULL || strlen(ext) != 4 || tolower(ext[1]) != 'p' || tolower(ext[2]) != 'n' || tolower(ext[3]) != 'g')
+            continue;
+        if (getCompressedVariant(path) != path)
+            continue;
+        bool duplicate = false;
+        for (size_t j = 0, decodeCount = decodePaths.size(); j < decodeCount && !duplicate; ++j)
+            duplicate = strcmp(decodePaths[j], path) == 0;
+        if (duplicate)
+            continue;
+        decodePaths.push_back(path);
+        decodeIndices.push_back(i);
+    }
+
+    unsigned int created = 0;
+    if (!decodePaths.empty())
+    {
+        std::vector<Image*> images(decodePaths.size());
+        Image::createBatch(&decodePaths[0], (unsigned int)decodePaths.size(), &images[0], __premultipliedAlpha);
+        for (size_t j = 0, decodeCount = images.size(); j < decodeCount; ++j)
         {
-        case 4:
-            if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'n' && tolower(ext[3]) == 'g')
-            {
-                Image* image = Image::create(path);
-                if (image)
-                    texture = create(image, generateMipmaps);
-                SAFE_RELEASE(image);
-            }
-            else if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'v' && tolower(ext[3]) == 'r')
+            if (images[j] == NULL)
+                continue;
+            Texture* texture = create(images[j], generateMipmaps);
+            SAFE_RELEASE(images[j]);
+            if (texture)
             {
-                // PowerVR Compressed Texture RGBA.
-                texture = createCompressedPVRTC(path);
+                addLoaded(decodePaths[j], texture);
+                textures[decodeIndices[j]] = texture;
+                ++created;
             }
-            else if (tolower(ext[1]) == 'd' && tolower(ext[2]) == 'd' && tolower(ext[3]) == 's')
-            {
-                // DDS file format (DXT/S3TC) compressed textures
-                texture = createCompressedDDS(path);
-            }
-            break;
         }
     }
 
-    if (texture)
+    // Everything else, including the repeated and failed files, loads as usual.
+    for (unsigned int i = 0; i < count; ++i)
     {
-        texture->_path = path;
-        texture->_cached = true;
+        if (textures[i] == NULL && paths[i])
+        {
+            textures[i] = create(paths[i], generateMipmaps);
+            if (textures[i])
+                ++created;
+        }
+    }
+    return created;
+}
+
+void Texture::setPremultipliedAlpha(bool premultiply)
+{
+    __premultipliedAlpha = premultiply;
+}
 
-        // Add to texture cache.
-        __textureCache.push_back(texture);
+bool Texture::isPremultipliedAlpha()
+{
+    return __premultipliedAlpha;
+}
 
-        return texture;
-    }
+void Texture::addLoaded(const char* path, Texture* texture)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(texture);
 
-    GP_ERROR("Failed to load texture from file '%s'.", path);
-    return NULL;
+    texture->_path = path;
+    texture->_cached = true;
+    DebugMarkers::setLabel(GL_TEXTURE, texture->_handle, path);
+
+    // Add to texture cache.
+    __textureCache.add(ResourceCache::Key(path), texture);
+
+    TextureStreamer* streamer = Game::getInstance()->getTextureStreamer();
+    if (streamer)
+        streamer->add(texture);
 }
 
 Texture* Texture::create(Image* image, bool generateMipmaps)
@@ -158,11 +355,16 @@ Texture* Texture::create(Image* image, bool generateMipmaps)
 Texture* Texture::create(Format format, unsigned int width, unsigned int height, unsigned char* data, bool generateMipmaps)
 {
     // Create and load the texture.
+    LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    bindTexture(textureId);
     GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
     GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, (GLenum)format, width, height, 0, (GLenum)format, GL_UNSIGNED_BYTE, data) );
+    if (data)
+    {
+        RenderStats::addUpload(width * height * getBytesPerPixel(format));
+    }
 
     // Set initial minification filter based on whether or not mipmaping was enabled.
     Filter minFilter = generateMipmaps ? NEAREST_MIPMAP_LINEAR : LINEAR;
@@ -174,13 +376,14 @@ Texture* Texture::create(Format format, unsigned int width, unsigned int height,
     texture->_width = width;
     texture->_height = height;
     texture->_minFilter = minFilter;
+    texture->setMemorySize(width * height * getBytesPerPixel(format));
     if (generateMipmaps)
     {
         texture->generateMipmaps();
     }
 
     // Restore the texture id
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, __currentTextureId) );
+    bindTexture(__currentTextureId);
 
     return texture;
 }
@@ -194,8 +397,78 @@ Texture* Texture::create(TextureHandle handle, int width, int height, Format for
     texture->_format = format;
     texture->_width = width;
     texture->_height = height;
+    texture->setMemorySize(width * height * getBytesPerPixel(format));
+
+    return texture;
+}
+
+Texture* Texture::createArray(Image** images, unsigned int count, bool generateMipmaps)
+{
+    GP_ASSERT(images);
+
+#ifdef USE_TEXTURE_ARRAYS
+    if (count == 0 || !(GLEW_VERSION_3_0 || GLEW_EXT_texture_array))
+    {
+        GP_WARN("Texture arrays are not supported.");
+        return NULL;
+    }
+
+    unsigned int width = images[0]->getWidth();
+    unsigned int height = images[0]->getHeight();
+    Image::Format imageFormat = images[0]->getFormat();
+    if (imageFormat != Image::RGB && imageFormat != Image::RGBA)
+    {
+        GP_WARN("Unsupported image format (%d) for a texture array.", imageFormat);
+        return NULL;
+    }
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        if (images[i]->getWidth() != width || images[i]->getHeight() != height || images[i]->getFormat() != imageFormat)
+        {
+            GP_WARN("Texture array layer %d does not match the size and format of the first layer.", i);
+            return NULL;
+        }
+    }
+    Format format = imageFormat == Image::RGBA ? RGBA : RGB;
+    unsigned int bpp = format == RGBA ? 4 : 3;
+
+    // Allocate all layers, then upload them one by one.
+    GLuint textureId;
+    GL_ASSERT( glGenTextures(1, &textureId) );
+    bindTexture(GL_TEXTURE_2D_ARRAY, textureId);
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    GL_ASSERT( glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, (GLenum)format, width, height, count, 0, (GLenum)format, GL_UNSIGNED_BYTE, NULL) );
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        GL_ASSERT( glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, (GLenum)format, GL_UNSIGNED_BYTE, images[i]->getData()) );
+    }
+    RenderStats::addUpload(width * height * bpp * count);
+
+    Filter minFilter = generateMipmaps ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter) );
+
+    Texture* texture = new Texture();
+    texture->_handle = textureId;
+    texture->_format = format;
+    texture->_width = width;
+    texture->_height = height;
+    texture->_layerCount = count;
+    texture->_target = GL_TEXTURE_2D_ARRAY;
+    texture->_minFilter = minFilter;
+    texture->setMemorySize(width * height * bpp * count);
+    if (generateMipmaps)
+    {
+        texture->generateMipmaps();
+    }
+
+    // Restore the texture id
+    bindTexture(__currentTextureId);
 
     return texture;
+#else
+    GP_WARN("Texture arrays are not supported on this platform.");
+    return NULL;
+#endif
 }
 
 // Computes the size of a PVRTC data chunk for a mipmap level of the given size.
@@ -221,7 +494,449 @@ static unsigned int computePVRTCDataSize(int width, int height, int bpp)
     return widthBlocks * heightBlocks * ((blockSize  * bpp) >> 3);
 }
 
-Texture* Texture::createCompressedPVRTC(const char* path)
+bool Texture::isCompressedFormatSupported(GLenum format)
+{
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions == NULL)
+        extensions = "";
+    const char* version = (const char*)glGetString(GL_VERSION);
+    bool es3 = version && strstr(version, "OpenGL ES 3");
+
+    if (format == GL_ETC1_RGB8_OES)
+    {
+        // ETC2 decoders also decode ETC1.
+        return strstr(extensions, "GL_OES_compressed_ETC1_RGB8_texture") || es3 || strstr(extensions, "GL_ARB_ES3_compatibility");
+    }
+    if (format >= GL_COMPRESSED_R11_EAC && format <= GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC)
+    {
+        return es3 || strstr(extensions, "GL_ARB_ES3_compatibility") || strstr(extensions, "GL_OES_compressed_ETC2");
+    }
+    if ((format >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && format <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR) ||
+        (format >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && format <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR))
+    {
+        return strstr(extensions, "GL_KHR_texture_compression_astc_ldr") || strstr(extensions, "GL_OES_texture_compression_astc");
+    }
+    if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+    {
+        return strstr(extensions, "GL_EXT_texture_compression_s3tc") || strstr(extensions, "GL_EXT_texture_compression_dxt1");
+    }
+    if (format >= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT && format <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    {
+        return strstr(extensions, "GL_EXT_texture_compression_s3tc") != NULL;
+    }
+    if (format >= GL_COMPRESSED_SRGB_S3TC_DXT1_EXT && format <= GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT)
+    {
+        return strstr(extensions, "GL_EXT_texture_compression_s3tc") && (strstr(extensions, "GL_EXT_texture_sRGB") || strstr(extensions, "GL_EXT_texture_compression_s3tc_srgb"));
+    }
+    if (format >= GL_COMPRESSED_RED_RGTC1 && format <= GL_COMPRESSED_SIGNED_RG_RGTC2)
+    {
+        return strstr(extensions, "GL_ARB_texture_compression_rgtc") || strstr(extensions, "GL_EXT_texture_compression_rgtc");
+    }
+    if (format >= GL_COMPRESSED_RGBA_BPTC_UNORM && format <= GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT)
+    {
+        return strstr(extensions, "GL_ARB_texture_compression_bptc") || strstr(extensions, "GL_EXT_texture_compression_bptc");
+    }
+
+    // Leave all other formats to the GL implementation.
+    return true;
+}
+
+std::string Texture::getCompressedVariant(const char* path)
+{
+    GP_ASSERT(path);
+
+    size_t length = strlen(path);
+    if (length < 4 || strcmp(path + length - 4, ".png") != 0)
+        return path;
+
+    std::string base(path, length - 4);
+    for (size_t i = 0, count = sizeof(__compressedVariants) / sizeof(__compressedVariants[0]); i < count; ++i)
+    {
+        if (__compressedVariants[i].format != 0 && !isCompressedFormatSupported(__compressedVariants[i].format))
+            continue;
+        std::string variant = base + "." + __compressedVariants[i].family + ".ktx";
+        if (FileSystem::fileExists(variant.c_str()))
+            return variant;
+    }
+    return path;
+}
+
+Texture* Texture::createCompressed(const char* path, unsigned int maxSize, Texture* texture)
+{
+    GP_ASSERT(path);
+
+    const char* ext = strrchr(FileSystem::resolvePath(path), '.');
+    if (ext == NULL)
+        return NULL;
+
+    switch (strlen(ext))
+    {
+    case 4:
+        if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'v' && tolower(ext[3]) == 'r')
+        {
+            // PowerVR Compressed Texture RGBA.
+            return createCompressedPVRTC(path, maxSize, texture);
+        }
+        else if (tolower(ext[1]) == 'd' && tolower(ext[2]) == 'd' && tolower(ext[3]) == 's')
+        {
+            // DDS file format (DXT/S3TC) compressed textures
+            return createCompressedDDS(path, maxSize, texture);
+        }
+        else if (tolower(ext[1]) == 'k' && tolower(ext[2]) == 't' && tolower(ext[3]) == 'x')
+        {
+            // KTX file format (ETC/ASTC/BC) compressed textures
+            return createCompressedKTX(path, maxSize, texture);
+        }
+        break;
+    case 5:
+        if (tolower(ext[1]) == 'k' && tolower(ext[2]) == 't' && tolower(ext[3]) == 'x' && ext[4] == '2')
+        {
+            return createCompressedKTX(path, maxSize, texture);
+        }
+        break;
+    }
+    return NULL;
+}
+
+// Gets the GL format of a KTX2 Vulkan format, or zero if it is not supported.
+// The sRGB formats are sampled like their linear counterparts, as PNG textures are.
+static GLenum getKTX2Format(unsigned int vkFormat, bool* compressed)
+{
+    *compressed = true;
+    switch (vkFormat)
+    {
+    case 23: case 29:   // VK_FORMAT_R8G8B8_UNORM/SRGB
+        *compressed = false;
+        return GL_RGB;
+    case 37: case 43:   // VK_FORMAT_R8G8B8A8_UNORM/SRGB
+        *compressed = false;
+        return GL_RGBA;
+    case 131: case 132: // VK_FORMAT_BC1_RGB_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case 133: case 134: // VK_FORMAT_BC1_RGBA_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case 135: case 136: // VK_FORMAT_BC2_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case 137: case 138: // VK_FORMAT_BC3_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case 139:           // VK_FORMAT_BC4_UNORM_BLOCK
+        return GL_COMPRESSED_RED_RGTC1;
+    case 140:           // VK_FORMAT_BC4_SNORM_BLOCK
+        return GL_COMPRESSED_SIGNED_RED_RGTC1;
+    case 141:           // VK_FORMAT_BC5_UNORM_BLOCK
+        return GL_COMPRESSED_RG_RGTC2;
+    case 142:           // VK_FORMAT_BC5_SNORM_BLOCK
+        return GL_COMPRESSED_SIGNED_RG_RGTC2;
+    case 143:           // VK_FORMAT_BC6H_UFLOAT_BLOCK
+        return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+    case 144:           // VK_FORMAT_BC6H_SFLOAT_BLOCK
+        return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+    case 145: case 146: // VK_FORMAT_BC7_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case 147: case 148: // VK_FORMAT_ETC2_R8G8B8_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGB8_ETC2;
+    case 149: case 150: // VK_FORMAT_ETC2_R8G8B8A1_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    case 151: case 152: // VK_FORMAT_ETC2_R8G8B8A8_UNORM/SRGB_BLOCK
+        return GL_COMPRESSED_RGBA8_ETC2_EAC;
+    case 153:           // VK_FORMAT_EAC_R11_UNORM_BLOCK
+        return GL_COMPRESSED_R11_EAC;
+    case 154:           // VK_FORMAT_EAC_R11_SNORM_BLOCK
+        return GL_COMPRESSED_SIGNED_R11_EAC;
+    case 155:           // VK_FORMAT_EAC_R11G11_UNORM_BLOCK
+        return GL_COMPRESSED_RG11_EAC;
+    case 156:           // VK_FORMAT_EAC_R11G11_SNORM_BLOCK
+        return GL_COMPRESSED_SIGNED_RG11_EAC;
+    }
+
+    // VK_FORMAT_ASTC_4x4_UNORM_BLOCK to VK_FORMAT_ASTC_12x12_SRGB_BLOCK, UNORM and SRGB
+    // alternating, in the same block size order as the GL formats.
+    if (vkFormat >= 157 && vkFormat <= 184)
+        return GL_COMPRESSED_RGBA_ASTC_4x4_KHR + (vkFormat - 157) / 2;
+
+    return 0;
+}
+
+/**
+ * The position and size of a mip level of a KTX file.
+ */
+struct KTXMipLevel
+{
+    unsigned int offset;
+    GLsizei width;
+    GLsizei height;
+    GLsizei size;
+};
+
+static unsigned int swapBytes(unsigned int value)
+{
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+Texture* Texture::createCompressedKTX(const char* path, unsigned int maxSize, Texture* texture)
+{
+    GP_ASSERT(path);
+
+    // KTX 1.1 file header, following the identifier.
+    struct ktx_header
+    {
+        unsigned int endianness;
+        unsigned int glType;
+        unsigned int glTypeSize;
+        unsigned int glFormat;
+        unsigned int glInternalFormat;
+        unsigned int glBaseInternalFormat;
+        unsigned int pixelWidth;
+        unsigned int pixelHeight;
+        unsigned int pixelDepth;
+        unsigned int numberOfArrayElements;
+        unsigned int numberOfFaces;
+        unsigned int numberOfMipmapLevels;
+        unsigned int bytesOfKeyValueData;
+    };
+
+    // KTX 2.0 file header, following the identifier, up to the 64-bit fields that are not used.
+    struct ktx2_header
+    {
+        unsigned int vkFormat;
+        unsigned int typeSize;
+        unsigned int pixelWidth;
+        unsigned int pixelHeight;
+        unsigned int pixelDepth;
+        unsigned int layerCount;
+        unsigned int faceCount;
+        unsigned int levelCount;
+        unsigned int supercompressionScheme;
+        unsigned int dfdByteOffset;
+        unsigned int dfdByteLength;
+        unsigned int kvdByteOffset;
+        unsigned int kvdByteLength;
+        unsigned int sgdByteOffset[2];
+        unsigned int sgdByteLength[2];
+    };
+
+    std::auto_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to open file '%s'.", path);
+        return NULL;
+    }
+
+    unsigned char identifier[sizeof(KTX_IDENTIFIER)];
+    if (stream->read(identifier, 1, sizeof(identifier)) != sizeof(identifier))
+    {
+        GP_ERROR("Failed to read identifier of KTX file '%s'.", path);
+        return NULL;
+    }
+
+    GLenum format = 0;
+    GLenum internalFormat = 0;
+    bool compressed = true;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    int unpackAlignment = 1;
+    std::vector<KTXMipLevel> mipLevels;
+
+    if (memcmp(identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0)
+    {
+        ktx_header header;
+        if (stream->read(&header, sizeof(ktx_header), 1) != 1)
+        {
+            GP_ERROR("Failed to read header for KTX file '%s'.", path);
+            return NULL;
+        }
+
+        // Files written on big endian machines are swapped, the texel data of block compressed and byte formats is not.
+        bool swap = header.endianness == 0x01020304;
+        if (swap)
+        {
+            unsigned int* fields = (unsigned int*)&header;
+            for (unsigned int i = 0; i < sizeof(ktx_header) / sizeof(unsigned int); ++i)
+                fields[i] = swapBytes(fields[i]);
+        }
+        if (header.endianness != 0x04030201 || (header.glType != 0 && header.glTypeSize != 1))
+        {
+            GP_ERROR("Failed to read KTX file '%s': invalid header.", path);
+            return NULL;
+        }
+        if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1)
+        {
+            GP_ERROR("Failed to read KTX file '%s': only 2D textures are supported.", path);
+            return NULL;
+        }
+
+        if (header.glType == 0)
+        {
+            format = internalFormat = header.glInternalFormat;
+        }
+        else if (header.glType == GL_UNSIGNED_BYTE && (header.glFormat == GL_RGB || header.glFormat == GL_RGBA))
+        {
+            // GL ES 2 requires the internal format to match the format.
+            compressed = false;
+            format = internalFormat = header.glFormat;
+            unpackAlignment = 4;
+        }
+        else
+        {
+            GP_ERROR("Unsupported texture format (type %d, format %d) for KTX file '%s'.", header.glType, header.glFormat, path);
+            return NULL;
+        }
+
+        width = header.pixelWidth;
+        height = header.pixelHeight;
+        if (!stream->seek(header.bytesOfKeyValueData, SEEK_CUR))
+        {
+            GP_ERROR("Failed to skip key/value data of KTX file '%s'.", path);
+            return NULL;
+        }
+
+        // Every level is preceded by its size and padded to 4 bytes.
+        mipLevels.resize(std::max(header.numberOfMipmapLevels, 1u));
+        unsigned int offset = sizeof(KTX_IDENTIFIER) + sizeof(ktx_header) + header.bytesOfKeyValueData;
+        for (size_t i = 0, count = mipLevels.size(); i < count; ++i)
+        {
+            unsigned int imageSize;
+            if (!stream->seek(offset, SEEK_SET) || stream->read(&imageSize, sizeof(unsigned int), 1) != 1)
+            {
+                GP_ERROR("Failed to read mip level %d of KTX file '%s'.", (int)i, path);
+                return NULL;
+            }
+            if (swap)
+                imageSize = swapBytes(imageSize);
+            mipLevels[i].offset = offset + sizeof(unsigned int);
+            mipLevels[i].size = imageSize;
+            offset += sizeof(unsigned int) + ((imageSize + 3) & ~3u);
+        }
+    }
+    else if (memcmp(identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+    {
+        ktx2_header header;
+        if (stream->read(&header, sizeof(ktx2_header), 1) != 1)
+        {
+            GP_ERROR("Failed to read header for KTX file '%s'.", path);
+            return NULL;
+        }
+        if (header.pixelDepth > 1 || header.layerCount > 0 || header.faceCount != 1)
+        {
+            GP_ERROR("Failed to read KTX file '%s': only 2D textures are supported.", path);
+            return NULL;
+        }
+        if (header.supercompressionScheme != 0)
+        {
+            GP_ERROR("Failed to read KTX file '%s': supercompressed files are not supported.", path);
+            return NULL;
+        }
+
+        format = internalFormat = getKTX2Format(header.vkFormat, &compressed);
+        if (format == 0)
+        {
+            GP_ERROR("Unsupported texture format (%d) for KTX file '%s'.", header.vkFormat, path);
+            return NULL;
+        }
+        width = header.pixelWidth;
+        height = header.pixelHeight;
+
+        // The level index follows the header, largest level first, as 64-bit offset, size and uncompressed size.
+        mipLevels.resize(std::max(header.levelCount, 1u));
+        for (size_t i = 0, count = mipLevels.size(); i < count; ++i)
+        {
+            unsigned int level[6];
+            if (stream->read(level, sizeof(level), 1) != 1 || level[1] != 0 || level[3] != 0)
+            {
+                GP_ERROR("Failed to read level index of KTX file '%s'.", path);
+                return NULL;
+            }
+            mipLevels[i].offset = level[0];
+            mipLevels[i].size = level[2];
+        }
+    }
+    else
+    {
+        GP_ERROR("Failed to read KTX file '%s': invalid identifier.", path);
+        return NULL;
+    }
+
+    if (compressed && !isCompressedFormatSupported(format))
+    {
+        GP_ERROR("Compressed texture format (0x%x) of KTX file '%s' is not supported by the GPU.", format, path);
+        return NULL;
+    }
+
+    unsigned int mipLevelCount = (unsigned int)mipLevels.size();
+    for (unsigned int i = 0; i < mipLevelCount; ++i)
+    {
+        mipLevels[i].width = std::max(1u, width >> i);
+        mipLevels[i].height = std::max(1u, height >> i);
+    }
+
+    // Skip the levels larger than the requested size.
+    unsigned int firstLevel = 0;
+    while (maxSize && firstLevel + 1 < mipLevelCount && std::max(width >> firstLevel, height >> firstLevel) > maxSize)
+    {
+        ++firstLevel;
+    }
+
+    // Generate GL texture.
+    GLuint textureId;
+    GL_ASSERT( glGenTextures(1, &textureId) );
+    bindTexture(textureId);
+
+    Filter minFilter = mipLevelCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    if (texture)
+    {
+        texture->replaceHandle(textureId);
+    }
+    else
+    {
+        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter ) );
+
+        // Create gameplay texture.
+        texture = new Texture();
+        texture->_handle = textureId;
+        texture->_format = compressed ? UNKNOWN : (format == GL_RGB ? RGB : RGBA);
+        texture->_width = width;
+        texture->_height = height;
+        texture->_compressed = compressed;
+        texture->_mipmapped = mipLevelCount > 1;
+        texture->_minFilter = minFilter;
+    }
+    texture->_mipLevelCount = mipLevelCount;
+    texture->_residentLevel = firstLevel;
+
+    // Load texture data, one level at a time.
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment) );
+    unsigned int memorySize = 0;
+    std::vector<GLubyte> data;
+    for (unsigned int i = firstLevel; i < mipLevelCount; ++i)
+    {
+        KTXMipLevel& level = mipLevels[i];
+        data.resize(std::max(level.size, 1));
+        if (!stream->seek(level.offset, SEEK_SET) || stream->read(&data[0], 1, level.size) != (size_t)level.size)
+        {
+            GP_ERROR("Failed to read mip level %d of KTX file '%s'.", i, path);
+            break;
+        }
+
+        LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
+        if (compressed)
+        {
+            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, i - firstLevel, format, level.width, level.height, 0, level.size, &data[0]) );
+        }
+        else
+        {
+            GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, i - firstLevel, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, &data[0]) );
+        }
+        memorySize += level.size;
+        RenderStats::addUpload(level.size);
+    }
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    texture->setMemorySize(memorySize);
+    stream->close();
+
+    return texture;
+}
+
+Texture* Texture::createCompressedPVRTC(const char* path, unsigned int maxSize, Texture* texture)
 {
     std::auto_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
@@ -272,35 +987,59 @@ Texture* Texture::createCompressedPVRTC(const char* path)
 
     int bpp = (format == GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG || format == GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG) ? 2 : 4;
 
+    // Skip the levels larger than the requested size.
+    unsigned int firstLevel = 0;
+    while (maxSize && firstLevel + 1 < mipMapCount && (unsigned int)std::max(width >> firstLevel, height >> firstLevel) > maxSize)
+    {
+        ++firstLevel;
+    }
+
     // Generate our texture.
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    bindTexture(textureId);
 
     Filter minFilter = mipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
-    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter) );
-
-    Texture* texture = new Texture();
-    texture->_handle = textureId;
-    texture->_width = width;
-    texture->_height = height;
-    texture->_mipmapped = mipMapCount > 1;
-    texture->_compressed = true;
-    texture->_minFilter = minFilter;
+    if (texture)
+    {
+        texture->replaceHandle(textureId);
+    }
+    else
+    {
+        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter) );
+
+        texture = new Texture();
+        texture->_handle = textureId;
+        texture->_width = width;
+        texture->_height = height;
+        texture->_mipmapped = mipMapCount > 1;
+        texture->_compressed = true;
+        texture->_minFilter = minFilter;
+    }
+    texture->_mipLevelCount = mipMapCount;
+    texture->_residentLevel = firstLevel;
 
     // Load the data for each level.
+    unsigned int memorySize = 0;
     GLubyte* ptr = data;
     for (unsigned int level = 0; level < mipMapCount; ++level)
     {
         unsigned int dataSize = computePVRTCDataSize(width, height, bpp);
 
         // Upload data to GL.
-        GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, dataSize, ptr) );
+        if (level >= firstLevel)
+        {
+            LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
+            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, level - firstLevel, format, width, height, 0, dataSize, ptr) );
+            memorySize += dataSize;
+            RenderStats::addUpload(dataSize);
+        }
 
         width = std::max(width >> 1, 1);
         height = std::max(height >> 1, 1);
         ptr += dataSize;
     }
+    texture->setMemorySize(memorySize);
 
     // Free data.
     SAFE_DELETE_ARRAY(data);
@@ -500,7 +1239,7 @@ int Texture::getMaskByteIndex(unsigned int mask)
     }
 }
 
-Texture* Texture::createCompressedDDS(const char* path)
+Texture* Texture::createCompressedDDS(const char* path, unsigned int maxSize, Texture* texture)
 {
     GP_ASSERT(path);
 
@@ -543,8 +1282,6 @@ Texture* Texture::createCompressedDDS(const char* path)
         GLsizei size;
     };
 
-    Texture* texture = NULL;
-
     // Read DDS file.
     std::auto_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
@@ -575,6 +1312,13 @@ Texture* Texture::createCompressedDDS(const char* path)
         header.dwMipMapCount = 1;
     }
 
+    // Skip the levels larger than the requested size.
+    unsigned int firstLevel = 0;
+    while (maxSize && firstLevel + 1 < header.dwMipMapCount && std::max(header.dwWidth >> firstLevel, header.dwHeight >> firstLevel) > maxSize)
+    {
+        ++firstLevel;
+    }
+
     // Allocate mip level structures.
     dds_mip_level* mipLevels = new dds_mip_level[header.dwMipMapCount];
     memset(mipLevels, 0, sizeof(dds_mip_level) * header.dwMipMapCount);
@@ -631,17 +1375,31 @@ Texture* Texture::createCompressedDDS(const char* path)
             level.width = width;
             level.height = height;
             level.size =  std::max(1, (width+3) >> 2) * std::max(1, (height+3) >> 2) * bytesPerBlock;
-            level.data = new GLubyte[level.size];
 
-            if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
+            if (i < firstLevel)
             {
-                GP_ERROR("Failed to load dds compressed texture bytes for texture: %s", path);
-                
-                // Cleanup mip data.
-                for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                    SAFE_DELETE_ARRAY(level.data);
-                SAFE_DELETE_ARRAY(mipLevels);
-                return texture;
+                if (!stream->seek(level.size, SEEK_CUR))
+                {
+                    GP_ERROR("Failed to skip dds compressed texture bytes for texture: %s", path);
+                    SAFE_DELETE_ARRAY(mipLevels);
+                    return NULL;
+                }
+                level.size = 0;
+            }
+            else
+            {
+                level.data = new GLubyte[level.size];
+
+                if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
+                {
+                    GP_ERROR("Failed to load dds compressed texture bytes for texture: %s", path);
+
+                    // Cleanup mip data.
+                    for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
+                        SAFE_DELETE_ARRAY(mipLevels[i].data);
+                    SAFE_DELETE_ARRAY(mipLevels);
+                    return NULL;
+                }
             }
 
             width  = std::max(1, width >> 1);
@@ -702,17 +1460,31 @@ Texture* Texture::createCompressedDDS(const char* path)
             level.width = width;
             level.height = height;
             level.size =  width * height * (header.ddspf.dwRGBBitCount >> 3);
-            level.data = new GLubyte[level.size];
 
-            if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
+            if (i < firstLevel)
+            {
+                if (!stream->seek(level.size, SEEK_CUR))
+                {
+                    GP_ERROR("Failed to skip bytes for RGB dds texture: %s", path);
+                    SAFE_DELETE_ARRAY(mipLevels);
+                    return NULL;
+                }
+                level.size = 0;
+            }
+            else
             {
-                GP_ERROR("Failed to load bytes for RGB dds texture: %s", path);
+                level.data = new GLubyte[level.size];
 
-                // Cleanup mip data.
-                for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                    SAFE_DELETE_ARRAY(level.data);
-                SAFE_DELETE_ARRAY(mipLevels);
-                return texture;
+                if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
+                {
+                    GP_ERROR("Failed to load bytes for RGB dds texture: %s", path);
+
+                    // Cleanup mip data.
+                    for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
+                        SAFE_DELETE_ARRAY(mipLevels[i].data);
+                    SAFE_DELETE_ARRAY(mipLevels);
+                    return NULL;
+                }
             }
 
             width  = std::max(1, width >> 1);
@@ -771,36 +1543,50 @@ Texture* Texture::createCompressedDDS(const char* path)
     // Generate GL texture.
     GLuint textureId;
     GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, textureId) );
+    bindTexture(textureId);
 
     Filter minFilter = header.dwMipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
-    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter ) );
-
-    // Create gameplay texture.
-    texture = new Texture();
-    texture->_handle = textureId;
-    texture->_width = header.dwWidth;
-    texture->_height = header.dwHeight;
-    texture->_compressed = compressed;
-    texture->_mipmapped = header.dwMipMapCount > 1;
-    texture->_minFilter = minFilter;
+    if (texture)
+    {
+        texture->replaceHandle(textureId);
+    }
+    else
+    {
+        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter ) );
+
+        // Create gameplay texture.
+        texture = new Texture();
+        texture->_handle = textureId;
+        texture->_width = header.dwWidth;
+        texture->_height = header.dwHeight;
+        texture->_compressed = compressed;
+        texture->_mipmapped = header.dwMipMapCount > 1;
+        texture->_minFilter = minFilter;
+    }
+    texture->_mipLevelCount = header.dwMipMapCount;
+    texture->_residentLevel = firstLevel;
 
     // Load texture data.
-    for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
+    unsigned int memorySize = 0;
+    for (unsigned int i = firstLevel; i < header.dwMipMapCount; ++i)
     {
         dds_mip_level& level = mipLevels[i];
+        LoadProfiler::Phase upload(LoadProfiler::UPLOAD);
         if (compressed)
         {
-            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, level.size, level.data) );
+            GL_ASSERT( glCompressedTexImage2D(GL_TEXTURE_2D, i - firstLevel, format, level.width, level.height, 0, level.size, level.data) );
         }
         else
         {
-            GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data) );
+            GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, i - firstLevel, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data) );
         }
+        memorySize += level.size;
+        RenderStats::addUpload(level.size);
 
         // Clean up the texture data.
         SAFE_DELETE_ARRAY(level.data);
     }
+    texture->setMemorySize(memorySize);
 
     // Clean up mip levels structure.
     SAFE_DELETE_ARRAY(mipLevels);
@@ -828,23 +1614,89 @@ unsigned int Texture::getHeight() const
     return _height;
 }
 
+unsigned int Texture::getLayerCount() const
+{
+    return _layerCount;
+}
+
 TextureHandle Texture::getHandle() const
 {
     return _handle;
 }
 
+void Texture::replaceHandle(TextureHandle handle)
+{
+    GP_ASSERT(handle);
+
+    // The new GL texture starts with default parameters; restore the cached ones.
+    bindTexture(handle);
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLenum)_minFilter) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLenum)_magFilter) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLenum)_wrapS) );
+    GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLenum)_wrapT) );
+
+    if (_handle)
+    {
+        StateCache::deleteTexture(_handle);
+    }
+    _handle = handle;
+}
+
+bool Texture::setResidentLevel(unsigned int level)
+{
+    GP_ASSERT(level < _mipLevelCount);
+
+    if (level == _residentLevel)
+        return true;
+
+    // Levels are never partially replaced: GL ES 2 has no base level parameter, so the
+    // whole chain starting at the requested level is loaded into a new GL texture.
+    unsigned int maxSize = std::max(std::max(_width >> level, _height >> level), 1u);
+    return createCompressed(getCompressedVariant(_path.c_str()).c_str(), maxSize, this) != NULL;
+}
+
+void Texture::setData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const unsigned char* data)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(_target == GL_TEXTURE_2D);
+    GP_ASSERT(!_compressed);
+    GP_ASSERT(x + width <= _width && y + height <= _height);
+
+    bindTexture(_target, _handle);
+    GL_ASSERT( glPixelStorei(GL_UNPACK_ALIGNMENT, 1) );
+    const unsigned int size = width * height * (_format == RGBA ? 4 : (_format == RGB ? 3 : 1));
+    RenderCommandList::texSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, (GLenum)_format, GL_UNSIGNED_BYTE, data, size);
+    RenderStats::addUpload(size);
+
+    if (_mipmapped)
+    {
+        RenderCommandList::generateMipmap(_target);
+    }
+}
+
 void Texture::generateMipmaps()
 {
     if (!_mipmapped)
     {
-        GL_ASSERT( glBindTexture(GL_TEXTURE_2D, _handle) );
+        bindTexture(_target, _handle);
         GL_ASSERT( glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST) );
-        GL_ASSERT( glGenerateMipmap(GL_TEXTURE_2D) );
+        RenderCommandList::generateMipmap(_target);
 
+        // The mip chain adds a third to the size of the base level.
         _mipmapped = true;
+        setMemorySize(_memorySize + _memorySize / 3);
     }
 }
 
+void Texture::setMemorySize(unsigned int size)
+{
+    if (_memorySize)
+        Allocator::untrack(Allocator::TEXTURE, _memorySize);
+    _memorySize = size;
+    if (_memorySize)
+        Allocator::track(Allocator::TEXTURE, _memorySize);
+}
+
 bool Texture::isMipmapped() const
 {
     return _mipmapped;
@@ -855,8 +1707,57 @@ bool Texture::isCompressed() const
     return _compressed;
 }
 
+void Texture::setActiveUnit(unsigned int unit)
+{
+    StateCache::setActiveTexture(unit);
+}
+
+void Texture::bindTexture(TextureHandle handle)
+{
+    bindTexture(GL_TEXTURE_2D, handle);
+}
+
+void Texture::bindTexture(GLenum target, TextureHandle handle)
+{
+    StateCache::bindTexture(target, handle);
+}
+
+GLuint Texture::getSamplerObject(Wrap wrapS, Wrap wrapT, Filter minFilter, Filter magFilter)
+{
+#ifdef USE_SAMPLER_OBJECTS
+    // The modes are GL enums below 0x10000, so 16 bits of the key each.
+    unsigned long long key = ((unsigned long long)wrapS << 48) | ((unsigned long long)wrapT << 32) |
+                             ((unsigned long long)minFilter << 16) | (unsigned long long)magFilter;
+    std::map<unsigned long long, GLuint>::const_iterator itr = __samplerObjects.find(key);
+    if (itr != __samplerObjects.end())
+        return itr->second;
+
+    GLuint sampler;
+    GL_ASSERT( glGenSamplers(1, &sampler) );
+    GL_ASSERT( glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, (GLenum)minFilter) );
+    GL_ASSERT( glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, (GLenum)magFilter) );
+    GL_ASSERT( glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, (GLenum)wrapS) );
+    GL_ASSERT( glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, (GLenum)wrapT) );
+    __samplerObjects[key] = sampler;
+    return sampler;
+#else
+    return 0;
+#endif
+}
+
+void Texture::finalize()
+{
+#ifdef USE_SAMPLER_OBJECTS
+    for (std::map<unsigned long long, GLuint>::const_iterator itr = __samplerObjects.begin(); itr != __samplerObjects.end(); ++itr)
+    {
+        StateCache::deleteSampler(itr->second);
+    }
+#endif
+    __samplerObjects.clear();
+}
+
 Texture::Sampler::Sampler(Texture* texture)
-    : _texture(texture), _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT)
+    : _texture(texture), _wrapS(Texture::REPEAT), _wrapT(Texture::REPEAT), _samplerObject(0)
 {
     GP_ASSERT(texture);
     _minFilter = texture->_minFilter;
@@ -885,12 +1786,14 @@ void Texture::Sampler::setWrapMode(Wrap wrapS, Wrap wrapT)
 {
     _wrapS = wrapS;
     _wrapT = wrapT;
+    _samplerObject = 0;
 }
 
 void Texture::Sampler::setFilterMode(Filter minificationFilter, Filter magnificationFilter)
 {
     _minFilter = minificationFilter;
     _magFilter = magnificationFilter;
+    _samplerObject = 0;
 }
 
 Texture* Texture::Sampler::getTexture() const
@@ -902,31 +1805,43 @@ void Texture::Sampler::bind()
 {
     GP_ASSERT(_texture);
 
-    GL_ASSERT( glBindTexture(GL_TEXTURE_2D, _texture->_handle) );
+    if (_texture->_streamed)
+    {
+        Game::getInstance()->getTextureStreamer()->touch(_texture);
+    }
+
+    bindTexture(_texture->_target, _texture->_handle);
 
+#ifdef USE_SAMPLER_OBJECTS
+    // The sampler object overrides the parameters of the texture, which are left alone.
+    if (_samplerObject == 0)
+        _samplerObject = getSamplerObject(_wrapS, _wrapT, _minFilter, _magFilter);
+    StateCache::bindSampler(_samplerObject);
+#else
     if (_texture->_minFilter != _minFilter)
     {
         _texture->_minFilter = _minFilter;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLenum)_minFilter) );
+        GL_ASSERT( glTexParameteri(_texture->_target, GL_TEXTURE_MIN_FILTER, (GLenum)_minFilter) );
     }
 
     if (_texture->_magFilter != _magFilter)
     {
         _texture->_magFilter = _magFilter;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLenum)_magFilter) );
+        GL_ASSERT( glTexParameteri(_texture->_target, GL_TEXTURE_MAG_FILTER, (GLenum)_magFilter) );
     }
 
     if (_texture->_wrapS != _wrapS)
     {
         _texture->_wrapS = _wrapS;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLenum)_wrapS) );
+        GL_ASSERT( glTexParameteri(_texture->_target, GL_TEXTURE_WRAP_S, (GLenum)_wrapS) );
     }
 
     if (_texture->_wrapT != _wrapT)
     {
         _texture->_wrapT = _wrapT;
-        GL_ASSERT( glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLenum)_wrapT) );
+        GL_ASSERT( glTexParameteri(_texture->_target, GL_TEXTURE_WRAP_T, (GLenum)_wrapT) );
     }
+#endif
 }
 
 }
@@ -15,6 +15,11 @@ class Image;
 class Texture : public Ref
 {
     friend class Sampler;
+    friend class Effect;
+    friend class TextureStreamer;
+    friend class LightClusters;
+    friend class GpuUploadQueue;
+    friend class Game;
 
 public:
 
@@ -58,6 +63,12 @@ public:
      * used to sample a texture from a material. In addition to the texture
      * itself, a sampler stores per-instance texture state information, such
      * as wrap and filter modes.
+     *
+     * Where GL sampler objects are supported, the state is applied through a
+     * sampler object shared by every sampler with the same wrap and filter
+     * modes, so samplers of one texture with different modes do not change
+     * the texture parameters back and forth. Otherwise the texture remembers
+     * the parameters last applied to it and only the ones that differ are set.
      */
     class Sampler : public Ref
     {
@@ -136,6 +147,7 @@ public:
         Wrap _wrapT;
         Filter _minFilter;
         Filter _magFilter;
+        GLuint _samplerObject;  // Shared sampler object with the state above, or 0 until bound.
     };
 
     /**
@@ -144,6 +156,10 @@ public:
      * Note that for textures that include mipmap data in the source data (such as most compressed textures),
      * the generateMipmaps flags should NOT be set to true.
      *
+     * A PNG image is replaced by its preprocessed variant, 'name.<family>.ktx', when the
+     * encoder wrote one that the GPU supports (see the encoder's -tc option). The variant
+     * holds its own mip chain, which is uploaded as is, and generateMipmaps is ignored.
+     *
      * @param path The image resource path.
      * @param generateMipmaps true to auto-generate a full mipmap chain, false otherwise.
      * 
@@ -199,6 +215,58 @@ public:
      */
     static Texture* create(TextureHandle handle, int width, int height, Format format = UNKNOWN);
 
+    /**
+     * Creates a 2D texture array from a set of images.
+     *
+     * All images must have the same size and format. Each image becomes one layer of
+     * the array, in the order given. Texture arrays are only available on platforms
+     * that define USE_TEXTURE_ARRAYS.
+     *
+     * @param images The images of the layers.
+     * @param count The number of images.
+     * @param generateMipmaps true to auto-generate a full mipmap chain, false otherwise.
+     *
+     * @return The new texture array, or NULL if texture arrays are not supported or the images do not match.
+     * @script{ignore}
+     */
+    static Texture* createArray(Image** images, unsigned int count, bool generateMipmaps = false);
+
+    /**
+     * Creates textures from the given image resources.
+     *
+     * This is the same as calling create(const char*, bool) for every path, except that
+     * the PNG files that are not cached yet are decoded in parallel by the job scheduler.
+     *
+     * @param paths The image resource paths.
+     * @param count The number of paths.
+     * @param textures The array that receives the textures, NULL for the files that failed to load.
+     * @param generateMipmaps true to auto-generate a full mipmap chain, false otherwise.
+     *
+     * @return The number of textures created.
+     * @script{ignore}
+     */
+    static unsigned int createBatch(const char** paths, unsigned int count, Texture** textures, bool generateMipmaps = false);
+
+    /**
+     * Sets whether the color channels of RGBA images are multiplied by their alpha when they
+     * are loaded from file.
+     *
+     * Premultiplied textures filter without dark fringes and blend with ONE, ONE_MINUS_SRC_ALPHA.
+     * The setting only applies to textures loaded after it is changed. The default is taken from
+     * the 'premultiplyAlpha' property of the 'textures' namespace of the game config, or false.
+     *
+     * @param premultiply true to premultiply the alpha of loaded images, false otherwise.
+     */
+    static void setPremultipliedAlpha(bool premultiply);
+
+    /**
+     * Returns whether the color channels of RGBA images are multiplied by their alpha when they
+     * are loaded from file.
+     *
+     * @return true if the alpha of loaded images is premultiplied, false otherwise.
+     */
+    static bool isPremultipliedAlpha();
+
     /**
      * Returns the path that the texture was originally loaded from (if applicable).
      *
@@ -227,6 +295,28 @@ public:
      */
     unsigned int getHeight() const;
 
+    /**
+     * Gets the number of layers of the texture.
+     *
+     * @return The number of layers of a texture array, or 1 for other textures.
+     */
+    unsigned int getLayerCount() const;
+
+    /**
+     * Replaces a rectangle of the texture data.
+     *
+     * The data must be in the format of the texture, with tightly packed rows. Mipmaps
+     * are generated again if the texture is mipmapped.
+     *
+     * @param x The x position of the rectangle in texels.
+     * @param y The y position of the rectangle in texels.
+     * @param width The width of the rectangle in texels.
+     * @param height The height of the rectangle in texels.
+     * @param data The texels of the rectangle.
+     * @script{ignore}
+     */
+    void setData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const unsigned char* data);
+
     /**
      * Generates a full mipmap chain for this texture if it isn't already mipmapped.
      */
@@ -273,9 +363,51 @@ private:
      */
     Texture& operator=(const Texture&);
 
-    static Texture* createCompressedPVRTC(const char* path);
+    /**
+     * Loads a PVR file.
+     *
+     * @param path The path of the file.
+     * @param maxSize If non-zero, the mip levels larger than this size are skipped
+     *      (the smallest level is always loaded).
+     * @param texture If not NULL, the texture that receives the loaded levels in place
+     *      of its current ones; otherwise a new texture is created.
+     */
+    static Texture* createCompressedPVRTC(const char* path, unsigned int maxSize = 0, Texture* texture = NULL);
 
-    static Texture* createCompressedDDS(const char* path);
+    /**
+     * Loads a DDS file.
+     *
+     * @see createCompressedPVRTC
+     */
+    static Texture* createCompressedDDS(const char* path, unsigned int maxSize = 0, Texture* texture = NULL);
+
+    /**
+     * Loads a KTX 1.1 or KTX 2.0 file.
+     *
+     * Only 2D textures without supercompression are supported.
+     *
+     * @see createCompressedPVRTC
+     */
+    static Texture* createCompressedKTX(const char* path, unsigned int maxSize = 0, Texture* texture = NULL);
+
+    /**
+     * Loads a PVR, DDS or KTX file, depending on its extension.
+     *
+     * @see createCompressedPVRTC
+     */
+    static Texture* createCompressed(const char* path, unsigned int maxSize, Texture* texture);
+
+    /**
+     * Returns whether the GPU can sample textures of a compressed format.
+     */
+    static bool isCompressedFormatSupported(GLenum format);
+
+    /**
+     * Returns the path of the preprocessed variant of a PNG file that is preferred on
+     * this GPU, 'name.<family>.ktx' for the block compressed families astc, bc, etc2 and
+     * etc1 in order, then the uncompressed family raw, or the path itself if there is none.
+     */
+    static std::string getCompressedVariant(const char* path);
 
     static GLubyte* readCompressedPVRTC(const char* path, Stream* stream, GLsizei* width, GLsizei* height, GLenum* format, unsigned int* mipMapCount);
 
@@ -283,11 +415,60 @@ private:
 
     static int getMaskByteIndex(unsigned int mask);
 
+    /**
+     * Adds a texture loaded from file to the texture cache and the texture streamer.
+     */
+    static void addLoaded(const char* path, Texture* texture);
+
+    /**
+     * Makes the specified texture unit active, skipping the GL call if it already is.
+     */
+    static void setActiveUnit(unsigned int unit);
+
+    /**
+     * Binds a texture to the active texture unit, skipping the GL call if it is already bound there.
+     */
+    static void bindTexture(TextureHandle handle);
+
+    /**
+     * Binds a texture to the specified target of the active texture unit.
+     */
+    static void bindTexture(GLenum target, TextureHandle handle);
+
+    /**
+     * Gets the shared sampler object with the specified state, creating it on first use.
+     */
+    static GLuint getSamplerObject(Wrap wrapS, Wrap wrapT, Filter minFilter, Filter magFilter);
+
+    /**
+     * Deletes the shared sampler objects.
+     */
+    static void finalize();
+
+    /**
+     * Replaces the GL texture of this texture with a newly loaded one and deletes the old one.
+     */
+    void replaceHandle(TextureHandle handle);
+
+    /**
+     * Sets the size in bytes of the GL texture and reports it to the allocator.
+     */
+    void setMemorySize(unsigned int size);
+
+    /**
+     * Reloads the texture from its file so that the specified mip level becomes its largest resident level.
+     *
+     * @return True if the texture was reloaded.
+     */
+    bool setResidentLevel(unsigned int level);
+
     std::string _path;
     TextureHandle _handle;
     Format _format;
     unsigned int _width;
     unsigned int _height;
+    unsigned int _layerCount;
+    GLenum _target;                 // GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY for texture arrays.
     bool _mipmapped;
     bool _cached;
     bool _compressed;
@@ -295,6 +476,13 @@ private:
     Wrap _wrapT;
     Filter _minFilter;
     Filter _magFilter;
+    unsigned int _mipLevelCount;    // Number of mip levels in the source file.
+    unsigned int _residentLevel;    // Largest mip level of the source file that is loaded in GL.
+    unsigned int _memorySize;       // Size in bytes of the loaded mip levels.
+    bool _streamed;
+    unsigned int _lastUsedFrame;
+    float _requestedSize;           // Largest on-screen size in pixels requested since the last streamer update.
+    unsigned int _requestedLevel;
 };
 
 }
@@ -0,0 +1,298 @@
+#include "Base.h"
+#include "TextureStreamer.h"
+#include "Game.h"
+#include "Node.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Pass.h"
+
+// Default texture streaming settings.
+#define DEFAULT_BUDGET              (128 * 1024 * 1024)
+#define DEFAULT_INITIAL_SIZE        64
+#define DEFAULT_UPLOADS_PER_FRAME   2
+
+namespace gameplay
+{
+
+TextureStreamer::TextureStreamer()
+    : _enabled(false), _budget(DEFAULT_BUDGET), _initialSize(DEFAULT_INITIAL_SIZE), _uploadsPerFrame(DEFAULT_UPLOADS_PER_FRAME), _frame(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+}
+
+void TextureStreamer::initialize(Properties* properties)
+{
+    if (properties == NULL)
+        return;
+
+    _enabled = properties->getBool("streaming");
+    if (properties->exists("budget"))
+    {
+        _budget = (unsigned int)std::max(0, properties->getInt("budget")) * 1024 * 1024;
+    }
+    if (properties->exists("initialSize"))
+    {
+        _initialSize = (unsigned int)std::max(1, properties->getInt("initialSize"));
+    }
+    if (properties->exists("uploadsPerFrame"))
+    {
+        _uploadsPerFrame = (unsigned int)std::max(1, properties->getInt("uploadsPerFrame"));
+    }
+}
+
+void TextureStreamer::finalize()
+{
+    for (size_t i = 0, count = _textures.size(); i < count; ++i)
+    {
+        _textures[i]->_streamed = false;
+    }
+    _textures.clear();
+    _enabled = false;
+}
+
+bool TextureStreamer::isEnabled() const
+{
+    return _enabled;
+}
+
+unsigned int TextureStreamer::getBudget() const
+{
+    return _budget;
+}
+
+void TextureStreamer::setBudget(unsigned int budget)
+{
+    _budget = budget;
+}
+
+unsigned int TextureStreamer::getMemoryUsage() const
+{
+    unsigned int memoryUsage = 0;
+    for (size_t i = 0, count = _textures.size(); i < count; ++i)
+    {
+        memoryUsage += _textures[i]->_memorySize;
+    }
+    return memoryUsage;
+}
+
+unsigned int TextureStreamer::getInitialSize() const
+{
+    return _initialSize;
+}
+
+unsigned int TextureStreamer::getTextureCount() const
+{
+    return (unsigned int)_textures.size();
+}
+
+void TextureStreamer::getResidency(std::vector<Residency>& residency) const
+{
+    residency.reserve(residency.size() + _textures.size());
+    for (size_t i = 0, count = _textures.size(); i < count; ++i)
+    {
+        Texture* texture = _textures[i];
+
+        Residency r;
+        r.texture = texture;
+        r.mipLevelCount = texture->_mipLevelCount;
+        r.residentLevel = texture->_residentLevel;
+        r.requestedLevel = texture->_requestedLevel;
+        r.memorySize = texture->_memorySize;
+        r.framesSinceUse = _frame - texture->_lastUsedFrame;
+        residency.push_back(r);
+    }
+}
+
+void TextureStreamer::add(Texture* texture)
+{
+    GP_ASSERT(texture);
+
+    if (!_enabled || texture->_streamed || texture->_mipLevelCount <= 1)
+        return;
+
+    texture->_streamed = true;
+    texture->_lastUsedFrame = _frame;
+    texture->_requestedLevel = texture->_residentLevel;
+    texture->_requestedSize = 0.0f;
+    _textures.push_back(texture);
+}
+
+void TextureStreamer::remove(Texture* texture)
+{
+    GP_ASSERT(texture);
+
+    std::vector<Texture*>::iterator itr = std::find(_textures.begin(), _textures.end(), texture);
+    if (itr != _textures.end())
+    {
+        _textures.erase(itr);
+    }
+    texture->_streamed = false;
+}
+
+void TextureStreamer::touch(Texture* texture)
+{
+    texture->_lastUsedFrame = _frame;
+}
+
+void TextureStreamer::notifyDraw(Node* node, Pass* pass)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(pass);
+
+    if (!_enabled)
+        return;
+
+    Scene* scene = node->getScene();
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (camera == NULL || camera->getNode() == NULL)
+        return;
+
+    const BoundingSphere& sphere = node->getBoundingSphere();
+    if (sphere.radius <= 0.0f)
+        return;
+
+    // Projected diameter of the bounding sphere in pixels; textures are assumed to cover the model once.
+    float size;
+    float viewportHeight = Game::getInstance()->getViewport().height;
+    if (camera->getCameraType() == Camera::PERSPECTIVE)
+    {
+        float distance = sphere.center.distance(camera->getNode()->getTranslationWorld()) - sphere.radius;
+        if (distance <= camera->getNearPlane())
+        {
+            size = FLT_MAX;
+        }
+        else
+        {
+            size = sphere.radius * viewportHeight / (distance * tan(MATH_DEG_TO_RAD(camera->getFieldOfView()) * 0.5f));
+        }
+    }
+    else
+    {
+        size = 2.0f * sphere.radius * viewportHeight / camera->getZoomY();
+    }
+
+    for (RenderState* rs = pass; rs; rs = rs->_parent)
+    {
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        {
+            Texture::Sampler* sampler = rs->_parameters[i]->getSampler();
+            Texture* texture = sampler ? sampler->getTexture() : NULL;
+            if (texture && texture->_streamed && size > texture->_requestedSize)
+            {
+                texture->_requestedSize = size;
+            }
+        }
+    }
+}
+
+unsigned int TextureStreamer::computeLevel(Texture* texture, float size)
+{
+    unsigned int dimension = std::max(texture->_width, texture->_height);
+    unsigned int level = 0;
+    while (level + 1 < texture->_mipLevelCount && (float)(dimension >> (level + 1)) >= size)
+    {
+        ++level;
+    }
+    return level;
+}
+
+bool TextureStreamer::compareLastUsed(Texture* a, Texture* b)
+{
+    return a->_lastUsedFrame < b->_lastUsedFrame;
+}
+
+void TextureStreamer::update()
+{
+    GP_PROFILE_SCOPE("TextureStreamer::update");
+
+    if (!_enabled || _textures.empty())
+    {
+        ++_frame;
+        return;
+    }
+
+    // Turn the sizes recorded while drawing the last frame into requested levels.
+    unsigned int memoryUsage = 0;
+    for (size_t i = 0, count = _textures.size(); i < count; ++i)
+    {
+        Texture* texture = _textures[i];
+        if (texture->_requestedSize > 0.0f)
+        {
+            texture->_requestedLevel = computeLevel(texture, texture->_requestedSize);
+            texture->_requestedSize = 0.0f;
+        }
+        memoryUsage += texture->_memorySize;
+    }
+
+    // Least recently used textures first.
+    std::sort(_textures.begin(), _textures.end(), compareLastUsed);
+
+    // Evict the largest level of the least recently used textures while over budget.
+    // Textures used in the last frame only lose the levels they do not need.
+    bool failed = false;
+    for (size_t i = 0, count = _textures.size(); i < count && memoryUsage > _budget; ++i)
+    {
+        Texture* texture = _textures[i];
+        bool used = texture->_lastUsedFrame == _frame;
+        if (texture->_residentLevel + 1 >= texture->_mipLevelCount || (used && texture->_residentLevel >= texture->_requestedLevel))
+            continue;
+
+        unsigned int memorySize = texture->_memorySize;
+        if (texture->setResidentLevel(texture->_residentLevel + 1))
+        {
+            memoryUsage = memoryUsage - memorySize + texture->_memorySize;
+        }
+        else
+        {
+            texture->_streamed = false;
+            failed = true;
+        }
+    }
+
+    // Upgrade the most recently used textures by one level each, as long as they fit in the budget.
+    unsigned int uploads = 0;
+    for (size_t i = _textures.size(); i-- > 0 && uploads < _uploadsPerFrame; )
+    {
+        Texture* texture = _textures[i];
+        if (texture->_lastUsedFrame != _frame)
+            break;
+        if (!texture->_streamed || texture->_residentLevel <= texture->_requestedLevel)
+            continue;
+
+        // Adding the next level makes the chain about four times as large.
+        unsigned int memorySize = texture->_memorySize;
+        if (memoryUsage + memorySize * 3 > _budget)
+            continue;
+
+        if (texture->setResidentLevel(texture->_residentLevel - 1))
+        {
+            memoryUsage = memoryUsage - memorySize + texture->_memorySize;
+            ++uploads;
+        }
+        else
+        {
+            texture->_streamed = false;
+            failed = true;
+        }
+    }
+
+    // Stop streaming textures whose file could not be reloaded.
+    if (failed)
+    {
+        for (size_t i = _textures.size(); i-- > 0; )
+        {
+            if (!_textures[i]->_streamed)
+            {
+                GP_WARN("Stopped streaming texture '%s'.", _textures[i]->getPath());
+                _textures.erase(_textures.begin() + i);
+            }
+        }
+    }
+
+    ++_frame;
+}
+
+}
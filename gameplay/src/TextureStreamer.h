@@ -0,0 +1,212 @@
+#ifndef TEXTURESTREAMER_H_
+#define TEXTURESTREAMER_H_
+
+#include "Texture.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class Node;
+class Pass;
+
+/**
+ * Defines the texture streamer, which keeps the mip levels of file textures
+ * resident based on how large they appear on screen and on a memory budget.
+ *
+ * When streaming is enabled, mipmapped DDS and PVR textures are first loaded
+ * with only their small mip levels. While models are drawn, the streamer
+ * estimates how many pixels each model covers from its bounding sphere and
+ * the active camera of its scene, and records that size for the textures of
+ * the pass. Once per frame, textures that need more detail are upgraded one
+ * mip level at a time, and when the resident size of all streamed textures
+ * exceeds the budget, the largest mip levels of the least recently used
+ * textures are evicted.
+ *
+ * Streaming is configured in the game config:
+ *
+ * @verbatim
+    textures
+    {
+        streaming = true
+        budget = 128            // Budget for streamed textures, in megabytes.
+        initialSize = 64        // Largest mip level loaded when a texture is created.
+        uploadsPerFrame = 2     // Maximum number of mip level upgrades per frame.
+    }
+   @endverbatim
+ *
+ * PNG textures and textures without mip levels are never streamed and are not
+ * counted against the budget.
+ *
+ * @script{ignore}
+ */
+class TextureStreamer
+{
+    friend class Game;
+    friend class Texture;
+    friend class Model;
+
+public:
+
+    /**
+     * Defines the residency of a streamed texture.
+     */
+    struct Residency
+    {
+        /**
+         * The texture.
+         */
+        Texture* texture;
+
+        /**
+         * The number of mip levels in the texture file.
+         */
+        unsigned int mipLevelCount;
+
+        /**
+         * The largest mip level that is resident, where 0 is the full resolution.
+         */
+        unsigned int residentLevel;
+
+        /**
+         * The mip level requested from the on-screen size of the texture.
+         */
+        unsigned int requestedLevel;
+
+        /**
+         * The size in bytes of the resident mip levels.
+         */
+        unsigned int memorySize;
+
+        /**
+         * The number of frames since the texture was last bound.
+         */
+        unsigned int framesSinceUse;
+    };
+
+    /**
+     * Determines if texture streaming is enabled.
+     *
+     * @return True if streaming is enabled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * Gets the memory budget for streamed textures.
+     *
+     * @return The budget in bytes.
+     */
+    unsigned int getBudget() const;
+
+    /**
+     * Sets the memory budget for streamed textures.
+     *
+     * @param budget The budget in bytes.
+     */
+    void setBudget(unsigned int budget);
+
+    /**
+     * Gets the size of the resident mip levels of all streamed textures.
+     *
+     * @return The memory usage in bytes.
+     */
+    unsigned int getMemoryUsage() const;
+
+    /**
+     * Gets the size of the largest mip level loaded when a streamed texture is created.
+     *
+     * @return The initial size in pixels.
+     */
+    unsigned int getInitialSize() const;
+
+    /**
+     * Gets the number of streamed textures.
+     *
+     * @return The number of streamed textures.
+     */
+    unsigned int getTextureCount() const;
+
+    /**
+     * Gets the residency of every streamed texture.
+     *
+     * @param residency The vector the residency entries are appended to.
+     */
+    void getResidency(std::vector<Residency>& residency) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    TextureStreamer();
+
+    /**
+     * Destructor.
+     */
+    ~TextureStreamer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TextureStreamer(const TextureStreamer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TextureStreamer& operator=(const TextureStreamer&);
+
+    /**
+     * Called during startup to read the streaming configuration.
+     *
+     * @param properties The 'textures' namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Called during shutdown to stop streaming the remaining textures.
+     */
+    void finalize();
+
+    /**
+     * Called once per frame to upgrade and evict mip levels.
+     */
+    void update();
+
+    /**
+     * Starts streaming a texture loaded from file, if it has mip levels.
+     */
+    void add(Texture* texture);
+
+    /**
+     * Stops streaming a texture.
+     */
+    void remove(Texture* texture);
+
+    /**
+     * Marks a texture as used in the current frame.
+     */
+    void touch(Texture* texture);
+
+    /**
+     * Records the on-screen size of a node for the textures of the pass it is drawn with.
+     */
+    void notifyDraw(Node* node, Pass* pass);
+
+    /**
+     * Computes the smallest mip level that is at least as large as the specified on-screen size.
+     */
+    static unsigned int computeLevel(Texture* texture, float size);
+
+    static bool compareLastUsed(Texture* a, Texture* b);
+
+    bool _enabled;
+    unsigned int _budget;
+    unsigned int _initialSize;
+    unsigned int _uploadsPerFrame;
+    unsigned int _frame;
+    std::vector<Texture*> _textures;
+};
+
+}
+
+#endif
@@ -1,13 +1,28 @@
 #include "Base.h"
 #include "Theme.h"
 #include "ThemeStyle.h"
+#include "Image.h"
+
+// Default size of the atlas shared by the images of ImageControls.
+#define THEME_ATLAS_SIZE 1024
+
+// Empty pixels kept around each image in the atlas, so that filtering does not bleed neighbours in.
+#define THEME_ATLAS_PADDING 2
 
 namespace gameplay
 {
 
 static std::vector<Theme*> __themeCache;
 
+// Unlike Rectangle::intersects, rectangles that only share an edge do not overlap.
+static bool overlaps(const Rectangle& a, const Rectangle& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
 Theme::Theme()
+    : _texture(NULL), _spriteBatch(NULL), _atlasTexture(NULL), _atlasBatch(NULL), _atlasSize(THEME_ATLAS_SIZE),
+      _atlasX(0), _atlasY(0), _atlasShelfHeight(0), _batching(false), _batchPending(false)
 {
 }
 
@@ -38,6 +53,8 @@ Theme::~Theme()
         SAFE_RELEASE(skin);
     }
 
+    SAFE_DELETE(_atlasBatch);
+    SAFE_RELEASE(_atlasTexture);
     SAFE_DELETE(_spriteBatch);
     SAFE_RELEASE(_texture);
 
@@ -94,6 +111,10 @@ Theme* Theme::create(const char* url)
     theme->_spriteBatch = SpriteBatch::create(theme->_texture);
     GP_ASSERT(theme->_spriteBatch);
     theme->_spriteBatch->getSampler()->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    if (themeProperties->exists("imageAtlasSize"))
+    {
+        theme->_atlasSize = (unsigned int)std::max(0, themeProperties->getInt("imageAtlasSize"));
+    }
 
     float tw = 1.0f / theme->_texture->getWidth();
     float th = 1.0f / theme->_texture->getHeight();
@@ -498,6 +519,11 @@ void Theme::setProjectionMatrix(const Matrix& matrix)
         GP_ASSERT(font->getSpriteBatch());
         font->getSpriteBatch()->setProjectionMatrix(matrix);
     }
+
+    if (_atlasBatch)
+    {
+        _atlasBatch->setProjectionMatrix(matrix);
+    }
 }
 
 SpriteBatch* Theme::getSpriteBatch() const
@@ -505,6 +531,166 @@ SpriteBatch* Theme::getSpriteBatch() const
     return _spriteBatch;
 }
 
+bool Theme::addAtlasImage(const char* path, Rectangle* region)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(region);
+
+    std::map<std::string, Rectangle>::const_iterator itr = _atlasImages.find(path);
+    if (itr != _atlasImages.end())
+    {
+        *region = itr->second;
+        return true;
+    }
+
+    // Images bigger than half the atlas on a side would use it up, they keep their own texture.
+    if (_atlasSize == 0)
+        return false;
+    Image* image = Image::create(path);
+    if (image == NULL)
+        return false;
+    unsigned int width = image->getWidth();
+    unsigned int height = image->getHeight();
+    if (width > _atlasSize / 2 || height > _atlasSize / 2)
+    {
+        SAFE_RELEASE(image);
+        return false;
+    }
+
+    // Place the image on the current shelf, or start a new shelf below it.
+    if (_atlasX + width + THEME_ATLAS_PADDING > _atlasSize)
+    {
+        _atlasX = 0;
+        _atlasY += _atlasShelfHeight;
+        _atlasShelfHeight = 0;
+    }
+    if (_atlasY + height + THEME_ATLAS_PADDING > _atlasSize)
+    {
+        SAFE_RELEASE(image);
+        return false;
+    }
+
+    if (_atlasTexture == NULL)
+    {
+        std::vector<unsigned char> data(_atlasSize * _atlasSize * 4, 0);
+        _atlasTexture = Texture::create(Texture::RGBA, _atlasSize, _atlasSize, &data[0], false);
+        _atlasBatch = SpriteBatch::create(_atlasTexture);
+        GP_ASSERT(_atlasBatch);
+        _atlasBatch->setProjectionMatrix(_spriteBatch->getProjectionMatrix());
+        if (_batching)
+            _atlasBatch->start();
+    }
+
+    // Images are stored bottom row first, and so is the texture, while regions are measured from the top.
+    const unsigned char* data = image->getData();
+    std::vector<unsigned char> rgba;
+    if (image->getFormat() == Image::RGB)
+    {
+        rgba.resize(width * height * 4);
+        for (unsigned int i = 0, count = width * height; i < count; ++i)
+        {
+            rgba[i * 4] = data[i * 3];
+            rgba[i * 4 + 1] = data[i * 3 + 1];
+            rgba[i * 4 + 2] = data[i * 3 + 2];
+            rgba[i * 4 + 3] = 255;
+        }
+        data = &rgba[0];
+    }
+    _atlasTexture->setData(_atlasX, _atlasSize - _atlasY - height, width, height, data);
+    SAFE_RELEASE(image);
+
+    region->set(_atlasX, _atlasY, width, height);
+    _atlasImages[path] = *region;
+    _atlasX += width + THEME_ATLAS_PADDING;
+    _atlasShelfHeight = std::max(_atlasShelfHeight, height + THEME_ATLAS_PADDING);
+    return true;
+}
+
+SpriteBatch* Theme::getAtlasBatch() const
+{
+    return _atlasBatch;
+}
+
+void Theme::startBatch()
+{
+    GP_ASSERT(_spriteBatch);
+    GP_ASSERT(!_batching);
+
+    _batching = true;
+    _batchPending = false;
+    _spriteBatch->start();
+    if (_atlasBatch)
+        _atlasBatch->start();
+}
+
+void Theme::prepareBatch(BatchLayer layer, const Rectangle& bounds)
+{
+    GP_ASSERT(_batching);
+
+    // Anything collected from a later layer over these bounds must be drawn before them.
+    for (size_t i = 0, count = _batchBounds.size(); i < count; ++i)
+    {
+        if (_batchBounds[i].first > layer && overlaps(_batchBounds[i].second, bounds))
+        {
+            flushBatch();
+            break;
+        }
+    }
+    if (layer != BATCH_SPRITES)
+    {
+        _batchBounds.push_back(std::make_pair(layer, bounds));
+    }
+    _batchPending = true;
+}
+
+void Theme::prepareText(Font* font, const Rectangle& bounds)
+{
+    GP_ASSERT(font);
+
+    prepareBatch(BATCH_TEXT, bounds);
+    if (std::find(_batchFonts.begin(), _batchFonts.end(), font) == _batchFonts.end())
+    {
+        font->start();
+        _batchFonts.push_back(font);
+    }
+}
+
+void Theme::flushBatch()
+{
+    GP_ASSERT(_batching);
+
+    if (!_batchPending)
+        return;
+
+    _spriteBatch->finish();
+    if (_atlasBatch)
+        _atlasBatch->finish();
+    for (size_t i = 0, count = _batchFonts.size(); i < count; ++i)
+    {
+        _batchFonts[i]->finish();
+    }
+    _batchFonts.clear();
+    _batchBounds.clear();
+    _batchPending = false;
+
+    _spriteBatch->start();
+    if (_atlasBatch)
+        _atlasBatch->start();
+}
+
+void Theme::finishBatch()
+{
+    GP_ASSERT(_batching);
+
+    flushBatch();
+    _batching = false;
+}
+
+bool Theme::isBatching() const
+{
+    return _batching;
+}
+
 /**************
  * Theme::UVs *
  **************/
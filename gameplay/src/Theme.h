@@ -26,6 +26,7 @@ namespace gameplay
     theme
     {
         texture = <Path to texture>
+        imageAtlasSize = <int>      // Size of the atlas shared by the images of ImageControls, or 0 for none. Default is 1024.
 
         // Describes a single image, to be used as a cursor.
         cursor <Cursor ID>
@@ -134,8 +135,12 @@ namespace gameplay
  */
 class Theme: public Ref
 {
+    friend class Container;
     friend class Control;
     friend class Form;
+    friend class ImageControl;
+    friend class Label;
+    friend class Slider;
     friend class Skin;
 
 public:
@@ -435,6 +440,16 @@ private:
         float _tw, _th;
     };
 
+    /**
+     * The kinds of sprites collected while a form is drawn, in the order they are drawn.
+     */
+    enum BatchLayer
+    {
+        BATCH_SPRITES,
+        BATCH_IMAGES,
+        BATCH_TEXT
+    };
+
     /**
      * Constructor.
      */
@@ -459,6 +474,55 @@ private:
 
     SpriteBatch* getSpriteBatch() const;
 
+    /**
+     * Packs an image into the atlas shared by all ImageControls of this theme.
+     *
+     * @param path The path of the image.
+     * @param region Set to the region of the image in the atlas, in pixels from its top left corner.
+     *
+     * @return True if the image was packed, false if it does not fit and must be drawn from its own texture.
+     */
+    bool addAtlasImage(const char* path, Rectangle* region);
+
+    /**
+     * Returns the sprite batch drawing the image atlas, or NULL if the theme has none.
+     */
+    SpriteBatch* getAtlasBatch() const;
+
+    /**
+     * Starts collecting the sprites and text of a form, so that all of it is drawn with one
+     * batch for the theme sprites, one for the image atlas and one for each font.
+     */
+    void startBatch();
+
+    /**
+     * Prepares to add sprites of a layer within the given bounds to the batches.
+     *
+     * Sprites, images and text collected so far are drawn first if some of a later layer
+     * overlaps the bounds, so overlapping controls are still drawn in order.
+     */
+    void prepareBatch(BatchLayer layer, const Rectangle& bounds);
+
+    /**
+     * Prepares to add text of a font within the given bounds, starting the font if needed.
+     */
+    void prepareText(Font* font, const Rectangle& bounds);
+
+    /**
+     * Draws everything collected so far and keeps collecting.
+     */
+    void flushBatch();
+
+    /**
+     * Draws everything collected and stops collecting.
+     */
+    void finishBatch();
+
+    /**
+     * Returns whether a form is being drawn with startBatch.
+     */
+    bool isBatching() const;
+
     static void generateUVs(float tw, float th, float x, float y, float width, float height, UVs* uvs);
 
     void lookUpSprites(const Properties* overlaySpace, ImageList** imageList, ThemeImage** mouseCursor, Skin** skin);
@@ -471,6 +535,17 @@ private:
     std::vector<ImageList*> _imageLists;
     std::vector<Skin*> _skins;
     std::set<Font*> _fonts;
+    Texture* _atlasTexture;
+    SpriteBatch* _atlasBatch;
+    std::map<std::string, Rectangle> _atlasImages;
+    unsigned int _atlasSize;
+    unsigned int _atlasX;
+    unsigned int _atlasY;
+    unsigned int _atlasShelfHeight;
+    bool _batching;
+    bool _batchPending;
+    std::vector<std::pair<BatchLayer, Rectangle> > _batchBounds;
+    std::vector<Font*> _batchFonts;
 };
 
 }
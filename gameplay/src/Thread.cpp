@@ -0,0 +1,252 @@
+#include "Base.h"
+#include "Thread.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace gameplay
+{
+
+static bool __mainThreadSet = false;
+#ifdef WIN32
+static DWORD __mainThread;
+#else
+static pthread_t __mainThread;
+#endif
+
+struct ThreadEntry
+{
+#ifdef WIN32
+    static DWORD WINAPI entry(LPVOID arg)
+#else
+    static void* entry(void* arg)
+#endif
+    {
+        static_cast<Thread*>(arg)->run();
+        return 0;
+    }
+};
+
+Thread::Thread()
+    : _function(NULL), _arg(NULL), _handle(NULL), _joined(false)
+{
+}
+
+Thread::~Thread()
+{
+    GP_ASSERT(_joined);
+#ifdef WIN32
+    if (_handle)
+        CloseHandle((HANDLE)_handle);
+#else
+    delete static_cast<pthread_t*>(_handle);
+#endif
+}
+
+Thread* Thread::create(ThreadFunction function, void* arg)
+{
+    GP_ASSERT(function);
+
+    Thread* thread = new Thread();
+    thread->_function = function;
+    thread->_arg = arg;
+
+#ifdef WIN32
+    thread->_handle = CreateThread(NULL, 0, ThreadEntry::entry, thread, 0, NULL);
+    if (thread->_handle == NULL)
+#else
+    pthread_t* handle = new pthread_t;
+    thread->_handle = handle;
+    if (pthread_create(handle, NULL, ThreadEntry::entry, thread) != 0)
+#endif
+    {
+        GP_WARN("Failed to create thread.");
+        thread->_joined = true;
+        SAFE_DELETE(thread);
+    }
+    return thread;
+}
+
+void Thread::run()
+{
+    _function(_arg);
+}
+
+void Thread::join()
+{
+    if (_joined)
+        return;
+
+#ifdef WIN32
+    WaitForSingleObject((HANDLE)_handle, INFINITE);
+#else
+    pthread_join(*static_cast<pthread_t*>(_handle), NULL);
+#endif
+    _joined = true;
+}
+
+bool Thread::isCurrent() const
+{
+#ifdef WIN32
+    return GetThreadId((HANDLE)_handle) == GetCurrentThreadId();
+#else
+    return pthread_equal(*static_cast<pthread_t*>(_handle), pthread_self()) != 0;
+#endif
+}
+
+unsigned int Thread::getHardwareConcurrency()
+{
+    long count = 1;
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (long)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (unsigned int)count : 1;
+}
+
+bool Thread::isMainThread()
+{
+    if (!__mainThreadSet)
+        return true;
+#ifdef WIN32
+    return GetCurrentThreadId() == __mainThread;
+#else
+    return pthread_equal(pthread_self(), __mainThread) != 0;
+#endif
+}
+
+void Thread::setMainThread()
+{
+#ifdef WIN32
+    __mainThread = GetCurrentThreadId();
+#else
+    __mainThread = pthread_self();
+#endif
+    __mainThreadSet = true;
+}
+
+void Thread::yield()
+{
+#ifdef WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+Mutex::Mutex()
+    : _handle(NULL)
+{
+#ifdef WIN32
+    CRITICAL_SECTION* cs = new CRITICAL_SECTION;
+    InitializeCriticalSection(cs);
+    _handle = cs;
+#else
+    pthread_mutex_t* mutex = new pthread_mutex_t;
+    pthread_mutex_init(mutex, NULL);
+    _handle = mutex;
+#endif
+}
+
+Mutex::~Mutex()
+{
+#ifdef WIN32
+    CRITICAL_SECTION* cs = static_cast<CRITICAL_SECTION*>(_handle);
+    DeleteCriticalSection(cs);
+    SAFE_DELETE(cs);
+#else
+    pthread_mutex_t* mutex = static_cast<pthread_mutex_t*>(_handle);
+    pthread_mutex_destroy(mutex);
+    SAFE_DELETE(mutex);
+#endif
+}
+
+void Mutex::lock()
+{
+#ifdef WIN32
+    EnterCriticalSection(static_cast<CRITICAL_SECTION*>(_handle));
+#else
+    pthread_mutex_lock(static_cast<pthread_mutex_t*>(_handle));
+#endif
+}
+
+bool Mutex::tryLock()
+{
+#ifdef WIN32
+    return TryEnterCriticalSection(static_cast<CRITICAL_SECTION*>(_handle)) != 0;
+#else
+    return pthread_mutex_trylock(static_cast<pthread_mutex_t*>(_handle)) == 0;
+#endif
+}
+
+void Mutex::unlock()
+{
+#ifdef WIN32
+    LeaveCriticalSection(static_cast<CRITICAL_SECTION*>(_handle));
+#else
+    pthread_mutex_unlock(static_cast<pthread_mutex_t*>(_handle));
+#endif
+}
+
+Condition::Condition()
+    : _handle(NULL)
+{
+#ifdef WIN32
+    CONDITION_VARIABLE* cv = new CONDITION_VARIABLE;
+    InitializeConditionVariable(cv);
+    _handle = cv;
+#else
+    pthread_cond_t* cv = new pthread_cond_t;
+    pthread_cond_init(cv, NULL);
+    _handle = cv;
+#endif
+}
+
+Condition::~Condition()
+{
+#ifdef WIN32
+    CONDITION_VARIABLE* cv = static_cast<CONDITION_VARIABLE*>(_handle);
+    SAFE_DELETE(cv);
+#else
+    pthread_cond_t* cv = static_cast<pthread_cond_t*>(_handle);
+    pthread_cond_destroy(cv);
+    SAFE_DELETE(cv);
+#endif
+}
+
+void Condition::wait(Mutex& mutex)
+{
+#ifdef WIN32
+    SleepConditionVariableCS(static_cast<CONDITION_VARIABLE*>(_handle), static_cast<CRITICAL_SECTION*>(mutex._handle), INFINITE);
+#else
+    pthread_cond_wait(static_cast<pthread_cond_t*>(_handle), static_cast<pthread_mutex_t*>(mutex._handle));
+#endif
+}
+
+void Condition::signal()
+{
+#ifdef WIN32
+    WakeConditionVariable(static_cast<CONDITION_VARIABLE*>(_handle));
+#else
+    pthread_cond_signal(static_cast<pthread_cond_t*>(_handle));
+#endif
+}
+
+void Condition::broadcast()
+{
+#ifdef WIN32
+    WakeAllConditionVariable(static_cast<CONDITION_VARIABLE*>(_handle));
+#else
+    pthread_cond_broadcast(static_cast<pthread_cond_t*>(_handle));
+#endif
+}
+
+}
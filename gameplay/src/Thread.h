@@ -0,0 +1,295 @@
+#ifndef THREAD_H_
+#define THREAD_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a thin, platform independent wrapper around a native OS thread.
+ *
+ * Threads are created through Thread::create() and begin executing
+ * immediately. A thread must be joined before it is destroyed.
+ *
+ * @script{ignore}
+ */
+class Thread
+{
+    friend struct ThreadEntry;
+    friend class Game;
+
+public:
+
+    /**
+     * Defines the entry point signature of a thread.
+     *
+     * @param arg The user argument passed to Thread::create().
+     */
+    typedef void (*ThreadFunction)(void* arg);
+
+    /**
+     * Creates and starts a new thread.
+     *
+     * @param function The function to execute on the new thread.
+     * @param arg The user argument to pass to the thread function.
+     *
+     * @return The newly created thread, or NULL if the thread could not be created.
+     */
+    static Thread* create(ThreadFunction function, void* arg);
+
+    /**
+     * Destructor.
+     *
+     * The thread must have been joined before being destroyed.
+     */
+    ~Thread();
+
+    /**
+     * Blocks the calling thread until this thread has finished executing.
+     */
+    void join();
+
+    /**
+     * Determines if this thread is the thread currently executing.
+     *
+     * @return true if this is the calling thread, false otherwise.
+     */
+    bool isCurrent() const;
+
+    /**
+     * Gets the number of hardware threads available on the device.
+     *
+     * @return The number of logical processors (always at least 1).
+     */
+    static unsigned int getHardwareConcurrency();
+
+    /**
+     * Determines if the calling thread is the main thread, which runs the game loop.
+     *
+     * Before the game has started up, every thread is considered the main thread.
+     *
+     * @return true if the calling thread is the main thread, false otherwise.
+     */
+    static bool isMainThread();
+
+    /**
+     * Yields the remainder of the calling thread's time slice.
+     */
+    static void yield();
+
+private:
+
+    Thread();
+    Thread(const Thread& copy);
+    Thread& operator=(const Thread&);
+
+    void run();
+
+    // Records the calling thread as the main thread (called by the game on startup).
+    static void setMainThread();
+
+    ThreadFunction _function;
+    void* _arg;
+    void* _handle;
+    bool _joined;
+};
+
+/**
+ * Defines a mutual exclusion lock.
+ *
+ * @script{ignore}
+ */
+class Mutex
+{
+    friend class Condition;
+
+public:
+
+    /**
+     * Constructor.
+     */
+    Mutex();
+
+    /**
+     * Destructor.
+     */
+    ~Mutex();
+
+    /**
+     * Acquires the lock, blocking until it is available.
+     */
+    void lock();
+
+    /**
+     * Attempts to acquire the lock without blocking.
+     *
+     * @return true if the lock was acquired, false otherwise.
+     */
+    bool tryLock();
+
+    /**
+     * Releases the lock.
+     */
+    void unlock();
+
+private:
+
+    Mutex(const Mutex& copy);
+    Mutex& operator=(const Mutex&);
+
+    void* _handle;
+};
+
+/**
+ * Locks a mutex for the lifetime of the object.
+ *
+ * @script{ignore}
+ */
+class MutexLock
+{
+public:
+
+    /**
+     * Constructor. Locks the specified mutex.
+     *
+     * @param mutex The mutex to lock.
+     */
+    inline explicit MutexLock(Mutex& mutex);
+
+    /**
+     * Destructor. Unlocks the mutex.
+     */
+    inline ~MutexLock();
+
+private:
+
+    MutexLock(const MutexLock& copy);
+    MutexLock& operator=(const MutexLock&);
+
+    Mutex& _mutex;
+};
+
+/**
+ * Defines a condition variable used to block threads until signaled.
+ *
+ * @script{ignore}
+ */
+class Condition
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    Condition();
+
+    /**
+     * Destructor.
+     */
+    ~Condition();
+
+    /**
+     * Atomically releases the specified (locked) mutex and blocks until
+     * the condition is signaled. The mutex is locked again before returning.
+     *
+     * Spurious wake ups are possible, so callers must re-check their predicate.
+     *
+     * @param mutex The locked mutex protecting the predicate.
+     */
+    void wait(Mutex& mutex);
+
+    /**
+     * Wakes one thread waiting on the condition.
+     */
+    void signal();
+
+    /**
+     * Wakes all threads waiting on the condition.
+     */
+    void broadcast();
+
+private:
+
+    Condition(const Condition& copy);
+    Condition& operator=(const Condition&);
+
+    void* _handle;
+};
+
+/**
+ * Defines an integer that is read and modified atomically.
+ *
+ * All modifying operations are full memory barriers.
+ *
+ * @script{ignore}
+ */
+class AtomicInt
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param value The initial value.
+     */
+    inline explicit AtomicInt(int value = 0);
+
+    /**
+     * Gets the current value.
+     *
+     * @return The current value.
+     */
+    inline int get() const;
+
+    /**
+     * Sets the value.
+     *
+     * @param value The new value.
+     */
+    inline void set(int value);
+
+    /**
+     * Atomically increments the value.
+     *
+     * @return The incremented value.
+     */
+    inline int increment();
+
+    /**
+     * Atomically decrements the value.
+     *
+     * @return The decremented value.
+     */
+    inline int decrement();
+
+    /**
+     * Atomically adds to the value.
+     *
+     * @param amount The amount to add.
+     *
+     * @return The resulting value.
+     */
+    inline int add(int amount);
+
+    /**
+     * Atomically replaces the value with newValue if it currently equals expected.
+     *
+     * @param expected The value expected to be held.
+     * @param newValue The value to store.
+     *
+     * @return true if the value was exchanged, false otherwise.
+     */
+    inline bool compareExchange(int expected, int newValue);
+
+private:
+
+    AtomicInt(const AtomicInt& copy);
+    AtomicInt& operator=(const AtomicInt&);
+
+    volatile long _value;
+};
+
+}
+
+#include "Thread.inl"
+
+#endif
@@ -0,0 +1,83 @@
+#include "Thread.h"
+
+#ifdef WIN32
+#include <intrin.h>
+#endif
+
+namespace gameplay
+{
+
+inline MutexLock::MutexLock(Mutex& mutex)
+    : _mutex(mutex)
+{
+    _mutex.lock();
+}
+
+inline MutexLock::~MutexLock()
+{
+    _mutex.unlock();
+}
+
+inline AtomicInt::AtomicInt(int value)
+    : _value(value)
+{
+}
+
+inline int AtomicInt::get() const
+{
+#ifdef WIN32
+    return (int)_InterlockedCompareExchange(const_cast<volatile long*>(&_value), 0, 0);
+#else
+    return (int)__sync_add_and_fetch(const_cast<volatile long*>(&_value), 0);
+#endif
+}
+
+inline void AtomicInt::set(int value)
+{
+#ifdef WIN32
+    _InterlockedExchange(&_value, value);
+#else
+    // __sync_lock_test_and_set is only an acquire barrier, so the writes before it are fenced explicitly.
+    __sync_synchronize();
+    __sync_lock_test_and_set(&_value, (long)value);
+    __sync_synchronize();
+#endif
+}
+
+inline int AtomicInt::increment()
+{
+#ifdef WIN32
+    return (int)_InterlockedIncrement(&_value);
+#else
+    return (int)__sync_add_and_fetch(&_value, 1);
+#endif
+}
+
+inline int AtomicInt::decrement()
+{
+#ifdef WIN32
+    return (int)_InterlockedDecrement(&_value);
+#else
+    return (int)__sync_sub_and_fetch(&_value, 1);
+#endif
+}
+
+inline int AtomicInt::add(int amount)
+{
+#ifdef WIN32
+    return (int)_InterlockedExchangeAdd(&_value, amount) + amount;
+#else
+    return (int)__sync_add_and_fetch(&_value, (long)amount);
+#endif
+}
+
+inline bool AtomicInt::compareExchange(int expected, int newValue)
+{
+#ifdef WIN32
+    return _InterlockedCompareExchange(&_value, newValue, expected) == expected;
+#else
+    return __sync_bool_compare_and_swap(&_value, (long)expected, (long)newValue);
+#endif
+}
+
+}
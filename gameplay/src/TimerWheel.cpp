@@ -0,0 +1,243 @@
+#include "Base.h"
+#include "TimerWheel.h"
+
+// Index of no timer, ending the lists of the slots and the free list.
+#define TIMER_NONE 0xFFFFFFFF
+
+// Slot values of timers that are not linked into the wheel.
+#define TIMER_SLOT_FREE 0xFFFF
+#define TIMER_SLOT_FIRING 0xFFFE
+
+// Handles hold the index of a timer in their low bits and its generation in their high bits.
+#define TIMER_INDEX_BITS 20
+#define TIMER_INDEX_MASK ((1u << TIMER_INDEX_BITS) - 1)
+#define TIMER_GENERATION_MASK ((1u << (32 - TIMER_INDEX_BITS)) - 1)
+
+namespace gameplay
+{
+
+TimerWheel::TimerWheel()
+    : _free(TIMER_NONE), _count(0), _currentTick(0)
+{
+    for (unsigned int i = 0; i < LEVEL_COUNT * LEVEL_SLOTS; ++i)
+    {
+        _slots[i] = TIMER_NONE;
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+}
+
+unsigned int TimerWheel::add(double time, TimeListener* listener, void* cookie)
+{
+    unsigned int index = _free;
+    if (index == TIMER_NONE)
+    {
+        if (_timers.size() >= TIMER_INDEX_MASK)
+        {
+            GP_ERROR("Too many scheduled time events (%u).", _count);
+            return 0;
+        }
+        index = (unsigned int)_timers.size();
+        Timer timer;
+        timer.generation = 0;
+        _timers.push_back(timer);
+    }
+    else
+    {
+        _free = _timers[index].next;
+    }
+
+    Timer& timer = _timers[index];
+    timer.time = time;
+    timer.tick = time > 0.0 ? (unsigned long long)time : 0;
+    timer.listener = listener;
+    timer.cookie = cookie;
+
+    // Generations skip zero so that no handle is zero.
+    timer.generation = (unsigned short)((timer.generation + 1) & TIMER_GENERATION_MASK);
+    if (timer.generation == 0)
+        timer.generation = 1;
+
+    link(index);
+    ++_count;
+    return (timer.generation << TIMER_INDEX_BITS) | index;
+}
+
+bool TimerWheel::remove(unsigned int handle)
+{
+    unsigned int index = handle & TIMER_INDEX_MASK;
+    if (handle == 0 || index >= _timers.size())
+        return false;
+
+    Timer& timer = _timers[index];
+    if (timer.slot == TIMER_SLOT_FREE || timer.generation != (handle >> TIMER_INDEX_BITS))
+        return false;
+
+    if (timer.slot == TIMER_SLOT_FIRING)
+    {
+        // The batch being fired releases the timer without notifying it.
+        if (timer.listener == NULL)
+            return false;
+        timer.listener = NULL;
+        return true;
+    }
+
+    unlink(index);
+    release(index);
+    return true;
+}
+
+void TimerWheel::clear()
+{
+    for (unsigned int i = 0; i < LEVEL_COUNT * LEVEL_SLOTS; ++i)
+    {
+        _slots[i] = TIMER_NONE;
+    }
+    _free = TIMER_NONE;
+    for (unsigned int i = (unsigned int)_timers.size(); i-- > 0;)
+    {
+        _timers[i].slot = TIMER_SLOT_FREE;
+        _timers[i].next = _free;
+        _free = i;
+    }
+    _batch.clear();
+    _count = 0;
+}
+
+void TimerWheel::advance(double time)
+{
+    unsigned long long target = time > 0.0 ? (unsigned long long)time : 0;
+    while (true)
+    {
+        // Nothing is left to fire in the ticks to come.
+        if (_count == 0)
+        {
+            if (target > _currentTick)
+                _currentTick = target;
+            return;
+        }
+
+        fire((unsigned int)(_currentTick & (LEVEL_SLOTS - 1)), time);
+
+        // Timers of the current tick that are not due yet stay in their slot until the next call.
+        if (_currentTick >= target)
+            return;
+
+        ++_currentTick;
+        for (unsigned int level = 1; level < LEVEL_COUNT; ++level)
+        {
+            if ((_currentTick >> (LEVEL_BITS * (level - 1))) & (LEVEL_SLOTS - 1))
+                break;
+            cascade(level);
+        }
+    }
+}
+
+unsigned int TimerWheel::getCount() const
+{
+    return _count;
+}
+
+void TimerWheel::link(unsigned int index)
+{
+    Timer& timer = _timers[index];
+
+    // Timers that are already due go into the slot of the current tick.
+    unsigned long long tick = std::max(timer.tick, _currentTick);
+    unsigned long long delta = tick - _currentTick;
+    unsigned int level = 0;
+    while (level < LEVEL_COUNT - 1 && delta >= (1ull << (LEVEL_BITS * (level + 1))))
+    {
+        ++level;
+    }
+    if (level == LEVEL_COUNT - 1 && delta >= (1ull << (LEVEL_BITS * LEVEL_COUNT)))
+    {
+        // Timers beyond the range of the wheel wait in its last slot and are linked again when it cascades.
+        tick = _currentTick + (1ull << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+    }
+    unsigned int slot = level * LEVEL_SLOTS + (unsigned int)((tick >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+
+    timer.slot = (unsigned short)slot;
+    timer.prev = TIMER_NONE;
+    timer.next = _slots[slot];
+    if (timer.next != TIMER_NONE)
+        _timers[timer.next].prev = index;
+    _slots[slot] = index;
+}
+
+void TimerWheel::unlink(unsigned int index)
+{
+    Timer& timer = _timers[index];
+    GP_ASSERT(timer.slot < LEVEL_COUNT * LEVEL_SLOTS);
+
+    if (timer.prev != TIMER_NONE)
+        _timers[timer.prev].next = timer.next;
+    else
+        _slots[timer.slot] = timer.next;
+    if (timer.next != TIMER_NONE)
+        _timers[timer.next].prev = timer.prev;
+}
+
+void TimerWheel::release(unsigned int index)
+{
+    Timer& timer = _timers[index];
+    timer.slot = TIMER_SLOT_FREE;
+    timer.listener = NULL;
+    timer.next = _free;
+    _free = index;
+    --_count;
+}
+
+void TimerWheel::cascade(unsigned int level)
+{
+    unsigned int slot = level * LEVEL_SLOTS + (unsigned int)((_currentTick >> (LEVEL_BITS * level)) & (LEVEL_SLOTS - 1));
+    unsigned int index = _slots[slot];
+    _slots[slot] = TIMER_NONE;
+    while (index != TIMER_NONE)
+    {
+        unsigned int next = _timers[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::fire(unsigned int slot, double time)
+{
+    // Listeners may add timers to this slot that are already due, so it is scanned until none are left.
+    while (true)
+    {
+        _batch.clear();
+        for (unsigned int index = _slots[slot]; index != TIMER_NONE;)
+        {
+            Timer& timer = _timers[index];
+            unsigned int next = timer.next;
+            if (timer.time <= time)
+            {
+                unlink(index);
+                timer.slot = TIMER_SLOT_FIRING;
+                _batch.push_back(std::make_pair(timer.time, index));
+            }
+            index = next;
+        }
+        if (_batch.empty())
+            return;
+
+        if (_batch.size() > 1)
+            std::sort(_batch.begin(), _batch.end());
+
+        // Listeners may add and cancel timers, which can move the timers in memory.
+        for (size_t i = 0; i < _batch.size(); ++i)
+        {
+            unsigned int index = _batch[i].second;
+            TimeListener* listener = _timers[index].listener;
+            void* cookie = _timers[index].cookie;
+            release(index);
+            if (listener)
+                listener->timeEvent((long)(time - _batch[i].first), cookie);
+        }
+    }
+}
+
+}
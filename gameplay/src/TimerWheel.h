@@ -0,0 +1,150 @@
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include "TimeListener.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a hierarchical timer wheel that holds the time events scheduled with Game::schedule().
+ *
+ * Time is divided into ticks of one millisecond. The wheel has four levels of 256 slots;
+ * a timer is linked into the slot of the lowest level that covers its distance from the
+ * current tick, and timers of higher levels cascade down a level each time the level below
+ * wraps around. Adding and cancelling a timer therefore take constant time regardless of
+ * the number of scheduled timers, and advancing the wheel only visits the slots of the
+ * ticks that have passed.
+ *
+ * The timers that are due in a slot are fired as a batch, in the order of their time.
+ * Timers are stored in a single array that is recycled through a free list, so a game
+ * that keeps a steady number of timers scheduled does not allocate.
+ *
+ * Timers are identified by handles, which stay valid until the timer has fired or has
+ * been cancelled. A handle of zero is never returned.
+ *
+ * @script{ignore}
+ */
+class TimerWheel
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    TimerWheel();
+
+    /**
+     * Destructor.
+     */
+    ~TimerWheel();
+
+    /**
+     * Adds a timer.
+     *
+     * @param time The game time at which the timer fires, in milliseconds.
+     * @param listener The listener to notify.
+     * @param cookie The cookie to pass to the listener.
+     *
+     * @return The handle of the timer, or 0 if the wheel is full.
+     */
+    unsigned int add(double time, TimeListener* listener, void* cookie);
+
+    /**
+     * Cancels a timer.
+     *
+     * @param handle The handle of the timer.
+     *
+     * @return true if the timer was cancelled, false if it has already fired or been cancelled.
+     */
+    bool remove(unsigned int handle);
+
+    /**
+     * Cancels all the timers.
+     */
+    void clear();
+
+    /**
+     * Advances the wheel to the given time and fires the timers that are due.
+     *
+     * Timers that are added by the listeners for a time that is already due are fired
+     * in the same call.
+     *
+     * @param time The current game time, in milliseconds.
+     */
+    void advance(double time);
+
+    /**
+     * Gets the number of scheduled timers.
+     *
+     * @return The number of timers.
+     */
+    unsigned int getCount() const;
+
+private:
+
+    enum
+    {
+        LEVEL_BITS = 8,
+        LEVEL_SLOTS = 1 << LEVEL_BITS,
+        LEVEL_COUNT = 4
+    };
+
+    struct Timer
+    {
+        double time;
+        unsigned long long tick;
+        TimeListener* listener;
+        void* cookie;
+        unsigned int prev;
+        unsigned int next;
+        unsigned short slot;
+        unsigned short generation;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    TimerWheel(const TimerWheel& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TimerWheel& operator=(const TimerWheel&);
+
+    /**
+     * Links a timer into the slot that covers its tick.
+     */
+    void link(unsigned int index);
+
+    /**
+     * Unlinks a timer from its slot.
+     */
+    void unlink(unsigned int index);
+
+    /**
+     * Returns a timer to the free list.
+     */
+    void release(unsigned int index);
+
+    /**
+     * Moves the timers of a slot of a higher level into the lower levels.
+     */
+    void cascade(unsigned int level);
+
+    /**
+     * Fires the due timers of a slot of the first level.
+     */
+    void fire(unsigned int slot, double time);
+
+    std::vector<Timer> _timers;
+    std::vector<std::pair<double, unsigned int> > _batch;
+    unsigned int _slots[LEVEL_COUNT * LEVEL_SLOTS];
+    unsigned int _free;
+    unsigned int _count;
+    unsigned long long _currentTick;
+};
+
+}
+
+#endif
@@ -8,9 +8,11 @@ namespace gameplay
 
 int Transform::_suspendTransformChanged(0);
 std::vector<Transform*> Transform::_transformsChanged;
+std::vector<Transform*> Transform::_transformsPending;
+std::vector<Transform*> Transform::_interpolatedTransforms;
 
 Transform::Transform()
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _interpolation(NULL), _notifyPending(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     _scale.set(Vector3::one());
@@ -18,7 +20,7 @@ Transform::Transform()
 }
 
 Transform::Transform(const Vector3& scale, const Quaternion& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _interpolation(NULL), _notifyPending(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(scale, rotation, translation);
@@ -26,7 +28,7 @@ Transform::Transform(const Vector3& scale, const Quaternion& rotation, const Vec
 }
 
 Transform::Transform(const Vector3& scale, const Matrix& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _interpolation(NULL), _notifyPending(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(scale, rotation, translation);
@@ -34,7 +36,7 @@ Transform::Transform(const Vector3& scale, const Matrix& rotation, const Vector3
 }
 
 Transform::Transform(const Transform& copy)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _interpolation(NULL), _notifyPending(false)
 {
     _targetType = AnimationTarget::TRANSFORM;
     set(copy);
@@ -43,7 +45,14 @@ Transform::Transform(const Transform& copy)
 
 Transform::~Transform()
 {
-    SAFE_DELETE(_listeners);
+    setInterpolationEnabled(false);
+
+    if (_notifyPending)
+    {
+        std::vector<Transform*>::iterator itr = std::find(_transformsPending.begin(), _transformsPending.end(), this);
+        if (itr != _transformsPending.end())
+            *itr = NULL;
+    }
 }
 
 void Transform::suspendTransformChanged()
@@ -922,6 +931,92 @@ void Transform::setAnimationPropertyValue(int propertyId, AnimationValue* value,
     }
 }
 
+Transform::AnimationPropertySetter Transform::getAnimationPropertySetter(int propertyId) const
+{
+    // The single component properties keep going through setAnimationPropertyValue.
+    switch (propertyId)
+    {
+        case ANIMATE_SCALE:
+            return setAnimationScale;
+        case ANIMATE_ROTATE:
+            return setAnimationRotate;
+        case ANIMATE_TRANSLATE:
+            return setAnimationTranslate;
+        case ANIMATE_ROTATE_TRANSLATE:
+            return setAnimationRotateTranslate;
+        case ANIMATE_SCALE_ROTATE:
+            return setAnimationScaleRotate;
+        case ANIMATE_SCALE_TRANSLATE:
+            return setAnimationScaleTranslate;
+        case ANIMATE_SCALE_ROTATE_TRANSLATE:
+            return setAnimationScaleRotateTranslate;
+        default:
+            return NULL;
+    }
+}
+
+void Transform::setAnimationScale(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(value, NULL, NULL, blendWeight);
+}
+
+void Transform::setAnimationRotate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(NULL, value, NULL, blendWeight);
+}
+
+void Transform::setAnimationTranslate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(NULL, NULL, value, blendWeight);
+}
+
+void Transform::setAnimationRotateTranslate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(NULL, value, value + 4, blendWeight);
+}
+
+void Transform::setAnimationScaleRotate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(value, value + 3, NULL, blendWeight);
+}
+
+void Transform::setAnimationScaleTranslate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(value, NULL, value + 3, blendWeight);
+}
+
+void Transform::setAnimationScaleRotateTranslate(AnimationTarget* target, const float* value, float blendWeight)
+{
+    static_cast<Transform*>(target)->applyAnimationValues(value, value + 3, value + 7, blendWeight);
+}
+
+void Transform::applyAnimationValues(const float* scale, const float* rotation, const float* translation, float blendWeight)
+{
+    GP_ASSERT(blendWeight >= 0.0f && blendWeight <= 1.0f);
+
+    if (isStatic())
+        return;
+
+    char bits = 0;
+    if (scale)
+    {
+        _scale.set(Curve::lerp(blendWeight, _scale.x, scale[0]), Curve::lerp(blendWeight, _scale.y, scale[1]), Curve::lerp(blendWeight, _scale.z, scale[2]));
+        bits |= DIRTY_SCALE;
+    }
+    if (rotation)
+    {
+        Quaternion::slerp(_rotation.x, _rotation.y, _rotation.z, _rotation.w, rotation[0], rotation[1], rotation[2], rotation[3], blendWeight,
+            &_rotation.x, &_rotation.y, &_rotation.z, &_rotation.w);
+        bits |= DIRTY_ROTATION;
+    }
+    if (translation)
+    {
+        _translation.set(Curve::lerp(blendWeight, _translation.x, translation[0]), Curve::lerp(blendWeight, _translation.y, translation[1]), Curve::lerp(blendWeight, _translation.z, translation[2]));
+        bits |= DIRTY_TRANSLATION;
+    }
+    dirty(bits);
+}
+
 void Transform::dirty(char matrixDirtyBits)
 {
     _matrixDirtyBits |= matrixDirtyBits;
@@ -938,6 +1033,79 @@ void Transform::dirty(char matrixDirtyBits)
     }
 }
 
+void Transform::setInterpolationEnabled(bool enabled)
+{
+    if (enabled == (_interpolation != NULL))
+        return;
+
+    if (enabled)
+    {
+        _interpolation = new InterpolationState();
+        _interpolation->scale[0] = _scale;
+        _interpolation->rotation[0] = _rotation;
+        _interpolation->translation[0] = _translation;
+        _interpolatedTransforms.push_back(this);
+    }
+    else
+    {
+        SAFE_DELETE(_interpolation);
+        std::vector<Transform*>::iterator itr = std::find(_interpolatedTransforms.begin(), _interpolatedTransforms.end(), this);
+        if (itr != _interpolatedTransforms.end())
+            _interpolatedTransforms.erase(itr);
+    }
+}
+
+bool Transform::isInterpolationEnabled() const
+{
+    return _interpolation != NULL;
+}
+
+void Transform::storeInterpolationStates()
+{
+    for (size_t i = 0, count = _interpolatedTransforms.size(); i < count; ++i)
+    {
+        Transform* t = _interpolatedTransforms[i];
+        t->_interpolation->scale[0] = t->_scale;
+        t->_interpolation->rotation[0] = t->_rotation;
+        t->_interpolation->translation[0] = t->_translation;
+    }
+}
+
+void Transform::beginInterpolation(float alpha)
+{
+    for (size_t i = 0, count = _interpolatedTransforms.size(); i < count; ++i)
+    {
+        Transform* t = _interpolatedTransforms[i];
+        InterpolationState* state = t->_interpolation;
+        state->scale[1] = t->_scale;
+        state->rotation[1] = t->_rotation;
+        state->translation[1] = t->_translation;
+        if (t->isStatic())
+            continue;
+
+        t->_scale = state->scale[0] + (state->scale[1] - state->scale[0]) * alpha;
+        Quaternion::slerp(state->rotation[0], state->rotation[1], alpha, &t->_rotation);
+        t->_translation = state->translation[0] + (state->translation[1] - state->translation[0]) * alpha;
+        t->dirty(DIRTY_SCALE | DIRTY_ROTATION | DIRTY_TRANSLATION);
+    }
+}
+
+void Transform::endInterpolation()
+{
+    for (size_t i = 0, count = _interpolatedTransforms.size(); i < count; ++i)
+    {
+        Transform* t = _interpolatedTransforms[i];
+        if (t->isStatic())
+            continue;
+
+        InterpolationState* state = t->_interpolation;
+        t->_scale = state->scale[1];
+        t->_rotation = state->rotation[1];
+        t->_translation = state->translation[1];
+        t->dirty(DIRTY_SCALE | DIRTY_ROTATION | DIRTY_TRANSLATION);
+    }
+}
+
 bool Transform::isDirty(char matrixDirtyBits) const
 {
     return (_matrixDirtyBits & matrixDirtyBits) == matrixDirtyBits;
@@ -950,48 +1118,72 @@ void Transform::suspendTransformChange(Transform* transform)
     _transformsChanged.push_back(transform);
 }
 
-void Transform::addListener(Transform::Listener* listener, long cookie)
+void Transform::addListener(Transform::Listener* listener, long cookie, bool deferred)
 {
     GP_ASSERT(listener);
 
-    if (_listeners == NULL)
-        _listeners = new std::list<TransformListener>();
-
     TransformListener l;
     l.listener = listener;
     l.cookie = cookie;
-    _listeners->push_back(l);
+    l.deferred = deferred;
+    _listeners.push_back(l);
 }
 
 void Transform::removeListener(Transform::Listener* listener)
 {
     GP_ASSERT(listener);
 
-    if (_listeners)
+    for (std::vector<TransformListener>::iterator itr = _listeners.begin(); itr != _listeners.end(); ++itr)
     {
-        for (std::list<TransformListener>::iterator itr = _listeners->begin(); itr != _listeners->end(); ++itr)
+        if ((*itr).listener == listener)
         {
-            if ((*itr).listener == listener)
-            {
-                _listeners->erase(itr);
-                break;
-            }
+            _listeners.erase(itr);
+            break;
         }
     }
 }
 
 void Transform::transformChanged()
 {
-    if (_listeners)
+    // Listeners may add or remove listeners, so index the array instead of holding iterators.
+    bool pending = hasScriptCallbacks("transformChanged");
+    for (size_t i = 0; i < _listeners.size(); ++i)
     {
-        for (std::list<TransformListener>::iterator itr = _listeners->begin(); itr != _listeners->end(); ++itr)
-        {
-            TransformListener& l = *itr;
-            GP_ASSERT(l.listener);
+        TransformListener l = _listeners[i];
+        GP_ASSERT(l.listener);
+        if (l.deferred)
+            pending = true;
+        else
             l.listener->transformChanged(this, l.cookie);
+    }
+
+    // The other listeners are notified once by notifyTransformsChanged.
+    if (pending && !_notifyPending)
+    {
+        _notifyPending = true;
+        _transformsPending.push_back(this);
+    }
+}
+
+void Transform::notifyTransformsChanged()
+{
+    // Transforms changed by the listeners are added to the array and notified in the same pass.
+    for (size_t i = 0; i < _transformsPending.size(); ++i)
+    {
+        Transform* t = _transformsPending[i];
+        if (t == NULL)
+            continue;
+        t->_notifyPending = false;
+
+        for (size_t j = 0; j < t->_listeners.size(); ++j)
+        {
+            TransformListener l = t->_listeners[j];
+            if (l.deferred)
+                l.listener->transformChanged(t, l.cookie);
         }
+        t->fireScriptEvent<void>("transformChanged", t);
     }
-    fireScriptEvent<void>("transformChanged", this);
+    _transformsPending.clear();
 }
 
 void Transform::cloneInto(Transform* transform, NodeCloneContext &context) const
@@ -7,6 +7,7 @@
 #include "Matrix.h"
 #include "AnimationTarget.h"
 #include "ScriptTarget.h"
+#include "Allocator.h"
 
 namespace gameplay
 {
@@ -31,6 +32,10 @@ class ScriptListener;
  */
 class Transform : public AnimationTarget, public ScriptTarget
 {
+    friend class Game;
+
+    GP_POOLED_ALLOCATION(SCENE)
+
 public:
 
     /**
@@ -760,10 +765,18 @@ public:
     /**
      * Adds a transform listener.
      *
+     * By default the listener is not called on every change. Changed transforms are
+     * collected and their deferred listeners, and the transformChanged script event,
+     * are notified once per simulation tick, after animations and before physics
+     * are updated, however many times each transform changed since the last time.
+     * Listeners that must observe every change as it happens can ask to be notified
+     * immediately instead.
+     *
      * @param listener The listener to add.
      * @param cookie An optional long value that is passed to the specified listener when it is called.
+     * @param deferred False to notify the listener immediately on every change.
      */
-    void addListener(Transform::Listener* listener, long cookie = 0);
+    void addListener(Transform::Listener* listener, long cookie = 0, bool deferred = true);
 
     /**
      * Removes a transform listener.
@@ -771,6 +784,26 @@ public:
      * @param listener The listener to remove.
      */
     void removeListener(Transform::Listener* listener);
+
+    /**
+     * Enables or disables the interpolation of this transform between simulation ticks.
+     *
+     * When the game runs with a fixed tick rate (see Game::setFixedTickRate), the
+     * transform keeps its state from the previous tick, and while the game renders
+     * it is set to the state between the previous and current ticks given by
+     * Game::getInterpolationAlpha(). The current state is restored after rendering,
+     * so the transform should not be modified from render().
+     *
+     * @param enabled True to interpolate the transform.
+     */
+    void setInterpolationEnabled(bool enabled);
+
+    /**
+     * Determines if this transform is interpolated between simulation ticks.
+     *
+     * @return True if the transform is interpolated.
+     */
+    bool isInterpolationEnabled() const;
     
     /**
      * @see AnimationTarget::getAnimationPropertyComponentCount
@@ -789,6 +822,11 @@ public:
 
 protected:
 
+    /**
+     * @see AnimationTarget::getAnimationPropertySetter
+     */
+    AnimationPropertySetter getAnimationPropertySetter(int propertyId) const;
+
     /**
      * Transform Listener.
      */
@@ -803,6 +841,11 @@ protected:
          * An optional long value that is specified to the Listener's callback.
          */
         long cookie;
+
+        /**
+         * Whether the listener is notified once per tick instead of on every change.
+         */
+        bool deferred;
     };
 
     /**
@@ -877,14 +920,66 @@ protected:
     /** 
      * List of TransformListener's on the Transform.
      */
-    std::list<TransformListener>* _listeners;
+    std::vector<TransformListener> _listeners;
 
 private:
+
+    struct InterpolationState
+    {
+        Vector3 scale[2];           // The previous tick and current state.
+        Quaternion rotation[2];
+        Vector3 translation[2];
+    };
    
     void applyAnimationValueRotation(AnimationValue* value, unsigned int index, float blendWeight);
 
+    /**
+     * Blends the scale, rotation and translation given by an animation value, and dirties the transform once.
+     *
+     * @param scale The scale components, or NULL.
+     * @param rotation The rotation components, or NULL.
+     * @param translation The translation components, or NULL.
+     * @param blendWeight The blend weight.
+     */
+    void applyAnimationValues(const float* scale, const float* rotation, const float* translation, float blendWeight);
+
+    static void setAnimationScale(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationRotate(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationTranslate(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationRotateTranslate(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationScaleRotate(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationScaleTranslate(AnimationTarget* target, const float* value, float blendWeight);
+    static void setAnimationScaleRotateTranslate(AnimationTarget* target, const float* value, float blendWeight);
+
+    /**
+     * Stores the state of the interpolated transforms before a simulation tick.
+     */
+    static void storeInterpolationStates();
+
+    /**
+     * Sets the interpolated transforms to their state between the previous and current ticks.
+     *
+     * @param alpha The position between the previous (0) and current (1) tick.
+     */
+    static void beginInterpolation(float alpha);
+
+    /**
+     * Restores the current state of the interpolated transforms.
+     */
+    static void endInterpolation();
+
+    /**
+     * Notifies the deferred listeners of the transforms changed since the last call.
+     */
+    static void notifyTransformsChanged();
+
+    InterpolationState* _interpolation;
+    bool _notifyPending;
+
     static int _suspendTransformChanged;
     static std::vector<Transform*> _transformsChanged;
+    static std::vector<Transform*> _transformsPending;
+    static std::vector<Transform*> _interpolatedTransforms;
     
 };
 
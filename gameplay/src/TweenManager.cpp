@@ -0,0 +1,278 @@
+#include "Base.h"
+#include "TweenManager.h"
+#include "AnimationValue.h"
+#include "Transform.h"
+#include "Quaternion.h"
+
+// The default maximum number of running tweens.
+#define TWEEN_DEFAULT_CAPACITY 256
+
+namespace gameplay
+{
+
+TweenManager::TweenManager()
+    : _capacity(0), _count(0), _nextId(0)
+{
+}
+
+TweenManager::~TweenManager()
+{
+}
+
+void TweenManager::initialize(Properties* properties)
+{
+    _capacity = TWEEN_DEFAULT_CAPACITY;
+    if (properties && properties->exists("capacity"))
+        _capacity = (unsigned int)std::max(1, properties->getInt("capacity"));
+
+    _count = 0;
+    _ids.resize(_capacity);
+    _targets.resize(_capacity);
+    _propertyIds.resize(_capacity);
+    _setters.resize(_capacity);
+    _componentCounts.resize(_capacity);
+    _rotationOffsets.resize(_capacity);
+    _types.resize(_capacity);
+    _elapsed.resize(_capacity);
+    _durations.resize(_capacity);
+    _from.resize(_capacity * MAX_COMPONENTS);
+    _to.resize(_capacity * MAX_COMPONENTS);
+    _values.resize(_capacity * MAX_COMPONENTS);
+    _listeners.resize(_capacity);
+    _finished.reserve(_capacity);
+
+    // Each slot passes its values to setAnimationPropertyValue through its own animation value.
+    _animationValues.resize(_capacity);
+    for (unsigned int i = 0; i < _capacity; ++i)
+        _animationValues[i] = new AnimationValue(MAX_COMPONENTS, &_values[i * MAX_COMPONENTS]);
+}
+
+void TweenManager::finalize()
+{
+    stopAll();
+    for (size_t i = 0, count = _animationValues.size(); i < count; ++i)
+        SAFE_DELETE(_animationValues[i]);
+    _animationValues.clear();
+    _capacity = 0;
+}
+
+int TweenManager::start(AnimationTarget* target, int propertyId, const float* to, unsigned long duration,
+                        Curve::InterpolationType type, unsigned long delay, Listener* listener)
+{
+    return start(target, propertyId, NULL, to, duration, type, delay, listener);
+}
+
+int TweenManager::start(AnimationTarget* target, int propertyId, const float* from, const float* to, unsigned long duration,
+                        Curve::InterpolationType type, unsigned long delay, Listener* listener)
+{
+    GP_ASSERT(target);
+    GP_ASSERT(to);
+
+    const unsigned int componentCount = target->getAnimationPropertyComponentCount(propertyId);
+    if (componentCount == 0 || componentCount > MAX_COMPONENTS)
+    {
+        GP_ERROR("Property %d cannot be tweened (%u components).", propertyId, componentCount);
+        return -1;
+    }
+
+    // A new tween of the property replaces the running one.
+    if (target->_tweenCount > 0)
+        stop(target, propertyId);
+    if (_count >= _capacity)
+    {
+        GP_WARN("The tween manager is full (%u tweens).", _capacity);
+        return -1;
+    }
+
+    const unsigned int index = _count++;
+    const unsigned int offset = index * MAX_COMPONENTS;
+    AnimationValue* value = _animationValues[index];
+    value->_componentCount = componentCount;
+    value->_componentSize = componentCount * sizeof(float);
+    if (from)
+    {
+        memcpy(&_from[offset], from, componentCount * sizeof(float));
+    }
+    else
+    {
+        target->getAnimationPropertyValue(propertyId, value);
+        memcpy(&_from[offset], &_values[offset], componentCount * sizeof(float));
+    }
+    memcpy(&_to[offset], to, componentCount * sizeof(float));
+
+    int rotationOffset = -1;
+    if (target->_targetType == AnimationTarget::TRANSFORM)
+    {
+        switch (propertyId)
+        {
+        case Transform::ANIMATE_ROTATE:
+        case Transform::ANIMATE_ROTATE_TRANSLATE:
+            rotationOffset = 0;
+            break;
+        case Transform::ANIMATE_SCALE_ROTATE:
+        case Transform::ANIMATE_SCALE_ROTATE_TRANSLATE:
+            rotationOffset = 3;
+            break;
+        }
+    }
+
+    _ids[index] = _nextId;
+    _nextId = _nextId == INT_MAX ? 0 : _nextId + 1;
+    _targets[index] = target;
+    _propertyIds[index] = propertyId;
+    _setters[index] = target->getAnimationPropertySetter(propertyId);
+    _componentCounts[index] = componentCount;
+    _rotationOffsets[index] = rotationOffset;
+    _types[index] = type;
+    _elapsed[index] = -(float)delay;
+    _durations[index] = (float)duration;
+    _listeners[index] = listener;
+    ++target->_tweenCount;
+    return _ids[index];
+}
+
+void TweenManager::stop(int id)
+{
+    int index = find(id);
+    if (index >= 0)
+        remove((unsigned int)index);
+}
+
+void TweenManager::stop(AnimationTarget* target, int propertyId)
+{
+    GP_ASSERT(target);
+
+    for (unsigned int i = 0; i < _count && target->_tweenCount > 0; )
+    {
+        if (_targets[i] == target && (propertyId < 0 || _propertyIds[i] == propertyId))
+            remove(i);
+        else
+            ++i;
+    }
+}
+
+void TweenManager::stopAll()
+{
+    while (_count > 0)
+        remove(_count - 1);
+}
+
+bool TweenManager::isRunning(int id) const
+{
+    return find(id) >= 0;
+}
+
+unsigned int TweenManager::getTweenCount() const
+{
+    return _count;
+}
+
+unsigned int TweenManager::getCapacity() const
+{
+    return _capacity;
+}
+
+void TweenManager::update(float elapsedTime)
+{
+    for (unsigned int i = 0; i < _count; )
+    {
+        const float time = (_elapsed[i] += elapsedTime);
+        if (time < 0.0f)
+        {
+            // Still delayed.
+            ++i;
+            continue;
+        }
+
+        const float duration = _durations[i];
+        const bool finished = time >= duration;
+        const float t = finished ? 1.0f : Curve::ease(_types[i], time / duration);
+
+        const unsigned int offset = i * MAX_COMPONENTS;
+        const float* from = &_from[offset];
+        const float* to = &_to[offset];
+        float* value = &_values[offset];
+        for (unsigned int c = 0, count = _componentCounts[i]; c < count; ++c)
+            value[c] = from[c] + (to[c] - from[c]) * t;
+
+        const int rotationOffset = _rotationOffsets[i];
+        if (rotationOffset >= 0)
+        {
+            // Easings that overshoot stop at the ends of the rotation.
+            const float* q1 = from + rotationOffset;
+            const float* q2 = to + rotationOffset;
+            float* q = value + rotationOffset;
+            Quaternion::slerp(q1[0], q1[1], q1[2], q1[3], q2[0], q2[1], q2[2], q2[3], std::min(std::max(t, 0.0f), 1.0f), q, q + 1, q + 2, q + 3);
+        }
+
+        AnimationTarget* target = _targets[i];
+        if (_setters[i])
+            _setters[i](target, value, 1.0f);
+        else
+            target->setAnimationPropertyValue(_propertyIds[i], _animationValues[i]);
+
+        if (finished)
+        {
+            if (_listeners[i])
+            {
+                Finished event = { _ids[i], target, _propertyIds[i], _listeners[i] };
+                _finished.push_back(event);
+            }
+            remove(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Notify the listeners once the pass is done, so they can start tweens.
+    for (size_t i = 0, count = _finished.size(); i < count; ++i)
+    {
+        const Finished& event = _finished[i];
+        event.listener->tweenFinished(event.id, event.target, event.propertyId);
+    }
+    _finished.clear();
+}
+
+void TweenManager::remove(unsigned int index)
+{
+    GP_ASSERT(index < _count);
+    GP_ASSERT(_targets[index]->_tweenCount > 0);
+
+    --_targets[index]->_tweenCount;
+    const unsigned int last = --_count;
+    if (index != last)
+    {
+        _ids[index] = _ids[last];
+        _targets[index] = _targets[last];
+        _propertyIds[index] = _propertyIds[last];
+        _setters[index] = _setters[last];
+        _componentCounts[index] = _componentCounts[last];
+        _rotationOffsets[index] = _rotationOffsets[last];
+        _types[index] = _types[last];
+        _elapsed[index] = _elapsed[last];
+        _durations[index] = _durations[last];
+        _listeners[index] = _listeners[last];
+        memcpy(&_from[index * MAX_COMPONENTS], &_from[last * MAX_COMPONENTS], MAX_COMPONENTS * sizeof(float));
+        memcpy(&_to[index * MAX_COMPONENTS], &_to[last * MAX_COMPONENTS], MAX_COMPONENTS * sizeof(float));
+
+        AnimationValue* value = _animationValues[index];
+        value->_componentCount = _animationValues[last]->_componentCount;
+        value->_componentSize = _animationValues[last]->_componentSize;
+    }
+    _targets[last] = NULL;
+    _listeners[last] = NULL;
+}
+
+int TweenManager::find(int id) const
+{
+    for (unsigned int i = 0; i < _count; ++i)
+    {
+        if (_ids[i] == id)
+            return (int)i;
+    }
+    return -1;
+}
+
+}
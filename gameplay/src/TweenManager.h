@@ -0,0 +1,234 @@
+#ifndef TWEENMANAGER_H_
+#define TWEENMANAGER_H_
+
+#include "AnimationTarget.h"
+#include "Properties.h"
+
+namespace gameplay
+{
+
+class AnimationValue;
+
+/**
+ * Defines a manager of tweens: short animations of one property of a target from its
+ * current value to another, such as a control fading in or a node sliding into place.
+ *
+ * A tween needs no Animation, Curve or AnimationClip. The manager keeps the tweens in
+ * arrays preallocated for a fixed number of tweens, one array per field, and updates all
+ * of them in a single pass after the animation controller each frame: the elapsed time of
+ * each tween is eased with the easing of its interpolation type (see Curve::ease), its
+ * value is interpolated and set on its target. Values are set through the direct property
+ * setters of the target when it has one (see AnimationTarget::getAnimationPropertySetter),
+ * as Transform and Control do for their main properties.
+ *
+ * Rotations of transforms are interpolated spherically; every other component linearly.
+ * Starting a tween on a property that is already tweened replaces the running tween, and
+ * tweens are stopped when their target is destroyed.
+ *
+ * The number of tweens is configured in the game config:
+ *
+ * @verbatim
+    tweens
+    {
+        capacity = 256      // The maximum number of running tweens (default 256).
+    }
+   @endverbatim
+ *
+ * @script{ignore}
+ */
+class TweenManager
+{
+    friend class Game;
+
+public:
+
+    /**
+     * The maximum number of components of a tweened property.
+     */
+    static const unsigned int MAX_COMPONENTS = 16;
+
+    /**
+     * Defines an interface notified when a tween finishes.
+     */
+    class Listener
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~Listener() { }
+
+        /**
+         * Called when a tween has set the final value of its property.
+         *
+         * The listener may start new tweens, including on the same property.
+         *
+         * @param id The ID of the tween.
+         * @param target The target of the tween.
+         * @param propertyId The property of the tween.
+         */
+        virtual void tweenFinished(int id, AnimationTarget* target, int propertyId) = 0;
+    };
+
+    /**
+     * Starts a tween of a property from its current value.
+     *
+     * @param target The target to animate.
+     * @param propertyId The property of the target to animate.
+     * @param to The final value of the property, one float per component.
+     * @param duration The duration of the tween, in milliseconds.
+     * @param type The interpolation type whose easing the tween follows.
+     * @param delay The time to wait before the tween starts, in milliseconds.
+     * @param listener The listener to notify when the tween finishes, or NULL.
+     *
+     * @return The ID of the tween, or -1 if the manager is full.
+     */
+    int start(AnimationTarget* target, int propertyId, const float* to, unsigned long duration,
+              Curve::InterpolationType type = Curve::LINEAR, unsigned long delay = 0, Listener* listener = NULL);
+
+    /**
+     * Starts a tween of a property between two values.
+     *
+     * @param target The target to animate.
+     * @param propertyId The property of the target to animate.
+     * @param from The initial value of the property, one float per component.
+     * @param to The final value of the property, one float per component.
+     * @param duration The duration of the tween, in milliseconds.
+     * @param type The interpolation type whose easing the tween follows.
+     * @param delay The time to wait before the tween starts, in milliseconds.
+     * @param listener The listener to notify when the tween finishes, or NULL.
+     *
+     * @return The ID of the tween, or -1 if the manager is full.
+     */
+    int start(AnimationTarget* target, int propertyId, const float* from, const float* to, unsigned long duration,
+              Curve::InterpolationType type = Curve::LINEAR, unsigned long delay = 0, Listener* listener = NULL);
+
+    /**
+     * Stops a tween, leaving its property at its current value.
+     *
+     * @param id The ID of the tween.
+     */
+    void stop(int id);
+
+    /**
+     * Stops the tweens of a target.
+     *
+     * @param target The target.
+     * @param propertyId The property whose tween to stop, or -1 to stop every tween of the target.
+     */
+    void stop(AnimationTarget* target, int propertyId = -1);
+
+    /**
+     * Stops every tween.
+     */
+    void stopAll();
+
+    /**
+     * Determines whether a tween is running.
+     *
+     * @param id The ID of the tween.
+     *
+     * @return true if the tween has not finished or been stopped.
+     */
+    bool isRunning(int id) const;
+
+    /**
+     * Gets the number of running tweens.
+     *
+     * @return The tween count.
+     */
+    unsigned int getTweenCount() const;
+
+    /**
+     * Gets the maximum number of running tweens.
+     *
+     * @return The capacity of the manager.
+     */
+    unsigned int getCapacity() const;
+
+private:
+
+    /**
+     * A finished tween whose listener is notified after the update.
+     */
+    struct Finished
+    {
+        int id;
+        AnimationTarget* target;
+        int propertyId;
+        Listener* listener;
+    };
+
+    /**
+     * Constructor.
+     */
+    TweenManager();
+
+    /**
+     * Destructor.
+     */
+    ~TweenManager();
+
+    /**
+     * Hidden copy constructor.
+     */
+    TweenManager(const TweenManager& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TweenManager& operator=(const TweenManager&);
+
+    /**
+     * Allocates the tweens.
+     *
+     * @param properties The tweens namespace of the game config, or NULL.
+     */
+    void initialize(Properties* properties);
+
+    /**
+     * Stops the tweens and frees them.
+     */
+    void finalize();
+
+    /**
+     * Advances the tweens and sets the values of their properties.
+     *
+     * @param elapsedTime The time elapsed since the last update, in milliseconds.
+     */
+    void update(float elapsedTime);
+
+    /**
+     * Removes a tween, moving the last tween into its slot.
+     */
+    void remove(unsigned int index);
+
+    /**
+     * Gets the slot of a tween, or -1.
+     */
+    int find(int id) const;
+
+    unsigned int _capacity;
+    unsigned int _count;
+    int _nextId;
+    std::vector<int> _ids;
+    std::vector<AnimationTarget*> _targets;
+    std::vector<int> _propertyIds;
+    std::vector<AnimationTarget::AnimationPropertySetter> _setters;
+    std::vector<unsigned int> _componentCounts;
+    std::vector<int> _rotationOffsets;
+    std::vector<Curve::InterpolationType> _types;
+    std::vector<float> _elapsed;
+    std::vector<float> _durations;
+    std::vector<float> _from;
+    std::vector<float> _to;
+    std::vector<float> _values;
+    std::vector<AnimationValue*> _animationValues;
+    std::vector<Listener*> _listeners;
+    std::vector<Finished> _finished;
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "Base.h"
+#include "UniformBuffer.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
+#include "RenderStats.h"
+#include "Allocator.h"
+
+// Maximum number of binding points whose bound buffers are tracked.
+#define MAX_UNIFORM_BUFFER_BINDINGS 16
+
+namespace gameplay
+{
+
+static GLuint __boundUniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS] = { 0 };
+
+UniformBuffer::UniformBuffer()
+    : _handle(0), _size(0), _dynamic(false)
+{
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    if (_handle)
+    {
+        for (unsigned int i = 0; i < MAX_UNIFORM_BUFFER_BINDINGS; ++i)
+        {
+            if (__boundUniformBuffers[i] == _handle)
+                __boundUniformBuffers[i] = 0;
+        }
+
+        StateCache::deleteBuffers(1, &_handle);
+        _handle = 0;
+        Allocator::untrack(Allocator::BUFFER, _size);
+    }
+}
+
+UniformBuffer* UniformBuffer::create(unsigned int size, bool dynamic)
+{
+#ifdef USE_UNIFORM_BUFFERS
+    if (!isSupported())
+    {
+        GP_WARN("Uniform buffers are not supported on this device.");
+        return NULL;
+    }
+
+    GLuint handle;
+    GL_ASSERT( glGenBuffers(1, &handle) );
+    StateCache::bindBuffer(GL_UNIFORM_BUFFER, handle);
+    GL_ASSERT( glBufferData(GL_UNIFORM_BUFFER, size, NULL, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW) );
+    StateCache::bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    UniformBuffer* buffer = new UniformBuffer();
+    buffer->_handle = handle;
+    buffer->_size = size;
+    buffer->_dynamic = dynamic;
+    Allocator::track(Allocator::BUFFER, size);
+    return buffer;
+#else
+    GP_WARN("Uniform buffers are not supported on this platform.");
+    return NULL;
+#endif
+}
+
+bool UniformBuffer::isSupported()
+{
+#ifdef USE_UNIFORM_BUFFERS
+    return glBindBufferBase && glGetUniformBlockIndex && glUniformBlockBinding;
+#else
+    return false;
+#endif
+}
+
+unsigned int UniformBuffer::getSize() const
+{
+    return _size;
+}
+
+void UniformBuffer::setData(const void* data, unsigned int offset, unsigned int size)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(offset + size <= _size);
+
+#ifdef USE_UNIFORM_BUFFERS
+    StateCache::bindBuffer(GL_UNIFORM_BUFFER, _handle);
+    if (offset == 0 && size == _size)
+    {
+        // Orphan the old storage so the driver does not stall on draws still using it.
+        RenderCommandList::bufferData(GL_UNIFORM_BUFFER, size, data, _dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+    }
+    else
+    {
+        RenderCommandList::bufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    }
+    RenderStats::addUpload(size);
+    StateCache::bindBuffer(GL_UNIFORM_BUFFER, 0);
+#endif
+}
+
+void UniformBuffer::bind(unsigned int bindingPoint)
+{
+#ifdef USE_UNIFORM_BUFFERS
+    if (bindingPoint >= MAX_UNIFORM_BUFFER_BINDINGS || __boundUniformBuffers[bindingPoint] != _handle)
+    {
+        RenderCommandList::bindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, _handle);
+        if (bindingPoint < MAX_UNIFORM_BUFFER_BINDINGS)
+            __boundUniformBuffers[bindingPoint] = _handle;
+    }
+#endif
+}
+
+}
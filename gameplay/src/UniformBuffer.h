@@ -0,0 +1,87 @@
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a buffer object holding the data of a shader uniform block.
+ *
+ * Uniform buffers allow bulk uniform data, such as matrix palettes or light
+ * arrays, to be uploaded once and shared by every effect that declares the
+ * matching uniform block (see Effect::setUniformBuffer). They require OpenGL 3.1
+ * or later; use isSupported() to check for availability at runtime.
+ *
+ * @script{ignore}
+ */
+class UniformBuffer : public Ref
+{
+    friend class Effect;
+
+public:
+
+    /**
+     * Creates a new uniform buffer.
+     *
+     * @param size The size of the buffer in bytes.
+     * @param dynamic true if the buffer data will be updated frequently.
+     *
+     * @return The new uniform buffer, or NULL if uniform buffers are not supported.
+     */
+    static UniformBuffer* create(unsigned int size, bool dynamic = true);
+
+    /**
+     * Determines if uniform buffers are supported on the current device.
+     *
+     * @return true if uniform buffers are supported, false otherwise.
+     */
+    static bool isSupported();
+
+    /**
+     * Gets the size of the buffer in bytes.
+     *
+     * @return The buffer size.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * Sets a range of the buffer data.
+     *
+     * @param data The data to copy into the buffer.
+     * @param offset The byte offset in the buffer to start copying to.
+     * @param size The number of bytes to copy.
+     */
+    void setData(const void* data, unsigned int offset, unsigned int size);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    UniformBuffer();
+
+    /**
+     * Destructor.
+     */
+    ~UniformBuffer();
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    UniformBuffer& operator=(const UniformBuffer&);
+
+    /**
+     * Binds the buffer to the specified uniform buffer binding point.
+     */
+    void bind(unsigned int bindingPoint);
+
+    GLuint _handle;
+    unsigned int _size;
+    bool _dynamic;
+};
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+#include "Base.h"
+#include "VertexAnimation.h"
+#include "Bundle.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Material.h"
+#include "MatrixPaletteTexture.h"
+#include "RenderStats.h"
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+
+// Width of the frame textures, in texels.
+#define VERTEX_ANIMATION_TEXTURE_WIDTH 1024
+
+namespace gameplay
+{
+
+VertexAnimation::Data::Data()
+    : frameRate(0.0f), frameCount(0), vertexCount(0)
+{
+}
+
+VertexAnimation::VertexAnimation()
+    : _frameRate(0.0f), _frameCount(0), _vertexCount(0), _mesh(NULL), _sampler(NULL)
+{
+}
+
+VertexAnimation::~VertexAnimation()
+{
+    SAFE_RELEASE(_mesh);
+    SAFE_RELEASE(_sampler);
+}
+
+VertexAnimation* VertexAnimation::create(const char* path, const char* meshId)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(meshId);
+
+    Bundle* bundle = Bundle::create(path);
+    if (bundle == NULL)
+    {
+        GP_ERROR("Failed to load bundle '%s' for the vertex animation of mesh '%s'.", path, meshId);
+        return NULL;
+    }
+    VertexAnimation* animation = bundle->loadVertexAnimation(meshId);
+    SAFE_RELEASE(bundle);
+    return animation;
+}
+
+VertexAnimation* VertexAnimation::create(const char* id, const Data& data)
+{
+    if (!MatrixPaletteTexture::isSupported())
+    {
+        GP_WARN("Vertex animations need vertex texture fetch and floating point textures; the animation of mesh '%s' is not loaded.", id);
+        return NULL;
+    }
+    if (data.frameCount == 0 || data.vertexCount == 0 ||
+        data.positions.size() != (size_t)data.frameCount * data.vertexCount * 3 ||
+        data.texCoords.size() != (size_t)data.vertexCount * 2 ||
+        (!data.normals.empty() && data.normals.size() != data.positions.size()))
+    {
+        GP_ERROR("Invalid frames in the vertex animation of mesh '%s'.", id);
+        return NULL;
+    }
+
+    // Lay the frames out two texels per vertex, wrapping onto the following lines of the texture.
+    const unsigned int texelCount = data.frameCount * data.vertexCount * 2;
+    const unsigned int width = VERTEX_ANIMATION_TEXTURE_WIDTH;
+    const unsigned int height = (texelCount + width - 1) / width;
+    GLint maxSize = 0;
+    GL_ASSERT( glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize) );
+    if (height > (unsigned int)maxSize)
+    {
+        GP_ERROR("The vertex animation of mesh '%s' needs a %ux%u texture, which is more than the device supports (%d); bake it at a lower frame rate.",
+            id, width, height, maxSize);
+        return NULL;
+    }
+
+    std::vector<float> texels(width * height * 4, 0.0f);
+    for (unsigned int i = 0, count = data.frameCount * data.vertexCount; i < count; ++i)
+    {
+        float* texel = &texels[i * 8];
+        memcpy(texel, &data.positions[i * 3], 3 * sizeof(float));
+        if (!data.normals.empty())
+            memcpy(texel + 4, &data.normals[i * 3], 3 * sizeof(float));
+        else
+            texel[6] = 1.0f;
+    }
+
+    // The frames need full precision, so the texture is created here rather than by Texture.
+    GLuint handle;
+    GL_ASSERT( glGenTextures(1, &handle) );
+    Texture::bindTexture(handle);
+#ifdef OPENGL_ES
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_FLOAT, &texels[0]) );
+#else
+    GL_ASSERT( glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, &texels[0]) );
+#endif
+    RenderStats::addUpload(texels.size() * sizeof(float));
+    Texture* texture = Texture::create(handle, width, height, Texture::RGBA);
+    texture->setMemorySize(texels.size() * sizeof(float));
+    Texture::Sampler* sampler = Texture::Sampler::create(texture);
+    sampler->setFilterMode(Texture::NEAREST, Texture::NEAREST);
+    sampler->setWrapMode(Texture::CLAMP, Texture::CLAMP);
+    SAFE_RELEASE(texture);
+
+    // The vertices of the mesh only hold what the texture does not: their texture coordinates and index.
+    VertexFormat::Element elements[] =
+    {
+        VertexFormat::Element(VertexFormat::TEXCOORD0, 2),
+        VertexFormat::Element(VertexFormat::TEXCOORD1, 1)
+    };
+    Mesh* mesh = Mesh::createMesh(VertexFormat(elements, 2), data.vertexCount, false);
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to create the mesh of the vertex animation of mesh '%s'.", id);
+        SAFE_RELEASE(sampler);
+        return NULL;
+    }
+    std::vector<float> vertices(data.vertexCount * 3);
+    for (unsigned int i = 0; i < data.vertexCount; ++i)
+    {
+        vertices[i * 3] = data.texCoords[i * 2];
+        vertices[i * 3 + 1] = data.texCoords[i * 2 + 1];
+        vertices[i * 3 + 2] = (float)i;
+    }
+    mesh->setVertexData(&vertices[0], 0, data.vertexCount);
+
+    const bool shortIndices = data.vertexCount <= 65536;
+    for (size_t i = 0, count = data.indices.size(); i < count; ++i)
+    {
+        const std::vector<unsigned int>& indices = data.indices[i];
+        if (indices.empty())
+            continue;
+        MeshPart* part = mesh->addPart((Mesh::PrimitiveType)data.primitiveTypes[i], shortIndices ? Mesh::INDEX16 : Mesh::INDEX32, (unsigned int)indices.size());
+        if (shortIndices)
+        {
+            std::vector<unsigned short> shorts(indices.begin(), indices.end());
+            part->setIndexData(&shorts[0], 0, (unsigned int)shorts.size());
+        }
+        else
+        {
+            part->setIndexData(&indices[0], 0, (unsigned int)indices.size());
+        }
+    }
+    mesh->setBoundingBox(data.boundingBox);
+    BoundingSphere sphere;
+    sphere.set(data.boundingBox);
+    mesh->setBoundingSphere(sphere);
+
+    VertexAnimation* animation = new VertexAnimation();
+    animation->_frameRate = data.frameRate;
+    animation->_frameCount = data.frameCount;
+    animation->_vertexCount = data.vertexCount;
+    animation->_boundingBox = data.boundingBox;
+    animation->_mesh = mesh;
+    animation->_sampler = sampler;
+    return animation;
+}
+
+float VertexAnimation::getFrameRate() const
+{
+    return _frameRate;
+}
+
+unsigned int VertexAnimation::getFrameCount() const
+{
+    return _frameCount;
+}
+
+unsigned int VertexAnimation::getVertexCount() const
+{
+    return _vertexCount;
+}
+
+float VertexAnimation::getDuration() const
+{
+    return _frameRate > 0.0f ? _frameCount * 1000.0f / _frameRate : 0.0f;
+}
+
+const BoundingBox& VertexAnimation::getBoundingBox() const
+{
+    return _boundingBox;
+}
+
+Mesh* VertexAnimation::getMesh() const
+{
+    return _mesh;
+}
+
+Texture::Sampler* VertexAnimation::getSampler() const
+{
+    return _sampler;
+}
+
+void VertexAnimation::bind(Material* material) const
+{
+    GP_ASSERT(material);
+    GP_ASSERT(_sampler);
+
+    Texture* texture = _sampler->getTexture();
+    material->getParameter("u_vertexAnimation")->setValue(_sampler);
+    material->getParameter("u_vertexAnimationSize")->setValue(Vector2((float)texture->getWidth(), (float)texture->getHeight()));
+    material->getParameter("u_vertexAnimationVertexCount")->setValue((float)_vertexCount);
+    material->getParameter("u_vertexAnimationFrameRate")->setValue(_frameRate);
+}
+
+}
@@ -0,0 +1,164 @@
+#ifndef VERTEXANIMATION_H_
+#define VERTEXANIMATION_H_
+
+#include "Ref.h"
+#include "Texture.h"
+#include "BoundingBox.h"
+
+namespace gameplay
+{
+
+class Mesh;
+class Material;
+
+/**
+ * Defines the animations of a skinned mesh, baked into a texture of vertex positions and normals.
+ *
+ * The encoder bakes the animations of skinned meshes when run with the -vat option: the joints
+ * are evaluated at a fixed frame rate and every vertex is skinned for every frame. A vertex
+ * animation draws the mesh from these frames with no joints, matrix palettes or animation
+ * clips at runtime, so thousands of animated characters can be drawn with a single instanced
+ * draw call (see CrowdRenderer).
+ *
+ * The frames are stored in a floating point texture 1024 texels wide, two texels per vertex
+ * and frame: the position then the normal of each vertex, frame after frame. The mesh of the
+ * animation has no positions; its vertices hold their texture coordinates (TEXCOORD0) and
+ * their index (TEXCOORD1), which the crowd shader uses to read the vertex from the texture.
+ *
+ * Vertex animations need vertex texture fetch and floating point textures, like the matrix
+ * palette texture (see MatrixPaletteTexture::isSupported).
+ *
+ * @script{ignore}
+ */
+class VertexAnimation : public Ref
+{
+    friend class Bundle;
+
+public:
+
+    /**
+     * Loads the vertex animation baked for a mesh of a bundle.
+     *
+     * @param path The path of the bundle.
+     * @param meshId The ID of the skinned mesh the animation was baked from.
+     *
+     * @return The vertex animation, or NULL if it could not be loaded or is not supported.
+     */
+    static VertexAnimation* create(const char* path, const char* meshId);
+
+    /**
+     * Gets the number of frames baked per second.
+     *
+     * @return The frame rate.
+     */
+    float getFrameRate() const;
+
+    /**
+     * Gets the number of frames.
+     *
+     * @return The frame count.
+     */
+    unsigned int getFrameCount() const;
+
+    /**
+     * Gets the number of vertices of each frame.
+     *
+     * @return The vertex count.
+     */
+    unsigned int getVertexCount() const;
+
+    /**
+     * Gets the duration of all the frames.
+     *
+     * @return The duration, in milliseconds.
+     */
+    float getDuration() const;
+
+    /**
+     * Gets the box bounding the vertices of every frame.
+     *
+     * @return The bounding box, in the space of the mesh.
+     */
+    const BoundingBox& getBoundingBox() const;
+
+    /**
+     * Gets the mesh drawn with the frames.
+     *
+     * @return The mesh.
+     */
+    Mesh* getMesh() const;
+
+    /**
+     * Gets the sampler of the texture holding the frames.
+     *
+     * @return The sampler.
+     */
+    Texture::Sampler* getSampler() const;
+
+    /**
+     * Sets the parameters a material needs to read the frames.
+     *
+     * This sets the "u_vertexAnimation" sampler, the "u_vertexAnimationSize" width and height
+     * of the texture, the "u_vertexAnimationVertexCount" and the "u_vertexAnimationFrameRate"
+     * parameters of the material.
+     *
+     * @param material The material.
+     */
+    void bind(Material* material) const;
+
+private:
+
+    /**
+     * The contents of a vertex animation, as read from a bundle.
+     */
+    struct Data
+    {
+        Data();
+
+        float frameRate;
+        unsigned int frameCount;
+        unsigned int vertexCount;
+        BoundingBox boundingBox;
+        std::vector<float> texCoords;
+        std::vector<unsigned int> primitiveTypes;
+        std::vector<std::vector<unsigned int> > indices;
+        std::vector<float> positions;
+        std::vector<float> normals;
+    };
+
+    /**
+     * Constructor.
+     */
+    VertexAnimation();
+
+    /**
+     * Destructor.
+     */
+    ~VertexAnimation();
+
+    /**
+     * Hidden copy constructor.
+     */
+    VertexAnimation(const VertexAnimation& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    VertexAnimation& operator=(const VertexAnimation&);
+
+    /**
+     * Creates the texture and the mesh of a vertex animation read by a bundle.
+     */
+    static VertexAnimation* create(const char* id, const Data& data);
+
+    float _frameRate;
+    unsigned int _frameCount;
+    unsigned int _vertexCount;
+    BoundingBox _boundingBox;
+    Mesh* _mesh;
+    Texture::Sampler* _sampler;
+};
+
+}
+
+#endif
@@ -1,26 +1,185 @@
 #include "Base.h"
 #include "VertexAttributeBinding.h"
+#include "StateCache.h"
+#include "RenderCommandList.h"
 #include "Mesh.h"
 #include "Effect.h"
+#include "InstanceBuffer.h"
+
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV 0x8D9F
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#endif
 
 namespace gameplay
 {
 
 static GLuint __maxVertexAttribs = 0;
-static std::vector<VertexAttributeBinding*> __vertexAttributeBindingCache;
+
+// The bindings of meshes, by mesh and attribute layout, shared by the effects with that layout.
+typedef std::pair<Mesh*, std::vector<gameplay::VertexAttribute> > BindingKey;
+static std::map<BindingKey, VertexAttributeBinding*> __vertexAttributeBindingCache;
+
+// Support for the vertex types that are not part of OpenGL ES 2.0, detected on first use.
+static int __halfFloatSupport = -1;
+static int __packedSupport = -1;
+static bool __halfFloatOES = false;
+
+static void detectVertexTypeSupport()
+{
+    if (__halfFloatSupport != -1)
+        return;
+
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    if (extensions == NULL)
+        extensions = "";
+    const char* version = (const char*)glGetString(GL_VERSION);
+    bool modern;
+    if (version && strstr(version, "OpenGL ES"))
+    {
+        modern = strstr(version, "OpenGL ES 3") != NULL;
+    }
+    else
+    {
+        int major = 0, minor = 0;
+        if (version)
+            sscanf(version, "%d.%d", &major, &minor);
+        modern = major > 3 || (major == 3 && minor >= 3);
+    }
+
+    __halfFloatOES = !modern && strstr(extensions, "GL_OES_vertex_half_float") != NULL;
+    __halfFloatSupport = (modern || __halfFloatOES || strstr(extensions, "GL_ARB_half_float_vertex")) ? 1 : 0;
+    __packedSupport = (modern || strstr(extensions, "GL_ARB_vertex_type_2_10_10_10_rev")) ? 1 : 0;
+}
+
+static GLenum toGLType(VertexFormat::Type type)
+{
+    switch (type)
+    {
+    case VertexFormat::HALF_FLOAT:
+        detectVertexTypeSupport();
+        return __halfFloatOES ? GL_HALF_FLOAT_OES : GL_HALF_FLOAT;
+    case VertexFormat::BYTE:
+        return GL_BYTE;
+    case VertexFormat::UNSIGNED_BYTE:
+        return GL_UNSIGNED_BYTE;
+    case VertexFormat::SHORT:
+        return GL_SHORT;
+    case VertexFormat::UNSIGNED_SHORT:
+        return GL_UNSIGNED_SHORT;
+    case VertexFormat::INT_2_10_10_10_REV:
+        return GL_INT_2_10_10_10_REV;
+    case VertexFormat::UNSIGNED_INT_2_10_10_10_REV:
+        return GL_UNSIGNED_INT_2_10_10_10_REV;
+    default:
+        return GL_FLOAT;
+    }
+}
+
+/**
+ * Gets the location of the attribute of an effect that a vertex element of the given usage feeds, or -1.
+ */
+static gameplay::VertexAttribute getAttributeLocation(Effect* effect, VertexFormat::Usage usage)
+{
+    gameplay::VertexAttribute attrib;
+    std::string name;
+
+    // Constructor vertex attribute name expected in shader.
+    switch (usage)
+    {
+    case VertexFormat::POSITION:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
+        break;
+    case VertexFormat::NORMAL:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
+        break;
+    case VertexFormat::COLOR:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
+        break;
+    case VertexFormat::TANGENT:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
+        break;
+    case VertexFormat::BINORMAL:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
+        break;
+    case VertexFormat::BLENDWEIGHTS:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
+        break;
+    case VertexFormat::BLENDINDICES:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
+        break;
+    case VertexFormat::TEXCOORD0:
+        if ((attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
+            break;
+
+        /*// Try adding a "0" after the texcoord attrib name (flexible name for this case).
+        if (attrib == -1)
+        {
+            name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
+            name += '0';
+            attrib = effect->getVertexAttribute(name.c_str());
+        }
+        break;*/
+    case VertexFormat::TEXCOORD1:
+    case VertexFormat::TEXCOORD2:
+    case VertexFormat::TEXCOORD3:
+    case VertexFormat::TEXCOORD4:
+    case VertexFormat::TEXCOORD5:
+    case VertexFormat::TEXCOORD6:
+    case VertexFormat::TEXCOORD7:
+        name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
+        name += '0' + (usage - VertexFormat::TEXCOORD0);
+        attrib = effect->getVertexAttribute(name.c_str());
+        break;
+    default:
+        // This happens whenever vertex data contains extra information (not an error).
+        attrib = -1;
+        break;
+    }
+
+    return attrib;
+}
+
+/**
+ * Gets the attribute locations that the elements of a vertex format feed in an effect.
+ *
+ * Bindings with the same layout set up the same attribute pointers, so effects whose
+ * attributes are at the same locations share the binding of a mesh.
+ */
+static void getAttributeLayout(const VertexFormat& vertexFormat, Effect* effect, std::vector<gameplay::VertexAttribute>& layout)
+{
+    layout.resize(vertexFormat.getElementCount());
+    for (unsigned int i = 0, count = vertexFormat.getElementCount(); i < count; ++i)
+    {
+        layout[i] = getAttributeLocation(effect, vertexFormat.getElement(i).usage);
+    }
+}
 
 VertexAttributeBinding::VertexAttributeBinding() :
-    _handle(0), _attributes(NULL), _mesh(NULL), _effect(NULL)
+    _handle(0), _attributes(NULL), _mesh(NULL), _effect(NULL), _instances(NULL), _vertexBuffer(0), _vertexOffset(0)
 {
 }
 
 VertexAttributeBinding::~VertexAttributeBinding()
 {
     // Delete from the vertex attribute binding cache.
-    std::vector<VertexAttributeBinding*>::iterator itr = std::find(__vertexAttributeBindingCache.begin(), __vertexAttributeBindingCache.end(), this);
-    if (itr != __vertexAttributeBindingCache.end())
+    if (_mesh && _effect && !_instances)
     {
-        __vertexAttributeBindingCache.erase(itr);
+        BindingKey key(_mesh, std::vector<gameplay::VertexAttribute>());
+        getAttributeLayout(_mesh->getVertexFormat(), _effect, key.second);
+        std::map<BindingKey, VertexAttributeBinding*>::iterator itr = __vertexAttributeBindingCache.find(key);
+        if (itr != __vertexAttributeBindingCache.end() && itr->second == this)
+        {
+            __vertexAttributeBindingCache.erase(itr);
+        }
     }
 
     SAFE_RELEASE(_mesh);
@@ -29,7 +188,7 @@ VertexAttributeBinding::~VertexAttributeBinding()
 
     if (_handle)
     {
-        GL_ASSERT( glDeleteVertexArrays(1, &_handle) );
+        StateCache::deleteVertexArray(_handle);
         _handle = 0;
     }
 }
@@ -37,27 +196,26 @@ VertexAttributeBinding::~VertexAttributeBinding()
 VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, Effect* effect)
 {
     GP_ASSERT(mesh);
+    GP_ASSERT(effect);
 
-    // Search for an existing vertex attribute binding that can be used.
-    VertexAttributeBinding* b;
-    for (size_t i = 0, count = __vertexAttributeBindingCache.size(); i < count; ++i)
+    // Search for an existing binding of the mesh with the same attribute locations, which may belong to another effect.
+    BindingKey key(mesh, std::vector<gameplay::VertexAttribute>());
+    getAttributeLayout(mesh->getVertexFormat(), effect, key.second);
+    std::map<BindingKey, VertexAttributeBinding*>::iterator itr = __vertexAttributeBindingCache.find(key);
+    if (itr != __vertexAttributeBindingCache.end())
     {
-        b = __vertexAttributeBindingCache[i];
+        VertexAttributeBinding* b = itr->second;
         GP_ASSERT(b);
-        if (b->_mesh == mesh && b->_effect == effect)
-        {
-            // Found a match!
-            b->addRef();
-            return b;
-        }
+        b->addRef();
+        return b;
     }
 
-    b = create(mesh, mesh->getVertexFormat(), 0, effect);
+    VertexAttributeBinding* b = create(mesh, mesh->getVertexFormat(), 0, effect);
 
     // Add the new vertex attribute binding to the cache.
     if (b)
     {
-        __vertexAttributeBindingCache.push_back(b);
+        __vertexAttributeBindingCache[key] = b;
     }
 
     return b;
@@ -68,7 +226,16 @@ VertexAttributeBinding* VertexAttributeBinding::create(const VertexFormat& verte
     return create(NULL, vertexFormat, vertexPointer, effect);
 }
 
-VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect)
+VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, InstanceBuffer* instances, Effect* effect)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(instances);
+    GP_ASSERT(instances->getVertexBuffer());
+
+    return create(mesh, mesh->getVertexFormat(), 0, effect, instances);
+}
+
+VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect, InstanceBuffer* instances)
 {
     GP_ASSERT(effect);
 
@@ -90,10 +257,11 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
     VertexAttributeBinding* b = new VertexAttributeBinding();
 
 #ifdef USE_VAO
-    if (mesh && glGenVertexArrays)
+    // Vertex arrays belong to the context that creates them, so none are made while a render thread replays the frames.
+    if (mesh && glGenVertexArrays && !RenderCommandList::isRecording())
     {
-        GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
-        GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0) );
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+        StateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         // Use hardware VAOs.
         GL_ASSERT( glGenVertexArrays(1, &b->_handle) );
@@ -106,10 +274,10 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
         }
 
         // Bind the new VAO.
-        GL_ASSERT( glBindVertexArray(b->_handle) );
+        StateCache::bindVertexArray(b->_handle);
 
         // Bind the Mesh VBO so our glVertexAttribPointer calls use it.
-        GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, mesh->getVertexBuffer()) );
+        StateCache::bindBuffer(GL_ARRAY_BUFFER, mesh->getVertexBuffer());
     }
     else
 #endif
@@ -125,6 +293,7 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
             attribs[i].type = GL_FLOAT;
             attribs[i].normalized = GL_FALSE;
             attribs[i].pointer = 0;
+            attribs[i].divisor = 0;
         }
         b->_attributes = attribs;
     }
@@ -139,65 +308,11 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
     effect->addRef();
 
     // Call setVertexAttribPointer for each vertex element.
-    std::string name;
     unsigned int offset = 0;
     for (unsigned int i = 0, count = vertexFormat.getElementCount(); i < count; ++i)
     {
         const VertexFormat::Element& e = vertexFormat.getElement(i);
-        gameplay::VertexAttribute attrib;
-
-        // Constructor vertex attribute name expected in shader.
-        switch (e.usage)
-        {
-        case VertexFormat::POSITION:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
-            break;
-        case VertexFormat::NORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
-            break;
-        case VertexFormat::COLOR:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
-            break;
-        case VertexFormat::TANGENT:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
-            break;
-        case VertexFormat::BINORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
-            break;
-        case VertexFormat::BLENDWEIGHTS:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
-            break;
-        case VertexFormat::BLENDINDICES:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
-            break;
-        case VertexFormat::TEXCOORD0:
-            if ((attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
-                break;
-
-            /*// Try adding a "0" after the texcoord attrib name (flexible name for this case).
-            if (attrib == -1)
-            {
-                name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
-                name += '0';
-                attrib = effect->getVertexAttribute(name.c_str());
-            }
-            break;*/
-        case VertexFormat::TEXCOORD1:
-        case VertexFormat::TEXCOORD2:
-        case VertexFormat::TEXCOORD3:
-        case VertexFormat::TEXCOORD4:
-        case VertexFormat::TEXCOORD5:
-        case VertexFormat::TEXCOORD6:
-        case VertexFormat::TEXCOORD7:
-            name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
-            name += '0' + (e.usage - VertexFormat::TEXCOORD0);
-            attrib = effect->getVertexAttribute(name.c_str());
-            break;
-        default:
-            // This happens whenever vertex data contains extra information (not an error).
-            attrib = -1;
-            break;
-        }
+        gameplay::VertexAttribute attrib = getAttributeLocation(effect, e.usage);
 
         if (attrib == -1)
         {
@@ -206,29 +321,99 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
         else
         {
             void* pointer = vertexPointer ? (void*)(((unsigned char*)vertexPointer) + offset) : (void*)offset;
-            b->setVertexAttribPointer(attrib, (GLint)e.size, GL_FLOAT, GL_FALSE, (GLsizei)vertexFormat.getVertexSize(), pointer);
+            b->setVertexAttribPointer(attrib, (GLint)e.size, toGLType(e.type), e.normalized ? GL_TRUE : GL_FALSE, (GLsizei)vertexFormat.getVertexSize(), pointer);
         }
 
-        offset += e.size * sizeof(float);
+        offset += e.getByteSize();
+    }
+
+    // Per-instance attributes are sourced from the instance buffer and advance once per instance.
+    if (instances)
+    {
+        b->_instances = instances;
+        if (b->_handle)
+        {
+            StateCache::bindBuffer(GL_ARRAY_BUFFER, instances->getVertexBuffer());
+        }
+
+        const VertexFormat& instanceFormat = instances->getInstanceFormat();
+        const GLsizei stride = (GLsizei)instanceFormat.getVertexSize();
+        offset = 0;
+        for (unsigned int i = 0, count = instanceFormat.getElementCount(); i < count; ++i)
+        {
+            const VertexFormat::Element& e = instanceFormat.getElement(i);
+            if (e.usage == VertexFormat::INSTANCE_MATRIX)
+            {
+                // A mat4 attribute occupies four consecutive locations, one per column.
+                gameplay::VertexAttribute attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME);
+                if (attrib != -1)
+                {
+                    for (unsigned int column = 0; column < 4; ++column)
+                    {
+                        b->setVertexAttribPointer(attrib + column, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + column * 4 * sizeof(float)), 1);
+                    }
+                }
+            }
+            else
+            {
+                gameplay::VertexAttribute attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_INSTANCE_DATA_NAME);
+                if (attrib != -1)
+                {
+                    b->setVertexAttribPointer(attrib, (GLint)e.size, toGLType(e.type), e.normalized ? GL_TRUE : GL_FALSE, stride, (void*)offset, 1);
+                }
+            }
+
+            offset += e.getByteSize();
+        }
     }
 
     if (b->_handle)
     {
-        GL_ASSERT( glBindVertexArray(0) );
+        StateCache::bindVertexArray(0);
     }
 
     return b;
 }
 
-void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer)
+bool VertexAttributeBinding::isTypeSupported(VertexFormat::Type type)
+{
+    switch (type)
+    {
+    case VertexFormat::HALF_FLOAT:
+        detectVertexTypeSupport();
+        return __halfFloatSupport == 1;
+    case VertexFormat::INT_2_10_10_10_REV:
+    case VertexFormat::UNSIGNED_INT_2_10_10_10_REV:
+        detectVertexTypeSupport();
+        return __packedSupport == 1;
+    default:
+        return true;
+    }
+}
+
+void VertexAttributeBinding::setVertexBuffer(VertexBufferHandle buffer, unsigned int offset)
+{
+    GP_ASSERT(_mesh == NULL);
+
+    _vertexBuffer = buffer;
+    _vertexOffset = offset;
+}
+
+void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer, GLuint divisor)
 {
     GP_ASSERT(indx < (GLuint)__maxVertexAttribs);
 
     if (_handle)
     {
         // Hardware mode.
-        GL_ASSERT( glVertexAttribPointer(indx, size, type, normalize, stride, pointer) );
-        GL_ASSERT( glEnableVertexAttribArray(indx) );
+        RenderCommandList::vertexAttribPointer(indx, size, type, normalize, stride, pointer);
+        RenderCommandList::setVertexAttribArrayEnabled(indx, true);
+#ifdef USE_INSTANCED_ARRAYS
+        if (divisor)
+        {
+            RenderCommandList::vertexAttribDivisor(indx, divisor);
+        }
+#endif
     }
     else
     {
@@ -240,6 +425,7 @@ void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLe
         _attributes[indx].normalized = normalize;
         _attributes[indx].stride = stride;
         _attributes[indx].pointer = pointer;
+        _attributes[indx].divisor = divisor;
     }
 }
 
@@ -248,30 +434,47 @@ void VertexAttributeBinding::bind()
     if (_handle)
     {
         // Hardware mode
-        GL_ASSERT( glBindVertexArray(_handle) );
+        StateCache::bindVertexArray(_handle);
     }
     else
     {
         // Software mode
         if (_mesh)
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer()) );
+            StateCache::bindBuffer(GL_ARRAY_BUFFER, _mesh->getVertexBuffer());
         }
         else
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
+            StateCache::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer);
         }
 
         GP_ASSERT(_attributes);
         for (unsigned int i = 0; i < __maxVertexAttribs; ++i)
         {
             VertexAttribute& a = _attributes[i];
-            if (a.enabled)
+            if (a.enabled && a.divisor == 0)
             {
-                GL_ASSERT( glVertexAttribPointer(i, a.size, a.type, a.normalized, a.stride, a.pointer) );
-                GL_ASSERT( glEnableVertexAttribArray(i) );
+                RenderCommandList::vertexAttribPointer(i, a.size, a.type, a.normalized, a.stride, (unsigned char*)a.pointer + _vertexOffset);
+                RenderCommandList::setVertexAttribArrayEnabled(i, true);
             }
         }
+
+#ifdef USE_INSTANCED_ARRAYS
+        if (_instances)
+        {
+            StateCache::bindBuffer(GL_ARRAY_BUFFER, _instances->getVertexBuffer());
+            for (unsigned int i = 0; i < __maxVertexAttribs; ++i)
+            {
+                VertexAttribute& a = _attributes[i];
+                if (a.enabled && a.divisor)
+                {
+                    RenderCommandList::vertexAttribPointer(i, a.size, a.type, a.normalized, a.stride, a.pointer);
+                    RenderCommandList::vertexAttribDivisor(i, a.divisor);
+                    RenderCommandList::setVertexAttribArrayEnabled(i, true);
+                }
+            }
+        }
+#endif
     }
 }
 
@@ -280,14 +483,14 @@ void VertexAttributeBinding::unbind()
     if (_handle)
     {
         // Hardware mode
-        GL_ASSERT( glBindVertexArray(0) );
+        StateCache::bindVertexArray(0);
     }
     else
     {
         // Software mode
-        if (_mesh)
+        if (_mesh || _vertexBuffer)
         {
-            GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
+            StateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
         }
 
         GP_ASSERT(_attributes);
@@ -295,7 +498,14 @@ void VertexAttributeBinding::unbind()
         {
             if (_attributes[i].enabled)
             {
-                GL_ASSERT( glDisableVertexAttribArray(i) );
+                RenderCommandList::setVertexAttribArrayEnabled(i, false);
+#ifdef USE_INSTANCED_ARRAYS
+                // Divisors are global state without VAOs, so restore the default.
+                if (_attributes[i].divisor)
+                {
+                    RenderCommandList::vertexAttribDivisor(i, 0);
+                }
+#endif
             }
         }
     }
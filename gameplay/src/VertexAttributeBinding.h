@@ -9,6 +9,7 @@ namespace gameplay
 
 class Mesh;
 class Effect;
+class InstanceBuffer;
 
 /**
  * Represents a binding between the vertex layout of a Mesh and the vertex
@@ -31,13 +32,18 @@ class Effect;
  */
 class VertexAttributeBinding : public Ref
 {
+    friend class InstanceBuffer;
+    friend class Model;
+
 public:
 
     /**
      * Creates a new VertexAttributeBinding between the given Mesh and Effect.
      *
-     * If a VertexAttributeBinding matching the specified Mesh and Effect already
-     * exists, it will be returned. Otherwise, a new VertexAttributeBinding will
+     * If a VertexAttributeBinding of the specified Mesh already exists for an Effect
+     * whose attributes are at the same locations, it will be returned: effects bind
+     * the standard attributes to fixed locations, so most effects drawing a mesh
+     * share one binding. Otherwise, a new VertexAttributeBinding will
      * be returned. If OpenGL VAOs are enabled, the a new VAO will be created and
      * stored in the returned VertexAttributeBinding, otherwise a client-side
      * array of vertex attribute bindings will be stored.
@@ -68,6 +74,32 @@ public:
      */
     static VertexAttributeBinding* create(const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect);
 
+    /**
+     * Determines whether the current device can read vertex elements of the given type.
+     *
+     * Float, byte and short types are always supported. Half floats and the packed
+     * 2_10_10_10 types require OpenGL ES 3.0, OpenGL 3.3 or an extension.
+     *
+     * @param type The vertex element type.
+     *
+     * @return true if the type is supported, false otherwise.
+     * @script{ignore}
+     */
+    static bool isTypeSupported(VertexFormat::Type type);
+
+    /**
+     * Sources the vertices of a client-side binding from a vertex buffer.
+     *
+     * This applies to bindings created from a vertex format with a NULL vertex pointer,
+     * whose attributes are then offsets into the given buffer. The offset is added to
+     * them, so the same binding can draw vertices streamed to different places in a buffer.
+     *
+     * @param buffer The vertex buffer, or 0 to use client-side vertex arrays again.
+     * @param offset The offset of the first vertex in the buffer, in bytes.
+     * @script{ignore}
+     */
+    void setVertexBuffer(VertexBufferHandle buffer, unsigned int offset);
+
     /**
      * Binds this vertex array object.
      */
@@ -89,6 +121,7 @@ private:
         bool normalized;
         unsigned int stride;
         void* pointer;
+        unsigned int divisor;
     };
 
     /**
@@ -106,14 +139,25 @@ private:
      */
     VertexAttributeBinding& operator=(const VertexAttributeBinding&);
 
-    static VertexAttributeBinding* create(Mesh* mesh, const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect);
+    static VertexAttributeBinding* create(Mesh* mesh, const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect, InstanceBuffer* instances = NULL);
+
+    /**
+     * Creates a binding that sources the vertex attributes from the mesh and the
+     * per-instance attributes from the specified instance buffer.
+     *
+     * The binding is not cached; it is owned by the instance buffer.
+     */
+    static VertexAttributeBinding* create(Mesh* mesh, InstanceBuffer* instances, Effect* effect);
 
-    void setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer);
+    void setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer, GLuint divisor = 0);
 
     GLuint _handle;
     VertexAttribute* _attributes;
     Mesh* _mesh;
     Effect* _effect;
+    InstanceBuffer* _instances;
+    VertexBufferHandle _vertexBuffer;
+    unsigned int _vertexOffset;
 };
 
 }
@@ -17,7 +17,7 @@ VertexFormat::VertexFormat(const Element* elements, unsigned int elementCount)
         memcpy(&element, &elements[i], sizeof(Element));
         _elements.push_back(element);
 
-        _vertexSize += element.size * sizeof(float);
+        _vertexSize += element.getByteSize();
     }
 }
 
@@ -62,18 +62,37 @@ bool VertexFormat::operator != (const VertexFormat& f) const
 }
 
 VertexFormat::Element::Element() :
-    usage(POSITION), size(0)
+    usage(POSITION), size(0), type(FLOAT), normalized(false)
 {
 }
 
-VertexFormat::Element::Element(Usage usage, unsigned int size) :
-    usage(usage), size(size)
+VertexFormat::Element::Element(Usage usage, unsigned int size, Type type, bool normalized) :
+    usage(usage), size(size), type(type), normalized(normalized)
 {
 }
 
+unsigned int VertexFormat::Element::getByteSize() const
+{
+    switch (type)
+    {
+    case HALF_FLOAT:
+    case SHORT:
+    case UNSIGNED_SHORT:
+        return size * 2;
+    case BYTE:
+    case UNSIGNED_BYTE:
+        return size;
+    case INT_2_10_10_10_REV:
+    case UNSIGNED_INT_2_10_10_10_REV:
+        return 4;
+    default:
+        return size * sizeof(float);
+    }
+}
+
 bool VertexFormat::Element::operator == (const VertexFormat::Element& e) const
 {
-    return (size == e.size && usage == e.usage);
+    return (size == e.size && usage == e.usage && type == e.type && normalized == e.normalized);
 }
 
 bool VertexFormat::Element::operator != (const VertexFormat::Element& e) const
@@ -115,9 +134,124 @@ const char* VertexFormat::toString(Usage usage)
         return "TEXCOORD6";
     case TEXCOORD7:
         return "TEXCOORD7";
+    case INSTANCE_MATRIX:
+        return "INSTANCE_MATRIX";
+    case INSTANCE_DATA:
+        return "INSTANCE_DATA";
     default:
         return "UNKNOWN";
     }
 }
 
+static float halfToFloat(unsigned short h)
+{
+    unsigned int sign = (h & 0x8000) << 16;
+    unsigned int exponent = (h >> 10) & 0x1f;
+    unsigned int mantissa = h & 0x3ff;
+    unsigned int bits;
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Renormalize the denormal.
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+void VertexFormat::decode(const Element& element, const void* data, float* values)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(values);
+
+    switch (element.type)
+    {
+    case FLOAT:
+        memcpy(values, data, element.size * sizeof(float));
+        break;
+    case HALF_FLOAT:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            unsigned short h;
+            memcpy(&h, (const unsigned char*)data + i * 2, 2);
+            values[i] = halfToFloat(h);
+        }
+        break;
+    case BYTE:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            float v = ((const signed char*)data)[i];
+            values[i] = element.normalized ? std::max(v / 127.0f, -1.0f) : v;
+        }
+        break;
+    case UNSIGNED_BYTE:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            float v = ((const unsigned char*)data)[i];
+            values[i] = element.normalized ? v / 255.0f : v;
+        }
+        break;
+    case SHORT:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            short s;
+            memcpy(&s, (const unsigned char*)data + i * 2, 2);
+            values[i] = element.normalized ? std::max(s / 32767.0f, -1.0f) : (float)s;
+        }
+        break;
+    case UNSIGNED_SHORT:
+        for (unsigned int i = 0; i < element.size; ++i)
+        {
+            unsigned short s;
+            memcpy(&s, (const unsigned char*)data + i * 2, 2);
+            values[i] = element.normalized ? s / 65535.0f : (float)s;
+        }
+        break;
+    case INT_2_10_10_10_REV:
+    case UNSIGNED_INT_2_10_10_10_REV:
+        {
+            unsigned int packed;
+            memcpy(&packed, data, 4);
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                unsigned int bits = i < 3 ? 10 : 2;
+                unsigned int v = (packed >> (i * 10)) & ((1u << bits) - 1);
+                if (element.type == INT_2_10_10_10_REV)
+                {
+                    // Sign extend, then map [-max, max] to [-1, 1].
+                    int s = (v & (1u << (bits - 1))) ? (int)v - (1 << bits) : (int)v;
+                    float range = (float)((1 << (bits - 1)) - 1);
+                    values[i] = element.normalized ? std::max(s / range, -1.0f) : (float)s;
+                }
+                else
+                {
+                    values[i] = element.normalized ? v / (float)((1u << bits) - 1) : (float)v;
+                }
+            }
+        }
+        break;
+    }
+}
+
 }
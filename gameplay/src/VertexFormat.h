@@ -16,6 +16,9 @@ public:
 
     /**
      * Defines a set of usages for vertex elements.
+     *
+     * The INSTANCE_MATRIX (16 floats) and INSTANCE_DATA usages are only valid
+     * in the instance format of an InstanceBuffer.
      */
     enum Usage
     {
@@ -33,16 +36,38 @@ public:
         TEXCOORD4 = 12,
         TEXCOORD5 = 13,
         TEXCOORD6 = 14,
-        TEXCOORD7 = 15
+        TEXCOORD7 = 15,
+        INSTANCE_MATRIX = 16,
+        INSTANCE_DATA = 17
+    };
+
+    /**
+     * Defines the data types of the values in a vertex element.
+     *
+     * The INT_2_10_10_10_REV types pack four values into 32 bits
+     * (10 bits each for x, y and z, and 2 bits for w) and require
+     * an element size of 4.
+     */
+    enum Type
+    {
+        FLOAT = 0,
+        HALF_FLOAT = 1,
+        BYTE = 2,
+        UNSIGNED_BYTE = 3,
+        SHORT = 4,
+        UNSIGNED_SHORT = 5,
+        INT_2_10_10_10_REV = 6,
+        UNSIGNED_INT_2_10_10_10_REV = 7
     };
 
     /**
      * Defines a single element within a vertex format.
      *
-     * All vertex elements are assumed to be of type float, but can
-     * have a varying number of float values (1-4), which is represented
-     * by the size attribute. Additionally, vertex elements are assumed
-     * to be tightly packed.
+     * Vertex elements have a varying number of values (1-4), which is
+     * represented by the size attribute, of the given type (float by default).
+     * Integer values are either normalized to [0, 1] or [-1, 1] (depending on
+     * their signedness) or converted to floats as they are. Vertex elements
+     * are assumed to be tightly packed.
      */
     class Element
     {
@@ -57,6 +82,16 @@ public:
          */
         unsigned int size;
 
+        /**
+         * The data type of the values in the vertex element.
+         */
+        Type type;
+
+        /**
+         * Whether integer values are normalized when they are read by the shader.
+         */
+        bool normalized;
+
         /**
          * Constructor.
          */
@@ -66,9 +101,16 @@ public:
          * Constructor.
          *
          * @param usage The vertex element usage semantic.
-         * @param size The number of float values in the vertex element.
+         * @param size The number of values in the vertex element.
+         * @param type The data type of the values.
+         * @param normalized true to normalize integer values.
+         */
+        Element(Usage usage, unsigned int size, Type type = FLOAT, bool normalized = false);
+
+        /**
+         * Gets the size (in bytes) of this vertex element.
          */
-        Element(Usage usage, unsigned int size);
+        unsigned int getByteSize() const;
 
         /**
          * Compares two vertex elements for equality.
@@ -146,6 +188,18 @@ public:
      */
     static const char* toString(Usage usage);
 
+    /**
+     * Decodes the values of a vertex element to floats.
+     *
+     * Normalized values are mapped to [0, 1] or [-1, 1]; the w value of a
+     * packed 2_10_10_10 element is written as well.
+     *
+     * @param element The vertex element.
+     * @param data Pointer to the vertex element within a vertex.
+     * @param values Receives the element's size values (4 for packed elements).
+     */
+    static void decode(const Element& element, const void* data, float* values);
+
 private:
 
     std::vector<Element> _elements;
@@ -18,7 +18,9 @@ void android_main(struct android_app* state)
     
     __state = state;
     Game* game = Game::getInstance();
+    StartupTrace::begin("Platform::create");
     Platform* platform = Platform::create(game);
+    StartupTrace::end();
     GP_ASSERT(platform);
     platform->enterMessagePump();
     delete platform;
@@ -15,7 +15,9 @@ int main(int argc, char** argv)
     __argc = argc;
     __argv = argv;
     Game* game = Game::getInstance();
+    StartupTrace::begin("Platform::create");
     Platform* platform = Platform::create(game);
+    StartupTrace::end();
     GP_ASSERT(platform);
     int result = platform->enterMessagePump();
     delete platform;
@@ -17,7 +17,9 @@ int main(int argc, char** argv)
     __argv = argv;
     NSAutoreleasePool *p = [[NSAutoreleasePool alloc] init];
     Game* game = Game::getInstance();
+    StartupTrace::begin("Platform::create");
     Platform* platform = Platform::create(game);
+    StartupTrace::end();
     GP_ASSERT(platform);
     int result = platform->enterMessagePump();
     delete platform;
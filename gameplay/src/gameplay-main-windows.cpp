@@ -15,7 +15,9 @@ using namespace gameplay;
 extern "C" int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR cmdLine, int cmdShow)
 {
     Game* game = Game::getInstance();
+    StartupTrace::begin("Platform::create");
     Platform* platform = Platform::create(game);
+    StartupTrace::end();
     GP_ASSERT(platform);
     int result = platform->enterMessagePump();
     delete platform;
@@ -2,15 +2,22 @@
 #include "Base.h"
 #include "Platform.h"
 #include "Game.h"
+#include "Thread.h"
+#include "JobScheduler.h"
+#include "Allocator.h"
 #include "Keyboard.h"
 #include "Mouse.h"
 #include "Touch.h"
 #include "Gesture.h"
 #include "Gamepad.h"
 #include "FileSystem.h"
+#include "ResourceCache.h"
+#include "StringTable.h"
 #include "Bundle.h"
 #include "MathUtil.h"
 #include "Logger.h"
+#include "StartupTrace.h"
+#include "LoadProfiler.h"
 
 // Math
 #include "Rectangle.h"
@@ -29,29 +36,69 @@
 
 // Graphics
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "Benchmark.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "GpuUploadQueue.h"
+#include "ReadbackQueue.h"
+#include "Picker.h"
+#include "RenderTargetPool.h"
+#include "RenderCommandList.h"
+#include "RenderThread.h"
+#include "DebugMarkers.h"
+#include "DebugRenderer.h"
+#include "PostProcessor.h"
 #include "Image.h"
 #include "Mesh.h"
 #include "MeshPart.h"
 #include "Effect.h"
+#include "EffectPermutations.h"
+#include "ProgramCache.h"
+#include "StateCache.h"
+#include "StaticBatcher.h"
+#include "StreamBuffer.h"
+#include "UniformBuffer.h"
 #include "Material.h"
+#include "MatrixPaletteTexture.h"
 #include "RenderState.h"
 #include "VertexFormat.h"
+#include "VertexAnimation.h"
+#include "CrowdRenderer.h"
 #include "VertexAttributeBinding.h"
+#include "InputQueue.h"
+#include "InputRecorder.h"
+#include "InstanceBuffer.h"
 #include "Model.h"
+#include "RenderQueue.h"
 #include "Camera.h"
 #include "Light.h"
+#include "LightClusters.h"
+#include "LightProbes.h"
 #include "Scene.h"
+#include "SceneSnapshot.h"
+#include "ShadowMaps.h"
 #include "Node.h"
+#include "Prefab.h"
+#include "NodePool.h"
+#include "OcclusionBuffer.h"
+#include "OcclusionCuller.h"
+#include "Octree.h"
 #include "Joint.h"
 #include "Font.h"
 #include "SpriteBatch.h"
 #include "ParticleEmitter.h"
+#include "ParticleManager.h"
 #include "FrameBuffer.h"
+#include "FrameGraph.h"
 #include "RenderTarget.h"
 #include "DepthStencilTarget.h"
 #include "ScreenDisplayer.h"
 #include "HeightField.h"
 #include "Terrain.h"
+#include "TerrainDetail.h"
 
 // Audio
 #include "AudioController.h"
@@ -65,6 +112,7 @@
 #include "AnimationValue.h"
 #include "Animation.h"
 #include "AnimationClip.h"
+#include "TweenManager.h"
 
 // Physics
 #include "PhysicsController.h"
@@ -87,11 +135,13 @@
 #include "AIAgent.h"
 #include "AIState.h"
 #include "AIStateMachine.h"
+#include "NavigationMesh.h"
 
 // UI
 #include "Theme.h"
 #include "Control.h"
 #include "Container.h"
+#include "ListContainer.h"
 #include "Form.h"
 #include "Label.h"
 #include "Button.h"
@@ -22,11 +22,13 @@ void luaRegister_AIAgent()
         {"getNode", lua_AIAgent_getNode},
         {"getRefCount", lua_AIAgent_getRefCount},
         {"getStateMachine", lua_AIAgent_getStateMachine},
+        {"getUpdateInterval", lua_AIAgent_getUpdateInterval},
         {"isEnabled", lua_AIAgent_isEnabled},
         {"release", lua_AIAgent_release},
         {"removeScriptCallback", lua_AIAgent_removeScriptCallback},
         {"setEnabled", lua_AIAgent_setEnabled},
         {"setListener", lua_AIAgent_setListener},
+        {"setUpdateInterval", lua_AIAgent_setUpdateInterval},
         {NULL, NULL}
     };
     const luaL_Reg lua_statics[] = 
@@ -314,6 +316,41 @@ int lua_AIAgent_getStateMachine(lua_State* state)
     return 0;
 }
 
+int lua_AIAgent_getUpdateInterval(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                AIAgent* instance = getInstance(state);
+                float result = instance->getUpdateInterval();
+
+                // Push the return value onto the stack.
+                lua_pushnumber(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_AIAgent_getUpdateInterval - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AIAgent_isEnabled(lua_State* state)
 {
     // Get the number of parameters.
@@ -499,6 +536,42 @@ int lua_AIAgent_setListener(lua_State* state)
     return 0;
 }
 
+int lua_AIAgent_setUpdateInterval(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                float param1 = (float)luaL_checknumber(state, 2);
+
+                AIAgent* instance = getInstance(state);
+                instance->setUpdateInterval(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_AIAgent_setUpdateInterval - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AIAgent_static_create(lua_State* state)
 {
     // Get the number of parameters.
@@ -12,11 +12,13 @@ int lua_AIAgent_getId(lua_State* state);
 int lua_AIAgent_getNode(lua_State* state);
 int lua_AIAgent_getRefCount(lua_State* state);
 int lua_AIAgent_getStateMachine(lua_State* state);
+int lua_AIAgent_getUpdateInterval(lua_State* state);
 int lua_AIAgent_isEnabled(lua_State* state);
 int lua_AIAgent_release(lua_State* state);
 int lua_AIAgent_removeScriptCallback(lua_State* state);
 int lua_AIAgent_setEnabled(lua_State* state);
 int lua_AIAgent_setListener(lua_State* state);
+int lua_AIAgent_setUpdateInterval(lua_State* state);
 int lua_AIAgent_static_create(lua_State* state);
 
 void luaRegister_AIAgent();
@@ -20,9 +20,11 @@ void luaRegister_AIState()
         {"addScriptCallback", lua_AIState_addScriptCallback},
         {"getId", lua_AIState_getId},
         {"getRefCount", lua_AIState_getRefCount},
+        {"isThreadSafe", lua_AIState_isThreadSafe},
         {"release", lua_AIState_release},
         {"removeScriptCallback", lua_AIState_removeScriptCallback},
         {"setListener", lua_AIState_setListener},
+        {"setThreadSafe", lua_AIState_setThreadSafe},
         {NULL, NULL}
     };
     const luaL_Reg lua_statics[] = 
@@ -222,6 +224,41 @@ int lua_AIState_getRefCount(lua_State* state)
     return 0;
 }
 
+int lua_AIState_isThreadSafe(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                AIState* instance = getInstance(state);
+                bool result = instance->isThreadSafe();
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_AIState_isThreadSafe - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AIState_release(lua_State* state)
 {
     // Get the number of parameters.
@@ -336,6 +373,42 @@ int lua_AIState_setListener(lua_State* state)
     return 0;
 }
 
+int lua_AIState_setThreadSafe(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TBOOLEAN)
+            {
+                // Get parameter 1 off the stack.
+                bool param1 = gameplay::ScriptUtil::luaCheckBool(state, 2);
+
+                AIState* instance = getInstance(state);
+                instance->setThreadSafe(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_AIState_setThreadSafe - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AIState_static_create(lua_State* state)
 {
     // Get the number of parameters.
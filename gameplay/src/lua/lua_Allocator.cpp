@@ -0,0 +1,338 @@
+#include "Base.h"
+#include "ScriptController.h"
+#include "lua_Allocator.h"
+#include "Allocator.h"
+#include "Base.h"
+#include "lua_AllocatorCategory.h"
+
+namespace gameplay
+{
+
+void luaRegister_Allocator()
+{
+    const luaL_Reg* lua_members = NULL;
+    const luaL_Reg lua_statics[] = 
+    {
+        {"getAllocationCount", lua_Allocator_static_getAllocationCount},
+        {"getBudget", lua_Allocator_static_getBudget},
+        {"getBytes", lua_Allocator_static_getBytes},
+        {"getCategoryName", lua_Allocator_static_getCategoryName},
+        {"getPeakBytes", lua_Allocator_static_getPeakBytes},
+        {"isOverBudget", lua_Allocator_static_isOverBudget},
+        {"setBudget", lua_Allocator_static_setBudget},
+        {"writeReport", lua_Allocator_static_writeReport},
+        {NULL, NULL}
+    };
+    std::vector<std::string> scopePath;
+
+    gameplay::ScriptUtil::registerClass("Allocator", lua_members, NULL, NULL, lua_statics, scopePath);
+}
+
+int lua_Allocator_static_getAllocationCount(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                unsigned int result = Allocator::getAllocationCount(param1);
+
+                // Push the return value onto the stack.
+                lua_pushunsigned(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_getAllocationCount - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_getBudget(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                size_t result = Allocator::getBudget(param1);
+
+                // Push the return value onto the stack.
+                lua_pushnumber(state, (lua_Number)result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_getBudget - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_getBytes(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                size_t result = Allocator::getBytes(param1);
+
+                // Push the return value onto the stack.
+                lua_pushnumber(state, (lua_Number)result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_getBytes - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_getCategoryName(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                const char* result = Allocator::getCategoryName(param1);
+
+                // Push the return value onto the stack.
+                lua_pushstring(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_getCategoryName - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_getPeakBytes(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                size_t result = Allocator::getPeakBytes(param1);
+
+                // Push the return value onto the stack.
+                lua_pushnumber(state, (lua_Number)result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_getPeakBytes - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_isOverBudget(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                bool result = Allocator::isOverBudget(param1);
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_isOverBudget - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_setBudget(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                Allocator::Category param1 = (Allocator::Category)lua_enumFromString_AllocatorCategory(luaL_checkstring(state, 1));
+
+                // Get parameter 2 off the stack.
+                size_t param2 = (size_t)luaL_checknumber(state, 2);
+
+                Allocator::setBudget(param1, param2);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_setBudget - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Allocator_static_writeReport(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 0:
+        {
+            bool result = Allocator::writeReport();
+
+            // Push the return value onto the stack.
+            lua_pushboolean(state, result);
+
+            return 1;
+            break;
+        }
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL))
+            {
+                // Get parameter 1 off the stack.
+                const char* param1 = gameplay::ScriptUtil::getString(1, false);
+
+                bool result = Allocator::writeReport(param1);
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Allocator_static_writeReport - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 0 or 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+}
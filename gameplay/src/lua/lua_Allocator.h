@@ -0,0 +1,21 @@
+#ifndef LUA_ALLOCATOR_H_
+#define LUA_ALLOCATOR_H_
+
+namespace gameplay
+{
+
+// Lua bindings for Allocator.
+int lua_Allocator_static_getAllocationCount(lua_State* state);
+int lua_Allocator_static_getBudget(lua_State* state);
+int lua_Allocator_static_getBytes(lua_State* state);
+int lua_Allocator_static_getCategoryName(lua_State* state);
+int lua_Allocator_static_getPeakBytes(lua_State* state);
+int lua_Allocator_static_isOverBudget(lua_State* state);
+int lua_Allocator_static_setBudget(lua_State* state);
+int lua_Allocator_static_writeReport(lua_State* state);
+
+void luaRegister_Allocator();
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "Base.h"
+#include "lua_AllocatorCategory.h"
+
+namespace gameplay
+{
+
+static const char* enumStringEmpty = "";
+
+static const char* luaEnumString_AllocatorCategory_GENERAL = "GENERAL";
+static const char* luaEnumString_AllocatorCategory_FRAME = "FRAME";
+static const char* luaEnumString_AllocatorCategory_SCENE = "SCENE";
+static const char* luaEnumString_AllocatorCategory_MATERIAL = "MATERIAL";
+static const char* luaEnumString_AllocatorCategory_AI = "AI";
+static const char* luaEnumString_AllocatorCategory_SCRIPT = "SCRIPT";
+static const char* luaEnumString_AllocatorCategory_TEXTURE = "TEXTURE";
+static const char* luaEnumString_AllocatorCategory_BUFFER = "BUFFER";
+static const char* luaEnumString_AllocatorCategory_FRAMEBUFFER = "FRAMEBUFFER";
+static const char* luaEnumString_AllocatorCategory_ANIMATION = "ANIMATION";
+static const char* luaEnumString_AllocatorCategory_PHYSICS = "PHYSICS";
+static const char* luaEnumString_AllocatorCategory_AUDIO = "AUDIO";
+static const char* luaEnumString_AllocatorCategory_CATEGORY_COUNT = "CATEGORY_COUNT";
+
+Allocator::Category lua_enumFromString_AllocatorCategory(const char* s)
+{
+    if (strcmp(s, luaEnumString_AllocatorCategory_GENERAL) == 0)
+        return Allocator::GENERAL;
+    if (strcmp(s, luaEnumString_AllocatorCategory_FRAME) == 0)
+        return Allocator::FRAME;
+    if (strcmp(s, luaEnumString_AllocatorCategory_SCENE) == 0)
+        return Allocator::SCENE;
+    if (strcmp(s, luaEnumString_AllocatorCategory_MATERIAL) == 0)
+        return Allocator::MATERIAL;
+    if (strcmp(s, luaEnumString_AllocatorCategory_AI) == 0)
+        return Allocator::AI;
+    if (strcmp(s, luaEnumString_AllocatorCategory_SCRIPT) == 0)
+        return Allocator::SCRIPT;
+    if (strcmp(s, luaEnumString_AllocatorCategory_TEXTURE) == 0)
+        return Allocator::TEXTURE;
+    if (strcmp(s, luaEnumString_AllocatorCategory_BUFFER) == 0)
+        return Allocator::BUFFER;
+    if (strcmp(s, luaEnumString_AllocatorCategory_FRAMEBUFFER) == 0)
+        return Allocator::FRAMEBUFFER;
+    if (strcmp(s, luaEnumString_AllocatorCategory_ANIMATION) == 0)
+        return Allocator::ANIMATION;
+    if (strcmp(s, luaEnumString_AllocatorCategory_PHYSICS) == 0)
+        return Allocator::PHYSICS;
+    if (strcmp(s, luaEnumString_AllocatorCategory_AUDIO) == 0)
+        return Allocator::AUDIO;
+    if (strcmp(s, luaEnumString_AllocatorCategory_CATEGORY_COUNT) == 0)
+        return Allocator::CATEGORY_COUNT;
+    return Allocator::GENERAL;
+}
+
+const char* lua_stringFromEnum_AllocatorCategory(Allocator::Category e)
+{
+    if (e == Allocator::GENERAL)
+        return luaEnumString_AllocatorCategory_GENERAL;
+    if (e == Allocator::FRAME)
+        return luaEnumString_AllocatorCategory_FRAME;
+    if (e == Allocator::SCENE)
+        return luaEnumString_AllocatorCategory_SCENE;
+    if (e == Allocator::MATERIAL)
+        return luaEnumString_AllocatorCategory_MATERIAL;
+    if (e == Allocator::AI)
+        return luaEnumString_AllocatorCategory_AI;
+    if (e == Allocator::SCRIPT)
+        return luaEnumString_AllocatorCategory_SCRIPT;
+    if (e == Allocator::TEXTURE)
+        return luaEnumString_AllocatorCategory_TEXTURE;
+    if (e == Allocator::BUFFER)
+        return luaEnumString_AllocatorCategory_BUFFER;
+    if (e == Allocator::FRAMEBUFFER)
+        return luaEnumString_AllocatorCategory_FRAMEBUFFER;
+    if (e == Allocator::ANIMATION)
+        return luaEnumString_AllocatorCategory_ANIMATION;
+    if (e == Allocator::PHYSICS)
+        return luaEnumString_AllocatorCategory_PHYSICS;
+    if (e == Allocator::AUDIO)
+        return luaEnumString_AllocatorCategory_AUDIO;
+    if (e == Allocator::CATEGORY_COUNT)
+        return luaEnumString_AllocatorCategory_CATEGORY_COUNT;
+    return enumStringEmpty;
+}
+
+}
+
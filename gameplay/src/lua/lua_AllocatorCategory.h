@@ -0,0 +1,15 @@
+#ifndef LUA_ALLOCATORCATEGORY_H_
+#define LUA_ALLOCATORCATEGORY_H_
+
+#include "Allocator.h"
+
+namespace gameplay
+{
+
+// Lua bindings for enum conversion functions for Allocator::Category.
+Allocator::Category lua_enumFromString_AllocatorCategory(const char* s);
+const char* lua_stringFromEnum_AllocatorCategory(Allocator::Category e);
+
+}
+
+#endif
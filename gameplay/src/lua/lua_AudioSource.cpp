@@ -27,6 +27,7 @@ void luaRegister_AudioSource()
         {"getGain", lua_AudioSource_getGain},
         {"getNode", lua_AudioSource_getNode},
         {"getPitch", lua_AudioSource_getPitch},
+        {"getPriority", lua_AudioSource_getPriority},
         {"getRefCount", lua_AudioSource_getRefCount},
         {"getState", lua_AudioSource_getState},
         {"getVelocity", lua_AudioSource_getVelocity},
@@ -39,6 +40,7 @@ void luaRegister_AudioSource()
         {"setGain", lua_AudioSource_setGain},
         {"setLooped", lua_AudioSource_setLooped},
         {"setPitch", lua_AudioSource_setPitch},
+        {"setPriority", lua_AudioSource_setPriority},
         {"setVelocity", lua_AudioSource_setVelocity},
         {"stop", lua_AudioSource_stop},
         {NULL, NULL}
@@ -244,6 +246,41 @@ int lua_AudioSource_getPitch(lua_State* state)
     return 0;
 }
 
+int lua_AudioSource_getPriority(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                AudioSource* instance = getInstance(state);
+                float result = instance->getPriority();
+
+                // Push the return value onto the stack.
+                lua_pushnumber(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_AudioSource_getPriority - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AudioSource_getRefCount(lua_State* state)
 {
     // Get the number of parameters.
@@ -661,6 +698,42 @@ int lua_AudioSource_setPitch(lua_State* state)
     return 0;
 }
 
+int lua_AudioSource_setPriority(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                float param1 = (float)luaL_checknumber(state, 2);
+
+                AudioSource* instance = getInstance(state);
+                instance->setPriority(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_AudioSource_setPriority - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_AudioSource_setVelocity(lua_State* state)
 {
     // Get the number of parameters.
@@ -674,7 +747,7 @@ int lua_AudioSource_setVelocity(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -799,9 +872,44 @@ int lua_AudioSource_static_create(lua_State* state)
             lua_error(state);
             break;
         }
+        case 2:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TSTRING || lua_type(state, 1) == LUA_TNIL) &&
+                    lua_type(state, 2) == LUA_TBOOLEAN)
+                {
+                    // Get parameter 1 off the stack.
+                    const char* param1 = gameplay::ScriptUtil::getString(1, false);
+
+                    // Get parameter 2 off the stack.
+                    bool param2 = gameplay::ScriptUtil::luaCheckBool(state, 2);
+
+                    void* returnPtr = (void*)AudioSource::create(param1, param2);
+                    if (returnPtr)
+                    {
+                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
+                        object->instance = returnPtr;
+                        object->owns = true;
+                        luaL_getmetatable(state, "AudioSource");
+                        lua_setmetatable(state, -2);
+                    }
+                    else
+                    {
+                        lua_pushnil(state);
+                    }
+
+                    return 1;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_AudioSource_static_create - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
         default:
         {
-            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_pushstring(state, "Invalid number of parameters (expected 1 or 2).");
             lua_error(state);
             break;
         }
@@ -144,8 +144,8 @@ int lua_BoundingBox__init(lua_State* state)
         {
             do
             {
-                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TNIL) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TCDATA || lua_type(state, 1) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -257,19 +257,7 @@ int lua_BoundingBox_getCenter(lua_State* state)
                 if ((lua_type(state, 1) == LUA_TUSERDATA))
                 {
                     BoundingBox* instance = getInstance(state);
-                    void* returnPtr = (void*)new Vector3(instance->getCenter());
-                    if (returnPtr)
-                    {
-                        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-                        object->instance = returnPtr;
-                        object->owns = true;
-                        luaL_getmetatable(state, "Vector3");
-                        lua_setmetatable(state, -2);
-                    }
-                    else
-                    {
-                        lua_pushnil(state);
-                    }
+                    gameplay::ScriptUtil::pushValue(state, Vector3(instance->getCenter()), "Vector3");
 
                     return 1;
                 }
@@ -284,7 +272,7 @@ int lua_BoundingBox_getCenter(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL))
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -324,7 +312,7 @@ int lua_BoundingBox_getCorners(lua_State* state)
         case 2:
         {
             if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL))
+                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL))
             {
                 // Get parameter 1 off the stack.
                 bool param1Valid;
@@ -545,19 +533,7 @@ int lua_BoundingBox_max(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->max);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->max), "Vector3");
 
         return 1;
     }
@@ -649,19 +625,7 @@ int lua_BoundingBox_min(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->min);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->min), "Vector3");
 
         return 1;
     }
@@ -722,8 +686,8 @@ int lua_BoundingBox_set(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -847,7 +811,7 @@ int lua_BoundingBox_transform(lua_State* state)
         case 2:
         {
             if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
             {
                 // Get parameter 1 off the stack.
                 bool param1Valid;
@@ -141,7 +141,7 @@ int lua_BoundingSphere__init(lua_State* state)
         {
             do
             {
-                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TNIL) &&
+                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TCDATA || lua_type(state, 1) == LUA_TNIL) &&
                     lua_type(state, 2) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -211,19 +211,7 @@ int lua_BoundingSphere_center(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->center);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->center), "Vector3");
 
         return 1;
     }
@@ -537,7 +525,7 @@ int lua_BoundingSphere_set(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     lua_type(state, 3) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -618,7 +606,7 @@ int lua_BoundingSphere_transform(lua_State* state)
         case 2:
         {
             if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
             {
                 // Get parameter 1 off the stack.
                 bool param1Valid;
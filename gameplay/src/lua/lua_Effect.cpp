@@ -511,7 +511,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -536,7 +536,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -561,7 +561,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -586,7 +586,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -611,7 +611,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -636,7 +636,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -661,7 +661,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -686,7 +686,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -794,7 +794,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
                     lua_type(state, 4) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -823,7 +823,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
                     lua_type(state, 4) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -852,7 +852,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
                     lua_type(state, 4) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -881,7 +881,7 @@ int lua_Effect_setValue(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TTABLE || lua_type(state, 3) == LUA_TNIL) &&
                     lua_type(state, 4) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -13,9 +13,11 @@ int lua_FileSystem_static_getExtension(lua_State* state);
 int lua_FileSystem_static_getResourcePath(lua_State* state);
 int lua_FileSystem_static_isAbsolutePath(lua_State* state);
 int lua_FileSystem_static_loadResourceAliases(lua_State* state);
+int lua_FileSystem_static_mountArchive(lua_State* state);
 int lua_FileSystem_static_readAll(lua_State* state);
 int lua_FileSystem_static_resolvePath(lua_State* state);
 int lua_FileSystem_static_setResourcePath(lua_State* state);
+int lua_FileSystem_static_unmountArchive(lua_State* state);
 
 void luaRegister_FileSystem();
 
@@ -15,6 +15,7 @@ int lua_Font_getLocationAtIndex(lua_State* state);
 int lua_Font_getRefCount(lua_State* state);
 int lua_Font_getSize(lua_State* state);
 int lua_Font_getSpriteBatch(lua_State* state);
+int lua_Font_isDistanceField(lua_State* state);
 int lua_Font_measureText(lua_State* state);
 int lua_Font_release(lua_State* state);
 int lua_Font_start(lua_State* state);
@@ -7,7 +7,10 @@ namespace gameplay
 // Lua bindings for Font::Text.
 int lua_FontText__gc(lua_State* state);
 int lua_FontText__init(lua_State* state);
+int lua_FontText_getColor(lua_State* state);
 int lua_FontText_getText(lua_State* state);
+int lua_FontText_setColor(lua_State* state);
+int lua_FontText_setText(lua_State* state);
 
 void luaRegister_FontText();
 
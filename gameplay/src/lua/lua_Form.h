@@ -40,6 +40,7 @@ int lua_Form_getImageColor(lua_State* state);
 int lua_Form_getImageRegion(lua_State* state);
 int lua_Form_getImageUVs(lua_State* state);
 int lua_Form_getLayout(lua_State* state);
+int lua_Form_getLayoutCount(lua_State* state);
 int lua_Form_getMargin(lua_State* state);
 int lua_Form_getOpacity(lua_State* state);
 int lua_Form_getPadding(lua_State* state);
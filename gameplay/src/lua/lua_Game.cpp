@@ -75,6 +75,7 @@ void luaRegister_Game()
         {"setViewport", lua_Game_setViewport},
         {"touchEvent", lua_Game_touchEvent},
         {"unregisterGesture", lua_Game_unregisterGesture},
+        {"unschedule", lua_Game_unschedule},
         {NULL, NULL}
     };
     const luaL_Reg lua_statics[] = 
@@ -185,7 +186,7 @@ int lua_Game_clear(lua_State* state)
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL) &&
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER)
                 {
@@ -1965,9 +1966,12 @@ int lua_Game_schedule(lua_State* state)
                 const char* param2 = gameplay::ScriptUtil::getString(3, false);
 
                 Game* instance = getInstance(state);
-                instance->schedule(param1, param2);
-                
-                return 0;
+                unsigned int result = instance->schedule(param1, param2);
+
+                // Push the return value onto the stack.
+                lua_pushunsigned(state, result);
+
+                return 1;
             }
 
             lua_pushstring(state, "lua_Game_schedule - Failed to match the given parameters to a valid function signature.");
@@ -2409,4 +2413,43 @@ int lua_Game_unregisterGesture(lua_State* state)
     return 0;
 }
 
+int lua_Game_unschedule(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                lua_type(state, 2) == LUA_TNUMBER)
+            {
+                // Get parameter 1 off the stack.
+                unsigned int param1 = (unsigned int)luaL_checkunsigned(state, 2);
+
+                Game* instance = getInstance(state);
+                bool result = instance->unschedule(param1);
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Game_unschedule - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 }
@@ -63,6 +63,7 @@ int lua_Game_static_isVsync(lua_State* state);
 int lua_Game_static_setVsync(lua_State* state);
 int lua_Game_touchEvent(lua_State* state);
 int lua_Game_unregisterGesture(lua_State* state);
+int lua_Game_unschedule(lua_State* state);
 
 void luaRegister_Game();
 
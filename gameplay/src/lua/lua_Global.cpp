@@ -154,6 +154,25 @@ void luaRegister_lua_Global()
         gameplay::ScriptUtil::registerConstantString("STRING", "STRING", scopePath);
     }
 
+    // Register enumeration Allocator::Category.
+    {
+        std::vector<std::string> scopePath;
+        scopePath.push_back("Allocator");
+        gameplay::ScriptUtil::registerConstantString("GENERAL", "GENERAL", scopePath);
+        gameplay::ScriptUtil::registerConstantString("FRAME", "FRAME", scopePath);
+        gameplay::ScriptUtil::registerConstantString("SCENE", "SCENE", scopePath);
+        gameplay::ScriptUtil::registerConstantString("MATERIAL", "MATERIAL", scopePath);
+        gameplay::ScriptUtil::registerConstantString("AI", "AI", scopePath);
+        gameplay::ScriptUtil::registerConstantString("SCRIPT", "SCRIPT", scopePath);
+        gameplay::ScriptUtil::registerConstantString("TEXTURE", "TEXTURE", scopePath);
+        gameplay::ScriptUtil::registerConstantString("BUFFER", "BUFFER", scopePath);
+        gameplay::ScriptUtil::registerConstantString("FRAMEBUFFER", "FRAMEBUFFER", scopePath);
+        gameplay::ScriptUtil::registerConstantString("ANIMATION", "ANIMATION", scopePath);
+        gameplay::ScriptUtil::registerConstantString("PHYSICS", "PHYSICS", scopePath);
+        gameplay::ScriptUtil::registerConstantString("AUDIO", "AUDIO", scopePath);
+        gameplay::ScriptUtil::registerConstantString("CATEGORY_COUNT", "CATEGORY_COUNT", scopePath);
+    }
+
     // Register enumeration AnimationClip::Listener::EventType.
     {
         std::vector<std::string> scopePath;
@@ -733,6 +752,8 @@ void luaRegister_lua_Global()
         gameplay::ScriptUtil::registerConstantString("SCENE_AMBIENT_COLOR", "SCENE_AMBIENT_COLOR", scopePath);
         gameplay::ScriptUtil::registerConstantString("SCENE_LIGHT_COLOR", "SCENE_LIGHT_COLOR", scopePath);
         gameplay::ScriptUtil::registerConstantString("SCENE_LIGHT_DIRECTION", "SCENE_LIGHT_DIRECTION", scopePath);
+        gameplay::ScriptUtil::registerConstantString("SCENE_LIGHT_PROBE", "SCENE_LIGHT_PROBE", scopePath);
+        gameplay::ScriptUtil::registerConstantString("NODE_LIGHTS", "NODE_LIGHTS", scopePath);
     }
 
     // Register enumeration RenderState::Blend.
@@ -785,6 +806,15 @@ void luaRegister_lua_Global()
         gameplay::ScriptUtil::registerConstantString("DEBUG_SPHERES", "DEBUG_SPHERES", scopePath);
     }
 
+    // Register enumeration Scene::VisitFilter.
+    {
+        std::vector<std::string> scopePath;
+        scopePath.push_back("Scene");
+        gameplay::ScriptUtil::registerConstantString("VISIT_MODELS", "VISIT_MODELS", scopePath);
+        gameplay::ScriptUtil::registerConstantString("VISIT_LIGHTS", "VISIT_LIGHTS", scopePath);
+        gameplay::ScriptUtil::registerConstantString("VISIT_CAMERAS", "VISIT_CAMERAS", scopePath);
+    }
+
     // Register enumeration Terrain::Flags.
     {
         std::vector<std::string> scopePath;
@@ -861,6 +891,8 @@ const char* lua_stringFromEnumGlobal(std::string& enumname, unsigned int value)
 {
     if (enumname == "AIMessage::ParameterType")
         return lua_stringFromEnum_AIMessageParameterType((AIMessage::ParameterType)value);
+    if (enumname == "Allocator::Category")
+        return lua_stringFromEnum_AllocatorCategory((Allocator::Category)value);
     if (enumname == "AnimationClip::Listener::EventType")
         return lua_stringFromEnum_AnimationClipListenerEventType((AnimationClip::Listener::EventType)value);
     if (enumname == "AudioSource::State")
@@ -935,6 +967,8 @@ const char* lua_stringFromEnumGlobal(std::string& enumname, unsigned int value)
         return lua_stringFromEnum_RenderStateDepthFunction((RenderState::DepthFunction)value);
     if (enumname == "Scene::DebugFlags")
         return lua_stringFromEnum_SceneDebugFlags((Scene::DebugFlags)value);
+    if (enumname == "Scene::VisitFilter")
+        return lua_stringFromEnum_SceneVisitFilter((Scene::VisitFilter)value);
     if (enumname == "Terrain::Flags")
         return lua_stringFromEnum_TerrainFlags((Terrain::Flags)value);
     if (enumname == "Texture::Filter")
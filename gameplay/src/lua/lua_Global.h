@@ -2,6 +2,7 @@
 #define LUA_GLOBAL_H_
 
 #include "lua_AIMessageParameterType.h"
+#include "lua_AllocatorCategory.h"
 #include "lua_AnimationClipListenerEventType.h"
 #include "lua_AudioSourceState.h"
 #include "lua_CameraType.h"
@@ -39,6 +40,7 @@
 #include "lua_RenderStateCullFaceSide.h"
 #include "lua_RenderStateDepthFunction.h"
 #include "lua_SceneDebugFlags.h"
+#include "lua_SceneVisitFilter.h"
 #include "lua_TerrainFlags.h"
 #include "lua_TextureFilter.h"
 #include "lua_TextureFormat.h"
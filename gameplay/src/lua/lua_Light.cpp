@@ -536,7 +536,7 @@ int lua_Light_setColor(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -766,7 +766,7 @@ int lua_Light_static_createDirectional(lua_State* state)
         {
             do
             {
-                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TNIL))
+                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TCDATA || lua_type(state, 1) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -857,7 +857,7 @@ int lua_Light_static_createPoint(lua_State* state)
         {
             do
             {
-                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TNIL) &&
+                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TCDATA || lua_type(state, 1) == LUA_TNIL) &&
                     lua_type(state, 2) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -956,7 +956,7 @@ int lua_Light_static_createSpot(lua_State* state)
         {
             do
             {
-                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TNIL) &&
+                if ((lua_type(state, 1) == LUA_TUSERDATA || lua_type(state, 1) == LUA_TCDATA || lua_type(state, 1) == LUA_TNIL) &&
                     lua_type(state, 2) == LUA_TNUMBER &&
                     lua_type(state, 3) == LUA_TNUMBER &&
                     lua_type(state, 4) == LUA_TNUMBER)
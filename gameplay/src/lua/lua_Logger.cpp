@@ -5,6 +5,7 @@
 #include "Base.h"
 #include "Game.h"
 #include "ScriptController.h"
+#include "Thread.h"
 #include "lua_LoggerLevel.h"
 
 namespace gameplay
@@ -15,6 +16,7 @@ void luaRegister_Logger()
     const luaL_Reg* lua_members = NULL;
     const luaL_Reg lua_statics[] = 
     {
+        {"flush", lua_Logger_static_flush},
         {"isEnabled", lua_Logger_static_isEnabled},
         {"log", lua_Logger_static_log},
         {"set", lua_Logger_static_set},
@@ -33,6 +35,31 @@ static Logger* getInstance(lua_State* state)
     return (Logger*)((gameplay::ScriptUtil::LuaObject*)userdata)->instance;
 }
 
+int lua_Logger_static_flush(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 0:
+        {
+            Logger::flush();
+            
+            return 0;
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 0).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Logger_static_isEnabled(lua_State* state)
 {
     // Get the number of parameters.
@@ -170,19 +170,7 @@ int lua_PhysicsControllerHitResult_normal(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->normal);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->normal), "Vector3");
 
         return 1;
     }
@@ -258,19 +246,7 @@ int lua_PhysicsControllerHitResult_point(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->point);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->point), "Vector3");
 
         return 1;
     }
@@ -377,7 +377,7 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TBOOLEAN &&
-                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TNIL))
+                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TCDATA || lua_type(state, 7) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     float param1 = (float)luaL_checknumber(state, 1);
@@ -435,8 +435,8 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TBOOLEAN &&
-                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TNIL) &&
-                    (lua_type(state, 8) == LUA_TUSERDATA || lua_type(state, 8) == LUA_TNIL))
+                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TCDATA || lua_type(state, 7) == LUA_TNIL) &&
+                    (lua_type(state, 8) == LUA_TUSERDATA || lua_type(state, 8) == LUA_TCDATA || lua_type(state, 8) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     float param1 = (float)luaL_checknumber(state, 1);
@@ -500,9 +500,9 @@ int lua_PhysicsRigidBodyParameters__init(lua_State* state)
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TBOOLEAN &&
-                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TNIL) &&
-                    (lua_type(state, 8) == LUA_TUSERDATA || lua_type(state, 8) == LUA_TNIL) &&
-                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TNIL))
+                    (lua_type(state, 7) == LUA_TUSERDATA || lua_type(state, 7) == LUA_TCDATA || lua_type(state, 7) == LUA_TNIL) &&
+                    (lua_type(state, 8) == LUA_TUSERDATA || lua_type(state, 8) == LUA_TCDATA || lua_type(state, 8) == LUA_TNIL) &&
+                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TCDATA || lua_type(state, 9) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     float param1 = (float)luaL_checknumber(state, 1);
@@ -627,19 +627,7 @@ int lua_PhysicsRigidBodyParameters_angularFactor(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->angularFactor);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->angularFactor), "Vector3");
 
         return 1;
     }
@@ -671,19 +659,7 @@ int lua_PhysicsRigidBodyParameters_anisotropicFriction(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->anisotropicFriction);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->anisotropicFriction), "Vector3");
 
         return 1;
     }
@@ -802,19 +778,7 @@ int lua_PhysicsRigidBodyParameters_linearFactor(lua_State* state)
     }
     else
     {
-        void* returnPtr = (void*)new Vector3(instance->linearFactor);
-        if (returnPtr)
-        {
-            gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-            object->instance = returnPtr;
-            object->owns = true;
-            luaL_getmetatable(state, "Vector3");
-            lua_setmetatable(state, -2);
-        }
-        else
-        {
-            lua_pushnil(state);
-        }
+        gameplay::ScriptUtil::pushValue(state, Vector3(instance->linearFactor), "Vector3");
 
         return 1;
     }
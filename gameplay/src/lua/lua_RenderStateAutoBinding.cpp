@@ -21,6 +21,8 @@ static const char* luaEnumString_RenderStateAutoBinding_MATRIX_PALETTE = "MATRIX
 static const char* luaEnumString_RenderStateAutoBinding_SCENE_AMBIENT_COLOR = "SCENE_AMBIENT_COLOR";
 static const char* luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_COLOR = "SCENE_LIGHT_COLOR";
 static const char* luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_DIRECTION = "SCENE_LIGHT_DIRECTION";
+static const char* luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_PROBE = "SCENE_LIGHT_PROBE";
+static const char* luaEnumString_RenderStateAutoBinding_NODE_LIGHTS = "NODE_LIGHTS";
 
 RenderState::AutoBinding lua_enumFromString_RenderStateAutoBinding(const char* s)
 {
@@ -54,6 +56,10 @@ RenderState::AutoBinding lua_enumFromString_RenderStateAutoBinding(const char* s
         return RenderState::SCENE_LIGHT_COLOR;
     if (strcmp(s, luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_DIRECTION) == 0)
         return RenderState::SCENE_LIGHT_DIRECTION;
+    if (strcmp(s, luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_PROBE) == 0)
+        return RenderState::SCENE_LIGHT_PROBE;
+    if (strcmp(s, luaEnumString_RenderStateAutoBinding_NODE_LIGHTS) == 0)
+        return RenderState::NODE_LIGHTS;
     return RenderState::NONE;
 }
 
@@ -89,6 +95,10 @@ const char* lua_stringFromEnum_RenderStateAutoBinding(RenderState::AutoBinding e
         return luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_COLOR;
     if (e == RenderState::SCENE_LIGHT_DIRECTION)
         return luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_DIRECTION;
+    if (e == RenderState::SCENE_LIGHT_PROBE)
+        return luaEnumString_RenderStateAutoBinding_SCENE_LIGHT_PROBE;
+    if (e == RenderState::NODE_LIGHTS)
+        return luaEnumString_RenderStateAutoBinding_NODE_LIGHTS;
     return enumStringEmpty;
 }
 
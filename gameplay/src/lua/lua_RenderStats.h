@@ -0,0 +1,21 @@
+#ifndef LUA_RENDERSTATS_H_
+#define LUA_RENDERSTATS_H_
+
+namespace gameplay
+{
+
+// Lua bindings for RenderStats.
+int lua_RenderStats_static_getDrawCalls(lua_State* state);
+int lua_RenderStats_static_getEffectBinds(lua_State* state);
+int lua_RenderStats_static_getRedundantStateChanges(lua_State* state);
+int lua_RenderStats_static_getTextureBinds(lua_State* state);
+int lua_RenderStats_static_getTriangleCount(lua_State* state);
+int lua_RenderStats_static_getUploadSize(lua_State* state);
+int lua_RenderStats_static_getUploads(lua_State* state);
+int lua_RenderStats_static_reset(lua_State* state);
+
+void luaRegister_RenderStats();
+
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "Ref.h"
 #include "Scene.h"
 #include "SceneLoader.h"
+#include "StartupTrace.h"
 #include "Terrain.h"
 
 namespace gameplay
@@ -22,7 +23,9 @@ void luaRegister_Scene()
         {"addNode", lua_Scene_addNode},
         {"addRef", lua_Scene_addRef},
         {"bindAudioListenerToCamera", lua_Scene_bindAudioListenerToCamera},
+        {"disableSpatialIndex", lua_Scene_disableSpatialIndex},
         {"drawDebug", lua_Scene_drawDebug},
+        {"enableSpatialIndex", lua_Scene_enableSpatialIndex},
         {"findNode", lua_Scene_findNode},
         {"getActiveCamera", lua_Scene_getActiveCamera},
         {"getAmbientColor", lua_Scene_getAmbientColor},
@@ -32,6 +35,7 @@ void luaRegister_Scene()
         {"getLightDirection", lua_Scene_getLightDirection},
         {"getNodeCount", lua_Scene_getNodeCount},
         {"getRefCount", lua_Scene_getRefCount},
+        {"isSpatialIndexEnabled", lua_Scene_isSpatialIndexEnabled},
         {"release", lua_Scene_release},
         {"removeAllNodes", lua_Scene_removeAllNodes},
         {"removeNode", lua_Scene_removeNode},
@@ -40,6 +44,8 @@ void luaRegister_Scene()
         {"setId", lua_Scene_setId},
         {"setLightColor", lua_Scene_setLightColor},
         {"setLightDirection", lua_Scene_setLightDirection},
+        {"updateMatrixPalettes", lua_Scene_updateMatrixPalettes},
+        {"updateTransforms", lua_Scene_updateTransforms},
         {"visit", lua_Scene_visit},
         {NULL, NULL}
     };
@@ -266,6 +272,38 @@ int lua_Scene_bindAudioListenerToCamera(lua_State* state)
     return 0;
 }
 
+int lua_Scene_disableSpatialIndex(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Scene* instance = getInstance(state);
+                instance->disableSpatialIndex();
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Scene_disableSpatialIndex - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Scene_drawDebug(lua_State* state)
 {
     // Get the number of parameters.
@@ -302,6 +340,76 @@ int lua_Scene_drawDebug(lua_State* state)
     return 0;
 }
 
+int lua_Scene_enableSpatialIndex(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                {
+                    // Get parameter 1 off the stack.
+                    bool param1Valid;
+                    gameplay::ScriptUtil::LuaArray<BoundingBox> param1 = gameplay::ScriptUtil::getObjectPointer<BoundingBox>(2, "BoundingBox", true, &param1Valid);
+                    if (!param1Valid)
+                        break;
+
+                    Scene* instance = getInstance(state);
+                    instance->enableSpatialIndex(*param1);
+                    
+                    return 0;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_Scene_enableSpatialIndex - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        case 3:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    lua_type(state, 3) == LUA_TNUMBER)
+                {
+                    // Get parameter 1 off the stack.
+                    bool param1Valid;
+                    gameplay::ScriptUtil::LuaArray<BoundingBox> param1 = gameplay::ScriptUtil::getObjectPointer<BoundingBox>(2, "BoundingBox", true, &param1Valid);
+                    if (!param1Valid)
+                        break;
+
+                    // Get parameter 2 off the stack.
+                    unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 3);
+
+                    Scene* instance = getInstance(state);
+                    instance->enableSpatialIndex(*param1, param2);
+                    
+                    return 0;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_Scene_enableSpatialIndex - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 2 or 3).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Scene_findNode(lua_State* state)
 {
     // Get the number of parameters.
@@ -747,6 +855,41 @@ int lua_Scene_getRefCount(lua_State* state)
     return 0;
 }
 
+int lua_Scene_isSpatialIndexEnabled(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Scene* instance = getInstance(state);
+                bool result = instance->isSpatialIndexEnabled();
+
+                // Push the return value onto the stack.
+                lua_pushboolean(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Scene_isSpatialIndexEnabled - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Scene_release(lua_State* state)
 {
     // Get the number of parameters.
@@ -1030,7 +1173,7 @@ int lua_Scene_setLightDirection(lua_State* state)
         case 2:
         {
             if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
             {
                 // Get parameter 1 off the stack.
                 bool param1Valid;
@@ -1237,7 +1380,7 @@ int lua_Scene_static_load(lua_State* state)
     return 0;
 }
 
-int lua_Scene_visit(lua_State* state)
+int lua_Scene_updateMatrixPalettes(lua_State* state)
 {
     // Get the number of parameters.
     int paramCount = lua_gettop(state);
@@ -1245,27 +1388,184 @@ int lua_Scene_visit(lua_State* state)
     // Attempt to match the parameters to a valid binding.
     switch (paramCount)
     {
-        case 2:
+        case 1:
         {
-            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL))
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
             {
-                // Get parameter 1 off the stack.
-                const char* param1 = gameplay::ScriptUtil::getString(2, false);
+                Scene* instance = getInstance(state);
+                instance->updateMatrixPalettes();
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Scene_updateMatrixPalettes - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Scene_updateTransforms(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
 
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
                 Scene* instance = getInstance(state);
-                instance->visit(param1);
+                instance->updateTransforms();
                 
                 return 0;
             }
 
+            lua_pushstring(state, "lua_Scene_updateTransforms - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Scene_visit(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 2:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL))
+                {
+                    // Get parameter 1 off the stack.
+                    const char* param1 = gameplay::ScriptUtil::getString(2, false);
+
+                    Scene* instance = getInstance(state);
+                    instance->visit(param1);
+                    
+                    return 0;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_Scene_visit - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        case 3:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL) &&
+                    lua_type(state, 3) == LUA_TNUMBER)
+                {
+                    // Get parameter 1 off the stack.
+                    const char* param1 = gameplay::ScriptUtil::getString(2, false);
+
+                    // Get parameter 2 off the stack.
+                    unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 3);
+
+                    Scene* instance = getInstance(state);
+                    instance->visit(param1, param2);
+                    
+                    return 0;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_Scene_visit - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        case 4:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL) &&
+                    lua_type(state, 3) == LUA_TNUMBER &&
+                    (lua_type(state, 4) == LUA_TSTRING || lua_type(state, 4) == LUA_TNIL))
+                {
+                    // Get parameter 1 off the stack.
+                    const char* param1 = gameplay::ScriptUtil::getString(2, false);
+
+                    // Get parameter 2 off the stack.
+                    unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 3);
+
+                    // Get parameter 3 off the stack.
+                    const char* param3 = gameplay::ScriptUtil::getString(4, false);
+
+                    Scene* instance = getInstance(state);
+                    instance->visit(param1, param2, param3);
+                    
+                    return 0;
+                }
+            } while (0);
+
+            lua_pushstring(state, "lua_Scene_visit - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        case 5:
+        {
+            do
+            {
+                if ((lua_type(state, 1) == LUA_TUSERDATA) &&
+                    (lua_type(state, 2) == LUA_TSTRING || lua_type(state, 2) == LUA_TNIL) &&
+                    lua_type(state, 3) == LUA_TNUMBER &&
+                    (lua_type(state, 4) == LUA_TSTRING || lua_type(state, 4) == LUA_TNIL) &&
+                    (lua_type(state, 5) == LUA_TUSERDATA || lua_type(state, 5) == LUA_TTABLE || lua_type(state, 5) == LUA_TNIL))
+                {
+                    // Get parameter 1 off the stack.
+                    const char* param1 = gameplay::ScriptUtil::getString(2, false);
+
+                    // Get parameter 2 off the stack.
+                    unsigned int param2 = (unsigned int)luaL_checkunsigned(state, 3);
+
+                    // Get parameter 3 off the stack.
+                    const char* param3 = gameplay::ScriptUtil::getString(4, false);
+
+                    // Get parameter 4 off the stack.
+                    bool param4Valid;
+                    gameplay::ScriptUtil::LuaArray<Frustum> param4 = gameplay::ScriptUtil::getObjectPointer<Frustum>(5, "Frustum", false, &param4Valid);
+                    if (!param4Valid)
+                        break;
+
+                    Scene* instance = getInstance(state);
+                    instance->visit(param1, param2, param3, param4);
+                    
+                    return 0;
+                }
+            } while (0);
+
             lua_pushstring(state, "lua_Scene_visit - Failed to match the given parameters to a valid function signature.");
             lua_error(state);
             break;
         }
         default:
         {
-            lua_pushstring(state, "Invalid number of parameters (expected 2).");
+            lua_pushstring(state, "Invalid number of parameters (expected 2, 3, 4 or 5).");
             lua_error(state);
             break;
         }
@@ -9,7 +9,9 @@ int lua_Scene__gc(lua_State* state);
 int lua_Scene_addNode(lua_State* state);
 int lua_Scene_addRef(lua_State* state);
 int lua_Scene_bindAudioListenerToCamera(lua_State* state);
+int lua_Scene_disableSpatialIndex(lua_State* state);
 int lua_Scene_drawDebug(lua_State* state);
+int lua_Scene_enableSpatialIndex(lua_State* state);
 int lua_Scene_findNode(lua_State* state);
 int lua_Scene_getActiveCamera(lua_State* state);
 int lua_Scene_getAmbientColor(lua_State* state);
@@ -19,6 +21,7 @@ int lua_Scene_getLightColor(lua_State* state);
 int lua_Scene_getLightDirection(lua_State* state);
 int lua_Scene_getNodeCount(lua_State* state);
 int lua_Scene_getRefCount(lua_State* state);
+int lua_Scene_isSpatialIndexEnabled(lua_State* state);
 int lua_Scene_release(lua_State* state);
 int lua_Scene_removeAllNodes(lua_State* state);
 int lua_Scene_removeNode(lua_State* state);
@@ -30,6 +33,8 @@ int lua_Scene_setLightDirection(lua_State* state);
 int lua_Scene_static_create(lua_State* state);
 int lua_Scene_static_getScene(lua_State* state);
 int lua_Scene_static_load(lua_State* state);
+int lua_Scene_updateMatrixPalettes(lua_State* state);
+int lua_Scene_updateTransforms(lua_State* state);
 int lua_Scene_visit(lua_State* state);
 
 void luaRegister_Scene();
@@ -0,0 +1,36 @@
+#include "Base.h"
+#include "lua_SceneVisitFilter.h"
+
+namespace gameplay
+{
+
+static const char* enumStringEmpty = "";
+
+static const char* luaEnumString_SceneVisitFilter_VISIT_MODELS = "VISIT_MODELS";
+static const char* luaEnumString_SceneVisitFilter_VISIT_LIGHTS = "VISIT_LIGHTS";
+static const char* luaEnumString_SceneVisitFilter_VISIT_CAMERAS = "VISIT_CAMERAS";
+
+Scene::VisitFilter lua_enumFromString_SceneVisitFilter(const char* s)
+{
+    if (strcmp(s, luaEnumString_SceneVisitFilter_VISIT_MODELS) == 0)
+        return Scene::VISIT_MODELS;
+    if (strcmp(s, luaEnumString_SceneVisitFilter_VISIT_LIGHTS) == 0)
+        return Scene::VISIT_LIGHTS;
+    if (strcmp(s, luaEnumString_SceneVisitFilter_VISIT_CAMERAS) == 0)
+        return Scene::VISIT_CAMERAS;
+    return Scene::VISIT_MODELS;
+}
+
+const char* lua_stringFromEnum_SceneVisitFilter(Scene::VisitFilter e)
+{
+    if (e == Scene::VISIT_MODELS)
+        return luaEnumString_SceneVisitFilter_VISIT_MODELS;
+    if (e == Scene::VISIT_LIGHTS)
+        return luaEnumString_SceneVisitFilter_VISIT_LIGHTS;
+    if (e == Scene::VISIT_CAMERAS)
+        return luaEnumString_SceneVisitFilter_VISIT_CAMERAS;
+    return enumStringEmpty;
+}
+
+}
+
@@ -0,0 +1,15 @@
+#ifndef LUA_SCENEVISITFILTER_H_
+#define LUA_SCENEVISITFILTER_H_
+
+#include "Scene.h"
+
+namespace gameplay
+{
+
+// Lua bindings for enum conversion functions for Scene::VisitFilter.
+Scene::VisitFilter lua_enumFromString_SceneVisitFilter(const char* s);
+const char* lua_stringFromEnum_SceneVisitFilter(Scene::VisitFilter e);
+
+}
+
+#endif
@@ -124,7 +124,7 @@ int lua_SpriteBatch_draw(lua_State* state)
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
                     (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
                     (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
-                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TNIL))
+                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TCDATA || lua_type(state, 4) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -154,9 +154,9 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
-                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TNIL))
+                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TCDATA || lua_type(state, 4) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -192,10 +192,10 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
-                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TNIL) &&
-                    (lua_type(state, 5) == LUA_TUSERDATA || lua_type(state, 5) == LUA_TNIL))
+                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TCDATA || lua_type(state, 4) == LUA_TNIL) &&
+                    (lua_type(state, 5) == LUA_TUSERDATA || lua_type(state, 5) == LUA_TCDATA || lua_type(state, 5) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     bool param1Valid;
@@ -237,11 +237,11 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
-                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TNIL) &&
-                    (lua_type(state, 5) == LUA_TUSERDATA || lua_type(state, 5) == LUA_TNIL) &&
-                    (lua_type(state, 6) == LUA_TUSERDATA || lua_type(state, 6) == LUA_TNIL) &&
+                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TCDATA || lua_type(state, 4) == LUA_TNIL) &&
+                    (lua_type(state, 5) == LUA_TUSERDATA || lua_type(state, 5) == LUA_TCDATA || lua_type(state, 5) == LUA_TNIL) &&
+                    (lua_type(state, 6) == LUA_TUSERDATA || lua_type(state, 6) == LUA_TCDATA || lua_type(state, 6) == LUA_TNIL) &&
                     lua_type(state, 7) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -301,7 +301,7 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 7) == LUA_TNUMBER &&
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
-                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TNIL))
+                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TCDATA || lua_type(state, 10) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     float param1 = (float)luaL_checknumber(state, 2);
@@ -349,15 +349,15 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     lua_type(state, 3) == LUA_TNUMBER &&
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TNUMBER &&
                     lua_type(state, 7) == LUA_TNUMBER &&
                     lua_type(state, 8) == LUA_TNUMBER &&
-                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TNIL) &&
-                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TNIL) &&
+                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TCDATA || lua_type(state, 9) == LUA_TNIL) &&
+                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TCDATA || lua_type(state, 10) == LUA_TNIL) &&
                     lua_type(state, 11) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -417,7 +417,7 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 7) == LUA_TNUMBER &&
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
-                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TNIL) &&
+                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TCDATA || lua_type(state, 10) == LUA_TNIL) &&
                     (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
@@ -475,7 +475,7 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
                     lua_type(state, 10) == LUA_TNUMBER &&
-                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL))
+                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TCDATA || lua_type(state, 11) == LUA_TNIL))
                 {
                     // Get parameter 1 off the stack.
                     float param1 = (float)luaL_checknumber(state, 2);
@@ -526,15 +526,15 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
                     lua_type(state, 3) == LUA_TNUMBER &&
                     lua_type(state, 4) == LUA_TNUMBER &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TNUMBER &&
                     lua_type(state, 7) == LUA_TNUMBER &&
                     lua_type(state, 8) == LUA_TNUMBER &&
-                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TNIL) &&
-                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TNIL) &&
+                    (lua_type(state, 9) == LUA_TUSERDATA || lua_type(state, 9) == LUA_TCDATA || lua_type(state, 9) == LUA_TNIL) &&
+                    (lua_type(state, 10) == LUA_TUSERDATA || lua_type(state, 10) == LUA_TCDATA || lua_type(state, 10) == LUA_TNIL) &&
                     lua_type(state, 11) == LUA_TNUMBER &&
                     lua_type(state, 12) == LUA_TBOOLEAN)
                 {
@@ -599,7 +599,7 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
                     lua_type(state, 10) == LUA_TNUMBER &&
-                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL) &&
+                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TCDATA || lua_type(state, 11) == LUA_TNIL) &&
                     lua_type(state, 12) == LUA_TBOOLEAN)
                 {
                     // Get parameter 1 off the stack.
@@ -663,8 +663,8 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
                     lua_type(state, 10) == LUA_TNUMBER &&
-                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL) &&
-                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TNIL) &&
+                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TCDATA || lua_type(state, 11) == LUA_TNIL) &&
+                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TCDATA || lua_type(state, 12) == LUA_TNIL) &&
                     lua_type(state, 13) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -719,17 +719,17 @@ int lua_SpriteBatch_draw(lua_State* state)
             do
             {
                 if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL) &&
-                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TNIL) &&
-                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TNIL) &&
+                    (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL) &&
+                    (lua_type(state, 3) == LUA_TUSERDATA || lua_type(state, 3) == LUA_TCDATA || lua_type(state, 3) == LUA_TNIL) &&
+                    (lua_type(state, 4) == LUA_TUSERDATA || lua_type(state, 4) == LUA_TCDATA || lua_type(state, 4) == LUA_TNIL) &&
                     lua_type(state, 5) == LUA_TNUMBER &&
                     lua_type(state, 6) == LUA_TNUMBER &&
                     lua_type(state, 7) == LUA_TNUMBER &&
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
                     lua_type(state, 10) == LUA_TNUMBER &&
-                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL) &&
-                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TNIL) &&
+                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TCDATA || lua_type(state, 11) == LUA_TNIL) &&
+                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TCDATA || lua_type(state, 12) == LUA_TNIL) &&
                     lua_type(state, 13) == LUA_TNUMBER)
                 {
                     // Get parameter 1 off the stack.
@@ -808,8 +808,8 @@ int lua_SpriteBatch_draw(lua_State* state)
                     lua_type(state, 8) == LUA_TNUMBER &&
                     lua_type(state, 9) == LUA_TNUMBER &&
                     lua_type(state, 10) == LUA_TNUMBER &&
-                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TNIL) &&
-                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TNIL) &&
+                    (lua_type(state, 11) == LUA_TUSERDATA || lua_type(state, 11) == LUA_TCDATA || lua_type(state, 11) == LUA_TNIL) &&
+                    (lua_type(state, 12) == LUA_TUSERDATA || lua_type(state, 12) == LUA_TCDATA || lua_type(state, 12) == LUA_TNIL) &&
                     lua_type(state, 13) == LUA_TNUMBER &&
                     lua_type(state, 14) == LUA_TBOOLEAN)
                 {
@@ -1098,7 +1098,7 @@ int lua_SpriteBatch_setProjectionMatrix(lua_State* state)
         case 2:
         {
             if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TNIL))
+                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TCDATA || lua_type(state, 2) == LUA_TNIL))
             {
                 // Get parameter 1 off the stack.
                 bool param1Valid;
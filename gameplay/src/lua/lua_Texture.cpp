@@ -23,6 +23,7 @@ void luaRegister_Texture()
         {"getFormat", lua_Texture_getFormat},
         {"getHandle", lua_Texture_getHandle},
         {"getHeight", lua_Texture_getHeight},
+        {"getLayerCount", lua_Texture_getLayerCount},
         {"getPath", lua_Texture_getPath},
         {"getRefCount", lua_Texture_getRefCount},
         {"getWidth", lua_Texture_getWidth},
@@ -34,6 +35,8 @@ void luaRegister_Texture()
     const luaL_Reg lua_statics[] = 
     {
         {"create", lua_Texture_static_create},
+        {"isPremultipliedAlpha", lua_Texture_static_isPremultipliedAlpha},
+        {"setPremultipliedAlpha", lua_Texture_static_setPremultipliedAlpha},
         {NULL, NULL}
     };
     std::vector<std::string> scopePath;
@@ -264,6 +267,41 @@ int lua_Texture_getHeight(lua_State* state)
     return 0;
 }
 
+int lua_Texture_getLayerCount(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if ((lua_type(state, 1) == LUA_TUSERDATA))
+            {
+                Texture* instance = getInstance(state);
+                unsigned int result = instance->getLayerCount();
+
+                // Push the return value onto the stack.
+                lua_pushunsigned(state, result);
+
+                return 1;
+            }
+
+            lua_pushstring(state, "lua_Texture_getLayerCount - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 int lua_Texture_getPath(lua_State* state)
 {
     // Get the number of parameters.
@@ -787,4 +825,66 @@ int lua_Texture_static_create(lua_State* state)
     return 0;
 }
 
+int lua_Texture_static_isPremultipliedAlpha(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 0:
+        {
+            bool result = Texture::isPremultipliedAlpha();
+
+            // Push the return value onto the stack.
+            lua_pushboolean(state, result);
+
+            return 1;
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 0).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
+int lua_Texture_static_setPremultipliedAlpha(lua_State* state)
+{
+    // Get the number of parameters.
+    int paramCount = lua_gettop(state);
+
+    // Attempt to match the parameters to a valid binding.
+    switch (paramCount)
+    {
+        case 1:
+        {
+            if (lua_type(state, 1) == LUA_TBOOLEAN)
+            {
+                // Get parameter 1 off the stack.
+                bool param1 = gameplay::ScriptUtil::luaCheckBool(state, 1);
+
+                Texture::setPremultipliedAlpha(param1);
+                
+                return 0;
+            }
+
+            lua_pushstring(state, "lua_Texture_static_setPremultipliedAlpha - Failed to match the given parameters to a valid function signature.");
+            lua_error(state);
+            break;
+        }
+        default:
+        {
+            lua_pushstring(state, "Invalid number of parameters (expected 1).");
+            lua_error(state);
+            break;
+        }
+    }
+    return 0;
+}
+
 }
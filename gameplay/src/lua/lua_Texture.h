@@ -11,6 +11,7 @@ int lua_Texture_generateMipmaps(lua_State* state);
 int lua_Texture_getFormat(lua_State* state);
 int lua_Texture_getHandle(lua_State* state);
 int lua_Texture_getHeight(lua_State* state);
+int lua_Texture_getLayerCount(lua_State* state);
 int lua_Texture_getPath(lua_State* state);
 int lua_Texture_getRefCount(lua_State* state);
 int lua_Texture_getWidth(lua_State* state);
@@ -18,6 +19,8 @@ int lua_Texture_isCompressed(lua_State* state);
 int lua_Texture_isMipmapped(lua_State* state);
 int lua_Texture_release(lua_State* state);
 int lua_Texture_static_create(lua_State* state);
+int lua_Texture_static_isPremultipliedAlpha(lua_State* state);
+int lua_Texture_static_setPremultipliedAlpha(lua_State* state);
 
 void luaRegister_Texture();
 
@@ -21,6 +21,8 @@ static const char* luaEnumString_VertexFormatUsage_TEXCOORD4 = "TEXCOORD4";
 static const char* luaEnumString_VertexFormatUsage_TEXCOORD5 = "TEXCOORD5";
 static const char* luaEnumString_VertexFormatUsage_TEXCOORD6 = "TEXCOORD6";
 static const char* luaEnumString_VertexFormatUsage_TEXCOORD7 = "TEXCOORD7";
+static const char* luaEnumString_VertexFormatUsage_INSTANCE_MATRIX = "INSTANCE_MATRIX";
+static const char* luaEnumString_VertexFormatUsage_INSTANCE_DATA = "INSTANCE_DATA";
 
 VertexFormat::Usage lua_enumFromString_VertexFormatUsage(const char* s)
 {
@@ -54,6 +56,10 @@ VertexFormat::Usage lua_enumFromString_VertexFormatUsage(const char* s)
         return VertexFormat::TEXCOORD6;
     if (strcmp(s, luaEnumString_VertexFormatUsage_TEXCOORD7) == 0)
         return VertexFormat::TEXCOORD7;
+    if (strcmp(s, luaEnumString_VertexFormatUsage_INSTANCE_MATRIX) == 0)
+        return VertexFormat::INSTANCE_MATRIX;
+    if (strcmp(s, luaEnumString_VertexFormatUsage_INSTANCE_DATA) == 0)
+        return VertexFormat::INSTANCE_DATA;
     return VertexFormat::POSITION;
 }
 
@@ -89,6 +95,10 @@ const char* lua_stringFromEnum_VertexFormatUsage(VertexFormat::Usage e)
         return luaEnumString_VertexFormatUsage_TEXCOORD6;
     if (e == VertexFormat::TEXCOORD7)
         return luaEnumString_VertexFormatUsage_TEXCOORD7;
+    if (e == VertexFormat::INSTANCE_MATRIX)
+        return luaEnumString_VertexFormatUsage_INSTANCE_MATRIX;
+    if (e == VertexFormat::INSTANCE_DATA)
+        return luaEnumString_VertexFormatUsage_INSTANCE_DATA;
     return enumStringEmpty;
 }
 
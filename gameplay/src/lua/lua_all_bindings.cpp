@@ -14,6 +14,7 @@ void lua_RegisterAllBindings()
     luaRegister_AIStateListener();
     luaRegister_AIStateMachine();
     luaRegister_AbsoluteLayout();
+    luaRegister_Allocator();
     luaRegister_Animation();
     luaRegister_AnimationClip();
     luaRegister_AnimationClipListener();
@@ -101,6 +102,7 @@ void lua_RegisterAllBindings()
     luaRegister_Ref();
     luaRegister_RenderState();
     luaRegister_RenderStateStateBlock();
+    luaRegister_RenderStats();
     luaRegister_RenderTarget();
     luaRegister_Scene();
     luaRegister_ScreenDisplayer();
@@ -9,6 +9,7 @@
 #include "lua_AIStateListener.h"
 #include "lua_AIStateMachine.h"
 #include "lua_AbsoluteLayout.h"
+#include "lua_Allocator.h"
 #include "lua_Animation.h"
 #include "lua_AnimationClip.h"
 #include "lua_AnimationClipListener.h"
@@ -96,6 +97,7 @@
 #include "lua_Ref.h"
 #include "lua_RenderState.h"
 #include "lua_RenderStateStateBlock.h"
+#include "lua_RenderStats.h"
 #include "lua_RenderTarget.h"
 #include "lua_Scene.h"
 #include "lua_ScreenDisplayer.h"
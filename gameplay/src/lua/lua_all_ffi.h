@@ -0,0 +1,18 @@
+#ifndef LUA_ALL_FFI_H_
+#define LUA_ALL_FFI_H_
+
+namespace gameplay
+{
+
+// The C declarations of the plain math classes, for the LuaJIT FFI.
+static const char* lua_ffi_cdef =
+    "typedef struct Vector2 { float x; float y; } Vector2;\n"
+    "typedef struct Vector3 { float x; float y; float z; } Vector3;\n"
+    "typedef struct Vector4 { float x; float y; float z; float w; } Vector4;\n"
+    "typedef struct Quaternion { float x; float y; float z; float w; } Quaternion;\n"
+    "typedef struct Matrix { float m[16]; } Matrix;\n"
+    "";
+
+}
+
+#endif
@@ -0,0 +1,459 @@
+#include "MicroBenchGame.h"
+
+// Declare our game instance
+MicroBenchGame game;
+
+#define DATASET_SIZE 1024
+#define CURVE_POINT_COUNT 8
+#define TRANSFORM_TREE_COUNT 64
+#define TRANSFORM_TREE_DEPTH 4
+
+// The interpolation types whose curves are benchmarked.
+static const char* __curveTypes[] =
+{
+    "BEZIER", "BSPLINE", "FLAT", "HERMITE", "LINEAR", "SMOOTH", "STEP",
+    "QUADRATIC_IN_OUT", "CUBIC_IN_OUT", "SINE_IN_OUT", "EXPONENTIAL_IN_OUT",
+    "CIRCULAR_IN_OUT", "ELASTIC_IN_OUT", "OVERSHOOT_IN_OUT", "BOUNCE_IN_OUT"
+};
+
+#if defined(WIN32)
+#define MICROBENCH_PLATFORM "windows"
+#elif defined(__ANDROID__)
+#define MICROBENCH_PLATFORM "android"
+#elif defined(__QNX__)
+#define MICROBENCH_PLATFORM "blackberry"
+#elif defined(__APPLE__)
+#define MICROBENCH_PLATFORM "apple"
+#elif defined(__linux__)
+#define MICROBENCH_PLATFORM "linux"
+#else
+#define MICROBENCH_PLATFORM "unknown"
+#endif
+
+#if defined(__aarch64__)
+#define MICROBENCH_ARCH "arm64"
+#elif defined(__arm__)
+#define MICROBENCH_ARCH "arm"
+#elif defined(__x86_64__) || defined(_M_X64)
+#define MICROBENCH_ARCH "x64"
+#elif defined(__i386__) || defined(_M_IX86)
+#define MICROBENCH_ARCH "x86"
+#else
+#define MICROBENCH_ARCH "unknown"
+#endif
+
+#if defined(USE_NEON)
+#define MICROBENCH_MATH "neon"
+#elif defined(USE_SSE)
+#define MICROBENCH_MATH "sse"
+#else
+#define MICROBENCH_MATH "scalar"
+#endif
+
+// Fixed seed, so that every run and platform benchmarks the same data.
+static unsigned int __seed = 12345;
+
+static float randomFloat(float min, float max)
+{
+    __seed = __seed * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(__seed >> 8) / (float)(1 << 24);
+}
+
+static Vector3 randomVector(float extent)
+{
+    return Vector3(randomFloat(-extent, extent), randomFloat(-extent, extent), randomFloat(-extent, extent));
+}
+
+MicroBenchGame::MicroBenchGame()
+    : _scene(NULL), _bundle(NULL), _minTime(50.0), _repeats(5), _sink(0.0f)
+{
+}
+
+MicroBenchGame::~MicroBenchGame()
+{
+}
+
+void MicroBenchGame::initialize()
+{
+    Properties* config = getConfig()->getNamespace("microbench", true);
+    const char* output = "microbench.json";
+    if (config)
+    {
+        if (config->exists("output"))
+            output = config->getString("output");
+        if (config->exists("minTime"))
+            _minTime = std::max(config->getFloat("minTime"), 1.0f);
+        if (config->exists("repeats"))
+            _repeats = (unsigned int)std::max(config->getInt("repeats"), 1);
+        if (config->exists("filter"))
+            _filter = config->getString("filter");
+    }
+
+    createDatasets();
+
+    print("Microbenchmarks (%s, %s, %s math)\n", MICROBENCH_PLATFORM, MICROBENCH_ARCH, MICROBENCH_MATH);
+    run("Matrix::multiply", matrixMultiply, NULL, DATASET_SIZE);
+    run("Matrix::invert", matrixInvert, NULL, DATASET_SIZE);
+    run("Quaternion::slerp", quaternionSlerp, NULL, DATASET_SIZE);
+    for (size_t i = 0; i < _curves.size(); ++i)
+    {
+        std::string name = std::string("Curve::evaluate ") + __curveTypes[i];
+        run(name.c_str(), curveEvaluate, _curves[i], DATASET_SIZE);
+    }
+    run("Frustum::intersects(BoundingBox)", frustumBoxes, NULL, DATASET_SIZE);
+    run("Frustum::intersects(BoundingSphere)", frustumSpheres, NULL, DATASET_SIZE);
+    run("BoundingBox::intersects(BoundingBox)", boxBoxes, NULL, DATASET_SIZE);
+    run("BoundingSphere::intersects(BoundingSphere)", sphereSpheres, NULL, DATASET_SIZE);
+    if (_scene)
+        run("Scene::updateTransforms (per node)", transformUpdate, NULL, TRANSFORM_TREE_COUNT * ((1 << TRANSFORM_TREE_DEPTH) - 1));
+    if (FileSystem::fileExists("res/common/game.material"))
+        run("Properties::create (game.material)", propertiesParse, NULL, 1);
+    if (_bundle && !_bundleIds.empty())
+        run("Bundle::find (game.gpb)", bundleFind, NULL, (unsigned int)_bundleIds.size());
+
+    writeResults(output);
+
+    // The benchmarks run once; there is nothing to draw.
+    exit();
+}
+
+void MicroBenchGame::finalize()
+{
+    for (size_t i = 0; i < _curves.size(); ++i)
+    {
+        SAFE_RELEASE(_curves[i]);
+    }
+    _curves.clear();
+    SAFE_RELEASE(_scene);
+    SAFE_RELEASE(_bundle);
+}
+
+void MicroBenchGame::update(float elapsedTime)
+{
+}
+
+void MicroBenchGame::render(float elapsedTime)
+{
+    clear(CLEAR_COLOR, Vector4::zero(), 1.0f, 0);
+}
+
+void MicroBenchGame::createDatasets()
+{
+    for (unsigned int i = 0; i < DATASET_SIZE; ++i)
+    {
+        // Invertible transforms, as the engine multiplies and inverts them.
+        Quaternion rotation(randomVector(1.0f), randomFloat(0.0f, MATH_PIX2));
+        rotation.normalize();
+        Matrix matrix;
+        Matrix::createRotation(rotation, &matrix);
+        matrix.scale(randomFloat(0.5f, 2.0f));
+        matrix.translate(randomVector(100.0f));
+        _matrices.push_back(matrix);
+        _quaternions.push_back(rotation);
+
+        // Volumes spread around the frustum, so that some are in and some are out.
+        Vector3 center = randomVector(500.0f);
+        Vector3 extent(randomFloat(1.0f, 20.0f), randomFloat(1.0f, 20.0f), randomFloat(1.0f, 20.0f));
+        _boxes.push_back(BoundingBox(center - extent, center + extent));
+        _spheres.push_back(BoundingSphere(center, extent.length()));
+        _times.push_back(randomFloat(0.0f, 1.0f));
+    }
+
+    Matrix projection;
+    Matrix view;
+    Matrix::createPerspective(60.0f, 16.0f / 9.0f, 1.0f, 1000.0f, &projection);
+    Matrix::createLookAt(Vector3(0, 100.0f, 400.0f), Vector3::zero(), Vector3::unitY(), &view);
+    Matrix viewProjection;
+    Matrix::multiply(projection, view, &viewProjection);
+    _frustum.set(viewProjection);
+
+    // One curve of three components per interpolation type, with tangents for the types that use them.
+    for (unsigned int i = 0; i < sizeof(__curveTypes) / sizeof(__curveTypes[0]); ++i)
+    {
+        Curve::InterpolationType type = (Curve::InterpolationType)Curve::getInterpolationType(__curveTypes[i]);
+        Curve* curve = Curve::create(CURVE_POINT_COUNT, 3);
+        for (unsigned int j = 0; j < CURVE_POINT_COUNT; ++j)
+        {
+            Vector3 value = randomVector(10.0f);
+            Vector3 in = randomVector(10.0f);
+            Vector3 out = randomVector(10.0f);
+            curve->setPoint(j, (float)j / (CURVE_POINT_COUNT - 1), &value.x, type, &in.x, &out.x);
+        }
+        _curves.push_back(curve);
+    }
+
+    // Binary trees of nodes, whose roots move every iteration.
+    _scene = Scene::create();
+    for (unsigned int i = 0; i < TRANSFORM_TREE_COUNT; ++i)
+    {
+        Node* root = _scene->addNode();
+        root->setTranslation(randomVector(100.0f));
+        _roots.push_back(root);
+
+        std::vector<Node*> level(1, root);
+        for (unsigned int depth = 1; depth < TRANSFORM_TREE_DEPTH; ++depth)
+        {
+            std::vector<Node*> next;
+            for (size_t j = 0; j < level.size(); ++j)
+            {
+                for (unsigned int k = 0; k < 2; ++k)
+                {
+                    Node* child = Node::create();
+                    child->setTranslation(randomVector(10.0f));
+                    child->setRotation(_quaternions[(i + j + k) % DATASET_SIZE]);
+                    level[j]->addChild(child);
+                    next.push_back(child);
+                    child->release();
+                }
+            }
+            level.swap(next);
+        }
+    }
+    _scene->updateTransforms();
+
+    // The racer sample's bundle, for its many objects.
+    if (FileSystem::fileExists("res/common/game.gpb"))
+    {
+        _bundle = Bundle::create("res/common/game.gpb");
+        if (_bundle)
+        {
+            for (unsigned int i = 0, count = _bundle->getObjectCount(); i < count; ++i)
+            {
+                _bundleIds.push_back(_bundle->getObjectId(i));
+            }
+        }
+    }
+}
+
+void MicroBenchGame::run(const char* name, BenchmarkFunction function, void* cookie, unsigned int operationsPerIteration)
+{
+    GP_ASSERT(name && function && operationsPerIteration > 0);
+
+    if (!_filter.empty() && strstr(name, _filter.c_str()) == NULL)
+        return;
+
+    // Double the iterations until a batch takes long enough to time, then keep the fastest batch.
+    function(this, cookie, 1);
+    unsigned int iterations = 1;
+    double elapsed = 0.0;
+    while (true)
+    {
+        double start = getAbsoluteTime();
+        function(this, cookie, iterations);
+        elapsed = getAbsoluteTime() - start;
+        if (elapsed >= _minTime || iterations >= (1u << 30))
+            break;
+        iterations *= 2;
+    }
+    for (unsigned int i = 1; i < _repeats; ++i)
+    {
+        double start = getAbsoluteTime();
+        function(this, cookie, iterations);
+        elapsed = std::min(elapsed, getAbsoluteTime() - start);
+    }
+
+    Result result;
+    result.name = name;
+    result.operations = iterations * operationsPerIteration;
+    double seconds = std::max(elapsed, 1e-6) / 1000.0;
+    result.nanosecondsPerOperation = seconds * 1e9 / result.operations;
+    result.operationsPerSecond = result.operations / seconds;
+    _results.push_back(result);
+
+    print("%-44s %12.2f ns/op %16.0f ops/s\n", name, result.nanosecondsPerOperation, result.operationsPerSecond);
+}
+
+bool MicroBenchGame::writeResults(const char* path) const
+{
+    GP_ASSERT(path);
+
+    FILE* file = FileSystem::openFile(path, "wb");
+    if (file == NULL)
+    {
+        GP_WARN("Failed to create microbenchmark results file '%s'.", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"platform\": \"%s\",\n  \"arch\": \"%s\",\n  \"math\": \"%s\",\n  \"results\": [", MICROBENCH_PLATFORM, MICROBENCH_ARCH, MICROBENCH_MATH);
+    for (size_t i = 0; i < _results.size(); ++i)
+    {
+        const Result& result = _results[i];
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"operations\": %u, \"nsPerOp\": %.3f, \"opsPerSecond\": %.0f}",
+            i == 0 ? "" : ",", result.name.c_str(), result.operations, result.nanosecondsPerOperation, result.operationsPerSecond);
+    }
+    fputs("\n  ]\n}\n", file);
+
+    bool success = ferror(file) == 0;
+    fclose(file);
+    if (!success)
+        GP_WARN("Failed to write microbenchmark results file '%s'.", path);
+    return success;
+}
+
+void MicroBenchGame::matrixMultiply(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<Matrix>& matrices = game->_matrices;
+    Matrix dst;
+    float sink = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            Matrix::multiply(matrices[j], matrices[(j + i + 1) % DATASET_SIZE], &dst);
+            sink += dst.m[12];
+        }
+    }
+    game->_sink += sink;
+}
+
+void MicroBenchGame::matrixInvert(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<Matrix>& matrices = game->_matrices;
+    Matrix dst;
+    float sink = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            matrices[j].invert(&dst);
+            sink += dst.m[12];
+        }
+    }
+    game->_sink += sink;
+}
+
+void MicroBenchGame::quaternionSlerp(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<Quaternion>& quaternions = game->_quaternions;
+    const std::vector<float>& times = game->_times;
+    Quaternion dst;
+    float sink = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            Quaternion::slerp(quaternions[j], quaternions[(j + i + 1) % DATASET_SIZE], times[j], &dst);
+            sink += dst.w;
+        }
+    }
+    game->_sink += sink;
+}
+
+void MicroBenchGame::curveEvaluate(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const Curve* curve = (const Curve*)cookie;
+    const std::vector<float>& times = game->_times;
+    float dst[3];
+    float sink = 0.0f;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            curve->evaluate(times[j], dst);
+            sink += dst[0];
+        }
+    }
+    game->_sink += sink;
+}
+
+void MicroBenchGame::frustumBoxes(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<BoundingBox>& boxes = game->_boxes;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            if (game->_frustum.intersects(boxes[j]))
+                ++count;
+        }
+    }
+    game->_sink += (float)count;
+}
+
+void MicroBenchGame::frustumSpheres(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<BoundingSphere>& spheres = game->_spheres;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            if (game->_frustum.intersects(spheres[j]))
+                ++count;
+        }
+    }
+    game->_sink += (float)count;
+}
+
+void MicroBenchGame::boxBoxes(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<BoundingBox>& boxes = game->_boxes;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            if (boxes[j].intersects(boxes[(j + i + 1) % DATASET_SIZE]))
+                ++count;
+        }
+    }
+    game->_sink += (float)count;
+}
+
+void MicroBenchGame::sphereSpheres(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<BoundingSphere>& spheres = game->_spheres;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (unsigned int j = 0; j < DATASET_SIZE; ++j)
+        {
+            if (spheres[j].intersects(spheres[(j + i + 1) % DATASET_SIZE]))
+                ++count;
+        }
+    }
+    game->_sink += (float)count;
+}
+
+void MicroBenchGame::transformUpdate(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    // Moving a root dirties its whole tree, which the scene then updates.
+    const std::vector<Node*>& roots = game->_roots;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        float offset = (i & 1) ? 0.01f : -0.01f;
+        for (size_t j = 0; j < roots.size(); ++j)
+        {
+            roots[j]->translateX(offset);
+        }
+        game->_scene->updateTransforms();
+    }
+    game->_sink += roots[0]->getWorldMatrix().m[12];
+}
+
+void MicroBenchGame::propertiesParse(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        Properties* properties = Properties::create("res/common/game.material");
+        if (properties)
+            game->_sink += 1.0f;
+        SAFE_DELETE(properties);
+    }
+}
+
+void MicroBenchGame::bundleFind(MicroBenchGame* game, void* cookie, unsigned int iterations)
+{
+    const std::vector<std::string>& ids = game->_bundleIds;
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        for (size_t j = 0; j < ids.size(); ++j)
+        {
+            if (game->_bundle->contains(ids[j].c_str()))
+                ++count;
+        }
+    }
+    game->_sink += (float)count;
+}
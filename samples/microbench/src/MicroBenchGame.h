@@ -0,0 +1,116 @@
+#ifndef MICROBENCHGAME_H_
+#define MICROBENCHGAME_H_
+
+#include "gameplay.h"
+
+using namespace gameplay;
+
+/**
+ * Microbenchmarks of the core math, culling, transform, properties and bundle paths.
+ *
+ * The benchmarks run on fixed datasets (generated from a fixed seed, or loaded from the
+ * racer sample's resources) when the game initializes. Each one runs batches of doubling
+ * size until a batch takes long enough to be timed reliably, and keeps the fastest of a
+ * few batches of that size. The time per operation and the throughput are printed, and
+ * written as JSON with the platform, architecture and math path (NEON, SSE or scalar)
+ * the engine was built for, so that runs on different platforms and builds compare.
+ * The game exits once the results are written.
+ *
+ * @verbatim
+    microbench
+    {
+        output = microbench.json    // File to write the results to.
+        minTime = 50                // Minimum duration of a timed batch, in milliseconds.
+        repeats = 5                 // Timed batches per benchmark, the fastest is kept.
+        filter = Matrix             // Only run the benchmarks whose name contains this text.
+    }
+   @endverbatim
+ */
+class MicroBenchGame: public Game
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    MicroBenchGame();
+
+    /**
+     * Destructor.
+     */
+    virtual ~MicroBenchGame();
+
+protected:
+
+    /**
+     * @see Game::initialize
+     */
+    void initialize();
+
+    /**
+     * @see Game::finalize
+     */
+    void finalize();
+
+    /**
+     * @see Game::update
+     */
+    void update(float elapsedTime);
+
+    /**
+     * @see Game::render
+     */
+    void render(float elapsedTime);
+
+private:
+
+    /**
+     * Runs a number of iterations of a benchmark.
+     */
+    typedef void (*BenchmarkFunction)(MicroBenchGame* game, void* cookie, unsigned int iterations);
+
+    struct Result
+    {
+        std::string name;
+        unsigned int operations;
+        double nanosecondsPerOperation;
+        double operationsPerSecond;
+    };
+
+    void createDatasets();
+
+    void run(const char* name, BenchmarkFunction function, void* cookie, unsigned int operationsPerIteration);
+
+    bool writeResults(const char* path) const;
+
+    static void matrixMultiply(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void matrixInvert(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void quaternionSlerp(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void curveEvaluate(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void frustumBoxes(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void frustumSpheres(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void boxBoxes(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void sphereSpheres(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void transformUpdate(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void propertiesParse(MicroBenchGame* game, void* cookie, unsigned int iterations);
+    static void bundleFind(MicroBenchGame* game, void* cookie, unsigned int iterations);
+
+    std::vector<Matrix> _matrices;
+    std::vector<Quaternion> _quaternions;
+    std::vector<BoundingBox> _boxes;
+    std::vector<BoundingSphere> _spheres;
+    std::vector<float> _times;
+    std::vector<Curve*> _curves;
+    Frustum _frustum;
+    Scene* _scene;
+    std::vector<Node*> _roots;
+    Bundle* _bundle;
+    std::vector<std::string> _bundleIds;
+    std::string _filter;
+    double _minTime;
+    unsigned int _repeats;
+    std::vector<Result> _results;
+    float _sink;
+};
+
+#endif
@@ -297,6 +297,10 @@ bool RacerGame::isUpset() const
 
 void RacerGame::render(float elapsedTime)
 {
+    // Render the scene at the dynamic resolution (if enabled in game.config), and the UI at the native resolution
+    DynamicResolution* dynamicResolution = getDynamicResolution();
+    dynamicResolution->begin();
+
     // Clear the color and depth buffers
     clear(CLEAR_COLOR_DEPTH, Vector4::zero(), 1.0f, 0);
 
@@ -313,6 +317,8 @@ void RacerGame::render(float elapsedTime)
         Game::getInstance()->getPhysicsController()->drawDebug(_scene->getActiveCamera()->getViewProjectionMatrix());
     }
 
+    dynamicResolution->end();
+
     // Draw the gamepad
     if (_gamepad && _gamepad->isVirtual())
     	_gamepad->draw();
@@ -1,12 +1,13 @@
 #include "Base.h"
 #include "AnimationChannel.h"
 #include "Transform.h"
+#include "Quaternion.h"
 
 namespace gameplay
 {
 
 AnimationChannel::AnimationChannel(void) :
-    _targetAttrib(0)
+    _targetAttrib(0), _quantized(false)
 {
 }
 
@@ -25,18 +26,76 @@ const char* AnimationChannel::getElementName(void) const
 
 void AnimationChannel::writeBinary(FILE* file)
 {
+    if (writeSpooled(file))
+        return;
     Object::writeBinary(file);
     write(_targetId, file);
     write(_targetAttrib, file);
-    write((unsigned int)_keytimes.size(), file);
+    FILE* section = beginSection(file);
+    write((unsigned int)(_quantized ? ENCODING_QUANTIZED : ENCODING_FLOAT), section);
+    write((unsigned int)_keytimes.size(), section);
     for (std::vector<float>::const_iterator i = _keytimes.begin(); i != _keytimes.end(); ++i)
     {
-        write((unsigned int)*i, file);
+        write((unsigned int)*i, section);
     }
-    write(_keyValues, file);
-    write(_tangentsIn, file);
-    write(_tangentsOut, file);
-    write(_interpolations, file);
+    if (_quantized)
+    {
+        writeQuantizedValues(section);
+    }
+    else
+    {
+        write(_keyValues, section);
+        write(_tangentsIn, section);
+        write(_tangentsOut, section);
+    }
+    write(_interpolations, section);
+    endSection(section, file);
+}
+
+void AnimationChannel::writeQuantizedValues(FILE* file)
+{
+    size_t keyCount = _keytimes.size();
+    size_t propSize = keyCount > 0 ? _keyValues.size() / keyCount : 0;
+
+    // Each component is quantized over its own range: value = offset + quantized * scale.
+    std::vector<float> offsets(propSize);
+    std::vector<float> scales(propSize);
+    for (size_t c = 0; c < propSize; ++c)
+    {
+        float minValue = FLT_MAX;
+        float maxValue = -FLT_MAX;
+        for (size_t i = 0; i < keyCount; ++i)
+        {
+            float value = _keyValues[i * propSize + c];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+        offsets[c] = minValue;
+        scales[c] = (maxValue - minValue) / 65535.0f;
+    }
+
+    std::vector<unsigned short> values(keyCount * propSize);
+    for (size_t i = 0; i < keyCount; ++i)
+    {
+        for (size_t c = 0; c < propSize; ++c)
+        {
+            float q = scales[c] > 0.0f ? (_keyValues[i * propSize + c] - offsets[c]) / scales[c] + 0.5f : 0.0f;
+            values[i * propSize + c] = (unsigned short)std::min(std::max(q, 0.0f), 65535.0f);
+        }
+    }
+
+    write(offsets, file);
+    write(scales, file);
+    write(values, file);
+}
+
+void AnimationChannel::releaseData()
+{
+    std::vector<float>().swap(_keytimes);
+    std::vector<float>().swap(_keyValues);
+    std::vector<float>().swap(_tangentsIn);
+    std::vector<float>().swap(_tangentsOut);
+    std::vector<unsigned int>().swap(_interpolations);
 }
 
 void AnimationChannel::writeText(FILE* file)
@@ -44,6 +103,7 @@ void AnimationChannel::writeText(FILE* file)
     fprintElementStart(file);
     fprintfElement(file, "targetId", _targetId);
     fprintf(file, "<%s>%u %s</%s>\n", "targetAttrib", _targetAttrib, Transform::getPropertyString(_targetAttrib), "targetAttrib");
+    fprintfElement(file, "encoding", (unsigned int)(_quantized ? ENCODING_QUANTIZED : ENCODING_FLOAT));
     fprintfElement(file, "%f ", "keytimes", _keytimes);
     fprintfElement(file, "%f ", "values", _keyValues);
     fprintfElement(file, "%f ", "tangentsIn", _tangentsIn);
@@ -175,6 +235,106 @@ void AnimationChannel::removeDuplicates()
     LOG(3, "      Removed %d duplicate keyframes from channel.\n", startCount- _keytimes.size());
 }
 
+void AnimationChannel::compress(float tolerance)
+{
+    size_t keyCount = _keytimes.size();
+    size_t propSize = keyCount > 0 ? _keyValues.size() / keyCount : 0;
+    if (propSize == 0)
+        return;
+
+    LOG(3, "      Compressing channel with target attribute: %u.\n", _targetAttrib);
+
+    // Walk the key frames and only keep the ones that the interpolation from
+    // the last kept key frame to the following key frame does not reproduce.
+    if (keyCount > 2)
+    {
+        std::vector<size_t> kept;
+        kept.push_back(0);
+        for (size_t i = 1; i < keyCount - 1; ++i)
+        {
+            if (!isInterpolated(kept.back(), i + 1, propSize, tolerance))
+                kept.push_back(i);
+        }
+        kept.push_back(keyCount - 1);
+
+        if (kept.size() < keyCount)
+        {
+            std::vector<float> keytimes;
+            std::vector<float> keyValues;
+            std::vector<unsigned int> interpolations;
+            for (size_t i = 0; i < kept.size(); ++i)
+            {
+                keytimes.push_back(_keytimes[kept[i]]);
+                keyValues.insert(keyValues.end(), _keyValues.begin() + kept[i] * propSize, _keyValues.begin() + (kept[i] + 1) * propSize);
+                if (_interpolations.size() == keyCount)
+                    interpolations.push_back(_interpolations[kept[i]]);
+            }
+            _keytimes.swap(keytimes);
+            _keyValues.swap(keyValues);
+            if (_interpolations.size() == keyCount)
+                _interpolations.swap(interpolations);
+
+            LOG(3, "      Removed %lu of %lu keyframes from channel.\n", keyCount - kept.size(), keyCount);
+        }
+    }
+
+    // Quantized values are only interpolated linearly, so tangents are not written.
+    _quantized = true;
+}
+
+bool AnimationChannel::isInterpolated(size_t from, size_t to, size_t propSize, float tolerance) const
+{
+    int rotationOffset = getRotationOffset(_targetAttrib);
+    const float* fromValue = &_keyValues[from * propSize];
+    const float* toValue = &_keyValues[to * propSize];
+    float duration = _keytimes[to] - _keytimes[from];
+
+    for (size_t k = from + 1; k < to; ++k)
+    {
+        float t = duration > 0.0f ? (_keytimes[k] - _keytimes[from]) / duration : 0.0f;
+        const float* value = &_keyValues[k * propSize];
+        for (size_t c = 0; c < propSize; ++c)
+        {
+            if (rotationOffset >= 0 && c == (size_t)rotationOffset)
+            {
+                // Rotations are interpolated with slerp, like the runtime does.
+                Quaternion q;
+                Quaternion::slerp(Quaternion(fromValue[c], fromValue[c + 1], fromValue[c + 2], fromValue[c + 3]),
+                    Quaternion(toValue[c], toValue[c + 1], toValue[c + 2], toValue[c + 3]), t, &q);
+
+                // q and -q are the same rotation.
+                float dot = q.x * value[c] + q.y * value[c + 1] + q.z * value[c + 2] + q.w * value[c + 3];
+                float sign = dot < 0.0f ? -1.0f : 1.0f;
+                if (fabs(sign * q.x - value[c]) > tolerance || fabs(sign * q.y - value[c + 1]) > tolerance ||
+                    fabs(sign * q.z - value[c + 2]) > tolerance || fabs(sign * q.w - value[c + 3]) > tolerance)
+                {
+                    return false;
+                }
+                c += 3;
+            }
+            else if (fabs(fromValue[c] + (toValue[c] - fromValue[c]) * t - value[c]) > tolerance)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int AnimationChannel::getRotationOffset(unsigned int targetAttrib)
+{
+    switch (targetAttrib)
+    {
+    case Transform::ANIMATE_ROTATE:
+    case Transform::ANIMATE_ROTATE_TRANSLATE:
+        return 0;
+    case Transform::ANIMATE_SCALE_ROTATE_TRANSLATE:
+        return 3;
+    default:
+        return -1;
+    }
+}
+
 unsigned int AnimationChannel::getInterpolationType(const char* str)
 {
     unsigned int value = 0;
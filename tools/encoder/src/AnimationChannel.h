@@ -20,6 +20,12 @@ public:
         STEP = 6
     };
 
+    enum Encoding
+    {
+        ENCODING_FLOAT = 0,
+        ENCODING_QUANTIZED = 1
+    };
+
     /**
      * Constructor.
      */
@@ -34,6 +40,7 @@ public:
     virtual const char* getElementName(void) const;
     virtual void writeBinary(FILE* file);
     virtual void writeText(FILE* file);
+    virtual void releaseData();
 
     const std::string& getTargetId() const;
 
@@ -65,6 +72,17 @@ public:
      */
     void removeDuplicates();
 
+    /**
+     * Compresses the animation channel.
+     *
+     * Removes the key frames that linear interpolation between the remaining key frames
+     * reproduces within the given tolerance, and marks the channel to be written with
+     * 16-bit quantized values instead of floats.
+     * 
+     * @param tolerance The maximum error allowed for each component of a removed key frame.
+     */
+    void compress(float tolerance);
+
     /**
      * Returns the interpolation type value for the given string or zero if not valid.
      * Example: "LINEAR" returns AnimationChannel::LINEAR
@@ -86,6 +104,23 @@ private:
      */
     void deleteRange(size_t begin, size_t end, size_t propSize);
 
+    /**
+     * Returns true if interpolating between the key frames at index from and to reproduces
+     * every key frame in between within the given tolerance.
+     */
+    bool isInterpolated(size_t from, size_t to, size_t propSize, float tolerance) const;
+
+    /**
+     * Writes the key values as 16-bit values quantized over the range of each component.
+     */
+    void writeQuantizedValues(FILE* file);
+
+    /**
+     * Returns the index of the rotation quaternion within the key values of the given
+     * target attribute, or -1 if it has none. Matches the offsets used by the runtime.
+     */
+    static int getRotationOffset(unsigned int targetAttrib);
+
 private:
 
     std::string _targetId;
@@ -95,6 +130,7 @@ private:
     std::vector<float> _tangentsIn;
     std::vector<float> _tangentsOut;
     std::vector<unsigned int> _interpolations;
+    bool _quantized;
 };
 
 }
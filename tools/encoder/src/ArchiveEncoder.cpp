@@ -0,0 +1,193 @@
+#include "Base.h"
+#include "ArchiveEncoder.h"
+#include "FileIO.h"
+
+#include <zlib.h>
+
+#ifdef WIN32
+    #include <windows.h>
+#else
+    #include <dirent.h>
+#endif
+
+// Compression of the files of an archive, matching gameplay::FileSystem.
+#define ARCHIVE_COMPRESSION_NONE 0
+#define ARCHIVE_COMPRESSION_ZLIB 1
+
+namespace gameplay
+{
+
+static const unsigned char ARCHIVE_IDENTIFIER[] = { 0xAB, 'G', 'P', 'K', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char ARCHIVE_VERSION[] = { 1, 0 };
+
+/**
+ * A file to store in an archive.
+ */
+struct ArchiveFile
+{
+    std::string path;
+    std::vector<unsigned char> data;
+    unsigned int size;
+    unsigned char compression;
+
+    bool operator<(const ArchiveFile& file) const
+    {
+        return path < file.path;
+    }
+};
+
+/**
+ * Adds the paths of the files in a directory and its subdirectories, relative to the root directory.
+ */
+static bool listFiles(const std::string& root, const std::string& directory, std::vector<std::string>& files)
+{
+    std::string path(root);
+    if (!directory.empty())
+    {
+        path += "/";
+        path += directory;
+    }
+#ifdef WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return false;
+    do
+    {
+        std::string name(data.cFileName);
+        if (name == "." || name == "..")
+            continue;
+        std::string filePath = directory.empty() ? name : directory + "/" + name;
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+            listFiles(root, filePath, files);
+        else
+            files.push_back(filePath);
+    } while (FindNextFileA(find, &data) != 0);
+    FindClose(find);
+    return true;
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL)
+        return false;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        std::string name(entry->d_name);
+        if (name == "." || name == "..")
+            continue;
+        std::string filePath = directory.empty() ? name : directory + "/" + name;
+        struct stat s;
+        if (stat((root + "/" + filePath).c_str(), &s) != 0)
+            continue;
+        if (S_ISDIR(s.st_mode))
+            listFiles(root, filePath, files);
+        else if (S_ISREG(s.st_mode))
+            files.push_back(filePath);
+    }
+    closedir(dir);
+    return true;
+#endif
+}
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    unsigned char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + read);
+    bool result = ferror(file) == 0;
+    fclose(file);
+    return result;
+}
+
+bool ArchiveEncoder::encode(const char* inputDirectory, const char* outputFile)
+{
+    std::string root(inputDirectory);
+    while (root.size() > 1 && root[root.size() - 1] == '/')
+        root.erase(root.size() - 1);
+
+    std::vector<std::string> paths;
+    if (!listFiles(root, "", paths))
+    {
+        LOG(1, "Error: failed to list the files of directory: %s.\n", inputDirectory);
+        return false;
+    }
+
+    std::vector<ArchiveFile> files;
+    files.reserve(paths.size());
+    size_t totalSize = 0;
+    size_t storedSize = 0;
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        std::string filePath = root + "/" + paths[i];
+        if (filePath == outputFile)
+            continue;
+
+        files.push_back(ArchiveFile());
+        ArchiveFile& file = files.back();
+        file.path = paths[i];
+        if (!readFile(filePath, file.data))
+        {
+            LOG(1, "Error: failed to read file: %s.\n", filePath.c_str());
+            return false;
+        }
+        file.size = (unsigned int)file.data.size();
+        file.compression = ARCHIVE_COMPRESSION_NONE;
+
+        // Keep the compressed data only if it is worth decompressing at load time.
+        if (file.size > 0)
+        {
+            uLongf compressedSize = compressBound(file.size);
+            std::vector<unsigned char> compressed(compressedSize);
+            if (compress2(&compressed[0], &compressedSize, &file.data[0], file.size, Z_BEST_COMPRESSION) == Z_OK &&
+                compressedSize < file.size - file.size / 8)
+            {
+                compressed.resize(compressedSize);
+                file.data.swap(compressed);
+                file.compression = ARCHIVE_COMPRESSION_ZLIB;
+            }
+        }
+        totalSize += file.size;
+        storedSize += file.data.size();
+    }
+    std::sort(files.begin(), files.end());
+
+    // The contents of the files follow the table of contents.
+    size_t offset = sizeof(ARCHIVE_IDENTIFIER) + sizeof(ARCHIVE_VERSION) + sizeof(unsigned int);
+    for (size_t i = 0; i < files.size(); ++i)
+        offset += sizeof(unsigned int) + files[i].path.size() + 3 * sizeof(unsigned int) + 1;
+
+    FILE* output = fopen(outputFile, "wb");
+    if (output == NULL)
+    {
+        LOG(1, "Error: failed to open file for writing: %s.\n", outputFile);
+        return false;
+    }
+    fwrite(ARCHIVE_IDENTIFIER, 1, sizeof(ARCHIVE_IDENTIFIER), output);
+    fwrite(ARCHIVE_VERSION, 1, sizeof(ARCHIVE_VERSION), output);
+    write((unsigned int)files.size(), output);
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const ArchiveFile& file = files[i];
+        write(file.path, output);
+        write((unsigned int)offset, output);
+        write(file.size, output);
+        write((unsigned int)file.data.size(), output);
+        write(file.compression, output);
+        offset += file.data.size();
+    }
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!files[i].data.empty())
+            fwrite(&files[i].data[0], 1, files[i].data.size(), output);
+    }
+    fclose(output);
+
+    LOG(1, "Wrote %d files (%d of %d bytes) to archive: %s.\n", (int)files.size(), (int)storedSize, (int)totalSize, outputFile);
+    return true;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef ARCHIVEENCODER_H_
+#define ARCHIVEENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Packs the files of a resource directory into an archive that is mounted with
+ * gameplay::FileSystem::mountArchive.
+ *
+ * The archive starts with a table of contents sorted by path, so that the runtime
+ * finds a file with a binary search, followed by the contents of the files. A file
+ * is compressed with zlib when that saves at least an eighth of its size, otherwise
+ * it is stored as is and read in place from the memory-mapped archive.
+ */
+class ArchiveEncoder
+{
+public:
+
+    /**
+     * Packs a directory.
+     *
+     * @param inputDirectory The directory to pack, the root of the paths in the archive.
+     * @param outputFile The archive to write.
+     *
+     * @return True if the archive was written.
+     */
+    static bool encode(const char* inputDirectory, const char* outputFile);
+
+};
+
+}
+
+#endif
@@ -70,6 +70,18 @@ enum VertexUsage
     TEXCOORD7 = 15
 };
 
+enum VertexType
+{
+    TYPE_FLOAT = 0,
+    TYPE_HALF_FLOAT = 1,
+    TYPE_BYTE = 2,
+    TYPE_UNSIGNED_BYTE = 3,
+    TYPE_SHORT = 4,
+    TYPE_UNSIGNED_SHORT = 5,
+    TYPE_INT_2_10_10_10_REV = 6,
+    TYPE_UNSIGNED_INT_2_10_10_10_REV = 7
+};
+
 void fillArray(float values[], float value, size_t length);
 
 /**
@@ -0,0 +1,338 @@
+#include "Base.h"
+#include "BatchEncoder.h"
+#include "EncoderArguments.h"
+#include "ThreadPool.h"
+
+#ifdef WIN32
+    #include <direct.h>
+#endif
+
+// 64-bit FNV-1a
+#define HASH_OFFSET 14695981039346656037ULL
+#define HASH_PRIME 1099511628211ULL
+
+namespace gameplay
+{
+
+/**
+ * An asset listed in a manifest.
+ */
+struct BatchEntry
+{
+    enum Result
+    {
+        FAILED,
+        ENCODED,
+        RESTORED,
+        UP_TO_DATE
+    };
+
+    unsigned int line;
+    std::vector<std::string> arguments;
+    std::string inputPath;
+    std::string outputPath;
+    Result result;
+};
+
+/**
+ * The data shared by the ThreadPool tasks that process the entries of a manifest.
+ */
+struct BatchData
+{
+    std::string encoderPath;
+    unsigned long long encoderHash;
+    std::string cacheDirPath;
+    std::vector<BatchEntry> entries;
+};
+
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+static bool hashFile(const std::string& path, unsigned long long* hash)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    std::vector<unsigned char> buffer(1 << 16);
+    size_t read;
+    while ((read = fread(&buffer[0], 1, buffer.size(), file)) > 0)
+    {
+        *hash = hashBytes(*hash, &buffer[0], read);
+    }
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+static bool copyFile(const std::string& source, const std::string& destination)
+{
+    FILE* in = fopen(source.c_str(), "rb");
+    if (in == NULL)
+        return false;
+    FILE* out = fopen(destination.c_str(), "wb");
+    if (out == NULL)
+    {
+        fclose(in);
+        return false;
+    }
+    std::vector<unsigned char> buffer(1 << 16);
+    size_t read;
+    bool ok = true;
+    while (ok && (read = fread(&buffer[0], 1, buffer.size(), in)) > 0)
+    {
+        ok = fwrite(&buffer[0], 1, read, out) == read;
+    }
+    ok = ok && ferror(in) == 0;
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+        remove(destination.c_str());
+    return ok;
+}
+
+static bool filesEqual(const std::string& path1, const std::string& path2)
+{
+    FILE* file1 = fopen(path1.c_str(), "rb");
+    FILE* file2 = fopen(path2.c_str(), "rb");
+    bool equal = file1 && file2;
+    if (equal)
+    {
+        std::vector<unsigned char> buffer1(1 << 16);
+        std::vector<unsigned char> buffer2(1 << 16);
+        for (;;)
+        {
+            size_t read1 = fread(&buffer1[0], 1, buffer1.size(), file1);
+            size_t read2 = fread(&buffer2[0], 1, buffer2.size(), file2);
+            if (read1 != read2 || memcmp(&buffer1[0], &buffer2[0], read1) != 0)
+            {
+                equal = false;
+                break;
+            }
+            if (read1 == 0)
+                break;
+        }
+    }
+    if (file1)
+        fclose(file1);
+    if (file2)
+        fclose(file2);
+    return equal;
+}
+
+static bool fileExists(const std::string& path)
+{
+    struct stat buf;
+    return stat(path.c_str(), &buf) == 0;
+}
+
+static bool createDirectory(const std::string& path)
+{
+    struct stat buf;
+    if (stat(path.c_str(), &buf) == 0)
+        return (buf.st_mode & S_IFDIR) != 0;
+#ifdef WIN32
+    return _mkdir(path.c_str()) == 0;
+#else
+    return mkdir(path.c_str(), 0777) == 0;
+#endif
+}
+
+/**
+ * Splits a manifest line into arguments, separated by white space or quoted.
+ */
+static void splitArguments(const std::string& line, std::vector<std::string>* arguments)
+{
+    size_t i = 0;
+    while (i < line.size())
+    {
+        while (i < line.size() && isspace((unsigned char)line[i]))
+            ++i;
+        if (i >= line.size())
+            break;
+        std::string argument;
+        bool quoted = false;
+        for (; i < line.size() && (quoted || !isspace((unsigned char)line[i])); ++i)
+        {
+            if (line[i] == '"')
+                quoted = !quoted;
+            else
+                argument += line[i];
+        }
+        arguments->push_back(argument);
+    }
+}
+
+/**
+ * Quotes an argument of a command run by the shell.
+ */
+static std::string quoteArgument(const std::string& argument)
+{
+#ifdef WIN32
+    return "\"" + argument + "\"";
+#else
+    std::string quoted("'");
+    for (size_t i = 0; i < argument.size(); ++i)
+    {
+        if (argument[i] == '\'')
+            quoted += "'\\''";
+        else
+            quoted += argument[i];
+    }
+    return quoted + "'";
+#endif
+}
+
+static void encodeEntry(unsigned int index, void* arg)
+{
+    BatchData* data = (BatchData*)arg;
+    BatchEntry& entry = data->entries[index];
+    entry.result = BatchEntry::FAILED;
+
+    unsigned long long hash = hashBytes(HASH_OFFSET, &data->encoderHash, sizeof(data->encoderHash));
+    for (size_t i = 0, count = entry.arguments.size(); i < count; ++i)
+    {
+        hash = hashBytes(hash, entry.arguments[i].c_str(), entry.arguments[i].size() + 1);
+    }
+    if (!hashFile(entry.inputPath, &hash))
+    {
+        LOG(1, "Error: Failed to read '%s' (manifest line %u).\n", entry.inputPath.c_str(), entry.line);
+        return;
+    }
+
+    char name[32];
+    sprintf(name, "/%016llx", hash);
+    std::string cachePath = data->cacheDirPath + name;
+
+    if (fileExists(cachePath))
+    {
+        if (fileExists(entry.outputPath) && filesEqual(cachePath, entry.outputPath))
+        {
+            LOG(2, "Up to date: %s\n", entry.outputPath.c_str());
+            entry.result = BatchEntry::UP_TO_DATE;
+        }
+        else if (copyFile(cachePath, entry.outputPath))
+        {
+            LOG(1, "Restored from cache: %s\n", entry.outputPath.c_str());
+            entry.result = BatchEntry::RESTORED;
+        }
+        else
+        {
+            LOG(1, "Error: Failed to restore '%s' from the cache.\n", entry.outputPath.c_str());
+        }
+        return;
+    }
+
+    // Encode in a child process; the batch already runs one process per thread.
+    std::string command = quoteArgument(data->encoderPath) + " -j 1";
+    for (size_t i = 0, count = entry.arguments.size(); i < count; ++i)
+    {
+        command += " ";
+        command += quoteArgument(entry.arguments[i]);
+    }
+#ifdef WIN32
+    // cmd.exe strips the outer quotes of a command that starts with a quote.
+    command = "\"" + command + "\"";
+#endif
+    LOG(1, "Encoding: %s\n", entry.inputPath.c_str());
+    if (system(command.c_str()) != 0 || !fileExists(entry.outputPath))
+    {
+        LOG(1, "Error: Failed to encode '%s' (manifest line %u).\n", entry.inputPath.c_str(), entry.line);
+        return;
+    }
+    entry.result = BatchEntry::ENCODED;
+
+    // Write the cache entry under a temporary name, so an interrupted copy is never used.
+    char temporary[32];
+    sprintf(temporary, ".%u.tmp", index);
+    std::string temporaryPath = cachePath + temporary;
+    if (!copyFile(entry.outputPath, temporaryPath) || rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+    {
+        remove(temporaryPath.c_str());
+        LOG(1, "Warning: Failed to cache '%s'.\n", entry.outputPath.c_str());
+    }
+}
+
+bool BatchEncoder::encode(const char* encoderPath, const char* manifestPath, const char* cacheDirPath)
+{
+    assert(encoderPath);
+    assert(manifestPath);
+    assert(cacheDirPath);
+
+    std::ifstream manifest(manifestPath);
+    if (!manifest)
+    {
+        LOG(1, "Error: Failed to open manifest '%s'.\n", manifestPath);
+        return false;
+    }
+
+    BatchData data;
+    data.encoderPath = encoderPath;
+    data.cacheDirPath = cacheDirPath;
+    while (data.cacheDirPath.size() > 1 && data.cacheDirPath[data.cacheDirPath.size() - 1] == '/')
+        data.cacheDirPath.erase(data.cacheDirPath.size() - 1);
+    if (!createDirectory(data.cacheDirPath))
+    {
+        LOG(1, "Error: Failed to create cache directory '%s'.\n", data.cacheDirPath.c_str());
+        return false;
+    }
+
+    // A new encoder invalidates every cached output.
+    data.encoderHash = HASH_OFFSET;
+    if (!hashFile(data.encoderPath, &data.encoderHash))
+    {
+        LOG(1, "Warning: Failed to read the encoder executable '%s'; cached outputs of other encoder builds are reused.\n", encoderPath);
+    }
+
+    // Parse the entries with the encoder's own argument parsing, for their input and output paths.
+    int logVerbosity = __logVerbosity;
+    bool parseError = false;
+    std::string line;
+    for (unsigned int lineNumber = 1; std::getline(manifest, line); ++lineNumber)
+    {
+        BatchEntry entry;
+        entry.line = lineNumber;
+        splitArguments(line, &entry.arguments);
+        if (entry.arguments.empty() || entry.arguments[0][0] == '#')
+            continue;
+
+        std::vector<const char*> argv;
+        argv.push_back(encoderPath);
+        for (size_t i = 0, count = entry.arguments.size(); i < count; ++i)
+            argv.push_back(entry.arguments[i].c_str());
+        EncoderArguments arguments(argv.size(), &argv[0]);
+        __logVerbosity = logVerbosity;
+
+        if (arguments.parseErrorOccured() || arguments.batchEnabled() || !arguments.fileExists())
+        {
+            LOG(1, "Error: Invalid command or missing input file on line %u of manifest '%s'.\n", lineNumber, manifestPath);
+            parseError = true;
+            continue;
+        }
+        entry.inputPath = arguments.getFilePath();
+        entry.outputPath = arguments.getOutputFilePath();
+        data.entries.push_back(entry);
+    }
+    if (parseError)
+        return false;
+
+    ThreadPool::run((unsigned int)data.entries.size(), &encodeEntry, &data);
+
+    unsigned int counts[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0, count = data.entries.size(); i < count; ++i)
+    {
+        ++counts[data.entries[i].result];
+    }
+    LOG(1, "Batch: %u encoded, %u restored from cache, %u up to date, %u failed.\n",
+        counts[BatchEntry::ENCODED], counts[BatchEntry::RESTORED], counts[BatchEntry::UP_TO_DATE], counts[BatchEntry::FAILED]);
+    return counts[BatchEntry::FAILED] == 0;
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef BATCHENCODER_H_
+#define BATCHENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Encodes the assets listed in a manifest, skipping those that have not changed.
+ *
+ * Each line of the manifest holds the arguments of one encoder command, the options
+ * followed by the input and output paths. Arguments are separated by white space and
+ * can be quoted with double quotes; empty lines and lines starting with '#' are ignored.
+ *
+ * An asset is identified by a hash of the encoder executable, its arguments and the
+ * contents of its input file. Outputs are stored in a cache directory under that hash,
+ * so an asset whose hash is in the cache is restored from it (or left alone if its
+ * output is already the same) instead of being encoded again, which also covers
+ * switching back to an earlier version of an asset. The other assets are encoded by
+ * running the encoder in a child process for each, with up to ThreadPool::getThreadCount()
+ * processes at a time. Only the main output file of an asset is cached.
+ */
+class BatchEncoder
+{
+public:
+
+    /**
+     * Encodes the assets of a manifest.
+     *
+     * @param encoderPath The path of the encoder executable, used to run and hash it.
+     * @param manifestPath The manifest file.
+     * @param cacheDirPath The directory to cache outputs in, created if needed.
+     *
+     * @return True if every asset is up to date or was encoded.
+     */
+    static bool encode(const char* encoderPath, const char* manifestPath, const char* cacheDirPath);
+
+};
+
+}
+
+#endif
@@ -13,6 +13,7 @@ class Curve
     friend class AnimationClip;
     friend class AnimationController;
     friend class MeshSkin;
+    friend class VertexAnimation;
 
 public:
 
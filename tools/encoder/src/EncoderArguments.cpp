@@ -2,6 +2,7 @@
 
 #include "EncoderArguments.h"
 #include "StringUtil.h"
+#include "TextureEncoder.h"
 
 #ifdef WIN32
     #define PATH_MAX    _MAX_PATH
@@ -20,12 +21,31 @@ extern int __logVerbosity = 1;
 EncoderArguments::EncoderArguments(size_t argc, const char** argv) :
     _fontSize(0),
     _normalMap(false),
+    _tileSize(0),
+    _archive(false),
+    _batch(false),
+    _textureFlags(0),
+    _compressSections(false),
     _parseError(false),
     _fontPreview(false),
+    _fontDistanceField(false),
     _textOutput(false),
     _optimizeAnimations(false),
+    _compressAnimations(false),
+    _animationTolerance(0.0f),
     _animationGrouping(ANIMATIONGROUP_PROMPT),
-    _outputMaterial(false)
+    _outputMaterial(false),
+    _bakeBvh(false),
+    _vertexCacheSize(16),
+    _quantizeVertices(false),
+    _splitMeshes(false),
+    _stream(false),
+    _vertexAnimationFrameRate(0.0f),
+    _navigationMeshSlope(0.0f),
+    _lightmapSize(0),
+    _atlasSize(0),
+    _lightProbeSpacing(0.0f),
+    _threadCount(0)
 {
     __instance = this;
 
@@ -99,12 +119,24 @@ std::string EncoderArguments::getOutputDirPath() const
 
 std::string EncoderArguments::getOutputFileExtension() const
 {
+    if (_archive)
+        return ".pak";
+
     switch (getFileFormat())
     {
     case FILEFORMAT_PNG:
     case FILEFORMAT_RAW:
         if (_normalMap)
             return ".png";
+        if (!_textureCompression.empty())
+            return "." + _textureCompression + ".ktx";
+        if (_tileSize > 0)
+            return ".tiles";
+        if (_navigationMeshSlope > 0.0f)
+            return ".gpb";
+
+    case FILEFORMAT_PROPERTIES:
+        return ".bin";
 
     default:
         return ".gpb";
@@ -121,6 +153,19 @@ std::string EncoderArguments::getOutputFilePath() const
     else
     {
         // Generate an output file path
+        if (_archive)
+        {
+            // The input is a directory.
+            std::string outputFilePath(_filePath);
+            while (outputFilePath.size() > 1 && outputFilePath[outputFilePath.size() - 1] == '/')
+                outputFilePath.erase(outputFilePath.size() - 1);
+            return outputFilePath + getOutputFileExtension();
+        }
+        if (getFileFormat() == FILEFORMAT_PROPERTIES)
+        {
+            // Keep the original extension, the engine recognizes binary properties files by their content.
+            return _filePath + getOutputFileExtension();
+        }
         int pos = _filePath.find_last_of('.');
         std::string outputFilePath(pos > 0 ? _filePath.substr(0, pos) : _filePath);
 
@@ -167,6 +212,16 @@ EncoderArguments::AnimationGroupOption EncoderArguments::getAnimationGrouping()
     return _animationGrouping;
 }
 
+unsigned int EncoderArguments::getThreadCount() const
+{
+    return _threadCount;
+}
+
+const std::vector<EncoderArguments::MeshLodOption>& EncoderArguments::getMeshLodOptions() const
+{
+    return _meshLods;
+}
+
 const std::vector<EncoderArguments::HeightmapOption>& EncoderArguments::getHeightmapOptions() const
 {
     return _heightmaps;
@@ -198,6 +253,16 @@ const Vector3& EncoderArguments::getHeightmapWorldSize() const
     return _heightmapWorldSize;
 }
 
+unsigned int EncoderArguments::getTileSize() const
+{
+    return _tileSize;
+}
+
+const std::string& EncoderArguments::getTileBlendPath() const
+{
+    return _tileBlendPath;
+}
+
 bool EncoderArguments::parseErrorOccured() const
 {
     return _parseError;
@@ -237,12 +302,20 @@ void EncoderArguments::printUsage() const
     "Supported file extensions:\n" \
     "  .fbx\t(FBX)\n" \
     "  .ttf\t(TrueType Font)\n" \
+    "  .material, .scene, .physics, .form, .theme, .particle, .animation,\n" \
+    "  .audio, .terrain\t(Properties)\n" \
     "\n" \
     "General Options:\n" \
     "  -v <verbosity>\tVerbosity level (0-4).\n" \
+    "  -j <threads>\tNumber of threads to encode with (default 0, one per\n" \
+        "\t\tprocessor). The output is the same for any number of threads.\n" \
     "\n" \
     "FBX file options:\n" \
     "  -i <id>\tFilter by node ID.\n" \
+    "  -i16\t\tSplits meshes with more than 65536 vertices into several\n" \
+        "\t\tmeshes with 16-bit indices, for OpenGL ES 2.0 devices that\n" \
+        "\t\tcannot draw 32-bit indices. Without it such meshes use 32-bit\n" \
+        "\t\tindices.\n" \
     "  -t\t\tWrite text/xml.\n" \
     "  -g:auto\tAutomatically group animation channels into a new animation.\n" \
     "  -g:none\tDo not prompt to group animations.\n" \
@@ -250,13 +323,54 @@ void EncoderArguments::printUsage() const
         "\t\tGroup all animation channels targeting the nodes into a \n" \
         "\t\tnew animation.\n" \
     "  -m\t\tOutput material file for scene.\n" \
+    "  -bvh\t\tBake bounding volume hierarchies for mesh collision shapes.\n" \
     "  -tb <node id>\n" \
         "\t\tGenerates tangents and binormals for the given node.\n" \
+    "  -om <size>\tOptimizes the triangle and vertex order of meshes for a\n" \
+        "\t\tvertex cache of <size> entries (default 16, 0 to turn off).\n" \
+    "  -vq\t\tQuantizes vertex attributes: 16-bit positions, 10:10:10:2\n" \
+        "\t\tnormals and tangents, half float texture coordinates and\n" \
+        "\t\t8-bit colors and blend weights/indices.\n" \
+    "  -vat <fps>\tBakes the animations of each skinned mesh into vertex\n" \
+        "\t\tpositions and normals sampled <fps> times per second, for\n" \
+        "\t\tcrowds drawn without skinning (see CrowdRenderer).\n" \
+    "  -nav <slope>\tBakes a navigation mesh for AI path finding from the\n" \
+        "\t\tupward facing triangles of the static meshes of the scene\n" \
+        "\t\tthat are no steeper than <slope> degrees (see NavigationMesh).\n" \
+    "  -lod <ratio[:size]>[,...]\n" \
+        "\t\tGenerates simplified levels of detail for each mesh, keeping\n" \
+        "\t\t<ratio> (0 to 1) of its triangles. A level is drawn once the\n" \
+        "\t\tmesh covers less than <size> of the viewport height (default\n" \
+        "\t\t0.5 * sqrt(ratio)). Example: -lod 0.5,0.25:0.1\n" \
+    "  -lm <size>\tBakes the direct light and ambient occlusion of the static\n" \
+        "\t\tnodes whose meshes have a second set of texture coordinates\n" \
+        "\t\tinto <size> x <size> lightmaps, written as PNG files next to\n" \
+        "\t\tthe output and laid out by those coordinates.\n" \
+    "  -lp <spacing>\tBakes light probes every <spacing> units over the static\n" \
+        "\t\tgeometry of the scene, for lighting dynamic objects.\n" \
+    "  -atlas <size>\tMerges the materials that differ only by their textures\n" \
+        "\t\tinto one material per group, packing their diffuse and normal\n" \
+        "\t\tmap PNGs into atlases of at most <size> x <size> written next\n" \
+        "\t\tto the output, and remapping the texture coordinates of the\n" \
+        "\t\tmeshes. Textures that tile are left alone. Requires -m.\n" \
+    "  -z\t\tCompresses the vertex, index and animation key data with zlib,\n" \
+        "\t\tin blocks that decompress on their own, for smaller bundles\n" \
+        "\t\tthat load with less I/O.\n" \
+    "  -stream\tProcesses and writes each static mesh and animation channel\n" \
+        "\t\tas soon as it is loaded, to a temporary file that is copied\n" \
+        "\t\tinto the output, so that large scenes encode with far less\n" \
+        "\t\tmemory. Skinned meshes and the channels of their joints are\n" \
+        "\t\tstill kept. Not available with -t, -nav, -lm, -lp, -h or\n" \
+        "\t\t-atlas.\n" \
     "  -oa\n" \
         "\t\tOptimizes animations by analyzing animation channel data and\n" \
         "\t\tremoving any channels that contain default/identity values\n" \
         "\t\tand removing any duplicate contiguous keyframes, which are \n" \
         "\t\tcommon when exporting baked animation data.\n" \
+    "  -ac <tolerance>\n" \
+        "\t\tCompresses animations by removing keyframes that linear \n" \
+        "\t\tinterpolation reproduces within <tolerance> and storing the \n" \
+        "\t\tkeyframe values as 16-bit quantized values.\n" \
     "  -h <size> \"<node ids>\" <filename>\n" \
         "\t\tGenerates a single heightmap image using meshes from the \n" \
         "\t\tspecified nodes. \n" \
@@ -283,9 +397,58 @@ void EncoderArguments::printUsage() const
         "  (8 or 16-bit), which is a common headerless format supported by most \n" \
         "  terrain generation tools.\n" \
     "\n" \
+    "Terrain tile generation options:\n" \
+        "  -tiles <size>\tSplit a heightmap (PNG or RAW) into the tiles of a paged\n" \
+        "\t\tterrain, with <size> quads along the edges of a tile. <size>\n" \
+        "\t\tmust be a power of two. Normals are stored with the tiles\n" \
+        "\t\twhen the -w option is given. -s is required for RAW files.\n" \
+        "  -blend <file>\tStore the layer blend weights of an RGBA image (PNG)\n" \
+        "\t\tcovering the terrain with the tiles.\n" \
+        "  -nav <slope>\tWrite a bundle with the navigation mesh of a heightmap\n" \
+        "\t\t(PNG or RAW) for a terrain of the size given by -w, made of\n" \
+        "\t\tthe triangles no steeper than <slope> degrees. -s is required\n" \
+        "\t\tfor RAW files.\n" \
+    "\n" \
+    "Texture compression options:\n" \
+        "  -tc <target>\tTranscode a PNG image to a GPU ready KTX file with a\n" \
+        "\t\tfull mip chain, written to <name>.<target>.ktx. The\n" \
+        "\t\tengine loads it in place of <name>.png on GPUs that support\n" \
+        "\t\tthe target. <target> is etc1 (GL ES 2), etc2 (GL ES 3),\n" \
+        "\t\tbc (BC1/BC3, desktop) or raw (uncompressed, any GPU).\n" \
+        "\t\tMip levels are filtered in linear space.\n" \
+        "  -tlinear\tFilter the mip levels of -tc without converting from\n" \
+        "\t\tsRGB, for normal maps and other data textures.\n" \
+        "  -tpot\t\tResize the image of -tc to the nearest power of two.\n" \
+    "\n" \
+    "Resource archive generation options:\n" \
+        "  -pak\t\tPack the files of the input directory into a resource archive\n" \
+        "\t\t(.pak) that the engine mounts with FileSystem::mountArchive.\n" \
+        "\t\tFiles are stored with their path relative to the input\n" \
+        "\t\tdirectory, compressed with zlib when that makes them smaller.\n" \
+    "\n" \
+    "Batch encoding options:\n" \
+        "  -batch\tEncode the assets listed in the input file, a manifest with\n" \
+        "\t\tthe options, input and output of one encoder command per line\n" \
+        "\t\t(quote paths with spaces, lines starting with # are comments).\n" \
+        "\t\tAn asset is only encoded when its input file, options or the\n" \
+        "\t\tencoder changed since it was last encoded; otherwise its output\n" \
+        "\t\tis restored from the cache. Changed assets are encoded by -j\n" \
+        "\t\tencoder processes at a time. FBX entries should use -g:auto or\n" \
+        "\t\t-g:off, since they cannot prompt.\n" \
+        "  -cache <dir>\tDirectory to cache outputs in (default <manifest>.cache).\n" \
+    "\n" \
+    "Properties files:\n" \
+        "  Text properties files are compiled to a binary file with a string\n" \
+        "  table and pre-parsed numbers, written to <input filepath>.bin by\n" \
+        "  default. The engine recognizes binary properties files by their\n" \
+        "  content, so the binary file can replace the text file under its\n" \
+        "  original name.\n" \
+    "\n" \
     "TTF file options:\n" \
     "  -s <size>\tSize of the font.\n" \
     "  -p\t\tOutput font preview.\n" \
+    "  -sdf\t\tStore the glyphs as a signed distance field, so that a single\n" \
+    "\t\tfont can be drawn crisply at any size.\n" \
     "\n");
     exit(8);
 }
@@ -295,6 +458,11 @@ bool EncoderArguments::fontPreviewEnabled() const
     return _fontPreview;
 }
 
+bool EncoderArguments::fontDistanceFieldEnabled() const
+{
+    return _fontDistanceField;
+}
+
 bool EncoderArguments::textOutputEnabled() const
 {
     return _textOutput;
@@ -305,11 +473,101 @@ bool EncoderArguments::optimizeAnimationsEnabled() const
     return _optimizeAnimations;
 }
 
+bool EncoderArguments::compressAnimationsEnabled() const
+{
+    return _compressAnimations;
+}
+
+float EncoderArguments::getAnimationTolerance() const
+{
+    return _animationTolerance;
+}
+
 bool EncoderArguments::outputMaterialEnabled() const
 {
     return _outputMaterial;
 }
 
+bool EncoderArguments::bakeBvhEnabled() const
+{
+    return _bakeBvh;
+}
+
+unsigned int EncoderArguments::getVertexCacheSize() const
+{
+    return _vertexCacheSize;
+}
+
+bool EncoderArguments::quantizeVerticesEnabled() const
+{
+    return _quantizeVertices;
+}
+
+bool EncoderArguments::splitMeshesEnabled() const
+{
+    return _splitMeshes;
+}
+
+bool EncoderArguments::streamEnabled() const
+{
+    return _stream;
+}
+
+float EncoderArguments::getVertexAnimationFrameRate() const
+{
+    return _vertexAnimationFrameRate;
+}
+
+float EncoderArguments::getNavigationMeshSlope() const
+{
+    return _navigationMeshSlope;
+}
+
+unsigned int EncoderArguments::getLightmapSize() const
+{
+    return _lightmapSize;
+}
+
+unsigned int EncoderArguments::getAtlasSize() const
+{
+    return _atlasSize;
+}
+
+float EncoderArguments::getLightProbeSpacing() const
+{
+    return _lightProbeSpacing;
+}
+
+bool EncoderArguments::archiveGenerationEnabled() const
+{
+    return _archive;
+}
+
+bool EncoderArguments::batchEnabled() const
+{
+    return _batch;
+}
+
+std::string EncoderArguments::getCacheDirPath() const
+{
+    return _cacheDirPath.empty() ? _filePath + ".cache" : _cacheDirPath;
+}
+
+bool EncoderArguments::compressSectionsEnabled() const
+{
+    return _compressSections;
+}
+
+const std::string& EncoderArguments::getTextureCompression() const
+{
+    return _textureCompression;
+}
+
+unsigned int EncoderArguments::getTextureFlags() const
+{
+    return _textureFlags;
+}
+
 const char* EncoderArguments::getNodeId() const
 {
     if (_nodeId.length() == 0)
@@ -365,6 +623,12 @@ EncoderArguments::FileFormat EncoderArguments::getFileFormat() const
     {
         return FILEFORMAT_RAW;
     }
+    if (ext.compare("material") == 0 || ext.compare("scene") == 0 || ext.compare("physics") == 0 ||
+        ext.compare("form") == 0 || ext.compare("theme") == 0 || ext.compare("particle") == 0 ||
+        ext.compare("animation") == 0 || ext.compare("audio") == 0 || ext.compare("terrain") == 0)
+    {
+        return FILEFORMAT_PROPERTIES;
+    }
 
     return FILEFORMAT_UNKNOWN;
 }
@@ -378,6 +642,75 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
     }
     switch (str[1])
     {
+    case 'a':
+        if (str.compare("-ac") == 0)
+        {
+            // Compress animations within the given tolerance
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: missing tolerance argument for -ac.\n");
+                _parseError = true;
+                return;
+            }
+            _animationTolerance = (float)atof(options[*index].c_str());
+            if (_animationTolerance < 0.0f)
+            {
+                LOG(1, "Error: invalid tolerance argument for -ac.\n");
+                _parseError = true;
+                return;
+            }
+            _compressAnimations = true;
+        }
+        else if (str.compare("-atlas") == 0)
+        {
+            // Merge materials into texture atlases of the given size
+            (*index)++;
+            int size = *index < options.size() ? atoi(options[*index].c_str()) : 0;
+            if (size < 64 || size > 8192)
+            {
+                LOG(1, "Error: -atlas requires an atlas size between 64 and 8192.\n");
+                _parseError = true;
+                return;
+            }
+            _atlasSize = (unsigned int)size;
+        }
+        break;
+    case 'b':
+        if (str.compare("-bvh") == 0)
+        {
+            // bake mesh collision hierarchies
+            _bakeBvh = true;
+        }
+        else if (str.compare("-batch") == 0)
+        {
+            _batch = true;
+        }
+        else if (str.compare("-blend") == 0)
+        {
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: missing filename argument for -blend.\n");
+                _parseError = true;
+                return;
+            }
+            _tileBlendPath = getRealPath(options[*index]);
+        }
+        break;
+    case 'c':
+        if (str.compare("-cache") == 0)
+        {
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: missing directory argument for -cache.\n");
+                _parseError = true;
+                return;
+            }
+            _cacheDirPath = options[*index];
+        }
+        break;
     case 'g':
         if (str.compare("-groupAnimations:auto") == 0 || str.compare("-g:auto") == 0)
         {
@@ -402,7 +735,24 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
             _groupAnimationAnimationId.push_back(options[*index]);
         }
         break;
+    case 'j':
+        // Thread count
+        (*index)++;
+        if (*index >= options.size() || atoi(options[*index].c_str()) < 0)
+        {
+            LOG(1, "Error: -j requires a thread count.\n");
+            _parseError = true;
+            return;
+        }
+        _threadCount = (unsigned int)atoi(options[*index].c_str());
+        break;
     case 'i':
+        if (str == "-i16")
+        {
+            // Split meshes for 16-bit indices
+            _splitMeshes = true;
+            break;
+        }
         // Node ID
         (*index)++;
         if (*index < options.size())
@@ -423,6 +773,18 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
             // Optimize animations
             _optimizeAnimations = true;
         }
+        else if (str == "-om")
+        {
+            // Vertex cache size that meshes are optimized for
+            (*index)++;
+            if (*index >= options.size() || atoi(options[*index].c_str()) < 0)
+            {
+                LOG(1, "Error: -om requires a vertex cache size.\n");
+                _parseError = true;
+                return;
+            }
+            _vertexCacheSize = (unsigned int)atoi(options[*index].c_str());
+        }
         break;
     case 'h':
         {
@@ -490,6 +852,61 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
             }
         }
         break;
+    case 'l':
+        if (str.compare("-lod") == 0)
+        {
+            // Levels of detail as comma-separated ratio[:screenSize] pairs
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: missing levels of detail argument for -lod.\n");
+                _parseError = true;
+                return;
+            }
+            std::vector<std::string> levels;
+            splitString(options[*index].c_str(), &levels);
+            for (size_t i = 0, count = levels.size(); i < count; ++i)
+            {
+                MeshLodOption lod;
+                size_t colon = levels[i].find(':');
+                lod.ratio = (float)atof(levels[i].substr(0, colon).c_str());
+                lod.screenSize = colon == std::string::npos ? 0.5f * sqrt(lod.ratio) : (float)atof(levels[i].substr(colon + 1).c_str());
+                if (lod.ratio <= 0.0f || lod.ratio >= 1.0f || lod.screenSize <= 0.0f ||
+                    (!_meshLods.empty() && (lod.ratio >= _meshLods.back().ratio || lod.screenSize >= _meshLods.back().screenSize)))
+                {
+                    LOG(1, "Error: invalid level of detail '%s' for -lod; ratios and sizes must decrease.\n", levels[i].c_str());
+                    _parseError = true;
+                    return;
+                }
+                _meshLods.push_back(lod);
+            }
+        }
+        else if (str.compare("-lm") == 0)
+        {
+            // Bake lightmaps of the given size
+            (*index)++;
+            int size = *index < options.size() ? atoi(options[*index].c_str()) : 0;
+            if (size < 4 || size > 4096)
+            {
+                LOG(1, "Error: -lm requires a lightmap size between 4 and 4096.\n");
+                _parseError = true;
+                return;
+            }
+            _lightmapSize = (unsigned int)size;
+        }
+        else if (str.compare("-lp") == 0)
+        {
+            // Bake light probes with the given spacing
+            (*index)++;
+            if (*index >= options.size() || atof(options[*index].c_str()) <= 0.0)
+            {
+                LOG(1, "Error: -lp requires a probe spacing.\n");
+                _parseError = true;
+                return;
+            }
+            _lightProbeSpacing = (float)atof(options[*index].c_str());
+        }
+        break;
     case 'm':
         if (str.compare("-m") == 0)
         {
@@ -498,6 +915,19 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         }
         break;
     case 'n':
+        if (str == "-nav")
+        {
+            // Bake a navigation mesh of the triangles no steeper than the given slope
+            (*index)++;
+            if (*index >= options.size() || atof(options[*index].c_str()) <= 0.0)
+            {
+                LOG(1, "Error: -nav requires a slope in degrees.\n");
+                _parseError = true;
+                return;
+            }
+            _navigationMeshSlope = (float)atof(options[*index].c_str());
+            break;
+        }
         _normalMap = true;
         break;
     case 'w':
@@ -530,10 +960,25 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         }
         break;
     case 'p':
-        _fontPreview = true;
+        if (str.compare("-pak") == 0)
+        {
+            _archive = true;
+        }
+        else
+        {
+            _fontPreview = true;
+        }
         break;
     case 's':
-        if (_normalMap)
+        if (str.compare("-sdf") == 0)
+        {
+            _fontDistanceField = true;
+        }
+        else if (str.compare("-stream") == 0)
+        {
+            _stream = true;
+        }
+        else if (_normalMap || _tileSize > 0 || _navigationMeshSlope > 0.0f)
         {
             (*index)++;
             if (*index >= options.size())
@@ -584,10 +1029,47 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         }
         break;
     case 't':
-        if (str.compare("-t") == 0)
+        if (str.compare("-tiles") == 0)
+        {
+            (*index)++;
+            if (*index >= options.size())
+            {
+                LOG(1, "Error: missing tile size argument for -tiles.\n");
+                _parseError = true;
+                return;
+            }
+            int tileSize = atoi(options[*index].c_str());
+            if (tileSize < 2 || (tileSize & (tileSize - 1)) != 0)
+            {
+                LOG(1, "Error: tile size argument for -tiles must be a power of two.\n");
+                _parseError = true;
+                return;
+            }
+            _tileSize = (unsigned int)tileSize;
+        }
+        else if (str.compare("-t") == 0)
         {
             _textOutput = true;
         }
+        else if (str.compare("-tc") == 0)
+        {
+            (*index)++;
+            if (*index >= options.size() || !TextureEncoder::isTargetSupported(options[*index].c_str()))
+            {
+                LOG(1, "Error: -tc requires a target of etc1, etc2, bc or raw.\n");
+                _parseError = true;
+                return;
+            }
+            _textureCompression = options[*index];
+        }
+        else if (str.compare("-tlinear") == 0)
+        {
+            _textureFlags |= TextureEncoder::LINEAR;
+        }
+        else if (str.compare("-tpot") == 0)
+        {
+            _textureFlags |= TextureEncoder::POWER_OF_TWO;
+        }
         else if (str.compare("-tb") == 0)
         {
             if ((*index + 1) >= options.size())
@@ -605,6 +1087,25 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
         }
         break;
     case 'v':
+        if (str == "-vq")
+        {
+            // Quantize vertex attributes
+            _quantizeVertices = true;
+            break;
+        }
+        if (str == "-vat")
+        {
+            // Bake skinned animations into vertex animations at the given frame rate
+            (*index)++;
+            if (*index >= options.size() || atof(options[*index].c_str()) <= 0.0)
+            {
+                LOG(1, "Error: -vat requires a frame rate.\n");
+                _parseError = true;
+                return;
+            }
+            _vertexAnimationFrameRate = (float)atof(options[*index].c_str());
+            break;
+        }
         (*index)++;
         if (*index < options.size())
         {
@@ -615,6 +1116,13 @@ void EncoderArguments::readOption(const std::vector<std::string>& options, size_
                 __logVerbosity = 4;
         }
         break;
+    case 'z':
+        if (str == "-z")
+        {
+            // Compress the vertex, index and animation key data
+            _compressSections = true;
+        }
+        break;
     default:
         break;
     }
@@ -632,7 +1140,7 @@ void EncoderArguments::setOutputfilePath(const std::string& outputPath)
     if (outputPath.size() > 0 && outputPath[0] != '\0')
     {
         std::string realPath = getRealPath(outputPath);
-        if (endsWith(realPath.c_str(), ext.c_str()))
+        if (endsWith(realPath.c_str(), ext.c_str()) || (!_archive && getFileFormat() == FILEFORMAT_PROPERTIES))
         {
             _fileOutputPath.assign(realPath);
         }
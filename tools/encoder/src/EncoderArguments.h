@@ -22,7 +22,8 @@ public:
         FILEFORMAT_TTF,
         FILEFORMAT_GPB,
         FILEFORMAT_PNG,
-        FILEFORMAT_RAW
+        FILEFORMAT_RAW,
+        FILEFORMAT_PROPERTIES
     };
 
     struct HeightmapOption
@@ -34,6 +35,12 @@ public:
         int height;
     };
 
+    struct MeshLodOption
+    {
+        float ratio;
+        float screenSize;
+    };
+
     struct NormalMapOption
     {
         std::string inputFile;
@@ -133,6 +140,52 @@ public:
      * This option is only applicable for normal map generation.
      */
     const Vector3& getHeightmapWorldSize() const;
+
+    /**
+     * Returns the number of quads along the edges of a terrain tile.
+     *
+     * @return The tile size, or 0 if terrain tile generation is turned off.
+     */
+    unsigned int getTileSize() const;
+
+    /**
+     * Returns the path of the blend map stored with terrain tiles.
+     *
+     * This option is only applicable for terrain tile generation.
+     */
+    const std::string& getTileBlendPath() const;
+
+    /**
+     * Returns true if the input directory is packed into a resource archive.
+     */
+    bool archiveGenerationEnabled() const;
+
+    /**
+     * Returns true if the input file is a manifest of assets to encode in a batch.
+     */
+    bool batchEnabled() const;
+
+    /**
+     * Returns the directory that batch encoding caches outputs in.
+     *
+     * Defaults to the manifest path followed by ".cache".
+     */
+    std::string getCacheDirPath() const;
+
+    /**
+     * Returns true if the vertex, index and animation key data of bundles is compressed.
+     */
+    bool compressSectionsEnabled() const;
+
+    /**
+     * Returns the target of texture compression, or an empty string if a PNG image is not transcoded.
+     */
+    const std::string& getTextureCompression() const;
+
+    /**
+     * Returns the TextureEncoder::Flags to transcode a PNG image with.
+     */
+    unsigned int getTextureFlags() const;
     
     /**
      * Returns true if an error occurred while parsing the command line arguments.
@@ -152,9 +205,60 @@ public:
     void printUsage() const;
 
     bool fontPreviewEnabled() const;
+    bool fontDistanceFieldEnabled() const;
     bool textOutputEnabled() const;
     bool optimizeAnimationsEnabled() const;
+    bool compressAnimationsEnabled() const;
+    float getAnimationTolerance() const;
     bool outputMaterialEnabled() const;
+    bool bakeBvhEnabled() const;
+    unsigned int getVertexCacheSize() const;
+    bool quantizeVerticesEnabled() const;
+
+    /**
+     * Returns true if meshes with more vertices than 16-bit indices can address are split into smaller meshes.
+     */
+    bool splitMeshesEnabled() const;
+
+    /**
+     * Returns true if the meshes and animation channels of an FBX file are written to a spool file as they are loaded.
+     */
+    bool streamEnabled() const;
+
+    /**
+     * Returns the frame rate the animations of skinned meshes are baked into vertex animations at, or 0 to not bake them.
+     */
+    float getVertexAnimationFrameRate() const;
+
+    /**
+     * Returns the steepest walkable slope of the navigation mesh, in degrees, or 0 to not bake one.
+     */
+    float getNavigationMeshSlope() const;
+
+    /**
+     * Returns the width and height of the lightmaps baked for static nodes, in texels, or 0 to not bake them.
+     */
+    unsigned int getLightmapSize() const;
+
+    /**
+     * Returns the largest width and height of the texture atlases that compatible materials are merged into, in texels, or 0 to not merge them.
+     */
+    unsigned int getAtlasSize() const;
+
+    /**
+     * Returns the spacing of the grid of light probes baked for dynamic objects, or 0 to not bake them.
+     */
+    float getLightProbeSpacing() const;
+
+    /**
+     * Returns the number of threads the encoder works with, or 0 for one per processor.
+     */
+    unsigned int getThreadCount() const;
+
+    /**
+     * Returns the levels of detail to generate for each mesh, from the most to the least detailed.
+     */
+    const std::vector<MeshLodOption>& getMeshLodOptions() const;
 
     const char* getNodeId() const;
     unsigned int getFontSize() const;
@@ -198,12 +302,39 @@ private:
     Vector3 _heightmapWorldSize;
     int _heightmapResolution[2];
 
+    unsigned int _tileSize;
+    std::string _tileBlendPath;
+
+    bool _archive;
+
+    bool _batch;
+    std::string _cacheDirPath;
+
+    std::string _textureCompression;
+    unsigned int _textureFlags;
+    bool _compressSections;
+
     bool _parseError;
     bool _fontPreview;
+    bool _fontDistanceField;
     bool _textOutput;
     bool _optimizeAnimations;
+    bool _compressAnimations;
+    float _animationTolerance;
     AnimationGroupOption _animationGrouping;
     bool _outputMaterial;
+    bool _bakeBvh;
+    unsigned int _vertexCacheSize;
+    bool _quantizeVertices;
+    bool _splitMeshes;
+    bool _stream;
+    float _vertexAnimationFrameRate;
+    float _navigationMeshSlope;
+    unsigned int _lightmapSize;
+    unsigned int _atlasSize;
+    float _lightProbeSpacing;
+    std::vector<MeshLodOption> _meshLods;
+    unsigned int _threadCount;
 
     std::vector<std::string> _groupAnimationNodeId;
     std::vector<std::string> _groupAnimationAnimationId;
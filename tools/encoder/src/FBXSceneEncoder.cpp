@@ -59,10 +59,27 @@ void FBXSceneEncoder::write(const string& filepath, const EncoderArguments& argu
         generateTangentsAndBinormals(fbxScene->GetRootNode(), arguments);
     }
 
+    if (arguments.streamEnabled() && _gamePlayFile.beginStreaming())
+    {
+        LOG(1, "Streaming meshes and animation channels to a spool file.\n");
+    }
+
     print("Loading Scene.");
     loadScene(fbxScene);
     print("Load materials");
     loadMaterials(fbxScene);
+    if (arguments.getAtlasSize() > 0)
+    {
+        if (arguments.outputMaterialEnabled())
+        {
+            print("Merging materials.");
+            mergeMaterials(fbxScene, arguments);
+        }
+        else
+        {
+            LOG(1, "Warning: -atlas requires -m; the materials are not merged.\n");
+        }
+    }
     print("Loading animations.");
     loadAnimations(fbxScene, arguments);
     sdkManager->Destroy();
@@ -403,6 +420,11 @@ void FBXSceneEncoder::loadAnimationChannels(FbxAnimLayer* animLayer, FbxNode* fb
         }
     }
 
+    if (_gamePlayFile.isStreaming())
+    {
+        _gamePlayFile.streamAnimationChannels(animation, channelStart);
+    }
+
     if (_groupAnimation != animation)
     {
         _gamePlayFile.addAnimation(animation);
@@ -898,6 +920,10 @@ void FBXSceneEncoder::loadModel(FbxNode* fbxNode, Node* node)
         {
             node->resetTransformMatrix();
         }
+        if (_gamePlayFile.isStreaming())
+        {
+            _gamePlayFile.streamMesh(mesh);
+        }
     }
 }
 
@@ -1126,6 +1152,29 @@ void FBXSceneEncoder::loadMaterialUniforms(FbxSurfaceMaterial* fbxMaterial, Mate
     }
 }
 
+void FBXSceneEncoder::mergeMaterials(FbxScene* fbxScene, const EncoderArguments& arguments)
+{
+    MaterialMerger merger(arguments.getAtlasSize());
+    if (FbxNode* rootNode = fbxScene->GetRootNode())
+    {
+        addMergedNodes(rootNode, merger);
+    }
+    merger.merge(arguments.getOutputFilePath(), arguments.getFilePath(), _materials);
+}
+
+void FBXSceneEncoder::addMergedNodes(FbxNode* fbxNode, MaterialMerger& merger)
+{
+    if (Node* node = findNode(fbxNode))
+    {
+        merger.addNode(node);
+    }
+    const int childCount = fbxNode->GetChildCount();
+    for (int i = 0; i < childCount; ++i)
+    {
+        addMergedNodes(fbxNode->GetChild(i), merger);
+    }
+}
+
 Material* FBXSceneEncoder::createMaterial(const string& name, FbxSurfaceMaterial* fbxMaterial, Node* node)
 {
     assert(fbxMaterial);
@@ -31,6 +31,7 @@
 #include "Transform.h"
 #include "GPBFile.h"
 #include "EncoderArguments.h"
+#include "MaterialMerger.h"
 
 using namespace gameplay;
 
@@ -149,6 +150,16 @@ private:
 
     void loadMaterialUniforms(FbxSurfaceMaterial* fbxMaterial, Material* material);
 
+    /**
+     * Merges the materials that differ only by their textures into materials drawing from texture atlases.
+     */
+    void mergeMaterials(FbxScene* fbxScene, const EncoderArguments& arguments);
+
+    /**
+     * Adds the given node and its children to a material merger, in scene order.
+     */
+    void addMergedNodes(FbxNode* fbxNode, MaterialMerger& merger);
+
     /**
      * Creates a material from an FbxSurfaceMaterial.
      * 
@@ -1,9 +1,18 @@
 #include "Base.h"
 #include "FileIO.h"
+#include <zlib.h>
+
+// The largest amount of data compressed into one block of a section.
+#define SECTION_BLOCK_SIZE (64 * 1024)
+
+// Sections smaller than this are not worth compressing.
+#define SECTION_MIN_SIZE 1024
 
 namespace gameplay
 {
 
+static bool __compressSections = false;
+
 // Writing out a binary file //
 
 void write(unsigned char value, FILE* file)
@@ -71,6 +80,72 @@ void writeZero(FILE* file)
     write((unsigned int)0, file);
 }
 
+void setSectionCompression(bool enabled)
+{
+    __compressSections = enabled;
+}
+
+FILE* beginSection(FILE* file)
+{
+    // Compressed sections are written to a temporary file first, since their stored size comes first.
+    FILE* section = __compressSections ? tmpfile() : NULL;
+    if (section == NULL)
+    {
+        writeZero(file);
+        return file;
+    }
+    return section;
+}
+
+void endSection(FILE* section, FILE* file)
+{
+    if (section == file)
+        return;
+
+    std::vector<unsigned char> data;
+    long size = ftell(section);
+    if (size > 0)
+    {
+        data.resize(size);
+        rewind(section);
+        size_t r = fread(&data[0], 1, size, section);
+        assert(r == (size_t)size);
+    }
+    fclose(section);
+
+    // Keep the compressed data only if it is worth decompressing at load time.
+    std::vector<unsigned char> blocks;
+    if (data.size() >= SECTION_MIN_SIZE)
+    {
+        for (size_t offset = 0; offset < data.size(); offset += SECTION_BLOCK_SIZE)
+        {
+            uLong blockSize = (uLong)std::min(data.size() - offset, (size_t)SECTION_BLOCK_SIZE);
+            uLongf packedSize = compressBound(blockSize);
+            size_t header = blocks.size();
+            blocks.resize(header + 8 + packedSize);
+            if (compress2(&blocks[header + 8], &packedSize, &data[offset], blockSize, Z_BEST_COMPRESSION) != Z_OK)
+            {
+                blocks.clear();
+                break;
+            }
+            unsigned int sizes[2] = { (unsigned int)blockSize, (unsigned int)packedSize };
+            memcpy(&blocks[header], sizes, sizeof(sizes));
+            blocks.resize(header + 8 + packedSize);
+        }
+    }
+    if (blocks.empty() || blocks.size() + 4 >= data.size() - data.size() / 8)
+    {
+        writeZero(file);
+        if (!data.empty())
+            fwrite(&data[0], 1, data.size(), file);
+        return;
+    }
+
+    write((unsigned int)(blocks.size() + 4), file);
+    write((unsigned int)data.size(), file);
+    fwrite(&blocks[0], 1, blocks.size(), file);
+}
+
 // Writing to a text file //
 
 void fprintfElement(FILE* file, const char* elementName, const float values[], int length)
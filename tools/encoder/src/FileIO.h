@@ -76,6 +76,33 @@ void write(const std::string& str, FILE* file);
 
 void writeZero(FILE* file);
 
+/**
+ * Enables or disables the compression of the sections written with beginSection and endSection.
+ */
+void setSectionCompression(bool enabled);
+
+/**
+ * Starts a section of binary data that may be stored compressed, such as vertex data.
+ *
+ * @param file The binary file stream.
+ *
+ * @return The stream to write the data of the section to, to be passed to endSection.
+ */
+FILE* beginSection(FILE* file);
+
+/**
+ * Ends a section, writing the size it is stored with, then its data.
+ *
+ * When section compression is enabled and it pays off, the data is stored as its size
+ * followed by zlib blocks of up to 64 KB, each preceded by its decompressed and compressed
+ * sizes so that it can be decompressed on its own. Otherwise the stored size is 0 and the
+ * data follows as is. The engine reads sections with Bundle::readCompressedSection.
+ *
+ * @param section The stream returned by beginSection.
+ * @param file The binary file stream.
+ */
+void endSection(FILE* section, FILE* file);
+
 /**
  * Writes the length of the list and writes each element value to the binary file stream.
  * 
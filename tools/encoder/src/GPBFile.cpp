@@ -4,6 +4,14 @@
 #include "StringUtil.h"
 #include "EncoderArguments.h"
 #include "Heightmap.h"
+#include "MeshBvh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshLod.h"
+#include "VertexAnimation.h"
+#include "NavigationMesh.h"
+#include "LightmapBaker.h"
+#include "ThreadPool.h"
 
 #define EPSILON 1.2e-7f;
 
@@ -41,15 +49,108 @@ static Node* getCommonNodeAncestor(const std::vector<Node*>& nodes);
  */
 static void getNodeAncestors(Node* node, std::list<Node*>& ancestors);
 
+/**
+ * The data shared by the ThreadPool tasks that process the meshes in GPBFile::adjust.
+ * Each task only writes to the mesh and the levels of detail at its own index.
+ */
+struct MeshTaskData
+{
+    std::vector<Mesh*> meshes;
+    unsigned int vertexCacheSize;
+    std::vector<EncoderArguments::MeshLodOption> lodOptions;
+    std::vector<std::vector<Mesh*> > lods;
+};
+
+/**
+ * The data shared by the ThreadPool tasks that compress animation channels.
+ */
+struct ChannelTaskData
+{
+    std::vector<AnimationChannel*> channels;
+    float tolerance;
+};
+
+static void optimizeMeshTask(unsigned int index, void* arg)
+{
+    MeshTaskData* data = (MeshTaskData*)arg;
+    MeshOptimizer::optimize(data->meshes[index], data->vertexCacheSize);
+}
+
+static void quantizeMeshTask(unsigned int index, void* arg)
+{
+    MeshTaskData* data = (MeshTaskData*)arg;
+    data->meshes[index]->quantizeVertices();
+}
+
+static void buildBvhTask(unsigned int index, void* arg)
+{
+    std::vector<MeshBvh*>* bvhs = (std::vector<MeshBvh*>*)arg;
+    (*bvhs)[index]->build();
+}
+
+static void bakeVertexAnimationTask(unsigned int index, void* arg)
+{
+    std::vector<VertexAnimation*>* animations = (std::vector<VertexAnimation*>*)arg;
+    (*animations)[index]->bake();
+}
+
+/**
+ * Generates the simplified levels of detail of a mesh, optimized for the vertex cache.
+ */
+static void simplifyMesh(Mesh* mesh, const std::vector<EncoderArguments::MeshLodOption>& lodOptions, unsigned int vertexCacheSize, std::vector<Mesh*>& lods)
+{
+    // Levels are found by the id of their mesh.
+    if (mesh->getId().length() == 0)
+        return;
+
+    unsigned int triangleCount = MeshSimplifier::getTriangleCount(mesh);
+    for (size_t i = 0, count = lodOptions.size(); i < count; ++i)
+    {
+        Mesh* lod = MeshSimplifier::simplify(mesh, lodOptions[i].ratio);
+        if (lod == NULL)
+            break;
+        unsigned int lodTriangleCount = MeshSimplifier::getTriangleCount(lod);
+        if (lodTriangleCount >= triangleCount)
+        {
+            // The remaining collapses are blocked by locked vertices; further levels would be no simpler.
+            delete lod;
+            break;
+        }
+        triangleCount = lodTriangleCount;
+        if (vertexCacheSize > 0)
+        {
+            MeshOptimizer::optimize(lod, vertexCacheSize);
+        }
+        lod->model = mesh->model;
+        lods.push_back(lod);
+    }
+}
+
+static void simplifyMeshTask(unsigned int index, void* arg)
+{
+    MeshTaskData* data = (MeshTaskData*)arg;
+    simplifyMesh(data->meshes[index], data->lodOptions, data->vertexCacheSize, data->lods[index]);
+}
+
+static void compressChannelTask(unsigned int index, void* arg)
+{
+    ChannelTaskData* data = (ChannelTaskData*)arg;
+    data->channels[index]->compress(data->tolerance);
+}
+
 
 GPBFile::GPBFile(void)
-    : _file(NULL), _animationsAdded(false)
+    : _file(NULL), _animationsAdded(false), _spool(NULL), _skinJointsFound(false)
 {
     __instance = this;
 }
 
 GPBFile::~GPBFile(void)
 {
+    if (_spool)
+    {
+        fclose(_spool);
+    }
 }
 
 GPBFile* GPBFile::getInstance()
@@ -85,10 +186,12 @@ bool GPBFile::saveBinary(const std::string& filepath)
 
     // TODO: Check for errors on all file writing.
 
+    setSectionCompression(EncoderArguments::getInstance()->compressSectionsEnabled());
+
     // write refs
     _refTable.writeBinary(_file);
 
-    // meshes
+    // meshes; spooled objects copy their data from the spool file
     write((unsigned int)_geometry.size(), _file);
     for (std::list<Mesh*>::const_iterator i = _geometry.begin(); i != _geometry.end(); ++i)
     {
@@ -302,6 +405,121 @@ unsigned int GPBFile::getLightCount() const
     return (unsigned int)_lights.size();
 }
 
+bool GPBFile::beginStreaming()
+{
+    EncoderArguments* arguments = EncoderArguments::getInstance();
+    if (arguments->textOutputEnabled() || arguments->getNavigationMeshSlope() > 0.0f || arguments->getLightmapSize() > 0 ||
+        arguments->getLightProbeSpacing() > 0.0f || !arguments->getHeightmapOptions().empty() || arguments->getAtlasSize() > 0)
+    {
+        LOG(1, "Warning: -stream is ignored with -t, -nav, -lm, -lp, -h and -atlas, which need the whole scene in memory.\n");
+        return false;
+    }
+    _spool = tmpfile();
+    if (!_spool)
+    {
+        LOG(1, "Warning: Failed to create the spool file; the scene is kept in memory.\n");
+        return false;
+    }
+    return true;
+}
+
+bool GPBFile::isStreaming() const
+{
+    return _spool != NULL;
+}
+
+void GPBFile::streamMesh(Mesh* mesh)
+{
+    assert(_spool);
+    if (mesh->isSpooled())
+        return;
+    for (size_t i = 0, count = mesh->getVertexElementCount(); i < count; ++i)
+    {
+        if (mesh->getVertexElement((unsigned int)i).usage == BLENDWEIGHTS)
+            return;
+    }
+
+    // The same steps as adjust(), in the same order, on this mesh alone.
+    EncoderArguments* arguments = EncoderArguments::getInstance();
+    unsigned int vertexCacheSize = arguments->getVertexCacheSize();
+    if (vertexCacheSize > 0)
+    {
+        MeshOptimizer::optimize(mesh, vertexCacheSize);
+    }
+
+    std::vector<Mesh*> meshes(1, mesh);
+    if (arguments->splitMeshesEnabled() && mesh->getVertexCount() > 65536)
+    {
+        std::vector<Mesh*> splitMeshes = mesh->split(65536);
+        if (!splitMeshes.empty())
+        {
+            LOG(1, "Splitting mesh '%s' into %u meshes.\n", mesh->getId().c_str(), (unsigned int)splitMeshes.size() + 1);
+        }
+        for (size_t i = 0, count = splitMeshes.size(); i < count; ++i)
+        {
+            char suffix[32];
+            sprintf(suffix, "_split%u", (unsigned int)i + 1);
+            splitMeshes[i]->setId(mesh->getId() + suffix);
+            addMesh(splitMeshes[i]);
+            _streamedSplits.push_back(std::make_pair(mesh, splitMeshes[i]));
+            meshes.push_back(splitMeshes[i]);
+        }
+    }
+
+    const std::vector<EncoderArguments::MeshLodOption>& lodOptions = arguments->getMeshLodOptions();
+    for (size_t i = 0, count = meshes.size(); i < count; ++i)
+    {
+        Mesh* streamed = meshes[i];
+        streamed->computeBounds();
+        if (arguments->quantizeVerticesEnabled())
+        {
+            streamed->quantizeVertices();
+        }
+        if (arguments->bakeBvhEnabled() && MeshBvh::isSupported(streamed))
+        {
+            LOG(2, "Baking bounding volume hierarchy for mesh: %s\n", streamed->getId().c_str());
+            MeshBvh* bvh = new MeshBvh(streamed);
+            addToRefTable(bvh);
+            add(bvh);
+            bvh->build();
+            bvh->spool(_spool);
+        }
+        if (!lodOptions.empty())
+        {
+            std::vector<Mesh*> lods;
+            simplifyMesh(streamed, lodOptions, vertexCacheSize, lods);
+            addLevelsOfDetail(streamed, lods);
+            for (size_t j = 0, lodCount = lods.size(); j < lodCount; ++j)
+            {
+                lods[j]->spool(_spool);
+            }
+        }
+        streamed->spool(_spool);
+    }
+}
+
+void GPBFile::streamAnimationChannels(Animation* animation, unsigned int first)
+{
+    assert(_spool);
+    EncoderArguments* arguments = EncoderArguments::getInstance();
+    if (arguments->optimizeAnimationsEnabled())
+    {
+        optimizeAnimationChannels(animation, first);
+    }
+
+    for (unsigned int i = first, count = animation->getAnimationChannelCount(); i < count; ++i)
+    {
+        AnimationChannel* channel = animation->getAnimationChannel(i);
+        if (isSkinJoint(channel->getTargetId()))
+            continue;
+        if (arguments->compressAnimationsEnabled())
+        {
+            channel->compress(arguments->getAnimationTolerance());
+        }
+        channel->spool(_spool);
+    }
+}
+
 void GPBFile::adjust()
 {
     // calculate the ambient color for each scene
@@ -326,6 +544,12 @@ void GPBFile::adjust()
         optimizeAnimations();
     }
 
+    if (EncoderArguments::getInstance()->compressAnimationsEnabled())
+    {
+        LOG(1, "Compressing animations.\n");
+        compressAnimations(EncoderArguments::getInstance()->getAnimationTolerance());
+    }
+
     // TODO:
     // remove ambient _lights
     // for each node
@@ -339,6 +563,146 @@ void GPBFile::adjust()
     //   Blender will output a simple translation animation to 3 separate animations with the same key times but targeting X, Y and Z.
     //   This can be merged into one animation. Same for scale animations.
 
+    // The meshes are processed in parallel, each task on its own mesh. Anything that
+    // adds to the file is done afterwards in mesh order, so the output is the same
+    // for any number of threads. Streamed meshes were processed as they were loaded.
+    MeshTaskData meshData;
+    for (std::list<Mesh*>::const_iterator i = _geometry.begin(); i != _geometry.end(); ++i)
+    {
+        if (!(*i)->isSpooled())
+            meshData.meshes.push_back(*i);
+    }
+    meshData.vertexCacheSize = EncoderArguments::getInstance()->getVertexCacheSize();
+    meshData.lodOptions = EncoderArguments::getInstance()->getMeshLodOptions();
+    unsigned int meshCount = (unsigned int)meshData.meshes.size();
+
+    // Reorder the triangles and vertices of meshes for the vertex cache, before anything refers to them by index
+    if (meshData.vertexCacheSize > 0)
+    {
+        LOG(1, "Optimizing meshes.\n");
+        ThreadPool::run(meshCount, &optimizeMeshTask, &meshData);
+    }
+
+    // Bake the navigation mesh from the full precision triangles of the static meshes, in world space
+    float navigationMeshSlope = EncoderArguments::getInstance()->getNavigationMeshSlope();
+    if (navigationMeshSlope > 0.0f)
+    {
+        LOG(1, "Baking navigation mesh.\n");
+        NavigationMesh* navigationMesh = new NavigationMesh(navigationMeshSlope);
+        for (std::list<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+        {
+            Model* model = (*i)->getModel();
+            if (model && model->getMesh() && model->getSkin() == NULL)
+                navigationMesh->addMesh(model->getMesh(), (*i)->getWorldMatrix());
+        }
+        navigationMesh->build();
+        LOG(1, "Navigation mesh: %u walkable triangles.\n", navigationMesh->getTriangleCount());
+        addToRefTable(navigationMesh);
+        add(navigationMesh);
+    }
+
+    // Split meshes for 16-bit indices, before anything is computed per mesh
+    if (EncoderArguments::getInstance()->splitMeshesEnabled())
+    {
+        splitMeshes(&meshData.meshes);
+        meshCount = (unsigned int)meshData.meshes.size();
+    }
+
+    // Bake the animations of skinned meshes for crowds, from the full precision vertices
+    float vertexAnimationFrameRate = EncoderArguments::getInstance()->getVertexAnimationFrameRate();
+    if (vertexAnimationFrameRate > 0.0f)
+    {
+        std::vector<VertexAnimation*> animations;
+        for (unsigned int i = 0; i < meshCount; ++i)
+        {
+            Mesh* mesh = meshData.meshes[i];
+            if (VertexAnimation::isSupported(mesh))
+            {
+                VertexAnimation* animation = new VertexAnimation(mesh, vertexAnimationFrameRate);
+                addToRefTable(animation);
+                add(animation);
+                animations.push_back(animation);
+            }
+        }
+        LOG(1, "Baking vertex animations.\n");
+        ThreadPool::run((unsigned int)animations.size(), &bakeVertexAnimationTask, &animations);
+    }
+
+    // Bake lightmaps and light probes from the full precision triangles of the static meshes, in world space
+    unsigned int lightmapSize = EncoderArguments::getInstance()->getLightmapSize();
+    float lightProbeSpacing = EncoderArguments::getInstance()->getLightProbeSpacing();
+    if (lightmapSize > 0 || lightProbeSpacing > 0.0f)
+    {
+        Scene* scene = NULL;
+        for (std::list<Object*>::iterator i = _objects.begin(); i != _objects.end() && scene == NULL; ++i)
+        {
+            if ((*i)->getTypeId() == Object::SCENE_ID)
+                scene = dynamic_cast<Scene*>(*i);
+        }
+
+        LightmapBaker baker;
+        if (scene)
+            baker.setAmbientColor(scene->getAmbientColor());
+        for (std::list<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+        {
+            baker.addNode(*i);
+        }
+        if (lightmapSize > 0)
+        {
+            LOG(1, "Baking lightmaps.\n");
+            unsigned int count = baker.bakeLightmaps(lightmapSize, EncoderArguments::getInstance()->getOutputFilePath());
+            LOG(1, "Lightmaps: %u.\n", count);
+        }
+        if (lightProbeSpacing > 0.0f && scene)
+        {
+            LOG(1, "Baking light probes.\n");
+            unsigned int count = baker.bakeLightProbes(lightProbeSpacing, scene);
+            LOG(1, "Light probes: %u.\n", count);
+        }
+        else if (lightProbeSpacing > 0.0f)
+        {
+            LOG(1, "Warning: No scene to add light probes to.\n");
+        }
+    }
+
+    // Quantize vertex attributes; positions are snapped to their decoded values before the hierarchies are baked
+    if (EncoderArguments::getInstance()->quantizeVerticesEnabled())
+    {
+        LOG(1, "Quantizing vertices.\n");
+        ThreadPool::run(meshCount, &quantizeMeshTask, &meshData);
+    }
+
+    // Bake the collision hierarchies of meshes
+    if (EncoderArguments::getInstance()->bakeBvhEnabled())
+    {
+        std::vector<MeshBvh*> bvhs;
+        for (unsigned int i = 0; i < meshCount; ++i)
+        {
+            Mesh* mesh = meshData.meshes[i];
+            if (MeshBvh::isSupported(mesh))
+            {
+                LOG(2, "Baking bounding volume hierarchy for mesh: %s\n", mesh->getId().c_str());
+                MeshBvh* bvh = new MeshBvh(mesh);
+                addToRefTable(bvh);
+                add(bvh);
+                bvhs.push_back(bvh);
+            }
+        }
+        ThreadPool::run((unsigned int)bvhs.size(), &buildBvhTask, &bvhs);
+    }
+
+    // Generate simplified levels of detail; they share the vertex format and position decode of their mesh
+    if (!meshData.lodOptions.empty())
+    {
+        LOG(1, "Generating mesh levels of detail.\n");
+        meshData.lods.resize(meshCount);
+        ThreadPool::run(meshCount, &simplifyMeshTask, &meshData);
+        for (unsigned int i = 0; i < meshCount; ++i)
+        {
+            addLevelsOfDetail(meshData.meshes[i], meshData.lods[i]);
+        }
+    }
+
     // Generate heightmaps
     const std::vector<EncoderArguments::HeightmapOption>& heightmaps = EncoderArguments::getInstance()->getHeightmapOptions();
     for (unsigned int i = 0, count = heightmaps.size(); i < count; ++i)
@@ -391,45 +755,198 @@ void GPBFile::computeBounds(Node* node)
     assert(node);
     if (Model* model = node->getModel())
     {
-        if (Mesh* mesh = model->getMesh())
+        Mesh* mesh = model->getMesh();
+        if (mesh && !mesh->isSpooled())
         {
             mesh->computeBounds();
         }
     }
 }
 
+void GPBFile::splitMeshes(std::vector<Mesh*>* meshes)
+{
+    // The meshes streamed were split as they were loaded
+    for (size_t i = 0, count = _streamedSplits.size(); i < count; ++i)
+    {
+        Mesh* mesh = _streamedSplits[i].first;
+        Mesh* splitMesh = _streamedSplits[i].second;
+        std::vector<Node*> nodes;
+        getMeshNodes(mesh, nodes);
+        addSplitNodes(nodes, splitMesh, splitMesh->getId().substr(mesh->getId().length()));
+    }
+
+    for (size_t i = 0, meshCount = meshes->size(); i < meshCount; ++i)
+    {
+        Mesh* mesh = (*meshes)[i];
+        if (mesh->getVertexCount() <= 65536)
+            continue;
+
+        std::vector<Node*> nodes;
+        bool skinned = getMeshNodes(mesh, nodes);
+        if (skinned)
+        {
+            LOG(1, "Warning: skinned mesh '%s' has more than 65536 vertices and is not split.\n", mesh->getId().c_str());
+            continue;
+        }
+
+        std::vector<Mesh*> splitMeshes = mesh->split(65536);
+        if (splitMeshes.empty())
+            continue;
+        LOG(1, "Splitting mesh '%s' into %u meshes.\n", mesh->getId().c_str(), (unsigned int)splitMeshes.size() + 1);
+        mesh->computeBounds();
+        for (size_t j = 0, count = splitMeshes.size(); j < count; ++j)
+        {
+            char suffix[32];
+            sprintf(suffix, "_split%u", (unsigned int)j + 1);
+            Mesh* splitMesh = splitMeshes[j];
+            splitMesh->setId(mesh->getId() + suffix);
+            addMesh(splitMesh);
+            meshes->push_back(splitMesh);
+            addSplitNodes(nodes, splitMesh, suffix);
+            splitMesh->computeBounds();
+        }
+    }
+}
+
+bool GPBFile::getMeshNodes(const Mesh* mesh, std::vector<Node*>& nodes) const
+{
+    bool skinned = false;
+    for (std::list<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+    {
+        Model* model = (*i)->getModel();
+        if (model && model->getMesh() == mesh)
+        {
+            nodes.push_back(*i);
+            skinned = skinned || model->getSkin() != NULL;
+        }
+    }
+    return skinned;
+}
+
+void GPBFile::addSplitNodes(const std::vector<Node*>& nodes, Mesh* splitMesh, const std::string& suffix)
+{
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        Model* model = new Model();
+        model->setMesh(splitMesh);
+        model->copyMaterials(nodes[i]->getModel());
+        Node* node = new Node();
+        node->setId(nodes[i]->getId() + suffix);
+        node->setModel(model);
+        nodes[i]->addChild(node);
+        addNode(node);
+    }
+}
+
+void GPBFile::addLevelsOfDetail(Mesh* mesh, const std::vector<Mesh*>& lods)
+{
+    if (lods.empty())
+        return;
+
+    const std::vector<EncoderArguments::MeshLodOption>& lodOptions = EncoderArguments::getInstance()->getMeshLodOptions();
+    MeshLod* meshLod = new MeshLod(mesh);
+    for (size_t i = 0, count = lods.size(); i < count; ++i)
+    {
+        char id[32];
+        sprintf(id, "_lod%u", (unsigned int)i + 1);
+        lods[i]->setId(mesh->getId() + id);
+        addMesh(lods[i]);
+        meshLod->addLevel(lods[i], lodOptions[i].screenSize);
+    }
+    addToRefTable(meshLod);
+    add(meshLod);
+}
+
 void GPBFile::optimizeAnimations()
 {
+    ThreadPool::run(_animations.getAnimationCount(), &optimizeAnimationTask, this);
+}
+
+void GPBFile::optimizeAnimationTask(unsigned int index, void* arg)
+{
+    GPBFile* file = (GPBFile*)arg;
+    Animation* animation = file->_animations.getAnimation(index);
+    assert(animation);
+    file->optimizeAnimation(animation);
+}
+
+void GPBFile::optimizeAnimation(Animation* animation)
+{
+    const int channelCount = animation->getAnimationChannelCount();
+
+    LOG(2, "Optimizing %d channel(s) in animation '%s'.\n", channelCount, animation->getId().c_str());
+
+    optimizeAnimationChannels(animation, 0);
+}
+
+void GPBFile::optimizeAnimationChannels(Animation* animation, unsigned int first)
+{
+    const int channelCount = animation->getAnimationChannelCount();
+
+    // loop backwards because we will be adding and removing channels
+    for (int channelIndex = channelCount -1; channelIndex >= (int)first; --channelIndex)
+    {
+        AnimationChannel* channel = animation->getAnimationChannel(channelIndex);
+        assert(channel);
+
+        // Optimize node animation channels
+        const Object* obj = _refTable.get(channel->getTargetId());
+        if (obj && obj->getTypeId() == Object::NODE_ID)
+        {
+            if (channel->getTargetAttribute() == Transform::ANIMATE_SCALE_ROTATE_TRANSLATE)
+            {
+                decomposeTransformAnimationChannel(animation, channel, channelIndex);
+
+                animation->remove(channel);
+                SAFE_DELETE(channel);
+            }
+        }
+    }
+}
+
+bool GPBFile::isSkinJoint(const std::string& id)
+{
+    // The skins are all loaded before the animations.
+    if (!_skinJointsFound)
+    {
+        for (std::list<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+        {
+            Model* model = (*i)->getModel();
+            if (model && model->getSkin())
+            {
+                const std::vector<std::string>& jointNames = model->getSkin()->getJointNames();
+                _skinJoints.insert(jointNames.begin(), jointNames.end());
+            }
+        }
+        _skinJointsFound = true;
+    }
+    return _skinJoints.find(id) != _skinJoints.end();
+}
+
+void GPBFile::compressAnimations(float tolerance)
+{
+    // Channels are compressed independently, so they are spread over the threads one by one.
+    ChannelTaskData data;
+    data.tolerance = tolerance;
     const unsigned int animationCount = _animations.getAnimationCount();
     for (unsigned int animationIndex = 0; animationIndex < animationCount; ++animationIndex)
     {
         Animation* animation = _animations.getAnimation(animationIndex);
         assert(animation);
 
-        const int channelCount = animation->getAnimationChannelCount();
-
-        LOG(2, "Optimizing %d channel(s) in animation '%s'.\n", channelCount, animation->getId().c_str());
+        const unsigned int channelCount = animation->getAnimationChannelCount();
+        LOG(2, "Compressing %u channel(s) in animation '%s'.\n", channelCount, animation->getId().c_str());
 
-        // loop backwards because we will be adding and removing channels
-        for (int channelIndex = channelCount -1; channelIndex >= 0 ; --channelIndex)
+        for (unsigned int channelIndex = 0; channelIndex < channelCount; ++channelIndex)
         {
             AnimationChannel* channel = animation->getAnimationChannel(channelIndex);
             assert(channel);
-
-            // Optimize node animation channels
-            const Object* obj = _refTable.get(channel->getTargetId());
-            if (obj && obj->getTypeId() == Object::NODE_ID)
-            {
-                if (channel->getTargetAttribute() == Transform::ANIMATE_SCALE_ROTATE_TRANSLATE)
-                {
-                    decomposeTransformAnimationChannel(animation, channel, channelIndex);
-
-                    animation->remove(channel);
-                    SAFE_DELETE(channel);
-                }
-            }
+            // Streamed channels were compressed before they were spooled
+            if (!channel->isSpooled())
+                data.channels.push_back(channel);
         }
     }
+    ThreadPool::run((unsigned int)data.channels.size(), &compressChannelTask, &data);
 }
 
 void GPBFile::decomposeTransformAnimationChannel(Animation* animation, AnimationChannel* channel, int channelIndex)
@@ -1,6 +1,7 @@
 #ifndef GPBFILE_H_
 #define GPBFILE_H_
 
+#include <set>
 #include "FileIO.h"
 #include "Object.h"
 #include "Scene.h"
@@ -21,7 +22,7 @@ namespace gameplay
  * Increment the version number when making a change that break binary compatibility.
  * [0] is major, [1] is minor.
  */
-const unsigned char GPB_VERSION[2] = {1, 2};
+const unsigned char GPB_VERSION[2] = {1, 8};
 
 /**
  * The GamePlay Binary file class handles writing the GamePlay Binary file.
@@ -102,6 +103,39 @@ public:
      */
     unsigned int getLightCount() const;
 
+    /**
+     * Starts writing the meshes and animation channels to a spool file as they are loaded, instead of
+     * keeping them in memory until the file is saved. The options that need every mesh of the scene at
+     * once (text output, navigation meshes, lightmaps, light probes, heightmaps and texture atlases) keep it
+     * in memory.
+     *
+     * @return True if streaming started, false if the scene is kept in memory.
+     */
+    bool beginStreaming();
+
+    /**
+     * Returns true if meshes and animation channels are spooled as they are loaded.
+     */
+    bool isStreaming() const;
+
+    /**
+     * Processes a loaded mesh the way adjust() does: it is optimized, split, quantized and given its
+     * collision hierarchy and levels of detail, which are added to the file. The mesh and everything made
+     * from it are then spooled. Skinned meshes are kept in memory, since the bounds of their skin are
+     * computed from them.
+     */
+    void streamMesh(Mesh* mesh);
+
+    /**
+     * Optimizes and compresses the animation channels from the given index on, the way adjust() does,
+     * and spools them. The channels that target the joints of a skin are kept in memory, since the
+     * bounds of the skin are computed from them.
+     *
+     * @param animation The animation the channels were loaded into.
+     * @param first The index of the first channel loaded.
+     */
+    void streamAnimationChannels(Animation* animation, unsigned int first);
+
     /**
      * Adjusts the game play binary file before it is written.
      */
@@ -127,11 +161,59 @@ private:
      */
     void computeBounds(Node* node);
 
+    /**
+     * Splits the meshes that have more vertices than 16-bit indices can address. The meshes split
+     * off are drawn by child nodes of the nodes that use the mesh, and are added to the given list.
+     */
+    void splitMeshes(std::vector<Mesh*>* meshes);
+
+    /**
+     * Finds the nodes that draw the given mesh.
+     *
+     * @return True if any of them is skinned.
+     */
+    bool getMeshNodes(const Mesh* mesh, std::vector<Node*>& nodes) const;
+
+    /**
+     * Adds a child node drawing a mesh split off to each of the nodes that draw the mesh it was split from.
+     */
+    void addSplitNodes(const std::vector<Node*>& nodes, Mesh* splitMesh, const std::string& suffix);
+
+    /**
+     * Names and adds the levels of detail generated for a mesh, and the MeshLod that selects them.
+     */
+    void addLevelsOfDetail(Mesh* mesh, const std::vector<Mesh*>& lods);
+
     /**
      * Optimizes animation data by removing unneccessary channels and keyframes.
      */
     void optimizeAnimations();
 
+    /**
+     * Optimizes the channels of one animation; animations are optimized in parallel.
+     */
+    void optimizeAnimation(Animation* animation);
+
+    /**
+     * Decomposes the node transform channels of an animation, from the given channel index on.
+     */
+    void optimizeAnimationChannels(Animation* animation, unsigned int first);
+
+    /**
+     * Returns true if the node with the given id is a joint of a skin.
+     */
+    bool isSkinJoint(const std::string& id);
+
+    /**
+     * ThreadPool task optimizing the animation at the given index, called with the GPBFile as argument.
+     */
+    static void optimizeAnimationTask(unsigned int index, void* arg);
+
+    /**
+     * Compresses the key frames of all animation channels within the given tolerance.
+     */
+    void compressAnimations(float tolerance);
+
     /**
      * Decomposes an ANIMATE_SCALE_ROTATE_TRANSLATE channel into 3 new channels. (Scale, Rotate and Translate)
      * 
@@ -164,6 +246,18 @@ private:
     bool _animationsAdded;
 
     ReferenceTable _refTable;
+
+    /**
+     * The file that meshes and animation channels are spooled to, or NULL if they are kept in memory.
+     */
+    FILE* _spool;
+    /**
+     * The meshes split while streaming, each with the mesh it was split from, in the order they were split.
+     * Their nodes are added by adjust(), once every node that draws the mesh is loaded.
+     */
+    std::vector<std::pair<Mesh*, Mesh*> > _streamedSplits;
+    std::set<std::string> _skinJoints;
+    bool _skinJointsFound;
 };
 
 }
@@ -2,13 +2,11 @@
 #include "Heightmap.h"
 #include "GPBFile.h"
 #include "Thread.h"
+#include "ThreadPool.h"
 
 namespace gameplay
 {
 
-// Number of threads to spawn for the heightmap generator
-#define THREAD_COUNT 8
-
 // Thread data structure
 struct HeightmapThreadData
 {
@@ -109,7 +107,7 @@ void Heightmap::generate(const std::vector<std::string>& nodeIds, int width, int
     __totalHeightmapScanlines = height;
 
     // Determine # of threads to spawn
-    int threadCount = min(THREAD_COUNT, height);
+    int threadCount = min((int)ThreadPool::getThreadCount(), height);
 
     // Split the work into separate threads to make max use of available cpu cores and speed up computation.
     HeightmapThreadData* threadData = new HeightmapThreadData[threadCount];
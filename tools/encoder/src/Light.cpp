@@ -93,12 +93,8 @@ float Light::computeInnerAngle(float outerAngle)
     return innerAngle;
 }
 
-void Light::writeBinary(FILE* file)
+void Light::computeRangeAndAngles()
 {
-    Object::writeBinary(file);
-    write(_lightType, file);
-    write(_color, COLOR_SIZE, file);
-
     // Compute an approximate light range with Collada's attenuation parameters.
     // This facilitates bringing in the light nodes directly from maya to gameplay.
     if (_range == -1.0f)
@@ -115,7 +111,18 @@ void Light::writeBinary(FILE* file)
         {
             _innerAngle = computeInnerAngle(_outerAngle);
         }
+    }
+}
 
+void Light::writeBinary(FILE* file)
+{
+    Object::writeBinary(file);
+    write(_lightType, file);
+    write(_color, COLOR_SIZE, file);
+
+    computeRangeAndAngles();
+    if (_lightType == SpotLight)
+    {
         write(_range, file);
         write(MATH_DEG_TO_RAD(_innerAngle), file);
         write(MATH_DEG_TO_RAD(_outerAngle), file);
@@ -132,22 +139,9 @@ void Light::writeText(FILE* file)
     fprintfElement(file, "lightType", _lightType);
     fprintfElement(file, "color", _color, COLOR_SIZE);
 
-    // Compute an approximate light range with Collada's attenuation parameters.
-    // This facilitates bringing in the light nodes directly from maya to gameplay.
-    if (_range == -1.0f)
-    {
-        _range = computeRange(_constantAttenuation, _linearAttenuation, _quadraticAttenuation);
-    }
-
+    computeRangeAndAngles();
     if (_lightType == SpotLight)
     {
-        // Compute an approximate inner angle of the spot light using Collada's outer angle.
-        _outerAngle = _falloffAngle / 2.0f;
-        if (_innerAngle == -1.0f)
-        {
-            _innerAngle = computeInnerAngle(_outerAngle);
-        }
-
         fprintfElement(file, "range", _range);
         fprintfElement(file, "innerAngle", MATH_DEG_TO_RAD(_innerAngle));
         fprintfElement(file, "outerAngle", MATH_DEG_TO_RAD(_outerAngle));
@@ -178,6 +172,29 @@ bool Light::isAmbient() const
     return _lightType == AmbientLight;
 }
 
+unsigned char Light::getLightType() const
+{
+    return _lightType;
+}
+
+float Light::getRange()
+{
+    computeRangeAndAngles();
+    return _range;
+}
+
+float Light::getInnerAngle()
+{
+    computeRangeAndAngles();
+    return MATH_DEG_TO_RAD(_innerAngle);
+}
+
+float Light::getOuterAngle()
+{
+    computeRangeAndAngles();
+    return MATH_DEG_TO_RAD(_outerAngle);
+}
+
 void Light::setAmbientLight()
 {
     _lightType = AmbientLight;
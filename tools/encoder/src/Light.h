@@ -33,6 +33,26 @@ public:
 
     bool isAmbient() const;
 
+    /**
+     * Returns the light type, one of LightType.
+     */
+    unsigned char getLightType() const;
+
+    /**
+     * Returns the range of a point or spot light, computed from its attenuation if it was not set.
+     */
+    float getRange();
+
+    /**
+     * Returns the inner angle of a spot light in radians.
+     */
+    float getInnerAngle();
+
+    /**
+     * Returns the outer angle of a spot light in radians.
+     */
+    float getOuterAngle();
+
     /**
      * Sets the light type to ambient.
      */
@@ -60,6 +80,11 @@ public:
 
 private:
 
+    /**
+     * Computes the range and the spot angles that were not set from Collada's attenuation parameters.
+     */
+    void computeRangeAndAngles();
+
     static float computeRange(float constantAttenuation, float linearAttenuation, float quadraticAttenuation);
     static float computeInnerAngle(float outerAngle);
     
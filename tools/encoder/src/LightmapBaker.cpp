@@ -0,0 +1,595 @@
+#include "Base.h"
+#include "LightmapBaker.h"
+#include "Node.h"
+#include "Scene.h"
+#include "Image.h"
+#include "StringUtil.h"
+#include "ThreadPool.h"
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
+
+// Number of rays cast per texel for ambient occlusion.
+#define LIGHTMAP_OCCLUSION_SAMPLES 64
+// Length of the ambient occlusion rays, as a fraction of the size of the static geometry.
+#define LIGHTMAP_OCCLUSION_DISTANCE 0.1f
+// Number of texels the lightmaps are extended by around the texels the triangles cover.
+#define LIGHTMAP_DILATION 4
+// Number of rays cast per light probe.
+#define LIGHT_PROBE_SAMPLES 256
+// Largest number of light probes baked.
+#define LIGHT_PROBE_MAX_COUNT 4096
+
+namespace gameplay
+{
+
+/**
+ * Ray cast callback that records whether the nearest triangle hit faces the ray.
+ */
+class LightmapRayCallback : public btTriangleRaycastCallback
+{
+public:
+
+    LightmapRayCallback(const btVector3& from, const btVector3& to)
+        : btTriangleRaycastCallback(from, to, kF_KeepUnflippedNormal), hit(0)
+    {
+    }
+
+    virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex)
+    {
+        // Triangles further along the ray are skipped from now on, so the last hit is the nearest.
+        hit = hitNormalLocal.dot(m_to - m_from) > 0 ? -1 : 1;
+        return hitFraction;
+    }
+
+    int hit;
+};
+
+static Vector3 multiplyAdd(const Vector3& a, const Vector3& b, float scale)
+{
+    return Vector3(a.x + b.x * scale, a.y + b.y * scale, a.z + b.z * scale);
+}
+
+static float smoothstep(float edge0, float edge1, float x)
+{
+    if (edge1 <= edge0)
+        return x >= edge1 ? 1.0f : 0.0f;
+    float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+/**
+ * Returns a well mixed seed for the random numbers of a texel or probe, never 0.
+ */
+static unsigned int hashSeed(unsigned int a, unsigned int b, unsigned int c)
+{
+    unsigned int h = a * 73856093u ^ b * 19349663u ^ c * 83492791u;
+    h = (h ^ 61u) ^ (h >> 16);
+    h *= 9u;
+    h ^= h >> 4;
+    h *= 0x27d4eb2du;
+    h ^= h >> 15;
+    return h ? h : 1u;
+}
+
+/**
+ * Returns a random number in [0, 1) and advances the xorshift state.
+ */
+static float nextRandom(unsigned int* state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * Computes two unit vectors perpendicular to a unit normal and to each other.
+ */
+static void computeTangentFrame(const Vector3& normal, Vector3* tangent, Vector3* bitangent)
+{
+    const Vector3& axis = fabs(normal.x) < 0.9f ? Vector3::unitX() : Vector3::unitY();
+    Vector3::cross(normal, axis, tangent);
+    tangent->normalize();
+    Vector3::cross(normal, *tangent, bitangent);
+}
+
+/**
+ * Transforms a direction by the upper 3x3 of a matrix and normalizes it.
+ */
+static Vector3 transformDirection(const Matrix& matrix, const Vector3& direction)
+{
+    Vector3 origin, end;
+    matrix.transformPoint(Vector3::zero(), &origin);
+    matrix.transformPoint(direction, &end);
+    end.subtract(origin);
+    end.normalize();
+    return end;
+}
+
+LightmapBaker::LightmapBaker(void) :
+    _bias(0.0f), _occlusionDistance(0.0f), _lightmapSize(0), _meshInterface(NULL), _shape(NULL)
+{
+}
+
+LightmapBaker::~LightmapBaker(void)
+{
+    delete _shape;
+    delete _meshInterface;
+}
+
+void LightmapBaker::addNode(Node* node)
+{
+    assert(node);
+    assert(_shape == NULL);
+
+    const Matrix& world = node->getWorldMatrix();
+    gameplay::Light* light = node->getLight();
+    if (light && !light->isAmbient())
+    {
+        Light bakeLight;
+        bakeLight.type = light->getLightType();
+        bakeLight.color.set(light->getRed(), light->getGreen(), light->getBlue());
+        world.transformPoint(Vector3::zero(), &bakeLight.position);
+        bakeLight.direction = transformDirection(world, Vector3(0.0f, 0.0f, -1.0f));
+        bakeLight.range = bakeLight.type == gameplay::Light::DirectionalLight ? 0.0f : light->getRange();
+        bakeLight.innerCos = bakeLight.type == gameplay::Light::SpotLight ? cos(light->getInnerAngle()) : 0.0f;
+        bakeLight.outerCos = bakeLight.type == gameplay::Light::SpotLight ? cos(light->getOuterAngle()) : 0.0f;
+        _lights.push_back(bakeLight);
+    }
+
+    Model* model = node->getModel();
+    Mesh* mesh = model ? model->getMesh() : NULL;
+    if (mesh == NULL || model->getSkin() || mesh->getVertexCount() == 0)
+        return;
+
+    bool lightmapped = mesh->getVertex(0).hasTexCoord[1];
+    if (lightmapped)
+    {
+        _targets.push_back(Target());
+        _targets.back().node = node;
+    }
+
+    // The vertices of the mesh in world space, shared by the triangles of all its parts.
+    unsigned int vertexCount = (unsigned int)mesh->getVertexCount();
+    unsigned int base = (unsigned int)(_positions.size() / 3);
+    std::vector<Vector3> positions(vertexCount);
+    std::vector<Vector3> normals(vertexCount);
+    for (unsigned int i = 0; i < vertexCount; ++i)
+    {
+        const Vertex& vertex = mesh->getVertex(i);
+        world.transformPoint(vertex.position, &positions[i]);
+        if (vertex.hasNormal)
+            normals[i] = transformDirection(world, vertex.normal);
+        _positions.push_back(positions[i].x);
+        _positions.push_back(positions[i].y);
+        _positions.push_back(positions[i].z);
+        if (_positions.size() == 3)
+        {
+            _min = positions[i];
+            _max = positions[i];
+        }
+        else
+        {
+            _min.set(std::min(_min.x, positions[i].x), std::min(_min.y, positions[i].y), std::min(_min.z, positions[i].z));
+            _max.set(std::max(_max.x, positions[i].x), std::max(_max.y, positions[i].y), std::max(_max.z, positions[i].z));
+        }
+    }
+
+    for (size_t i = 0, partCount = mesh->parts.size(); i < partCount; ++i)
+    {
+        const MeshPart* part = mesh->parts[i];
+        unsigned int primitiveType = part->getPrimitiveType();
+        if (primitiveType != MeshPart::TRIANGLES && primitiveType != MeshPart::TRIANGLE_STRIP)
+            continue;
+
+        unsigned int indexCount = (unsigned int)part->getIndicesCount();
+        unsigned int step = primitiveType == MeshPart::TRIANGLES ? 3 : 1;
+        for (unsigned int j = 0; j + 2 < indexCount; j += step)
+        {
+            // Every other triangle of a strip is wound the other way.
+            unsigned int corners[3] = { part->getIndex(j), part->getIndex(j + 1), part->getIndex(j + 2) };
+            if (step == 1 && (j & 1) != 0)
+                std::swap(corners[1], corners[2]);
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+                continue;
+
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                _indices.push_back((int)(base + corners[k]));
+            }
+
+            if (lightmapped)
+            {
+                Triangle triangle;
+                Vector3 edge1, edge2, faceNormal;
+                Vector3::subtract(positions[corners[1]], positions[corners[0]], &edge1);
+                Vector3::subtract(positions[corners[2]], positions[corners[0]], &edge2);
+                Vector3::cross(edge1, edge2, &faceNormal);
+                faceNormal.normalize();
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    const Vertex& vertex = mesh->getVertex(corners[k]);
+                    triangle.position[k] = positions[corners[k]];
+                    triangle.normal[k] = vertex.hasNormal ? normals[corners[k]] : faceNormal;
+                    triangle.texCoord[k] = vertex.texCoord[1];
+                }
+                _targets.back().triangles.push_back(triangle);
+            }
+        }
+    }
+}
+
+void LightmapBaker::setAmbientColor(const float* color)
+{
+    assert(color);
+    _ambientColor.set(color[0], color[1], color[2]);
+}
+
+void LightmapBaker::build()
+{
+    if (_shape || _indices.empty())
+        return;
+
+    float size = _min.distance(_max);
+    _bias = std::max(size * 1e-4f, 1e-4f);
+    _occlusionDistance = size * LIGHTMAP_OCCLUSION_DISTANCE;
+
+    btIndexedMesh indexedMesh;
+    indexedMesh.m_indexType = PHY_INTEGER;
+    indexedMesh.m_numTriangles = (int)_indices.size() / 3;
+    indexedMesh.m_numVertices = (int)_positions.size() / 3;
+    indexedMesh.m_triangleIndexBase = (const unsigned char*)&_indices[0];
+    indexedMesh.m_triangleIndexStride = sizeof(int) * 3;
+    indexedMesh.m_vertexBase = (const unsigned char*)&_positions[0];
+    indexedMesh.m_vertexStride = sizeof(float) * 3;
+    indexedMesh.m_vertexType = PHY_FLOAT;
+    _meshInterface = new btTriangleIndexVertexArray();
+    _meshInterface->addIndexedMesh(indexedMesh, PHY_INTEGER);
+    _shape = new btBvhTriangleMeshShape(_meshInterface, true);
+}
+
+int LightmapBaker::castRay(const Vector3& from, const Vector3& to) const
+{
+    if (_shape == NULL)
+        return 0;
+
+    btVector3 rayFrom(from.x, from.y, from.z);
+    btVector3 rayTo(to.x, to.y, to.z);
+    LightmapRayCallback callback(rayFrom, rayTo);
+    _shape->performRaycast(&callback, rayFrom, rayTo);
+    return callback.hit;
+}
+
+bool LightmapBaker::isOccluded(const Vector3& from, const Vector3& to) const
+{
+    return castRay(from, to) != 0;
+}
+
+float LightmapBaker::computeLight(const Light& light, const Vector3& position, Vector3* toLight) const
+{
+    assert(toLight);
+
+    if (light.type == gameplay::Light::DirectionalLight)
+    {
+        // Lit unless something lies between the point and the far side of the scene.
+        toLight->set(-light.direction.x, -light.direction.y, -light.direction.z);
+        float distance = _min.distance(_max) * 2.0f;
+        return isOccluded(position, multiplyAdd(position, *toLight, distance)) ? 0.0f : 1.0f;
+    }
+
+    // Point and spot lights fade out over their range like the lighting shaders.
+    Vector3::subtract(light.position, position, toLight);
+    float distance = toLight->length();
+    if (distance <= 0.0f || distance >= light.range)
+        return 0.0f;
+    toLight->scale(1.0f / distance);
+    float ratio = distance / light.range;
+    float intensity = 1.0f - ratio * ratio;
+    if (light.type == gameplay::Light::SpotLight)
+    {
+        float cosAngle = -Vector3::dot(light.direction, *toLight);
+        intensity *= smoothstep(light.outerCos, light.innerCos, cosAngle);
+    }
+    if (intensity <= 0.0f)
+        return 0.0f;
+
+    return isOccluded(position, light.position) ? 0.0f : intensity;
+}
+
+void LightmapBaker::computeIrradiance(const Vector3& position, const Vector3& normal, unsigned int seed, Vector3* dst) const
+{
+    assert(dst);
+
+    // Rays start off the surface so that they do not hit the triangle they start on.
+    Vector3 origin = multiplyAdd(position, normal, _bias);
+    dst->set(0.0f, 0.0f, 0.0f);
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        const Light& light = _lights[i];
+        Vector3 toLight;
+        float intensity = computeLight(light, origin, &toLight);
+        float cosAngle = Vector3::dot(normal, toLight);
+        if (intensity > 0.0f && cosAngle > 0.0f)
+            *dst = multiplyAdd(*dst, light.color, intensity * cosAngle);
+    }
+
+    // The ambient light is scaled by the fraction of cosine weighted rays that escape.
+    if (!_ambientColor.isZero())
+    {
+        Vector3 tangent, bitangent;
+        computeTangentFrame(normal, &tangent, &bitangent);
+        unsigned int open = 0;
+        for (unsigned int i = 0; i < LIGHTMAP_OCCLUSION_SAMPLES; ++i)
+        {
+            float u = nextRandom(&seed);
+            float phi = nextRandom(&seed) * 2.0f * MATH_PI;
+            float r = sqrt(u);
+            Vector3 direction = multiplyAdd(multiplyAdd(Vector3::zero(), normal, sqrt(1.0f - u)), tangent, r * cos(phi));
+            direction = multiplyAdd(direction, bitangent, r * sin(phi));
+            if (!isOccluded(origin, multiplyAdd(origin, direction, _occlusionDistance)))
+                ++open;
+        }
+        *dst = multiplyAdd(*dst, _ambientColor, (float)open / LIGHTMAP_OCCLUSION_SAMPLES);
+    }
+}
+
+void LightmapBaker::bakeLightmap(unsigned int index)
+{
+    Target& target = _targets[index];
+    const unsigned int size = _lightmapSize;
+    std::vector<Vector3> colors(size * size);
+    std::vector<unsigned char> covered(size * size, 0);
+
+    // Each texel whose center lies in a triangle is lit at the matching point of the triangle.
+    for (size_t t = 0, triangleCount = target.triangles.size(); t < triangleCount; ++t)
+    {
+        const Triangle& triangle = target.triangles[t];
+        float u[3], v[3];
+        for (unsigned int k = 0; k < 3; ++k)
+        {
+            u[k] = triangle.texCoord[k].x * size;
+            v[k] = triangle.texCoord[k].y * size;
+        }
+        float area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+        if (fabs(area) < 1e-8f)
+            continue;
+
+        int minX = std::max((int)floor(std::min(u[0], std::min(u[1], u[2])) - 0.5f), 0);
+        int maxX = std::min((int)ceil(std::max(u[0], std::max(u[1], u[2])) - 0.5f), (int)size - 1);
+        int minY = std::max((int)floor(std::min(v[0], std::min(v[1], v[2])) - 0.5f), 0);
+        int maxY = std::min((int)ceil(std::max(v[0], std::max(v[1], v[2])) - 0.5f), (int)size - 1);
+        for (int y = minY; y <= maxY; ++y)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                unsigned int texel = y * size + x;
+                if (covered[texel])
+                    continue;
+
+                float px = x + 0.5f;
+                float py = y + 0.5f;
+                float w0 = ((u[1] - px) * (v[2] - py) - (u[2] - px) * (v[1] - py)) / area;
+                float w1 = ((u[2] - px) * (v[0] - py) - (u[0] - px) * (v[2] - py)) / area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f)
+                    continue;
+
+                Vector3 position = multiplyAdd(multiplyAdd(Vector3::zero(), triangle.position[0], w0), triangle.position[1], w1);
+                position = multiplyAdd(position, triangle.position[2], w2);
+                Vector3 normal = multiplyAdd(multiplyAdd(Vector3::zero(), triangle.normal[0], w0), triangle.normal[1], w1);
+                normal = multiplyAdd(normal, triangle.normal[2], w2);
+                normal.normalize();
+
+                computeIrradiance(position, normal, hashSeed(index, x, y), &colors[texel]);
+                covered[texel] = 1;
+            }
+        }
+    }
+
+    // Extend the lit texels into their uncovered neighbors, one ring per pass.
+    for (unsigned int pass = 0; pass < LIGHTMAP_DILATION; ++pass)
+    {
+        std::vector<unsigned char> previous(covered);
+        for (int y = 0; y < (int)size; ++y)
+        {
+            for (int x = 0; x < (int)size; ++x)
+            {
+                unsigned int texel = y * size + x;
+                if (previous[texel])
+                    continue;
+
+                Vector3 sum;
+                unsigned int count = 0;
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= (int)size || ny >= (int)size || !previous[ny * size + nx])
+                            continue;
+                        sum.add(colors[ny * size + nx]);
+                        ++count;
+                    }
+                }
+                if (count > 0)
+                {
+                    sum.scale(1.0f / count);
+                    colors[texel] = sum;
+                    covered[texel] = 1;
+                }
+            }
+        }
+    }
+
+    // Images are written top row first, and texture coordinates start at the bottom row.
+    target.pixels.resize(size * size * 3);
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            const Vector3& color = colors[y * size + x];
+            unsigned char* pixel = &target.pixels[((size - 1 - y) * size + x) * 3];
+            pixel[0] = (unsigned char)(std::min(std::max(color.x, 0.0f), 1.0f) * 255.0f + 0.5f);
+            pixel[1] = (unsigned char)(std::min(std::max(color.y, 0.0f), 1.0f) * 255.0f + 0.5f);
+            pixel[2] = (unsigned char)(std::min(std::max(color.z, 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+}
+
+void LightmapBaker::bakeLightmapTask(unsigned int index, void* arg)
+{
+    ((LightmapBaker*)arg)->bakeLightmap(index);
+}
+
+unsigned int LightmapBaker::bakeLightmaps(unsigned int size, const std::string& outputPath)
+{
+    assert(size > 0);
+
+    build();
+    _lightmapSize = size;
+    ThreadPool::run((unsigned int)_targets.size(), &bakeLightmapTask, this);
+
+    // The images are written in node order, after all are baked.
+    size_t slash = outputPath.find_last_of('/');
+    std::string directory = slash == std::string::npos ? std::string() : outputPath.substr(0, slash + 1);
+    std::string name = getFilenameNoExt(getFilenameFromFilePath(outputPath));
+    unsigned int written = 0;
+    for (size_t i = 0, count = _targets.size(); i < count; ++i)
+    {
+        Target& target = _targets[i];
+        std::string fileName = name + "-" + target.node->getId() + ".png";
+        for (size_t j = name.length() + 1, length = fileName.length() - 4; j < length; ++j)
+        {
+            if (!isalnum((unsigned char)fileName[j]) && fileName[j] != '-' && fileName[j] != '_')
+                fileName[j] = '_';
+        }
+
+        LOG(2, "Writing lightmap: %s\n", fileName.c_str());
+        Image* image = Image::create(Image::RGB, size, size);
+        image->setData(&target.pixels[0]);
+        image->save((directory + fileName).c_str());
+        delete image;
+        target.node->setLightmap(fileName);
+        std::vector<unsigned char>().swap(target.pixels);
+        ++written;
+    }
+    return written;
+}
+
+void LightmapBaker::bakeLightProbe(unsigned int index)
+{
+    Probe& probe = _probes[index];
+    memset(probe.irradiance, 0, sizeof(probe.irradiance));
+
+    // Direct light, projected onto the spherical harmonics of the clamped cosine.
+    for (size_t i = 0, count = _lights.size(); i < count; ++i)
+    {
+        const Light& light = _lights[i];
+        Vector3 toLight;
+        float intensity = computeLight(light, probe.position, &toLight);
+        if (intensity <= 0.0f)
+            continue;
+        const float color[3] = { light.color.x * intensity, light.color.y * intensity, light.color.z * intensity };
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            probe.irradiance[c * 4 + 0] += color[c] * 0.5f * toLight.x;
+            probe.irradiance[c * 4 + 1] += color[c] * 0.5f * toLight.y;
+            probe.irradiance[c * 4 + 2] += color[c] * 0.5f * toLight.z;
+            probe.irradiance[c * 4 + 3] += color[c] * 0.25f;
+        }
+    }
+
+    // Ambient light from the directions that are not occluded, over the whole sphere.
+    unsigned int seed = hashSeed(index, 0x9e3779b9u, 0);
+    unsigned int backFaces = 0;
+    const float weight = 1.0f / LIGHT_PROBE_SAMPLES;
+    for (unsigned int i = 0; i < LIGHT_PROBE_SAMPLES; ++i)
+    {
+        float z = 1.0f - 2.0f * nextRandom(&seed);
+        float phi = nextRandom(&seed) * 2.0f * MATH_PI;
+        float r = sqrt(std::max(1.0f - z * z, 0.0f));
+        Vector3 direction(r * cos(phi), r * sin(phi), z);
+        int hit = castRay(probe.position, multiplyAdd(probe.position, direction, _occlusionDistance));
+        if (hit < 0)
+            ++backFaces;
+        if (hit != 0)
+            continue;
+
+        const float ambient[3] = { _ambientColor.x, _ambientColor.y, _ambientColor.z };
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            probe.irradiance[c * 4 + 0] += ambient[c] * 2.0f * weight * direction.x;
+            probe.irradiance[c * 4 + 1] += ambient[c] * 2.0f * weight * direction.y;
+            probe.irradiance[c * 4 + 2] += ambient[c] * 2.0f * weight * direction.z;
+            probe.irradiance[c * 4 + 3] += ambient[c] * weight;
+        }
+    }
+
+    // A probe that sees mostly the inside of geometry would light objects near it wrongly.
+    probe.valid = backFaces * 4 < LIGHT_PROBE_SAMPLES;
+}
+
+void LightmapBaker::bakeLightProbeTask(unsigned int index, void* arg)
+{
+    ((LightmapBaker*)arg)->bakeLightProbe(index);
+}
+
+unsigned int LightmapBaker::bakeLightProbes(float spacing, Scene* scene)
+{
+    assert(spacing > 0.0f);
+    assert(scene);
+
+    build();
+    if (_shape == NULL)
+        return 0;
+
+    // A grid centered on the static geometry, made coarser if it would have too many probes.
+    Vector3 extent;
+    Vector3::subtract(_max, _min, &extent);
+    unsigned int counts[3];
+    for (;;)
+    {
+        counts[0] = (unsigned int)(extent.x / spacing) + 1;
+        counts[1] = (unsigned int)(extent.y / spacing) + 1;
+        counts[2] = (unsigned int)(extent.z / spacing) + 1;
+        if (counts[0] * counts[1] * counts[2] <= LIGHT_PROBE_MAX_COUNT)
+            break;
+        spacing *= 1.25f;
+    }
+    LOG(2, "Light probe grid: %u x %u x %u, spacing %f.\n", counts[0], counts[1], counts[2], spacing);
+
+    Vector3 center = multiplyAdd(_min, extent, 0.5f);
+    _probes.resize(counts[0] * counts[1] * counts[2]);
+    unsigned int index = 0;
+    for (unsigned int z = 0; z < counts[2]; ++z)
+    {
+        for (unsigned int y = 0; y < counts[1]; ++y)
+        {
+            for (unsigned int x = 0; x < counts[0]; ++x)
+            {
+                Probe& probe = _probes[index++];
+                probe.position.set(center.x + (x - (counts[0] - 1) * 0.5f) * spacing,
+                                   center.y + (y - (counts[1] - 1) * 0.5f) * spacing,
+                                   center.z + (z - (counts[2] - 1) * 0.5f) * spacing);
+                probe.valid = false;
+            }
+        }
+    }
+    ThreadPool::run((unsigned int)_probes.size(), &bakeLightProbeTask, this);
+
+    unsigned int added = 0;
+    for (size_t i = 0, count = _probes.size(); i < count; ++i)
+    {
+        if (_probes[i].valid)
+        {
+            scene->addLightProbe(_probes[i].position, _probes[i].irradiance);
+            ++added;
+        }
+    }
+    _probes.clear();
+    return added;
+}
+
+}
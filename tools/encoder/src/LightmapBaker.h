@@ -0,0 +1,195 @@
+#ifndef LIGHTMAPBAKER_H_
+#define LIGHTMAPBAKER_H_
+
+#include "Base.h"
+#include "Vector2.h"
+#include "Vector3.h"
+
+class btTriangleIndexVertexArray;
+class btBvhTriangleMeshShape;
+
+namespace gameplay
+{
+
+class Node;
+class Scene;
+
+/**
+ * Bakes the static lighting of a scene into lightmaps and light probes.
+ *
+ * The static nodes (nodes with a model and no skin) are gathered in world space into a
+ * bounding volume hierarchy that the baker casts shadow and occlusion rays against. For
+ * each static node whose mesh has a second set of texture coordinates, the triangles are
+ * rasterized in that texture space; each texel covered receives the direct light of the
+ * directional, point and spot lights of the scene that reach it unoccluded, plus the
+ * ambient color of the scene scaled by its ambient occlusion. Texels no triangle covers
+ * are filled from their neighbors, so that filtering at the seams does not bleed black.
+ * The lightmaps are written as PNG files, in low dynamic range, and their file names are
+ * set on the nodes. Light is not bounced between surfaces.
+ *
+ * Light probes are placed on a regular grid over the static geometry and store the light
+ * arriving from all directions as first order spherical harmonics, for the runtime to
+ * light dynamic objects with. Probes inside geometry, whose rays mostly hit back faces,
+ * are dropped.
+ *
+ * Baking writes only to the texels and probes of its own task, so the results are the
+ * same for any number of threads.
+ */
+class LightmapBaker
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    LightmapBaker(void);
+
+    /**
+     * Destructor.
+     */
+    ~LightmapBaker(void);
+
+    /**
+     * Adds a node. Static nodes occlude the light and are lightmapped if their mesh has a
+     * second set of texture coordinates; nodes with a light, other than an ambient light,
+     * light the scene.
+     */
+    void addNode(Node* node);
+
+    /**
+     * Sets the ambient color that lights the scene from all directions, 3 floats.
+     */
+    void setAmbientColor(const float* color);
+
+    /**
+     * Bakes the lightmaps of the static nodes that have a second set of texture coordinates.
+     *
+     * @param size The width and height of each lightmap, in texels.
+     * @param outputPath The path of the bundle; each lightmap is written next to it as
+     *      "<bundle name>-<node id>.png".
+     *
+     * @return The number of lightmaps written.
+     */
+    unsigned int bakeLightmaps(unsigned int size, const std::string& outputPath);
+
+    /**
+     * Bakes light probes on a grid over the static nodes and adds them to a scene.
+     *
+     * @param spacing The distance between neighboring probes.
+     * @param scene The scene to add the probes to.
+     *
+     * @return The number of probes added.
+     */
+    unsigned int bakeLightProbes(float spacing, Scene* scene);
+
+private:
+
+    struct Light
+    {
+        unsigned char type;
+        Vector3 color;
+        Vector3 position;
+        Vector3 direction;      // Direction the light shines in.
+        float range;
+        float innerCos;
+        float outerCos;
+    };
+
+    struct Triangle
+    {
+        Vector3 position[3];
+        Vector3 normal[3];
+        Vector2 texCoord[3];
+    };
+
+    struct Target
+    {
+        Node* node;
+        std::vector<Triangle> triangles;
+        std::vector<unsigned char> pixels;
+    };
+
+    struct Probe
+    {
+        Vector3 position;
+        float irradiance[12];
+        bool valid;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    LightmapBaker(const LightmapBaker&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    LightmapBaker& operator=(const LightmapBaker&);
+
+    /**
+     * Builds the bounding volume hierarchy of the static triangles, unless it is already built.
+     */
+    void build();
+
+    /**
+     * Returns true if a segment hits a static triangle.
+     */
+    bool isOccluded(const Vector3& from, const Vector3& to) const;
+
+    /**
+     * Casts a ray and returns 0 if it hits nothing, 1 if it hits a front face and -1 if it hits a back face.
+     */
+    int castRay(const Vector3& from, const Vector3& to) const;
+
+    /**
+     * Computes the irradiance at a point on a surface.
+     *
+     * @param position The point, in world space.
+     * @param normal The unit normal of the surface.
+     * @param seed The seed of the occlusion samples.
+     * @param dst The red, green and blue irradiance.
+     */
+    void computeIrradiance(const Vector3& position, const Vector3& normal, unsigned int seed, Vector3* dst) const;
+
+    /**
+     * Computes the light arriving at a point from a light, with its shadow.
+     *
+     * @param light The light.
+     * @param position The point, in world space.
+     * @param toLight Set to the unit direction from the point to the light.
+     *
+     * @return The intensity of the light at the point, 0 if it does not reach it.
+     */
+    float computeLight(const Light& light, const Vector3& position, Vector3* toLight) const;
+
+    /**
+     * Bakes the lightmap of the target at the given index.
+     */
+    void bakeLightmap(unsigned int index);
+
+    /**
+     * Bakes the probe at the given index.
+     */
+    void bakeLightProbe(unsigned int index);
+
+    static void bakeLightmapTask(unsigned int index, void* arg);
+    static void bakeLightProbeTask(unsigned int index, void* arg);
+
+    std::vector<Light> _lights;
+    std::vector<Target> _targets;
+    std::vector<Probe> _probes;
+    std::vector<float> _positions;
+    std::vector<int> _indices;
+    Vector3 _ambientColor;
+    Vector3 _min;
+    Vector3 _max;
+    float _bias;
+    float _occlusionDistance;
+    unsigned int _lightmapSize;
+    btTriangleIndexVertexArray* _meshInterface;
+    btBvhTriangleMeshShape* _shape;
+};
+
+}
+
+#endif
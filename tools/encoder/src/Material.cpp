@@ -185,6 +185,24 @@ void Material::setLit(bool value)
     _lit = value;
 }
 
+bool Material::isCompatible(const Material* material) const
+{
+    if (_parent != material->_parent || _lit != material->_lit ||
+        _vertexShader != material->_vertexShader || _fragmentShader != material->_fragmentShader ||
+        _defines != material->_defines || _uniforms != material->_uniforms || _renderStates != material->_renderStates ||
+        _samplers.size() != material->_samplers.size())
+    {
+        return false;
+    }
+    for (size_t i = 0, count = _samplers.size(); i < count; ++i)
+    {
+        Sampler* sampler = material->getSampler(_samplers[i]->getId());
+        if (sampler == NULL || !_samplers[i]->isCompatible(sampler))
+            return false;
+    }
+    return true;
+}
+
 void Material::writeMaterial(FILE* file)
 {
     fprintf(file, "material");
@@ -54,6 +54,12 @@ public:
      */
     Sampler* createSampler(const std::string& id);
     Sampler* getSampler(const std::string& id) const;
+
+    /**
+     * Returns true if the given material only differs from this one by the images of its samplers,
+     * so that both can be drawn with one material once their images are packed into an atlas.
+     */
+    bool isCompatible(const Material* material) const;
     
     bool isTextured() const;
     bool isBumped() const;
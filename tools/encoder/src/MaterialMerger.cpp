@@ -0,0 +1,476 @@
+#include "Base.h"
+#include "MaterialMerger.h"
+#include "Node.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Image.h"
+#include "StringUtil.h"
+
+// The border of edge texels around each texture of an atlas.
+#define ATLAS_PADDING 4
+
+// How far texture coordinates may be outside of 0 to 1 and still be clamped into an atlas.
+#define ATLAS_TEXCOORD_TOLERANCE 0.001f
+
+namespace gameplay
+{
+
+static bool fileExists(const std::string& path)
+{
+    struct stat buf;
+    return stat(path.c_str(), &buf) == 0;
+}
+
+static unsigned int nextPowerOfTwo(unsigned int value, unsigned int limit)
+{
+    unsigned int result = 1;
+    while (result < value)
+        result <<= 1;
+    return std::min(result, limit);
+}
+
+/**
+ * Orders the textures of a group for shelf packing: tallest first, then widest, then in the order of their materials.
+ */
+struct TextureOrder
+{
+    const std::vector<Image*>* images;
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        const Image* imageA = (*images)[a];
+        const Image* imageB = (*images)[b];
+        if (imageA->getHeight() != imageB->getHeight())
+            return imageA->getHeight() > imageB->getHeight();
+        if (imageA->getWidth() != imageB->getWidth())
+            return imageA->getWidth() > imageB->getWidth();
+        return a < b;
+    }
+};
+
+MaterialMerger::MaterialMerger(unsigned int atlasSize) : _atlasSize(atlasSize)
+{
+}
+
+MaterialMerger::~MaterialMerger()
+{
+    for (std::map<std::string, Image*>::iterator i = _images.begin(); i != _images.end(); ++i)
+    {
+        delete i->second;
+    }
+}
+
+void MaterialMerger::addNode(Node* node)
+{
+    Model* model = node->getModel();
+    if (model && model->getMesh())
+        _models.push_back(model);
+}
+
+unsigned int MaterialMerger::merge(const std::string& outputPath, const std::string& inputPath, std::map<std::string, Material*>& materials)
+{
+    // Find the mesh parts drawn with each material. A part drawn with different materials by
+    // different nodes cannot have its texture coordinates remapped for only one of them.
+    std::map<std::pair<Mesh*, unsigned int>, Material*> partMaterials;
+    for (size_t i = 0, count = _models.size(); i < count; ++i)
+    {
+        Model* model = _models[i];
+        Mesh* mesh = model->getMesh();
+        for (unsigned int j = 0, partCount = (unsigned int)mesh->parts.size(); j < partCount; ++j)
+        {
+            Material* material = model->getMaterial(j);
+            if (material == NULL)
+                continue;
+            std::pair<Mesh*, unsigned int> part(mesh, j);
+            std::map<std::pair<Mesh*, unsigned int>, Material*>::const_iterator it = partMaterials.find(part);
+            if (it == partMaterials.end())
+            {
+                partMaterials[part] = material;
+                Binding binding = { mesh, j };
+                getEntry(material).bindings.push_back(binding);
+            }
+            else if (it->second != material)
+            {
+                getEntry(material).eligible = false;
+                getEntry(it->second).eligible = false;
+            }
+        }
+    }
+
+    // Group the materials whose textures fit in an atlas.
+    std::vector<std::vector<size_t> > groups;
+    for (size_t i = 0, count = _entries.size(); i < count; ++i)
+    {
+        Entry& entry = _entries[i];
+        Material* material = entry.material;
+        if (!entry.eligible || material->getSampler(u_diffuseTexture) == NULL ||
+            material->isDefined(TEXTURE_REPEAT) || material->isDefined(TEXTURE_OFFSET) || !hasAtlasTexCoords(entry))
+        {
+            continue;
+        }
+        size_t group = 0;
+        while (group < groups.size() && !_entries[groups[group][0]].material->isCompatible(material))
+            ++group;
+        if (group == groups.size())
+            groups.push_back(std::vector<size_t>());
+        groups[group].push_back(i);
+    }
+
+    size_t slash = outputPath.find_last_of('/');
+    std::string directory = slash == std::string::npos ? std::string() : outputPath.substr(0, slash + 1);
+    std::string name = getFilenameNoExt(getFilenameFromFilePath(outputPath));
+    slash = inputPath.find_last_of('/');
+    std::string inputDirectory = slash == std::string::npos ? std::string() : inputPath.substr(0, slash + 1);
+
+    unsigned int merged = 0;
+    unsigned int atlasCount = 0;
+    int owner = 0;
+    for (size_t i = 0, groupCount = groups.size(); i < groupCount; ++i)
+    {
+        if (groups[i].size() < 2)
+            continue;
+
+        // The entries with the same images share a texture.
+        std::vector<size_t> members;
+        std::vector<Texture> textures;
+        std::map<std::pair<Image*, Image*>, int> textureIndices;
+        for (size_t j = 0, count = groups[i].size(); j < count; ++j)
+        {
+            Entry& entry = _entries[groups[i][j]];
+            if (!loadImages(entry, inputDirectory))
+                continue;
+            std::pair<Image*, Image*> images(entry.diffuse, entry.normal);
+            std::map<std::pair<Image*, Image*>, int>::const_iterator it = textureIndices.find(images);
+            if (it == textureIndices.end())
+            {
+                Texture texture = { entry.diffuse, entry.normal, 0, 0, 0 };
+                entry.texture = (int)textures.size();
+                textureIndices[images] = entry.texture;
+                textures.push_back(texture);
+            }
+            else
+            {
+                entry.texture = it->second;
+            }
+            members.push_back(groups[i][j]);
+        }
+        if (textures.size() < 2)
+            continue;
+
+        std::vector<unsigned int> pageWidths;
+        std::vector<unsigned int> pageHeights;
+        unsigned int pageCount = pack(textures, pageWidths, pageHeights);
+        Material* first = _entries[members[0]].material;
+        bool bumped = first->getSampler("u_normalmapTexture") != NULL;
+        for (unsigned int page = 0; page < pageCount; ++page)
+        {
+            unsigned int textureCount = 0;
+            for (size_t j = 0, count = textures.size(); j < count; ++j)
+            {
+                if (textures[j].page == page)
+                    ++textureCount;
+            }
+            if (textureCount < 2)
+                continue;
+
+            char suffix[32];
+            sprintf(suffix, "%u", ++atlasCount);
+            std::string fileName = name + "-atlas" + suffix + ".png";
+            LOG(2, "Writing texture atlas: %s\n", fileName.c_str());
+            Image* atlas = createAtlas(textures, page, pageWidths[page], pageHeights[page], false);
+            atlas->save((directory + fileName).c_str());
+            delete atlas;
+
+            std::string id = std::string("atlas") + suffix;
+            while (materials.find(id) != materials.end())
+                id = "_" + id;
+            Material* material = new Material(*first);
+            material->setId(id.c_str());
+            material->setLit(first->isLit());
+            Sampler* sampler = material->getSampler(u_diffuseTexture);
+            sampler->set("absolutePath", directory + fileName);
+            sampler->set("relativePath", fileName);
+            sampler->set("wrapS", CLAMP);
+            sampler->set("wrapT", CLAMP);
+            if (bumped)
+            {
+                std::string normalFileName = name + "-atlas" + suffix + "-normal.png";
+                Image* normalAtlas = createAtlas(textures, page, pageWidths[page], pageHeights[page], true);
+                normalAtlas->save((directory + normalFileName).c_str());
+                delete normalAtlas;
+                sampler = material->getSampler("u_normalmapTexture");
+                sampler->set("absolutePath", directory + normalFileName);
+                sampler->set("relativePath", normalFileName);
+                sampler->set("wrapS", CLAMP);
+                sampler->set("wrapT", CLAMP);
+            }
+
+            // Remap the texture coordinates of the parts into their texture, with v up from the bottom row.
+            float width = (float)pageWidths[page];
+            float height = (float)pageHeights[page];
+            for (size_t j = 0, count = members.size(); j < count; ++j)
+            {
+                Entry& entry = _entries[members[j]];
+                const Texture& texture = textures[entry.texture];
+                if (texture.page != page)
+                    continue;
+                float w = (float)texture.diffuse->getWidth();
+                float h = (float)texture.diffuse->getHeight();
+                Vector2 offset((texture.x + ATLAS_PADDING) / width, (height - (texture.y + ATLAS_PADDING + h)) / height);
+                Vector2 scale(w / width, h / height);
+                for (size_t k = 0, bindingCount = entry.bindings.size(); k < bindingCount; ++k)
+                {
+                    remap(entry.bindings[k], owner + entry.texture, offset, scale);
+                }
+                for (size_t k = 0, modelCount = _models.size(); k < modelCount; ++k)
+                {
+                    _models[k]->replaceMaterial(entry.material, material);
+                }
+                materials.erase(entry.material->getId());
+                ++merged;
+            }
+            materials[id] = material;
+        }
+        owner += (int)textures.size();
+    }
+    if (atlasCount > 0)
+    {
+        LOG(1, "Merged %u materials into %u texture atlases.\n", merged, atlasCount);
+    }
+    return merged;
+}
+
+MaterialMerger::Entry& MaterialMerger::getEntry(Material* material)
+{
+    std::map<Material*, size_t>::const_iterator it = _entryIndices.find(material);
+    if (it != _entryIndices.end())
+        return _entries[it->second];
+
+    Entry entry;
+    entry.material = material;
+    entry.eligible = true;
+    entry.diffuse = NULL;
+    entry.normal = NULL;
+    entry.texture = -1;
+    _entryIndices[material] = _entries.size();
+    _entries.push_back(entry);
+    return _entries.back();
+}
+
+bool MaterialMerger::hasAtlasTexCoords(const Entry& entry) const
+{
+    for (size_t i = 0, count = entry.bindings.size(); i < count; ++i)
+    {
+        const Mesh* mesh = entry.bindings[i].mesh;
+        const std::vector<unsigned int>& indices = mesh->parts[entry.bindings[i].part]->getIndices();
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            const Vertex& vertex = mesh->vertices[indices[j]];
+            if (!vertex.hasTexCoord[0] ||
+                vertex.texCoord[0].x < -ATLAS_TEXCOORD_TOLERANCE || vertex.texCoord[0].x > 1.0f + ATLAS_TEXCOORD_TOLERANCE ||
+                vertex.texCoord[0].y < -ATLAS_TEXCOORD_TOLERANCE || vertex.texCoord[0].y > 1.0f + ATLAS_TEXCOORD_TOLERANCE)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool MaterialMerger::loadImages(Entry& entry, const std::string& inputDirectory)
+{
+    Sampler* sampler = entry.material->getSampler(u_diffuseTexture);
+    entry.diffuse = loadImage(sampler->getString("absolutePath"), sampler->getString("relativePath"), inputDirectory);
+    if (entry.diffuse == NULL)
+        return false;
+    unsigned int width = entry.diffuse->getWidth();
+    unsigned int height = entry.diffuse->getHeight();
+    if (width + 2 * ATLAS_PADDING > _atlasSize || height + 2 * ATLAS_PADDING > _atlasSize)
+    {
+        LOG(2, "Material '%s' is not merged; its texture does not fit in an atlas.\n", entry.material->getId().c_str());
+        return false;
+    }
+
+    sampler = entry.material->getSampler("u_normalmapTexture");
+    if (sampler)
+    {
+        entry.normal = loadImage(sampler->getString("absolutePath"), sampler->getString("relativePath"), inputDirectory);
+        if (entry.normal == NULL || entry.normal->getWidth() != width || entry.normal->getHeight() != height)
+        {
+            LOG(2, "Material '%s' is not merged; its normal map is not the size of its texture.\n", entry.material->getId().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+Image* MaterialMerger::loadImage(const char* absolutePath, const char* relativePath, const std::string& inputDirectory)
+{
+    std::string path;
+    if (absolutePath && fileExists(absolutePath))
+        path = absolutePath;
+    else if (relativePath && fileExists(inputDirectory + relativePath))
+        path = inputDirectory + relativePath;
+    else
+        return NULL;
+
+    // Images are shared by the materials that use them, and failures are not retried.
+    std::map<std::string, Image*>::const_iterator it = _images.find(path);
+    if (it != _images.end())
+        return it->second;
+    Image* image = Image::create(path.c_str());
+    _images[path] = image;
+    return image;
+}
+
+unsigned int MaterialMerger::pack(std::vector<Texture>& textures, std::vector<unsigned int>& pageWidths, std::vector<unsigned int>& pageHeights) const
+{
+    std::vector<Image*> images;
+    std::vector<unsigned int> order;
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        images.push_back(textures[i].diffuse);
+        order.push_back((unsigned int)i);
+    }
+    TextureOrder textureOrder = { &images };
+    std::sort(order.begin(), order.end(), textureOrder);
+
+    // Fill shelves left to right and pages top to bottom; a shelf is as tall as its first texture.
+    unsigned int page = 0;
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int shelfHeight = 0;
+    unsigned int maxX = 0;
+    for (size_t i = 0, count = order.size(); i < count; ++i)
+    {
+        Texture& texture = textures[order[i]];
+        unsigned int width = texture.diffuse->getWidth() + 2 * ATLAS_PADDING;
+        unsigned int height = texture.diffuse->getHeight() + 2 * ATLAS_PADDING;
+        if (x + width > _atlasSize)
+        {
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        if (y + height > _atlasSize)
+        {
+            pageWidths.push_back(nextPowerOfTwo(maxX, _atlasSize));
+            pageHeights.push_back(nextPowerOfTwo(y, _atlasSize));
+            ++page;
+            x = 0;
+            y = 0;
+            maxX = 0;
+        }
+        texture.x = x;
+        texture.y = y;
+        texture.page = page;
+        x += width;
+        maxX = std::max(maxX, x);
+        shelfHeight = std::max(shelfHeight, height);
+    }
+    pageWidths.push_back(nextPowerOfTwo(maxX, _atlasSize));
+    pageHeights.push_back(nextPowerOfTwo(y + shelfHeight, _atlasSize));
+    return page + 1;
+}
+
+void MaterialMerger::remap(const Binding& binding, int owner, const Vector2& offset, const Vector2& scale)
+{
+    Mesh* mesh = binding.mesh;
+    MeshState& state = _meshStates[mesh];
+    if (state.owners.empty())
+    {
+        state.owners.assign(mesh->vertices.size(), -1);
+        state.texCoords.resize(mesh->vertices.size());
+        for (size_t i = 0, count = mesh->vertices.size(); i < count; ++i)
+        {
+            state.texCoords[i] = mesh->vertices[i].texCoord[0];
+        }
+    }
+
+    MeshPart* part = mesh->parts[binding.part];
+    std::vector<unsigned int> indices(part->getIndices());
+    std::map<unsigned int, unsigned int> copies;
+    bool copied = false;
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+    {
+        unsigned int index = indices[i];
+        if (state.owners[index] == owner)
+            continue;
+
+        unsigned int target = index;
+        if (state.owners[index] >= 0)
+        {
+            // The vertex is shared with a part drawn from another texture.
+            std::map<unsigned int, unsigned int>::const_iterator it = copies.find(index);
+            if (it != copies.end())
+            {
+                indices[i] = it->second;
+                copied = true;
+                continue;
+            }
+            target = (unsigned int)mesh->vertices.size();
+            mesh->vertices.push_back(mesh->vertices[index]);
+            state.owners.push_back(owner);
+            state.texCoords.push_back(state.texCoords[index]);
+            copies[index] = target;
+            indices[i] = target;
+            copied = true;
+        }
+        state.owners[target] = owner;
+        const Vector2& texCoord = state.texCoords[target];
+        Vector2& remapped = mesh->vertices[target].texCoord[0];
+        remapped.x = offset.x + std::min(std::max(texCoord.x, 0.0f), 1.0f) * scale.x;
+        remapped.y = offset.y + std::min(std::max(texCoord.y, 0.0f), 1.0f) * scale.y;
+    }
+    if (copied)
+    {
+        part->setIndices(indices);
+    }
+}
+
+Image* MaterialMerger::createAtlas(const std::vector<Texture>& textures, unsigned int page, unsigned int width, unsigned int height, bool normal)
+{
+    bool alpha = false;
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        const Image* image = normal ? textures[i].normal : textures[i].diffuse;
+        if (textures[i].page == page && image->getFormat() == Image::RGBA)
+            alpha = true;
+    }
+    Image* atlas = Image::create(alpha ? Image::RGBA : Image::RGB, width, height);
+    for (size_t i = 0, count = textures.size(); i < count; ++i)
+    {
+        if (textures[i].page == page)
+            blit(atlas, textures[i].x, textures[i].y, normal ? textures[i].normal : textures[i].diffuse);
+    }
+    return atlas;
+}
+
+void MaterialMerger::blit(Image* atlas, unsigned int x, unsigned int y, const Image* image)
+{
+    // Copy the image with a border repeating its edge texels, converting it to the format of the atlas.
+    unsigned char* data = (unsigned char*)atlas->getData();
+    const unsigned char* source = (const unsigned char*)image->getData();
+    unsigned int atlasBpp = atlas->getBpp();
+    unsigned int bpp = image->getBpp();
+    int width = (int)image->getWidth();
+    int height = (int)image->getHeight();
+    for (int row = -ATLAS_PADDING; row < height + ATLAS_PADDING; ++row)
+    {
+        int sourceRow = std::min(std::max(row, 0), height - 1);
+        unsigned char* target = data + ((y + ATLAS_PADDING + row) * atlas->getWidth() + x) * atlasBpp;
+        for (int column = -ATLAS_PADDING; column < width + ATLAS_PADDING; ++column, target += atlasBpp)
+        {
+            int sourceColumn = std::min(std::max(column, 0), width - 1);
+            const unsigned char* texel = source + (sourceRow * width + sourceColumn) * bpp;
+            target[0] = texel[0];
+            target[1] = bpp >= 3 ? texel[1] : texel[0];
+            target[2] = bpp >= 3 ? texel[2] : texel[0];
+            if (atlasBpp == 4)
+                target[3] = bpp == 4 ? texel[3] : 255;
+        }
+    }
+}
+
+}
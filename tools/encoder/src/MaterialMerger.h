@@ -0,0 +1,136 @@
+#ifndef MATERIALMERGER_H_
+#define MATERIALMERGER_H_
+
+#include "Base.h"
+#include "Vector2.h"
+
+namespace gameplay
+{
+
+class Node;
+class Model;
+class Mesh;
+class Material;
+class Image;
+
+/**
+ * Merges the materials of a scene that differ only by their textures, so that the
+ * objects drawn with them can be batched and instanced together.
+ *
+ * The materials are grouped with Material::isCompatible. The diffuse textures of each
+ * group, and their normal maps when the material is bumped, are packed into atlases of
+ * at most the given size, on shelves sorted by height. Each texture is surrounded by a
+ * border of its edge texels, so that filtering and the smaller mipmaps do not bleed the
+ * neighboring textures in. The texture coordinates of the mesh parts drawn with a merged
+ * material are remapped into its place in the atlas; vertices shared with parts drawn
+ * from another place are duplicated.
+ *
+ * A material is left alone when its textures tile (texture coordinates outside of 0 to 1,
+ * or a texture repeat or offset), when its images cannot be read as PNG files or do not
+ * fit in an atlas, when its normal map is not the size of its diffuse texture, or when a
+ * mesh part it draws is drawn with another material by another node. Atlases that would
+ * hold a single texture are not written.
+ */
+class MaterialMerger
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param atlasSize The largest width and height of an atlas, in texels.
+     */
+    MaterialMerger(unsigned int atlasSize);
+
+    /**
+     * Destructor.
+     */
+    ~MaterialMerger();
+
+    /**
+     * Adds a node whose model may have its materials merged.
+     */
+    void addNode(Node* node);
+
+    /**
+     * Merges the materials of the nodes added. The atlases are written as PNG files next to the
+     * output file, and the merged materials are replaced, in the models and in the given map of
+     * materials by id, by one material per atlas.
+     *
+     * @param outputPath The path of the output file.
+     * @param inputPath The path of the input file, which relative texture paths start from.
+     * @param materials The materials of the scene by id.
+     *
+     * @return The number of materials that were merged.
+     */
+    unsigned int merge(const std::string& outputPath, const std::string& inputPath, std::map<std::string, Material*>& materials);
+
+private:
+
+    /**
+     * A mesh part drawn with a material.
+     */
+    struct Binding
+    {
+        Mesh* mesh;
+        unsigned int part;
+    };
+
+    /**
+     * A material that may be merged, with the mesh parts it draws.
+     */
+    struct Entry
+    {
+        Material* material;
+        std::vector<Binding> bindings;
+        bool eligible;
+        Image* diffuse;
+        Image* normal;
+        int texture;
+    };
+
+    /**
+     * A texture of a group, shared by the entries with the same images, and its place in an atlas.
+     */
+    struct Texture
+    {
+        Image* diffuse;
+        Image* normal;
+        unsigned int x;
+        unsigned int y;
+        unsigned int page;
+    };
+
+    /**
+     * The texture coordinates of a mesh before they were remapped, and the texture each vertex was remapped into.
+     */
+    struct MeshState
+    {
+        std::vector<Vector2> texCoords;
+        std::vector<int> owners;
+    };
+
+    MaterialMerger(const MaterialMerger&);
+    MaterialMerger& operator=(const MaterialMerger&);
+
+    Entry& getEntry(Material* material);
+    bool hasAtlasTexCoords(const Entry& entry) const;
+    bool loadImages(Entry& entry, const std::string& inputDirectory);
+    Image* loadImage(const char* absolutePath, const char* relativePath, const std::string& inputDirectory);
+    unsigned int pack(std::vector<Texture>& textures, std::vector<unsigned int>& pageWidths, std::vector<unsigned int>& pageHeights) const;
+    void remap(const Binding& binding, int owner, const Vector2& offset, const Vector2& scale);
+
+    static Image* createAtlas(const std::vector<Texture>& textures, unsigned int page, unsigned int width, unsigned int height, bool normal);
+    static void blit(Image* atlas, unsigned int x, unsigned int y, const Image* image);
+
+    unsigned int _atlasSize;
+    std::vector<Model*> _models;
+    std::vector<Entry> _entries;
+    std::map<Material*, size_t> _entryIndices;
+    std::map<Mesh*, MeshState> _meshStates;
+    std::map<std::string, Image*> _images;
+};
+
+}
+
+#endif
@@ -5,7 +5,7 @@
 namespace gameplay
 {
 
-Mesh::Mesh(void) : model(NULL)
+Mesh::Mesh(void) : model(NULL), _quantized(false), _positionDecode(false)
 {
 }
 
@@ -25,6 +25,8 @@ const char* Mesh::getElementName(void) const
 
 void Mesh::writeBinary(FILE* file)
 {
+    if (writeSpooled(file))
+        return;
     Object::writeBinary(file);
     // vertex formats
     write((unsigned int)_vertexFormat.size(), file);
@@ -32,6 +34,12 @@ void Mesh::writeBinary(FILE* file)
     {
         i->writeBinary(file);
     }
+    // position decode
+    if (_positionDecode)
+    {
+        writeVectorBinary(_positionOffset, file);
+        writeVectorBinary(_positionScale, file);
+    }
     // vertices
     writeBinaryVertices(file);
     // parts
@@ -42,16 +50,36 @@ void Mesh::writeBinaryVertices(FILE* file)
 {
     if (vertices.size() > 0)
     {
-        // Assumes that all vertices are the same size.
-        // Write the number of bytes for the vertex data
-        const Vertex& vertex = vertices.front();
-        write((unsigned int)(vertices.size() * vertex.byteSize()), file); // (vertex count) * (vertex size)
-
-        // for each vertex
-        for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+        if (_quantized)
+        {
+            unsigned int vertexSize = 0;
+            for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+            {
+                vertexSize += i->byteSize();
+            }
+            write((unsigned int)(vertices.size() * vertexSize), file);
+            FILE* section = beginSection(file);
+            for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+            {
+                writeBinaryVertex(*i, section);
+            }
+            endSection(section, file);
+        }
+        else
         {
-            // Write this vertex
-            i->writeBinary(file);
+            // Assumes that all vertices are the same size.
+            // Write the number of bytes for the vertex data
+            const Vertex& vertex = vertices.front();
+            write((unsigned int)(vertices.size() * vertex.byteSize()), file); // (vertex count) * (vertex size)
+
+            // for each vertex
+            FILE* section = beginSection(file);
+            for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+            {
+                // Write this vertex
+                i->writeBinary(section);
+            }
+            endSection(section, file);
         }
     }
     else
@@ -67,6 +95,16 @@ void Mesh::writeBinaryVertices(FILE* file)
     write(bounds.radius, file);
 }
 
+void Mesh::releaseData()
+{
+    std::vector<Vertex>().swap(vertices);
+    vertexLookupTable.clear();
+    for (std::vector<MeshPart*>::iterator i = parts.begin(); i != parts.end(); ++i)
+    {
+        (*i)->releaseData();
+    }
+}
+
 void Mesh::writeText(FILE* file)
 {
     fprintElementStart(file);
@@ -168,14 +206,28 @@ unsigned int Mesh::getVertexIndex(const Vertex& vertex)
 
 bool Mesh::hasNormals() const
 {
+    if (isSpooled())
+        return hasVertexElement(NORMAL);
     return !vertices.empty() && vertices[0].hasNormal;
 }
 
 bool Mesh::hasVertexColors() const
 {
+    if (isSpooled())
+        return hasVertexElement(COLOR);
     return !vertices.empty() && vertices[0].hasDiffuse;
 }
 
+bool Mesh::hasVertexElement(unsigned int usage) const
+{
+    for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        if (i->usage == usage)
+            return true;
+    }
+    return false;
+}
+
 void Mesh::computeBounds()
 {
     // If we have a Model with a MeshSkin associated with it,
@@ -230,4 +282,339 @@ void Mesh::computeBounds()
     bounds.radius = sqrt(bounds.radius);
 }
 
+static unsigned short floatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(float));
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    unsigned int mantissa = bits & 0x7fffff;
+
+    if (exponent >= 0x1f)
+    {
+        // Clamp to the largest half rather than producing infinity.
+        return sign | 0x7bff;
+    }
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return sign;
+        // Denormal half.
+        mantissa |= 0x800000;
+        unsigned int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            ++half;
+        return sign | (unsigned short)half;
+    }
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    // Round to nearest; a carry into the exponent is still the correctly rounded value.
+    if (mantissa & 0x1000)
+        ++half;
+    return sign | (unsigned short)std::min(half, 0x7bffu);
+}
+
+static short toSnorm16(float value)
+{
+    value = std::min(std::max(value, -1.0f), 1.0f);
+    return (short)floorf(value * 32767.0f + 0.5f);
+}
+
+static float fromSnorm16(short value)
+{
+    // Matches the decoding of normalized shorts by OpenGL ES 3.0 and the runtime.
+    return std::max(value / 32767.0f, -1.0f);
+}
+
+static unsigned char toUnorm8(float value)
+{
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return (unsigned char)floorf(value * 255.0f + 0.5f);
+}
+
+static unsigned int toSnorm1010102(float x, float y, float z)
+{
+    float v[3] = { x, y, z };
+    unsigned int packed = 0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        float c = std::min(std::max(v[i], -1.0f), 1.0f);
+        int q = (int)floorf(c * 511.0f + 0.5f);
+        packed |= ((unsigned int)q & 0x3ff) << (i * 10);
+    }
+    return packed;
+}
+
+void Mesh::quantizeVertices()
+{
+    if (vertices.empty() || _quantized)
+        return;
+
+    // Blend indices only fit into bytes for skins of up to 256 joints.
+    bool byteIndices = true;
+    for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+    {
+        if (i->hasWeights && (i->blendIndices.x > 255.0f || i->blendIndices.y > 255.0f || i->blendIndices.z > 255.0f || i->blendIndices.w > 255.0f))
+        {
+            byteIndices = false;
+            break;
+        }
+    }
+
+    for (std::vector<VertexElement>::iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        switch (i->usage)
+        {
+        case POSITION:
+            // Skinned positions are transformed by the joints before the decode could be applied.
+            if (!(model && model->getSkin()))
+            {
+                *i = VertexElement(POSITION, 4, TYPE_SHORT, true);
+                _positionDecode = true;
+            }
+            break;
+        case NORMAL:
+        case TANGENT:
+        case BINORMAL:
+            *i = VertexElement(i->usage, 4, TYPE_INT_2_10_10_10_REV, true);
+            break;
+        case COLOR:
+        case BLENDWEIGHTS:
+            *i = VertexElement(i->usage, 4, TYPE_UNSIGNED_BYTE, true);
+            break;
+        case BLENDINDICES:
+            if (byteIndices)
+                *i = VertexElement(i->usage, 4, TYPE_UNSIGNED_BYTE, false);
+            break;
+        default:
+            if (i->usage >= TEXCOORD0 && i->usage <= TEXCOORD7)
+                *i = VertexElement(i->usage, i->size, TYPE_HALF_FLOAT, false);
+            break;
+        }
+    }
+    _quantized = true;
+
+    if (_positionDecode)
+    {
+        // Map the bounds of the vertices to [-1, 1].
+        Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+        Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (std::vector<Vertex>::const_iterator i = vertices.begin(); i != vertices.end(); ++i)
+        {
+            min.x = std::min(min.x, i->position.x);
+            min.y = std::min(min.y, i->position.y);
+            min.z = std::min(min.z, i->position.z);
+            max.x = std::max(max.x, i->position.x);
+            max.y = std::max(max.y, i->position.y);
+            max.z = std::max(max.z, i->position.z);
+        }
+        _positionOffset.set((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+        _positionScale.set((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+        if (_positionScale.x <= 0.0f)
+            _positionScale.x = 1.0f;
+        if (_positionScale.y <= 0.0f)
+            _positionScale.y = 1.0f;
+        if (_positionScale.z <= 0.0f)
+            _positionScale.z = 1.0f;
+
+        // Snap the positions to their decoded values.
+        for (std::vector<Vertex>::iterator i = vertices.begin(); i != vertices.end(); ++i)
+        {
+            Vector3& p = i->position;
+            p.x = fromSnorm16(toSnorm16((p.x - _positionOffset.x) / _positionScale.x)) * _positionScale.x + _positionOffset.x;
+            p.y = fromSnorm16(toSnorm16((p.y - _positionOffset.y) / _positionScale.y)) * _positionScale.y + _positionOffset.y;
+            p.z = fromSnorm16(toSnorm16((p.z - _positionOffset.z) / _positionScale.z)) * _positionScale.z + _positionOffset.z;
+        }
+
+        vertexLookupTable.clear();
+        for (unsigned int i = 0, count = (unsigned int)vertices.size(); i < count; ++i)
+        {
+            vertexLookupTable[vertices[i]] = i;
+        }
+    }
+}
+
+void Mesh::copyVertexFormat(const Mesh* mesh)
+{
+    _vertexFormat = mesh->_vertexFormat;
+    _quantized = mesh->_quantized;
+    _positionDecode = mesh->_positionDecode;
+    _positionOffset = mesh->_positionOffset;
+    _positionScale = mesh->_positionScale;
+}
+
+std::vector<Mesh*> Mesh::split(unsigned int maxVertexCount)
+{
+    std::vector<Mesh*> meshes;
+    if (vertices.size() <= maxVertexCount || maxVertexCount < 3)
+        return meshes;
+
+    for (size_t i = 0, count = parts.size(); i < count; ++i)
+    {
+        if (parts[i]->getPrimitiveType() != MeshPart::TRIANGLES || parts[i]->getIndicesCount() % 3 != 0)
+        {
+            LOG(1, "Warning: mesh '%s' has parts that are not triangle lists and is not split.\n", getId().c_str());
+            return meshes;
+        }
+    }
+
+    // Assign the triangles to meshes in order, starting a new mesh when the next triangle
+    // would take the current one over the vertex limit.
+    const unsigned int vertexCount = (unsigned int)vertices.size();
+    const size_t partCount = parts.size();
+    std::vector<std::vector<Vertex> > meshVertices(1);
+    std::vector<std::vector<std::vector<unsigned int> > > meshIndices(1, std::vector<std::vector<unsigned int> >(partCount));
+    std::vector<unsigned int> remap(vertexCount, UINT_MAX);
+    std::vector<unsigned int> remapMesh(vertexCount, UINT_MAX);
+    for (size_t i = 0; i < partCount; ++i)
+    {
+        const std::vector<unsigned int>& indices = parts[i]->getIndices();
+        for (size_t t = 0, indexCount = indices.size(); t < indexCount; t += 3)
+        {
+            unsigned int current = (unsigned int)meshVertices.size() - 1;
+            unsigned int newCount = 0;
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                assert(indices[t + k] < vertexCount);
+                if (remapMesh[indices[t + k]] != current)
+                    ++newCount;
+            }
+            if (meshVertices[current].size() + newCount > maxVertexCount)
+            {
+                meshVertices.push_back(std::vector<Vertex>());
+                meshIndices.push_back(std::vector<std::vector<unsigned int> >(partCount));
+                ++current;
+            }
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                unsigned int index = indices[t + k];
+                if (remapMesh[index] != current)
+                {
+                    remapMesh[index] = current;
+                    remap[index] = (unsigned int)meshVertices[current].size();
+                    meshVertices[current].push_back(vertices[index]);
+                }
+                meshIndices[current][i].push_back(remap[index]);
+            }
+        }
+    }
+
+    for (size_t m = 0, meshCount = meshVertices.size(); m < meshCount; ++m)
+    {
+        Mesh* mesh = this;
+        if (m > 0)
+        {
+            mesh = new Mesh();
+            mesh->copyVertexFormat(this);
+            for (size_t i = 0; i < partCount; ++i)
+                mesh->addMeshPart(new MeshPart());
+            meshes.push_back(mesh);
+        }
+        mesh->vertices.swap(meshVertices[m]);
+        mesh->vertexLookupTable.clear();
+        for (unsigned int i = 0, count = (unsigned int)mesh->vertices.size(); i < count; ++i)
+        {
+            mesh->vertexLookupTable[mesh->vertices[i]] = i;
+        }
+        for (size_t i = 0; i < partCount; ++i)
+        {
+            mesh->parts[i]->setIndices(meshIndices[m][i]);
+        }
+    }
+
+    LOG(2, "Split mesh '%s' of %u vertices into %u meshes.\n", getId().c_str(), vertexCount, (unsigned int)meshVertices.size());
+    return meshes;
+}
+
+void Mesh::writeBinaryVertex(const Vertex& vertex, FILE* file) const
+{
+    for (std::vector<VertexElement>::const_iterator i = _vertexFormat.begin(); i != _vertexFormat.end(); ++i)
+    {
+        const Vector3* direction = NULL;
+        const Vector4* values = NULL;
+        switch (i->usage)
+        {
+        case POSITION:
+            if (i->type == TYPE_SHORT)
+            {
+                write((unsigned short)toSnorm16((vertex.position.x - _positionOffset.x) / _positionScale.x), file);
+                write((unsigned short)toSnorm16((vertex.position.y - _positionOffset.y) / _positionScale.y), file);
+                write((unsigned short)toSnorm16((vertex.position.z - _positionOffset.z) / _positionScale.z), file);
+                // w = 1 so that the decode transform applies its offset.
+                write((unsigned short)32767, file);
+            }
+            else
+            {
+                writeVectorBinary(vertex.position, file);
+            }
+            break;
+        case NORMAL:
+            direction = &vertex.normal;
+            break;
+        case TANGENT:
+            direction = &vertex.tangent;
+            break;
+        case BINORMAL:
+            direction = &vertex.binormal;
+            break;
+        case COLOR:
+            values = &vertex.diffuse;
+            break;
+        case BLENDWEIGHTS:
+            {
+                // Round the weights so that they still add up to one.
+                float w[4] = { vertex.blendWeights.x, vertex.blendWeights.y, vertex.blendWeights.z, vertex.blendWeights.w };
+                unsigned char q[4];
+                int total = 0;
+                unsigned int largest = 0;
+                for (unsigned int j = 0; j < 4; ++j)
+                {
+                    q[j] = toUnorm8(w[j]);
+                    total += q[j];
+                    if (w[j] > w[largest])
+                        largest = j;
+                }
+                if (total > 0)
+                    q[largest] = (unsigned char)std::min(std::max((int)q[largest] + 255 - total, 0), 255);
+                for (unsigned int j = 0; j < 4; ++j)
+                    write(q[j], file);
+            }
+            break;
+        case BLENDINDICES:
+            if (i->type == TYPE_UNSIGNED_BYTE)
+            {
+                write((unsigned char)vertex.blendIndices.x, file);
+                write((unsigned char)vertex.blendIndices.y, file);
+                write((unsigned char)vertex.blendIndices.z, file);
+                write((unsigned char)vertex.blendIndices.w, file);
+            }
+            else
+            {
+                writeVectorBinary(vertex.blendIndices, file);
+            }
+            break;
+        default:
+            if (i->usage >= TEXCOORD0 && i->usage <= TEXCOORD7)
+            {
+                const Vector2& uv = vertex.texCoord[i->usage - TEXCOORD0];
+                write(floatToHalf(uv.x), file);
+                write(floatToHalf(uv.y), file);
+            }
+            break;
+        }
+
+        if (direction)
+        {
+            write(toSnorm1010102(direction->x, direction->y, direction->z), file);
+        }
+        else if (values)
+        {
+            write(toUnorm8(values->x), file);
+            write(toUnorm8(values->y), file);
+            write(toUnorm8(values->z), file);
+            write(toUnorm8(values->w), file);
+        }
+    }
+}
+
 }
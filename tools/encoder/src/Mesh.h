@@ -33,6 +33,7 @@ public:
 
     virtual void writeBinary(FILE* file);
     void writeBinaryVertices(FILE* file);
+    virtual void releaseData();
 
     virtual void writeText(FILE* file);
     void writeText(FILE* file, const Vertex& vertex);
@@ -60,11 +61,48 @@ public:
 
     unsigned int getVertexIndex(const Vertex& vertex);
 
+    /**
+     * Returns true if the vertices have normals. Once the mesh is spooled, this is read from its vertex format.
+     */
     bool hasNormals() const;
+
+    /**
+     * Returns true if the vertices have colors. Once the mesh is spooled, this is read from its vertex format.
+     */
     bool hasVertexColors() const;
 
     void computeBounds();
 
+    /**
+     * Switches the vertex format of this mesh to compact types.
+     *
+     * Positions become normalized 16-bit integers relative to the mesh bounds (unless
+     * the mesh is skinned), normals, tangents and binormals 10:10:10:2 normalized
+     * integers, texture coordinates half floats and colors, blend weights and blend
+     * indices 8-bit integers. Positions are snapped to the values the runtime decodes,
+     * so that anything computed from them afterwards matches the rendered mesh.
+     */
+    void quantizeVertices();
+
+    /**
+     * Copies the vertex format of another mesh, including the quantization of its vertices.
+     */
+    void copyVertexFormat(const Mesh* mesh);
+
+    /**
+     * Splits this mesh so that no mesh has more than the given number of vertices.
+     *
+     * Triangles are moved, in order, into meshes that each take as many as fit. This mesh
+     * keeps the first of them and the others are returned; every mesh has the same number of
+     * parts as this one, so the part materials still apply, and parts may end up empty.
+     * Only meshes made of triangle list parts are split.
+     *
+     * @param maxVertexCount The most vertices a mesh may have.
+     *
+     * @return The meshes that were split off, or an empty list if the mesh was not split.
+     */
+    std::vector<Mesh*> split(unsigned int maxVertexCount);
+
     Model* model;
     std::vector<Vertex> vertices;
     std::vector<MeshPart*> parts;
@@ -72,7 +110,16 @@ public:
     std::map<Vertex, unsigned int> vertexLookupTable;
 
 private:
+
+    void writeBinaryVertex(const Vertex& vertex, FILE* file) const;
+
+    bool hasVertexElement(unsigned int usage) const;
+
     std::vector<VertexElement> _vertexFormat;
+    bool _quantized;
+    bool _positionDecode;
+    Vector3 _positionOffset;
+    Vector3 _positionScale;
 
 };
 
@@ -0,0 +1,159 @@
+#include "Base.h"
+#include "MeshBvh.h"
+#include "Mesh.h"
+#include "btBulletCollisionCommon.h"
+
+namespace gameplay
+{
+
+MeshBvh::MeshBvh(Mesh* mesh) : _mesh(mesh)
+{
+    std::string id(mesh->getId());
+    id.append("_bvh");
+    setId(id);
+}
+
+MeshBvh::~MeshBvh(void)
+{
+}
+
+unsigned int MeshBvh::getTypeId(void) const
+{
+    return MESHBVH_ID;
+}
+
+const char* MeshBvh::getElementName(void) const
+{
+    return "MeshBvh";
+}
+
+bool MeshBvh::isSupported(const Mesh* mesh)
+{
+    if (mesh == NULL || mesh->getId().length() == 0 || mesh->getVertexCount() < 3)
+        return false;
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        if (mesh->parts[i]->getIndicesCount() < 3)
+            return false;
+    }
+    return true;
+}
+
+void MeshBvh::build()
+{
+    if (!_data.empty())
+        return;
+
+    // Copy the vertex positions and the indices of each part in the same layout the
+    // runtime gives to Bullet, so the triangle and part indices in the tree match.
+    size_t vertexCount = _mesh->getVertexCount();
+    std::vector<float> positions(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const Vector3& p = _mesh->getVertex((unsigned int)i).position;
+        positions[i * 3 + 0] = p.x;
+        positions[i * 3 + 1] = p.y;
+        positions[i * 3 + 2] = p.z;
+    }
+
+    size_t partCount = _mesh->parts.size();
+    std::vector<std::vector<int> > indices(partCount > 0 ? partCount : 1);
+    if (partCount > 0)
+    {
+        for (size_t i = 0; i < partCount; ++i)
+        {
+            MeshPart* part = _mesh->parts[i];
+            indices[i].resize(part->getIndicesCount());
+            for (size_t j = 0, count = indices[i].size(); j < count; ++j)
+            {
+                indices[i][j] = (int)part->getIndex((unsigned int)j);
+            }
+        }
+    }
+    else
+    {
+        // Meshes without parts are drawn as a triangle list over all vertices.
+        indices[0].resize(vertexCount);
+        for (size_t j = 0; j < vertexCount; ++j)
+        {
+            indices[0][j] = (int)j;
+        }
+    }
+
+    btTriangleIndexVertexArray meshInterface;
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+    {
+        btIndexedMesh indexedMesh;
+        indexedMesh.m_indexType = PHY_INTEGER;
+        indexedMesh.m_numTriangles = (int)indices[i].size() / 3;
+        indexedMesh.m_numVertices = (int)vertexCount;
+        indexedMesh.m_triangleIndexBase = (const unsigned char*)&indices[i][0];
+        indexedMesh.m_triangleIndexStride = sizeof(int) * 3;
+        indexedMesh.m_vertexBase = (const unsigned char*)&positions[0];
+        indexedMesh.m_vertexStride = sizeof(float) * 3;
+        indexedMesh.m_vertexType = PHY_FLOAT;
+        meshInterface.addIndexedMesh(indexedMesh, PHY_INTEGER);
+    }
+
+    btVector3 aabbMin, aabbMax;
+    meshInterface.calculateAabbBruteForce(aabbMin, aabbMax);
+
+    btOptimizedBvh* bvh = new btOptimizedBvh();
+    bvh->build(&meshInterface, true, aabbMin, aabbMax);
+
+    // The buffer is over-allocated by 16 bytes so the tree can be serialized at an aligned address.
+    unsigned int size = bvh->calculateSerializeBufferSize();
+    std::vector<unsigned char> buffer(size + 16);
+    unsigned char* aligned = (unsigned char*)(((size_t)&buffer[0] + 15) & ~(size_t)15);
+    if (bvh->serializeInPlace(aligned, size, false))
+    {
+        _data.assign(aligned, aligned + size);
+    }
+    else
+    {
+        LOG(1, "Warning: Failed to serialize the bounding volume hierarchy for mesh '%s'.\n", _mesh->getId().c_str());
+    }
+
+    delete bvh;
+}
+
+void MeshBvh::writeBinary(FILE* file)
+{
+    if (writeSpooled(file))
+        return;
+    Object::writeBinary(file);
+
+    if (_data.empty())
+        build();
+
+    // The in-place format is only valid for the pointer size, float size, byte order
+    // and Bullet version it was built with, so write them for the runtime to check.
+    unsigned short endianTest = 1;
+    unsigned int platform = (unsigned int)sizeof(void*) | ((unsigned int)sizeof(btScalar) << 8) | ((*(unsigned char*)&endianTest == 0 ? 1u : 0u) << 16);
+    write(platform, file);
+    write((unsigned int)btGetVersion(), file);
+
+    write((unsigned int)_data.size(), file);
+    if (!_data.empty())
+    {
+        fwrite(&_data[0], 1, _data.size(), file);
+    }
+}
+
+void MeshBvh::releaseData()
+{
+    std::vector<unsigned char>().swap(_data);
+}
+
+void MeshBvh::writeText(FILE* file)
+{
+    if (_data.empty())
+        build();
+
+    fprintElementStart(file);
+    fprintfElement(file, "mesh", _mesh->getId());
+    fprintfElement(file, "byteCount", (unsigned int)_data.size());
+    fprintElementEnd(file);
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef MESHBVH_H_
+#define MESHBVH_H_
+
+#include "Base.h"
+#include "Object.h"
+
+namespace gameplay
+{
+
+class Mesh;
+
+/**
+ * A bounding volume hierarchy baked for the triangles of a mesh.
+ *
+ * The hierarchy is built with Bullet (as a quantized btOptimizedBvh) over the same
+ * triangles the runtime uses for mesh collision shapes and written in Bullet's
+ * in-place serialization format, so the runtime can use it without rebuilding.
+ * It is written with the id of its mesh followed by "_bvh".
+ */
+class MeshBvh : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param mesh The mesh to build the hierarchy for.
+     */
+    MeshBvh(Mesh* mesh);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MeshBvh(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+    virtual void releaseData();
+
+    /**
+     * Returns true if a hierarchy can be built for the given mesh.
+     */
+    static bool isSupported(const Mesh* mesh);
+
+    /**
+     * Builds the hierarchy, unless it is already built.
+     *
+     * It is built when the object is written otherwise. The hierarchies of different
+     * meshes can be built on different threads.
+     */
+    void build();
+
+private:
+
+    Mesh* _mesh;
+    std::vector<unsigned char> _data;
+};
+
+}
+
+#endif
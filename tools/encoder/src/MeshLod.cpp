@@ -0,0 +1,68 @@
+#include "Base.h"
+#include "MeshLod.h"
+#include "Mesh.h"
+
+namespace gameplay
+{
+
+MeshLod::MeshLod(Mesh* mesh) : _mesh(mesh)
+{
+    std::string id(mesh->getId());
+    id.append("_lod");
+    setId(id);
+}
+
+MeshLod::~MeshLod(void)
+{
+}
+
+unsigned int MeshLod::getTypeId(void) const
+{
+    return MESHLOD_ID;
+}
+
+const char* MeshLod::getElementName(void) const
+{
+    return "MeshLod";
+}
+
+void MeshLod::addLevel(Mesh* mesh, float screenSize)
+{
+    Level level;
+    level.mesh = mesh;
+    level.screenSize = screenSize;
+    _levels.push_back(level);
+}
+
+unsigned int MeshLod::getLevelCount() const
+{
+    return (unsigned int)_levels.size();
+}
+
+void MeshLod::writeBinary(FILE* file)
+{
+    Object::writeBinary(file);
+
+    write((unsigned int)_levels.size(), file);
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        _levels[i].mesh->writeBinaryXref(file);
+        write(_levels[i].screenSize, file);
+    }
+}
+
+void MeshLod::writeText(FILE* file)
+{
+    fprintElementStart(file);
+    fprintfElement(file, "mesh", _mesh->getId());
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        fprintf(file, "<level>\n");
+        fprintfElement(file, "mesh", _levels[i].mesh->getId());
+        fprintfElement(file, "screenSize", _levels[i].screenSize);
+        fprintf(file, "</level>\n");
+    }
+    fprintElementEnd(file);
+}
+
+}
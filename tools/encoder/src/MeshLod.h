@@ -0,0 +1,68 @@
+#ifndef MESHLOD_H_
+#define MESHLOD_H_
+
+#include "Base.h"
+#include "Object.h"
+
+namespace gameplay
+{
+
+class Mesh;
+
+/**
+ * The simplified levels of detail generated for a mesh.
+ *
+ * Each level references a mesh and the projected screen size (the fraction of the
+ * viewport height covered by the bounding sphere) below which the runtime switches
+ * to it. Levels are ordered from the most to the least detailed.
+ * It is written with the id of its mesh followed by "_lod".
+ */
+class MeshLod : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param mesh The full detail mesh.
+     */
+    MeshLod(Mesh* mesh);
+
+    /**
+     * Destructor.
+     */
+    virtual ~MeshLod(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+
+    /**
+     * Adds a level of detail.
+     *
+     * @param mesh The simplified mesh.
+     * @param screenSize The projected screen size below which the mesh is drawn.
+     */
+    void addLevel(Mesh* mesh, float screenSize);
+
+    /**
+     * Returns the number of levels.
+     */
+    unsigned int getLevelCount() const;
+
+private:
+
+    struct Level
+    {
+        Mesh* mesh;
+        float screenSize;
+    };
+
+    Mesh* _mesh;
+    std::vector<Level> _levels;
+};
+
+}
+
+#endif
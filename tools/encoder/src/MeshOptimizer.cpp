@@ -0,0 +1,281 @@
+#include "Base.h"
+#include "MeshOptimizer.h"
+
+namespace gameplay
+{
+
+/**
+ * A run of triangles that Tipsify emitted without a jump.
+ */
+struct TriangleCluster
+{
+    unsigned int start;
+    unsigned int count;
+    float occlusion;
+
+    bool operator<(const TriangleCluster& c) const
+    {
+        // Clusters facing away from the center occlude the others, so they are drawn first.
+        return occlusion > c.occlusion;
+    }
+};
+
+void MeshOptimizer::optimize(Mesh* mesh, unsigned int cacheSize)
+{
+    assert(mesh);
+
+    if (mesh->parts.empty() || mesh->vertices.empty() || cacheSize == 0)
+        return;
+
+    unsigned int vertexCount = (unsigned int)mesh->vertices.size();
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        MeshPart* part = mesh->parts[i];
+        if (part->getPrimitiveType() != MeshPart::TRIANGLES || part->getIndicesCount() < 3 || part->getIndicesCount() % 3 != 0)
+            continue;
+
+        std::vector<unsigned int> indices(part->getIndices());
+        bool valid = true;
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount && valid; ++j)
+            valid = indices[j] < vertexCount;
+        if (!valid)
+        {
+            LOG(1, "Warning: mesh part %d of mesh '%s' has out of range indices and is not optimized.\n", (int)i, mesh->getId().c_str());
+            continue;
+        }
+
+        float before = getCacheMissRatio(indices, cacheSize);
+        reorderTriangles(mesh, indices, cacheSize);
+        LOG(3, "Vertex cache miss ratio of part %d of mesh '%s': %.3f -> %.3f\n", (int)i, mesh->getId().c_str(), before, getCacheMissRatio(indices, cacheSize));
+        part->setIndices(indices);
+    }
+
+    reorderVertices(mesh);
+}
+
+float MeshOptimizer::getCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int cacheSize)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+
+    unsigned int maxIndex = *std::max_element(indices.begin(), indices.end());
+
+    // A vertex stays in the FIFO for cacheSize misses after its own.
+    std::vector<unsigned int> insertedAt(maxIndex + 1, UINT_MAX);
+    unsigned int misses = 0;
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+    {
+        unsigned int v = indices[i];
+        if (insertedAt[v] == UINT_MAX || misses - insertedAt[v] > cacheSize)
+        {
+            insertedAt[v] = misses;
+            ++misses;
+        }
+    }
+    return (float)misses / (float)(indices.size() / 3);
+}
+
+void MeshOptimizer::reorderTriangles(const Mesh* mesh, std::vector<unsigned int>& indices, unsigned int cacheSize)
+{
+    unsigned int triangleCount = (unsigned int)indices.size() / 3;
+    unsigned int vertexCount = (unsigned int)mesh->vertices.size();
+
+    // The triangles of every vertex, and the number of them that are not emitted yet.
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+        ++offsets[indices[i] + 1];
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0, count = indices.size(); i < count; ++i)
+        adjacency[fill[indices[i]]++] = (unsigned int)i / 3;
+    std::vector<int> live(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        live[v] = (int)(offsets[v + 1] - offsets[v]);
+
+    // Tipsify: emit all triangles around a fanning vertex, then continue with the vertex
+    // among the ones just emitted that is still in the cache and has the fewest triangles left.
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> clusterStarts(1, 0);
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    int fanning = (int)indices[0];
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        for (unsigned int k = offsets[fanning]; k < offsets[fanning + 1]; ++k)
+        {
+            unsigned int t = adjacency[k];
+            if (emitted[t])
+                continue;
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                unsigned int v = indices[t * 3 + j];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = time;
+                    ++time;
+                }
+            }
+            emitted[t] = true;
+        }
+
+        int next = -1;
+        int bestPriority = -1;
+        for (size_t i = 0, count = candidates.size(); i < count; ++i)
+        {
+            unsigned int v = candidates[i];
+            if (live[v] <= 0)
+                continue;
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+                priority = (int)(time - cacheTime[v]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = (int)v;
+            }
+        }
+
+        if (next < 0)
+        {
+            // Dead end: continue with a recently used vertex, or the next one in order. This is a jump.
+            while (next < 0 && !deadEnds.empty())
+            {
+                unsigned int v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0)
+                    next = (int)v;
+            }
+            while (next < 0 && cursor < vertexCount)
+            {
+                if (live[cursor] > 0)
+                    next = (int)cursor;
+                ++cursor;
+            }
+            if (next >= 0)
+                clusterStarts.push_back((unsigned int)output.size() / 3);
+        }
+        fanning = next;
+    }
+    assert(output.size() == indices.size());
+
+    // Clusters smaller than the cache are merged into the previous one, they gain little from being sorted.
+    std::vector<TriangleCluster> clusters;
+    for (size_t i = 0, count = clusterStarts.size(); i < count; ++i)
+    {
+        unsigned int end = i + 1 < count ? clusterStarts[i + 1] : triangleCount;
+        unsigned int size = end - clusterStarts[i];
+        if (!clusters.empty() && clusters.back().count < cacheSize)
+        {
+            clusters.back().count += size;
+        }
+        else
+        {
+            TriangleCluster cluster;
+            cluster.start = clusterStarts[i];
+            cluster.count = size;
+            cluster.occlusion = 0.0f;
+            clusters.push_back(cluster);
+        }
+    }
+
+    if (clusters.size() > 1)
+    {
+        // Area weighted centroid of the part and of every cluster.
+        std::vector<Vector3> centroids(clusters.size());
+        std::vector<Vector3> normals(clusters.size());
+        Vector3 center;
+        float totalArea = 0.0f;
+        for (size_t c = 0, count = clusters.size(); c < count; ++c)
+        {
+            float clusterArea = 0.0f;
+            for (unsigned int t = clusters[c].start; t < clusters[c].start + clusters[c].count; ++t)
+            {
+                const Vector3& p0 = mesh->vertices[output[t * 3]].position;
+                const Vector3& p1 = mesh->vertices[output[t * 3 + 1]].position;
+                const Vector3& p2 = mesh->vertices[output[t * 3 + 2]].position;
+                Vector3 normal;
+                Vector3::cross(Vector3(p0, p1), Vector3(p0, p2), &normal);
+                float area = normal.length();
+                Vector3 centroid((p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f);
+                centroids[c] += centroid * area;
+                normals[c] += normal;
+                clusterArea += area;
+            }
+            center += centroids[c];
+            totalArea += clusterArea;
+            if (clusterArea > 0.0f)
+                centroids[c] *= 1.0f / clusterArea;
+        }
+        if (totalArea > 0.0f)
+            center *= 1.0f / totalArea;
+
+        for (size_t c = 0, count = clusters.size(); c < count; ++c)
+        {
+            Vector3 normal = normals[c];
+            if (normal.lengthSquared() > 0.0f)
+                normal.normalize();
+            clusters[c].occlusion = Vector3::dot(Vector3(center, centroids[c]), normal);
+        }
+        std::stable_sort(clusters.begin(), clusters.end());
+    }
+
+    indices.clear();
+    for (size_t c = 0, count = clusters.size(); c < count; ++c)
+        indices.insert(indices.end(), output.begin() + clusters[c].start * 3, output.begin() + (clusters[c].start + clusters[c].count) * 3);
+}
+
+void MeshOptimizer::reorderVertices(Mesh* mesh)
+{
+    // Vertices are numbered in the order in which the parts first use them, unused ones go last.
+    unsigned int vertexCount = (unsigned int)mesh->vertices.size();
+    std::vector<unsigned int> remap(vertexCount, UINT_MAX);
+    unsigned int next = 0;
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        const std::vector<unsigned int>& indices = mesh->parts[i]->getIndices();
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            if (indices[j] < vertexCount && remap[indices[j]] == UINT_MAX)
+                remap[indices[j]] = next++;
+        }
+    }
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] == UINT_MAX)
+            remap[v] = next++;
+    }
+
+    std::vector<Vertex> vertices(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        vertices[remap[v]] = mesh->vertices[v];
+    mesh->vertices.swap(vertices);
+
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        std::vector<unsigned int> indices(mesh->parts[i]->getIndices());
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            if (indices[j] < vertexCount)
+                indices[j] = remap[indices[j]];
+        }
+        mesh->parts[i]->setIndices(indices);
+    }
+
+    mesh->vertexLookupTable.clear();
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        mesh->vertexLookupTable[mesh->vertices[v]] = v;
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef MESHOPTIMIZER_H_
+#define MESHOPTIMIZER_H_
+
+#include "Mesh.h"
+
+namespace gameplay
+{
+
+/**
+ * Reorders the triangles and vertices of a mesh for the GPU.
+ *
+ * The triangles of every triangle list part are reordered with Tipsify (Sander, Nehab
+ * and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw") for
+ * a post-transform vertex cache of the given size. The runs of triangles that Tipsify
+ * emits between two jumps are then ordered as clusters, those facing away from the center
+ * of the part first, so that front most surfaces tend to be drawn before the surfaces they
+ * hide. Finally the vertices are stored in the order in which the parts first use them,
+ * which keeps the vertex fetches sequential.
+ */
+class MeshOptimizer
+{
+public:
+
+    /**
+     * Optimizes a mesh.
+     *
+     * Meshes without parts are left as they are, since their vertices are their triangles.
+     *
+     * @param mesh The mesh to optimize.
+     * @param cacheSize The number of entries of the vertex cache to optimize for.
+     */
+    static void optimize(Mesh* mesh, unsigned int cacheSize);
+
+    /**
+     * Returns the average number of vertex cache misses per triangle (ACMR) of a triangle list
+     * for a FIFO cache of the given size.
+     */
+    static float getCacheMissRatio(const std::vector<unsigned int>& indices, unsigned int cacheSize);
+
+private:
+
+    static void reorderTriangles(const Mesh* mesh, std::vector<unsigned int>& indices, unsigned int cacheSize);
+
+    static void reorderVertices(Mesh* mesh);
+};
+
+}
+
+#endif
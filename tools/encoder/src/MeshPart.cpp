@@ -34,10 +34,17 @@ void MeshPart::writeBinary(FILE* file)
     // write the number of bytes
     write(indicesByteSize(), file);
     // for each index
+    FILE* section = beginSection(file);
     for (std::vector<unsigned int>::const_iterator i = _indices.begin(); i != _indices.end(); ++i)
     {
-        writeBinaryIndex(*i, file);
+        writeBinaryIndex(*i, section);
     }
+    endSection(section, file);
+}
+
+void MeshPart::releaseData()
+{
+    std::vector<unsigned int>().swap(_indices);
 }
 
 void MeshPart::writeText(FILE* file)
@@ -86,6 +93,27 @@ unsigned int MeshPart::getIndex(unsigned int i) const
     return _indices[i];
 }
 
+const std::vector<unsigned int>& MeshPart::getIndices() const
+{
+    return _indices;
+}
+
+void MeshPart::setIndices(const std::vector<unsigned int>& indices)
+{
+    _indexFormat = INDEX16;
+    _indices.clear();
+    _indices.reserve(indices.size());
+    for (std::vector<unsigned int>::const_iterator i = indices.begin(); i != indices.end(); ++i)
+    {
+        addIndex(*i);
+    }
+}
+
+unsigned int MeshPart::getPrimitiveType() const
+{
+    return _primitiveType;
+}
+
 void MeshPart::writeBinaryIndex(unsigned int index, FILE* file)
 {
     switch (_indexFormat)
@@ -41,6 +41,7 @@ public:
     virtual const char* getElementName(void) const;
     virtual void writeBinary(FILE* file);
     virtual void writeText(FILE* file);
+    virtual void releaseData();
 
     /**
      * Adds an index to the list of indices.
@@ -62,6 +63,21 @@ public:
      */
     unsigned int getIndex(unsigned int i) const;
 
+    /**
+     * Returns the indices.
+     */
+    const std::vector<unsigned int>& getIndices() const;
+
+    /**
+     * Replaces the indices and updates the index format to fit them.
+     */
+    void setIndices(const std::vector<unsigned int>& indices);
+
+    /**
+     * Returns the primitive type.
+     */
+    unsigned int getPrimitiveType() const;
+
 private:
 
     /**
@@ -0,0 +1,327 @@
+#include "Base.h"
+#include "MeshSimplifier.h"
+#include <queue>
+
+namespace gameplay
+{
+
+/**
+ * A symmetric 4x4 matrix that sums the squared distances to a set of planes.
+ */
+struct Quadric
+{
+    // a^2, ab, ac, ad, b^2, bc, bd, c^2, cd, d^2
+    double q[10];
+
+    Quadric()
+    {
+        for (unsigned int i = 0; i < 10; ++i)
+            q[i] = 0.0;
+    }
+
+    void addPlane(double a, double b, double c, double d, double weight)
+    {
+        q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c; q[3] += weight * a * d;
+        q[4] += weight * b * b; q[5] += weight * b * c; q[6] += weight * b * d;
+        q[7] += weight * c * c; q[8] += weight * c * d;
+        q[9] += weight * d * d;
+    }
+
+    void add(const Quadric& other)
+    {
+        for (unsigned int i = 0; i < 10; ++i)
+            q[i] += other.q[i];
+    }
+
+    double evaluate(const Vector3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+            q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+            q[7] * z * z + 2.0 * q[8] * z +
+            q[9];
+    }
+};
+
+/**
+ * A candidate collapse of the vertex 'from' onto the vertex 'to'.
+ */
+struct Collapse
+{
+    double cost;
+    unsigned int from;
+    unsigned int to;
+    unsigned int fromVersion;
+    unsigned int toVersion;
+
+    bool operator<(const Collapse& c) const
+    {
+        // Lowest cost first in a std::priority_queue.
+        return cost > c.cost;
+    }
+};
+
+static Vector3 triangleNormal(const Vector3& p0, const Vector3& p1, const Vector3& p2)
+{
+    Vector3 normal;
+    Vector3::cross(Vector3(p0, p1), Vector3(p0, p2), &normal);
+    return normal;
+}
+
+static void pushCollapse(std::priority_queue<Collapse>& collapses, const Mesh* mesh, const std::vector<Quadric>& quadrics,
+    const std::vector<unsigned int>& versions, unsigned int from, unsigned int to)
+{
+    Quadric q = quadrics[from];
+    q.add(quadrics[to]);
+    Collapse c;
+    c.cost = q.evaluate(mesh->vertices[to].position);
+    c.from = from;
+    c.to = to;
+    c.fromVersion = versions[from];
+    c.toVersion = versions[to];
+    collapses.push(c);
+}
+
+unsigned int MeshSimplifier::getTriangleCount(const Mesh* mesh)
+{
+    unsigned int count = 0;
+    for (size_t i = 0, partCount = mesh->parts.size(); i < partCount; ++i)
+    {
+        if (mesh->parts[i]->getPrimitiveType() == MeshPart::TRIANGLES)
+            count += (unsigned int)mesh->parts[i]->getIndicesCount() / 3;
+    }
+    return count;
+}
+
+Mesh* MeshSimplifier::simplify(const Mesh* mesh, float ratio)
+{
+    assert(mesh);
+
+    unsigned int vertexCount = (unsigned int)mesh->vertices.size();
+    if (mesh->parts.empty() || vertexCount == 0 || ratio <= 0.0f || ratio >= 1.0f)
+        return NULL;
+
+    // Gather the triangles of all parts.
+    std::vector<unsigned int> triangles;
+    std::vector<unsigned int> trianglePart;
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        const MeshPart* part = mesh->parts[i];
+        const std::vector<unsigned int>& indices = part->getIndices();
+        if (part->getPrimitiveType() != MeshPart::TRIANGLES || indices.size() % 3 != 0)
+        {
+            LOG(1, "Warning: mesh '%s' has parts that are not triangle lists and is not simplified.\n", mesh->getId().c_str());
+            return NULL;
+        }
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            if (indices[j] >= vertexCount)
+            {
+                LOG(1, "Warning: mesh '%s' has out of range indices and is not simplified.\n", mesh->getId().c_str());
+                return NULL;
+            }
+            triangles.push_back(indices[j]);
+        }
+        trianglePart.insert(trianglePart.end(), indices.size() / 3, (unsigned int)i);
+    }
+    unsigned int triangleCount = (unsigned int)trianglePart.size();
+    unsigned int targetCount = std::max((unsigned int)(triangleCount * ratio), 1u);
+    if (targetCount >= triangleCount)
+        return NULL;
+
+    // Lock the vertices on attribute seams and open borders.
+    std::vector<bool> locked(vertexCount, false);
+    std::map<Vector3, unsigned int> positionCount;
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        ++positionCount[mesh->vertices[v].position];
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        locked[v] = positionCount[mesh->vertices[v].position] > 1;
+
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edgeCount;
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        for (unsigned int e = 0; e < 3; ++e)
+        {
+            unsigned int a = triangles[t * 3 + e];
+            unsigned int b = triangles[t * 3 + (e + 1) % 3];
+            ++edgeCount[std::make_pair(std::min(a, b), std::max(a, b))];
+        }
+    }
+    for (std::map<std::pair<unsigned int, unsigned int>, unsigned int>::const_iterator i = edgeCount.begin(); i != edgeCount.end(); ++i)
+    {
+        if (i->second == 1)
+        {
+            locked[i->first.first] = true;
+            locked[i->first.second] = true;
+        }
+    }
+
+    // Area weighted plane quadrics and triangle adjacency of each vertex.
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<unsigned int> > vertexTriangles(vertexCount);
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        const Vector3& p0 = mesh->vertices[triangles[t * 3]].position;
+        const Vector3& p1 = mesh->vertices[triangles[t * 3 + 1]].position;
+        const Vector3& p2 = mesh->vertices[triangles[t * 3 + 2]].position;
+        Vector3 normal = triangleNormal(p0, p1, p2);
+        double area = normal.length();
+        if (area > 0.0)
+        {
+            double a = normal.x / area, b = normal.y / area, c = normal.z / area;
+            double d = -(a * p0.x + b * p0.y + c * p0.z);
+            for (unsigned int k = 0; k < 3; ++k)
+                quadrics[triangles[t * 3 + k]].addPlane(a, b, c, d, area);
+        }
+        for (unsigned int k = 0; k < 3; ++k)
+            vertexTriangles[triangles[t * 3 + k]].push_back(t);
+    }
+
+    std::vector<unsigned int> versions(vertexCount, 0);
+    std::vector<bool> removedTriangles(triangleCount, false);
+    std::vector<bool> removedVertices(vertexCount, false);
+    std::priority_queue<Collapse> collapses;
+
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+        for (unsigned int e = 0; e < 3; ++e)
+        {
+            unsigned int a = triangles[t * 3 + e];
+            unsigned int b = triangles[t * 3 + (e + 1) % 3];
+            if (!locked[a])
+                pushCollapse(collapses, mesh, quadrics, versions, a, b);
+            if (!locked[b])
+                pushCollapse(collapses, mesh, quadrics, versions, b, a);
+        }
+    }
+
+    unsigned int liveCount = triangleCount;
+    while (liveCount > targetCount && !collapses.empty())
+    {
+        Collapse c = collapses.top();
+        collapses.pop();
+        unsigned int u = c.from;
+        unsigned int v = c.to;
+        if (removedVertices[u] || removedVertices[v] || versions[u] != c.fromVersion || versions[v] != c.toVersion)
+            continue;
+
+        // The edge must still exist and no remaining triangle of u may flip or degenerate.
+        const Vector3& target = mesh->vertices[v].position;
+        bool adjacent = false;
+        bool valid = true;
+        std::vector<unsigned int>& uTriangles = vertexTriangles[u];
+        for (size_t i = 0, count = uTriangles.size(); i < count && valid; ++i)
+        {
+            unsigned int t = uTriangles[i];
+            if (removedTriangles[t])
+                continue;
+            const unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+            {
+                adjacent = true;
+                continue;
+            }
+            Vector3 p[3];
+            for (unsigned int k = 0; k < 3; ++k)
+                p[k] = mesh->vertices[tri[k]].position;
+            Vector3 before = triangleNormal(p[0], p[1], p[2]);
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                if (tri[k] == u)
+                    p[k] = target;
+            }
+            Vector3 after = triangleNormal(p[0], p[1], p[2]);
+            valid = after.lengthSquared() > 0.0f && Vector3::dot(before, after) > 0.0f;
+        }
+        if (!adjacent || !valid)
+            continue;
+
+        // Move u onto v.
+        std::vector<unsigned int>& vTriangles = vertexTriangles[v];
+        for (size_t i = 0, count = uTriangles.size(); i < count; ++i)
+        {
+            unsigned int t = uTriangles[i];
+            if (removedTriangles[t])
+                continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+            {
+                removedTriangles[t] = true;
+                --liveCount;
+            }
+            else
+            {
+                for (unsigned int k = 0; k < 3; ++k)
+                {
+                    if (tri[k] == u)
+                        tri[k] = v;
+                }
+                vTriangles.push_back(t);
+            }
+        }
+        uTriangles.clear();
+        removedVertices[u] = true;
+        quadrics[v].add(quadrics[u]);
+        ++versions[v];
+
+        // Drop the removed triangles of v and requeue the collapses around it.
+        size_t live = 0;
+        for (size_t i = 0, count = vTriangles.size(); i < count; ++i)
+        {
+            if (!removedTriangles[vTriangles[i]])
+                vTriangles[live++] = vTriangles[i];
+        }
+        vTriangles.resize(live);
+        for (size_t i = 0; i < live; ++i)
+        {
+            const unsigned int* tri = &triangles[vTriangles[i] * 3];
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                unsigned int w = tri[k];
+                if (w == v)
+                    continue;
+                if (!locked[v])
+                    pushCollapse(collapses, mesh, quadrics, versions, v, w);
+                if (!locked[w])
+                    pushCollapse(collapses, mesh, quadrics, versions, w, v);
+            }
+        }
+    }
+
+    if (liveCount == triangleCount)
+        return NULL;
+
+    // Build the simplified mesh from the vertices still in use, in order of first use.
+    Mesh* lod = new Mesh();
+    lod->copyVertexFormat(mesh);
+    lod->bounds = mesh->bounds;
+    std::vector<unsigned int> remap(vertexCount, UINT_MAX);
+    for (size_t i = 0, count = mesh->parts.size(); i < count; ++i)
+    {
+        std::vector<unsigned int> indices;
+        for (unsigned int t = 0; t < triangleCount; ++t)
+        {
+            if (removedTriangles[t] || trianglePart[t] != i)
+                continue;
+            for (unsigned int k = 0; k < 3; ++k)
+            {
+                unsigned int index = triangles[t * 3 + k];
+                if (remap[index] == UINT_MAX)
+                {
+                    remap[index] = (unsigned int)lod->vertices.size();
+                    lod->vertices.push_back(mesh->vertices[index]);
+                    lod->vertexLookupTable[mesh->vertices[index]] = remap[index];
+                }
+                indices.push_back(remap[index]);
+            }
+        }
+        MeshPart* part = new MeshPart();
+        part->setIndices(indices);
+        lod->addMeshPart(part);
+    }
+
+    LOG(2, "Simplified mesh '%s' from %u to %u triangles.\n", mesh->getId().c_str(), triangleCount, liveCount);
+    return lod;
+}
+
+}
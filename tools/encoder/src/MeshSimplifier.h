@@ -0,0 +1,44 @@
+#ifndef MESHSIMPLIFIER_H_
+#define MESHSIMPLIFIER_H_
+
+#include "Mesh.h"
+
+namespace gameplay
+{
+
+/**
+ * Generates simplified versions of a mesh for levels of detail.
+ *
+ * Triangles are removed with quadric error metric edge collapses (Garland and Heckbert,
+ * "Surface Simplification Using Quadric Error Metrics"). Each collapse moves a vertex onto
+ * one of its neighbours rather than to a new position, so the simplified mesh reuses the
+ * original vertices and keeps all of their attributes, blend weights included. Vertices on
+ * open borders and on attribute seams (vertices sharing a position with another vertex)
+ * never move, which keeps silhouettes, UV islands and hard edges intact.
+ */
+class MeshSimplifier
+{
+public:
+
+    /**
+     * Creates a simplified copy of a mesh.
+     *
+     * The copy has the same vertex format and number of parts as the mesh; parts may end up
+     * with no triangles. Only meshes made of triangle list parts are simplified.
+     *
+     * @param mesh The mesh to simplify.
+     * @param ratio The fraction of the triangles to keep, in (0, 1).
+     *
+     * @return The simplified mesh, or NULL if the mesh cannot be simplified below its triangle count.
+     */
+    static Mesh* simplify(const Mesh* mesh, float ratio);
+
+    /**
+     * Returns the number of triangles in the triangle list parts of a mesh.
+     */
+    static unsigned int getTriangleCount(const Mesh* mesh);
+};
+
+}
+
+#endif
@@ -47,8 +47,8 @@ void MeshSkin::writeBinary(FILE* file)
         write(i->m, 16, file);
     }
 
-    /*
-    // Write joint bounding spheres
+    // Write the bounding sphere of the vertices each joint influences, so that the runtime
+    // can bound the skin in its current pose; there are none if the bounds were not computed.
     write((unsigned int)_jointBounds.size(), file);
     for (unsigned int i = 0; i < _jointBounds.size(); ++i)
     {
@@ -58,7 +58,6 @@ void MeshSkin::writeBinary(FILE* file)
         write(v.center.z, file);
         write(v.radius, file);
     }
-    */
 }
 
 void MeshSkin::writeText(FILE* file)
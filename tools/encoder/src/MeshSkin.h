@@ -16,6 +16,7 @@ class Mesh;
 class MeshSkin : public Object
 {
     friend class Model;
+    friend class VertexAnimation;
 
 public:
 
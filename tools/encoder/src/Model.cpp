@@ -152,4 +152,24 @@ void Model::setMaterial(Material* material, int partIndex)
     }
 }
 
+Material* Model::getMaterial(unsigned int partIndex) const
+{
+    if (_materials.empty())
+        return _material;
+    return partIndex < _materials.size() ? _materials[partIndex] : NULL;
+}
+
+void Model::replaceMaterial(Material* material, Material* replacement)
+{
+    if (_material == material)
+        _material = replacement;
+    std::replace(_materials.begin(), _materials.end(), material, replacement);
+}
+
+void Model::copyMaterials(const Model* model)
+{
+    _material = model->_material;
+    _materials = model->_materials;
+}
+
 }
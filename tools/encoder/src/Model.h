@@ -34,6 +34,21 @@ public:
     void setSkin(MeshSkin* skin);
     void setMaterial(Material* material, int partIndex = -1);
 
+    /**
+     * Returns the material that the mesh part at the given index is drawn with, or NULL if it has none.
+     */
+    Material* getMaterial(unsigned int partIndex) const;
+
+    /**
+     * Replaces a material of this model, wherever it is used, with another one.
+     */
+    void replaceMaterial(Material* material, Material* replacement);
+
+    /**
+     * Gives this model the same materials as another model.
+     */
+    void copyMaterials(const Model* model);
+
 private:
 
     Mesh* _mesh;
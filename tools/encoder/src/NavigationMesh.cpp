@@ -0,0 +1,257 @@
+#include "Base.h"
+#include "NavigationMesh.h"
+#include "NormalMapGenerator.h"
+#include "GPBFile.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Matrix.h"
+
+// Vertices closer than this along every axis are welded, in world units.
+#define NAVIGATION_WELD_DISTANCE 0.001f
+
+// The link of an edge that no other triangle shares.
+#define NAVIGATION_NO_LINK 0xFFFFFFFF
+
+namespace gameplay
+{
+
+/**
+ * A welded vertex position, in multiples of the weld distance.
+ */
+struct WeldKey
+{
+    long long x, y, z;
+
+    bool operator<(const WeldKey& key) const
+    {
+        if (x != key.x)
+            return x < key.x;
+        if (y != key.y)
+            return y < key.y;
+        return z < key.z;
+    }
+};
+
+NavigationMesh::NavigationMesh(float maxSlope) : _built(false)
+{
+    maxSlope = std::min(std::max(maxSlope, 0.0f), 89.9f);
+    _minNormalY = cos(MATH_DEG_TO_RAD(maxSlope));
+    setId("navmesh");
+}
+
+NavigationMesh::~NavigationMesh(void)
+{
+}
+
+unsigned int NavigationMesh::getTypeId(void) const
+{
+    return NAVIGATIONMESH_ID;
+}
+
+const char* NavigationMesh::getElementName(void) const
+{
+    return "NavigationMesh";
+}
+
+void NavigationMesh::addTriangle(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+    // Keep the triangles that face up and are not too steep.
+    Vector3 normal;
+    Vector3::cross(Vector3(b.x - a.x, b.y - a.y, b.z - a.z), Vector3(c.x - a.x, c.y - a.y, c.z - a.z), &normal);
+    float length = normal.length();
+    if (length <= 0.0f || normal.y < _minNormalY * length)
+        return;
+
+    _corners.push_back(a);
+    _corners.push_back(b);
+    _corners.push_back(c);
+    _built = false;
+}
+
+void NavigationMesh::addMesh(const Mesh* mesh, const Matrix& worldMatrix)
+{
+    assert(mesh);
+
+    for (size_t i = 0, partCount = mesh->parts.size(); i < partCount; ++i)
+    {
+        const MeshPart* part = mesh->parts[i];
+        unsigned int primitiveType = part->getPrimitiveType();
+        if (primitiveType != MeshPart::TRIANGLES && primitiveType != MeshPart::TRIANGLE_STRIP)
+            continue;
+
+        unsigned int indexCount = (unsigned int)part->getIndicesCount();
+        unsigned int step = primitiveType == MeshPart::TRIANGLES ? 3 : 1;
+        for (unsigned int j = 0; j + 2 < indexCount; j += step)
+        {
+            Vector3 a, b, c;
+            worldMatrix.transformPoint(mesh->vertices[part->getIndex(j)].position, &a);
+            worldMatrix.transformPoint(mesh->vertices[part->getIndex(j + 1)].position, &b);
+            worldMatrix.transformPoint(mesh->vertices[part->getIndex(j + 2)].position, &c);
+
+            // Every other triangle of a strip is wound the other way.
+            if (step == 1 && (j & 1) != 0)
+                addTriangle(a, c, b);
+            else
+                addTriangle(a, b, c);
+        }
+    }
+}
+
+void NavigationMesh::addHeightmap(const float* heights, int width, int height, const Vector3& worldSize)
+{
+    assert(heights);
+    assert(width > 1 && height > 1);
+
+    const float stepX = worldSize.x / (width - 1);
+    const float stepZ = worldSize.z / (height - 1);
+    const float originX = -worldSize.x * 0.5f;
+    const float originZ = -worldSize.z * 0.5f;
+    for (int z = 0; z + 1 < height; ++z)
+    {
+        for (int x = 0; x + 1 < width; ++x)
+        {
+            Vector3 a(originX + x * stepX, heights[z * width + x] * worldSize.y, originZ + z * stepZ);
+            Vector3 b(a.x, heights[(z + 1) * width + x] * worldSize.y, a.z + stepZ);
+            Vector3 c(a.x + stepX, heights[z * width + x + 1] * worldSize.y, a.z);
+            Vector3 d(c.x, heights[(z + 1) * width + x + 1] * worldSize.y, b.z);
+            addTriangle(a, b, c);
+            addTriangle(c, b, d);
+        }
+    }
+}
+
+void NavigationMesh::build()
+{
+    if (_built)
+        return;
+    _built = true;
+
+    // Weld the corners of the triangles, dropping the triangles that collapse.
+    _vertices.clear();
+    _triangles.clear();
+    std::map<WeldKey, unsigned int> welded;
+    for (size_t i = 0, count = _corners.size(); i < count; i += 3)
+    {
+        unsigned int indices[3];
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            const Vector3& corner = _corners[i + j];
+            WeldKey key;
+            key.x = (long long)floor(corner.x / NAVIGATION_WELD_DISTANCE + 0.5f);
+            key.y = (long long)floor(corner.y / NAVIGATION_WELD_DISTANCE + 0.5f);
+            key.z = (long long)floor(corner.z / NAVIGATION_WELD_DISTANCE + 0.5f);
+            std::map<WeldKey, unsigned int>::const_iterator itr = welded.find(key);
+            if (itr != welded.end())
+            {
+                indices[j] = itr->second;
+            }
+            else
+            {
+                indices[j] = (unsigned int)(_vertices.size() / 3);
+                welded[key] = indices[j];
+                _vertices.push_back(corner.x);
+                _vertices.push_back(corner.y);
+                _vertices.push_back(corner.z);
+            }
+        }
+        if (indices[0] != indices[1] && indices[1] != indices[2] && indices[2] != indices[0])
+            _triangles.insert(_triangles.end(), indices, indices + 3);
+    }
+
+    // Link the triangles that share an edge; an edge shared by more than two triangles only links the first two.
+    _links.assign(_triangles.size(), NAVIGATION_NO_LINK);
+    std::map<std::pair<unsigned int, unsigned int>, unsigned int> edges;
+    for (unsigned int i = 0, count = (unsigned int)_triangles.size(); i < count; ++i)
+    {
+        unsigned int a = _triangles[i];
+        unsigned int b = _triangles[i % 3 == 2 ? i - 2 : i + 1];
+        std::pair<unsigned int, unsigned int> edge(std::min(a, b), std::max(a, b));
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int>::iterator itr = edges.find(edge);
+        if (itr == edges.end())
+        {
+            edges[edge] = i;
+        }
+        else if (itr->second != NAVIGATION_NO_LINK && _links[itr->second] == NAVIGATION_NO_LINK)
+        {
+            _links[i] = itr->second / 3;
+            _links[itr->second] = i / 3;
+            itr->second = NAVIGATION_NO_LINK;
+        }
+    }
+
+    _corners.clear();
+}
+
+unsigned int NavigationMesh::getTriangleCount() const
+{
+    return _built ? (unsigned int)(_triangles.size() / 3) : (unsigned int)(_corners.size() / 3);
+}
+
+void NavigationMesh::writeBinary(FILE* file)
+{
+    build();
+
+    Object::writeBinary(file);
+
+    write((unsigned int)_vertices.size(), file);
+    write(_vertices.empty() ? NULL : &_vertices[0], (int)_vertices.size(), file);
+    write((unsigned int)_triangles.size(), file);
+    for (size_t i = 0, count = _triangles.size(); i < count; ++i)
+    {
+        write(_triangles[i], file);
+    }
+    write((unsigned int)_links.size(), file);
+    for (size_t i = 0, count = _links.size(); i < count; ++i)
+    {
+        write(_links[i], file);
+    }
+}
+
+void NavigationMesh::writeText(FILE* file)
+{
+    build();
+
+    fprintElementStart(file);
+    fprintfElement(file, "vertexCount", (unsigned int)(_vertices.size() / 3));
+    fprintfElement(file, "triangleCount", (unsigned int)(_triangles.size() / 3));
+    fprintElementEnd(file);
+}
+
+bool NavigationMesh::encodeHeightmap(const char* inputFile, const char* outputFile, int resolutionX, int resolutionY,
+                                     const Vector3& worldSize, float maxSlope)
+{
+    if (worldSize.x <= 0 || worldSize.y <= 0 || worldSize.z <= 0)
+    {
+        LOG(1, "Error: the navigation mesh of a heightmap needs the world size of the terrain (-w).\n");
+        return false;
+    }
+    float* heights = NormalMapGenerator::loadHeights(inputFile, &resolutionX, &resolutionY);
+    if (heights == NULL)
+        return false;
+    if (resolutionX < 2 || resolutionY < 2)
+    {
+        LOG(1, "Error: heightmap must be at least 2x2 pixels: %s.\n", inputFile);
+        delete[] heights;
+        return false;
+    }
+
+    NavigationMesh* navigationMesh = new NavigationMesh(maxSlope);
+    navigationMesh->addHeightmap(heights, resolutionX, resolutionY, worldSize);
+    delete[] heights;
+    navigationMesh->build();
+    LOG(1, "Navigation mesh: %u walkable triangles.\n", navigationMesh->getTriangleCount());
+
+    GPBFile bundle;
+    bundle.addToRefTable(navigationMesh);
+    bundle.add(navigationMesh);
+    bool saved = bundle.saveBinary(outputFile);
+    SAFE_DELETE(navigationMesh);
+    if (!saved)
+    {
+        LOG(1, "Error: failed to write file: %s.\n", outputFile);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef NAVIGATIONMESH_H_
+#define NAVIGATIONMESH_H_
+
+#include "Base.h"
+#include "Object.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+class Matrix;
+class Mesh;
+
+/**
+ * The walkable surface of a scene or terrain, for the path finding of AI agents.
+ *
+ * The surface is made of the triangles of the input geometry whose normal is no steeper
+ * than a maximum slope. Their vertices are welded and each triangle is linked to the
+ * triangles it shares an edge with, so the runtime searches paths over the triangles
+ * without processing the geometry. The triangles are wound counterclockwise seen from
+ * above. The object is written with the id "navmesh".
+ */
+class NavigationMesh : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param maxSlope The steepest slope that is walkable, in degrees.
+     */
+    NavigationMesh(float maxSlope);
+
+    /**
+     * Destructor.
+     */
+    virtual ~NavigationMesh(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+
+    /**
+     * Adds the walkable triangles of a mesh.
+     *
+     * @param mesh The mesh.
+     * @param worldMatrix The world matrix of the node the mesh is drawn by.
+     */
+    void addMesh(const Mesh* mesh, const Matrix& worldMatrix);
+
+    /**
+     * Adds the walkable triangles of a heightmap, in the space of a terrain of the given size
+     * centered on the origin, two triangles per quad of samples.
+     *
+     * @param heights The normalized heights, row by row.
+     * @param width The number of samples along X.
+     * @param height The number of samples along Z.
+     * @param worldSize The size of the terrain along X, Y and Z.
+     */
+    void addHeightmap(const float* heights, int width, int height, const Vector3& worldSize);
+
+    /**
+     * Welds the vertices of the triangles and links the triangles, unless it is already done.
+     */
+    void build();
+
+    /**
+     * Returns the number of walkable triangles.
+     */
+    unsigned int getTriangleCount() const;
+
+    /**
+     * Writes a bundle that holds the navigation mesh of a heightmap.
+     *
+     * @param inputFile The input heightmap (PNG or RAW).
+     * @param outputFile The bundle to write.
+     * @param resolutionX The width of a RAW heightmap.
+     * @param resolutionY The height of a RAW heightmap.
+     * @param worldSize The size of the terrain in world units.
+     * @param maxSlope The steepest slope that is walkable, in degrees.
+     *
+     * @return True if the file was written.
+     */
+    static bool encodeHeightmap(const char* inputFile, const char* outputFile, int resolutionX, int resolutionY,
+                                const Vector3& worldSize, float maxSlope);
+
+private:
+
+    void addTriangle(const Vector3& a, const Vector3& b, const Vector3& c);
+
+    float _minNormalY;
+    bool _built;
+    std::vector<Vector3> _corners;
+    std::vector<float> _vertices;
+    std::vector<unsigned int> _triangles;
+    std::vector<unsigned int> _links;
+};
+
+}
+
+#endif
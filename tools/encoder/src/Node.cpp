@@ -78,6 +78,8 @@ void Node::writeBinary(FILE* file)
     {
         writeZero(file);
     }
+    // lightmap
+    write(_lightmap, file);
 }
 
 void Node::writeText(FILE* file)
@@ -114,9 +116,23 @@ void Node::writeText(FILE* file)
     {
         _model->writeText(file);
     }
+    if (!_lightmap.empty())
+    {
+        fprintfElement(file, "lightmap", _lightmap);
+    }
     fprintElementEnd(file);
 }
 
+void Node::setLightmap(const std::string& lightmap)
+{
+    _lightmap = lightmap;
+}
+
+const std::string& Node::getLightmap() const
+{
+    return _lightmap;
+}
+
 void Node::addChild(Node* child)
 {
     // If this child is already parented, remove it from its parent
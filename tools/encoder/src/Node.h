@@ -168,6 +168,16 @@ public:
      * Returns true if this node has a light.
      */
     bool hasLight() const;
+
+    /**
+     * Sets the file name of the lightmap baked for this node's model, relative to the bundle.
+     */
+    void setLightmap(const std::string& lightmap);
+
+    /**
+     * Returns the file name of the lightmap baked for this node's model, or an empty string.
+     */
+    const std::string& getLightmap() const;
     
 private:
 
@@ -184,6 +194,7 @@ private:
     Camera* _camera;
     Light* _light;
     Model* _model;
+    std::string _lightmap;
 
     bool _joint;
 };
@@ -70,25 +70,24 @@ float normalizedHeightPacked(float r, float g, float b)
     return (256.0f*r + g + 0.00390625f*b) / 65536.0f;
 }
 
-void NormalMapGenerator::generate()
+float* NormalMapGenerator::loadHeights(const std::string& inputFile, int* resolutionX, int* resolutionY)
 {
-    // Load the input heightmap
     float* heights = NULL;
-    size_t pos = _inputFile.find_last_of('.');
-    std::string ext = pos == std::string::npos ? "" : _inputFile.substr(pos, _inputFile.size()-pos);
+    size_t pos = inputFile.find_last_of('.');
+    std::string ext = pos == std::string::npos ? "" : inputFile.substr(pos, inputFile.size()-pos);
     if (equalsIgnoreCase(ext, ".png"))
     {
         // Load heights from PNG image
-        Image* image = Image::create(_inputFile.c_str());
+        Image* image = Image::create(inputFile.c_str());
         if (image == NULL)
         {
-            LOG(1, "Failed to load input heightmap PNG: %s.\n", _inputFile.c_str());
-            return;
+            LOG(1, "Failed to load input heightmap PNG: %s.\n", inputFile.c_str());
+            return NULL;
         }
 
-        _resolutionX = image->getWidth();
-        _resolutionY = image->getHeight();
-        int size = _resolutionX * _resolutionY;
+        *resolutionX = image->getWidth();
+        *resolutionY = image->getHeight();
+        int size = *resolutionX * *resolutionY;
         heights = new float[size];
         unsigned char* data = (unsigned char*)image->getData();
         for (int i = 0; i < size; ++i)
@@ -109,25 +108,24 @@ void NormalMapGenerator::generate()
                 heights[i] = 0.0f;
                 break;
             }
-            heights[i] = heights[i] * _worldSize.y;
         }
         SAFE_DELETE(image);
     }
     else if (equalsIgnoreCase(ext, ".raw"))
     {
         // Load heights from RAW 8 or 16-bit file
-        if (_resolutionX <= 0 || _resolutionY <= 0)
+        if (*resolutionX <= 0 || *resolutionY <= 0)
         {
-            LOG(1, "Missing resolution argument - must be explicitly specified for RAW heightmap files: %s.\n", _inputFile.c_str());
-            return;
+            LOG(1, "Missing resolution argument - must be explicitly specified for RAW heightmap files: %s.\n", inputFile.c_str());
+            return NULL;
         }
 
         // Read all data from file
-        FILE* fp = fopen(_inputFile.c_str(), "rb");
+        FILE* fp = fopen(inputFile.c_str(), "rb");
         if (fp == NULL)
         {
-            LOG(1, "Failed to open input file: %s.\n", _inputFile.c_str());
-            return;
+            LOG(1, "Failed to open input file: %s.\n", inputFile.c_str());
+            return NULL;
         }
 
         fseek(fp, 0, SEEK_END);
@@ -139,43 +137,43 @@ void NormalMapGenerator::generate()
         {
             fclose(fp);
             delete[] data;
-            LOG(1, "Failed to read bytes from input file: %s.\n", _inputFile.c_str());
-            return;
+            LOG(1, "Failed to read bytes from input file: %s.\n", inputFile.c_str());
+            return NULL;
         }
         fclose(fp);
 
         // Determine if the RAW file is 8-bit or 16-bit based on file size.
-        int bits = (fileSize / (_resolutionX * _resolutionY)) * 8;
+        int bits = (fileSize / (*resolutionX * *resolutionY)) * 8;
         if (bits != 8 && bits != 16)
         {
-            LOG(1, "Invalid RAW file - must be 8-bit or 16-bit, but found neither: %s.", _inputFile.c_str());
+            LOG(1, "Invalid RAW file - must be 8-bit or 16-bit, but found neither: %s.", inputFile.c_str());
             delete[] data;
-            return;
+            return NULL;
         }
 
-        int size = _resolutionX * _resolutionY;
+        int size = *resolutionX * *resolutionY;
         heights = new float[size];
         if (bits == 16)
         {
             // 16-bit (0-65535)
             int idx;
-            for (unsigned int y = 0, i = 0; y < (unsigned int)_resolutionY; ++y)
+            for (unsigned int y = 0, i = 0; y < (unsigned int)*resolutionY; ++y)
             {
-                for (unsigned int x = 0; x < (unsigned int)_resolutionX; ++x, ++i)
+                for (unsigned int x = 0; x < (unsigned int)*resolutionX; ++x, ++i)
                 {
-                    idx = (y * _resolutionX + x) << 1;
-                    heights[i] = ((data[idx] | (int)data[idx+1] << 8) / 65535.0f) * _worldSize.y;
+                    idx = (y * *resolutionX + x) << 1;
+                    heights[i] = ((data[idx] | (int)data[idx+1] << 8) / 65535.0f);
                 }
             }
         }
         else
         {
             // 8-bit (0-255)
-            for (unsigned int y = 0, i = 0; y < (unsigned int)_resolutionY; ++y)
+            for (unsigned int y = 0, i = 0; y < (unsigned int)*resolutionY; ++y)
             {
-                for (unsigned int x = 0; x < (unsigned int)_resolutionX; ++x, ++i)
+                for (unsigned int x = 0; x < (unsigned int)*resolutionX; ++x, ++i)
                 {
-                    heights[i] = (data[y * _resolutionX + x] / 255.0f) * _worldSize.y;
+                    heights[i] = (data[y * *resolutionX + x] / 255.0f);
                 }
             }
         }
@@ -184,10 +182,15 @@ void NormalMapGenerator::generate()
     }
     else
     {
-        LOG(1, "Unsupported input heightmap file (must be a valid PNG or RAW file: %s.\n", _inputFile.c_str());
-        return;
+        LOG(1, "Unsupported input heightmap file (must be a valid PNG or RAW file: %s.\n", inputFile.c_str());
+        return NULL;
     }
 
+    return heights;
+}
+
+unsigned char* NormalMapGenerator::calculateNormals(float* heights, int resolutionX, int resolutionY, const Vector3& worldSize)
+{
     ///////////////////////////////////////////////////////////////////////////////////////////////
     //
     // NOTE: This method assumes the heightmap geometry is generated as follows.
@@ -206,7 +209,8 @@ void NormalMapGenerator::generate()
     {
         unsigned char r, g, b;
     };
-    NormalPixel* normalPixels = new NormalPixel[_resolutionX * _resolutionY];
+    unsigned char* pixels = new unsigned char[resolutionX * resolutionY * 3];
+    NormalPixel* normalPixels = (NormalPixel*)pixels;
 
     struct Face
     {
@@ -214,52 +218,48 @@ void NormalMapGenerator::generate()
         Vector3 normal2;
     };
 
-    int progressMax = (_resolutionX-1) * (_resolutionY-1) + _resolutionX * _resolutionY;
+    int progressMax = (resolutionX-1) * (resolutionY-1) + resolutionX * resolutionY;
     int progress = 0;
 
-    Vector2 scale(_worldSize.x / (_resolutionX-1), _worldSize.z / (_resolutionY-1));
+    Vector2 scale(worldSize.x / (resolutionX-1), worldSize.z / (resolutionY-1));
 
     // First calculate all face normals for the heightmap
     LOG(1, "Calculating normals... 0%%");
-    Face* faceNormals = new Face[(_resolutionX - 1) * (_resolutionY - 1)];
+    Face* faceNormals = new Face[(resolutionX - 1) * (resolutionY - 1)];
     Vector3 v1, v2;
-    for (int z = 0; z < _resolutionY-1; z++)
+    for (int z = 0; z < resolutionY-1; z++)
     {
-        for (int x = 0; x < _resolutionX-1; x++)
+        for (int x = 0; x < resolutionX-1; x++)
         {
-            float topLeftHeight = getHeight(heights, _resolutionX, _resolutionY, x, z);
-            float bottomLeftHeight = getHeight(heights, _resolutionX, _resolutionY, x, z + 1);
-            float bottomRightHeight = getHeight(heights, _resolutionX, _resolutionY, x + 1, z + 1);
-            float topRightHeight = getHeight(heights, _resolutionX, _resolutionY, x + 1, z);
+            float topLeftHeight = getHeight(heights, resolutionX, resolutionY, x, z) * worldSize.y;
+            float bottomLeftHeight = getHeight(heights, resolutionX, resolutionY, x, z + 1) * worldSize.y;
+            float bottomRightHeight = getHeight(heights, resolutionX, resolutionY, x + 1, z + 1) * worldSize.y;
+            float topRightHeight = getHeight(heights, resolutionX, resolutionY, x + 1, z) * worldSize.y;
 
             // Triangle 1
             calculateNormal(
                 (float)x*scale.x, bottomLeftHeight, (float)(z + 1)*scale.y,
                 (float)x*scale.x, topLeftHeight, (float)z*scale.y,
                 (float)(x + 1)*scale.x, topRightHeight, (float)z*scale.y,
-                &faceNormals[z*(_resolutionX-1)+x].normal1);
+                &faceNormals[z*(resolutionX-1)+x].normal1);
 
             // Triangle 2
             calculateNormal(
                 (float)x*scale.x, bottomLeftHeight, (float)(z + 1)*scale.y,
                 (float)(x + 1)*scale.x, topRightHeight, (float)z*scale.y,
                 (float)(x + 1)*scale.x, bottomRightHeight, (float)(z + 1)*scale.y,
-                &faceNormals[z*(_resolutionX-1)+x].normal2);
+                &faceNormals[z*(resolutionX-1)+x].normal2);
 
             ++progress;
             LOG(1, "\rCalculating normals... %d%%", (int)(((float)progress / progressMax) * 100));
         }
     }
 
-    // Free height array
-    delete[] heights;
-    heights = NULL;
-
     // Smooth normals by taking an average for each vertex
     Vector3 normal;
-    for (int z = 0; z < _resolutionY; z++)
+    for (int z = 0; z < resolutionY; z++)
     {
-        for (int x = 0; x < _resolutionX; x++)
+        for (int x = 0; x < resolutionX; x++)
         {
             // Reset normal sum
             normal.set(0, 0, 0);
@@ -269,30 +269,30 @@ void NormalMapGenerator::generate()
                 if (z > 0)
                 {
                     // Top left
-                    normal.add(faceNormals[(z-1)*(_resolutionX-1) + (x-1)].normal2);
+                    normal.add(faceNormals[(z-1)*(resolutionX-1) + (x-1)].normal2);
                 }
 
-                if (z < (_resolutionY - 1))
+                if (z < (resolutionY - 1))
                 {
                     // Bottom left
-                    normal.add(faceNormals[z*(_resolutionX-1) + (x - 1)].normal1);
-                    normal.add(faceNormals[z*(_resolutionX-1) + (x - 1)].normal2);
+                    normal.add(faceNormals[z*(resolutionX-1) + (x - 1)].normal1);
+                    normal.add(faceNormals[z*(resolutionX-1) + (x - 1)].normal2);
                 }
             }
 
-            if (x < (_resolutionX - 1))
+            if (x < (resolutionX - 1))
             {
                 if (z > 0)
                 {
                     // Top right
-                    normal.add(faceNormals[(z-1)*(_resolutionX-1) + x].normal1);
-                    normal.add(faceNormals[(z-1)*(_resolutionX-1) + x].normal2);
+                    normal.add(faceNormals[(z-1)*(resolutionX-1) + x].normal1);
+                    normal.add(faceNormals[(z-1)*(resolutionX-1) + x].normal2);
                 }
 
-                if (z < (_resolutionY - 1))
+                if (z < (resolutionY - 1))
                 {
                     // Bottom right
-                    normal.add(faceNormals[z*(_resolutionX-1) + x].normal1);
+                    normal.add(faceNormals[z*(resolutionX-1) + x].normal1);
                 }
             }
 
@@ -302,7 +302,7 @@ void NormalMapGenerator::generate()
             normal.normalize();
 
             // Store this vertex normal
-            NormalPixel& pixel = normalPixels[z*_resolutionX + x];
+            NormalPixel& pixel = normalPixels[z*resolutionX + x];
             pixel.r = (unsigned char)((normal.x + 1.0f) * 0.5f * 255.0f);
             pixel.g = (unsigned char)((normal.y + 1.0f) * 0.5f * 255.0f);
             pixel.b = (unsigned char)((normal.z + 1.0f) * 0.5f * 255.0f);
@@ -314,6 +314,22 @@ void NormalMapGenerator::generate()
 
     LOG(1, "\rCalculating normals... Done.\n");
 
+    delete[] faceNormals;
+
+    return pixels;
+}
+
+void NormalMapGenerator::generate()
+{
+    // Load the input heightmap
+    float* heights = loadHeights(_inputFile, &_resolutionX, &_resolutionY);
+    if (heights == NULL)
+        return;
+
+    unsigned char* normalPixels = calculateNormals(heights, _resolutionX, _resolutionY, _worldSize);
+    delete[] heights;
+    heights = NULL;
+
     // Create and save an image for the normal map
     Image* normalMap = Image::create(Image::RGB, _resolutionX, _resolutionY);
     normalMap->setData(normalPixels);
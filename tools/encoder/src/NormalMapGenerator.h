@@ -16,6 +16,22 @@ public:
 
     void generate();
 
+    /**
+     * Loads the normalized heights of a PNG or RAW heightmap.
+     *
+     * The resolution must be given for RAW files and is set from the image for PNG files.
+     *
+     * @return The heights, which the caller must delete, or NULL if the file could not be loaded.
+     */
+    static float* loadHeights(const std::string& inputFile, int* resolutionX, int* resolutionY);
+
+    /**
+     * Calculates the object-space vertex normals of a heightmap of the specified world size.
+     *
+     * @return The RGB encoded normals, which the caller must delete.
+     */
+    static unsigned char* calculateNormals(float* heights, int resolutionX, int resolutionY, const Vector3& worldSize);
+
 private:
 
     // Hidden copy/assignment
@@ -4,7 +4,7 @@
 namespace gameplay
 {
 
-Object::Object(void) : _fposition(0)
+Object::Object(void) : _fposition(0), _spool(NULL), _spoolOffset(0), _spoolSize(0)
 {
 }
 
@@ -70,6 +70,56 @@ void Object::saveFilePosition(FILE* file)
     _fposition = ftell(file);
 }
 
+void Object::spool(FILE* spool)
+{
+    assert(spool);
+    assert(_spool == NULL);
+
+    fseek(spool, 0, SEEK_END);
+    _spoolOffset = ftell(spool);
+    writeBinary(spool);
+    _spoolSize = ftell(spool) - _spoolOffset;
+    _spool = spool;
+
+    // The position in the spool file is not the position in the binary file.
+    _fposition = 0;
+    releaseData();
+}
+
+bool Object::isSpooled() const
+{
+    return _spool != NULL;
+}
+
+void Object::releaseData()
+{
+}
+
+bool Object::writeSpooled(FILE* file)
+{
+    if (_spool == NULL)
+        return false;
+
+    saveFilePosition(file);
+
+    // Copy in blocks, so that the data is never held in memory whole.
+    std::vector<unsigned char> buffer((size_t)std::min(_spoolSize, 65536L));
+    fseek(_spool, _spoolOffset, SEEK_SET);
+    long remaining = _spoolSize;
+    while (remaining > 0)
+    {
+        size_t n = fread(&buffer[0], 1, (size_t)std::min(remaining, (long)buffer.size()), _spool);
+        if (n == 0)
+        {
+            LOG(1, "Error: Failed to read the spooled data of '%s'.\n", _id.c_str());
+            break;
+        }
+        fwrite(&buffer[0], 1, n, file);
+        remaining -= (long)n;
+    }
+    return true;
+}
+
 void Object::writeBinaryXref(FILE* file)
 {
     std::string xref("#");
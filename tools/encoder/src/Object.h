@@ -31,6 +31,10 @@ public:
         MESH_ID = 34,
         MESHPART_ID = 35,
         MESHSKIN_ID = 36,
+        MESHBVH_ID = 37,
+        MESHLOD_ID = 38,
+        VERTEXANIMATION_ID = 39,
+        NAVIGATIONMESH_ID = 40,
         FONT_ID = 128,
     };
 
@@ -102,6 +106,25 @@ public:
      */
     unsigned int getFilePosition();
 
+    /**
+     * Writes this object as binary to the end of a spool file and releases the memory of the data written.
+     * From then on, writeBinary copies the spooled data instead of writing it again.
+     *
+     * @param spool The spool file, which must stay open until this object is written.
+     */
+    void spool(FILE* spool);
+
+    /**
+     * Returns true if this object has been written to a spool file.
+     */
+    bool isSpooled() const;
+
+    /**
+     * Releases the memory of the data that writeBinary writes, once it has been spooled.
+     * Objects that hold little data keep it.
+     */
+    virtual void releaseData();
+
     /**
      * Writes out a list of objects to a binary file stream.
      */
@@ -134,6 +157,16 @@ public:
         }
     }
 
+protected:
+
+    /**
+     * Copies the spooled data of this object to the binary file stream, saving where it was written.
+     * Objects that can be spooled call this first in writeBinary.
+     *
+     * @return True if the spooled data was copied, false if this object has not been spooled.
+     */
+    bool writeSpooled(FILE* file);
+
 private:
 
     /**
@@ -144,6 +177,9 @@ private:
 private:
     std::string _id;
     long _fposition;
+    FILE* _spool;
+    long _spoolOffset;
+    long _spoolSize;
 };
 
 }
@@ -0,0 +1,324 @@
+#include "Base.h"
+#include "PropertiesEncoder.h"
+#include "FileIO.h"
+
+// The largest number of numbers stored with a property, which matches the values parsed by gameplay::Properties.
+#define PROPERTIES_MAX_FLOATS 4
+
+namespace gameplay
+{
+
+static const unsigned char PROPERTIES_BINARY_IDENTIFIER[] = { 0xAB, 'G', 'P', 'P', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char PROPERTIES_BINARY_VERSION[] = { 1, 0 };
+
+/**
+ * A namespace of a properties file.
+ */
+struct PropertiesNamespace
+{
+    std::string name;
+    std::string id;
+    std::string parentID;
+    std::vector<std::pair<std::string, std::string> > properties;
+    std::vector<PropertiesNamespace*> namespaces;
+
+    ~PropertiesNamespace()
+    {
+        for (size_t i = 0; i < namespaces.size(); ++i)
+            delete namespaces[i];
+    }
+
+    void setProperty(const std::string& propertyName, const std::string& value)
+    {
+        // Like the runtime, a property that is set twice keeps its first position and its last value.
+        for (size_t i = 0; i < properties.size(); ++i)
+        {
+            if (properties[i].first == propertyName)
+            {
+                properties[i].second = value;
+                return;
+            }
+        }
+        properties.push_back(std::make_pair(propertyName, value));
+    }
+};
+
+/**
+ * Reads the text of a properties file with the same rules as gameplay::Properties.
+ */
+class PropertiesReader
+{
+public:
+
+    PropertiesReader(const char* data, size_t length) : _data(data), _length(length), _position(0), _failed(false)
+    {
+    }
+
+    bool read(PropertiesNamespace* space)
+    {
+        readNamespace(space);
+        return !_failed;
+    }
+
+private:
+
+    static std::string trim(const std::string& str)
+    {
+        size_t first = 0;
+        while (first < str.size() && isspace((unsigned char)str[first]))
+            ++first;
+        size_t last = str.size();
+        while (last > first && isspace((unsigned char)str[last - 1]))
+            --last;
+        return str.substr(first, last - first);
+    }
+
+    // Returns the next token of str from position, like strtok. Returns false if there is none.
+    static bool nextToken(const std::string& str, size_t* position, const char* delimiters, std::string* token)
+    {
+        size_t start = str.find_first_not_of(delimiters, *position);
+        if (start == std::string::npos)
+        {
+            *position = str.size();
+            return false;
+        }
+        size_t end = str.find_first_of(delimiters, start);
+        if (end == std::string::npos)
+            end = str.size();
+        *token = str.substr(start, end - start);
+        *position = end < str.size() ? end + 1 : end;
+        return true;
+    }
+
+    void skipWhiteSpace()
+    {
+        while (_position < _length && isspace((unsigned char)_data[_position]))
+            ++_position;
+    }
+
+    std::string readLine()
+    {
+        size_t start = _position;
+        while (_position < _length && _data[_position] != '\n')
+            ++_position;
+        std::string line(_data + start, _position - start);
+        if (_position < _length)
+            ++_position;
+        return line;
+    }
+
+    void readNamespace(PropertiesNamespace* space)
+    {
+        while (!_failed)
+        {
+            skipWhiteSpace();
+            if (_position >= _length)
+                return;
+
+            std::string line = readLine();
+            if (line.compare(0, 2, "//") == 0)
+                continue;
+
+            size_t position = 0;
+            std::string name;
+            std::string value;
+            if (line.find('=') != std::string::npos)
+            {
+                if (!nextToken(line, &position, "=", &name))
+                {
+                    LOG(1, "Error: attribute without name.\n");
+                    _failed = true;
+                    return;
+                }
+                if (!nextToken(line, &position, "=", &value))
+                {
+                    LOG(1, "Error: attribute with name ('%s') but no value.\n", trim(name).c_str());
+                    _failed = true;
+                    return;
+                }
+                space->setProperty(trim(name), trim(value));
+
+                // A '}' on the line ends the namespace.
+                if (line.find('}') != std::string::npos)
+                    return;
+                continue;
+            }
+
+            // The namespace ends on this line if its first '}' is its last character.
+            std::string trimmed = trim(line);
+            size_t close = line.find('}');
+            bool closesOnLine = close != std::string::npos && trimmed.size() > 0 && line.find_last_not_of(" \t\r\n\f\v") == close;
+            bool opensOnLine = line.find('{') != std::string::npos;
+            bool inherits = line.find(':') != std::string::npos;
+
+            if (!nextToken(line, &position, " \t\n{", &name))
+            {
+                LOG(1, "Error: failed to determine a valid token for line '%s'.\n", line.c_str());
+                _failed = true;
+                return;
+            }
+            name = trim(name);
+            if (name[0] == '}')
+                return;
+
+            std::string id;
+            bool hasId = nextToken(line, &position, ":{", &id);
+            std::string parentID;
+            if (inherits)
+                nextToken(line, &position, "{", &parentID);
+
+            bool opens = opensOnLine;
+            if (!opensOnLine)
+            {
+                // The namespace may start on the next line.
+                skipWhiteSpace();
+                if (_position < _length && _data[_position] == '{')
+                {
+                    ++_position;
+                    opens = true;
+                }
+            }
+
+            if (opens)
+            {
+                PropertiesNamespace* child = new PropertiesNamespace();
+                child->name = name;
+                child->id = trim(id);
+                child->parentID = trim(parentID);
+                space->namespaces.push_back(child);
+                if (!(opensOnLine && closesOnLine))
+                    readNamespace(child);
+            }
+            else
+            {
+                // A "name value" pair, or just "name".
+                space->setProperty(name, hasId ? trim(id) : std::string());
+            }
+        }
+    }
+
+    const char* _data;
+    size_t _length;
+    size_t _position;
+    bool _failed;
+};
+
+/**
+ * Parses up to count comma separated floats, like gameplay::Properties.
+ */
+static unsigned int parseFloats(const char* str, float* values, unsigned int count)
+{
+    unsigned int parsed = 0;
+    while (parsed < count)
+    {
+        char* end;
+        double value = strtod(str, &end);
+        if (end == str)
+            break;
+        values[parsed++] = (float)value;
+        if (*end != ',')
+            break;
+        str = end + 1;
+    }
+    return parsed;
+}
+
+static unsigned int addString(const std::string& str, std::map<std::string, unsigned int>& indices, std::vector<std::string>& strings)
+{
+    std::map<std::string, unsigned int>::const_iterator itr = indices.find(str);
+    if (itr != indices.end())
+        return itr->second;
+    unsigned int index = (unsigned int)strings.size();
+    indices[str] = index;
+    strings.push_back(str);
+    return index;
+}
+
+static void addStrings(const PropertiesNamespace* space, std::map<std::string, unsigned int>& indices, std::vector<std::string>& strings)
+{
+    addString(space->name, indices, strings);
+    addString(space->id, indices, strings);
+    addString(space->parentID, indices, strings);
+    for (size_t i = 0; i < space->properties.size(); ++i)
+    {
+        addString(space->properties[i].first, indices, strings);
+        addString(space->properties[i].second, indices, strings);
+    }
+    for (size_t i = 0; i < space->namespaces.size(); ++i)
+        addStrings(space->namespaces[i], indices, strings);
+}
+
+static void writeNamespace(const PropertiesNamespace* space, std::map<std::string, unsigned int>& indices, FILE* file)
+{
+    write(indices[space->name], file);
+    write(indices[space->id], file);
+    write(indices[space->parentID], file);
+
+    write((unsigned int)space->properties.size(), file);
+    for (size_t i = 0; i < space->properties.size(); ++i)
+    {
+        float floats[PROPERTIES_MAX_FLOATS];
+        unsigned int floatCount = parseFloats(space->properties[i].second.c_str(), floats, PROPERTIES_MAX_FLOATS);
+        write(indices[space->properties[i].first], file);
+        write(indices[space->properties[i].second], file);
+        write((unsigned char)floatCount, file);
+        write(floats, floatCount, file);
+    }
+
+    write((unsigned int)space->namespaces.size(), file);
+    for (size_t i = 0; i < space->namespaces.size(); ++i)
+        writeNamespace(space->namespaces[i], indices, file);
+}
+
+bool PropertiesEncoder::encode(const char* inputFile, const char* outputFile)
+{
+    FILE* input = fopen(inputFile, "rb");
+    if (input == NULL)
+    {
+        LOG(1, "Error: failed to open file: %s.\n", inputFile);
+        return false;
+    }
+    std::vector<char> data;
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), input)) > 0)
+        data.insert(data.end(), buffer, buffer + read);
+    fclose(input);
+
+    if (data.size() >= sizeof(PROPERTIES_BINARY_IDENTIFIER) && memcmp(&data[0], PROPERTIES_BINARY_IDENTIFIER, sizeof(PROPERTIES_BINARY_IDENTIFIER)) == 0)
+    {
+        LOG(1, "Error: file is already a binary properties file: %s.\n", inputFile);
+        return false;
+    }
+
+    PropertiesNamespace root;
+    PropertiesReader reader(data.empty() ? NULL : &data[0], data.size());
+    if (!reader.read(&root))
+    {
+        LOG(1, "Error: failed to parse properties file: %s.\n", inputFile);
+        return false;
+    }
+
+    std::map<std::string, unsigned int> indices;
+    std::vector<std::string> strings;
+    addStrings(&root, indices, strings);
+
+    FILE* file = fopen(outputFile, "wb");
+    if (file == NULL)
+    {
+        LOG(1, "Error: failed to open file for writing: %s.\n", outputFile);
+        return false;
+    }
+    fwrite(PROPERTIES_BINARY_IDENTIFIER, 1, sizeof(PROPERTIES_BINARY_IDENTIFIER), file);
+    fwrite(PROPERTIES_BINARY_VERSION, 1, sizeof(PROPERTIES_BINARY_VERSION), file);
+    write((unsigned int)strings.size(), file);
+    for (size_t i = 0; i < strings.size(); ++i)
+        write(strings[i], file);
+    writeNamespace(&root, indices, file);
+    fclose(file);
+
+    LOG(1, "Wrote %d strings to binary properties file: %s.\n", (int)strings.size(), outputFile);
+    return true;
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef PROPERTIESENCODER_H_
+#define PROPERTIESENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Compiles a text properties file (.material, .scene, .physics, .form, ...) to the
+ * binary properties format loaded by gameplay::Properties.
+ *
+ * The binary file holds a table of all the strings of the file, followed by the
+ * namespaces and their properties as indices into the table. The numbers of every
+ * value are parsed at compile time and stored with the property, so that the
+ * runtime does not parse them again. Inheritance between namespaces is resolved
+ * by the runtime, as for text files.
+ */
+class PropertiesEncoder
+{
+public:
+
+    /**
+     * Compiles a text properties file.
+     *
+     * @param inputFile The text properties file.
+     * @param outputFile The binary properties file to write.
+     *
+     * @return True if the file was written.
+     */
+    static bool encode(const char* inputFile, const char* outputFile);
+
+};
+
+}
+
+#endif
@@ -37,6 +37,33 @@ void Sampler::set(const string& name, const string& value)
     props[name] = value;
 }
 
+bool Sampler::isCompatible(const Sampler* sampler) const
+{
+    if (_id != sampler->_id)
+        return false;
+    map<string, string>::const_iterator i = props.begin();
+    map<string, string>::const_iterator j = sampler->props.begin();
+    while (i != props.end() || j != sampler->props.end())
+    {
+        // Skip the paths
+        if (i != props.end() && (i->first == "path" || i->first == "relativePath" || i->first == "absolutePath"))
+        {
+            ++i;
+            continue;
+        }
+        if (j != sampler->props.end() && (j->first == "path" || j->first == "relativePath" || j->first == "absolutePath"))
+        {
+            ++j;
+            continue;
+        }
+        if (i == props.end() || j == sampler->props.end() || i->first != j->first || i->second != j->second)
+            return false;
+        ++i;
+        ++j;
+    }
+    return true;
+}
+
 void Sampler::writeMaterial(FILE* file, unsigned int indent, Sampler* parent)
 {
     writeIndent(indent, file);
@@ -26,6 +26,11 @@ public:
     const char* getString(const std::string& name);
     void set(const std::string& name, const std::string& value);
 
+    /**
+     * Returns true if the given sampler has the same id and properties as this one, apart from the path of its image.
+     */
+    bool isCompatible(const Sampler* sampler) const;
+
     /**
      * Writes this sampler to a material file.
      * 
@@ -39,6 +39,11 @@ void Scene::writeBinary(FILE* file)
         writeZero(file);
     }
     write(_ambientColor, Light::COLOR_SIZE, file);
+    write((unsigned int)(_lightProbes.size() / 15), file);
+    if (!_lightProbes.empty())
+    {
+        write(&_lightProbes[0], (int)_lightProbes.size(), file);
+    }
 }
 
 void Scene::writeText(FILE* file)
@@ -53,6 +58,10 @@ void Scene::writeText(FILE* file)
         fprintfElement(file, "activeCamera", _cameraNode->getId());
     }
     fprintfElement(file, "ambientColor", _ambientColor, Light::COLOR_SIZE);
+    for (size_t i = 0, count = _lightProbes.size(); i < count; i += 15)
+    {
+        fprintfElement(file, "lightProbe", &_lightProbes[i], 15);
+    }
     fprintElementEnd(file);
 }
 
@@ -99,6 +108,19 @@ void Scene::setAmbientColor(float red, float green, float blue)
     _ambientColor[2] = blue;
 }
 
+const float* Scene::getAmbientColor() const
+{
+    return _ambientColor;
+}
+
+void Scene::addLightProbe(const Vector3& position, const float* irradiance)
+{
+    _lightProbes.push_back(position.x);
+    _lightProbes.push_back(position.y);
+    _lightProbes.push_back(position.z);
+    _lightProbes.insert(_lightProbes.end(), irradiance, irradiance + 12);
+}
+
 void Scene::calcAmbientColor(const Node* node, float* values) const
 {
     if (!node)
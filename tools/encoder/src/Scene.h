@@ -55,6 +55,20 @@ public:
      */
     void setAmbientColor(float red, float green, float blue);
 
+    /**
+     * Returns the scene's ambient color, 3 floats.
+     */
+    const float* getAmbientColor() const;
+
+    /**
+     * Adds a light probe baked for lighting the dynamic objects of the scene.
+     *
+     * @param position The position of the probe in world space.
+     * @param irradiance The red, green and blue irradiance as first order spherical harmonics,
+     *      4 floats each: the linear directional part followed by the constant part.
+     */
+    void addLightProbe(const Vector3& position, const float* irradiance);
+
 private:
 
     /**
@@ -70,6 +84,7 @@ private:
     std::list<Node*> _nodes;
     Node* _cameraNode;
     float _ambientColor[Light::COLOR_SIZE];
+    std::vector<float> _lightProbes;   // Position followed by irradiance, 15 floats per probe.
 };
 
 }
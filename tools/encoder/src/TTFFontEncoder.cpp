@@ -19,6 +19,103 @@ static void drawBitmap(unsigned char* dstBitmap, int x, int y, int dstWidth, uns
     }
 }
 
+#define DISTANCE_INFINITY 1e20f
+
+/**
+ * Computes the squared distance of each sample to the nearest zero sample along one row or column.
+ * (Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions".)
+ */
+static void distanceTransform(float* f, int count, int stride, float* d, int* v, float* z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -DISTANCE_INFINITY;
+    z[1] = DISTANCE_INFINITY;
+    for (int q = 1; q < count; ++q)
+    {
+        float s = ((f[q * stride] + q * q) - (f[v[k] * stride] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        while (s <= z[k])
+        {
+            --k;
+            s = ((f[q * stride] + q * q) - (f[v[k] * stride] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = DISTANCE_INFINITY;
+    }
+
+    k = 0;
+    for (int q = 0; q < count; ++q)
+    {
+        while (z[k + 1] < q)
+        {
+            ++k;
+        }
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k] * stride];
+    }
+    for (int q = 0; q < count; ++q)
+    {
+        f[q * stride] = d[q];
+    }
+}
+
+/**
+ * Replaces every zero sample of the grid with 0, and every other one with its squared distance to the nearest zero sample.
+ */
+static void distanceTransform(float* grid, int width, int height)
+{
+    int size = std::max(width, height);
+    std::vector<float> d(size);
+    std::vector<int> v(size);
+    std::vector<float> z(size + 1);
+    for (int x = 0; x < width; ++x)
+    {
+        distanceTransform(grid + x, height, width, &d[0], &v[0], &z[0]);
+    }
+    for (int y = 0; y < height; ++y)
+    {
+        distanceTransform(grid + y * width, width, 1, &d[0], &v[0], &z[0]);
+    }
+}
+
+/**
+ * Creates a signed distance field, scale times smaller than the given glyph bitmap.
+ *
+ * 128 is on the outline of the glyphs, larger values are inside of them and smaller ones outside,
+ * and a step of 127 corresponds to spread pixels of the bitmap.
+ */
+static unsigned char* createDistanceField(const unsigned char* bitmap, int width, int height, int scale, int spread)
+{
+    const int size = width * height;
+    std::vector<float> outside(size);
+    std::vector<float> inside(size);
+    for (int i = 0; i < size; ++i)
+    {
+        bool ink = bitmap[i] >= 128;
+        outside[i] = ink ? 0.0f : DISTANCE_INFINITY;
+        inside[i] = ink ? DISTANCE_INFINITY : 0.0f;
+    }
+    distanceTransform(&outside[0], width, height);
+    distanceTransform(&inside[0], width, height);
+
+    const int fieldWidth = width / scale;
+    const int fieldHeight = height / scale;
+    unsigned char* field = (unsigned char*)malloc(fieldWidth * fieldHeight);
+    for (int y = 0; y < fieldHeight; ++y)
+    {
+        for (int x = 0; x < fieldWidth; ++x)
+        {
+            // Sample the center of the texel.
+            int i = (y * scale + scale / 2) * width + x * scale + scale / 2;
+            float distance = sqrt(inside[i]) - sqrt(outside[i]);
+            float value = 128.0f + distance * 127.0f / spread;
+            field[y * fieldWidth + x] = (unsigned char)std::max(0.0f, std::min(value, 255.0f));
+        }
+    }
+    return field;
+}
+
 static void writeUint(FILE* fp, unsigned int i)
 {
     fwrite(&i, sizeof(unsigned int), 1, fp);
@@ -34,9 +131,13 @@ static void writeString(FILE* fp, const char* str)
     }
 }
 
-int writeFont(const char* inFilePath, const char* outFilePath, unsigned int fontSize, const char* id, bool fontpreview = false)
+int writeFont(const char* inFilePath, const char* outFilePath, unsigned int fontSize, const char* id, bool fontpreview, bool distanceField)
 {
     Glyph glyphArray[END_INDEX - START_INDEX];
+
+    // Distance fields are computed from a larger rendering of the glyphs.
+    const int scale = distanceField ? FONT_DISTANCE_FIELD_SCALE : 1;
+    const int padding = GLYPH_PADDING * scale;
     
     // Initialize freetype library.
     FT_Library library;
@@ -60,7 +161,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
     error = FT_Set_Char_Size(
             face,           // handle to face object.
             0,              // char_width in 1/64th of points.
-            fontSize * 64,   // char_height in 1/64th of points.
+            fontSize * scale * 64,   // char_height in 1/64th of points.
             0,              // horizontal device resolution (defaults to 72 dpi if resolution (0, 0)).
             0 );            // vertical device resolution.
     
@@ -106,7 +207,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
     }
 
     // Include padding in the rowSize.
-    rowSize += GLYPH_PADDING;
+    rowSize += padding;
     
     // Initialize with padding.
     int penX = 0;
@@ -144,7 +245,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
             int glyphWidth = slot->bitmap.pitch;
             int glyphHeight = slot->bitmap.rows;
 
-            advance = glyphWidth + GLYPH_PADDING; //((int)slot->advance.x >> 6) + GLYPH_PADDING;
+            advance = glyphWidth + padding; //((int)slot->advance.x >> 6) + padding;
 
             // If we reach the end of the image wrap aroud to the next row.
             if ((penX + advance) > (int)imageWidth)
@@ -212,7 +313,7 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
         int glyphWidth = slot->bitmap.pitch;
         int glyphHeight = slot->bitmap.rows;
 
-        advance = glyphWidth + GLYPH_PADDING;//((int)slot->advance.x >> 6) + GLYPH_PADDING;
+        advance = glyphWidth + padding;//((int)slot->advance.x >> 6) + padding;
 
         // If we reach the end of the image wrap aroud to the next row.
         if ((penX + advance) > (int)imageWidth)
@@ -238,12 +339,12 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
         penY = row * rowSize;
 
         glyphArray[i].index = ascii;
-        glyphArray[i].width = advance - GLYPH_PADDING;
+        glyphArray[i].width = (advance - padding + scale / 2) / scale;
         
         // Generate UV coords.
         glyphArray[i].uvCoords[0] = (float)penX / (float)imageWidth;
         glyphArray[i].uvCoords[1] = (float)penY / (float)imageHeight;
-        glyphArray[i].uvCoords[2] = (float)(penX + advance - GLYPH_PADDING) / (float)imageWidth;
+        glyphArray[i].uvCoords[2] = (float)(penX + advance - padding) / (float)imageWidth;
         glyphArray[i].uvCoords[3] = (float)(penY + rowSize) / (float)imageHeight;
 
         // Set the pen position for the next glyph
@@ -251,6 +352,16 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
         i++;
     }
 
+    if (distanceField)
+    {
+        // The glyph uvs are relative, so they still hold for the smaller texture.
+        unsigned char* fieldBuffer = createDistanceField(imageBuffer, imageWidth, imageHeight, scale, FONT_DISTANCE_FIELD_SPREAD * scale);
+        free(imageBuffer);
+        imageBuffer = fieldBuffer;
+        imageWidth /= scale;
+        imageHeight /= scale;
+        rowSize /= scale;
+    }
 
     FILE *gpbFp = fopen(outFilePath, "wb");
     
@@ -282,6 +393,9 @@ int writeFont(const char* inFilePath, const char* outFilePath, unsigned int font
     // Character set.
     // TODO: Empty for now
     writeString(gpbFp, "");
+
+    // Format (0 == BITMAP, 1 == DISTANCE_FIELD).
+    writeUint(gpbFp, distanceField ? 1 : 0);
     
     // Glyphs.
     unsigned int glyphSetSize = END_INDEX - START_INDEX;
@@ -0,0 +1,148 @@
+#include "Base.h"
+#include "TerrainTileEncoder.h"
+#include "NormalMapGenerator.h"
+#include "Image.h"
+
+// Optional data stored with the heights of every tile
+#define TERRAIN_TILES_NORMALS 1
+#define TERRAIN_TILES_BLEND 2
+
+namespace gameplay
+{
+
+static const unsigned char TERRAIN_TILES_IDENTIFIER[] = { 0xAB, 'G', 'P', 'T', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+static const unsigned char TERRAIN_TILES_VERSION[] = { 1, 0 };
+
+static unsigned int getTileCount(int resolution, unsigned int tileSize, unsigned int level)
+{
+    unsigned int extent = tileSize << level;
+    return std::max(1u, ((unsigned int)resolution - 1 + extent - 1) / extent);
+}
+
+bool TerrainTileEncoder::encode(const char* inputFile, const char* outputFile, int resolutionX, int resolutionY,
+                                unsigned int tileSize, const Vector3& worldSize, const char* blendMapFile)
+{
+    float* heights = NormalMapGenerator::loadHeights(inputFile, &resolutionX, &resolutionY);
+    if (heights == NULL)
+        return false;
+    if (resolutionX < 2 || resolutionY < 2)
+    {
+        LOG(1, "Error: heightmap must be at least 2x2 pixels: %s.\n", inputFile);
+        delete[] heights;
+        return false;
+    }
+
+    // Normals are calculated from the full resolution heights, so coarse tiles keep the fine detail.
+    unsigned char* normals = NULL;
+    if (worldSize.x > 0 && worldSize.y > 0 && worldSize.z > 0)
+        normals = NormalMapGenerator::calculateNormals(heights, resolutionX, resolutionY, worldSize);
+
+    Image* blendMap = NULL;
+    if (blendMapFile)
+    {
+        blendMap = Image::create(blendMapFile);
+        if (blendMap == NULL || (blendMap->getFormat() != Image::RGB && blendMap->getFormat() != Image::RGBA))
+        {
+            LOG(1, "Error: blend map must be an RGB or RGBA PNG image: %s.\n", blendMapFile);
+            SAFE_DELETE(blendMap);
+            delete[] heights;
+            delete[] normals;
+            return false;
+        }
+    }
+
+    FILE* file = fopen(outputFile, "wb");
+    if (file == NULL)
+    {
+        LOG(1, "Error: failed to open file for writing: %s.\n", outputFile);
+        SAFE_DELETE(blendMap);
+        delete[] heights;
+        delete[] normals;
+        return false;
+    }
+
+    // Add levels until a single tile covers the heightmap.
+    unsigned int levelCount = 1;
+    while (getTileCount(resolutionX, tileSize, levelCount - 1) > 1 || getTileCount(resolutionY, tileSize, levelCount - 1) > 1)
+        ++levelCount;
+
+    unsigned int flags = (normals ? TERRAIN_TILES_NORMALS : 0) | (blendMap ? TERRAIN_TILES_BLEND : 0);
+    unsigned int header[5] = { tileSize, (unsigned int)resolutionX, (unsigned int)resolutionY, levelCount, flags };
+    fwrite(TERRAIN_TILES_IDENTIFIER, 1, sizeof(TERRAIN_TILES_IDENTIFIER), file);
+    fwrite(TERRAIN_TILES_VERSION, 1, sizeof(TERRAIN_TILES_VERSION), file);
+    fwrite(header, sizeof(unsigned int), 5, file);
+
+    unsigned int samples = tileSize + 1;
+    unsigned int sampleCount = samples * samples;
+    unsigned char* tile = new unsigned char[sampleCount * (2 + 3 + 4)];
+
+    unsigned int tileCount = 0;
+    for (unsigned int level = 0; level < levelCount; ++level)
+        tileCount += getTileCount(resolutionX, tileSize, level) * getTileCount(resolutionY, tileSize, level);
+
+    LOG(1, "Writing %d terrain tiles in %d levels... 0%%", tileCount, levelCount);
+    unsigned int progress = 0;
+    for (unsigned int level = 0; level < levelCount; ++level)
+    {
+        unsigned int spacing = 1u << level;
+        unsigned int extent = tileSize << level;
+        for (unsigned int row = 0, rows = getTileCount(resolutionY, tileSize, level); row < rows; ++row)
+        {
+            for (unsigned int column = 0, columns = getTileCount(resolutionX, tileSize, level); column < columns; ++column)
+            {
+                // Samples past the edges of the heightmap repeat its last row or column.
+                unsigned char* heightData = tile;
+                unsigned char* normalData = heightData + sampleCount * 2;
+                unsigned char* blendData = normalData + (normals ? sampleCount * 3 : 0);
+                for (unsigned int j = 0; j < samples; ++j)
+                {
+                    unsigned int z = std::min(row * extent + j * spacing, (unsigned int)resolutionY - 1);
+                    for (unsigned int i = 0; i < samples; ++i)
+                    {
+                        unsigned int x = std::min(column * extent + i * spacing, (unsigned int)resolutionX - 1);
+                        unsigned int index = z * resolutionX + x;
+
+                        float h = std::min(std::max(heights[index], 0.0f), 1.0f);
+                        unsigned int value = (unsigned int)(h * 65535.0f + 0.5f);
+                        *heightData++ = (unsigned char)(value & 0xFF);
+                        *heightData++ = (unsigned char)(value >> 8);
+
+                        if (normals)
+                        {
+                            memcpy(normalData, normals + index * 3, 3);
+                            normalData += 3;
+                        }
+
+                        if (blendMap)
+                        {
+                            unsigned int bx = x * (blendMap->getWidth() - 1) / (resolutionX - 1);
+                            unsigned int by = z * (blendMap->getHeight() - 1) / (resolutionY - 1);
+                            const unsigned char* pixel = (const unsigned char*)blendMap->getData() + (by * blendMap->getWidth() + bx) * blendMap->getBpp();
+                            blendData[0] = pixel[0];
+                            blendData[1] = pixel[1];
+                            blendData[2] = pixel[2];
+                            blendData[3] = blendMap->getFormat() == Image::RGBA ? pixel[3] : 255;
+                            blendData += 4;
+                        }
+                    }
+                }
+                fwrite(tile, 1, blendMap ? blendData - tile : normalData - tile, file);
+
+                ++progress;
+                LOG(1, "\rWriting %d terrain tiles in %d levels... %d%%", tileCount, levelCount, (int)(((float)progress / tileCount) * 100));
+            }
+        }
+    }
+    LOG(1, "\rWriting %d terrain tiles in %d levels... Done.\n", tileCount, levelCount);
+
+    fclose(file);
+    delete[] tile;
+    SAFE_DELETE(blendMap);
+    delete[] heights;
+    delete[] normals;
+
+    LOG(1, "Terrain tiles saved to '%s'.\n", outputFile);
+    return true;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef TERRAINTILEENCODER_H_
+#define TERRAINTILEENCODER_H_
+
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+/**
+ * Splits a heightmap into the tiles of a paged terrain.
+ *
+ * The tiles form a quadtree of levels. Level 0 samples every height of the heightmap
+ * and each following level samples every other height of the level below it, until a
+ * single tile covers the whole heightmap. Every tile holds (tileSize + 1) x (tileSize + 1)
+ * samples, so neighboring tiles share their edge samples.
+ *
+ * Each sample stores a normalized 16-bit height, followed by an RGB encoded object-space
+ * normal when a world size is given and an RGBA blend weight when a blend map is given.
+ */
+class TerrainTileEncoder
+{
+public:
+
+    /**
+     * Writes the tiles of a heightmap to a tile file.
+     *
+     * @param inputFile The input heightmap (PNG or RAW).
+     * @param outputFile The tile file to write.
+     * @param resolutionX The width of a RAW heightmap.
+     * @param resolutionY The height of a RAW heightmap.
+     * @param tileSize The number of quads along the edges of a tile, which must be a power of two.
+     * @param worldSize The size of the terrain in world units, used to compute the normals,
+     *      or zero to leave the normals out.
+     * @param blendMapFile An optional RGBA image of layer blend weights covering the terrain.
+     *
+     * @return True if the file was written.
+     */
+    static bool encode(const char* inputFile, const char* outputFile, int resolutionX, int resolutionY,
+                       unsigned int tileSize, const Vector3& worldSize, const char* blendMapFile);
+
+};
+
+}
+
+#endif
@@ -0,0 +1,796 @@
+#include "Base.h"
+#include "TextureEncoder.h"
+#include "FileIO.h"
+#include "Image.h"
+
+// GL formats written to the KTX file
+#define KTX_GL_UNSIGNED_BYTE 0x1401
+#define KTX_GL_RGB 0x1907
+#define KTX_GL_RGBA 0x1908
+#define KTX_GL_COMPRESSED_RGB_S3TC_DXT1 0x83F0
+#define KTX_GL_COMPRESSED_RGBA_S3TC_DXT5 0x83F3
+#define KTX_GL_ETC1_RGB8 0x8D64
+#define KTX_GL_COMPRESSED_RGB8_ETC2 0x9274
+#define KTX_GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+
+namespace gameplay
+{
+
+static const unsigned char KTX_IDENTIFIER[] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// The rows are stored bottom up, see TextureEncoder.
+static const char KTX_ORIENTATION_KEY[] = "KTXorientation";
+static const char KTX_ORIENTATION_VALUE[] = "S=r,T=u";
+
+// ETC1 intensity modifiers, in the order of the pixel index values.
+static const int ETC1_MODIFIERS[8][4] =
+{
+    { 2, 8, -2, -8 },
+    { 5, 17, -5, -17 },
+    { 9, 29, -9, -29 },
+    { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 },
+    { 24, 80, -24, -80 },
+    { 33, 106, -33, -106 },
+    { 47, 183, -47, -183 }
+};
+
+// EAC alpha modifiers, in the order of the pixel index values.
+static const int EAC_MODIFIERS[16][8] =
+{
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+/**
+ * An RGBA image level, rows bottom up.
+ */
+struct TextureLevel
+{
+    unsigned int width;
+    unsigned int height;
+    std::vector<unsigned char> pixels;
+};
+
+/**
+ * An RGBA image level with float channels between 0 and 1, in linear space unless the
+ * texture is encoded with TextureEncoder::LINEAR, rows bottom up.
+ */
+struct FilterLevel
+{
+    unsigned int width;
+    unsigned int height;
+    std::vector<float> pixels;
+};
+
+static float srgbToLinear(unsigned char value)
+{
+    static float table[256];
+    static bool initialized = false;
+    if (!initialized)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+        initialized = true;
+    }
+    return table[value];
+}
+
+static unsigned char linearToSrgb(float value)
+{
+    value = std::max(0.0f, std::min(1.0f, value));
+    float c = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return (unsigned char)(c * 255.0f + 0.5f);
+}
+
+static unsigned char toByte(float value)
+{
+    return (unsigned char)(std::max(0.0f, std::min(1.0f, value)) * 255.0f + 0.5f);
+}
+
+// Converts a level to float channels, the color to linear space when gamma is true. Alpha is always linear.
+static void toFilterLevel(const TextureLevel& source, bool gamma, FilterLevel* level)
+{
+    level->width = source.width;
+    level->height = source.height;
+    level->pixels.resize(source.pixels.size());
+    for (size_t i = 0, count = source.pixels.size(); i < count; ++i)
+        level->pixels[i] = gamma && i % 4 != 3 ? srgbToLinear(source.pixels[i]) : source.pixels[i] / 255.0f;
+}
+
+static void toTextureLevel(const FilterLevel& source, bool gamma, TextureLevel* level)
+{
+    level->width = source.width;
+    level->height = source.height;
+    level->pixels.resize(source.pixels.size());
+    for (size_t i = 0, count = source.pixels.size(); i < count; ++i)
+        level->pixels[i] = gamma && i % 4 != 3 ? linearToSrgb(source.pixels[i]) : toByte(source.pixels[i]);
+}
+
+// Averages RGBA texels, weighting the color by alpha so that transparent texels do not bleed into the visible ones.
+static void average(const float** texels, const float* weights, unsigned int count, float* result)
+{
+    float color[3] = { 0.0f, 0.0f, 0.0f };
+    float plainColor[3] = { 0.0f, 0.0f, 0.0f };
+    float alpha = 0.0f;
+    float weightSum = 0.0f;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        float w = weights[i];
+        for (int c = 0; c < 3; ++c)
+        {
+            color[c] += texels[i][c] * texels[i][3] * w;
+            plainColor[c] += texels[i][c] * w;
+        }
+        alpha += texels[i][3] * w;
+        weightSum += w;
+    }
+    for (int c = 0; c < 3; ++c)
+        result[c] = alpha > 0.0f ? color[c] / alpha : plainColor[c] / weightSum;
+    result[3] = alpha / weightSum;
+}
+
+static int clampByte(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static unsigned int colorError(const unsigned char* a, int r, int g, int b)
+{
+    int dr = a[0] - r;
+    int dg = a[1] - g;
+    int db = a[2] - b;
+    return (unsigned int)(dr * dr + dg * dg + db * db);
+}
+
+// Finds the modifier table and pixel indices of an ETC1 half block with the given base color.
+static unsigned int encodeETC1Half(const unsigned char pixels[16][4], bool flip, int half, const int base[3], int* table, unsigned char indices[16])
+{
+    unsigned int bestError = UINT_MAX;
+    for (int t = 0; t < 8; ++t)
+    {
+        unsigned int error = 0;
+        unsigned char tableIndices[16];
+        for (int p = 0; p < 16 && error < bestError; ++p)
+        {
+            int x = p % 4;
+            int y = p / 4;
+            if ((flip ? y : x) / 2 != half)
+                continue;
+            unsigned int pixelError = UINT_MAX;
+            for (int i = 0; i < 4; ++i)
+            {
+                int m = ETC1_MODIFIERS[t][i];
+                unsigned int e = colorError(pixels[p], clampByte(base[0] + m), clampByte(base[1] + m), clampByte(base[2] + m));
+                if (e < pixelError)
+                {
+                    pixelError = e;
+                    tableIndices[p] = (unsigned char)i;
+                }
+            }
+            error += pixelError;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            *table = t;
+            for (int p = 0; p < 16; ++p)
+            {
+                if ((flip ? p / 4 : p % 4) / 2 == half)
+                    indices[p] = tableIndices[p];
+            }
+        }
+    }
+    return bestError;
+}
+
+// Encodes an ETC1 block, which ETC2 decodes the same way since no differential color overflows.
+static void encodeETC1Block(const unsigned char pixels[16][4], unsigned char* block)
+{
+    unsigned int bestError = UINT_MAX;
+    bool bestDiff = false;
+    bool bestFlip = false;
+    int bestColors[2][3] = { { 0 } };
+    int bestTables[2] = { 0, 0 };
+    unsigned char bestIndices[16] = { 0 };
+
+    for (int f = 0; f < 2; ++f)
+    {
+        bool flip = f == 1;
+
+        // Average color of both halves.
+        int sums[2][3] = { { 0 } };
+        for (int p = 0; p < 16; ++p)
+        {
+            int half = (flip ? p / 4 : p % 4) / 2;
+            for (int c = 0; c < 3; ++c)
+                sums[half][c] += pixels[p][c];
+        }
+
+        for (int d = 0; d < 2; ++d)
+        {
+            bool diff = d == 1;
+            int colors[2][3];
+            int bases[2][3];
+            bool valid = true;
+            for (int half = 0; half < 2; ++half)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    int average = (sums[half][c] + 4) / 8;
+                    if (diff)
+                    {
+                        colors[half][c] = (average * 31 + 127) / 255;
+                        bases[half][c] = (colors[half][c] << 3) | (colors[half][c] >> 2);
+                    }
+                    else
+                    {
+                        colors[half][c] = (average * 15 + 127) / 255;
+                        bases[half][c] = colors[half][c] * 17;
+                    }
+                }
+            }
+            if (diff)
+            {
+                for (int c = 0; c < 3; ++c)
+                {
+                    int delta = colors[1][c] - colors[0][c];
+                    if (delta < -4 || delta > 3)
+                        valid = false;
+                }
+            }
+            if (!valid)
+                continue;
+
+            int tables[2];
+            unsigned char indices[16];
+            unsigned int error = encodeETC1Half(pixels, flip, 0, bases[0], &tables[0], indices) +
+                                 encodeETC1Half(pixels, flip, 1, bases[1], &tables[1], indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestDiff = diff;
+                bestFlip = flip;
+                memcpy(bestColors, colors, sizeof(colors));
+                memcpy(bestTables, tables, sizeof(tables));
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+    }
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (bestDiff)
+            block[c] = (unsigned char)((bestColors[0][c] << 3) | ((bestColors[1][c] - bestColors[0][c]) & 7));
+        else
+            block[c] = (unsigned char)((bestColors[0][c] << 4) | bestColors[1][c]);
+    }
+    block[3] = (unsigned char)((bestTables[0] << 5) | (bestTables[1] << 2) | (bestDiff ? 2 : 0) | (bestFlip ? 1 : 0));
+
+    // The pixel indices are stored by column, most significant bits first.
+    unsigned int msb = 0;
+    unsigned int lsb = 0;
+    for (int p = 0; p < 16; ++p)
+    {
+        int bit = (p % 4) * 4 + p / 4;
+        msb |= (unsigned int)((bestIndices[p] >> 1) & 1) << bit;
+        lsb |= (unsigned int)(bestIndices[p] & 1) << bit;
+    }
+    block[4] = (unsigned char)(msb >> 8);
+    block[5] = (unsigned char)msb;
+    block[6] = (unsigned char)(lsb >> 8);
+    block[7] = (unsigned char)lsb;
+}
+
+// Encodes the EAC alpha block of an ETC2 RGBA block.
+static void encodeEACBlock(const unsigned char pixels[16][4], unsigned char* block)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int p = 0; p < 16; ++p)
+    {
+        minAlpha = std::min(minAlpha, (int)pixels[p][3]);
+        maxAlpha = std::max(maxAlpha, (int)pixels[p][3]);
+    }
+
+    // Table 13 has a zero modifier, which stores a constant alpha exactly.
+    int bestBase = minAlpha;
+    int bestMultiplier = 1;
+    int bestTable = 13;
+    unsigned char bestIndices[16];
+    memset(bestIndices, 4, sizeof(bestIndices));
+
+    if (minAlpha != maxAlpha)
+    {
+        unsigned int bestError = UINT_MAX;
+        for (int t = 0; t < 16; ++t)
+        {
+            int range = EAC_MODIFIERS[t][7] - EAC_MODIFIERS[t][3];
+            int center = EAC_MODIFIERS[t][7] + EAC_MODIFIERS[t][3];
+            int multiplier = std::max(1, std::min(15, (maxAlpha - minAlpha + range / 2) / range));
+            for (int m = std::max(1, multiplier - 1); m <= std::min(15, multiplier + 1); ++m)
+            {
+                int base = clampByte((minAlpha + maxAlpha - center * m) / 2);
+                for (int b = std::max(0, base - 1); b <= std::min(255, base + 1); ++b)
+                {
+                    unsigned int error = 0;
+                    unsigned char indices[16];
+                    for (int p = 0; p < 16 && error < bestError; ++p)
+                    {
+                        unsigned int pixelError = UINT_MAX;
+                        for (int i = 0; i < 8; ++i)
+                        {
+                            int d = clampByte(b + EAC_MODIFIERS[t][i] * m) - pixels[p][3];
+                            if ((unsigned int)(d * d) < pixelError)
+                            {
+                                pixelError = d * d;
+                                indices[p] = (unsigned char)i;
+                            }
+                        }
+                        error += pixelError;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestBase = b;
+                        bestMultiplier = m;
+                        bestTable = t;
+                        memcpy(bestIndices, indices, sizeof(indices));
+                    }
+                }
+            }
+        }
+    }
+
+    block[0] = (unsigned char)bestBase;
+    block[1] = (unsigned char)((bestMultiplier << 4) | bestTable);
+
+    // The pixel indices are stored by column, first pixel in the most significant bits.
+    unsigned long long bits = 0;
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+            bits = (bits << 3) | bestIndices[row * 4 + column];
+    }
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = (unsigned char)(bits >> (40 - 8 * i));
+}
+
+static unsigned short packRGB565(const float* color)
+{
+    int r = clampByte((int)(color[0] + 0.5f));
+    int g = clampByte((int)(color[1] + 0.5f));
+    int b = clampByte((int)(color[2] + 0.5f));
+    return (unsigned short)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+static void unpackRGB565(unsigned short color, int* rgb)
+{
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Encodes a BC1 color block in four color mode, with the endpoints on the principal axis of the colors.
+static void encodeBC1Block(const unsigned char pixels[16][4], unsigned char* block)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int p = 0; p < 16; ++p)
+    {
+        for (int c = 0; c < 3; ++c)
+            mean[c] += pixels[p][c] / 16.0f;
+    }
+    float covariance[3][3] = { { 0.0f } };
+    for (int p = 0; p < 16; ++p)
+    {
+        float d[3] = { pixels[p][0] - mean[0], pixels[p][1] - mean[1], pixels[p][2] - mean[2] };
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+                covariance[i][j] += d[i] * d[j];
+        }
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[3];
+        for (int i = 0; i < 3; ++i)
+            next[i] = covariance[i][0] * axis[0] + covariance[i][1] * axis[1] + covariance[i][2] * axis[2];
+        float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f)
+            break;
+        for (int i = 0; i < 3; ++i)
+            axis[i] = next[i] / length;
+    }
+
+    float minT = FLT_MAX;
+    float maxT = -FLT_MAX;
+    for (int p = 0; p < 16; ++p)
+    {
+        float t = (pixels[p][0] - mean[0]) * axis[0] + (pixels[p][1] - mean[1]) * axis[1] + (pixels[p][2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float end0[3];
+    float end1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        end0[c] = mean[c] + axis[c] * maxT;
+        end1[c] = mean[c] + axis[c] * minT;
+    }
+    unsigned short color0 = packRGB565(end0);
+    unsigned short color1 = packRGB565(end1);
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    unsigned int bits = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int p = 0; p < 16; ++p)
+        {
+            unsigned int bestError = UINT_MAX;
+            unsigned int index = 0;
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                unsigned int e = colorError(pixels[p], palette[i][0], palette[i][1], palette[i][2]);
+                if (e < bestError)
+                {
+                    bestError = e;
+                    index = i;
+                }
+            }
+            bits |= index << (2 * p);
+        }
+    }
+
+    block[0] = (unsigned char)color0;
+    block[1] = (unsigned char)(color0 >> 8);
+    block[2] = (unsigned char)color1;
+    block[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        block[4 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Encodes the BC3 alpha block, with eight interpolated values between the smallest and largest alpha.
+static void encodeBC3AlphaBlock(const unsigned char pixels[16][4], unsigned char* block)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (int p = 0; p < 16; ++p)
+    {
+        alpha0 = std::max(alpha0, (int)pixels[p][3]);
+        alpha1 = std::min(alpha1, (int)pixels[p][3]);
+    }
+
+    unsigned long long bits = 0;
+    if (alpha0 != alpha1)
+    {
+        int palette[8];
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+        for (int p = 0; p < 16; ++p)
+        {
+            int bestError = INT_MAX;
+            unsigned long long index = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                int e = abs(palette[i] - pixels[p][3]);
+                if (e < bestError)
+                {
+                    bestError = e;
+                    index = i;
+                }
+            }
+            bits |= index << (3 * p);
+        }
+    }
+
+    block[0] = (unsigned char)alpha0;
+    block[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+// Halves a level with a box filter.
+static void downsample(const FilterLevel& source, FilterLevel* level)
+{
+    static const float weights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    level->width = std::max(1u, source.width / 2);
+    level->height = std::max(1u, source.height / 2);
+    level->pixels.resize(level->width * level->height * 4);
+    for (unsigned int y = 0; y < level->height; ++y)
+    {
+        unsigned int y0 = std::min(y * 2, source.height - 1);
+        unsigned int y1 = std::min(y * 2 + 1, source.height - 1);
+        for (unsigned int x = 0; x < level->width; ++x)
+        {
+            unsigned int x0 = std::min(x * 2, source.width - 1);
+            unsigned int x1 = std::min(x * 2 + 1, source.width - 1);
+            const float* texels[4] =
+            {
+                &source.pixels[(y0 * source.width + x0) * 4], &source.pixels[(y0 * source.width + x1) * 4],
+                &source.pixels[(y1 * source.width + x0) * 4], &source.pixels[(y1 * source.width + x1) * 4]
+            };
+            average(texels, weights, 4, &level->pixels[(y * level->width + x) * 4]);
+        }
+    }
+}
+
+// Resizes a level along one axis with a tent filter, as wide as a source texel when enlarging and as a target texel when shrinking.
+static void resampleAxis(const FilterLevel& source, unsigned int size, bool horizontal, FilterLevel* level)
+{
+    unsigned int sourceSize = horizontal ? source.width : source.height;
+    level->width = horizontal ? size : source.width;
+    level->height = horizontal ? source.height : size;
+    level->pixels.resize(level->width * level->height * 4);
+
+    float scale = (float)sourceSize / size;
+    float radius = std::max(1.0f, scale);
+    std::vector<const float*> texels;
+    std::vector<float> weights;
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        float center = (i + 0.5f) * scale - 0.5f;
+        int first = (int)floorf(center - radius) + 1;
+        int last = (int)ceilf(center + radius) - 1;
+        for (unsigned int j = 0, lines = horizontal ? level->height : level->width; j < lines; ++j)
+        {
+            texels.clear();
+            weights.clear();
+            for (int s = first; s <= last; ++s)
+            {
+                float w = 1.0f - fabsf(s - center) / radius;
+                if (w <= 0.0f)
+                    continue;
+                unsigned int clamped = (unsigned int)std::max(0, std::min((int)sourceSize - 1, s));
+                unsigned int x = horizontal ? clamped : j;
+                unsigned int y = horizontal ? j : clamped;
+                texels.push_back(&source.pixels[(y * source.width + x) * 4]);
+                weights.push_back(w);
+            }
+            unsigned int x = horizontal ? i : j;
+            unsigned int y = horizontal ? j : i;
+            average(&texels[0], &weights[0], (unsigned int)texels.size(), &level->pixels[(y * level->width + x) * 4]);
+        }
+    }
+}
+
+// Returns the power of two nearest to a size.
+static unsigned int nearestPowerOfTwo(unsigned int size)
+{
+    unsigned int lower = 1;
+    while (lower * 2 <= size)
+        lower *= 2;
+    return size - lower <= lower * 2 - size ? lower : lower * 2;
+}
+
+bool TextureEncoder::isTargetSupported(const char* target)
+{
+    return target && (strcmp(target, "etc1") == 0 || strcmp(target, "etc2") == 0 || strcmp(target, "bc") == 0 ||
+                      strcmp(target, "raw") == 0);
+}
+
+bool TextureEncoder::encode(const char* inputFile, const char* outputFile, const char* target, unsigned int flags)
+{
+    if (!isTargetSupported(target))
+    {
+        LOG(1, "Error: unsupported texture compression target: %s.\n", target ? target : "");
+        return false;
+    }
+
+    Image* image = Image::create(inputFile);
+    if (image == NULL)
+        return false;
+
+    // Expand the image to RGBA, bottom row first.
+    std::vector<TextureLevel> levels(1);
+    TextureLevel& base = levels[0];
+    base.width = image->getWidth();
+    base.height = image->getHeight();
+    base.pixels.resize(base.width * base.height * 4);
+    const unsigned char* data = (const unsigned char*)image->getData();
+    unsigned int bpp = image->getBpp();
+    bool alpha = false;
+    for (unsigned int y = 0; y < base.height; ++y)
+    {
+        const unsigned char* row = data + (base.height - 1 - y) * base.width * bpp;
+        for (unsigned int x = 0; x < base.width; ++x)
+        {
+            const unsigned char* source = row + x * bpp;
+            unsigned char* pixel = &base.pixels[(y * base.width + x) * 4];
+            pixel[0] = source[0];
+            pixel[1] = bpp >= 3 ? source[1] : source[0];
+            pixel[2] = bpp >= 3 ? source[2] : source[0];
+            pixel[3] = bpp == 4 ? source[3] : 255;
+            alpha = alpha || pixel[3] != 255;
+        }
+    }
+    delete image;
+
+    // The mip levels are filtered in linear space, unless the texels are not colors.
+    bool gamma = (flags & LINEAR) == 0;
+    FilterLevel filterLevel;
+    toFilterLevel(base, gamma, &filterLevel);
+
+    if (flags & POWER_OF_TWO)
+    {
+        unsigned int potWidth = nearestPowerOfTwo(base.width);
+        unsigned int potHeight = nearestPowerOfTwo(base.height);
+        if (potWidth != base.width || potHeight != base.height)
+        {
+            LOG(2, "Resizing %s from %dx%d to %dx%d.\n", inputFile, base.width, base.height, potWidth, potHeight);
+            FilterLevel resized;
+            resampleAxis(filterLevel, potWidth, true, &resized);
+            resampleAxis(resized, potHeight, false, &filterLevel);
+            toTextureLevel(filterLevel, gamma, &base);
+        }
+    }
+    unsigned int width = base.width;
+    unsigned int height = base.height;
+
+    unsigned int internalFormat;
+    unsigned int baseInternalFormat = alpha ? KTX_GL_RGBA : KTX_GL_RGB;
+    bool raw = strcmp(target, "raw") == 0;
+    if (raw)
+    {
+        internalFormat = baseInternalFormat;
+    }
+    else if (strcmp(target, "etc1") == 0)
+    {
+        if (alpha)
+            LOG(1, "Warning: ETC1 has no alpha channel, the alpha of %s is dropped.\n", inputFile);
+        internalFormat = KTX_GL_ETC1_RGB8;
+        baseInternalFormat = KTX_GL_RGB;
+    }
+    else if (strcmp(target, "etc2") == 0)
+    {
+        internalFormat = alpha ? KTX_GL_COMPRESSED_RGBA8_ETC2_EAC : KTX_GL_COMPRESSED_RGB8_ETC2;
+    }
+    else
+    {
+        internalFormat = alpha ? KTX_GL_COMPRESSED_RGBA_S3TC_DXT5 : KTX_GL_COMPRESSED_RGB_S3TC_DXT1;
+    }
+    bool alphaBlocks = internalFormat == KTX_GL_COMPRESSED_RGBA8_ETC2_EAC || internalFormat == KTX_GL_COMPRESSED_RGBA_S3TC_DXT5;
+    bool etc = internalFormat != KTX_GL_COMPRESSED_RGB_S3TC_DXT1 && internalFormat != KTX_GL_COMPRESSED_RGBA_S3TC_DXT5;
+
+    // Full mip chain, down to 1x1. This reallocates the levels, so base is not valid after it.
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        FilterLevel next;
+        downsample(filterLevel, &next);
+        filterLevel.width = next.width;
+        filterLevel.height = next.height;
+        filterLevel.pixels.swap(next.pixels);
+        levels.push_back(TextureLevel());
+        toTextureLevel(filterLevel, gamma, &levels.back());
+    }
+
+    FILE* file = fopen(outputFile, "wb");
+    if (file == NULL)
+    {
+        LOG(1, "Error: failed to open file for writing: %s.\n", outputFile);
+        return false;
+    }
+
+    // Block compressed formats have no type and format.
+    unsigned int glType = raw ? KTX_GL_UNSIGNED_BYTE : 0;
+    unsigned int glFormat = raw ? baseInternalFormat : 0;
+    unsigned int keyValueSize = sizeof(KTX_ORIENTATION_KEY) + sizeof(KTX_ORIENTATION_VALUE);
+    unsigned int keyValuePadding = (4 - keyValueSize % 4) % 4;
+    fwrite(KTX_IDENTIFIER, 1, sizeof(KTX_IDENTIFIER), file);
+    write((unsigned int)0x04030201, file);
+    write(glType, file);
+    write((unsigned int)1, file);                   // glTypeSize
+    write(glFormat, file);
+    write(internalFormat, file);
+    write(baseInternalFormat, file);
+    write(width, file);
+    write(height, file);
+    write((unsigned int)0, file);                   // pixelDepth
+    write((unsigned int)0, file);                   // numberOfArrayElements
+    write((unsigned int)1, file);                   // numberOfFaces
+    write((unsigned int)levels.size(), file);
+    write((unsigned int)sizeof(unsigned int) + keyValueSize + keyValuePadding, file);
+
+    write(keyValueSize, file);
+    fwrite(KTX_ORIENTATION_KEY, 1, sizeof(KTX_ORIENTATION_KEY), file);
+    fwrite(KTX_ORIENTATION_VALUE, 1, sizeof(KTX_ORIENTATION_VALUE), file);
+    for (unsigned int i = 0; i < keyValuePadding; ++i)
+        write((unsigned char)0, file);
+
+    unsigned int blockSize = alphaBlocks ? 16 : 8;
+    size_t written = 0;
+    for (size_t l = 0, levelCount = levels.size(); l < levelCount; ++l)
+    {
+        const TextureLevel& level = levels[l];
+        if (raw)
+        {
+            // The rows are padded to 4 bytes, the unpack alignment the engine loads them with.
+            unsigned int components = alpha ? 4 : 3;
+            unsigned int rowSize = (level.width * components + 3) & ~3u;
+            std::vector<unsigned char> texels(rowSize * level.height, 0);
+            for (unsigned int y = 0; y < level.height; ++y)
+            {
+                for (unsigned int x = 0; x < level.width; ++x)
+                    memcpy(&texels[y * rowSize + x * components], &level.pixels[(y * level.width + x) * 4], components);
+            }
+            write((unsigned int)texels.size(), file);
+            fwrite(&texels[0], 1, texels.size(), file);
+            written += texels.size();
+            continue;
+        }
+
+        unsigned int blocksX = (level.width + 3) / 4;
+        unsigned int blocksY = (level.height + 3) / 4;
+        std::vector<unsigned char> blocks(blocksX * blocksY * blockSize);
+        for (unsigned int by = 0; by < blocksY; ++by)
+        {
+            for (unsigned int bx = 0; bx < blocksX; ++bx)
+            {
+                // The edge pixels are repeated for blocks that extend past the level.
+                unsigned char pixels[16][4];
+                for (unsigned int p = 0; p < 16; ++p)
+                {
+                    unsigned int x = std::min(bx * 4 + p % 4, level.width - 1);
+                    unsigned int y = std::min(by * 4 + p / 4, level.height - 1);
+                    memcpy(pixels[p], &level.pixels[(y * level.width + x) * 4], 4);
+                }
+                unsigned char* block = &blocks[(by * blocksX + bx) * blockSize];
+                if (alphaBlocks)
+                {
+                    if (etc)
+                        encodeEACBlock(pixels, block);
+                    else
+                        encodeBC3AlphaBlock(pixels, block);
+                    block += 8;
+                }
+                if (etc)
+                    encodeETC1Block(pixels, block);
+                else
+                    encodeBC1Block(pixels, block);
+            }
+        }
+
+        // Block sizes are multiples of 4 bytes, so no level padding is needed.
+        write((unsigned int)blocks.size(), file);
+        fwrite(&blocks[0], 1, blocks.size(), file);
+        written += blocks.size();
+    }
+    fclose(file);
+
+    LOG(1, "Wrote %d mip levels (%d bytes) to %s texture file: %s.\n", (int)levels.size(), (int)written, raw ? "uncompressed" : "compressed", outputFile);
+    return true;
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef TEXTUREENCODER_H_
+#define TEXTUREENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Transcodes a PNG image to a GPU ready KTX file with a full mip chain.
+ *
+ * The supported targets are:
+ *  - "etc1": ETC1, for GL ES 2 gpus. The alpha channel is dropped.
+ *  - "etc2": ETC2 RGB, or ETC2 RGBA with an EAC alpha channel, for GL ES 3 gpus.
+ *  - "bc": BC1 (DXT1), or BC3 (DXT5) with an alpha channel, for desktop gpus.
+ *  - "raw": uncompressed RGB, or RGBA with an alpha channel, for every gpu.
+ *
+ * The mip levels are filtered in linear space, converting the sRGB colors of the image
+ * before averaging them and back afterwards, so that they do not darken with distance.
+ * Colors are weighted by alpha, so that transparent texels do not bleed into the visible
+ * ones. Textures of data rather than colors, such as normal maps, are filtered as is
+ * with the LINEAR flag. The engine uploads the levels as they are and generates none.
+ *
+ * The rows are stored bottom up, the same as the engine stores PNG images, so that the
+ * KTX file can be used with the texture coordinates of the PNG. The engine loads the file
+ * in place of 'name.png' when it is named 'name.<target>.ktx' and the GPU supports it.
+ */
+class TextureEncoder
+{
+public:
+
+    /**
+     * Options of the encoding, combined with bitwise or.
+     */
+    enum Flags
+    {
+        /**
+         * Filter the texels as they are rather than as sRGB colors.
+         */
+        LINEAR = 1,
+
+        /**
+         * Resize the image to the nearest power of two along each edge.
+         */
+        POWER_OF_TWO = 2
+    };
+
+    /**
+     * Transcodes an image.
+     *
+     * @param inputFile The PNG image.
+     * @param outputFile The KTX file to write.
+     * @param target The format family: "etc1", "etc2", "bc" or "raw".
+     * @param flags The options of the encoding, a combination of Flags.
+     *
+     * @return True if the file was written.
+     */
+    static bool encode(const char* inputFile, const char* outputFile, const char* target, unsigned int flags = 0);
+
+    /**
+     * Returns true if the target is one of the supported format families.
+     */
+    static bool isTargetSupported(const char* target);
+
+};
+
+}
+
+#endif
@@ -16,7 +16,7 @@ namespace gameplay
         void* arg;
     };
 
-    DWORD WINAPI WindowsThreadProc(LPVOID lpParam)
+    static DWORD WINAPI WindowsThreadProc(LPVOID lpParam)
     {
         WindowsThreadData* data = (WindowsThreadData*)lpParam;
         int(*threadFunction)(void*) = data->threadFunction;
@@ -57,7 +57,7 @@ namespace gameplay
         void* arg;
     };
 
-    void* PThreadProc(void* threadData)
+    static void* PThreadProc(void* threadData)
     {
         PThreadData* data = (PThreadData*)threadData;
         int(*threadFunction)(void*) = data->threadFunction;
@@ -65,7 +65,7 @@ namespace gameplay
         delete data;
         data = NULL;
         int retVal = threadFunction(arg);
-        pthread_exit((void*)retVal);
+        pthread_exit((void*)(size_t)retVal);
     }
 
     static bool createThread(THREAD_HANDLE* handle, int(*threadFunction)(void*), void* arg)
@@ -0,0 +1,109 @@
+#include "Base.h"
+#include "ThreadPool.h"
+#include "Thread.h"
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+namespace gameplay
+{
+
+static unsigned int __threadCount = 0;
+
+/**
+ * The state shared by the workers of a batch.
+ */
+struct ThreadPoolBatch
+{
+    ThreadPool::Task task;
+    void* arg;
+    unsigned int count;
+    volatile long next;
+};
+
+/**
+ * Atomically increments the value and returns its previous value.
+ */
+static long fetchAndIncrement(volatile long* value)
+{
+#ifdef WIN32
+    return InterlockedIncrement(value) - 1;
+#else
+    return __sync_fetch_and_add(value, 1);
+#endif
+}
+
+static int runTasks(void* threadData)
+{
+    ThreadPoolBatch* batch = (ThreadPoolBatch*)threadData;
+    for (;;)
+    {
+        long index = fetchAndIncrement(&batch->next);
+        if (index >= (long)batch->count)
+            break;
+        batch->task((unsigned int)index, batch->arg);
+    }
+    return 0;
+}
+
+void ThreadPool::setThreadCount(unsigned int count)
+{
+    __threadCount = count;
+}
+
+unsigned int ThreadPool::getThreadCount()
+{
+    if (__threadCount > 0)
+        return __threadCount;
+
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long processors = (long)info.dwNumberOfProcessors;
+#else
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return processors > 0 ? (unsigned int)processors : 1;
+}
+
+void ThreadPool::run(unsigned int count, Task task, void* arg)
+{
+    assert(task);
+
+    unsigned int threadCount = std::min(getThreadCount(), count);
+    if (threadCount <= 1)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+            task(i, arg);
+        return;
+    }
+
+    ThreadPoolBatch batch;
+    batch.task = task;
+    batch.arg = arg;
+    batch.count = count;
+    batch.next = 0;
+
+    // The calling thread works on the batch too, so it needs one thread less.
+    std::vector<THREAD_HANDLE> threads(threadCount - 1);
+    unsigned int started = 0;
+    for (; started < threads.size(); ++started)
+    {
+        if (!createThread(&threads[started], &runTasks, &batch))
+        {
+            LOG(1, "Warning: Failed to start a worker thread; running with %u thread(s).\n", started + 1);
+            break;
+        }
+    }
+
+    runTasks(&batch);
+
+    if (started > 0)
+    {
+        waitForThreads((int)started, &threads[0]);
+        for (unsigned int i = 0; i < started; ++i)
+            closeThread(threads[i]);
+    }
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+namespace gameplay
+{
+
+/**
+ * Runs independent tasks of the encoder on worker threads.
+ *
+ * A batch of tasks is run by starting up to getThreadCount() workers that take
+ * the task indices in turn until all have run, and returns once they are done.
+ * Tasks must only write to data of their own index, so the results of a batch
+ * do not depend on the number of threads or the order the tasks run in, and
+ * the files the encoder writes stay the same for any thread count.
+ */
+class ThreadPool
+{
+public:
+
+    /**
+     * A task, called with the index of the task and the argument given to run().
+     */
+    typedef void (*Task)(unsigned int index, void* arg);
+
+    /**
+     * Sets the number of worker threads.
+     *
+     * @param count The number of threads, or 0 for one thread per processor.
+     */
+    static void setThreadCount(unsigned int count);
+
+    /**
+     * Returns the number of worker threads, at least one.
+     */
+    static unsigned int getThreadCount();
+
+    /**
+     * Runs a batch of tasks and waits for all of them to finish.
+     *
+     * The tasks are run on the calling thread when there is only one thread or one task.
+     *
+     * @param count The number of tasks.
+     * @param task The function run for each index from 0 to count - 1.
+     * @param arg The argument passed to every task.
+     */
+    static void run(unsigned int count, Task task, void* arg);
+};
+
+}
+
+#endif
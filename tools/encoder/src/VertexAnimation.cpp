@@ -0,0 +1,326 @@
+#include "Base.h"
+#include "VertexAnimation.h"
+#include "Mesh.h"
+#include "MeshSkin.h"
+#include "Model.h"
+#include "Node.h"
+#include "GPBFile.h"
+#include "Animations.h"
+#include "Transform.h"
+#include "Curve.h"
+#include "Matrix.h"
+
+namespace gameplay
+{
+
+/**
+ * The curve of an animation channel that targets a joint, over the time of its keys.
+ */
+struct JointCurve
+{
+    Node* joint;
+    Curve* curve;
+    float startTime;
+    float duration;
+};
+
+/**
+ * Gets the transform of a node relative to the root joint of a skeleton at the current frame,
+ * from the local transforms of the animated joints and the transforms of the other nodes.
+ */
+static const Matrix& getSkeletonMatrix(Node* node, Node* rootJoint, std::map<Node*, Matrix>& locals, std::map<Node*, Matrix>& worlds)
+{
+    std::map<Node*, Matrix>::iterator itr = worlds.find(node);
+    if (itr != worlds.end())
+        return itr->second;
+
+    std::map<Node*, Matrix>::const_iterator local = locals.find(node);
+    const Matrix& localMatrix = local != locals.end() ? local->second : node->getTransformMatrix();
+    Matrix& world = worlds[node];
+    if (node == rootJoint || node->getParent() == NULL)
+        world = localMatrix;
+    else
+        Matrix::multiply(getSkeletonMatrix(node->getParent(), rootJoint, locals, worlds).m, localMatrix.m, world.m);
+    return world;
+}
+
+VertexAnimation::VertexAnimation(Mesh* mesh, float frameRate) : _mesh(mesh), _frameRate(frameRate), _frameCount(0)
+{
+    std::string id(mesh->getId());
+    id.append("_vat");
+    setId(id);
+}
+
+VertexAnimation::~VertexAnimation(void)
+{
+}
+
+unsigned int VertexAnimation::getTypeId(void) const
+{
+    return VERTEXANIMATION_ID;
+}
+
+const char* VertexAnimation::getElementName(void) const
+{
+    return "VertexAnimation";
+}
+
+bool VertexAnimation::isSupported(const Mesh* mesh)
+{
+    if (mesh == NULL || mesh->getId().length() == 0 || mesh->getVertexCount() == 0 || mesh->model == NULL)
+        return false;
+    MeshSkin* skin = mesh->model->getSkin();
+    if (skin == NULL || skin->getJointCount() == 0)
+        return false;
+
+    // The mesh needs blend indices and weights, and an animation channel on one of its joints.
+    bool blendIndices = false;
+    bool blendWeights = false;
+    for (size_t i = 0, count = mesh->getVertexElementCount(); i < count; ++i)
+    {
+        unsigned int usage = mesh->getVertexElement((unsigned int)i).usage;
+        blendIndices |= usage == BLENDINDICES;
+        blendWeights |= usage == BLENDWEIGHTS;
+    }
+    if (!blendIndices || !blendWeights)
+        return false;
+
+    Animations* animations = GPBFile::getInstance()->getAnimations();
+    for (unsigned int i = 0, animationCount = animations->getAnimationCount(); i < animationCount; ++i)
+    {
+        Animation* animation = animations->getAnimation(i);
+        for (unsigned int j = 0, channelCount = animation->getAnimationChannelCount(); j < channelCount; ++j)
+        {
+            if (skin->hasJoint(animation->getAnimationChannel(j)->getTargetId().c_str()))
+                return true;
+        }
+    }
+    return false;
+}
+
+void VertexAnimation::bake()
+{
+    if (_frameCount > 0)
+        return;
+
+    MeshSkin* skin = _mesh->model->getSkin();
+    const std::vector<Node*>& joints = skin->getJoints();
+    unsigned int jointCount = (unsigned int)joints.size();
+
+    // Find the root joint, whose parents are left out of the baked positions.
+    Node* rootJoint = joints[0];
+    for (Node* parent = rootJoint->getParent(); parent; parent = parent->getParent())
+    {
+        if (find(joints.begin(), joints.end(), parent) != joints.end())
+            rootJoint = parent;
+    }
+
+    // Build a curve for each channel that targets a joint, and find the time they cover.
+    std::vector<JointCurve> curves;
+    float startTime = FLT_MAX;
+    float endTime = -FLT_MAX;
+    Animations* animations = GPBFile::getInstance()->getAnimations();
+    for (unsigned int i = 0, animationCount = animations->getAnimationCount(); i < animationCount; ++i)
+    {
+        Animation* animation = animations->getAnimation(i);
+        for (unsigned int j = 0, channelCount = animation->getAnimationChannelCount(); j < channelCount; ++j)
+        {
+            AnimationChannel* channel = animation->getAnimationChannel(j);
+            const std::vector<float>& keyTimes = channel->getKeyTimes();
+            unsigned int keyCount = (unsigned int)keyTimes.size();
+            if (keyCount == 0 || channel->getTargetAttribute() != Transform::ANIMATE_SCALE_ROTATE_TRANSLATE)
+                continue;
+            std::vector<Node*>::const_iterator joint;
+            for (joint = joints.begin(); joint != joints.end(); ++joint)
+            {
+                if ((*joint)->getId() == channel->getTargetId())
+                    break;
+            }
+            if (joint == joints.end())
+                continue;
+
+            JointCurve jointCurve;
+            jointCurve.joint = *joint;
+            jointCurve.startTime = keyTimes[0];
+            jointCurve.duration = keyTimes[keyCount - 1] - keyTimes[0];
+            jointCurve.curve = new Curve(keyCount, 10);
+            jointCurve.curve->setQuaternionOffset(3);
+            std::vector<float> keyValues(channel->getKeyValues());
+            for (unsigned int k = 0; k < keyCount; ++k)
+            {
+                float t = jointCurve.duration > 0.0f ? (keyTimes[k] - jointCurve.startTime) / jointCurve.duration : 0.0f;
+                jointCurve.curve->setPoint(k, t, &keyValues[k * 10], gameplay::Curve::LINEAR);
+            }
+            curves.push_back(jointCurve);
+            startTime = std::min(startTime, keyTimes[0]);
+            endTime = std::max(endTime, keyTimes[keyCount - 1]);
+        }
+    }
+    if (curves.empty())
+        return;
+
+    // Key times are in milliseconds.
+    _frameCount = (unsigned int)((endTime - startTime) * _frameRate / 1000.0f) + 1;
+    unsigned int vertexCount = (unsigned int)_mesh->getVertexCount();
+    bool hasNormals = _mesh->hasNormals();
+    LOG(2, "Baking %u frames of vertex animation for mesh: %s\n", _frameCount, _mesh->getId().c_str());
+
+    _positions.resize(_frameCount * vertexCount * 3);
+    if (hasNormals)
+        _normals.resize(_frameCount * vertexCount * 3);
+    _min.set(FLT_MAX, FLT_MAX, FLT_MAX);
+    _max.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    std::map<Node*, Matrix> locals;
+    std::map<Node*, Matrix> worlds;
+    std::vector<Matrix> palette(jointCount);
+    float srt[10];
+    for (unsigned int frame = 0; frame < _frameCount; ++frame)
+    {
+        // Evaluate the local transforms of the animated joints at the time of the frame.
+        float time = std::min(startTime + frame * 1000.0f / _frameRate, endTime);
+        locals.clear();
+        worlds.clear();
+        for (size_t i = 0, count = curves.size(); i < count; ++i)
+        {
+            const JointCurve& c = curves[i];
+            float t = c.duration > 0.0f ? (time - c.startTime) / c.duration : 0.0f;
+            c.curve->evaluate(std::max(0.0f, std::min(t, 1.0f)), srt);
+            Matrix& local = locals[c.joint];
+            Matrix::createTranslation(srt[7], srt[8], srt[9], local.m);
+            local.rotate(*((Quaternion*)&srt[3]));
+            local.scale(srt[0], srt[1], srt[2]);
+        }
+
+        // Resolve the matrix palette the same way the runtime does.
+        for (unsigned int i = 0; i < jointCount; ++i)
+        {
+            Matrix::multiply(getSkeletonMatrix(joints[i], rootJoint, locals, worlds).m, skin->_bindPoses[i].m, palette[i].m);
+            Matrix::multiply(palette[i].m, skin->_bindShape, palette[i].m);
+        }
+
+        // Skin the vertices with up to four joints each.
+        float* positions = &_positions[frame * vertexCount * 3];
+        float* normals = hasNormals ? &_normals[frame * vertexCount * 3] : NULL;
+        for (unsigned int i = 0; i < vertexCount; ++i)
+        {
+            const Vertex& v = _mesh->getVertex(i);
+            const float* weights = &v.blendWeights.x;
+            const float* indices = &v.blendIndices.x;
+            Vector3 position;
+            Vector3 normal;
+            for (unsigned int j = 0; j < 4; ++j)
+            {
+                unsigned int index = (unsigned int)indices[j];
+                if (ISZERO(weights[j]) || index >= jointCount)
+                    continue;
+                const float* m = palette[index].m;
+                Vector3 p;
+                palette[index].transformPoint(v.position, &p);
+                position.x += weights[j] * p.x;
+                position.y += weights[j] * p.y;
+                position.z += weights[j] * p.z;
+                if (normals)
+                {
+                    normal.x += weights[j] * (m[0] * v.normal.x + m[4] * v.normal.y + m[8] * v.normal.z);
+                    normal.y += weights[j] * (m[1] * v.normal.x + m[5] * v.normal.y + m[9] * v.normal.z);
+                    normal.z += weights[j] * (m[2] * v.normal.x + m[6] * v.normal.y + m[10] * v.normal.z);
+                }
+            }
+            positions[i * 3 + 0] = position.x;
+            positions[i * 3 + 1] = position.y;
+            positions[i * 3 + 2] = position.z;
+            _min.x = std::min(_min.x, position.x);
+            _min.y = std::min(_min.y, position.y);
+            _min.z = std::min(_min.z, position.z);
+            _max.x = std::max(_max.x, position.x);
+            _max.y = std::max(_max.y, position.y);
+            _max.z = std::max(_max.z, position.z);
+            if (normals)
+            {
+                if (normal.lengthSquared() > 0.0f)
+                    normal.normalize();
+                normals[i * 3 + 0] = normal.x;
+                normals[i * 3 + 1] = normal.y;
+                normals[i * 3 + 2] = normal.z;
+            }
+        }
+    }
+
+    for (size_t i = 0, count = curves.size(); i < count; ++i)
+    {
+        delete curves[i].curve;
+    }
+
+    // Keep the texture coordinates and triangles of the mesh, which the runtime draws the frames with.
+    bool hasTexCoords = false;
+    for (size_t i = 0, count = _mesh->getVertexElementCount(); i < count; ++i)
+    {
+        hasTexCoords |= _mesh->getVertexElement((unsigned int)i).usage == TEXCOORD0;
+    }
+    if (hasTexCoords)
+    {
+        _texCoords.resize(vertexCount * 2);
+        for (unsigned int i = 0; i < vertexCount; ++i)
+        {
+            const Vector2& uv = _mesh->getVertex(i).texCoord[0];
+            _texCoords[i * 2 + 0] = uv.x;
+            _texCoords[i * 2 + 1] = uv.y;
+        }
+    }
+    _parts.resize(_mesh->parts.size());
+    for (size_t i = 0, count = _mesh->parts.size(); i < count; ++i)
+    {
+        _parts[i].primitiveType = _mesh->parts[i]->getPrimitiveType();
+        _parts[i].indices = _mesh->parts[i]->getIndices();
+    }
+}
+
+void VertexAnimation::writeBinary(FILE* file)
+{
+    bake();
+
+    Object::writeBinary(file);
+
+    write(_frameRate, file);
+    write(_frameCount, file);
+    write((unsigned int)_mesh->getVertexCount(), file);
+    writeVectorBinary(_min, file);
+    writeVectorBinary(_max, file);
+    write((unsigned int)_texCoords.size(), file);
+    write(_texCoords.empty() ? NULL : &_texCoords[0], (int)_texCoords.size(), file);
+    write((unsigned int)_parts.size(), file);
+    for (size_t i = 0, count = _parts.size(); i < count; ++i)
+    {
+        write(_parts[i].primitiveType, file);
+        write((unsigned int)_parts[i].indices.size(), file);
+        for (size_t j = 0, indexCount = _parts[i].indices.size(); j < indexCount; ++j)
+        {
+            write(_parts[i].indices[j], file);
+        }
+    }
+    write((unsigned int)_positions.size(), file);
+    write(_positions.empty() ? NULL : &_positions[0], (int)_positions.size(), file);
+    write((unsigned int)_normals.size(), file);
+    write(_normals.empty() ? NULL : &_normals[0], (int)_normals.size(), file);
+}
+
+void VertexAnimation::writeText(FILE* file)
+{
+    bake();
+
+    fprintElementStart(file);
+    fprintfElement(file, "mesh", _mesh->getId());
+    fprintfElement(file, "frameRate", _frameRate);
+    fprintfElement(file, "frameCount", _frameCount);
+    fprintfElement(file, "vertexCount", (unsigned int)_mesh->getVertexCount());
+    fprintf(file, "<boundingBox>\n");
+    fprintfElement(file, "min", &_min.x, 3);
+    fprintfElement(file, "max", &_max.x, 3);
+    fprintf(file, "</boundingBox>\n");
+    fprintfElement(file, "parts", (unsigned int)_parts.size());
+    fprintfElement(file, "hasNormals", (unsigned int)(_normals.empty() ? 0 : 1));
+    fprintElementEnd(file);
+}
+
+}
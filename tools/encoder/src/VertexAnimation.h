@@ -0,0 +1,79 @@
+#ifndef VERTEXANIMATION_H_
+#define VERTEXANIMATION_H_
+
+#include "Base.h"
+#include "Object.h"
+#include "Vector3.h"
+
+namespace gameplay
+{
+
+class Mesh;
+
+/**
+ * The animations of a skinned mesh, baked into the positions and normals of its vertices.
+ *
+ * The joints of the skin are evaluated at a fixed frame rate over the time covered by the
+ * animation channels that target them, and the vertices are skinned on the CPU for every
+ * frame. The runtime draws crowds of the mesh from these frames without any skinning.
+ * The object also holds the first texture coordinates and the triangles of the mesh, so the
+ * runtime can draw it without the skinned mesh. It is written with the id of its mesh
+ * followed by "_vat".
+ */
+class VertexAnimation : public Object
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param mesh The skinned mesh.
+     * @param frameRate The number of frames baked per second.
+     */
+    VertexAnimation(Mesh* mesh, float frameRate);
+
+    /**
+     * Destructor.
+     */
+    virtual ~VertexAnimation(void);
+
+    virtual unsigned int getTypeId(void) const;
+    virtual const char* getElementName(void) const;
+    virtual void writeBinary(FILE* file);
+    virtual void writeText(FILE* file);
+
+    /**
+     * Returns true if the mesh has a skin with animated joints to bake.
+     */
+    static bool isSupported(const Mesh* mesh);
+
+    /**
+     * Bakes the frames, unless they are already baked.
+     *
+     * They are baked when the object is written otherwise. The animations of different
+     * meshes can be baked on different threads.
+     */
+    void bake();
+
+private:
+
+    struct Part
+    {
+        unsigned int primitiveType;
+        std::vector<unsigned int> indices;
+    };
+
+    Mesh* _mesh;
+    float _frameRate;
+    unsigned int _frameCount;
+    Vector3 _min;
+    Vector3 _max;
+    std::vector<float> _texCoords;
+    std::vector<Part> _parts;
+    std::vector<float> _positions;
+    std::vector<float> _normals;
+};
+
+}
+
+#endif
@@ -4,9 +4,11 @@
 namespace gameplay
 {
 
-VertexElement::VertexElement(unsigned int t, unsigned int c) :
+VertexElement::VertexElement(unsigned int t, unsigned int c, unsigned int type, bool normalized) :
     usage(t),
-    size(c)
+    size(c),
+    type(type),
+    normalized(normalized)
 {
 }
 
@@ -23,15 +25,38 @@ void VertexElement::writeBinary(FILE* file)
     Object::writeBinary(file);
     write(usage, file);
     write(size, file);
+    write(type, file);
+    write(normalized, file);
 }
 void VertexElement::writeText(FILE* file)
 {
     fprintElementStart(file);
     fprintfElement(file, "usage", usageStr(usage));
     fprintfElement(file, "size", size);
+    fprintfElement(file, "type", typeStr(type));
+    fprintfElement(file, "normalized", normalized ? "true" : "false");
     fprintElementEnd(file);
 }
 
+unsigned int VertexElement::byteSize() const
+{
+    switch (type)
+    {
+        case TYPE_HALF_FLOAT:
+        case TYPE_SHORT:
+        case TYPE_UNSIGNED_SHORT:
+            return size * 2;
+        case TYPE_BYTE:
+        case TYPE_UNSIGNED_BYTE:
+            return size;
+        case TYPE_INT_2_10_10_10_REV:
+        case TYPE_UNSIGNED_INT_2_10_10_10_REV:
+            return 4;
+        default:
+            return size * sizeof(float);
+    }
+}
+
 const char* VertexElement::usageStr(unsigned int usage)
 {
     switch (usage)
@@ -73,4 +98,29 @@ const char* VertexElement::usageStr(unsigned int usage)
     }
 }
 
+const char* VertexElement::typeStr(unsigned int type)
+{
+    switch (type)
+    {
+        case TYPE_FLOAT:
+            return "FLOAT";
+        case TYPE_HALF_FLOAT:
+            return "HALF_FLOAT";
+        case TYPE_BYTE:
+            return "BYTE";
+        case TYPE_UNSIGNED_BYTE:
+            return "UNSIGNED_BYTE";
+        case TYPE_SHORT:
+            return "SHORT";
+        case TYPE_UNSIGNED_SHORT:
+            return "UNSIGNED_SHORT";
+        case TYPE_INT_2_10_10_10_REV:
+            return "INT_2_10_10_10_REV";
+        case TYPE_UNSIGNED_INT_2_10_10_10_REV:
+            return "UNSIGNED_INT_2_10_10_10_REV";
+        default:
+            return "";
+    }
+}
+
 }
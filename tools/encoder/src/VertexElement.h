@@ -1,6 +1,7 @@
 #ifndef VERTEXELEMENT_H_
 #define VERTEXELEMENT_H_
 
+#include "Base.h"
 #include "Object.h"
 
 namespace gameplay
@@ -13,7 +14,7 @@ public:
     /**
      * Constructor.
      */
-    VertexElement(unsigned int t, unsigned int c);
+    VertexElement(unsigned int t, unsigned int c, unsigned int type = TYPE_FLOAT, bool normalized = false);
 
     /**
      * Destructor.
@@ -24,10 +25,18 @@ public:
     virtual void writeBinary(FILE* file);
     virtual void writeText(FILE* file);
 
+    /**
+     * Returns the size of this element in bytes.
+     */
+    unsigned int byteSize() const;
+
     static const char* usageStr(unsigned int usage);
+    static const char* typeStr(unsigned int type);
 
     unsigned int usage;
     unsigned int size;
+    unsigned int type;
+    bool normalized;
 };
 
 }
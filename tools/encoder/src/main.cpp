@@ -4,6 +4,13 @@
 #include "GPBDecoder.h"
 #include "EncoderArguments.h"
 #include "NormalMapGenerator.h"
+#include "TerrainTileEncoder.h"
+#include "NavigationMesh.h"
+#include "PropertiesEncoder.h"
+#include "ArchiveEncoder.h"
+#include "BatchEncoder.h"
+#include "TextureEncoder.h"
+#include "ThreadPool.h"
 
 using namespace gameplay;
 
@@ -53,6 +60,8 @@ int main(int argc, const char** argv)
         return 0;
     }
 
+    ThreadPool::setThreadCount(arguments.getThreadCount());
+
     // Check if the file exists.
     if (!arguments.fileExists())
     {
@@ -63,6 +72,16 @@ int main(int argc, const char** argv)
     // File exists
     LOG(1, "Encoding file: %s\n", arguments.getFilePathPointer());
 
+    if (arguments.batchEnabled())
+    {
+        return BatchEncoder::encode(argv[0], arguments.getFilePathPointer(), arguments.getCacheDirPath().c_str()) ? 0 : -1;
+    }
+
+    if (arguments.archiveGenerationEnabled())
+    {
+        return ArchiveEncoder::encode(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str()) ? 0 : -1;
+    }
+
     switch (arguments.getFileFormat())
     {
     case EncoderArguments::FILEFORMAT_DAE:
@@ -85,7 +104,7 @@ int main(int argc, const char** argv)
                 fontSize = promptUserFontSize();
             }
             std::string id = getBaseName(arguments.getFilePath());
-            writeFont(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), fontSize, id.c_str(), arguments.fontPreviewEnabled());
+            writeFont(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), fontSize, id.c_str(), arguments.fontPreviewEnabled(), arguments.fontDistanceFieldEnabled());
             break;
         }
     case EncoderArguments::FILEFORMAT_GPB:
@@ -105,6 +124,35 @@ int main(int argc, const char** argv)
                 NormalMapGenerator generator(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), x, y, arguments.getHeightmapWorldSize());
                 generator.generate();
             }
+            else if (arguments.getTileSize() > 0)
+            {
+                int x, y;
+                arguments.getHeightmapResolution(&x, &y);
+                const std::string& blendPath = arguments.getTileBlendPath();
+                if (!TerrainTileEncoder::encode(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), x, y,
+                    arguments.getTileSize(), arguments.getHeightmapWorldSize(), blendPath.empty() ? NULL : blendPath.c_str()))
+                {
+                    return -1;
+                }
+            }
+            else if (arguments.getNavigationMeshSlope() > 0.0f)
+            {
+                int x, y;
+                arguments.getHeightmapResolution(&x, &y);
+                if (!NavigationMesh::encodeHeightmap(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(), x, y,
+                    arguments.getHeightmapWorldSize(), arguments.getNavigationMeshSlope()))
+                {
+                    return -1;
+                }
+            }
+            else if (!arguments.getTextureCompression().empty())
+            {
+                if (!TextureEncoder::encode(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str(),
+                    arguments.getTextureCompression().c_str(), arguments.getTextureFlags()))
+                {
+                    return -1;
+                }
+            }
             else
             {
                 LOG(1, "Error: Nothing to do for specified file format. Did you forget an option?\n");
@@ -112,6 +160,14 @@ int main(int argc, const char** argv)
             }
             break;
         }
+    case EncoderArguments::FILEFORMAT_PROPERTIES:
+        {
+            if (!PropertiesEncoder::encode(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str()))
+            {
+                return -1;
+            }
+            break;
+        }
    default:
         {
             LOG(1, "Error: Unsupported file format: %s\n", arguments.getFilePathPointer());
@@ -13,6 +13,7 @@ using namespace std;
 
 #define LUA_GLOBAL_FILENAME "lua_Global"
 #define LUA_ALL_BINDINGS_FILENAME "lua_all_bindings"
+#define LUA_ALL_FFI_FILENAME "lua_all_ffi"
 #define LUA_OBJECT "gameplay::ScriptUtil::LuaObject"
 #define SCOPE_REPLACEMENT ""
 #define SCOPE_REPLACEMENT_SIZE strlen(SCOPE_REPLACEMENT)
@@ -30,6 +30,8 @@ struct ClassBinding
     map<string, vector<FunctionBinding> > bindings;
     /** Holds bindings for hidden functions of the class (protected/private). */
     map<string, vector<FunctionBinding> > hidden;
+    /** Holds the public member variables of the class, in declaration order. */
+    vector<FunctionBinding> fields;
     /** Holds the name(s) of the derived class(es). */
     vector<string> derived;
     /** Holds the name of the class. */
@@ -12,6 +12,9 @@ static inline void outputGetParam(ostream& o, const FunctionBinding::Param& p, i
 static inline void outputMatchedBinding(ostream& o, const FunctionBinding& b, unsigned int paramCount, unsigned int indentLevel, int numBindings);
 static inline void outputReturnValue(ostream& o, const FunctionBinding& b, int indentLevel);
 static inline std::string getTypeName(const FunctionBinding::Param& param);
+static inline bool isValueReturn(const FunctionBinding& b);
+static inline void outputNewReturnValue(ostream& o, const FunctionBinding& b);
+static inline void outputNewReturnValueEnd(ostream& o, const FunctionBinding& b);
 
 FunctionBinding::Param::Param(FunctionBinding::Param::Type type, Kind kind, const string& info) : 
     type(type), kind(kind), info(info), hasDefaultValue(false), levelsOfIndirection(0)
@@ -133,7 +136,10 @@ void FunctionBinding::write(ostream& o, const vector<FunctionBinding>& bindings)
                 o << "        void* returnPtr = (void*)instance->" << bindings[0].name << ";\n";
                 break;
             case FunctionBinding::Param::KIND_VALUE:
-                o << "        void* returnPtr = (void*)new " << bindings[0].returnParam << "(instance->" << bindings[0].name << ");\n";
+                o << "        ";
+                outputNewReturnValue(o, bindings[0]);
+                o << "instance->" << bindings[0].name;
+                outputNewReturnValueEnd(o, bindings[0]);
                 break;
             case FunctionBinding::Param::KIND_REFERENCE:
                 o << "        void* returnPtr = (void*)&(instance->" << bindings[0].name << ");\n";
@@ -208,10 +214,12 @@ void FunctionBinding::write(ostream& o, const vector<FunctionBinding>& bindings)
                 o << bindings[0].name << ";\n";
                 break;
             case FunctionBinding::Param::KIND_VALUE:
-                o << "        void* returnPtr = (void*)new " << bindings[0].returnParam << "(";
+                o << "        ";
+                outputNewReturnValue(o, bindings[0]);
                 if (bindings[0].classname.size() > 0)
                     o << bindings[0].classname << "::";
-                o << bindings[0].name << ");\n";
+                o << bindings[0].name;
+                outputNewReturnValueEnd(o, bindings[0]);
                 break;
             case FunctionBinding::Param::KIND_REFERENCE:
                 o << "        void* returnPtr = (void*)&(";
@@ -255,7 +263,10 @@ void FunctionBinding::write(ostream& o, const vector<FunctionBinding>& bindings)
                 o << "    void* returnPtr = (void*)instance->" << bindings[0].name << ";\n";
                 break;
             case FunctionBinding::Param::KIND_VALUE:
-                o << "    void* returnPtr = (void*)new " << bindings[0].returnParam << "(instance->" << bindings[0].name << ");\n";
+                o << "    ";
+                outputNewReturnValue(o, bindings[0]);
+                o << "instance->" << bindings[0].name;
+                outputNewReturnValueEnd(o, bindings[0]);
                 break;
             case FunctionBinding::Param::KIND_REFERENCE:
                 o << "    void* returnPtr = (void*)&(instance->" << bindings[0].name << ");\n";
@@ -296,10 +307,12 @@ void FunctionBinding::write(ostream& o, const vector<FunctionBinding>& bindings)
                 o << bindings[0].name << ";\n";
                 break;
             case FunctionBinding::Param::KIND_VALUE:
-                o << "    void* returnPtr = (void*)new " << bindings[0].returnParam << "(";
+                o << "    ";
+                outputNewReturnValue(o, bindings[0]);
                 if (bindings[0].classname.size() > 0)
                     o << bindings[0].classname << "::";
-                o << bindings[0].name << ");\n";
+                o << bindings[0].name;
+                outputNewReturnValueEnd(o, bindings[0]);
                 break;
             case FunctionBinding::Param::KIND_REFERENCE:
                 o << "    void* returnPtr = (void*)&(";
@@ -445,6 +458,44 @@ bool FunctionBinding::signaturesMatch(const FunctionBinding& b1, const FunctionB
     return false;
 }
 
+static inline bool isValueReturn(const FunctionBinding& b)
+{
+    // The math classes are returned as values stored in their userdata (see ScriptUtil::pushValue).
+    static const char* valueTypes[] = { "Vector2", "Vector3", "Vector4", "Quaternion", "Matrix" };
+
+    if (b.returnParam.type != FunctionBinding::Param::TYPE_CONSTRUCTOR &&
+        !(b.returnParam.type == FunctionBinding::Param::TYPE_OBJECT && b.returnParam.kind == FunctionBinding::Param::KIND_VALUE))
+    {
+        return false;
+    }
+
+    string name = Generator::getInstance()->getIdentifier(b.returnParam.info);
+    if (name.find("gameplay::") == 0)
+        name = name.substr(10);
+    for (unsigned int i = 0; i < sizeof(valueTypes) / sizeof(valueTypes[0]); i++)
+    {
+        if (name == valueTypes[i])
+            return true;
+    }
+    return false;
+}
+
+static inline void outputNewReturnValue(ostream& o, const FunctionBinding& b)
+{
+    if (isValueReturn(b))
+        o << "gameplay::ScriptUtil::pushValue(state, " << b.returnParam << "(";
+    else
+        o << "void* returnPtr = (void*)new " << b.returnParam << "(";
+}
+
+static inline void outputNewReturnValueEnd(ostream& o, const FunctionBinding& b)
+{
+    if (isValueReturn(b))
+        o << "), \"" << Generator::getInstance()->getUniqueNameFromRef(b.returnParam.info) << "\");\n";
+    else
+        o << ");\n";
+}
+
 static inline std::string getTypeName(const FunctionBinding::Param& param)
 {
     switch (param.type)
@@ -554,6 +605,8 @@ static inline void outputLuaTypeCheck(ostream& o, int index, const FunctionBindi
         break;
     case FunctionBinding::Param::TYPE_OBJECT:
         o << "(lua_type(state, " << index << ") == LUA_TUSERDATA || ";
+        if (p.levelsOfIndirection <= 1 && Generator::getInstance()->isFFIType(Generator::getInstance()->getIdentifier(p.info)))
+            o << "lua_type(state, " << index << ") == LUA_TCDATA || ";
         if (p.kind == FunctionBinding::Param::KIND_POINTER)
             o << "lua_type(state, " << index << ") == LUA_TTABLE || ";
         o << "lua_type(state, " << index << ") == LUA_TNIL)";
@@ -637,10 +690,13 @@ static inline void outputBindingInvocation(ostream& o, const FunctionBinding& b,
             switch (b.returnParam.kind)
             {
             case FunctionBinding::Param::KIND_POINTER:
-                o << "void* returnPtr = (void*)";
+                if (isValueReturn(b))
+                    o << "gameplay::ScriptUtil::pushValue(state, ";
+                else
+                    o << "void* returnPtr = (void*)";
                 break;
             case FunctionBinding::Param::KIND_VALUE:
-                o << "void* returnPtr = (void*)new " << b.returnParam << "(";
+                outputNewReturnValue(o, b);
                 break;
             case FunctionBinding::Param::KIND_REFERENCE:
                 o << "void* returnPtr = (void*)&(";
@@ -667,7 +723,9 @@ static inline void outputBindingInvocation(ostream& o, const FunctionBinding& b,
         {
             if (b.returnParam.type == FunctionBinding::Param::TYPE_CONSTRUCTOR)
             {
-                o << "new " << Generator::getInstance()->getIdentifier(b.returnParam.info) << "(";
+                if (!isValueReturn(b))
+                    o << "new ";
+                o << Generator::getInstance()->getIdentifier(b.returnParam.info) << "(";
             }
             else
             {
@@ -692,7 +750,7 @@ static inline void outputBindingInvocation(ostream& o, const FunctionBinding& b,
         if (b.returnParam.type == FunctionBinding::Param::TYPE_OBJECT && b.returnParam.kind != FunctionBinding::Param::KIND_POINTER)
             o << ")";
 
-        o << ");\n";
+        outputNewReturnValueEnd(o, b);
     }
 
     outputReturnValue(o, b, indentLevel);
@@ -988,6 +1046,9 @@ static inline void outputReturnValue(ostream& o, const FunctionBinding& b, int i
         break;
     case FunctionBinding::Param::TYPE_OBJECT:
     case FunctionBinding::Param::TYPE_CONSTRUCTOR:
+        // Values were already pushed by ScriptUtil::pushValue.
+        if (isValueReturn(b))
+            break;
         o << "if (returnPtr)\n";
         indent(o, indentLevel);
         o << "{\n";
@@ -129,6 +129,19 @@ bool Generator::isDerived(const ClassBinding& c, string classname)
     return false;
 }
 
+// The classes that are plain structs of floats, in the order they are declared to the FFI.
+static const char* __ffiClasses[] = { "gameplay::Vector2", "gameplay::Vector3", "gameplay::Vector4", "gameplay::Quaternion", "gameplay::Matrix" };
+
+bool Generator::isFFIType(string classname)
+{
+    for (unsigned int i = 0; i < sizeof(__ffiClasses) / sizeof(__ffiClasses[0]); i++)
+    {
+        if (classname == __ffiClasses[i])
+            return _classes.find(classname) != _classes.end() && _classes[classname].fields.size() > 0;
+    }
+    return false;
+}
+
 bool Generator::isRef(string classname)
 {
     // Check if the class is derived from Ref.
@@ -600,6 +613,7 @@ void Generator::getClass(XMLElement* classNode, const string& name)
                     {
                         b.returnParam = getParam(e, true, b.classname);
                         classBinding.bindings[b.getFunctionName()].push_back(b);
+                        classBinding.fields.push_back(b);
                     }
                     else
                     {
@@ -1767,6 +1781,9 @@ void Generator::generateBindings(string* bindingNS)
 
     writeFile(luaAllCppStr, luaAllCpp.str());
 
+    if (generatingGameplay)
+        generateFFIDeclarations(bindingNS);
+
     if (bindingNS)
     {
         luaAllH << "\nnamespace " << *bindingNS << "\n";
@@ -1780,6 +1797,65 @@ void Generator::generateBindings(string* bindingNS)
     writeFile(luaAllHStr, luaAllH.str());
 }
 
+void Generator::generateFFIDeclarations(string* bindingNS)
+{
+    vector<string> declarations;
+    for (unsigned int i = 0; i < sizeof(__ffiClasses) / sizeof(__ffiClasses[0]); i++)
+    {
+        map<string, ClassBinding>::iterator iter = _classes.find(__ffiClasses[i]);
+        if (iter == _classes.end() || iter->second.fields.size() == 0)
+            continue;
+
+        // Only float members (and arrays of them) can be laid out without the class declaration.
+        const ClassBinding& c = iter->second;
+        string declaration = string("typedef struct ") + c.uniquename + string(" {");
+        bool plain = true;
+        for (unsigned int j = 0; j < c.fields.size(); j++)
+        {
+            const FunctionBinding::Param& p = c.fields[j].returnParam;
+            if (p.type != FunctionBinding::Param::TYPE_FLOAT || (p.kind == FunctionBinding::Param::KIND_POINTER && p.info.size() == 0))
+            {
+                plain = false;
+                break;
+            }
+            declaration += string(" float ") + c.fields[j].name;
+            if (p.kind == FunctionBinding::Param::KIND_POINTER)
+                declaration += string("[") + p.info + string("]");
+            declaration += string(";");
+        }
+        declaration += string(" } ") + c.uniquename + string(";");
+
+        if (plain)
+            declarations.push_back(declaration);
+        else
+            __warnings.insert(string("Class '") + c.classname + string("' is not a plain struct of floats; no FFI declaration was generated."));
+    }
+
+    cout << "Generating FFI declarations...\n";
+
+    string luaAllFFIStr = _outDir + string(LUA_ALL_FFI_FILENAME) + string(".h");
+    ostringstream luaAllFFI;
+    string includeGuard = string(LUA_ALL_FFI_FILENAME) + string("_H_");
+    transform(includeGuard.begin(), includeGuard.end(), includeGuard.begin(), ::toupper);
+    luaAllFFI << "#ifndef " << includeGuard << "\n";
+    luaAllFFI << "#define " << includeGuard << "\n\n";
+    if (bindingNS)
+    {
+        luaAllFFI << "namespace " << *bindingNS << "\n";
+        luaAllFFI << "{\n\n";
+    }
+    luaAllFFI << "// The C declarations of the plain math classes, for the LuaJIT FFI.\n";
+    luaAllFFI << "static const char* lua_ffi_cdef =\n";
+    for (unsigned int i = 0; i < declarations.size(); i++)
+        luaAllFFI << "    \"" << declarations[i] << "\\n\"\n";
+    luaAllFFI << "    \"\";\n\n";
+    if (bindingNS)
+        luaAllFFI << "}\n\n";
+    luaAllFFI << "#endif\n";
+
+    writeFile(luaAllFFIStr, luaAllFFI.str());
+}
+
 void Generator::getAllDerived(set<string>& derived, string classname)
 {
     for (unsigned int i = 0, count = _classes[classname].derived.size(); i < count; i++)
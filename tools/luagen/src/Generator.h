@@ -100,6 +100,15 @@ public:
      */
     bool isRef(string classname);
 
+    /**
+     * Retrieves whether the given class is declared to the LuaJIT FFI as a plain struct,
+     * in which case its cdata can be passed where the class is expected.
+     * 
+     * @param classname The name of the class.
+     * @return True if the class has an FFI declaration; false otherwise.
+     */
+    bool isFFIType(string classname);
+
 protected:
     /**
      * Constructor.
@@ -181,6 +190,9 @@ protected:
 
     // Generates the bindings to C++ header and source files.
     void generateBindings(string* bindingNS);
+
+    // Writes out the LuaJIT FFI declarations of the plain math classes.
+    void generateFFIDeclarations(string* bindingNS);
     
     // Gets the set off all classes that derives from the given class.
     void getAllDerived(set<string>& derived, string classname);
@@ -1,5 +1,7 @@
 #include "Base.h"
 #include "Generator.h"
+#include <cstring>
+#include <lua.hpp>
 
 //TRACK_MEMORY();
 
@@ -60,12 +62,100 @@ void writeFile(const std::string& path, const std::string& text)
     }
 }
 
+// Compiled scripts start with this magic, followed by the size and hash of their source
+// (this must match LUA_CHUNK_MAGIC in gameplay's ScriptController.cpp, and hashScript() must match
+// gameplay's StringTable::hash, which the tool does not link against).
+#define LUA_CHUNK_MAGIC "GPLC"
+
+static unsigned int hashScript(const char* source, size_t size)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned int)(unsigned char)source[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int writeChunk(lua_State* lua, const void* data, size_t size, void* userData)
+{
+    string* chunk = (string*)userData;
+    chunk->append((const char*)data, size);
+    return 0;
+}
+
+/**
+ * Compiles a Lua script to bytecode and writes it next to the script (with a 'c' appended to its name),
+ * where ScriptController::loadScript picks it up in place of the script while the script is unchanged.
+ */
+static bool compileScript(lua_State* lua, const char* path)
+{
+    ifstream in(path, ios::in | ios::binary);
+    if (!in.is_open())
+    {
+        printError("Failed to open script '%s'.\n", path);
+        return false;
+    }
+    string source((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+
+    string chunkName = string("@") + path;
+    if (luaL_loadbuffer(lua, source.c_str(), source.size(), chunkName.c_str()) != 0)
+    {
+        printError("Failed to compile script '%s': %s\n", path, lua_tostring(lua, -1));
+        lua_pop(lua, 1);
+        return false;
+    }
+
+    string chunk;
+    lua_dump(lua, writeChunk, &chunk);
+    lua_pop(lua, 1);
+
+    unsigned int sourceSize = (unsigned int)source.size();
+    unsigned int sourceHash = hashScript(source.c_str(), source.size());
+    string outputPath = string(path) + "c";
+    ofstream o(outputPath.c_str(), ios::out | ios::binary);
+    if (!o.is_open())
+    {
+        printError("Failed to write compiled script '%s'.\n", outputPath.c_str());
+        return false;
+    }
+    o.write(LUA_CHUNK_MAGIC, 4);
+    o.write((const char*)&sourceSize, sizeof(unsigned int));
+    o.write((const char*)&sourceHash, sizeof(unsigned int));
+    o.write(chunk.c_str(), chunk.size());
+    o.close();
+    return true;
+}
+
 int main(int argc, char** argv)
 {
+    // Compile scripts to bytecode.
+    if (argc >= 2 && strcmp(argv[1], "-c") == 0)
+    {
+        if (argc < 3)
+        {
+            printf("Usage: gameplay-luagen -c <script.lua> [script.lua ...]\n");
+            exit(0);
+        }
+
+        lua_State* lua = luaL_newstate();
+        int failed = 0;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (!compileScript(lua, argv[i]))
+                ++failed;
+        }
+        lua_close(lua);
+        return failed > 0 ? 1 : 0;
+    }
+
     // Ensure the user is calling the program correctly.
     if (argc < 2 || argc > 4)
     {
         printf("Usage: gameplay-luagen <doxygen-xml-input-directory> [output-directory] [binding-namespace]\n");
+        printf("       gameplay-luagen -c <script.lua> [script.lua ...]\n");
         exit(0);
     }
 